@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bench {
+    /// @brief Prevent compiler from optimizing out computation of the value
+    template <typename T>
+    inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    struct Sample {
+        uint64_t iterations;
+        /// @brief Total duration of iterations in nanoseconds
+        int64_t duration;
+    };
+
+    /// @brief Benchmark run state. Benchmark function performs setup and
+    /// calls run(...) with the measured operation once
+    class State {
+        int64_t sampleDuration;
+        int samplesCount;
+        std::vector<Sample> samples;
+        uint64_t itemsPerIteration = 0;
+
+        static int64_t now() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()
+            ).count();
+        }
+
+        template <typename Func>
+        static int64_t measure(Func& func, uint64_t iterations) {
+            int64_t start = now();
+            for (uint64_t i = 0; i < iterations; i++) {
+                func();
+            }
+            return now() - start;
+        }
+    public:
+        /// @param sampleDuration min duration of a sample in nanoseconds
+        /// @param samplesCount number of measured samples
+        State(int64_t sampleDuration, int samplesCount)
+            : sampleDuration(sampleDuration), samplesCount(samplesCount) {
+        }
+
+        /// @brief Measure func calls. Number of iterations per sample is
+        /// calibrated to reach the sample duration
+        template <typename Func>
+        void run(Func&& func) {
+            uint64_t iterations = 1;
+            int64_t duration = measure(func, iterations);
+            while (duration < sampleDuration && iterations < (1ULL << 40)) {
+                uint64_t scale =
+                    duration > 0 ? sampleDuration / duration + 1 : 10;
+                iterations *= std::clamp<uint64_t>(scale, 2, 10);
+                duration = measure(func, iterations);
+            }
+            samples.push_back({iterations, duration});
+            for (int i = 1; i < samplesCount; i++) {
+                samples.push_back({iterations, measure(func, iterations)});
+            }
+        }
+
+        /// @brief Measure func calls each preceded by not measured setup.
+        /// Use for heavy operations modifying their input
+        template <typename Setup, typename Func>
+        void run(Setup&& setup, Func&& func) {
+            for (int i = 0; i < samplesCount; i++) {
+                Sample sample {0, 0};
+                while (sample.duration < sampleDuration ||
+                       sample.iterations == 0) {
+                    setup();
+                    int64_t start = now();
+                    func();
+                    sample.duration += now() - start;
+                    sample.iterations++;
+                }
+                samples.push_back(sample);
+            }
+        }
+
+        /// @brief Set number of processed items (voxels, bytes, nodes)
+        /// per iteration to report throughput
+        void setItemsPerIteration(uint64_t count) {
+            itemsPerIteration = count;
+        }
+
+        uint64_t getItemsPerIteration() const {
+            return itemsPerIteration;
+        }
+
+        const std::vector<Sample>& getSamples() const {
+            return samples;
+        }
+    };
+
+    using Function = void (*)(State&);
+
+    struct Benchmark {
+        std::string name;
+        Function function;
+    };
+
+    std::vector<Benchmark>& registry();
+
+    /// @brief Register benchmark. Use VC_BENCHMARK macro
+    int add(std::string name, Function function);
+}
+
+/// @brief Define a benchmark function taking `bench::State& state`
+#define VC_BENCHMARK(name)                                            \
+    static void bench_##name(bench::State& state);                  \
+    static const int bench_registered_##name =                       \
+        bench::add(#name, bench_##name);                             \
+    static void bench_##name(bench::State& state)
@@ -0,0 +1,68 @@
+#include "bench.hpp"
+#include "coders/binary_json.hpp"
+#include "coders/json.hpp"
+#include "data/dv.hpp"
+
+/// @brief Document similar to world and content files: nested objects,
+/// numbers arrays and strings
+static dv::value create_document() {
+    auto root = dv::object();
+    root["name"] = "benchmark";
+    root["version"] = 3;
+    auto entities = dv::list();
+    for (int i = 0; i < 500; i++) {
+        auto entity = dv::object();
+        entity["id"] = i;
+        entity["def"] = "base:drop";
+        entity["caption"] = "Entity \"" + std::to_string(i) + "\"\n";
+        auto pos = dv::list();
+        pos.add(i * 0.5);
+        pos.add(64.25);
+        pos.add(-i * 1.5);
+        entity["pos"] = std::move(pos);
+        auto components = dv::object();
+        components["base:drop"] = dv::object({{"count", i % 64}});
+        entity["comps"] = std::move(components);
+        entity["enabled"] = i % 2 == 0;
+        entities.add(std::move(entity));
+    }
+    root["entities"] = std::move(entities);
+    return root;
+}
+
+VC_BENCHMARK(json_parse) {
+    auto source = json::stringify(create_document(), true);
+    state.setItemsPerIteration(source.size());
+    state.run([&]() {
+        bench::do_not_optimize(json::parse(source));
+    });
+}
+
+VC_BENCHMARK(json_stringify) {
+    auto document = create_document();
+    state.run([&]() {
+        bench::do_not_optimize(json::stringify(document, false));
+    });
+}
+
+VC_BENCHMARK(json_to_binary) {
+    auto document = create_document();
+    state.run([&]() {
+        bench::do_not_optimize(json::to_binary(document, false));
+    });
+}
+
+VC_BENCHMARK(json_to_binary_compressed) {
+    auto document = create_document();
+    state.run([&]() {
+        bench::do_not_optimize(json::to_binary(document, true));
+    });
+}
+
+VC_BENCHMARK(json_from_binary) {
+    auto bytes = json::to_binary(create_document(), false);
+    state.setItemsPerIteration(bytes.size());
+    state.run([&]() {
+        bench::do_not_optimize(json::from_binary(bytes.data(), bytes.size()));
+    });
+}
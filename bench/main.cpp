@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "bench.hpp"
+#include "coders/json.hpp"
+#include "data/dv.hpp"
+#include "util/ArgsReader.hpp"
+
+std::vector<bench::Benchmark>& bench::registry() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+int bench::add(std::string name, Function function) {
+    registry().push_back({std::move(name), function});
+    return registry().size();
+}
+
+struct Config {
+    std::string filter;
+    std::string jsonFile;
+    int samples = 10;
+    int64_t sampleDuration = 50'000'000;
+    bool list = false;
+};
+
+struct Result {
+    std::string name;
+    uint64_t iterations = 0;
+    double min = 0.0;
+    double median = 0.0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    double itemsPerSecond = 0.0;
+};
+
+static bool parse_args(int argc, char** argv, Config& config) {
+    util::ArgsReader reader(argc, argv);
+    reader.skip();
+    while (reader.hasNext()) {
+        std::string token = reader.next();
+        if (token == "--help" || token == "-h") {
+            std::cout << "Options\n\n";
+            std::cout << "  --help, -h                = show help\n";
+            std::cout << "  --list                    = list benchmarks\n";
+            std::cout << "  --filter <text>           = run benchmarks containing text in name\n";
+            std::cout << "  --json <path>             = write results to JSON file ('-' for stdout)\n";
+            std::cout << "  --samples <n>             = number of samples (default 10)\n";
+            std::cout << "  --sample-time <ms>        = min duration of a sample (default 50)\n";
+            std::cout << std::endl;
+            return false;
+        } else if (token == "--list") {
+            config.list = true;
+        } else if (token == "--filter") {
+            config.filter = reader.next();
+        } else if (token == "--json") {
+            config.jsonFile = reader.next();
+        } else if (token == "--samples") {
+            config.samples = std::max(1, reader.nextInt());
+        } else if (token == "--sample-time") {
+            config.sampleDuration =
+                std::max(1, reader.nextInt()) * int64_t(1'000'000);
+        } else {
+            std::cerr << "unknown argument " << token << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static Result process_samples(
+    const std::string& name, const bench::State& state
+) {
+    Result result {name};
+    std::vector<double> times;
+    for (const auto& sample : state.getSamples()) {
+        times.push_back(
+            static_cast<double>(sample.duration) / sample.iterations
+        );
+        result.iterations += sample.iterations;
+    }
+    if (times.empty()) {
+        return result;
+    }
+    std::sort(times.begin(), times.end());
+    size_t count = times.size();
+    result.min = times.front();
+    result.median = count % 2
+        ? times[count / 2] : (times[count / 2 - 1] + times[count / 2]) * 0.5;
+    for (double time : times) {
+        result.mean += time;
+    }
+    result.mean /= count;
+    for (double time : times) {
+        result.stddev += (time - result.mean) * (time - result.mean);
+    }
+    result.stddev = std::sqrt(result.stddev / count);
+    if (state.getItemsPerIteration() && result.median > 0.0) {
+        result.itemsPerSecond =
+            state.getItemsPerIteration() * 1e9 / result.median;
+    }
+    return result;
+}
+
+static void print_result(const Result& result) {
+    std::cout << std::left << std::setw(36) << result.name << std::right
+              << std::fixed << std::setprecision(1) << std::setw(14)
+              << result.median << std::setw(14) << result.min
+              << std::setw(10) << std::setprecision(2)
+              << (result.mean > 0.0 ? result.stddev / result.mean * 100.0
+                                    : 0.0)
+              << "%";
+    if (result.itemsPerSecond > 0.0) {
+        std::cout << std::setw(14) << std::setprecision(2)
+                  << result.itemsPerSecond / 1e6 << " M/s";
+    }
+    std::cout << std::endl;
+}
+
+static dv::value to_json(const std::vector<Result>& results) {
+    auto list = dv::list();
+    for (const auto& result : results) {
+        auto object = dv::object();
+        object["name"] = result.name;
+        object["iterations"] = static_cast<dv::integer_t>(result.iterations);
+        object["median_ns"] = result.median;
+        object["min_ns"] = result.min;
+        object["mean_ns"] = result.mean;
+        object["stddev_ns"] = result.stddev;
+        if (result.itemsPerSecond > 0.0) {
+            object["items_per_second"] = result.itemsPerSecond;
+        }
+        list.add(std::move(object));
+    }
+    auto root = dv::object();
+    root["benchmarks"] = std::move(list);
+    return root;
+}
+
+int main(int argc, char** argv) {
+    Config config;
+    try {
+        if (!parse_args(argc, argv, config)) {
+            return 0;
+        }
+    } catch (const std::runtime_error& err) {
+        std::cerr << err.what() << std::endl;
+        return 1;
+    }
+    auto& benchmarks = bench::registry();
+    std::sort(benchmarks.begin(), benchmarks.end(), [](auto& a, auto& b) {
+        return a.name < b.name;
+    });
+    if (config.list) {
+        for (const auto& benchmark : benchmarks) {
+            std::cout << benchmark.name << "\n";
+        }
+        return 0;
+    }
+    std::cout << std::left << std::setw(36) << "benchmark" << std::right
+              << std::setw(14) << "median (ns)" << std::setw(14)
+              << "min (ns)" << std::setw(11) << "rsd"
+              << std::setw(18) << "throughput" << std::endl;
+
+    std::vector<Result> results;
+    for (const auto& benchmark : benchmarks) {
+        if (benchmark.name.find(config.filter) == std::string::npos) {
+            continue;
+        }
+        bench::State state(config.sampleDuration, config.samples);
+        try {
+            benchmark.function(state);
+        } catch (const std::exception& err) {
+            std::cerr << benchmark.name << " failed: " << err.what()
+                      << std::endl;
+            return 1;
+        }
+        results.push_back(process_samples(benchmark.name, state));
+        print_result(results.back());
+    }
+    if (config.jsonFile.empty()) {
+        return 0;
+    }
+    auto text = json::stringify(to_json(results), true);
+    if (config.jsonFile == "-") {
+        std::cout << text << std::endl;
+    } else {
+        std::ofstream file(config.jsonFile);
+        file << text << std::endl;
+        if (!file) {
+            std::cerr << "could not write " << config.jsonFile << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <cmath>
+#include <memory>
+
+#include "bench.hpp"
+#include "content/Content.hpp"
+#include "content/ContentBuilder.hpp"
+#include "core_defs.hpp"
+#include "lighting/Lighting.hpp"
+#include "lighting/Lightmap.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Pathfinding.hpp"
+#include "voxels/compressed_chunks.hpp"
+
+namespace {
+    /// @brief Minimal content: core blocks, a solid block and a lamp
+    struct BenchContent {
+        std::unique_ptr<Content> content;
+        blockid_t stone;
+        blockid_t lamp;
+
+        BenchContent() {
+            ContentBuilder builder;
+            corecontent::setup(nullptr, builder);
+            {
+                Block& block = builder.blocks.create("bench:stone");
+                block.pickingItem = CORE_EMPTY;
+            }
+            {
+                Block& block = builder.blocks.create("bench:lamp");
+                block.pickingItem = CORE_EMPTY;
+                block.emission[0] = 15;
+                block.emission[1] = 12;
+                block.emission[2] = 4;
+            }
+            content = builder.build();
+            stone = content->blocks.require("bench:stone").rt.id;
+            lamp = content->blocks.require("bench:lamp").rt.id;
+        }
+
+        const ContentIndices& indices() const {
+            return *content->getIndices();
+        }
+    };
+}
+
+static const BenchContent& get_content() {
+    static BenchContent content;
+    return content;
+}
+
+/// @brief Fill chunk with a hilly surface, caves and scattered lamps
+static std::unique_ptr<Chunk> create_chunk(const BenchContent& content) {
+    auto chunk = std::make_unique<Chunk>(0, 0, std::make_shared<Lightmap>());
+    for (int z = 0; z < CHUNK_D; z++) {
+        for (int x = 0; x < CHUNK_W; x++) {
+            int height = 64 + static_cast<int>(
+                std::sin(x * 0.4f) * 6.0f + std::cos(z * 0.3f) * 5.0f
+            );
+            for (int y = 0; y < height; y++) {
+                bool cave = std::sin(x * 0.7f + y * 0.3f) *
+                            std::cos(z * 0.5f - y * 0.2f) > 0.6f;
+                if (cave) {
+                    continue;
+                }
+                auto& vox = chunk->voxels[vox_index(x, y, z)];
+                vox.id = (x * 7 + y * 13 + z * 3) % 97 == 0 ? content.lamp
+                                                            : content.stone;
+            }
+        }
+    }
+    chunk->updateHeights();
+    return chunk;
+}
+
+VC_BENCHMARK(compressed_chunks_encode) {
+    const auto& content = get_content();
+    auto chunk = create_chunk(content);
+    state.setItemsPerIteration(CHUNK_VOL);
+    state.run([&]() {
+        bench::do_not_optimize(compressed_chunks::encode(*chunk));
+    });
+}
+
+VC_BENCHMARK(compressed_chunks_decode) {
+    const auto& content = get_content();
+    auto bytes = compressed_chunks::encode(*create_chunk(content));
+    Chunk chunk(0, 0);
+    state.setItemsPerIteration(CHUNK_VOL);
+    state.run([&]() {
+        compressed_chunks::decode(
+            chunk, bytes.data(), bytes.size(), content.indices()
+        );
+        bench::do_not_optimize(chunk.voxels);
+    });
+}
+
+VC_BENCHMARK(lights_isolated_build) {
+    const auto& content = get_content();
+    auto chunk = create_chunk(content);
+    IsolatedLighting lighting(content.indices());
+    state.setItemsPerIteration(CHUNK_VOL);
+    state.run(
+        [&]() { chunk->lightmap->clear(); },
+        [&]() {
+            lighting.build(*chunk, true);
+            bench::do_not_optimize(chunk->lightmap->map);
+        }
+    );
+}
+
+VC_BENCHMARK(lights_isolated_emission) {
+    const auto& content = get_content();
+    auto chunk = create_chunk(content);
+    IsolatedLighting lighting(content.indices());
+    state.setItemsPerIteration(CHUNK_VOL);
+    state.run(
+        [&]() { chunk->lightmap->clear(); },
+        [&]() {
+            lighting.build(*chunk, false);
+            bench::do_not_optimize(chunk->lightmap->map);
+        }
+    );
+}
+
+VC_BENCHMARK(pathfinding_state) {
+    constexpr int count = 4096;
+    voxels::State searchState;
+    state.setItemsPerIteration(count);
+    state.run([&]() {
+        searchState.begin({0, 64, 0}, {40, 64, 40});
+        for (int i = 0; i < count; i++) {
+            glm::ivec3 pos(i % 40, 64, i / 40 % 40);
+            if (auto cell = searchState.getCell(pos)) {
+                cell->generation = searchState.generation;
+            }
+            float score = static_cast<float>((i * 7919) % 1000);
+            searchState.nodes.push_back(voxels::Node {pos, 0, 0.0f, score, -1});
+            searchState.push(searchState.nodes.size() - 1);
+            if (i % 4 == 3) {
+                bench::do_not_optimize(searchState.pop());
+            }
+        }
+        while (!searchState.heap.empty()) {
+            bench::do_not_optimize(searchState.pop());
+        }
+    });
+}
@@ -14,15 +14,17 @@ local seed = math.floor(math.random() * 1e6)
 print("random seed", seed)
 math.randomseed(seed)
 
-for i=1,25 do
-    if i % 5 == 0 then
-        print(tostring(i*4).." % done")
-        print("chunks loaded", world.count_chunks())
-    end
-    player.set_pos(pid1, math.random() * 100 - 50, 100, math.random() * 100 - 50)
-    player.set_pos(pid2, math.random() * 200 - 100, 100, math.random() * 200 - 100)
-    app.tick()
-end
+util.measure_time("chunks_total_time", 120, function()
+    util.measure_ticks("chunks_tick_p99", 25, nil, 99, function(i)
+        if i % 5 == 0 then
+            print(tostring(i*4).." % done")
+            print("chunks loaded", world.count_chunks())
+        end
+        player.set_pos(pid1, math.random() * 100 - 50, 100, math.random() * 100 - 50)
+        player.set_pos(pid2, math.random() * 200 - 100, 100, math.random() * 200 - 100)
+    end)
+end)
+util.measure_memory("chunks_memory")
 
 player.delete(pid2)
 
@@ -34,6 +34,8 @@
             libpng
             freetype
             libvorbis
+            zstd
+            lz4
             openal
             luajit
             curl
@@ -71,20 +71,19 @@ function place_structures_wide(x, z, w, d, chunk_height)
 end
 
 function generate_heightmap(x, y, w, h, s, inputs)
-    local umap = Heightmap(w, h)
-    local vmap = Heightmap(w, h)
-    umap.noiseSeed = SEED
+    local graph = HeightmapGraph(w, h)
+    local vmap = graph:map()
     vmap.noiseSeed = SEED
     vmap:noise({x+521, y+70}, 0.1*s, 3, 25.8)
     vmap:noise({x+95, y+246}, 0.15*s, 3, 25.8)
 
-    local map = Heightmap(w, h)
+    local map = graph:map()
     map.noiseSeed = SEED
     map:noise({x, y}, 0.8*s, 4, 0.02)
-    map:cellnoise({x, y}, 0.1*s, 3, 0.3, umap, vmap)
+    map:cellnoise({x, y}, 0.1*s, 3, 0.3, nil, vmap)
     map:add(0.7)
 
-    local rivermap = Heightmap(w, h)
+    local rivermap = graph:map()
     rivermap.noiseSeed = SEED
     rivermap:noise({x+21, y+12}, 0.1*s, 4)
     rivermap:abs()
@@ -93,24 +92,25 @@ function generate_heightmap(x, y, w, h, s, inputs)
     rivermap:max(0.5)
     map:mul(rivermap)
 
-    local desertmap = Heightmap(w, h)
+    local desertmap = graph:map()
     desertmap.noiseSeed = SEED
     desertmap:cellnoise({x+52, y+326}, 0.3*s, 2, 0.2)
     desertmap:add(0.5)
     map:mixin(desertmap, inputs[1])
-    return map
+    return graph:evaluate(map)
 end
 
 function generate_biome_parameters(x, y, w, h, s)
-    local tempmap = Heightmap(w, h)
+    local graph = HeightmapGraph(w, h)
+    local tempmap = graph:map()
     tempmap.noiseSeed = SEED + 5324
     tempmap:noise({x, y}, 0.08*s, 6)
     tempmap:mul(0.5)
     tempmap:add(0.5)
-    local hummap = Heightmap(w, h)
+    local hummap = graph:map()
     hummap.noiseSeed = SEED + 953
     hummap:noise({x, y}, 0.08*s, 6)
     tempmap:pow(3)
     hummap:pow(3)
-    return tempmap, hummap
+    return graph:evaluate(tempmap, hummap)
 end
@@ -4,23 +4,39 @@ function ores.load(directory)
     ores.ores = file.read_combined_list(directory.."/ores.json")
 end
 
+-- xorshift32 sequence seeded by the chunk position
+local function chunk_random(seed, x, z)
+    local state = bit.bxor(seed, x * 73856093, z * 19349663)
+    if state == 0 then
+        state = 1
+    end
+    return function()
+        state = bit.bxor(state, bit.lshift(state, 13))
+        state = bit.bxor(state, bit.rshift(state, 17))
+        state = bit.bxor(state, bit.lshift(state, 5))
+        return bit.band(state, 0xFFFFFF) / 0x1000000
+    end
+end
+
 function ores.place(placements, x, z, w, d, seed, hmap, chunk_height)
     local BLOCKS_PER_CHUNK = w * d * chunk_height
+    -- placements must not depend on the chunks generation order
+    local rng = chunk_random(seed, x, z)
     for _, ore in ipairs(ores.ores) do
         local count = BLOCKS_PER_CHUNK / ore.rarity
 
         -- average count is less than 1
         local addchance = math.fmod(count, 1.0)
-        if math.random() < addchance then
+        if rng() < addchance then
             count = count + 1
         end
 
         for i=1,count do
-            local sx = math.random() * w
-            local sz = math.random() * d
-            local sy = math.random() * (chunk_height * 0.5) + 6
+            local sx = rng() * w
+            local sz = rng() * d
+            local sy = rng() * (chunk_height * 0.5) + 6
             if sy < hmap:at(sx, sz) * chunk_height - 6 then
-                table.insert(placements, {ore.struct, {sx, sy, sz}, math.random()*4, -1})
+                table.insert(placements, {ore.struct, {sx, sy, sz}, rng()*4, -1})
             end
         end
     end
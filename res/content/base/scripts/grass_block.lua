@@ -1,9 +1,7 @@
-function on_random_update(x, y, z)
-    local dirtid = block.index('base:dirt');
+local function update_grass(x, y, z, dirtid, grassblockid)
     if block.is_solid_at(x, y+1, z) then
         block.set(x, y, z, dirtid, 0)
     else
-        local grassblockid = block.index('base:grass_block')
         for lx=-1,1 do
             for ly=-1,1 do
                 for lz=-1,1 do
@@ -18,3 +16,15 @@ function on_random_update(x, y, z)
         end
     end
 end
+
+function on_random_updates(positions, count)
+    local dirtid = block.index('base:dirt')
+    local grassblockid = block.index('base:grass_block')
+    for i=1, count * 3, 3 do
+        local x, y, z = positions[i], positions[i + 1], positions[i + 2]
+        -- block may be changed since the update was collected
+        if block.get(x, y, z) == grassblockid then
+            update_grass(x, y, z, dirtid, grassblockid)
+        end
+    end
+end
@@ -4,7 +4,7 @@
 function vec3.add(a, b, dst)
     local btype = type(b)
     if dst then
-        if btype == "table" then
+        if btype ~= "number" then
             dst[1] = a[1] + b[1]
             dst[2] = a[2] + b[2]
             dst[3] = a[3] + b[3]
@@ -15,7 +15,7 @@ function vec3.add(a, b, dst)
         end
         return dst
     else
-        if btype == "table" then
+        if btype ~= "number" then
             return {a[1] + b[1], a[2] + b[2], a[3] + b[3]}
         else
             return {a[1] + b, a[2] + b, a[3] + b}
@@ -26,7 +26,7 @@ end
 function vec3.sub(a, b, dst)
     local btype = type(b)
     if dst then
-        if btype == "table" then
+        if btype ~= "number" then
             dst[1] = a[1] - b[1]
             dst[2] = a[2] - b[2]
             dst[3] = a[3] - b[3]
@@ -37,7 +37,7 @@ function vec3.sub(a, b, dst)
         end
         return dst
     else
-        if btype == "table" then
+        if btype ~= "number" then
             return {a[1] - b[1], a[2] - b[2], a[3] - b[3]}
         else
             return {a[1] - b, a[2] - b, a[3] - b}
@@ -48,7 +48,7 @@ end
 function vec3.mul(a, b, dst)
     local btype = type(b)
     if dst then
-        if btype == "table" then
+        if btype ~= "number" then
             dst[1] = a[1] * b[1]
             dst[2] = a[2] * b[2]
             dst[3] = a[3] * b[3]
@@ -59,7 +59,7 @@ function vec3.mul(a, b, dst)
         end
         return dst
     else
-        if btype == "table" then
+        if btype ~= "number" then
             return {a[1] * b[1], a[2] * b[2], a[3] * b[3]}
         else
             return {a[1] * b, a[2] * b, a[3] * b}
@@ -70,7 +70,7 @@ end
 function vec3.div(a, b, dst)
     local btype = type(b)
     if dst then
-        if btype == "table" then
+        if btype ~= "number" then
             dst[1] = a[1] / b[1]
             dst[2] = a[2] / b[2]
             dst[3] = a[3] / b[3]
@@ -81,7 +81,7 @@ function vec3.div(a, b, dst)
         end
         return dst
     else
-        if btype == "table" then
+        if btype ~= "number" then
             return {a[1] / b[1], a[2] / b[2], a[3] / b[3]}
         else
             return {a[1] / b, a[2] / b, a[3] / b}
@@ -131,7 +131,7 @@ end
 function vec2.add(a, b, dst)
     local btype = type(b)
     if dst then
-        if btype == "table" then
+        if btype ~= "number" then
             dst[1] = a[1] + b[1]
             dst[2] = a[2] + b[2]
         else
@@ -140,7 +140,7 @@ function vec2.add(a, b, dst)
         end
         return dst
     else
-        if btype == "table" then
+        if btype ~= "number" then
             return {a[1] + b[1], a[2] + b[2]}
         else
             return {a[1] + b, a[2] + b}
@@ -151,7 +151,7 @@ end
 function vec2.sub(a, b, dst)
     local btype = type(b)
     if dst then
-        if btype == "table" then
+        if btype ~= "number" then
             dst[1] = a[1] - b[1]
             dst[2] = a[2] - b[2]
         else
@@ -160,7 +160,7 @@ function vec2.sub(a, b, dst)
         end
         return dst
     else
-        if btype == "table" then
+        if btype ~= "number" then
             return {a[1] - b[1], a[2] - b[2]}
         else
             return {a[1] - b, a[2] - b}
@@ -171,7 +171,7 @@ end
 function vec2.mul(a, b, dst)
     local btype = type(b)
     if dst then
-        if btype == "table" then
+        if btype ~= "number" then
             dst[1] = a[1] * b[1]
             dst[2] = a[2] * b[2]
         else
@@ -180,7 +180,7 @@ function vec2.mul(a, b, dst)
         end
         return dst
     else
-        if btype == "table" then
+        if btype ~= "number" then
             return {a[1] * b[1], a[2] * b[2]}
         else
             return {a[1] * b, a[2] * b}
@@ -191,7 +191,7 @@ end
 function vec2.div(a, b, dst)
     local btype = type(b)
     if dst then
-        if btype == "table" then
+        if btype ~= "number" then
             dst[1] = a[1] / b[1]
             dst[2] = a[2] / b[2]
         else
@@ -200,7 +200,7 @@ function vec2.div(a, b, dst)
         end
         return dst
     else
-        if btype == "table" then
+        if btype ~= "number" then
             return {a[1] / b[1], a[2] / b[2]}
         else
             return {a[1] / b, a[2] / b}
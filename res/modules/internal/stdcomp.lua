@@ -1,12 +1,14 @@
 -- Standard components OOP wrappers (__index tables of metatables)
 
 local Transform = {__index={
-    get_pos=function(self) return __transform.get_pos(self.eid) end,
+    get_pos=function(self, dst) return __transform.get_pos(self.eid, dst) end,
     set_pos=function(self, v) return __transform.set_pos(self.eid, v) end,
-    get_size=function(self) return __transform.get_size(self.eid) end,
+    get_size=function(self, dst) return __transform.get_size(self.eid, dst) end,
     set_size=function(self, v) return __transform.set_size(self.eid, v) end,
     get_rot=function(self) return __transform.get_rot(self.eid) end,
     set_rot=function(self, m) return __transform.set_rot(self.eid, m) end,
+    get_state=function(self, pos, vel) return __transform.get_state(self.eid, pos, vel) end,
+    set_state=function(self, pos, rot, vel) return __transform.set_state(self.eid, pos, rot, vel) end,
 }}
 
 local function new_Transform(eid)
@@ -16,9 +18,9 @@ end
 local Rigidbody = {__index={
     is_enabled=function(self) return __rigidbody.is_enabled(self.eid) end,
     set_enabled=function(self, b) return __rigidbody.set_enabled(self.eid, b) end,
-    get_vel=function(self) return __rigidbody.get_vel(self.eid) end,
+    get_vel=function(self, dst) return __rigidbody.get_vel(self.eid, dst) end,
     set_vel=function(self, v) return __rigidbody.set_vel(self.eid, v) end,
-    get_size=function(self) return __rigidbody.get_size(self.eid) end,
+    get_size=function(self, dst) return __rigidbody.get_size(self.eid, dst) end,
     set_size=function(self, v) return __rigidbody.set_size(self.eid, v) end,
     get_gravity_scale=function(self) return __rigidbody.get_gravity_scale(self.eid) end,
     set_gravity_scale=function(self, s) return __rigidbody.set_gravity_scale(self.eid, s) end,
@@ -95,6 +97,51 @@ local Entity = {__index={
 }}
 
 local entities = {}
+local update_cycle = 0
+
+-- Components having a callback grouped by component name:
+-- callback name -> component name -> dense array of entries
+local groups = {
+    on_update = {},
+    on_physics_update = {},
+    on_render = {},
+}
+
+local function add_entry(callback, name, entry)
+    local group = groups[callback][name]
+    if not group then
+        group = {}
+        groups[callback][name] = group
+    end
+    local index = #group + 1
+    group[index] = entry
+    entry.indices[callback] = index
+end
+
+local function remove_entry(callback, name, entry)
+    local group = groups[callback][name]
+    local index = entry.indices[callback]
+    local last = group[#group]
+    group[index] = last
+    last.indices[callback] = index
+    group[#group] = nil
+end
+
+-- Returns nil if component is not updated in the current cycle
+local function get_update_tps(entity, entry, tps)
+    local rate = entity.__rate
+    if rate == 0 then
+        return nil
+    end
+    rate = (rate or 1) * entry.interval
+    if rate == 1 then
+        return tps
+    end
+    if (update_cycle + entry.eid) % rate ~= 0 then
+        return nil
+    end
+    return tps / rate
+end
 
 return {
     new_Entity = function(eid)
@@ -109,33 +156,83 @@ return {
     get_Entity = function(eid)
         return entities[eid]
     end,
+    -- Called after all entity components are created
+    register_components = function(eid)
+        local entity = entities[eid]
+        local entries = {}
+        for name, component in pairs(entity.components) do
+            local interval = component.UPDATE_INTERVAL
+            local entry = {
+                eid=eid,
+                entity=entity,
+                component=component,
+                interval=interval and math.max(1, math.floor(interval)) or 1,
+                indices={}
+            }
+            for callback, _ in pairs(groups) do
+                if component[callback] then
+                    add_entry(callback, name, entry)
+                end
+            end
+            entries[name] = entry
+        end
+        entity.__entries = entries
+    end,
     remove_Entity = function(eid)
         local entity = entities[eid]
         if entity then
+            for name, entry in pairs(entity.__entries or {}) do
+                for callback, _ in pairs(entry.indices) do
+                    remove_entry(callback, name, entry)
+                end
+            end
+            entity.__entries = nil
             entity.components = nil
             entities[eid] = nil;
         end
     end,
+    set_rate = function(eid, rate)
+        local entity = entities[eid]
+        if entity then
+            -- nil for full rate
+            entity.__rate = rate ~= 1 and rate or nil
+        end
+    end,
     update = function(tps, parts, part)
-        for uid, entity in pairs(entities) do
-            if uid % parts ~= part then
-                goto continue
-            end
-            for _, component in pairs(entity.components) do
+        if part == 0 then
+            update_cycle = update_cycle + 1
+        end
+        for _, group in pairs(groups.on_update) do
+            -- iterating backwards as callbacks may despawn entities
+            for i = #group, 1, -1 do
+                local entry = group[i]
+                if not entry or entry.eid % parts ~= part then
+                    goto continue
+                end
+                local component = entry.component
+                if component.__disabled then
+                    goto continue
+                end
+                local entity_tps = get_update_tps(entry.entity, entry, tps)
                 local callback = component.on_update
-                if not component.__disabled and callback then
-                    local result, err = pcall(callback, tps)
+                if entity_tps and callback then
+                    local result, err = pcall(callback, entity_tps)
                     if err then
                         debug.error(err)
                     end
                 end
+                ::continue::
             end
-            ::continue::
         end
     end,
     physics_update = function(delta)
-        for uid, entity in pairs(entities) do
-            for _, component in pairs(entity.components) do
+        for _, group in pairs(groups.on_physics_update) do
+            for i = #group, 1, -1 do
+                local entry = group[i]
+                if not entry or entry.entity.__rate == 0 then
+                    goto continue
+                end
+                local component = entry.component
                 local callback = component.on_physics_update
                 if not component.__disabled and callback then
                     local result, err = pcall(callback, delta)
@@ -143,12 +240,18 @@ return {
                         debug.error(err)
                     end
                 end
+                ::continue::
             end
         end
     end,
     render = function(delta)
-        for _,entity in pairs(entities) do
-            for _, component in pairs(entity.components) do
+        for _, group in pairs(groups.on_render) do
+            for i = #group, 1, -1 do
+                local entry = group[i]
+                if not entry then
+                    goto continue
+                end
+                local component = entry.component
                 local callback = component.on_render
                 if not component.__disabled and callback then
                     local result, err = pcall(callback, delta)
@@ -156,6 +259,7 @@ return {
                         debug.error(err)
                     end
                 end
+                ::continue::
             end
         end
     end,
@@ -172,5 +276,8 @@ return {
     end,
     __reset = function()
         entities = {}
+        for callback, _ in pairs(groups) do
+            groups[callback] = {}
+        end
     end
 }
@@ -5,4 +5,71 @@ function util.create_demo_world(generator)
     app.new_world("demo", "2019", generator or "core:default")
 end
 
+--- Report a performance metric. Metrics are collected by vctest from the
+--- test output, written to the report and checked against the budget.
+--- Lower values are considered better.
+--- @param name metric name (without spaces)
+--- @param value measured value
+--- @param unit value unit ("ms", "s", "bytes", ...)
+--- @param budget maximum allowed value (optional)
+function util.report(name, value, unit, budget)
+    print(string.format(
+        "[METRIC] %s %.6g %s %s",
+        name, value, unit, budget and string.format("%.6g", budget) or "-"
+    ))
+    if budget and value > budget then
+        debug.warning(string.format(
+            "metric %s budget exceeded: %.6g > %.6g %s",
+            name, value, budget, unit
+        ))
+    end
+end
+
+--- Measure function execution time and report it in seconds
+--- @return measured time in seconds
+function util.measure_time(name, budget, func, ...)
+    local start = time.uptime()
+    func(...)
+    local elapsed = time.uptime() - start
+    util.report(name, elapsed, "s", budget)
+    return elapsed
+end
+
+--- Run the given number of ticks and report the ticks duration
+--- percentile in milliseconds
+--- @param name metric name
+--- @param ticks number of ticks
+--- @param budget maximum allowed duration in milliseconds (optional)
+--- @param percentile percentile in range [0, 100] (default: 99)
+--- @param callback function called before every tick (optional)
+--- @return measured ticks duration percentile in milliseconds
+function util.measure_ticks(name, ticks, budget, percentile, callback)
+    percentile = percentile or 99
+    local durations = {}
+    for i=1,ticks do
+        if callback then
+            callback(i)
+        end
+        local start = time.uptime()
+        app.tick()
+        durations[i] = (time.uptime() - start) * 1000
+    end
+    table.sort(durations)
+    local index = math.max(1, math.ceil(#durations * percentile / 100))
+    local value = durations[index] or 0
+    util.report(name, value, "ms", budget)
+    return value
+end
+
+--- Report the engine memory usage (see profiler.memory_stats)
+--- @param name metric name
+--- @param budget maximum allowed usage in bytes (optional)
+--- @param tag memory tag (default: "total")
+--- @return memory usage in bytes
+function util.measure_memory(name, budget, tag)
+    local value = profiler.memory_stats()[tag or "total"]
+    util.report(name, value, "bytes", budget)
+    return value
+end
+
 return util
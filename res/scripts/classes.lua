@@ -1,5 +1,5 @@
 local Camera = {__index={
-    get_pos=function(self) return cameras.get_pos(self.cid) end,
+    get_pos=function(self, dst) return cameras.get_pos(self.cid, dst) end,
     set_pos=function(self, v) return cameras.set_pos(self.cid, v) end,
     get_name=function(self) return cameras.name(self.cid) end,
     get_index=function(self) return self.cid end,
@@ -13,9 +13,9 @@ local Camera = {__index={
     set_perspective=function(self, b) return cameras.set_perspective(self.cid, b) end,
     is_flipped=function(self) return cameras.is_flipped(self.cid) end,
     set_flipped=function(self, b) return cameras.set_flipped(self.cid, b) end,
-    get_front=function(self) return cameras.get_front(self.cid) end,
-    get_right=function(self) return cameras.get_right(self.cid) end,
-    get_up=function(self) return cameras.get_up(self.cid) end,
+    get_front=function(self, dst) return cameras.get_front(self.cid, dst) end,
+    get_right=function(self, dst) return cameras.get_right(self.cid, dst) end,
+    get_up=function(self, dst) return cameras.get_up(self.cid, dst) end,
     look_at=function(self, v, f) return cameras.look_at(self.cid, v, f) end,
 }}
 
@@ -39,6 +39,11 @@ end
 local Socket = {__index={
     send=function(self, ...) return network.__send(self.id, ...) end,
     recv=function(self, ...) return network.__recv(self.id, ...) end,
+    recv_into=function(self, bytes, length)
+        return __vc_Socket_recv_into(self.id, bytes, length)
+    end,
+    peek=function(self, ...) return network.__peek(self.id, ...) end,
+    consume=function(self, length) return network.__consume(self.id, length) end,
     recv_async=function(self, length, usetable)
         while self:is_alive() do
             local available = self:available()
@@ -56,6 +61,10 @@ local Socket = {__index={
     get_address=function(self) return network.__get_address(self.id) end,
     set_nodelay=function(self, nodelay) return network.__set_nodelay(self.id, nodelay or false) end,
     is_nodelay=function(self) return network.__is_nodelay(self.id) end,
+    set_coalescing=function(self, flag) return network.__set_coalescing(self.id, flag or false) end,
+    is_coalescing=function(self) return network.__is_coalescing(self.id) end,
+    flush=function(self) return network.__flush(self.id) end,
+    get_stats=function(self) return network.get_stats(self.id) end,
 }}
 
 local WriteableSocket = {__index={
@@ -63,6 +72,7 @@ local WriteableSocket = {__index={
     close=function(self) return network.__close(self.id) end,
     is_open=function(self) return network.__is_alive(self.id) end,
     get_address=function(self) return network.__get_address(self.id) end,
+    get_stats=function(self) return network.get_stats(self.id) end,
 }}
 
 local ServerSocket = {__index={
@@ -75,7 +85,8 @@ local DatagramServerSocket = {__index={
     close=function(self) return network.__closeserver(self.id) end,
     is_open=function(self) return network.__is_serveropen(self.id) end,
     get_port=function(self) return network.__get_serverport(self.id) end,
-    send=function(self, ...) return network.__udp_server_send_to(self.id, ...) end
+    send=function(self, ...) return network.__udp_server_send_to(self.id, ...) end,
+    get_stats=function(self) return network.__get_server_stats(self.id) end,
 }}
 
 local _tcp_server_callbacks = {}
@@ -17,6 +17,10 @@ function set_jump_height(height)
     pathfinding.set_jump_height(agent, height)
 end
 
+function set_shared_target(shared)
+    pathfinding.set_shared_target(agent, shared)
+end
+
 function get_target()
     return target
 end
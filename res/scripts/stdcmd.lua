@@ -96,6 +96,85 @@ console.add_command(
         end
     end, true
 )
+console.add_command(
+    "profiler operation:[start|stop|clear|stats]",
+    "Control zones profiler. Operations: start, stop, clear, stats",
+    function(args, kwargs)
+        local operation = args[1]
+        if operation == "start" then
+            profiler.start()
+            return "Profiler started"
+        elseif operation == "stop" then
+            profiler.stop()
+            return "Profiler stopped"
+        elseif operation == "clear" then
+            profiler.clear()
+            return "Profiler events cleared"
+        end
+        local str = "Zones for the last second (total / max ms, calls):"
+        for _, zone in ipairs(profiler.get_stats(1.0)) do
+            str = str .. string.format(
+                "\n  %s: %.3f / %.3f, %d",
+                zone.name, zone.total, zone.max, zone.calls
+            )
+        end
+        return str
+    end
+)
+
+console.add_command(
+    "profiler.dump file:str='export:trace.json'",
+    "Save recorded profiler zones in Chrome trace format",
+    function(args, kwargs)
+        file.write(args[1], profiler.dump())
+        return "Trace saved to " .. args[1]
+    end
+)
+
+console.add_command(
+    "profiler.scripts operation:[start|stop|clear|stats] interval:int=10",
+    "Control scripts profiler. Operations: start, stop, clear, stats",
+    function(args, kwargs)
+        local operation = args[1]
+        if operation == "start" then
+            profiler.start_scripts(args[2])
+            return "Scripts profiler started"
+        elseif operation == "stop" then
+            profiler.stop_scripts()
+            return "Scripts profiler stopped"
+        elseif operation == "clear" then
+            profiler.clear()
+            return "Profiler events cleared"
+        end
+        local str = "Packs scripts (total ms, calls, allocated KB, samples):"
+        for _, pack in ipairs(profiler.get_scripts_stats()) do
+            str = str .. string.format(
+                "\n  %s: %.3f, %d, %.1f, %d",
+                pack.pack, pack.total, pack.calls,
+                pack.allocated / 1024, pack.samples
+            )
+            for i = 1, math.min(#pack.events, 3) do
+                local event = pack.events[i]
+                str = str .. string.format(
+                    "\n    %s: %.3f, %d, %.1f",
+                    event.name, event.total, event.calls,
+                    event.allocated / 1024
+                )
+            end
+        end
+        return str
+    end
+)
+
+console.add_command(
+    "profiler.scripts.dump file:str='export:scripts.folded'",
+    "Save scripts profiler samples as folded stacks (flamegraph)",
+    function(args, kwargs)
+        file.write(args[1], profiler.dump_scripts())
+        return "Stacks saved to " .. args[1]
+    end
+)
+
 console.add_command(
     "echo value:str",
     "Print value to the console",
@@ -314,3 +393,51 @@ console.add_command(
         return "available presets:" .. presets
     end
 )
+
+console.add_command(
+    "world.pregen radius:int x:int~pos.x z:int~pos.z",
+    "Pre-generate chunks in the radius (chunks) around the position",
+    function(args, kwargs)
+        local radius, x, z = unpack(args)
+        local cx = math.floor(x / 16)
+        local cz = math.floor(z / 16)
+        world.pregenerate(cx - radius, cz - radius, cx + radius, cz + radius)
+        local size = radius * 2 + 1
+        return string.format("Pre-generation of %d chunks started", size * size)
+    end, true
+)
+
+console.add_command(
+    "world.pregen.resume",
+    "Continue interrupted chunks pre-generation",
+    function(args, kwargs)
+        if world.pregenerate() then
+            return "Pre-generation continued"
+        end
+        return "No interrupted pre-generation found"
+    end, true
+)
+
+console.add_command(
+    "world.pregen.stop",
+    "Stop chunks pre-generation (continue with world.pregen.resume)",
+    function(args, kwargs)
+        world.stop_pregeneration()
+        return "Pre-generation stopped"
+    end
+)
+
+console.add_command(
+    "world.pregen.status",
+    "Show chunks pre-generation progress",
+    function(args, kwargs)
+        local status = world.get_pregeneration()
+        if not status then
+            return "Pre-generation is not running"
+        end
+        return string.format(
+            "Pre-generated %d/%d chunks (%.1f chunks/s)",
+            status.done, status.total, status.speed
+        )
+    end
+)
@@ -381,6 +381,71 @@ __vc_scripts_registry = require "core:internal/scripts_registry"
 file.open = require "core:internal/stream_providers/file"
 file.open_named_pipe = require "core:internal/stream_providers/named_pipe"
 
+local __async_callbacks = {}
+
+-- Performs request in a background thread. Result is passed to the callback
+-- at the next tick. Without callback the current coroutine is suspended
+-- until the result is ready
+local function async_request(callback, func, ...)
+    local id = func(...)
+    if callback then
+        __async_callbacks[id] = callback
+        return
+    end
+    if not coroutine.running() then
+        error("callback is required outside of a coroutine")
+    end
+    local done, result, err
+    __async_callbacks[id] = function(res, e)
+        done, result, err = true, res, e
+    end
+    while not done do
+        coroutine.yield()
+    end
+    if err then
+        error(err)
+    end
+    return result
+end
+
+local function process_async_results()
+    for _, entry in ipairs(file.__pull_async_results()) do
+        local id = entry[1]
+        local callback = __async_callbacks[id]
+        __async_callbacks[id] = nil
+        if callback then
+            local status, result = xpcall(callback, __vc__error, entry[2], entry[3])
+            if not status then
+                debug.error("error in async callback: "..result)
+            end
+        end
+    end
+end
+
+function file.read_async(path, callback)
+    return async_request(callback, file.__read_async, path, false)
+end
+
+function file.read_bytes_async(path, callback)
+    return async_request(callback, file.__read_async, path, true)
+end
+
+function file.write_async(path, text, callback)
+    async_request(callback, file.__write_async, path, tostring(text))
+end
+
+function file.write_bytes_async(path, bytes, callback)
+    async_request(callback, file.__write_async, path, bytes)
+end
+
+function compression.encode_async(bytes, algorithm, callback)
+    return async_request(callback, compression.__encode_async, bytes, algorithm)
+end
+
+function compression.decode_async(bytes, algorithm, callback)
+    return async_request(callback, compression.__decode_async, bytes, algorithm)
+end
+
 if ffi.os == "Windows" then
     ffi.cdef[[
     unsigned long GetCurrentProcessId();
@@ -529,6 +594,8 @@ function __vc_on_world_quit()
     gui_util:__reset_local()
     stdcomp.__reset()
     file.__close_all_descriptors()
+    -- pending operations are completed, but results are dropped
+    __async_callbacks = {}
 end
 
 local __post_runnables = {}
@@ -565,6 +632,7 @@ local function __vc__process_post_runnables()
     fn_audio_reset_fetch_buffer()
     debug.pull_events()
     network.__process_events()
+    process_async_results()
     if not hud or not hud.is_paused() then
         block.__process_register_events()
         block.__perform_ticks(time.delta())
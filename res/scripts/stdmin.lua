@@ -18,6 +18,35 @@ function crc32(bytes, chksum)
     return _crc32(bytes, chksum)
 end
 
+if _ffi then
+    -- stdmin may be executed in the same state twice
+    pcall(_ffi.cdef, "typedef struct { uint16_t id; uint16_t state; } vc_voxel;")
+end
+
+local function view_is_valid(self)
+    return self.handle:is_valid()
+end
+
+-- Wrap engine buffer view handle into a table with typed FFI pointer.
+-- The handle keeps the buffer alive while the view is referenced
+function __vc_wrap_view(handle)
+    if not _ffi then
+        error("ffi is not available")
+    end
+    local ctype = handle.type.."*"
+    if handle.readonly then
+        ctype = "const "..ctype
+    end
+    return {
+        ptr=_ffi.cast(ctype, handle.address),
+        length=handle.length,
+        type=handle.type,
+        readonly=handle.readonly,
+        handle=handle,
+        is_valid=view_is_valid,
+    }
+end
+
 -- Check if given table is an array
 function is_array(x)
     if #x > 0 then
@@ -64,6 +93,25 @@ function __vc_Canvas_set_data(self, data)
     self:_set_data(tostring(_ffi.cast("uintptr_t", canvas_ffi_buffer)), size)
 end
 
+-- Appends received data to the bytearray without intermediate copies
+function __vc_Socket_recv_into(id, bytes, length)
+    if type(bytes) ~= "cdata" then
+        error("Bytearray expected, got "..type(bytes))
+    end
+    local available = network.__available(id) or 0
+    length = math.min(length or available, available)
+    bytes:reserve(bytes.size + length)
+    local size = network.__recv_into(
+        id,
+        tostring(_ffi.cast("uintptr_t", bytes.bytes + bytes.size)),
+        length
+    )
+    if size then
+        bytes.size = bytes.size + size
+    end
+    return size
+end
+
 local ipairs_mt_supported = false
 for i, _ in ipairs(setmetatable({l={1}}, {
     __ipairs=function(self) return ipairs(self.l) end})) do
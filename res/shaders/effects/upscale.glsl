@@ -0,0 +1,30 @@
+#param float p_sharpness = 0.4
+
+vec3 fetch(ivec2 coord, ivec2 size) {
+    return texelFetch(u_screen, clamp(coord, ivec2(0), size - 1), 0).rgb;
+}
+
+// framebuffer textures use nearest filtering
+vec3 sample_bilinear(vec2 uv, ivec2 size) {
+    vec2 pos = uv * vec2(size) - 0.5;
+    ivec2 base = ivec2(floor(pos));
+    vec2 f = fract(pos);
+    vec3 a = mix(fetch(base, size), fetch(base + ivec2(1, 0), size), f.x);
+    vec3 b = mix(
+        fetch(base + ivec2(0, 1), size), fetch(base + ivec2(1, 1), size), f.x
+    );
+    return mix(a, b, f.y);
+}
+
+vec4 effect() {
+    ivec2 size = textureSize(u_screen, 0);
+    vec2 texel = 1.0 / vec2(size);
+    vec3 color = sample_bilinear(v_uv, size);
+    vec3 blur = (
+        sample_bilinear(v_uv + vec2(texel.x, 0.0), size) +
+        sample_bilinear(v_uv - vec2(texel.x, 0.0), size) +
+        sample_bilinear(v_uv + vec2(0.0, texel.y), size) +
+        sample_bilinear(v_uv - vec2(0.0, texel.y), size)
+    ) * 0.25;
+    return vec4(clamp(color + (color - blur) * p_sharpness, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,16 @@
+#ifndef ATLAS_GLSL_
+#define ATLAS_GLSL_
+
+// Sample atlas region repeated over a face (greedy meshing).
+// Zero region means uv is an atlas coordinate already.
+vec4 sample_atlas(sampler2D tex, vec2 uv, vec4 region) {
+    vec2 size = region.zw - region.xy;
+    if (size.x == 0.0) {
+        return texture(tex, uv);
+    }
+    return textureGrad(
+        tex, region.xy + fract(uv) * size, dFdx(uv) * size, dFdy(uv) * size
+    );
+}
+
+#endif // ATLAS_GLSL_
@@ -0,0 +1,22 @@
+#ifndef CHUNK_VERTEX_GLSL_
+#define CHUNK_VERTEX_GLSL_
+
+// Packed chunk vertex decode (see PackedChunkVertex in
+// src/graphics/render/commons.hpp)
+#define CHUNK_POSITION_SCALE 128.0
+#define CHUNK_POSITION_ORIGIN vec3(8.0, 128.0, 8.0)
+#define CHUNK_MAX_TILES 16.0
+
+vec3 decode_chunk_position(vec3 position) {
+    return position / CHUNK_POSITION_SCALE + CHUNK_POSITION_ORIGIN;
+}
+
+// Greedy faces tile coordinates are stored normalized
+vec2 decode_chunk_uv(vec2 uv, vec4 region) {
+    if (region.z == region.x) {
+        return uv;
+    }
+    return uv * CHUNK_MAX_TILES;
+}
+
+#endif // CHUNK_VERTEX_GLSL_
@@ -34,6 +34,10 @@ namespace assetload {
 
     using setupfunc = std::function<void(const Assets*)>;
 
+    /// @brief Load pending asset on demand
+    /// @return true if an asset with the name was pending
+    using resolvefunc = std::function<bool(const std::string& name)>;
+
     template <class T>
     void assets_setup(const Assets*);
 
@@ -69,6 +73,7 @@ class Assets {
     using assets_map = std::unordered_map<std::string, std::shared_ptr<void>>;
     std::unordered_map<std::type_index, assets_map> assets;
     std::vector<assetload::setupfunc> setupFuncs;
+    assetload::resolvefunc resolver;
 public:
     Assets() = default;
     Assets(const Assets&) = delete;
@@ -115,9 +120,15 @@ public:
         return std::static_pointer_cast<T>(found->second);
     }
 
+    /// @brief Get asset or load it immediately if it is still streamed
+    /// by the resolver
+    /// @throws std::runtime_error if asset not found
     template <class T>
     T& require(const std::string& name) const {
         T* asset = get<T>(name);
+        if (asset == nullptr && resolver && resolver(name)) {
+            asset = get<T>(name);
+        }
         if (asset == nullptr) {
             throw std::runtime_error(util::quote(name) + " not found");
         }
@@ -142,6 +153,10 @@ public:
     void addSetupFunc(assetload::setupfunc setupfunc) {
         setupFuncs.push_back(setupfunc);
     }
+
+    void setResolver(assetload::resolvefunc resolver) {
+        this->resolver = std::move(resolver);
+    }
 };
 
 template <class T>
@@ -19,7 +19,10 @@
 #include "util/ThreadPool.hpp"
 #include "voxels/Block.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
+#include <thread>
 #include <utility>
 
 namespace fs = std::filesystem;
@@ -43,23 +46,83 @@ void AssetsLoader::addLoader(AssetType tag, aloader_func func) {
     loaders[tag] = std::move(func);
 }
 
+static void insert_entry(
+    std::deque<aloader_entry>& entries, aloader_entry&& entry
+) {
+    auto position = std::upper_bound(
+        entries.begin(),
+        entries.end(),
+        entry.priority,
+        [](int priority, const aloader_entry& other) {
+            return priority > other.priority;
+        }
+    );
+    entries.insert(position, std::move(entry));
+}
+
 void AssetsLoader::add(
     AssetType tag,
     const std::string& filename,
     const std::string& alias,
-    std::shared_ptr<AssetCfg> settings
+    std::shared_ptr<AssetCfg> settings,
+    bool required,
+    int priority
 ) {
-    if (enqueued.find({tag, alias}) != enqueued.end()){
+    if (enqueued.find({tag, alias}) != enqueued.end()) {
+        if (!required) {
+            return;
+        }
+        // required now, so stop deferring it
+        auto found = std::find_if(
+            deferred.begin(),
+            deferred.end(),
+            [tag, &alias](const auto& entry) {
+                return entry.tag == tag && entry.alias == alias;
+            }
+        );
+        if (found != deferred.end()) {
+            aloader_entry entry = std::move(*found);
+            deferred.erase(found);
+            entry.required = true;
+            entry.priority = std::max(entry.priority, priority);
+            insert_entry(entries, std::move(entry));
+        }
         return;
     }
-    entries.push(aloader_entry {tag, filename, alias, std::move(settings)});
     enqueued.insert({tag, alias});
+    aloader_entry entry {
+        tag, filename, alias, std::move(settings), priority, required};
+    if (required) {
+        insert_entry(entries, std::move(entry));
+    } else {
+        deferred.push_back(std::move(entry));
+    }
+}
+
+void AssetsLoader::add(aloader_entry entry) {
+    if (!enqueued.insert({entry.tag, entry.alias}).second) {
+        return;
+    }
+    entry.required = true;
+    insert_entry(entries, std::move(entry));
 }
 
 bool AssetsLoader::hasNext() const {
     return !entries.empty();
 }
 
+std::vector<aloader_entry> AssetsLoader::takeDeferred() {
+    std::vector<aloader_entry> taken(
+        std::make_move_iterator(deferred.begin()),
+        std::make_move_iterator(deferred.end())
+    );
+    deferred.clear();
+    for (const auto& entry : taken) {
+        enqueued.erase({entry.tag, entry.alias});
+    }
+    return taken;
+}
+
 aloader_func AssetsLoader::getLoader(AssetType tag) {
     auto found = loaders.find(tag);
     if (found == loaders.end()) {
@@ -71,7 +134,12 @@ aloader_func AssetsLoader::getLoader(AssetType tag) {
 }
 
 void AssetsLoader::loadNext() {
-    const aloader_entry& entry = entries.front();
+    aloader_entry entry = std::move(entries.front());
+    entries.pop_front();
+    load(entry);
+}
+
+void AssetsLoader::load(const aloader_entry& entry) {
     logger.info() << "loading " << entry.filename << " as " << entry.alias;
 
     std::string error {};
@@ -87,12 +155,8 @@ void AssetsLoader::loadNext() {
     }
     if (!error.empty()) {
         logger.error() << error;
-        auto tag = entry.tag;
-        auto filename = entry.filename;
-        entries.pop();
-        throw assetload::error(tag, std::move(filename), std::move(error));
+        throw assetload::error(entry.tag, entry.filename, std::move(error));
     }
-    entries.pop();
 }
 
 static void add_layouts(
@@ -121,7 +185,8 @@ void AssetsLoader::tryAddSound(const std::string& name) {
         return;
     }
     std::string file = SOUNDS_FOLDER + "/" + name;
-    add(AssetType::SOUND, file, name);
+    // sounds are not required to show a screen
+    add(AssetType::SOUND, file, name, nullptr, false);
 }
 
 static std::string assets_def_folder(AssetType tag) {
@@ -153,12 +218,16 @@ void AssetsLoader::processPreload(
 ) {
     std::string defFolder = assets_def_folder(tag);
     std::string path = defFolder + "/" + name;
+    bool required = tag != AssetType::SOUND;
     if (map == nullptr) {
-        add(tag, path, name);
+        add(tag, path, name, nullptr, required);
         return;
     }
     std::shared_ptr<AssetCfg> config = nullptr;
+    int priority = 0;
     map.at("path").get(path);
+    map.at("required").get(required);
+    map.at("priority").get(priority);
     switch (tag) {
         case AssetType::SOUND: {
             bool keepPCM = false;
@@ -196,7 +265,7 @@ void AssetsLoader::processPreload(
         default:
             break;
     }
-    add(tag, path, name, std::move(config));
+    add(tag, path, name, std::move(config), required, priority);
 }
 
 void AssetsLoader::processPreloadList(AssetType tag, const dv::value& list) {
@@ -367,38 +436,110 @@ public:
     assetload::postfunc operator()(const aloader_entry& entry
     ) override {
         aloader_func loadfunc = loader->getLoader(entry.tag);
-        return loadfunc(
+        auto postfunc = loadfunc(
             loader,
             loader->getPaths(),
             entry.filename,
             entry.alias,
             entry.config
         );
+        return [loader = loader, alias = entry.alias, postfunc](
+                   Assets* assets
+               ) {
+            loader->setPerformed(alias);
+            postfunc(assets);
+        };
     }
 };
 
-std::shared_ptr<Task> AssetsLoader::startTask(runnable onDone, int maxWorkers) {
-    auto pool =
-        std::make_shared<util::ThreadPool<aloader_entry, assetload::postfunc>>(
-            "assets-loader-pool",
-            [=]() { return std::make_unique<LoaderWorker>(this); },
-            [this](const assetload::postfunc& func) { func(&assets); },
-            maxWorkers
-        );
+void AssetsLoader::setPerformed(const std::string& alias) {
+    std::lock_guard lock(pendingMutex);
+    auto found = pending.find(alias);
+    if (found != pending.end()) {
+        pending.erase(found);
+    }
+}
+
+bool AssetsLoader::isPending(const std::string& alias) {
+    std::lock_guard lock(pendingMutex);
+    return pending.find(alias) != pending.end();
+}
+
+std::shared_ptr<Task> AssetsLoader::startTask(
+    runnable onDone, int maxWorkers, bool stopOnFail
+) {
+    auto pool = std::make_shared<loader_pool>(
+        "assets-loader-pool",
+        [=]() { return std::make_unique<LoaderWorker>(this); },
+        [this](const assetload::postfunc& func) { func(&assets); },
+        maxWorkers
+    );
     pool->setOnComplete(std::move(onDone));
+    pool->setStopOnFail(stopOnFail);
+    pool->setOnJobFailed([this](aloader_entry& entry) {
+        setPerformed(entry.alias);
+    });
     pool->setJobsSource([this]() -> std::optional<aloader_entry> {
         if (entries.empty()) {
             return std::nullopt;
         }
         aloader_entry entry = std::move(entries.front());
-        entries.pop();
+        entries.pop_front();
+        std::lock_guard lock(pendingMutex);
+        pending.insert(entry.alias);
         return entry;
     });
 
     while (!entries.empty()) {
         aloader_entry entry = std::move(entries.front());
-        entries.pop();
-        pool->enqueueJob(std::move(entry));
+        entries.pop_front();
+        {
+            std::lock_guard lock(pendingMutex);
+            pending.insert(entry.alias);
+        }
+        int priority = entry.priority;
+        pool->enqueueJob(std::move(entry), priority);
     }
+    this->pool = pool;
     return pool;
 }
+
+bool AssetsLoader::resolve(const std::string& alias) {
+    std::vector<aloader_entry> found;
+    auto take = [&found, &alias](std::deque<aloader_entry>& entries) {
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->alias == alias) {
+                found.push_back(std::move(*it));
+                it = entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    };
+    take(entries);
+    take(deferred);
+
+    auto pool = this->pool.lock();
+    if (pool) {
+        auto cancelled = pool->cancelJobs([&alias](const aloader_entry& entry) {
+            return entry.alias == alias;
+        });
+        for (auto& entry : cancelled) {
+            setPerformed(entry.alias);
+            found.push_back(std::move(entry));
+        }
+    }
+    for (const auto& entry : found) {
+        load(entry);
+    }
+    if (pool == nullptr || !isPending(alias)) {
+        return !found.empty();
+    }
+    // already being loaded by a worker
+    logger.info() << "waiting for " << alias;
+    while (isPending(alias) && pool->isActive()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        pool->update();
+    }
+    return true;
+}
@@ -1,12 +1,14 @@
 #pragma once
 
+#include <deque>
 #include <functional>
 #include <map>
+#include <mutex>
 #include <set>
 #include <memory>
-#include <queue>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "delegates.hpp"
 #include "interfaces/Task.hpp"
@@ -24,6 +26,11 @@ namespace gui {
     class GUI;
 }
 
+namespace util {
+    template <class T, class R>
+    class ThreadPool;
+}
+
 struct AssetCfg {
     virtual ~AssetCfg() {
     }
@@ -79,18 +86,36 @@ struct aloader_entry {
     std::string filename;
     std::string alias;
     std::shared_ptr<AssetCfg> config;
+    /// @brief Entries with greater priority are loaded first
+    int priority = 0;
+    /// @brief Asset must be loaded before the next screen is shown.
+    /// Other entries are streamed in background after that
+    bool required = true;
 };
 
 class AssetsLoader {
+    friend class LoaderWorker;
+    using loader_pool = util::ThreadPool<aloader_entry, assetload::postfunc>;
+
     Engine& engine;
     Assets& assets;
     std::map<AssetType, aloader_func> loaders;
-    std::queue<aloader_entry> entries;
+    /// @brief Sorted by priority (descending)
+    std::deque<aloader_entry> entries;
+    std::deque<aloader_entry> deferred;
     std::set<std::pair<AssetType, std::string>> enqueued;
     const ResPaths& paths;
+    std::weak_ptr<loader_pool> pool;
+    /// @brief Aliases of entries taken by the pool and not performed yet
+    std::multiset<std::string> pending;
+    std::mutex pendingMutex;
 
     void tryAddSound(const std::string& name);
 
+    void load(const aloader_entry& entry);
+    void setPerformed(const std::string& alias);
+    bool isPending(const std::string& alias);
+
     void processPreload(
         AssetType tag, const std::string& name, const dv::value& map
     );
@@ -106,19 +131,39 @@ public:
     /// @param filename asset file path
     /// @param alias internal asset name
     /// @param settings asset loading settings (based on asset type)
+    /// @param required asset must be loaded before the next screen is 
+    /// shown, otherwise it's deferred
+    /// @param priority entries with greater priority are loaded first
     void add(
         AssetType tag,
         const std::string& filename,
         const std::string& alias,
-        std::shared_ptr<AssetCfg> settings = nullptr
+        std::shared_ptr<AssetCfg> settings = nullptr,
+        bool required = true,
+        int priority = 0
     );
 
+    /// @brief Enqueue entry (deferred entries are enqueued as required)
+    void add(aloader_entry entry);
+
     bool hasNext() const;
 
+    /// @brief Take entries deferred to be streamed in background
+    std::vector<aloader_entry> takeDeferred();
+
     /// @throws assetload::error
     void loadNext();
 
-    std::shared_ptr<Task> startTask(runnable onDone, int maxWorkers);
+    /// @param stopOnFail if false, failed entries are logged only
+    std::shared_ptr<Task> startTask(
+        runnable onDone, int maxWorkers, bool stopOnFail = true
+    );
+
+    /// @brief Load not performed yet entries with the alias immediately
+    /// (in the main thread) or wait for them if already being loaded
+    /// by the task workers
+    /// @return true if any entry was found
+    bool resolve(const std::string& alias);
 
     const ResPaths& getPaths() const;
     aloader_func getLoader(AssetType tag);
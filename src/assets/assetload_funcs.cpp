@@ -7,6 +7,7 @@
 
 #include "audio/audio.hpp"
 #include "coders/GLSLExtension.hpp"
+#include "coders/bcn.hpp"
 #include "coders/commons.hpp"
 #include "coders/imageio.hpp"
 #include "coders/json.hpp"
@@ -16,6 +17,7 @@
 #include "coders/vector_fonts.hpp"
 #include "constants.hpp"
 #include "debug/Logger.hpp"
+#include "engine/Engine.hpp"
 #include "engine/EnginePaths.hpp"
 #include "io/io.hpp"
 #include "frontend/UiDocument.hpp"
@@ -30,6 +32,8 @@
 #include "util/stringutil.hpp"
 #include "Assets.hpp"
 #include "AssetsLoader.hpp"
+#include "atlas_cache.hpp"
+#include "model_cache.hpp"
 
 static debug::Logger logger("assetload-funcs");
 
@@ -121,9 +125,30 @@ assetload::postfunc assetload::posteffect(
     std::string effectSource = io::read_string(effectFile);
 
     auto& preprocessor = *Shader::preprocessor;
-    preprocessor.addHeader(
-        "__effect__", preprocessor.process(effectFile, effectSource, true, {})
-    );
+    auto header = preprocessor.process(effectFile, effectSource, true, {});
+
+    bool advanced = false;
+    if (settings) {
+        advanced = dynamic_cast<const PostEffectCfg*>(settings.get())->advanced;
+    }
+    std::shared_ptr<PostEffect::FusionSource> fusion;
+    if (!advanced) {
+        auto code = PostEffect::toFusableCode(header.code);
+        if (!code.empty()) {
+            const std::string program = SHADERS_FOLDER + "/effect";
+            auto [vertexRaw, fragmentRaw] = read_program(paths, program);
+            fusion = std::make_shared<PostEffect::FusionSource>(
+                PostEffect::FusionSource {
+                    std::move(code),
+                    paths.find(program + ".glslv").string(),
+                    std::move(vertexRaw),
+                    paths.find(program + ".glslf").string(),
+                    std::move(fragmentRaw),
+                }
+            );
+        }
+    }
+    preprocessor.addHeader("__effect__", std::move(header));
 
     auto [vertex, fragment] = process_program(paths, SHADERS_FOLDER + "/effect");
     auto params = std::move(fragment.params);
@@ -136,12 +161,10 @@ assetload::postfunc assetload::posteffect(
             {effectFile.string(), vertexSource},
             {effectFile.string(), fragmentSource}
         );
-        bool advanced = false;
-        if (settings) {
-            advanced = dynamic_cast<const PostEffectCfg*>(settings.get())->advanced;
-        }
         assets->store(
-            std::make_shared<PostEffect>(advanced, std::move(program), params),
+            std::make_shared<PostEffect>(
+                advanced, std::move(program), params, fusion
+            ),
             name
         );
     };
@@ -159,6 +182,19 @@ static bool append_atlas(AtlasBuilder& atlas, const io::path& file) {
     return true;
 }
 
+static bool has_animations(
+    const ResPaths& paths,
+    const std::string& directory,
+    const std::set<std::string>& names
+) {
+    for (const auto& folder : paths.listdir(directory + "/animation")) {
+        if (names.find(folder.name()) != names.end()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 assetload::postfunc assetload::atlas(
     AssetsLoader* loader,
     const ResPaths& paths,
@@ -179,13 +215,44 @@ assetload::postfunc assetload::atlas(
         }
         return [](auto){};
     }
-    AtlasBuilder builder;
+    std::vector<io::path> files;
     for (const auto& file : paths.listdir(directory)) {
-        if (!imageio::is_read_supported(file.extension())) continue;
-        if (!append_atlas(builder, file)) continue;
+        if (imageio::is_read_supported(file.extension())) {
+            files.push_back(file);
+        }
+    }
+    uint64_t key = atlas_cache::compute_key(files, ATLAS_EXTRUSION);
+    std::set<std::string> names;
+    bool modified = false;
+    Atlas* atlas = atlas_cache::load(name, key).release();
+    if (atlas) {
+        for (const auto& [regionName, _] : atlas->getRegions()) {
+            names.insert(regionName);
+        }
+    } else {
+        AtlasBuilder builder;
+        for (const auto& file : files) {
+            append_atlas(builder, file);
+        }
+        names = builder.getNames();
+        atlas = builder.build(ATLAS_EXTRUSION, false).release();
+        modified = true;
+    }
+    const auto& settings = loader->getEngine().getSettings().graphics;
+    // animations are drawn to the atlas texture via framebuffer
+    bool compress = settings.atlasCompression.get() &&
+                    !has_animations(paths, directory, names);
+    if (compress && atlas->getCompressed() == nullptr) {
+        atlas->setCompressed(bcn::compress(*atlas->getImage(), 2));
+        modified = true;
+    }
+    if (modified) {
+        atlas_cache::save(name, key, *atlas);
+    }
+    if (!compress) {
+        atlas->setCompressed(nullptr);
+        atlas->generateMipmaps(ATLAS_MIP_LEVELS, ATLAS_EXTRUSION);
     }
-    std::set<std::string> names = builder.getNames();
-    Atlas* atlas = builder.build(ATLAS_EXTRUSION, false).release();
     return [=](auto assets) {
         atlas->prepare();
         assets->store(std::unique_ptr<Atlas>(atlas), name);
@@ -324,6 +391,20 @@ static void request_textures(AssetsLoader* loader, const model::Model& model) {
     }
 }
 
+static assetload::postfunc make_model_storer(
+    AssetsLoader* loader,
+    const std::string& name,
+    std::unique_ptr<model::Model> model
+) {
+    auto modelPtr = model.release();
+    return [=](Assets* assets) {
+        auto model = std::unique_ptr<model::Model>(modelPtr);
+        request_textures(loader, *model);
+        assets->store(std::move(model), name);
+        logger.info() << "store model " << util::quote(name);
+    };
+}
+
 assetload::postfunc assetload::model(
     AssetsLoader* loader,
     const ResPaths& paths,
@@ -371,17 +452,19 @@ assetload::postfunc assetload::model(
     }
     path = paths.find(file + ".obj");
     if (io::exists(path)) {
-        auto text = io::read_string(path);
-        try {
-            auto model = obj::parse(path.string(), text).release();
-            return [=](Assets* assets) {
-                request_textures(loader, *model);
-                assets->store(std::unique_ptr<model::Model>(model), name);
-            };
-        } catch (const parsing_error& err) {
-            std::cerr << err.errorLog() << std::endl;
-            throw;
+        uint64_t key = model_cache::compute_key(path, false);
+        auto model = model_cache::load(name, key);
+        if (model == nullptr) {
+            auto view = io::read_view(path);
+            try {
+                model = obj::parse(path.string(), view.text());
+            } catch (const parsing_error& err) {
+                std::cerr << err.errorLog() << std::endl;
+                throw;
+            }
+            model_cache::save(name, key, *model);
         }
+        return make_model_storer(loader, name, std::move(model));
     }
 
     std::array<std::string, 2> extensions {
@@ -401,20 +484,24 @@ assetload::postfunc assetload::model(
         throw std::runtime_error("could not to find model " + util::quote(file));
     }
 
-    auto text = io::read_string(path);
+    // models with skeleton are not cached
+    uint64_t key = model_cache::compute_key(path, cfg && cfg->squashed);
+    if (auto model = model_cache::load(name, key)) {
+        return make_model_storer(loader, name, std::move(model));
+    }
+
+    auto view = io::read_view(path);
     try {
-        auto vcmModel = vcm::parse(path.string(), text, path.extension() == ".xml");
+        auto vcmModel = vcm::parse(
+            path.string(), view.text(), path.extension() == ".xml"
+        );
 
         assert(vcmModel.parts.size() > 0);
 
         if (vcmModel.parts.size() == 1 || (cfg && cfg->squashed)) {
-            auto modelPtr = std::make_unique<model::Model>(std::move(vcmModel.squash())).release();
-            return [=](Assets* assets) {
-                auto model = std::unique_ptr<model::Model>(modelPtr);
-                request_textures(loader, *model);
-                assets->store(std::move(model), name);
-                logger.info() << "store model " << util::quote(name);
-            };
+            auto model = std::make_unique<model::Model>(std::move(vcmModel.squash()));
+            model_cache::save(name, key, *model);
+            return make_model_storer(loader, name, std::move(model));
         } else {
             auto vcmModelPtr = std::make_unique<vcm::VcmModel>(std::move(vcmModel)).release();
             return [=](Assets* assets) {
@@ -581,7 +668,10 @@ static bool load_animation(
             }
             if (!append_atlas(builder, file)) continue;
         }
-        auto srcAtlas = builder.build(ATLAS_EXTRUSION, true);
+        // frames are drawn to each mip level of the atlas
+        auto srcAtlas = builder.build(ATLAS_EXTRUSION, false);
+        srcAtlas->generateMipmaps(ATLAS_MIP_LEVELS, ATLAS_EXTRUSION);
+        srcAtlas->prepare();
         if (frameList.empty()) {
             for (const auto& frameName : builder.getNames()) {
                 frameList.emplace_back(frameName, 0);
@@ -0,0 +1,162 @@
+#include "atlas_cache.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "coders/bcn.hpp"
+#include "coders/byte_utils.hpp"
+#include "coders/compression.hpp"
+#include "debug/Logger.hpp"
+#include "graphics/core/Atlas.hpp"
+#include "graphics/core/ImageData.hpp"
+#include "io/io.hpp"
+#include "util/Hasher.hpp"
+
+static debug::Logger logger("atlas-cache");
+
+static const io::path CACHE_FOLDER = "user:cache/atlases";
+static constexpr const char* CACHE_MAGIC = ".VCATLAS";
+static constexpr int CACHE_MAGIC_SIZE = 8;
+static constexpr int CACHE_VERSION = 2;
+
+static io::path get_cache_file(std::string name) {
+    std::replace(name.begin(), name.end(), '/', '.');
+    std::replace(name.begin(), name.end(), ':', '.');
+    return CACHE_FOLDER / (name + ".bin");
+}
+
+uint64_t atlas_cache::compute_key(
+    const std::vector<io::path>& files, uint extrusion
+) {
+    util::Hasher hasher;
+    hasher.update(CACHE_VERSION);
+    hasher.update(extrusion);
+    for (const auto& file : files) {
+        hasher.update(file.string());
+        hasher.update(static_cast<uint64_t>(io::file_size(file)));
+        hasher.update(static_cast<int64_t>(
+            io::last_write_time(file).time_since_epoch().count()
+        ));
+    }
+    return hasher.get();
+}
+
+std::unique_ptr<Atlas> atlas_cache::load(const std::string& name, uint64_t key) {
+    auto file = get_cache_file(name);
+    if (!io::is_regular_file(file)) {
+        return nullptr;
+    }
+    try {
+        auto bytes = io::read_bytes_buffer(file);
+        ByteReader reader(bytes.data(), bytes.size());
+        reader.checkMagic(CACHE_MAGIC, CACHE_MAGIC_SIZE);
+        if (reader.getInt32() != CACHE_VERSION ||
+            static_cast<uint64_t>(reader.getInt64()) != key) {
+            return nullptr;
+        }
+        uint width = reader.getInt32();
+        uint height = reader.getInt32();
+
+        int regionsCount = reader.getInt32();
+        std::unordered_map<std::string, UVRegion> regions;
+        for (int i = 0; i < regionsCount; i++) {
+            auto regionName = reader.getString();
+            float u1 = reader.getFloat32();
+            float v1 = reader.getFloat32();
+            float u2 = reader.getFloat32();
+            float v2 = reader.getFloat32();
+            regions[regionName] = UVRegion(u1, v1, u2, v2);
+        }
+        size_t srcSize = width * height * 4;
+        size_t dataSize = reader.getInt32();
+        if (dataSize > reader.remaining()) {
+            throw std::runtime_error("buffer underflow");
+        }
+        auto data = compression::decompress(
+            reader.pointer(), dataSize, srcSize, compression::Method::LZ4
+        );
+        reader.skip(dataSize);
+        auto image = std::make_unique<ImageData>(
+            ImageFormat::RGBA8888, width, height, std::move(data)
+        );
+        auto atlas = std::make_unique<Atlas>(std::move(image), regions, false);
+
+        int levelsCount = reader.get();
+        if (levelsCount > 0) {
+            auto format = static_cast<bcn::Format>(reader.get());
+            auto compressed = std::make_shared<bcn::CompressedImage>(
+                bcn::CompressedImage {format, width, height, {}}
+            );
+            uint levelWidth = width;
+            uint levelHeight = height;
+            for (int i = 0; i < levelsCount; i++) {
+                size_t size = bcn::get_data_size(format, levelWidth, levelHeight);
+                if (size > reader.remaining()) {
+                    throw std::runtime_error("buffer underflow");
+                }
+                compressed->levels.emplace_back(
+                    reader.pointer(), reader.pointer() + size
+                );
+                reader.skip(size);
+                levelWidth = std::max(1u, levelWidth / 2);
+                levelHeight = std::max(1u, levelHeight / 2);
+            }
+            atlas->setCompressed(std::move(compressed));
+        }
+        return atlas;
+    } catch (const std::runtime_error& err) {
+        logger.error() << "could not read " << file.string() << ": "
+                       << err.what();
+        return nullptr;
+    }
+}
+
+void atlas_cache::save(
+    const std::string& name, uint64_t key, const Atlas& atlas
+) {
+    auto image = atlas.getImage();
+    if (image->getFormat() != ImageFormat::RGBA8888) {
+        return;
+    }
+    ByteBuilder builder;
+    builder.put(reinterpret_cast<const ubyte*>(CACHE_MAGIC), CACHE_MAGIC_SIZE);
+    builder.putInt32(CACHE_VERSION);
+    builder.putInt64(static_cast<int64_t>(key));
+    builder.putInt32(image->getWidth());
+    builder.putInt32(image->getHeight());
+
+    const auto& regions = atlas.getRegions();
+    builder.putInt32(regions.size());
+    for (const auto& [regionName, region] : regions) {
+        builder.put(regionName);
+        builder.putFloat32(region.u1);
+        builder.putFloat32(region.v1);
+        builder.putFloat32(region.u2);
+        builder.putFloat32(region.v2);
+    }
+    size_t length;
+    auto data = compression::compress(
+        image->getData(), image->getDataSize(), length, compression::Method::LZ4
+    );
+    builder.putInt32(length);
+    builder.put(data.get(), length);
+
+    if (auto compressed = atlas.getCompressed()) {
+        builder.put(static_cast<ubyte>(compressed->levels.size()));
+        builder.put(static_cast<ubyte>(compressed->format));
+        for (const auto& level : compressed->levels) {
+            builder.put(level.data(), level.size());
+        }
+    } else {
+        builder.put(static_cast<ubyte>(0));
+    }
+
+    auto file = get_cache_file(name);
+    try {
+        io::create_directories(CACHE_FOLDER);
+        io::write_bytes(file, builder.data(), builder.size());
+    } catch (const std::runtime_error& err) {
+        logger.error() << "could not write " << file.string() << ": "
+                       << err.what();
+    }
+}
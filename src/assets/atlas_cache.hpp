@@ -0,0 +1,31 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "io/fwd.hpp"
+#include "typedefs.hpp"
+
+class Atlas;
+
+/// @brief On-disk cache of built atlases (raster, regions and optional
+/// block compressed levels), so warm start doesn't decode and pack
+/// source images
+namespace atlas_cache {
+    /// @brief Compute cache key of atlas source images
+    /// @param files source image files
+    /// @param extrusion atlas builder extrusion
+    uint64_t compute_key(const std::vector<io::path>& files, uint extrusion);
+
+    /// @brief Load cached atlas (texture is not generated)
+    /// @param name atlas name
+    /// @param key source images key
+    /// @return nullptr if cache entry is missing or outdated
+    std::unique_ptr<Atlas> load(const std::string& name, uint64_t key);
+
+    /// @brief Write atlas raster and regions to cache
+    /// @param name atlas name
+    /// @param key source images key
+    void save(const std::string& name, uint64_t key, const Atlas& atlas);
+}
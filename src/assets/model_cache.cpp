@@ -0,0 +1,125 @@
+#include "model_cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "coders/byte_utils.hpp"
+#include "debug/Logger.hpp"
+#include "graphics/commons/Model.hpp"
+#include "io/io.hpp"
+#include "util/Hasher.hpp"
+
+static debug::Logger logger("model-cache");
+
+static const io::path CACHE_FOLDER = "user:cache/models";
+static constexpr const char* CACHE_MAGIC = ".VCMODEL";
+static constexpr int CACHE_MAGIC_SIZE = 8;
+static constexpr int CACHE_VERSION = 1;
+
+static_assert(
+    sizeof(model::Vertex) == 8 * sizeof(float),
+    "vertices are stored as raw floats"
+);
+
+static io::path get_cache_file(std::string name) {
+    std::replace(name.begin(), name.end(), '/', '.');
+    std::replace(name.begin(), name.end(), ':', '.');
+    return CACHE_FOLDER / (name + ".bin");
+}
+
+uint64_t model_cache::compute_key(const io::path& file, bool squashed) {
+    util::Hasher hasher;
+    hasher.update(CACHE_VERSION);
+    hasher.update(squashed);
+    hasher.update(file.string());
+    hasher.update(static_cast<uint64_t>(io::file_size(file)));
+    hasher.update(static_cast<int64_t>(
+        io::last_write_time(file).time_since_epoch().count()
+    ));
+    return hasher.get();
+}
+
+std::vector<ubyte> model_cache::serialize(
+    uint64_t key, const model::Model& model
+) {
+    ByteBuilder builder;
+    builder.put(reinterpret_cast<const ubyte*>(CACHE_MAGIC), CACHE_MAGIC_SIZE);
+    builder.putInt32(CACHE_VERSION);
+    builder.putInt64(static_cast<int64_t>(key));
+    builder.putInt32(model.meshes.size());
+    for (const auto& mesh : model.meshes) {
+        builder.put(mesh.texture);
+        builder.put(static_cast<ubyte>(mesh.shading));
+        builder.putInt32(mesh.vertices.size());
+        builder.put(
+            reinterpret_cast<const ubyte*>(mesh.vertices.data()),
+            mesh.vertices.size() * sizeof(model::Vertex)
+        );
+    }
+    return builder.build();
+}
+
+std::unique_ptr<model::Model> model_cache::deserialize(
+    const ubyte* bytes, size_t size, uint64_t key
+) {
+    ByteReader reader(bytes, size);
+    reader.checkMagic(CACHE_MAGIC, CACHE_MAGIC_SIZE);
+    if (reader.getInt32() != CACHE_VERSION ||
+        static_cast<uint64_t>(reader.getInt64()) != key) {
+        return nullptr;
+    }
+    auto model = std::make_unique<model::Model>();
+    int meshesCount = reader.getInt32();
+    if (meshesCount < 0 ||
+        static_cast<size_t>(meshesCount) > reader.remaining()) {
+        throw std::runtime_error("invalid meshes count");
+    }
+    model->meshes.reserve(meshesCount);
+    for (int i = 0; i < meshesCount; i++) {
+        // meshes are not merged by texture as Model::addMesh does
+        auto& mesh = model->meshes.emplace_back();
+        mesh.texture = reader.getString();
+        mesh.shading = reader.get();
+        size_t verticesCount = static_cast<uint32_t>(reader.getInt32());
+        size_t dataSize = verticesCount * sizeof(model::Vertex);
+        if (dataSize > reader.remaining()) {
+            throw std::runtime_error("buffer underflow");
+        }
+        mesh.vertices.resize(verticesCount);
+        std::memcpy(mesh.vertices.data(), reader.pointer(), dataSize);
+        reader.skip(dataSize);
+    }
+    return model;
+}
+
+std::unique_ptr<model::Model> model_cache::load(
+    const std::string& name, uint64_t key
+) {
+    auto file = get_cache_file(name);
+    if (!io::is_regular_file(file)) {
+        return nullptr;
+    }
+    try {
+        auto bytes = io::read_bytes_buffer(file);
+        return deserialize(bytes.data(), bytes.size(), key);
+    } catch (const std::runtime_error& err) {
+        logger.error() << "could not read " << file.string() << ": "
+                       << err.what();
+        return nullptr;
+    }
+}
+
+void model_cache::save(
+    const std::string& name, uint64_t key, const model::Model& model
+) {
+    auto bytes = serialize(key, model);
+    auto file = get_cache_file(name);
+    try {
+        io::create_directories(CACHE_FOLDER);
+        io::write_bytes(file, bytes.data(), bytes.size());
+    } catch (const std::runtime_error& err) {
+        logger.error() << "could not write " << file.string() << ": "
+                       << err.what();
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "io/fwd.hpp"
+#include "typedefs.hpp"
+
+namespace model {
+    struct Model;
+}
+
+/// @brief On-disk cache of parsed text models (.obj, .vcm, .xml), so warm
+/// start loads meshes with a single read instead of parsing source text.
+/// Vertices are stored in native byte order
+namespace model_cache {
+    /// @brief Compute cache key of model source file
+    /// @param file source model file
+    /// @param squashed model parts are merged into a single model
+    uint64_t compute_key(const io::path& file, bool squashed);
+
+    /// @brief Serialize model to cache entry bytes
+    std::vector<ubyte> serialize(uint64_t key, const model::Model& model);
+
+    /// @brief Deserialize model from cache entry bytes
+    /// @return nullptr if entry key or version does not match
+    /// @throws std::runtime_error on malformed entry
+    std::unique_ptr<model::Model> deserialize(
+        const ubyte* bytes, size_t size, uint64_t key
+    );
+
+    /// @brief Load cached model
+    /// @param name model asset name
+    /// @param key source file key
+    /// @return nullptr if cache entry is missing or outdated
+    std::unique_ptr<model::Model> load(const std::string& name, uint64_t key);
+
+    /// @brief Write model meshes to cache
+    /// @param name model asset name
+    /// @param key source file key
+    void save(const std::string& name, uint64_t key, const model::Model& model);
+}
@@ -1,9 +1,14 @@
 #include "ALAudio.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <string>
+#include <unordered_set>
 #include <utility>
 
 #include "debug/Logger.hpp"
+#include "debug/Memory.hpp"
 #include "alutil.hpp"
 #include "../MemoryPCMStream.hpp"
 
@@ -55,6 +60,14 @@ static LPALFILTERF alFilterf = nullptr;
 
 static inline constexpr int REVERB_EFFECT = 0;
 static inline constexpr int LOWPASS_FILTER = 0;
+static inline constexpr uint STREAMS_DECODER_THREADS = 2;
+/// @brief Sources not used by voices to keep streams playing
+static inline constexpr uint STREAMS_RESERVED_SOURCES = 16;
+/// @brief Voices with lower estimated gain are virtualized
+static inline constexpr float VOICE_MIN_GAIN = 0.005f;
+/// @brief Playing voice gain multiplier preventing voices swapping back and
+/// forth when their gains are close
+static inline constexpr float VOICE_HYSTERESIS = 1.5f;
 
 ALSound::ALSound(
     ALAudio* al, uint buffer, const std::shared_ptr<PCM>& pcm, bool keepPCM
@@ -66,19 +79,30 @@ ALSound::ALSound(
     }
 }
 
+ALSound::ALSound(
+    ALAudio* al, const std::shared_ptr<PCM>& header, PCMLoader loader
+)
+    : al(al), buffer(0), loader(std::move(loader)) {
+    duration = header->getDuration();
+}
+
 ALSound::~ALSound() {
-    al->freeBuffer(buffer);
+    al->releaseSound(*this);
     buffer = 0;
 }
 
 std::unique_ptr<Speaker> ALSound::newInstance(int priority, int channel) const {
-    uint source = al->getFreeSource();
-    if (source == 0) {
+    uint buffer = loader ? al->useSoundBuffer(*this) : this->buffer;
+    if (buffer == 0) {
         return nullptr;
     }
-    AL_CHECK(alSourcei(source, AL_BUFFER, buffer));
-
-    auto speaker = std::make_unique<ALSpeaker>(al, source, priority, channel);
+    // voice is created virtual if the limit is reached
+    uint source = al->hasFreeVoice() ? al->getFreeSource() : 0;
+    if (source) {
+        AL_CHECK(alSourcei(source, AL_BUFFER, buffer));
+    }
+    auto speaker =
+        std::make_unique<ALSpeaker>(al, source, priority, channel, buffer);
     speaker->duration = duration;
     return speaker;
 }
@@ -150,6 +174,11 @@ ALStream::ALStream(
     ALAudio* al, std::shared_ptr<PCMStream> source, bool keepSource
 )
     : al(al), source(std::move(source)), keepSource(keepSource) {
+    if (!keepSource) {
+        decoded = std::make_shared<DecodedStream>(
+            this->source, BUFFER_SIZE, STREAM_BUFFERS
+        );
+    }
 }
 
 ALStream::~ALStream() {
@@ -171,7 +200,13 @@ std::shared_ptr<PCMStream> ALStream::getSource() const {
 }
 
 bool ALStream::preloadBuffer(uint buffer, bool loop) {
-    size_t read = source->readFully(this->buffer, BUFFER_SIZE, loop);
+    size_t read;
+    if (decoded) {
+        read = decoded->read(this->buffer, loop);
+        al->getStreamsDecoder().schedule(decoded);
+    } else {
+        read = source->readFully(this->buffer, BUFFER_SIZE, loop);
+    }
     if (!read) return false;
     ALenum format =
         AL::to_al_format(source->getChannels(), source->getBitsPerSample());
@@ -299,7 +334,11 @@ duration_t ALStream::getTime() const {
 void ALStream::setTime(duration_t time) {
     if (!source->isSeekable()) return;
     uint sample = time * source->getSampleRate();
-    source->seek(sample);
+    if (decoded) {
+        decoded->seek(sample);
+    } else {
+        source->seek(sample);
+    }
     auto alspeaker =
         dynamic_cast<ALSpeaker*>(audio::get_speaker(this->speaker));
     if (alspeaker) {
@@ -325,14 +364,27 @@ void ALStream::setStopOnEnd(bool flag) {
     stopOnEnd = flag;
 }
 
-ALSpeaker::ALSpeaker(ALAudio* al, uint source, int priority, int channel)
-    : al(al), priority(priority), channel(channel), source(source) {
+ALSpeaker::ALSpeaker(
+    ALAudio* al, uint source, int priority, int channel, uint buffer
+)
+    : al(al),
+      priority(priority),
+      channel(channel),
+      virtualized(source == 0 && buffer != 0),
+      source(source),
+      buffer(buffer) {
+    if (buffer) {
+        al->addVoice(this);
+    }
 }
 
 ALSpeaker::~ALSpeaker() {
     if (source) {
         stop();
     }
+    if (buffer) {
+        al->removeVoice(this);
+    }
 }
 
 void ALSpeaker::update(const Channel* channel) {
@@ -354,6 +406,15 @@ int ALSpeaker::getChannel() const {
 }
 
 State ALSpeaker::getState() const {
+    if (virtualized) {
+        if (paused) {
+            return State::paused;
+        }
+        if (!loop && getTime() >= duration) {
+            return State::stopped;
+        }
+        return State::playing;
+    }
     int state = AL::getSourcei(source, AL_SOURCE_STATE, AL_STOPPED);
     switch (state) {
         case AL_PLAYING:
@@ -374,22 +435,41 @@ void ALSpeaker::setVolume(float volume) {
 }
 
 float ALSpeaker::getPitch() const {
-    return AL::getSourcef(source, AL_PITCH);
+    return pitch;
 }
 
 void ALSpeaker::setPitch(float pitch) {
-    AL_CHECK(alSourcef(source, AL_PITCH, pitch));
+    if (virtualized) {
+        // keeping already played time
+        virtualTime = getTime();
+        virtualSince = std::chrono::steady_clock::now();
+    }
+    this->pitch = pitch;
+    if (source) {
+        AL_CHECK(alSourcef(source, AL_PITCH, pitch));
+    }
 }
 
 bool ALSpeaker::isLoop() const {
-    return AL::getSourcei(source, AL_LOOPING) == AL_TRUE; //-V550
+    return loop;
 }
 
 void ALSpeaker::setLoop(bool loop) {
-    AL_CHECK(alSourcei(source, AL_LOOPING, loop ? AL_TRUE : AL_FALSE));
+    this->loop = loop;
+    if (source) {
+        AL_CHECK(alSourcei(source, AL_LOOPING, loop ? AL_TRUE : AL_FALSE));
+    }
 }
 
 void ALSpeaker::play() {
+    if (virtualized) {
+        if (paused || manuallyStopped) {
+            virtualSince = std::chrono::steady_clock::now();
+        }
+        paused = false;
+        manuallyStopped = false;
+        return;
+    }
     paused = false;
     manuallyStopped = false;
     auto channel = get_channel(this->channel);
@@ -409,12 +489,18 @@ void ALSpeaker::play() {
 }
 
 void ALSpeaker::pause() {
+    if (virtualized) {
+        virtualTime = getTime();
+        paused = true;
+        return;
+    }
     paused = true;
     AL_CHECK(alSourcePause(source));
 }
 
 void ALSpeaker::stop() {
     manuallyStopped = true;
+    virtualized = false;
     if (source) {
         AL_CHECK(alSourceStop(source));
 
@@ -430,10 +516,65 @@ void ALSpeaker::stop() {
     }
 }
 
+void ALSpeaker::virtualize() {
+    if (virtualized || source == 0 || buffer == 0) {
+        return;
+    }
+    virtualTime = AL::getSourcef(source, AL_SEC_OFFSET);
+    virtualSince = std::chrono::steady_clock::now();
+    AL_CHECK(alSourceStop(source));
+    AL_CHECK(alSourcei(source, AL_BUFFER, 0));
+    al->freeSource(source);
+    source = 0;
+    virtualized = true;
+}
+
+bool ALSpeaker::devirtualize() {
+    if (!virtualized) {
+        return true;
+    }
+    uint source = al->getFreeSource();
+    if (source == 0) {
+        return false;
+    }
+    duration_t time = getTime();
+    this->source = source;
+    virtualized = false;
+
+    AL_CHECK(alSourcei(source, AL_BUFFER, buffer));
+    AL_CHECK(alSource3f(source, AL_POSITION, position.x, position.y, position.z));
+    AL_CHECK(alSource3f(source, AL_VELOCITY, velocity.x, velocity.y, velocity.z));
+    AL_CHECK(alSourcef(source, AL_PITCH, pitch));
+    AL_CHECK(alSourcei(source, AL_LOOPING, loop ? AL_TRUE : AL_FALSE));
+    AL_CHECK(
+        alSourcei(source, AL_SOURCE_RELATIVE, relative ? AL_TRUE : AL_FALSE)
+    );
+    AL_CHECK(alSourcef(source, AL_SEC_OFFSET, static_cast<float>(time)));
+    if (paused) {
+        play();
+        pause();
+    } else {
+        play();
+    }
+    return true;
+}
+
 duration_t ALSpeaker::getTime() const {
     if (stream) {
         return stream->getTime();
     }
+    if (virtualized) {
+        duration_t time = virtualTime;
+        if (!paused) {
+            std::chrono::duration<duration_t> elapsed =
+                std::chrono::steady_clock::now() - virtualSince;
+            time += elapsed.count() * pitch;
+        }
+        if (duration <= 0.0) {
+            return 0.0;
+        }
+        return loop ? std::fmod(time, duration) : std::min(time, duration);
+    }
     return static_cast<duration_t>(AL::getSourcef(source, AL_SEC_OFFSET));
 }
 
@@ -445,33 +586,47 @@ void ALSpeaker::setTime(duration_t time) {
     if (stream) {
         return stream->setTime(time);
     }
+    if (virtualized) {
+        virtualTime = time;
+        virtualSince = std::chrono::steady_clock::now();
+        return;
+    }
     AL_CHECK(alSourcef(source, AL_SEC_OFFSET, static_cast<float>(time)));
 }
 
 void ALSpeaker::setPosition(glm::vec3 pos) {
-    AL_CHECK(alSource3f(source, AL_POSITION, pos.x, pos.y, pos.z));
+    position = pos;
+    if (source) {
+        AL_CHECK(alSource3f(source, AL_POSITION, pos.x, pos.y, pos.z));
+    }
 }
 
 glm::vec3 ALSpeaker::getPosition() const {
-    return AL::getSource3f(source, AL_POSITION);
+    return position;
 }
 
 void ALSpeaker::setVelocity(glm::vec3 vel) {
-    AL_CHECK(alSource3f(source, AL_VELOCITY, vel.x, vel.y, vel.z));
+    velocity = vel;
+    if (source) {
+        AL_CHECK(alSource3f(source, AL_VELOCITY, vel.x, vel.y, vel.z));
+    }
 }
 
 glm::vec3 ALSpeaker::getVelocity() const {
-    return AL::getSource3f(source, AL_VELOCITY);
+    return velocity;
 }
 
 void ALSpeaker::setRelative(bool relative) {
-    AL_CHECK(
-        alSourcei(source, AL_SOURCE_RELATIVE, relative ? AL_TRUE : AL_FALSE)
-    );
+    this->relative = relative;
+    if (source) {
+        AL_CHECK(
+            alSourcei(source, AL_SOURCE_RELATIVE, relative ? AL_TRUE : AL_FALSE)
+        );
+    }
 }
 
 bool ALSpeaker::isRelative() const {
-    return AL::getSourcei(source, AL_SOURCE_RELATIVE) == AL_TRUE; //-V550
+    return relative;
 }
 
 int ALSpeaker::getPriority() const {
@@ -522,9 +677,20 @@ ALAudio::ALAudio(
     if (useEffects) {
         this->useEffects = initEffects();
     }
+    streamsDecoder = std::make_unique<StreamsDecoder>(STREAMS_DECODER_THREADS);
+
+    memorySource = debug::memory::add_source(
+        debug::MemoryTag::SOUNDS,
+        [this]() { return decodedBytes + residentBytes; },
+        [this](size_t bytes) {
+            return evictSounds(decodedBytes > bytes ? decodedBytes - bytes : 0);
+        }
+    );
 }
 
 ALAudio::~ALAudio() {
+    streamsDecoder.reset();
+
     for (uint source : allsources) {
         int state = AL::getSourcei(source, AL_SOURCE_STATE);
         if (state == AL_PLAYING || state == AL_PAUSED) {
@@ -630,7 +796,93 @@ std::unique_ptr<Sound> ALAudio::createSound(
     AL_CHECK(alBufferData(
         buffer, format, pcm->data.data(), pcm->data.size(), pcm->sampleRate
     ));
-    return std::make_unique<ALSound>(this, buffer, pcm, keepPCM);
+    auto sound = std::make_unique<ALSound>(this, buffer, pcm, keepPCM);
+    sound->bufferSize = pcm->data.size();
+    residentBytes += sound->bufferSize + (keepPCM ? pcm->data.size() : 0);
+    return sound;
+}
+
+std::unique_ptr<Sound> ALAudio::createSound(
+    std::shared_ptr<PCM> header, PCMLoader loader
+) {
+    if (settings.soundsCacheSize.get() == 0) {
+        return createSound(std::shared_ptr<PCM>(loader()), false);
+    }
+    return std::make_unique<ALSound>(this, header, std::move(loader));
+}
+
+uint ALAudio::useSoundBuffer(const ALSound& sound) {
+    if (sound.buffer) {
+        decodedSounds.splice(
+            decodedSounds.end(), decodedSounds, sound.lruPosition
+        );
+        return sound.buffer;
+    }
+    std::unique_ptr<PCM> pcm;
+    try {
+        pcm = sound.loader();
+    } catch (const std::runtime_error& err) {
+        logger.error() << "could not to decode sound: " << err.what();
+        return 0;
+    }
+    uint buffer = getFreeBuffer();
+    if (buffer == 0) {
+        return 0;
+    }
+    auto format = AL::to_al_format(pcm->channels, pcm->bitsPerSample);
+    AL_CHECK(alBufferData(
+        buffer, format, pcm->data.data(), pcm->data.size(), pcm->sampleRate
+    ));
+    sound.buffer = buffer;
+    sound.bufferSize = pcm->data.size();
+    sound.lruPosition = decodedSounds.insert(decodedSounds.end(), &sound);
+    decodedBytes += sound.bufferSize;
+    evictSounds(static_cast<size_t>(settings.soundsCacheSize.get()) << 20);
+    return buffer;
+}
+
+void ALAudio::releaseSound(const ALSound& sound) {
+    if (!sound.loader) {
+        residentBytes -=
+            sound.bufferSize + (sound.pcm ? sound.pcm->data.size() : 0);
+        freeBuffer(sound.buffer);
+        return;
+    }
+    if (sound.buffer == 0) {
+        return;
+    }
+    decodedSounds.erase(sound.lruPosition);
+    decodedBytes -= sound.bufferSize;
+    deleteBuffer(sound.buffer);
+    sound.buffer = 0;
+    sound.bufferSize = 0;
+}
+
+size_t ALAudio::evictSounds(size_t limit) {
+    if (decodedBytes <= limit || decodedSounds.empty()) {
+        return 0;
+    }
+    size_t before = decodedBytes;
+    // virtual voices buffers are kept too
+    std::unordered_set<uint> attached;
+    for (const auto voice : voices) {
+        attached.insert(voice->buffer);
+    }
+    // the last one is the sound being played now
+    auto last = std::prev(decodedSounds.end());
+    for (auto it = decodedSounds.begin(); it != last && decodedBytes > limit;) {
+        const ALSound* sound = *it;
+        if (attached.find(sound->buffer) != attached.end()) {
+            ++it;
+            continue;
+        }
+        it = decodedSounds.erase(it);
+        decodedBytes -= sound->bufferSize;
+        deleteBuffer(sound->buffer);
+        sound->buffer = 0;
+        sound->bufferSize = 0;
+    }
+    return before - decodedBytes;
 }
 
 std::unique_ptr<Stream> ALAudio::openStream(
@@ -777,9 +1029,107 @@ void ALAudio::freeBuffer(uint buffer) {
     freebuffers.push_back(buffer);
 }
 
+void ALAudio::deleteBuffer(uint buffer) {
+    AL_CHECK(alDeleteBuffers(1, &buffer));
+    allbuffers.erase(
+        std::remove(allbuffers.begin(), allbuffers.end(), buffer),
+        allbuffers.end()
+    );
+}
+
+void ALAudio::addVoice(ALSpeaker* speaker) {
+    voices.push_back(speaker);
+}
+
+void ALAudio::removeVoice(ALSpeaker* speaker) {
+    auto found = std::find(voices.begin(), voices.end(), speaker);
+    if (found != voices.end()) {
+        *found = voices.back();
+        voices.pop_back();
+    }
+}
+
+uint ALAudio::getMaxVoices() const {
+    uint limit = maxSources > STREAMS_RESERVED_SOURCES
+                     ? maxSources - STREAMS_RESERVED_SOURCES
+                     : 1;
+    return std::min<uint>(settings.maxVoices.get(), limit);
+}
+
+bool ALAudio::hasFreeVoice() const {
+    uint playing = 0;
+    for (const auto voice : voices) {
+        playing += voice->source != 0;
+    }
+    return playing < getMaxVoices();
+}
+
+void ALAudio::updateVoices() {
+    struct Candidate {
+        ALSpeaker* voice;
+        float gain;
+    };
+    std::vector<Candidate> candidates;
+    candidates.reserve(voices.size());
+    for (auto voice : voices) {
+        if (voice->manuallyStopped) {
+            continue;
+        }
+        auto channel = get_channel(voice->getChannel());
+        if (channel == nullptr) {
+            continue;
+        }
+        glm::vec3 position = voice->getPosition();
+        float distance = voice->isRelative()
+                             ? glm::length(position)
+                             : glm::distance(position, listenerPosition);
+        // default AL_INVERSE_DISTANCE_CLAMPED model with unit reference
+        // distance and rolloff factor
+        float gain = voice->getVolume() * channel->getVolume() /
+                     glm::max(distance, 1.0f);
+        if (gain < VOICE_MIN_GAIN) {
+            voice->virtualize();
+            continue;
+        }
+        if (!voice->isVirtual()) {
+            gain *= VOICE_HYSTERESIS;
+        } else if (channel->isPaused()) {
+            continue;
+        }
+        candidates.push_back({voice, gain});
+    }
+    uint maxVoices = getMaxVoices();
+    if (candidates.size() > maxVoices) {
+        std::nth_element(
+            candidates.begin(),
+            candidates.begin() + maxVoices,
+            candidates.end(),
+            [](const auto& a, const auto& b) {
+                int priorityA = a.voice->getPriority();
+                int priorityB = b.voice->getPriority();
+                if (priorityA != priorityB) {
+                    return priorityA > priorityB;
+                }
+                return a.gain > b.gain;
+            }
+        );
+        // releasing sources before acquiring
+        for (size_t i = maxVoices; i < candidates.size(); i++) {
+            candidates[i].voice->virtualize();
+        }
+        candidates.resize(maxVoices);
+    }
+    for (const auto& candidate : candidates) {
+        if (!candidate.voice->devirtualize()) {
+            break;
+        }
+    }
+}
+
 void ALAudio::setListener(
     glm::vec3 position, glm::vec3 velocity, glm::vec3 at, glm::vec3 up
 ) {
+    listenerPosition = position;
     ALfloat listenerOri[] = {at.x, at.y, at.z, up.x, up.y, up.z};
 
     AL_CHECK(alListener3f(AL_POSITION, position.x, position.y, position.z));
@@ -789,6 +1139,7 @@ void ALAudio::setListener(
 }
 
 void ALAudio::update(double) {
+    updateVoices();
 }
 
 void ALAudio::setAcoustics(Acoustics acoustics) {
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <chrono>
 #include <glm/glm.hpp>
+#include <list>
+#include <memory>
 #include <queue>
 #include <string>
 #include <array>
@@ -8,8 +11,10 @@
 #include <vector>
 
 #include "typedefs.hpp"
+#include "util/observer_handler.hpp"
 #include "audio/audio.hpp"
 #include "audio/effects.hpp"
+#include "audio/StreamsDecoder.hpp"
 
 #include <AL/al.h>
 #include <AL/alc.h>
@@ -23,10 +28,19 @@ namespace audio {
     class PCMStream;
 
     class ALSound : public Sound {
+        friend class ALAudio;
+
         ALAudio* al;
-        uint buffer;
+        /// @brief AL buffer (0 - PCM is not decoded yet or evicted)
+        mutable uint buffer;
         std::shared_ptr<PCM> pcm;
         duration_t duration;
+        /// @brief Decodes PCM on demand (nullptr - buffer is never evicted)
+        PCMLoader loader;
+        /// @brief Resident buffer size
+        mutable size_t bufferSize = 0;
+        /// @brief Position in ALAudio decoded sounds LRU list
+        mutable std::list<const ALSound*>::iterator lruPosition;
     public:
         ALSound(
             ALAudio* al,
@@ -34,6 +48,9 @@ namespace audio {
             const std::shared_ptr<PCM>& pcm,
             bool keepPCM
         );
+        ALSound(
+            ALAudio* al, const std::shared_ptr<PCM>& header, PCMLoader loader
+        );
         ~ALSound();
 
         duration_t getDuration() const override {
@@ -53,6 +70,8 @@ namespace audio {
 
         ALAudio* al;
         std::shared_ptr<PCMStream> source;
+        /// @brief Source decoded in background (nullptr if keepSource)
+        std::shared_ptr<DecodedStream> decoded;
         std::queue<uint> unusedBuffers;
         speakerid_t speaker = 0;
         bool keepSource;
@@ -115,22 +134,50 @@ namespace audio {
         std::string deviceSpecifier;
     };
 
-    /// @brief AL source adapter
+    /// @brief AL source adapter. Sound speaker (voice) may be virtualized by
+    /// ALAudio: source is released while playback time is still tracked
     class ALSpeaker : public Speaker {
         ALAudio* al;
         int priority;
         int channel;
         float volume = 0.0f;
+        /// @brief Source properties kept to restore virtualized voice
+        glm::vec3 position {};
+        glm::vec3 velocity {};
+        float pitch = 1.0f;
+        bool loop = false;
+        bool relative = false;
+        /// @brief Virtual voice playback time at virtualSince
+        duration_t virtualTime = 0.0f;
+        std::chrono::steady_clock::time_point virtualSince;
+        bool virtualized;
     public:
         ALStream* stream = nullptr;
         bool manuallyStopped = true;
         bool paused = false;
         uint source;
+        /// @brief Sound buffer (0 - stream speaker, not managed as voice)
+        uint buffer;
         duration_t duration = 0.0f;
 
-        ALSpeaker(ALAudio* al, uint source, int priority, int channel);
+        /// @param source AL source (0 with buffer - create virtual voice)
+        /// @param buffer sound buffer (0 for stream speaker)
+        ALSpeaker(
+            ALAudio* al, uint source, int priority, int channel, uint buffer = 0
+        );
         ~ALSpeaker();
 
+        /// @brief Release source keeping playback state
+        void virtualize();
+
+        /// @brief Acquire source and continue playback from tracked time
+        /// @return false if no free source available
+        bool devirtualize();
+
+        bool isVirtual() const {
+            return virtualized;
+        }
+
         void update(const Channel* channel) override;
         int getChannel() const override;
 
@@ -179,9 +226,38 @@ namespace audio {
         uint maxSources = 256;
         uint maxEffectSlots = 64;
 
+        /// @brief Sound speakers managed by voices limit
+        std::vector<ALSpeaker*> voices;
+        glm::vec3 listenerPosition {};
+
+        /// @brief Decoded on demand sounds, least recently played first
+        std::list<const ALSound*> decodedSounds;
+        /// @brief Total size of decodedSounds buffers
+        size_t decodedBytes = 0;
+        /// @brief Total size of sounds buffers never evicted and kept PCM
+        /// data
+        size_t residentBytes = 0;
+
         const AudioSettings& settings;
 
+        std::unique_ptr<StreamsDecoder> streamsDecoder;
+
+        /// @brief Memory accounting source (see debug::memory)
+        ObserverHandler memorySource;
+
         bool initEffects();
+
+        /// @brief Release least recently played sounds buffers not attached
+        /// to sources until decoded sounds fit the limit
+        /// @param limit decoded sounds size limit in bytes
+        /// @return number of released bytes
+        size_t evictSounds(size_t limit);
+
+        /// @brief Virtualize inaudible and least important voices over the
+        /// limit, restore the most important virtual ones
+        void updateVoices();
+
+        uint getMaxVoices() const;
     public:
         std::vector<uint> effectSlots;
         std::vector<uint> effects;
@@ -201,11 +277,35 @@ namespace audio {
         uint getFreeBuffer();
         void freeSource(uint source);
         void freeBuffer(uint buffer);
+        /// @brief Delete buffer releasing its memory
+        void deleteBuffer(uint buffer);
+
+        /// @brief Decode sound PCM if not resident and mark it as
+        /// recently played
+        /// @return sound buffer or 0 if decoding failed
+        uint useSoundBuffer(const ALSound& sound);
+
+        /// @brief Release sound buffer
+        void releaseSound(const ALSound& sound);
+
+        void addVoice(ALSpeaker* speaker);
+        void removeVoice(ALSpeaker* speaker);
+
+        /// @return true if a new voice may get a source
+        bool hasFreeVoice() const;
+
+        StreamsDecoder& getStreamsDecoder() {
+            return *streamsDecoder;
+        }
 
         std::unique_ptr<Sound> createSound(
             std::shared_ptr<PCM> pcm, bool keepPCM
         ) override;
 
+        std::unique_ptr<Sound> createSound(
+            std::shared_ptr<PCM> header, PCMLoader loader
+        ) override;
+
         std::unique_ptr<Stream> openStream(
             std::shared_ptr<PCMStream> stream, bool keepSource
         ) override;
@@ -15,6 +15,12 @@ std::unique_ptr<Sound> NoAudio::createSound(
     return std::make_unique<NoSound>(pcm, keepPCM);
 }
 
+std::unique_ptr<Sound> NoAudio::createSound(
+    std::shared_ptr<PCM> header, PCMLoader
+) {
+    return std::make_unique<NoSound>(header, false);
+}
+
 std::unique_ptr<Stream> NoAudio::openStream(
     std::shared_ptr<PCMStream> stream, bool keepSource
 ) {
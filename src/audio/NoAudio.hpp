@@ -79,6 +79,10 @@ namespace audio {
             std::shared_ptr<PCM> pcm, bool keepPCM
         ) override;
 
+        std::unique_ptr<Sound> createSound(
+            std::shared_ptr<PCM> header, PCMLoader loader
+        ) override;
+
         std::unique_ptr<Stream> openStream(
             std::shared_ptr<PCMStream> stream, bool keepSource
         ) override;
@@ -0,0 +1,132 @@
+#include "StreamsDecoder.hpp"
+
+#include <cstring>
+#include <utility>
+
+using namespace audio;
+
+DecodedStream::DecodedStream(
+    std::shared_ptr<PCMStream> source, size_t chunkSize, size_t maxChunks
+)
+    : source(std::move(source)), chunkSize(chunkSize), maxChunks(maxChunks) {
+}
+
+bool DecodedStream::decodeChunk() {
+    if (end) {
+        return false;
+    }
+    std::vector<char> chunk;
+    if (!spare.empty()) {
+        chunk = std::move(spare.back());
+        spare.pop_back();
+    }
+    chunk.resize(chunkSize);
+    size_t read = source->readFully(chunk.data(), chunkSize, loop);
+    if (read == 0) {
+        end = true;
+        spare.push_back(std::move(chunk));
+        return false;
+    }
+    chunk.resize(read);
+    chunks.push_back(std::move(chunk));
+    return true;
+}
+
+void DecodedStream::decodeAhead() {
+    while (true) {
+        // lock is released between chunks to not block the reader long
+        std::lock_guard lock(mutex);
+        if (chunks.size() >= maxChunks || !decodeChunk()) {
+            return;
+        }
+    }
+}
+
+size_t DecodedStream::read(char* dst, bool loop) {
+    std::lock_guard lock(mutex);
+    if (loop && !this->loop) {
+        // source reached end may be continued from start now
+        end = false;
+    }
+    this->loop = loop;
+    if (chunks.empty() && !decodeChunk()) {
+        return 0;
+    }
+    auto chunk = std::move(chunks.front());
+    chunks.pop_front();
+    size_t size = chunk.size();
+    std::memcpy(dst, chunk.data(), size);
+    spare.push_back(std::move(chunk));
+    return size;
+}
+
+void DecodedStream::seek(size_t position) {
+    std::lock_guard lock(mutex);
+    while (!chunks.empty()) {
+        spare.push_back(std::move(chunks.front()));
+        chunks.pop_front();
+    }
+    source->seek(position);
+    end = false;
+}
+
+bool DecodedStream::isDecodingNeeded() const {
+    std::lock_guard lock(mutex);
+    return !end && chunks.size() < maxChunks;
+}
+
+bool DecodedStream::isEnd() const {
+    std::lock_guard lock(mutex);
+    return end && chunks.empty();
+}
+
+StreamsDecoder::StreamsDecoder(uint threadsCount) {
+    for (uint i = 0; i < threadsCount; i++) {
+        threads.emplace_back(&StreamsDecoder::threadLoop, this);
+    }
+}
+
+StreamsDecoder::~StreamsDecoder() {
+    {
+        std::lock_guard lock(mutex);
+        working = false;
+    }
+    condition.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void StreamsDecoder::schedule(const std::shared_ptr<DecodedStream>& stream) {
+    if (!stream->isDecodingNeeded() || stream->scheduled.exchange(true)) {
+        return;
+    }
+    {
+        std::lock_guard lock(mutex);
+        queue.push_back(stream);
+    }
+    condition.notify_one();
+}
+
+void StreamsDecoder::threadLoop() {
+    while (true) {
+        std::shared_ptr<DecodedStream> stream;
+        {
+            std::unique_lock lock(mutex);
+            condition.wait(lock, [this]() {
+                return !queue.empty() || !working;
+            });
+            if (!working) {
+                return;
+            }
+            stream = queue.front().lock();
+            queue.pop_front();
+        }
+        if (stream == nullptr) {
+            continue;
+        }
+        // chunks taken while decoding must schedule the stream again
+        stream->scheduled = false;
+        stream->decodeAhead();
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "audio.hpp"
+
+namespace audio {
+    /// @brief PCM stream wrapper keeping a few chunks decoded ahead.
+    /// Source stream is accessed by the StreamsDecoder threads, so it must
+    /// not be used elsewhere while wrapped
+    class DecodedStream {
+        friend class StreamsDecoder;
+
+        mutable std::mutex mutex;
+        std::shared_ptr<PCMStream> source;
+        std::deque<std::vector<char>> chunks;
+        /// @brief Consumed chunks kept to reuse allocations
+        std::vector<std::vector<char>> spare;
+        size_t chunkSize;
+        size_t maxChunks;
+        bool loop = false;
+        bool end = false;
+        /// @brief Stream is queued in decoder
+        std::atomic<bool> scheduled = false;
+
+        /// @brief Decode next chunk. Mutex must be locked
+        /// @return false if the stream end is reached
+        bool decodeChunk();
+
+        /// @brief Decode chunks until maxChunks are ready
+        void decodeAhead();
+    public:
+        DecodedStream(
+            std::shared_ptr<PCMStream> source, size_t chunkSize, size_t maxChunks
+        );
+
+        /// @brief Take next decoded chunk. Decodes it in-place if none is
+        /// ready yet
+        /// @param dst destination buffer of chunkSize bytes
+        /// @param loop continue from the stream start on its end
+        /// @return number of bytes read (0 - stream end is reached)
+        size_t read(char* dst, bool loop);
+
+        /// @brief Drop decoded chunks and seek the source stream
+        void seek(size_t position);
+
+        /// @return true if more chunks may be decoded ahead
+        bool isDecodingNeeded() const;
+
+        /// @return true if source end is reached and all chunks are taken
+        bool isEnd() const;
+
+        size_t getChunkSize() const {
+            return chunkSize;
+        }
+    };
+
+    /// @brief Background threads decoding streams ahead of playback
+    class StreamsDecoder {
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<std::weak_ptr<DecodedStream>> queue;
+        bool working = true;
+
+        void threadLoop();
+    public:
+        StreamsDecoder(uint threadsCount);
+        ~StreamsDecoder();
+
+        /// @brief Queue stream to decode chunks ahead if needed
+        void schedule(const std::shared_ptr<DecodedStream>& stream);
+    };
+}
@@ -217,7 +217,24 @@ std::unique_ptr<PCM> audio::load_PCM(const io::path& file, bool headerOnly) {
     throw std::runtime_error("unsupported audio format");
 }
 
+static bool is_ogg_file(const io::path& file) {
+    std::string ext = file.extension();
+    return ext == ".ogg" || ext == ".OGG";
+}
+
 std::unique_ptr<Sound> audio::load_sound(const io::path& file, bool keepPCM) {
+    if (!keepPCM && !backend->isDummy() && is_ogg_file(file)) {
+        // keeping compressed data until the sound is played
+        auto bytes = std::make_shared<util::Buffer<ubyte>>(
+            io::read_bytes_buffer(file)
+        );
+        std::shared_ptr<PCM> header(
+            ogg::load_pcm(bytes->data(), bytes->size(), true).release()
+        );
+        return backend->createSound(std::move(header), [bytes]() {
+            return ogg::load_pcm(bytes->data(), bytes->size(), false);
+        });
+    }
     std::shared_ptr<PCM> pcm(
         load_PCM(file, !keepPCM && backend->isDummy()).release()
     );
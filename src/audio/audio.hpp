@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <glm/glm.hpp>
 #include <memory>
 #include <vector>
@@ -374,6 +375,9 @@ namespace audio {
         virtual bool isManuallyStopped() const = 0;
     };
 
+    /// @brief Decodes sound PCM data
+    using PCMLoader = std::function<std::unique_ptr<PCM>()>;
+
     class Backend {
     public:
         virtual ~Backend() {};
@@ -381,6 +385,12 @@ namespace audio {
         virtual std::unique_ptr<Sound> createSound(
             std::shared_ptr<PCM> pcm, bool keepPCM
         ) = 0;
+        /// @brief Create sound decoded on demand
+        /// @param header PCM info without data
+        /// @param loader decodes full PCM when the sound is played
+        virtual std::unique_ptr<Sound> createSound(
+            std::shared_ptr<PCM> header, PCMLoader loader
+        ) = 0;
         virtual std::unique_ptr<Stream> openStream(
             std::shared_ptr<PCMStream> stream, bool keepSource
         ) = 0;
@@ -417,7 +427,8 @@ namespace audio {
     /// @return PCM audio data
     std::unique_ptr<PCM> load_PCM(const io::path& file, bool headerOnly);
 
-    /// @brief Load sound from file
+    /// @brief Load sound from file. OGG sounds without keepPCM are kept
+    /// compressed and decoded when played first time
     /// @param file audio file path
     /// @param keepPCM store PCM data in sound to make it accessible with
     /// Sound::getPCM
@@ -0,0 +1,308 @@
+#include "bcn.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include "graphics/core/ImageData.hpp"
+
+using namespace bcn;
+
+static inline uint16_t to_rgb565(const ubyte* c) {
+    return ((c[0] >> 3) << 11) | ((c[1] >> 2) << 5) | (c[2] >> 3);
+}
+
+static inline void from_rgb565(uint16_t value, int* dst) {
+    int r = (value >> 11) & 0x1F;
+    int g = (value >> 5) & 0x3F;
+    int b = value & 0x1F;
+    dst[0] = (r << 3) | (r >> 2);
+    dst[1] = (g << 2) | (g >> 4);
+    dst[2] = (b << 3) | (b >> 2);
+}
+
+static inline void put16(ubyte* dst, uint16_t value) {
+    dst[0] = value & 0xFF;
+    dst[1] = value >> 8;
+}
+
+static inline uint16_t get16(const ubyte* src) {
+    return src[0] | (src[1] << 8);
+}
+
+/// @brief Encode color block using 4-colors mode
+static void encode_color_block(const ubyte* block, ubyte* dst) {
+    int min[3] {255, 255, 255};
+    int max[3] {0, 0, 0};
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+            min[c] = std::min<int>(min[c], block[i * 4 + c]);
+            max[c] = std::max<int>(max[c], block[i * 4 + c]);
+        }
+    }
+    // inset bounding box to reduce the mean error
+    ubyte minColor[3];
+    ubyte maxColor[3];
+    for (int c = 0; c < 3; c++) {
+        int inset = (max[c] - min[c]) >> 4;
+        minColor[c] = std::min(255, min[c] + inset);
+        maxColor[c] = std::max(0, max[c] - inset);
+    }
+    uint16_t c0 = to_rgb565(maxColor);
+    uint16_t c1 = to_rgb565(minColor);
+    uint32_t indices = 0;
+    if (c0 < c1) {
+        std::swap(c0, c1);
+    }
+    if (c0 != c1) {
+        int palette[4][3];
+        from_rgb565(c0, palette[0]);
+        from_rgb565(c1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; i++) {
+            const ubyte* pixel = block + i * 4;
+            int best = 0;
+            int bestDistance = INT32_MAX;
+            for (int p = 0; p < 4; p++) {
+                int distance = 0;
+                for (int c = 0; c < 3; c++) {
+                    int d = pixel[c] - palette[p][c];
+                    distance += d * d;
+                }
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint32_t>(best) << (i * 2);
+        }
+    }
+    put16(dst, c0);
+    put16(dst + 2, c1);
+    for (int i = 0; i < 4; i++) {
+        dst[4 + i] = (indices >> (i * 8)) & 0xFF;
+    }
+}
+
+/// @brief Encode alpha block using 8-alpha mode
+static void encode_alpha_block(const ubyte* block, ubyte* dst) {
+    int min = 255;
+    int max = 0;
+    for (int i = 0; i < 16; i++) {
+        min = std::min<int>(min, block[i * 4 + 3]);
+        max = std::max<int>(max, block[i * 4 + 3]);
+    }
+    uint64_t indices = 0;
+    if (min != max) {
+        int palette[8];
+        palette[0] = max;
+        palette[1] = min;
+        for (int i = 1; i < 7; i++) {
+            palette[i + 1] = ((7 - i) * max + i * min) / 7;
+        }
+        for (int i = 0; i < 16; i++) {
+            int alpha = block[i * 4 + 3];
+            int best = 0;
+            int bestDistance = INT32_MAX;
+            for (int p = 0; p < 8; p++) {
+                int distance = std::abs(alpha - palette[p]);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint64_t>(best) << (i * 3);
+        }
+    }
+    dst[0] = max;
+    dst[1] = min;
+    for (int i = 0; i < 6; i++) {
+        dst[2 + i] = (indices >> (i * 8)) & 0xFF;
+    }
+}
+
+static void decode_color_block(const ubyte* src, ubyte* block, bool opaque) {
+    uint16_t c0 = get16(src);
+    uint16_t c1 = get16(src + 2);
+    int palette[4][3];
+    from_rgb565(c0, palette[0]);
+    from_rgb565(c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        if (c0 > c1 || !opaque) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        } else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    uint32_t indices = src[4] | (src[5] << 8) | (src[6] << 16) |
+                       (static_cast<uint32_t>(src[7]) << 24);
+    for (int i = 0; i < 16; i++) {
+        int index = (indices >> (i * 2)) & 0x3;
+        for (int c = 0; c < 3; c++) {
+            block[i * 4 + c] = palette[index][c];
+        }
+        block[i * 4 + 3] = 255;
+        if (opaque && c0 <= c1 && index == 3) {
+            block[i * 4 + 3] = 0;
+        }
+    }
+}
+
+static void decode_alpha_block(const ubyte* src, ubyte* block) {
+    int palette[8];
+    palette[0] = src[0];
+    palette[1] = src[1];
+    if (palette[0] > palette[1]) {
+        for (int i = 1; i < 7; i++) {
+            palette[i + 1] = ((7 - i) * palette[0] + i * palette[1]) / 7;
+        }
+    } else {
+        for (int i = 1; i < 5; i++) {
+            palette[i + 1] = ((5 - i) * palette[0] + i * palette[1]) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; i++) {
+        indices |= static_cast<uint64_t>(src[2 + i]) << (i * 8);
+    }
+    for (int i = 0; i < 16; i++) {
+        block[i * 4 + 3] = palette[(indices >> (i * 3)) & 0x7];
+    }
+}
+
+size_t bcn::get_block_size(Format format) {
+    return format == Format::BC1 ? 8 : 16;
+}
+
+size_t bcn::get_data_size(Format format, uint width, uint height) {
+    return ((width + 3) / 4) * ((height + 3) / 4) * get_block_size(format);
+}
+
+std::vector<ubyte> bcn::encode(
+    Format format, const ubyte* rgba, uint width, uint height
+) {
+    std::vector<ubyte> dst(get_data_size(format, width, height));
+    size_t blockSize = get_block_size(format);
+    ubyte* out = dst.data();
+    ubyte block[64];
+    for (uint by = 0; by < height; by += 4) {
+        for (uint bx = 0; bx < width; bx += 4) {
+            for (uint y = 0; y < 4; y++) {
+                uint sy = std::min(by + y, height - 1);
+                for (uint x = 0; x < 4; x++) {
+                    uint sx = std::min(bx + x, width - 1);
+                    std::memcpy(
+                        block + (y * 4 + x) * 4,
+                        rgba + (sy * width + sx) * 4,
+                        4
+                    );
+                }
+            }
+            if (format == Format::BC3) {
+                encode_alpha_block(block, out);
+                encode_color_block(block, out + 8);
+            } else {
+                encode_color_block(block, out);
+            }
+            out += blockSize;
+        }
+    }
+    return dst;
+}
+
+void bcn::decode(
+    Format format, const ubyte* src, uint width, uint height, ubyte* dst
+) {
+    size_t blockSize = get_block_size(format);
+    ubyte block[64];
+    for (uint by = 0; by < height; by += 4) {
+        for (uint bx = 0; bx < width; bx += 4) {
+            if (format == Format::BC3) {
+                decode_color_block(src + 8, block, false);
+                decode_alpha_block(src, block);
+            } else {
+                decode_color_block(src, block, true);
+            }
+            src += blockSize;
+            for (uint y = 0; y < 4 && by + y < height; y++) {
+                for (uint x = 0; x < 4 && bx + x < width; x++) {
+                    std::memcpy(
+                        dst + ((by + y) * width + bx + x) * 4,
+                        block + (y * 4 + x) * 4,
+                        4
+                    );
+                }
+            }
+        }
+    }
+}
+
+/// @brief Box-filtered half size image
+static std::vector<ubyte> downsample(
+    const ubyte* rgba, uint width, uint height, uint& dstWidth, uint& dstHeight
+) {
+    dstWidth = std::max(1u, width / 2);
+    dstHeight = std::max(1u, height / 2);
+    std::vector<ubyte> dst(dstWidth * dstHeight * 4);
+    for (uint y = 0; y < dstHeight; y++) {
+        uint y0 = std::min(y * 2, height - 1);
+        uint y1 = std::min(y * 2 + 1, height - 1);
+        for (uint x = 0; x < dstWidth; x++) {
+            uint x0 = std::min(x * 2, width - 1);
+            uint x1 = std::min(x * 2 + 1, width - 1);
+            for (uint c = 0; c < 4; c++) {
+                uint sum = rgba[(y0 * width + x0) * 4 + c] +
+                           rgba[(y0 * width + x1) * 4 + c] +
+                           rgba[(y1 * width + x0) * 4 + c] +
+                           rgba[(y1 * width + x1) * 4 + c];
+                dst[(y * dstWidth + x) * 4 + c] = (sum + 2) / 4;
+            }
+        }
+    }
+    return dst;
+}
+
+std::unique_ptr<CompressedImage> bcn::compress(
+    const ImageData& image, uint levels
+) {
+    if (image.getFormat() != ImageFormat::RGBA8888) {
+        throw std::runtime_error("RGBA8888 image expected");
+    }
+    uint width = image.getWidth();
+    uint height = image.getHeight();
+    const ubyte* data = image.getData();
+
+    bool opaque = true;
+    for (size_t i = 0; i < static_cast<size_t>(width) * height; i++) {
+        if (data[i * 4 + 3] != 255) {
+            opaque = false;
+            break;
+        }
+    }
+    auto format = opaque ? Format::BC1 : Format::BC3;
+    auto compressed = std::make_unique<CompressedImage>(
+        CompressedImage {format, width, height, {}}
+    );
+    compressed->levels.push_back(encode(format, data, width, height));
+
+    std::vector<ubyte> level;
+    for (uint i = 1; i < levels && (width > 1 || height > 1); i++) {
+        uint levelWidth, levelHeight;
+        auto next = downsample(data, width, height, levelWidth, levelHeight);
+        level = std::move(next);
+        data = level.data();
+        width = levelWidth;
+        height = levelHeight;
+        compressed->levels.push_back(encode(format, data, width, height));
+    }
+    return compressed;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "typedefs.hpp"
+
+class ImageData;
+
+/// @brief S3TC block compression (BC1 = DXT1, BC3 = DXT5) of RGBA images
+namespace bcn {
+    enum class Format {
+        /// @brief 8 bytes per 4x4 block, opaque
+        BC1,
+        /// @brief 16 bytes per 4x4 block, interpolated alpha
+        BC3,
+    };
+
+    /// @brief Block compressed image with mip levels
+    struct CompressedImage {
+        Format format;
+        uint width;
+        uint height;
+        /// @brief Mip levels data starting with the base level
+        std::vector<std::vector<ubyte>> levels;
+    };
+
+    size_t get_block_size(Format format);
+
+    size_t get_data_size(Format format, uint width, uint height);
+
+    /// @brief Encode RGBA8888 pixels (edge blocks are padded by clamping)
+    std::vector<ubyte> encode(
+        Format format, const ubyte* rgba, uint width, uint height
+    );
+
+    /// @brief Decode to RGBA8888 pixels
+    void decode(
+        Format format, const ubyte* src, uint width, uint height, ubyte* dst
+    );
+
+    /// @brief Compress RGBA8888 image with box-filtered mip levels.
+    /// BC1 is chosen for fully opaque images, BC3 otherwise
+    /// @param levels number of levels (including the base one)
+    std::unique_ptr<CompressedImage> compress(
+        const ImageData& image, uint levels
+    );
+}
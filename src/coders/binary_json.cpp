@@ -1,90 +1,375 @@
 #include "binary_json.hpp"
 
+#include <cstring>
 #include <stdexcept>
 
 #include "data/dv.hpp"
 #include "byte_utils.hpp"
 #include "gzip.hpp"
+#include "io/deflate_istream.hpp"
+#include "io/deflate_ostream.hpp"
 #include "util/Buffer.hpp"
+#include "util/data_io.hpp"
 
 using namespace json;
 
-static void to_binary(ByteBuilder& builder, const dv::value& value) {
-    switch (value.getType()) {
-        case dv::value_type::none:
-            throw std::runtime_error("none value is not implemented");
-        case dv::value_type::object: {
-            const auto bytes = json::to_binary(value);
-            builder.put(bytes.data(), bytes.size());
-            break;
-        }
-        case dv::value_type::list:
-            builder.put(BJSON_TYPE_LIST);
-            for (const auto& element : value) {
-                to_binary(builder, element);
+namespace {
+    /// @brief Appends bytes to a vector
+    class VectorSink {
+        std::vector<ubyte>& dst;
+    public:
+        VectorSink(std::vector<ubyte>& dst) : dst(dst) {}
+
+        void write(const void* data, size_t size) {
+            auto bytes = reinterpret_cast<const ubyte*>(data);
+            dst.insert(dst.end(), bytes, bytes + size);
+        }
+    };
+
+    class StreamSink {
+        std::streambuf& dst;
+    public:
+        StreamSink(std::ostream& dst) : dst(*dst.rdbuf()) {}
+
+        void write(const void* data, size_t size) {
+            auto written = dst.sputn(reinterpret_cast<const char*>(data), size);
+            if (static_cast<size_t>(written) != size) {
+                throw std::runtime_error("binary json stream write failed");
             }
-            builder.put(BJSON_END);
-            break;
-        case dv::value_type::bytes: {
-            const auto& bytes = value.asBytes();
-            builder.put(BJSON_TYPE_BYTES);
-            builder.putInt32(bytes.size());
-            builder.put(bytes.data(), bytes.size());
-            break;
-        }
-        case dv::value_type::integer: {
-            auto val = value.asInteger();
-            if (val >= 0 && val <= 255) {
-                builder.put(BJSON_TYPE_BYTE);
-                builder.put(val);
-            } else if (val >= INT16_MIN && val <= INT16_MAX) {
-                builder.put(BJSON_TYPE_INT16);
-                builder.putInt16(val);
-            } else if (val >= INT32_MIN && val <= INT32_MAX) {
-                builder.put(BJSON_TYPE_INT32);
-                builder.putInt32(val);
-            } else {
-                builder.put(BJSON_TYPE_INT64);
-                builder.putInt64(val);
+        }
+    };
+
+    /// @brief Vector output used as compression destination
+    class vector_streambuf : public std::streambuf {
+        std::vector<ubyte>& dst;
+    public:
+        vector_streambuf(std::vector<ubyte>& dst) : dst(dst) {}
+    protected:
+        int_type overflow(int_type c) override {
+            if (c != traits_type::eof()) {
+                dst.push_back(static_cast<ubyte>(c));
             }
-            break;
-        }
-        case dv::value_type::number:
-            builder.put(BJSON_TYPE_NUMBER);
-            builder.putFloat64(value.asNumber());
-            break;
-        case dv::value_type::boolean:
-            builder.put(BJSON_TYPE_FALSE + value.asBoolean());
-            break;
-        case dv::value_type::string:
-            builder.put(BJSON_TYPE_STRING);
-            builder.put(value.asString());
-            break;
+            return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(const char* s, std::streamsize n) override {
+            dst.insert(dst.end(), s, s + n);
+            return n;
+        }
+    };
+
+    int integer_typecode(dv::integer_t val) {
+        if (val >= 0 && val <= 255) {
+            return BJSON_TYPE_BYTE;
+        } else if (val >= INT16_MIN && val <= INT16_MAX) {
+            return BJSON_TYPE_INT16;
+        } else if (val >= INT32_MIN && val <= INT32_MAX) {
+            return BJSON_TYPE_INT32;
+        }
+        return BJSON_TYPE_INT64;
     }
+
+    /// @brief Writes encoded value directly to the sink. Documents sizes
+    /// are calculated in a separate pass, so no intermediate buffers needed
+    template <class Sink>
+    class Encoder {
+        Sink& sink;
+        /// @brief Documents sizes in order of appearance
+        std::vector<int32_t> sizes;
+        size_t nextDocument = 0;
+
+        void put(ubyte b) {
+            sink.write(&b, 1);
+        }
+
+        template <typename T>
+        void putInt(T val) {
+            val = dataio::h2le(val);
+            sink.write(&val, sizeof(T));
+        }
+
+        size_t measureDocument(const dv::value& object) {
+            size_t index = sizes.size();
+            sizes.push_back(0);
+            // type byte, document size and terminating byte
+            size_t size = 1 + sizeof(int32_t) + 1;
+            for (const auto& [key, value] : object.asObject()) {
+                size += key.length() + 1 + measure(value);
+            }
+            sizes[index] = static_cast<int32_t>(size);
+            return size;
+        }
+
+        size_t measure(const dv::value& value) {
+            switch (value.getType()) {
+                case dv::value_type::none:
+                    throw std::runtime_error("none value is not implemented");
+                case dv::value_type::object:
+                    return measureDocument(value);
+                case dv::value_type::list: {
+                    size_t size = 2;
+                    for (const auto& element : value) {
+                        size += measure(element);
+                    }
+                    return size;
+                }
+                case dv::value_type::bytes:
+                    return 1 + sizeof(int32_t) + value.asBytes().size();
+                case dv::value_type::integer:
+                    switch (integer_typecode(value.asInteger())) {
+                        case BJSON_TYPE_BYTE: return 2;
+                        case BJSON_TYPE_INT16: return 1 + sizeof(int16_t);
+                        case BJSON_TYPE_INT32: return 1 + sizeof(int32_t);
+                        default: return 1 + sizeof(int64_t);
+                    }
+                case dv::value_type::number:
+                    return 1 + sizeof(double);
+                case dv::value_type::boolean:
+                    return 1;
+                case dv::value_type::string:
+                    return 1 + sizeof(int32_t) + value.asString().length();
+            }
+            return 0;
+        }
+
+        void writeDocument(const dv::value& object) {
+            put(BJSON_TYPE_DOCUMENT);
+            putInt<int32_t>(sizes.at(nextDocument++));
+            for (const auto& [key, value] : object.asObject()) {
+                sink.write(key.c_str(), key.length() + 1);
+                write(value);
+            }
+            put(BJSON_END);
+        }
+
+        void write(const dv::value& value) {
+            switch (value.getType()) {
+                case dv::value_type::none:
+                    throw std::runtime_error("none value is not implemented");
+                case dv::value_type::object:
+                    writeDocument(value);
+                    break;
+                case dv::value_type::list:
+                    put(BJSON_TYPE_LIST);
+                    for (const auto& element : value) {
+                        write(element);
+                    }
+                    put(BJSON_END);
+                    break;
+                case dv::value_type::bytes: {
+                    const auto& bytes = value.asBytes();
+                    put(BJSON_TYPE_BYTES);
+                    putInt<int32_t>(bytes.size());
+                    sink.write(bytes.data(), bytes.size());
+                    break;
+                }
+                case dv::value_type::integer: {
+                    auto val = value.asInteger();
+                    int typecode = integer_typecode(val);
+                    put(typecode);
+                    switch (typecode) {
+                        case BJSON_TYPE_BYTE: put(val); break;
+                        case BJSON_TYPE_INT16: putInt<int16_t>(val); break;
+                        case BJSON_TYPE_INT32: putInt<int32_t>(val); break;
+                        default: putInt<int64_t>(val); break;
+                    }
+                    break;
+                }
+                case dv::value_type::number: {
+                    double val = value.asNumber();
+                    int64_t i64_val;
+                    std::memcpy(&i64_val, &val, sizeof(int64_t));
+                    put(BJSON_TYPE_NUMBER);
+                    putInt<int64_t>(i64_val);
+                    break;
+                }
+                case dv::value_type::boolean:
+                    put(BJSON_TYPE_FALSE + value.asBoolean());
+                    break;
+                case dv::value_type::string: {
+                    const auto& str = value.asString();
+                    put(BJSON_TYPE_STRING);
+                    putInt<int32_t>(str.length());
+                    sink.write(str.data(), str.length());
+                    break;
+                }
+            }
+        }
+    public:
+        Encoder(Sink& sink) : sink(sink) {}
+
+        /// @return encoded document size
+        size_t prepare(const dv::value& object) {
+            return measureDocument(object);
+        }
+
+        void encode(const dv::value& object) {
+            writeDocument(object);
+        }
+    };
+
+    /// @brief Pull-style decoder reading values from the stream buffer
+    /// as they are needed
+    class Decoder {
+        std::streambuf& src;
+
+        [[noreturn]] static void underflow() {
+            throw std::runtime_error("binary json: unexpected end of stream");
+        }
+
+        ubyte get() {
+            auto c = src.sbumpc();
+            if (c == std::streambuf::traits_type::eof()) {
+                underflow();
+            }
+            return static_cast<ubyte>(c);
+        }
+
+        ubyte peek() {
+            auto c = src.sgetc();
+            if (c == std::streambuf::traits_type::eof()) {
+                underflow();
+            }
+            return static_cast<ubyte>(c);
+        }
+
+        void read(void* dst, size_t size) {
+            auto count = src.sgetn(reinterpret_cast<char*>(dst), size);
+            if (static_cast<size_t>(count) != size) {
+                underflow();
+            }
+        }
+
+        template <typename T>
+        T getInt() {
+            T val;
+            read(&val, sizeof(T));
+            return dataio::le2h(val);
+        }
+
+        std::string getCString() {
+            std::string str;
+            while (ubyte c = get()) {
+                str.push_back(static_cast<char>(c));
+            }
+            return str;
+        }
+
+        dv::value readList() {
+            auto list = dv::list();
+            while (peek() != BJSON_END) {
+                list.add(readValue());
+            }
+            get();
+            return list;
+        }
+
+        dv::value readObject() {
+            auto obj = dv::object();
+            while (peek() != BJSON_END) {
+                auto key = getCString();
+                obj[key] = readValue();
+            }
+            get();
+            return obj;
+        }
+    public:
+        Decoder(std::istream& src) : src(*src.rdbuf()) {}
+
+        dv::value readValue() {
+            ubyte typecode = get();
+            switch (typecode) {
+                case BJSON_TYPE_DOCUMENT:
+                    getInt<int32_t>();
+                    return readObject();
+                case BJSON_TYPE_LIST:
+                    return readList();
+                case BJSON_TYPE_BYTE:
+                    return get();
+                case BJSON_TYPE_INT16:
+                    return getInt<int16_t>();
+                case BJSON_TYPE_INT32:
+                    return getInt<int32_t>();
+                case BJSON_TYPE_INT64:
+                    return getInt<int64_t>();
+                case BJSON_TYPE_NUMBER: {
+                    int64_t i64_val = getInt<int64_t>();
+                    double val;
+                    std::memcpy(&val, &i64_val, sizeof(double));
+                    return val;
+                }
+                case BJSON_TYPE_FALSE:
+                case BJSON_TYPE_TRUE:
+                    return (typecode - BJSON_TYPE_FALSE) != 0;
+                case BJSON_TYPE_STRING: {
+                    uint32_t length = static_cast<uint32_t>(getInt<int32_t>());
+                    std::string str(length, '\0');
+                    read(str.data(), length);
+                    return str;
+                }
+                case BJSON_TYPE_NULL:
+                    return nullptr;
+                case BJSON_TYPE_BYTES: {
+                    int32_t size = getInt<int32_t>();
+                    if (size < 0) {
+                        throw std::runtime_error(
+                            "invalid byte-buffer size "+std::to_string(size));
+                    }
+                    auto bytes = std::make_shared<util::Buffer<ubyte>>(size);
+                    read(bytes->data(), size);
+                    return bytes;
+                }
+            }
+            throw std::runtime_error(
+                "type support not implemented for <"+std::to_string(typecode)+">");
+        }
+    };
 }
 
-std::vector<ubyte> json::to_binary(const dv::value& object, bool compress) {
+static void write_raw(std::ostream& dst, const dv::value& object) {
+    StreamSink sink(dst);
+    Encoder encoder(sink);
+    encoder.prepare(object);
+    encoder.encode(object);
+}
+
+void json::write_binary(
+    std::ostream& dst, const dv::value& object, bool compress
+) {
     if (compress) {
-        auto bytes = to_binary(object, false);
-        return gzip::compress(bytes.data(), bytes.size());
+        deflate_ostream stream(dst, Z_DEFAULT_COMPRESSION, true);
+        write_raw(stream, object);
+    } else {
+        write_raw(dst, object);
     }
-    ByteBuilder builder;
-    // type byte
-    builder.put(BJSON_TYPE_DOCUMENT);
-    // document size
-    builder.putInt32(0);
-
-    // writing entries
-    for (const auto& [key, value] : object.asObject()) {
-        builder.putCStr(key.c_str());
-        to_binary(builder, value);
+}
+
+std::vector<ubyte> json::to_binary(const dv::value& object, bool compress) {
+    std::vector<ubyte> bytes;
+    if (compress) {
+        vector_streambuf buffer(bytes);
+        std::ostream stream(&buffer);
+        write_binary(stream, object, true);
+        return bytes;
     }
-    // terminating byte
-    builder.put(BJSON_END);
+    VectorSink sink(bytes);
+    Encoder encoder(sink);
+    bytes.reserve(encoder.prepare(object));
+    encoder.encode(object);
+    return bytes;
+}
 
-    // updating document size
-    builder.setInt32(1, builder.size());
-    return builder.build();
+dv::value json::read_binary(std::istream& src) {
+    // compressed document type code matches the GZIP magic first byte
+    if (src.peek() == BJSON_TYPE_CDOCUMENT) {
+        deflate_istreambuf buffer(src, true);
+        std::istream stream(&buffer);
+        return Decoder(stream).readValue();
+    }
+    if (!src) {
+        throw std::runtime_error("binary json: unexpected end of stream");
+    }
+    return Decoder(src).readValue();
 }
 
 static dv::value list_from_binary(ByteReader& reader);
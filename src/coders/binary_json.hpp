@@ -1,5 +1,6 @@
 #pragma once
 
+#include <iosfwd>
 #include <memory>
 #include <vector>
 
@@ -24,6 +25,16 @@ namespace json {
     inline constexpr int BJSON_TYPE_CDOCUMENT = 0x1F;
 
     std::vector<ubyte> to_binary(const dv::value& obj, bool compress = false);
+
+    /// @brief Encode document directly to the output stream
+    /// @param compress write GZIP-compressed document (see from_binary)
+    void write_binary(
+        std::ostream& dst, const dv::value& obj, bool compress = false
+    );
     
     dv::value from_binary(const ubyte* src, size_t size);
+
+    /// @brief Decode document pulling bytes from the input stream as needed.
+    /// Compressed documents are inflated on the fly
+    dv::value read_binary(std::istream& src);
 }
@@ -6,10 +6,30 @@
 
 #include "rle.hpp"
 #include "gzip.hpp"
+#include "lz4.hpp"
+#include "zstd.hpp"
 #include "util/BufferPool.hpp"
 
 using namespace compression;
 
+static std::unique_ptr<ubyte[]> to_unique(
+    const std::vector<ubyte>& buffer, size_t& len
+) {
+    auto data = std::make_unique<ubyte[]>(buffer.size());
+    std::memcpy(data.get(), buffer.data(), buffer.size());
+    len = buffer.size();
+    return data;
+}
+
+static void check_decompressed_size(size_t expected, size_t decoded) {
+    if (decoded != expected) {
+        throw std::runtime_error(
+            "expected decompressed size " + std::to_string(expected) +
+            " got " + std::to_string(decoded)
+        );
+    }
+}
+
 inline constexpr float BUFFER_NOCROP_THRESOLD = 0.9;
 
 static util::BufferPool<ubyte> buffer_pools[] {
@@ -72,6 +92,10 @@ std::unique_ptr<ubyte[]> compression::compress(
             len = buffer.size();
             return data;
         }
+        case Method::ZSTD:
+            return to_unique(zstd::compress(src, srclen), len);
+        case Method::LZ4:
+            return to_unique(lz4::compress(src, srclen), len);
         default:
             throw std::runtime_error("not implemented");
     }
@@ -109,6 +133,17 @@ std::unique_ptr<ubyte[]> compression::decompress(
             std::memcpy(decompressed.get(), buffer.data(), buffer.size());
             return decompressed;
         }
+        case Method::ZSTD:
+        case Method::LZ4: {
+            auto decompressed = std::make_unique<ubyte[]>(dstlen);
+            decompress(
+                util::span<ubyte>(src, srclen),
+                decompressed.get(),
+                dstlen,
+                method
+            );
+            return decompressed;
+        }
         default:
             throw std::runtime_error("method not implemented");
     }
@@ -143,6 +178,16 @@ void compression::decompress(const util::span<ubyte> src, ubyte* dst, size_t dst
             std::memcpy(dst, buffer.data(), buffer.size());
             break;
         }
+        case Method::ZSTD:
+            check_decompressed_size(
+                dstlen, zstd::decompress(src.data(), src.size(), dst, dstlen)
+            );
+            break;
+        case Method::LZ4:
+            check_decompressed_size(
+                dstlen, lz4::decompress(src.data(), src.size(), dst, dstlen)
+            );
+            break;
         default:
             throw std::runtime_error("method not implemented");
     }
@@ -6,8 +6,10 @@
 #include "util/span.hpp"
 
 namespace compression {
+    /// @brief Compression methods. Values are stored in region files
+    /// headers, so new methods must be added to the end
     enum class Method {
-        NONE, EXTRLE8, EXTRLE16, GZIP
+        NONE, EXTRLE8, EXTRLE16, GZIP, ZSTD, LZ4
     };
 
     /// @brief Compress buffer
@@ -41,7 +41,7 @@ std::unique_ptr<ImageData> imageio::read(const io::path& file) {
             "file format is not supported (read): " + file.string()
         );
     }
-    auto bytes = io::read_bytes_buffer(file);
+    auto bytes = io::read_view(file);
     try {
         return std::unique_ptr<ImageData>(found->second(bytes.data(), bytes.size()));
     } catch (const std::runtime_error& err) {
@@ -9,8 +9,77 @@
 #include "util/stringutil.hpp"
 #include "BasicParser.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define VC_JSON_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define VC_JSON_NEON
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 using namespace json;
 
+/// @brief Find first character ending a plain run of string literal
+/// characters: the quote, a backslash or a newline. Scans 16 bytes
+/// per step where SIMD is available
+/// @return index of the character or src.size() if not found
+static size_t find_string_special(std::string_view src, size_t pos, char quote) {
+    const char* data = src.data();
+    size_t size = src.size();
+#if defined(VC_JSON_SSE2)
+    const __m128i quotes = _mm_set1_epi8(quote);
+    const __m128i backslashes = _mm_set1_epi8('\\');
+    const __m128i newlines = _mm_set1_epi8('\n');
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(chunk, quotes),
+                _mm_cmpeq_epi8(chunk, backslashes)
+            ),
+            _mm_cmpeq_epi8(chunk, newlines)
+        );
+        uint mask = static_cast<uint>(_mm_movemask_epi8(special));
+        if (mask) {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return pos + index;
+#else
+            return pos + __builtin_ctz(mask);
+#endif
+        }
+    }
+#elif defined(VC_JSON_NEON)
+    const uint8x16_t quotes = vdupq_n_u8(quote);
+    const uint8x16_t backslashes = vdupq_n_u8('\\');
+    const uint8x16_t newlines = vdupq_n_u8('\n');
+    for (; pos + 16 <= size; pos += 16) {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(data + pos));
+        uint8x16_t special = vorrq_u8(
+            vorrq_u8(vceqq_u8(chunk, quotes), vceqq_u8(chunk, backslashes)),
+            vceqq_u8(chunk, newlines)
+        );
+        uint64x2_t halves = vreinterpretq_u64_u8(special);
+        if (vgetq_lane_u64(halves, 0) | vgetq_lane_u64(halves, 1)) {
+            break;  // found inside, resolved by the scalar loop
+        }
+    }
+#endif
+    for (; pos < size; pos++) {
+        char c = data[pos];
+        if (c == quote || c == '\\' || c == '\n') {
+            return pos;
+        }
+    }
+    return size;
+}
+
 namespace {
     class Parser : BasicParser<char> {
         public:
@@ -21,6 +90,9 @@ namespace {
         dv::value parseList();
         dv::value parseObject();
         dv::value parseValue();
+
+        /// @brief Fast path of parseString for literals without escapes
+        std::string parseJsonString(char quote);
     };
 }
 
@@ -190,7 +262,7 @@ dv::value Parser::parseObject() {
             continue;
         }
         expect('"');
-        std::string key = parseString('"');
+        std::string key = parseJsonString('"');
         char next = peek();
         if (next != ':') {
             throw error("':' expected");
@@ -233,6 +305,20 @@ dv::value Parser::parseList() {
     return list;
 }
 
+std::string Parser::parseJsonString(char quote) {
+    size_t end = find_string_special(source, pos, quote);
+    if (end < source.size() && source[end] == quote) {
+        std::string string(source.substr(pos, end - pos));
+        pos = end + 1;
+        return string;
+    }
+    // escape sequence, newline or end of source: use the generic parser
+    // from the first special character
+    std::string prefix(source.substr(pos, end - pos));
+    pos = end;
+    return prefix + parseString(quote);
+}
+
 dv::value Parser::parseValue() {
     char next = peek();
     if (next == '-' || next == '+' || is_digit(next)) {
@@ -265,7 +351,7 @@ dv::value Parser::parseValue() {
     }
     if (next == '"' || next == '\'') {
         pos++;
-        return parseString(next);
+        return parseJsonString(next);
     }
     throw error("unexpected character '" + std::string({next}) + "'");
 }
@@ -0,0 +1,44 @@
+#include "lz4.hpp"
+
+#include <lz4.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+static constexpr size_t MAX_INPUT_SIZE = LZ4_MAX_INPUT_SIZE;
+
+std::vector<ubyte> lz4::compress(const ubyte* src, size_t size) {
+    if (size > MAX_INPUT_SIZE) {
+        throw std::invalid_argument("lz4 input data is too big");
+    }
+    std::vector<ubyte> buffer(LZ4_compressBound(static_cast<int>(size)));
+    int compressed_size = LZ4_compress_default(
+        reinterpret_cast<const char*>(src),
+        reinterpret_cast<char*>(buffer.data()),
+        static_cast<int>(size),
+        static_cast<int>(buffer.size())
+    );
+    if (compressed_size <= 0) {
+        throw std::runtime_error("lz4 compression error");
+    }
+    buffer.resize(compressed_size);
+    return buffer;
+}
+
+size_t lz4::decompress(
+    const ubyte* src, size_t size, ubyte* dst, size_t dstlen
+) {
+    int decompressed_size = LZ4_decompress_safe(
+        reinterpret_cast<const char*>(src),
+        reinterpret_cast<char*>(dst),
+        static_cast<int>(size),
+        static_cast<int>(
+            std::min<size_t>(dstlen, std::numeric_limits<int>::max())
+        )
+    );
+    if (decompressed_size < 0) {
+        throw std::runtime_error("lz4 decompression error: corrupted data");
+    }
+    return decompressed_size;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+
+#include "typedefs.hpp"
+
+namespace lz4 {
+    /// Compress bytes array to LZ4 block
+    /// @param src source bytes array
+    /// @param size length of source bytes array
+    std::vector<ubyte> compress(const ubyte* src, size_t size);
+
+    /// Decompress LZ4 block
+    /// @param src LZ4 data
+    /// @param size length of LZ4 data
+    /// @param dst destination buffer
+    /// @param dstlen destination buffer capacity
+    /// @return decompressed data length
+    /// @throws std::runtime_error if data is corrupted
+    size_t decompress(const ubyte* src, size_t size, ubyte* dst, size_t dstlen);
+}
@@ -3,6 +3,8 @@
 #include <vorbis/codec.h>
 #include <vorbis/vorbisfile.h>
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 
 #include "io/io.hpp"
@@ -43,14 +45,45 @@ static inline std::string vorbis_error_message(int code) {
     }
 }
 
-std::unique_ptr<audio::PCM> ogg::load_pcm(
-    const io::path& file, bool headerOnly
-) {
-    OggVorbis_File vf;
-    int code;
-    if ((code = ov_fopen(io::resolve(file).u8string().c_str(), &vf))) {
-        throw std::runtime_error("vorbis: " + vorbis_error_message(code));
+namespace {
+    struct MemorySource {
+        const ubyte* data;
+        size_t size;
+        size_t position;
+    };
+}
+
+static size_t memory_read(void* dst, size_t size, size_t count, void* ptr) {
+    auto& source = *static_cast<MemorySource*>(ptr);
+    size_t bytes = std::min(size * count, source.size - source.position);
+    std::memcpy(dst, source.data + source.position, bytes);
+    source.position += bytes;
+    return size ? bytes / size : 0;
+}
+
+static int memory_seek(void* ptr, ogg_int64_t offset, int whence) {
+    auto& source = *static_cast<MemorySource*>(ptr);
+    ogg_int64_t position;
+    switch (whence) {
+        case SEEK_SET: position = offset; break;
+        case SEEK_CUR: position = source.position + offset; break;
+        case SEEK_END: position = source.size + offset; break;
+        default: return -1;
+    }
+    if (position < 0 || position > static_cast<ogg_int64_t>(source.size)) {
+        return -1;
     }
+    source.position = position;
+    return 0;
+}
+
+static long memory_tell(void* ptr) {
+    return static_cast<MemorySource*>(ptr)->position;
+}
+
+static std::unique_ptr<audio::PCM> read_pcm(
+    OggVorbis_File& vf, bool headerOnly
+) {
     std::vector<char> data;
 
     vorbis_info* info = ov_info(&vf, -1);
@@ -86,6 +119,30 @@ std::unique_ptr<audio::PCM> ogg::load_pcm(
     );
 }
 
+std::unique_ptr<audio::PCM> ogg::load_pcm(
+    const io::path& file, bool headerOnly
+) {
+    OggVorbis_File vf;
+    int code;
+    if ((code = ov_fopen(io::resolve(file).u8string().c_str(), &vf))) {
+        throw std::runtime_error("vorbis: " + vorbis_error_message(code));
+    }
+    return read_pcm(vf, headerOnly);
+}
+
+std::unique_ptr<audio::PCM> ogg::load_pcm(
+    const ubyte* data, size_t size, bool headerOnly
+) {
+    MemorySource source {data, size, 0};
+    ov_callbacks callbacks {memory_read, memory_seek, nullptr, memory_tell};
+    OggVorbis_File vf;
+    int code;
+    if ((code = ov_open_callbacks(&source, &vf, nullptr, 0, callbacks))) {
+        throw std::runtime_error("vorbis: " + vorbis_error_message(code));
+    }
+    return read_pcm(vf, headerOnly);
+}
+
 class OggStream : public PCMStream {
     OggVorbis_File vf;
     bool closed = false;
@@ -3,6 +3,7 @@
 #include <memory>
 
 #include "io/fwd.hpp"
+#include "typedefs.hpp"
 
 namespace audio {
     struct PCM;
@@ -13,6 +14,11 @@ namespace ogg {
     std::unique_ptr<audio::PCM> load_pcm(
         const io::path& file, bool headerOnly
     );
+
+    /// @brief Decode PCM from ogg file data kept in memory
+    std::unique_ptr<audio::PCM> load_pcm(
+        const ubyte* data, size_t size, bool headerOnly
+    );
     std::unique_ptr<audio::PCMStream> create_stream(
         const io::path& file
     );
@@ -158,12 +158,31 @@ static void read_in_memory(png_structp pngPtr, png_bytep dst, png_size_t toread)
     }
     auto& reader = *reinterpret_cast<InMemoryReader*>(ioPtr);
     if (reader.offset + toread > reader.size) {
-        throw std::runtime_error("buffer underflow");
+        // exceptions must not be thrown through libpng frames
+        png_error(pngPtr, "buffer underflow");
     }
     std::memcpy(dst, reader.bytes + reader.offset, toread);
     reader.offset += toread;
 }
 
+/// @brief Configure reader to skip work not affecting decoded pixels
+static void setup_fast_reading(png_structp pngPtr) {
+    // CRC of every chunk is calculated by default (assets integrity is
+    // expected to be checked at distribution level)
+    png_set_crc_action(pngPtr, PNG_CRC_QUIET_USE, PNG_CRC_QUIET_USE);
+#ifdef PNG_IGNORE_ADLER32
+    png_set_option(pngPtr, PNG_IGNORE_ADLER32, PNG_OPTION_ON);
+#endif
+#ifdef PNG_HANDLE_AS_UNKNOWN_SUPPORTED
+    // metadata chunks are not used, iCCP and zTXt are also decompressed
+    static const png_byte ignoredChunks[] =
+        "iCCP\0tEXt\0zTXt\0iTXt\0tIME\0pHYs\0eXIf\0sPLT\0hIST\0bKGD";
+    png_set_keep_unknown_chunks(
+        pngPtr, PNG_HANDLE_CHUNK_NEVER, ignoredChunks, sizeof(ignoredChunks) / 5
+    );
+#endif
+}
+
 void png_error_handler(png_structp pngPtr, png_const_charp errorMessage) {
     logger.error() << "libpng error: " << errorMessage;
     if (pngPtr) {
@@ -198,6 +217,7 @@ std::unique_ptr<ImageData> png::load_image(const ubyte* bytes, size_t size) {
     InMemoryReader reader {bytes, size, 0};
 
     png_set_read_fn(pngPtr, &reader, read_in_memory);
+    setup_fast_reading(pngPtr);
     png_read_info(pngPtr, infoPtr);
 
     png_uint_32 width = 0;
@@ -280,7 +300,7 @@ std::unique_ptr<Texture> png::load_texture(const ubyte* bytes, size_t size) {
 }
 
 std::unique_ptr<Texture> png::load_texture(const std::string& filename) {
-    auto bytes = io::read_bytes_buffer(filename);
+    auto bytes = io::read_view(filename);
     try {
         return load_texture(bytes.data(), bytes.size());
     } catch (const std::runtime_error& err) {
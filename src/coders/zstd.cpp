@@ -0,0 +1,37 @@
+#include "zstd.hpp"
+
+#include <zstd.h>
+
+#include <stdexcept>
+#include <string>
+
+/// @brief Balanced between speed and ratio for frequent chunks saving
+static constexpr int COMPRESSION_LEVEL = 3;
+
+std::vector<ubyte> zstd::compress(const ubyte* src, size_t size) {
+    std::vector<ubyte> buffer(ZSTD_compressBound(size));
+    size_t compressed_size = ZSTD_compress(
+        buffer.data(), buffer.size(), src, size, COMPRESSION_LEVEL
+    );
+    if (ZSTD_isError(compressed_size)) {
+        throw std::runtime_error(
+            std::string("zstd compression error: ") +
+            ZSTD_getErrorName(compressed_size)
+        );
+    }
+    buffer.resize(compressed_size);
+    return buffer;
+}
+
+size_t zstd::decompress(
+    const ubyte* src, size_t size, ubyte* dst, size_t dstlen
+) {
+    size_t decompressed_size = ZSTD_decompress(dst, dstlen, src, size);
+    if (ZSTD_isError(decompressed_size)) {
+        throw std::runtime_error(
+            std::string("zstd decompression error: ") +
+            ZSTD_getErrorName(decompressed_size)
+        );
+    }
+    return decompressed_size;
+}
@@ -17,11 +17,18 @@ inline constexpr bool ENGINE_DEBUG_BUILD = true;
 inline const std::string ENGINE_VERSION_STRING = "0.31";
 
 /// @brief world regions format version
-inline constexpr uint REGION_FORMAT_VERSION = 3;
+inline constexpr uint REGION_FORMAT_VERSION = 5;
 
-/// @brief max simultaneously open world region files
+/// @brief oldest world regions format version read without upgrade.
+/// Such region files are rewritten in the current format on save
+inline constexpr uint REGION_FORMAT_MIN_VERSION = 3;
+
+/// @brief default max open world region files per layer not in use
 inline constexpr uint MAX_OPEN_REGION_FILES = 32;
 
+/// @brief number of independently locked open region files groups per layer
+inline constexpr uint REGION_FILES_SHARDS = 8;
+
 inline constexpr blockid_t BLOCK_AIR = 0;
 inline constexpr blockid_t BLOCK_OBSTACLE = 1;
 inline constexpr blockid_t BLOCK_STRUCT_AIR = 2;
@@ -36,14 +43,23 @@ inline constexpr int CHUNK_D = 16;
 inline constexpr uint VOXEL_USER_BITS = 8;
 inline constexpr uint VOXEL_USER_BITS_OFFSET = sizeof(blockstate_t)*8-VOXEL_USER_BITS;
 
-/// @brief % unordered map max average buckets load factor.
-/// Low value gives significant performance impact by minimizing collisions and
-/// lookup latency. Default value (1.0) shows x2 slower work.
-inline constexpr float CHUNKS_MAP_MAX_LOAD_FACTOR = 0.1f;
-
 /// @brief chunk volume (count of voxels per Chunk)
 inline constexpr int CHUNK_VOL = (CHUNK_W * CHUNK_H * CHUNK_D);
 
+/// @brief height of chunk mesh section (remeshed independently)
+inline constexpr int CHUNK_SECTION_H = 16;
+/// @brief number of mesh sections per chunk
+inline constexpr int CHUNK_SECTIONS = CHUNK_H / CHUNK_SECTION_H;
+/// @brief count of voxels per chunk section
+inline constexpr int CHUNK_SECTION_VOL = CHUNK_W * CHUNK_D * CHUNK_SECTION_H;
+
+/// @brief bit mask of chunk mesh sections
+using chunk_sections_t = uint16_t;
+
+static_assert(CHUNK_SECTIONS <= sizeof(chunk_sections_t) * 8);
+inline constexpr chunk_sections_t CHUNK_ALL_SECTIONS =
+    static_cast<chunk_sections_t>((1U << CHUNK_SECTIONS) - 1);
+
 /// @brief block id used to mark non-existing voxel (voxel of missing chunk)
 inline constexpr blockid_t BLOCK_VOID = std::numeric_limits<blockid_t>::max();
 /// @brief item id used to mark non-existing item (error)
@@ -61,8 +77,15 @@ inline constexpr int ITEM_ICON_SIZE = 48;
 
 inline constexpr int TRANSLUCENT_BLOCKS_SORT_INTERVAL = 8;
 
+/// @brief World environment (day-time, weather effects) update interval
+/// in seconds
+inline constexpr float ENVIRONMENT_TICK_INTERVAL = 1.0f / 20.0f;
+
 inline constexpr int ATLAS_EXTRUSION = 2;
 
+/// @brief Mip levels count of atlases loaded from textures directories
+inline constexpr int ATLAS_MIP_LEVELS = 5;
+
 inline constexpr int DEFAULT_FONT_SIZE = 16;
 
 inline constexpr int DEFAULT_PRE_RENDER_FONT_PAGES = 1; // must be at least 1
@@ -13,6 +13,28 @@
 #include "world/generator/GeneratorDef.hpp"
 #include "ContentPack.hpp"
 
+static bool is_unit_cube(const std::vector<AABB>& boxes) {
+    return boxes.size() == 1 && boxes[0].min() == glm::vec3(0.0f) &&
+           boxes[0].max() == glm::vec3(1.0f);
+}
+
+static BlockCollision collision_of(const Block& def) {
+    if (!def.obstacle || def.hitboxes.empty()) {
+        return BlockCollision::NONE;
+    }
+    if (def.rt.extended || !is_unit_cube(def.hitboxes)) {
+        return BlockCollision::COMPLEX;
+    }
+    if (def.rotatable) {
+        for (const auto& boxes : def.rt.hitboxes) {
+            if (!is_unit_cube(boxes)) {
+                return BlockCollision::COMPLEX;
+            }
+        }
+    }
+    return BlockCollision::FULL;
+}
+
 ContentIndices::ContentIndices(
     ContentUnitIndices<Block, blockid_t> blocks,
     ContentUnitIndices<ItemDef, itemid_t> items,
@@ -21,6 +43,15 @@ ContentIndices::ContentIndices(
     : blocks(std::move(blocks)),
       items(std::move(items)),
       entities(std::move(entities)) {
+    const auto& defs = this->blocks.getIterable();
+    lightPassingMasks.resize(defs.size());
+    skyLightPassingMasks.resize(defs.size());
+    blockCollisions.resize(defs.size());
+    for (size_t i = 0; i < defs.size(); i++) {
+        lightPassingMasks[i] = defs[i]->lightPassing ? 0xFF : 0x00;
+        skyLightPassingMasks[i] = defs[i]->skyLightPassing ? 0xFF : 0x00;
+        blockCollisions[i] = collision_of(*defs[i]);
+    }
 }
 
 Content::Content(
@@ -72,8 +72,21 @@ private:
     }
 };
 
+/// @brief Block collision shape class used by physics fast paths
+enum class BlockCollision : uint8_t {
+    /// @brief Not an obstacle
+    NONE,
+    /// @brief Single unit cube hitbox in all rotations
+    FULL,
+    /// @brief Hitboxes must be tested
+    COMPLEX,
+};
+
 /// @brief Runtime defs cache: indices
 class ContentIndices {
+    std::vector<uint8_t> lightPassingMasks;
+    std::vector<uint8_t> skyLightPassingMasks;
+    std::vector<BlockCollision> blockCollisions;
 public:
     ContentUnitIndices<Block, blockid_t> blocks;
     ContentUnitIndices<ItemDef, itemid_t> items;
@@ -84,6 +97,25 @@ public:
         ContentUnitIndices<ItemDef, itemid_t> items,
         ContentUnitIndices<EntityDef, entitydefid_t> entities
     );
+
+    /// @brief Flat table indexed by block id: 0xFF if block is light
+    /// passing, 0x00 otherwise. Used as ready lanes masks in lighting.
+    const uint8_t* getLightPassingMasks() const {
+        return lightPassingMasks.data();
+    }
+
+    /// @brief Same as getLightPassingMasks() for sky light passing
+    const uint8_t* getSkyLightPassingMasks() const {
+        return skyLightPassingMasks.data();
+    }
+
+    /// @brief Get block collision class from the flat table, so voxel
+    /// collision test does not access block definition for the most of
+    /// blocks. Invalid ids are COMPLEX to be reported by the full check
+    BlockCollision getBlockCollision(blockid_t id) const {
+        return id < blockCollisions.size() ? blockCollisions[id]
+                                           : BlockCollision::COMPLEX;
+    }
 };
 
 template <class T>
@@ -216,6 +248,10 @@ public:
         return defaults;
     }
 
+    const std::unordered_map<std::string, int>& getTags() const {
+        return tags;
+    }
+
     int getTagIndex(const std::string& tag) const {
         const auto& found = tags.find(tag);
         if (found == tags.end()) {
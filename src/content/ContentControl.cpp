@@ -7,6 +7,7 @@
 #include "ContentBuilder.hpp"
 #include "ContentLoader.hpp"
 #include "PacksManager.hpp"
+#include "loading/ContentFilesCache.hpp"
 #include "objects/rigging.hpp"
 #include "devtools/Project.hpp"
 #include "logic/scripting/scripting.hpp"
@@ -16,6 +17,8 @@ static void load_configs(Input* input, const io::path& root) {
     auto configFolder = root / "config";
 }
 
+static const io::path CONTENT_IMAGE_FILE = "user:cache/content.bin";
+
 static std::vector<io::path> default_content_sources {
     "world:content",
     "user:content",
@@ -106,9 +109,20 @@ void ContentControl::loadContent() {
         resRoots.push_back({pack.id, pack.folder});
     }
     paths.resPaths = ResPaths(resRoots);
+
+    // Read and parse data files of all packs in parallel
+    // or take them from the image written by the previous launch
+    std::vector<io::path> dataFiles;
+    for (const auto& pack : allPacks) {
+        auto packFiles = ContentLoader::listDataFiles(pack);
+        dataFiles.insert(dataFiles.end(), packFiles.begin(), packFiles.end());
+    }
+    ContentFilesCache files;
+    files.load(dataFiles, CONTENT_IMAGE_FILE);
+
     // Load content
     for (auto& pack : allPacks) {
-        ContentLoader(&pack, contentBuilder, paths.resPaths).load();
+        ContentLoader(&pack, contentBuilder, paths.resPaths, files).load();
         load_configs(input, pack.folder);
     }
     content = contentBuilder.build();
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <glm/glm.hpp>
 
+#include "loading/ContentFilesCache.hpp"
 #include "loading/ContentUnitLoader.hpp"
 #include "ContentBuilder.hpp"
 #include "ContentPack.hpp"
@@ -16,9 +17,12 @@
 static debug::Logger logger("content-loader");
 
 ContentLoader::ContentLoader(
-    ContentPack* pack, ContentBuilder& builder, const ResPaths& paths
+    ContentPack* pack,
+    ContentBuilder& builder,
+    const ResPaths& paths,
+    const ContentFilesCache& files
 )
-    : pack(pack), builder(builder), paths(paths) {
+    : pack(pack), builder(builder), paths(paths), files(files) {
     auto runtime = std::make_unique<ContentPackRuntime>(
         *pack, scripting::create_pack_environment(*pack)
     );
@@ -31,7 +35,8 @@ ContentLoader::ContentLoader(
 static void detect_defs(
     const io::path& folder,
     const std::string& prefix,
-    std::vector<std::string>& detected
+    std::vector<std::string>& detected,
+    const ContentFilesCache& files
 ) {
     if (!io::is_directory(folder)) {
         return;
@@ -42,11 +47,11 @@ static void detect_defs(
             continue;
         }
         if (io::is_regular_file(file) && io::is_data_file(file)) {
-            auto map = io::read_object(file);
+            auto map = files.read(file);
             std::string id = prefix.empty() ? name : prefix + ":" + name;
             detected.emplace_back(id);
         } else if (io::is_directory(file) && file.extension() != ".files") {
-            detect_defs(file, name, detected);
+            detect_defs(file, name, detected, files);
         }
     }
 }
@@ -80,6 +85,39 @@ static void detect_defs_pairs(
     }
 }
 
+static void list_data_files(
+    const io::path& folder, std::vector<io::path>& files
+) {
+    if (!io::is_directory(folder)) {
+        return;
+    }
+    for (const auto& file : io::directory_iterator(folder)) {
+        if (io::is_directory(file)) {
+            if (file.extension() != ".files") {
+                list_data_files(file, files);
+            }
+        } else if (io::is_data_file(file)) {
+            files.push_back(file);
+        }
+    }
+}
+
+std::vector<io::path> ContentLoader::listDataFiles(const ContentPack& pack) {
+    std::vector<io::path> files;
+    for (const auto& name :
+         {"content.json", "resources.json", "resource-aliases.json", "tags.toml"}) {
+        auto file = pack.folder / name;
+        if (io::is_regular_file(file)) {
+            files.push_back(file);
+        }
+    }
+    list_data_files(pack.folder / ContentPack::BLOCKS_FOLDER, files);
+    list_data_files(pack.folder / ContentPack::ITEMS_FOLDER, files);
+    list_data_files(pack.folder / ContentPack::ENTITIES_FOLDER, files);
+    list_data_files(pack.folder / "block_materials", files);
+    return files;
+}
+
 std::vector<std::tuple<std::string, std::string>> ContentLoader::scanContent(
     const ContentPack& pack, ContentType type
 ) {
@@ -92,10 +130,11 @@ std::vector<std::tuple<std::string, std::string>> ContentLoader::scanContent(
 bool ContentLoader::fixPackIndices(
     const io::path& folder,
     dv::value& indicesRoot,
-    const std::string& contentSection
+    const std::string& contentSection,
+    const ContentFilesCache& files
 ) {
     std::vector<std::string> detected;
-    detect_defs(folder, "", detected);
+    detect_defs(folder, "", detected, files);
 
     std::vector<std::string> indexed;
     bool modified = false;
@@ -131,18 +170,19 @@ void ContentLoader::fixPackIndices() {
 
     dv::value root;
     if (io::is_regular_file(contentFile)) {
-        root = io::read_json(contentFile);
+        root = files.read(contentFile);
     } else {
         root = dv::object();
     }
 
     bool modified = false;
-    modified |= fixPackIndices(blocksFolder, root, "blocks");
-    modified |= fixPackIndices(itemsFolder, root, "items");
-    modified |= fixPackIndices(entitiesFolder, root, "entities");
+    modified |= fixPackIndices(blocksFolder, root, "blocks", files);
+    modified |= fixPackIndices(itemsFolder, root, "items", files);
+    modified |= fixPackIndices(entitiesFolder, root, "entities", files);
 
     if (modified) {
         // rewrite modified json
+        // (root shares data with the cached file, so it's up to date too)
         io::write_json(contentFile, root);
     }
 }
@@ -184,7 +224,7 @@ void ContentUnitLoader<DefT>::loadUnit(
 void ContentLoader::loadBlockMaterial(
     BlockMaterial& def, const io::path& file
 ) {
-    def.deserialize(io::read_json(file));
+    def.deserialize(files.read(file));
     if (def.hitSound.empty()) {
         def.hitSound = def.stepsSound;
     }
@@ -202,8 +242,8 @@ void ContentUnitLoader<DefT>::loadDefs(const dv::value& root) {
     auto getJsonParent = [this](const std::string& prefix, const std::string& name) {
         auto configFile = pack.folder / (prefix + "/" + name + ".json");
         std::string parent;
-        if (io::exists(configFile)) {
-            auto root = io::read_json(configFile);
+        if (files.has(configFile) || io::exists(configFile)) {
+            auto root = files.read(configFile);
             root.at("parent").get(parent);
         }
         return parent;
@@ -276,7 +316,7 @@ void ContentLoader::loadContent(const dv::value& root) {
         builder.entities.defs.size(),
     };
 
-    ContentUnitLoader<Block>(*pack, builder.blocks, "blocks", 
+    ContentUnitLoader<Block>(*pack, builder.blocks, files, "blocks", 
         [this](Block& def) {
         if (!def.hidden) {
             bool created;
@@ -295,8 +335,9 @@ void ContentLoader::loadContent(const dv::value& root) {
         }
     }).loadDefs(root);
 
-    ContentUnitLoader(*pack, builder.items, "items").loadDefs(root);
-    ContentUnitLoader(*pack, builder.entities, "entities").loadDefs(root);
+    ContentUnitLoader(*pack, builder.items, files, "items").loadDefs(root);
+    ContentUnitLoader(*pack, builder.entities, files, "entities")
+        .loadDefs(root);
 
     stats->totalBlocks = builder.blocks.defs.size() - prevStats.totalBlocks;
     stats->totalItems = builder.items.defs.size() - prevStats.totalItems;
@@ -357,7 +398,7 @@ void ContentLoader::load() {
     // Load pack resources.json
     io::path resourcesFile = folder / "resources.json";
     if (io::exists(resourcesFile)) {
-        auto resRoot = io::read_json(resourcesFile);
+        auto resRoot = files.read(resourcesFile);
         for (const auto& [key, arr] : resRoot.asObject()) {
             ResourceType type;
             if (ResourceTypeMeta.getItem(key, type)) {
@@ -372,7 +413,7 @@ void ContentLoader::load() {
     // Load pack resources aliases
     io::path aliasesFile = folder / "resource-aliases.json";
     if (io::exists(aliasesFile)) {
-        auto resRoot = io::read_json(aliasesFile);
+        auto resRoot = files.read(aliasesFile);
         for (const auto& [key, arr] : resRoot.asObject()) {
             ResourceType type;
             if (ResourceTypeMeta.getItem(key, type)) {
@@ -400,13 +441,13 @@ void ContentLoader::load() {
     // Process content.json and load defined content units
     auto contentFile = pack->getContentFile();
     if (io::exists(contentFile)) {
-        loadContent(io::read_json(contentFile));
+        loadContent(files.read(contentFile));
     }
 
     // Load attached tags
     io::path tagsFile = folder / "tags.toml";
     if (io::exists(tagsFile)) {
-        auto tagsMap = io::read_object(tagsFile);
+        auto tagsMap = files.read(tagsFile);
         for (const auto& [key, list] : tagsMap.asObject()) {
             for (const auto& id : list) {
                 const auto& stringId = id.asString();
@@ -472,7 +513,8 @@ void ContentLoader::loadWorldScript(ContentPackRuntime& runtime) {
             pack.id,
             scriptFile,
             pack.id + ":scripts/world.lua",
-            runtime.worldfuncsset
+            runtime.worldfuncsset,
+            runtime.worldeventnames
         );
     }
 }
@@ -18,6 +18,7 @@ class ResPaths;
 class Content;
 class ContentBuilder;
 class ContentPackRuntime;
+class ContentFilesCache;
 struct ContentPackStats;
 
 class ContentLoader {
@@ -27,11 +28,12 @@ class ContentLoader {
     ContentBuilder& builder;
     ContentPackStats* stats;
     const ResPaths& paths;
+    const ContentFilesCache& files;
 
     void loadGenerator(
         GeneratorDef& def, const std::string& full, const std::string& name
     );
-    static void loadBlockMaterial(BlockMaterial& def, const io::path& file);
+    void loadBlockMaterial(BlockMaterial& def, const io::path& file);
     void loadResources(ResourceType type, const dv::value& list);
     void loadResourceAliases(ResourceType type, const dv::value& aliases);
 
@@ -40,16 +42,22 @@ public:
     ContentLoader(
         ContentPack* pack,
         ContentBuilder& builder,
-        const ResPaths& paths
+        const ResPaths& paths,
+        const ContentFilesCache& files
     );
 
     // Refresh pack content.json
     static bool fixPackIndices(
         const io::path& folder,
         dv::value& indicesRoot,
-        const std::string& contentSection
+        const std::string& contentSection,
+        const ContentFilesCache& files
     );
 
+    /// @brief List pack data files to be read in advance
+    /// (see ContentFilesCache)
+    static std::vector<io::path> listDataFiles(const ContentPack& pack);
+
     static std::vector<std::tuple<std::string, std::string>> scanContent(
         const ContentPack& pack, ContentType type
     );
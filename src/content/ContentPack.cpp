@@ -2,7 +2,10 @@
 #include "ContentPack.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <optional>
+#include <thread>
 #include <utility>
 
 #include "coders/json.hpp"
@@ -196,19 +199,57 @@ ContentPack ContentPack::read(const io::path& folder) {
 void ContentPack::scanFolder(
     const io::path& folder, std::vector<ContentPack>& packs
 ) {
-    if (!io::is_directory(folder)) {
-        return;
+    scanFolders({folder}, packs);
+}
+
+void ContentPack::scanFolders(
+    const std::vector<io::path>& folders, std::vector<ContentPack>& packs
+) {
+    std::vector<io::path> packFolders;
+    for (const auto& folder : folders) {
+        if (!io::is_directory(folder)) {
+            continue;
+        }
+        for (const auto& packFolder : io::directory_iterator(folder)) {
+            if (!io::is_directory(packFolder)) continue;
+            if (!is_pack(packFolder)) continue;
+            packFolders.push_back(packFolder);
+        }
+    }
+    size_t count = packFolders.size();
+    std::vector<std::optional<ContentPack>> results(count);
+    std::vector<std::string> errors(count);
+    std::atomic<size_t> next = 0;
+
+    auto work = [&]() {
+        size_t index;
+        while ((index = next++) < count) {
+            try {
+                results[index] = read(packFolders[index]);
+            } catch (const contentpack_error& err) {
+                errors[index] = "package.json error at " +
+                                err.getFolder().string() + ": " + err.what();
+            } catch (const std::runtime_error& err) {
+                errors[index] = err.what();
+            }
+        }
+    };
+    size_t numThreads = std::min<size_t>(
+        count, std::max(1u, std::thread::hardware_concurrency())
+    );
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < numThreads; i++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread : threads) {
+        thread.join();
     }
-    for (const auto& packFolder : io::directory_iterator(folder)) {
-        if (!io::is_directory(packFolder)) continue;
-        if (!is_pack(packFolder)) continue;
-        try {
-            packs.push_back(read(packFolder));
-        } catch (const contentpack_error& err) {
-            std::cerr << "package.json error at " << err.getFolder().string();
-            std::cerr << ": " << err.what() << std::endl;
-        } catch (const std::runtime_error& err) {
-            std::cerr << err.what() << std::endl;
+    for (size_t i = 0; i < count; i++) {
+        if (results[i]) {
+            packs.push_back(std::move(*results[i]));
+        } else if (!errors[i].empty()) {
+            std::cerr << errors[i] << std::endl;
         }
     }
 }
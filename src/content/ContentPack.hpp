@@ -92,6 +92,12 @@ struct ContentPack {
         const io::path& folder, std::vector<ContentPack>& packs
     );
 
+    /// @brief Read packs of the folders in parallel. Packs are added in
+    /// the folders order, invalid packs are reported and skipped
+    static void scanFolders(
+        const std::vector<io::path>& folders, std::vector<ContentPack>& packs
+    );
+
     static std::vector<std::string> worldPacksList(
         const io::path& folder
     );
@@ -122,6 +128,7 @@ struct WorldFuncsSet {
     bool onblockbreaking;
     bool onblockbroken;
     bool onblockinteract;
+    bool onblocksbatch;
     bool onplayertick;
     bool onchunkpresent;
     bool onchunkremove;
@@ -129,12 +136,28 @@ struct WorldFuncsSet {
     bool oninventoryclosed;
 };
 
+/// @brief World events handles (see lua::intern_event)
+struct WorldFuncNamesCache {
+    int onblockplaced;
+    int onblockreplaced;
+    int onblockbreaking;
+    int onblockbroken;
+    int onblockinteract;
+    int onblocksbatch;
+    int onplayertick;
+    int onchunkpresent;
+    int onchunkremove;
+    int oninventoryopen;
+    int oninventoryclosed;
+};
+
 class ContentPackRuntime {
     ContentPack info;
     ContentPackStats stats {};
     scriptenv env;
 public:
     WorldFuncsSet worldfuncsset {};
+    WorldFuncNamesCache worldeventnames {};
 
     ContentPackRuntime(ContentPack info, scriptenv env);
     ~ContentPackRuntime();
@@ -122,7 +122,7 @@ void ContentReport::buildIssues() {
     build_issues(issues, blocks);
     build_issues(issues, items);
     
-    if (regionsVersion < REGION_FORMAT_VERSION) {
+    if (regionsVersion < REGION_FORMAT_MIN_VERSION) {
         for (int layer = REGION_LAYER_VOXELS; 
              layer < REGION_LAYERS_COUNT; 
              layer++) {
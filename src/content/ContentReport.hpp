@@ -92,6 +92,10 @@ public:
     inline T getId(T index) const {
         return indices[index];
     }
+    /// @return dense old to new indices table
+    inline const std::vector<T>& getIndices() const {
+        return indices;
+    }
     inline void set(T index, std::string name, T id) {
         indices[index] = id;
         names[index] = std::move(name);
@@ -156,7 +160,14 @@ public:
         return blocks.hasMissingContent() || items.hasMissingContent();
     }
     inline bool isUpgradeRequired() const {
-        return regionsVersion < REGION_FORMAT_VERSION;
+        return regionsVersion < REGION_FORMAT_MIN_VERSION;
+    }
+    /// @brief Only blocks are reordered, so voxels regions may be
+    /// converted on access (see WorldRegions::remapBlocks)
+    inline bool isLazyConvertible() const {
+        return blocks.hasContentReorder() && !items.hasContentReorder() &&
+               !hasMissingContent() && !isUpgradeRequired() &&
+               !dataLayoutsUpdated;
     }
     inline bool hasDataLoss() const {
         return !dataLoss.empty();
@@ -21,11 +21,10 @@ void PacksManager::scan() {
     packs.clear();
 
     std::vector<ContentPack> packsList;
-    for (auto& folder : sources) {
-        ContentPack::scanFolder(folder, packsList);
-        for (auto& pack : packsList) {
-            packs.try_emplace(pack.id, pack);
-        }
+    ContentPack::scanFolders(sources, packsList);
+    // packs of the first sources take precedence
+    for (auto& pack : packsList) {
+        packs.try_emplace(pack.id, pack);
     }
 }
 
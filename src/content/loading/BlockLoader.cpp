@@ -1,7 +1,10 @@
 #define VC_ENABLE_REFLECTION
 #include "ContentUnitLoader.hpp"
+#include "ContentFilesCache.hpp"
 #include "ContentLoadingCommons.hpp"
 
+#include <algorithm>
+
 #include "../ContentBuilder.hpp"
 #include "coders/json.hpp"
 #include "core_defs.hpp"
@@ -84,10 +87,31 @@ static void load_variant(
     root.at("draw-group").get(variant.drawGroup);
 }
 
+/// @brief Max liquid flow levels (stored in 4 lower user bits)
+inline constexpr int MAX_CELLULAR_LEVELS = 16;
+
+static void load_cellular_rules(
+    CellularRules& rules, const dv::value& root, const std::string& name
+) {
+    std::string typeName = CellularTypeMeta.getNameString(rules.type);
+    root.at("type").get(typeName);
+    if (!CellularTypeMeta.getItem(typeName, rules.type)) {
+        logger.error() << name << ": unknown cellular type: " << typeName;
+        rules.type = CellularType::NONE;
+    }
+    int levels = rules.levels;
+    int interval = rules.interval;
+    root.at("levels").get(levels);
+    root.at("interval").get(interval);
+    root.at("slide").get(rules.slide);
+    rules.levels = std::clamp(levels, 1, MAX_CELLULAR_LEVELS);
+    rules.interval = std::clamp(interval, 1, 255);
+}
+
 template<> void ContentUnitLoader<Block>::loadUnit(
     Block& def, const std::string& name, const io::path& file
 ) {
-    auto root = io::read_json(file);
+    auto root = files.read(file);
     process_properties(def, name, root);
     process_tags(def, root);
 
@@ -241,6 +265,10 @@ template<> void ContentUnitLoader<Block>::loadUnit(
         def.particles->deserialize(root["particles"]);
     }
 
+    if (root.has("cellular")) {
+        load_cellular_rules(def.cellular, root["cellular"], def.name);
+    }
+
     if (def.tickInterval == 0) {
         def.tickInterval = 1;
     }
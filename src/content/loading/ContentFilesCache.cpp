@@ -0,0 +1,124 @@
+#include "ContentFilesCache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "debug/Logger.hpp"
+#include "io/io.hpp"
+#include "util/Hasher.hpp"
+
+static debug::Logger logger("content-files");
+
+static constexpr int IMAGE_VERSION = 1;
+
+static dv::value read_file(const io::path& file) {
+    if (file.extension() == ".json") {
+        return io::read_json(file);
+    }
+    return io::read_object(file);
+}
+
+void ContentFilesCache::load(const std::vector<io::path>& paths, int maxWorkers) {
+    size_t count = paths.size();
+    std::vector<dv::value> values(count);
+    std::vector<char> parsed(count, false);
+    std::atomic<size_t> next = 0;
+
+    auto work = [&]() {
+        size_t index;
+        while ((index = next++) < count) {
+            try {
+                values[index] = read_file(paths[index]);
+                parsed[index] = true;
+            } catch (const std::exception&) {
+                // will be thrown by read(...)
+            }
+        }
+    };
+
+    size_t numThreads = maxWorkers > 0
+                            ? static_cast<size_t>(maxWorkers)
+                            : std::thread::hardware_concurrency();
+    numThreads = std::max<size_t>(1, std::min(numThreads, count));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < numThreads; i++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (parsed[i]) {
+            files[paths[i].normalized().string()] = std::move(values[i]);
+        }
+    }
+}
+
+static uint64_t compute_key(const std::vector<io::path>& paths) {
+    util::Hasher hasher;
+    hasher.update(IMAGE_VERSION);
+    for (const auto& file : paths) {
+        hasher.update(file.string());
+        hasher.update(static_cast<uint64_t>(io::file_size(file)));
+        hasher.update(static_cast<int64_t>(
+            io::last_write_time(file).time_since_epoch().count()
+        ));
+    }
+    return hasher.get();
+}
+
+void ContentFilesCache::load(
+    const std::vector<io::path>& paths,
+    const io::path& imageFile,
+    int maxWorkers
+) {
+    auto key = static_cast<int64_t>(compute_key(paths));
+    if (io::is_regular_file(imageFile)) {
+        try {
+            auto root = io::read_binary_json(imageFile);
+            if (root["version"].asInteger() == IMAGE_VERSION &&
+                root["key"].asInteger() == key) {
+                for (const auto& [name, value] : root["files"].asObject()) {
+                    files[name] = value;
+                }
+                logger.info() << "loaded " << files.size() << " files from "
+                              << imageFile.string();
+                return;
+            }
+        } catch (const std::runtime_error& err) {
+            logger.error() << "could not read " << imageFile.string() << ": "
+                           << err.what();
+        }
+    }
+    load(paths, maxWorkers);
+
+    auto filesMap = dv::object();
+    for (const auto& [name, value] : files) {
+        filesMap[name] = value;
+    }
+    auto root = dv::object();
+    root["version"] = IMAGE_VERSION;
+    root["key"] = key;
+    root["files"] = std::move(filesMap);
+    try {
+        io::create_directories(imageFile.parent());
+        io::write_binary_json(imageFile, root);
+    } catch (const std::runtime_error& err) {
+        logger.error() << "could not write " << imageFile.string() << ": "
+                       << err.what();
+    }
+}
+
+dv::value ContentFilesCache::read(const io::path& file) const {
+    const auto& found = files.find(file.normalized().string());
+    if (found != files.end()) {
+        return found->second;
+    }
+    return read_file(file);
+}
+
+bool ContentFilesCache::has(const io::path& file) const {
+    return files.find(file.normalized().string()) != files.end();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "data/dv.hpp"
+#include "io/path.hpp"
+
+/// @brief Content data files read and parsed in advance by worker threads.
+/// Content units are still created serially in the packs order, so the
+/// result does not depend on workers timing
+class ContentFilesCache {
+    std::unordered_map<std::string, dv::value> files;
+public:
+    /// @brief Read and parse files in parallel. Failed files are not cached,
+    /// so the error is thrown by read(...) at the same loading step as
+    /// without the cache
+    /// @param maxWorkers max number of threads (0 is hardware concurrency)
+    void load(const std::vector<io::path>& paths, int maxWorkers = 0);
+
+    /// @brief Load binary image of the parsed files written by a previous
+    /// run. If any file is modified, added or removed since, the files are
+    /// loaded with load(...) and the image is rewritten
+    /// @param imageFile image file (binary json)
+    /// @param maxWorkers max number of threads (0 is hardware concurrency)
+    void load(
+        const std::vector<io::path>& paths,
+        const io::path& imageFile,
+        int maxWorkers = 0
+    );
+
+    /// @brief Get parsed file or read it if not cached
+    /// @throws std::runtime_error file read or parsing failed
+    dv::value read(const io::path& file) const;
+
+    bool has(const io::path& file) const;
+
+    size_t size() const {
+        return files.size();
+    }
+};
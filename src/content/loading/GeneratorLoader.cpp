@@ -5,9 +5,11 @@
 
 #include "../ContentPack.hpp"
 
+#include "coders/json.hpp"
 #include "io/io.hpp"
 #include "engine/EnginePaths.hpp"
 #include "logic/scripting/scripting.hpp"
+#include "util/Hasher.hpp"
 #include "util/stringutil.hpp"
 #include "world/generator/GeneratorDef.hpp"
 #include "world/generator/VoxelFragment.hpp"
@@ -247,6 +249,17 @@ void ContentLoader::loadGenerator(
         );
     }
     load_biomes(def, biomesMap);
+
+    util::Hasher hasher;
+    hasher.update(pack->version);
+    hasher.update(io::read_string(generatorFile));
+    if (io::is_regular_file(scriptFile)) {
+        hasher.update(io::read_string(scriptFile));
+    }
+    hasher.update(json::stringify(structuresMap, false));
+    hasher.update(json::stringify(biomesMap, false));
+    def.fingerprint = hasher.get();
+
     def.script = scripting::load_generator(
         def, scriptFile, pack->id+":generators/"+name+".files");
 }
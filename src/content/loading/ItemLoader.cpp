@@ -1,5 +1,6 @@
 #define VC_ENABLE_REFLECTION
 #include "ContentUnitLoader.hpp"
+#include "ContentFilesCache.hpp"
 #include "ContentLoadingCommons.hpp"
 
 #include "../ContentBuilder.hpp"
@@ -17,7 +18,7 @@ static debug::Logger logger("item-content-loader");
 template<> void ContentUnitLoader<ItemDef>::loadUnit(
     ItemDef& def, const std::string& name, const io::path& file
 ) {
-    auto root = io::read_json(file);
+    auto root = files.read(file);
     process_properties(def, name, root);
     process_tags(def, root);
 
@@ -114,7 +114,7 @@ static void reset_integer(
 ) {
     int elements = std::min(field.elements, dstField.elements);
     for (int i = 0; i < elements; i++) {
-        auto value = srcLayout.getInteger(src, field.name, i);
+        auto value = srcLayout.getInteger(src, field, i);
         auto clamped = clamp_value(value, dstField.type);
         if (dstField.convertStrategy == FieldConvertStrategy::CLAMP) {
             value = clamped;
@@ -123,7 +123,7 @@ static void reset_integer(
                 value = 0;
             }
         }
-        dstLayout.setInteger(dst, value, field.name, i);
+        dstLayout.setInteger(dst, value, dstField, i);
     }
 }
 
@@ -137,8 +137,8 @@ static void reset_number(
 ) {
     int elements = std::min(field.elements, dstField.elements);
     for (int i = 0; i < elements; i++) {
-        auto value = srcLayout.getNumber(src, field.name, i);
-        dstLayout.setNumber(dst, value, field.name, i);
+        auto value = srcLayout.getNumber(src, field, i);
+        dstLayout.setNumber(dst, value, dstField, i);
     }
 }
 
@@ -148,7 +148,28 @@ void StructLayout::convert(
     ubyte* dst,
     bool allowDataLoss
 ) const {
-    std::memset(dst, 0, totalSize);
+    convert(srcLayout, &src, &dst, 1, allowDataLoss);
+}
+
+void StructLayout::convert(
+    const StructLayout& srcLayout,
+    const ubyte* const* src,
+    ubyte* const* dst,
+    size_t count,
+    bool allowDataLoss
+) const {
+    if (srcLayout == *this) {
+        for (size_t i = 0; i < count; i++) {
+            std::memcpy(dst[i], src[i], totalSize);
+        }
+        return;
+    }
+    struct FieldPair {
+        const Field* field;
+        const Field* dstField;
+        bool integer;
+    };
+    std::vector<FieldPair> pairs;
     for (const Field& field : srcLayout.fields) {
         auto dstField = getField(field.name);
         if (dstField == nullptr) {
@@ -162,9 +183,19 @@ void StructLayout::convert(
         if (is_integer_type(field.type) ||
                 (is_floating_point_type(field.type) && 
                     is_integer_type(dstField->type))) {
-            reset_integer(srcLayout, *this, field, *dstField, src, dst);
+            pairs.push_back({&field, dstField, true});
         } else if (is_floating_point_type(dstField->type)) {
-            reset_number(srcLayout, *this, field, *dstField, src, dst);
+            pairs.push_back({&field, dstField, false});
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        std::memset(dst[i], 0, totalSize);
+        for (const auto& [field, dstField, integer] : pairs) {
+            if (integer) {
+                reset_integer(srcLayout, *this, *field, *dstField, src[i], dst[i]);
+            } else {
+                reset_number(srcLayout, *this, *field, *dstField, src[i], dst[i]);
+            }
         }
     }
 }
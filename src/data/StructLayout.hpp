@@ -267,6 +267,20 @@ namespace data {
             ubyte* dst,
             bool allowDataLoss) const;
 
+        /// @brief Convert multiple structures data from srcLayout to this
+        /// layout. Fields mapping is resolved once for all structures
+        /// @param srcLayout source structures layout
+        /// @param src source structures data
+        /// @param dst destination buffers
+        /// @param count number of structures
+        /// @param allowDataLoss see single structure convert
+        void convert(
+            const StructLayout& srcLayout,
+            const ubyte* const* src,
+            ubyte* const* dst,
+            size_t count,
+            bool allowDataLoss) const;
+
         std::vector<FieldIncapatibility> checkCompatibility(
             const StructLayout& dstLayout);
 
@@ -92,13 +92,13 @@ namespace dv {
 
     value& value::object() {
         check_type(type, value_type::list);
-        val.list->push_back(std::make_shared<objects::Object>());
+        val.list->push_back(dv::object());
         return val.list->operator[](val.list->size()-1);
     }
 
     value& value::list() {
         check_type(type, value_type::list);
-        val.list->push_back(std::make_shared<objects::List>());
+        val.list->push_back(dv::list());
         return val.list->operator[](val.list->size()-1);
     }
 
@@ -9,6 +9,8 @@
 #include <stdexcept>
 #include <unordered_map>
 
+#include "dv_arena.hpp"
+
 namespace util {
     template<class T> class Buffer;
 }
@@ -47,16 +49,21 @@ namespace dv {
 
     class value;
 
-    using list_t = std::vector<value>;
-    using map_t = std::unordered_map<key_t, value>;
     using pair = std::pair<const key_t, value>;
+    using list_t = std::vector<value, arena_allocator<value>>;
+    using map_t = std::unordered_map<
+        key_t,
+        value,
+        std::hash<key_t>,
+        std::equal_to<key_t>,
+        arena_allocator<pair>>;
 
     using reference = value&;
     using const_reference = const value&;
 
     namespace objects {
-        using Object = std::unordered_map<key_t, value>;
-        using List = std::vector<value>;
+        using Object = map_t;
+        using List = list_t;
         using Bytes = util::Buffer<byte_t>;
     }
 
@@ -197,7 +204,9 @@ namespace dv {
             this->operator=(std::move(v));
         }
         value(list_t values) {
-            this->operator=(std::make_shared<list_t>(std::move(values)));
+            this->operator=(std::allocate_shared<list_t>(
+                arena_allocator<list_t>(), std::move(values)
+            ));
         }
 
         value(const value& v) noexcept : type(value_type::none) {
@@ -523,19 +532,27 @@ namespace dv {
     }
 
     inline value object() {
-        return std::make_shared<objects::Object>();
+        return std::allocate_shared<objects::Object>(
+            arena_allocator<objects::Object>()
+        );
     }
 
     inline value object(std::initializer_list<pair> pairs) {
-        return std::make_shared<objects::Object>(std::move(pairs));
+        return std::allocate_shared<objects::Object>(
+            arena_allocator<objects::Object>(), std::move(pairs)
+        );
     }
 
     inline value list() {
-        return std::make_shared<objects::List>();
+        return std::allocate_shared<objects::List>(
+            arena_allocator<objects::List>()
+        );
     }
 
     inline value list(std::initializer_list<value> values) {
-        return std::make_shared<objects::List>(std::move(values));
+        return std::allocate_shared<objects::List>(
+            arena_allocator<objects::List>(), std::move(values)
+        );
     }
 
     template<typename T> inline bool get_to_int(value* ptr, T& dst) {
@@ -0,0 +1,55 @@
+#include "dv_arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+using namespace dv;
+
+static thread_local std::shared_ptr<Arena> current_arena = nullptr;
+
+Arena::Arena(size_t initialBlockSize) : nextBlockSize(initialBlockSize) {
+}
+
+/// @return offset aligned relative to the block address
+static size_t align_offset(const std::byte* block, size_t offset, size_t alignment) {
+    auto address = reinterpret_cast<uintptr_t>(block) + offset;
+    auto aligned = (address + alignment - 1) & ~uintptr_t(alignment - 1);
+    return offset + (aligned - address);
+}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+    std::lock_guard lock(mutex);
+    if (!blocks.empty()) {
+        auto& block = blocks.back();
+        size_t start = align_offset(block.data.get(), offset, alignment);
+        if (start + size <= block.size) {
+            offset = start + size;
+            allocated += size;
+            return block.data.get() + start;
+        }
+    }
+    size_t blockSize = std::max(size + alignment, nextBlockSize);
+    nextBlockSize = std::min(nextBlockSize * 2, MAX_BLOCK_SIZE);
+    // not value-initialized
+    blocks.push_back(
+        {std::unique_ptr<std::byte[]>(new std::byte[blockSize]), blockSize}
+    );
+    auto& block = blocks.back();
+    size_t start = align_offset(block.data.get(), 0, alignment);
+    offset = start + size;
+    allocated += size;
+    return block.data.get() + start;
+}
+
+const std::shared_ptr<Arena>& dv::get_current_arena() noexcept {
+    return current_arena;
+}
+
+ArenaScope::ArenaScope(std::shared_ptr<Arena> arena)
+    : previous(std::move(current_arena)) {
+    current_arena = std::move(arena);
+}
+
+ArenaScope::~ArenaScope() {
+    current_arena = std::move(previous);
+}
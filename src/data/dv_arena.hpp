@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace dv {
+    /// @brief Monotonic memory arena for short living dv trees (parsed,
+    /// processed and freed). Memory is released when the arena and all
+    /// containers allocated in it are destroyed
+    class Arena {
+        struct Block {
+            std::unique_ptr<std::byte[]> data;
+            size_t size;
+        };
+        std::vector<Block> blocks;
+        size_t offset = 0;
+        size_t nextBlockSize;
+        size_t allocated = 0;
+        /// @brief Containers may be modified in other threads after scope
+        std::mutex mutex;
+    public:
+        static constexpr size_t INITIAL_BLOCK_SIZE = 4096;
+        static constexpr size_t MAX_BLOCK_SIZE = 256 * 1024;
+
+        explicit Arena(size_t initialBlockSize = INITIAL_BLOCK_SIZE);
+        Arena(const Arena&) = delete;
+
+        void* allocate(size_t size, size_t alignment);
+
+        /// @return total bytes allocated from the arena
+        size_t getAllocated() const {
+            return allocated;
+        }
+    };
+
+    /// @return arena of the current thread ArenaScope or nullptr
+    const std::shared_ptr<Arena>& get_current_arena() noexcept;
+
+    /// @brief Makes dv containers created in the current thread allocate
+    /// from the arena while the scope is alive. Containers created in the
+    /// scope keep using the arena after it
+    /// @attention Do not use for trees stored for a long time: a single
+    /// remaining container keeps whole arena memory allocated
+    class ArenaScope {
+        std::shared_ptr<Arena> previous;
+    public:
+        explicit ArenaScope(
+            std::shared_ptr<Arena> arena = std::make_shared<Arena>()
+        );
+        ~ArenaScope();
+
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope& operator=(const ArenaScope&) = delete;
+    };
+
+    /// @brief Allocator of dv containers. Default-constructed allocator
+    /// uses the current scope arena or the heap if there is no scope
+    template <class T>
+    class arena_allocator {
+        template <class U>
+        friend class arena_allocator;
+
+        std::shared_ptr<Arena> arena;
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        arena_allocator() noexcept : arena(get_current_arena()) {
+        }
+
+        template <class U>
+        arena_allocator(const arena_allocator<U>& other) noexcept
+            : arena(other.arena) {
+        }
+
+        T* allocate(size_t n) {
+            if (arena) {
+                return static_cast<T*>(
+                    arena->allocate(n * sizeof(T), alignof(T))
+                );
+            }
+            return std::allocator<T>().allocate(n);
+        }
+
+        void deallocate(T* ptr, size_t n) noexcept {
+            if (arena == nullptr) {
+                std::allocator<T>().deallocate(ptr, n);
+            }
+        }
+
+        /// @brief Copied containers are allocated as new ones
+        arena_allocator select_on_container_copy_construction() const {
+            return arena_allocator();
+        }
+
+        template <class U>
+        bool operator==(const arena_allocator<U>& other) const noexcept {
+            return arena == other.arena;
+        }
+
+        template <class U>
+        bool operator!=(const arena_allocator<U>& other) const noexcept {
+            return arena != other.arena;
+        }
+    };
+}
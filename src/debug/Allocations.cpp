@@ -0,0 +1,206 @@
+#include "Allocations.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+using namespace debug;
+
+namespace {
+    /// @brief Counters of a thread. Slots are never freed and are reused
+    /// by new threads, so the total stays monotonic
+    struct Slot {
+        std::atomic<bool> owned = false;
+        std::atomic<uint64_t> allocations = 0;
+        std::atomic<uint64_t> frees = 0;
+        std::atomic<uint64_t> bytes = 0;
+        /// @brief Fixed-size to not allocate. Guarded by names_mutex
+        char name[32] {};
+    };
+
+    /// @brief Releases the thread slot on thread exit
+    struct SlotOwner {
+        Slot* slot = nullptr;
+
+        ~SlotOwner() {
+            if (slot) {
+                slot->owned = false;
+            }
+        }
+    };
+}
+
+// constant-initialized, so available to allocations made before main
+static std::array<Slot, allocations::MAX_THREADS> slots {};
+static std::mutex names_mutex;
+
+static thread_local Slot* local_slot = nullptr;
+static thread_local SlotOwner slot_owner;
+
+static AllocationStats frame_start {};
+static AllocationStats last_frame {};
+static AllocationStats tick_start {};
+static AllocationStats last_tick {};
+
+static Slot& acquire_slot() {
+    if (local_slot) {
+        return *local_slot;
+    }
+    Slot* found = &slots[slots.size() - 1];
+    for (size_t i = 0; i + 1 < slots.size(); i++) {
+        bool expected = false;
+        if (slots[i].owned.compare_exchange_strong(expected, true)) {
+            found = &slots[i];
+            slot_owner.slot = found;
+            break;
+        }
+    }
+    local_slot = found;
+    return *found;
+}
+
+static AllocationStats get_stats(const Slot& slot) {
+    return {
+        slot.allocations.load(std::memory_order_relaxed),
+        slot.frees.load(std::memory_order_relaxed),
+        slot.bytes.load(std::memory_order_relaxed)
+    };
+}
+
+void allocations::count_allocation(size_t bytes) {
+    auto& slot = acquire_slot();
+    slot.allocations.fetch_add(1, std::memory_order_relaxed);
+    slot.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void allocations::count_free() {
+    acquire_slot().frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+AllocationStats allocations::get_thread() {
+    return get_stats(acquire_slot());
+}
+
+AllocationStats allocations::get_total() {
+    AllocationStats total {};
+    for (const auto& slot : slots) {
+        auto stats = get_stats(slot);
+        total.allocations += stats.allocations;
+        total.frees += stats.frees;
+        total.bytes += stats.bytes;
+    }
+    return total;
+}
+
+std::vector<ThreadAllocationStats> allocations::get_threads() {
+    std::vector<ThreadAllocationStats> threads;
+    std::lock_guard lock(names_mutex);
+    for (size_t i = 0; i < slots.size(); i++) {
+        auto stats = get_stats(slots[i]);
+        if (stats.allocations == 0) {
+            continue;
+        }
+        std::string name = slots[i].name;
+        if (name.empty()) {
+            name = "thread " + std::to_string(i);
+        }
+        threads.push_back({std::move(name), stats});
+    }
+    return threads;
+}
+
+void allocations::set_thread_name(const std::string& name) {
+    auto& slot = acquire_slot();
+    std::lock_guard lock(names_mutex);
+    std::strncpy(slot.name, name.c_str(), sizeof(slot.name) - 1);
+}
+
+void allocations::end_frame() {
+    auto total = get_total();
+    last_frame = total - frame_start;
+    frame_start = total;
+}
+
+AllocationStats allocations::get_last_frame() {
+    return last_frame;
+}
+
+void allocations::begin_tick() {
+    tick_start = get_total();
+}
+
+void allocations::end_tick() {
+    last_tick = get_total() - tick_start;
+}
+
+AllocationStats allocations::get_last_tick() {
+    return last_tick;
+}
+
+#ifdef VC_ALLOCATION_TRACKING
+
+// Aligned overloads are not replaced: the standard library implements them
+// separately from the replaced ones, so they stay untracked but consistent
+
+static void* allocate(std::size_t size) noexcept {
+    allocations::count_allocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+static void deallocate(void* ptr) noexcept {
+    if (ptr) {
+        allocations::count_free();
+        std::free(ptr);
+    }
+}
+
+void* operator new(std::size_t size) {
+    if (void* ptr = allocate(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    if (void* ptr = allocate(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    deallocate(ptr);
+}
+
+#endif
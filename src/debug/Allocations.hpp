@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace debug {
+    /// @brief Global operator new/delete calls counters
+    struct AllocationStats {
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        /// @brief Requested bytes (freed bytes are not known)
+        uint64_t bytes = 0;
+
+        AllocationStats operator-(const AllocationStats& other) const {
+            return {
+                allocations - other.allocations,
+                frees - other.frees,
+                bytes - other.bytes
+            };
+        }
+    };
+
+    struct ThreadAllocationStats {
+        std::string threadName;
+        AllocationStats stats;
+    };
+
+    /// @brief Allocations counting. Global operator new/delete are replaced
+    /// only if the engine is built with VOXELENGINE_ALLOCATION_TRACKING
+    /// CMake option, otherwise all counters are zero
+    namespace allocations {
+        /// @brief Max number of threads counted separately. Threads over
+        /// the limit share the last counters slot
+        inline constexpr size_t MAX_THREADS = 128;
+
+        constexpr bool is_available() {
+#ifdef VC_ALLOCATION_TRACKING
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        /// @brief Count allocation of the current thread
+        void count_allocation(size_t bytes);
+
+        /// @brief Count deallocation of the current thread
+        void count_free();
+
+        /// @return counters of the current thread since its start
+        AllocationStats get_thread();
+
+        /// @return counters of all threads since the engine start
+        AllocationStats get_total();
+
+        /// @return counters of threads that have allocated anything
+        std::vector<ThreadAllocationStats> get_threads();
+
+        /// @brief Set name of the current thread shown in statistics
+        void set_thread_name(const std::string& name);
+
+        /// @brief Finish the frame measurement. Must be called from
+        /// the main thread once per frame (or server tick)
+        void end_frame();
+
+        /// @return counters of all threads during the last frame
+        AllocationStats get_last_frame();
+
+        /// @brief Start the world tick measurement (main thread)
+        void begin_tick();
+
+        /// @brief Finish the world tick measurement (main thread)
+        void end_tick();
+
+        /// @return counters of all threads during the last world tick
+        AllocationStats get_last_tick();
+    }
+}
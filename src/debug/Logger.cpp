@@ -1,41 +1,95 @@
 #include "Logger.hpp"
 
 #include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <ctime>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 
 using namespace debug;
+using namespace std::chrono;
+
+#ifdef NDEBUG
+static constexpr LogLevel DEFAULT_LEVEL = LogLevel::info;
+#else
+static constexpr LogLevel DEFAULT_LEVEL = LogLevel::debug;
+#endif
+
+constexpr unsigned int moduleLen = 20;
+/// @brief Async writer wakes up at least this often to write messages
+/// queued without notification
+constexpr auto WRITER_INTERVAL = milliseconds(50);
+
+namespace {
+    struct Modules {
+        std::mutex mutex;
+        LogLevel defaultLevel = DEFAULT_LEVEL;
+        std::unordered_map<std::string, std::unique_ptr<LogModule>> map;
+    };
+
+    struct Record {
+        Record* next;
+        LogLevel level;
+        const LogModule* module;
+        system_clock::time_point time;
+        std::string message;
+    };
+}
+
+/// @brief Modules registry is never destroyed, so loggers are usable in
+/// static objects destructors
+static Modules& get_modules() {
+    static auto modules = new Modules();
+    return *modules;
+}
 
 static std::ofstream file;
+/// @brief Output mutex
 static std::mutex mutex;
 static std::string utcOffset = "";
-constexpr unsigned int moduleLen = 20;
 
-LogMessage::~LogMessage() {
-    logger->log(level, ss.str());
+/// @brief Queued records stack (lock-free multiple producers push,
+/// writer takes all at once)
+static std::atomic<Record*> queued = nullptr;
+static std::atomic<bool> asyncMode = false;
+static std::atomic<bool> writerSleeping = false;
+static std::mutex writerMutex;
+static std::condition_variable writerCv;
+static std::thread writer;
+
+/// @brief Cached timestamp of the last written message second.
+/// Output mutex must be locked
+static const std::string& format_time(std::time_t time) {
+    static std::time_t cachedTime = -1;
+    static std::string cachedString;
+    if (time != cachedTime) {
+        std::stringstream ss;
+        ss << std::put_time(std::localtime(&time), "%Y/%m/%d %T");
+        cachedString = ss.str();
+        cachedTime = time;
+    }
+    return cachedString;
 }
 
-static void write(
-    LogLevel level, const std::string& name, const std::string& message
-) {
-    if (level == LogLevel::print) {
-        std::cout << "[" << name << "]    " << message << std::endl;
+/// @brief Write record to the log file and stdout without flushing.
+/// Output mutex must be locked
+static void write(const Record& record) {
+    const auto& name = record.module->name;
+    if (record.level == LogLevel::print) {
+        std::cout << "[" << name << "]    " << record.message << '\n';
         return;
     }
-
-    using namespace std::chrono;
-
     std::stringstream ss;
-    switch (level) {
+    switch (record.level) {
         case LogLevel::print:
         case LogLevel::debug:
-#ifdef NDEBUG
-            return;
-#endif
             ss << "[D]";
             break;
         case LogLevel::info:
@@ -48,40 +102,168 @@ static void write(
             ss << "[E]";
             break;
     }
-    time_t tm = std::time(nullptr);
-    auto ms =
-        duration_cast<milliseconds>(system_clock::now().time_since_epoch()) %
-        1000;
-    ss << " " << std::put_time(std::localtime(&tm), "%Y/%m/%d %T");
-    ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
+    auto ms = duration_cast<milliseconds>(record.time.time_since_epoch());
+    ss << " " << format_time(system_clock::to_time_t(record.time));
+    ss << '.' << std::setfill('0') << std::setw(3) << ms.count() % 1000;
     ss << utcOffset << " [" << std::setfill(' ') << std::setw(moduleLen) << name
        << "] ";
-    ss << message;
-    {
-        std::lock_guard<std::mutex> lock(mutex);
-        auto string = ss.str();
-        if (file.good()) {
-            file << string << '\n';
-            file.flush();
+    ss << record.message;
+
+    auto string = ss.str();
+    if (file.good()) {
+        file << string << '\n';
+    }
+    std::cout << string << '\n';
+}
+
+/// @brief Write all queued records in order. Output mutex must be locked
+/// @return false if there was nothing to write
+static bool write_queued() {
+    Record* record = queued.exchange(nullptr, std::memory_order_acquire);
+    if (record == nullptr) {
+        return false;
+    }
+    // stack to queue order
+    Record* ordered = nullptr;
+    while (record) {
+        Record* next = record->next;
+        record->next = ordered;
+        ordered = record;
+        record = next;
+    }
+    while (ordered) {
+        std::unique_ptr<Record> current(ordered);
+        ordered = current->next;
+        write(*current);
+    }
+    if (file.good()) {
+        file.flush();
+    }
+    std::cout.flush();
+    return true;
+}
+
+static void writer_loop() {
+    while (asyncMode.load()) {
+        {
+            std::lock_guard lock(mutex);
+            if (write_queued()) {
+                continue;
+            }
         }
-        std::cout << string << std::endl;
+        std::unique_lock lock(writerMutex);
+        writerSleeping = true;
+        writerCv.wait_for(lock, WRITER_INTERVAL, []() {
+            return queued.load() != nullptr || !asyncMode.load();
+        });
+        writerSleeping = false;
+    }
+    std::lock_guard lock(mutex);
+    write_queued();
+}
+
+LogMessage::~LogMessage() {
+    if (ss) {
+        logger->log(level, ss->str());
+    }
+}
+
+Logger::Logger(const std::string& name) {
+    auto& modules = get_modules();
+    std::lock_guard lock(modules.mutex);
+    auto& found = modules.map[name];
+    if (found == nullptr) {
+        found = std::make_unique<LogModule>();
+        found->name = name;
+        found->minLevel = modules.defaultLevel;
     }
+    module = found.get();
 }
 
-void Logger::init(const std::string& filename) {
+void Logger::init(const std::string& filename, bool async) {
     file.open(filename);
 
     time_t tm = std::time(nullptr);
     std::stringstream ss;
     ss << std::put_time(std::localtime(&tm), "%z");
     utcOffset = ss.str();
+
+    if (async && !asyncMode.exchange(true)) {
+        writer = std::thread(writer_loop);
+        std::atexit(Logger::terminate);
+    }
 }
 
 void Logger::flush() {
-    std::lock_guard<std::mutex> lock(mutex);
+    std::lock_guard lock(mutex);
+    write_queued();
     file.flush();
 }
 
+void Logger::terminate() {
+    if (!asyncMode.exchange(false)) {
+        return;
+    }
+    writerCv.notify_one();
+    writer.join();
+    // pushed while stopping
+    flush();
+}
+
+void Logger::setLevel(LogLevel level) {
+    auto& modules = get_modules();
+    std::lock_guard lock(modules.mutex);
+    modules.defaultLevel = level;
+    for (auto& [_, module] : modules.map) {
+        if (!module->custom) {
+            module->minLevel = level;
+        }
+    }
+}
+
+void Logger::setLevel(const std::string& name, LogLevel level) {
+    Logger logger(name);
+    auto& modules = get_modules();
+    std::lock_guard lock(modules.mutex);
+    logger.module->minLevel = level;
+    logger.module->custom = true;
+}
+
+bool Logger::parseLevel(const std::string& name, LogLevel& level) {
+    static const std::unordered_map<std::string, LogLevel> levels {
+        {"print", LogLevel::print},
+        {"debug", LogLevel::debug},
+        {"info", LogLevel::info},
+        {"warning", LogLevel::warning},
+        {"error", LogLevel::error},
+    };
+    const auto& found = levels.find(name);
+    if (found == levels.end()) {
+        return false;
+    }
+    level = found->second;
+    return true;
+}
+
 void Logger::log(LogLevel level, std::string message) {
-    write(level, name, std::move(message));
+    Record record {
+        nullptr, level, module, system_clock::now(), std::move(message)};
+    if (!asyncMode.load(std::memory_order_relaxed)) {
+        std::lock_guard lock(mutex);
+        write(record);
+        if (level != LogLevel::print && file.good()) {
+            file.flush();
+        }
+        std::cout.flush();
+        return;
+    }
+    auto ptr = new Record(std::move(record));
+    ptr->next = queued.load(std::memory_order_relaxed);
+    while (!queued.compare_exchange_weak(
+        ptr->next, ptr, std::memory_order_release, std::memory_order_relaxed
+    )) {
+    }
+    if (writerSleeping.load(std::memory_order_relaxed)) {
+        writerCv.notify_one();
+    }
 }
@@ -1,59 +1,102 @@
 #pragma once
 
+#include <atomic>
+#include <optional>
 #include <sstream>
+#include <string>
 
 namespace debug {
     enum class LogLevel { print, debug, info, warning, error };
 
     class Logger;
 
+    /// @brief Loggers having the same name share the module
+    struct LogModule {
+        std::string name;
+        std::atomic<LogLevel> minLevel;
+        /// @brief Level is set for the module, so default one is not used
+        bool custom = false;
+    };
+
     class LogMessage {
         Logger* logger;
         LogLevel level;
-        std::stringstream ss;
+        /// @brief Not constructed for disabled levels
+        std::optional<std::stringstream> ss;
     public:
-        LogMessage(Logger* logger, LogLevel level)
+        LogMessage(Logger* logger, LogLevel level, bool enabled)
             : logger(logger), level(level) {
+            if (enabled) {
+                ss.emplace();
+            }
         }
         ~LogMessage();
 
         template <class T>
         LogMessage& operator<<(const T& x) {
-            ss << x;
+            if (ss) {
+                *ss << x;
+            }
             return *this;
         }
     };
 
     class Logger {
-        std::string name;
+        /// @brief Registered module (never destroyed)
+        LogModule* module;
+
+        LogMessage message(LogLevel level) {
+            return LogMessage(this, level, isEnabled(level));
+        }
     public:
-        static void init(const std::string& filename);
+        /// @param filename log file
+        /// @param async write messages in background thread
+        static void init(const std::string& filename, bool async = false);
+
+        /// @brief Write all queued messages and flush log file
         static void flush();
 
-        Logger(const std::string& name) : name(name) {
+        /// @brief Stop background writer thread writing all queued messages
+        static void terminate();
+
+        /// @brief Set min level of modules having no own level set
+        static void setLevel(LogLevel level);
+
+        /// @brief Set module min level
+        static void setLevel(const std::string& module, LogLevel level);
+
+        /// @return false if name is not a level name
+        static bool parseLevel(const std::string& name, LogLevel& level);
+
+        Logger(const std::string& name);
+
+        /// @brief Print level is always enabled
+        bool isEnabled(LogLevel level) const {
+            return level == LogLevel::print ||
+                   level >= module->minLevel.load(std::memory_order_relaxed);
         }
 
         void log(LogLevel level, std::string message);
-        
+
         LogMessage debug() {
-            return LogMessage(this, LogLevel::debug);
+            return message(LogLevel::debug);
         }
 
         LogMessage info() {
-            return LogMessage(this, LogLevel::info);
+            return message(LogLevel::info);
         }
 
         LogMessage error() {
-            return LogMessage(this, LogLevel::error);
+            return message(LogLevel::error);
         }
 
         LogMessage warning() {
-            return LogMessage(this, LogLevel::warning);
+            return message(LogLevel::warning);
         }
-        
+
         /// @brief Print-debugging tool (printed without header)
         LogMessage print() {
-            return LogMessage(this, LogLevel::print);
+            return message(LogLevel::print);
         }
     };
 }
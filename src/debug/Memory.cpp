@@ -0,0 +1,194 @@
+#include "Memory.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <numeric>
+#include <vector>
+
+#include "Logger.hpp"
+
+using namespace debug;
+
+static debug::Logger logger("memory");
+
+namespace {
+    struct MemorySource {
+        uint64_t id;
+        MemoryTag tag;
+        memory::UsageSupplier supplier;
+        memory::Evictor evictor;
+    };
+}
+
+static std::array<std::atomic<int64_t>, MEMORY_TAGS_COUNT> counters {};
+static std::atomic<size_t> budget = 0;
+static std::atomic<size_t> video_budget = 0;
+static std::atomic<int> video_pressure = 0;
+
+/// @brief Video memory usage (budget ratio) raising the pressure level
+static constexpr double PRESSURE_RAISE_RATIO = 0.9;
+/// @brief Video memory usage (budget ratio) lowering the pressure level
+static constexpr double PRESSURE_LOWER_RATIO = 0.6;
+
+static std::mutex sources_mutex;
+static std::vector<MemorySource> sources;
+static uint64_t next_source_id = 1;
+
+static const char* TAG_NAMES[] {
+    "chunks",
+    "lightmaps",
+    "blocks_metadata",
+    "unloaded_chunks",
+    "regions",
+    "sounds",
+    "lua",
+    "meshes",
+    "meshes_gpu",
+    "textures",
+    "framebuffers",
+    "shadow_maps",
+    "entities",
+};
+static_assert(std::size(TAG_NAMES) == MEMORY_TAGS_COUNT);
+
+std::string_view memory::tag_name(MemoryTag tag) {
+    return TAG_NAMES[static_cast<size_t>(tag)];
+}
+
+bool memory::is_video(MemoryTag tag) {
+    switch (tag) {
+        case MemoryTag::MESHES_GPU:
+        case MemoryTag::TEXTURES:
+        case MemoryTag::FRAMEBUFFERS:
+        case MemoryTag::SHADOW_MAPS:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void memory::add(MemoryTag tag, int64_t bytes) {
+    counters[static_cast<size_t>(tag)].fetch_add(
+        bytes, std::memory_order_relaxed
+    );
+}
+
+ObserverHandler memory::add_source(
+    MemoryTag tag, UsageSupplier supplier, Evictor evictor
+) {
+    std::lock_guard lock(sources_mutex);
+    uint64_t id = next_source_id++;
+    sources.push_back({id, tag, std::move(supplier), std::move(evictor)});
+    return ObserverHandler([id]() {
+        std::lock_guard lock(sources_mutex);
+        sources.erase(std::remove_if(
+            sources.begin(),
+            sources.end(),
+            [id](const auto& source) { return source.id == id; }
+        ), sources.end());
+    });
+}
+
+MemoryUsage memory::collect() {
+    MemoryUsage usage {};
+    for (size_t i = 0; i < MEMORY_TAGS_COUNT; i++) {
+        usage[i] = static_cast<size_t>(
+            std::max<int64_t>(0, counters[i].load(std::memory_order_relaxed))
+        );
+    }
+    std::lock_guard lock(sources_mutex);
+    for (const auto& source : sources) {
+        usage[static_cast<size_t>(source.tag)] += source.supplier();
+    }
+    return usage;
+}
+
+void memory::set_budget(size_t bytes) {
+    budget = bytes;
+}
+
+size_t memory::get_budget() {
+    return budget;
+}
+
+size_t memory::enforce_budget() {
+    size_t limit = budget;
+    if (limit == 0) {
+        return 0;
+    }
+    auto usage = collect();
+    size_t total = std::accumulate(usage.begin(), usage.end(), size_t(0));
+    if (total <= limit) {
+        return 0;
+    }
+    std::vector<MemorySource> evictable;
+    {
+        std::lock_guard lock(sources_mutex);
+        for (const auto& source : sources) {
+            if (source.evictor) {
+                evictable.push_back(source);
+            }
+        }
+    }
+    std::stable_sort(
+        evictable.begin(),
+        evictable.end(),
+        [](const auto& a, const auto& b) { return a.tag < b.tag; }
+    );
+    size_t excess = total - limit;
+    size_t released = 0;
+    for (const auto& source : evictable) {
+        if (released >= excess) {
+            break;
+        }
+        released += source.evictor(excess - released);
+    }
+    logger.info() << "memory budget exceeded by " << excess << " B, released "
+                  << released << " B";
+    return released;
+}
+
+void memory::set_video_budget(size_t bytes) {
+    video_budget = bytes;
+}
+
+size_t memory::get_video_budget() {
+    return video_budget;
+}
+
+size_t memory::video_usage(const MemoryUsage& usage) {
+    size_t total = 0;
+    for (size_t i = 0; i < MEMORY_TAGS_COUNT; i++) {
+        if (is_video(static_cast<MemoryTag>(i))) {
+            total += usage[i];
+        }
+    }
+    return total;
+}
+
+int memory::update_video_pressure() {
+    size_t limit = video_budget;
+    int level = video_pressure;
+    if (limit == 0) {
+        video_pressure = 0;
+        return 0;
+    }
+    size_t usage = video_usage(collect());
+    int prevLevel = level;
+    if (usage > limit * PRESSURE_RAISE_RATIO && level < MAX_VIDEO_PRESSURE) {
+        level++;
+    } else if (usage < limit * PRESSURE_LOWER_RATIO && level > 0) {
+        level--;
+    }
+    if (level != prevLevel) {
+        logger.info() << "video memory usage is " << usage << " B of "
+                      << limit << " B, pressure level " << level;
+    }
+    video_pressure = level;
+    return level;
+}
+
+int memory::get_video_pressure() {
+    return video_pressure;
+}
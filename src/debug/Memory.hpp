@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+#include "util/observer_handler.hpp"
+
+namespace debug {
+    /// @brief Engine memory consumers. Caches are evicted in this order
+    /// when the memory budget is exceeded
+    enum class MemoryTag {
+        /// @brief Loaded chunks voxels
+        CHUNKS,
+        /// @brief Loaded chunks lightmaps
+        LIGHTMAPS,
+        /// @brief Loaded chunks blocks metadata
+        BLOCKS_METADATA,
+        /// @brief Recently unloaded chunks cache
+        UNLOADED_CHUNKS,
+        /// @brief Regions data kept in memory
+        REGIONS,
+        /// @brief Decoded sounds
+        SOUNDS,
+        /// @brief Lua main state heap
+        LUA,
+        /// @brief Chunk meshes data kept in RAM and meshing buffers
+        MESHES,
+        /// @brief Chunk meshes GPU buffers
+        MESHES_GPU,
+        /// @brief Textures, atlases and cubemaps (estimated)
+        TEXTURES,
+        /// @brief Framebuffers and G-buffer attachments (estimated)
+        FRAMEBUFFERS,
+        /// @brief Shadow maps (estimated)
+        SHADOW_MAPS,
+        /// @brief Entities components
+        ENTITIES,
+        COUNT
+    };
+
+    inline constexpr size_t MEMORY_TAGS_COUNT =
+        static_cast<size_t>(MemoryTag::COUNT);
+
+    /// @brief Max video memory pressure level
+    inline constexpr int MAX_VIDEO_PRESSURE = 3;
+
+    /// @brief Usage in bytes by tag index
+    using MemoryUsage = std::array<size_t, MEMORY_TAGS_COUNT>;
+
+    namespace memory {
+        /// @return current usage of the source in bytes
+        using UsageSupplier = std::function<size_t()>;
+        /// @brief Release cached data
+        /// @param bytes number of bytes to be released
+        /// @return number of released bytes
+        using Evictor = std::function<size_t(size_t bytes)>;
+
+        std::string_view tag_name(MemoryTag tag);
+
+        /// @return true if the tag consumers are allocated in video memory
+        bool is_video(MemoryTag tag);
+
+        /// @brief Adjust usage counter of the tag. Thread-safe
+        /// @param bytes usage difference (negative if released)
+        void add(MemoryTag tag, int64_t bytes);
+
+        /// @brief Register usage source polled on collect. Source is
+        /// removed when the handler is destroyed
+        /// @param evictor releases the source cached data (may be nullptr)
+        [[nodiscard]] ObserverHandler add_source(
+            MemoryTag tag, UsageSupplier supplier, Evictor evictor = nullptr
+        );
+
+        /// @brief Get current usage of all tags. Must be called from the
+        /// main thread, as sources are not synchronized
+        MemoryUsage collect();
+
+        /// @param bytes total memory budget (0 - unlimited)
+        void set_budget(size_t bytes);
+
+        size_t get_budget();
+
+        /// @brief Evict sources caches until the total usage fits the
+        /// budget. Must be called from the main thread
+        /// @return number of released bytes
+        size_t enforce_budget();
+
+        /// @param bytes video memory budget (0 - unlimited)
+        void set_video_budget(size_t bytes);
+
+        size_t get_video_budget();
+
+        /// @brief Total usage of the video memory tags
+        size_t video_usage(const MemoryUsage& usage);
+
+        /// @brief Raise the video memory pressure level by one if the
+        /// usage approaches the budget or lower it if the usage went
+        /// far below. Renderers reduce quality of the GPU resources
+        /// according to the level. Must be called from the main thread
+        /// @return current level
+        int update_video_pressure();
+
+        /// @return video memory pressure level
+        /// (0 - no pressure, MAX_VIDEO_PRESSURE - max)
+        int get_video_pressure();
+    }
+}
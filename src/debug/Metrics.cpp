@@ -0,0 +1,147 @@
+#include "Metrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+using namespace debug;
+
+Histogram::Histogram(std::vector<double> bounds)
+    : bounds(std::move(bounds)) {
+    std::sort(this->bounds.begin(), this->bounds.end());
+    counts.resize(this->bounds.size() + 1);
+}
+
+void Histogram::observe(double value) {
+    size_t index =
+        std::lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin();
+    counts[index]++;
+    sum += value;
+    count++;
+}
+
+uint64_t Histogram::getCumulativeCount(size_t index) const {
+    uint64_t total = 0;
+    for (size_t i = 0; i <= index && i < counts.size(); i++) {
+        total += counts[i];
+    }
+    return total;
+}
+
+static void write_value(std::ostream& stream, double value) {
+    if (std::isnan(value)) {
+        stream << "NaN";
+    } else if (std::isinf(value)) {
+        stream << (value > 0 ? "+Inf" : "-Inf");
+    } else if (value == std::floor(value) && std::abs(value) < 1e15) {
+        stream << static_cast<int64_t>(value);
+    } else {
+        stream << value;
+    }
+}
+
+static void write_label_value(std::ostream& stream, const std::string& value) {
+    stream << '"';
+    for (char c : value) {
+        switch (c) {
+            case '\\': stream << "\\\\"; break;
+            case '"': stream << "\\\""; break;
+            case '\n': stream << "\\n"; break;
+            default: stream << c; break;
+        }
+    }
+    stream << '"';
+}
+
+MetricsWriter::MetricsWriter() {
+    ss << std::setprecision(15);
+}
+
+void MetricsWriter::writeHeader(
+    const std::string& name, const char* help, const char* type
+) {
+    if (family == name) {
+        return;
+    }
+    family = name;
+    ss << "# HELP " << name << " " << help << "\n";
+    ss << "# TYPE " << name << " " << type << "\n";
+}
+
+void MetricsWriter::writeSample(
+    const std::string& name,
+    const MetricLabels& labels,
+    double value,
+    const char* le
+) {
+    ss << name;
+    if (!labels.empty() || le) {
+        ss << '{';
+        bool first = true;
+        for (const auto& [key, labelValue] : labels) {
+            if (!first) {
+                ss << ',';
+            }
+            first = false;
+            ss << key << '=';
+            write_label_value(ss, labelValue);
+        }
+        if (le) {
+            if (!first) {
+                ss << ',';
+            }
+            ss << "le=\"" << le << '"';
+        }
+        ss << '}';
+    }
+    ss << ' ';
+    write_value(ss, value);
+    ss << "\n";
+}
+
+void MetricsWriter::gauge(
+    const std::string& name,
+    const char* help,
+    double value,
+    const MetricLabels& labels
+) {
+    writeHeader(name, help, "gauge");
+    writeSample(name, labels, value);
+}
+
+void MetricsWriter::counter(
+    const std::string& name,
+    const char* help,
+    double value,
+    const MetricLabels& labels
+) {
+    writeHeader(name, help, "counter");
+    writeSample(name, labels, value);
+}
+
+void MetricsWriter::histogram(
+    const std::string& name, const char* help, const Histogram& histogram
+) {
+    writeHeader(name, help, "histogram");
+    const auto& bounds = histogram.getBounds();
+    for (size_t i = 0; i < bounds.size(); i++) {
+        std::stringstream le;
+        le << std::setprecision(15);
+        write_value(le, bounds[i]);
+        writeSample(
+            name + "_bucket",
+            {},
+            histogram.getCumulativeCount(i),
+            le.str().c_str()
+        );
+    }
+    writeSample(
+        name + "_bucket", {}, histogram.getCumulativeCount(bounds.size()), "+Inf"
+    );
+    writeSample(name + "_sum", {}, histogram.getSum());
+    writeSample(name + "_count", {}, histogram.getCount());
+}
+
+std::string MetricsWriter::build() const {
+    return ss.str();
+}
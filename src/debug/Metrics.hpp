@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace debug {
+    /// @brief Observations distribution over fixed buckets
+    class Histogram {
+        /// @brief Sorted buckets upper bounds (inclusive)
+        std::vector<double> bounds;
+        /// @brief Observations per bucket, the last one is +Inf bucket
+        std::vector<uint64_t> counts;
+        double sum = 0.0;
+        uint64_t count = 0;
+    public:
+        Histogram(std::vector<double> bounds);
+
+        void observe(double value);
+
+        const std::vector<double>& getBounds() const {
+            return bounds;
+        }
+
+        /// @return number of observations less than or equal to the bucket
+        /// upper bound (index == bounds count is the +Inf bucket)
+        uint64_t getCumulativeCount(size_t index) const;
+
+        double getSum() const {
+            return sum;
+        }
+
+        uint64_t getCount() const {
+            return count;
+        }
+    };
+
+    using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+    /// @brief Metrics writer in Prometheus text exposition format (0.0.4).
+    /// Consecutive samples of the same metric with different labels
+    /// share the family header
+    class MetricsWriter {
+        std::stringstream ss;
+        std::string family;
+
+        void writeHeader(
+            const std::string& name, const char* help, const char* type
+        );
+        void writeSample(
+            const std::string& name,
+            const MetricLabels& labels,
+            double value,
+            const char* le = nullptr
+        );
+    public:
+        MetricsWriter();
+
+        /// @brief Write value that may go up and down
+        void gauge(
+            const std::string& name,
+            const char* help,
+            double value,
+            const MetricLabels& labels = {}
+        );
+
+        /// @brief Write monotonic value (name should end with '_total')
+        void counter(
+            const std::string& name,
+            const char* help,
+            double value,
+            const MetricLabels& labels = {}
+        );
+
+        void histogram(
+            const std::string& name, const char* help, const Histogram& histogram
+        );
+
+        std::string build() const;
+    };
+}
@@ -0,0 +1,221 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#include "util/stringutil.hpp"
+
+using namespace debug;
+
+std::atomic<bool> profiler::enabled = false;
+
+namespace {
+    /// @brief Single-writer ring buffer owned by a thread
+    struct ThreadBuffer {
+        uint32_t index;
+        /// @brief Guarded by buffers_mutex
+        std::string name;
+        std::unique_ptr<ProfilerEvent[]> events;
+        /// @brief Total number of recorded events (written by owner only)
+        std::atomic<uint64_t> head = 0;
+        /// @brief Events before are dropped by clear()
+        std::atomic<uint64_t> tail = 0;
+        /// @brief Buffer is used by a running thread
+        std::atomic<bool> owned = true;
+
+        ThreadBuffer(uint32_t index)
+            : index(index),
+              name("thread " + std::to_string(index)),
+              events(std::make_unique<ProfilerEvent[]>(
+                  profiler::BUFFER_CAPACITY
+              )) {
+        }
+    };
+
+    /// @brief Releases the thread buffer on thread exit to be reused
+    struct LocalBuffer {
+        ThreadBuffer* buffer = nullptr;
+        /// @brief Thread name set before the buffer is acquired
+        std::string name;
+
+        ~LocalBuffer() {
+            if (buffer) {
+                buffer->owned = false;
+            }
+        }
+    };
+}
+
+static std::mutex buffers_mutex;
+/// @brief Buffers are never freed, so exited threads events stay available
+static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+static thread_local LocalBuffer local_buffer;
+
+static const auto epoch = std::chrono::steady_clock::now();
+
+static ThreadBuffer& acquire_buffer() {
+    if (local_buffer.buffer) {
+        return *local_buffer.buffer;
+    }
+    std::lock_guard lock(buffers_mutex);
+    ThreadBuffer* found = nullptr;
+    for (auto& buffer : buffers) {
+        if (!buffer->owned) {
+            found = buffer.get();
+            found->owned = true;
+            found->name = "thread " + std::to_string(found->index);
+            break;
+        }
+    }
+    if (found == nullptr) {
+        buffers.push_back(std::make_unique<ThreadBuffer>(
+            static_cast<uint32_t>(buffers.size())
+        ));
+        found = buffers.back().get();
+    }
+    if (!local_buffer.name.empty()) {
+        found->name = local_buffer.name;
+    }
+    local_buffer.buffer = found;
+    return *found;
+}
+
+void profiler::set_enabled(bool flag) {
+    enabled = flag;
+}
+
+int64_t profiler::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - epoch
+    ).count();
+}
+
+void profiler::record(
+    const char* name,
+    int64_t start,
+    int64_t end,
+    uint64_t allocations,
+    uint64_t allocatedBytes
+) {
+    auto& buffer = acquire_buffer();
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    buffer.events[head % BUFFER_CAPACITY] = {
+        name,
+        start,
+        end - start,
+        static_cast<uint32_t>(allocations),
+        allocatedBytes
+    };
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void profiler::set_thread_name(std::string name) {
+    allocations::set_thread_name(name);
+    std::lock_guard lock(buffers_mutex);
+    if (local_buffer.buffer) {
+        local_buffer.buffer->name = name;
+    }
+    // buffer is allocated on first record only
+    local_buffer.name = std::move(name);
+}
+
+std::vector<ProfilerThreadEvents> profiler::collect() {
+    std::vector<ProfilerThreadEvents> threads;
+    std::lock_guard lock(buffers_mutex);
+    for (const auto& buffer : buffers) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t begin = std::max(
+            buffer->tail.load(),
+            head > BUFFER_CAPACITY ? head - BUFFER_CAPACITY : 0
+        );
+        ProfilerThreadEvents thread {buffer->index, buffer->name, {}};
+        thread.events.reserve(head - begin);
+        for (uint64_t i = begin; i < head; i++) {
+            thread.events.push_back(buffer->events[i % BUFFER_CAPACITY]);
+        }
+        // drop events overwritten by the owner while copying
+        uint64_t after = buffer->head.load(std::memory_order_acquire);
+        if (after >= BUFFER_CAPACITY) {
+            uint64_t safe = after - BUFFER_CAPACITY + 1;
+            if (safe > begin) {
+                size_t dropped = std::min<uint64_t>(safe - begin, head - begin);
+                thread.events.erase(
+                    thread.events.begin(), thread.events.begin() + dropped
+                );
+            }
+        }
+        if (!thread.events.empty()) {
+            threads.push_back(std::move(thread));
+        }
+    }
+    return threads;
+}
+
+void profiler::clear() {
+    std::lock_guard lock(buffers_mutex);
+    for (auto& buffer : buffers) {
+        buffer->tail = buffer->head.load();
+    }
+}
+
+std::vector<ProfilerZoneStats> profiler::get_stats(int64_t period) {
+    int64_t since = now() - period;
+    std::unordered_map<std::string_view, ProfilerZoneStats> zones;
+    for (const auto& thread : collect()) {
+        for (const auto& event : thread.events) {
+            if (event.start + event.duration < since) {
+                continue;
+            }
+            auto& zone = zones[event.name];
+            zone.name = event.name;
+            zone.calls++;
+            zone.total += event.duration;
+            zone.max = std::max(zone.max, event.duration);
+            zone.allocations += event.allocations;
+            zone.allocatedBytes += event.allocatedBytes;
+        }
+    }
+    std::vector<ProfilerZoneStats> stats;
+    stats.reserve(zones.size());
+    for (const auto& [_, zone] : zones) {
+        stats.push_back(zone);
+    }
+    std::sort(stats.begin(), stats.end(), [](const auto& a, const auto& b) {
+        return a.total > b.total;
+    });
+    return stats;
+}
+
+std::string profiler::to_chrome_trace() {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(3);
+    ss << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (const auto& thread : collect()) {
+        if (!first) {
+            ss << ',';
+        }
+        first = false;
+        ss << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+           << thread.threadIndex << ",\"args\":{\"name\":"
+           << util::escape(thread.threadName) << "}}";
+        for (const auto& event : thread.events) {
+            ss << ",\n{\"name\":" << util::escape(event.name)
+               << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread.threadIndex
+               << ",\"ts\":" << event.start / 1000.0
+               << ",\"dur\":" << event.duration / 1000.0;
+            if (allocations::is_available()) {
+                ss << ",\"args\":{\"allocations\":" << event.allocations
+                   << ",\"bytes\":" << event.allocatedBytes << '}';
+            }
+            ss << '}';
+        }
+    }
+    ss << "\n]}\n";
+    return ss.str();
+}
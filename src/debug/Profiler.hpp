@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Allocations.hpp"
+
+namespace debug {
+    /// @brief Completed profiler zone
+    struct ProfilerEvent {
+        /// @brief Zone name (must have static storage duration)
+        const char* name;
+        /// @brief Nanoseconds since the profiler epoch
+        int64_t start;
+        int64_t duration;
+        /// @brief Allocations made by the zone thread (zero if allocations
+        /// tracking is not available)
+        uint32_t allocations;
+        uint64_t allocatedBytes;
+    };
+
+    /// @brief Recorded events of a single thread
+    struct ProfilerThreadEvents {
+        uint32_t threadIndex;
+        std::string threadName;
+        std::vector<ProfilerEvent> events;
+    };
+
+    /// @brief Zone statistics for a period
+    struct ProfilerZoneStats {
+        std::string_view name;
+        uint32_t calls;
+        int64_t total;
+        int64_t max;
+        uint64_t allocations;
+        uint64_t allocatedBytes;
+    };
+
+    namespace profiler {
+        /// @brief Max number of last events kept per thread
+        inline constexpr size_t BUFFER_CAPACITY = 1 << 14;
+
+        extern std::atomic<bool> enabled;
+
+        inline bool is_enabled() {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        void set_enabled(bool flag);
+
+        /// @return nanoseconds since the profiler epoch
+        int64_t now();
+
+        /// @brief Append event to the current thread ring buffer.
+        /// Lock-free except first call in a thread
+        void record(
+            const char* name,
+            int64_t start,
+            int64_t end,
+            uint64_t allocations = 0,
+            uint64_t allocatedBytes = 0
+        );
+
+        /// @brief Set name of the current thread shown in traces
+        void set_thread_name(std::string name);
+
+        /// @brief Copy events recorded by all threads
+        std::vector<ProfilerThreadEvents> collect();
+
+        /// @brief Drop all recorded events
+        void clear();
+
+        /// @brief Aggregate zones finished during the last period
+        /// @param period period length in nanoseconds
+        /// @return zones sorted by total duration (descending)
+        std::vector<ProfilerZoneStats> get_stats(int64_t period);
+
+        /// @brief Export recorded events in Chrome trace events format
+        /// (chrome://tracing, Perfetto, Tracy import-chrome)
+        std::string to_chrome_trace();
+    }
+
+    /// @brief Records zone from construction to destruction if profiler
+    /// is enabled. Use VC_PROFILE_ZONE macro
+    class ProfilerZone {
+        const char* name;
+        int64_t start;
+        AllocationStats startAllocations {};
+    public:
+        ProfilerZone(const char* name)
+            : name(name), start(profiler::is_enabled() ? profiler::now() : -1) {
+            if (allocations::is_available() && start >= 0) {
+                startAllocations = allocations::get_thread();
+            }
+        }
+
+        ~ProfilerZone() {
+            if (start < 0) {
+                return;
+            }
+            if (allocations::is_available()) {
+                auto made = allocations::get_thread() - startAllocations;
+                profiler::record(
+                    name, start, profiler::now(), made.allocations, made.bytes
+                );
+            } else {
+                profiler::record(name, start, profiler::now());
+            }
+        }
+
+        ProfilerZone(const ProfilerZone&) = delete;
+        ProfilerZone& operator=(const ProfilerZone&) = delete;
+    };
+}
+
+#define VC_PROFILE_CONCAT_IMPL(a, b) a##b
+#define VC_PROFILE_CONCAT(a, b) VC_PROFILE_CONCAT_IMPL(a, b)
+
+/// @brief Profile the rest of the current scope as a named zone
+#define VC_PROFILE_ZONE(name) \
+    debug::ProfilerZone VC_PROFILE_CONCAT(profilerZone_, __LINE__)(name)
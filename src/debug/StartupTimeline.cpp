@@ -0,0 +1,56 @@
+#include "StartupTimeline.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "Profiler.hpp"
+
+using namespace debug;
+
+StartupTimeline::Scope::Scope(StartupTimeline& timeline, const char* name)
+    : timeline(timeline), name(name), start(profiler::now()) {
+}
+
+StartupTimeline::Scope::~Scope() {
+    timeline.add(name, start, profiler::now());
+}
+
+StartupTimeline::StartupTimeline() : origin(profiler::now()) {
+}
+
+void StartupTimeline::add(const char* name, int64_t start, int64_t end) {
+    profiler::record(name, start, end);
+    std::lock_guard lock(mutex);
+    phases.push_back({name, start - origin, end - start});
+}
+
+std::vector<StartupPhase> StartupTimeline::getPhases() {
+    std::vector<StartupPhase> sorted;
+    {
+        std::lock_guard lock(mutex);
+        sorted = phases;
+    }
+    std::stable_sort(
+        sorted.begin(),
+        sorted.end(),
+        [](const auto& a, const auto& b) { return a.start < b.start; }
+    );
+    return sorted;
+}
+
+int64_t StartupTimeline::getElapsed() const {
+    return profiler::now() - origin;
+}
+
+std::string StartupTimeline::toString() {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    for (const auto& phase : getPhases()) {
+        ss << "\n  " << std::left << std::setw(16) << phase.name << std::right
+           << " at " << std::setw(8) << phase.start / 1e6 << " ms took "
+           << std::setw(8) << phase.duration / 1e6 << " ms";
+    }
+    ss << "\n  total " << getElapsed() / 1e6 << " ms";
+    return ss.str();
+}
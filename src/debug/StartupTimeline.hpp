@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace debug {
+    /// @brief Completed startup phase
+    struct StartupPhase {
+        /// @brief Phase name (must have static storage duration)
+        const char* name;
+        /// @brief Nanoseconds since the timeline start
+        int64_t start;
+        int64_t duration;
+    };
+
+    /// @brief Measures engine startup phases. Phases are recorded as
+    /// profiler zones too, so they are included in the profiler trace
+    class StartupTimeline {
+        int64_t origin;
+        std::mutex mutex;
+        std::vector<StartupPhase> phases;
+    public:
+        /// @brief Records phase from construction to destruction
+        class Scope {
+            StartupTimeline& timeline;
+            const char* name;
+            int64_t start;
+        public:
+            Scope(StartupTimeline& timeline, const char* name);
+            Scope(const Scope&) = delete;
+            ~Scope();
+        };
+
+        StartupTimeline();
+
+        /// @brief Start phase measurement. Thread-safe
+        /// @param name phase name (must have static storage duration)
+        [[nodiscard]] Scope phase(const char* name) {
+            return Scope(*this, name);
+        }
+
+        /// @brief Add completed phase. Thread-safe
+        /// @param start profiler::now() at the phase start
+        /// @param end profiler::now() at the phase end
+        void add(const char* name, int64_t start, int64_t end);
+
+        /// @return completed phases sorted by start time
+        std::vector<StartupPhase> getPhases();
+
+        /// @return nanoseconds since the timeline start
+        int64_t getElapsed() const;
+
+        /// @brief Format phases durations table
+        std::string toString();
+    };
+}
@@ -0,0 +1,195 @@
+#include "InputJournal.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+#include "coders/binary_json.hpp"
+#include "debug/Logger.hpp"
+
+using namespace devtools;
+
+static debug::Logger logger("input-journal");
+
+static constexpr const char* JOURNAL_FORMAT = "vc-inputs";
+static constexpr int JOURNAL_VERSION = 1;
+
+InputJournal::InputJournal(
+    std::unique_ptr<std::ostream> output,
+    std::unique_ptr<std::istream> input,
+    int tps
+)
+    : output(std::move(output)), input(std::move(input)), tps(tps) {
+}
+
+InputJournal::~InputJournal() {
+    if (output == nullptr) {
+        return;
+    }
+    try {
+        writeFrame();
+        // entries of the unfinished tick are written but not replayed
+        json::write_binary(*output, dv::object({{"ticks", tick}}));
+        output->flush();
+    } catch (const std::exception& err) {
+        logger.error() << "could not finish journal: " << err.what();
+    }
+}
+
+std::unique_ptr<InputJournal> InputJournal::record(
+    const std::filesystem::path& file, int tps
+) {
+    auto stream = std::make_unique<std::ofstream>(file, std::ios::binary);
+    if (!*stream) {
+        throw std::runtime_error("could not open " + file.u8string());
+    }
+    json::write_binary(
+        *stream,
+        dv::object({
+            {"format", std::string(JOURNAL_FORMAT)},
+            {"version", JOURNAL_VERSION},
+            {"tps", tps},
+        })
+    );
+    logger.info() << "recording inputs to " << file.u8string();
+    return std::unique_ptr<InputJournal>(
+        new InputJournal(std::move(stream), nullptr, tps)
+    );
+}
+
+std::unique_ptr<InputJournal> InputJournal::replay(
+    const std::filesystem::path& file
+) {
+    auto stream = std::make_unique<std::ifstream>(file, std::ios::binary);
+    if (!*stream) {
+        throw std::runtime_error("could not open " + file.u8string());
+    }
+    auto header = json::read_binary(*stream);
+    if (!header.isObject() || !header.has("format") ||
+        header["format"].asString() != JOURNAL_FORMAT) {
+        throw std::runtime_error(file.u8string() + " is not an inputs journal");
+    }
+    if (header["version"].asInteger() != JOURNAL_VERSION) {
+        throw std::runtime_error(
+            "unsupported inputs journal version " +
+            std::to_string(header["version"].asInteger())
+        );
+    }
+    int tps = header["tps"].asInteger();
+    auto journal = std::unique_ptr<InputJournal>(
+        new InputJournal(nullptr, std::move(stream), tps)
+    );
+    journal->readFrame();
+    journal->loadEntries();
+    logger.info() << "replaying inputs from " << file.u8string();
+    return journal;
+}
+
+void InputJournal::writeFrame() {
+    if (entries.empty()) {
+        return;
+    }
+    auto list = dv::list();
+    for (auto& [type, value] : entries) {
+        list.add(dv::list({static_cast<int>(type), std::move(value)}));
+    }
+    entries.clear();
+    json::write_binary(
+        *output, dv::object({{"tick", tick}, {"entries", std::move(list)}})
+    );
+    output->flush();
+}
+
+void InputJournal::readFrame() {
+    nextFrame = nullptr;
+    if (endReached || input->peek() == std::char_traits<char>::eof()) {
+        endReached = true;
+        return;
+    }
+    try {
+        auto document = json::read_binary(*input);
+        if (document.has("ticks")) {
+            ticksCount = document["ticks"].asInteger();
+            endReached = true;
+            return;
+        }
+        nextFrame = std::move(document);
+        ticksCount = nextFrame["tick"].asInteger() + 1;
+    } catch (const std::runtime_error& err) {
+        // the recorded process has crashed while writing
+        logger.warning() << "truncated journal: " << err.what();
+        endReached = true;
+    }
+}
+
+void InputJournal::loadEntries() {
+    if (nextFrame.isObject() &&
+        static_cast<uint64_t>(nextFrame["tick"].asInteger()) == tick) {
+        for (const auto& entry : nextFrame["entries"]) {
+            entries.emplace_back(
+                static_cast<JournalEntryType>(entry[0].asInteger()), entry[1]
+            );
+        }
+        readFrame();
+    }
+}
+
+bool InputJournal::isFinished() const {
+    return endReached && tick >= ticksCount;
+}
+
+void InputJournal::nextTick() {
+    if (!isReplaying()) {
+        writeFrame();
+        tick++;
+        return;
+    }
+    for (const auto& [type, value] : entries) {
+        if (type == JournalEntryType::CALL_RESULT) {
+            logger.warning() << "replay desync at tick " << tick
+                             << ": recorded calls are not made";
+            break;
+        }
+    }
+    entries.clear();
+    tick++;
+    loadEntries();
+}
+
+void InputJournal::add(JournalEntryType type, dv::value value) {
+    entries.emplace_back(type, std::move(value));
+}
+
+dv::value InputJournal::take(JournalEntryType type) {
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->first == type) {
+            auto value = std::move(it->second);
+            entries.erase(it);
+            return value;
+        }
+    }
+    throw std::runtime_error(
+        "replay desync at tick " + std::to_string(tick) +
+        ": missing recorded entry"
+    );
+}
+
+std::vector<std::string> InputJournal::takeCommands() {
+    std::vector<std::string> commands;
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->first == JournalEntryType::COMMAND) {
+            commands.push_back(it->second.asString());
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return commands;
+}
+
+dv::value InputJournal::pass(dv::value value) {
+    if (isReplaying()) {
+        return take(JournalEntryType::CALL_RESULT);
+    }
+    add(JournalEntryType::CALL_RESULT, value);
+    return value;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <deque>
+#include <filesystem>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "data/dv.hpp"
+
+namespace devtools {
+    enum class JournalEntryType {
+        /// @brief Console command line
+        COMMAND = 1,
+        /// @brief Results of a non-deterministic call (network data
+        /// delivered to scripts, random values and seeds, wall clock time)
+        CALL_RESULT,
+    };
+
+    /// @brief Per-tick log of the server external inputs, re-fed on replay
+    /// to reproduce the run. Ticks without inputs are not written.
+    ///
+    /// File is a sequence of binary JSON documents: header, tick frames
+    /// and the end document with total ticks count (missing if the
+    /// recorded process has crashed)
+    class InputJournal {
+        std::unique_ptr<std::ostream> output;
+        std::unique_ptr<std::istream> input;
+        int tps;
+        uint64_t tick = 0;
+        /// @brief Entries of the current tick (recorded or not taken yet)
+        std::deque<std::pair<JournalEntryType, dv::value>> entries;
+        /// @brief Next tick frame read ahead (replay, none if no frames left)
+        dv::value nextFrame;
+        /// @brief Recorded ticks count (replay, unknown until the end)
+        uint64_t ticksCount = 0;
+        bool endReached = false;
+
+        InputJournal(
+            std::unique_ptr<std::ostream> output,
+            std::unique_ptr<std::istream> input,
+            int tps
+        );
+
+        void writeFrame();
+        void readFrame();
+        /// @brief Move the next frame entries if it is the current tick one
+        void loadEntries();
+    public:
+        ~InputJournal();
+
+        /// @throws std::runtime_error - could not open the file
+        static std::unique_ptr<InputJournal> record(
+            const std::filesystem::path& file, int tps
+        );
+
+        /// @throws std::runtime_error - could not read the file header
+        static std::unique_ptr<InputJournal> replay(
+            const std::filesystem::path& file
+        );
+
+        bool isReplaying() const {
+            return input != nullptr;
+        }
+
+        /// @brief Recorded ticks per second
+        int getTps() const {
+            return tps;
+        }
+
+        uint64_t getTick() const {
+            return tick;
+        }
+
+        /// @return true if all recorded ticks are replayed
+        bool isFinished() const;
+
+        /// @brief Finish the current tick: write its entries or load
+        /// the next tick ones
+        void nextTick();
+
+        /// @brief Record entry to the current tick
+        void add(JournalEntryType type, dv::value value);
+
+        /// @brief Take the next recorded entry of the current tick
+        /// @throws std::runtime_error - entry is missing (replay desync)
+        dv::value take(JournalEntryType type);
+
+        /// @brief Take all recorded commands of the current tick
+        std::vector<std::string> takeCommands();
+
+        /// @brief Record the value or replace it with the recorded one
+        /// @throws std::runtime_error - entry is missing (replay desync)
+        dv::value pass(dv::value value);
+    };
+}
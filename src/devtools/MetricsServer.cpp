@@ -0,0 +1,134 @@
+#include "MetricsServer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "debug/Logger.hpp"
+#include "network/Network.hpp"
+
+using namespace devtools;
+
+static debug::Logger logger("metrics-server");
+
+/// @brief Max request head size, bigger requests are rejected
+inline constexpr size_t MAX_REQUEST_SIZE = 8192;
+/// @brief Time given to a client to send the request head
+inline constexpr auto REQUEST_TIMEOUT = std::chrono::seconds(5);
+/// @brief Max number of concurrently served clients
+inline constexpr size_t MAX_CLIENTS = 32;
+
+MetricsServer::MetricsServer(
+    network::Network& network, int port, MetricsCollector collector
+)
+    : network(network), collector(std::move(collector)) {
+    serverId = network.openTcpServer(port, [this](u64id_t, u64id_t id) {
+        if (auto connection = this->network.getConnection(id, true)) {
+            connection->setPrivate(true);
+        }
+        std::lock_guard lock(acceptedMutex);
+        accepted.push_back(id);
+    });
+    auto server = network.getServer(serverId, true);
+    if (server == nullptr) {
+        throw std::runtime_error("could not open metrics server");
+    }
+    server->setPrivate(true);
+    logger.info() << "metrics server open at port " << server->getPort();
+}
+
+MetricsServer::~MetricsServer() {
+    if (auto server = network.getServer(serverId, true)) {
+        server->close();
+    }
+}
+
+static std::string build_response(
+    const std::string& status, const std::string& contentType,
+    const std::string& body
+) {
+    return "HTTP/1.1 " + status + "\r\n"
+           "Content-Type: " + contentType + "\r\n"
+           "Content-Length: " + std::to_string(body.length()) + "\r\n"
+           "Connection: close\r\n"
+           "\r\n" + body;
+}
+
+static void close_connection(network::Network& network, u64id_t id) {
+    if (auto connection = network.getConnection(id, true)) {
+        connection->close(true);
+    }
+}
+
+bool MetricsServer::process(Client& client) {
+    auto connection = dynamic_cast<network::ReadableConnection*>(
+        network.getConnection(client.connection, true)
+    );
+    if (connection == nullptr) {
+        return true;
+    }
+    int available = connection->available();
+    if (available > 0) {
+        size_t offset = client.request.length();
+        client.request.resize(offset + available);
+        int read = connection->recv(client.request.data() + offset, available);
+        client.request.resize(offset + std::max(read, 0));
+    }
+    size_t headEnd = client.request.find("\r\n\r\n");
+    if (headEnd == std::string::npos) {
+        if (client.request.length() > MAX_REQUEST_SIZE) {
+            connection->close(true);
+            return true;
+        }
+        return false;
+    }
+    // request line: METHOD SP TARGET SP VERSION
+    const auto& request = client.request;
+    size_t methodEnd = request.find(' ');
+    size_t targetEnd = request.find(' ', methodEnd + 1);
+    std::string method = request.substr(0, methodEnd);
+    std::string target;
+    if (methodEnd != std::string::npos && targetEnd != std::string::npos) {
+        target = request.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+        target = target.substr(0, target.find('?'));
+    }
+    std::string response;
+    if (method == "GET" && target == "/metrics") {
+        response = build_response(
+            "200 OK", "text/plain; version=0.0.4; charset=utf-8", collector()
+        );
+    } else {
+        response = build_response("404 Not Found", "text/plain", "not found\n");
+    }
+    connection->send(response.data(), response.length());
+    connection->close();
+    return true;
+}
+
+void MetricsServer::update() {
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard lock(acceptedMutex);
+        for (u64id_t id : accepted) {
+            if (clients.size() >= MAX_CLIENTS) {
+                logger.warning() << "too many clients, connection rejected";
+                close_connection(network, id);
+                continue;
+            }
+            clients.push_back({id, "", now});
+        }
+        accepted.clear();
+    }
+    for (size_t i = 0; i < clients.size();) {
+        auto& client = clients[i];
+        bool finished = process(client);
+        if (!finished && now - client.acceptTime > REQUEST_TIMEOUT) {
+            close_connection(network, client.connection);
+            finished = true;
+        }
+        if (finished) {
+            clients.erase(clients.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
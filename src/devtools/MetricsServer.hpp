@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "typedefs.hpp"
+
+namespace network {
+    class Network;
+}
+
+namespace devtools {
+    /// @return metrics in Prometheus text format
+    using MetricsCollector = std::function<std::string()>;
+
+    /// @brief Minimal HTTP server answering 'GET /metrics' scrapes.
+    /// Each connection serves a single request and is closed. Connections
+    /// not sending the request head in time or exceeding the clients limit
+    /// are dropped
+    class MetricsServer {
+        struct Client {
+            u64id_t connection;
+            std::string request;
+            std::chrono::steady_clock::time_point acceptTime;
+        };
+
+        network::Network& network;
+        MetricsCollector collector;
+        u64id_t serverId;
+        /// @brief Connections accepted by the network thread
+        std::vector<u64id_t> accepted;
+        std::mutex acceptedMutex;
+        std::vector<Client> clients;
+
+        /// @return true if the request is complete and has been answered
+        bool process(Client& client);
+    public:
+        /// @throws std::runtime_error - could not open the port
+        MetricsServer(
+            network::Network& network, int port, MetricsCollector collector
+        );
+        ~MetricsServer();
+
+        /// @brief Answer received requests. Must be called from the main
+        /// thread before the network update
+        void update();
+    };
+}
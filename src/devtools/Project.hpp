@@ -17,6 +17,8 @@ struct Permissions {
     static inline std::string NETWORK = "network";
     static inline std::string RECORD_AUDIO = "record-audio";
     static inline std::string WRITE_TO_USER = "write-to-user";
+    /// @brief Access engine buffers from Lua via FFI without copying
+    static inline std::string FFI_VIEWS = "ffi-views";
 
     std::set<std::string> permissions;
 
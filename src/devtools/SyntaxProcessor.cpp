@@ -54,6 +54,189 @@ static std::unique_ptr<FontStylesScheme> build_styles(
     return std::make_unique<FontStylesScheme>(std::move(styles));
 }
 
+static int get_style_index(devtools::TokenTag tag) {
+    using devtools::TokenTag;
+    switch (tag) {
+        case TokenTag::KEYWORD: return SyntaxStyles::KEYWORD;
+        case TokenTag::STRING:
+        case TokenTag::INTEGER:
+        case TokenTag::NUMBER: return SyntaxStyles::LITERAL;
+        case TokenTag::COMMENT: return SyntaxStyles::COMMENT;
+        case TokenTag::UNEXPECTED: return SyntaxStyles::ERROR;
+        default: return SyntaxStyles::DEFAULT;
+    }
+}
+
+/// @brief Write tokens styles to the cache
+/// @param source full source
+/// @param offset tokens source offset in the full source
+static void write_styles(
+    HighlightCache& cache,
+    std::wstring_view source,
+    const std::vector<devtools::Token>& tokens,
+    int offset,
+    std::vector<std::pair<int, int>>& multilineTokens
+) {
+    for (const auto& token : tokens) {
+        int start = token.start.pos + offset;
+        int end = token.end.pos + offset;
+        if (source.substr(start, end - start).find(L'\n') !=
+            std::wstring_view::npos) {
+            multilineTokens.emplace_back(start, end);
+        }
+        int styleIndex = get_style_index(token.tag);
+        if (styleIndex == SyntaxStyles::DEFAULT) {
+            continue;
+        }
+        if (styleIndex >= cache.paletteSize) {
+            styleIndex = 0;
+        }
+        std::fill(
+            cache.map.begin() + start, cache.map.begin() + end, styleIndex
+        );
+    }
+}
+
+/// @return multiline token strictly containing the position or nullptr.
+/// Tokens not terminated before the source end contain the end too
+static const std::pair<int, int>* find_multiline_token(
+    const std::vector<std::pair<int, int>>& tokens, int pos, int length
+) {
+    auto found = std::upper_bound(
+        tokens.begin(),
+        tokens.end(),
+        pos,
+        [](int pos, const auto& token) { return pos < token.first; }
+    );
+    if (found == tokens.begin()) {
+        return nullptr;
+    }
+    --found;
+    if (found->first < pos && (pos < found->second || found->second == length)) {
+        return &*found;
+    }
+    return nullptr;
+}
+
+static int find_line_start(std::wstring_view source, int pos) {
+    while (pos > 0 && source[pos - 1] != L'\n') {
+        pos--;
+    }
+    return pos;
+}
+
+static bool highlight_full(
+    const Syntax& syntax, std::wstring_view source, HighlightCache& cache
+) {
+    try {
+        auto tokens = tokenize(syntax, "<string>", source);
+        cache.map.assign(source.length() + 1, 0);
+        cache.multilineTokens.clear();
+        write_styles(cache, source, tokens, 0, cache.multilineTokens);
+    } catch (const parsing_error& err) {
+        cache.valid = false;
+        return false;
+    }
+    cache.source = source;
+    cache.valid = true;
+    return true;
+}
+
+/// @brief Re-tokenize lines range including the changed text, from a line
+/// start outside of any token until a line start in the unchanged text
+/// where the old and new tokens are split the same way
+static bool highlight_changed(
+    const Syntax& syntax, std::wstring_view source, HighlightCache& cache
+) {
+    std::wstring_view prev = cache.source;
+    int newLength = source.length();
+    int prevLength = prev.length();
+    int maxCommon = std::min(newLength, prevLength);
+    int prefix = 0;
+    while (prefix < maxCommon && source[prefix] == prev[prefix]) {
+        prefix++;
+    }
+    if (prefix == newLength && prefix == prevLength) {
+        return true;
+    }
+    int suffix = 0;
+    while (suffix < maxCommon - prefix &&
+           source[newLength - suffix - 1] == prev[prevLength - suffix - 1]) {
+        suffix++;
+    }
+    int delta = newLength - prevLength;
+
+    int start = find_line_start(source, prefix);
+    while (auto token = find_multiline_token(
+               cache.multilineTokens, start, prevLength
+           )) {
+        start = find_line_start(source, token->first);
+    }
+
+    // window end is a line start after a line break in the unchanged suffix
+    int end = std::min(newLength, newLength - suffix + 1);
+    for (int attempt = 0; attempt < 4; attempt++) {
+        while (end < newLength && source[end - 1] != L'\n') {
+            end++;
+        }
+        while (end < newLength) {
+            auto token = find_multiline_token(
+                cache.multilineTokens, end - delta, prevLength
+            );
+            if (token == nullptr) {
+                break;
+            }
+            end = token->second + delta;
+            while (end < newLength && source[end - 1] != L'\n') {
+                end++;
+            }
+        }
+        std::vector<devtools::Token> tokens;
+        try {
+            tokens = tokenize(
+                syntax, "<string>", source.substr(start, end - start)
+            );
+        } catch (const parsing_error& err) {
+            if (end == newLength) {
+                return false;
+            }
+            end++;
+            continue;
+        }
+        if (end < newLength && !tokens.empty() &&
+            tokens.back().end.pos + start >= end) {
+            // the last token may continue after the window
+            end++;
+            continue;
+        }
+        std::vector<unsigned char> map;
+        map.reserve(newLength + 1);
+        map.insert(map.end(), cache.map.begin(), cache.map.begin() + start);
+        map.insert(map.end(), end - start, 0);
+        map.insert(map.end(), cache.map.begin() + (end - delta), cache.map.end());
+
+        std::vector<std::pair<int, int>> multilineTokens;
+        for (const auto& token : cache.multilineTokens) {
+            if (token.second <= start) {
+                multilineTokens.push_back(token);
+            }
+        }
+        cache.map = std::move(map);
+        write_styles(cache, source, tokens, start, multilineTokens);
+        for (const auto& token : cache.multilineTokens) {
+            if (token.first >= end - delta) {
+                multilineTokens.emplace_back(
+                    token.first + delta, token.second + delta
+                );
+            }
+        }
+        cache.multilineTokens = std::move(multilineTokens);
+        cache.source = source;
+        return true;
+    }
+    return false;
+}
+
 void SyntaxProcessor::addSyntax(
     std::unique_ptr<Syntax> syntax
 ) {
@@ -82,3 +265,33 @@ std::unique_ptr<FontStylesScheme> SyntaxProcessor::highlight(
         return nullptr;
     }
 }
+
+std::unique_ptr<FontStylesScheme> SyntaxProcessor::highlight(
+    const FontStylesScheme& colorScheme,
+    const std::string& ext,
+    std::wstring_view source,
+    HighlightCache& cache
+) const {
+    const auto& found = langsExtensions.find(ext);
+    if (found == langsExtensions.end()) {
+        return nullptr;
+    }
+    const auto& syntax = *found->second;
+
+    FontStylesScheme styles {colorScheme.palette, {}};
+    if (styles.palette.empty()) {
+        styles.palette.push_back(FontStyle {
+            false, false, false, false, glm::vec4(0.8f, 0.8f, 0.8f, 1)});
+    }
+    if (cache.ext != ext || cache.paletteSize != styles.palette.size()) {
+        cache.valid = false;
+        cache.ext = ext;
+        cache.paletteSize = styles.palette.size();
+    }
+    if (!(cache.valid && highlight_changed(syntax, source, cache)) &&
+        !highlight_full(syntax, source, cache)) {
+        return nullptr;
+    }
+    styles.map = cache.map;
+    return std::make_unique<FontStylesScheme>(std::move(styles));
+}
@@ -15,6 +15,19 @@ namespace devtools {
         DEFAULT, KEYWORD, LITERAL, COMMENT, ERROR
     };
 
+    /// @brief Highlighting results kept between text edits to tokenize
+    /// changed lines only
+    struct HighlightCache {
+        bool valid = false;
+        std::string ext;
+        size_t paletteSize = 0;
+        std::wstring source;
+        /// @brief Style index of each source character + trailing 0
+        std::vector<unsigned char> map;
+        /// @brief [start, end) of tokens spanning multiple lines
+        std::vector<std::pair<int, int>> multilineTokens;
+    };
+
     class SyntaxProcessor {
     public:
         std::unique_ptr<FontStylesScheme> highlight(
@@ -23,6 +36,15 @@ namespace devtools {
             std::wstring_view source
         ) const;
 
+        /// @brief Highlight source re-tokenizing only lines changed since
+        /// the previous call with the same cache
+        std::unique_ptr<FontStylesScheme> highlight(
+            const FontStylesScheme& colorScheme,
+            const std::string& ext,
+            std::wstring_view source,
+            HighlightCache& cache
+        ) const;
+
         void addSyntax(std::unique_ptr<Syntax> syntax);
     private:
         std::vector<std::unique_ptr<Syntax>> langs;
@@ -1,6 +1,7 @@
 #include "stdin_cmd_reader.hpp"
 
 #include "engine/Engine.hpp"
+#include "devtools/InputJournal.hpp"
 #include "logic/CommandsInterpreter.hpp"
 #include "coders/json.hpp"
 #include "debug/Logger.hpp"
@@ -12,9 +13,25 @@ static debug::Logger logger("stdin-cmd");
 
 static std::thread reader_thread;
 
+void cmd::execute_command(Engine& engine, const std::string& line) {
+    auto journal = engine.getInputJournal();
+    if (journal && !journal->isReplaying()) {
+        journal->add(devtools::JournalEntryType::COMMAND, line);
+    }
+    try {
+        auto result = engine.getCmd().execute(line);
+        if (result.isString()) {
+            logger.info() << result.asString();
+        } else {
+            logger.info() << json::stringify(result, true);
+        }
+    } catch (const std::exception& err) {
+        logger.error() << err.what();
+    }
+}
+
 void cmd::start_stdin_cmd_reader(Engine& engine) {
     reader_thread = std::thread([&engine]() {
-        auto& interpreter = engine.getCmd();
         logger.info() << "reader thread started";
         
         std::string line;
@@ -22,17 +39,8 @@ void cmd::start_stdin_cmd_reader(Engine& engine) {
             if (line.empty()) {
                 continue;
             }
-            engine.postRunnable([line, &interpreter] () {
-                try {
-                    auto result = interpreter.execute(line);
-                    if (result.isString()) {
-                        logger.info() << result.asString();
-                    } else {
-                        logger.info() << json::stringify(result, true);
-                    }
-                } catch (const std::exception& err) {
-                    logger.error() << err.what();
-                }
+            engine.postRunnable([line, &engine] () {
+                execute_command(engine, line);
             });
         }
     });
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <string>
+
 class Engine;
 
 namespace cmd {
     void start_stdin_cmd_reader(Engine& engine);
+
+    /// @brief Execute console command logging the result. Command is
+    /// recorded to the inputs journal if it's active
+    void execute_command(Engine& engine, const std::string& line);
 }
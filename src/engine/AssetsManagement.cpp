@@ -38,8 +38,9 @@ AssetsLoader& AssetsManagement::acquireBackgroundLoader() {
     backgroundLoader = std::make_unique<AssetsLoader>(
         engine, *assets, engine.getResPaths()
     );
+    // streamed assets failures must not break the running screen
     backgroundLoaderTask = backgroundLoader->startTask(
-        nullptr, settings.system.maxBgAssetLoaders.get()
+        nullptr, settings.system.maxBgAssetLoaders.get(), false
     );
     return *backgroundLoader;
 }
@@ -70,11 +71,24 @@ void AssetsManagement::loadAssets(Content* content) {
         }
     }
     assets = std::move(new_assets);
+    assets->setResolver([this](const std::string& name) {
+        return backgroundLoader && backgroundLoader->resolve(name);
+    });
     if (content) {
         ModelsGenerator::prepare(*content, *assets);
     }
     assets->setup();
     engine.getGUI().onAssetsLoad(assets.get());
+
+    // not required assets are streamed in after the screen is shown
+    auto deferred = loader.takeDeferred();
+    if (!deferred.empty()) {
+        logger.info() << "streaming " << deferred.size() << " assets";
+        auto& streamLoader = acquireBackgroundLoader();
+        for (auto& entry : deferred) {
+            streamLoader.add(std::move(entry));
+        }
+    }
 }
 
 void AssetsManagement::update() {
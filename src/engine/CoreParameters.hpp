@@ -7,10 +7,32 @@ struct CoreParameters {
     bool headless = false;
     bool testMode = false;
     bool stdinCommands = false;
+    /// @brief Write log in background thread
+    bool asyncLogging = false;
     std::filesystem::path resFolder = "res";
     std::filesystem::path userFolder = ".";
     std::filesystem::path scriptFile;
     std::filesystem::path projectFolder;
     std::string debugServerString;
     int tps = 20;
+    /// @brief Name of the world to run headless benchmark in
+    std::string benchmarkWorld;
+    /// @brief Number of simulated players in benchmark
+    int benchmarkPlayers = 8;
+    /// @brief Number of ticks performed by benchmark
+    int benchmarkTicks = 1200;
+    /// @brief Benchmark JSON report file (not written if empty)
+    std::filesystem::path benchmarkReport;
+    /// @brief Startup trace file in Chrome trace events format
+    /// (not written if empty)
+    std::filesystem::path startupTrace;
+    /// @brief Headless mode Prometheus metrics HTTP port (0 - disabled)
+    int metricsPort = 0;
+    /// @brief Headless mode inputs journal to write (not written if empty)
+    std::filesystem::path inputsRecord;
+    /// @brief Inputs journal replayed instead of the live inputs
+    std::filesystem::path inputsReplay;
+    /// @brief Replay trace file in Chrome trace events format
+    /// (not written if empty)
+    std::filesystem::path replayTrace;
 };
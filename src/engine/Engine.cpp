@@ -12,9 +12,13 @@
 #include "coders/vector_fonts.hpp"
 #include "content/ContentControl.hpp"
 #include "core_defs.hpp"
+#include "debug/Allocations.hpp"
 #include "debug/Logger.hpp"
+#include "debug/Memory.hpp"
+#include "debug/Profiler.hpp"
 #include "devtools/DebuggingServer.hpp"
 #include "devtools/Editor.hpp"
+#include "devtools/InputJournal.hpp"
 #include "devtools/Project.hpp"
 #include "devtools/stdin_cmd_reader.hpp"
 #include "EnginePaths.hpp"
@@ -34,6 +38,7 @@
 #include "Mainloop.hpp"
 #include "network/Network.hpp"
 #include "ServerMainloop.hpp"
+#include "util/cores.hpp"
 #include "util/platform.hpp"
 #include "util/stringutil.hpp"
 #include "window/input.hpp"
@@ -45,9 +50,14 @@
 #include <glm/glm.hpp>
 #include <unordered_set>
 #include <functional>
+#include <fstream>
+#include <future>
 
 static debug::Logger logger("engine");
 
+/// @brief Memory budget check interval (seconds)
+inline constexpr double MEMORY_CHECK_INTERVAL = 1.0;
+
 Engine::Engine() = default;
 Engine::~Engine() = default;
 
@@ -127,58 +137,106 @@ void Engine::initialize(CoreParameters coreParameters) {
     settingsHandler = std::make_unique<SettingsHandler>(settings);
 
     logger.info() << "engine version: " << ENGINE_VERSION_STRING;
+    debug::profiler::set_thread_name("main");
+    if (!params.startupTrace.empty()) {
+        // record zones of the startup systems to the trace
+        debug::profiler::set_enabled(true);
+    }
     if (params.headless) {
         logger.info() << "engine runs in headless mode";
     }
     if (params.projectFolder.empty()) {
         params.projectFolder = params.resFolder;
     }
-    paths = std::make_unique<EnginePaths>(params);
-    loadProject();
-    paths->setupProject(*project);
-
-    editor = std::make_unique<devtools::Editor>(*this);
-    cmd = std::make_unique<cmd::CommandsInterpreter>();
+    {
+        auto phase = startup.phase("startup.project");
+        paths = std::make_unique<EnginePaths>(params);
+        loadProject();
+        paths->setupProject(*project);
+
+        editor = std::make_unique<devtools::Editor>(*this);
+        cmd = std::make_unique<cmd::CommandsInterpreter>();
+    }
+    {
+        auto phase = startup.phase("startup.network");
+        if (project->permissions.has(Permissions::NETWORK) ||
+            !params.debugServerString.empty() ||
+            (params.headless && params.metricsPort > 0)) {
+            network = network::Network::create(settings.network);
+        }
 
-    if (project->permissions.has(Permissions::NETWORK) ||
-        !params.debugServerString.empty()) {
-        network = network::Network::create(settings.network);
+        if (!params.debugServerString.empty()) {
+            try {
+                debuggingServer = std::make_unique<devtools::DebuggingServer>(
+                    *this, params.debugServerString
+                );
+            } catch (const std::runtime_error& err) {
+                throw initialize_error(
+                    "debugging server error: " + std::string(err.what())
+                );
+            }
+        }
     }
-
-    if (!params.debugServerString.empty()) {
-        try {
-            debuggingServer = std::make_unique<devtools::DebuggingServer>(
-                *this, params.debugServerString
-            );
-        } catch (const std::runtime_error& err) {
-            throw initialize_error(
-                "debugging server error: " + std::string(err.what())
+    {
+        auto phase = startup.phase("startup.settings");
+        loadSettings();
+    }
+    util::cores::set_pinning(settings.system.pinThreads.get());
+    util::cores::pin_main_thread();
+
+    // audio device and fonts library are opened while the window and
+    // GL context are created
+    auto backgroundInit = std::async(std::launch::async, [this]() {
+        debug::profiler::set_thread_name("startup");
+        {
+            auto phase = startup.phase("startup.audio");
+            audio::initialize(
+                !params.headless,
+                project->permissions.has(Permissions::RECORD_AUDIO),
+                settings.audio
             );
         }
-    }
-    loadSettings();
+        auto phase = startup.phase("startup.fonts");
+        vector_fonts::initialize();
+    });
 
     controller = std::make_unique<EngineController>(*this);
     if (!params.headless) {
+        auto phase = startup.phase("startup.client");
         initializeClient();
     }
-    audio::initialize(
-        !params.headless,
-        project->permissions.has(Permissions::RECORD_AUDIO),
-        settings.audio
-    );
-
-    vector_fonts::initialize();
+    {
+        auto phase = startup.phase("startup.background-wait");
+        backgroundInit.get();
+    }
 
     if (settings.ui.language.get() == "auto") {
         settings.ui.language.set(
             langs::locale_by_envlocale(platform::detect_locale())
         );
     }
-    content = std::make_unique<ContentControl>(
-        *project, *paths, input.get(), [this]() { onContentLoad(); }
-    );
-    scripting::initialize(this);
+    {
+        auto phase = startup.phase("startup.scripting");
+        content = std::make_unique<ContentControl>(
+            *project, *paths, input.get(), [this]() { onContentLoad(); }
+        );
+        scripting::initialize(this);
+    }
+
+    auto configureGC = [](auto) { scripting::configure_gc(); };
+    keepAlive(settings.scripting.gcStepping.observe(configureGC));
+    keepAlive(settings.scripting.gcPause.observe(configureGC));
+    keepAlive(settings.scripting.gcStepMul.observe(configureGC, true));
+
+    keepAlive(settings.system.memoryBudget.observe([](int mib) {
+        debug::memory::set_budget(static_cast<size_t>(mib) << 20);
+    }, true));
+    keepAlive(settings.system.videoMemoryBudget.observe([](int mib) {
+        debug::memory::set_video_budget(static_cast<size_t>(mib) << 20);
+    }, true));
+    keepAlive(settings.system.workerThreads.observe([](int count) {
+        util::cores::set_budget(count);
+    }, true));
 
     if (!isHeadless()) {
         gui->getMenu()->setPageLoader(scripting::create_page_loader());
@@ -191,15 +249,52 @@ void Engine::initialize(CoreParameters coreParameters) {
         audio::set_input_device(name == "auto" ? "" : name);
     }, true));
 
-    project->loadProjectStartScript();
-    if (!params.headless) {
-        project->loadProjectClientScript();
+    if (params.headless) {
+        try {
+            if (!params.inputsReplay.empty()) {
+                inputJournal =
+                    devtools::InputJournal::replay(params.inputsReplay);
+            } else if (!params.inputsRecord.empty()) {
+                inputJournal = devtools::InputJournal::record(
+                    params.inputsRecord, params.tps
+                );
+            }
+        } catch (const std::runtime_error& err) {
+            throw initialize_error(
+                "inputs journal error: " + std::string(err.what())
+            );
+        }
     }
-    if (params.stdinCommands) {
+    {
+        auto phase = startup.phase("startup.project-scripts");
+        project->loadProjectStartScript();
+        if (!params.headless) {
+            project->loadProjectClientScript();
+        }
+    }
+    // replay executes recorded commands instead
+    if (params.stdinCommands && params.inputsReplay.empty()) {
         cmd::start_stdin_cmd_reader(*this);
     }
 }
 
+void Engine::finishStartup() {
+    if (startupFinished) {
+        return;
+    }
+    startupFinished = true;
+    logger.info() << "startup phases:" << startup.toString();
+
+    if (params.startupTrace.empty()) {
+        return;
+    }
+    debug::profiler::set_enabled(false);
+    std::ofstream stream(params.startupTrace);
+    stream << debug::profiler::to_chrome_trace();
+    logger.info() << "startup trace written to "
+                  << params.startupTrace.u8string();
+}
+
 void Engine::loadSettings() {
     io::path settings_file = EnginePaths::SETTINGS_FILE;
     if (io::is_regular_file(settings_file)) {
@@ -256,6 +351,14 @@ void Engine::postUpdate() {
     if (debuggingServer) {
         debuggingServer->update();
     }
+
+    memoryTimer += time.getDelta();
+    if (memoryTimer >= MEMORY_CHECK_INTERVAL) {
+        memoryTimer = 0.0;
+        debug::memory::enforce_budget();
+        debug::memory::update_video_pressure();
+    }
+    debug::allocations::end_frame();
 }
 
 void Engine::detachDebugger() {
@@ -269,6 +372,7 @@ void Engine::applicationTick() {
 }
 
 void Engine::updateFrontend() {
+    VC_PROFILE_ZONE("Engine::updateFrontend");
     double delta = time.getDelta();
     assets->update();
     updateHotkeys();
@@ -309,6 +413,7 @@ void Engine::startPauseLoop() {
 }
 
 void Engine::renderFrame() {
+    VC_PROFILE_ZONE("Engine::renderFrame");
     if (input->isCursorLocked() != (gui->getActiveFrame() == nullptr)) {
         input->toggleCursor();
     }
@@ -355,6 +460,7 @@ void Engine::close() {
     project.reset();
     scripting::close();
     logger.info() << "scripting finished";
+    inputJournal.reset();
     if (!params.headless) {
         window.reset();
         logger.info() << "window closed";
@@ -466,6 +572,10 @@ Time& Engine::getTime() {
     return time;
 }
 
+TickMetrics& Engine::getTickMetrics() {
+    return tickMetrics;
+}
+
 const CoreParameters& Engine::getCoreParameters() const {
     return params;
 }
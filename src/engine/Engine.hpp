@@ -2,8 +2,10 @@
 
 #include "CoreParameters.hpp"
 #include "PostRunnables.hpp"
+#include "TickScheduler.hpp"
 #include "Time.hpp"
 #include "settings.hpp"
+#include "debug/StartupTimeline.hpp"
 #include "util/ObjectsKeeper.hpp"
 
 #include <memory>
@@ -39,6 +41,7 @@ namespace network {
 namespace devtools {
     class Editor;
     class DebuggingServer;
+    class InputJournal;
 }
 
 class initialize_error : public std::runtime_error {
@@ -65,11 +68,17 @@ class Engine : public util::ObjectsKeeper {
     std::unique_ptr<gui::GUI> gui;
     std::unique_ptr<devtools::Editor> editor;
     std::unique_ptr<devtools::DebuggingServer> debuggingServer;
+    std::unique_ptr<devtools::InputJournal> inputJournal;
     std::unique_ptr<WindowControl> windowControl;
     PostRunnables postRunnables;
     Time time;
+    /// @brief Time since the last memory budget check
+    double memoryTimer = 0.0;
+    TickMetrics tickMetrics;
     OnWorldOpen levelConsumer;
     bool quitSignal = false;
+    debug::StartupTimeline startup;
+    bool startupFinished = false;
     
     void loadControls();
     void loadSettings();
@@ -94,6 +103,15 @@ public:
     /// @brief Start the engine
     void run();
 
+    /// @brief Startup phases measurement (see finishStartup)
+    debug::StartupTimeline& getStartupTimeline() {
+        return startup;
+    }
+
+    /// @brief Write startup phases to the log and the startup trace file
+    /// if requested. Called by the main loop before the first frame
+    void finishStartup();
+
     void postUpdate();
 
     void applicationTick();
@@ -146,6 +164,9 @@ public:
 
     Time& getTime();
 
+    /// @brief Headless mainloop ticks schedule metrics
+    TickMetrics& getTickMetrics();
+
     const CoreParameters& getCoreParameters() const;
 
     bool isHeadless() const;
@@ -172,6 +193,11 @@ public:
         return *cmd;
     }
 
+    /// @return active inputs journal (recorded or replayed) or nullptr
+    devtools::InputJournal* getInputJournal() {
+        return inputJournal.get();
+    }
+
     devtools::Editor& getEditor() {
         return *editor;
     }
@@ -1,10 +1,13 @@
 #include "Mainloop.hpp"
 
+#include <chrono>
+
 #include "Engine.hpp"
 #include "debug/Logger.hpp"
 #include "devtools/Project.hpp"
 #include "frontend/screens/MenuScreen.hpp"
 #include "frontend/screens/LevelScreen.hpp"
+#include "logic/scripting/scripting.hpp"
 #include "window/Window.hpp"
 #include "world/Level.hpp"
 #include "graphics/ui/GUI.hpp"
@@ -34,10 +37,15 @@ void Mainloop::run() {
     });
 
     logger.info() << "starting menu screen";
-    engine.setScreen(std::make_shared<MenuScreen>(engine));
+    {
+        auto phase = engine.getStartupTimeline().phase("startup.menu");
+        engine.setScreen(std::make_shared<MenuScreen>(engine));
+    }
+    engine.finishStartup();
     
     logger.info() << "main loop started";
     while (!window.isShouldClose()){
+        auto frameStart = std::chrono::steady_clock::now();
         time.update(window.time());
         engine.applicationTick();
         engine.updateFrontend();
@@ -46,6 +54,17 @@ void Mainloop::run() {
             engine.renderFrame();
         }
         engine.postUpdate();
+
+        // frame slack is known only if framerate is limited
+        int framerate = settings.display.framerate.get();
+        double slack = 0.0;
+        if (framerate > 0) {
+            slack = 1.0 / framerate -
+                    std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - frameStart
+                    ).count();
+        }
+        scripting::step_gc(slack);
         engine.nextFrame(
             settings.display.adaptiveFpsInMenu.get() &&
             dynamic_cast<const MenuScreen*>(engine.getScreen().get()) != nullptr
@@ -2,6 +2,12 @@
 
 class Engine;
 
+/// @brief Client main loop. Frame phases (world update, frontend update,
+/// render) run sequentially in the thread owning the GL context and the
+/// scripting state: both are accessed by every phase, so they can't
+/// overlap. Parallel work is moved to background pools instead (chunks
+/// generation, lighting and meshing, physics, pathfinding) which results
+/// are consumed at the start of the phase using them
 class Mainloop {
     Engine& engine;
 public:
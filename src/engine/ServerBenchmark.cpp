@@ -0,0 +1,186 @@
+#include "ServerBenchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string_view>
+
+#include <glm/gtc/constants.hpp>
+
+#include "coders/json.hpp"
+#include "data/dv.hpp"
+#include "debug/Logger.hpp"
+#include "debug/Profiler.hpp"
+#include "logic/LevelController.hpp"
+#include "logic/scripting/lua/lua_engine.hpp"
+#include "objects/Player.hpp"
+#include "objects/Players.hpp"
+#include "util/platform.hpp"
+#include "world/Level.hpp"
+
+static debug::Logger logger("benchmark");
+
+/// @brief Blocks per second
+inline constexpr float FLIGHT_SPEED = 16.0f;
+inline constexpr float FLIGHT_HEIGHT = 120.0f;
+
+namespace {
+    struct SubsystemInfo {
+        const char* name;
+        std::vector<std::string_view> zones;
+    };
+}
+
+// zones may be nested, so the subsystems durations may overlap
+static const SubsystemInfo SUBSYSTEMS[] {
+    {"tick", {}},
+    {"chunks", {"ChunksController::update"}},
+    {"generation", {"ChunksController::generate"}},
+    {"lighting",
+     {"ChunksController::buildLights",
+      "Lighting::onChunkLoaded",
+      "Lighting::solveBlocksChanges"}},
+    {"blocks", {"BlocksController::update", "BlocksController::applyBatch"}},
+    {"entities", {"Entities::update"}},
+    {"pathfinding", {"Pathfinding::performAllAsync", "Pathfinding::search"}},
+    {"scripts",
+     {"scripting::on_world_tick",
+      "scripting::on_blocks_tick",
+      "scripting::on_player_tick",
+      "scripting::on_entities_update",
+      "scripting::on_entities_physics_update"}},
+    {"gc", {"scripting::step_gc"}},
+};
+static_assert(
+    std::size(SUBSYSTEMS) == ServerBenchmark::SUBSYSTEMS_COUNT,
+    "subsystems info mismatch"
+);
+
+static int64_t percentile(const std::vector<int64_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::clamp<size_t>(index, 1, sorted.size()) - 1];
+}
+
+ServerBenchmark::ServerBenchmark(
+    LevelController& controller, int playersCount, int ticks
+)
+    : controller(controller), ticks(ticks) {
+    auto& level = *controller.getLevel();
+    for (int i = 0; i < playersCount; i++) {
+        auto player = level.players->create();
+        player->setName("benchmark" + std::to_string(i));
+        player->setFlight(true);
+        player->setNoclip(true);
+        players.push_back(player);
+    }
+    for (auto& durations : samples) {
+        durations.reserve(ticks);
+    }
+    movePlayers(0.0);
+
+    debug::profiler::clear();
+    debug::profiler::set_enabled(true);
+    logger.info() << "started with " << playersCount << " players, "
+                  << ticks << " ticks";
+}
+
+ServerBenchmark::~ServerBenchmark() {
+    debug::profiler::set_enabled(false);
+    auto& level = *controller.getLevel();
+    for (auto player : players) {
+        level.players->suspend(player->getId());
+        level.players->remove(player->getId());
+    }
+}
+
+void ServerBenchmark::movePlayers(double time) {
+    // players fly away from the world origin in evenly distributed
+    // directions, waving vertically to cross chunk sections
+    for (size_t i = 0; i < players.size(); i++) {
+        float angle = glm::two_pi<float>() * i / players.size();
+        glm::vec3 dir(std::cos(angle), 0.0f, std::sin(angle));
+        glm::vec3 pos = dir * static_cast<float>(FLIGHT_SPEED * time);
+        pos.y = FLIGHT_HEIGHT + 16.0f * std::sin(time * 0.25 + i);
+        players[i]->teleport(pos);
+        players[i]->setRotation({glm::degrees(angle), 0.0f, 0.0f});
+    }
+}
+
+void ServerBenchmark::beginTick(double time) {
+    movePlayers(time);
+    tickStart = debug::profiler::now();
+}
+
+void ServerBenchmark::endTick() {
+    int64_t tickEnd = debug::profiler::now();
+    samples[TICK].push_back(tickEnd - tickStart);
+
+    std::array<int64_t, SUBSYSTEMS_COUNT> totals {};
+    for (const auto& zone : debug::profiler::get_stats(tickEnd - tickStart)) {
+        for (size_t i = 0; i < SUBSYSTEMS_COUNT; i++) {
+            const auto& zones = SUBSYSTEMS[i].zones;
+            if (std::find(zones.begin(), zones.end(), zone.name) !=
+                zones.end()) {
+                totals[i] += zone.total;
+            }
+        }
+    }
+    for (size_t i = TICK + 1; i < SUBSYSTEMS_COUNT; i++) {
+        samples[i].push_back(totals[i]);
+    }
+    debug::profiler::clear();
+    tick++;
+}
+
+void ServerBenchmark::report(const std::filesystem::path& file) const {
+    size_t peakMemory = platform::get_peak_memory_usage();
+    auto root = dv::object();
+    root["players"] = static_cast<dv::integer_t>(players.size());
+    root["ticks"] = tick;
+    root["peak_rss"] = static_cast<dv::integer_t>(peakMemory);
+    const auto& gcMetrics = lua::get_gc_metrics();
+    root["lua_peak_heap"] = gcMetrics.maxMemory;
+    root["lua_gc_cycles"] = static_cast<dv::integer_t>(gcMetrics.cycles);
+    auto& subsystems = root.object("subsystems");
+
+    logger.info() << "results (ms) for " << tick << " ticks:";
+    for (size_t i = 0; i < SUBSYSTEMS_COUNT; i++) {
+        auto sorted = samples[i];
+        std::sort(sorted.begin(), sorted.end());
+        int64_t p50 = percentile(sorted, 0.5);
+        int64_t p99 = percentile(sorted, 0.99);
+        int64_t max = sorted.empty() ? 0 : sorted.back();
+
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(3) << std::left
+           << std::setw(12) << SUBSYSTEMS[i].name << std::right
+           << " p50 " << std::setw(9) << p50 / 1e6
+           << " p99 " << std::setw(9) << p99 / 1e6
+           << " max " << std::setw(9) << max / 1e6;
+        logger.info() << ss.str();
+
+        auto& entry = subsystems.object(SUBSYSTEMS[i].name);
+        entry["p50_ns"] = p50;
+        entry["p99_ns"] = p99;
+        entry["max_ns"] = max;
+    }
+    logger.info() << "peak RSS: " << peakMemory / (1024 * 1024) << " MiB";
+    logger.info() << "Lua peak heap: " << gcMetrics.maxMemory / (1024 * 1024)
+                  << " MiB, GC cycles: " << gcMetrics.cycles;
+
+    if (file.empty()) {
+        return;
+    }
+    std::ofstream stream(file);
+    stream << json::stringify(root, true) << std::endl;
+    if (stream) {
+        logger.info() << "report written to " << file.u8string();
+    } else {
+        logger.error() << "could not write report " << file.u8string();
+    }
+}
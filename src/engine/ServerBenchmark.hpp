@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+class Player;
+class LevelController;
+
+/// @brief Deterministic headless benchmark: simulated players fly along
+/// fixed paths loading chunks while per-tick subsystems durations are
+/// collected with the profiler
+class ServerBenchmark {
+public:
+    /// @brief Measured subsystems (zones are listed in ServerBenchmark.cpp)
+    enum Subsystem {
+        TICK,
+        CHUNKS,
+        GENERATION,
+        LIGHTING,
+        BLOCKS,
+        ENTITIES,
+        PATHFINDING,
+        SCRIPTS,
+        GC,
+        SUBSYSTEMS_COUNT
+    };
+private:
+    LevelController& controller;
+    std::vector<Player*> players;
+    int ticks;
+    int tick = 0;
+    int64_t tickStart = 0;
+    /// @brief Per-tick durations (nanoseconds) of each subsystem
+    std::array<std::vector<int64_t>, SUBSYSTEMS_COUNT> samples;
+
+    void movePlayers(double time);
+public:
+    /// @param controller level controller with loaded world
+    /// @param playersCount number of simulated players to create
+    /// @param ticks number of ticks to perform
+    ServerBenchmark(LevelController& controller, int playersCount, int ticks);
+    ~ServerBenchmark();
+
+    /// @param time world time since benchmark start in seconds
+    void beginTick(double time);
+    void endTick();
+
+    bool isFinished() const {
+        return tick >= ticks;
+    }
+
+    /// @brief Log results and write JSON report if file is not empty
+    void report(const std::filesystem::path& file) const;
+};
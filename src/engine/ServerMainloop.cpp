@@ -1,19 +1,116 @@
 #include "ServerMainloop.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
 #include "Engine.hpp"
+#include "ServerBenchmark.hpp"
 #include "logic/scripting/scripting.hpp"
 #include "logic/LevelController.hpp"
+#include "logic/EngineController.hpp"
+#include "logic/ChunksController.hpp"
 #include "interfaces/Process.hpp"
 #include "debug/Logger.hpp"
+#include "debug/Memory.hpp"
+#include "debug/Metrics.hpp"
+#include "debug/Profiler.hpp"
+#include "devtools/InputJournal.hpp"
+#include "devtools/MetricsServer.hpp"
+#include "devtools/stdin_cmd_reader.hpp"
+#include "network/Network.hpp"
+#include "objects/Entities.hpp"
+#include "objects/Players.hpp"
+#include "voxels/GlobalChunks.hpp"
+#include "world/files/WorldRegions.hpp"
 #include "world/Level.hpp"
 #include "world/World.hpp"
-#include "util/platform.hpp"
+#include "util/stringutil.hpp"
 
-#include <chrono>
+static debug::Logger logger("mainloop");
 
-using namespace std::chrono;
+/// @brief Max number of overrun ticks compensated in a row
+inline constexpr int MAX_CATCH_UP_TICKS = 5;
 
-static debug::Logger logger("mainloop");
+/// @brief Tick work time histogram buckets upper bounds (seconds)
+static const std::vector<double> TICK_DURATION_BUCKETS {
+    0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0
+};
+
+static const char* CHUNK_STAGE_NAMES[] {
+    "requested", "io", "generation", "lighting"
+};
+static_assert(
+    std::size(CHUNK_STAGE_NAMES) == static_cast<size_t>(ChunkStage::COUNT)
+);
+
+/// @brief Number of the slowest replayed ticks reported
+inline constexpr size_t REPLAY_REPORTED_TICKS = 5;
+/// @brief Number of the heaviest profiler zones reported per slow tick
+inline constexpr size_t REPLAY_REPORTED_ZONES = 3;
+
+namespace {
+    struct SlowTick {
+        uint64_t tick;
+        /// @brief Nanoseconds
+        int64_t duration;
+        std::vector<debug::ProfilerZoneStats> zones;
+    };
+}
+
+/// @brief Keep the tick if it's one of the slowest (sorted descending)
+static void add_slow_tick(
+    std::vector<SlowTick>& slowTicks, uint64_t tick, int64_t duration
+) {
+    if (slowTicks.size() == REPLAY_REPORTED_TICKS &&
+        slowTicks.back().duration >= duration) {
+        return;
+    }
+    auto zones = debug::profiler::get_stats(duration);
+    if (zones.size() > REPLAY_REPORTED_ZONES) {
+        zones.resize(REPLAY_REPORTED_ZONES);
+    }
+    auto pos = std::find_if(
+        slowTicks.begin(),
+        slowTicks.end(),
+        [duration](const auto& slow) { return slow.duration < duration; }
+    );
+    slowTicks.insert(pos, {tick, duration, std::move(zones)});
+    if (slowTicks.size() > REPLAY_REPORTED_TICKS) {
+        slowTicks.pop_back();
+    }
+}
+
+static void report_replay(
+    const std::vector<SlowTick>& slowTicks, const std::filesystem::path& trace
+) {
+    for (const auto& slow : slowTicks) {
+        auto message = logger.info();
+        message << "slow tick " << slow.tick << ": "
+                << slow.duration / 1e6 << " ms";
+        for (const auto& zone : slow.zones) {
+            message << "\n  " << zone.name << " " << zone.total / 1e6
+                    << " ms (" << zone.calls << " calls)";
+        }
+    }
+    if (trace.empty()) {
+        return;
+    }
+    std::ofstream stream(trace);
+    stream << debug::profiler::to_chrome_trace();
+    if (stream) {
+        logger.info() << "replay trace written to " << trace.u8string();
+    } else {
+        logger.error() << "could not write replay trace " << trace.u8string();
+    }
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point point) {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now() - point).count();
+}
 
 ServerMainloop::ServerMainloop(Engine& engine) : engine(engine) {
 }
@@ -24,6 +121,11 @@ void ServerMainloop::run() {
     const auto& coreParams = engine.getCoreParameters();
     auto& time = engine.getTime();
 
+    engine.finishStartup();
+    if (!coreParams.benchmarkWorld.empty()) {
+        runBenchmark();
+        return;
+    }
     if (coreParams.scriptFile.empty()) {
         logger.info() << "nothing to do";
         return;
@@ -36,46 +138,250 @@ void ServerMainloop::run() {
         "script:" + coreParams.scriptFile.filename().u8string()
     );
 
-    double targetDelta = 1.0 / static_cast<double>(coreParams.tps);
-    double delta = targetDelta;
-    auto begin = system_clock::now();
-    auto startupTime = begin;
+    auto network = engine.getNetwork();
+    if (coreParams.metricsPort > 0 && network) {
+        tickDurations = std::make_unique<debug::Histogram>(
+            TICK_DURATION_BUCKETS
+        );
+        try {
+            metricsServer = std::make_unique<devtools::MetricsServer>(
+                *network,
+                coreParams.metricsPort,
+                [this]() { return collectMetrics(); }
+            );
+        } catch (const std::runtime_error& err) {
+            logger.error() << "could not start metrics server: " << err.what();
+        }
+    }
+
+    auto journal = engine.getInputJournal();
+    bool replaying = journal && journal->isReplaying();
+    std::vector<SlowTick> slowTicks;
+    if (replaying) {
+        debug::profiler::clear();
+        debug::profiler::set_enabled(true);
+    }
+
+    TickScheduler scheduler(
+        replaying ? journal->getTps() : coreParams.tps, MAX_CATCH_UP_TICKS
+    );
+    double delta = scheduler.getInterval();
+    scheduler.start();
 
     while (process->isActive()) {
+        auto tickStart = std::chrono::steady_clock::now();
+        int64_t profilerTickStart = debug::profiler::now();
+        if (replaying && journal->isFinished()) {
+            process->terminate();
+            logger.info() << "replay finished at tick " << journal->getTick();
+            break;
+        }
         if (engine.isQuitSignal()) {
             process->terminate();
             logger.info() << "script has been terminated due to quit signal";
             break;
         }
-        if (coreParams.testMode) {
-            time.step(delta);
-        } else {
-            auto now = system_clock::now();
-            time.update(
-                duration_cast<microseconds>(now - startupTime).count() / 1e6);
-            delta = time.getDelta();
-        }
+        time.step(delta);
         process->update();
         if (controller) {
             controller->getLevel()->getWorld()->updateTimers(delta);
             controller->update(glm::min(delta, 0.2), false);
         }
         engine.applicationTick();
+        if (metricsServer) {
+            metricsServer->update();
+        }
         engine.postUpdate();
-
-        if (!coreParams.testMode) {
-            auto end = system_clock::now();
-            int64_t millis = targetDelta * 1000 - 
-                duration_cast<microseconds>(end - begin).count() / 1000;
-            if (millis > 0) {
-                platform::sleep(millis);
+        if (replaying) {
+            for (const auto& command : journal->takeCommands()) {
+                cmd::execute_command(engine, command);
             }
-            begin = system_clock::now();
+        }
+        scripting::step_gc(delta - seconds_since(tickStart));
+        if (tickDurations) {
+            tickDurations->observe(seconds_since(tickStart));
+        }
+        if (replaying) {
+            add_slow_tick(
+                slowTicks,
+                journal->getTick(),
+                debug::profiler::now() - profilerTickStart
+            );
+        }
+        if (journal) {
+            journal->nextTick();
+        }
+
+        // replay runs without waiting, like the test mode
+        if (!coreParams.testMode && !replaying) {
+            scheduler.waitNextTick();
+            engine.getTickMetrics() = scheduler.getMetrics();
         }
     }
+    const auto& metrics = scheduler.getMetrics();
+    if (metrics.catchUpTicks || metrics.skippedTicks) {
+        logger.info() << "late ticks: " << metrics.catchUpTicks
+                      << ", skipped ticks: " << metrics.skippedTicks
+                      << ", max lag: " << metrics.maxLag * 1000.0 << " ms";
+    }
+    if (replaying) {
+        debug::profiler::set_enabled(false);
+        report_replay(slowTicks, coreParams.replayTrace);
+    }
+    metricsServer.reset();
     logger.info() << "script finished";
 }
 
+std::string ServerMainloop::collectMetrics() {
+    debug::MetricsWriter writer;
+
+    const auto& tickMetrics = engine.getTickMetrics();
+    writer.histogram(
+        "voxelcore_tick_duration_seconds",
+        "Server tick work time",
+        *tickDurations
+    );
+    writer.counter(
+        "voxelcore_ticks_total", "Performed ticks", tickMetrics.ticks
+    );
+    writer.counter(
+        "voxelcore_ticks_late_total",
+        "Ticks started late to catch up the schedule",
+        tickMetrics.catchUpTicks
+    );
+    writer.counter(
+        "voxelcore_ticks_skipped_total",
+        "Ticks dropped over the catch-up limit",
+        tickMetrics.skippedTicks
+    );
+    writer.gauge(
+        "voxelcore_tick_lag_seconds",
+        "Average tick start delay",
+        tickMetrics.averageLag
+    );
+
+    if (controller) {
+        const auto& level = *controller->getLevel();
+        writer.gauge(
+            "voxelcore_chunks_loaded", "Loaded chunks", level.chunks->size()
+        );
+        writer.gauge("voxelcore_entities", "Entities", level.entities->size());
+        writer.gauge("voxelcore_players", "Players", level.players->size());
+
+        if (auto chunksController = controller->getChunksController()) {
+            const auto& stats = chunksController->getStats();
+            for (size_t i = 0; i < stats.size(); i++) {
+                writer.gauge(
+                    "voxelcore_chunk_stage_queue",
+                    "Chunks in the loading pipeline stage",
+                    stats[i].count,
+                    {{"stage", CHUNK_STAGE_NAMES[i]}}
+                );
+            }
+            for (size_t i = 0; i < stats.size(); i++) {
+                writer.counter(
+                    "voxelcore_chunk_stage_passed_total",
+                    "Chunks passed the loading pipeline stage",
+                    stats[i].passed,
+                    {{"stage", CHUNK_STAGE_NAMES[i]}}
+                );
+            }
+        }
+    }
+
+    auto usage = debug::memory::collect();
+    for (size_t i = 0; i < usage.size(); i++) {
+        writer.gauge(
+            "voxelcore_memory_bytes",
+            "Memory used by the engine subsystem",
+            usage[i],
+            {{"tag",
+              std::string(debug::memory::tag_name(
+                  static_cast<debug::MemoryTag>(i)
+              ))}}
+        );
+    }
+
+    if (auto network = engine.getNetwork()) {
+        writer.counter(
+            "voxelcore_network_sent_bytes_total",
+            "Bytes sent by connections and requests",
+            network->getTotalUpload()
+        );
+        writer.counter(
+            "voxelcore_network_received_bytes_total",
+            "Bytes received by connections and requests",
+            network->getTotalDownload()
+        );
+        writer.gauge(
+            "voxelcore_network_connections",
+            "Open connections",
+            network->countConnections()
+        );
+    }
+
+    auto regionsIO = WorldRegions::getIOStats();
+    writer.counter(
+        "voxelcore_region_read_chunks_total",
+        "Chunk records read from region files",
+        regionsIO.readChunks
+    );
+    writer.counter(
+        "voxelcore_region_read_bytes_total",
+        "Bytes read from region files",
+        regionsIO.readBytes
+    );
+    writer.counter(
+        "voxelcore_region_written_chunks_total",
+        "Chunk records written to region files",
+        regionsIO.writtenChunks
+    );
+    writer.counter(
+        "voxelcore_region_written_bytes_total",
+        "Bytes written to region files",
+        regionsIO.writtenBytes
+    );
+    return writer.build();
+}
+
+void ServerMainloop::runBenchmark() {
+    const auto& coreParams = engine.getCoreParameters();
+    auto& time = engine.getTime();
+
+    engine.setLevelConsumer([this](auto level, auto) {
+        setLevel(std::move(level));
+    });
+    engine.getController()->openWorld(coreParams.benchmarkWorld, true);
+    if (controller == nullptr) {
+        logger.error() << "could not open world "
+                       << util::quote(coreParams.benchmarkWorld);
+        return;
+    }
+    double delta = 1.0 / static_cast<double>(coreParams.tps);
+    double startTime = time.getTime();
+    {
+        ServerBenchmark benchmark(
+            *controller, coreParams.benchmarkPlayers, coreParams.benchmarkTicks
+        );
+        while (!benchmark.isFinished() && !engine.isQuitSignal()) {
+            auto tickStart = std::chrono::steady_clock::now();
+            time.step(delta);
+            benchmark.beginTick(time.getTime() - startTime);
+
+            controller->getLevel()->getWorld()->updateTimers(delta);
+            controller->update(delta, false);
+            engine.applicationTick();
+            engine.postUpdate();
+            scripting::step_gc(delta - seconds_since(tickStart));
+
+            benchmark.endTick();
+        }
+        benchmark.report(coreParams.benchmarkReport);
+    }
+    // world is not saved to keep the benchmark repeatable
+    setLevel(nullptr);
+}
+
 void ServerMainloop::setLevel(std::unique_ptr<Level> level) {
     if (level == nullptr) {
         controller->onWorldQuit();
@@ -1,14 +1,32 @@
 #pragma once
 
 #include <memory>
+#include <string>
 
 class Level;
 class LevelController;
 class Engine;
 
+namespace debug {
+    class Histogram;
+}
+
+namespace devtools {
+    class MetricsServer;
+}
+
 class ServerMainloop {
     Engine& engine;
     std::unique_ptr<LevelController> controller;
+    std::unique_ptr<devtools::MetricsServer> metricsServer;
+    /// @brief Ticks work time (seconds) exported by the metrics server
+    std::unique_ptr<debug::Histogram> tickDurations;
+
+    /// @brief Run fixed number of ticks in the benchmark world
+    void runBenchmark();
+
+    /// @brief Write current server state metrics in Prometheus format
+    std::string collectMetrics();
 public:
     ServerMainloop(Engine& engine);
     ~ServerMainloop();
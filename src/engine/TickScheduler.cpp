@@ -0,0 +1,69 @@
+#include "TickScheduler.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#include "util/platform.hpp"
+
+using namespace std::chrono;
+
+/// @brief Part of the wait performed by yielding instead of sleeping
+/// (sleep precision is limited by system timer resolution)
+inline constexpr auto SPIN_MARGIN = milliseconds(2);
+inline constexpr double LAG_SMOOTHING = 0.05;
+
+template <class Clock>
+static void wait_until(const typename Clock::time_point& time) {
+    auto remaining = time - Clock::now();
+    if (remaining > SPIN_MARGIN) {
+        platform::sleep(
+            duration_cast<milliseconds>(remaining - SPIN_MARGIN).count()
+        );
+    }
+    while (Clock::now() < time) {
+        std::this_thread::yield();
+    }
+}
+
+TickScheduler::TickScheduler(int tps, int maxCatchUpTicks)
+    : interval(duration_cast<clock::duration>(
+          duration<double>(1.0 / std::max(1, tps))
+      )),
+      maxCatchUpTicks(maxCatchUpTicks) {
+}
+
+void TickScheduler::start() {
+    next = clock::now();
+    catchUpStreak = 0;
+}
+
+void TickScheduler::waitNextTick() {
+    next += interval;
+
+    auto now = clock::now();
+    if (now < next) {
+        wait_until<clock>(next);
+        catchUpStreak = 0;
+        now = clock::now();
+    } else if (now - next >= interval) {
+        // behind the schedule by a whole tick or more
+        if (catchUpStreak >= maxCatchUpTicks) {
+            auto skipped = (now - next) / interval;
+            metrics.skippedTicks += skipped;
+            next += skipped * interval;
+            catchUpStreak = 0;
+        } else {
+            catchUpStreak++;
+            metrics.catchUpTicks++;
+        }
+    }
+    double lag = duration<double>(now - next).count();
+    metrics.ticks++;
+    metrics.lag = lag;
+    metrics.maxLag = std::max(metrics.maxLag, lag);
+    metrics.averageLag += (lag - metrics.averageLag) * LAG_SMOOTHING;
+}
+
+double TickScheduler::getInterval() const {
+    return duration<double>(interval).count();
+}
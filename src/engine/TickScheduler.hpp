@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+struct TickMetrics {
+    /// @brief Number of performed ticks
+    uint64_t ticks = 0;
+    /// @brief Ticks started late without waiting to catch up the schedule
+    uint64_t catchUpTicks = 0;
+    /// @brief Ticks dropped when catch-up limit was exceeded
+    uint64_t skippedTicks = 0;
+    /// @brief Delay of the last tick start after its scheduled time (seconds)
+    double lag = 0.0;
+    /// @brief Max tick start delay (seconds)
+    double maxLag = 0.0;
+    /// @brief Exponential moving average of tick start delay (seconds)
+    double averageLag = 0.0;
+};
+
+/// @brief Fixed timestep ticks scheduler. Waits with sub-millisecond
+/// precision, ticks overrun are compensated by performing the following
+/// ticks without wait, but no more than maxCatchUpTicks in a row
+class TickScheduler {
+    using clock = std::chrono::steady_clock;
+
+    clock::duration interval;
+    clock::time_point next;
+    int maxCatchUpTicks;
+    int catchUpStreak = 0;
+    TickMetrics metrics {};
+public:
+    /// @param tps target ticks per second
+    /// @param maxCatchUpTicks max number of late ticks performed in a row
+    /// before the schedule is reset
+    TickScheduler(int tps, int maxCatchUpTicks);
+
+    /// @brief Schedule the first tick to the current time
+    void start();
+
+    /// @brief Wait for the next tick scheduled time
+    void waitNextTick();
+
+    /// @return tick interval in seconds
+    double getInterval() const;
+
+    const TickMetrics& getMetrics() const {
+        return metrics;
+    }
+};
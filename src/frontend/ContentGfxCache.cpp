@@ -15,6 +15,50 @@
 
 static debug::Logger logger("content-gfx-cache");
 
+/// @brief Transform model for the block coordinate system and precompute
+/// triangles culling and lighting data
+static RotatedModel rotate_model(
+    const model::Model& model, const CoordSystem& orient
+) {
+    glm::vec3 X = orient.axes[0];
+    glm::vec3 Y = orient.axes[1];
+    glm::vec3 Z = orient.axes[2];
+    auto rotate = [&](const glm::vec3& v) {
+        return v.x * X + v.y * Y + v.z * Z;
+    };
+    const float eps = 0.05f;
+    RotatedModel rotated;
+    for (const auto& mesh : model.meshes) {
+        RotatedMesh& dst = rotated.emplace_back();
+        dst.shading = mesh.shading;
+        int trianglesCount = mesh.vertices.size() / 3;
+        dst.triangles.reserve(trianglesCount);
+        for (int triangle = 0; triangle < trianglesCount; triangle++) {
+            const auto* vertices = &mesh.vertices[triangle * 3];
+            auto r = glm::normalize(rotate(
+                vertices[(triangle % 2) * 2].coord - vertices[1].coord
+            ));
+            auto n = rotate(vertices[0].normal);
+            auto t = glm::cross(r, n);
+            auto vp = (vertices[0].coord + vertices[1].coord +
+                       vertices[2].coord) * 0.3333f - 0.5f;
+
+            RotatedTriangle& tri = dst.triangles.emplace_back();
+            tri.normal = n;
+            tri.right = glm::ivec3(r);
+            tri.up = glm::ivec3(t);
+            tri.facing = rotate(vp) + 0.5f + n * 1e-3f;
+            for (int i = 0; i < 3; i++) {
+                auto position = rotate(vertices[i].coord - 0.5f);
+                auto p = position + r * 0.5f + t * 0.5f + n * eps;
+                tri.vertices[i] = RotatedTriangle::Vertex {
+                    position, vertices[i].uv, p + n * eps, p + n * 0.5f};
+            }
+        }
+    }
+    return rotated;
+}
+
 ContentGfxCache::ContentGfxCache(
     const Content& content,
     const Assets& assets,
@@ -62,6 +106,17 @@ void ContentGfxCache::refreshVariant(
                 }
             }
         }
+        auto& rotated = rotatedModels[modelKey(def.rt.id, variantIndex)];
+        rotated.clear();
+        if (def.rotatable) {
+            for (const auto& orient : def.rotations.variants) {
+                rotated.push_back(rotate_model(model, orient));
+            }
+        } else {
+            rotated.push_back(rotate_model(
+                model, CoordSystem({1, 0, 0}, {0, 1, 0}, {0, 0, 1})
+            ));
+        }
         models[modelKey(def.rt.id, variantIndex)] = std::move(model);
     }
 }
@@ -101,3 +156,14 @@ const model::Model& ContentGfxCache::getModel(blockid_t id, uint8_t variant) con
     }
     return found->second;
 }
+
+const RotatedModel& ContentGfxCache::getRotatedModel(
+    blockid_t id, uint8_t variant, uint8_t rotation
+) const {
+    const auto& found = rotatedModels.find(modelKey(id, variant));
+    if (found == rotatedModels.end()) {
+        throw std::runtime_error("model not found");
+    }
+    const auto& rotations = found->second;
+    return rotations[rotation < rotations.size() ? rotation : 0];
+}
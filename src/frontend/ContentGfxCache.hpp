@@ -2,9 +2,11 @@
 
 #include "typedefs.hpp"
 
+#include <array>
 #include <memory>
 #include <stdexcept>
 #include <unordered_map>
+#include <vector>
 
 #include "maths/UVRegion.hpp"
 #include "graphics/commons/Model.hpp"
@@ -20,6 +22,34 @@ struct GraphicsSettings;
 inline constexpr int GFXC_MAX_VARIANTS = 16;
 inline constexpr int GFXC_SIDES = 6;
 
+/// @brief Custom model triangle transformed for a block rotation
+struct RotatedTriangle {
+    struct Vertex {
+        /// @brief Position relative to the block
+        glm::vec3 position;
+        glm::vec2 uv;
+        /// @brief Soft light sampling points relative to the block
+        glm::vec3 lightNear;
+        glm::vec3 lightFar;
+    };
+    std::array<Vertex, 3> vertices;
+    glm::vec3 normal;
+    /// @brief Soft light sampling axes
+    glm::ivec3 right;
+    glm::ivec3 up;
+    /// @brief Point relative to the block inside of the voxel the
+    /// triangle faces (used for culling)
+    glm::vec3 facing;
+};
+
+struct RotatedMesh {
+    std::vector<RotatedTriangle> triangles;
+    bool shading;
+};
+
+/// @brief Custom model meshes transformed for a block rotation
+using RotatedModel = std::vector<RotatedMesh>;
+
 class ContentGfxCache {
     const Content& content;
     const Assets& assets;
@@ -28,6 +58,9 @@ class ContentGfxCache {
     // array of block sides uv regions (6 per block)
     std::unique_ptr<UVRegion[]> sideregions;
     std::unordered_map<uint64_t, model::Model> models;
+    /// @brief Custom models by block rotation index (single model if the
+    /// block is not rotatable)
+    std::unordered_map<uint64_t, std::vector<RotatedModel>> rotatedModels;
     
     static inline uint64_t modelKey(blockid_t id, uint8_t variant) {
         return (uint64_t(id) << 8) | uint64_t(variant & 0xFF);
@@ -59,6 +92,11 @@ public:
 
     const model::Model& getModel(blockid_t id, uint8_t variant) const;
 
+    /// @brief Get custom model transformed for the block rotation
+    const RotatedModel& getRotatedModel(
+        blockid_t id, uint8_t variant, uint8_t rotation
+    ) const;
+
     void refresh(const Block& block, const Atlas& atlas);
 
     void refresh();
@@ -64,7 +64,7 @@ std::unique_ptr<UiDocument> UiDocument::read(
     const std::string& fileName
 ) {
     const std::string text = io::read_string(file);
-    auto xmldoc = xml::parse(file.string(), text);
+    auto xmldoc = gui::parse_xml_cached(file.string(), text);
 
     auto env = penv == nullptr 
         ? scripting::create_doc_environment(scripting::get_root_environment(), name)
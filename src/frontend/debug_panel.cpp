@@ -1,6 +1,9 @@
 #include "audio/audio.hpp"
 #include "constants.hpp"
 #include "content/Content.hpp"
+#include "debug/Allocations.hpp"
+#include "debug/Memory.hpp"
+#include "debug/Profiler.hpp"
 #include "delegates.hpp"
 #include "engine/Engine.hpp"
 #include "graphics/core/Mesh.hpp"
@@ -14,7 +17,10 @@
 #include "graphics/ui/elements/TextBox.hpp"
 #include "graphics/ui/elements/TrackBar.hpp"
 #include "hud.hpp"
+#include "logic/ChunksController.hpp"
 #include "logic/scripting/scripting.hpp"
+#include "logic/scripting/lua/lua_engine.hpp"
+#include "logic/scripting/lua/lua_profiler.hpp"
 #include "network/Network.hpp"
 #include "objects/Entities.hpp"
 #include "objects/Entity.hpp"
@@ -30,6 +36,7 @@
 #include "voxels/GlobalChunks.hpp"
 #include "world/Level.hpp"
 #include "world/World.hpp"
+#include "world/files/WorldFiles.hpp"
 
 #include <bitset>
 #include <memory>
@@ -55,7 +62,11 @@ static bool should_keep_previous(GUI& gui) {
 // TODO: move to xml finally
 // TODO: move to xml finally
 std::shared_ptr<UINode> create_debug_panel(
-    Engine& engine, Level& level, Player& player, bool allowDebugCheats
+    Engine& engine,
+    Level& level,
+    const ChunksController& chunksController,
+    Player& player,
+    bool allowDebugCheats
 ) {
     auto network = engine.getNetwork();
     auto& gui = engine.getGUI();
@@ -82,6 +93,7 @@ std::shared_ptr<UINode> create_debug_panel(
     static size_t lastTotalDownload = 0;
     static size_t lastTotalUpload = 0;
     static std::wstring netSpeedString = L"";
+    static std::wstring netStatsString = L"";
 
     panel->listenInterval(0.016f, [&engine]() {
         double delta = engine.getTime().getDelta();
@@ -133,6 +145,14 @@ std::shared_ptr<UINode> create_debug_panel(
                 std::to_wstring(totalUpload - lastTotalUpload) + L" B/s";
             lastTotalDownload = totalDownload;
             lastTotalUpload = totalUpload;
+
+            auto stats = network->getStats();
+            netStatsString =
+                L"connections: " +
+                std::to_wstring(network->countConnections()) +
+                L" max-rtt: " + std::to_wstring(stats.rtt / 1000) +
+                L" ms queued: " + std::to_wstring(stats.sendQueue) +
+                L" B drops: " + std::to_wstring(stats.drops);
         });
     }
 
@@ -159,8 +179,18 @@ std::shared_ptr<UINode> create_debug_panel(
         return L"lua-stack: " +
                std::to_wstring(scripting::get_values_on_stack());
     }));
+    panel->add(create_label(gui, []() {
+        const auto& metrics = lua::get_gc_metrics();
+        return L"lua-heap: " +
+               std::to_wstring(metrics.memory / (1024 * 1024)) + L"MB live: " +
+               std::to_wstring(metrics.liveMemory / (1024 * 1024)) +
+               L"MB gc: " + util::to_wstring(metrics.lastTime * 1000, 2) +
+               L"ms max: " + util::to_wstring(metrics.maxTime * 1000, 2) +
+               L"ms cycles: " + std::to_wstring(metrics.cycles);
+    }));
     if (network) {
         panel->add(create_label(gui, []() { return netSpeedString; }));
+        panel->add(create_label(gui, []() { return netStatsString; }));
     }
     panel->add(create_label(gui, [&engine]() {
         auto& settings = engine.getSettings();
@@ -175,10 +205,84 @@ std::shared_ptr<UINode> create_debug_panel(
     }));
     panel->add(create_label(gui, [&]() {
         return L"chunks: " + std::to_wstring(level.chunks->size()) +
-               L" visible: " + std::to_wstring(ChunksRenderer::visibleChunks);
+               L" visible: " + std::to_wstring(ChunksRenderer::visibleChunks) +
+               L" packed: " + std::to_wstring(level.chunks->countPacked()) +
+               L" unloaded: " +
+               std::to_wstring(level.chunks->getUnloadedCount());
+    }));
+    panel->add(create_label(gui, [&chunksController]() {
+        static const wchar_t* names[] {L"req", L"io", L"gen", L"light"};
+        const auto& stats = chunksController.getStats();
+        std::wstringstream ss;
+        ss << L"chunks stages:";
+        for (size_t i = 0; i < stats.size(); i++) {
+            ss << L" " << names[i] << L" " << stats[i].count;
+            if (stats[i].passed) {
+                ss << L"/" << static_cast<int>(stats[i].latency / 1000)
+                   << L"ms";
+            }
+        }
+        return ss.str();
     }));
+    {
+        static std::wstring regionsMemory;
+        panel->listenInterval(1.0f, [&level]() {
+            static const wchar_t* names[] {
+                L"vox", L"light", L"inv", L"ent", L"data", L"proto", L"upd"
+            };
+            auto& regions = level.getWorld()->wfile->getRegions();
+            std::wstringstream ss;
+            ss << L"regions KiB:";
+            for (uint i = 0; i < REGION_LAYERS_COUNT; i++) {
+                ss << L" " << names[i] << L" "
+                   << regions.getMemoryUsage(static_cast<RegionLayerIndex>(i)) /
+                          1024;
+            }
+            regionsMemory = ss.str();
+        });
+        panel->add(create_label(gui, []() { return regionsMemory; }));
+    }
+    {
+        static std::wstring memoryTotal;
+        static std::wstring memoryTags;
+        static std::wstring videoMemory;
+        panel->listenInterval(1.0f, []() {
+            auto usage = debug::memory::collect();
+            size_t total = 0;
+            std::wstringstream ss;
+            for (size_t i = 0; i < usage.size(); i++) {
+                auto tag = static_cast<debug::MemoryTag>(i);
+                ss << (i ? L" " : L"")
+                   << util::str2wstr_utf8(debug::memory::tag_name(tag)) << L" "
+                   << usage[i] / (1024 * 1024);
+                total += usage[i];
+            }
+            memoryTags = ss.str();
+            memoryTotal =
+                L"memory MiB: " + std::to_wstring(total / (1024 * 1024));
+            if (size_t budget = debug::memory::get_budget()) {
+                memoryTotal +=
+                    L" budget: " + std::to_wstring(budget / (1024 * 1024));
+            }
+            videoMemory = L"video memory MiB: " +
+                          std::to_wstring(
+                              debug::memory::video_usage(usage) / (1024 * 1024)
+                          );
+            if (size_t budget = debug::memory::get_video_budget()) {
+                videoMemory +=
+                    L" budget: " + std::to_wstring(budget / (1024 * 1024)) +
+                    L" pressure: " +
+                    std::to_wstring(debug::memory::get_video_pressure());
+            }
+        });
+        panel->add(create_label(gui, []() { return memoryTotal; }));
+        panel->add(create_label(gui, []() { return videoMemory; }));
+        panel->add(create_label(gui, []() { return memoryTags; }));
+    }
     panel->add(create_label(gui, [&]() {
         return L"entities: " + std::to_wstring(level.entities->size()) +
+               L" pending: " +
+               std::to_wstring(level.entities->getPendingCount()) +
                L" next: " + std::to_wstring(level.entities->peekNextID());
     }));
     panel->add(create_label(gui, [&]() {
@@ -360,6 +464,105 @@ std::shared_ptr<UINode> create_debug_panel(
         });
         panel->add(checkbox);
     }
+    {
+        auto checkbox = std::make_shared<FullCheckBox>(
+            gui, L"Profiler", glm::vec2(400, 24)
+        );
+        checkbox->setSupplier([=]() { return debug::profiler::is_enabled(); });
+        checkbox->setConsumer([=](bool checked) {
+            debug::profiler::set_enabled(checked);
+        });
+        panel->add(checkbox);
+    }
+    static constexpr int PROFILER_ZONES_SHOWN = 6;
+    static std::wstring profilerZones[PROFILER_ZONES_SHOWN];
+
+    panel->listenInterval(1.0f, []() {
+        auto stats = debug::profiler::is_enabled()
+                         ? debug::profiler::get_stats(1'000'000'000)
+                         : std::vector<debug::ProfilerZoneStats> {};
+        for (int i = 0; i < PROFILER_ZONES_SHOWN; i++) {
+            if (static_cast<size_t>(i) >= stats.size()) {
+                profilerZones[i].clear();
+                continue;
+            }
+            const auto& zone = stats[i];
+            profilerZones[i] =
+                util::str2wstr_utf8(std::string(zone.name)) + L": " +
+                util::to_wstring(zone.total / 1e6, 2) + L"ms max: " +
+                util::to_wstring(zone.max / 1e6, 2) + L"ms x" +
+                std::to_wstring(zone.calls);
+            if (debug::allocations::is_available()) {
+                profilerZones[i] +=
+                    L" allocs: " + std::to_wstring(zone.allocations);
+            }
+        }
+    });
+    for (int i = 0; i < PROFILER_ZONES_SHOWN; i++) {
+        panel->add(create_label(gui, [i]() { return profilerZones[i]; }));
+    }
+    if (debug::allocations::is_available()) {
+        panel->add(create_label(gui, []() {
+            auto frame = debug::allocations::get_last_frame();
+            auto tick = debug::allocations::get_last_tick();
+            return L"allocs frame: " + std::to_wstring(frame.allocations) +
+                   L" (" + std::to_wstring(frame.bytes / 1024) +
+                   L"KB) tick: " + std::to_wstring(tick.allocations) + L" (" +
+                   std::to_wstring(tick.bytes / 1024) + L"KB)";
+        }));
+    }
+    static constexpr int GPU_PASSES_SHOWN = 8;
+    static std::wstring gpuPasses[GPU_PASSES_SHOWN];
+
+    panel->listenInterval(1.0f, []() {
+        const auto& timings = WorldRenderer::gpuPassTimings;
+        for (int i = 0; i < GPU_PASSES_SHOWN; i++) {
+            if (static_cast<size_t>(i) >= timings.size()) {
+                gpuPasses[i].clear();
+                continue;
+            }
+            const auto& pass = timings[i];
+            gpuPasses[i] = L"gpu " + util::str2wstr_utf8(pass.name) + L": " +
+                           util::to_wstring(pass.gpuMillis, 2) + L"ms";
+        }
+    });
+    for (int i = 0; i < GPU_PASSES_SHOWN; i++) {
+        panel->add(create_label(gui, [i]() { return gpuPasses[i]; }));
+    }
+    {
+        auto checkbox = std::make_shared<FullCheckBox>(
+            gui, L"Scripts Profiler", glm::vec2(400, 24)
+        );
+        checkbox->setSupplier([=]() { return lua::profiler::is_enabled(); });
+        checkbox->setConsumer([=](bool checked) {
+            lua::profiler::set_enabled(checked);
+        });
+        panel->add(checkbox);
+    }
+    static constexpr int PROFILER_PACKS_SHOWN = 4;
+    static std::wstring profilerPacks[PROFILER_PACKS_SHOWN];
+
+    panel->listenInterval(1.0f, []() {
+        auto stats = lua::profiler::is_enabled()
+                         ? lua::profiler::get_stats()
+                         : std::vector<lua::ScriptsPackStats> {};
+        for (int i = 0; i < PROFILER_PACKS_SHOWN; i++) {
+            if (static_cast<size_t>(i) >= stats.size()) {
+                profilerPacks[i].clear();
+                continue;
+            }
+            const auto& pack = stats[i];
+            profilerPacks[i] =
+                util::str2wstr_utf8(pack.packid) + L": " +
+                util::to_wstring(pack.total / 1e6, 2) + L"ms x" +
+                std::to_wstring(pack.calls) + L" alloc: " +
+                std::to_wstring(pack.allocated / 1024) + L"KB samples: " +
+                std::to_wstring(pack.samples);
+        }
+    });
+    for (int i = 0; i < PROFILER_PACKS_SHOWN; i++) {
+        panel->add(create_label(gui, [i]() { return profilerPacks[i]; }));
+    }
     panel->refresh();
     return panel;
 }
@@ -62,6 +62,7 @@ bool Hud::showGeneratorMinimap = false;
 std::shared_ptr<UINode> create_debug_panel(
     Engine& engine,
     Level& level,
+    const ChunksController& chunksController,
     Player& player,
     bool allowDebugCheats
 );
@@ -182,7 +183,11 @@ Hud::Hud(Engine& engine, LevelFrontend& frontend, Player& player)
     uicamera->far = 1.0f;
 
     debugPanel = create_debug_panel(
-        engine, frontend.getLevel(), player, allowDebugCheats
+        engine,
+        frontend.getLevel(),
+        *frontend.getController()->getChunksController(),
+        player,
+        allowDebugCheats
     );
     debugPanel->setZIndex(2);
 
@@ -341,8 +346,8 @@ void Hud::update(bool visible) {
     }
 
     if (blockUI) {
-        voxel* vox = chunks.get(blockPos.x, blockPos.y, blockPos.z);
-        if (vox == nullptr || vox->id != currentblockid) {
+        auto vox = chunks.getVoxel(blockPos.x, blockPos.y, blockPos.z);
+        if (!vox || vox->id != currentblockid) {
             closeInventory();
         }
     }
@@ -443,7 +448,6 @@ void Hud::openInventory(
     if (blockinv == nullptr) {
         blockinv = level.inventories->createVirtual(blockUI->getSlotsCount());
     }
-    chunks.getChunkByVoxel(block)->flags.unsaved = true;
     blockUI->bind(blockinv, &content);
     blockPos = block;
     currentblockid = chunks.require(block.x, block.y, block.z).id;
@@ -738,7 +742,11 @@ void Hud::setDebugCheats(bool flag) {
     
     gui.remove(debugPanel);
     debugPanel = create_debug_panel(
-        engine, frontend.getLevel(), player, allowDebugCheats
+        engine,
+        frontend.getLevel(),
+        *frontend.getController()->getChunksController(),
+        player,
+        allowDebugCheats
     );
     debugPanel->setZIndex(2);
     gui.add(debugPanel);
@@ -85,6 +85,7 @@ LevelScreen::LevelScreen(
     };
     keepAlive(settings.graphics.backlight.observe(resetChunks));
     keepAlive(settings.graphics.softLighting.observe(resetChunks));
+    keepAlive(settings.graphics.greedyMeshing.observe(resetChunks));
     keepAlive(settings.graphics.denseRender.observe([=](bool flag) {
         resetChunks(flag);
         frontend->getContentGfxCache().refresh();
@@ -272,6 +273,10 @@ void LevelScreen::draw(float delta) {
         scripting::on_entities_render(engine.getTime().getDelta());
     }
     renderer->update(*camera, delta * !hud->isPause());
+    renderer->updateResolutionScale(delta);
+    postProcessing->setEffectsFusion(
+        engine.getSettings().graphics.postEffectsFusion.get()
+    );
     renderer->renderFrame(ctx, *camera, hudVisible, *postProcessing);
     if (!hud->isPause()) {
         scripting::on_frontend_render();
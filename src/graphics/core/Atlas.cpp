@@ -2,8 +2,11 @@
 
 #include "Texture.hpp"
 #include "ImageData.hpp"
+#include "coders/bcn.hpp"
 #include "maths/LMPacker.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
 Atlas::Atlas(
@@ -22,9 +25,56 @@ Atlas::Atlas(
 Atlas::~Atlas() = default;
 
 void Atlas::prepare() {
+    if (compressed && Texture::isCompressionSupported()) {
+        texture = std::make_shared<Texture>(*compressed);
+        return;
+    }
+    if (!mipmaps.empty()) {
+        std::vector<const ImageData*> levels {image.get()};
+        for (const auto& mipmap : mipmaps) {
+            levels.push_back(mipmap.get());
+        }
+        texture = std::make_shared<Texture>(levels);
+        return;
+    }
     texture = Texture::from(image.get());
 }
 
+void Atlas::generateMipmaps(uint levels, uint extrusion) {
+    mipmaps.clear();
+    if (image->getFormat() != ImageFormat::RGBA8888) {
+        return;
+    }
+    uint width = image->getWidth();
+    uint height = image->getHeight();
+    std::vector<glm::ivec4> rects;
+    rects.reserve(regions.size());
+    for (const auto& [_, region] : regions) {
+        int x = std::round(region.u1 * width);
+        int y = std::round(region.v1 * height);
+        rects.emplace_back(
+            x,
+            y,
+            std::round(region.u2 * width) - x,
+            std::round(region.v2 * height) - y
+        );
+    }
+    for (uint level = 1; level < levels; level++) {
+        if ((width >> level) == 0 || (height >> level) == 0) {
+            break;
+        }
+        mipmaps.push_back(build_atlas_mipmap(*image, rects, level, extrusion));
+    }
+}
+
+void Atlas::setCompressed(std::shared_ptr<bcn::CompressedImage> compressed) {
+    this->compressed = std::move(compressed);
+}
+
+const bcn::CompressedImage* Atlas::getCompressed() const {
+    return compressed.get();
+}
+
 bool Atlas::has(const std::string& name) const {
     return regions.find(name) != regions.end();
 }
@@ -41,6 +91,10 @@ std::optional<UVRegion> Atlas::getIf(const std::string& name) const {
     return found->second;
 }
 
+const std::unordered_map<std::string, UVRegion>& Atlas::getRegions() const {
+    return regions;
+}
+
 Texture* Atlas::getTexture() const {
     return texture.get();
 }
@@ -57,6 +111,70 @@ std::shared_ptr<ImageData> Atlas::shareImageData() const {
     return image;
 }
 
+std::unique_ptr<ImageData> build_atlas_mipmap(
+    const ImageData& image,
+    const std::vector<glm::ivec4>& regions,
+    uint level,
+    uint extrusion
+) {
+    const int size = 1 << level;
+    const int srcWidth = image.getWidth();
+    const int width = std::max(1, srcWidth >> level);
+    const int height = std::max(1, static_cast<int>(image.getHeight()) >> level);
+    auto mipmap = std::make_unique<ImageData>(
+        ImageFormat::RGBA8888, width, height
+    );
+    const ubyte* src = image.getData();
+    ubyte* dst = mipmap->getData();
+
+    // texels with footprint center in [start, end) base pixels
+    auto first = [size](int start) {
+        return static_cast<int>(std::ceil(start / float(size) - 0.5f));
+    };
+    auto fill = [&](const glm::ivec4& region, int padding) {
+        int minX = std::max(0, first(region.x - padding));
+        int minY = std::max(0, first(region.y - padding));
+        int maxX = std::min(width, first(region.x + region.z + padding));
+        int maxY = std::min(height, first(region.y + region.w + padding));
+        for (int ty = minY; ty < maxY; ty++) {
+            for (int tx = minX; tx < maxX; tx++) {
+                int sum[4] {};
+                for (int sy = 0; sy < size; sy++) {
+                    // pixels outside of the region are clamped to its edge
+                    int py = std::clamp(
+                        ty * size + sy, region.y, region.y + region.w - 1
+                    );
+                    for (int sx = 0; sx < size; sx++) {
+                        int px = std::clamp(
+                            tx * size + sx, region.x, region.x + region.z - 1
+                        );
+                        const ubyte* pixel = src + (py * srcWidth + px) * 4;
+                        for (int c = 0; c < 4; c++) {
+                            sum[c] += pixel[c];
+                        }
+                    }
+                }
+                ubyte* texel = dst + (ty * width + tx) * 4;
+                for (int c = 0; c < 4; c++) {
+                    texel[c] = sum[c] / (size * size);
+                }
+            }
+        }
+    };
+    for (const auto& region : regions) {
+        if (region.z > 0 && region.w > 0) {
+            fill(region, extrusion);
+        }
+    }
+    // padding of a region may cover neighbour ones at low resolution
+    for (const auto& region : regions) {
+        if (region.z > 0 && region.w > 0) {
+            fill(region, 0);
+        }
+    }
+    return mipmap;
+}
+
 void AtlasBuilder::add(const std::string& name, std::unique_ptr<ImageData> image) {
     entries.push_back(atlasentry{name, std::shared_ptr<ImageData>(image.release())});
     names.insert(name);
@@ -7,15 +7,25 @@
 #include <optional>
 #include <unordered_map>
 
+#include <glm/glm.hpp>
+
 #include "maths/UVRegion.hpp"
 #include "typedefs.hpp"
 
 class ImageData;
 class Texture;
 
+namespace bcn {
+    struct CompressedImage;
+}
+
 class Atlas {
     std::shared_ptr<Texture> texture;
     std::shared_ptr<ImageData> image;
+    /// @brief Block compressed raster used by prepare() if supported
+    std::shared_ptr<bcn::CompressedImage> compressed;
+    /// @brief Mip levels following the base one used by prepare()
+    std::vector<std::unique_ptr<ImageData>> mipmaps;
     std::unordered_map<std::string, UVRegion> regions;
 public:
     /// @param image atlas raster
@@ -28,12 +38,25 @@ public:
     );
     ~Atlas();
 
+    /// @brief Generate texture. Compressed raster is used if set and
+    /// supported by driver
     void prepare();
 
+    /// @brief Generate mip levels with regions downsampled separately,
+    /// so the texture has no bleeding between regions at distance.
+    /// Texture mipmaps generated by GL are used if not called
+    /// @param levels levels count including the base one
+    void generateMipmaps(uint levels, uint extrusion);
+
+    void setCompressed(std::shared_ptr<bcn::CompressedImage> compressed);
+    const bcn::CompressedImage* getCompressed() const;
+
     bool has(const std::string& name) const;
     const UVRegion& get(const std::string& name) const;
     std::optional<UVRegion> getIf(const std::string& name) const;
 
+    const std::unordered_map<std::string, UVRegion>& getRegions() const;
+
     Texture* getTexture() const;
     ImageData* getImage() const;
 
@@ -41,6 +64,19 @@ public:
     std::shared_ptr<ImageData> shareImageData() const;
 };
 
+/// @brief Build atlas mip level sampling every region from its own pixels
+/// of the base level only
+/// @param image base level (RGBA8888)
+/// @param regions regions in pixels (x, y, width, height)
+/// @param level mip level (>= 1)
+/// @param extrusion pixels around regions filled with their edges
+std::unique_ptr<ImageData> build_atlas_mipmap(
+    const ImageData& image,
+    const std::vector<glm::ivec4>& regions,
+    uint level,
+    uint extrusion
+);
+
 struct atlasentry {
     std::string name;
     std::shared_ptr<ImageData> image;
@@ -1,5 +1,5 @@
 #include "Batch2D.hpp"
-#include "Mesh.hpp"
+#include "StreamMesh.hpp"
 #include "Texture.hpp"
 #include "gl_util.hpp"
 #include "maths/UVRegion.hpp"
@@ -9,7 +9,7 @@
 
 Batch2D::Batch2D(size_t capacity) : capacity(capacity), color(1.0f){
     buffer = std::make_unique<Batch2DVertex[]>(capacity );
-    mesh = std::make_unique<Mesh<Batch2DVertex>>(buffer.get(), 0);
+    mesh = std::make_unique<StreamMesh<Batch2DVertex>>(capacity);
     index = 0;
 
     const ubyte pixels[] = {
@@ -372,8 +372,7 @@ void Batch2D::sprite(
 void Batch2D::flush() {
     if (index == 0)
         return;
-    mesh->reload(buffer.get(), index);
-    mesh->draw(gl::to_glenum(primitive));
+    mesh->draw(buffer.get(), index, gl::to_glenum(primitive));
     index = 0;
 }
 
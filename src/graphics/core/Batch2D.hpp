@@ -8,7 +8,7 @@
 #include "MeshData.hpp"
 
 template<typename VertexStructure>
-class Mesh;
+class StreamMesh;
 class Texture;
 
 struct Batch2DVertex {
@@ -26,7 +26,7 @@ struct Batch2DVertex {
 class Batch2D : public Flushable {
     std::unique_ptr<Batch2DVertex[]> buffer;
     size_t capacity;
-    std::unique_ptr<Mesh<Batch2DVertex>> mesh;
+    std::unique_ptr<StreamMesh<Batch2DVertex>> mesh;
     std::unique_ptr<Texture> blank;
     size_t index;
     glm::vec4 color;
@@ -1,6 +1,6 @@
 #include "Batch3D.hpp"
 
-#include "Mesh.hpp"
+#include "StreamMesh.hpp"
 #include "Texture.hpp"
 
 #include "typedefs.hpp"
@@ -14,7 +14,7 @@ namespace {
 Batch3D::Batch3D(size_t capacity)
     : capacity(capacity) {
     buffer = std::make_unique<Batch3DVertex[]>(capacity);
-    mesh = std::make_unique<Mesh<Batch3DVertex>>(buffer.get(), 0);
+    mesh = std::make_unique<StreamMesh<Batch3DVertex>>(capacity);
     index = 0;
 
     const ubyte pixels[] = {
@@ -292,14 +292,12 @@ void Batch3D::point(const glm::vec3& coord, const glm::vec4& tint) {
 }
 
 void Batch3D::flush() {
-    mesh->reload(buffer.get(), index);
-    mesh->draw();
+    mesh->draw(buffer.get(), index);
     index = 0;
 }
 
 void Batch3D::flushPoints() {
-    mesh->reload(buffer.get(), index);
-    mesh->draw(GL_POINTS);
+    mesh->draw(buffer.get(), index, GL_POINTS);
     index = 0;
 }
 
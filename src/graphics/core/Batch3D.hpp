@@ -9,7 +9,7 @@
 #include <cstdlib>
 #include <glm/glm.hpp>
 
-template<typename VertexStructure> class Mesh;
+template<typename VertexStructure> class StreamMesh;
 
 class Texture;
 struct UVRegion;
@@ -29,7 +29,7 @@ struct Batch3DVertex {
 class Batch3D : public Flushable {
     std::unique_ptr<Batch3DVertex[]> buffer;
     size_t capacity;
-    std::unique_ptr<Mesh<Batch3DVertex>> mesh;
+    std::unique_ptr<StreamMesh<Batch3DVertex>> mesh;
     std::unique_ptr<Texture> blank;
     size_t index;
     glm::vec4 tint {1.0f};
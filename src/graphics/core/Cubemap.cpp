@@ -28,6 +28,7 @@ Cubemap::Cubemap(uint width, uint height, ImageFormat imageFormat)
             nullptr
         );
     }
+    setMemoryUsage(static_cast<size_t>(width) * height * 4 * 6);
 }
 
 void Cubemap::bind() const {
@@ -6,6 +6,7 @@
 #include "Texture.hpp"
 #include "window/Camera.hpp"
 
+#include <algorithm>
 #include <limits>
 #include <utility>
 
@@ -158,52 +159,44 @@ static inline void draw_text(
     if (styles == nullptr) {
         styles = &defStyles;
     }
-    
-    uint page = 0;
-    uint next = MAX_CODEPAGES;
+    const auto& run = font.getRun(text);
+
     float x = 0;
     int y = 0;
-    bool hasLines = false;
-
     float baseAdvance = glm::length(right);
+    float lineHeight = font.getLineHeight();
 
-    do {
-        for (size_t i = 0; i < text.length(); i++) {
-            uint c = text[i];
-            size_t styleIndex = styles->map.at(
-                std::min(styles->map.size() - 1, i + styleMapOffset)
-            );
-            const FontStyle& style = styles->palette.at(styleIndex);
-            hasLines |= style.strikethrough;
-            hasLines |= style.underline;
+    uint page = MAX_CODEPAGES;
+    for (const auto& glyph : run.glyphs) {
+        size_t styleIndex = styles->map.at(
+            std::min(styles->map.size() - 1, glyph.index + styleMapOffset)
+        );
+        const FontStyle& style = styles->palette.at(styleIndex);
 
-            if (!font.isPrintableChar(c)) {
-                x++;
-                continue;
-            }
-            int yOffset = 0;
-            float advance = baseAdvance;
-            if (auto glyph = font.getGlyph(c)) {
-                yOffset = glyph->yOffset;
-                advance = glyph->xAdvance;
-            }
-            uint charpage = c >> 8;
-            if (charpage == page){
-                batch.texture(font.getPage(charpage));
-                draw_glyph(
-                    batch, pos, glm::vec2(x, y - yOffset / static_cast<float>(font.getLineHeight())), c, right, up, interval, style
-                );
-            }
-            else if (charpage > page && charpage < next){
-                next = charpage;
-            }
-            x += advance / baseAdvance;
+        uint charpage = glyph.codepoint >> 8;
+        if (charpage != page) {
+            page = charpage;
+            batch.texture(font.getPage(charpage));
         }
-        page = next;
-        next = MAX_CODEPAGES;
-        x = 0;
-    } while (page < MAX_CODEPAGES);
+        x = glyph.units + glyph.pixels / baseAdvance;
+        draw_glyph(
+            batch,
+            pos,
+            glm::vec2(x, y - glyph.yOffset / lineHeight),
+            glyph.codepoint,
+            right,
+            up,
+            interval,
+            style
+        );
+    }
+    x = 0;
 
+    bool hasLines = false;
+    for (const auto& style : styles->palette) {
+        hasLines |= style.strikethrough;
+        hasLines |= style.underline;
+    }
     if (!hasLines) {
         return;
     }
@@ -279,6 +272,53 @@ void Font::draw(
     );
 }
 
+/// @brief Max number of cached text layouts, the cache is cleared when
+/// exceeded
+inline constexpr size_t MAX_CACHED_RUNS = 4096;
+
+const Font::GlyphsRun& Font::getRun(std::wstring_view text) {
+    size_t hash = std::hash<std::wstring_view>()(text);
+    auto found = runs.find(hash);
+    if (found != runs.end() && found->second.text == text) {
+        return found->second;
+    }
+    if (runs.size() >= MAX_CACHED_RUNS) {
+        runs.clear();
+    }
+    GlyphsRun run {std::wstring(text), {}};
+    float units = 0;
+    float pixels = 0;
+    for (size_t i = 0; i < text.length(); i++) {
+        uint c = text[i];
+        if (!isPrintableChar(c)) {
+            units++;
+            continue;
+        }
+        int yOffset = 0;
+        int advance = -1;
+        if (auto glyph = getGlyph(c)) {
+            yOffset = glyph->yOffset;
+            advance = glyph->xAdvance;
+        }
+        run.glyphs.push_back(GlyphPlacement {
+            static_cast<uint32_t>(i), c, units, pixels, yOffset});
+        if (advance < 0) {
+            // missing glyph takes the base advance
+            units++;
+        } else {
+            pixels += advance;
+        }
+    }
+    std::stable_sort(
+        run.glyphs.begin(),
+        run.glyphs.end(),
+        [](const auto& a, const auto& b) {
+            return (a.codepoint >> 8) < (b.codepoint >> 8);
+        }
+    );
+    return runs[hash] = std::move(run);
+}
+
 std::unique_ptr<Font> Font::createBitmapFont(
     std::vector<std::unique_ptr<ImageData>> pages
 ) {
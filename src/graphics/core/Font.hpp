@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include <unordered_map>
 #include <glm/glm.hpp>
 
 #include "typedefs.hpp"
@@ -90,6 +91,28 @@ public:
     static std::unique_ptr<Font> createBitmapFont(
         std::vector<std::unique_ptr<ImageData>> pages
     );
+    /// @brief Printable glyph placement in a text
+    struct GlyphPlacement {
+        /// @brief Index of the character in the text (style map index)
+        uint32_t index;
+        uint32_t codepoint;
+        /// @brief Advance of non-printable characters before the glyph
+        /// in glyph intervals
+        float units;
+        /// @brief Advance of glyphs before the glyph in pixels
+        float pixels;
+        int yOffset;
+    };
+
+    /// @brief Text layout independent of styles and transform, glyphs
+    /// are ordered by page, so texture is switched once per page
+    struct GlyphsRun {
+        std::wstring text;
+        std::vector<GlyphPlacement> glyphs;
+    };
+
+    /// @brief Get cached layout of the text or build a new one
+    const GlyphsRun& getRun(std::wstring_view text);
 private:
     int lineHeight;
     int yoffset;
@@ -97,4 +120,6 @@ private:
     std::vector<std::unique_ptr<Texture>> pages;
     std::vector<Glyph> glyphs;
     std::optional<std::weak_ptr<vector_fonts::FontFile>> fontFile;
+    /// @brief Text layouts by text hash
+    std::unordered_map<size_t, GlyphsRun> runs;
 };
@@ -3,9 +3,15 @@
 #include <GL/glew.h>
 #include "Texture.hpp"
 #include "debug/Logger.hpp"
+#include "debug/Memory.hpp"
 
 static debug::Logger logger("gl-framebuffer");
 
+/// @return depth renderbuffer size estimation in bytes
+static int64_t depth_memory_usage(uint width, uint height) {
+    return static_cast<int64_t>(width) * height * 4;
+}
+
 Framebuffer::Framebuffer(uint fbo, uint depth, std::unique_ptr<Texture> texture)
   : fbo(fbo), depth(depth), texture(std::move(texture)) 
 {
@@ -16,6 +22,11 @@ Framebuffer::Framebuffer(uint fbo, uint depth, std::unique_ptr<Texture> texture)
         width = 0;
         height = 0;
     }
+    if (depth) {
+        debug::memory::add(
+            debug::MemoryTag::FRAMEBUFFERS, depth_memory_usage(width, height)
+        );
+    }
 }
 
 static std::unique_ptr<Texture> create_texture(int width, int height, int format) {
@@ -28,7 +39,9 @@ static std::unique_ptr<Texture> create_texture(int width, int height, int format
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
-    return std::make_unique<Texture>(tex, width, height);
+    auto texture = std::make_unique<Texture>(tex, width, height);
+    texture->setMemoryTag(debug::MemoryTag::FRAMEBUFFERS);
+    return texture;
 }
 
 Framebuffer::Framebuffer(uint width, uint height, bool alpha) 
@@ -47,6 +60,9 @@ Framebuffer::Framebuffer(uint width, uint height, bool alpha)
     glBindRenderbuffer(GL_RENDERBUFFER, depth);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+    debug::memory::add(
+        debug::MemoryTag::FRAMEBUFFERS, depth_memory_usage(width, height)
+    );
 
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
         logger.error() << "framebuffer is not complete!";
@@ -57,7 +73,12 @@ Framebuffer::Framebuffer(uint width, uint height, bool alpha)
 
 Framebuffer::~Framebuffer() {
     glDeleteFramebuffers(1, &fbo);
-    glDeleteRenderbuffers(1, &depth);
+    if (depth) {
+        glDeleteRenderbuffers(1, &depth);
+        debug::memory::add(
+            debug::MemoryTag::FRAMEBUFFERS, -depth_memory_usage(width, height)
+        );
+    }
 }
 
 void Framebuffer::bind() {
@@ -72,6 +93,13 @@ void Framebuffer::resize(uint width, uint height) {
     if (this->width == width && this->height == height) {
         return;
     }
+    if (depth) {
+        debug::memory::add(
+            debug::MemoryTag::FRAMEBUFFERS,
+            depth_memory_usage(width, height) -
+                depth_memory_usage(this->width, this->height)
+        );
+    }
     this->width = width;
     this->height = height;
 
@@ -3,6 +3,7 @@
 #include <GL/glew.h>
 
 #include "debug/Logger.hpp"
+#include "debug/Memory.hpp"
 
 using namespace advanced_pipeline;
 
@@ -10,6 +11,14 @@ static debug::Logger logger("gl-gbuffer");
 
 // TODO: REFACTOR
 
+/// @return attachments size estimation in bytes
+static int64_t memory_usage(uint width, uint height) {
+    // color (RGB8 padded), positions and normals (RGBA16F), emission (R8),
+    // depth (24 bit padded) and SSAO (R16F)
+    constexpr int64_t pixelSize = 4 + 8 + 8 + 1 + 4 + 2;
+    return static_cast<int64_t>(width) * height * pixelSize;
+}
+
 void GBuffer::createColorBuffer() {
     if (colorBuffer == 0)
         glGenTextures(1, &colorBuffer);
@@ -176,6 +185,9 @@ GBuffer::GBuffer(uint width, uint height) : width(width), height(height) {
         logger.error() << "SSAO framebuffer is not complete! (" << status << ")";
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    debug::memory::add(
+        debug::MemoryTag::FRAMEBUFFERS, memory_usage(width, height)
+    );
 }
 
 GBuffer::~GBuffer() {
@@ -187,6 +199,9 @@ GBuffer::~GBuffer() {
     glDeleteRenderbuffers(1, &depthBuffer);
     glDeleteFramebuffers(1, &fbo);
     glDeleteFramebuffers(1, &ssaoFbo);
+    debug::memory::add(
+        debug::MemoryTag::FRAMEBUFFERS, -memory_usage(width, height)
+    );
 }
 
 void GBuffer::bind() {
@@ -234,6 +249,10 @@ void GBuffer::resize(uint width, uint height) {
     if (this->width == width && this->height == height) {
         return;
     }
+    debug::memory::add(
+        debug::MemoryTag::FRAMEBUFFERS,
+        memory_usage(width, height) - memory_usage(this->width, this->height)
+    );
     this->width = width;
     this->height = height;
 
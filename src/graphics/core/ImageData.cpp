@@ -7,6 +7,11 @@
 #include <cmath>
 #include <algorithm>
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define VC_IMAGE_SSE2
+#endif
+
 ImageData::ImageData(ImageFormat format, uint width, uint height) 
     : format(format), width(width), height(height) {
     size_t pixsize;
@@ -17,10 +22,12 @@ ImageData::ImageData(ImageFormat format, uint width, uint height)
             throw std::runtime_error("format is not supported");
     }
     data = std::make_unique<ubyte[]>((width + width % 2) * (height + width % 2) * pixsize);
+    markDirty();
 }
 
 ImageData::ImageData(ImageFormat format, uint width, uint height, std::unique_ptr<ubyte[]> data) 
     : format(format), width(width), height(height), data(std::move(data)) {
+    markDirty();
 }
 
 ImageData::ImageData(ImageFormat format, uint width, uint height, const ubyte* data) 
@@ -34,11 +41,52 @@ ImageData::ImageData(ImageFormat format, uint width, uint height, const ubyte* d
     }
     this->data = std::make_unique<ubyte[]>(width * height * pixsize);
     std::memcpy(this->data.get(), data, width * height * pixsize);
+    markDirty();
 }
 
 ImageData::~ImageData() = default;
 
+void ImageData::markDirty(int x, int y, int w, int h) {
+    if (!dirtyTracking) {
+        return;
+    }
+    int x1 = std::max(x, 0);
+    int y1 = std::max(y, 0);
+    int x2 = std::min<int>(x + w, width);
+    int y2 = std::min<int>(y + h, height);
+    if (x1 >= x2 || y1 >= y2) {
+        return;
+    }
+    if (!dirty.empty()) {
+        x1 = std::min(x1, dirty.x);
+        y1 = std::min(y1, dirty.y);
+        x2 = std::max(x2, dirty.x + dirty.w);
+        y2 = std::max(y2, dirty.y + dirty.h);
+    }
+    dirty = {x1, y1, x2 - x1, y2 - y1};
+}
+
+void ImageData::markDirty() {
+    dirty = {0, 0, static_cast<int>(width), static_cast<int>(height)};
+}
+
+ImageRegion ImageData::getDirty() const {
+    if (!dirtyTracking) {
+        return {0, 0, static_cast<int>(width), static_cast<int>(height)};
+    }
+    return dirty;
+}
+
+void ImageData::resetDirty() {
+    dirty = {};
+}
+
+void ImageData::disableDirtyTracking() {
+    dirtyTracking = false;
+}
+
 void ImageData::flipX() {
+    markDirty();
     switch (format) {
         case ImageFormat::RGB888:
         case ImageFormat::RGBA8888: {
@@ -61,6 +109,7 @@ void ImageData::flipX() {
 }
 
 void ImageData::flipY() {
+    markDirty();
     switch (format) {
         case ImageFormat::RGB888:
         case ImageFormat::RGBA8888: {
@@ -83,6 +132,7 @@ void ImageData::flipY() {
 }
 
 void ImageData::blit(const ImageData& image, int x, int y) {
+    markDirty(x, y, image.width, image.height);
     if (format == image.format) {
         blitMatchingFormat(image, x, y);
         return;
@@ -187,6 +237,12 @@ static void draw_line(ImageData& image, int x1, int y1, int x2, int y2, const gl
 }
 
 void ImageData::drawLine(int x1, int y1, int x2, int y2, const glm::ivec4& color) {
+    markDirty(
+        std::min(x1, x2),
+        std::min(y1, y2),
+        std::abs(x2 - x1) + 1,
+        std::abs(y2 - y1) + 1
+    );
     switch (format) {
         case ImageFormat::RGB888:
             draw_line<3>(*this, x1, y1, x2, y2, color);
@@ -222,6 +278,8 @@ static void draw_rect(ImageData& image, int dstX, int dstY, int width, int heigh
 }
 
 void ImageData::drawRect(int x, int y, int width, int height, const glm::ivec4& color) {
+    // bounds are inclusive
+    markDirty(x, y, width + 1, height + 1);
     switch (format) {
         case ImageFormat::RGB888:
             draw_rect<3>(*this, x, y, width, height, color);
@@ -273,26 +331,26 @@ void ImageData::blitMatchingFormat(const ImageData& image, int x, int y) {
     const uint src_height = image.getHeight();
     ubyte* data = this->data.get();
 
+    int srcx1 = std::max(0, -x);
+    int srcx2 = std::min<int>(src_width, static_cast<int>(width) - x);
+    if (srcx1 >= srcx2) {
+        return;
+    }
+    size_t rowSize = (srcx2 - srcx1) * comps;
     for (uint srcy = std::max(0, -y);
          srcy < std::min(src_height, height - y);
          srcy++) {
-        for (uint srcx = std::max(0, -x);
-             srcx < std::min(src_width, width - x);
-             srcx++) {
-            uint dstx = srcx + x;
-            uint dsty = srcy + y;
-            uint dstidx = (dsty * width + dstx) * comps;
-            uint srcidx = (srcy * src_width + srcx) * comps;
-            for (uint c = 0; c < comps; c++) {
-                data[dstidx + c] = source[srcidx + c];
-            }
-        }
+        uint dsty = srcy + y;
+        uint dstidx = (dsty * width + srcx1 + x) * comps;
+        uint srcidx = (srcy * src_width + srcx1) * comps;
+        std::memcpy(data + dstidx, source + srcidx, rowSize);
     }
 }
 
 /* Extrude rectangle zone border pixels out by 1 pixel.
    Used to remove atlas texture border artifacts */
 void ImageData::extrude(int x, int y, int w, int h) {
+    markDirty(x - 1, y - 1, w + 2, h + 2);
     uint comps;
     switch (format) {
         case ImageFormat::RGB888: comps = 3; break;
@@ -389,6 +447,7 @@ void ImageData::extrude(int x, int y, int w, int h) {
 
 // Fixing black transparent pixels for Mip-Mapping
 void ImageData::fixAlphaColor() {
+    markDirty();
     int samples = 0;
     int sums[3] {};
     for (uint ly = 0; ly < height; ly++) {
@@ -428,45 +487,153 @@ static void check_matching(const ImageData& a, const ImageData& b) {
     }
 }
 
-void ImageData::mulColor(const glm::ivec4& color) {    
-    uint comps;
+// Blend kernels work with bytes of the image data. Source is either data of
+// the same size or 16 bytes pattern of a color repeated for 4 or 16 pixels
+
+/// @brief dst = dst * src / 255
+template <bool pattern>
+static void mul_bytes(ubyte* dst, const ubyte* src, size_t size) {
+    size_t i = 0;
+#ifdef VC_IMAGE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    // (x * 0x8081) >> 23 == x / 255 for x in [0, 65025]
+    const __m128i div255 = _mm_set1_epi16(static_cast<short>(0x8081));
+    __m128i patternBytes = _mm_setzero_si128();
+    if constexpr (pattern) {
+        patternBytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    }
+    for (; i + 16 <= size; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i b = pattern ? patternBytes
+                            : _mm_loadu_si128(
+                                  reinterpret_cast<const __m128i*>(src + i)
+                              );
+        __m128i lo = _mm_mullo_epi16(
+            _mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)
+        );
+        __m128i hi = _mm_mullo_epi16(
+            _mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)
+        );
+        lo = _mm_srli_epi16(_mm_mulhi_epu16(lo, div255), 7);
+        hi = _mm_srli_epi16(_mm_mulhi_epu16(hi, div255), 7);
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi)
+        );
+    }
+#endif
+    for (; i < size; i++) {
+        dst[i] = dst[i] * src[pattern ? (i & 15) : i] / 255;
+    }
+}
+
+/// @brief dst = clamp(dst + src) or clamp(dst - src) if subtract is true
+template <bool pattern>
+static void add_bytes(ubyte* dst, const ubyte* src, size_t size, bool subtract) {
+    size_t i = 0;
+#ifdef VC_IMAGE_SSE2
+    __m128i patternBytes = _mm_setzero_si128();
+    if constexpr (pattern) {
+        patternBytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    }
+    for (; i + 16 <= size; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i b = pattern ? patternBytes
+                            : _mm_loadu_si128(
+                                  reinterpret_cast<const __m128i*>(src + i)
+                              );
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(dst + i),
+            subtract ? _mm_subs_epu8(a, b) : _mm_adds_epu8(a, b)
+        );
+    }
+#endif
+    for (; i < size; i++) {
+        int val = dst[i];
+        int other = src[pattern ? (i & 15) : i];
+        val = subtract ? val - other : val + other;
+        dst[i] = static_cast<ubyte>(std::min(std::max(val, 0), 255));
+    }
+}
+
+/// @return true if the color fits bytes and can be used as a kernel pattern
+static bool make_pattern(
+    const glm::ivec4& color, uint comps, int multiplier, ubyte (&pattern)[16]
+) {
+    if (comps != 4) {
+        return false;
+    }
+    for (int c = 0; c < 4; c++) {
+        int value = color[c] * std::abs(multiplier);
+        if (value < 0 || value > 255) {
+            return false;
+        }
+        for (int i = 0; i < 4; i++) {
+            pattern[i * 4 + c] = static_cast<ubyte>(value);
+        }
+    }
+    return true;
+}
+
+static uint get_comps(ImageFormat format) {
     switch (format) {
-        case ImageFormat::RGB888: comps = 3; break;
-        case ImageFormat::RGBA8888: comps = 4; break;
+        case ImageFormat::RGB888: return 3;
+        case ImageFormat::RGBA8888: return 4;
         default:
-            throw std::runtime_error("only unsigned byte formats supported");    
+            throw std::runtime_error("only unsigned byte formats supported");
     }
-    for (uint y = 0; y < height; y++) {
-        for (uint x = 0; x < width; x++) {
-            uint idx = (y * width + x) * comps;
-            for (uint c = 0; c < comps; c++) {
-                float val = static_cast<float>(data[idx + c]) * color[c] / 255.0f;
-                data[idx + c] =
-                    static_cast<ubyte>(std::min(std::max(val, 0.0f), 255.0f));
-            }
-        }
+}
+
+void ImageData::mulColor(const glm::ivec4& color) {
+    uint comps = get_comps(format);
+    markDirty();
+    size_t size = static_cast<size_t>(width) * height * comps;
+    ubyte pattern[16];
+    if (make_pattern(color, comps, 1, pattern)) {
+        mul_bytes<true>(data.get(), pattern, size);
+        return;
+    }
+    for (size_t i = 0; i < size; i++) {
+        int val = data[i] * color[i % comps] / 255;
+        data[i] = static_cast<ubyte>(std::min(std::max(val, 0), 255));
     }
 }
 
-void ImageData::addColor(const ImageData& other, int multiplier) {
+void ImageData::mulColor(const ImageData& other) {
     check_matching(*this, other);
+    uint comps = get_comps(format);
+    markDirty();
+    mul_bytes<false>(
+        data.get(), other.data.get(), static_cast<size_t>(width) * height * comps
+    );
+}
 
-    uint comps;
-    switch (format) {
-        case ImageFormat::RGB888: comps = 3; break;
-        case ImageFormat::RGBA8888: comps = 4; break;
-        default:
-            throw std::runtime_error("only unsigned byte formats supported");    
+void ImageData::addColor(const glm::ivec4& color, int multiplier) {
+    uint comps = get_comps(format);
+    markDirty();
+    size_t size = static_cast<size_t>(width) * height * comps;
+    ubyte pattern[16];
+    if (make_pattern(color, comps, multiplier, pattern)) {
+        add_bytes<true>(data.get(), pattern, size, multiplier < 0);
+        return;
     }
-    for (uint y = 0; y < height; y++) {
-        for (uint x = 0; x < width; x++) {
-            uint idx = (y * width + x) * comps;
-            for (uint c = 0; c < comps; c++) {
-                int val = data[idx + c] + other.data[idx + c] * multiplier;
-                data[idx + c] =
-                    static_cast<ubyte>(std::min(std::max(val, 0), 255));
-            }
-        }
+    for (size_t i = 0; i < size; i++) {
+        int val = data[i] + color[i % comps] * multiplier;
+        data[i] = static_cast<ubyte>(std::min(std::max(val, 0), 255));
+    }
+}
+
+void ImageData::addColor(const ImageData& other, int multiplier) {
+    check_matching(*this, other);
+    uint comps = get_comps(format);
+    markDirty();
+    size_t size = static_cast<size_t>(width) * height * comps;
+    if (multiplier == 1 || multiplier == -1) {
+        add_bytes<false>(data.get(), other.data.get(), size, multiplier < 0);
+        return;
+    }
+    for (size_t i = 0; i < size; i++) {
+        int val = data[i] + other.data[i] * multiplier;
+        data[i] = static_cast<ubyte>(std::min(std::max(val, 0), 255));
     }
 }
 
@@ -494,49 +661,7 @@ void ImageData::extend(int newWidth, int newHeight) {
     data = std::move(newData);
     width = newWidth;
     height = newHeight;
-}
-
-void ImageData::addColor(const glm::ivec4& color, int multiplier) {
-    uint comps;
-    switch (format) {
-        case ImageFormat::RGB888: comps = 3; break;
-        case ImageFormat::RGBA8888: comps = 4; break;
-        default:
-            throw std::runtime_error("only unsigned byte formats supported");    
-    }
-    for (uint y = 0; y < height; y++) {
-        for (uint x = 0; x < width; x++) {
-            uint idx = (y * width + x) * comps;
-            for (uint c = 0; c < comps; c++) {
-                int val = data[idx + c] + color[c] * multiplier;
-                data[idx + c] =
-                    static_cast<ubyte>(std::min(std::max(val, 0), 255));
-            }
-        }
-    }
-}
-
-void ImageData::mulColor(const ImageData& other) {
-    check_matching(*this, other);
-
-    uint comps;
-    switch (format) {
-        case ImageFormat::RGB888: comps = 3; break;
-        case ImageFormat::RGBA8888: comps = 4; break;
-        default:
-            throw std::runtime_error("only unsigned byte formats supported");    
-    }
-    for (uint y = 0; y < height; y++) {
-        for (uint x = 0; x < width; x++) {
-            uint idx = (y * width + x) * comps;
-            for (uint c = 0; c < comps; c++) {
-                float val = static_cast<float>(data[idx + c]) *
-                            static_cast<float>(other.data[idx + c]) / 255.0f;
-                data[idx + c] =
-                    static_cast<ubyte>(std::min(std::max(val, 0.0f), 255.0f));
-            }
-        }
-    }
+    markDirty();
 }
 
 std::unique_ptr<ImageData> add_atlas_margins(ImageData* image, int grid_size) {
@@ -10,11 +10,26 @@ enum class ImageFormat {
     RGBA8888
 };
 
+/// @brief Rectangle of image pixels
+struct ImageRegion {
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+
+    bool empty() const {
+        return w <= 0 || h <= 0;
+    }
+};
+
 class ImageData {
     ImageFormat format;
     uint width;
     uint height;
     std::unique_ptr<ubyte[]> data;
+    /// @brief Bounds of pixels modified since the last resetDirty call
+    ImageRegion dirty {};
+    bool dirtyTracking = true;
 
     void blitRGB_on_RGBA(const ImageData& image, int x, int y);
     void blitMatchingFormat(const ImageData& image, int x, int y);
@@ -40,6 +55,24 @@ public:
 
     std::unique_ptr<ImageData> cropped(int x, int y, int width, int height) const;
 
+    /// @brief Extend modified region with the rectangle clipped by the
+    /// image bounds. ImageData methods mark modified pixels themselves,
+    /// writes through getData() must be marked by the caller
+    void markDirty(int x, int y, int w, int h);
+
+    /// @brief Mark the whole image modified
+    void markDirty();
+
+    /// @return bounds of pixels modified since the last resetDirty call
+    /// (the whole image if tracking is disabled)
+    ImageRegion getDirty() const;
+
+    void resetDirty();
+
+    /// @brief Consider the whole image modified from now on. Used when
+    /// data is exposed for writes that can not be tracked
+    void disableDirtyTracking();
+
     ubyte* getData() const {
         return data.get();
     }
@@ -1,5 +1,5 @@
 #include "LineBatch.hpp"
-#include "Mesh.hpp"
+#include "StreamMesh.hpp"
 
 #include <GL/glew.h>
 
@@ -7,7 +7,7 @@
 LineBatch::LineBatch(size_t capacity) : capacity(capacity) {
 
     buffer = std::make_unique<LineVertex[]>(capacity * 2);
-    mesh = std::make_unique<Mesh<LineVertex>>(buffer.get(), 0);
+    mesh = std::make_unique<StreamMesh<LineVertex>>(capacity * 2);
     index = 0;
 }
 
@@ -57,8 +57,7 @@ void LineBatch::box(float x, float y, float z, float w, float h, float d,
 void LineBatch::flush(){
     if (index == 0)
         return;
-    mesh->reload(buffer.get(), index);
-    mesh->draw(GL_LINES);
+    mesh->draw(buffer.get(), index, GL_LINES);
     index = 0;
 }
 
@@ -8,7 +8,7 @@
 #include "MeshData.hpp"
 
 template<typename VertexStructure>
-class Mesh;
+class StreamMesh;
 
 struct LineVertex {
     glm::vec3 position;
@@ -21,7 +21,7 @@ struct LineVertex {
 };
 
 class LineBatch : public Flushable {
-    std::unique_ptr<Mesh<LineVertex>> mesh;
+    std::unique_ptr<StreamMesh<LineVertex>> mesh;
     std::unique_ptr<LineVertex[]> buffer;
     size_t index;
     size_t capacity;
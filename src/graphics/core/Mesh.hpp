@@ -25,6 +25,11 @@ class Mesh {
     unsigned int vbo;
     std::vector<IndexBuffer> ibos;
     size_t vertexCount;
+    /// @brief Vertex and index buffers size in bytes
+    size_t memoryUsage = 0;
+
+    /// @brief Update buffers video memory usage (see debug::memory)
+    void updateMemoryUsage();
 public:
     explicit Mesh(const MeshData<VertexStructure>& data);
 
@@ -55,6 +60,10 @@ public:
         reload(vertexBuffer, vertexCount, indices);
     }
 
+    /// @brief Update GL index buffers data keeping vertex data.
+    /// Existing index buffers are reused
+    void reloadIndices(const std::vector<IndexBufferData>& indices);
+
     /// @brief Draw mesh with specified primitives type
     /// @param iboIndex index of used element buffer
     void draw(unsigned int primitive, int iboIndex = 0) const;
@@ -2,6 +2,7 @@
 
 #include "MeshData.hpp"
 #include "gl_util.hpp"
+#include "debug/Memory.hpp"
 
 inline constexpr size_t calc_size(const VertexAttribute attrs[]) {
     size_t vertexSize = 0;
@@ -11,6 +12,27 @@ inline constexpr size_t calc_size(const VertexAttribute attrs[]) {
     return vertexSize;
 }
 
+/// @brief Setup attributes of the bound VAO for the vertex structure
+/// stored in the bound GL_ARRAY_BUFFER
+template <typename VertexStructure>
+inline void setup_vertex_attributes() {
+    const auto& attrs = VertexStructure::ATTRIBUTES;
+    int offset = 0;
+    for (int i = 0; attrs[i].count; i++) {
+        const VertexAttribute& attr = attrs[i];
+        glVertexAttribPointer(
+            i,
+            attr.count,
+            gl::to_glenum(attr.type),
+            attr.normalized,
+            sizeof(VertexStructure),
+            (GLvoid*)(size_t)offset
+        );
+        glEnableVertexAttribArray(i);
+        offset += attr.size();
+    }
+}
+
 template <typename VertexStructure>
 inline std::vector<IndexBufferData> convert_to_ibd(const MeshData<VertexStructure>& data) {
     std::vector<IndexBufferData> indices;
@@ -39,8 +61,6 @@ Mesh<VertexStructure>::Mesh(
     static_assert(
         calc_size(VertexStructure::ATTRIBUTES) == sizeof(VertexStructure)
     );
-    
-    const auto& attrs = VertexStructure::ATTRIBUTES;
     MeshStats::meshesCount++;
 
     glGenVertexArrays(1, &vao);
@@ -49,28 +69,17 @@ Mesh<VertexStructure>::Mesh(
     reload(vertexBuffer, vertices, std::move(indices));
 
     glBindVertexArray(vao);
-    // attributes
-    int offset = 0;
-    for (int i = 0; attrs[i].count; i++) {
-        const VertexAttribute& attr = attrs[i];
-        glVertexAttribPointer(
-            i,
-            attr.count,
-            gl::to_glenum(attr.type),
-            attr.normalized,
-            sizeof(VertexStructure),
-            (GLvoid*)(size_t)offset
-        );
-        glEnableVertexAttribArray(i);
-        offset += attr.size();
-    }
-
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    setup_vertex_attributes<VertexStructure>();
     glBindVertexArray(0);
 }
 
 template <typename VertexStructure>
 Mesh<VertexStructure>::~Mesh() {
     MeshStats::meshesCount--;
+    debug::memory::add(
+        debug::MemoryTag::MESHES_GPU, -static_cast<int64_t>(memoryUsage)
+    );
     glDeleteVertexArrays(1, &vao);
     glDeleteBuffers(1, &vbo);
     for (int i = ibos.size() - 1; i >= 0; i--) {
@@ -97,16 +106,25 @@ void Mesh<VertexStructure>::reload(
     } else {
         glBufferData(GL_ARRAY_BUFFER, 0, {}, GL_STREAM_DRAW);
     }
+    glBindVertexArray(0);
+    reloadIndices(indices);
+}
 
-    for (int i = indices.size(); i < ibos.size(); i++) {
+template <typename VertexStructure>
+void Mesh<VertexStructure>::reloadIndices(
+    const std::vector<IndexBufferData>& indices
+) {
+    glBindVertexArray(vao);
+    for (size_t i = indices.size(); i < ibos.size(); i++) {
         glDeleteBuffers(1, &ibos[i].ibo);
     }
-    ibos.clear();
+    ibos.resize(indices.size(), IndexBuffer {0, 0});
 
-    for (int i = 0; i < indices.size(); i++) {
+    for (size_t i = 0; i < indices.size(); i++) {
         const auto& indexBuffer = indices[i];
-        ibos.push_back(IndexBuffer {0, 0});
-        glGenBuffers(1, &ibos[i].ibo);
+        if (ibos[i].ibo == 0) {
+            glGenBuffers(1, &ibos[i].ibo);
+        }
         ibos[i].indexCount = indexBuffer.indicesCount;
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibos[i].ibo);
         glBufferData(
@@ -117,6 +135,20 @@ void Mesh<VertexStructure>::reload(
         );
     }
     glBindVertexArray(0);
+    updateMemoryUsage();
+}
+
+template <typename VertexStructure>
+void Mesh<VertexStructure>::updateMemoryUsage() {
+    size_t bytes = vertexCount * sizeof(VertexStructure);
+    for (const auto& buffer : ibos) {
+        bytes += buffer.indexCount * sizeof(uint32_t);
+    }
+    debug::memory::add(
+        debug::MemoryTag::MESHES_GPU,
+        static_cast<int64_t>(bytes) - static_cast<int64_t>(memoryUsage)
+    );
+    memoryUsage = bytes;
 }
 
 template <typename VertexStructure>
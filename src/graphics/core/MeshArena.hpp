@@ -0,0 +1,120 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "MeshData.hpp"
+#include "util/RangeAllocator.hpp"
+
+/// @brief Location of a mesh inside of MeshArena
+struct ArenaMesh {
+    struct IndexBuffer {
+        /// @brief First index relative to the page index buffer
+        size_t offset;
+        size_t count;
+    };
+    size_t page;
+    size_t vertexOffset;
+    size_t vertexCount;
+    size_t indexOffset;
+    /// @brief Total indices count of all index buffers
+    size_t indexCount;
+    std::vector<IndexBuffer> ibos;
+};
+
+/// @brief glMultiDrawElementsIndirect command structure
+struct DrawElementsIndirectCommand {
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    uint32_t baseInstance;
+};
+
+/// @brief Large shared vertex and index buffers storing many meshes with the
+/// same vertex format. Replaces separate VAO/VBO/IBOs per mesh, so meshes
+/// rebuilding does not reallocate GL buffers. All meshes of a page may be
+/// drawn with a single glMultiDrawElementsIndirect call
+/// @tparam InstanceStructure per-draw attributes (divisor 1) bound to
+/// locations following the vertex attributes, selected by baseInstance
+template <typename VertexStructure, typename InstanceStructure>
+class MeshArena {
+    struct Page {
+        unsigned int vao;
+        unsigned int vbo;
+        unsigned int ibo;
+        unsigned int instancesVbo;
+        util::RangeAllocator vertices;
+        util::RangeAllocator indices;
+    };
+    std::vector<std::unique_ptr<Page>> pages;
+    unsigned int indirectBuffer;
+    size_t pageVertices;
+    size_t pageIndices;
+    bool indirect;
+
+    Page& createPage(size_t vertices, size_t indices);
+    void free(const ArenaMesh& mesh);
+    void upload(
+        const ArenaMesh& mesh,
+        const VertexStructure* vertices,
+        const std::vector<IndexBufferData>& indices
+    );
+    /// @brief Allocate space for mesh, creating new page if needed
+    std::shared_ptr<ArenaMesh> allocate(
+        size_t vertexCount, size_t indexCount
+    );
+public:
+    /// @param pageVertices vertices capacity of a page
+    /// @param pageIndices indices capacity of a page
+    /// @param indirect enable instance attributes for drawIndirect.
+    /// Meshes are drawn with draw(...) only otherwise
+    MeshArena(size_t pageVertices, size_t pageIndices, bool indirect);
+    ~MeshArena();
+
+    MeshArena(const MeshArena&) = delete;
+
+    /// @brief Upload mesh to the arena. New page is created if the mesh
+    /// does not fit into existing ones
+    /// @return mesh handle releasing the occupied space when destroyed.
+    /// Arena must outlive all handles
+    std::shared_ptr<ArenaMesh> add(const MeshData<VertexStructure>& data);
+
+    /// @brief Replace mesh data. Mesh is overwritten in place if the new
+    /// data fits into the occupied (or adjacent free) space, otherwise it
+    /// is moved
+    /// @param mesh mesh handle (nullptr is allowed, creates new one)
+    void update(
+        std::shared_ptr<ArenaMesh>& mesh, const MeshData<VertexStructure>& data
+    );
+
+    size_t getPagesCount() const {
+        return pages.size();
+    }
+
+    bool isIndirect() const {
+        return indirect;
+    }
+
+    /// @return total GL buffers size in bytes
+    size_t getMemoryConsumption() const;
+
+    /// @brief Draw mesh as triangles using u_model transform
+    /// @param iboIndex index of used index buffer
+    void draw(const ArenaMesh& mesh, int iboIndex) const;
+
+    /// @brief Draw page meshes as triangles
+    /// @param commands draw commands for meshes of the page
+    /// @param instances per-draw attributes indexed by baseInstance
+    void drawIndirect(
+        size_t page,
+        const std::vector<DrawElementsIndirectCommand>& commands,
+        const std::vector<InstanceStructure>& instances
+    ) const;
+
+    /// @brief Check if current GL context supports indirect multi-draw
+    /// with non-zero base instance
+    static bool isIndirectSupported();
+};
+
+#include "graphics/core/MeshArena.inl"
@@ -0,0 +1,339 @@
+#pragma once
+
+#include "Mesh.hpp"
+#include "gl_util.hpp"
+
+template <typename VertexStructure, typename InstanceStructure>
+MeshArena<VertexStructure, InstanceStructure>::MeshArena(
+    size_t pageVertices, size_t pageIndices, bool indirect
+)
+    : indirectBuffer(0),
+      pageVertices(pageVertices),
+      pageIndices(pageIndices),
+      indirect(indirect) {
+    static_assert(
+        calc_size(VertexStructure::ATTRIBUTES) == sizeof(VertexStructure)
+    );
+    static_assert(
+        calc_size(InstanceStructure::ATTRIBUTES) == sizeof(InstanceStructure)
+    );
+    if (indirect) {
+        glGenBuffers(1, &indirectBuffer);
+    }
+}
+
+template <typename VertexStructure, typename InstanceStructure>
+MeshArena<VertexStructure, InstanceStructure>::~MeshArena() {
+    for (const auto& page : pages) {
+        glDeleteVertexArrays(1, &page->vao);
+        glDeleteBuffers(1, &page->vbo);
+        glDeleteBuffers(1, &page->ibo);
+        glDeleteBuffers(1, &page->instancesVbo);
+    }
+    if (indirectBuffer) {
+        glDeleteBuffers(1, &indirectBuffer);
+    }
+}
+
+template <typename VertexStructure, typename InstanceStructure>
+auto MeshArena<VertexStructure, InstanceStructure>::createPage(
+    size_t vertices, size_t indices
+) -> Page& {
+    auto page = std::make_unique<Page>(Page {
+        0, 0, 0, 0, util::RangeAllocator(vertices), util::RangeAllocator(indices)
+    });
+    glGenVertexArrays(1, &page->vao);
+    glGenBuffers(1, &page->vbo);
+    glGenBuffers(1, &page->ibo);
+
+    glBindVertexArray(page->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, page->vbo);
+    glBufferData(
+        GL_ARRAY_BUFFER,
+        vertices * sizeof(VertexStructure),
+        nullptr,
+        GL_DYNAMIC_DRAW
+    );
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page->ibo);
+    glBufferData(
+        GL_ELEMENT_ARRAY_BUFFER,
+        indices * sizeof(uint32_t),
+        nullptr,
+        GL_DYNAMIC_DRAW
+    );
+
+    const auto& attrs = VertexStructure::ATTRIBUTES;
+    int index = 0;
+    int offset = 0;
+    for (; attrs[index].count; index++) {
+        const VertexAttribute& attr = attrs[index];
+        glVertexAttribPointer(
+            index,
+            attr.count,
+            gl::to_glenum(attr.type),
+            attr.normalized,
+            sizeof(VertexStructure),
+            (GLvoid*)(size_t)offset
+        );
+        glEnableVertexAttribArray(index);
+        offset += attr.size();
+    }
+
+    if (indirect) {
+        glGenBuffers(1, &page->instancesVbo);
+        glBindBuffer(GL_ARRAY_BUFFER, page->instancesVbo);
+        const auto& instanceAttrs = InstanceStructure::ATTRIBUTES;
+        offset = 0;
+        for (int i = 0; instanceAttrs[i].count; i++, index++) {
+            const VertexAttribute& attr = instanceAttrs[i];
+            glVertexAttribPointer(
+                index,
+                attr.count,
+                gl::to_glenum(attr.type),
+                attr.normalized,
+                sizeof(InstanceStructure),
+                (GLvoid*)(size_t)offset
+            );
+            glEnableVertexAttribArray(index);
+            glVertexAttribDivisor(index, 1);
+            offset += attr.size();
+        }
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    pages.push_back(std::move(page));
+    return *pages.back();
+}
+
+template <typename VertexStructure, typename InstanceStructure>
+std::shared_ptr<ArenaMesh> MeshArena<VertexStructure, InstanceStructure>::allocate(
+    size_t vertexCount, size_t indexCount
+) {
+    Page* page = nullptr;
+    size_t pageIndex = 0;
+    std::optional<size_t> vertexOffset;
+    std::optional<size_t> indexOffset;
+    for (; pageIndex < pages.size(); pageIndex++) {
+        auto& current = *pages[pageIndex];
+        if (current.vertices.getFreeSize() < vertexCount ||
+            current.indices.getFreeSize() < indexCount) {
+            continue;
+        }
+        vertexOffset = current.vertices.allocate(vertexCount);
+        if (!vertexOffset && vertexCount) {
+            continue;
+        }
+        indexOffset = current.indices.allocate(indexCount);
+        if (!indexOffset && indexCount) {
+            current.vertices.free(vertexOffset.value_or(0), vertexCount);
+            continue;
+        }
+        page = &current;
+        break;
+    }
+    if (page == nullptr) {
+        page = &createPage(
+            std::max(pageVertices, vertexCount),
+            std::max(pageIndices, indexCount)
+        );
+        pageIndex = pages.size() - 1;
+        vertexOffset = page->vertices.allocate(vertexCount);
+        indexOffset = page->indices.allocate(indexCount);
+    }
+    return std::shared_ptr<ArenaMesh>(
+        new ArenaMesh {
+            pageIndex,
+            vertexOffset.value_or(0),
+            vertexCount,
+            indexOffset.value_or(0),
+            indexCount,
+            {}
+        },
+        [this](ArenaMesh* mesh) {
+            free(*mesh);
+            delete mesh;
+        }
+    );
+}
+
+template <typename VertexStructure, typename InstanceStructure>
+void MeshArena<VertexStructure, InstanceStructure>::upload(
+    const ArenaMesh& mesh,
+    const VertexStructure* vertices,
+    const std::vector<IndexBufferData>& indices
+) {
+    const auto& page = *pages[mesh.page];
+    if (mesh.vertexCount) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, page.vbo);
+        glBufferSubData(
+            GL_COPY_WRITE_BUFFER,
+            mesh.vertexOffset * sizeof(VertexStructure),
+            mesh.vertexCount * sizeof(VertexStructure),
+            vertices
+        );
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, page.ibo);
+    for (size_t i = 0; i < indices.size(); i++) {
+        const auto& ibo = mesh.ibos[i];
+        if (ibo.count) {
+            glBufferSubData(
+                GL_COPY_WRITE_BUFFER,
+                ibo.offset * sizeof(uint32_t),
+                ibo.count * sizeof(uint32_t),
+                indices[i].indices
+            );
+        }
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+template <typename VertexStructure, typename InstanceStructure>
+std::shared_ptr<ArenaMesh> MeshArena<VertexStructure, InstanceStructure>::add(
+    const MeshData<VertexStructure>& data
+) {
+    std::shared_ptr<ArenaMesh> mesh;
+    update(mesh, data);
+    return mesh;
+}
+
+template <typename VertexStructure, typename InstanceStructure>
+void MeshArena<VertexStructure, InstanceStructure>::update(
+    std::shared_ptr<ArenaMesh>& mesh, const MeshData<VertexStructure>& data
+) {
+    size_t vertexCount = data.vertices.size();
+    size_t indexCount = 0;
+    for (const auto& buffer : data.indices) {
+        indexCount += buffer.size();
+    }
+
+    bool inPlace = false;
+    if (mesh) {
+        auto& page = *pages[mesh->page];
+        if (page.vertices.resize(
+                mesh->vertexOffset, mesh->vertexCount, vertexCount
+            )) {
+            if (page.indices.resize(
+                    mesh->indexOffset, mesh->indexCount, indexCount
+                )) {
+                inPlace = true;
+            } else {
+                // rollback vertices range
+                page.vertices.resize(
+                    mesh->vertexOffset, vertexCount, mesh->vertexCount
+                );
+            }
+        }
+        if (inPlace) {
+            mesh->vertexCount = vertexCount;
+            mesh->indexCount = indexCount;
+        } else {
+            mesh.reset();
+        }
+    }
+    if (mesh == nullptr) {
+        mesh = allocate(vertexCount, indexCount);
+    }
+
+    mesh->ibos.clear();
+    size_t offset = mesh->indexOffset;
+    for (const auto& buffer : data.indices) {
+        mesh->ibos.push_back(ArenaMesh::IndexBuffer {offset, buffer.size()});
+        offset += buffer.size();
+    }
+    upload(*mesh, data.vertices.data(), convert_to_ibd<VertexStructure>(data));
+}
+
+template <typename VertexStructure, typename InstanceStructure>
+void MeshArena<VertexStructure, InstanceStructure>::free(const ArenaMesh& mesh) {
+    auto& page = *pages.at(mesh.page);
+    page.vertices.free(mesh.vertexOffset, mesh.vertexCount);
+    page.indices.free(mesh.indexOffset, mesh.indexCount);
+
+    // release trailing empty pages (except the first one)
+    while (pages.size() > 1) {
+        const auto& last = *pages.back();
+        if (last.vertices.getFreeSize() != last.vertices.getCapacity() ||
+            last.indices.getFreeSize() != last.indices.getCapacity()) {
+            break;
+        }
+        glDeleteVertexArrays(1, &last.vao);
+        glDeleteBuffers(1, &last.vbo);
+        glDeleteBuffers(1, &last.ibo);
+        glDeleteBuffers(1, &last.instancesVbo);
+        pages.pop_back();
+    }
+}
+
+template <typename VertexStructure, typename InstanceStructure>
+size_t MeshArena<VertexStructure, InstanceStructure>::getMemoryConsumption(
+) const {
+    size_t size = 0;
+    for (const auto& page : pages) {
+        size += page->vertices.getCapacity() * sizeof(VertexStructure) +
+                page->indices.getCapacity() * sizeof(uint32_t);
+    }
+    return size;
+}
+
+template <typename VertexStructure, typename InstanceStructure>
+void MeshArena<VertexStructure, InstanceStructure>::draw(
+    const ArenaMesh& mesh, int iboIndex
+) const {
+    if (iboIndex >= mesh.ibos.size() || mesh.ibos[iboIndex].count == 0) {
+        return;
+    }
+    MeshStats::drawCalls++;
+
+    const auto& ibo = mesh.ibos[iboIndex];
+    glBindVertexArray(pages.at(mesh.page)->vao);
+    glDrawElementsBaseVertex(
+        GL_TRIANGLES,
+        ibo.count,
+        GL_UNSIGNED_INT,
+        (GLvoid*)(ibo.offset * sizeof(uint32_t)),
+        mesh.vertexOffset
+    );
+    glBindVertexArray(0);
+}
+
+template <typename VertexStructure, typename InstanceStructure>
+void MeshArena<VertexStructure, InstanceStructure>::drawIndirect(
+    size_t pageIndex,
+    const std::vector<DrawElementsIndirectCommand>& commands,
+    const std::vector<InstanceStructure>& instances
+) const {
+    if (commands.empty()) {
+        return;
+    }
+    MeshStats::drawCalls++;
+
+    const auto& page = *pages.at(pageIndex);
+    glBindVertexArray(page.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, page.instancesVbo);
+    glBufferData(
+        GL_ARRAY_BUFFER,
+        instances.size() * sizeof(InstanceStructure),
+        instances.data(),
+        GL_STREAM_DRAW
+    );
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+    glBufferData(
+        GL_DRAW_INDIRECT_BUFFER,
+        commands.size() * sizeof(DrawElementsIndirectCommand),
+        commands.data(),
+        GL_STREAM_DRAW
+    );
+    glMultiDrawElementsIndirect(
+        GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, commands.size(), 0
+    );
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+template <typename VertexStructure, typename InstanceStructure>
+bool MeshArena<VertexStructure, InstanceStructure>::isIndirectSupported() {
+    return GLEW_VERSION_4_3 ||
+           (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+}
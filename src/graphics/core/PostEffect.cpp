@@ -1,11 +1,16 @@
 #include "PostEffect.hpp"
 
 #include "Shader.hpp"
+#include "coders/GLSLExtension.hpp"
 #include "data/dv_util.hpp"
 #include "debug/Logger.hpp"
 
+#include <regex>
+
 static debug::Logger logger("post-effect");
 
+static uint64_t next_effect_id = 1;
+
 PostEffect::Param::Param() : type(Type::FLOAT) {}
 
 PostEffect::Param::Param(Type type, Value defValue, bool array)
@@ -15,9 +20,14 @@ PostEffect::Param::Param(Type type, Value defValue, bool array)
 PostEffect::PostEffect(
     bool advanced,
     std::shared_ptr<Shader> shader,
-    std::unordered_map<std::string, Param> params
+    std::unordered_map<std::string, Param> params,
+    std::shared_ptr<const FusionSource> fusion
 )
-    : advanced(advanced), shader(std::move(shader)), params(std::move(params)) {
+    : id(next_effect_id++),
+      advanced(advanced),
+      shader(std::move(shader)),
+      params(std::move(params)),
+      fusion(std::move(fusion)) {
 }
 
 static void apply_uniform_value(
@@ -145,6 +155,82 @@ void PostEffect::setParam(const std::string& name, const dv::value& value) {
     param.dirty = true;
 }
 
+void PostEffect::applyFused(Shader& shader, size_t index) {
+    std::string suffix = "_" + std::to_string(index);
+    shader.uniform1f("u_intensity" + suffix, intensity);
+    for (const auto& [name, param] : params) {
+        if (!param.array) {
+            apply_uniform_value(param, shader, name + suffix);
+            continue;
+        }
+        const auto& found = arrayValues.find(name);
+        if (found != arrayValues.end()) {
+            apply_uniform_array(param, shader, name + suffix, found->second);
+        }
+    }
+}
+
+std::string PostEffect::toFusableCode(const std::string& code) {
+    static const std::regex input_color(
+        R"(texture\s*\(\s*u_screen\s*,\s*v_uv\s*\))"
+    );
+    // samplers are not available in fused effects, neighbour pixels
+    // of the input are not rendered yet
+    static const std::regex non_local(
+        R"(\b(u_screen|u_position|u_normal|u_emission|u_noise|u_ssao|)"
+        R"(u_skybox|texelFetch|textureSize|textureOffset|textureLod|)"
+        R"(dFdx|dFdy|fwidth)\b)"
+    );
+    std::string result = std::regex_replace(code, input_color, "vc_color");
+    if (std::regex_search(result, non_local)) {
+        return "";
+    }
+    return result;
+}
+
+std::unique_ptr<Shader> PostEffect::createFused(
+    const std::vector<PostEffect*>& effects
+) {
+    // effects functions and params are renamed to not collide
+    std::string code = "vec4 vc_color;\n";
+    for (size_t i = 0; i < effects.size(); i++) {
+        const auto& effect = *effects[i];
+        std::string suffix = "_" + std::to_string(i);
+        std::vector<std::string> names {"effect", "u_intensity"};
+        for (const auto& [name, _] : effect.params) {
+            names.push_back(name);
+        }
+        code += "uniform float u_intensity" + suffix + ";\n";
+        for (const auto& name : names) {
+            code += "#define " + name + " " + name + suffix + "\n";
+        }
+        code += effect.fusion->code + "\n";
+        for (const auto& name : names) {
+            code += "#undef " + name + "\n";
+        }
+    }
+    code += "vec4 effect() {\n    vc_color = texture(u_screen, v_uv);\n";
+    for (size_t i = 0; i < effects.size(); i++) {
+        code += "    vc_color = effect_" + std::to_string(i) + "();\n";
+    }
+    code += "    return vc_color;\n}\n";
+
+    auto& preprocessor = *Shader::preprocessor;
+    preprocessor.addHeader("__effect__", {std::move(code), {}});
+
+    const auto& source = *effects.at(0)->fusion;
+    auto vertex = preprocessor.process(
+        source.vertexFile, source.vertexSource, false, {}
+    );
+    auto fragment = preprocessor.process(
+        source.fragmentFile, source.fragmentSource, false, {}
+    );
+    return Shader::create(
+        {source.vertexFile, std::move(vertex.code)},
+        {source.fragmentFile, std::move(fragment.code)}
+    );
+}
+
 void PostEffect::setArray(const std::string& name, std::vector<ubyte>&& values) {
     const auto& found = params.find(name);
     if (found == params.end()) {
@@ -38,10 +38,23 @@ public:
         Param(Type type, Value defValue, bool array);
     };
 
+    /// @brief Sources used to fuse per-pixel effects into a single pass
+    struct FusionSource {
+        /// @brief Effect code with the input color sampling replaced
+        /// with 'vc_color' variable
+        std::string code;
+        /// @brief Effect program sources (not preprocessed)
+        std::string vertexFile;
+        std::string vertexSource;
+        std::string fragmentFile;
+        std::string fragmentSource;
+    };
+
     PostEffect(
         bool advanced,
         std::shared_ptr<Shader> shader,
-        std::unordered_map<std::string, Param> params
+        std::unordered_map<std::string, Param> params,
+        std::shared_ptr<const FusionSource> fusion = nullptr
     );
 
     explicit PostEffect(const PostEffect&) = default;
@@ -64,10 +77,38 @@ public:
     bool isActive() {
         return intensity > 1e-4f;
     }
+
+    /// @brief Effect may be fused with other per-pixel effects
+    bool isFusable() const {
+        return fusion != nullptr;
+    }
+
+    /// @brief Unique id of the effect program (shared by copies)
+    uint64_t getId() const {
+        return id;
+    }
+
+    /// @brief Apply intensity and params to a fused effects shader
+    /// @param index effect index in the fused chain
+    void applyFused(Shader& shader, size_t index);
+
+    /// @brief Make code of an effect fusable with other effects
+    /// @param code preprocessed effect code
+    /// @return code with the input color sampling replaced with
+    /// 'vc_color' or empty string if effect samples other pixels or buffers
+    static std::string toFusableCode(const std::string& code);
+
+    /// @brief Create shader applying the fusable effects in a single pass
+    /// @throws std::runtime_error if shader compilation failed
+    static std::unique_ptr<Shader> createFused(
+        const std::vector<PostEffect*>& effects
+    );
 private:
+    uint64_t id;
     bool advanced = false;
     std::shared_ptr<Shader> shader;
     std::unordered_map<std::string, Param> params;
     std::unordered_map<std::string, std::vector<ubyte>> arrayValues;
     float intensity = 0.0f;
+    std::shared_ptr<const FusionSource> fusion;
 };
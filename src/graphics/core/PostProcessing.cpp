@@ -7,6 +7,7 @@
 #include "DrawContext.hpp"
 #include "PostEffect.hpp"
 #include "assets/Assets.hpp"
+#include "debug/Logger.hpp"
 #include "window/Camera.hpp"
 
 #include <stdexcept>
@@ -16,6 +17,8 @@
 
 using namespace advanced_pipeline;
 
+static debug::Logger logger("post-processing");
+
 PostProcessing::PostProcessing(size_t effectSlotsCount)
     : effectSlots(effectSlotsCount) {
     // Fullscreen quad mesh bulding
@@ -53,6 +56,7 @@ PostProcessing::~PostProcessing() = default;
 
 void PostProcessing::use(DrawContext& context, bool gbufferPipeline) {
     const auto& vp = context.getViewport();
+    renderSize = vp;
 
     if (gbufferPipeline) {
         if (gbuffer == nullptr) {
@@ -86,7 +90,6 @@ void PostProcessing::bindDepthBuffer() {
 
 void PostProcessing::configureEffect(
     const DrawContext& context,
-    PostEffect& effect,
     Shader& shader,
     float timer,
     const Camera& camera
@@ -130,7 +133,6 @@ void PostProcessing::renderDeferredShading(
     auto& shader = ssaoEffect.use();
     configureEffect(
         context,
-        ssaoEffect,
         shader,
         timer,
         camera
@@ -157,7 +159,6 @@ void PostProcessing::renderDeferredShading(
         auto& shader = effect.use();
         configureEffect(
             context,
-            effect,
             shader,
             timer,
             camera
@@ -175,42 +176,71 @@ void PostProcessing::render(
     if (fbo == nullptr) {
         throw std::runtime_error("'use(...)' was never called");
     }
-    int totalPasses = 0;
+    std::vector<PostEffect*> effects;
     for (const auto& effect : effectSlots) {
-        totalPasses +=
-            (effect != nullptr && effect->isActive() &&
-             !(effect->isAdvanced() && gbuffer == nullptr));
+        if (effect == nullptr || !effect->isActive()) {
+            continue;
+        }
+        if (effect->isAdvanced() && gbuffer == nullptr) {
+            continue;
+        }
+        effects.push_back(effect.get());
+    }
+
+    // consecutive per-pixel effects [begin, end) are rendered by one pass
+    struct Pass {
+        size_t begin;
+        size_t end;
+        Shader* fused;
+    };
+    std::vector<Pass> passes;
+    for (size_t i = 0; i < effects.size();) {
+        size_t end = i + 1;
+        while (effectsFusion && end < effects.size() &&
+               effects[i]->isFusable() && effects[end]->isFusable()) {
+            end++;
+        }
+        Shader* fused = nullptr;
+        if (end - i > 1) {
+            fused = getFusedShader(effects, i, end);
+            if (fused == nullptr) {
+                end = i + 1;
+            }
+        }
+        passes.push_back({i, end, fused});
+        i = end;
     }
+    int totalPasses = passes.size();
 
+    // scene rendered in lower resolution is upscaled by the last pass
     const auto& vp = context.getViewport();
-    refreshFbos(vp.x, vp.y);
+    bool upscale = renderSize != vp;
+    totalPasses += upscale;
+    refreshFbos(renderSize.x, renderSize.y);
 
     glActiveTexture(GL_TEXTURE0);
     fbo->getTexture()->bind();
 
     if (totalPasses == 0) {
         // replace 'default' blit shader with glBlitFramebuffer?
-        auto& effect = assets.require<PostEffect>("default");
-        auto& shader = effect.use();
-        configureEffect(
-            context, effect, shader, timer, camera
-        );
+        auto& shader = assets.require<PostEffect>("default").use();
+        configureEffect(context, shader, timer, camera);
         quadMesh->draw();
         return;
     }
 
+    // intermediate passes are rendered in the scene resolution
+    auto sceneContext = context.sub();
+    sceneContext.setViewport(renderSize);
+
     int currentPass = 1;
-    for (const auto& effect : effectSlots) {
-        if (effect == nullptr || !effect->isActive()) {
-            continue;
+    auto applyPass = [&](Shader& shader) {
+        bool last = currentPass == totalPasses;
+        if (last) {
+            glViewport(0, 0, vp.x, vp.y);
         }
-        if (effect->isAdvanced() && gbuffer == nullptr) {
-            continue;
-        }
-        auto& shader = effect->use();
         configureEffect(
-            context,
-            *effect,
+            last ? context : sceneContext,
             shader,
             timer,
             camera
@@ -220,17 +250,60 @@ void PostProcessing::render(
             fbo->getTexture()->bind();
         }
 
-        if (currentPass < totalPasses) {
+        if (!last) {
             fboSecond->bind();
         }
 
         quadMesh->draw();
-        if (currentPass < totalPasses) {
+        if (!last) {
             fboSecond->unbind();
             std::swap(fbo, fboSecond);
         }
         currentPass++;
+    };
+    for (const auto& pass : passes) {
+        if (pass.fused == nullptr) {
+            applyPass(effects[pass.begin]->use());
+            continue;
+        }
+        pass.fused->use();
+        for (size_t i = pass.begin; i < pass.end; i++) {
+            effects[i]->applyFused(*pass.fused, i - pass.begin);
+        }
+        applyPass(*pass.fused);
     }
+    if (upscale) {
+        applyPass(assets.require<PostEffect>("upscale").use());
+    }
+}
+
+Shader* PostProcessing::getFusedShader(
+    const std::vector<PostEffect*>& effects, size_t begin, size_t end
+) {
+    std::string key;
+    for (size_t i = begin; i < end; i++) {
+        key += std::to_string(effects[i]->getId()) + ";";
+    }
+    const auto& found = fusedShaders.find(key);
+    if (found != fusedShaders.end()) {
+        return found->second.get();
+    }
+    std::unique_ptr<Shader> shader;
+    try {
+        shader = PostEffect::createFused(std::vector<PostEffect*>(
+            effects.begin() + begin, effects.begin() + end
+        ));
+    } catch (const std::runtime_error& err) {
+        // effects are rendered separately
+        logger.error() << "post-effects fusion failed: " << err.what();
+    }
+    auto ptr = shader.get();
+    fusedShaders[key] = std::move(shader);
+    return ptr;
+}
+
+void PostProcessing::setEffectsFusion(bool flag) {
+    effectsFusion = flag;
 }
 
 void PostProcessing::setEffect(size_t slot, std::shared_ptr<PostEffect> effect) {
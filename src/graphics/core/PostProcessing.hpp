@@ -2,6 +2,8 @@
 
 #include <vector>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <glm/glm.hpp>
 #include "MeshData.hpp"
 
@@ -32,7 +34,9 @@ public:
     ~PostProcessing();
 
     /// @brief Prepare and bind framebuffer
-    /// @param context graphics context will be modified
+    /// @param context graphics context will be modified. Its viewport
+    /// defines the scene resolution, upscaled by render(...) to the
+    /// render(...) context viewport if differs
     void use(DrawContext& context, bool gbufferPipeline);
 
     void renderDeferredShading(
@@ -55,6 +59,9 @@ public:
 
     void setEffect(size_t slot, std::shared_ptr<PostEffect> effect);
 
+    /// @brief Render consecutive per-pixel effects in a single pass
+    void setEffectsFusion(bool flag);
+
     PostEffect* getEffect(size_t slot);
 
     /// @brief Make an image from the last rendered frame
@@ -65,7 +72,6 @@ public:
 private:
     void configureEffect(
         const DrawContext& context,
-        PostEffect& effect,
         Shader& shader,
         float timer,
         const Camera& camera
@@ -73,6 +79,12 @@ private:
 
     void refreshFbos(uint width, uint height);
 
+    /// @return shader of fused effects [begin, end) or nullptr if
+    /// compilation failed
+    Shader* getFusedShader(
+        const std::vector<PostEffect*>& effects, size_t begin, size_t end
+    );
+
     /// @brief Main framebuffer (lasy field)
     std::unique_ptr<Framebuffer> fbo;
     std::unique_ptr<Framebuffer> fboSecond;
@@ -81,4 +93,9 @@ private:
     std::vector<std::shared_ptr<PostEffect>> effectSlots;
     std::unique_ptr<GBuffer> gbuffer;
     uint noiseTexture;
+    /// @brief Scene resolution (viewport passed to use(...))
+    glm::uvec2 renderSize {};
+    bool effectsFusion = true;
+    /// @brief Fused effects shaders by effects ids chain
+    std::unordered_map<std::string, std::unique_ptr<Shader>> fusedShaders;
 };
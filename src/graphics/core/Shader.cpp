@@ -12,6 +12,7 @@
 
 #include "coders/GLSLExtension.hpp"
 #include "debug/Logger.hpp"
+#include "shader_cache.hpp"
 
 static debug::Logger logger("gl-shader");
 
@@ -154,6 +155,15 @@ static GLuint compile_program(
             .code
     );
 
+    static const bool cacheSupported = shader_cache::is_supported();
+    uint64_t cacheKey = 0;
+    if (cacheSupported) {
+        cacheKey = shader_cache::compute_key(vertexCode, fragmentCode, defines);
+        if (GLuint program = shader_cache::load(cacheKey)) {
+            return program;
+        }
+    }
+
     const GLchar* vCode = vertexCode.c_str();
     const GLchar* fCode = fragmentCode.c_str();
 
@@ -167,6 +177,11 @@ static GLuint compile_program(
     GLuint program = glCreateProgram();
     glAttachShader(program, *vertex);
     glAttachShader(program, *fragment);
+    if (cacheSupported) {
+        glProgramParameteri(
+            program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE
+        );
+    }
     glLinkProgram(program);
 
     glGetProgramiv(program, GL_LINK_STATUS, &success);
@@ -178,6 +193,9 @@ static GLuint compile_program(
             "shader program linking failed:\n" + std::string(infoLog)
         );
     }
+    if (cacheSupported) {
+        shader_cache::save(cacheKey, program);
+    }
     return program;
 }
 
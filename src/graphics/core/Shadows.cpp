@@ -8,6 +8,7 @@
 #include <GL/glew.h>
 
 #include "assets/Assets.hpp"
+#include "debug/Memory.hpp"
 #include "graphics/core/DrawContext.hpp"
 #include "graphics/core/Shader.hpp"
 #include "graphics/core/commons.hpp"
@@ -46,11 +47,13 @@ public:
         glDrawBuffer(GL_NONE);
         glReadBuffer(GL_NONE);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        debug::memory::add(debug::MemoryTag::SHADOW_MAPS, memoryUsage());
     }
 
     ~ShadowMap() {
         glDeleteFramebuffers(1, &fbo);
         glDeleteTextures(1, &depthMap);
+        debug::memory::add(debug::MemoryTag::SHADOW_MAPS, -memoryUsage());
     }
 
     void bind(){
@@ -68,6 +71,11 @@ public:
         return resolution;
     }
 private:
+    /// @return depth map size estimation in bytes
+    int64_t memoryUsage() const {
+        return static_cast<int64_t>(resolution) * resolution * 4;
+    }
+
     uint fbo;
     uint depthMap; 
     int resolution;
@@ -92,6 +100,9 @@ void Shadows::setQuality(int quality) {
         shadowMap = std::make_unique<ShadowMap>(resolution);
         wideShadowMap = std::make_unique<ShadowMap>(resolution);
     }
+    if (this->quality != quality) {
+        wideValid = false;
+    }
     this->quality = quality;
 }
 
@@ -103,7 +114,9 @@ void Shadows::setup(Shader& shader, const Weather& weather) {
     float cloudsIntensity = glm::max(worldInfo.fog, weather.clouds());
     float shadowsOpacity = 1.0f - cloudsIntensity;
     shadowsOpacity *= glm::sqrt(glm::abs(
-        glm::mod((worldInfo.daytime + 0.5f) * 2.0f, 1.0f) * 2.0f - 1.0f
+        glm::mod(
+            (level.getWorld()->getRenderDaytime() + 0.5f) * 2.0f, 1.0f
+        ) * 2.0f - 1.0f
     ));
     shader.uniform1i("u_screen", 0);
     shader.uniformMatrix("u_shadowsMatrix[0]", shadowCamera.getProjView());
@@ -127,6 +140,7 @@ void Shadows::setup(Shader& shader, const Weather& weather) {
 void Shadows::refresh(
     const Camera& camera,
     const DrawContext& pctx,
+    uint64_t revision,
     const std::function<void(Camera&)>& renderShadowPass
 ) {
     static int frameid = 0;
@@ -134,32 +148,43 @@ void Shadows::refresh(
         return;
     }
     if (frameid % 2 == 0) {
-        generateShadowsMap(
-            camera, pctx, *shadowMap, shadowCamera, 1.0f, renderShadowPass
-        );
-    } else {
         generateShadowsMap(
             camera,
             pctx,
-            *wideShadowMap,
-            wideShadowCamera,
-            3.0f,
+            *shadowMap,
+            shadowCamera,
+            1.0f,
+            false,
             renderShadowPass
         );
+    } else {
+        if (generateShadowsMap(
+                camera,
+                pctx,
+                *wideShadowMap,
+                wideShadowCamera,
+                3.0f,
+                wideValid && wideRevision == revision,
+                renderShadowPass
+            )) {
+            wideRevision = revision;
+            wideValid = true;
+        }
     }
     frameid++;
 }
 
-void Shadows::generateShadowsMap(
+bool Shadows::generateShadowsMap(
     const Camera& camera,
     const DrawContext& pctx,
     ShadowMap& shadowMap,
     Camera& shadowCamera,
     float scale,
+    bool reuse,
     const std::function<void(Camera&)>& renderShadowPass
 ) {
+    glm::mat4 prevProjView = shadowCamera.getProjView();
     auto world = level.getWorld();
-    const auto& worldInfo = world->getInfo();
 
     int resolution = shadowMap.getResolution();
     float shadowMapScale = 0.32f / (1 << glm::max(0, quality)) * scale;
@@ -176,7 +201,7 @@ void Shadows::generateShadowsMap(
     shadowCamera.perspective = false;
     shadowCamera.setAspectRatio(1.0f);
 
-    float t = worldInfo.daytime - 0.25f;
+    float t = world->getRenderDaytime() - 0.25f;
     t = glm::mod(t < 0.0f ? t + 1.0f : t, 0.5f);
 
     float sunCycleStep = 1.0f / 500.0f;
@@ -203,6 +228,9 @@ void Shadows::generateShadowsMap(
     auto max = view * glm::vec4(currentPos + topRight * shadowMapSize * 0.5f, 1.0f);
 
     shadowCamera.setProjection(glm::ortho(min.x, max.x, min.y, max.y, 0.1f, 1000.0f));
+    if (reuse && shadowCamera.getProjView() == prevProjView) {
+        return false;
+    }
 
     auto sctx = pctx.sub();
     sctx.setDepthTest(true);
@@ -213,4 +241,5 @@ void Shadows::generateShadowsMap(
         renderShadowPass(shadowCamera);
     }
     shadowMap.unbind();
+    return true;
 }
@@ -21,11 +21,18 @@ public:
 
     void setup(Shader& shader, const Weather& weather);
     void setQuality(int quality);
+    /// @param revision shadow casters revision. The wide shadow map is
+    /// not rendered again while it and the map camera stay unchanged
     void refresh(
         const Camera& camera,
         const DrawContext& pctx,
+        uint64_t revision,
         const std::function<void(Camera&)>& renderShadowPass
     );
+
+    bool isEnabled() const {
+        return shadows;
+    }
 private:
     const Level& level;
     bool shadows = false;
@@ -34,13 +41,20 @@ private:
     std::unique_ptr<ShadowMap> shadowMap;
     std::unique_ptr<ShadowMap> wideShadowMap;
     int quality = 0;
+    /// @brief Shadow casters revision of the wide shadow map
+    uint64_t wideRevision = 0;
+    bool wideValid = false;
 
-    void generateShadowsMap(
+    /// @param reuse keep the current shadow map content if the map camera
+    /// is unchanged
+    /// @return true if the shadow map has been rendered
+    bool generateShadowsMap(
         const Camera& camera,
         const DrawContext& pctx,
         ShadowMap& shadowMap,
         Camera& shadowCamera,
         float scale,
+        bool reuse,
         const std::function<void(Camera&)>& renderShadowPass
     );
 };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+
+#include "MeshData.hpp"
+
+/// @brief Vertex buffer for meshes rebuilt on every draw (batches).
+/// Vertices are written to a ring of SEGMENTS regions, so the data being
+/// read by previous draws is not overwritten and uploading does not wait
+/// for GPU. If supported, the buffer is persistently mapped and vertices
+/// are copied directly, with fences guarding reused regions
+template <typename VertexStructure>
+class StreamMesh {
+public:
+    static constexpr int SEGMENTS = 3;
+
+    /// @param capacity max vertices count of a single draw
+    explicit StreamMesh(size_t capacity);
+    ~StreamMesh();
+
+    StreamMesh(const StreamMesh&) = delete;
+
+    /// @brief Upload vertices and draw them with specified primitives type
+    /// @param count vertices count (not greater than capacity)
+    void draw(
+        const VertexStructure* vertices, size_t count, unsigned int primitive
+    );
+
+    /// @brief Upload vertices and draw them as triangles
+    void draw(const VertexStructure* vertices, size_t count);
+
+    bool isPersistent() const {
+        return mapped != nullptr;
+    }
+
+    /// @brief Check if current GL context supports persistent mapping
+    static bool isPersistentSupported();
+private:
+    unsigned int vao;
+    unsigned int vbo;
+    size_t capacity;
+    /// @brief Mapped buffer (nullptr if not mapped)
+    VertexStructure* mapped = nullptr;
+    /// @brief GLsync fences of segments being read by GPU
+    std::array<void*, SEGMENTS> fences {};
+    int segment = 0;
+    /// @brief Write offset in the current segment
+    size_t offset = 0;
+
+    /// @brief Switch to the next segment, waiting until GPU finishes
+    /// reading it
+    void nextSegment();
+};
+
+#include "graphics/core/StreamMesh.inl"
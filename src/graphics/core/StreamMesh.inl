@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstring>
+#include <algorithm>
+
+#include "Mesh.hpp"
+#include "gl_util.hpp"
+
+template <typename VertexStructure>
+StreamMesh<VertexStructure>::StreamMesh(size_t capacity)
+    : vao(0), vbo(0), capacity(capacity) {
+    static_assert(
+        calc_size(VertexStructure::ATTRIBUTES) == sizeof(VertexStructure)
+    );
+    MeshStats::meshesCount++;
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    size_t size = capacity * SEGMENTS * sizeof(VertexStructure);
+    if (isPersistentSupported()) {
+        GLbitfield flags =
+            GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+        mapped = static_cast<VertexStructure*>(
+            glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags)
+        );
+    }
+    if (mapped == nullptr) {
+        glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    }
+    setup_vertex_attributes<VertexStructure>();
+    glBindVertexArray(0);
+}
+
+template <typename VertexStructure>
+StreamMesh<VertexStructure>::~StreamMesh() {
+    MeshStats::meshesCount--;
+    for (auto fence : fences) {
+        if (fence) {
+            glDeleteSync(static_cast<GLsync>(fence));
+        }
+    }
+    if (mapped) {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+}
+
+template <typename VertexStructure>
+void StreamMesh<VertexStructure>::nextSegment() {
+    // GPU may be still reading the segment being left
+    if (mapped) {
+        fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    segment = (segment + 1) % SEGMENTS;
+    offset = 0;
+
+    if (mapped == nullptr) {
+        if (segment == 0) {
+            // orphan the storage instead of waiting for previous draws
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            glBufferData(
+                GL_ARRAY_BUFFER,
+                capacity * SEGMENTS * sizeof(VertexStructure),
+                nullptr,
+                GL_STREAM_DRAW
+            );
+        }
+        return;
+    }
+    auto fence = static_cast<GLsync>(fences[segment]);
+    if (fence == nullptr) {
+        return;
+    }
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    while (status == GL_TIMEOUT_EXPIRED) {
+        status = glClientWaitSync(
+            fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000
+        );
+    }
+    glDeleteSync(fence);
+    fences[segment] = nullptr;
+}
+
+template <typename VertexStructure>
+void StreamMesh<VertexStructure>::draw(
+    const VertexStructure* vertices, size_t count, unsigned int primitive
+) {
+    if (count == 0) {
+        return;
+    }
+    count = std::min(count, capacity);
+    if (offset + count > capacity) {
+        nextSegment();
+    }
+    size_t first = segment * capacity + offset;
+    if (mapped) {
+        std::memcpy(
+            mapped + first, vertices, count * sizeof(VertexStructure)
+        );
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferSubData(
+            GL_ARRAY_BUFFER,
+            first * sizeof(VertexStructure),
+            count * sizeof(VertexStructure),
+            vertices
+        );
+    }
+    offset += count;
+
+    MeshStats::drawCalls++;
+    glBindVertexArray(vao);
+    glDrawArrays(primitive, first, count);
+    glBindVertexArray(0);
+}
+
+template <typename VertexStructure>
+void StreamMesh<VertexStructure>::draw(
+    const VertexStructure* vertices, size_t count
+) {
+    draw(vertices, count, GL_TRIANGLES);
+}
+
+template <typename VertexStructure>
+bool StreamMesh<VertexStructure>::isPersistentSupported() {
+    return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+}
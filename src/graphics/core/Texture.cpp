@@ -1,7 +1,10 @@
 #include "Texture.hpp"
 #include "gl_util.hpp"
+#include "coders/bcn.hpp"
+#include "debug/Memory.hpp"
 
 #include <GL/glew.h>
+#include <algorithm>
 #include <stdexcept>
 #include <memory>
 
@@ -9,6 +12,7 @@ uint Texture::MAX_RESOLUTION = 1024; // Window.initialize overrides it
 
 Texture::Texture(uint id, uint width, uint height) 
     : id(id), width(width), height(height) {
+    setMemoryUsage(static_cast<size_t>(width) * height * 4);
 }
 
 Texture::Texture(const ubyte* data, uint width, uint height, ImageFormat imageFormat) 
@@ -27,10 +31,93 @@ Texture::Texture(const ubyte* data, uint width, uint height, ImageFormat imageFo
     glGenerateMipmap(GL_TEXTURE_2D);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1);
     glBindTexture(GL_TEXTURE_2D, 0);
+    mipLevels = 2;
+    // the second level is a quarter of the base one
+    setMemoryUsage(static_cast<size_t>(width) * height * 4 * 5 / 4);
+}
+
+Texture::Texture(const bcn::CompressedImage& image)
+    : width(image.width), height(image.height) {
+    GLenum format = image.format == bcn::Format::BC1
+                        ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+                        : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    uint levelWidth = width;
+    uint levelHeight = height;
+    for (size_t level = 0; level < image.levels.size(); level++) {
+        const auto& data = image.levels[level];
+        glCompressedTexImage2D(
+            GL_TEXTURE_2D,
+            level,
+            format,
+            levelWidth,
+            levelHeight,
+            0,
+            data.size(),
+            data.data()
+        );
+        levelWidth = std::max(1u, levelWidth / 2);
+        levelHeight = std::max(1u, levelHeight / 2);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(
+        GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.levels.size() - 1
+    );
+    glBindTexture(GL_TEXTURE_2D, 0);
+    mipLevels = image.levels.size();
+
+    size_t size = 0;
+    for (const auto& data : image.levels) {
+        size += data.size();
+    }
+    setMemoryUsage(size);
+}
+
+Texture::Texture(const std::vector<const ImageData*>& levels)
+    : width(levels.at(0)->getWidth()), height(levels.at(0)->getHeight()) {
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t level = 0; level < levels.size(); level++) {
+        const auto& image = *levels[level];
+        glTexImage2D(
+            GL_TEXTURE_2D,
+            level,
+            GL_RGBA,
+            image.getWidth(),
+            image.getHeight(),
+            0,
+            GL_RGBA,
+            GL_UNSIGNED_BYTE,
+            image.getData()
+        );
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels.size() - 1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    mipLevels = levels.size();
+
+    size_t size = 0;
+    for (const auto& image : levels) {
+        size += static_cast<size_t>(image->getWidth()) * image->getHeight() * 4;
+    }
+    setMemoryUsage(size);
 }
 
 Texture::~Texture() {
     glDeleteTextures(1, &id);
+    setMemoryUsage(0);
+}
+
+void Texture::setMemoryUsage(size_t bytes) {
+    debug::memory::add(
+        memoryTag,
+        static_cast<int64_t>(bytes) - static_cast<int64_t>(memoryUsage)
+    );
+    memoryUsage = bytes;
 }
 
 void Texture::bind() const {
@@ -53,6 +140,8 @@ void Texture::reload(const ubyte* data, uint width, uint height) {
         GL_RGBA, GL_UNSIGNED_BYTE, static_cast<const GLvoid*>(data));
     glGenerateMipmap(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, 0);
+    // full mipmaps chain takes a third of the base level
+    setMemoryUsage(static_cast<size_t>(width) * height * 4 * 4 / 3);
 }
 
 void Texture::reloadPartial(const ImageData& image, uint x, uint y, uint w, uint h) {
@@ -62,6 +151,30 @@ void Texture::reloadPartial(const ImageData& image, uint x, uint y, uint w, uint
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
+void Texture::reloadRegion(const ImageData& image, const ImageRegion& region) {
+    glBindTexture(GL_TEXTURE_2D, id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, image.getWidth());
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, region.x);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, region.y);
+    glTexSubImage2D(
+        GL_TEXTURE_2D,
+        0,
+        region.x,
+        region.y,
+        region.w,
+        region.h,
+        gl::to_glenum(image.getFormat()),
+        GL_UNSIGNED_BYTE,
+        image.getData()
+    );
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 std::unique_ptr<ImageData> Texture::readData() {
     auto data = std::make_unique<ubyte[]>(width * height * 4);
     glBindTexture(GL_TEXTURE_2D, id);
@@ -72,6 +185,19 @@ std::unique_ptr<ImageData> Texture::readData() {
     );
 }
 
+void Texture::setMemoryTag(debug::MemoryTag tag) {
+    size_t usage = memoryUsage;
+    setMemoryUsage(0);
+    memoryTag = tag;
+    setMemoryUsage(usage);
+}
+
+void Texture::setLodBias(float bias) {
+    bind();
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, bias);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 void Texture::setNearestFilter() {
     bind();
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -106,6 +232,10 @@ std::unique_ptr<Texture> Texture::from(const ImageData* image) {
     );
 }
 
+bool Texture::isCompressionSupported() {
+    return GLEW_EXT_texture_compression_s3tc;
+}
+
 uint Texture::getId() const {
     return id;
 }
@@ -3,23 +3,46 @@
 #include "typedefs.hpp"
 #include "maths/UVRegion.hpp"
 #include "ImageData.hpp"
+#include "debug/Memory.hpp"
 
 #include <memory>
+#include <vector>
+
+namespace bcn {
+    struct CompressedImage;
+}
 
 class Texture {
 protected:
     uint id;
     uint width;
     uint height;
+    /// @brief Number of used mip levels including the base one
+    uint mipLevels = 1;
+    /// @brief Estimated video memory usage in bytes
+    size_t memoryUsage = 0;
+    /// @brief Video memory consumer the usage is accounted for
+    debug::MemoryTag memoryTag = debug::MemoryTag::TEXTURES;
+
+    /// @brief Update estimated video memory usage (see debug::memory)
+    void setMemoryUsage(size_t bytes);
 public:
     Texture(uint id, uint width, uint height);
     Texture(const ubyte* data, uint width, uint height, ImageFormat format);
+    /// @brief Create texture from block compressed mip levels
+    Texture(const bcn::CompressedImage& image);
+    /// @brief Create texture from RGBA8888 mip levels starting with the
+    /// base one
+    explicit Texture(const std::vector<const ImageData*>& levels);
     virtual ~Texture();
 
     virtual void bind() const;
     virtual void unbind() const;
     void reload(const ubyte* data, uint w, uint h);
     void reloadPartial(const ImageData& image, uint x, uint y, uint w, uint h);
+    /// @brief Upload rectangle of the image of the texture size to the
+    /// same position of the texture
+    void reloadRegion(const ImageData& image, const ImageRegion& region);
 
     void setNearestFilter();
 
@@ -27,6 +50,14 @@ public:
 
     void setMipMapping(bool flag, bool pixelated);
 
+    /// @brief Set bias added to the mip level selected on sampling
+    /// (positive values select smaller levels)
+    void setLodBias(float bias);
+
+    /// @brief Account the texture memory usage for another consumer
+    /// (e.g. framebuffer attachments)
+    void setMemoryTag(debug::MemoryTag tag);
+
     std::unique_ptr<ImageData> readData();
     uint getId() const;
 
@@ -42,6 +73,13 @@ public:
         return height;
     }
 
+    uint getMipLevels() const {
+        return mipLevels;
+    }
+
     static std::unique_ptr<Texture> from(const ImageData* image);
+
+    /// @return true if S3TC (BC1, BC3) textures are supported by driver
+    static bool isCompressionSupported();
     static uint MAX_RESOLUTION;
 };
@@ -3,6 +3,7 @@
 #include "Framebuffer.hpp"
 
 #include <GL/glew.h>
+#include <algorithm>
 #include <unordered_set>
 
 TextureAnimator::TextureAnimator() {
@@ -21,10 +22,35 @@ void TextureAnimator::addAnimations(const std::vector<TextureAnimation>& animati
     }
 }
 
-void TextureAnimator::update(float delta) {
-    std::unordered_set<uint> changedTextures;
+/// @brief Blit current frame of the animation at the mip level.
+/// Framebuffers must be bound with the animation textures attached
+static void blit_frame(const TextureAnimation& animation, uint level) {
+    const auto& frame = animation.frames[animation.currentFrame];
+    // vertical flip
+    int srcPosY =
+        animation.srcTexture->getHeight() - frame.size.y - frame.srcPos.y;
+    int srcX = frame.srcPos.x >> level;
+    int srcY = srcPosY >> level;
+    int dstX = frame.dstPos.x >> level;
+    int dstY = frame.dstPos.y >> level;
+    int width = frame.size.x >> level;
+    int height = frame.size.y >> level;
+    if (width == 0 || height == 0) {
+        return;
+    }
+    glBlitFramebuffer(
+        srcX, srcY,
+        srcX + width, srcY + height,
+        dstX, dstY,
+        dstX + width, dstY + height,
+        GL_COLOR_BUFFER_BIT, GL_NEAREST
+    );
+}
 
-    for (auto& elem : animations) {
+void TextureAnimator::update(float delta) {
+    changed.clear();
+    for (size_t i = 0; i < animations.size(); i++) {
+        auto& elem = animations[i];
         if (elem.frames.empty()) {
             continue;
         }
@@ -37,38 +63,57 @@ void TextureAnimator::update(float delta) {
             if (elem.currentFrame >= elem.frames.size()) elem.currentFrame = 0;
             frame = elem.frames[elem.currentFrame];
         }
-        if (frameNum != elem.currentFrame){
-            uint elemDstId = elem.dstTexture->getId();
-            uint elemSrcId = elem.srcTexture->getId();
-
-            changedTextures.insert(elemDstId);
-
-            glBindFramebuffer(GL_FRAMEBUFFER, fboD);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, elemDstId, 0);
-
-            glBindFramebuffer(GL_FRAMEBUFFER, fboR);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, elemSrcId, 0);
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fboD);
+        if (frameNum != elem.currentFrame) {
+            changed.push_back(i);
+        }
+    }
+    if (changed.empty()) {
+        return;
+    }
+    // animations of the same textures are drawn with the same attachments
+    std::sort(changed.begin(), changed.end(), [this](size_t a, size_t b) {
+        const auto& first = animations[a];
+        const auto& second = animations[b];
+        if (first.srcTexture != second.srcTexture) {
+            return first.srcTexture < second.srcTexture;
+        }
+        return first.dstTexture < second.dstTexture;
+    });
+    std::unordered_set<uint> changedTextures;
+    for (size_t begin = 0; begin < changed.size();) {
+        const auto& first = animations[changed[begin]];
+        size_t end = begin + 1;
+        while (end < changed.size() &&
+               animations[changed[end]].srcTexture == first.srcTexture &&
+               animations[changed[end]].dstTexture == first.dstTexture) {
+            end++;
+        }
+        uint srcId = first.srcTexture->getId();
+        uint dstId = first.dstTexture->getId();
+        uint dstLevels = first.dstTexture->getMipLevels();
+        uint levels = std::min(first.srcTexture->getMipLevels(), dstLevels);
+        for (uint level = 0; level < levels; level++) {
             glBindFramebuffer(GL_READ_FRAMEBUFFER, fboR);
-
-            float srcPosY = elem.srcTexture->getHeight() - frame.size.y - frame.srcPos.y; // vertical flip
-
-            glBlitFramebuffer(
-                frame.srcPos.x, srcPosY,
-                frame.srcPos.x + frame.size.x,    
-                srcPosY + frame.size.y,
-                frame.dstPos.x, frame.dstPos.y,    
-                frame.dstPos.x + frame.size.x,
-                frame.dstPos.y + frame.size.y,
-                GL_COLOR_BUFFER_BIT, GL_NEAREST
+            glFramebufferTexture2D(
+                GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                srcId, level
             );
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fboD);
+            glFramebufferTexture2D(
+                GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                dstId, level
+            );
+            for (size_t i = begin; i < end; i++) {
+                blit_frame(animations[changed[i]], level);
+            }
+        }
+        if (levels < dstLevels) {
+            changedTextures.insert(dstId);
         }
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        begin = end;
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // source texture has less mip levels than destination one
     for (auto& elem : changedTextures) {
         glBindTexture(GL_TEXTURE_2D, elem);
         glGenerateMipmap(GL_TEXTURE_2D);
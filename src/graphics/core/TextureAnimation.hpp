@@ -40,10 +40,15 @@ public:
     void addAnimation(const TextureAnimation& animation) { animations.emplace_back(animation); };
     void addAnimations(const std::vector<TextureAnimation>& animations);
 
+    /// @brief Advance animations and draw changed frames to all mip levels
+    /// of the destination textures (source textures having the same mip
+    /// levels are required to not regenerate destination mipmaps)
     void update(float delta);
 private:
     uint fboR;
     uint fboD;
 
     std::vector<TextureAnimation> animations;
+    /// @brief Indices of animations with frame changed in update (reused)
+    std::vector<size_t> changed;
 };
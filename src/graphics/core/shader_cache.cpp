@@ -0,0 +1,122 @@
+#include "shader_cache.hpp"
+
+#include <GL/glew.h>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include "coders/byte_utils.hpp"
+#include "debug/Logger.hpp"
+#include "io/io.hpp"
+#include "util/Hasher.hpp"
+
+static debug::Logger logger("shader-cache");
+
+static const io::path CACHE_FOLDER = "user:cache/shaders";
+static constexpr const char* CACHE_MAGIC = ".VCSHADR";
+static constexpr int CACHE_MAGIC_SIZE = 8;
+static constexpr int CACHE_VERSION = 1;
+
+static io::path get_cache_file(uint64_t key) {
+    std::stringstream ss;
+    ss << std::hex << std::setfill('0') << std::setw(16) << key << ".bin";
+    return CACHE_FOLDER / ss.str();
+}
+
+static std::string get_gl_string(GLenum name) {
+    auto string = reinterpret_cast<const char*>(glGetString(name));
+    return string ? string : "";
+}
+
+bool shader_cache::is_supported() {
+    if (!GLEW_ARB_get_program_binary) {
+        return false;
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+uint64_t shader_cache::compute_key(
+    const std::string& vertexCode,
+    const std::string& fragmentCode,
+    const std::vector<std::string>& defines
+) {
+    util::Hasher hasher;
+    hasher.update(CACHE_VERSION);
+    hasher.update(get_gl_string(GL_VENDOR));
+    hasher.update(get_gl_string(GL_RENDERER));
+    hasher.update(get_gl_string(GL_VERSION));
+    hasher.update(vertexCode);
+    hasher.update(fragmentCode);
+    hasher.update(static_cast<uint64_t>(defines.size()));
+    for (const auto& define : defines) {
+        hasher.update(define);
+    }
+    return hasher.get();
+}
+
+uint shader_cache::load(uint64_t key) {
+    auto file = get_cache_file(key);
+    if (!io::is_regular_file(file)) {
+        return 0;
+    }
+    try {
+        auto bytes = io::read_bytes_buffer(file);
+        ByteReader reader(bytes.data(), bytes.size());
+        reader.checkMagic(CACHE_MAGIC, CACHE_MAGIC_SIZE);
+        if (reader.getInt32() != CACHE_VERSION ||
+            static_cast<uint64_t>(reader.getInt64()) != key) {
+            return 0;
+        }
+        GLenum format = reader.getInt32();
+        size_t length = reader.getInt32();
+        if (length > reader.remaining()) {
+            throw std::runtime_error("buffer underflow");
+        }
+        GLuint program = glCreateProgram();
+        glProgramBinary(program, format, reader.pointer(), length);
+
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            // driver changed binary format, so compile sources instead
+            glDeleteProgram(program);
+            logger.info() << "cached program is rejected by driver";
+            return 0;
+        }
+        return program;
+    } catch (const std::runtime_error& err) {
+        logger.error() << "could not read " << file.string() << ": "
+                       << err.what();
+        return 0;
+    }
+}
+
+void shader_cache::save(uint64_t key, uint program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<ubyte> binary(length);
+    GLenum format;
+    glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+    ByteBuilder builder;
+    builder.put(reinterpret_cast<const ubyte*>(CACHE_MAGIC), CACHE_MAGIC_SIZE);
+    builder.putInt32(CACHE_VERSION);
+    builder.putInt64(static_cast<int64_t>(key));
+    builder.putInt32(format);
+    builder.putInt32(length);
+    builder.put(binary.data(), binary.size());
+
+    auto file = get_cache_file(key);
+    try {
+        io::create_directories(CACHE_FOLDER);
+        io::write_bytes(file, builder.data(), builder.size());
+    } catch (const std::runtime_error& err) {
+        logger.error() << "could not write " << file.string() << ": "
+                       << err.what();
+    }
+}
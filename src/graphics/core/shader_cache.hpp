@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "typedefs.hpp"
+
+/// @brief On-disk cache of linked shader program binaries, so warm start
+/// and defines changes don't compile and link GLSL sources again
+namespace shader_cache {
+    /// @return true if driver supports program binaries
+    bool is_supported();
+
+    /// @brief Compute cache key of preprocessed program sources. Driver
+    /// vendor, renderer and version are included, so cache is invalidated
+    /// on driver update
+    uint64_t compute_key(
+        const std::string& vertexCode,
+        const std::string& fragmentCode,
+        const std::vector<std::string>& defines
+    );
+
+    /// @brief Create program from cached binary
+    /// @param key preprocessed sources key
+    /// @return 0 if cache entry is missing or rejected by the driver
+    uint load(uint64_t key);
+
+    /// @brief Write linked program binary to cache
+    /// @param key preprocessed sources key
+    /// @param program linked program created with retrievable binary hint
+    void save(uint64_t key, uint program);
+}
@@ -42,8 +42,10 @@ void BlockWrapsRenderer::draw(BlockWrapper& wrapper, const Texture* texture) {
         return;
     }
 
-    const voxel* vox = chunks.get(wrapper.position);
-    if (vox == nullptr || vox->id == BLOCK_VOID) {
+    auto vox = chunks.getVoxel(
+        wrapper.position.x, wrapper.position.y, wrapper.position.z
+    );
+    if (!vox || vox->id == BLOCK_VOID) {
         return;
     }
     // one frame can be invalid due to texture change but ok
@@ -108,8 +110,10 @@ void BlockWrapsRenderer::refreshWrapper(BlockWrapper& wrapper) {
     }
     wrapper.dirtySides = 0x0;
 
-    const voxel* vox = chunks.get(wrapper.position);
-    if (vox == nullptr || vox->id == BLOCK_VOID) {
+    auto vox = chunks.getVoxel(
+        wrapper.position.x, wrapper.position.y, wrapper.position.z
+    );
+    if (!vox || vox->id == BLOCK_VOID) {
         return;
     }
     const auto& def = level.content.getIndices()->blocks.require(vox->id);
@@ -1,6 +1,7 @@
 #include "BlocksPreview.hpp"
 
 #include "assets/Assets.hpp"
+#include "assets/atlas_cache.hpp"
 #include "constants.hpp"
 #include "content/Content.hpp"
 #include "frontend/ContentGfxCache.hpp"
@@ -13,19 +14,26 @@
 #include "graphics/core/DrawContext.hpp"
 #include "graphics/core/Shader.hpp"
 #include "graphics/core/Texture.hpp"
+#include "graphics/core/ImageData.hpp"
 #include "graphics/commons/Model.hpp"
+#include "util/Hasher.hpp"
 
+#include <GL/glew.h>
 #include <glm/ext.hpp>
 
-std::unique_ptr<ImageData> BlocksPreview::draw(
+/// @brief Max framebuffer size used to render icons in one pass
+static constexpr uint MAX_PASS_SIZE = 2048;
+/// @brief Icons cache format version, changed on draw modifications
+static constexpr int CACHE_VERSION = 1;
+static const std::string CACHE_NAME = "block-previews";
+
+void BlocksPreview::draw(
     const ContentGfxCache& cache,
     Shader& shader,
-    const Framebuffer& fbo,
     Batch3D& batch,
     const Block& def, 
     int size
 ){
-    display::clear();
     blockid_t id = def.rt.id;
     const UVRegion texfaces[6] {
         cache.getRegion(id, 0, 0, true), cache.getRegion(id, 0, 1, true),
@@ -94,7 +102,41 @@ std::unique_ptr<ImageData> BlocksPreview::draw(
             break;
         }
     }
-    return fbo.getTexture()->readData();
+}
+
+uint64_t BlocksPreview::computeKey(
+    const ContentGfxCache& cache,
+    const Atlas& atlas,
+    const ContentIndices& indices
+) {
+    util::Hasher hasher;
+    hasher.update(CACHE_VERSION);
+    hasher.update(ITEM_ICON_SIZE);
+    if (auto image = atlas.getImage()) {
+        hasher.update(image->getData(), image->getDataSize());
+    }
+    size_t count = indices.blocks.count();
+    for (size_t i = 0; i < count; i++) {
+        const auto& def = indices.blocks.require(i);
+        blockid_t id = def.rt.id;
+        hasher.update(def.name);
+        hasher.update(static_cast<int>(def.defaults.model.type));
+        hasher.update(def.rt.emissive);
+        for (int face = 0; face < 6; face++) {
+            const auto& region = cache.getRegion(id, 0, face, true);
+            hasher.update(&region, sizeof(UVRegion));
+        }
+        hasher.update(
+            def.hitboxes.data(), def.hitboxes.size() * sizeof(AABB)
+        );
+        if (def.defaults.model.type == BlockModelType::CUSTOM) {
+            for (const auto& mesh : cache.getModel(id, 0).meshes) {
+                hasher.update(mesh.vertices.data(),
+                              mesh.vertices.size() * sizeof(mesh.vertices[0]));
+            }
+        }
+    }
+    return hasher.get();
 }
 
 std::unique_ptr<Atlas> BlocksPreview::build(
@@ -104,17 +146,32 @@ std::unique_ptr<Atlas> BlocksPreview::build(
     const ContentIndices& indices
 ) {
     size_t count = indices.blocks.count();
-    size_t iconSize = ITEM_ICON_SIZE;
+    uint iconSize = ITEM_ICON_SIZE;
 
     auto& shader = assets.require<Shader>("ui3d");
     const auto& atlas = assets.require<Atlas>("blocks");
 
+    uint64_t key = computeKey(cache, atlas, indices);
+    if (auto cached = atlas_cache::load(CACHE_NAME, key)) {
+        cached->prepare();
+        return cached;
+    }
+
+    // icons are drawn into cells of a grid, one viewport per cell,
+    // and read back once per pass
+    uint columns = std::min<size_t>(count, MAX_PASS_SIZE / iconSize);
+    columns = std::max(1u, columns);
+    uint rows = std::min<size_t>(
+        (count + columns - 1) / columns, MAX_PASS_SIZE / iconSize
+    );
+    rows = std::max(1u, rows);
+
     DrawContext pctx(nullptr, window, nullptr);
     DrawContext ctx = pctx.sub();
     ctx.setCullFace(true);
     ctx.setDepthTest(true);
 
-    Framebuffer fbo(iconSize, iconSize, true);
+    Framebuffer fbo(columns * iconSize, rows * iconSize, true);
     Batch3D batch(1024);
     batch.begin();
 
@@ -127,15 +184,41 @@ std::unique_ptr<Atlas> BlocksPreview::build(
                     glm::vec3(0, 1, 0)));
 
     AtlasBuilder builder;
-    ctx.setViewport({iconSize, iconSize});
+    ctx.setViewport({columns * iconSize, rows * iconSize});
     display::setBgColor(glm::vec4(0.0f));
     
     fbo.bind();
-    for (size_t i = 0; i < count; i++) {
-        auto& def = indices.blocks.require(i);
-        atlas.getTexture()->bind();
-        builder.add(def.name, draw(cache, shader, fbo, batch, def, iconSize));
+    atlas.getTexture()->bind();
+    for (size_t first = 0; first < count; first += columns * rows) {
+        size_t last = std::min<size_t>(count, first + columns * rows);
+        glViewport(0, 0, columns * iconSize, rows * iconSize);
+        display::clear();
+        for (size_t i = first; i < last; i++) {
+            uint cell = i - first;
+            glViewport(
+                cell % columns * iconSize,
+                cell / columns * iconSize,
+                iconSize,
+                iconSize
+            );
+            draw(cache, shader, batch, indices.blocks.require(i), iconSize);
+        }
+        auto image = fbo.getTexture()->readData();
+        for (size_t i = first; i < last; i++) {
+            uint cell = i - first;
+            builder.add(
+                indices.blocks.require(i).name,
+                image->cropped(
+                    cell % columns * iconSize,
+                    cell / columns * iconSize,
+                    iconSize,
+                    iconSize
+                )
+            );
+        }
     }
     fbo.unbind();
-    return builder.build(ATLAS_EXTRUSION);
+    auto previews = builder.build(ATLAS_EXTRUSION);
+    atlas_cache::save(CACHE_NAME, key, *previews);
+    return previews;
 }
@@ -17,15 +17,25 @@ class Window;
 class ContentGfxCache;
 
 class BlocksPreview {
-    static std::unique_ptr<ImageData> draw(
+    /// @brief Draw block icon into the current viewport
+    static void draw(
         const ContentGfxCache& cache,
         Shader& shader,
-        const Framebuffer& framebuffer,
         Batch3D& batch,
         const Block& block, 
         int size
     );
+
+    /// @brief Compute icons cache key of all draw inputs
+    static uint64_t computeKey(
+        const ContentGfxCache& cache,
+        const Atlas& atlas,
+        const ContentIndices& indices
+    );
 public:
+    /// @brief Build block icons atlas. Icons are drawn in batches of
+    /// framebuffer passes or loaded from the icons cache if content
+    /// is not changed
     static std::unique_ptr<Atlas> build(
         Window& window,
         const ContentGfxCache& cache,
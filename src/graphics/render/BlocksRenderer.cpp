@@ -9,6 +9,10 @@
 #include "lighting/Lightmap.hpp"
 #include "frontend/ContentGfxCache.hpp"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
 const glm::vec3 BlocksRenderer::SUN_VECTOR(0.528265, 0.833149, -0.163704);
 const float DIRECTIONAL_LIGHT_FACTOR = 0.3f;
 
@@ -25,10 +29,41 @@ BlocksRenderer::BlocksRenderer(
     vertexOffset(0),
     indexCount(0),
     capacity(capacity),
+    volumeCulling(std::make_unique<uint16_t[]>(VoxelsRenderVolume::size)),
+    expandedLights(std::make_unique<uint32_t[]>(
+        SOFT_LIGHTS_LAYERS * VoxelsRenderVolume::width *
+        VoxelsRenderVolume::depth
+    )),
+    softLights(std::make_unique<uint32_t[]>(
+        3 * SOFT_LIGHTS_LAYERS * VoxelsRenderVolume::width *
+        VoxelsRenderVolume::depth
+    )),
+    chunkVoxels(std::make_unique<voxel[]>(CHUNK_VOL)),
     cache(cache),
     settings(settings)
 {
-    blockDefsCache = content.getIndices()->blocks.getDefs();
+    const auto& blocks = content.getIndices()->blocks;
+    blockDefsCache = blocks.getDefs();
+
+    blocksCulling.resize(blocks.count());
+    for (size_t id = 0; id < blocks.count(); id++) {
+        const auto& def = *blockDefsCache[id];
+        auto& culling = blocksCulling[id];
+        if (def.variants) {
+            culling.variantsOffset = def.variants->offset;
+            culling.variantsMask = def.variants->mask;
+        }
+        for (int i = 0; i < BLOCK_MAX_VARIANTS; i++) {
+            const auto& variant =
+                i == 0 || def.variants == nullptr ||
+                        i >= def.variants->variants.size()
+                    ? def.defaults
+                    : def.variants->variants[i];
+            culling.variants[i] = variant.drawGroup |
+                                  (variant.rt.solid ? CULLING_SOLID : 0) |
+                                  (id == 0 ? CULLING_EMPTY : 0);
+        }
+    }
 }
 
 BlocksRenderer::~BlocksRenderer() = default;
@@ -56,7 +91,8 @@ void BlocksRenderer::vertex(
             static_cast<uint8_t>(normal.y * 127 + 128),
             static_cast<uint8_t>(normal.z * 127 + 128),
             static_cast<uint8_t>(emission * 255)
-        }
+        },
+        {}
     };
 }
 
@@ -318,64 +354,47 @@ void BlocksRenderer::blockCustomModel(
         );
     }
 
-    const auto& model = cache.getModel(block.rt.id, block.getVariantIndex(states.userbits));
-    for (const auto& mesh : model.meshes) {
-        if (vertexCount + mesh.vertices.size() >= capacity
-            || indexCount + mesh.vertices.size() >= capacity) {
+    const auto& model = cache.getRotatedModel(
+        block.rt.id,
+        block.getVariantIndex(states.userbits),
+        block.rotatable ? states.rotation : 0
+    );
+    for (const auto& mesh : model) {
+        if (vertexCount + mesh.triangles.size() * 3 >= capacity
+            || indexCount + mesh.triangles.size() * 3 >= capacity) {
             overflow = true;
             return;
         }
         bool shading = mesh.shading && !block.shadeless;
 
-        int trianglesCount = mesh.vertices.size() / 3;
-        for (int triangle = 0; triangle < trianglesCount; triangle++) {
-            auto r = mesh.vertices[triangle * 3 + (triangle % 2) * 2].coord -
-                     mesh.vertices[triangle * 3 + 1].coord;
-            r = r.x * X + r.y * Y + r.z * Z;
-            r = glm::normalize(r);
-
-            const auto& v0 = mesh.vertices[triangle * 3];
-            auto n = v0.normal.x * X + v0.normal.y * Y + v0.normal.z * Z;
-
-            auto vp = (mesh.vertices[triangle * 3].coord +
-                       mesh.vertices[triangle * 3 + 1].coord +
-                       mesh.vertices[triangle * 3 + 2].coord) *
-                          0.3333f -
-                      0.5f;
-            vp = vp.x * X + vp.y * Y + vp.z * Z;
-
+        for (const auto& triangle : mesh.triangles) {
             if (!block.rt.extended
-                && !isOpen(glm::floor(coord + vp + 0.5f + n * 1e-3f), block, variant)) {
+                && !isOpen(glm::floor(coord + triangle.facing), block, variant)) {
                 continue;
             }
-
+            const auto& n = triangle.normal;
             float d = glm::dot(n, SUN_VECTOR);
             d = (1.0f - DIRECTIONAL_LIGHT_FACTOR) + d * DIRECTIONAL_LIGHT_FACTOR;
-            glm::vec3 t = glm::cross(r, n);
-
-            for (int i = 0; i < 3; i++) {
-                const auto& vertex = mesh.vertices[triangle * 3 + i];
-                const auto& vcoord = vertex.coord - 0.5f;
 
+            for (const auto& vertex : triangle.vertices) {
                 glm::vec4 aoColor {1.0f, 1.0f, 1.0f, 1.0f};
                 if (shading && ao) {
-                    const float eps = 0.05f;
-                    auto p = coord + vcoord.x * X + vcoord.y * Y + vcoord.z * Z +
-                             r * 0.5f + t * 0.5f + n * eps;
-                    auto p1 = p + n * eps;
-                    auto p2 = p + n * 0.5f;
-                    aoColor = pickSoftLight(p1.x, p1.y, p1.z, glm::ivec3(r), glm::ivec3(t));
+                    auto p1 = coord + vertex.lightNear;
+                    aoColor = pickSoftLight(
+                        p1.x, p1.y, p1.z, triangle.right, triangle.up
+                    );
                     if (!block.lightPassing) {
+                        auto p2 = coord + vertex.lightFar;
                         aoColor = glm::max(
                             aoColor,
                             pickSoftLight(
-                                p2.x, p2.y, p2.z, glm::ivec3(r), glm::ivec3(t)
+                                p2.x, p2.y, p2.z, triangle.right, triangle.up
                             )
                         );
                     }
                 }
                 this->vertex(
-                    coord + vcoord.x * X + vcoord.y * Y + vcoord.z * Z,
+                    coord + vertex.position,
                     vertex.uv.x,
                     vertex.uv.y,
                     shading ? (glm::vec4(d, d, d, d) * aoColor) : glm::vec4(1, 1, 1, d),
@@ -451,6 +470,375 @@ void BlocksRenderer::blockCube(
     }
 }
 
+namespace {
+    /// @brief Cube face axes in texture faces order
+    struct CubeSide {
+        /// @brief Texture u direction, v direction and face normal
+        glm::ivec3 X, Y, Z;
+        /// @brief Indices of X, Y and Z axes
+        int u, v, n;
+    };
+
+    const CubeSide CUBE_SIDES[6] {
+        {{0, 0, 1}, {0, 1, 0}, {-1, 0, 0}, 2, 1, 0},
+        {{0, 0, -1}, {0, 1, 0}, {1, 0, 0}, 2, 1, 0},
+        {{1, 0, 0}, {0, 0, 1}, {0, -1, 0}, 0, 2, 1},
+        {{1, 0, 0}, {0, 0, -1}, {0, 1, 0}, 0, 2, 1},
+        {{-1, 0, 0}, {0, 1, 0}, {0, 0, -1}, 0, 1, 2},
+        {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, 0, 1, 2},
+    };
+
+    inline uint8_t to_color_byte(float value) {
+        return static_cast<uint8_t>(value * 255);
+    }
+
+    inline uint16_t to_region_short(float value) {
+        return static_cast<uint16_t>(std::round(value * 0xFFFF));
+    }
+
+    inline bool same_region(const UVRegion& a, const UVRegion& b) {
+        return a.u1 == b.u1 && a.v1 == b.v1 && a.u2 == b.u2 && a.v2 == b.v2;
+    }
+}
+
+void BlocksRenderer::blockCubeGreedy(
+    const glm::ivec3& coord,
+    const Block& block,
+    uint8_t variantId,
+    blockstate states,
+    bool lights,
+    bool ao
+) {
+    const auto& variant = block.getVariant(variantId);
+    for (int side = 0; side < 6; side++) {
+        const auto& cs = CUBE_SIDES[side];
+        if (!isOpen(coord + cs.Z, block, variant)) {
+            continue;
+        }
+        glm::vec3 X(cs.X);
+        glm::vec3 Y(cs.Y);
+        glm::vec3 Z(cs.Z);
+
+        glm::vec4 color(1.0f, 1.0f, 1.0f, ao ? 1.0f : 0.0f);
+        if (lights) {
+            float d = glm::dot(Z, SUN_VECTOR);
+            d = (1.0f - DIRECTIONAL_LIGHT_FACTOR) + d * DIRECTIONAL_LIGHT_FACTOR;
+            if (ao) {
+                // same sampling as in vertexAO
+                glm::vec3 offsets[4] {-X - Y, X - Y, X + Y, -X + Y};
+                glm::vec4 corners[4];
+                for (int i = 0; i < 4; i++) {
+                    auto pos = glm::vec3(coord) + (offsets[i] + Z) * 0.5f +
+                               Z * 0.5f + (X + Y) * 0.5f;
+                    corners[i] = pickSoftLight(
+                        glm::ivec3(
+                            std::round(pos.x), std::round(pos.y), std::round(pos.z)
+                        ),
+                        cs.X,
+                        cs.Y
+                    );
+                }
+                if (corners[0] != corners[1] || corners[0] != corners[2] ||
+                    corners[0] != corners[3]) {
+                    faceAO(
+                        coord,
+                        X,
+                        Y,
+                        Z,
+                        cache.getRegion(block.rt.id, variantId, side, densePass),
+                        lights
+                    );
+                    continue;
+                }
+                color = corners[0] * d;
+            } else {
+                color = pickLight(coord + cs.Z) * d;
+            }
+        }
+        auto& face = greedyFaces[
+            side * CHUNK_VOL + vox_index(coord.x, coord.y, coord.z)
+        ];
+        face.color = {
+            to_color_byte(color.r),
+            to_color_byte(color.g),
+            to_color_byte(color.b),
+            to_color_byte(color.a),
+        };
+        face.id = block.rt.id;
+        face.variant = variantId;
+        face.flags = lights ? 1 : 2;
+    }
+}
+
+void BlocksRenderer::faceGreedy(
+    const glm::vec3& coord,
+    const glm::vec3& axisX,
+    const glm::vec3& axisY,
+    const glm::vec3& axisZ,
+    int w, int h,
+    const UVRegion& region,
+    const GreedyFace& face
+) {
+    if (vertexCount + 4 >= capacity || indexCount + 6 >= capacity) {
+        overflow = true;
+        return;
+    }
+    float fw = static_cast<float>(w);
+    float fh = static_cast<float>(h);
+    auto X = axisX * fw;
+    auto Y = axisY * fh;
+    const std::array<uint8_t, 4> normal {
+        static_cast<uint8_t>(axisZ.x * 127 + 128),
+        static_cast<uint8_t>(axisZ.y * 127 + 128),
+        static_cast<uint8_t>(axisZ.z * 127 + 128),
+        static_cast<uint8_t>(face.flags == 2 ? 255 : 0),
+    };
+    const std::array<uint16_t, 4> tiling {
+        to_region_short(region.u1),
+        to_region_short(region.v1),
+        to_region_short(region.u2),
+        to_region_short(region.v2),
+    };
+    float s = 0.5f;
+    vertexBuffer[vertexCount++] = {
+        coord + (-X - Y + axisZ) * s, {0, 0}, face.color, normal, tiling};
+    vertexBuffer[vertexCount++] = {
+        coord + (X - Y + axisZ) * s, {fw, 0}, face.color, normal, tiling};
+    vertexBuffer[vertexCount++] = {
+        coord + (X + Y + axisZ) * s, {fw, fh}, face.color, normal, tiling};
+    vertexBuffer[vertexCount++] = {
+        coord + (-X + Y + axisZ) * s, {0, fh}, face.color, normal, tiling};
+    index(0, 1, 2, 0, 2, 3);
+}
+
+void BlocksRenderer::flushGreedyFaces() {
+    const int mins[3] {0, sectionBottom, 0};
+    const int maxs[3] {CHUNK_W, sectionTop, CHUNK_D};
+
+    for (int side = 0; side < 6; side++) {
+        const auto& cs = CUBE_SIDES[side];
+        GreedyFace* faces = greedyFaces.get() + side * CHUNK_VOL;
+        glm::ivec3 pos;
+        auto at = [&](int a, int b) -> GreedyFace& {
+            glm::ivec3 cell = pos;
+            cell[cs.u] = a;
+            cell[cs.v] = b;
+            return faces[vox_index(cell.x, cell.y, cell.z)];
+        };
+        for (int n = mins[cs.n]; n < maxs[cs.n]; n++) {
+            pos[cs.n] = n;
+            for (int b = mins[cs.v]; b < maxs[cs.v]; b++) {
+                for (int a = mins[cs.u]; a < maxs[cs.u]; a++) {
+                    const GreedyFace face = at(a, b);
+                    if (face.flags == 0) {
+                        continue;
+                    }
+                    const auto& region =
+                        cache.getRegion(face.id, face.variant, side, densePass);
+                    auto matches = [&](const GreedyFace& other) {
+                        if (other.flags != face.flags || other.color != face.color) {
+                            return false;
+                        }
+                        if (other.id == face.id && other.variant == face.variant) {
+                            return true;
+                        }
+                        return same_region(region, cache.getRegion(
+                            other.id, other.variant, side, densePass
+                        ));
+                    };
+                    int w = 1;
+                    while (a + w < maxs[cs.u] && matches(at(a + w, b))) {
+                        w++;
+                    }
+                    int h = 1;
+                    for (; b + h < maxs[cs.v]; h++) {
+                        int i = 0;
+                        while (i < w && matches(at(a + i, b + h))) {
+                            i++;
+                        }
+                        if (i < w) {
+                            break;
+                        }
+                    }
+                    for (int j = 0; j < h; j++) {
+                        for (int i = 0; i < w; i++) {
+                            at(a + i, b + j).flags = 0;
+                        }
+                    }
+                    glm::vec3 coord = pos;
+                    coord[cs.u] = a + (w - 1) * 0.5f;
+                    coord[cs.v] = b + (h - 1) * 0.5f;
+                    faceGreedy(
+                        coord,
+                        glm::vec3(cs.X),
+                        glm::vec3(cs.Y),
+                        glm::vec3(cs.Z),
+                        w,
+                        h,
+                        region,
+                        face
+                    );
+                    if (overflow) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// @brief Check if the voxel is a part of the LOD cell volume
+static inline bool is_lod_filling(const voxel& vox, const Block& def) {
+    return vox.id != 0 &&
+           def.getModel(vox.state.userbits).type == BlockModelType::BLOCK;
+}
+
+const voxel* BlocksRenderer::pickLodCell(
+    const glm::ivec3& min, int size
+) const {
+    const voxel* top = nullptr;
+    int filled = 0;
+    for (int y = min.y + size - 1; y >= min.y; y--) {
+        for (int z = min.z; z < min.z + size; z++) {
+            for (int x = min.x; x < min.x + size; x++) {
+                const voxel& vox = chunkVoxels[vox_index(x, y, z)];
+                if (!is_lod_filling(vox, *blockDefsCache[vox.id])) {
+                    continue;
+                }
+                if (top == nullptr) {
+                    top = &vox;
+                }
+                filled++;
+            }
+        }
+    }
+    return filled * 2 >= size * size * size ? top : nullptr;
+}
+
+bool BlocksRenderer::scanLodLayer(
+    const glm::ivec3& min, int size, int side, glm::vec4& light
+) const {
+    const auto& cs = CUBE_SIDES[side];
+    glm::ivec3 layer = min;
+    layer[cs.n] = cs.Z[cs.n] > 0 ? min[cs.n] + size : min[cs.n] - 1;
+    // voxels volume above the chunk top is not filled
+    int top = std::min(chunk->top, CHUNK_H - 1);
+
+    int filled = 0;
+    light = glm::vec4(0.0f);
+    for (int b = 0; b < size; b++) {
+        for (int a = 0; a < size; a++) {
+            glm::ivec3 pos = layer;
+            pos[cs.u] += a;
+            pos[cs.v] += b;
+            light = glm::max(light, pickLight(pos.x, std::min(pos.y, top), pos.z));
+            if (pos.y > top) {
+                continue;
+            }
+            const auto& vox = voxelsBuffer->pickBlock(
+                chunk->x * CHUNK_W + pos.x, pos.y, chunk->z * CHUNK_D + pos.z
+            );
+            if (vox.id == BLOCK_VOID ||
+                is_lod_filling(vox, *blockDefsCache[vox.id])) {
+                filled++;
+            }
+        }
+    }
+    return filled * 2 >= size * size;
+}
+
+void BlocksRenderer::renderLod(int section, int lod) {
+    const int size = 1 << lod;
+    const int width = CHUNK_W / size;
+    const int height = CHUNK_SECTION_H / size;
+    const int depth = CHUNK_D / size;
+    const int bottom = section * CHUNK_SECTION_H;
+    if (sectionBottom >= sectionTop) {
+        return;
+    }
+    auto cellIndex = [=](int x, int y, int z) {
+        return ((y + 1) * depth + z) * width + x;
+    };
+    lodCells.assign(width * depth * (height + 2), nullptr);
+    for (int y = -1; y <= height; y++) {
+        int cellY = bottom + y * size;
+        if (cellY < 0 || cellY + size > CHUNK_H || cellY > chunk->top ||
+            cellY + size <= chunk->bottom) {
+            continue;
+        }
+        for (int z = 0; z < depth; z++) {
+            for (int x = 0; x < width; x++) {
+                lodCells[cellIndex(x, y, z)] = pickLodCell(
+                    {x * size, cellY, z * size}, size
+                );
+            }
+        }
+    }
+    for (int y = 0; y < height; y++) {
+        for (int z = 0; z < depth; z++) {
+            for (int x = 0; x < width; x++) {
+                const voxel* vox = lodCells[cellIndex(x, y, z)];
+                if (vox == nullptr) {
+                    continue;
+                }
+                const auto& def = *blockDefsCache[vox->id];
+                uint8_t variantId = def.getVariantIndex(vox->state.userbits);
+                bool lights = !def.shadeless;
+                glm::ivec3 min(x * size, bottom + y * size, z * size);
+
+                for (int side = 0; side < 6; side++) {
+                    const auto& cs = CUBE_SIDES[side];
+                    glm::ivec3 next = glm::ivec3(x, y, z) + cs.Z;
+                    glm::vec4 light;
+                    bool hidden = scanLodLayer(min, size, side, light);
+                    if (next.x >= 0 && next.z >= 0 && next.x < width &&
+                        next.z < depth) {
+                        // inner neighbour cell
+                        hidden = lodCells[cellIndex(next.x, next.y, next.z)] !=
+                                 nullptr;
+                    }
+                    if (hidden || min.y + cs.Z.y < 0) {
+                        continue;
+                    }
+                    glm::vec4 color(1.0f, 1.0f, 1.0f, 0.0f);
+                    if (lights) {
+                        float d = glm::dot(glm::vec3(cs.Z), SUN_VECTOR);
+                        d = (1.0f - DIRECTIONAL_LIGHT_FACTOR) +
+                            d * DIRECTIONAL_LIGHT_FACTOR;
+                        color = light * d;
+                    }
+                    GreedyFace face {
+                        {
+                            to_color_byte(color.r),
+                            to_color_byte(color.g),
+                            to_color_byte(color.b),
+                            to_color_byte(color.a),
+                        },
+                        vox->id,
+                        variantId,
+                        static_cast<uint8_t>(lights ? 1 : 2)};
+                    float offset = (size - 1) * 0.5f;
+                    auto coord = glm::vec3(min) + offset +
+                                 glm::vec3(cs.Z) * offset;
+                    faceGreedy(
+                        coord,
+                        glm::vec3(cs.X),
+                        glm::vec3(cs.Y),
+                        glm::vec3(cs.Z),
+                        size,
+                        size,
+                        cache.getRegion(vox->id, variantId, side, false),
+                        face
+                    );
+                    if (overflow) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
+
 glm::vec4 BlocksRenderer::pickLight(int x, int y, int z) const {
     light_t light = voxelsBuffer->pickLight(
         chunk->x * CHUNK_W + x, y, chunk->z * CHUNK_D + z
@@ -462,9 +850,39 @@ glm::vec4 BlocksRenderer::pickLight(const glm::ivec3& coord) const {
     return pickLight(coord.x, coord.y, coord.z);
 }
 
+/// @return index of the axis if the vector is a unit axis vector, else -1
+static inline int unit_axis(const glm::ivec3& v) {
+    if (std::abs(v.x) + std::abs(v.y) + std::abs(v.z) != 1) {
+        return -1;
+    }
+    return v.x ? 0 : (v.y ? 1 : 2);
+}
+
 glm::vec4 BlocksRenderer::pickSoftLight(
     const glm::ivec3& coord, const glm::ivec3& right, const glm::ivec3& up
 ) const {
+    constexpr int width = VoxelsRenderVolume::width;
+    constexpr int depth = VoxelsRenderVolume::depth;
+    int a = unit_axis(right);
+    int b = unit_axis(up);
+    if (a != -1 && b != -1 && a != b) {
+        // square of the voxels: coord, coord - right, coord - up, ...
+        glm::ivec3 min = coord;
+        min[a] -= right[a] > 0;
+        min[b] -= up[b] > 0;
+        int x = min.x + VOXELS_BUFFER_PADDING;
+        int z = min.z + VOXELS_BUFFER_PADDING;
+        if (x >= 0 && z >= 0 && x < width - 1 && z < depth - 1 &&
+            min.y >= softLightsBottom && min.y < softLightsTop - 1) {
+            uint32_t sum = softLights[
+                (3 - a - b) * SOFT_LIGHTS_LAYERS * width * depth +
+                vox_index(x, min.y - softLightsBottom, z, width, depth)
+            ];
+            return glm::vec4(
+                sum & 0xFF, (sum >> 8) & 0xFF, (sum >> 16) & 0xFF, sum >> 24
+            ) * (1.0f / 60.0f);
+        }
+    }
     return (pickLight(coord) +
             pickLight(coord - right) +
             pickLight(coord - right - up) +
@@ -481,12 +899,41 @@ glm::vec4 BlocksRenderer::pickSoftLight(
         right, up);
 }
 
+/// @brief Check if voxel has all neighbours inside of the section
+static inline bool is_interior_voxel(int index, int bottom, int top) {
+    int x = index % CHUNK_W;
+    int y = index / (CHUNK_D * CHUNK_W);
+    int z = (index / CHUNK_D) % CHUNK_W;
+    return x > 0 && x < CHUNK_W - 1 && z > 0 && z < CHUNK_D - 1 &&
+           y > bottom && y < top - 1;
+}
+
+/// @brief Check if the block fully hides faces of the same block around
+static inline bool is_occluding_cube(const Block& def) {
+    const auto& variant = def.defaults;
+    return def.variants == nullptr && !def.rt.extended && !def.translucent &&
+           variant.rt.solid && variant.culling == CullingMode::DEFAULT &&
+           variant.model.type == BlockModelType::BLOCK;
+}
+
 void BlocksRenderer::render(
     const voxel* voxels, const int beginEnds[256][2]
 ) {
     bool denseRender = this->denseRender;
     bool densePass = this->densePass;
+    bool greedyMeshing = this->greedyMeshing;
     bool enableAO = settings.graphics.softLighting.get();
+    if (greedyMeshing) {
+        size_t offset = sectionBottom * (CHUNK_W * CHUNK_D);
+        size_t count = (sectionTop - sectionBottom) * (CHUNK_W * CHUNK_D);
+        for (int side = 0; side < 6; side++) {
+            std::memset(
+                greedyFaces.get() + side * CHUNK_VOL + offset,
+                0,
+                count * sizeof(GreedyFace)
+            );
+        }
+    }
     for (const auto drawGroup : *content.drawGroups) {
         int begin = beginEnds[drawGroup][0];
         if (begin == 0) {
@@ -509,6 +956,9 @@ void BlocksRenderer::render(
             if (def.translucent) {
                 continue;
             }
+            if (hiddenInterior && is_interior_voxel(i, sectionBottom, sectionTop)) {
+                continue;
+            }
             const UVRegion texfaces[6] {
                 cache.getRegion(id, variantId, 0, densePass),
                 cache.getRegion(id, variantId, 1, densePass),
@@ -522,6 +972,12 @@ void BlocksRenderer::render(
             int z = (i / CHUNK_D) % CHUNK_W;
             switch (def.getModel(state.userbits).type) {
                 case BlockModelType::BLOCK:
+                    if (greedyMeshing && !def.rotatable) {
+                        blockCubeGreedy({x, y, z}, def, variantId, vox.state,
+                                        !def.shadeless,
+                                        def.ambientOcclusion && enableAO);
+                        break;
+                    }
                     blockCube({x, y, z}, texfaces, def, vox.state, !def.shadeless,
                               def.ambientOcclusion && enableAO);
                     break;
@@ -556,6 +1012,9 @@ void BlocksRenderer::render(
             }
         }
     }
+    if (greedyMeshing) {
+        flushGreedyFaces();
+    }
 }
 
 SortingMeshData BlocksRenderer::renderTranslucent(
@@ -694,30 +1153,156 @@ SortingMeshData BlocksRenderer::renderTranslucent(
     return sortingMesh;
 }
 
+/// @brief Check if the block hides everything behind it
+static inline bool is_occluding(const Block& def, const Variant& variant) {
+    return !def.rt.extended && !def.translucent && variant.rt.solid &&
+           variant.drawGroup == 0 && variant.culling == CullingMode::DEFAULT &&
+           variant.model.type == BlockModelType::BLOCK;
+}
+
+SectionConnectivity BlocksRenderer::calculateConnectivity(
+    int section, const Block* uniformDef
+) const {
+    if (chunk->isSectionEmpty(section)) {
+        return SectionConnectivity::all();
+    }
+    if (uniformDef && uniformDef->variants == nullptr) {
+        return is_occluding(*uniformDef, uniformDef->defaults)
+                   ? SectionConnectivity()
+                   : SectionConnectivity::all();
+    }
+    bool occluding[CHUNK_SECTION_VOL];
+    const voxel* voxels = chunkVoxels.get() + section * CHUNK_SECTION_VOL;
+    for (int i = 0; i < CHUNK_SECTION_VOL; i++) {
+        const auto& vox = voxels[i];
+        const auto& def = *blockDefsCache[vox.id];
+        occluding[i] =
+            is_occluding(def, def.getVariantByBits(vox.state.userbits));
+    }
+    return calculate_connectivity(occluding);
+}
+
+void BlocksRenderer::prepareCulling(int bottom, int top) {
+    constexpr size_t layer =
+        VoxelsRenderVolume::width * VoxelsRenderVolume::depth;
+    cullingBottom = std::max(0, bottom);
+    cullingTop = std::max(cullingBottom, std::min(CHUNK_H, top));
+    // layers are contiguous, so the range is filled in one pass
+    const voxel* voxels = voxelsBuffer->getVoxels();
+    uint16_t* dst = volumeCulling.get();
+    for (size_t i = cullingBottom * layer; i < cullingTop * layer; i++) {
+        dst[i] = getCulling(voxels[i]);
+    }
+}
+
+void BlocksRenderer::prepareSoftLights(int bottom, int top) {
+    constexpr size_t width = VoxelsRenderVolume::width;
+    constexpr size_t layer = width * VoxelsRenderVolume::depth;
+    constexpr size_t plane = SOFT_LIGHTS_LAYERS * layer;
+    softLightsBottom = std::max(0, bottom);
+    softLightsTop = std::max(
+        softLightsBottom,
+        std::min({CHUNK_H, top, softLightsBottom + SOFT_LIGHTS_LAYERS})
+    );
+    size_t count = (softLightsTop - softLightsBottom) * layer;
+    if (count < layer + width + 1) {
+        return;
+    }
+    // channels [0, 15] are expanded to bytes, so 4 lights sum fits
+    const light_t* lights =
+        voxelsBuffer->getLights() + softLightsBottom * layer;
+    uint32_t* src = expandedLights.get();
+    for (size_t i = 0; i < count; i++) {
+        uint32_t light = lights[i];
+        src[i] = (light & 0xF) | ((light & 0xF0) << 4) |
+                 ((light & 0xF00) << 8) | ((light & 0xF000) << 12);
+    }
+    // squares of the last layer, row and column are never picked
+    uint32_t* dstX = softLights.get();
+    uint32_t* dstY = dstX + plane;
+    uint32_t* dstZ = dstY + plane;
+    for (size_t i = 0; i < count - layer - width - 1; i++) {
+        uint32_t nearX = src[i] + src[i + 1];
+        uint32_t farX = src[i + layer] + src[i + layer + 1];
+        dstX[i] = src[i] + src[i + width] + src[i + layer] +
+                  src[i + layer + width];
+        dstY[i] = nearX + src[i + width] + src[i + width + 1];
+        dstZ[i] = nearX + farX;
+    }
+}
+
 void BlocksRenderer::build(
-    const Chunk* chunk, const VoxelsRenderVolume& volume
+    const Chunk* chunk,
+    const VoxelsRenderVolume& volume,
+    int section,
+    int lod
 ) {
     meshAABB = AABB(glm::vec3(CHUNK_W, CHUNK_H, CHUNK_D));
+    emitters.clear();
     this->chunk = chunk;
     this->voxelsBuffer = &volume;
-    if (voxelsBuffer->pickBlockId(
-        chunk->x * CHUNK_W, 0, chunk->z * CHUNK_D
+    cullingBottom = cullingTop = 0;
+    softLightsBottom = softLightsTop = 0;
+    sectionBottom = std::max(chunk->bottom, section * CHUNK_SECTION_H);
+    sectionTop = std::max(
+        sectionBottom, std::min(chunk->top, (section + 1) * CHUNK_SECTION_H)
+    );
+    if (chunk->isSectionEmpty(section)) {
+        sectionTop = sectionBottom;
+    }
+    const Block* uniformDef = nullptr;
+    if (chunk->isSectionUniform(section)) {
+        uniformDef =
+            blockDefsCache[chunkVoxels[section * CHUNK_SECTION_VOL].id];
+    }
+    hiddenInterior = uniformDef && is_occluding_cube(*uniformDef);
+    connectivity = calculateConnectivity(section, uniformDef);
+    if (sectionBottom < sectionTop && voxelsBuffer->pickBlockId(
+        chunk->x * CHUNK_W, sectionBottom, chunk->z * CHUNK_D
     ) == BLOCK_VOID) {
         cancelled = true;
         return;
     }
-    const voxel* voxels = chunk->voxels;
+    if (lod > 0) {
+        // translucent blocks are drawn as opaque cells
+        sortingMesh = {};
+        cancelled = false;
+        overflow = false;
+        vertexCount = 0;
+        vertexOffset = indexCount = 0;
+        renderLod(section, std::min(lod, MAX_LOD));
+
+        denseIndexCount = indexCount;
+        std::copy(
+            indexBuffer.get(),
+            indexBuffer.get() + indexCount,
+            denseIndexBuffer.get()
+        );
+        return;
+    }
+    const voxel* voxels = chunkVoxels.get();
 
-    int totalBegin = chunk->bottom * (CHUNK_W * CHUNK_D);
-    int totalEnd = chunk->top * (CHUNK_W * CHUNK_D);
+    int totalBegin = sectionBottom * (CHUNK_W * CHUNK_D);
+    int totalEnd = sectionTop * (CHUNK_W * CHUNK_D);
     bool hasTranslucent = false;
     int beginEnds[256][2] {};
+    if (uniformDef && uniformDef->variants == nullptr &&
+        uniformDef->particles == nullptr && totalBegin < totalEnd) {
+        // single draw group, no need to scan the section
+        hasTranslucent = uniformDef->translucent;
+        beginEnds[uniformDef->defaults.drawGroup][0] = totalBegin + 1;
+        beginEnds[uniformDef->defaults.drawGroup][1] = totalEnd - 1;
+        totalBegin = totalEnd;
+    }
     for (int i = totalBegin; i < totalEnd; i++) {
         const voxel& vox = voxels[i];
         blockid_t id = vox.id;
         const auto& def = *blockDefsCache[id];
         const auto& variant = def.getVariantByBits(vox.state.userbits);
         hasTranslucent = def.translucent || hasTranslucent;
+        if (def.particles) {
+            emitters.push_back(i);
+        }
 
         if (beginEnds[variant.drawGroup][0] == 0) {
             beginEnds[variant.drawGroup][0] = i + 1;
@@ -725,6 +1310,10 @@ void BlocksRenderer::build(
         beginEnds[variant.drawGroup][1] = i;
     }
     cancelled = false;
+    // faces of the section blocks look at the adjacent layers
+    prepareCulling(sectionBottom - 1, sectionTop + 1);
+    // vertices sample lights up to two voxels away
+    prepareSoftLights(sectionBottom - 2, sectionTop + 2);
 
     overflow = false;
     vertexCount = 0;
@@ -732,6 +1321,10 @@ void BlocksRenderer::build(
 
     denseRender = false;
     densePass = false;
+    greedyMeshing = settings.graphics.greedyMeshing.get();
+    if (greedyMeshing && greedyFaces == nullptr) {
+        greedyFaces = std::make_unique<GreedyFace[]>(CHUNK_VOL * 6);
+    }
 
     if (hasTranslucent) {
         sortingMesh = renderTranslucent(voxels, beginEnds);
@@ -766,41 +1359,55 @@ void BlocksRenderer::build(
 }
 
 ChunkMeshData BlocksRenderer::createMesh() {
+    util::Buffer<PackedChunkVertex> vertices(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++) {
+        vertices[i] = PackedChunkVertex::pack(vertexBuffer[i]);
+    }
     return ChunkMeshData {
         MeshData(
-            util::Buffer(vertexBuffer.get(), vertexCount),
+            std::move(vertices),
             std::vector<util::Buffer<uint32_t>> {
                 util::Buffer(indexBuffer.get(), indexCount),
                 util::Buffer(denseIndexBuffer.get(), denseIndexCount),
             },
             util::Buffer(
-                ChunkVertex::ATTRIBUTES,
-                sizeof(ChunkVertex::ATTRIBUTES) / sizeof(VertexAttribute)
+                PackedChunkVertex::ATTRIBUTES,
+                sizeof(PackedChunkVertex::ATTRIBUTES) / sizeof(VertexAttribute)
             )
         ),
         std::move(sortingMesh),
-        std::move(meshAABB)
+        std::move(meshAABB),
+        connectivity,
+        emitters
     };
 }
 
-ChunkMesh BlocksRenderer::render(
-    const Chunk* chunk, const VoxelsRenderVolume& volume
+void BlocksRenderer::copyChunkVoxels(
+    const Chunk& chunk, chunk_sections_t sections, int lod
 ) {
-    build(chunk, volume);
-    
-    assert(vertexCount <= capacity);
-    assert(indexCount <= capacity);
-    assert(denseIndexCount <= capacity);
-
-    return ChunkMesh{std::make_unique<Mesh<ChunkVertex>>(
-        vertexBuffer.get(), vertexCount, 
-        std::vector<IndexBufferData> {
-            IndexBufferData {indexBuffer.get(), indexCount},
-            IndexBufferData {denseIndexBuffer.get(), denseIndexCount},
+    // levels of detail cells are picked from the adjacent layers too
+    const int padding = lod > 0 ? 1 << std::min(lod, MAX_LOD) : 0;
+    const int layer = CHUNK_W * CHUNK_D;
+    for (int section = 0; section < CHUNK_SECTIONS; section++) {
+        if ((sections & (1U << section)) == 0) {
+            continue;
         }
-    ), std::move(sortingMesh), nullptr, std::move(meshAABB)};
+        int bottom = std::max(0, section * CHUNK_SECTION_H - padding);
+        int top = std::min(CHUNK_H, (section + 1) * CHUNK_SECTION_H + padding);
+        chunk.copyVoxels(
+            chunkVoxels.get() + bottom * layer, bottom * layer, top * layer
+        );
+    }
 }
 
 size_t BlocksRenderer::getMemoryConsumption() const {
-    return capacity * (sizeof(ChunkVertex) + sizeof(uint32_t) * 2);
+    size_t size = capacity * (sizeof(ChunkVertex) + sizeof(uint32_t) * 2);
+    size += VoxelsRenderVolume::size * sizeof(uint16_t);
+    size += CHUNK_VOL * sizeof(voxel);
+    size += 4 * SOFT_LIGHTS_LAYERS * VoxelsRenderVolume::width *
+            VoxelsRenderVolume::depth * sizeof(uint32_t);
+    if (greedyFaces) {
+        size += CHUNK_VOL * 6 * sizeof(GreedyFace);
+    }
+    return size;
 }
@@ -10,7 +10,9 @@
 #include "commons.hpp"
 #include "settings.hpp"
 
+#include <array>
 #include <memory>
+#include <vector>
 #include <glm/glm.hpp>
 
 template<typename VertexStructure> class Mesh;
@@ -31,12 +33,28 @@ public:
     );
     ~BlocksRenderer();
 
-    void build(const Chunk* chunk, const VoxelsRenderVolume& volume);
-    ChunkMesh render(
-        const Chunk* chunk, const VoxelsRenderVolume& volume
+    /// @brief Max supported level of detail
+    static constexpr int MAX_LOD = 2;
+
+    /// @brief Build mesh of the chunk vertical section
+    /// @param section section index [0, CHUNK_SECTIONS)
+    /// @param lod level of detail. Voxels are merged into cells of 2^lod
+    /// size, drawn as cubes textured with the topmost block of the cell
+    void build(
+        const Chunk* chunk,
+        const VoxelsRenderVolume& volume,
+        int section,
+        int lod = 0
     );
     ChunkMeshData createMesh();
 
+    /// @brief Copy voxels of the chunk sections to be built (including
+    /// layers read by levels of detail cells). Must be called before build
+    /// while the chunk may not be modified or packed
+    void copyChunkVoxels(
+        const Chunk& chunk, chunk_sections_t sections, int lod = 0
+    );
+
     size_t getMemoryConsumption() const;
 
     bool isCancelled() const {
@@ -57,17 +75,75 @@ private:
     bool cancelled = false;
     bool densePass = false;
     bool denseRender = false;
+    bool greedyMeshing = false;
+    /// @brief Y range of the section being built
+    int sectionBottom = 0;
+    int sectionTop = 0;
+    /// @brief Section is filled with an opaque cube block, so only its outer
+    /// layer of voxels may have visible faces
+    bool hiddenInterior = false;
     AABB meshAABB {};
+    /// @brief Faces connectivity of the section being built
+    SectionConnectivity connectivity;
     const Chunk* chunk = nullptr;
     const VoxelsRenderVolume* voxelsBuffer = nullptr;
+    /// @brief Flat copy of the chunk voxels made by copyChunkVoxels
+    std::unique_ptr<voxel[]> chunkVoxels;
 
     const Block* const* blockDefsCache;
+
+    /// @brief Neighbour voxel culling info flags (low byte is draw group)
+    static constexpr uint16_t CULLING_SOLID = 0x100;
+    static constexpr uint16_t CULLING_EMPTY = 0x200;
+    static constexpr uint16_t CULLING_VOID = 0x400;
+    /// @brief Culling info of the block variants precomputed on
+    /// content load
+    struct BlockCulling {
+        uint8_t variantsOffset = 0;
+        uint8_t variantsMask = 0;
+        std::array<uint16_t, BLOCK_MAX_VARIANTS> variants {};
+    };
+    std::vector<BlockCulling> blocksCulling;
+    /// @brief Culling info of the volume voxels in layers
+    /// [cullingBottom, cullingTop) filled before the section is built
+    std::unique_ptr<uint16_t[]> volumeCulling;
+    int cullingBottom = 0;
+    int cullingTop = 0;
+
+    /// @brief Max number of the volume layers having soft lights prepared
+    static constexpr int SOFT_LIGHTS_LAYERS = CHUNK_SECTION_H + 4;
+    /// @brief Volume lights with channels expanded to bytes (scratch)
+    std::unique_ptr<uint32_t[]> expandedLights;
+    /// @brief Lights sums of 2x2 voxels squares for each plane by its
+    /// normal axis, indexed by the square min voxel of the layers
+    /// [softLightsBottom, softLightsTop). Channels are packed to bytes
+    std::unique_ptr<uint32_t[]> softLights;
+    int softLightsBottom = 0;
+    int softLightsTop = 0;
+
     const ContentGfxCache& cache;
     const EngineSettings& settings;
     
     util::PseudoRandom randomizer;
 
     SortingMeshData sortingMesh;
+    /// @brief Voxel indices of the section blocks having particles
+    std::vector<uint32_t> emitters;
+
+    /// @brief Full-cube block face waiting to be merged by greedy meshing
+    struct GreedyFace {
+        /// @brief Face vertices color (light multiplied by tint)
+        std::array<uint8_t, 4> color;
+        blockid_t id;
+        uint8_t variant;
+        /// @brief 0 - no face, 1 - shaded face, 2 - emissive face
+        uint8_t flags;
+    };
+    /// @brief Faces buffer [side][voxel] (allocated on demand)
+    std::unique_ptr<GreedyFace[]> greedyFaces;
+    /// @brief Representative voxels of the LOD cells of the section and
+    /// layers above and below it (nullptr if cell is empty)
+    std::vector<const voxel*> lodCells;
 
     void vertex(
         const glm::vec3& coord,
@@ -121,6 +197,42 @@ private:
         bool lights,
         bool ao
     );
+    /// @brief Put cube faces to the greedy meshing buffer.
+    /// Faces with non-uniform soft lighting are rendered immediately
+    void blockCubeGreedy(
+        const glm::ivec3& coord,
+        const Block& block,
+        uint8_t variantId,
+        blockstate states,
+        bool lights,
+        bool ao
+    );
+    /// @brief Merge buffered faces into quads and clear the buffer
+    void flushGreedyFaces();
+    /// @brief Calculate faces connectivity for occlusion culling
+    SectionConnectivity calculateConnectivity(
+        int section, const Block* uniformDef
+    ) const;
+    void faceGreedy(
+        const glm::vec3& coord,
+        const glm::vec3& X,
+        const glm::vec3& Y,
+        const glm::vec3& Z,
+        int w, int h,
+        const UVRegion& region,
+        const GreedyFace& face
+    );
+    /// @brief Build section mesh of LOD cells
+    void renderLod(int section, int lod);
+    /// @return topmost filling voxel of the cell or nullptr if less than
+    /// half of the cell voxels are filling
+    const voxel* pickLodCell(const glm::ivec3& min, int size) const;
+    /// @brief Scan voxels layer adjacent to the LOD cell side
+    /// @param light [out] brightest light of the layer
+    /// @return true if the layer is mostly filled
+    bool scanLodLayer(
+        const glm::ivec3& min, int size, int side, glm::vec4& light
+    ) const;
     void blockAABB(
         const glm::ivec3& coord,
         const UVRegion(&faces)[6], 
@@ -144,18 +256,48 @@ private:
         bool ao
     );
 
+    inline uint16_t getCulling(const voxel& vox) const {
+        if (vox.id >= blocksCulling.size()) {
+            return CULLING_VOID;
+        }
+        const auto& culling = blocksCulling[vox.id];
+        return culling.variants[
+            (vox.state.userbits >> culling.variantsOffset) &
+            culling.variantsMask
+        ];
+    }
+
+    /// @brief Fill volume voxels culling info of the layers
+    void prepareCulling(int bottom, int top);
+
+    /// @brief Sum lights of the voxels squares of the layers once, so soft
+    /// lights of the vertices are not sampled voxel by voxel
+    void prepareSoftLights(int bottom, int top);
+
+    /// @param pos chunk-relative position
+    inline uint16_t pickCulling(const glm::ivec3& pos) const {
+        constexpr int width = VoxelsRenderVolume::width;
+        constexpr int depth = VoxelsRenderVolume::depth;
+        int x = pos.x + VOXELS_BUFFER_PADDING;
+        int z = pos.z + VOXELS_BUFFER_PADDING;
+        if (pos.y < cullingBottom || pos.y >= cullingTop || x < 0 ||
+            z < 0 || x >= width || z >= depth) {
+            return getCulling(voxelsBuffer->pickBlock(
+                chunk->x * CHUNK_W + pos.x, pos.y, chunk->z * CHUNK_D + pos.z
+            ));
+        }
+        return volumeCulling[vox_index(x, pos.y, z, width, depth)];
+    }
+
     // Does block allow to see other blocks sides (is it transparent)
     inline bool isOpen(const glm::ivec3& pos, const Block& def, const Variant& variant) const {
-        const auto& vox = voxelsBuffer->pickBlock(
-            chunk->x * CHUNK_W + pos.x, pos.y, chunk->z * CHUNK_D + pos.z
-        );
-        if (vox.id == BLOCK_VOID) {
+        uint16_t culling = pickCulling(pos);
+        if (culling & CULLING_VOID) {
             return false;
         }
-        const auto& block = *blockDefsCache[vox.id];
-        const auto& blockVariant = block.getVariantByBits(vox.state.userbits);
-        uint8_t otherDrawGroup = blockVariant.drawGroup;
-        if ((otherDrawGroup && (otherDrawGroup != variant.drawGroup)) || !blockVariant.rt.solid) {
+        uint8_t otherDrawGroup = culling & 0xFF;
+        if ((otherDrawGroup && (otherDrawGroup != variant.drawGroup)) ||
+            !(culling & CULLING_SOLID)) {
             return true;
         }
         if (densePass) {
@@ -163,10 +305,13 @@ private:
         } else if (variant.culling == CullingMode::OPTIONAL) {
             return false;
         }
-        if (variant.culling == CullingMode::DISABLED && vox.id == def.rt.id) {
+        if (variant.culling == CullingMode::DISABLED &&
+            voxelsBuffer->pickBlockId(
+                chunk->x * CHUNK_W + pos.x, pos.y, chunk->z * CHUNK_D + pos.z
+            ) == def.rt.id) {
             return true;
         }
-        return !vox.id;
+        return culling & CULLING_EMPTY;
     }
 
     glm::vec4 pickLight(int x, int y, int z) const;
@@ -1,8 +1,12 @@
 #include "ChunksRenderer.hpp"
 #include "BlocksRenderer.hpp"
 #include "debug/Logger.hpp"
+#include "debug/Memory.hpp"
+#include "debug/Profiler.hpp"
 #include "assets/Assets.hpp"
+#include "content/Content.hpp"
 #include "graphics/core/Mesh.hpp"
+#include "graphics/core/MeshArena.hpp"
 #include "graphics/core/Shader.hpp"
 #include "graphics/core/Texture.hpp"
 #include "graphics/core/Atlas.hpp"
@@ -11,25 +15,140 @@
 #include "world/Level.hpp"
 #include "window/Camera.hpp"
 #include "maths/FrustumCulling.hpp"
-#include "util/listutil.hpp"
+#include "maths/voxmaths.hpp"
 #include "util/ObjectsPool.hpp"
 #include "settings.hpp"
 
+#include <algorithm>
+
 static debug::Logger logger("chunks-render");
 
 size_t ChunksRenderer::visibleChunks = 0;
 
 static constexpr inline size_t MAX_CHUNKS_ENQUEUED_IN_FRAME = 4;
+static constexpr inline size_t ARENA_PAGE_VERTICES = 1 << 20;
+static constexpr inline size_t ARENA_PAGE_INDICES = 3 << 20;
+/// @brief Distance in blocks by which results in the view frustum are
+/// preferred over other ones
+static constexpr inline float UPLOAD_VISIBLE_BONUS = CHUNK_W * 8;
+/// @brief Distance in blocks the chunk must pass over a LOD threshold
+/// before its mesh is rebuilt with another level of detail
+static constexpr inline float LOD_HYSTERESIS = CHUNK_W;
+/// @brief Distance in chunks of the first level of detail used under
+/// video memory pressure if levels of detail are disabled
+static constexpr inline int PRESSURE_LOD_DISTANCE = 32;
+
+/// @return level of detail at the distance
+static int lod_at(float distance, int lodDistance) {
+    float threshold = lodDistance * CHUNK_W;
+    int lod = 0;
+    while (lod < BlocksRenderer::MAX_LOD && distance >= threshold) {
+        threshold *= 2;
+        lod++;
+    }
+    return lod;
+}
+
+/// @brief Select chunk mesh level of detail
+/// @param current level of the existing mesh (-1 if there is no mesh)
+static int choose_lod(float distance, int current, int lodDistance) {
+    if (lodDistance <= 0) {
+        return 0;
+    }
+    int lod = lod_at(distance, lodDistance);
+    // current level is kept until the chunk goes far enough from threshold
+    if (current >= lod_at(distance - LOD_HYSTERESIS, lodDistance) &&
+        current <= lod_at(distance + LOD_HYSTERESIS, lodDistance)) {
+        return current;
+    }
+    return lod;
+}
+
+/// @brief Bring levels of detail closer by half per video memory
+/// pressure level
+static int pressured_lod_distance(int lodDistance, int pressure) {
+    if (pressure == 0) {
+        return lodDistance;
+    }
+    if (lodDistance <= 0) {
+        lodDistance = PRESSURE_LOD_DISTANCE;
+    }
+    return std::max(1, lodDistance >> pressure);
+}
+
+/// @brief Build meshes of the chunk sections selected by the mask
+/// @return false if building was cancelled
+static bool build_sections(
+    BlocksRenderer& renderer,
+    const Chunk& chunk,
+    const VoxelsRenderVolume& volume,
+    chunk_sections_t sections,
+    int lod,
+    std::vector<ChunkMeshData>& dst
+) {
+    for (int section = 0; section < CHUNK_SECTIONS; section++) {
+        if (!(sections & (1U << section))) {
+            continue;
+        }
+        renderer.build(&chunk, volume, section, lod);
+        if (renderer.isCancelled()) {
+            return false;
+        }
+        dst.push_back(renderer.createMesh());
+    }
+    return true;
+}
+
+/// @brief Fill voxels volume from the job chunks area
+static void fill_volume(
+    const ContentIndices& indices,
+    const RendererJob& job,
+    VoxelsRenderVolume& volume
+) {
+    constexpr int width = VoxelsRenderVolume::width;
+    constexpr int depth = VoxelsRenderVolume::depth;
+    const auto& chunk = *job.chunk;
+    volume.setPosition(
+        chunk.x * CHUNK_W - VOXELS_BUFFER_PADDING, 0,
+        chunk.z * CHUNK_D - VOXELS_BUFFER_PADDING
+    );
+    size_t offset = static_cast<size_t>(job.bottom) * width * depth;
+    Chunks::getVoxels(
+        indices,
+        [&job](int32_t x, int32_t z) -> const Chunk* {
+            int dx = x - job.chunk->x + 1;
+            int dz = z - job.chunk->z + 1;
+            if (dx < 0 || dz < 0 || dx > 2 || dz > 2) {
+                return nullptr;
+            }
+            return job.area[dz * 3 + dx].get();
+        },
+        volume.getVoxels() + offset,
+        volume.getLights() + offset,
+        {volume.getX(), job.bottom, volume.getZ()},
+        {width, CHUNK_H - job.bottom, depth},
+        job.backlight,
+        job.top - job.bottom
+    );
+}
+
+// volumes own large buffers, so they are allocated one by one
+static util::ObjectsPool<VoxelsRenderVolume> voxelsVolumesPool {0, 0};
 
 class RendererWorker : public util::Worker<RendererJob, RendererResult> {
+    const ContentIndices& indices;
+    util::ReadersGate& chunksGate;
     BlocksRenderer renderer;
 public:
     RendererWorker(
         const Level& level,
         const ContentGfxCache& cache,
-        const EngineSettings& settings
+        const EngineSettings& settings,
+        util::ReadersGate& chunksGate
     )
-        : renderer(
+        : indices(*level.content.getIndices()),
+          chunksGate(chunksGate),
+          renderer(
               settings.graphics.denseRender.get()
                   ? settings.graphics.chunkMaxVerticesDense.get()
                   : settings.graphics.chunkMaxVertices.get(),
@@ -40,21 +159,28 @@ public:
     }
 
     RendererResult operator()(const RendererJob& job) override {
-        auto chunk = job.chunk;
-        auto volume = job.volume;
-        renderer.build(chunk.get(), *volume);
-        if (renderer.isCancelled()) {
-            return RendererResult {
-                glm::ivec2(chunk->x, chunk->z), true, ChunkMeshData {}};
+        const auto& chunk = *job.chunk;
+        auto volume = voxelsVolumesPool.create();
+        std::vector<ChunkMeshData> meshData;
+        bool built = false;
+        // chunks may be read only while the main thread does not modify them
+        if (chunksGate.enter()) {
+            fill_volume(indices, job, *volume);
+            renderer.copyChunkVoxels(chunk, job.sections, job.lod);
+            chunksGate.leave();
+            built = build_sections(
+                renderer, chunk, *volume, job.sections, job.lod, meshData
+            );
         }
-        auto meshData = renderer.createMesh();
         return RendererResult {
-            glm::ivec2(chunk->x, chunk->z), false, std::move(meshData)};
+            glm::ivec2(chunk.x, chunk.z),
+            !built,
+            job.sections,
+            job.lod,
+            std::move(meshData)};
     }
 };
 
-static util::ObjectsPool<VoxelsRenderVolume> voxelsVolumesPool {};
-
 ChunksRenderer::ChunksRenderer(
     const Level& level,
     const Chunks& chunks,
@@ -64,6 +190,7 @@ ChunksRenderer::ChunksRenderer(
     const EngineSettings& settings
 )
     : chunks(chunks),
+      contentIndices(*level.content.getIndices()),
       assets(assets),
       frustum(frustum),
       settings(settings),
@@ -71,114 +198,411 @@ ChunksRenderer::ChunksRenderer(
           "chunks-render-pool",
           [&]() {
               return std::make_unique<RendererWorker>(
-                  level, cache, settings
+                  level, cache, settings, chunksGate
               );
           },
           [&](RendererResult&& result) {
-                if (!result.cancelled) {
-                    auto meshData = std::move(result.meshData);
-                    auto chunk = std::make_unique<Mesh<ChunkVertex>>(meshData.mesh);
-                    meshes[result.key] = ChunkMesh {
-                        std::move(chunk),
-                        std::move(meshData.sortingMesh),
-                        nullptr,
-                        std::move(meshData.meshAABB)
-                    };
-                }
-                inwork.erase(result.key);
+              pendingResults.push_back(std::move(result));
           },
           settings.graphics.chunkMaxRenderers.get()
       ) {
     threadPool.setStopOnFail(false);
+    bool indirect = false;
+    if (settings.graphics.indirectRender.get()) {
+        indirect = MeshArena<PackedChunkVertex, ChunkInstance>::isIndirectSupported();
+        if (indirect) {
+            logger.info() << "using multi-draw indirect rendering";
+        } else {
+            logger.info() << "multi-draw indirect is not supported";
+        }
+    }
+    arena = std::make_unique<MeshArena<PackedChunkVertex, ChunkInstance>>(
+        ARENA_PAGE_VERTICES, ARENA_PAGE_INDICES, indirect
+    );
     renderer = std::make_unique<BlocksRenderer>(
         settings.graphics.chunkMaxVertices.get(), 
         level.content, cache, settings
     );
     logger.info() << "created " << threadPool.getWorkersCount() << " workers";
+    size_t workersMemory =
+        renderer->getMemoryConsumption() * threadPool.getWorkersCount();
+    constexpr size_t volumeMemory =
+        sizeof(VoxelsVolume) + (CHUNK_W + VOXELS_BUFFER_PADDING * 2) *
+                                   CHUNK_H *
+                                   (CHUNK_D + VOXELS_BUFFER_PADDING * 2) *
+                                   (sizeof(voxel) + sizeof(light_t));
     logger.info() << "memory consumption is "
-                  << renderer->getMemoryConsumption() *
-                             threadPool.getWorkersCount() +
-                         voxelsVolumesPool.countTotal() *
-                             (sizeof(VoxelsVolume) +
-                              (CHUNK_W + VOXELS_BUFFER_PADDING * 2) * CHUNK_H *
-                                  (CHUNK_D + VOXELS_BUFFER_PADDING * 2) *
-                                  (sizeof(voxel) + sizeof(light_t)))
+                  << workersMemory +
+                         voxelsVolumesPool.countTotal() * volumeMemory
                   << " B";
+
+    using debug::MemoryTag;
+    // meshes are not evicted: visible chunks would be meshed again
+    memorySources.push_back(debug::memory::add_source(
+        MemoryTag::MESHES,
+        [this, workersMemory]() {
+            size_t usage = workersMemory +
+                           voxelsVolumesPool.countTotal() * volumeMemory;
+            for (const auto& [_, mesh] : meshes) {
+                for (const auto& entry : mesh.sortingMeshData.entries) {
+                    usage += sizeof(SortingMeshEntry) +
+                             entry.vertexData.size() * sizeof(ChunkVertex);
+                }
+            }
+            return usage;
+        }
+    ));
+    memorySources.push_back(debug::memory::add_source(
+        MemoryTag::MESHES_GPU,
+        [this]() { return arena->getMemoryConsumption(); }
+    ));
+}
+
+ChunksRenderer::~ChunksRenderer() {
+    // release workers waiting for the gate before the pool is joined
+    chunksGate.stop();
+}
+
+void ChunksRenderer::beginChunksAccess() {
+    chunksGate.open();
+}
+
+void ChunksRenderer::endChunksAccess() {
+    VC_PROFILE_ZONE("ChunksRenderer::endChunksAccess");
+    chunksGate.close();
+}
+
+void ChunksRenderer::applyResult(RendererResult&& result) {
+    if (!result.cancelled) {
+        updateMesh(
+            result.key,
+            result.sections,
+            result.lod,
+            std::move(result.meshData)
+        );
+    } else if (result.sections != CHUNK_ALL_SECTIONS) {
+        // modified sections are lost, full rebuild required
+        meshes.erase(result.key);
+        meshesRevision++;
+    }
+    inwork.erase(result.key);
 }
 
-ChunksRenderer::~ChunksRenderer() = default;
+static size_t upload_size(const RendererResult& result) {
+    if (result.cancelled) {
+        return 0;
+    }
+    size_t size = 0;
+    for (const auto& data : result.meshData) {
+        size += data.mesh.vertices.size() * sizeof(PackedChunkVertex);
+        for (const auto& indices : data.mesh.indices) {
+            size += indices.size() * sizeof(uint32_t);
+        }
+    }
+    return size;
+}
 
-std::shared_ptr<VoxelsRenderVolume> ChunksRenderer::prepareVoxelsVolume(
-    const Chunk& chunk
+ChunkMesh& ChunksRenderer::updateMesh(
+    const glm::ivec2& key,
+    chunk_sections_t sections,
+    int lod,
+    std::vector<ChunkMeshData>&& meshData
 ) {
-    auto voxelsBuffer = voxelsVolumesPool.create();
-    voxelsBuffer->setPosition(
-        chunk.x * CHUNK_W - VOXELS_BUFFER_PADDING, 0,
-        chunk.z * CHUNK_D - VOXELS_BUFFER_PADDING
+    meshesRevision++;
+    auto& mesh = meshes[key];
+    mesh.lod = lod;
+    auto& entries = mesh.sortingMeshData.entries;
+    // remove translucent entries of the rebuilt sections
+    entries.erase(
+        std::remove_if(
+            entries.begin(),
+            entries.end(),
+            [sections](const SortingMeshEntry& entry) {
+                int section = static_cast<int>(entry.position.y) / CHUNK_SECTION_H;
+                return (sections & (1U << section)) != 0;
+            }
+        ),
+        entries.end()
     );
-    chunks.getVoxels(
-        *voxelsBuffer, settings.graphics.backlight.get(), chunk.top + 1
+    size_t index = 0;
+    for (int section = 0; section < CHUNK_SECTIONS; section++) {
+        if (!(sections & (1U << section))) {
+            continue;
+        }
+        auto& data = meshData.at(index++);
+        auto& sectionMesh = mesh.sections[section];
+        if (data.mesh.vertices.size() == 0) {
+            sectionMesh = nullptr;
+        } else {
+            arena->update(sectionMesh, data.mesh);
+        }
+        mesh.sectionsAABB[section] = std::move(data.meshAABB);
+        mesh.sectionsConnectivity[section] = data.connectivity;
+        mesh.sectionsEmitters[section] = std::move(data.emitters);
+        for (auto& entry : data.sortingMesh.entries) {
+            entries.push_back(std::move(entry));
+        }
+    }
+    mesh.sortedMesh = nullptr;
+    mesh.meshAABB = mesh.sectionsAABB[0];
+    for (int section = 1; section < CHUNK_SECTIONS; section++) {
+        const auto& aabb = mesh.sectionsAABB[section];
+        mesh.meshAABB.addPoint(aabb.min());
+        mesh.meshAABB.addPoint(aabb.max());
+    }
+    return mesh;
+}
+
+RendererJob ChunksRenderer::prepareJob(
+    const std::shared_ptr<Chunk>& chunk, chunk_sections_t sections, int lod
+) {
+    int lowest = 0;
+    while (!(sections & (1U << lowest))) {
+        lowest++;
+    }
+    int highest = CHUNK_SECTIONS - 1;
+    while (!(sections & (1U << highest))) {
+        highest--;
+    }
+    // blocks renderer looks at neighbour voxels outside of the section
+    int bottom = std::max(0, lowest * CHUNK_SECTION_H - VOXELS_BUFFER_PADDING);
+    int top = std::min(
+        chunk->top + 1,
+        (highest + 1) * CHUNK_SECTION_H + VOXELS_BUFFER_PADDING
     );
-    return voxelsBuffer;
+    RendererJob job {
+        chunk,
+        {},
+        sections,
+        lod,
+        bottom,
+        std::max(bottom, top),
+        settings.graphics.backlight.get()};
+    for (int dz = -1; dz <= 1; dz++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            job.area[(dz + 1) * 3 + dx + 1] =
+                chunks.getChunkShared(chunk->x + dx, chunk->z + dz);
+        }
+    }
+    return job;
 }
 
 const ChunkMesh* ChunksRenderer::render(
-    const std::shared_ptr<Chunk>& chunk, bool important, bool lowPriority
+    const std::shared_ptr<Chunk>& chunk,
+    bool important,
+    bool lowPriority,
+    int priority,
+    int lod
 ) {
     glm::ivec2 key(chunk->x, chunk->z);
-    chunk->flags.modified = false;
+    // mesh being built in background may be outdated, so the modification
+    // flags are kept until the result is received
+    if (inwork.find(key) != inwork.end()) {
+        return nullptr;
+    }
+    chunk_sections_t sections = chunk->modifiedSections;
+    const auto& found = meshes.find(key);
+    if (sections == 0 || found == meshes.end() || found->second.lod != lod) {
+        sections = CHUNK_ALL_SECTIONS;
+    }
     if (important) {
-        ChunkMesh mesh {};
-        auto voxelsBuffer = prepareVoxelsVolume(*chunk);
-        mesh = renderer->render(chunk.get(), *voxelsBuffer);
-        meshes[key] = std::move(mesh);
-        return &meshes[key];
-    }
-    if (inwork.find(key) != inwork.end() ||
-        ((inwork.size() >= threadPool.getWorkersCount() ||
-          enqueuedInFrame >= MAX_CHUNKS_ENQUEUED_IN_FRAME) &&
-         lowPriority)) {
+        chunk->flags.modified = false;
+        chunk->modifiedSections = 0;
+        auto job = prepareJob(chunk, sections, lod);
+        auto voxelsBuffer = voxelsVolumesPool.create();
+        fill_volume(contentIndices, job, *voxelsBuffer);
+        renderer->copyChunkVoxels(*chunk, sections, lod);
+        std::vector<ChunkMeshData> meshData;
+        if (!build_sections(
+                *renderer, *chunk, *voxelsBuffer, sections, lod, meshData
+            )) {
+            chunk->flags.modified = true;
+            chunk->modifiedSections |= sections;
+            return nullptr;
+        }
+        return &updateMesh(key, sections, lod, std::move(meshData));
+    }
+    if ((inwork.size() >= threadPool.getWorkersCount() ||
+         enqueuedInFrame >= MAX_CHUNKS_ENQUEUED_IN_FRAME) &&
+        lowPriority) {
         return nullptr;
     }
+    chunk->flags.modified = false;
+    chunk->modifiedSections = 0;
     enqueuedInFrame++;
-    auto voxelsBuffer = prepareVoxelsVolume(*chunk);
-    threadPool.enqueueJob({chunk, std::move(voxelsBuffer)});
+    threadPool.enqueueJob(prepareJob(chunk, sections, lod), priority);
     inwork[key] = true;
     return nullptr;
 }
 
+const ChunkMesh* ChunksRenderer::getMesh(const glm::ivec2& chunkPos) const {
+    const auto& found = meshes.find(chunkPos);
+    if (found == meshes.end()) {
+        return nullptr;
+    }
+    return &found->second;
+}
+
 void ChunksRenderer::unload(const Chunk* chunk) {
-    auto found = meshes.find(glm::ivec2(chunk->x, chunk->z));
+    glm::ivec2 key(chunk->x, chunk->z);
+    auto found = meshes.find(key);
     if (found != meshes.end()) {
         meshes.erase(found);
+        meshesRevision++;
+    }
+    if (inwork.find(key) == inwork.end()) {
+        return;
     }
+    auto cancelled = threadPool.cancelJobs([chunk](const RendererJob& job) {
+        return job.chunk.get() == chunk;
+    });
+    // finished but not uploaded yet
+    auto pending = std::remove_if(
+        pendingResults.begin(),
+        pendingResults.end(),
+        [key](const RendererResult& result) { return result.key == key; }
+    );
+    if (!cancelled.empty() || pending != pendingResults.end()) {
+        inwork.erase(key);
+    }
+    pendingResults.erase(pending, pendingResults.end());
 }
 
 void ChunksRenderer::clear() {
     meshes.clear();
+    meshesRevision++;
     inwork.clear();
+    pendingResults.clear();
     threadPool.clearQueue();
 }
 
 const ChunkMesh* ChunksRenderer::getOrRender(
-    const std::shared_ptr<Chunk>& chunk, bool important, bool lowPriority
+    const std::shared_ptr<Chunk>& chunk,
+    bool important,
+    bool lowPriority,
+    int priority,
+    int lod
 ) {
     auto found = meshes.find(glm::ivec2(chunk->x, chunk->z));
     if (found == meshes.end()) {
-        return render(chunk, important, lowPriority);
+        return render(chunk, important, lowPriority, priority, lod);
     }
     if (chunk->flags.modified && chunk->flags.lighted) {
-        render(chunk, important, lowPriority);
+        render(chunk, important, lowPriority, priority, lod);
+    } else if (found->second.lod != lod) {
+        // previous mesh is drawn until the new one is built
+        render(chunk, false, true, priority, lod);
     }
     return &found->second;
 }
 
-void ChunksRenderer::update() {
+void ChunksRenderer::update(const Camera& camera) {
     threadPool.pullResults();
     enqueuedInFrame = 0;
+    if (pendingResults.empty()) {
+        return;
+    }
+    size_t budget = settings.graphics.chunkUploadBudget.get() * 1024;
+    if (budget == 0) {
+        for (auto& result : pendingResults) {
+            applyResult(std::move(result));
+        }
+        pendingResults.clear();
+        return;
+    }
+    // farthest first, so the nearest are popped from the back
+    std::vector<std::pair<float, size_t>> order;
+    order.reserve(pendingResults.size());
+    for (size_t i = 0; i < pendingResults.size(); i++) {
+        const auto& key = pendingResults[i].key;
+        glm::vec3 min(key.x * CHUNK_W, 0, key.y * CHUNK_D);
+        glm::vec3 max = min + glm::vec3(CHUNK_W, CHUNK_H, CHUNK_D);
+        float distance = glm::distance(
+            glm::vec2(
+                camera.position.x + lookAhead.x,
+                camera.position.z + lookAhead.z
+            ),
+            glm::vec2(min.x + CHUNK_W * 0.5f, min.z + CHUNK_D * 0.5f)
+        );
+        if (frustum.isBoxVisible(min, max)) {
+            distance -= UPLOAD_VISIBLE_BONUS;
+        }
+        order.emplace_back(distance, i);
+    }
+    std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) {
+        return a.first > b.first;
+    });
+    size_t uploaded = 0;
+    while (!order.empty()) {
+        auto& result = pendingResults[order.back().second];
+        size_t size = upload_size(result);
+        // at least one result per frame to make progress
+        if (uploaded > 0 && uploaded + size > budget) {
+            break;
+        }
+        uploaded += size;
+        applyResult(std::move(result));
+        order.pop_back();
+    }
+    std::vector<RendererResult> postponed;
+    postponed.reserve(order.size());
+    for (const auto& [_, index] : order) {
+        postponed.push_back(std::move(pendingResults[index]));
+    }
+    pendingResults = std::move(postponed);
+}
+
+/// @brief Chunk mesh bounds used for frustum culling
+static void get_mesh_bounds(
+    const Chunk& chunk, const ChunkMesh& mesh, glm::vec3& min, glm::vec3& max
+) {
+    auto aabbMin = mesh.meshAABB.min();
+    auto aabbMax = mesh.meshAABB.max();
+    min = glm::vec3(
+        chunk.x * CHUNK_W + std::min(0.0f, aabbMin.x),
+        chunk.bottom,
+        chunk.z * CHUNK_D + std::min(0.0f, aabbMin.z)
+    );
+    max = glm::vec3(
+        chunk.x * CHUNK_W + aabbMax.x,
+        chunk.top,
+        chunk.z * CHUNK_D + aabbMax.z
+    );
 }
 
-const Mesh<ChunkVertex>* ChunksRenderer::retrieveChunk(
+void ChunksRenderer::cullChunks() {
+    const auto& chunksList = chunks.getChunks();
+    chunksBounds.clear();
+    for (const auto& chunk : chunksList) {
+        glm::vec3 min {};
+        glm::vec3 max {};
+        if (chunk) {
+            const auto& found = meshes.find({chunk->x, chunk->z});
+            if (found != meshes.end()) {
+                get_mesh_bounds(*chunk, found->second, min, max);
+            }
+        }
+        chunksBounds.push_back(min, max);
+    }
+    frustum.areBoxesVisible(chunksBounds, chunksVisible);
+}
+
+bool ChunksRenderer::isChunkVisible(
+    size_t index, const glm::vec3& min, const glm::vec3& max
+) const {
+    // mesh may be rebuilt after the batch culling
+    if (index < chunksBounds.size() && chunksBounds.minX[index] == min.x &&
+        chunksBounds.minY[index] == min.y &&
+        chunksBounds.minZ[index] == min.z &&
+        chunksBounds.maxX[index] == max.x &&
+        chunksBounds.maxY[index] == max.y &&
+        chunksBounds.maxZ[index] == max.z) {
+        return Frustum::isVisible(chunksVisible, index);
+    }
+    return frustum.isBoxVisible(min, max);
+}
+
+const ChunkMesh* ChunksRenderer::retrieveChunk(
     size_t index, const Camera& camera, bool culling
 ) {
     auto chunk = chunks.getChunks()[index];
@@ -190,7 +614,7 @@ const Mesh<ChunkVertex>* ChunksRenderer::retrieveChunk(
         if (found == meshes.end()) {
             return nullptr;
         } else {
-            return found->second.mesh.get();
+            return &found->second;
         }
     }
     float distance = glm::distance(
@@ -201,10 +625,28 @@ const Mesh<ChunkVertex>* ChunksRenderer::retrieveChunk(
             (chunk->z + 0.5f) * CHUNK_D
         )
     );
+    const auto& found = meshes.find({chunk->x, chunk->z});
+    int lod = choose_lod(
+        distance,
+        found == meshes.end() ? -1 : found->second.lod,
+        pressured_lod_distance(
+            settings.graphics.lodDistance.get(),
+            debug::memory::get_video_pressure()
+        )
+    );
+    // nearest to the predicted position chunks first
+    float aheadDistance = glm::distance(
+        glm::vec2(
+            camera.position.x + lookAhead.x, camera.position.z + lookAhead.z
+        ),
+        glm::vec2((chunk->x + 0.5f) * CHUNK_W, (chunk->z + 0.5f) * CHUNK_D)
+    );
     auto mesh = getOrRender(
         chunk,
         distance < CHUNK_W * 1.5f * 10.0f,
-        distance > CHUNK_W * settings.chunks.loadDistance.get() * 0.5
+        distance > CHUNK_W * settings.chunks.loadDistance.get() * 0.5,
+        -static_cast<int>(aheadDistance),
+        lod
     );
     if (mesh == nullptr) {
         return nullptr;
@@ -213,23 +655,69 @@ const Mesh<ChunkVertex>* ChunksRenderer::retrieveChunk(
         chunk->updateHeights();
     }
     if (culling) {
-        const auto& meshAABB = mesh->meshAABB;
-        auto aabbMin = meshAABB.min();
-        auto aabbMax = meshAABB.max();
-        glm::vec3 min(
-            chunk->x * CHUNK_W + std::min(0.0f, aabbMin.x),
-            chunk->bottom,
-            chunk->z * CHUNK_D + std::min(0.0f, aabbMin.z)
-        );
-        glm::vec3 max(
-            chunk->x * CHUNK_W + aabbMax.x,
-            chunk->top,
-            chunk->z * CHUNK_D + aabbMax.z
-        );
+        glm::vec3 min;
+        glm::vec3 max;
+        get_mesh_bounds(*chunk, *mesh, min, max);
+        if (!isChunkVisible(index, min, max)) return nullptr;
+    }
+    return mesh;
+}
 
-        if (!frustum.isBoxVisible(min, max)) return nullptr;
+void ChunksRenderer::drawMesh(
+    const ChunkMesh& mesh,
+    const glm::vec3& coord,
+    bool dense,
+    Shader& shader,
+    chunk_sections_t visibleSections
+) {
+    if (!arena->isIndirect()) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), coord);
+        shader.uniformMatrix("u_model", model);
+        for (int i = 0; i < CHUNK_SECTIONS; i++) {
+            const auto& section = mesh.sections[i];
+            if (section && (visibleSections & (1U << i))) {
+                arena->draw(*section, dense);
+            }
+        }
+        return;
+    }
+    for (int i = 0; i < CHUNK_SECTIONS; i++) {
+        const auto& section = mesh.sections[i];
+        if (section == nullptr || !(visibleSections & (1U << i))) {
+            continue;
+        }
+        const auto& arenaMesh = *section;
+        if (dense >= arenaMesh.ibos.size() ||
+            arenaMesh.ibos[dense].count == 0) {
+            continue;
+        }
+        if (batches.size() <= arenaMesh.page) {
+            batches.resize(arenaMesh.page + 1);
+        }
+        const auto& ibo = arenaMesh.ibos[dense];
+        auto& batch = batches[arenaMesh.page];
+        batch.commands.push_back(DrawElementsIndirectCommand {
+            static_cast<uint32_t>(ibo.count),
+            1,
+            static_cast<uint32_t>(ibo.offset),
+            static_cast<int32_t>(arenaMesh.vertexOffset),
+            static_cast<uint32_t>(batch.instances.size())
+        });
+        batch.instances.push_back(ChunkInstance {coord});
+    }
+}
+
+void ChunksRenderer::flushBatches(Shader& shader) {
+    if (!arena->isIndirect()) {
+        return;
+    }
+    shader.uniformMatrix("u_model", glm::mat4(1.0f));
+    for (size_t page = 0; page < batches.size(); page++) {
+        auto& batch = batches[page];
+        arena->drawIndirect(page, batch.commands, batch.instances);
+        batch.commands.clear();
+        batch.instances.clear();
     }
-    return mesh->mesh.get();
 }
 
 void ChunksRenderer::drawShadowsPass(
@@ -245,6 +733,8 @@ void ChunksRenderer::drawShadowsPass(
     auto denseDistance = settings.graphics.denseRenderDistance.get();
     auto denseDistance2 = denseDistance * denseDistance;
 
+    shadowBounds.clear();
+    shadowMeshes.clear();
     for (const auto& chunk : chunks.getChunks()) {
         if (chunk == nullptr) {
             continue;
@@ -254,27 +744,98 @@ void ChunksRenderer::drawShadowsPass(
         if (found == meshes.end()) {
             continue;
         }
-
-        glm::vec3 coord(
-            pos.x * CHUNK_W + 0.5f, 0.5f, pos.y * CHUNK_D + 0.5f
-        );
-
         glm::vec3 min(pos.x * CHUNK_W, chunk->bottom, pos.y * CHUNK_D);
         glm::vec3 max(
             pos.x * CHUNK_W + CHUNK_W,
             chunk->top,
             pos.y * CHUNK_D + CHUNK_D
         );
+        shadowBounds.push_back(min, max);
+        shadowMeshes.push_back(&found->second);
+    }
+    frustum.areBoxesVisible(shadowBounds, shadowVisible);
 
-        if (!frustum.isBoxVisible(min, max)) {
+    for (size_t i = 0; i < shadowMeshes.size(); i++) {
+        if (!Frustum::isVisible(shadowVisible, i)) {
             continue;
         }
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), coord);
-        shader.uniformMatrix("u_model", model);
-        found->second.mesh->draw(GL_TRIANGLES, 
-            glm::distance2(playerCamera.position * glm::vec3(1, 0, 1), 
-                           (min + max) * 0.5f * glm::vec3(1, 0, 1)) < denseDistance2);
+        glm::vec3 min(
+            shadowBounds.minX[i], shadowBounds.minY[i], shadowBounds.minZ[i]
+        );
+        glm::vec3 max(
+            shadowBounds.maxX[i], shadowBounds.maxY[i], shadowBounds.maxZ[i]
+        );
+        glm::vec3 coord(min.x + 0.5f, 0.5f, min.z + 0.5f);
+        drawMesh(
+            *shadowMeshes[i],
+            coord,
+            glm::distance2(
+                playerCamera.position * glm::vec3(1, 0, 1),
+                (min + max) * 0.5f * glm::vec3(1, 0, 1)
+            ) < denseDistance2,
+            shader
+        );
+    }
+    flushBatches(shader);
+}
+
+bool ChunksRenderer::updateVisibility(const Camera& camera) {
+    const auto& chunksList = chunks.getChunks();
+    int width = chunks.getWidth();
+    int offsetX = chunks.getOffsetX();
+    int offsetZ = chunks.getOffsetY();
+    // indexed by position relative to the matrix origin
+    sectionsConnectivity.assign(chunksList.size(), nullptr);
+    for (const auto& chunk : chunksList) {
+        if (chunk == nullptr) {
+            continue;
+        }
+        const auto& found = meshes.find({chunk->x, chunk->z});
+        if (found != meshes.end()) {
+            size_t index = (chunk->z - offsetZ) * width + (chunk->x - offsetX);
+            sectionsConnectivity[index] = &found->second.sectionsConnectivity;
+        }
+    }
+    return visibility.update(
+        chunks.getWidth(),
+        chunks.getHeight(),
+        {chunks.getOffsetX(), chunks.getOffsetY()},
+        sectionsConnectivity,
+        camera.position,
+        &frustum
+    );
+}
+
+void ChunksRenderer::updateDrawOrder(const Camera& camera) {
+    glm::ivec2 cameraChunk(
+        floordiv<CHUNK_W>(static_cast<int>(std::floor(camera.position.x))),
+        floordiv<CHUNK_D>(static_cast<int>(std::floor(camera.position.z)))
+    );
+    glm::ivec2 offset(chunks.getOffsetX(), chunks.getOffsetY());
+    if (indices.size() == chunks.getVolume() &&
+        cameraChunk == orderCameraChunk && offset == orderOffset) {
+        return;
+    }
+    orderCameraChunk = cameraChunk;
+    orderOffset = offset;
+
+    int chunksWidth = chunks.getWidth();
+    int chunksHeight = chunks.getHeight();
+    indices.resize(chunks.getVolume());
+    for (int i = 0; i < static_cast<int>(indices.size()); i++) {
+        // chunks matrix buffer is wrapped around the window origin
+        int bx = i % chunksWidth;
+        int bz = i / chunksWidth;
+        int x = offset.x +
+                (((bx - offset.x) % chunksWidth) + chunksWidth) % chunksWidth -
+                cameraChunk.x;
+        int z = offset.y +
+                (((bz - offset.y) % chunksHeight) + chunksHeight) %
+                    chunksHeight -
+                cameraChunk.y;
+        indices[i] = ChunksSortEntry {i, x * x + z * z};
     }
+    std::sort(indices.begin(), indices.end());
 }
 
 void ChunksRenderer::drawChunks(
@@ -290,22 +851,15 @@ void ChunksRenderer::drawChunks(
     int chunksOffsetX = chunks.getOffsetX();
     int chunksOffsetY = chunks.getOffsetY();
 
-    if (indices.size() != chunks.getVolume()) {
-        indices.clear();
-        for (int i = 0; i < chunks.getVolume(); i++) {
-            indices.push_back(ChunksSortEntry {i, 0});
-        }
-    }
-    float px = camera.position.x / static_cast<float>(CHUNK_W) - 0.5f;
-    float pz = camera.position.z / static_cast<float>(CHUNK_D) - 0.5f;
-    for (auto& index : indices) {
-        float x = index.index % chunksWidth + chunksOffsetX - px;
-        float z = index.index / chunksWidth + chunksOffsetY - pz;
-        index.d = (x * x + z * z) * 1024;
-    }
-    util::insertion_sort(indices.begin(), indices.end());
+    updateDrawOrder(camera);
+    visibleIndices.clear();
 
     bool culling = settings.graphics.frustumCulling.get();
+    bool occlusion = culling && settings.graphics.occlusionCulling.get() &&
+                     updateVisibility(camera);
+    if (culling) {
+        cullChunks();
+    }
 
     visibleChunks = 0;
     shader.uniform1i("u_alphaClip", true);
@@ -313,36 +867,89 @@ void ChunksRenderer::drawChunks(
     auto denseDistance = settings.graphics.denseRenderDistance.get();
     auto denseDistance2 = denseDistance * denseDistance;
 
-    // TODO: minimize draw calls number
     for (int i = indices.size()-1; i >= 0; i--) {
         auto& chunk = chunks.getChunks()[indices[i].index];
         auto mesh = retrieveChunk(indices[i].index, camera, culling);
         if (mesh == nullptr) {
             continue;
         }
+        visibleIndices.push_back(indices[i].index);
+        chunk_sections_t sections = CHUNK_ALL_SECTIONS;
+        if (occlusion) {
+            sections = visibility.getVisible(
+                (chunk->z - chunksOffsetY) * chunksWidth +
+                (chunk->x - chunksOffsetX)
+            );
+            if (sections == 0) {
+                continue;
+            }
+        }
         glm::vec3 coord(
             chunk->x * CHUNK_W + 0.5f, 0.5f, chunk->z * CHUNK_D + 0.5f
         );
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), coord);
-        shader.uniformMatrix("u_model", model);
-        mesh->draw(GL_TRIANGLES, glm::distance2(camera.position * glm::vec3(1, 0, 1), 
-            (coord + glm::vec3(CHUNK_W * 0.5f, 0.0f, CHUNK_D * 0.5f))) < denseDistance2);
+        drawMesh(
+            *mesh,
+            coord,
+            glm::distance2(
+                camera.position * glm::vec3(1, 0, 1),
+                (coord + glm::vec3(CHUNK_W * 0.5f, 0.0f, CHUNK_D * 0.5f))
+            ) < denseDistance2,
+            shader,
+            sections
+        );
         visibleChunks++;
     }
+    flushBatches(shader);
 }
 
-static inline void write_sorting_mesh_entries(
-    ChunkVertex* buffer, const std::vector<SortingMeshEntry>& chunkEntries
-) {
-    for (const auto& entry : chunkEntries) {
+/// @brief Upload translucent entries vertices to the chunk sorted mesh
+static void create_sorted_mesh(ChunkMesh& mesh) {
+    auto& entries = mesh.sortingMeshData.entries;
+    size_t size = 0;
+    for (auto& entry : entries) {
+        entry.vertexOffset = size;
+        size += entry.vertexData.size();
+    }
+    static util::Buffer<ChunkVertex> buffer;
+    if (buffer.size() < size) {
+        buffer = util::Buffer<ChunkVertex>(size);
+    }
+    for (const auto& entry : entries) {
         const auto& vertexData = entry.vertexData;
         std::memcpy(
-            buffer,
+            buffer.data() + entry.vertexOffset,
             vertexData.data(),
             vertexData.size() * sizeof(ChunkVertex)
         );
-        buffer += vertexData.size();
     }
+    mesh.sortedMesh = std::make_unique<Mesh<ChunkVertex>>(buffer.data(), size);
+}
+
+/// @brief Sort translucent entries back to front and rewrite the sorted
+/// mesh index buffer. Vertex data is not uploaded again
+static void sort_entries(ChunkMesh& mesh, const glm::vec3& cameraPos) {
+    auto& entries = mesh.sortingMeshData.entries;
+    size_t size = 0;
+    for (auto& entry : entries) {
+        entry.distance = static_cast<long long>(
+            glm::distance2(entry.position, cameraPos)
+        );
+        size += entry.vertexData.size();
+    }
+    std::sort(entries.begin(), entries.end());
+
+    static util::Buffer<uint32_t> indices;
+    if (indices.size() < size) {
+        indices = util::Buffer<uint32_t>(size);
+    }
+    size_t count = 0;
+    for (const auto& entry : entries) {
+        for (size_t i = 0; i < entry.vertexData.size(); i++) {
+            indices[count++] = entry.vertexOffset + i;
+        }
+    }
+    mesh.sortedMesh->reloadIndices({IndexBufferData {indices.data(), count}});
+    mesh.sortedCameraBlock = glm::floor(cameraPos);
 }
 
 void ChunksRenderer::drawSortedMeshes(const Camera& camera, Shader& shader) {
@@ -350,7 +957,6 @@ void ChunksRenderer::drawSortedMeshes(const Camera& camera, Shader& shader) {
     static int frameid = 0;
     frameid++;
 
-    bool culling = settings.graphics.frustumCulling.get();
     const auto& chunks = this->chunks.getChunks();
     const auto& cameraPos = camera.position;
     const auto& atlas = assets.require<Atlas>("blocks");
@@ -360,8 +966,9 @@ void ChunksRenderer::drawSortedMeshes(const Camera& camera, Shader& shader) {
     shader.uniformMatrix("u_model", glm::mat4(1.0f));
     shader.uniform1i("u_alphaClip", false);
     
-    for (const auto& index : indices) {
-        const auto& chunk = chunks[index.index];
+    // back to front
+    for (auto it = visibleIndices.rbegin(); it != visibleIndices.rend(); ++it) {
+        const auto& chunk = chunks[*it];
         if (chunk == nullptr || !chunk->flags.lighted) {
             continue;
         }
@@ -370,51 +977,19 @@ void ChunksRenderer::drawSortedMeshes(const Camera& camera, Shader& shader) {
             continue;
         }
 
-        if (culling) {
-            glm::vec3 min(chunk->x * CHUNK_W, chunk->bottom, chunk->z * CHUNK_D);
-            glm::vec3 max(
-                chunk->x * CHUNK_W + CHUNK_W,
-                chunk->top,
-                chunk->z * CHUNK_D + CHUNK_D
-            );
-
-            if (!frustum.isBoxVisible(min, max)) continue;
-        }
-
-        auto& chunkEntries = found->second.sortingMeshData.entries;
-
-        if (chunkEntries.size() == 1) {
-            auto& entry = chunkEntries.at(0);
-            if (found->second.sortedMesh == nullptr) {
-                found->second.sortedMesh = std::make_unique<Mesh<ChunkVertex>>(
-                    entry.vertexData.data(), entry.vertexData.size()
-                );
-            }
-            found->second.sortedMesh->draw();
-            continue;
-        }
-        for (auto& entry : chunkEntries) {
-            entry.distance = static_cast<long long>(
-                glm::distance2(entry.position, cameraPos)
-            );
-        }
-        if (found->second.sortedMesh == nullptr ||
-            (frameid + chunk->x) % sortInterval == 0) {
-            std::sort(chunkEntries.begin(), chunkEntries.end());
-            size_t size = 0;
-            for (const auto& entry : chunkEntries) {
-                size += entry.vertexData.size();
+        auto& mesh = found->second;
+        if (mesh.sortedMesh == nullptr) {
+            create_sorted_mesh(mesh);
+            if (mesh.sortingMeshData.entries.size() > 1) {
+                sort_entries(mesh, cameraPos);
             }
-
-            static util::Buffer<ChunkVertex> buffer;
-            if (buffer.size() < size) {
-                buffer = util::Buffer<ChunkVertex>(size);
-            }
-            write_sorting_mesh_entries(buffer.data(), chunkEntries);
-            found->second.sortedMesh = std::make_unique<Mesh<ChunkVertex>>(
-                buffer.data(), size
-            );
+        } else if (mesh.sortingMeshData.entries.size() > 1 &&
+                   (frameid + chunk->x) % sortInterval == 0 &&
+                   mesh.sortedCameraBlock != glm::ivec3(glm::floor(cameraPos))) {
+            // order changes noticeably only when the camera moves to
+            // another block
+            sort_entries(mesh, cameraPos);
         }
-        found->second.sortedMesh->draw();
+        mesh.sortedMesh->draw();
     }
 }
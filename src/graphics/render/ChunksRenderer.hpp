@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <memory>
 #include <vector>
 #include <unordered_map>
@@ -8,17 +9,22 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 
+#include "util/ReadersGate.hpp"
+#include "util/observer_handler.hpp"
 #include "util/ThreadPool.hpp"
+#include "maths/FrustumCulling.hpp"
 #include "commons.hpp"
 
 template<typename VertexStructure> class Mesh;
+template<typename VertexStructure, typename InstanceStructure> class MeshArena;
+struct DrawElementsIndirectCommand;
 class Chunk;
 class Level;
 class Camera;
 class Shader;
 class Assets;
 class Chunks;
-class Frustum;
+class ContentIndices;
 class BlocksRenderer;
 class ContentGfxCache;
 struct EngineSettings;
@@ -35,31 +41,123 @@ struct ChunksSortEntry {
 struct RendererResult {
     glm::ivec2 key;
     bool cancelled;
-    ChunkMeshData meshData;
+    chunk_sections_t sections;
+    int lod;
+    /// @brief Meshes of the rebuilt sections in ascending order
+    std::vector<ChunkMeshData> meshData;
 };
 
 struct RendererJob {
     std::shared_ptr<Chunk> chunk;
-    std::shared_ptr<VoxelsRenderVolume> volume;
+    /// @brief The chunk and its neighbours providing voxels to the volume,
+    /// row by row (nullptr - missing chunk)
+    std::array<std::shared_ptr<const Chunk>, 9> area;
+    /// @brief Sections to rebuild
+    chunk_sections_t sections;
+    /// @brief Level of detail
+    int lod;
+    /// @brief Range of the volume layers to fill [bottom, top)
+    int bottom;
+    int top;
+    bool backlight;
+};
+
+/// @brief Draw commands collected for one chunks arena page
+struct ChunksDrawBatch {
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<ChunkInstance> instances;
 };
 
 class ChunksRenderer {
     const Chunks& chunks;
+    const ContentIndices& contentIndices;
     const Assets& assets;
     const Frustum& frustum;
     const EngineSettings& settings;
 
     std::unique_ptr<BlocksRenderer> renderer;
+    /// @brief Shared chunk meshes storage. Must outlive meshes
+    std::unique_ptr<MeshArena<PackedChunkVertex, ChunkInstance>> arena;
+    /// @brief Per-page draw batches reused between passes
+    std::vector<ChunksDrawBatch> batches;
     std::unordered_map<glm::ivec2, ChunkMesh> meshes;
     std::unordered_map<glm::ivec2, bool> inwork;
+    /// @brief Chunks matrix indices ordered farthest to nearest to the
+    /// camera chunk
     std::vector<ChunksSortEntry> indices;
+    /// @brief Camera chunk and matrix offset the order is built for
+    glm::ivec2 orderCameraChunk {};
+    glm::ivec2 orderOffset {};
+    /// @brief Matrix indices of chunks passed frustum culling in the last
+    /// opaque pass, nearest first. Reused by the translucent pass
+    std::vector<int> visibleIndices;
+    /// @brief Chunks meshes bounds by matrix index (empty if no mesh)
+    /// tested against the frustum in one batch before drawing
+    BoxesArray chunksBounds;
+    std::vector<uint64_t> chunksVisible;
+    /// @brief Shadow pass meshes and their bounds (reused)
+    BoxesArray shadowBounds;
+    std::vector<const ChunkMesh*> shadowMeshes;
+    std::vector<uint64_t> shadowVisible;
+    /// @brief Fill chunksBounds and cull them with the frustum
+    void cullChunks();
+    /// @brief Use batch culling result if the bounds are unchanged
+    bool isChunkVisible(
+        size_t index, const glm::vec3& min, const glm::vec3& max
+    ) const;
+    /// @brief Rebuild chunks draw order if the camera moved to another
+    /// chunk or the matrix is moved or resized
+    void updateDrawOrder(const Camera& camera);
+    SectionsVisibility visibility;
+    /// @brief Chunks sections connectivity by chunk index (reused)
+    std::vector<const sections_connectivity*> sectionsConnectivity;
+    /// @brief Open while chunks are not modified, so workers may gather
+    /// voxels volumes. Must outlive the thread pool
+    util::ReadersGate chunksGate;
     util::ThreadPool<RendererJob, RendererResult> threadPool;
-    const Mesh<ChunkVertex>* retrieveChunk(
+    /// @brief Background results waiting for upload budget
+    std::vector<RendererResult> pendingResults;
+    /// @brief Apply background job result
+    void applyResult(RendererResult&& result);
+    const ChunkMesh* retrieveChunk(
         size_t index, const Camera& camera, bool culling
     );
-    std::shared_ptr<VoxelsRenderVolume> prepareVoxelsVolume(const Chunk& chunk);
+    /// @brief Upload rebuilt sections to the arena, reusing the previous
+    /// sections space if possible
+    ChunkMesh& updateMesh(
+        const glm::ivec2& key,
+        chunk_sections_t sections,
+        int lod,
+        std::vector<ChunkMeshData>&& meshData
+    );
+    /// @brief Draw chunk mesh or add it to the indirect draw batch
+    /// @param visibleSections mask of the sections to draw
+    void drawMesh(
+        const ChunkMesh& mesh,
+        const glm::vec3& coord,
+        bool dense,
+        Shader& shader,
+        chunk_sections_t visibleSections = CHUNK_ALL_SECTIONS
+    );
+    /// @brief Find sections visible from the camera (occlusion culling)
+    /// @return false if visibility is not available
+    bool updateVisibility(const Camera& camera);
+    /// @brief Draw collected indirect batches
+    void flushBatches(Shader& shader);
+    /// @brief Capture the chunk area required to build the sections.
+    /// Voxels are gathered later by the worker
+    RendererJob prepareJob(
+        const std::shared_ptr<Chunk>& chunk, chunk_sections_t sections, int lod
+    );
 
     size_t enqueuedInFrame = 0;
+    /// @brief Predicted player movement. Meshes are built and uploaded
+    /// nearest to the predicted position first
+    glm::vec3 lookAhead {};
+    /// @brief Incremented on every chunk mesh change
+    uint64_t meshesRevision = 0;
+    /// @brief Memory accounting sources (see debug::memory)
+    std::vector<ObserverHandler> memorySources;
 public:
     ChunksRenderer(
         const Level& level,
@@ -71,14 +169,30 @@ public:
     );
     virtual ~ChunksRenderer();
 
+    /// @param priority background job priority (greater is built first)
+    /// @param lod level of detail. All sections are rebuilt if the current
+    /// mesh has another one
     const ChunkMesh* render(
-        const std::shared_ptr<Chunk>& chunk, bool important, bool lowPriority
+        const std::shared_ptr<Chunk>& chunk,
+        bool important,
+        bool lowPriority,
+        int priority = 0,
+        int lod = 0
     );
     void unload(const Chunk* chunk);
     void clear();
 
+    /// @return built mesh of the chunk or nullptr
+    const ChunkMesh* getMesh(const glm::ivec2& chunkPos) const;
+
+    /// @brief Get chunk mesh rebuilding it if modified. Mesh of another
+    /// level of detail is replaced in background
     const ChunkMesh* getOrRender(
-        const std::shared_ptr<Chunk>& chunk, bool important, bool lowPriority
+        const std::shared_ptr<Chunk>& chunk,
+        bool important,
+        bool lowPriority,
+        int priority = 0,
+        int lod = 0
     );
 
     void drawShadowsPass(
@@ -87,9 +201,30 @@ public:
 
     void drawChunks(const Camera& camera, Shader& shader);
 
+    /// @brief Draw translucent meshes of the chunks visible in the last
+    /// drawChunks call
     void drawSortedMeshes(const Camera& camera, Shader& shader);
 
-    void update();
+    /// @brief Upload background meshing results. Results in view and
+    /// nearest to the camera are uploaded first within the per frame
+    /// upload budget, the rest are kept for the next frames
+    void update(const Camera& camera);
+
+    /// @brief Allow background workers to gather voxels of the enqueued
+    /// jobs. Chunks must not be modified until endChunksAccess call
+    void beginChunksAccess();
+
+    /// @brief Wait for background workers to finish gathering voxels
+    void endChunksAccess();
+
+    /// @brief Set predicted player movement (see Player::getLookAhead)
+    void setLookAhead(const glm::vec3& offset) {
+        lookAhead = offset;
+    }
+
+    uint64_t getMeshesRevision() const {
+        return meshesRevision;
+    }
 
     static size_t visibleChunks;
 };
@@ -118,6 +118,7 @@ private:
         vert.color = {
             0, 0, 0, static_cast<uint8_t>((coord.y / 8.0f * 0.25f + 0.75f) * 255)
         };
+        vert.region = {};
     }
 
     void face(
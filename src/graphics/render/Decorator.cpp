@@ -1,5 +1,6 @@
 #include "Decorator.hpp"
 
+#include "ChunksRenderer.hpp"
 #include "ParticlesRenderer.hpp"
 #include "WorldRenderer.hpp"
 #include "TextsRenderer.hpp"
@@ -23,21 +24,15 @@
 #include "io/io.hpp"
 #include "audio/audio.hpp"
 #include "maths/util.hpp"
+#include "maths/voxmaths.hpp"
 #include "debug/Logger.hpp"
 
 namespace fs = std::filesystem;
 
 static debug::Logger logger("decorator");
 
-/// @brief Not greater than 64 for this BIG_PRIME value
+/// @brief Size of the cube around the camera, where block emitters are added
 inline constexpr int UPDATE_AREA_DIAMETER = 32;
-/// @brief Number of blocks in the volume
-inline constexpr int UPDATE_BLOCKS =
-    UPDATE_AREA_DIAMETER * UPDATE_AREA_DIAMETER * UPDATE_AREA_DIAMETER;
-/// @brief Number of update iterations
-inline constexpr int ITERATIONS = 512;
-/// @brief Big prime number used for pseudo-random 3d array iteration
-inline constexpr int BIG_PRIME = 666667;
 
 Decorator::Decorator(
     Engine& engine,
@@ -175,9 +170,9 @@ void Decorator::updateRandom(
         random.rand32() % 12,
         random.rand32() % 12
     );
-    auto vox = chunks.get(pos);
+    auto vox = chunks.getVoxel(pos.x, pos.y, pos.z);
     auto chunk = chunks.getChunkByVoxel(pos);
-    if (vox == nullptr || chunk == nullptr) {
+    if (!vox || chunk == nullptr) {
         return;
     }
 
@@ -187,7 +182,8 @@ void Decorator::updateRandom(
         return;
     }
     for (int y = pos.y + 1; y < chunk->top; y++) {
-        if (indices.blocks.require(chunks.get(pos.x, y, pos.z)->id).obstacle) {
+        if (indices.blocks.require(chunks.getVoxel(pos.x, y, pos.z)->id)
+                .obstacle) {
             return;
         }
     }
@@ -224,28 +220,53 @@ void Decorator::updateRandom(
     }
 }
 
-void Decorator::update(
-    float delta,
-    const glm::ivec3& areaStart,
-    const glm::ivec3& areaCenter
+static inline bool is_in_area(
+    const glm::ivec3& pos, const glm::ivec3& start, const glm::ivec3& end
 ) {
-    int index = currentIndex;
-    currentIndex = (currentIndex + BIG_PRIME) % UPDATE_BLOCKS;
+    return pos.x >= start.x && pos.y >= start.y && pos.z >= start.z &&
+           pos.x < end.x && pos.y < end.y && pos.z < end.z;
+}
 
+void Decorator::updateEmitters(const glm::ivec3& areaCenter) {
+    const auto& chunksRenderer = renderer.getChunksRenderer();
     const auto& chunks = *player.chunks;
     const auto& indices = *level.content.getIndices();
 
-    int lx = index % UPDATE_AREA_DIAMETER;
-    int lz = (index / UPDATE_AREA_DIAMETER) % UPDATE_AREA_DIAMETER;
-    int ly = (index / UPDATE_AREA_DIAMETER / UPDATE_AREA_DIAMETER);
-    
-    glm::ivec3 offset {lx, ly, lz};
-    auto pos = areaStart + offset;
+    glm::ivec3 areaStart = areaCenter - glm::ivec3(UPDATE_AREA_DIAMETER / 2);
+    glm::ivec3 areaEnd = areaStart + glm::ivec3(UPDATE_AREA_DIAMETER);
+    if (areaEnd.y <= 0 || areaStart.y >= CHUNK_H) {
+        return;
+    }
+    int bottomSection = std::max(0, areaStart.y) / CHUNK_SECTION_H;
+    int topSection = (std::min(CHUNK_H, areaEnd.y) - 1) / CHUNK_SECTION_H;
 
-    if (auto vox = chunks.get(pos)) {
-        const auto& def = indices.blocks.require(vox->id);
-        if (def.particles) {
-            addParticles(def, pos);
+    int endX = floordiv(areaEnd.x - 1, CHUNK_W);
+    int endZ = floordiv(areaEnd.z - 1, CHUNK_D);
+    for (int cz = floordiv(areaStart.z, CHUNK_D); cz <= endZ; cz++) {
+        for (int cx = floordiv(areaStart.x, CHUNK_W); cx <= endX; cx++) {
+            auto mesh = chunksRenderer.getMesh({cx, cz});
+            if (mesh == nullptr) {
+                continue;
+            }
+            for (int section = bottomSection; section <= topSection; section++) {
+                for (uint32_t index : mesh->sectionsEmitters[section]) {
+                    glm::ivec3 pos {
+                        cx * CHUNK_W + index % CHUNK_W,
+                        index / (CHUNK_W * CHUNK_D),
+                        cz * CHUNK_D + index / CHUNK_W % CHUNK_D};
+                    if (!is_in_area(pos, areaStart, areaEnd) ||
+                        blockEmitters.find(pos) != blockEmitters.end()) {
+                        continue;
+                    }
+                    // mesh may be not rebuilt yet after the block change
+                    if (auto vox = chunks.getVoxel(pos.x, pos.y, pos.z)) {
+                        const auto& def = indices.blocks.require(vox->id);
+                        if (def.particles) {
+                            addParticles(def, pos);
+                        }
+                    }
+                }
+            }
         }
     }
 }
@@ -262,7 +283,8 @@ void Decorator::updateBlockEmitters(const Camera& camera) {
         }
 
         bool remove = false;
-        if (auto vox = chunks.get(iter->first)) {
+        const auto& pos = iter->first;
+        if (auto vox = chunks.getVoxel(pos.x, pos.y, pos.z)) {
             const auto& def = indices.blocks.require(vox->id);
             if (def.particles == nullptr) {
                 remove = true;
@@ -340,19 +362,24 @@ void Decorator::update(
     const Camera& camera,
     const Weather& weather
 ) {
-    updateRandomSounds(delta, weather);    
-
     glm::ivec3 pos = camera.position;
-    for (int i = 0; i < ITERATIONS; i++) {
-        update(delta, pos - glm::ivec3(UPDATE_AREA_DIAMETER / 2), pos);
-    }
-    int randIters = std::min(50'000, static_cast<int>(delta * 24'000));
-    for (int i = 0; i < randIters; i++) {
-        if (weather.a.intensity > 1.e-3f) {
-            updateRandom(delta, pos, weather.a);
-        }
-        if (weather.b.intensity > 1.e-3f) {
-            updateRandom(delta, pos, weather.b);
+    updateEmitters(pos);
+
+    // weather effects are updated with the environment tick rate
+    environmentTimer += delta;
+    if (environmentTimer >= ENVIRONMENT_TICK_INTERVAL) {
+        float envDelta = environmentTimer;
+        environmentTimer = 0.0f;
+        updateRandomSounds(envDelta, weather);
+
+        int randIters = std::min(50'000, static_cast<int>(envDelta * 24'000));
+        for (int i = 0; i < randIters; i++) {
+            if (weather.a.intensity > 1.e-3f) {
+                updateRandom(envDelta, pos, weather.a);
+            }
+            if (weather.b.intensity > 1.e-3f) {
+                updateRandom(envDelta, pos, weather.b);
+            }
         }
     }
     updateBlockEmitters(camera);
@@ -28,16 +28,16 @@ class Decorator {
     WorldRenderer& renderer;
     std::unordered_map<glm::ivec3, uint64_t> blockEmitters;
     std::unordered_map<int64_t, u64id_t> playerTexts;
-    int currentIndex = 0;
     NotePreset playerNamePreset {};
     float thunderTimer = 0.0f;
+    /// @brief Time passed since the last weather effects update
+    float environmentTimer = 0.0f;
+
+    /// @brief Add emitters of the blocks having particles around the camera
+    /// using the lists collected by chunks meshing
+    void updateEmitters(const glm::ivec3& areaCenter);
+
 
-    void update(
-        float delta,
-        const glm::ivec3& areaStart,
-        const glm::ivec3& areaCenter
-    );
-    
     /// @brief Updates weather effects, blocks ambient sounds, etc..
     void updateRandom(
         float delta,
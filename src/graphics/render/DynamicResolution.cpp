@@ -0,0 +1,38 @@
+#include "DynamicResolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+inline constexpr float FRAME_TIME_SMOOTHING = 0.1f;
+/// @brief Scale is increased only when frame time is noticeably below
+/// the target to not switch resolution back and forth
+inline constexpr float INCREASE_THRESHOLD = 0.85f;
+inline constexpr float DECREASE_THRESHOLD = 1.05f;
+
+float DynamicResolution::update(float delta, float targetFrameTime) {
+    if (frameTime == 0.0f) {
+        frameTime = delta;
+    }
+    frameTime += (delta - frameTime) * FRAME_TIME_SMOOTHING;
+    timer += delta;
+    if (timer < ADJUST_INTERVAL || frameTime <= 0.0f) {
+        return scale;
+    }
+    timer = 0.0f;
+
+    float ratio = targetFrameTime / frameTime;
+    if (ratio > 1.0f / INCREASE_THRESHOLD ||
+        ratio < 1.0f / DECREASE_THRESHOLD) {
+        // frame time is approximated as proportional to pixels count
+        float desired = scale * std::sqrt(ratio);
+        desired = std::round(desired / SCALE_STEP) * SCALE_STEP;
+        scale = std::clamp(desired, MIN_SCALE, 1.0f);
+    }
+    return scale;
+}
+
+void DynamicResolution::reset() {
+    scale = 1.0f;
+    frameTime = 0.0f;
+    timer = 0.0f;
+}
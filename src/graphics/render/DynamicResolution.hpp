@@ -0,0 +1,27 @@
+#pragma once
+
+/// @brief Adapts world render resolution scale to keep frame time near
+/// the target. Scale is changed in steps and not often than once per
+/// ADJUST_INTERVAL to not reallocate framebuffers every frame
+class DynamicResolution {
+    float scale = 1.0f;
+    /// @brief Smoothed frame time (seconds)
+    float frameTime = 0.0f;
+    float timer = 0.0f;
+public:
+    static constexpr float MIN_SCALE = 0.5f;
+    static constexpr float SCALE_STEP = 0.05f;
+    static constexpr float ADJUST_INTERVAL = 0.5f;
+
+    /// @param delta last frame time (seconds)
+    /// @param targetFrameTime target frame time (seconds)
+    /// @return resolution scale for the next frame
+    float update(float delta, float targetFrameTime);
+
+    /// @brief Return to the native resolution
+    void reset();
+
+    float getScale() const {
+        return scale;
+    }
+};
@@ -31,6 +31,11 @@ struct Particle {
     float angle;
     /// @brief Angular velocity
     float angularVelocity;
+    /// @brief Cached light (preset.lighting)
+    glm::vec4 light {};
+    /// @brief Block position the light was sampled at
+    glm::ivec3 lightBlock {};
+    bool lightValid = false;
 };
 
 class Texture;
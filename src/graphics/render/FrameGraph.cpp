@@ -0,0 +1,165 @@
+#include "FrameGraph.hpp"
+
+#include <GL/glew.h>
+#include <algorithm>
+
+inline constexpr float TIMINGS_SMOOTHING = 0.1f;
+
+FrameGraph::FrameGraph() = default;
+
+FrameGraph::~FrameGraph() {
+    for (auto& frame : timingFrames) {
+        if (!frame.queries.empty()) {
+            glDeleteQueries(frame.queries.size(), frame.queries.data());
+        }
+    }
+}
+
+void FrameGraph::addPass(
+    const char* name,
+    std::initializer_list<std::string_view> reads,
+    std::initializer_list<std::string_view> writes,
+    PassFunc execute,
+    bool enabled
+) {
+    Pass pass {};
+    pass.name = name;
+    pass.readsBegin = resources.size();
+    resources.insert(resources.end(), reads);
+    pass.readsEnd = resources.size();
+    pass.writesBegin = resources.size();
+    resources.insert(resources.end(), writes);
+    pass.writesEnd = resources.size();
+    pass.execute = std::move(execute);
+    pass.enabled = enabled;
+    passes.push_back(std::move(pass));
+}
+
+void FrameGraph::addOutput(std::string_view resource) {
+    outputs.push_back(resource);
+}
+
+void FrameGraph::cull() {
+    // walking from the last pass: a pass is needed if it writes
+    // a resource needed by the later passes or the frame outputs
+    std::vector<std::string_view> needed = outputs;
+    auto isNeeded = [&needed](std::string_view resource) {
+        return std::find(needed.begin(), needed.end(), resource) !=
+               needed.end();
+    };
+    for (size_t i = passes.size(); i-- > 0;) {
+        auto& pass = passes[i];
+        pass.needed = false;
+        if (!pass.enabled) {
+            continue;
+        }
+        for (uint j = pass.writesBegin; j < pass.writesEnd; j++) {
+            pass.needed |= isNeeded(resources[j]);
+        }
+        if (!pass.needed) {
+            continue;
+        }
+        // written resources are produced here unless read by the pass
+        for (uint j = pass.writesBegin; j < pass.writesEnd; j++) {
+            needed.erase(
+                std::remove(needed.begin(), needed.end(), resources[j]),
+                needed.end()
+            );
+        }
+        for (uint j = pass.readsBegin; j < pass.readsEnd; j++) {
+            if (!isNeeded(resources[j])) {
+                needed.push_back(resources[j]);
+            }
+        }
+    }
+}
+
+void FrameGraph::execute() {
+    cull();
+
+    TimingFrame* frame = nullptr;
+    if (timingsEnabled) {
+        // results of the frame issued TIMING_FRAMES ago are ready usually
+        frame = &timingFrames[timingFrame];
+        timingFrame = (timingFrame + 1) % TIMING_FRAMES;
+        readTimings(*frame);
+        size_t required = passes.size() * 2;
+        if (frame->queries.size() < required) {
+            size_t count = frame->queries.size();
+            frame->queries.resize(required);
+            glGenQueries(required - count, frame->queries.data() + count);
+        }
+        frame->names.clear();
+    }
+    executed.clear();
+    for (auto& pass : passes) {
+        if (!pass.needed) {
+            continue;
+        }
+        if (frame) {
+            size_t index = frame->names.size() * 2;
+            glQueryCounter(frame->queries[index], GL_TIMESTAMP);
+            pass.execute();
+            glQueryCounter(frame->queries[index + 1], GL_TIMESTAMP);
+            frame->names.push_back(pass.name);
+        } else {
+            pass.execute();
+        }
+        executed.push_back(pass.name);
+    }
+    if (frame) {
+        frame->issued = frame->names.size();
+    }
+    passes.clear();
+    resources.clear();
+    outputs.clear();
+}
+
+void FrameGraph::readTimings(TimingFrame& frame) {
+    if (frame.issued == 0) {
+        return;
+    }
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(
+        frame.queries[frame.issued * 2 - 1],
+        GL_QUERY_RESULT_AVAILABLE,
+        &available
+    );
+    if (!available) {
+        return;
+    }
+    for (size_t i = 0; i < frame.issued; i++) {
+        GLuint64 start = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+        float millis = (end - start) * 1e-6f;
+
+        std::string_view name = frame.names[i];
+        auto found = std::find_if(
+            timings.begin(),
+            timings.end(),
+            [name](const auto& timing) { return timing.name == name; }
+        );
+        if (found == timings.end()) {
+            timings.push_back({frame.names[i], millis});
+        } else {
+            found->gpuMillis += (millis - found->gpuMillis) * TIMINGS_SMOOTHING;
+        }
+    }
+    frame.issued = 0;
+}
+
+void FrameGraph::setTimingsEnabled(bool flag) {
+    if (timingsEnabled && !flag) {
+        timings.clear();
+        for (auto& frame : timingFrames) {
+            frame.issued = 0;
+        }
+    }
+    timingsEnabled = flag;
+}
+
+bool FrameGraph::wasExecuted(std::string_view name) const {
+    return std::find(executed.begin(), executed.end(), name) != executed.end();
+}
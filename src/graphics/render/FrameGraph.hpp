@@ -0,0 +1,90 @@
+#pragma once
+
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "typedefs.hpp"
+
+/// @brief Frame render passes declared with resources they read and write.
+/// Passes are executed in the declaration order, passes not contributing
+/// (directly or via other passes) to the frame outputs are skipped.
+/// Passes blending onto a resource must declare it as read too.
+/// GPU time of the passes may be measured with timestamp queries
+class FrameGraph {
+public:
+    using PassFunc = std::function<void()>;
+
+    struct PassTiming {
+        /// @brief Pass name (must have static storage duration)
+        const char* name;
+        /// @brief Smoothed GPU time of the pass in milliseconds
+        float gpuMillis;
+    };
+
+    FrameGraph();
+    ~FrameGraph();
+
+    /// @brief Declare pass of the frame
+    /// @param name pass name (must have static storage duration)
+    /// @param reads resources read by the pass
+    /// @param writes resources written by the pass
+    /// @param execute pass rendering function
+    /// @param enabled disabled pass is not executed and does not depend
+    /// on resources it reads
+    void addPass(
+        const char* name,
+        std::initializer_list<std::string_view> reads,
+        std::initializer_list<std::string_view> writes,
+        PassFunc execute,
+        bool enabled = true
+    );
+
+    /// @brief Mark resource as a result of the frame
+    void addOutput(std::string_view resource);
+
+    /// @brief Execute needed passes and clear the graph for the next frame
+    void execute();
+
+    /// @brief Measure passes GPU time (timestamp queries)
+    void setTimingsEnabled(bool flag);
+
+    const std::vector<PassTiming>& getTimings() const {
+        return timings;
+    }
+
+    /// @return true if pass of the last executed frame was executed
+    bool wasExecuted(std::string_view name) const;
+private:
+    struct Pass {
+        const char* name;
+        uint readsBegin;
+        uint readsEnd;
+        uint writesBegin;
+        uint writesEnd;
+        PassFunc execute;
+        bool enabled;
+        bool needed = false;
+    };
+    struct TimingFrame {
+        /// @brief Begin and end timestamp query pairs
+        std::vector<uint> queries;
+        std::vector<const char*> names;
+        size_t issued = 0;
+    };
+    static constexpr int TIMING_FRAMES = 3;
+
+    std::vector<Pass> passes;
+    /// @brief Resources of all passes (ranges are stored in passes)
+    std::vector<std::string_view> resources;
+    std::vector<std::string_view> outputs;
+    std::vector<const char*> executed;
+
+    bool timingsEnabled = false;
+    TimingFrame timingFrames[TIMING_FRAMES];
+    int timingFrame = 0;
+    std::vector<PassTiming> timings;
+
+    void cull();
+    void readTimings(TimingFrame& frame);
+};
@@ -1,7 +1,7 @@
 #include "MainBatch.hpp"
 
 #include "graphics/core/Texture.hpp"
-#include "graphics/core/Mesh.hpp"
+#include "graphics/core/StreamMesh.hpp"
 #include "graphics/core/ImageData.hpp"
 #include "voxels/Chunks.hpp"
 #include "voxels/Chunk.hpp"
@@ -11,7 +11,7 @@ MainBatch::MainBatch(size_t capacity)
         : buffer(std::make_unique<MainBatchVertex[]>(capacity)),
           capacity(capacity),
           index(0),
-          mesh(std::make_unique<Mesh<MainBatchVertex>>(buffer.get(), 0)) {
+          mesh(std::make_unique<StreamMesh<MainBatchVertex>>(capacity)) {
 
     const ubyte pixels[] = {
             255, 255, 255, 255,
@@ -46,8 +46,7 @@ void MainBatch::flush() {
         texture = blank.get();
     }
     texture->bind();
-    mesh->reload(buffer.get(), index);
-    mesh->draw();
+    mesh->draw(buffer.get(), index);
     index = 0;
 }
 
@@ -10,7 +10,7 @@
 #include "graphics/core/MeshData.hpp"
 
 template<typename VertexStructure>
-class Mesh;
+class StreamMesh;
 class Texture;
 class Chunks;
 
@@ -37,7 +37,7 @@ class MainBatch {
 
     UVRegion region {0.0f, 0.0f, 1.0f, 1.0f};
 
-    std::unique_ptr<Mesh<MainBatchVertex>> mesh;
+    std::unique_ptr<StreamMesh<MainBatchVertex>> mesh;
     std::unique_ptr<Texture> blank;
 
     const Texture* texture = nullptr;
@@ -63,17 +63,14 @@ void ModelBatch::draw(
     const glm::mat3& rotation,
     glm::vec3 tint,
     const texture_names_map* varTextures,
-    bool backlight
+    glm::vec4 lights
 ) {
     setTexture(mesh.texture, varTextures);
     size_t vcount = mesh.vertices.size();
     const auto& vertexData = mesh.vertices.data();
 
-    glm::vec4 lights(1, 1, 1, 0);
-    if (mesh.shading) {
-        glm::vec3 gpos = matrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
-        gpos += lightsOffset;
-        lights = MainBatch::sampleLight(gpos, chunks, backlight);
+    if (!mesh.shading) {
+        lights = glm::vec4(1, 1, 1, 0);
     }
     for (size_t i = 0; i < vcount / 3; i++) {
         batch->prepare(3);
@@ -101,9 +98,27 @@ void ModelBatch::draw(glm::mat4 matrix,
                       glm::vec3 tint,
                       const model::Model* model,
                       const texture_names_map* varTextures) {
+    if (model->meshes.empty()) {
+        return;
+    }
+    // all meshes of the model share the transform and the light sample
+    glm::mat3 rotation = extract_rotation(matrix);
+    glm::vec4 lights(1, 1, 1, 0);
+    bool shading = std::any_of(
+        model->meshes.begin(),
+        model->meshes.end(),
+        [](const auto& mesh) { return mesh.shading; }
+    );
+    if (shading) {
+        glm::vec3 gpos = matrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        gpos += lightsOffset;
+        lights = MainBatch::sampleLight(
+            gpos, chunks, settings.graphics.backlight.get()
+        );
+    }
     for (const auto& mesh : model->meshes) {
         entries.push_back({
-            matrix, extract_rotation(matrix), tint, &mesh, varTextures
+            matrix, rotation, tint, lights, &mesh, varTextures
         });
     }
 }
@@ -114,7 +129,6 @@ void ModelBatch::render() {
             return a.mesh->texture < b.mesh->texture;
         }
     );
-    bool backlight = settings.graphics.backlight.get();
     for (auto& entry : entries) {
         draw(
             *entry.mesh,
@@ -122,7 +136,7 @@ void ModelBatch::render() {
             entry.rotation,
             entry.tint,
             entry.varTextures,
-            backlight
+            entry.lights
         );
     }
     batch->flush();
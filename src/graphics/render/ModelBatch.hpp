@@ -36,7 +36,7 @@ class ModelBatch {
               const glm::mat3& rotation, 
               glm::vec3 tint,
               const texture_names_map* varTextures,
-              bool backlight);
+              glm::vec4 lights);
 
     void setTexture(const std::string& name,
                     const texture_names_map* varTextures);
@@ -45,6 +45,8 @@ class ModelBatch {
         glm::mat4 matrix;
         glm::mat3 rotation;
         glm::vec3 tint;
+        /// @brief Light sampled at the model origin
+        glm::vec4 lights;
         const model::Mesh* mesh;
         const texture_names_map* varTextures;
     };
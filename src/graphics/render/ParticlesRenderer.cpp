@@ -12,6 +12,9 @@
 #include "MainBatch.hpp"
 #include "settings.hpp"
 
+/// @brief Frames between particle light resamplings
+inline constexpr uint LIGHT_REFRESH_INTERVAL = 8;
+
 size_t ParticlesRenderer::visibleParticles = 0;
 size_t ParticlesRenderer::aliveEmitters = 0;
 
@@ -56,9 +59,10 @@ void ParticlesRenderer::updateParticles(float delta) {
         }
         visibleParticles += vec.size();
 
-        auto iter = vec.begin();
-        while (iter != vec.end()) {
-            auto& particle = *iter;
+        // dead particles are removed by compacting the alive ones in order
+        size_t alive = 0;
+        for (size_t i = 0; i < vec.size(); i++) {
+            auto& particle = vec[i];
             auto& emitter = *particle.emitter;
             auto& preset = emitter.preset;
 
@@ -81,12 +85,15 @@ void ParticlesRenderer::updateParticles(float delta) {
             }
             update_particle(particle, delta, chunks);
             if (particle.lifetime <= 0.0f) {
-                iter = vec.erase(iter);
                 emitter.refCount--;
-            } else {
-                iter++;
+                continue;
+            }
+            if (alive != i) {
+                vec[alive] = particle;
             }
+            alive++;
         }
+        vec.erase(vec.begin() + alive, vec.end());
     }
 
     for (const auto& texture : unusedTextures) {
@@ -137,7 +144,17 @@ void ParticlesRenderer::renderParticle(
 
     glm::vec4 light(1, 1, 1, 0);
     if (preset.lighting) {
-        light = calc_lights(particle, preset, backlight, scale, chunks);
+        // 27 samples are taken, so the light is resampled only when the
+        // particle moves to another block or once per refresh interval
+        glm::ivec3 block = glm::floor(particle.position);
+        if (!particle.lightValid || block != particle.lightBlock ||
+            (frame + particle.random) % LIGHT_REFRESH_INTERVAL == 0) {
+            particle.light =
+                calc_lights(particle, preset, backlight, scale, chunks);
+            particle.lightBlock = block;
+            particle.lightValid = true;
+        }
+        light = particle.light;
     }
 
     glm::vec3 localRight = right;
@@ -189,24 +206,28 @@ void ParticlesRenderer::render(const Camera& camera) {
     visibleParticles = 0;
 
     bool backlight = settings.backlight.get();
+    frame++;
 
     batch->begin();
     for (auto& [texture, vec] : particles) {
         batch->setTexture(texture);
 
-        auto iter = vec.begin();
-        while (iter != vec.end()) {
-            auto& particle = *iter;
+        size_t alive = 0;
+        for (size_t i = 0; i < vec.size(); i++) {
+            auto& particle = vec[i];
 
             renderParticle(particle, camera, backlight);
             
             if (particle.lifetime <= 0.0f) {
-                iter = vec.erase(iter);
                 particle.emitter->refCount--;
-            } else {
-                iter++;
+                continue;
+            }
+            if (alive != i) {
+                vec[alive] = particle;
             }
+            alive++;
         }
+        vec.erase(vec.begin() + alive, vec.end());
     }
     batch->flush();
 }
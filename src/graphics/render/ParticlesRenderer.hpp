@@ -24,6 +24,7 @@ class ParticlesRenderer {
 
     std::unordered_map<u64id_t, std::unique_ptr<Emitter>> emitters;
     u64id_t nextEmitter = 1;
+    uint64_t frame = 0;
 
     void renderParticle(
         Particle& particle, const Camera& camera, bool backlight
@@ -41,7 +41,7 @@ int PrecipitationRenderer::getHeightAt(int x, int z) {
     x -= cx * CHUNK_W;
     z -= cz * CHUNK_D;
     while (y > 0) {
-        const auto& vox = chunk->voxels[vox_index(x, y, z)];
+        voxel vox = chunk->get(x, y, z);
         if (vox.id == 0) {
             y--;
             continue;
@@ -90,27 +90,54 @@ static UVRegion calc_uv(
     return {u1, v1, u1 + m * scale, v1 + FACE_SIZE.y * scale};
 }
 
+/// @brief Interval of full precipitation heights refresh (seconds)
+static constexpr float HEIGHTS_REFRESH_INTERVAL = 0.25f;
+
 void PrecipitationRenderer::update(float delta) {
     timer += delta;
+    heightsTimer += delta;
+}
+
+void PrecipitationRenderer::updateHeights(int x, int z) {
+    if (!heightsValid || heightsTimer >= HEIGHTS_REFRESH_INTERVAL) {
+        heights.setCenter(x, z);
+        for (int z = heights.beginY(); z < heights.endY(); z++) {
+            for (int x = heights.beginX(); x < heights.endX(); x++) {
+                heights.at(x, z) = getHeightAt(x, z);
+            }
+        }
+        heightsValid = true;
+        heightsTimer = 0.0f;
+        return;
+    }
+    auto prev = heights;
+    heights.setCenter(x, z);
+    if (heights.beginX() == prev.beginX() && heights.beginY() == prev.beginY()) {
+        return;
+    }
+    for (int z = heights.beginY(); z < heights.endY(); z++) {
+        for (int x = heights.beginX(); x < heights.endX(); x++) {
+            if (x >= prev.beginX() && x < prev.endX() &&
+                z >= prev.beginY() && z < prev.endY()) {
+                heights.at(x, z) = prev.at(x, z);
+            } else {
+                heights.at(x, z) = getHeightAt(x, z);
+            }
+        }
+    }
 }
 
 void PrecipitationRenderer::render(
     const Camera& camera, const WeatherPreset& weather
 ) {
-    const int radius = 6;
-    const int depth = 12;
+    const int radius = RADIUS;
+    const int depth = DEPTH;
 
     int x = glm::floor(camera.position.x);
     int y = glm::floor(camera.position.y);
     int z = glm::floor(camera.position.z);
 
-    util::CentredMatrix<int, (depth + 1) * 2> heights;
-    heights.setCenter(x, z);
-    for (int z = heights.beginY(); z < heights.endY(); z++) {
-        for (int x = heights.beginX(); x < heights.endX(); x++) {
-            heights.at(x, z) = getHeightAt(x, z);
-        }
-    }
+    updateHeights(x, z);
 
     batch->begin();
     auto& texture = assets.require<Texture>(weather.fall.texture);
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <memory>
+
 #include "typedefs.hpp"
+#include "util/CentredMatrix.hpp"
 
 class Level;
 class Assets;
@@ -16,7 +19,20 @@ class PrecipitationRenderer {
     const Assets& assets;
     float timer = 0.0f;
 
+    static constexpr int RADIUS = 6;
+    static constexpr int DEPTH = 12;
+    /// @brief Columns heights around the camera reused between frames
+    util::CentredMatrix<int, (DEPTH + 1) * 2> heights;
+    bool heightsValid = false;
+    /// @brief Time since the full heights refresh
+    float heightsTimer = 0.0f;
+
     int getHeightAt(int x, int z);
+
+    /// @brief Move heights centre to the camera column, sampling only new
+    /// columns. All columns are resampled periodically to follow world
+    /// changes
+    void updateHeights(int x, int z);
 public:
     PrecipitationRenderer(
         const Assets& assets,
@@ -0,0 +1,150 @@
+#include "SectionsVisibility.hpp"
+
+#include "maths/FrustumCulling.hpp"
+#include "maths/voxmaths.hpp"
+
+#include <algorithm>
+
+static const glm::ivec3 FACE_DIRECTIONS[SectionConnectivity::FACES] {
+    {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1},
+};
+
+static inline int opposite_face(int face) {
+    return face ^ 1;
+}
+
+SectionConnectivity calculate_connectivity(const bool* occluding) {
+    constexpr int W = CHUNK_W;
+    constexpr int H = CHUNK_SECTION_H;
+    constexpr int D = CHUNK_D;
+
+    SectionConnectivity connectivity;
+    bool visited[CHUNK_SECTION_VOL] {};
+    uint16_t stack[CHUNK_SECTION_VOL];
+
+    for (int i = 0; i < CHUNK_SECTION_VOL; i++) {
+        if (occluding[i] || visited[i]) {
+            continue;
+        }
+        // flood fill of the open area collecting touched faces
+        int faces = 0;
+        int stackSize = 0;
+        stack[stackSize++] = i;
+        visited[i] = true;
+        while (stackSize) {
+            int index = stack[--stackSize];
+            int x = index % W;
+            int y = index / (D * W);
+            int z = (index / W) % D;
+            faces |= (x == 0) | (x == W - 1) << 1 | (y == 0) << 2 |
+                     (y == H - 1) << 3 | (z == 0) << 4 | (z == D - 1) << 5;
+
+            for (const auto& dir : FACE_DIRECTIONS) {
+                int nx = x + dir.x;
+                int ny = y + dir.y;
+                int nz = z + dir.z;
+                if (nx < 0 || ny < 0 || nz < 0 || nx >= W || ny >= H ||
+                    nz >= D) {
+                    continue;
+                }
+                int neighbour = vox_index(nx, ny, nz, W, D);
+                if (occluding[neighbour] || visited[neighbour]) {
+                    continue;
+                }
+                visited[neighbour] = true;
+                stack[stackSize++] = neighbour;
+            }
+        }
+        for (int a = 0; a < SectionConnectivity::FACES; a++) {
+            if (!(faces & (1 << a))) {
+                continue;
+            }
+            for (int b = a + 1; b < SectionConnectivity::FACES; b++) {
+                if (faces & (1 << b)) {
+                    connectivity.connect(a, b);
+                }
+            }
+        }
+        if (connectivity == SectionConnectivity::all()) {
+            break;
+        }
+    }
+    return connectivity;
+}
+
+bool SectionsVisibility::update(
+    int width,
+    int depth,
+    const glm::ivec2& offset,
+    const std::vector<const sections_connectivity*>& connectivity,
+    const glm::vec3& cameraPos,
+    const Frustum* frustum
+) {
+    visible.assign(connectivity.size(), 0);
+    queue.clear();
+
+    glm::ivec3 camera = glm::floor(cameraPos);
+    int cx = floordiv<CHUNK_W>(camera.x) - offset.x;
+    int cz = floordiv<CHUNK_D>(camera.z) - offset.y;
+    if (cx < 0 || cz < 0 || cx >= width || cz >= depth) {
+        return false;
+    }
+    int cameraIndex = cz * width + cx;
+    if (connectivity[cameraIndex] == nullptr) {
+        return false;
+    }
+    int cy = std::clamp(
+        floordiv<CHUNK_SECTION_H>(camera.y), 0, CHUNK_SECTIONS - 1
+    );
+    visible[cameraIndex] |= 1U << cy;
+    queue.push_back(Node {cameraIndex, static_cast<int8_t>(cy), -1, 0});
+
+    const glm::vec3 sectionSize(CHUNK_W, CHUNK_SECTION_H, CHUNK_D);
+    for (size_t i = 0; i < queue.size(); i++) {
+        Node node = queue[i];
+        const auto& sectionConnectivity =
+            (*connectivity[node.index])[node.section];
+        int x = node.index % width;
+        int z = node.index / width;
+
+        for (int face = 0; face < SectionConnectivity::FACES; face++) {
+            if (node.directions & (1U << opposite_face(face))) {
+                continue;
+            }
+            if (node.face >= 0 &&
+                !sectionConnectivity.isConnected(node.face, face)) {
+                continue;
+            }
+            const auto& dir = FACE_DIRECTIONS[face];
+            int nx = x + dir.x;
+            int ny = node.section + dir.y;
+            int nz = z + dir.z;
+            if (nx < 0 || nz < 0 || ny < 0 || nx >= width || nz >= depth ||
+                ny >= CHUNK_SECTIONS) {
+                continue;
+            }
+            int neighbour = nz * width + nx;
+            if (connectivity[neighbour] == nullptr ||
+                (visible[neighbour] & (1U << ny))) {
+                continue;
+            }
+            if (frustum) {
+                glm::vec3 min(
+                    (nx + offset.x) * CHUNK_W,
+                    ny * CHUNK_SECTION_H,
+                    (nz + offset.y) * CHUNK_D
+                );
+                if (!frustum->isBoxVisible(min, min + sectionSize)) {
+                    continue;
+                }
+            }
+            visible[neighbour] |= 1U << ny;
+            queue.push_back(Node {
+                neighbour,
+                static_cast<int8_t>(ny),
+                static_cast<int8_t>(opposite_face(face)),
+                static_cast<uint8_t>(node.directions | (1U << face))});
+        }
+    }
+    return true;
+}
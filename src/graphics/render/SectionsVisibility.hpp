@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "typedefs.hpp"
+#include "constants.hpp"
+
+class Frustum;
+
+/// @brief Pairs of chunk section faces connected through non-occluding
+/// voxels. Faces order: -x, +x, -y, +y, -z, +z
+class SectionConnectivity {
+    uint16_t bits = 0;
+
+    static constexpr int pair_index(int a, int b) {
+        int lo = a < b ? a : b;
+        int hi = a < b ? b : a;
+        // index in the upper triangle of the 6x6 matrix
+        return lo * 5 - lo * (lo - 1) / 2 + (hi - lo - 1);
+    }
+public:
+    static constexpr int FACES = 6;
+    static constexpr uint16_t ALL_BITS = (1U << 15) - 1;
+
+    constexpr SectionConnectivity() = default;
+    constexpr explicit SectionConnectivity(uint16_t bits) : bits(bits) {}
+
+    /// @brief Section visible through from any face to any other
+    static constexpr SectionConnectivity all() {
+        return SectionConnectivity(ALL_BITS);
+    }
+
+    void connect(int a, int b) {
+        if (a != b) {
+            bits |= 1U << pair_index(a, b);
+        }
+    }
+
+    bool isConnected(int a, int b) const {
+        return a == b || (bits & (1U << pair_index(a, b)));
+    }
+
+    uint16_t getBits() const {
+        return bits;
+    }
+
+    bool operator==(const SectionConnectivity& o) const {
+        return bits == o.bits;
+    }
+};
+
+/// @brief Calculate section faces connectivity
+/// @param occluding voxels occlusion flags of a chunk section
+/// (CHUNK_SECTION_VOL) in vox_index order
+SectionConnectivity calculate_connectivity(const bool* occluding);
+
+using sections_connectivity =
+    std::array<SectionConnectivity, CHUNK_SECTIONS>;
+
+/// @brief Chunk sections visibility search (occlusion culling). Sections
+/// are traversed from the camera section through connected faces, never
+/// turning back to the camera, so sections hidden behind occluding
+/// geometry are not reached.
+class SectionsVisibility {
+public:
+    /// @brief Find visible sections
+    /// @param width, depth chunks matrix size
+    /// @param offset world chunk coordinates of the matrix origin
+    /// @param connectivity sections connectivity of the matrix chunks
+    /// or nullptr if chunk has no mesh
+    /// @param cameraPos camera world position
+    /// @param frustum frustum sections are checked against
+    /// (nullptr to disable)
+    /// @return false if the camera is outside of the meshed chunks
+    /// (visibility is not available)
+    bool update(
+        int width,
+        int depth,
+        const glm::ivec2& offset,
+        const std::vector<const sections_connectivity*>& connectivity,
+        const glm::vec3& cameraPos,
+        const Frustum* frustum
+    );
+
+    /// @return visible sections of the chunk by its matrix index
+    chunk_sections_t getVisible(size_t index) const {
+        return visible[index];
+    }
+private:
+    struct Node {
+        int index;
+        int8_t section;
+        /// @brief Face the section is entered through (-1 for camera section)
+        int8_t face;
+        /// @brief Bit mask of directions passed from the camera section
+        uint8_t directions;
+    };
+    std::vector<chunk_sections_t> visible;
+    std::vector<Node> queue;
+};
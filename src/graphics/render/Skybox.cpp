@@ -22,10 +22,16 @@ using namespace advanced_pipeline;
 
 const int STARS_COUNT = 3000;
 const int STARS_SEED = 632;
+/// @brief Sky parameters change ignored (faces are not refreshed)
+const float REFRESH_THRESHOLD = 1e-4f;
+/// @brief Sky parameters change refreshing all faces at once
+const float REFRESH_ALL_THRESHOLD = 0.01f;
+const uint ALL_FACES = 0b111111;
 
-Skybox::Skybox(uint size, Shader& shader)
+Skybox::Skybox(uint size, Shader& shader, bool amortized)
   : size(size),
     shader(shader),
+    amortized(amortized),
     batch3d(std::make_unique<Batch3D>(4096))
 {
     auto cubemap = std::make_unique<Cubemap>(size, size, ImageFormat::RGB888);
@@ -173,6 +179,34 @@ void Skybox::draw(
 void Skybox::refresh(const DrawContext& pctx, float t, float mie, const glm::vec3& tint, const glm::vec3& hightlight, uint quality) {
     frameid++;
     float dayTime = t;
+    t *= glm::two_pi<float>();
+
+    lightDir = glm::normalize(glm::vec3(sin(t), -cos(t), 0.0f));
+
+    float sunAngle = glm::radians((t / glm::two_pi<float>() - 0.25f) * 360.0f);
+    float x = -glm::cos(sunAngle + glm::pi<float>() * 0.5f) * glm::radians(sunAltitude);
+    float y = sunAngle - glm::pi<float>() * 0.5f;
+    float z = glm::radians(0.0f);
+    rotation = glm::rotate(glm::mat4(1.0f), y, glm::vec3(0, 1, 0));
+    rotation = glm::rotate(rotation, x, glm::vec3(1, 0, 0));
+    rotation = glm::rotate(rotation, z, glm::vec3(0, 0, 1));
+    lightDir = glm::vec3(rotation * glm::vec4(0, 0, -1, 1));
+
+    glm::vec3 tintChange = glm::abs(tint - prevTint);
+    float change = glm::abs(mie - prevMie) + glm::abs(t - prevT) +
+                   glm::abs(prevHighlight.r - hightlight.r) +
+                   glm::max(tintChange.r, glm::max(tintChange.g, tintChange.b));
+    bool refreshAll = !amortized || change >= REFRESH_ALL_THRESHOLD;
+    if (change >= REFRESH_THRESHOLD) {
+        outdatedFaces = ALL_FACES;
+        prevMie = mie;
+        prevT = t;
+        prevHighlight = hightlight;
+        prevTint = tint;
+    }
+    if (outdatedFaces == 0) {
+        return;
+    }
     DrawContext ctx = pctx.sub();
     ctx.setDepthMask(false);
     ctx.setDepthTest(false);
@@ -186,18 +220,6 @@ void Skybox::refresh(const DrawContext& pctx, float t, float mie, const glm::vec
     glActiveTexture(GL_TEXTURE0 + TARGET_SKYBOX);
     cubemap->bind();
     shader.use();
-    t *= glm::two_pi<float>();
-
-    lightDir = glm::normalize(glm::vec3(sin(t), -cos(t), 0.0f));
-
-    float sunAngle = glm::radians((t / glm::two_pi<float>() - 0.25f) * 360.0f);
-    float x = -glm::cos(sunAngle + glm::pi<float>() * 0.5f) * glm::radians(sunAltitude);
-    float y = sunAngle - glm::pi<float>() * 0.5f;
-    float z = glm::radians(0.0f);
-    rotation = glm::rotate(glm::mat4(1.0f), y, glm::vec3(0, 1, 0));
-    rotation = glm::rotate(rotation, x, glm::vec3(1, 0, 0));
-    rotation = glm::rotate(rotation, z, glm::vec3(0, 0, 1));
-    lightDir = glm::vec3(rotation * glm::vec4(0, 0, -1, 1));
 
     shader.uniform1i("u_quality", quality);
     shader.uniform1f("u_mie", mie);
@@ -207,17 +229,18 @@ void Skybox::refresh(const DrawContext& pctx, float t, float mie, const glm::vec
     shader.uniform3f("u_lightDir", lightDir);
     shader.uniform1f("u_dayTime", dayTime);
 
-    if (glm::abs(mie-prevMie) + glm::abs(t-prevT) + glm::abs(prevHighlight.r - hightlight.r) >= 0.01) {
-        for (uint face = 0; face < 6; face++) {
-            refreshFace(face, cubemap);
+    for (uint i = 0; i < 6; i++) {
+        // round-robin starting face
+        uint face = (frameid + i) % 6;
+        if (!(outdatedFaces & (1U << face))) {
+            continue;
         }
-    } else {
-        uint face = frameid % 6;
         refreshFace(face, cubemap);
+        outdatedFaces &= ~(1U << face);
+        if (!refreshAll) {
+            break;
+        }
     }
-    prevMie = mie;
-    prevT = t;
-    prevHighlight = hightlight;
 
     cubemap->unbind();
     glActiveTexture(GL_TEXTURE0);
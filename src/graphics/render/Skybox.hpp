@@ -45,11 +45,17 @@ class Skybox {
     std::unique_ptr<Batch3D> batch3d;
     std::vector<SkySprite> sprites;
     int frameid = 0;
+    /// @brief Refresh one outdated face per frame
+    bool amortized;
+    /// @brief Bit mask of cubemap faces outdated since the last change
+    uint outdatedFaces = 0;
 
+    /// @brief Parameters of the last change (faces are outdated after)
     float prevMie = -1.0f;
     float prevT = -1.0f;
     float sunAltitude = 45.0f;
     glm::vec3 prevHighlight {1.0f};
+    glm::vec3 prevTint {1.0f};
     glm::mat4 rotation;
 
     void drawStars(float angle, float opacity);
@@ -58,7 +64,9 @@ class Skybox {
     );
     void refreshFace(uint face, Cubemap* cubemap);
 public:
-    Skybox(uint size, Shader& shader);
+    /// @param amortized refresh one cubemap face per frame on slow
+    /// changes (day/night cycle) instead of all faces
+    Skybox(uint size, Shader& shader, bool amortized = true);
     ~Skybox();
 
     void draw(
@@ -24,27 +24,13 @@ void TextsRenderer::renderNote(
     const Camera& camera,
     const EngineSettings& settings,
     bool hudVisible,
-    bool frontLayer,
-    bool projected
+    bool frontLayer
 ) {
     const auto& text = note.getText();
     const auto& preset = note.getPreset();
     auto pos = note.getPosition();
 
-    if (util::distance2(pos, camera.position) >
-        util::sqr(preset.renderDistance / camera.zoom)) {
-        return;
-    }
-    if ((preset.displayMode == NoteDisplayMode::PROJECTED) != projected) {
-        return;
-    }
-    float opacity = 1.0f;
-    if (frontLayer) {
-        if (preset.xrayOpacity <= 0.0001f) {
-            return;
-        }
-        opacity = preset.xrayOpacity;
-    }
+    float opacity = frontLayer ? preset.xrayOpacity : 1.0f;
     auto& font = assets.require<Font>(FONT_DEFAULT);
 
     glm::vec3 xvec = note.getAxisX();
@@ -117,6 +103,28 @@ void TextsRenderer::renderNote(
     );
 }
 
+void TextsRenderer::collectVisible(const Camera& camera, bool frontLayer) {
+    worldNotes.clear();
+    projectedNotes.clear();
+
+    float zoom2 = util::sqr(camera.zoom);
+    for (const auto& [_, note] : notes) {
+        const auto& preset = note->getPreset();
+        if (frontLayer && preset.xrayOpacity <= 0.0001f) {
+            continue;
+        }
+        if (util::distance2(note->getPosition(), camera.position) * zoom2 >
+            util::sqr(preset.renderDistance)) {
+            continue;
+        }
+        if (preset.displayMode == NoteDisplayMode::PROJECTED) {
+            projectedNotes.push_back(note.get());
+        } else {
+            worldNotes.push_back(note.get());
+        }
+    }
+}
+
 void TextsRenderer::render(
     const DrawContext& context,
     const Camera& camera,
@@ -124,19 +132,23 @@ void TextsRenderer::render(
     bool hudVisible,
     bool frontLayer
 ) {
+    collectVisible(camera, frontLayer);
+    if (worldNotes.empty() && projectedNotes.empty()) {
+        return;
+    }
     auto& shader = assets.require<Shader>("ui3d");
     
     shader.use();
     shader.uniformMatrix("u_projview", camera.getProjView());
     shader.uniformMatrix("u_apply", glm::mat4(1.0f));
     batch.begin();
-    for (const auto& [_, note] : notes) {
-        renderNote(*note, context, camera, settings, hudVisible, frontLayer, false);
+    for (const auto note : worldNotes) {
+        renderNote(*note, context, camera, settings, hudVisible, frontLayer);
     }
     batch.flush();
     shader.uniformMatrix("u_projview", glm::mat4(1.0f));
-    for (const auto& [_, note] : notes) {
-        renderNote(*note, context, camera, settings, hudVisible, frontLayer, true);
+    for (const auto note : projectedNotes) {
+        renderNote(*note, context, camera, settings, hudVisible, frontLayer);
     }
     batch.flush();
 }
@@ -2,6 +2,7 @@
 
 #include <unordered_map>
 #include <memory>
+#include <vector>
 
 #include "typedefs.hpp"
 
@@ -21,14 +22,21 @@ class TextsRenderer {
     std::unordered_map<u64id_t, std::unique_ptr<TextNote>> notes;
     u64id_t nextNote = 1;
 
+    /// @brief Notes passed distance culling, reused between frames
+    std::vector<const TextNote*> worldNotes;
+    std::vector<const TextNote*> projectedNotes;
+
+    /// @brief Distance-cull all notes at once splitting them by
+    /// display mode
+    void collectVisible(const Camera& camera, bool frontLayer);
+
     void renderNote(
         const TextNote& note,
         const DrawContext& context,
         const Camera& camera,
         const EngineSettings& settings,
         bool hudVisible,
-        bool frontLayer,
-        bool projected
+        bool frontLayer
     );
 public:
     TextsRenderer(Batch3D& batch, const Assets& assets, const Frustum& frustum);
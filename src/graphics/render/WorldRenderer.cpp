@@ -3,6 +3,8 @@
 #include "assets/Assets.hpp"
 #include "assets/assets_util.hpp"
 #include "content/Content.hpp"
+#include "debug/Memory.hpp"
+#include "debug/Profiler.hpp"
 #include "engine/Engine.hpp"
 #include "coders/GLSLExtension.hpp"
 #include "frontend/LevelFrontend.hpp"
@@ -65,6 +67,7 @@ inline constexpr size_t MODEL_BATCH_CAPACITY = 20'000;
 
 bool WorldRenderer::showChunkBorders = false;
 bool WorldRenderer::showEntitiesDebug = false;
+std::vector<FrameGraph::PassTiming> WorldRenderer::gpuPassTimings;
 
 WorldRenderer::WorldRenderer(
     Engine& engine, LevelFrontend& frontend, Player& player
@@ -104,7 +107,8 @@ WorldRenderer::WorldRenderer(
     );
     skybox = std::make_unique<Skybox>(
         settings.graphics.skyboxResolution.get(),
-        assets.require<Shader>("skybox_gen")
+        assets.require<Shader>("skybox_gen"),
+        settings.graphics.skyboxAmortized.get()
     );
 
     const auto& content = level.content;
@@ -154,7 +158,7 @@ void WorldRenderer::setupWorldShader(
     shader.uniform1f("u_fogCurve", settings.graphics.fogCurve.get());
     shader.uniform1i("u_debugLights", lightsDebug);
     shader.uniform1i("u_debugNormals", false);
-    shader.uniform1f("u_dayTime", level.getWorld()->getInfo().daytime);
+    shader.uniform1f("u_dayTime", level.getWorld()->getRenderDaytime());
     shader.uniform2f("u_lightDir", skybox->getLightDir());
     shader.uniform1i("u_skybox", TARGET_SKYBOX);
 
@@ -181,6 +185,7 @@ void WorldRenderer::renderOpaque(
     const EngineSettings& settings,
     bool hudVisible
 ) {
+    VC_PROFILE_ZONE("WorldRenderer::renderOpaque");
     texts->render(ctx, camera, settings, hudVisible, false);
 
     bool culling = engine.getSettings().graphics.frustumCulling.get();
@@ -280,8 +285,21 @@ void WorldRenderer::refreshSettings(Shader** shaders) {
     const auto& graphics = engine.getSettings().graphics;
     gbufferPipeline = graphics.advancedRender.get();
 
+    int videoPressure = debug::memory::get_video_pressure();
     int shadowsQuality = graphics.shadowsQuality.get() * gbufferPipeline;
+    if (shadowsQuality > 0) {
+        // shadows are kept on, as disabling them recompiles shaders
+        shadowsQuality = std::max(1, shadowsQuality - videoPressure);
+    }
     shadowMapping->setQuality(shadowsQuality);
+
+    if (videoPressure != atlasVideoPressure) {
+        // smaller mip levels are sampled, not evicted
+        if (auto texture = assets.require<Atlas>("blocks").getTexture()) {
+            texture->setLodBias(static_cast<float>(videoPressure));
+        }
+        atlasVideoPressure = videoPressure;
+    }
     
     CompileTimeShaderSettings currentSettings {
         gbufferPipeline,
@@ -312,12 +330,22 @@ void WorldRenderer::update(const Camera& camera, float delta) {
     particles->update(camera, delta);
 }
 
+void WorldRenderer::updateResolutionScale(float delta) {
+    int targetFps = engine.getSettings().graphics.dynamicResolution.get();
+    if (targetFps == 0) {
+        dynamicResolution.reset();
+        return;
+    }
+    dynamicResolution.update(delta, 1.0f / targetFps);
+}
+
 void WorldRenderer::renderFrame(
     const DrawContext& pctx,
     Camera& camera,
     bool hudVisible,
     PostProcessing& postProcessing
 ) {
+    VC_PROFILE_ZONE("WorldRenderer::renderFrame");
     auto projView = camera.getProjView();
     auto world = level.getWorld();
 
@@ -344,30 +372,52 @@ void WorldRenderer::renderFrame(
     refreshSettings(affectedShaders);
 
     const auto& worldInfo = world->getInfo();
+    float daytime = world->getRenderDaytime();
     
     float clouds = weather.clouds();
     clouds = glm::max(worldInfo.fog, clouds);
     float mie = 1.0f + glm::max(worldInfo.fog, clouds * 0.5f) * 2.0f;
 
     float random = rand() / static_cast<float>(RAND_MAX);
-    skybox->refresh(
-        pctx,
-        worldInfo.daytime,
-        mie,
-        weather.skyTint(),
-        weather.highlight * random,
-        4
-    );
-
-    chunksRenderer->update();
+    auto highlight = weather.highlight * random;
+
+    chunksRenderer->setLookAhead(player.getLookAhead());
+    chunksRenderer->update(camera);
+
+    // world is rendered in the scaled resolution and upscaled by the
+    // post-processing, UI stays in the native resolution
+    DrawContext sctx = pctx.sub();
+    float scale = dynamicResolution.getScale();
+    if (scale < 1.0f) {
+        sctx.setViewport(glm::max(
+            glm::uvec2(glm::vec2(vp) * scale), glm::uvec2(1)
+        ));
+    }
+    float fogFactor =
+        15.0f / static_cast<float>(settings.chunks.loadDistance.get() - 2);
 
-    shadowMapping->refresh(camera, pctx, [this, &camera](Camera& shadowCamera) {
-        auto& shader = assets.require<Shader>("shadows");
-        setupWorldShader(shader, shadowCamera, engine.getSettings(), 0.0f);
-        chunksRenderer->drawShadowsPass(shadowCamera, shader, camera);
+    frameGraph.addPass("skybox", {}, {"skybox"}, [&]() {
+        skybox->refresh(
+            pctx, daytime, mie, weather.skyTint(), highlight, 4
+        );
     });
-    {
-        DrawContext wctx = pctx.sub();
+    frameGraph.addPass("shadows", {}, {"shadow-map"}, [&]() {
+        shadowMapping->refresh(
+            camera,
+            pctx,
+            chunksRenderer->getMeshesRevision(),
+            [this, &camera](Camera& shadowCamera) {
+                VC_PROFILE_ZONE("WorldRenderer::shadowsPass");
+                auto& shader = assets.require<Shader>("shadows");
+                setupWorldShader(
+                    shader, shadowCamera, engine.getSettings(), 0.0f
+                );
+                chunksRenderer->drawShadowsPass(shadowCamera, shader, camera);
+            }
+        );
+    }, shadowMapping->isEnabled());
+    frameGraph.addPass("opaque", {"skybox", "shadow-map"}, {"scene"}, [&]() {
+        DrawContext wctx = sctx.sub();
         postProcessing.use(wctx, gbufferPipeline);
 
         display::clearDepth();
@@ -378,18 +428,17 @@ void WorldRenderer::renderFrame(
             ctx.setCullFace(true);
             renderOpaque(ctx, camera, settings, hudVisible);
         }
-        texts->render(pctx, camera, settings, hudVisible, true);
-    }
-    skybox->bind();
-    float fogFactor =
-        15.0f / static_cast<float>(settings.chunks.loadDistance.get() - 2);
-    if (gbufferPipeline) {
+        texts->render(sctx, camera, settings, hudVisible, true);
+    });
+    frameGraph.addPass("deferred", {"scene", "skybox"}, {"scene"}, [&]() {
+        VC_PROFILE_ZONE("WorldRenderer::deferredShading");
+        skybox->bind();
         deferredShader.use();
         setupWorldShader(deferredShader, camera, settings, fogFactor);
-        postProcessing.renderDeferredShading(pctx, assets, timer, camera);
-    }
-    {
-        DrawContext ctx = pctx.sub();
+        postProcessing.renderDeferredShading(sctx, assets, timer, camera);
+    }, gbufferPipeline);
+    frameGraph.addPass("translucent", {"scene", "skybox"}, {"scene"}, [&]() {
+        DrawContext ctx = sctx.sub();
         ctx.setDepthTest(true);
 
         if (gbufferPipeline) {
@@ -399,7 +448,7 @@ void WorldRenderer::renderFrame(
         }
 
         // Background sky plane
-        skybox->draw(ctx, camera, assets, worldInfo.daytime, clouds);
+        skybox->draw(ctx, camera, assets, daytime, clouds);
 
         auto& linesShader = assets.require<Shader>("lines");
         linesShader.use();
@@ -414,6 +463,7 @@ void WorldRenderer::renderFrame(
         skybox->bind();
         // Translucent blocks
         {
+            VC_PROFILE_ZONE("WorldRenderer::translucentPass");
             auto sctx = ctx.sub();
             sctx.setCullFace(true);
             translucentShader.use();
@@ -440,10 +490,12 @@ void WorldRenderer::renderFrame(
         skybox->unbind();
 
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    }
-    postProcessing.render(pctx, assets, timer, camera);
-    
-    if (player.currentCamera == player.fpCamera) {
+    });
+    frameGraph.addPass("post-processing", {"scene"}, {"screen"}, [&]() {
+        VC_PROFILE_ZONE("WorldRenderer::postProcessing");
+        postProcessing.render(pctx, assets, timer, camera);
+    });
+    frameGraph.addPass("hands", {"screen", "skybox"}, {"screen"}, [&]() {
         DrawContext ctx = pctx.sub();
         ctx.setDepthTest(true);
         ctx.setCullFace(true);
@@ -463,8 +515,19 @@ void WorldRenderer::renderFrame(
         modelBatch->render();
         modelBatch->setLightsOffset(glm::vec3());
         skybox->unbind();
-    }
-    renderBlockOverlay(pctx);
+    }, player.currentCamera == player.fpCamera);
+    frameGraph.addPass("block-overlay", {"screen"}, {"screen"}, [&]() {
+        renderBlockOverlay(pctx);
+    });
+    frameGraph.addOutput("screen");
+
+    frameGraph.setTimingsEnabled(debug::profiler::is_enabled());
+    // chunks are not modified while the frame is drawn, so meshing workers
+    // gather voxels meanwhile
+    chunksRenderer->beginChunksAccess();
+    frameGraph.execute();
+    chunksRenderer->endChunksAccess();
+    gpuPassTimings = frameGraph.getTimings();
 
     glActiveTexture(GL_TEXTURE0);
 }
@@ -473,9 +536,9 @@ void WorldRenderer::renderBlockOverlay(const DrawContext& wctx) {
     int x = std::floor(player.currentCamera->position.x);
     int y = std::floor(player.currentCamera->position.y);
     int z = std::floor(player.currentCamera->position.z);
-    auto block = player.chunks->get(x, y, z);
+    auto block = player.chunks->getVoxel(x, y, z);
 
-    if (block == nullptr || block->id == BLOCK_AIR || block->id == BLOCK_VOID) {
+    if (!block || block->id == BLOCK_AIR || block->id == BLOCK_VOID) {
         return;
     }
     const auto& def = level.content.getIndices()->blocks.require(block->id);
@@ -530,3 +593,7 @@ void WorldRenderer::toggleLightsDebug() {
 Weather& WorldRenderer::getWeather() {
     return weather;
 }
+
+const ChunksRenderer& WorldRenderer::getChunksRenderer() const {
+    return *chunksRenderer;
+}
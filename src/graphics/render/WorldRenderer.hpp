@@ -1,6 +1,8 @@
 #pragma once
 
 #include "commons.hpp"
+#include "DynamicResolution.hpp"
+#include "FrameGraph.hpp"
 #include "typedefs.hpp"
 
 #include "presets/WeatherPreset.hpp"
@@ -65,6 +67,11 @@ class WorldRenderer {
     bool debug = false;
     bool lightsDebug = false;
     bool gbufferPipeline = false;
+    /// @brief Video memory pressure level the blocks atlas LOD bias is
+    /// set for
+    int atlasVideoPressure = 0;
+    DynamicResolution dynamicResolution;
+    FrameGraph frameGraph;
 
     CompileTimeShaderSettings prevCTShaderSettings {};
 
@@ -107,12 +114,20 @@ public:
 
     static bool showChunkBorders;
     static bool showEntitiesDebug;
+    /// @brief GPU time of the world render passes of the last frame
+    /// (measured while profiler is enabled)
+    static std::vector<FrameGraph::PassTiming> gpuPassTimings;
 
     WorldRenderer(Engine& engine, LevelFrontend& frontend, Player& player);
     ~WorldRenderer();
 
     void update(const Camera& camera, float delta);
 
+    /// @brief Adapt world rendering resolution to the target framerate
+    /// (graphics.dynamic-resolution setting)
+    /// @param delta last frame time (seconds)
+    void updateResolutionScale(float delta);
+
     void renderFrame(
         const DrawContext& context, 
         Camera& camera, 
@@ -127,4 +142,6 @@ public:
     void toggleLightsDebug();
 
     Weather& getWeather();
+
+    const ChunksRenderer& getChunksRenderer() const;
 };
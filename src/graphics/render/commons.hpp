@@ -1,6 +1,7 @@
 #pragma once
 
 #include "constants.hpp"
+#include "SectionsVisibility.hpp"
 #include "graphics/core/MeshData.hpp"
 #include "maths/aabb.hpp"
 #include "util/Buffer.hpp"
@@ -8,8 +9,8 @@
 #include <vector>
 #include <array>
 #include <memory>
-#include <glm/vec2.hpp>
-#include <glm/vec3.hpp>
+#include <cstdint>
+#include <glm/glm.hpp>
 
 /// @brief Chunk mesh vertex format
 struct ChunkVertex {
@@ -17,22 +18,98 @@ struct ChunkVertex {
     glm::vec2 uv;
     std::array<uint8_t, 4> color;
     std::array<uint8_t, 4> normal;
+    /// @brief Atlas region (u1, v1, u2, v2) repeated over the face using
+    /// uv as tile coordinates. Zero if uv is used as is (greedy meshing)
+    std::array<uint16_t, 4> region;
 
     static constexpr VertexAttribute ATTRIBUTES[] = {
         {VertexAttribute::Type::FLOAT, false, 3},
         {VertexAttribute::Type::FLOAT, false, 2},
         {VertexAttribute::Type::UNSIGNED_BYTE, true, 4},
         {VertexAttribute::Type::UNSIGNED_BYTE, true, 4},
+        {VertexAttribute::Type::UNSIGNED_SHORT, true, 4},
+        {{}, 0}};
+};
+
+/// @brief Compact chunk mesh vertex format used by the meshes arena
+/// (decoded in res/shaders/lib/chunk_vertex.glsl).
+/// Chunk-local position is stored in fixed point relative to the chunk
+/// center, uv is normalized (greedy faces tile coordinates are divided
+/// by MAX_TILES)
+struct PackedChunkVertex {
+    static constexpr float POSITION_SCALE = 128.0f;
+    static constexpr int ORIGIN_X = CHUNK_W / 2;
+    static constexpr int ORIGIN_Y = CHUNK_H / 2;
+    static constexpr int ORIGIN_Z = CHUNK_D / 2;
+    /// @brief Max greedy face size in blocks
+    static constexpr float MAX_TILES = 16.0f;
+
+    /// @brief x, y, z and padding keeping attributes 4-bytes aligned
+    std::array<int16_t, 4> position;
+    std::array<uint16_t, 2> uv;
+    std::array<uint8_t, 4> color;
+    std::array<uint8_t, 4> normal;
+    std::array<uint16_t, 4> region;
+
+    static constexpr VertexAttribute ATTRIBUTES[] = {
+        {VertexAttribute::Type::SHORT, false, 4},
+        {VertexAttribute::Type::UNSIGNED_SHORT, true, 2},
+        {VertexAttribute::Type::UNSIGNED_BYTE, true, 4},
+        {VertexAttribute::Type::UNSIGNED_BYTE, true, 4},
+        {VertexAttribute::Type::UNSIGNED_SHORT, true, 4},
+        {{}, 0}};
+
+    static PackedChunkVertex pack(const ChunkVertex& vertex) {
+        const glm::vec3 origin(ORIGIN_X, ORIGIN_Y, ORIGIN_Z);
+        auto pos = glm::round((vertex.position - origin) * POSITION_SCALE);
+        pos = glm::clamp(pos, glm::vec3(INT16_MIN), glm::vec3(INT16_MAX));
+
+        bool tiled = vertex.region[0] != vertex.region[2];
+        auto uv = vertex.uv / (tiled ? MAX_TILES : 1.0f);
+        uv = glm::round(glm::clamp(uv, 0.0f, 1.0f) * 65535.0f);
+        return PackedChunkVertex {
+            {
+                static_cast<int16_t>(pos.x),
+                static_cast<int16_t>(pos.y),
+                static_cast<int16_t>(pos.z),
+                0,
+            },
+            {static_cast<uint16_t>(uv.x), static_cast<uint16_t>(uv.y)},
+            vertex.color,
+            vertex.normal,
+            vertex.region};
+    }
+};
+
+static_assert(sizeof(PackedChunkVertex) == 28);
+static_assert(
+    CHUNK_W <= PackedChunkVertex::MAX_TILES &&
+    CHUNK_D <= PackedChunkVertex::MAX_TILES &&
+    CHUNK_SECTION_H <= PackedChunkVertex::MAX_TILES,
+    "greedy faces do not fit into packed uv"
+);
+
+/// @brief Per-draw attributes of chunk meshes drawn from MeshArena
+struct ChunkInstance {
+    /// @brief Chunk mesh position in world
+    glm::vec3 offset;
+
+    static constexpr VertexAttribute ATTRIBUTES[] = {
+        {VertexAttribute::Type::FLOAT, false, 3},
         {{}, 0}};
 };
 
 template<typename VertexStructure>
 class Mesh;
 
+struct ArenaMesh;
+
 struct SortingMeshEntry {
     glm::vec3 position;
     util::Buffer<ChunkVertex> vertexData;
     long long distance;
+    /// @brief First vertex of the entry in the chunk sorted mesh
+    uint32_t vertexOffset = 0;
 
     inline bool operator<(const SortingMeshEntry &o) const noexcept {
         return distance > o.distance;
@@ -44,16 +121,33 @@ struct SortingMeshData {
 };
 
 struct ChunkMeshData {
-    MeshData<ChunkVertex> mesh;
+    MeshData<PackedChunkVertex> mesh;
     SortingMeshData sortingMesh;
     AABB meshAABB;
+    SectionConnectivity connectivity;
+    /// @brief Chunk voxel indices of the section blocks having particles
+    std::vector<uint32_t> emitters;
 };
 
 struct ChunkMesh {
-    std::unique_ptr<Mesh<ChunkVertex>> mesh;
+    /// @brief Opaque mesh sections locations in the chunks arena
+    /// (nullptr if section mesh is empty)
+    std::array<std::shared_ptr<ArenaMesh>, CHUNK_SECTIONS> sections;
+    std::array<AABB, CHUNK_SECTIONS> sectionsAABB;
+    sections_connectivity sectionsConnectivity;
+    /// @brief Level of detail the sections are built with
+    int lod = 0;
+    /// @brief Translucent meshes of all sections
     SortingMeshData sortingMeshData;
+    /// @brief Translucent entries vertices drawn in order of the index
+    /// buffer rewritten on sort
     std::unique_ptr<Mesh<ChunkVertex> > sortedMesh;
+    /// @brief Camera block position the entries were sorted for
+    glm::ivec3 sortedCameraBlock {};
+    /// @brief Union of sections bounding boxes
     AABB meshAABB;
+    /// @brief Chunk voxel indices of blocks having particles by section
+    std::array<std::vector<uint32_t>, CHUNK_SECTIONS> sectionsEmitters;
 };
 
 inline constexpr int VOXELS_BUFFER_PADDING = 2;
@@ -133,9 +133,23 @@ void Container::draw(const DrawContext& pctx, const Assets& assets) {
         batch->flush();
         DrawContext ctx = pctx.sub();
         ctx.setScissors(glm::vec4(pos.x, pos.y, glm::ceil(size.x), glm::ceil(size.y)));
+        glm::vec2 contentPos = pos + getContentOffset();
         for (const auto& node : nodes) {
-            if (node->isVisible())
-                node->draw(pctx, assets);
+            if (!node->isVisible()) {
+                continue;
+            }
+            // nodes scrolled out of the container are clipped entirely
+            if (scrollable) {
+                glm::vec2 nodePos = glm::ivec2(contentPos + node->getPos());
+                glm::vec2 nodeSize = node->getSize();
+                if (nodePos.y + nodeSize.y < pos.y ||
+                    nodePos.y > pos.y + size.y ||
+                    nodePos.x + nodeSize.x < pos.x ||
+                    nodePos.x > pos.x + size.x) {
+                    continue;
+                }
+            }
+            node->draw(pctx, assets);
         }
 
         int diff = (actualLength-size.y);
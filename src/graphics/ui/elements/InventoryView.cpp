@@ -1,5 +1,6 @@
 #include "InventoryView.hpp"
 
+#include <cmath>
 #include <glm/glm.hpp>
 #include <utility>
 
@@ -462,6 +463,10 @@ void SlotView::bind(
     this->content = content;
 }
 
+void SlotView::setSlotIndex(int index) {
+    layout.index = index;
+}
+
 const SlotLayout& SlotView::getLayout() const {
     return layout;
 }
@@ -507,12 +512,98 @@ std::shared_ptr<SlotView> InventoryView::addSlot(const SlotLayout& layout) {
     return slot;
 }
 
+void InventoryView::addVirtualGrid(
+    const SlotLayout& layout, int count, int cols, int rows, int interval
+) {
+    const int step = SLOT_SIZE + interval;
+    auto vsize = getSize();
+    glm::vec2 end = layout.position +
+                    glm::vec2(layout.padding * 2 + SLOT_SIZE) +
+                    glm::vec2(cols - 1, rows - 1) * static_cast<float>(step);
+    setSize(glm::max(vsize, end));
+    grids.push_back(VirtualGrid {layout, count, cols, rows, interval, {}});
+}
+
+void InventoryView::updateGrid(VirtualGrid& grid) {
+    const int step = SLOT_SIZE + grid.interval;
+    const int padding = grid.layout.padding;
+
+    // visible part of the view is limited by the ancestors (scrolled panels)
+    glm::vec2 pos = calcPos();
+    float top = pos.y;
+    float bottom = pos.y + getSize().y;
+    for (auto node = getParent(); node; node = node->getParent()) {
+        float y = node->calcPos().y;
+        top = glm::max(top, y);
+        bottom = glm::min(bottom, y + node->getSize().y);
+    }
+    float gridY = pos.y + grid.layout.position.y + padding;
+    int firstRow = glm::clamp(
+        static_cast<int>(std::floor((top - gridY) / step)), 0, grid.rows
+    );
+    int endRow = glm::clamp(
+        static_cast<int>(std::ceil((bottom - gridY) / step)), firstRow, grid.rows
+    );
+    if (firstRow == grid.firstRow && endRow == grid.endRow) {
+        return;
+    }
+    grid.firstRow = firstRow;
+    grid.endRow = endRow;
+
+    size_t required = (endRow - firstRow) * grid.cols;
+    while (grid.pool.size() < required) {
+        auto slot = std::make_shared<SlotView>(gui, grid.layout);
+        if (!grid.layout.background) {
+            slot->setColor(glm::vec4());
+        }
+        add(slot);
+        grid.pool.push_back(std::move(slot));
+    }
+    size_t used = 0;
+    for (int row = firstRow; row < endRow; row++) {
+        for (int col = 0; col < grid.cols; col++) {
+            // slots are placed from the bottom row
+            int idx = (grid.rows - row - 1) * grid.cols + col;
+            if (idx >= grid.count) {
+                continue;
+            }
+            int index = grid.layout.index + idx;
+            auto& slot = *grid.pool[used++];
+            slot.setSlotIndex(index);
+            slot.bind(
+                inventory->getId(), inventory->getSlot(index), index, content
+            );
+            slot.setPos(
+                grid.layout.position +
+                glm::vec2(padding + col * step, padding + row * step)
+            );
+            slot.setVisible(true);
+        }
+    }
+    for (size_t i = used; i < grid.pool.size(); i++) {
+        grid.pool[i]->setVisible(false);
+    }
+}
+
+void InventoryView::act(float delta) {
+    if (inventory) {
+        for (auto& grid : grids) {
+            updateGrid(grid);
+        }
+    }
+    Container::act(delta);
+}
+
 std::shared_ptr<Inventory> InventoryView::getInventory() const {
     return inventory;
 }
 
 size_t InventoryView::getSlotsCount() const {
-    return slots.size();
+    size_t count = slots.size();
+    for (const auto& grid : grids) {
+        count += grid.count;
+    }
+    return count;
 }
 
 void InventoryView::bind(
@@ -529,6 +620,10 @@ void InventoryView::bind(
             content
         );
     }
+    // virtual grids views are bound on the next act
+    for (auto& grid : grids) {
+        grid.firstRow = grid.endRow = -1;
+    }
 }
 
 void InventoryView::unbind() {
@@ -7,6 +7,7 @@
 #include "items/ItemStack.hpp"
 
 #include <vector>
+#include <memory>
 #include <functional>
 #include <glm/glm.hpp>
 
@@ -105,6 +106,9 @@ namespace gui {
             const Content* content
         );
 
+        /// @brief Set slot index used by the layout (for reused views)
+        void setSlotIndex(int index);
+
         ItemStack& getStack();
         const SlotLayout& getLayout() const;
         int64_t getInventoryId() const;
@@ -120,6 +124,25 @@ namespace gui {
 
         std::vector<SlotView*> slots;
         glm::vec2 origin {};
+
+        /// @brief Slots grid having views for the visible rows only.
+        /// Views of rows scrolled out are reused for rows scrolled in
+        struct VirtualGrid {
+            /// @brief Index is the first slot index, position is the grid
+            /// position, padding is the grid padding
+            SlotLayout layout;
+            int count;
+            int cols;
+            int rows;
+            int interval;
+            std::vector<std::shared_ptr<SlotView>> pool;
+            /// @brief Materialized rows range (counted from the top)
+            int firstRow = -1;
+            int endRow = -1;
+        };
+        std::vector<VirtualGrid> grids;
+
+        void updateGrid(VirtualGrid& grid);
     public:
         InventoryView(GUI& gui);
         virtual ~InventoryView();
@@ -140,12 +163,24 @@ namespace gui {
 
         std::shared_ptr<SlotView> addSlot(const SlotLayout& layout);
 
+        /// @brief Add slots grid creating slot views for visible rows only
+        /// @param layout slot settings, index is the first slot index,
+        /// position is the grid position, padding is the grid padding
+        void addVirtualGrid(
+            const SlotLayout& layout, int count, int cols, int rows, int interval
+        );
+
+        void act(float delta) override;
+
         std::shared_ptr<Inventory> getInventory() const;
 
         size_t getSlotsCount() const;
 
         static const int SLOT_INTERVAL = 4;
         static const int SLOT_SIZE = ITEM_ICON_SIZE;
+        /// @brief Slots grids with at least this number of slots are
+        /// virtual by default
+        static const int VIRTUAL_GRID_MIN_SLOTS = 256;
     };
 
     class InventoryBuilder {
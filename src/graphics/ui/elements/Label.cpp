@@ -255,10 +255,19 @@ void Label::draw(const DrawContext& pctx, const Assets& assets) {
         bounds.w = std::min(bounds.w, ppos.y + psize.y);
     }
     if (multiline) {
-        // todo: reduce loop range to the actual area
-        for (size_t i = 0; i < cache.lines.size(); i++) {
+        size_t firstLine = 0;
+        if (totalLineHeight > 0 && bounds.y > pos.y) {
+            firstLine = static_cast<size_t>(
+                (bounds.y - pos.y) / static_cast<float>(totalLineHeight)
+            );
+            firstLine -= std::min<size_t>(firstLine, 1);
+        }
+        for (size_t i = firstLine; i < cache.lines.size(); i++) {
             float y = pos.y + i * totalLineHeight;
-            if (y + totalLineHeight < bounds.y || y > bounds.w) {
+            if (y > bounds.w) {
+                break;
+            }
+            if (y + totalLineHeight < bounds.y) {
                 continue;
             }
             auto& line = cache.lines[i];
@@ -391,7 +391,10 @@ void TextBox::refreshLabel() {
         rawTextCache.metrics,
         static_cast<size_t>(getSize().x)
     );
-    rawTextCache.update(input, multiline, false);
+    if (rawTextCache.resetFlag || rawText != input) {
+        rawText = input;
+        rawTextCache.update(input, multiline, false);
+    }
 
     label->setColor(textColor * glm::vec4(input.empty() ? 0.5f : 1.0f));
 
@@ -568,6 +571,7 @@ bool TextBox::isValid() const {
 
 void TextBox::setMultiline(bool multiline) {
     this->multiline = multiline;
+    rawTextCache.resetFlag = true;
     label->setMultiline(multiline);
     label->setVerticalAlign(multiline ? Align::TOP : Align::CENTER);
 }
@@ -921,8 +925,12 @@ void TextBox::refreshSyntax() {
     if (!syntax.empty()) {
         const auto& processor = gui.getEditor().getSyntaxProcessor();
         auto scheme = gui.getSyntaxColorScheme();
-        if (auto styles =
-                processor.highlight(scheme ? *scheme : FontStylesScheme {}, syntax, input)) {
+        if (auto styles = processor.highlight(
+                scheme ? *scheme : FontStylesScheme {},
+                syntax,
+                input,
+                highlightCache
+            )) {
             label->setStyles(std::move(styles));
         }
     }
@@ -1271,6 +1279,7 @@ bool TextBox::isShowLineNumbers() const {
 
 void TextBox::setSyntax(std::string_view lang) {
     syntax = lang;
+    highlightCache = {};
     if (syntax.empty()) {
         label->setStyles(nullptr);
     } else {
@@ -2,6 +2,7 @@
 
 #include "Panel.hpp"
 #include "Label.hpp"
+#include "devtools/SyntaxProcessor.hpp"
 
 class Font;
 class ActionsHistory;
@@ -11,6 +12,10 @@ namespace gui {
     class TextBox : public Container {
         const Input& inputEvents;
         LabelCache rawTextCache;
+        /// @brief Input the rawTextCache was updated with
+        std::wstring rawText;
+        /// @brief Previous highlighting results reused on input change
+        devtools::HighlightCache highlightCache;
         std::shared_ptr<ActionsHistory> history;
         std::unique_ptr<TextBoxHistorian> historian;
         int editedHistorySize = 0;
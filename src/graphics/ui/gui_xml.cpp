@@ -1,6 +1,7 @@
 #define VC_ENABLE_REFLECTION
 #include "gui_xml.hpp"
 
+#include <mutex>
 #include <stdexcept>
 #include <utility>
 
@@ -829,6 +830,16 @@ static void read_slots_grid(
     layout.taking = taking;
     layout.placing = placing;
 
+    bool virtualGrid = element.attr(
+        "virtual",
+        count >= InventoryView::VIRTUAL_GRID_MIN_SLOTS ? "true" : "false"
+    ).asBool();
+    if (virtualGrid) {
+        layout.index = startIndex;
+        view->addVirtualGrid(layout, count, cols, rows, interval);
+        return;
+    }
+
     int idx = 0;
     for (int row = 0; row < rows; row++) {
         for (int col = 0; col < cols; col++, idx++) {
@@ -953,11 +964,38 @@ std::shared_ptr<UINode> UiXmlReader::readUINode(const xml::xmlelement& element
     return node;
 }
 
+/// @brief Max number of cached parsed sources (cache is cleared when
+/// exceeded, as sources may be generated by scripts)
+inline constexpr size_t XML_CACHE_MAX_ENTRIES = 512;
+
+std::shared_ptr<const xml::Document> gui::parse_xml_cached(
+    const std::string& filename, const std::string& source
+) {
+    static std::unordered_map<std::string, std::shared_ptr<xml::Document>>
+        cache;
+    static std::mutex mutex;
+    {
+        std::lock_guard lock(mutex);
+        auto found = cache.find(source);
+        if (found != cache.end()) {
+            return found->second;
+        }
+    }
+    std::shared_ptr<xml::Document> document = xml::parse(filename, source);
+
+    std::lock_guard lock(mutex);
+    if (cache.size() >= XML_CACHE_MAX_ENTRIES) {
+        cache.clear();
+    }
+    cache[source] = document;
+    return document;
+}
+
 std::shared_ptr<UINode> UiXmlReader::readXML(
     const std::string& filename, const std::string& source
 ) {
     this->filename = filename;
-    auto document = xml::parse(filename, source);
+    auto document = parse_xml_cached(filename, source);
     return readUINode(*document->getRoot());
 }
 
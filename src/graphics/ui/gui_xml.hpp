@@ -14,6 +14,15 @@ namespace gui {
     using uinode_reader = std::function<
         std::shared_ptr<UINode>(UiXmlReader&, const xml::xmlelement&)>;
 
+    /// @brief Parse XML or get previously parsed document of the same
+    /// source. Documents are read-only for UI readers, so reopened layouts
+    /// are built from the cached DOM without parsing
+    /// @param filename source file name used in parsing errors
+    /// @param source XML source text
+    std::shared_ptr<const xml::Document> parse_xml_cached(
+        const std::string& filename, const std::string& source
+    );
+
     class UiXmlReader {
         gui::GUI& gui;
         std::unordered_map<std::string, uinode_reader> readers;
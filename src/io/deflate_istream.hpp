@@ -9,14 +9,16 @@
 
 class deflate_istreambuf : public std::streambuf {
 public:
-    explicit deflate_istreambuf(std::istream& src) : src(src) {
+    /// @param gzip expect GZIP header and trailer instead of raw deflate
+    explicit deflate_istreambuf(std::istream& src, bool gzip = false)
+        : src(src) {
         zstream.zalloc = Z_NULL;
         zstream.zfree = Z_NULL;
         zstream.opaque = Z_NULL;
         zstream.avail_in = 0;
         zstream.next_in = Z_NULL;
         
-        int ret = inflateInit2(&zstream, -15);
+        int ret = inflateInit2(&zstream, gzip ? 16 + MAX_WBITS : -MAX_WBITS);
         if (ret != Z_OK) {
             throw std::runtime_error("zlib init failed");
         }
@@ -90,8 +92,8 @@ private:
 
 class deflate_istream : public std::istream {
 public:
-    explicit deflate_istream(std::unique_ptr<std::istream> src)
-        : std::istream(&buffer), source(std::move(src)), buffer(*source) {}
+    explicit deflate_istream(std::unique_ptr<std::istream> src, bool gzip = false)
+        : std::istream(&buffer), source(std::move(src)), buffer(*source, gzip) {}
 
 private:
     std::unique_ptr<std::istream> source;
@@ -7,13 +7,21 @@
 
 class deflate_ostreambuf : public std::streambuf {
 public:
-    deflate_ostreambuf(std::ostream& dest, int level = Z_DEFAULT_COMPRESSION)
+    /// @param gzip write GZIP header and trailer instead of raw deflate
+    deflate_ostreambuf(
+        std::ostream& dest, int level = Z_DEFAULT_COMPRESSION, bool gzip = false
+    )
         : dest(dest) {
         zstream.zalloc = Z_NULL;
         zstream.zfree = Z_NULL;
         zstream.opaque = Z_NULL;
         int ret = deflateInit2(
-            &zstream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY
+            &zstream,
+            level,
+            Z_DEFLATED,
+            gzip ? 16 + MAX_WBITS : -MAX_WBITS,
+            8,
+            Z_DEFAULT_STRATEGY
         );
         if (ret != Z_OK) {
             throw std::runtime_error("zlib deflate initialization failed");
@@ -112,8 +120,10 @@ private:
 
 class deflate_ostream : public std::ostream {
 public:
-    explicit deflate_ostream(std::ostream& dest, int level = Z_DEFAULT_COMPRESSION)
-        : std::ostream(&buffer), buffer(dest, level) {}
+    explicit deflate_ostream(
+        std::ostream& dest, int level = Z_DEFAULT_COMPRESSION, bool gzip = false
+    )
+        : std::ostream(&buffer), buffer(dest, level, gzip) {}
 
 private:
     deflate_ostreambuf buffer;
@@ -6,6 +6,7 @@
 #include <filesystem>
 
 #include "../path.hpp"
+#include "../mapped_file.hpp"
 
 namespace io {
     /// @brief Device interface for file system operations
@@ -57,6 +58,13 @@ namespace io {
 
         /// @brief List directory contents
         virtual std::unique_ptr<PathsGenerator> list(std::string_view path) = 0;
+
+        /// @brief Map file to memory for reading
+        /// @throw std::runtime_error if file cannot be mapped
+        /// @return nullptr if the device does not support mapping
+        virtual std::unique_ptr<mapped_file> map(std::string_view path) {
+            return nullptr;
+        }
     };
 
     /// @brief Subdevice is a wrapper around another device limited to a directory
@@ -119,6 +127,10 @@ namespace io {
         std::unique_ptr<PathsGenerator> list(std::string_view path) override {
             return parent->list((root / path).pathPart());
         }
+
+        std::unique_ptr<mapped_file> map(std::string_view path) override {
+            return parent->map((root / path).pathPart());
+        }
     private:
         std::shared_ptr<Device> parent;
         path root;
@@ -44,6 +44,10 @@ std::unique_ptr<std::istream> StdfsDevice::read(std::string_view path) {
     return input;
 }
 
+std::unique_ptr<mapped_file> StdfsDevice::map(std::string_view path) {
+    return std::make_unique<mapped_file>(resolve(path));
+}
+
 size_t StdfsDevice::size(std::string_view path) {
     return fs::file_size(resolve(path));
 }
@@ -21,6 +21,7 @@ namespace io {
         bool remove(std::string_view path) override;
         uint64_t removeAll(std::string_view path) override;
         std::unique_ptr<PathsGenerator> list(std::string_view path) override;
+        std::unique_ptr<mapped_file> map(std::string_view path) override;
     private:
         std::filesystem::path root;
     };
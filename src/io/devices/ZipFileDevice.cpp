@@ -1,6 +1,7 @@
 #include "ZipFileDevice.hpp"
 
 #include <vector>
+#include <zlib.h>
 
 #include "debug/Logger.hpp"
 #include "io/memory_istream.hpp"
@@ -20,6 +21,9 @@ static constexpr uint32_t CENTRAL_DIR_SIGNATURE = 0x02014b50;
 static constexpr uint32_t LOCAL_FILE_SIGNATURE = 0x04034b50;
 static constexpr uint32_t COMPRESSION_NONE = 0;
 static constexpr uint32_t COMPRESSION_DEFLATE = 8;
+/// @brief Entries larger than that are not cached
+static constexpr size_t CACHE_MAX_ENTRY_SIZE = 256 * 1024;
+static constexpr size_t CACHE_SIZE = 16 * 1024 * 1024;
 
 namespace {
     template<typename T>
@@ -57,6 +61,25 @@ namespace {
         return file_time_type::clock::now() + (time_point - system_clock::now());
     }
 
+    /// @brief Stream reading shared cached entry data
+    class cached_entry_istream : public std::istream {
+    public:
+        explicit cached_entry_istream(
+            std::shared_ptr<const util::Buffer<char>> data
+        )
+            : std::istream(nullptr), data(std::move(data)), buf(*this->data) {
+            rdbuf(&buf);
+        }
+    private:
+        std::shared_ptr<const util::Buffer<char>> data;
+        memory_view_streambuf buf;
+    };
+
+    std::string parent_of(const std::string& name) {
+        size_t pos = name.rfind('/');
+        return pos == std::string::npos ? "" : name.substr(0, pos);
+    }
+
     uint32_t to_ms_dos_timestamp(const file_time_type& fileTime) {
         auto timePoint = time_point_cast<system_clock::duration>(
             fileTime - file_time_type::clock::now() + system_clock::now()
@@ -173,23 +196,29 @@ ZipFileDevice::ZipFileDevice(
         entries[entry.fileName] = std::move(entry);
     }
 
-    for (auto& [name, _] : entries) {
-        io::path path = name;
-
-        while (!(path = path.parent()).pathPart().empty()) {
-            if (entries.find(path.pathPart()) != entries.end()) {
-                continue;
-            }
+    // adding directories missing in the archive
+    std::vector<std::string> names;
+    names.reserve(entries.size());
+    for (const auto& [name, _] : entries) {
+        names.push_back(name);
+    }
+    for (const auto& name : names) {
+        std::string path = parent_of(name);
+        while (!path.empty() && entries.find(path) == entries.end()) {
             Entry entry {};
             entry.isDirectory = true;
-            entries[path.pathPart()] = entry;
+            entries[path] = entry;
+            path = parent_of(path);
         }
-        break;
     }
 
-    for (auto& [_, entry] : entries) {
-        findBlob(entry);
+    for (const auto& [name, _] : entries) {
+        auto parent = parent_of(name);
+        directories[parent].push_back(
+            parent.empty() ? name : name.substr(parent.length() + 1)
+        );
     }
+    // blob offsets are found on first read
 }
 
 std::filesystem::path ZipFileDevice::resolve(std::string_view path) {
@@ -200,40 +229,139 @@ std::unique_ptr<std::ostream> ZipFileDevice::write(std::string_view path) {
     return nullptr;
 }
 
-std::unique_ptr<std::istream> ZipFileDevice::read(std::string_view path) {
-    const auto& found = entries.find(std::string(path));
-    if (found == entries.end()) {
-        throw std::runtime_error("could not to open file zip://" + std::string(path));
-    }
-    auto& entry = found->second;
-    if (entry.isDirectory) {
-        throw std::runtime_error("zip://" + std::string(path) + " is directory");
-    }
+util::Buffer<char> ZipFileDevice::readBlob(Entry& entry) {
+    util::Buffer<char> buffer(entry.compressedSize);
+    std::unique_lock lock(fileMutex);
     if (entry.blobOffset == 0) {
         findBlob(entry);
     }
+    if (separateFunc) {
+        // Separate istream is used for concurrent data reading
+        size_t offset = entry.blobOffset;
+        lock.unlock();
+        auto stream = separateFunc();
+        stream->seekg(offset);
+        stream->read(buffer.data(), buffer.size());
+    } else {
+        file->seekg(entry.blobOffset);
+        file->read(buffer.data(), buffer.size());
+    }
+    return buffer;
+}
+
+std::unique_ptr<std::istream> ZipFileDevice::openEntry(Entry& entry) {
     std::unique_ptr<std::istream> src_stream;
     if (separateFunc) {
+        size_t offset;
+        {
+            std::lock_guard lock(fileMutex);
+            if (entry.blobOffset == 0) {
+                findBlob(entry);
+            }
+            offset = entry.blobOffset;
+        }
         // Create new istream for concurrent data reading
         src_stream = separateFunc();
-        src_stream->seekg(entry.blobOffset);
+        src_stream->seekg(offset);
     } else {
         // Read compressed data to memory if istream cannot be separated
-        file->seekg(entry.blobOffset);
-        util::Buffer<char> buffer(entry.compressedSize);
-        file->read(buffer.data(), buffer.size());
-        src_stream = std::make_unique<memory_istream>(std::move(buffer));
+        src_stream = std::make_unique<memory_istream>(readBlob(entry));
     }
     if (entry.compressionMethod == COMPRESSION_NONE) {
         return src_stream;
-    } else if (entry.compressionMethod == COMPRESSION_DEFLATE) {
-        return std::make_unique<deflate_istream>(std::move(src_stream));
-    } else {
+    }
+    return std::make_unique<deflate_istream>(std::move(src_stream));
+}
+
+static util::Buffer<char> inflate_blob(
+    const util::Buffer<char>& src, size_t size
+) {
+    util::Buffer<char> dst(size);
+    z_stream zstream {};
+    if (inflateInit2(&zstream, -MAX_WBITS) != Z_OK) {
+        throw std::runtime_error("zlib init failed");
+    }
+    zstream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(src.data()));
+    zstream.avail_in = static_cast<uInt>(src.size());
+    zstream.next_out = reinterpret_cast<Bytef*>(dst.data());
+    zstream.avail_out = static_cast<uInt>(size);
+    int ret = inflate(&zstream, Z_FINISH);
+    inflateEnd(&zstream);
+    if (ret != Z_STREAM_END || zstream.total_out != size) {
+        throw std::runtime_error("corrupted zip entry data");
+    }
+    return dst;
+}
+
+std::shared_ptr<const util::Buffer<char>> ZipFileDevice::getCached(
+    const std::string& name
+) {
+    std::lock_guard lock(cacheMutex);
+    const auto& found = cache.find(name);
+    if (found == cache.end()) {
+        return nullptr;
+    }
+    auto& cached = found->second;
+    cacheOrder.splice(cacheOrder.begin(), cacheOrder, cached.position);
+    return cached.data;
+}
+
+void ZipFileDevice::addCached(
+    const std::string& name, std::shared_ptr<const util::Buffer<char>> data
+) {
+    std::lock_guard lock(cacheMutex);
+    auto [found, inserted] = cache.try_emplace(name);
+    if (!inserted) {
+        // read concurrently
+        return;
+    }
+    cacheBytes += data->size();
+    found->second.data = std::move(data);
+    found->second.position =
+        cacheOrder.insert(cacheOrder.begin(), &found->first);
+
+    while (cacheBytes > CACHE_SIZE) {
+        const auto& evicted = cache.find(*cacheOrder.back());
+        cacheBytes -= evicted->second.data->size();
+        cacheOrder.pop_back();
+        cache.erase(evicted);
+    }
+}
+
+std::unique_ptr<std::istream> ZipFileDevice::read(std::string_view path) {
+    std::string name(path);
+    const auto& found = entries.find(name);
+    if (found == entries.end()) {
+        throw std::runtime_error("could not to open file zip://" + name);
+    }
+    auto& entry = found->second;
+    if (entry.isDirectory) {
+        throw std::runtime_error("zip://" + name + " is directory");
+    }
+    if (entry.compressionMethod != COMPRESSION_NONE &&
+        entry.compressionMethod != COMPRESSION_DEFLATE) {
         throw std::runtime_error(
             "unsupported compression method [" +
             std::to_string(entry.compressionMethod) + "]"
         );
     }
+    if (entry.uncompressedSize > CACHE_MAX_ENTRY_SIZE) {
+        return openEntry(entry);
+    }
+    if (auto data = getCached(name)) {
+        return std::make_unique<cached_entry_istream>(std::move(data));
+    }
+    auto blob = readBlob(entry);
+    std::shared_ptr<const util::Buffer<char>> data;
+    if (entry.compressionMethod == COMPRESSION_NONE) {
+        data = std::make_shared<util::Buffer<char>>(std::move(blob));
+    } else {
+        data = std::make_shared<util::Buffer<char>>(
+            inflate_blob(blob, entry.uncompressedSize)
+        );
+    }
+    addCached(name, data);
+    return std::make_unique<cached_entry_istream>(std::move(data));
 }
 
 size_t ZipFileDevice::size(std::string_view path) {
@@ -309,30 +437,11 @@ private:
 };
 
 std::unique_ptr<PathsGenerator> ZipFileDevice::list(std::string_view path) {
-    std::vector<std::string> names;
-    if (path.empty()) {
-        for (const auto& [name, entry] : entries) {
-            if (name.find('/') == std::string::npos) {
-                names.push_back(name);
-            }
-        }
-    } else {
-        auto folder = std::string(path) + "/";
-        size_t folder_len = folder.length();
-        for (const auto& [name, entry] : entries) {
-            if (name.find(folder) != 0) {
-                continue;
-            }
-            size_t pos = name.find('/', folder_len);
-            if (pos == std::string::npos) {
-                names.push_back(name.substr(folder_len, pos - folder_len));
-            }
-            if (pos == name.length() - 1) {
-                names.push_back(name.substr(folder_len, pos - folder_len));
-            }
-        }
+    const auto& found = directories.find(std::string(path));
+    if (found == directories.end()) {
+        return std::make_unique<ListPathsGenerator>(std::vector<std::string>());
     }
-    return std::make_unique<ListPathsGenerator>(std::move(names));
+    return std::make_unique<ListPathsGenerator>(found->second);
 }
 
 #include "io/io.hpp"
@@ -393,6 +502,9 @@ static size_t write_zip(
     size_t entries = 0;
     for (const auto& entry : io::directory_iterator(folder)) {
         auto name = entry.pathPart().substr(root.length());
+        if (!name.empty() && name[0] == '/') {
+            name = name.substr(1);
+        }
         auto last_write_time = io::last_write_time(entry);
         if (io::is_directory(entry)) {
             name = name + "/";
@@ -1,11 +1,17 @@
 #pragma once
 
 #include <functional>
+#include <list>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "Device.hpp"
+#include "util/Buffer.hpp"
 
 namespace io {
+    /// @brief Read-only ZIP archive device. Small entries read are kept
+    /// decompressed in LRU cache
     class ZipFileDevice : public Device {
         struct Entry {
             uint16_t versionMadeBy;
@@ -22,9 +28,15 @@ namespace io {
             uint32_t externalAttributes;
             uint32_t localHeaderOffset;
             std::string fileName;
+            /// @brief Found on first read (0 - not found yet)
             size_t blobOffset = 0;
             bool isDirectory = false;
         };
+
+        struct CachedEntry {
+            std::shared_ptr<const util::Buffer<char>> data;
+            std::list<const std::string*>::iterator position;
+        };
     public:
         using FileSeparateFunc = std::function<std::unique_ptr<std::istream>()>;
 
@@ -53,9 +65,32 @@ namespace io {
         std::unique_ptr<std::istream> file;
         FileSeparateFunc separateFunc;
         std::unordered_map<std::string, Entry> entries;
+        /// @brief Directory path to names of its direct children
+        std::unordered_map<std::string, std::vector<std::string>> directories;
+        /// @brief Guards the file stream and blob offsets
+        std::mutex fileMutex;
+
+        std::mutex cacheMutex;
+        std::unordered_map<std::string, CachedEntry> cache;
+        /// @brief Cached entries names, most recently read first
+        std::list<const std::string*> cacheOrder;
+        size_t cacheBytes = 0;
 
         Entry readEntry();
         void findBlob(Entry& entry);
+
+        /// @brief Read compressed entry data
+        util::Buffer<char> readBlob(Entry& entry);
+
+        /// @brief Open stream decompressing entry data
+        std::unique_ptr<std::istream> openEntry(Entry& entry);
+
+        std::shared_ptr<const util::Buffer<char>> getCached(
+            const std::string& name
+        );
+        void addCached(
+            const std::string& name, std::shared_ptr<const util::Buffer<char>> data
+        );
     };
 
     void write_zip(const path& folder, const path& file);
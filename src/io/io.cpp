@@ -12,12 +12,18 @@
 #include "coders/gzip.hpp"
 #include "coders/json.hpp"
 #include "coders/toml.hpp"
+#include "debug/Logger.hpp"
 #include "util/stringutil.hpp"
 
 #include "devices/Device.hpp"
 
 namespace fs = std::filesystem;
 
+static debug::Logger logger("io");
+
+/// @brief Smaller files are read instead of mapping
+static constexpr size_t MAP_MIN_SIZE = 64 * 1024;
+
 static std::map<std::string, std::shared_ptr<io::Device>> devices;
 
 void io::set_device(const std::string& name, std::shared_ptr<io::Device> device) {
@@ -155,6 +161,21 @@ std::string io::read_string(const path& filename) {
     return std::string((const char*)bytes.get(), size);
 }
 
+io::file_view io::read_view(const path& file) {
+    auto& device = io::require_device(file.entryPoint());
+    // reading small files is cheaper than mapping
+    if (device.size(file.pathPart()) >= MAP_MIN_SIZE) {
+        try {
+            if (auto mapping = device.map(file.pathPart())) {
+                return file_view(std::move(mapping));
+            }
+        } catch (const std::runtime_error& err) {
+            logger.warning() << err.what();
+        }
+    }
+    return file_view(read_bytes_buffer(file));
+}
+
 bool io::write_string(const io::path& file, std::string_view content) {
     return io::write_bytes(file, (const ubyte*)content.data(), content.size());
 }
@@ -168,23 +189,25 @@ bool io::write_json(
 bool io::write_binary_json(
     const io::path& file, const dv::value& obj, bool compression
 ) {
-    auto bytes = json::to_binary(obj, compression);
-    return io::write_bytes(file, bytes.data(), bytes.size());
+    auto stream = io::write(file);
+    json::write_binary(*stream, obj, compression);
+    stream->flush();
+    return stream->good();
 }
 
 dv::value io::read_json(const path& filename) {
-    std::string text = io::read_string(filename);
-    return json::parse(filename.string(), text);
+    auto view = io::read_view(filename);
+    return json::parse(filename.string(), view.text());
 }
 
 dv::value io::read_binary_json(const path& file) {
-    size_t size;
-    auto bytes = io::read_bytes(file, size);
-    return json::from_binary(bytes.get(), size);
+    auto stream = io::read(file);
+    return json::read_binary(*stream);
 }
 
 dv::value io::read_toml(const path& file) {
-    return toml::parse(file.string(), io::read_string(file));
+    auto view = io::read_view(file);
+    return toml::parse(file.string(), view.text());
 }
 
 std::vector<std::string> io::read_list(const io::path& filename) {
@@ -11,6 +11,7 @@
 #include "data/dv.hpp"
 #include "util/Buffer.hpp"
 #include "path.hpp"
+#include "mapped_file.hpp"
 
 namespace io {
     class Device;
@@ -159,6 +160,10 @@ namespace io {
     /// @brief Read string from the file
     std::string read_string(const path& file);
 
+    /// @brief Get read-only file content without copying it to a buffer
+    /// if the device supports mapping and the file is large enough
+    file_view read_view(const path& file);
+
     /// @brief Read JSON or BJSON file
     /// @param file *.json or *.bjson file
     dv::value read_json(const path& file);
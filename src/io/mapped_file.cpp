@@ -0,0 +1,103 @@
+#include "mapped_file.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace io;
+
+#ifdef _WIN32
+
+mapped_file::mapped_file(const std::filesystem::path& file) {
+    HANDLE handle = CreateFileW(
+        file.wstring().c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (handle == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("could not open file " + file.u8string());
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(handle, &fileSize)) {
+        CloseHandle(handle);
+        throw std::runtime_error("could not get size of " + file.u8string());
+    }
+    fileHandle = handle;
+    length = static_cast<size_t>(fileSize.QuadPart);
+    if (length == 0) {
+        return;
+    }
+    HANDLE mapping =
+        CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(handle);
+        throw std::runtime_error("could not map file " + file.u8string());
+    }
+    mappingHandle = mapping;
+    bytes = static_cast<const ubyte*>(
+        MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)
+    );
+    if (bytes == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(handle);
+        throw std::runtime_error("could not map file " + file.u8string());
+    }
+}
+
+mapped_file::~mapped_file() {
+    if (bytes) {
+        UnmapViewOfFile(bytes);
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle) {
+        CloseHandle(fileHandle);
+    }
+}
+
+#else
+
+mapped_file::mapped_file(const std::filesystem::path& file) {
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("could not open file " + file.u8string());
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        throw std::runtime_error("could not get size of " + file.u8string());
+    }
+    length = static_cast<size_t>(st.st_size);
+    if (length == 0) {
+        close(fd);
+        return;
+    }
+    void* ptr = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    // mapping stays valid after the descriptor is closed
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        throw std::runtime_error("could not map file " + file.u8string());
+    }
+    bytes = static_cast<const ubyte*>(ptr);
+}
+
+mapped_file::~mapped_file() {
+    if (bytes) {
+        munmap(const_cast<ubyte*>(bytes), length);
+    }
+}
+
+#endif // _WIN32
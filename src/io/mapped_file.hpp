@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+
+#include "typedefs.hpp"
+#include "util/Buffer.hpp"
+
+namespace io {
+    /// @brief Read-only file mapped to memory
+    class mapped_file {
+        const ubyte* bytes = nullptr;
+        size_t length = 0;
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#endif
+    public:
+        /// @param file resolved file path
+        /// @throw std::runtime_error if file could not be mapped
+        mapped_file(const std::filesystem::path& file);
+        ~mapped_file();
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        /// @return mapped file content (nullptr if file is empty)
+        const ubyte* data() const {
+            return bytes;
+        }
+
+        size_t size() const {
+            return length;
+        }
+    };
+
+    /// @brief Read-only file content mapped to memory or read to a buffer
+    class file_view {
+        std::unique_ptr<mapped_file> mapping;
+        util::Buffer<ubyte> buffer;
+    public:
+        file_view(std::unique_ptr<mapped_file> mapping)
+            : mapping(std::move(mapping)) {
+        }
+
+        file_view(util::Buffer<ubyte> buffer) : buffer(std::move(buffer)) {
+        }
+
+        const ubyte* data() const {
+            return mapping ? mapping->data() : buffer.data();
+        }
+
+        size_t size() const {
+            return mapping ? mapping->size() : buffer.size();
+        }
+
+        std::string_view text() const {
+            return std::string_view(
+                reinterpret_cast<const char*>(data()), size()
+            );
+        }
+    };
+}
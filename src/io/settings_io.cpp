@@ -45,6 +45,8 @@ SettingsHandler::SettingsHandler(EngineSettings& settings) {
     builder.add("volume-music", &settings.audio.volumeMusic);
     builder.add("input-device", &settings.audio.inputDevice);
     builder.add("acoustic-effects", &settings.audio.acousticEffects);
+    builder.add("sounds-cache-size", &settings.audio.soundsCacheSize);
+    builder.add("max-voices", &settings.audio.maxVoices);
 
     builder.addSection("display");
     builder.add("width", &settings.display.width);
@@ -54,6 +56,7 @@ SettingsHandler::SettingsHandler(EngineSettings& settings) {
     builder.add("limit-fps-iconified", &settings.display.limitFpsIconified);
     builder.add("window-mode", &settings.display.windowMode);
     builder.add("adaptive-menu-fps", &settings.display.adaptiveFpsInMenu);
+    builder.add("low-latency", &settings.display.lowLatency);
 
     builder.addSection("camera");
     builder.add("sensitivity", &settings.camera.sensitivity);
@@ -66,40 +69,78 @@ SettingsHandler::SettingsHandler(EngineSettings& settings) {
     builder.add("load-distance", &settings.chunks.loadDistance);
     builder.add("load-speed", &settings.chunks.loadSpeed);
     builder.add("padding", &settings.chunks.padding);
+    builder.add("async-generation", &settings.chunks.asyncGeneration);
+    builder.add("generator-workers", &settings.chunks.generatorWorkers);
+    builder.add("async-prototypes", &settings.chunks.asyncPrototypes);
+    builder.add("prototype-workers", &settings.chunks.prototypeWorkers);
+    builder.add("prototypes-cache", &settings.chunks.prototypesCache);
+    builder.add("async-lighting", &settings.chunks.asyncLighting);
+    builder.add("lights-workers", &settings.chunks.lightsWorkers);
+    builder.add("unloaded-cache", &settings.chunks.unloadedCache);
+    builder.add("pack-delay", &settings.chunks.packDelay);
 
     builder.addSection("graphics");
     builder.add("fog-curve", &settings.graphics.fogCurve);
     builder.add("backlight", &settings.graphics.backlight);
     builder.add("dense-render", &settings.graphics.denseRender);
+    builder.add("greedy-meshing", &settings.graphics.greedyMeshing);
+    builder.add("indirect-render", &settings.graphics.indirectRender);
     builder.add("gamma", &settings.graphics.gamma);
     builder.add("frustum-culling", &settings.graphics.frustumCulling);
+    builder.add("occlusion-culling", &settings.graphics.occlusionCulling);
     builder.add("skybox-resolution", &settings.graphics.skyboxResolution);
+    builder.add("skybox-amortized", &settings.graphics.skyboxAmortized);
     builder.add("chunk-max-vertices", &settings.graphics.chunkMaxVertices);
     builder.add("chunk-max-vertices-dense", &settings.graphics.chunkMaxVerticesDense);
     builder.add("chunk-max-renderers", &settings.graphics.chunkMaxRenderers);
+    builder.add("chunk-upload-budget", &settings.graphics.chunkUploadBudget);
     builder.add("particles-batch-vertices", &settings.graphics.particlesBatchVertices);
     builder.add("advanced-render", &settings.graphics.advancedRender);
+    builder.add("dynamic-resolution", &settings.graphics.dynamicResolution);
+    builder.add("post-effects-fusion", &settings.graphics.postEffectsFusion);
     builder.add("ssao", &settings.graphics.ssao);
     builder.add("shadows-quality", &settings.graphics.shadowsQuality);
     builder.add("dense-render-distance", &settings.graphics.denseRenderDistance);
+    builder.add("lod-distance", &settings.graphics.lodDistance);
     builder.add("soft-lighting", &settings.graphics.softLighting);
     builder.add("clouds-quality", &settings.graphics.cloudsQuality);
+    builder.add("atlas-compression", &settings.graphics.atlasCompression);
 
     builder.addSection("ui");
     builder.add("language", &settings.ui.language);
     builder.add("world-preview-size", &settings.ui.worldPreviewSize);
 
+    builder.addSection("network");
+    builder.add("max-requests", &settings.network.maxRequests);
+
     builder.addSection("pathfinding");
     builder.add("steps-per-async-agent", &settings.pathfinding.stepsPerAsyncAgent);
+    builder.add("steps-per-tick", &settings.pathfinding.stepsPerTick);
+    builder.add("shared-field-ticks", &settings.pathfinding.sharedFieldTicks);
+
+    builder.addSection("scripting");
+    builder.add("gc-stepping", &settings.scripting.gcStepping);
+    builder.add("gc-pause", &settings.scripting.gcPause);
+    builder.add("gc-stepmul", &settings.scripting.gcStepMul);
+    builder.add("gc-min-budget", &settings.scripting.gcMinBudget);
+    builder.add("gc-max-budget", &settings.scripting.gcMaxBudget);
+    builder.add("systems-workers", &settings.scripting.systemsWorkers);
 
     builder.addSection("debug");
     builder.add("generator-test-mode", &settings.debug.generatorTestMode);
     builder.add("do-write-lights", &settings.debug.doWriteLights);
+    builder.add("do-map-region-files", &settings.debug.doMapRegionFiles);
+    builder.add("max-open-region-files", &settings.debug.maxOpenRegionFiles);
+    builder.add("regions-memory-budget", &settings.debug.regionsMemoryBudget);
     builder.add("do-trace-shaders", &settings.debug.doTraceShaders);
     builder.add("enable-experimental", &settings.debug.enableExperimental);
 
     builder.addSection("system");
     builder.add("max-bg-asset-loaders", &settings.system.maxBgAssetLoaders);
+    builder.add("memory-budget", &settings.system.memoryBudget);
+    builder.add("video-memory-budget", &settings.system.videoMemoryBudget);
+    builder.add("worker-threads", &settings.system.workerThreads);
+    builder.add("pin-threads", &settings.system.pinThreads);
 }
 
 dv::value SettingsHandler::getValue(const std::string& name) const {
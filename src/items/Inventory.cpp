@@ -13,6 +13,7 @@ Inventory::Inventory(const Inventory& orig) : id(0) {
 }
 
 ItemStack& Inventory::getSlot(size_t index) {
+    dirty = true;
     return slots.at(index);
 }
 
@@ -42,6 +43,7 @@ size_t Inventory::findSlotByItem(
 void Inventory::move(
     ItemStack& item, const ContentIndices& indices, size_t begin, size_t end
 ) {
+    dirty = true;
     end = std::min(slots.size(), end);
     for (size_t i = begin; i < end && !item.isEmpty(); i++) {
         ItemStack& slot = slots[i];
@@ -59,10 +61,12 @@ void Inventory::move(
 
 void Inventory::resize(uint newSize) {
     slots.resize(newSize);
+    dirty = true;
 }
 
 void Inventory::deserialize(const dv::value& src) {
     id = src["id"].asInteger(1);
+    dirty = true;
     auto& slotsarr = src["slots"];
     size_t slotscount = slotsarr.size();
     while (slots.size() < slotscount) {
@@ -116,6 +120,7 @@ void Inventory::check(const ContentIndices& indices) {
                            << " found in inventory #" << id << " slot #" << i
                            << "; will reset";
             slot.clear();
+            dirty = true;
 #else
             abort();
 #endif
@@ -124,6 +129,7 @@ void Inventory::check(const ContentIndices& indices) {
 }
 
 void Inventory::convert(const ContentReport* report) {
+    dirty = true;
     for (auto& slot : slots) {
         itemid_t id = slot.getItemId();
         itemid_t replacement = report->items.getId(id);
@@ -13,6 +13,7 @@ class ContentIndices;
 class Inventory : public Serializable {
     int64_t id;
     std::vector<ItemStack> slots;
+    bool dirty = true;
 public:
     Inventory() = default;
 
@@ -20,6 +21,7 @@ public:
 
     explicit Inventory(const Inventory& orig);
 
+    /// @brief Get slot for modification (marks inventory dirty)
     ItemStack& getSlot(size_t index);
     size_t findEmptySlot(size_t begin = 0, size_t end = -1) const;
     size_t findSlotByItem(
@@ -49,6 +51,17 @@ public:
 
     void setId(int64_t id) {
         this->id = id;
+        dirty = true;
+    }
+
+    /// @return true if inventory may be modified since the last resetDirty
+    /// call. Any non-const slot access is considered a modification
+    bool isDirty() const {
+        return dirty;
+    }
+
+    void resetDirty() {
+        dirty = false;
     }
 
     int64_t getId() const {
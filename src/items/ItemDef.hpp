@@ -15,7 +15,11 @@ struct ItemFuncsSet {
     bool on_block_break_by : 1;
 };
 
+/// @brief Item events handles (see lua::intern_event)
 struct ItemFuncNamesCache {
+    int use;
+    int useOn;
+    int blockBreakBy;
 };
 
 enum class ItemIconType {
@@ -5,20 +5,43 @@
 #include "voxels/Chunk.hpp"
 #include "voxels/voxel.hpp"
 #include "voxels/Block.hpp"
+#include "maths/voxmaths.hpp"
 
 #include <assert.h>
 
 LightSolver::LightSolver(const ContentIndices& contentIds, Chunks& chunks, int channel) 
     : blockDefs(contentIds.blocks.getDefs()),
-      chunks(chunks), 
+      chunks(&chunks), 
       channel(channel) {
 }
 
+LightSolver::LightSolver(const ContentIndices& contentIds, int channel)
+    : blockDefs(contentIds.blocks.getDefs()),
+      chunks(nullptr),
+      channel(channel) {
+}
+
+void LightSolver::setIsolatedChunk(Chunk* chunk) {
+    assert(chunks == nullptr);
+    isolatedChunk = chunk;
+}
+
+inline Chunk* LightSolver::getChunkByVoxel(int x, int y, int z) const {
+    if (chunks) {
+        return chunks->getChunkByVoxel(x, y, z);
+    }
+    if (y < 0 || y >= CHUNK_H || isolatedChunk == nullptr ||
+        !isolatedChunk->isBlockInside(x, z)) {
+        return nullptr;
+    }
+    return isolatedChunk;
+}
+
 void LightSolver::add(int x, int y, int z, int emission) {
     if (emission <= 1) {
         return;
     }
-    Chunk* chunk = chunks.getChunkByVoxel(x, y, z);
+    Chunk* chunk = getChunkByVoxel(x, y, z);
     if (chunk == nullptr) {
         return;
     }
@@ -30,16 +53,23 @@ void LightSolver::add(int x, int y, int z, int emission) {
 
     addqueue.push(lightentry {x, y, z, ubyte(emission)});
 
-    chunk->flags.modified = true;
+    chunk->setModified(y);
     lightmap.set(x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, channel, emission);
 }
 
 void LightSolver::add(int x, int y, int z) {
-    add(x,y,z, chunks.getLight(x,y,z, channel));
+    Chunk* chunk = getChunkByVoxel(x, y, z);
+    if (chunk == nullptr) {
+        return;
+    }
+    assert(chunk->lightmap != nullptr);
+    add(x, y, z, chunk->lightmap->get(
+        x - chunk->x * CHUNK_W, y, z - chunk->z * CHUNK_D, channel
+    ));
 }
 
 void LightSolver::remove(int x, int y, int z) {
-    Chunk* chunk = chunks.getChunkByVoxel(x, y, z);
+    Chunk* chunk = getChunkByVoxel(x, y, z);
     if (chunk == nullptr) {
         return;
     }
@@ -54,99 +84,323 @@ void LightSolver::remove(int x, int y, int z) {
     lightmap.set(x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, channel, 0);
 }
 
-void LightSolver::solve(Chunk* prevailingChunk) {
-    const int coords[] = {
-            0, 0, 1,
-            0, 0,-1,
-            0, 1, 0,
-            0,-1, 0,
-            1, 0, 0,
-           -1, 0, 0
-    };
-
-    while (!remqueue.empty()){
-        lightentry entry = std::move(remqueue.front());
-        remqueue.pop();
+static constexpr int NEIGHBOUR_OFFSETS[] {
+    0, 0, 1,
+    0, 0,-1,
+    0, 1, 0,
+    0,-1, 0,
+    1, 0, 0,
+   -1, 0, 0
+};
+
+static_assert(CHUNK_VOL <= 0x10000, "local index must fit 16 bits");
+
+namespace {
+    /// @brief Packed chunk-local light entry:
+    /// [0..15] voxel index, [16..19] neighbourhood slot, [20..23] level
+    inline uint32_t pack_entry(int slot, int index, int level) {
+        return index | (slot << 16) | (level << 20);
+    }
+
+    inline int entry_index(uint32_t entry) {
+        return entry & 0xFFFF;
+    }
+
+    inline int entry_slot(uint32_t entry) {
+        return (entry >> 16) & 0xF;
+    }
+
+    inline int entry_level(uint32_t entry) {
+        return (entry >> 20) & 0xF;
+    }
+}
+
+/// @brief Removal step of a neighbour voxel of removed light source
+/// @param light entry (removed) light level
+/// @param pushRemove, pushAdd queue the voxel with a light level
+template <typename PushRemove, typename PushAdd>
+static inline void remove_neighbour(
+    const Block* const* blockDefs,
+    int channel,
+    Chunk& chunk,
+    int lx,
+    int y,
+    int lz,
+    int light,
+    const PushRemove& pushRemove,
+    const PushAdd& pushAdd
+) {
+    chunk.setModified(y);
+    auto& lightmap = *chunk.lightmap;
+
+    int current = lightmap.get(lx, y, lz, channel);
+    if (current != 0 && current == light - 1) {
+        voxel vox = chunk.get(lx, y, lz);
+        uint8_t emission = 0;
+        if (vox.id != 0) {
+            emission = blockDefs[vox.id]->emission[channel];
+        }
+        if (emission) {
+            pushAdd(emission);
+        }
+        lightmap.set(lx, y, lz, channel, emission);
+        pushRemove(current);
+    } else if (current >= light) {
+        pushAdd(current);
+    }
+}
+
+/// @brief Addition step of a neighbour voxel of light source
+/// @param light entry light level
+/// @param pushAdd queue the voxel with a light level
+template <typename PushAdd>
+static inline void add_neighbour(
+    const Block* const* blockDefs,
+    int channel,
+    Chunk& chunk,
+    int lx,
+    int y,
+    int lz,
+    int light,
+    const PushAdd& pushAdd
+) {
+    chunk.setModified(y);
+    auto& lightmap = *chunk.lightmap;
+
+    int current = lightmap.get(lx, y, lz, channel);
+    voxel vox = chunk.get(lx, y, lz);
+    if (blockDefs[vox.id]->lightPassing && current + 2 <= light) {
+        lightmap.set(lx, y, lz, channel, light - 1);
+        pushAdd(light - 1);
+    }
+}
+
+void LightSolver::cacheNeighbours(Chunk& center) {
+    centerX = center.x;
+    centerZ = center.z;
+    for (int dz = -1; dz <= 1; dz++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            Chunk* chunk = nullptr;
+            if (chunks) {
+                chunk = chunks->getChunk(centerX + dx, centerZ + dz);
+            } else if (dx == 0 && dz == 0 && &center == isolatedChunk) {
+                chunk = isolatedChunk;
+            }
+            neighbours[(dz + 1) * 3 + dx + 1] = chunk;
+        }
+    }
+}
+
+void LightSolver::localize(
+    util::array_queue<lightentry>& queue, std::vector<uint32_t>& dst
+) {
+    for (size_t n = queue.size(); n > 0; n--) {
+        lightentry entry = queue.front();
+        queue.pop();
+        int sx = floordiv<CHUNK_W>(entry.x) - centerX + 1;
+        int sz = floordiv<CHUNK_D>(entry.z) - centerZ + 1;
+        if (sx < 0 || sz < 0 || sx > 2 || sz > 2 ||
+            neighbours[sz * 3 + sx] == nullptr) {
+            queue.push(std::move(entry));
+            continue;
+        }
+        int slot = sz * 3 + sx;
+        Chunk* chunk = neighbours[slot];
+        int index = vox_index(
+            entry.x - chunk->x * CHUNK_W, entry.y, entry.z - chunk->z * CHUNK_D
+        );
+        dst.push_back(pack_entry(slot, index, entry.light));
+    }
+}
 
-        for (int i = 0; i < 6; i++) {
-            int imul3 = i * 3;
-            int x = entry.x+coords[imul3];
-            int y = entry.y+coords[imul3+1];
-            int z = entry.z+coords[imul3+2];
-            
-            Chunk* chunk = prevailingChunk;
-            if (chunk == nullptr || !chunk->isBlockInside(x, z)) {
-                chunk = chunks.getChunkByVoxel(x,y,z);
-                if (chunk == nullptr) {
-                    continue;
+void LightSolver::solveLocalRemoval() {
+    // the queue grows while processed
+    for (size_t i = 0; i < localRemQueue.size(); i++) {
+        uint32_t entry = localRemQueue[i];
+        int index = entry_index(entry);
+        int slot = entry_slot(entry);
+        int light = entry_level(entry);
+        int ex = index % CHUNK_W;
+        int ey = index / (CHUNK_W * CHUNK_D);
+        int ez = (index / CHUNK_W) % CHUNK_D;
+
+        for (int face = 0; face < 6; face++) {
+            int lx = ex + NEIGHBOUR_OFFSETS[face * 3];
+            int y = ey + NEIGHBOUR_OFFSETS[face * 3 + 1];
+            int lz = ez + NEIGHBOUR_OFFSETS[face * 3 + 2];
+            if (y < 0 || y >= CHUNK_H) {
+                continue;
+            }
+            int sx = slot % 3 + floordiv<CHUNK_W>(lx);
+            int sz = slot / 3 + floordiv<CHUNK_D>(lz);
+            lx = lx & (CHUNK_W - 1);
+            lz = lz & (CHUNK_D - 1);
+            if (sx < 0 || sz < 0 || sx > 2 || sz > 2) {
+                // leaving the neighbourhood
+                int x = (centerX + sx - 1) * CHUNK_W + lx;
+                int z = (centerZ + sz - 1) * CHUNK_D + lz;
+                if (Chunk* chunk = getChunkByVoxel(x, y, z)) {
+                    remove_neighbour(
+                        blockDefs, channel, *chunk, lx, y, lz, light,
+                        [&](int level) {
+                            remqueue.push(lightentry {x, y, z, ubyte(level)});
+                        },
+                        [&](int level) {
+                            addqueue.push(lightentry {x, y, z, ubyte(level)});
+                        }
+                    );
                 }
-            } else if (y < 0 || y >= CHUNK_H) {
                 continue;
             }
+            int nslot = sz * 3 + sx;
+            Chunk* chunk = neighbours[nslot];
+            if (chunk == nullptr) {
+                continue;
+            }
+            int nindex = vox_index(lx, y, lz);
+            remove_neighbour(
+                blockDefs, channel, *chunk, lx, y, lz, light,
+                [&](int level) {
+                    localRemQueue.push_back(pack_entry(nslot, nindex, level));
+                },
+                [&](int level) {
+                    localAddQueue.push_back(pack_entry(nslot, nindex, level));
+                }
+            );
+        }
+    }
+    localRemQueue.clear();
+}
+
+void LightSolver::solveLocalAddition() {
+    for (size_t i = 0; i < localAddQueue.size(); i++) {
+        uint32_t entry = localAddQueue[i];
+        int index = entry_index(entry);
+        int slot = entry_slot(entry);
+        int light = entry_level(entry);
+        if (light <= 1) {
+            continue;
+        }
+        int ex = index % CHUNK_W;
+        int ey = index / (CHUNK_W * CHUNK_D);
+        int ez = (index / CHUNK_W) % CHUNK_D;
 
-            int lx = x - chunk->x * CHUNK_W;
-            int lz = z - chunk->z * CHUNK_D;
-            chunk->flags.modified = true;
-
-            assert(chunk->lightmap != nullptr);
-            auto& lightmap = *chunk->lightmap;
-
-            ubyte light = lightmap.get(lx,y,lz, channel);
-            if (light != 0 && light == entry.light-1) {
-                voxel* vox = chunks.get(x, y, z);
-                if (vox && vox->id != 0) {
-                    const Block* block = blockDefs[vox->id];
-                    if (uint8_t emission = block->emission[channel]) {
-                        addqueue.push(lightentry {x, y, z, emission});
-                        lightmap.set(lx, y, lz, channel, emission);
-                    }
-                    else lightmap.set(lx, y, lz, channel, 0);
+        for (int face = 0; face < 6; face++) {
+            int lx = ex + NEIGHBOUR_OFFSETS[face * 3];
+            int y = ey + NEIGHBOUR_OFFSETS[face * 3 + 1];
+            int lz = ez + NEIGHBOUR_OFFSETS[face * 3 + 2];
+            if (y < 0 || y >= CHUNK_H) {
+                continue;
+            }
+            int sx = slot % 3 + floordiv<CHUNK_W>(lx);
+            int sz = slot / 3 + floordiv<CHUNK_D>(lz);
+            lx = lx & (CHUNK_W - 1);
+            lz = lz & (CHUNK_D - 1);
+            if (sx < 0 || sz < 0 || sx > 2 || sz > 2) {
+                // leaving the neighbourhood
+                int x = (centerX + sx - 1) * CHUNK_W + lx;
+                int z = (centerZ + sz - 1) * CHUNK_D + lz;
+                if (Chunk* chunk = getChunkByVoxel(x, y, z)) {
+                    add_neighbour(
+                        blockDefs, channel, *chunk, lx, y, lz, light,
+                        [&](int level) {
+                            addqueue.push(lightentry {x, y, z, ubyte(level)});
+                        }
+                    );
                 }
-                else lightmap.set(lx, y, lz, channel, 0);
-                remqueue.push(lightentry {x, y, z, light});
+                continue;
+            }
+            int nslot = sz * 3 + sx;
+            Chunk* chunk = neighbours[nslot];
+            if (chunk == nullptr) {
+                continue;
             }
-            else if (light >= entry.light) {
-                addqueue.push(lightentry {x, y, z, light});
+            int nindex = vox_index(lx, y, lz);
+            add_neighbour(
+                blockDefs, channel, *chunk, lx, y, lz, light,
+                [&](int level) {
+                    localAddQueue.push_back(pack_entry(nslot, nindex, level));
+                }
+            );
+        }
+    }
+    localAddQueue.clear();
+}
+
+void LightSolver::solveWorldRemoval() {
+    while (!remqueue.empty()) {
+        lightentry entry = remqueue.front();
+        remqueue.pop();
+
+        for (int face = 0; face < 6; face++) {
+            int x = entry.x + NEIGHBOUR_OFFSETS[face * 3];
+            int y = entry.y + NEIGHBOUR_OFFSETS[face * 3 + 1];
+            int z = entry.z + NEIGHBOUR_OFFSETS[face * 3 + 2];
+            Chunk* chunk = getChunkByVoxel(x, y, z);
+            if (chunk == nullptr) {
+                continue;
             }
+            remove_neighbour(
+                blockDefs, channel, *chunk,
+                x - chunk->x * CHUNK_W, y, z - chunk->z * CHUNK_D,
+                entry.light,
+                [&](int level) {
+                    remqueue.push(lightentry {x, y, z, ubyte(level)});
+                },
+                [&](int level) {
+                    addqueue.push(lightentry {x, y, z, ubyte(level)});
+                }
+            );
         }
     }
+}
 
-    while (!addqueue.empty()){
-        lightentry entry = std::move(addqueue.front());
+void LightSolver::solveWorldAddition() {
+    while (!addqueue.empty()) {
+        lightentry entry = addqueue.front();
         addqueue.pop();
 
-        for (int i = 0; i < 6; i++) {
-            int imul3 = i*3;
-            int x = entry.x+coords[imul3];
-            int y = entry.y+coords[imul3+1];
-            int z = entry.z+coords[imul3+2];
-
-            Chunk* chunk = prevailingChunk;
-            if (chunk == nullptr || !chunk->isBlockInside(x, z)) {
-                chunk = chunks.getChunkByVoxel(x,y,z);
-                if (chunk == nullptr) {
-                    continue;
-                }
-            } else if (y < 0 || y >= CHUNK_H) {
+        for (int face = 0; face < 6; face++) {
+            int x = entry.x + NEIGHBOUR_OFFSETS[face * 3];
+            int y = entry.y + NEIGHBOUR_OFFSETS[face * 3 + 1];
+            int z = entry.z + NEIGHBOUR_OFFSETS[face * 3 + 2];
+            Chunk* chunk = getChunkByVoxel(x, y, z);
+            if (chunk == nullptr) {
                 continue;
             }
+            add_neighbour(
+                blockDefs, channel, *chunk,
+                x - chunk->x * CHUNK_W, y, z - chunk->z * CHUNK_D,
+                entry.light,
+                [&](int level) {
+                    addqueue.push(lightentry {x, y, z, ubyte(level)});
+                }
+            );
+        }
+    }
+}
 
-            assert(chunk->lightmap != nullptr);
-            auto& lightmap = *chunk->lightmap;
-            int lx = x - chunk->x * CHUNK_W;
-            int lz = z - chunk->z * CHUNK_D;
-            chunk->flags.modified = true;
-
-            ubyte light = lightmap.get(lx, y, lz, channel);
-            voxel& v = chunk->voxels[vox_index(lx, y, lz)];
-            const Block* block = blockDefs[v.id];
-            if (block->lightPassing && light+2 <= entry.light){
-                lightmap.set(
-                    x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, 
-                    channel, 
-                    entry.light-1);
-                addqueue.push(lightentry {x, y, z, ubyte(entry.light-1)});
-            }
+void LightSolver::solve(Chunk* prevailingChunk) {
+    Chunk* center = prevailingChunk;
+    if (center == nullptr) {
+        if (!remqueue.empty()) {
+            const auto& entry = remqueue.front();
+            center = getChunkByVoxel(entry.x, entry.y, entry.z);
+        } else if (!addqueue.empty()) {
+            const auto& entry = addqueue.front();
+            center = getChunkByVoxel(entry.x, entry.y, entry.z);
         }
     }
+    if (center) {
+        cacheNeighbours(*center);
+        localize(remqueue, localRemQueue);
+        localize(addqueue, localAddQueue);
+        solveLocalRemoval();
+    }
+    solveWorldRemoval();
+    if (center) {
+        localize(addqueue, localAddQueue);
+        solveLocalAddition();
+    }
+    solveWorldAddition();
 }
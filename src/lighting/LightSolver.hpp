@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include "util/array_queue.hpp"
 
 class Chunk;
@@ -15,16 +18,56 @@ struct lightentry {
 };
 
 class LightSolver {
+    /// @brief World coordinates queues: entries pushed with add/remove
+    /// and ones spilled outside of the cached neighbourhood
     util::array_queue<lightentry> addqueue;
     util::array_queue<lightentry> remqueue;
+    /// @brief Chunk-local entries packed as (level, chunk slot, local
+    /// voxel index), processed in bulk phases
+    std::vector<uint32_t> localAddQueue;
+    std::vector<uint32_t> localRemQueue;
+    /// @brief Cached 3x3 chunks neighbourhood of the solved area
+    /// (nullptr - chunk is not available)
+    Chunk* neighbours[9] {};
+    int centerX = 0;
+    int centerZ = 0;
+
     const Block* const* blockDefs;
-    Chunks& chunks;
+    Chunks* chunks;
+    /// @brief The only chunk accessible in isolated mode
+    Chunk* isolatedChunk = nullptr;
     int channel;
+
+    inline Chunk* getChunkByVoxel(int x, int y, int z) const;
+
+    void cacheNeighbours(Chunk& center);
+    /// @brief Move world queue entries inside of the neighbourhood to the
+    /// local queue
+    void localize(
+        util::array_queue<lightentry>& queue, std::vector<uint32_t>& dst
+    );
+    void solveLocalRemoval();
+    void solveLocalAddition();
+    void solveWorldRemoval();
+    void solveWorldAddition();
 public:
     LightSolver(const ContentIndices& contentIds, Chunks& chunks, int channel);
 
+    /// @brief Create solver working in isolated mode: light is not
+    /// propagated outside of the chunk set with setIsolatedChunk(...).
+    /// Isolated solvers do not access the chunks matrix, so they may be
+    /// used from worker threads
+    LightSolver(const ContentIndices& contentIds, int channel);
+
+    void setIsolatedChunk(Chunk* chunk);
+
     void add(int x, int y, int z);
     void add(int x, int y, int z, int emission);
     void remove(int x, int y, int z);
+
+    /// @brief Propagate queued changes. Light is solved in the 3x3 chunks
+    /// neighbourhood of the prevailing chunk (or the first queued entry
+    /// chunk) with chunk-local entries; the rare entries leaving it are
+    /// solved in world coordinates
     void solve(Chunk* prevailingChunk = nullptr);
 };
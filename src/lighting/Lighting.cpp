@@ -9,11 +9,198 @@
 #include "constants.hpp"
 #include "util/timeutil.hpp"
 #include "debug/Logger.hpp"
+#include "debug/Profiler.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define VC_LIGHTING_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define VC_LIGHTING_NEON
+#endif
+
 static debug::Logger logger("lighting");
 
+static_assert(CHUNK_W == 16, "column-scan kernels process 16 columns per row");
+
+/// Lane masks of 16 voxel columns of a chunk row (0xFF - set, 0x00 - unset)
+namespace {
+#if defined(VC_LIGHTING_SSE2)
+    using lanes16 = __m128i;
+
+    inline lanes16 lanes_all() {
+        return _mm_set1_epi8(-1);
+    }
+    inline lanes16 lanes_none() {
+        return _mm_setzero_si128();
+    }
+    inline lanes16 lanes_load(const uint8_t* src) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    }
+    inline void lanes_store(uint8_t* dst, lanes16 a) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), a);
+    }
+    inline lanes16 lanes_and(lanes16 a, lanes16 b) {
+        return _mm_and_si128(a, b);
+    }
+    inline lanes16 lanes_or(lanes16 a, lanes16 b) {
+        return _mm_or_si128(a, b);
+    }
+    /// @return a & ~b
+    inline lanes16 lanes_andnot(lanes16 a, lanes16 b) {
+        return _mm_andnot_si128(b, a);
+    }
+    inline bool lanes_any(lanes16 a) {
+        return _mm_movemask_epi8(a) != 0;
+    }
+    inline bool lanes_every(lanes16 a) {
+        return _mm_movemask_epi8(a) == 0xFFFF;
+    }
+    /// @brief Set sky light to 15 in the masked lanes of 16 lights
+    inline void lanes_fill_sky(light_t* lights, lanes16 mask) {
+        const __m128i sky = _mm_set1_epi16(static_cast<short>(0xF000));
+        auto lo = reinterpret_cast<__m128i*>(lights);
+        auto hi = reinterpret_cast<__m128i*>(lights + 8);
+        __m128i mlo = _mm_and_si128(_mm_unpacklo_epi8(mask, mask), sky);
+        __m128i mhi = _mm_and_si128(_mm_unpackhi_epi8(mask, mask), sky);
+        _mm_storeu_si128(lo, _mm_or_si128(_mm_loadu_si128(lo), mlo));
+        _mm_storeu_si128(hi, _mm_or_si128(_mm_loadu_si128(hi), mhi));
+    }
+    /// @brief Lanes where sky light of 16 lights is 15
+    inline lanes16 lanes_sky_full(const light_t* lights) {
+        const __m128i sky = _mm_set1_epi16(static_cast<short>(0xF000));
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lights));
+        __m128i hi =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(lights + 8));
+        lo = _mm_cmpeq_epi16(_mm_and_si128(lo, sky), sky);
+        hi = _mm_cmpeq_epi16(_mm_and_si128(hi, sky), sky);
+        return _mm_packs_epi16(lo, hi);
+    }
+#elif defined(VC_LIGHTING_NEON)
+    using lanes16 = uint8x16_t;
+
+    inline lanes16 lanes_all() {
+        return vdupq_n_u8(0xFF);
+    }
+    inline lanes16 lanes_none() {
+        return vdupq_n_u8(0);
+    }
+    inline lanes16 lanes_load(const uint8_t* src) {
+        return vld1q_u8(src);
+    }
+    inline void lanes_store(uint8_t* dst, lanes16 a) {
+        vst1q_u8(dst, a);
+    }
+    inline lanes16 lanes_and(lanes16 a, lanes16 b) {
+        return vandq_u8(a, b);
+    }
+    inline lanes16 lanes_or(lanes16 a, lanes16 b) {
+        return vorrq_u8(a, b);
+    }
+    /// @return a & ~b
+    inline lanes16 lanes_andnot(lanes16 a, lanes16 b) {
+        return vbicq_u8(a, b);
+    }
+    inline bool lanes_any(lanes16 a) {
+        uint64x2_t v = vreinterpretq_u64_u8(a);
+        return (vgetq_lane_u64(v, 0) | vgetq_lane_u64(v, 1)) != 0;
+    }
+    inline bool lanes_every(lanes16 a) {
+        uint64x2_t v = vreinterpretq_u64_u8(a);
+        return (vgetq_lane_u64(v, 0) & vgetq_lane_u64(v, 1)) == ~0ULL;
+    }
+    inline uint16x8_t widen(uint8x8_t mask) {
+        return vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(mask)));
+    }
+    /// @brief Set sky light to 15 in the masked lanes of 16 lights
+    inline void lanes_fill_sky(light_t* lights, lanes16 mask) {
+        const uint16x8_t sky = vdupq_n_u16(0xF000);
+        uint16x8_t lo = vld1q_u16(lights);
+        uint16x8_t hi = vld1q_u16(lights + 8);
+        lo = vorrq_u16(lo, vandq_u16(widen(vget_low_u8(mask)), sky));
+        hi = vorrq_u16(hi, vandq_u16(widen(vget_high_u8(mask)), sky));
+        vst1q_u16(lights, lo);
+        vst1q_u16(lights + 8, hi);
+    }
+    /// @brief Lanes where sky light of 16 lights is 15
+    inline lanes16 lanes_sky_full(const light_t* lights) {
+        const uint16x8_t sky = vdupq_n_u16(0xF000);
+        uint16x8_t lo = vceqq_u16(vandq_u16(vld1q_u16(lights), sky), sky);
+        uint16x8_t hi = vceqq_u16(vandq_u16(vld1q_u16(lights + 8), sky), sky);
+        return vcombine_u8(vmovn_u16(lo), vmovn_u16(hi));
+    }
+#else
+    struct lanes16 {
+        uint8_t v[16];
+    };
+
+    inline lanes16 lanes_all() {
+        lanes16 r;
+        std::memset(r.v, 0xFF, sizeof(r.v));
+        return r;
+    }
+    inline lanes16 lanes_none() {
+        return lanes16 {};
+    }
+    inline lanes16 lanes_load(const uint8_t* src) {
+        lanes16 r;
+        std::memcpy(r.v, src, sizeof(r.v));
+        return r;
+    }
+    inline void lanes_store(uint8_t* dst, lanes16 a) {
+        std::memcpy(dst, a.v, sizeof(a.v));
+    }
+    inline lanes16 lanes_and(lanes16 a, lanes16 b) {
+        for (int i = 0; i < 16; i++) a.v[i] &= b.v[i];
+        return a;
+    }
+    inline lanes16 lanes_or(lanes16 a, lanes16 b) {
+        for (int i = 0; i < 16; i++) a.v[i] |= b.v[i];
+        return a;
+    }
+    /// @return a & ~b
+    inline lanes16 lanes_andnot(lanes16 a, lanes16 b) {
+        for (int i = 0; i < 16; i++) a.v[i] &= ~b.v[i];
+        return a;
+    }
+    inline bool lanes_any(lanes16 a) {
+        for (int i = 0; i < 16; i++) if (a.v[i]) return true;
+        return false;
+    }
+    inline bool lanes_every(lanes16 a) {
+        for (int i = 0; i < 16; i++) if (!a.v[i]) return false;
+        return true;
+    }
+    /// @brief Set sky light to 15 in the masked lanes of 16 lights
+    inline void lanes_fill_sky(light_t* lights, lanes16 mask) {
+        for (int i = 0; i < 16; i++) {
+            if (mask.v[i]) lights[i] |= 0xF000;
+        }
+    }
+    /// @brief Lanes where sky light of 16 lights is 15
+    inline lanes16 lanes_sky_full(const light_t* lights) {
+        lanes16 r;
+        for (int i = 0; i < 16; i++) {
+            r.v[i] = (lights[i] & 0xF000) == 0xF000 ? 0xFF : 0x00;
+        }
+        return r;
+    }
+#endif
+
+    /// @brief Lookup block masks of 16 voxels of a row
+    inline lanes16 lanes_gather(const uint8_t* masks, const voxel* row) {
+        alignas(16) uint8_t values[16];
+        for (int i = 0; i < 16; i++) {
+            values[i] = masks[row[i].id];
+        }
+        return lanes_load(values);
+    }
+}
+
 Lighting::Lighting(const Content& content, Chunks& chunks) 
   : content(content), chunks(chunks) {
     auto& indices = *content.getIndices();
@@ -36,7 +223,7 @@ void Lighting::clear(){
         if (lightmap == nullptr) {
             continue;
         }
-        std::memset(lightmap->map, 0, sizeof(Lightmap::map));
+        lightmap->clear();
     }
 }
 
@@ -44,23 +231,38 @@ void Lighting::prebuildSkyLight(Chunk& chunk, const ContentIndices& indices) {
     assert(chunk.lightmap != nullptr);
     auto& lightmap = *chunk.lightmap;
     
-    const auto* blockDefs = indices.blocks.getDefs();
+    const uint8_t* passingMasks = indices.getSkyLightPassingMasks();
+    const voxel* voxels = chunk.getVoxels();
 
+    // the highest row blocking sky light in any column
     int highestPoint = 0;
-    for (int z = 0; z < CHUNK_D; z++){
-        for (int x = 0; x < CHUNK_W; x++){
-            for (int y = CHUNK_H-1; y >= 0; y--){
-                int index = (y * CHUNK_D + z) * CHUNK_W + x;
-                voxel& vox = chunk.voxels[index];
-                const Block* block = blockDefs[vox.id];
-                if (!block->skyLightPassing) {
-                    if (highestPoint < y) {
-                        highestPoint = y;
-                    }
-                    break;
-                }
-                lightmap.setS(x, y, z, 15);
+    for (int z = 0; z < CHUNK_D; z++) {
+        for (int y = CHUNK_H - 1; y > highestPoint; y--) {
+            int index = (y * CHUNK_D + z) * CHUNK_W;
+            lanes16 passing = lanes_gather(passingMasks, voxels + index);
+            if (!lanes_every(passing)) {
+                highestPoint = y;
+                break;
+            }
+        }
+    }
+    // sections above are fully lit without allocating storage
+    int uniformSection = highestPoint / CHUNK_SECTION_H + 1;
+    for (int section = uniformSection; section < CHUNK_SECTIONS; section++) {
+        lightmap.orSection(section, Lightmap::SUN_LIGHT_ONLY);
+    }
+    int startY = std::min(CHUNK_H, uniformSection * CHUNK_SECTION_H) - 1;
+    for (int z = 0; z < CHUNK_D; z++) {
+        // columns not blocked yet
+        lanes16 open = lanes_all();
+        for (int y = startY; y >= 0; y--) {
+            int index = (y * CHUNK_D + z) * CHUNK_W;
+            lanes16 passing = lanes_gather(passingMasks, voxels + index);
+            open = lanes_and(open, passing);
+            if (!lanes_any(open)) {
+                break;
             }
+            lanes_fill_sky(lightmap.getRowWriteable(y, z), open);
         }
     }
     if (highestPoint < CHUNK_H-1) {
@@ -69,42 +271,117 @@ void Lighting::prebuildSkyLight(Chunk& chunk, const ContentIndices& indices) {
     lightmap.highestPoint = highestPoint;
 }
 
-void Lighting::buildSkyLight(int cx, int cz){
-    const auto blockDefs = content.getIndices()->blocks.getDefs();
-
-    Chunk* chunk = chunks.getChunk(cx, cz);
-    if (chunk == nullptr) {
-        logger.error() << "attempted to build sky lights to chunk missing in local matrix";
-        return;
+/// @brief Find top sky light sources of each of 16 columns of a chunk row:
+/// the highest (not above lightmap.highestPoint) light passing voxel with
+/// sky light below 15 (the lowest voxel counts as passing)
+/// @param starts output start Y of each column or -1
+static void scan_sky_light_row(
+    const uint8_t* passingMasks, const Chunk& chunk, int z, int* starts
+) {
+    const auto& lightmap = *chunk.lightmap;
+    lanes16 found = lanes_none();
+    alignas(16) uint8_t values[16];
+    // packed chunk voxels are not contiguous
+    voxel row[CHUNK_W];
+    for (int x = 0; x < CHUNK_W; x++) {
+        starts[x] = -1;
     }
-    assert(chunk->lightmap != nullptr);
-    auto& lightmap = *chunk->lightmap;
+    for (int y = lightmap.highestPoint; y >= 0; y--) {
+        int index = (y * CHUNK_D + z) * CHUNK_W;
+        if (y > 0) {
+            chunk.copyVoxels(row, index, index + CHUNK_W);
+        }
+        lanes16 passing = y == 0
+            ? lanes_all()
+            : lanes_gather(passingMasks, row);
+        lanes16 candidates = lanes_andnot(
+            lanes_andnot(passing, lanes_sky_full(lightmap.getRow(y, z))), found
+        );
+        if (!lanes_any(candidates)) {
+            continue;
+        }
+        lanes_store(values, candidates);
+        for (int x = 0; x < CHUNK_W; x++) {
+            if (values[x]) {
+                starts[x] = y;
+            }
+        }
+        found = lanes_or(found, candidates);
+        if (lanes_every(found)) {
+            break;
+        }
+    }
+}
 
+static void build_sky_light(
+    const ContentIndices& indices, Chunk& chunk, LightSolver& solverS
+) {
+    const uint8_t* passingMasks = indices.getLightPassingMasks();
+    int starts[CHUNK_W];
     for (int z = 0; z < CHUNK_D; z++){
+        scan_sky_light_row(passingMasks, chunk, z, starts);
         for (int x = 0; x < CHUNK_W; x++){
-            int gx = x + cx * CHUNK_W;
-            int gz = z + cz * CHUNK_D;
-            for (int y = lightmap.highestPoint; y >= 0; y--){
-                while (y > 0 && !blockDefs[chunk->voxels[vox_index(x, y, z)].id]->lightPassing) {
-                    y--;
-                }
-                if (lightmap.getS(x, y, z) != 15) {
-                    solverS->add(gx,y+1,gz);
-                    for (; y >= 0; y--){
-                        solverS->add(gx+1,y,gz);
-                        solverS->add(gx-1,y,gz);
-                        solverS->add(gx,y,gz+1);
-                        solverS->add(gx,y,gz-1);
-                    }
+            int y = starts[x];
+            if (y < 0) {
+                continue;
+            }
+            int gx = x + chunk.x * CHUNK_W;
+            int gz = z + chunk.z * CHUNK_D;
+            solverS.add(gx,y+1,gz);
+            for (; y >= 0; y--){
+                solverS.add(gx+1,y,gz);
+                solverS.add(gx-1,y,gz);
+                solverS.add(gx,y,gz+1);
+                solverS.add(gx,y,gz-1);
+            }
+        }
+    }
+}
+
+static void add_emission(
+    const Block* const* blockDefs,
+    const Chunk& chunk,
+    LightSolver& solverR,
+    LightSolver& solverG,
+    LightSolver& solverB
+) {
+    for (uint y = 0; y < CHUNK_H; y++){
+        int section = y / CHUNK_SECTION_H;
+        if (chunk.isSectionUniform(section) &&
+            !blockDefs[chunk.getSectionBlock(section)]->rt.emissive) {
+            // no light sources in the section
+            y = (section + 1) * CHUNK_SECTION_H - 1;
+            continue;
+        }
+        for (uint z = 0; z < CHUNK_D; z++){
+            for (uint x = 0; x < CHUNK_W; x++){
+                voxel vox = chunk.get(x, y, z);
+                const Block* block = blockDefs[vox.id];
+                int gx = x + chunk.x * CHUNK_W;
+                int gz = z + chunk.z * CHUNK_D;
+                if (block->rt.emissive){
+                    solverR.add(gx,y,gz,block->emission[0]);
+                    solverG.add(gx,y,gz,block->emission[1]);
+                    solverB.add(gx,y,gz,block->emission[2]);
                 }
             }
         }
     }
-    solverS->solve();
 }
 
+void Lighting::buildSkyLight(int cx, int cz){
+    Chunk* chunk = chunks.getChunk(cx, cz);
+    if (chunk == nullptr) {
+        logger.error() << "attempted to build sky lights to chunk missing in local matrix";
+        return;
+    }
+    assert(chunk->lightmap != nullptr);
+    build_sky_light(*content.getIndices(), *chunk, *solverS);
+    solverS->solve();
+}
 
 void Lighting::onChunkLoaded(int cx, int cz, bool expand) {
+    VC_PROFILE_ZONE("Lighting::onChunkLoaded");
     auto& solverR = *this->solverR;
     auto& solverG = *this->solverG;
     auto& solverB = *this->solverB;
@@ -119,21 +396,7 @@ void Lighting::onChunkLoaded(int cx, int cz, bool expand) {
     assert(chunk->lightmap != nullptr);
     auto& lightmap = *chunk->lightmap;
 
-    for (uint y = 0; y < CHUNK_H; y++){
-        for (uint z = 0; z < CHUNK_D; z++){
-            for (uint x = 0; x < CHUNK_W; x++){
-                const voxel& vox = chunk->voxels[(y * CHUNK_D + z) * CHUNK_W + x];
-                const Block* block = blockDefs[vox.id];
-                int gx = x + cx * CHUNK_W;
-                int gz = z + cz * CHUNK_D;
-                if (block->rt.emissive){
-                    solverR.add(gx,y,gz,block->emission[0]);
-                    solverG.add(gx,y,gz,block->emission[1]);
-                    solverB.add(gx,y,gz,block->emission[2]);
-                }
-            }
-        }
-    }
+    add_emission(blockDefs, *chunk, solverR, solverG, solverB);
 
     if (expand) {
         for (int x = 0; x < CHUNK_W; x += CHUNK_W-1) {
@@ -171,72 +434,176 @@ void Lighting::onChunkLoaded(int cx, int cz, bool expand) {
     solverG.solve(chunk);
     solverB.solve(chunk);
     solverS.solve(chunk);
+    lightmap.compact();
 }
 
-void Lighting::onBlockSet(int x, int y, int z, blockid_t id){
-    const auto& block = content.getIndices()->blocks.require(id);
-    solverR->remove(x,y,z);
-    solverG->remove(x,y,z);
-    solverB->remove(x,y,z);
-
-    if (id == 0){
-        auto chunk = chunks.getChunkByVoxel(glm::ivec3{x, y, z});
-        solverR->solve(chunk);
-        solverG->solve(chunk);
-        solverB->solve(chunk);
-        if (chunks.getLight(x,y+1,z, 3) == 0xF){
-            for (int i = y; i >= 0; i--){
-                voxel* vox = chunks.get(x,i,z);
-                if ((vox == nullptr || vox->id != 0) && block.skyLightPassing)
-                    break;
-                solverS->add(x,i,z, 0xF);
+bool Lighting::applyIsolatedLights(Chunk& chunk, const Lightmap& lights) {
+    if (chunks.getChunk(chunk.x, chunk.z) != &chunk) {
+        return false;
+    }
+    assert(chunk.lightmap != nullptr);
+    chunk.lightmap->merge(lights);
+
+    int cx = chunk.x;
+    int cz = chunk.z;
+    LightSolver* solvers[] {
+        solverR.get(), solverG.get(), solverB.get(), solverS.get()
+    };
+    int gx = cx * CHUNK_W;
+    int gz = cz * CHUNK_D;
+    // both sides of each border: chunk lights flow out, neighbours' in
+    for (int y = 0; y < CHUNK_H; y++) {
+        for (int z = 0; z < CHUNK_D; z++) {
+            for (auto solver : solvers) {
+                solver->add(gx, y, gz + z);
+                solver->add(gx - 1, y, gz + z);
+                solver->add(gx + CHUNK_W - 1, y, gz + z);
+                solver->add(gx + CHUNK_W, y, gz + z);
             }
         }
-        const int coords[] = {
-            0, 0, 1,
-            0, 0,-1,
-            0, 1, 0,
-            0,-1, 0,
-            1, 0, 0,
-            -1, 0, 0
-        };
-        for (int i = 0; i < 6; i++) {
-            int lx = x + coords[i * 3];
-            int ly = y + coords[i * 3 + 1];
-            int lz = z + coords[i * 3 + 2];
-
-            solverR->add(lx, ly, lz);
-            solverG->add(lx, ly, lz);
-            solverB->add(lx, ly, lz);
-            solverS->add(lx, ly, lz);
-            solverR->solve(chunk);
-            solverG->solve(chunk);
-            solverB->solve(chunk);
-            solverS->solve(chunk);
-        }
-    } else {
-        auto chunk = chunks.getChunkByVoxel(glm::ivec3{x, y, z});
-        if (!block.skyLightPassing){
-            solverS->remove(x,y,z);
-            for (int i = y-1; i >= 0; i--){
-                solverS->remove(x,i,z);
-                if (i == 0 || chunks.get(x,i-1,z)->id != 0){
+        for (int x = 0; x < CHUNK_W; x++) {
+            for (auto solver : solvers) {
+                solver->add(gx + x, y, gz);
+                solver->add(gx + x, y, gz - 1);
+                solver->add(gx + x, y, gz + CHUNK_D - 1);
+                solver->add(gx + x, y, gz + CHUNK_D);
+            }
+        }
+    }
+    for (auto solver : solvers) {
+        solver->solve(&chunk);
+    }
+    chunk.lightmap->compact();
+    return true;
+}
+
+static const glm::ivec3 BLOCK_SIDES[] {
+    {0, 0, 1}, {0, 0, -1}, {0, 1, 0}, {0, -1, 0}, {1, 0, 0}, {-1, 0, 0}
+};
+
+void Lighting::onBlockSet(int x, int y, int z) {
+    pendingChanges.emplace_back(x, y, z);
+}
+
+void Lighting::onBlocksSet(const std::vector<glm::ivec3>& positions) {
+    pendingChanges.insert(
+        pendingChanges.end(), positions.begin(), positions.end()
+    );
+}
+
+void Lighting::flush() {
+    if (pendingChanges.empty()) {
+        return;
+    }
+    // same position may be changed many times within a tick
+    std::sort(
+        pendingChanges.begin(),
+        pendingChanges.end(),
+        [](const glm::ivec3& a, const glm::ivec3& b) {
+            if (a.x != b.x) return a.x < b.x;
+            if (a.z != b.z) return a.z < b.z;
+            return a.y < b.y;
+        }
+    );
+    pendingChanges.erase(
+        std::unique(pendingChanges.begin(), pendingChanges.end()),
+        pendingChanges.end()
+    );
+    solveBlocksChanges(pendingChanges);
+    pendingChanges.clear();
+}
+
+void Lighting::solveBlocksChanges(const std::vector<glm::ivec3>& positions) {
+    VC_PROFILE_ZONE("Lighting::solveBlocksChanges");
+    const auto& blocks = content.getIndices()->blocks;
+    for (const auto& pos : positions) {
+        auto vox = chunks.getVoxel(pos.x, pos.y, pos.z);
+        if (!vox) {
+            continue;
+        }
+        solverR->remove(pos.x, pos.y, pos.z);
+        solverG->remove(pos.x, pos.y, pos.z);
+        solverB->remove(pos.x, pos.y, pos.z);
+        if (vox->id == 0 || blocks.require(vox->id).skyLightPassing) {
+            continue;
+        }
+        solverS->remove(pos.x, pos.y, pos.z);
+        for (int i = pos.y - 1; i >= 0; i--) {
+            solverS->remove(pos.x, i, pos.z);
+            auto below = chunks.getVoxel(pos.x, i - 1, pos.z);
+            if (!below || below->id != 0) {
+                break;
+            }
+        }
+    }
+    solverR->solve();
+    solverG->solve();
+    solverB->solve();
+    solverS->solve();
+
+    for (const auto& pos : positions) {
+        auto vox = chunks.getVoxel(pos.x, pos.y, pos.z);
+        if (!vox) {
+            continue;
+        }
+        if (vox->id != 0) {
+            const auto& block = blocks.require(vox->id);
+            if (block.rt.emissive) {
+                solverR->add(pos.x, pos.y, pos.z, block.emission[0]);
+                solverG->add(pos.x, pos.y, pos.z, block.emission[1]);
+                solverB->add(pos.x, pos.y, pos.z, block.emission[2]);
+            }
+            continue;
+        }
+        if (chunks.getLight(pos.x, pos.y + 1, pos.z, 3) == 0xF) {
+            for (int i = pos.y; i >= 0; i--) {
+                auto column = chunks.getVoxel(pos.x, i, pos.z);
+                if (!column || column->id != 0) {
                     break;
                 }
+                solverS->add(pos.x, i, pos.z, 0xF);
             }
-            solverS->solve(chunk);
         }
-        solverR->solve(chunk);
-        solverG->solve(chunk);
-        solverB->solve(chunk);
-
-        if (block.emission[0] || block.emission[1] || block.emission[2]){
-            solverR->add(x,y,z,block.emission[0]);
-            solverG->add(x,y,z,block.emission[1]);
-            solverB->add(x,y,z,block.emission[2]);
-            solverR->solve(chunk);
-            solverG->solve(chunk);
-            solverB->solve(chunk);
+        for (const auto& offset : BLOCK_SIDES) {
+            auto side = pos + offset;
+            solverR->add(side.x, side.y, side.z);
+            solverG->add(side.x, side.y, side.z);
+            solverB->add(side.x, side.y, side.z);
+            solverS->add(side.x, side.y, side.z);
         }
     }
+    solverR->solve();
+    solverG->solve();
+    solverB->solve();
+    solverS->solve();
+}
+
+IsolatedLighting::IsolatedLighting(const ContentIndices& indices)
+    : indices(indices),
+      solverR(std::make_unique<LightSolver>(indices, 0)),
+      solverG(std::make_unique<LightSolver>(indices, 1)),
+      solverB(std::make_unique<LightSolver>(indices, 2)),
+      solverS(std::make_unique<LightSolver>(indices, 3)) {
+}
+
+IsolatedLighting::~IsolatedLighting() = default;
+
+void IsolatedLighting::build(Chunk& chunk, bool buildSky) {
+    assert(chunk.lightmap != nullptr);
+    const auto blockDefs = indices.blocks.getDefs();
+
+    LightSolver* solvers[] {
+        solverR.get(), solverG.get(), solverB.get(), solverS.get()
+    };
+    for (auto solver : solvers) {
+        solver->setIsolatedChunk(&chunk);
+    }
+    if (buildSky) {
+        build_sky_light(indices, chunk, *solverS);
+    }
+    add_emission(blockDefs, chunk, *solverR, *solverG, *solverB);
+    for (auto solver : solvers) {
+        solver->solve(&chunk);
+        solver->setIsolatedChunk(nullptr);
+    }
 }
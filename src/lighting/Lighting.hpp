@@ -1,5 +1,10 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
 #include "typedefs.hpp"
 
 class Content;
@@ -7,6 +12,7 @@ class ContentIndices;
 class Chunk;
 class Chunks;
 class LightSolver;
+class Lightmap;
 
 class Lighting {
     const Content& content;
@@ -15,6 +21,12 @@ class Lighting {
     std::unique_ptr<LightSolver> solverG;
     std::unique_ptr<LightSolver> solverB;
     std::unique_ptr<LightSolver> solverS;
+    /// @brief Positions of blocks changed since the last flush
+    std::vector<glm::ivec3> pendingChanges;
+
+    /// @brief Update lights after blocks change. Lights removal and
+    /// propagation are solved once for all the positions
+    void solveBlocksChanges(const std::vector<glm::ivec3>& positions);
 public:
     Lighting(const Content& content, Chunks& chunks);
     ~Lighting();
@@ -22,7 +34,41 @@ public:
     void clear();
     void buildSkyLight(int cx, int cz);
     void onChunkLoaded(int cx, int cz, bool expand);
-    void onBlockSet(int x, int y, int z, blockid_t id);
+
+    /// @brief Queue lights update of the changed block (solved by flush)
+    void onBlockSet(int x, int y, int z);
+
+    /// @brief Queue lights update of the changed blocks (solved by flush)
+    /// @param positions positions of the changed blocks
+    void onBlocksSet(const std::vector<glm::ivec3>& positions);
+
+    /// @brief Solve all queued blocks changes at once. Chunks affected are
+    /// marked modified by the combined solve only
+    void flush();
+
+    /// @brief Merge lights built with IsolatedLighting into the chunk and
+    /// propagate them across the chunk borders
+    /// @param chunk target chunk
+    /// @param lights lightmap built for a copy of the chunk
+    /// @return false if the chunk is not present in the local matrix
+    bool applyIsolatedLights(Chunk& chunk, const Lightmap& lights);
 
     static void prebuildSkyLight(Chunk& chunk, const ContentIndices& indices);
 };
+
+/// @brief Builds initial chunk sky and emission lights without access to
+/// the neighbour chunks. Instance may be used in any single thread.
+class IsolatedLighting {
+    const ContentIndices& indices;
+    std::unique_ptr<LightSolver> solverR;
+    std::unique_ptr<LightSolver> solverG;
+    std::unique_ptr<LightSolver> solverB;
+    std::unique_ptr<LightSolver> solverS;
+public:
+    IsolatedLighting(const ContentIndices& indices);
+    ~IsolatedLighting();
+
+    /// @param chunk target chunk, must not be accessed by other threads
+    /// @param buildSky build sky light (false if loaded from cache)
+    void build(Chunk& chunk, bool buildSky);
+};
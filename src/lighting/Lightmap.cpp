@@ -2,31 +2,165 @@
 
 #include "util/data_io.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
+static_assert(
+    CHUNK_VOL == CHUNK_SECTION_VOL * CHUNK_SECTIONS,
+    "sections must be contiguous parts of the chunk volume"
+);
+
+light_t* Lightmap::densify(int section) {
+    auto data = std::make_unique<light_t[]>(CHUNK_SECTION_VOL);
+    std::fill_n(data.get(), CHUNK_SECTION_VOL, uniforms[section][0]);
+    sections[section] = std::move(data);
+    return sections[section].get();
+}
+
+void Lightmap::compactSection(int section) {
+    const light_t* data = sections[section].get();
+    if (data == nullptr) {
+        return;
+    }
+    light_t value = data[0];
+    for (int i = 1; i < CHUNK_SECTION_VOL; i++) {
+        if (data[i] != value) {
+            return;
+        }
+    }
+    setUniform(section, value);
+}
+
+void Lightmap::compact() {
+    for (int i = 0; i < CHUNK_SECTIONS; i++) {
+        compactSection(i);
+    }
+}
+
+int Lightmap::countDenseSections() const {
+    int count = 0;
+    for (const auto& section : sections) {
+        count += section != nullptr;
+    }
+    return count;
+}
+
+void Lightmap::fill(light_t value) {
+    for (int i = 0; i < CHUNK_SECTIONS; i++) {
+        setUniform(i, value);
+    }
+}
+
+void Lightmap::orSection(int section, light_t bits) {
+    if (light_t* data = sections[section].get()) {
+        for (int i = 0; i < CHUNK_SECTION_VOL; i++) {
+            data[i] |= bits;
+        }
+    } else {
+        uniforms[section].fill(uniforms[section][0] | bits);
+    }
+}
+
 void Lightmap::set(const Lightmap* lightmap) {
-    set(lightmap->map);
+    for (int i = 0; i < CHUNK_SECTIONS; i++) {
+        const light_t* src = lightmap->sections[i].get();
+        if (src == nullptr) {
+            setUniform(i, lightmap->uniforms[i][0]);
+            continue;
+        }
+        light_t* dst = sections[i] ? sections[i].get() : densify(i);
+        std::memcpy(dst, src, sizeof(light_t) * CHUNK_SECTION_VOL);
+    }
 }
 
 void Lightmap::set(const light_t* map) {
-    std::memcpy(this->map, map, sizeof(light_t) * CHUNK_VOL);
+    for (int i = 0; i < CHUNK_SECTIONS; i++) {
+        light_t* dst = sections[i] ? sections[i].get() : densify(i);
+        std::memcpy(
+            dst, map + i * CHUNK_SECTION_VOL, sizeof(light_t) * CHUNK_SECTION_VOL
+        );
+        compactSection(i);
+    }
+}
+
+static inline light_t max_channels(light_t a, light_t b) {
+    return Lightmap::combine(
+        std::max(Lightmap::extract(a, 0), Lightmap::extract(b, 0)),
+        std::max(Lightmap::extract(a, 1), Lightmap::extract(b, 1)),
+        std::max(Lightmap::extract(a, 2), Lightmap::extract(b, 2)),
+        std::max(Lightmap::extract(a, 3), Lightmap::extract(b, 3))
+    );
+}
+
+void Lightmap::merge(const Lightmap& other) {
+    for (int section = 0; section < CHUNK_SECTIONS; section++) {
+        const light_t* src = other.sections[section].get();
+        light_t* dst = sections[section].get();
+        if (src == nullptr) {
+            light_t b = other.uniforms[section][0];
+            if (dst == nullptr) {
+                uniforms[section].fill(max_channels(uniforms[section][0], b));
+                continue;
+            }
+            if (b == 0) {
+                continue;
+            }
+            for (int i = 0; i < CHUNK_SECTION_VOL; i++) {
+                dst[i] = max_channels(dst[i], b);
+            }
+            continue;
+        }
+        if (dst == nullptr) {
+            dst = densify(section);
+        }
+        for (int i = 0; i < CHUNK_SECTION_VOL; i++) {
+            light_t a = dst[i];
+            light_t b = src[i];
+            if (a != b) {
+                dst[i] = max_channels(a, b);
+            }
+        }
+    }
 }
 
 static_assert(sizeof(light_t) == 2, "replace dataio calls to new light_t");
 
 std::unique_ptr<ubyte[]> Lightmap::encode() const {
     auto buffer = std::make_unique<ubyte[]>(LIGHTMAP_DATA_LEN);
-    for (uint i = 0; i < CHUNK_VOL; i+=2) {
-        buffer[i/2] = ((map[i] >> 12) & 0xF) | ((map[i+1] >> 8) & 0xF0);
+    for (int section = 0; section < CHUNK_SECTIONS; section++) {
+        ubyte* dst = buffer.get() + section * CHUNK_SECTION_VOL / 2;
+        const light_t* src = sections[section].get();
+        if (src == nullptr) {
+            ubyte s = (uniforms[section][0] >> 12) & 0xF;
+            std::memset(dst, s | (s << 4), CHUNK_SECTION_VOL / 2);
+            continue;
+        }
+        for (int i = 0; i < CHUNK_SECTION_VOL; i += 2) {
+            dst[i / 2] = ((src[i] >> 12) & 0xF) | ((src[i + 1] >> 8) & 0xF0);
+        }
     }
     return buffer;
 }
 
 void Lightmap::decode(const ubyte* src) {
-    for (uint i = 0; i < CHUNK_VOL; i+=2) {
-        ubyte b = src[i/2];
-        map[i] = ((b & 0xF) << 12);
-        map[i+1] = ((b & 0xF0) << 8);
-    } 
+    for (int section = 0; section < CHUNK_SECTIONS; section++) {
+        const ubyte* bytes = src + section * CHUNK_SECTION_VOL / 2;
+        ubyte first = bytes[0];
+        bool uniform = (first & 0xF) == (first >> 4);
+        for (int i = 1; uniform && i < CHUNK_SECTION_VOL / 2; i++) {
+            uniform = bytes[i] == first;
+        }
+        if (uniform) {
+            setUniform(section, (first & 0xF) << 12);
+            continue;
+        }
+        light_t* dst = sections[section] ? sections[section].get()
+                                         : densify(section);
+        for (int i = 0; i < CHUNK_SECTION_VOL; i += 2) {
+            ubyte b = bytes[i / 2];
+            dst[i] = ((b & 0xF) << 12);
+            dst[i + 1] = ((b & 0xF0) << 8);
+        }
+    }
 }
@@ -3,81 +3,158 @@
 #include "constants.hpp"
 #include "typedefs.hpp"
 
+#include <array>
 #include <memory>
-#include <cstring>
 #include <glm/vec4.hpp>
 
 inline constexpr int LIGHTMAP_DATA_LEN = CHUNK_VOL/2;
 
-// Lichtkarte
+/// @brief Chunk lights storage split into CHUNK_SECTIONS sections.
+/// Section is stored as a single value until a voxel of it gets a
+/// different light (sky above the terrain, dark underground), then
+/// section storage is allocated. Call compact() after lights building
+/// to release sections turned uniform.
 class Lightmap {
+    using section_data = std::unique_ptr<light_t[]>;
+
+    /// @brief Dense sections storage (nullptr - uniform section)
+    std::array<section_data, CHUNK_SECTIONS> sections;
+    /// @brief Uniform section value repeated to provide rows pointers
+    std::array<std::array<light_t, CHUNK_W>, CHUNK_SECTIONS> uniforms {};
+
+    static constexpr int section_index(int x, int y, int z) {
+        return ((y % CHUNK_SECTION_H) * CHUNK_D + z) * CHUNK_W + x;
+    }
+
+    /// @brief Allocate section storage filled with its uniform value
+    light_t* densify(int section);
+
+    /// @brief Release section storage if all values are same
+    void compactSection(int section);
+
+    void setUniform(int section, light_t value) {
+        sections[section].reset();
+        uniforms[section].fill(value);
+    }
+
+    inline void write(int x, int y, int z, light_t value) {
+        int section = y / CHUNK_SECTION_H;
+        light_t* data = sections[section].get();
+        if (data == nullptr) {
+            if (uniforms[section][0] == value) {
+                return;
+            }
+            data = densify(section);
+        }
+        data[section_index(x, y, z)] = value;
+    }
 public:
-    light_t map[CHUNK_VOL] {};
     int highestPoint = 0;
 
+    /// @brief Copy lights of other lightmap
     void set(const Lightmap* lightmap);
 
+    /// @brief Copy lights from dense CHUNK_VOL array
     void set(const light_t* map);
 
+    /// @brief Set each channel of each voxel to maximum of own and the
+    /// other lightmap values
+    void merge(const Lightmap& other);
+
+    /// @brief Set all lights to zero releasing sections storage
     void clear() {
-        std::memset(map, 0, sizeof(map));
+        fill(0);
     }
 
-    inline unsigned short get(int x, int y, int z) const {
-        return (map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x]);
+    /// @brief Set all lights to the value releasing sections storage
+    void fill(light_t value);
+
+    /// @brief Bitwise OR all section lights with the value
+    void orSection(int section, light_t bits);
+
+    /// @brief Release storage of sections having all lights same
+    void compact();
+
+    /// @return true if section has no dense storage
+    bool isSectionUniform(int section) const {
+        return sections[section] == nullptr;
+    }
+
+    /// @return number of sections having dense storage
+    int countDenseSections() const;
+
+    inline light_t get(int x, int y, int z) const {
+        int section = y / CHUNK_SECTION_H;
+        const light_t* data = sections[section].get();
+        return data ? data[section_index(x, y, z)] : uniforms[section][0];
     }
 
     inline unsigned char get(int x, int y, int z, int channel) const {
-        return (map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x] >> (channel << 2)) & 0xF;
+        return extract(get(x, y, z), channel);
     }
 
     inline unsigned char getR(int x, int y, int z) const {
-        return map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x] & 0xF;
+        return get(x, y, z) & 0xF;
     }
 
     inline unsigned char getG(int x, int y, int z) const {
-        return (map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x] >> 4) & 0xF;
+        return (get(x, y, z) >> 4) & 0xF;
     }
 
     inline unsigned char getB(int x, int y, int z) const {
-        return (map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x] >> 8) & 0xF;
+        return (get(x, y, z) >> 8) & 0xF;
     }
 
     inline unsigned char getS(int x, int y, int z) const {
-        return (map[y*CHUNK_D*CHUNK_W+z*CHUNK_W+x] >> 12) & 0xF;
+        return (get(x, y, z) >> 12) & 0xF;
+    }
+
+    /// @brief Get CHUNK_W lights of the row
+    /// @attention pointer is invalidated by the lightmap modification
+    inline const light_t* getRow(int y, int z) const {
+        int section = y / CHUNK_SECTION_H;
+        const light_t* data = sections[section].get();
+        if (data == nullptr) {
+            return uniforms[section].data();
+        }
+        return data + section_index(0, y, z);
+    }
+
+    /// @brief Get writeable CHUNK_W lights of the row allocating
+    /// section storage if needed
+    inline light_t* getRowWriteable(int y, int z) {
+        int section = y / CHUNK_SECTION_H;
+        light_t* data = sections[section].get();
+        if (data == nullptr) {
+            data = densify(section);
+        }
+        return data + section_index(0, y, z);
     }
 
     inline void setR(int x, int y, int z, int value){
-        const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
-        map[index] = (map[index] & 0xFFF0) | value;
+        write(x, y, z, (get(x, y, z) & 0xFFF0) | value);
     }
 
     inline void setG(int x, int y, int z, int value){
-        const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
-        map[index] = (map[index] & 0xFF0F) | (value << 4);
+        write(x, y, z, (get(x, y, z) & 0xFF0F) | (value << 4));
     }
 
     inline void setB(int x, int y, int z, int value){
-        const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
-        map[index] = (map[index] & 0xF0FF) | (value << 8);
+        write(x, y, z, (get(x, y, z) & 0xF0FF) | (value << 8));
     }
 
     inline void setS(int x, int y, int z, int value){
-        const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
-        map[index] = (map[index] & 0x0FFF) | (value << 12);
+        write(x, y, z, (get(x, y, z) & 0x0FFF) | (value << 12));
     }
 
     inline void set(int x, int y, int z, int channel, int value){
-        const int index = y*CHUNK_D*CHUNK_W+z*CHUNK_W+x;
-        map[index] = (map[index] & (0xFFFF & (~(0xF << (channel*4))))) | (value << (channel << 2));
-    }
-
-    inline const light_t* getLights() const {
-        return map;
-    }
-
-    inline light_t* getLightsWriteable() {
-        return map;
+        write(
+            x,
+            y,
+            z,
+            (get(x, y, z) & (0xFFFF & (~(0xF << (channel * 4))))) |
+                (value << (channel << 2))
+        );
     }
 
     static constexpr light_t combine(int r, int g, int b, int s) {
@@ -1,32 +1,76 @@
 #include "BlocksController.hpp"
 
+#include <algorithm>
+#include <thread>
+
+#include "CellularSimulation.hpp"
 #include "content/Content.hpp"
+#include "debug/Profiler.hpp"
 #include "items/Inventories.hpp"
 #include "items/Inventory.hpp"
 #include "lighting/Lighting.hpp"
 #include "maths/fastmaths.hpp"
 #include "scripting/scripting.hpp"
+#include "util/ThreadPool.hpp"
 #include "util/timeutil.hpp"
 #include "voxels/Block.hpp"
+#include "voxels/BlocksBatch.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/Chunks.hpp"
 #include "voxels/voxel.hpp"
 #include "voxels/blocks_agent.hpp"
 #include "world/Level.hpp"
+#include "world/LevelEvents.hpp"
+#include "world/SimulationArea.hpp"
 #include "world/World.hpp"
+#include "objects/Entities.hpp"
 #include "objects/Player.hpp"
 #include "objects/Players.hpp"
 
-BlocksController::BlocksController(const Level& level, Lighting* lighting)
+/// @brief Scheduled updates timer wheel slots number
+inline constexpr size_t SCHEDULED_WHEEL_SLOTS = 256;
+/// @brief Max scheduled updates called per tick, the rest is delayed
+inline constexpr size_t MAX_SCHEDULED_UPDATES_PER_TICK = 4096;
+
+BlocksController::BlocksController(Level& level, Lighting* lighting)
     : level(level),
+      worldInfo(level.getWorld()->getInfo()),
       chunks(*level.chunks),
       lighting(lighting),
       randTickClock(20, 3),
       blocksTickClock(20, 3),
-      worldTickClock(20, 1) {
+      worldTickClock(20, 1),
+      scheduledWheel(SCHEDULED_WHEEL_SLOTS),
+      cellular(std::make_unique<CellularSimulation>(
+          *level.content.getIndices(),
+          [this](int cx, int cz) { return chunks.getChunk(cx, cz); }
+      )),
+      cellularBatch(std::make_unique<BlocksBatch>()) {
+    level.events->listen(
+        LevelEventType::CHUNK_PRESENT,
+        [this](auto, Chunk* chunk) {
+            for (const auto& update : chunk->scheduledUpdates) {
+                enqueueScheduled(*chunk, update);
+            }
+        }
+    );
+}
+
+BlocksController::~BlocksController() = default;
+
+void BlocksController::wakeEntities(
+    const glm::ivec3& min, const glm::ivec3& max
+) {
+    if (level.entities) {
+        level.entities->wakeInside(
+            AABB(glm::vec3(min - 1), glm::vec3(max + 2))
+        );
+    }
 }
 
 void BlocksController::updateSides(int x, int y, int z) {
+    wakeEntities({x, y, z}, {x, y, z});
+    cellular->activate(x, y, z);
     updateBlock(x - 1, y, z);
     updateBlock(x + 1, y, z);
     updateBlock(x, y - 1, z);
@@ -36,12 +80,14 @@ void BlocksController::updateSides(int x, int y, int z) {
 }
 
 void BlocksController::updateSides(int x, int y, int z, int w, int h, int d) {
-    voxel* vox = blocks_agent::get(chunks, x, y, z);
+    auto vox = blocks_agent::get_voxel(chunks, x, y, z);
     const auto& def = level.content.getIndices()->blocks.require(vox->id);
     const auto& rot = def.rotations.variants[vox->state.rotation];
     const auto& xaxis = rot.axes[0];
     const auto& yaxis = rot.axes[1];
     const auto& zaxis = rot.axes[2];
+    int maxSize = std::max(w, std::max(h, d));
+    wakeEntities(glm::ivec3(x, y, z) - maxSize, glm::ivec3(x, y, z) + maxSize);
     for (int ly = -1; ly <= h; ly++) {
         for (int lz = -1; lz <= d; lz++) {
             for (int lx = -1; lx <= w; lx++) {
@@ -66,7 +112,7 @@ void BlocksController::breakBlock(
     );
     blocks_agent::set(chunks, x, y, z, 0, {});
     if (lighting) {
-        lighting->onBlockSet(x, y, z, 0);
+        lighting->onBlockSet(x, y, z);
     }
     scripting::on_block_broken(player, def, glm::ivec3(x, y, z));
     if (def.rt.extended) {
@@ -91,7 +137,7 @@ void BlocksController::placeBlock(
     );
     blocks_agent::set(chunks, x, y, z, def.rt.id, state);
     if (lighting) {
-        lighting->onBlockSet(x, y, z, def.rt.id);
+        lighting->onBlockSet(x, y, z);
     }
     scripting::on_block_placed(player, def, glm::ivec3(x, y, z));
     if (def.rt.extended) {
@@ -101,10 +147,79 @@ void BlocksController::placeBlock(
     }
 }
 
+size_t BlocksController::applyBatch(
+    BlocksBatch& batch, bool updateNeighbours
+) {
+    VC_PROFILE_ZONE("BlocksController::applyBatch");
+    const auto& indices = level.content.getIndices()->blocks;
+    batch.sortByChunks();
+
+    std::vector<glm::ivec3> changed;
+    changed.reserve(batch.size());
+    glm::ivec3 min {};
+    glm::ivec3 max {};
+    for (const auto& entry : batch.getEntries()) {
+        const auto& pos = entry.pos;
+        auto vox = blocks_agent::get_voxel(chunks, pos.x, pos.y, pos.z);
+        if (!vox || entry.id >= indices.count()) {
+            continue;
+        }
+        if (vox->id == entry.id &&
+            blockstate2int(vox->state) == blockstate2int(entry.state)) {
+            continue;
+        }
+        blocks_agent::set(chunks, pos.x, pos.y, pos.z, entry.id, entry.state);
+        if (changed.empty()) {
+            min = max = pos;
+        }
+        min = glm::min(min, pos);
+        max = glm::max(max, pos);
+        changed.push_back(pos);
+        cellular->activate(pos.x, pos.y, pos.z);
+    }
+    batch.clear();
+    if (changed.empty()) {
+        return 0;
+    }
+    if (lighting) {
+        lighting->onBlocksSet(changed);
+    }
+    wakeEntities(min, max);
+    if (updateNeighbours) {
+        static const glm::ivec3 sides[] {
+            {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}
+        };
+        std::vector<glm::ivec3> neighbours;
+        neighbours.reserve(changed.size() * 6);
+        for (const auto& pos : changed) {
+            for (const auto& side : sides) {
+                neighbours.push_back(pos + side);
+            }
+        }
+        auto less = [](const glm::ivec3& a, const glm::ivec3& b) {
+            if (a.y != b.y) return a.y < b.y;
+            if (a.z != b.z) return a.z < b.z;
+            return a.x < b.x;
+        };
+        std::sort(neighbours.begin(), neighbours.end(), less);
+        neighbours.erase(
+            std::unique(neighbours.begin(), neighbours.end()), neighbours.end()
+        );
+        for (const auto& pos : neighbours) {
+            updateBlock(pos.x, pos.y, pos.z);
+        }
+    }
+    scripting::on_blocks_batch(min, max, changed.size());
+    return changed.size();
+}
+
 void BlocksController::updateBlock(int x, int y, int z) {
-    voxel* vox = blocks_agent::get(chunks, x, y, z);
-    if (vox == nullptr) return;
+    auto vox = blocks_agent::get_voxel(chunks, x, y, z);
+    if (!vox) return;
     const auto& def = level.content.getIndices()->blocks.require(vox->id);
+    if (def.cellular.type != CellularType::NONE) {
+        cellular->activate(x, y, z);
+    }
     if (def.grounded) {
         const auto& vec = get_ground_direction(def, vox->state.rotation);
         if (!blocks_agent::is_solid_at(chunks, x + vec.x, y + vec.y, z + vec.z)) {
@@ -118,6 +233,7 @@ void BlocksController::updateBlock(int x, int y, int z) {
 }
 
 void BlocksController::update(float delta, uint padding) {
+    VC_PROFILE_ZONE("BlocksController::update");
     if (randTickClock.update(delta)) {
         randomTick(randTickClock.getPart(), randTickClock.getParts(), padding);
     }
@@ -125,6 +241,8 @@ void BlocksController::update(float delta, uint padding) {
         onBlocksTick(blocksTickClock.getTickId(), blocksTickClock.getParts());
     }
     if (worldTickClock.update(delta)) {
+        scheduledTick();
+        cellularTick();
         scripting::on_world_tick(worldTickClock.getTickRate());
     }
 }
@@ -142,42 +260,254 @@ void BlocksController::onBlocksTick(int tickid, int parts) {
     }
 }
 
-void BlocksController::randomTick(
-    const Chunk& chunk, int segments, const ContentIndices* indices
+void BlocksController::cellularTick() {
+    cellular->step(worldInfo.ticks, *cellularBatch);
+    if (!cellularBatch->empty()) {
+        applyBatch(*cellularBatch, true);
+    }
+}
+
+void BlocksController::enqueueScheduled(
+    const Chunk& chunk, const ScheduledUpdate& update
+) {
+    // updates overdue while the chunk was unloaded are called on next tick
+    uint64_t tick = std::max(update.tick, worldInfo.ticks + 1);
+    scheduledWheel[tick % SCHEDULED_WHEEL_SLOTS].push_back(
+        ScheduledUpdateEntry {chunk.x, chunk.z, update.index, update.tick}
+    );
+}
+
+bool BlocksController::scheduleUpdate(int x, int y, int z, uint delay) {
+    if (y < 0 || y >= CHUNK_H) {
+        return false;
+    }
+    auto chunk = blocks_agent::get_chunk(
+        chunks, floordiv<CHUNK_W>(x), floordiv<CHUNK_D>(z)
+    );
+    if (chunk == nullptr) {
+        return false;
+    }
+    uint index = vox_index(
+        x - chunk->x * CHUNK_W, y, z - chunk->z * CHUNK_D
+    );
+    uint64_t tick = worldInfo.ticks + std::max(delay, 1U);
+    auto& updates = chunk->scheduledUpdates;
+    auto found = std::find_if(
+        updates.begin(), updates.end(),
+        [index](const auto& update) { return update.index == index; }
+    );
+    if (found != updates.end()) {
+        if (found->tick <= tick) {
+            return true;
+        }
+        // previous wheel entry becomes invalid
+        found->tick = tick;
+    } else {
+        updates.push_back(ScheduledUpdate {index, tick});
+    }
+    chunk->flags.scheduledUpdates = true;
+    enqueueScheduled(*chunk, ScheduledUpdate {index, tick});
+    return true;
+}
+
+bool BlocksController::cancelUpdate(int x, int y, int z) {
+    if (y < 0 || y >= CHUNK_H) {
+        return false;
+    }
+    auto chunk = blocks_agent::get_chunk(
+        chunks, floordiv<CHUNK_W>(x), floordiv<CHUNK_D>(z)
+    );
+    if (chunk == nullptr) {
+        return false;
+    }
+    uint index = vox_index(
+        x - chunk->x * CHUNK_W, y, z - chunk->z * CHUNK_D
+    );
+    auto& updates = chunk->scheduledUpdates;
+    auto found = std::find_if(
+        updates.begin(), updates.end(),
+        [index](const auto& update) { return update.index == index; }
+    );
+    if (found == updates.end()) {
+        return false;
+    }
+    // wheel entry is skipped as not found in the chunk
+    *found = updates.back();
+    updates.pop_back();
+    chunk->flags.scheduledUpdates = true;
+    return true;
+}
+
+void BlocksController::scheduledTick() {
+    uint64_t tick = ++worldInfo.ticks;
+    auto& slot = scheduledWheel[tick % SCHEDULED_WHEEL_SLOTS];
+    if (slot.empty()) {
+        return;
+    }
+    VC_PROFILE_ZONE("BlocksController::scheduledTick");
+    const auto& indices = level.content.getIndices()->blocks;
+    // callbacks may schedule new updates to the same slot
+    std::swap(slot, scheduledSlot);
+
+    size_t called = 0;
+    for (const auto& entry : scheduledSlot) {
+        if (entry.tick > tick || called >= MAX_SCHEDULED_UPDATES_PER_TICK) {
+            // next wheel turn or delayed to the next tick
+            uint64_t next = std::max(entry.tick, tick + 1);
+            scheduledWheel[next % SCHEDULED_WHEEL_SLOTS].push_back(entry);
+            continue;
+        }
+        // unloaded chunk updates are enqueued again when it's present
+        auto chunk = blocks_agent::get_chunk(chunks, entry.chunkX, entry.chunkZ);
+        if (chunk == nullptr) {
+            continue;
+        }
+        auto& updates = chunk->scheduledUpdates;
+        auto found = std::find_if(
+            updates.begin(), updates.end(),
+            [&entry](const auto& update) {
+                return update.index == entry.index && update.tick == entry.tick;
+            }
+        );
+        if (found == updates.end()) {
+            // cancelled or rescheduled
+            continue;
+        }
+        *found = updates.back();
+        updates.pop_back();
+        chunk->flags.scheduledUpdates = true;
+
+        const auto& def = indices.require(chunk->get(entry.index).id);
+        if (!def.rt.funcsset.scheduledupdate) {
+            continue;
+        }
+        int lx = entry.index % CHUNK_W;
+        int lz = entry.index / CHUNK_W % CHUNK_D;
+        int y = entry.index / (CHUNK_W * CHUNK_D);
+        scripting::scheduled_update_block(
+            def, {chunk->x * CHUNK_W + lx, y, chunk->z * CHUNK_D + lz}
+        );
+        called++;
+    }
+    scheduledSlot.clear();
+}
+
+static bool has_random_update(const Block& def) {
+    return def.rt.funcsset.randupdate || def.rt.funcsset.randupdates;
+}
+
+/// @brief Check if y range of the chunk may contain randomly updated blocks
+static bool has_random_updates(
+    const Chunk& chunk, const ContentIndices& indices, int bottom, int top
+) {
+    for (int y = bottom; y < top; y += CHUNK_SECTION_H) {
+        int section = y / CHUNK_SECTION_H;
+        if (!chunk.isSectionUniform(section) ||
+            has_random_update(
+                indices.blocks.require(chunk.getSectionBlock(section))
+            )) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @brief Min chunks processed by a random tick worker
+inline constexpr size_t RANDOM_TICK_JOB_MIN_CHUNKS = 128;
+/// @brief Chunk height segments sampled by random tick
+inline constexpr int RANDOM_TICK_SEGMENTS = 4;
+/// @brief Random blocks selected per chunk segment
+inline constexpr int RANDOM_TICK_SAMPLES = 4;
+
+/// @brief Select random blocks having random update callbacks
+static void select_random_updates(
+    const RandomTickJob& job, const ContentIndices& indices
 ) {
-    const int segheight = CHUNK_H / segments;
+    constexpr int segheight = CHUNK_H / RANDOM_TICK_SEGMENTS;
+    FastRandom random;
+    random.setSeed(job.seed);
+    auto& candidates = *job.candidates;
+    candidates.clear();
 
-    for (int s = 0; s < segments; s++) {
-        for (int i = 0; i < 4; i++) {
+    for (size_t c = 0; c < job.count; c++) {
+        const Chunk& chunk = *job.chunks[c];
+        for (int s = 0; s < RANDOM_TICK_SEGMENTS; s++) {
             int segmentY = s * segheight;
-            if (segmentY  > chunk.top) {
+            if (segmentY > chunk.top) {
                 break;
             }
-            int bx = random.rand() % CHUNK_W;
-            int by = random.rand() % segheight + segmentY;
-            int bz = random.rand() % CHUNK_D;
-            const voxel& vox = chunk.voxels[vox_index(bx, by, bz)];
-            auto& block = indices->blocks.require(vox.id);
-            if (block.rt.funcsset.randupdate) {
-                scripting::random_update_block(
-                    block,
-                    glm::ivec3(
-                        chunk.x * CHUNK_W + bx, by, chunk.z * CHUNK_D + bz
-                    )
-                );
+            if (!has_random_updates(
+                    chunk, indices, segmentY, segmentY + segheight
+                )) {
+                continue;
             }
+            for (int i = 0; i < RANDOM_TICK_SAMPLES; i++) {
+                int bx = random.rand() % CHUNK_W;
+                int by = random.rand() % segheight + segmentY;
+                int bz = random.rand() % CHUNK_D;
+                voxel vox = chunk.get(bx, by, bz);
+                if (!has_random_update(indices.blocks.require(vox.id))) {
+                    continue;
+                }
+                candidates.push_back(RandomTickCandidate {
+                    {chunk.x * CHUNK_W + bx, by, chunk.z * CHUNK_D + bz},
+                    vox.id});
+            }
+        }
+    }
+}
+
+class RandomTickWorker : public util::Worker<RandomTickJob, size_t> {
+    const ContentIndices& indices;
+public:
+    RandomTickWorker(const ContentIndices& indices) : indices(indices) {
+    }
+
+    size_t operator()(const RandomTickJob& job) override {
+        select_random_updates(job, indices);
+        return job.count;
+    }
+};
+
+void BlocksController::dispatchRandomUpdates(
+    const std::vector<RandomTickCandidate>& candidates
+) {
+    const auto& indices = level.content.getIndices()->blocks;
+    for (const auto& candidate : candidates) {
+        const auto& pos = candidate.pos;
+        // previous callbacks may have changed the block
+        auto vox = blocks_agent::get_voxel(chunks, pos.x, pos.y, pos.z);
+        if (!vox || vox->id != candidate.id) {
+            continue;
+        }
+        auto& block = indices.require(vox->id);
+        if (block.rt.funcsset.randupdates) {
+            // delivered once per block type at the end of the tick
+            if (randomUpdates.size() <= vox->id) {
+                randomUpdates.resize(indices.count());
+            }
+            auto& positions = randomUpdates[vox->id];
+            if (positions.empty()) {
+                randomUpdated.push_back(vox->id);
+            }
+            positions.push_back(pos);
+        } else if (block.rt.funcsset.randupdate) {
+            scripting::random_update_block(block, pos);
         }
     }
 }
 
 void BlocksController::randomTick(int tickid, int parts, uint padding) {
+    VC_PROFILE_ZONE("BlocksController::randomTick");
     auto indices = level.content.getIndices();
+    const auto& simulation = *level.simulation;
+    uint64_t cycle = randomTickId / parts;
 
+    randomTickChunks.clear();
     for (const auto& [pid, player] : *level.players) {
         const auto& chunks = *player->chunks;
         int width = chunks.getWidth();
         int height = chunks.getHeight();
-        int segments = 4;
 
         for (uint z = padding; z < height - padding; z++) {
             for (uint x = padding; x < width - padding; x++) {
@@ -185,18 +515,81 @@ void BlocksController::randomTick(int tickid, int parts, uint padding) {
                 if ((index + tickid) % parts != 0) {
                     continue;
                 }
-                auto& chunk = chunks.getChunks()[index];
+                auto& chunk = chunks.getChunkLocal(x, z);
                 if (chunk == nullptr || !chunk->flags.ready) {
                     continue;
                 }
+                // chunk is in the area of another player too
                 if (chunk->lastRandomTickId == randomTickId) {
                     continue;
                 }
                 chunk->lastRandomTickId = randomTickId;
-                randomTick(*chunk, segments, indices);
+                auto tier = simulation.getTier(chunk->x, chunk->z);
+                if (!simulation.isTicked(tier, cycle, chunk->x + chunk->z)) {
+                    continue;
+                }
+                randomTickChunks.push_back(chunk.get());
             }
         }
     }
+
+    size_t count = randomTickChunks.size();
+    if (randomTickPool == nullptr && count >= RANDOM_TICK_JOB_MIN_CHUNKS * 2) {
+        randomTickPool =
+            std::make_unique<util::ThreadPool<RandomTickJob, size_t>>(
+                "random-tick",
+                [indices]() {
+                    return std::make_unique<RandomTickWorker>(*indices);
+                },
+                [this](size_t&&) { randomJobsDone++; },
+                util::ThreadPool<RandomTickJob, size_t>::QUARTER
+            );
+        randomTickPool->setStandaloneResults(true);
+    }
+    size_t jobsCount = 1;
+    if (randomTickPool) {
+        jobsCount = std::max<size_t>(1, std::min(
+            static_cast<size_t>(randomTickPool->getWorkersCount()) + 1,
+            count / RANDOM_TICK_JOB_MIN_CHUNKS
+        ));
+    }
+    size_t jobSize = (count + jobsCount - 1) / jobsCount;
+    if (randomCandidates.size() < jobsCount) {
+        randomCandidates.resize(jobsCount);
+    }
+    std::vector<RandomTickJob> jobs;
+    for (size_t i = 0; i < jobsCount; i++) {
+        size_t offset = i * jobSize;
+        uint seed = (static_cast<uint>(random.rand()) << 15) ^ random.rand();
+        jobs.push_back(RandomTickJob {
+            randomTickChunks.data() + std::min(offset, count),
+            offset < count ? std::min(jobSize, count - offset) : 0,
+            seed,
+            &randomCandidates[i]});
+    }
+    // chunks must not be modified until all jobs are done
+    randomJobsDone = 0;
+    for (size_t i = 1; i < jobsCount; i++) {
+        randomTickPool->enqueueJob(RandomTickJob(jobs[i]));
+    }
+    // the first range is processed by the current thread
+    select_random_updates(jobs[0], *indices);
+    while (randomJobsDone + 1 < jobsCount) {
+        if (randomTickPool->pullResults() == 0) {
+            std::this_thread::yield();
+        }
+    }
+    // script callbacks are called on the main thread in the chunks order
+    for (size_t i = 0; i < jobsCount; i++) {
+        dispatchRandomUpdates(randomCandidates[i]);
+    }
+
+    for (blockid_t id : randomUpdated) {
+        auto& positions = randomUpdates[id];
+        scripting::random_update_blocks(indices->blocks.require(id), positions);
+        positions.clear();
+    }
+    randomUpdated.clear();
     randomTickId++;
 }
 
@@ -212,7 +605,7 @@ int64_t BlocksController::createBlockInventory(int x, int y, int z) {
     auto inv = chunk->getBlockInventory(lx, y, lz);
     if (inv == nullptr) {
         const auto& indices = level.content.getIndices()->blocks;
-        auto& def = indices.require(chunk->voxels[vox_index(lx, y, lz)].id);
+        auto& def = indices.require(chunk->get(lx, y, lz).id);
         int invsize = def.inventorySize;
         if (invsize == 0) {
             return 0;
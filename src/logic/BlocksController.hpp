@@ -1,6 +1,8 @@
 #pragma once
 
 #include <functional>
+#include <memory>
+#include <vector>
 #include <glm/glm.hpp>
 
 #include "maths/fastmaths.hpp"
@@ -16,6 +18,15 @@ class Chunks;
 class Lighting;
 class GlobalChunks;
 class ContentIndices;
+class BlocksBatch;
+class CellularSimulation;
+struct WorldInfo;
+struct ScheduledUpdate;
+
+namespace util {
+    template <class T, class R>
+    class ThreadPool;
+}
 
 enum class BlockInteraction { step, destruction, placing };
 
@@ -23,9 +34,33 @@ enum class BlockInteraction { step, destruction, placing };
 using OnBlockInteraction = std::function<
     void(Player*, const glm::ivec3&, const Block&, BlockInteraction)>;
 
+/// @brief Randomly selected block having random update callbacks
+struct RandomTickCandidate {
+    glm::ivec3 pos;
+    blockid_t id;
+};
+
+/// @brief Range of chunks processed by a single random tick worker
+struct RandomTickJob {
+    const Chunk* const* chunks;
+    size_t count;
+    uint seed;
+    std::vector<RandomTickCandidate>* candidates;
+};
+
+/// @brief Scheduled update placed to the timer wheel. Stays valid while
+/// the chunk has the same update (see Chunk::scheduledUpdates)
+struct ScheduledUpdateEntry {
+    int chunkX;
+    int chunkZ;
+    uint index;
+    uint64_t tick;
+};
+
 /// BlocksController manages block updates and data (inventories, metadata)
 class BlocksController {
     const Level& level;
+    WorldInfo& worldInfo;
     GlobalChunks& chunks;
     Lighting* lighting;
     util::Clock randTickClock;
@@ -34,8 +69,46 @@ class BlocksController {
     FastRandom random {};
     std::vector<OnBlockInteraction> blockInteractionCallbacks;
     uint64_t randomTickId = 0;
+    /// @brief Positions of blocks with on_random_updates callback collected
+    /// during random tick, indexed by block id
+    std::vector<std::vector<glm::ivec3>> randomUpdates;
+    /// @brief Ids of blocks having collected random updates
+    std::vector<blockid_t> randomUpdated;
+    /// @brief Chunks of the current random tick, each one listed once
+    /// even if it's in the areas of multiple players
+    std::vector<const Chunk*> randomTickChunks;
+    /// @brief Candidates selected by random tick jobs
+    std::vector<std::vector<RandomTickCandidate>> randomCandidates;
+    std::unique_ptr<util::ThreadPool<RandomTickJob, size_t>> randomTickPool;
+    size_t randomJobsDone = 0;
+    /// @brief Scheduled updates timer wheel, slot is tick modulo slots number
+    std::vector<std::vector<ScheduledUpdateEntry>> scheduledWheel;
+    std::vector<ScheduledUpdateEntry> scheduledSlot;
+    std::unique_ptr<CellularSimulation> cellular;
+    std::unique_ptr<BlocksBatch> cellularBatch;
+
+    /// @brief Put chunk scheduled update to the timer wheel
+    void enqueueScheduled(const Chunk& chunk, const ScheduledUpdate& update);
+
+    /// @brief Advance world ticks counter and call due scheduled updates
+    void scheduledTick();
+
+    /// @brief Step liquids and powders simulation and apply the changes
+    void cellularTick();
+
+    /// @brief Deliver random update callbacks of the selected blocks
+    /// still present at the positions
+    void dispatchRandomUpdates(
+        const std::vector<RandomTickCandidate>& candidates
+    );
+
+    /// @brief Wake up sleeping entities bodies around changed blocks area
+    /// @param min area min block
+    /// @param max area max block (inclusive)
+    void wakeEntities(const glm::ivec3& min, const glm::ivec3& max);
 public:
-    BlocksController(const Level& level, Lighting* lighting);
+    BlocksController(Level& level, Lighting* lighting);
+    ~BlocksController();
 
     void updateSides(int x, int y, int z);
     void updateSides(int x, int y, int z, int w, int h, int d);
@@ -46,12 +119,30 @@ public:
         Player* player, const Block& def, blockstate state, int x, int y, int z
     );
 
+    /// @brief Apply blocks changes chunk by chunk. Lights are updated once
+    /// for all changed blocks, neighbour blocks are updated once each.
+    /// Single on_blocks_batch event is emitted. The batch is cleared.
+    /// @param batch changes to apply (same blocks changes are skipped)
+    /// @param updateNeighbours call update for the blocks around changed
+    /// @return number of changed blocks
+    size_t applyBatch(BlocksBatch& batch, bool updateNeighbours);
+
     void update(float delta, uint padding);
-    void randomTick(
-        const Chunk& chunk, int segments, const ContentIndices* indices
-    );
+
+    /// @brief Select random blocks of the players areas chunks on worker
+    /// threads, then call their random update callbacks
     void randomTick(int tickid, int parts, uint padding);
     void onBlocksTick(int tickid, int parts);
+
+    /// @brief Schedule on_scheduled_update call of the block. Earlier update
+    /// stays if the block has one already
+    /// @param delay number of world ticks (min is 1)
+    /// @return false if the block chunk is not loaded
+    bool scheduleUpdate(int x, int y, int z, uint delay);
+
+    /// @brief Cancel scheduled update of the block
+    /// @return false if the block has no scheduled update
+    bool cancelUpdate(int x, int y, int z);
     int64_t createBlockInventory(int x, int y, int z);
     void bindInventory(int64_t invid, int x, int y, int z);
     void unbindInventory(int x, int y, int z);
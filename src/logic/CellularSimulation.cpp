@@ -0,0 +1,323 @@
+#include "CellularSimulation.hpp"
+
+#include <algorithm>
+
+#include "constants.hpp"
+#include "content/Content.hpp"
+#include "debug/Profiler.hpp"
+#include "maths/voxmaths.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/BlocksBatch.hpp"
+#include "voxels/Chunk.hpp"
+
+/// @brief Max cells processed per step, the rest waits for the next one
+inline constexpr size_t MAX_CELLS_PER_STEP = 1 << 16;
+/// @brief Block state user bits storing the liquid level
+inline constexpr int LEVEL_MASK = 0xF;
+
+static const glm::ivec3 SIDES[] {
+    {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}
+};
+static const glm::ivec3 HORIZONTAL_SIDES[] {
+    {-1, 0, 0}, {0, 0, -1}, {1, 0, 0}, {0, 0, 1}
+};
+static const glm::ivec3 DOWN {0, -1, 0};
+
+static inline uint64_t chunk_key(int cx, int cz) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32 |
+           static_cast<uint32_t>(cz);
+}
+
+static inline uint64_t cell_key(const glm::ivec3& pos) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(pos.x) & 0x3FFFFFF)
+            << 38) |
+           (static_cast<uint64_t>(static_cast<uint32_t>(pos.z) & 0x3FFFFFF)
+            << 12) |
+           (static_cast<uint32_t>(pos.y) & 0xFFF);
+}
+
+CellularSimulation::CellularSimulation(
+    const ContentIndices& indices, ChunkSupplier chunks
+)
+    : indices(indices), chunks(std::move(chunks)) {
+}
+
+CellularSimulation::~CellularSimulation() = default;
+
+int CellularSimulation::getLevel(blockstate state) {
+    return state.userbits & LEVEL_MASK;
+}
+
+blockstate CellularSimulation::makeLevelState(int level) {
+    blockstate state {};
+    state.userbits = level;
+    return state;
+}
+
+void CellularSimulation::activate(int x, int y, int z) {
+    if (y < 0 || y >= CHUNK_H) {
+        return;
+    }
+    int cx = floordiv<CHUNK_W>(x);
+    int cz = floordiv<CHUNK_D>(z);
+    active[chunk_key(cx, cz)].push_back(
+        vox_index(x - cx * CHUNK_W, y, z - cz * CHUNK_D)
+    );
+}
+
+size_t CellularSimulation::getActiveCount() const {
+    size_t count = 0;
+    for (const auto& [_, cells] : active) {
+        count += cells.size();
+    }
+    return count;
+}
+
+Chunk* CellularSimulation::getChunk(int cx, int cz) {
+    if (!cacheValid || cachedX != cx || cachedZ != cz) {
+        cachedChunk = chunks(cx, cz);
+        cachedX = cx;
+        cachedZ = cz;
+        cacheValid = true;
+    }
+    return cachedChunk;
+}
+
+std::optional<voxel> CellularSimulation::at(const glm::ivec3& pos) {
+    if (pos.y < 0 || pos.y >= CHUNK_H) {
+        return std::nullopt;
+    }
+    int cx = floordiv<CHUNK_W>(pos.x);
+    int cz = floordiv<CHUNK_D>(pos.z);
+    Chunk* chunk = getChunk(cx, cz);
+    if (chunk == nullptr) {
+        return std::nullopt;
+    }
+    return chunk->get(pos.x - cx * CHUNK_W, pos.y, pos.z - cz * CHUNK_D);
+}
+
+const Block& CellularSimulation::def(const voxel& vox) const {
+    return indices.blocks.require(vox.id);
+}
+
+bool CellularSimulation::isClaimed(const glm::ivec3& pos) const {
+    return claimed.find(cell_key(pos)) != claimed.end();
+}
+
+void CellularSimulation::write(
+    const glm::ivec3& pos, blockid_t id, blockstate state
+) {
+    claimed.insert(cell_key(pos));
+    batch->set(pos.x, pos.y, pos.z, id, state);
+    activate(pos.x, pos.y, pos.z);
+    for (const auto& side : SIDES) {
+        activate(pos.x + side.x, pos.y + side.y, pos.z + side.z);
+    }
+}
+
+bool CellularSimulation::isOpen(const voxel& vox, blockid_t id) const {
+    if (vox.id == id) {
+        return false;
+    }
+    const auto& target = def(vox);
+    // other liquids and powders are not washed away
+    return target.replaceable && target.cellular.type == CellularType::NONE;
+}
+
+bool CellularSimulation::spreads(const glm::ivec3& pos, blockid_t id) {
+    if (pos.y == 0) {
+        return true;
+    }
+    auto below = at(pos + DOWN);
+    return below && below->id != id && !isOpen(*below, id);
+}
+
+int CellularSimulation::feedLevel(
+    const glm::ivec3& pos, const voxel& vox, int levels
+) {
+    if (auto above = at(pos - DOWN); above && above->id == vox.id) {
+        return 1;
+    }
+    int level = levels;
+    for (const auto& side : HORIZONTAL_SIDES) {
+        auto neighbour = at(pos + side);
+        if (!neighbour) {
+            // the feeding cell may be in the chunk not loaded
+            return getLevel(vox.state);
+        }
+        if (neighbour->id == vox.id && spreads(pos + side, vox.id)) {
+            level = std::min(level, getLevel(neighbour->state) + 1);
+        }
+    }
+    return level;
+}
+
+CellularSimulation::StepResult CellularSimulation::stepLiquid(
+    const glm::ivec3& pos, const voxel& vox
+) {
+    int levels = def(vox).cellular.levels;
+    int level = getLevel(vox.state);
+    // flowing liquid follows the feeding cells, sources are kept
+    if (level > 0) {
+        int expected = feedLevel(pos, vox, levels);
+        if (expected >= levels) {
+            write(pos, BLOCK_AIR, {});
+            return StepResult::CHANGED;
+        } else if (expected != level) {
+            write(pos, vox.id, makeLevelState(expected));
+            return StepResult::CHANGED;
+        }
+    }
+    if (levels == 1) {
+        return StepResult::STABLE;
+    }
+    if (auto below = at(pos + DOWN)) {
+        if (isOpen(*below, vox.id) ||
+            (below->id == vox.id && getLevel(below->state) > 1)) {
+            if (isClaimed(pos + DOWN)) {
+                return StepResult::BLOCKED;
+            }
+            write(pos + DOWN, vox.id, makeLevelState(1));
+            return StepResult::CHANGED;
+        }
+    }
+    if (level + 1 >= levels || !spreads(pos, vox.id)) {
+        return StepResult::STABLE;
+    }
+    auto result = StepResult::STABLE;
+    for (const auto& side : HORIZONTAL_SIDES) {
+        auto neighbour = at(pos + side);
+        if (!neighbour) {
+            continue;
+        }
+        if (!isOpen(*neighbour, vox.id) &&
+            !(neighbour->id == vox.id &&
+              getLevel(neighbour->state) > level + 1)) {
+            continue;
+        }
+        if (isClaimed(pos + side)) {
+            result = StepResult::BLOCKED;
+            continue;
+        }
+        write(pos + side, vox.id, makeLevelState(level + 1));
+        if (result == StepResult::STABLE) {
+            result = StepResult::CHANGED;
+        }
+    }
+    return result;
+}
+
+CellularSimulation::StepResult CellularSimulation::movePowder(
+    const glm::ivec3& from,
+    const voxel& vox,
+    const glm::ivec3& to,
+    const voxel& target
+) {
+    if (isClaimed(to)) {
+        return StepResult::BLOCKED;
+    }
+    if (def(target).cellular.type == CellularType::LIQUID) {
+        write(from, target.id, target.state);
+    } else {
+        write(from, BLOCK_AIR, {});
+    }
+    write(to, vox.id, vox.state);
+    return StepResult::CHANGED;
+}
+
+CellularSimulation::StepResult CellularSimulation::stepPowder(
+    const glm::ivec3& pos, const voxel& vox
+) {
+    // powder sinks in liquids
+    auto sinks = [this, &vox](const voxel& target) {
+        return isOpen(target, vox.id) ||
+               def(target).cellular.type == CellularType::LIQUID;
+    };
+    auto below = at(pos + DOWN);
+    if (below && sinks(*below)) {
+        return movePowder(pos, vox, pos + DOWN, *below);
+    }
+    if (!below || !def(vox).cellular.slide) {
+        return StepResult::STABLE;
+    }
+    // slide direction is rotated to keep piles symmetric
+    int first = static_cast<int>((tick + pos.x + pos.z) & 3);
+    for (int i = 0; i < 4; i++) {
+        const auto& side = HORIZONTAL_SIDES[(first + i) & 3];
+        auto neighbour = at(pos + side);
+        auto diagonal = at(pos + side + DOWN);
+        if (neighbour && diagonal && isOpen(*neighbour, vox.id) &&
+            sinks(*diagonal)) {
+            return movePowder(pos, vox, pos + side + DOWN, *diagonal);
+        }
+    }
+    return StepResult::STABLE;
+}
+
+size_t CellularSimulation::step(uint64_t tick, BlocksBatch& batch) {
+    if (active.empty()) {
+        return 0;
+    }
+    VC_PROFILE_ZONE("CellularSimulation::step");
+    std::swap(active, processing);
+    this->batch = &batch;
+    this->tick = tick;
+    claimed.clear();
+    cacheValid = false;
+
+    size_t processed = 0;
+    for (auto& [key, cells] : processing) {
+        int cx = static_cast<int32_t>(key >> 32);
+        int cz = static_cast<int32_t>(key & 0xFFFFFFFF);
+        Chunk* chunk = getChunk(cx, cz);
+        if (chunk == nullptr) {
+            // cells of unloaded chunks are dropped
+            continue;
+        }
+        // sorted by height, so lower cells are moved first
+        std::sort(cells.begin(), cells.end());
+        cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+
+        auto& next = active[key];
+        for (uint index : cells) {
+            const voxel vox = chunk->get(index);
+            const auto* blockDef = indices.blocks.get(vox.id);
+            if (blockDef == nullptr ||
+                blockDef->cellular.type == CellularType::NONE) {
+                continue;
+            }
+            if (processed >= MAX_CELLS_PER_STEP ||
+                tick % blockDef->cellular.interval != 0) {
+                next.push_back(index);
+                continue;
+            }
+            processed++;
+            glm::ivec3 pos(
+                cx * CHUNK_W + index % CHUNK_W,
+                index / (CHUNK_W * CHUNK_D),
+                cz * CHUNK_D + index / CHUNK_W % CHUNK_D
+            );
+            auto result = StepResult::BLOCKED;
+            if (!isClaimed(pos)) {
+                if (blockDef->cellular.type == CellularType::LIQUID) {
+                    result = stepLiquid(pos, vox);
+                } else {
+                    result = stepPowder(pos, vox);
+                }
+            }
+            if (result == StepResult::BLOCKED) {
+                next.push_back(index);
+            }
+        }
+    }
+    processing.clear();
+    for (auto it = active.begin(); it != active.end();) {
+        if (it->second.empty()) {
+            it = active.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    this->batch = nullptr;
+    return processed;
+}
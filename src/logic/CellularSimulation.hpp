@@ -0,0 +1,105 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "typedefs.hpp"
+#include "voxels/voxel.hpp"
+
+class Block;
+class Chunk;
+class BlocksBatch;
+class ContentIndices;
+
+/// @return chunk at the chunk grid position or nullptr if not loaded
+using ChunkSupplier = std::function<Chunk*(int cx, int cz)>;
+
+/// @brief Native simulation of blocks having cellular rules (liquids and
+/// powders, see CellularRules). Only active cells are processed: cells
+/// changed by the simulation, their neighbours and cells activated by
+/// blocks updates. Cells left unchanged by a step are deactivated, so
+/// settled liquids cost nothing.
+///
+/// Active cells are grouped by chunks. A step collects changes to a
+/// BlocksBatch applied by the caller, so lights, neighbour updates and
+/// events are processed once per step.
+class CellularSimulation {
+    enum class StepResult {
+        /// @brief Cell is settled
+        STABLE,
+        /// @brief Changes are written
+        CHANGED,
+        /// @brief Cell is blocked by changes of other cells made at the
+        /// same step and stays active
+        BLOCKED,
+    };
+
+    const ContentIndices& indices;
+    ChunkSupplier chunks;
+    /// @brief Active cells voxel indices by chunk key (may repeat)
+    std::unordered_map<uint64_t, std::vector<uint>> active;
+    /// @brief Cells of the current step
+    std::unordered_map<uint64_t, std::vector<uint>> processing;
+    /// @brief Keys of cells written at the current step
+    std::unordered_set<uint64_t> claimed;
+    BlocksBatch* batch = nullptr;
+    uint64_t tick = 0;
+
+    Chunk* cachedChunk = nullptr;
+    int cachedX = 0;
+    int cachedZ = 0;
+    bool cacheValid = false;
+
+    Chunk* getChunk(int cx, int cz);
+    /// @return voxel or std::nullopt if out of height or chunk is not
+    /// loaded
+    std::optional<voxel> at(const glm::ivec3& pos);
+    const Block& def(const voxel& vox) const;
+
+    bool isClaimed(const glm::ivec3& pos) const;
+    /// @brief Add change to the batch and activate the cell with neighbours
+    void write(const glm::ivec3& pos, blockid_t id, blockstate state);
+
+    /// @brief Check if liquid or powder may take place of the voxel
+    bool isOpen(const voxel& vox, blockid_t id) const;
+    /// @brief Check if liquid at the position flows to sides
+    bool spreads(const glm::ivec3& pos, blockid_t id);
+    /// @return level the liquid cell is fed with (levels if not fed)
+    int feedLevel(const glm::ivec3& pos, const voxel& vox, int levels);
+
+    StepResult stepLiquid(const glm::ivec3& pos, const voxel& vox);
+    StepResult stepPowder(const glm::ivec3& pos, const voxel& vox);
+    /// @brief Move powder swapping it with a liquid or replacing other
+    /// replaceable block
+    StepResult movePowder(
+        const glm::ivec3& from,
+        const voxel& vox,
+        const glm::ivec3& to,
+        const voxel& target
+    );
+public:
+    CellularSimulation(const ContentIndices& indices, ChunkSupplier chunks);
+    ~CellularSimulation();
+
+    /// @brief Mark the cell to be processed at the next step. Cells of
+    /// blocks without cellular rules are skipped by the step
+    void activate(int x, int y, int z);
+
+    /// @brief Process active cells having step interval matching the tick
+    /// @param batch destination of the changes
+    /// @return number of processed cells
+    size_t step(uint64_t tick, BlocksBatch& batch);
+
+    /// @return number of active cells (repeated activations included)
+    size_t getActiveCount() const;
+
+    /// @return liquid level stored in the block state
+    static int getLevel(blockstate state);
+
+    /// @return block state with the liquid level
+    static blockstate makeLevelState(int level);
+};
@@ -1,15 +1,21 @@
 #include "ChunksController.hpp"
 
 #include <limits.h>
+#include <algorithm>
 #include <memory>
 
 #include "content/Content.hpp"
+#include "debug/Logger.hpp"
+#include "debug/Profiler.hpp"
 #include "world/files/WorldFiles.hpp"
 #include "graphics/core/Mesh.hpp"
 #include "lighting/Lighting.hpp"
 #include "maths/voxmaths.hpp"
 #include "util/timeutil.hpp"
+#include "util/ObjectsPool.hpp"
 #include "objects/Player.hpp"
+#include "objects/Players.hpp"
+#include "settings.hpp"
 #include "voxels/Block.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/Chunks.hpp"
@@ -17,20 +23,164 @@
 #include "world/Level.hpp"
 #include "world/LevelEvents.hpp"
 #include "world/World.hpp"
+#include "world/generator/PrototypesCache.hpp"
 #include "world/generator/WorldGenerator.hpp"
 
+static debug::Logger logger("chunks-control");
+
 const uint MAX_WORK_PER_FRAME = 128;
 const uint MIN_SURROUNDING = 9;
+/// @brief Max number of chunks waiting for generation per worker
+const uint MAX_PENDING_PER_WORKER = 4;
+/// @brief Width of the ring of chunks read ahead outside of load distance
+const int PREFETCH_DISTANCE = 3;
+/// @brief Weight of the last chunk in stages latency
+const double LATENCY_SMOOTHING = 0.05;
+
+class GeneratorWorker : public util::Worker<GeneratorJob, GeneratorResult> {
+    const WorldGenerator& generator;
+    const ContentIndices& indices;
+public:
+    GeneratorWorker(
+        const WorldGenerator& generator, const ContentIndices& indices
+    )
+        : generator(generator), indices(indices) {
+    }
+
+    GeneratorResult operator()(const GeneratorJob& job) override {
+        VC_PROFILE_ZONE("ChunksController::generate");
+        auto& chunk = *job.chunk;
+        try {
+            generator.generate(
+                *job.prototype, chunk.getVoxels(), chunk.x, chunk.z
+            );
+            chunk.updateHeights();
+            if (!chunk.flags.loadedLights && chunk.lightmap) {
+                Lighting::prebuildSkyLight(chunk, indices);
+            }
+        } catch (const std::exception& err) {
+            return GeneratorResult {job.chunk, job.playerId, err.what()};
+        }
+        return GeneratorResult {job.chunk, job.playerId, ""};
+    }
+};
+
+class LightsWorker : public util::Worker<LightsJob, LightsResult> {
+    IsolatedLighting lighting;
+public:
+    LightsWorker(const ContentIndices& indices) : lighting(indices) {
+    }
+
+    LightsResult operator()(const LightsJob& job) override {
+        VC_PROFILE_ZONE("ChunksController::buildLights");
+        lighting.build(*job.snapshot, job.buildSky);
+        return LightsResult {job.chunk, job.snapshot, job.revision};
+    }
+};
+
+class RegionsPrototypesCache : public PrototypesCache {
+    WorldRegions& regions;
+public:
+    RegionsPrototypesCache(WorldRegions& regions) : regions(regions) {
+    }
+
+    std::unique_ptr<ubyte[]> read(int x, int z, size_t& size) override {
+        uint32_t dataSize;
+        auto data = regions.getPrototype(x, z, dataSize);
+        size = dataSize;
+        return data;
+    }
+
+    void write(
+        int x, int z, std::unique_ptr<ubyte[]> data, size_t size
+    ) override {
+        regions.put(x, z, REGION_LAYER_PROTOTYPES, std::move(data), size);
+    }
+};
+
+static util::ObjectsPool<Chunk> snapshots_pool;
+static util::ObjectsPool<Lightmap> snapshot_lightmaps_pool;
+
+/// @return number of chunks in the player loading area
+static size_t count_area_chunks(const ChunksSettings& settings) {
+    size_t diameter =
+        (settings.loadDistance.get() + settings.padding.get()) * 2;
+    return diameter * diameter;
+}
 
-ChunksController::ChunksController(Level& level)
+ChunksController::ChunksController(
+    Level& level, const ChunksSettings& settings
+)
     : level(level),
+      settings(settings),
       generator(std::make_unique<WorldGenerator>(
           level.content.generators.require(level.getWorld()->getGenerator()),
           level.content,
-          level.getWorld()->getSeed()
-      )) {}
+          level.getWorld()->getSeed(),
+          settings.asyncPrototypes.get()
+              ? std::optional<int>(settings.prototypeWorkers.get())
+              : std::nullopt
+      )) {
+    GlobalChunks::reserve(count_area_chunks(settings), false);
+    level.chunks->setUnloadedCacheBudget(
+        static_cast<size_t>(settings.unloadedCache.get()) * 1024 * 1024
+    );
+    if (settings.prototypesCache.get()) {
+        generator->setCache(std::make_unique<RegionsPrototypesCache>(
+            level.getWorld()->wfile->getRegions()
+        ));
+    }
+    if (!settings.asyncGeneration.get()) {
+        return;
+    }
+    generatorPool = std::make_unique<
+        util::ThreadPool<GeneratorJob, GeneratorResult>>(
+        "chunks-generator-pool",
+        [this]() {
+            return std::make_unique<GeneratorWorker>(
+                *generator, *this->level.content.getIndices()
+            );
+        },
+        [this](GeneratorResult&& result) {
+            installChunk(std::move(result));
+        },
+        settings.generatorWorkers.get()
+    );
+    generatorPool->setStopOnFail(false);
+    logger.info() << "created " << generatorPool->getWorkersCount()
+                  << " generator workers";
+}
 
-ChunksController::~ChunksController() = default;
+ChunksController::~ChunksController() {
+    // workers must be stopped before the generator is destroyed
+    generatorPool.reset();
+    lightsPool.reset();
+}
+
+void ChunksController::enableLighting(Chunks& chunks) {
+    if (lighting) {
+        return;
+    }
+    lighting = std::make_unique<Lighting>(level.content, chunks);
+    GlobalChunks::reserve(count_area_chunks(settings), true);
+    if (!settings.asyncLighting.get()) {
+        return;
+    }
+    lightsPool = std::make_unique<util::ThreadPool<LightsJob, LightsResult>>(
+        "chunks-lights-pool",
+        [this]() {
+            return std::make_unique<LightsWorker>(
+                *this->level.content.getIndices()
+            );
+        },
+        [this](LightsResult&& result) {
+            installLights(std::move(result));
+        },
+        settings.lightsWorkers.get()
+    );
+    logger.info() << "created " << lightsPool->getWorkersCount()
+                  << " lights workers";
+}
 
 void ChunksController::update(
     int64_t maxDuration,
@@ -38,7 +188,14 @@ void ChunksController::update(
     uint padding,
     Player& player,
     bool isLocalPlayer
-) const {
+) {
+    VC_PROFILE_ZONE("ChunksController::update");
+    if (generatorPool) {
+        generatorPool->pullResults();
+    }
+    if (lightsPool) {
+        lightsPool->pullResults();
+    }
     const auto& position = player.getPosition();
     int centerX = floordiv<CHUNK_W>(glm::floor(position.x));
     int centerY = floordiv<CHUNK_D>(glm::floor(position.z));
@@ -49,12 +206,23 @@ void ChunksController::update(
     } else {
         return;
     }
+    if (isLocalPlayer) {
+        prefetchChunks(centerX, centerY, loadDistance);
+    }
+
+    auto lookAhead = player.getLookAhead();
+    collectStages(
+        player,
+        padding,
+        isLocalPlayer,
+        glm::vec2(lookAhead.x / CHUNK_W, lookAhead.z / CHUNK_D)
+    );
 
     int64_t mcstotal = 0;
 
     for (uint i = 0; i < MAX_WORK_PER_FRAME; i++) {
         timeutil::Timer timer;
-        if (loadVisible(player, padding, isLocalPlayer)) {
+        if (loadVisible(player)) {
             int64_t mcs = timer.stop();
             if (mcstotal + mcs < maxDuration * 1000) {
                 mcstotal += mcs;
@@ -65,6 +233,38 @@ void ChunksController::update(
     }
 }
 
+void ChunksController::prefetchChunks(
+    int centerX, int centerZ, int loadDistance
+) {
+    glm::ivec2 center(centerX, centerZ);
+    if (prefetchCenter == center) {
+        return;
+    }
+    int inner = 0;
+    glm::ivec2 direction {};
+    if (prefetchCenter.has_value()) {
+        inner = loadDistance;
+        direction = center - *prefetchCenter;
+    }
+    prefetchCenter = center;
+
+    int outer = loadDistance + PREFETCH_DISTANCE;
+    std::vector<glm::ivec2> chunks;
+    for (int dz = -outer; dz <= outer; dz++) {
+        for (int dx = -outer; dx <= outer; dx++) {
+            int distance = dx * dx + dz * dz;
+            if (distance < inner * inner || distance > outer * outer) {
+                continue;
+            }
+            if (dx * direction.x + dz * direction.y < 0) {
+                continue;
+            }
+            chunks.emplace_back(centerX + dx, centerZ + dz);
+        }
+    }
+    level.getWorld()->wfile->getRegions().prefetch(chunks);
+}
+
 bool ChunksController::isInLoadingZone(
     const Player& player, uint padding, int x, int z
 ) const {
@@ -81,73 +281,167 @@ bool ChunksController::isInLoadingZone(
     return distance < minDistance;
 }
 
-bool ChunksController::loadVisible(
-    const Player& player, uint padding, bool isLocalPlayer
-) const {
+static bool nearer_first(const QueuedChunk& a, const QueuedChunk& b) {
+    return a.priority > b.priority;
+}
+
+void ChunksController::collectStages(
+    const Player& player,
+    uint padding,
+    bool isLocalPlayer,
+    const glm::vec2& lookAhead
+) {
+    VC_PROFILE_ZONE("ChunksController::collectStages");
     auto& chunks = *player.chunks;
     int sizeX = chunks.getWidth();
     int sizeY = chunks.getHeight();
+    int offsetX = chunks.getOffsetX();
+    int offsetY = chunks.getOffsetY();
+    int pad = padding;
 
-    int nearX = 0;
-    int nearZ = 0;
-    bool assigned = false;
-    int minDistance = ((sizeX - padding * 2) / 2) * ((sizeY - padding * 2) / 2);
+    int minDistance = ((sizeX - pad * 2) / 2) * ((sizeY - pad * 2) / 2);
     int maxDistance = ((sizeX) / 2) * ((sizeY) / 2);
-    for (uint z = 0; z < sizeY; z++) {
-        for (uint x = 0; x < sizeX; x++) {
-            int index = z * sizeX + x;
+
+    // predicted position is kept inside of the loading area, so chunks
+    // behind the player are still loaded after the ones ahead
+    glm::vec2 predicted = lookAhead;
+    float radius = glm::sqrt(static_cast<float>(minDistance));
+    if (glm::length(predicted) > radius) {
+        predicted = glm::normalize(predicted) * radius;
+    }
+
+    requestedQueue.clear();
+    lightsQueue.clear();
+    for (int z = 0; z < sizeY; z++) {
+        for (int x = 0; x < sizeX; x++) {
             int lx = x - sizeX / 2;
             int lz = z - sizeY / 2;
             int distance = (lx * lx + lz * lz);
-            auto& chunk = chunks.getChunks()[index];
+            bool inner =
+                x >= pad && x < sizeX - pad && z >= pad && z < sizeY - pad;
+            glm::ivec2 pos(x + offsetX, z + offsetY);
+            glm::vec2 ahead = glm::vec2(lx, lz) - predicted;
+            float priority = glm::dot(ahead, ahead);
+
+            auto& chunk = chunks.getChunkLocal(x, z);
             if (chunk != nullptr) {
                 if (distance >= maxDistance) {
-                    chunks.remove(
-                        x + chunks.getOffsetX(), z + chunks.getOffsetY()
-                    );
+                    chunks.remove(pos.x, pos.y);
+                } else if (inner && isLocalPlayer && chunk->flags.loaded &&
+                           !chunk->flags.lighted &&
+                           pendingLights.find(pos) == pendingLights.end()) {
+                    lightsQueue.push_back({pos, distance, priority});
                 }
                 continue;
             }
-        }
-    }
-    for (uint z = padding; z < sizeY - padding; z++) {
-        for (uint x = padding; x < sizeX - padding; x++) {
-            int index = z * sizeX + x;
-            int lx = x - sizeX / 2;
-            int lz = z - sizeY / 2;
-            int distance = (lx * lx + lz * lz);
-            auto& chunk = chunks.getChunks()[index];
-            if (chunk != nullptr) {
-                if (chunk->flags.loaded && !chunk->flags.lighted) {
-                    if (isLocalPlayer && buildLights(player, chunk)) {
-                        return true;
-                    }
-                }
+            if (!inner || distance >= minDistance) {
                 continue;
             }
-
-            if (distance < minDistance) {
-                minDistance = distance;
-                nearX = x;
-                nearZ = z;
-                assigned = true;
+            if (!pendingChunks.empty() &&
+                pendingChunks.find(pos) != pendingChunks.end()) {
+                continue;
             }
+            requestedQueue.push_back({pos, distance, priority});
         }
     }
+    std::sort(lightsQueue.begin(), lightsQueue.end(), nearer_first);
+    std::sort(requestedQueue.begin(), requestedQueue.end(), nearer_first);
 
-    const auto& chunk = chunks.getChunks()[nearZ * sizeX + nearX];
-    if (chunk != nullptr || !assigned || !player.isLoadingChunks()) {
-        return false;
+    // stages of unloaded chunks are not finished
+    for (auto it = stageStarts.begin(); it != stageStarts.end();) {
+        const auto& pos = it->first;
+        if (level.chunks->getChunk(pos.x, pos.y) == nullptr &&
+            pendingChunks.find(pos) == pendingChunks.end()) {
+            it = stageStarts.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = staleLights.begin(); it != staleLights.end();) {
+        if (level.chunks->getChunk(it->x, it->y) == nullptr) {
+            it = staleLights.erase(it);
+        } else {
+            ++it;
+        }
     }
+    stats[static_cast<size_t>(ChunkStage::requested)].count =
+        requestedQueue.size();
+    stats[static_cast<size_t>(ChunkStage::generation)].count =
+        pendingChunks.size();
+    stats[static_cast<size_t>(ChunkStage::lighting)].count =
+        lightsQueue.size() + pendingLights.size();
+}
+
+bool ChunksController::loadVisible(const Player& player) {
+    const auto& chunks = *player.chunks;
     int offsetX = chunks.getOffsetX();
     int offsetY = chunks.getOffsetY();
-    createChunk(player, nearX + offsetX, nearZ + offsetY);
-    return true;
+    auto is_inside = [&chunks](int x, int z) {
+        return x >= 0 && z >= 0 && x < chunks.getWidth() &&
+               z < chunks.getHeight();
+    };
+    // chunks not having all surrounding chunks wait for the next update
+    while (!lightsQueue.empty()) {
+        auto pos = lightsQueue.back().pos;
+        lightsQueue.pop_back();
+        int x = pos.x - offsetX;
+        int z = pos.y - offsetY;
+        if (!is_inside(x, z)) {
+            continue;
+        }
+        const auto& chunk = chunks.getChunkLocal(x, z);
+        if (chunk && !chunk->flags.lighted && buildLights(player, chunk)) {
+            return true;
+        }
+    }
+    if (generatorPool && pendingChunks.size() >=
+                             generatorPool->getWorkersCount() *
+                                 MAX_PENDING_PER_WORKER) {
+        return false;
+    }
+    while (!requestedQueue.empty()) {
+        auto pos = requestedQueue.back().pos;
+        requestedQueue.pop_back();
+        int x = pos.x - offsetX;
+        int z = pos.y - offsetY;
+        if (!is_inside(x, z) || chunks.getChunkLocal(x, z) ||
+            pendingChunks.find(pos) != pendingChunks.end()) {
+            continue;
+        }
+        createChunk(player, pos.x, pos.y);
+        return true;
+    }
+    return false;
+}
+
+void ChunksController::enterStage(int x, int z) {
+    stageStarts[{x, z}] = std::chrono::steady_clock::now();
+}
+
+void ChunksController::passStage(ChunkStage stage, int x, int z) {
+    const auto& found = stageStarts.find({x, z});
+    if (found == stageStarts.end()) {
+        return;
+    }
+    auto mcs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - found->second
+    );
+    stageStarts.erase(found);
+    passStage(stage, mcs.count());
+}
+
+void ChunksController::passStage(ChunkStage stage, int64_t mcs) {
+    auto& stageStats = stats[static_cast<size_t>(stage)];
+    if (stageStats.passed++ == 0) {
+        stageStats.latency = mcs;
+    } else {
+        stageStats.latency += (mcs - stageStats.latency) * LATENCY_SMOOTHING;
+    }
 }
 
 bool ChunksController::buildLights(
     const Player& player, const std::shared_ptr<Chunk>& chunk
-) const {
+) {
     int surrounding = 0;
     for (int oz = -1; oz <= 1; oz++) {
         for (int ox = -1; ox <= 1; ox++) {
@@ -156,6 +450,10 @@ bool ChunksController::buildLights(
         }
     }
     if (surrounding == MIN_SURROUNDING) {
+        if (lightsPool && lighting && chunk->lightmap &&
+            staleLights.erase({chunk->x, chunk->z}) == 0) {
+            return enqueueLights(chunk);
+        }
         if (lighting && chunk->lightmap) {
             bool lightsCache = chunk->flags.loadedLights;
             if (!lightsCache) {
@@ -164,23 +462,37 @@ bool ChunksController::buildLights(
             lighting->onChunkLoaded(chunk->x, chunk->z, !lightsCache);
         }
         chunk->flags.lighted = true;
+        passStage(ChunkStage::lighting, chunk->x, chunk->z);
         return true;
     }
     return false;
 }
 
-void ChunksController::createChunk(const Player& player, int x, int z) const {
+void ChunksController::createChunk(const Player& player, int x, int z) {
     if (!player.isLoadingChunks()) {
         if (auto chunk = level.chunks->fetch(x, z)) {
             player.chunks->putChunk(chunk);
         }
         return;
     }
+    timeutil::Timer timer;
     auto chunk = level.chunks->create(x, z, lighting != nullptr);
-    player.chunks->putChunk(chunk);
+    passStage(ChunkStage::io, timer.stop());
     auto& chunkFlags = chunk->flags;
+    if (!chunkFlags.loaded && generatorPool) {
+        // chunk stays invisible for the level until its voxels are generated
+        level.chunks->erase(x, z);
+        pendingChunks[{x, z}] = chunk;
+        enterStage(x, z);
+        generatorPool->enqueueJob(GeneratorJob {
+            chunk, generator->prepare(x, z), player.getId()});
+        return;
+    }
+    player.chunks->putChunk(chunk);
     if (!chunkFlags.loaded) {
-        generator->generate(chunk->voxels, x, z);
+        timeutil::Timer generationTimer;
+        generator->generate(chunk->getVoxels(), x, z);
+        passStage(ChunkStage::generation, generationTimer.stop());
         chunkFlags.unsaved = true;
     }
     chunk->updateHeights();
@@ -188,6 +500,83 @@ void ChunksController::createChunk(const Player& player, int x, int z) const {
     if (!chunkFlags.loadedLights && chunk->lightmap) {
         Lighting::prebuildSkyLight(*chunk, *level.content.getIndices());
     }
-    chunkFlags.loaded = true;
-    chunkFlags.ready = true;
+    finishChunk(chunk);
+}
+
+void ChunksController::finishChunk(const std::shared_ptr<Chunk>& chunk) {
+    chunk->flags.loaded = true;
+    chunk->flags.ready = true;
+    if (!chunk->flags.lighted) {
+        enterStage(chunk->x, chunk->z);
+    }
+}
+
+void ChunksController::installChunk(GeneratorResult&& result) {
+    const auto& chunk = result.chunk;
+    pendingChunks.erase({chunk->x, chunk->z});
+    passStage(ChunkStage::generation, chunk->x, chunk->z);
+    if (!result.error.empty()) {
+        logger.error() << "could not generate chunk " << chunk->x << "x"
+                       << chunk->z << ": " << result.error;
+        return;
+    }
+    auto player = level.players->get(result.playerId);
+    if (player == nullptr || player->chunks == nullptr ||
+        level.chunks->getChunk(chunk->x, chunk->z)) {
+        return;
+    }
+    level.chunks->putChunk(chunk);
+    if (!player->chunks->putChunk(chunk)) {
+        // player has left the area while the chunk was generating
+        level.chunks->erase(chunk->x, chunk->z);
+        return;
+    }
+    chunk->flags.unsaved = true;
+    level.events->trigger(LevelEventType::CHUNK_PRESENT, chunk.get());
+    finishChunk(chunk);
+}
+
+bool ChunksController::enqueueLights(const std::shared_ptr<Chunk>& chunk) {
+    glm::ivec2 key(chunk->x, chunk->z);
+    if (pendingLights.find(key) != pendingLights.end() ||
+        pendingLights.size() >=
+            lightsPool->getWorkersCount() * MAX_PENDING_PER_WORKER) {
+        return false;
+    }
+    auto snapshot = snapshots_pool.create(
+        chunk->x, chunk->z, snapshot_lightmaps_pool.create()
+    );
+    chunk->copyVoxels(snapshot->getVoxels());
+    snapshot->emptySections = chunk->emptySections;
+    snapshot->uniformSections = chunk->uniformSections;
+    snapshot->lightmap->set(chunk->lightmap.get());
+    snapshot->lightmap->highestPoint = chunk->lightmap->highestPoint;
+
+    pendingLights[key] = chunk;
+    lightsPool->enqueueJob(LightsJob {
+        chunk,
+        std::move(snapshot),
+        !chunk->flags.loadedLights,
+        chunk->revision});
+    return true;
+}
+
+void ChunksController::installLights(LightsResult&& result) {
+    const auto& chunk = result.chunk;
+    pendingLights.erase({chunk->x, chunk->z});
+    if (lighting == nullptr || chunk->flags.lighted) {
+        return;
+    }
+    if (chunk->revision != result.revision) {
+        // merging lights of the old voxels may leave lights in placed
+        // opaque blocks and of removed sources
+        staleLights.insert({chunk->x, chunk->z});
+        return;
+    }
+    if (!lighting->applyIsolatedLights(*chunk, *result.snapshot->lightmap)) {
+        return;
+    }
+    chunk->flags.lighted = true;
+    chunk->setModified();
+    passStage(ChunkStage::lighting, chunk->x, chunk->z);
 }
@@ -1,8 +1,20 @@
 #pragma once
 
+#include <array>
+#include <chrono>
 #include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
 
 #include "typedefs.hpp"
+#include "util/ThreadPool.hpp"
 
 class Level;
 class Chunk;
@@ -10,23 +22,145 @@ class Chunks;
 class Player;
 class Lighting;
 class WorldGenerator;
+struct ChunkPrototype;
+struct ChunksSettings;
+
+struct GeneratorJob {
+    std::shared_ptr<Chunk> chunk;
+    std::shared_ptr<const ChunkPrototype> prototype;
+    u64id_t playerId;
+};
+
+struct GeneratorResult {
+    std::shared_ptr<Chunk> chunk;
+    u64id_t playerId;
+    /// @brief Error message if generation failed
+    std::string error;
+};
+
+struct LightsJob {
+    /// @brief Chunk the lights are building for
+    std::shared_ptr<Chunk> chunk;
+    /// @brief Copy of the chunk voxels and lights processed by worker
+    std::shared_ptr<Chunk> snapshot;
+    bool buildSky;
+    /// @brief Chunk revision the snapshot is taken at
+    uint32_t revision;
+};
+
+struct LightsResult {
+    std::shared_ptr<Chunk> chunk;
+    std::shared_ptr<Chunk> snapshot;
+    uint32_t revision;
+};
+
+/// @brief Chunks loading pipeline stages in order chunks pass them.
+/// Meshing stage follows in the renderer
+enum class ChunkStage {
+    /// @brief Missing chunk in the loading area waiting to be created
+    requested = 0,
+    /// @brief Reading chunk from the world regions
+    io,
+    /// @brief Generating chunk voxels
+    generation,
+    /// @brief Waiting for surrounding chunks and building lights
+    lighting,
+    COUNT
+};
+
+struct ChunkStageStats {
+    /// @brief Chunks in the stage at the last update
+    /// (io stage is processed synchronously)
+    size_t count = 0;
+    /// @brief Total number of chunks passed the stage
+    uint64_t passed = 0;
+    /// @brief Smoothed time spent in the stage (microseconds)
+    double latency = 0.0;
+};
+
+using ChunksPipelineStats =
+    std::array<ChunkStageStats, static_cast<size_t>(ChunkStage::COUNT)>;
+
+/// @brief Chunk position in a stage queue
+struct QueuedChunk {
+    glm::ivec2 pos;
+    /// @brief Squared distance to the player area center (chunks)
+    int distance;
+    /// @brief Squared distance to the predicted player position (chunks),
+    /// the queue is sorted by
+    float priority;
+};
 
 /// @brief ChunksController manages chunks dynamic loading/unloading
 class ChunksController {
 private:
     Level& level;
+    const ChunksSettings& settings;
     std::unique_ptr<WorldGenerator> generator;
+    /// @brief Chunks being generated by workers and not yet installed
+    std::unordered_map<glm::ivec2, std::shared_ptr<Chunk>> pendingChunks;
+    /// @brief Background generation workers (nullptr if disabled)
+    std::unique_ptr<util::ThreadPool<GeneratorJob, GeneratorResult>>
+        generatorPool;
+    /// @brief Chunks with lights building in background
+    std::unordered_map<glm::ivec2, std::shared_ptr<Chunk>> pendingLights;
+    /// @brief Chunks changed while lights were building in background,
+    /// so lights are built synchronously
+    std::unordered_set<glm::ivec2> staleLights;
+    /// @brief Background lights workers (nullptr if disabled)
+    std::unique_ptr<util::ThreadPool<LightsJob, LightsResult>> lightsPool;
+    /// @brief Center chunk of the last region files prefetch
+    std::optional<glm::ivec2> prefetchCenter;
+    /// @brief Missing chunks of the player area, nearest to the predicted
+    /// player position at the back
+    std::vector<QueuedChunk> requestedQueue;
+    /// @brief Loaded chunks without lights, nearest to the predicted
+    /// player position at the back
+    std::vector<QueuedChunk> lightsQueue;
+    /// @brief Time the chunk entered its current background stage
+    std::unordered_map<glm::ivec2, std::chrono::steady_clock::time_point>
+        stageStarts;
+    ChunksPipelineStats stats {};
 
-    /// @brief Process one chunk: load it or calculate lights for it
-    bool loadVisible(const Player& player, uint padding, bool isLocalPlayer) const;
-    bool buildLights(const Player& player, const std::shared_ptr<Chunk>& chunk) const;
-    void createChunk(const Player& player, int x, int y) const;
+    /// @brief Unload chunks out of the player area and fill stage queues
+    /// in a single pass over the chunks matrix
+    /// @param lookAhead predicted player movement (chunks)
+    void collectStages(
+        const Player& player,
+        uint padding,
+        bool isLocalPlayer,
+        const glm::vec2& lookAhead
+    );
+    /// @brief Process the nearest queued chunk: calculate lights for it
+    /// or create it
+    bool loadVisible(const Player& player);
+    void enterStage(int x, int z);
+    void passStage(ChunkStage stage, int x, int z);
+    void passStage(ChunkStage stage, int64_t mcs);
+    bool buildLights(const Player& player, const std::shared_ptr<Chunk>& chunk);
+    void createChunk(const Player& player, int x, int y);
+    void finishChunk(const std::shared_ptr<Chunk>& chunk);
+    void installChunk(GeneratorResult&& result);
+    bool enqueueLights(const std::shared_ptr<Chunk>& chunk);
+    void installLights(LightsResult&& result);
+    /// @brief Start reading saved chunks in the ring ahead of the player
+    /// movement (the whole area on first call)
+    void prefetchChunks(int centerX, int centerZ, int loadDistance);
 public:
+    /// @brief Chunks lights solver. nullptr in the no-lightmap mode
+    /// (headless server where clients compute lighting themselves):
+    /// chunks are created without lightmaps, the regions lights layer
+    /// is neither read nor written and lights getters report sunlight
     std::unique_ptr<Lighting> lighting;
 
-    ChunksController(Level& level);
+    ChunksController(Level& level, const ChunksSettings& settings);
     ~ChunksController();
 
+    /// @brief Enable lights building (until called, the world is in the
+    /// no-lightmap mode). Must be called before any chunk is created
+    /// @param chunks chunks matrix lights are solved in
+    void enableLighting(Chunks& chunks);
+
     /// @param maxDuration milliseconds reserved for chunks loading
     void update(
         int64_t maxDuration,
@@ -34,10 +168,19 @@ public:
         uint padding,
         Player& player,
         bool isLocalPlayer
-    ) const;
+    );
 
     bool isInLoadingZone(const Player& player, uint padding, int x, int z) const;
 
+    /// @return number of chunks being generated in background
+    size_t getPendingCount() const {
+        return pendingChunks.size();
+    }
+
+    const ChunksPipelineStats& getStats() const {
+        return stats;
+    }
+
     const WorldGenerator* getGenerator() const {
         return generator.get();
     }
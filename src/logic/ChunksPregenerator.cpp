@@ -0,0 +1,419 @@
+#include "ChunksPregenerator.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+#include "content/Content.hpp"
+#include "debug/Logger.hpp"
+#include "debug/Profiler.hpp"
+#include "io/io.hpp"
+#include "lighting/Lighting.hpp"
+#include "lighting/Lightmap.hpp"
+#include "maths/voxmaths.hpp"
+#include "settings.hpp"
+#include "util/ObjectsPool.hpp"
+#include "util/timeutil.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+#include "voxels/GlobalChunks.hpp"
+#include "world/Level.hpp"
+#include "world/World.hpp"
+#include "world/files/WorldFiles.hpp"
+#include "world/generator/WorldGenerator.hpp"
+
+static debug::Logger logger("chunks-pregen");
+
+/// @brief Width of the square tile of chunks generated by one job
+const int TILE_SIZE = 10;
+/// @brief Chunks around the tile generated to build complete lights
+/// (light does not spread further than one chunk)
+const int TILE_MARGIN = 1;
+const int TILE_AREA = TILE_SIZE + TILE_MARGIN * 2;
+/// @brief Max number of tiles in work per worker
+const size_t MAX_TILES_PER_WORKER = 2;
+/// @brief Time between background regions writes
+const auto WRITE_INTERVAL = std::chrono::seconds(10);
+/// @brief Time between progress log messages
+const auto REPORT_INTERVAL = std::chrono::seconds(5);
+
+static util::ObjectsPool<Chunk> chunks_pool;
+static util::ObjectsPool<Lightmap> lightmaps_pool;
+
+class PregenerationWorker
+    : public util::Worker<PregenerationJob, PregenerationResult> {
+    const WorldGenerator& generator;
+    const Content& content;
+    bool lighting;
+public:
+    PregenerationWorker(
+        const WorldGenerator& generator, const Content& content, bool lighting
+    )
+        : generator(generator), content(content), lighting(lighting) {
+    }
+
+    PregenerationResult operator()(const PregenerationJob& job) override {
+        VC_PROFILE_ZONE("ChunksPregenerator::generate");
+        PregenerationResult result {job.tile, {}, ""};
+        try {
+            generate(job, result);
+        } catch (const std::exception& err) {
+            result.chunks.clear();
+            result.error = err.what();
+        }
+        return result;
+    }
+private:
+    void generate(const PregenerationJob& job, PregenerationResult& result) {
+        const auto& indices = *content.getIndices();
+        Chunks chunks(TILE_AREA, TILE_AREA, 0, 0, nullptr, indices);
+        chunks.setCenter(
+            (job.origin.x + TILE_AREA / 2) * CHUNK_W,
+            (job.origin.y + TILE_AREA / 2) * CHUNK_D
+        );
+        for (size_t i = 0; i < job.prototypes.size(); i++) {
+            int x = job.origin.x + i % TILE_AREA;
+            int z = job.origin.y + i / TILE_AREA;
+            auto chunk = chunks_pool.create(
+                x, z, lighting ? lightmaps_pool.create() : nullptr
+            );
+            generator.generate(*job.prototypes[i], chunk->getVoxels(), x, z);
+            chunk->updateHeights();
+            if (chunk->lightmap) {
+                Lighting::prebuildSkyLight(*chunk, indices);
+            }
+            chunks.putChunk(chunk);
+        }
+        if (lighting) {
+            Lighting solver(content, chunks);
+            for (int z = 0; z < TILE_AREA; z++) {
+                for (int x = 0; x < TILE_AREA; x++) {
+                    solver.buildSkyLight(job.origin.x + x, job.origin.y + z);
+                    solver.onChunkLoaded(
+                        job.origin.x + x, job.origin.y + z, true
+                    );
+                }
+            }
+        }
+        for (int z = TILE_MARGIN; z < TILE_AREA - TILE_MARGIN; z++) {
+            for (int x = TILE_MARGIN; x < TILE_AREA - TILE_MARGIN; x++) {
+                const auto& chunk = chunks.getChunkLocal(x, z);
+                chunk->flags.loaded = true;
+                chunk->flags.ready = true;
+                chunk->flags.lighted = lighting;
+                chunk->flags.unsaved = true;
+                result.chunks.push_back(chunk);
+            }
+        }
+    }
+};
+
+ChunksPregenerator::ChunksPregenerator(
+    Level& level,
+    const ChunksSettings& settings,
+    glm::ivec2 areaMin,
+    glm::ivec2 areaMax,
+    bool lighting,
+    size_t tilesDone
+)
+    : level(level),
+      lighting(lighting),
+      generator(std::make_unique<WorldGenerator>(
+          level.content.generators.require(level.getWorld()->getGenerator()),
+          level.content,
+          level.getWorld()->getSeed(),
+          settings.asyncPrototypes.get()
+              ? std::optional<int>(settings.prototypeWorkers.get())
+              : std::nullopt
+      )),
+      areaMin(glm::min(areaMin, areaMax)),
+      areaMax(glm::max(areaMin, areaMax)) {
+    glm::ivec2 size = this->areaMax - this->areaMin + 1;
+    chunksTotal = size.x * size.y;
+
+    // nearest to the area center first
+    glm::ivec2 tilesCount = (size + TILE_SIZE - 1) / TILE_SIZE;
+    glm::ivec2 center = tilesCount - 1;
+    std::vector<std::pair<int, glm::ivec2>> order;
+    for (int z = 0; z < tilesCount.y; z++) {
+        for (int x = 0; x < tilesCount.x; x++) {
+            glm::ivec2 offset = glm::ivec2(x, z) * 2 - center;
+            order.emplace_back(
+                offset.x * offset.x + offset.y * offset.y,
+                this->areaMin + glm::ivec2(x, z) * TILE_SIZE
+            );
+        }
+    }
+    std::stable_sort(
+        order.begin(),
+        order.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; }
+    );
+    for (const auto& [_, tile] : order) {
+        tiles.push_back(tile);
+    }
+    this->tilesDone.resize(tiles.size());
+    for (size_t i = 0; i < std::min(tilesDone, tiles.size()); i++) {
+        markDone(i);
+    }
+    tilesWritten = tilesDonePrefix;
+    nextTile = tilesDonePrefix;
+    chunksResumed = chunksDone;
+
+    pool = std::make_unique<
+        util::ThreadPool<PregenerationJob, PregenerationResult>>(
+        "chunks-pregen-pool",
+        [this]() {
+            return std::make_unique<PregenerationWorker>(
+                *generator, this->level.content, this->lighting
+            );
+        },
+        [this](PregenerationResult&& result) {
+            results.push_back(std::move(result));
+        },
+        settings.generatorWorkers.get()
+    );
+    pool->setStopOnFail(false);
+
+    startTime = std::chrono::steady_clock::now();
+    lastWrite = startTime;
+    lastReport = startTime;
+    logger.info() << "pre-generation of " << chunksTotal << " chunks ("
+                  << this->areaMin.x << ", " << this->areaMin.y << ") - ("
+                  << this->areaMax.x << ", " << this->areaMax.y
+                  << ") started with " << pool->getWorkersCount()
+                  << " workers";
+    if (chunksResumed) {
+        logger.info() << "continuing from " << chunksResumed << " chunks done";
+    }
+}
+
+ChunksPregenerator::~ChunksPregenerator() {
+    // workers must be stopped before the generator is destroyed
+    pool.reset();
+}
+
+std::unique_ptr<ChunksPregenerator> ChunksPregenerator::resume(
+    Level& level, const ChunksSettings& settings, bool lighting
+) {
+    auto file = level.getWorld()->wfile->getPregenerationFile();
+    if (!io::exists(file)) {
+        return nullptr;
+    }
+    auto root = io::read_json(file);
+    const auto& area = root["area"];
+    return std::make_unique<ChunksPregenerator>(
+        level,
+        settings,
+        glm::ivec2(area[0].asInteger(), area[1].asInteger()),
+        glm::ivec2(area[2].asInteger(), area[3].asInteger()),
+        lighting,
+        root["tiles-done"].asInteger(0)
+    );
+}
+
+uint ChunksPregenerator::countTileChunks(size_t tile) const {
+    glm::ivec2 size = glm::min(areaMax - tiles[tile] + 1, TILE_SIZE);
+    return size.x * size.y;
+}
+
+bool ChunksPregenerator::isTileMissing(size_t tile) const {
+    auto& regions = level.getWorld()->wfile->getRegions();
+    glm::ivec2 end = glm::min(tiles[tile] + TILE_SIZE - 1, areaMax);
+    for (int z = tiles[tile].y; z <= end.y; z++) {
+        for (int x = tiles[tile].x; x <= end.x; x++) {
+            if (level.chunks->getChunk(x, z) == nullptr &&
+                !regions.hasVoxels(x, z)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ChunksPregenerator::markDone(size_t tile) {
+    tilesDone[tile] = true;
+    chunksDone += countTileChunks(tile);
+    while (tilesDonePrefix < tiles.size() && tilesDone[tilesDonePrefix]) {
+        tilesDonePrefix++;
+    }
+}
+
+void ChunksPregenerator::prepareNext(
+    timeutil::Timer& timer, int64_t maxDuration
+) {
+    while (timer.stop() < maxDuration) {
+        if (!preparing.has_value()) {
+            if (tilesInWork >=
+                pool->getWorkersCount() * MAX_TILES_PER_WORKER) {
+                return;
+            }
+            while (nextTile < tiles.size() && !isTileMissing(nextTile)) {
+                markDone(nextTile++);
+            }
+            if (nextTile == tiles.size()) {
+                return;
+            }
+            const auto& tile = tiles[nextTile];
+            preparing = PregenerationJob {
+                nextTile, tile - TILE_MARGIN, {}};
+            preparing->prototypes.reserve(TILE_AREA * TILE_AREA);
+            generator->update(
+                tile.x + TILE_SIZE / 2, tile.y + TILE_SIZE / 2, TILE_AREA / 2 + 1
+            );
+            nextTile++;
+        }
+        auto& job = *preparing;
+        int index = job.prototypes.size();
+        int x = job.origin.x + index % TILE_AREA;
+        int z = job.origin.y + index / TILE_AREA;
+        try {
+            job.prototypes.push_back(generator->prepare(x, z));
+        } catch (const std::exception& err) {
+            logger.error() << "could not prepare chunk " << x << "x" << z
+                           << ": " << err.what();
+            terminate();
+            return;
+        }
+        if (job.prototypes.size() == TILE_AREA * TILE_AREA) {
+            tilesInWork++;
+            pool->enqueueJob(std::move(job));
+            preparing.reset();
+        }
+    }
+}
+
+void ChunksPregenerator::save(PregenerationResult&& result) {
+    VC_PROFILE_ZONE("ChunksPregenerator::save");
+    tilesInWork--;
+    markDone(result.tile);
+    if (!result.error.empty()) {
+        logger.error() << "could not generate tile at " << tiles[result.tile].x
+                       << "x" << tiles[result.tile].y << ": " << result.error;
+        return;
+    }
+    auto& regions = level.getWorld()->wfile->getRegions();
+    for (const auto& chunk : result.chunks) {
+        if (chunk->x > areaMax.x || chunk->z > areaMax.y) {
+            continue;
+        }
+        // chunk may be loaded or saved by the level since the tile started
+        if (level.chunks->getChunk(chunk->x, chunk->z) ||
+            regions.hasVoxels(chunk->x, chunk->z)) {
+            continue;
+        }
+        regions.put(chunk.get(), {});
+        chunksSaved++;
+    }
+}
+
+void ChunksPregenerator::writeProgress(size_t tilesDone) {
+    auto root = dv::object();
+    auto& area = root.list("area");
+    area.add(areaMin.x);
+    area.add(areaMin.y);
+    area.add(areaMax.x);
+    area.add(areaMax.y);
+    root["tiles-done"] = static_cast<dv::integer_t>(tilesDone);
+    io::write_json(level.getWorld()->wfile->getPregenerationFile(), root);
+}
+
+void ChunksPregenerator::write() {
+    auto& regions = level.getWorld()->wfile->getRegions();
+    // tiles saved before the previous write are on disk now
+    regions.waitSaving();
+    writeProgress(tilesWritten);
+    tilesWritten = tilesDonePrefix;
+    regions.writeAllAsync(regions.createSnapshot());
+    lastWrite = std::chrono::steady_clock::now();
+}
+
+void ChunksPregenerator::finish() {
+    write();
+    level.getWorld()->wfile->getRegions().waitSaving();
+    io::remove(level.getWorld()->wfile->getPregenerationFile());
+    active = false;
+    pool->terminate();
+
+    auto seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - startTime
+    );
+    logger.info() << "pre-generation finished: " << chunksSaved
+                  << " chunks saved in " << seconds.count() << " s";
+}
+
+void ChunksPregenerator::update(int64_t maxDuration) {
+    VC_PROFILE_ZONE("ChunksPregenerator::update");
+    if (!active) {
+        return;
+    }
+    timeutil::Timer timer;
+    pool->pullResults();
+    while (!results.empty() && timer.stop() < maxDuration) {
+        save(std::move(results.back()));
+        results.pop_back();
+    }
+    prepareNext(timer, maxDuration);
+    if (!active) {
+        return;
+    }
+    if (tilesDonePrefix == tiles.size()) {
+        finish();
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now - lastWrite >= WRITE_INTERVAL) {
+        write();
+    }
+    if (now - lastReport >= REPORT_INTERVAL) {
+        lastReport = now;
+        logger.info() << "pre-generated " << chunksDone << "/" << chunksTotal
+                      << " chunks (" << static_cast<int>(getSpeed())
+                      << " chunks/s)";
+    }
+}
+
+void ChunksPregenerator::update() {
+    update(std::numeric_limits<int64_t>::max());
+}
+
+void ChunksPregenerator::terminate() {
+    if (!active) {
+        return;
+    }
+    active = false;
+    pool->terminate();
+    // saved chunks are written with the world, the rest are generated
+    // by the level when loaded
+    writeProgress(tilesDonePrefix);
+    logger.info() << "pre-generation stopped at " << chunksDone << "/"
+                  << chunksTotal << " chunks";
+}
+
+bool ChunksPregenerator::isActive() const {
+    return active;
+}
+
+void ChunksPregenerator::waitForEnd() {
+    using namespace std::chrono_literals;
+    while (active) {
+        std::this_thread::sleep_for(2ms);
+        update();
+    }
+}
+
+uint ChunksPregenerator::getWorkTotal() const {
+    return chunksTotal;
+}
+
+uint ChunksPregenerator::getWorkDone() const {
+    return chunksDone;
+}
+
+double ChunksPregenerator::getSpeed() const {
+    auto seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - startTime
+    );
+    uint chunks = chunksDone - chunksResumed;
+    return seconds.count() > 0.0 ? chunks / seconds.count() : 0.0;
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+
+#include "interfaces/Task.hpp"
+#include "typedefs.hpp"
+#include "util/ThreadPool.hpp"
+
+class Level;
+class Chunk;
+class WorldGenerator;
+namespace timeutil {
+    class Timer;
+}
+struct ChunkPrototype;
+struct ChunksSettings;
+
+struct PregenerationJob {
+    /// @brief Index of the tile in the pre-generation order
+    size_t tile;
+    /// @brief Position of the first tile chunk including the margin
+    glm::ivec2 origin;
+    /// @brief Prepared prototypes of the tile chunks including the margin,
+    /// row by row
+    std::vector<std::shared_ptr<const ChunkPrototype>> prototypes;
+};
+
+struct PregenerationResult {
+    size_t tile;
+    /// @brief Generated and lit chunks of the tile without the margin
+    std::vector<std::shared_ptr<Chunk>> chunks;
+    /// @brief Error message if generation failed
+    std::string error;
+};
+
+/// @brief Pre-generation of a chunks area directly into the world regions
+/// without loading chunks to the level.
+///
+/// The area is split into square tiles processed nearest to the area
+/// center first. Tile chunk prototypes are prepared in the main thread by
+/// own world generator, then voxels are generated and lights are built by
+/// workers in an isolated chunks matrix including one chunk margin around
+/// the tile, so lights of the saved chunks are complete. Chunks already
+/// saved or loaded are kept.
+///
+/// Progress is written to the world pre-generation file along with the
+/// background regions writes, so interrupted pre-generation is continued
+/// by resume().
+class ChunksPregenerator : public Task {
+    Level& level;
+    const bool lighting;
+    std::unique_ptr<WorldGenerator> generator;
+    std::unique_ptr<util::ThreadPool<PregenerationJob, PregenerationResult>>
+        pool;
+
+    /// @brief Area bounds (chunks, inclusive)
+    glm::ivec2 areaMin;
+    glm::ivec2 areaMax;
+    /// @brief Tiles positions in the processing order
+    std::vector<glm::ivec2> tiles;
+    std::vector<bool> tilesDone;
+    /// @brief Number of the first tiles done
+    size_t tilesDonePrefix = 0;
+    /// @brief tilesDonePrefix at the last background regions write
+    size_t tilesWritten = 0;
+    /// @brief Next tile to enqueue
+    size_t nextTile = 0;
+    /// @brief Job being prepared (prototypes are prepared gradually)
+    std::optional<PregenerationJob> preparing;
+    size_t tilesInWork = 0;
+    /// @brief Results waiting to be saved
+    std::vector<PregenerationResult> results;
+
+    bool active = true;
+
+    uint chunksTotal = 0;
+    uint chunksDone = 0;
+    /// @brief Chunks done by the interrupted pre-generation
+    uint chunksResumed = 0;
+    uint chunksSaved = 0;
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point lastWrite;
+    std::chrono::steady_clock::time_point lastReport;
+
+    /// @brief Prepare prototypes of the next tiles and enqueue them
+    void prepareNext(timeutil::Timer& timer, int64_t maxDuration);
+    void save(PregenerationResult&& result);
+    void markDone(size_t tile);
+    /// @return number of the tile chunks inside of the area
+    uint countTileChunks(size_t tile) const;
+    /// @return false if all tile chunks are saved or loaded
+    bool isTileMissing(size_t tile) const;
+    /// @brief Start background regions write and store progress of the
+    /// previous one
+    void write();
+    void writeProgress(size_t tilesDone);
+    void finish();
+public:
+    /// @param areaMin area first chunk position
+    /// @param areaMax area last chunk position (inclusive)
+    /// @param lighting build chunks lights
+    /// @param tilesDone number of tiles done by the interrupted
+    /// pre-generation of the same area
+    ChunksPregenerator(
+        Level& level,
+        const ChunksSettings& settings,
+        glm::ivec2 areaMin,
+        glm::ivec2 areaMax,
+        bool lighting,
+        size_t tilesDone = 0
+    );
+    ~ChunksPregenerator();
+
+    /// @brief Continue interrupted pre-generation of the world
+    /// @return nullptr if no pre-generation progress found
+    static std::unique_ptr<ChunksPregenerator> resume(
+        Level& level, const ChunksSettings& settings, bool lighting
+    );
+
+    /// @brief Prepare chunks and save generated ones for the given time
+    /// @param maxDuration microseconds spent in the main thread
+    void update(int64_t maxDuration);
+
+    void update() override;
+    void terminate() override;
+    bool isActive() const override;
+    void waitForEnd() override;
+    uint getWorkTotal() const override;
+    uint getWorkDone() const override;
+
+    /// @return chunks processed per second since start
+    double getSpeed() const;
+
+    const glm::ivec2& getAreaMin() const {
+        return areaMin;
+    }
+
+    const glm::ivec2& getAreaMax() const {
+        return areaMax;
+    }
+};
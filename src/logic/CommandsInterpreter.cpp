@@ -8,6 +8,9 @@
 
 using namespace cmd;
 
+/// @brief Max cached prompts (cache is cleared on overflow)
+inline constexpr size_t MAX_CACHED_PROMPTS = 1024;
+
 inline bool is_cmd_identifier_part(char c, bool allowColon) {
     return is_identifier_part(c) || c == '.' || c == '$' ||
            (allowColon && c == ':');
@@ -18,6 +21,16 @@ inline bool is_cmd_identifier_start(char c) {
 }
 
 class CommandParser : BasicParser<char> {
+    /// @brief Parsed prompt reads interpreter variables
+    bool readsVariables = false;
+
+    dv::value& getVariable(
+        CommandsInterpreter* interpreter, const std::string& name
+    ) {
+        readsVariables = true;
+        return (*interpreter)[name];
+    }
+
     std::string parseIdentifier(bool allowColon) {
         char c = peek();
         if (!is_identifier_start(c) && c != '$') {
@@ -271,7 +284,7 @@ public:
         if (dv::is_numeric(arg->origin)) {
             return dv::value(arg->origin);
         } else if (arg->origin.getType() == dv::value_type::string) {
-            return dv::value((*interpreter)[arg->origin.asString()]);
+            return dv::value(getVariable(interpreter, arg->origin.asString()));
         }
         return nullptr;
     }
@@ -353,7 +366,7 @@ public:
                 if (value.isString()) {
                     const auto& string = value.asString();
                     if (string[0] == '$') {
-                        value = (*interpreter)[string.substr(1)];
+                        value = getVariable(interpreter, string.substr(1));
                     }
                 }
 
@@ -371,7 +384,7 @@ public:
                     if (arg->def.isString()) {
                         const auto& string = arg->def.asString();
                         if (string[0] == '$') {
-                            args.add((*interpreter)[string.substr(1)]);
+                            args.add(getVariable(interpreter, string.substr(1)));
                         } else {
                             args.add(arg->def);
                         }
@@ -402,7 +415,7 @@ public:
                 if (arg->def.isString()) {
                     const auto& string = arg->def.asString();
                     if (string[0] == '$') {
-                        args.add((*interpreter)[string.substr(1)]);
+                        args.add(getVariable(interpreter, string.substr(1)));
                         continue;
                     }
                 }
@@ -411,6 +424,10 @@ public:
         }
         return Prompt {command, std::move(args), std::move(kwargs)};
     }
+
+    bool isReadingVariables() const {
+        return readsVariables;
+    }
 };
 
 Command Command::create(
@@ -429,6 +446,7 @@ void CommandsRepository::add(
 ) {
     Command command = Command::create(scheme, description, std::move(executor));
     commands[command.getName()] = command;
+    revision++;
 }
 
 Command* CommandsRepository::get(const std::string& name) {
@@ -440,5 +458,46 @@ Command* CommandsRepository::get(const std::string& name) {
 }
 
 Prompt CommandsInterpreter::parse(std::string_view text) {
-    return CommandParser("[string]", text).parsePrompt(this);
+    if (promptsRevision != repository->getRevision()) {
+        // cached prompts may refer to replaced commands
+        prompts.clear();
+        promptsRevision = repository->getRevision();
+    }
+    std::string key(text);
+    const auto& found = prompts.find(key);
+    if (found != prompts.end()) {
+        return found->second;
+    }
+    CommandParser parser("[string]", text);
+    auto prompt = parser.parsePrompt(this);
+    if (!parser.isReadingVariables()) {
+        if (prompts.size() >= MAX_CACHED_PROMPTS) {
+            prompts.clear();
+        }
+        prompts[std::move(key)] = prompt;
+    }
+    return prompt;
+}
+
+dv::value CommandsInterpreter::executeBatch(
+    const std::vector<std::string>& inputs,
+    std::unordered_map<size_t, std::string>& errors
+) {
+    auto results = dv::list();
+    for (size_t i = 0; i < inputs.size(); i++) {
+        try {
+            results.add(execute(inputs[i]));
+        } catch (const parsing_error& err) {
+            if (std::string(err.what()).find("unknown command ") == 0) {
+                errors[i] = err.what();
+            } else {
+                errors[i] = err.errorLog();
+            }
+            results.add(nullptr);
+        } catch (const std::exception& err) {
+            errors[i] = err.what();
+            results.add(nullptr);
+        }
+    }
+    return results;
 }
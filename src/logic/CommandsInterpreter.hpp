@@ -116,6 +116,8 @@ namespace cmd {
 
     class CommandsRepository {
         std::unordered_map<std::string, Command> commands;
+        /// @brief Incremented on commands change
+        uint64_t revision = 0;
     public:
         void add(
             std::string_view scheme, std::string_view description, executor_func
@@ -128,12 +130,21 @@ namespace cmd {
 
         void clear() {
             commands.clear();
+            revision++;
+        }
+
+        uint64_t getRevision() const {
+            return revision;
         }
     };
 
     class CommandsInterpreter {
         std::unique_ptr<CommandsRepository> repository;
         std::unordered_map<std::string, dv::value> variables;
+        /// @brief Parsed prompts not reading variables by input text
+        std::unordered_map<std::string, Prompt> prompts;
+        /// @brief Repository revision the prompts are parsed with
+        uint64_t promptsRevision = 0;
     public:
         CommandsInterpreter()
             : repository(std::make_unique<CommandsRepository>()) {
@@ -145,6 +156,8 @@ namespace cmd {
             : repository(std::move(repository)) {
         }
 
+        /// @brief Parse prompt. Prompts not reading variables are cached
+        /// until the repository commands change
         Prompt parse(std::string_view text);
 
         dv::value execute(std::string_view input) {
@@ -155,6 +168,16 @@ namespace cmd {
             return prompt.command->execute(this, prompt);
         }
 
+        /// @brief Execute commands in order. Failed commands do not stop
+        /// the batch
+        /// @param errors [out] error messages of the failed commands by
+        /// input index
+        /// @return list of the commands results (null for failed ones)
+        dv::value executeBatch(
+            const std::vector<std::string>& inputs,
+            std::unordered_map<size_t, std::string>& errors
+        );
+
         dv::value& operator[](const std::string& name) {
             return variables[name];
         }
@@ -166,6 +189,7 @@ namespace cmd {
         void reset() {
             repository->clear();
             variables.clear();
+            prompts.clear();
         }
     };
 }
@@ -109,6 +109,21 @@ static ConfirmRequest create_convert_request(
     return request;
 }
 
+/// @brief Write new indices and let regions be converted on access
+static void convert_lazily(
+    WorldFiles& worldFiles, const ContentReport& report, const Content* content
+) {
+    std::vector<blockid_t> table(report.blocks.count());
+    for (size_t i = 0; i < table.size(); i++) {
+        table[i] = report.blocks.getId(i);
+    }
+    worldFiles.getRegions().remapBlocks(std::move(table));
+
+    auto patch = dv::object();
+    WorldFiles::createContentIndicesCache(content->getIndices(), patch);
+    worldFiles.patchIndicesFile(patch);
+}
+
 static void call(Engine& engine, runnable func) {
     if (engine.isHeadless()) {
         func();
@@ -219,6 +234,30 @@ static void confirm(
     }
 }
 
+void EngineController::compactWorld(const std::string& name) {
+    auto& paths = engine.getPaths();
+    auto folder = paths.getWorldFolderByName(name);
+    check_world(paths, folder);
+    auto worldFiles = std::make_shared<WorldFiles>(
+        folder, engine.getSettings().debug
+    );
+    auto task = WorldConverter::startTask(
+        worldFiles,
+        nullptr,
+        nullptr,
+        [this]() {
+            engine.postRunnable([this]() {
+                if (!engine.isHeadless()) {
+                    engine.setScreen(std::make_shared<MenuScreen>(engine));
+                }
+            });
+        },
+        ConvertMode::COMPACT,
+        true
+    );
+    start(engine, std::move(task), L"Compacting world...");
+}
+
 void EngineController::openWorld(const std::string& name, bool confirmConvert) {
     auto& paths = engine.getPaths();
     auto& debugSettings = engine.getSettings().debug;
@@ -240,6 +279,13 @@ void EngineController::openWorld(const std::string& name, bool confirmConvert) {
 
     auto request = create_convert_request(report);
     confirm(engine, std::move(request), confirmConvert, [=]() {
+        if (report->isLazyConvertible()) {
+            convert_lazily(*worldFiles, *report, content);
+            load_world(engine, worldFiles, localPlayer);
+            return;
+        }
+        // converter expects regions to match the current indices
+        worldFiles->getRegions().finishRemap();
         auto task = create_converter(
             engine,
             worldFiles,
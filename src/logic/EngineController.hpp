@@ -26,6 +26,11 @@ public:
     /// @param name world name
     void deleteWorld(const std::string& name);
 
+    /// @brief Rewrite world region files to remove fragmentation.
+    /// World must not be open
+    /// @param name world name
+    void compactWorld(const std::string& name);
+
     void reconfigPacks(
         LevelController* controller,
         const std::vector<std::string>& packsToAdd,
@@ -2,33 +2,46 @@
 
 #include <algorithm>
 
+#include "debug/Allocations.hpp"
 #include "debug/Logger.hpp"
+#include "debug/Profiler.hpp"
 #include "engine/Engine.hpp"
 #include "engine/EnginePaths.hpp"
 #include "world/files/WorldFiles.hpp"
 #include "maths/voxmaths.hpp"
 #include "objects/Entities.hpp"
+#include "objects/Entity.hpp"
 #include "objects/Players.hpp"
 #include "objects/Player.hpp"
 #include "physics/Hitbox.hpp"
 #include "voxels/Chunks.hpp"
+#include "voxels/GlobalChunks.hpp"
 #include "voxels/Pathfinding.hpp"
 #include "scripting/scripting.hpp"
 #include "lighting/Lighting.hpp"
 #include "settings.hpp"
+#include "world/InterestManager.hpp"
 #include "world/LevelEvents.hpp"
 #include "world/Level.hpp"
+#include "world/SimulationArea.hpp"
 #include "world/World.hpp"
 
 static debug::Logger logger("level-control");
 
+/// @brief Main thread time spent on chunks pre-generation per update
+/// (microseconds)
+const int64_t PREGENERATION_BUDGET = 4000;
+
+/// @brief Max chunks packed per second (see GlobalChunks::packIdle)
+const size_t MAX_PACKED_CHUNKS = 64;
+
 LevelController::LevelController(
     Engine& engine, std::unique_ptr<Level> levelPtr, Player* clientPlayer
 )
     : engine(engine),
       settings(engine.getSettings()),
       level(std::move(levelPtr)),
-      chunks(std::make_unique<ChunksController>(*level)),
+      chunks(std::make_unique<ChunksController>(*level, settings.chunks)),
       playerTickClock(20, 3),
       clientPlayer(clientPlayer) {
     
@@ -39,10 +52,9 @@ LevelController::LevelController(
         scripting::on_chunk_remove(*chunk);
     });
 
+    // headless server runs in the no-lightmap mode
     if (clientPlayer) {
-        chunks->lighting = std::make_unique<Lighting>(
-            level->content, *clientPlayer->chunks
-        );
+        chunks->enableLighting(*clientPlayer->chunks);
     }
     blocks = std::make_unique<BlocksController>(
         *level, chunks ? chunks->lighting.get() : nullptr
@@ -63,7 +75,7 @@ LevelController::LevelController(
                 std::floor(position.x), std::floor(position.z), 1
             );
             chunks->update(16, 1, 0, *player, player.get() == clientPlayer);
-            if (player->chunks->get(
+            if (player->chunks->getVoxel(
                     std::floor(position.x), 0, std::floor(position.z)
                 )) {
                 confirmed++;
@@ -73,8 +85,12 @@ LevelController::LevelController(
 }
 
 void LevelController::update(float delta, bool pause) {
+    debug::allocations::begin_tick();
+    VC_PROFILE_ZONE("LevelController::update");
     level->pathfinding->performAllAsync(
-        settings.pathfinding.stepsPerAsyncAgent.get()
+        settings.pathfinding.stepsPerAsyncAgent.get(),
+        settings.pathfinding.stepsPerTick.get(),
+        settings.pathfinding.sharedFieldTicks.get()
     );
     for (const auto& [_, player] : *level->players) {
         if (player->isSuspended()) {
@@ -96,6 +112,15 @@ void LevelController::update(float delta, bool pause) {
             player.get() == clientPlayer
         );
     }
+    if (pregenerator) {
+        pregenerator->update(PREGENERATION_BUDGET);
+        if (!pregenerator->isActive()) {
+            pregenerator.reset();
+        }
+    }
+    level->simulation->update(
+        *level->players, level->getWorld()->getInfo().simulation
+    );
     if (!pause) {
         // update all objects that needed
         blocks->update(delta, settings.chunks.padding.get());
@@ -109,7 +134,7 @@ void LevelController::update(float delta, bool pause) {
                     playerTickClock.getPart()) {
                     
                     const auto& position = player->getPosition();
-                    if (player->chunks->get(
+                    if (player->chunks->getVoxel(
                         std::floor(position.x),
                         std::floor(position.y),
                         std::floor(position.z)
@@ -122,11 +147,60 @@ void LevelController::update(float delta, bool pause) {
             }
         }
     }
+    // block changes of the tick are lit at once
+    if (chunks->lighting) {
+        chunks->lighting->flush();
+    }
     level->entities->clean();
+    updateInterests();
+
+    // not accessed regions of lazily converted world are converted slowly
+    remapTimer += delta;
+    if (remapTimer >= 1.0f) {
+        remapTimer = 0.0f;
+        level->getWorld()->wfile->getRegions().convertPendingRegions(1);
+    }
+
+    // voxels of chunks not accessed for a while are stored paletted
+    packTimer += delta;
+    if (packTimer >= 1.0f) {
+        packTimer = 0.0f;
+        if (int delay = settings.chunks.packDelay.get()) {
+            level->chunks->packIdle(delay, MAX_PACKED_CHUNKS);
+        }
+    }
+    debug::allocations::end_tick();
+}
+
+void LevelController::updateInterests() {
+    auto& interests = *level->interests;
+    if (interests.empty()) {
+        return;
+    }
+    VC_PROFILE_ZONE("LevelController::updateInterests");
+    std::vector<InterestObserver> observers;
+    for (const auto& [id, player] : *level->players) {
+        if (!player->isSuspended()) {
+            observers.push_back({id, player->getPosition()});
+        }
+    }
+    auto& entities = *level->entities;
+    interests.update(
+        observers,
+        [&entities](const glm::vec3& center, float radius, auto& dst) {
+            for (const auto& entity : entities.getAllInRadius(center, radius)) {
+                dst.push_back(entity.getUID());
+            }
+        }
+    );
 }
 
 void LevelController::processBeforeQuit() {
     preQuitCallbacks.notify();
+    stopPregeneration();
+    if (chunks->lighting) {
+        chunks->lighting->flush();
+    }
     // todo: move somewhere else
     for (auto player : level->players->getAll()) {
         if (player->chunks) {
@@ -136,7 +210,7 @@ void LevelController::processBeforeQuit() {
     scripting::process_before_quit();
 }
 
-void LevelController::saveWorld() {
+void LevelController::saveWorld(bool background) {
     auto world = level->getWorld();
     if (world->isNameless()) {
         logger.info() << "nameless world will not be saved";
@@ -145,8 +219,11 @@ void LevelController::saveWorld() {
     logger.info() << "writing world '" << world->getName() << "'";
     world->wfile->createDirectories();
     scripting::on_world_save();
+    if (chunks->lighting) {
+        chunks->lighting->flush();
+    }
     level->onSave();
-    level->getWorld()->write(level.get());
+    level->getWorld()->write(level.get(), background);
 }
 
 void LevelController::onWorldQuit() {
@@ -165,3 +242,31 @@ BlocksController* LevelController::getBlocksController() {
 ChunksController* LevelController::getChunksController() {
     return chunks.get();
 }
+
+void LevelController::startPregeneration(
+    glm::ivec2 areaMin, glm::ivec2 areaMax
+) {
+    stopPregeneration();
+    pregenerator = std::make_unique<ChunksPregenerator>(
+        *level, settings.chunks, areaMin, areaMax, chunks->lighting != nullptr
+    );
+}
+
+bool LevelController::resumePregeneration() {
+    stopPregeneration();
+    pregenerator = ChunksPregenerator::resume(
+        *level, settings.chunks, chunks->lighting != nullptr
+    );
+    return pregenerator != nullptr;
+}
+
+void LevelController::stopPregeneration() {
+    if (pregenerator) {
+        pregenerator->terminate();
+        pregenerator.reset();
+    }
+}
+
+const ChunksPregenerator* LevelController::getPregenerator() const {
+    return pregenerator.get();
+}
@@ -4,6 +4,7 @@
 
 #include "BlocksController.hpp"
 #include "ChunksController.hpp"
+#include "ChunksPregenerator.hpp"
 #include "util/Clock.hpp"
 #include "util/CallbacksSet.hpp"
 
@@ -20,10 +21,19 @@ class LevelController {
     // Sub-controllers
     std::unique_ptr<BlocksController> blocks;
     std::unique_ptr<ChunksController> chunks;
+    /// @brief Running chunks pre-generation (may be nullptr)
+    std::unique_ptr<ChunksPregenerator> pregenerator;
 
     util::Clock playerTickClock;
+    /// @brief Lazy world conversion step timer
+    float remapTimer = 0.0f;
+    /// @brief Idle chunks packing timer
+    float packTimer = 0.0f;
 
     Player* clientPlayer;
+
+    /// @brief Update entities observed by players with interest radius set
+    void updateInterests();
 public:
     CallbacksSet<> preQuitCallbacks;
 
@@ -34,7 +44,9 @@ public:
     void update(float delta, bool pause);
 
     void processBeforeQuit();
-    void saveWorld();
+    /// @param background write chunks in background
+    /// (see World::write)
+    void saveWorld(bool background = false);
 
     void onWorldQuit();
 
@@ -42,4 +54,20 @@ public:
 
     BlocksController* getBlocksController();
     ChunksController* getChunksController();
+
+    /// @brief Start pre-generation of the chunks area replacing the
+    /// running one
+    /// @param areaMin area first chunk position
+    /// @param areaMax area last chunk position (inclusive)
+    void startPregeneration(glm::ivec2 areaMin, glm::ivec2 areaMax);
+
+    /// @brief Continue interrupted chunks pre-generation of the world
+    /// @return false if no pre-generation progress found
+    bool resumePregeneration();
+
+    /// @brief Stop chunks pre-generation keeping its progress
+    void stopPregeneration();
+
+    /// @return running chunks pre-generation or nullptr
+    const ChunksPregenerator* getPregenerator() const;
 };
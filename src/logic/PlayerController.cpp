@@ -236,7 +236,7 @@ void PlayerController::onFootstep(const Hitbox& hitbox) {
             int x = std::floor(pos.x + half.x * offsetX);
             int y = std::floor(pos.y - half.y * 1.1f);
             int z = std::floor(pos.z + half.z * offsetZ);
-            auto vox = player.chunks->get(x, y, z);
+            auto vox = player.chunks->getVoxel(x, y, z);
             if (vox) {
                 auto& def = level.content.getIndices()->blocks.require(vox->id);
                 if (!def.obstacle) {
@@ -41,9 +41,12 @@ extern const luaL_Reg particleslib[]; // gfx.particles
 extern const luaL_Reg pathfindinglib[];
 extern const luaL_Reg playerlib[];
 extern const luaL_Reg posteffectslib[]; // gfx.posteffects
+extern const luaL_Reg profilerlib[];
 extern const luaL_Reg quatlib[];
 extern const luaL_Reg randomlib[];
 extern const luaL_Reg compressionlib[];
+extern const luaL_Reg systemlib[]; // worker systems states
+extern const luaL_Reg systemslib[];
 extern const luaL_Reg text3dlib[]; // gfx.text3d
 extern const luaL_Reg timelib[];
 extern const luaL_Reg tomllib[];
@@ -5,14 +5,16 @@
 
 static int l_get_vel(lua::State* L) {
     if (auto entity = get_entity(L, 1)) {
-        return lua::pushvec3(L, entity->getRigidbody().hitbox.velocity);
+        return lua::pushvec_out(L, 2, entity->getRigidbody().hitbox.velocity);
     }
     return 0;
 }
 
 static int l_set_vel(lua::State* L) {
     if (auto entity = get_entity(L, 1)) {
-        entity->getRigidbody().hitbox.velocity = lua::tovec3(L, 2);
+        auto& hitbox = entity->getRigidbody().hitbox;
+        hitbox.velocity = lua::tovec3(L, 2);
+        hitbox.wake();
     }
     return 0;
 }
@@ -33,14 +35,18 @@ static int l_set_enabled(lua::State* L) {
 
 static int l_get_size(lua::State* L) {
     if (auto entity = get_entity(L, 1)) {
-        return lua::pushvec3(L, entity->getRigidbody().hitbox.halfsize * 2.0f);
+        return lua::pushvec_out(
+            L, 2, entity->getRigidbody().hitbox.halfsize * 2.0f
+        );
     }
     return 0;
 }
 
 static int l_set_size(lua::State* L) {
     if (auto entity = get_entity(L, 1)) {
-        entity->getRigidbody().hitbox.halfsize = lua::tovec3(L, 2) * 0.5f;
+        auto& hitbox = entity->getRigidbody().hitbox;
+        hitbox.halfsize = lua::tovec3(L, 2) * 0.5f;
+        hitbox.wake();
     }
     return 0;
 }
@@ -60,6 +66,7 @@ static int l_set_gravity_scale(lua::State* L) {
         } else {
             hitbox.gravityScale = lua::tonumber(L, 2);
         }
+        hitbox.wake();
     }
     return 0;
 }
@@ -125,13 +132,13 @@ static int l_get_body_type(lua::State* L) {
 
 static int l_set_body_type(lua::State* L) {
     if (auto entity = get_entity(L, 1)) {
-        if (!BodyTypeMeta.getItem(
-                lua::tostring(L, 2), entity->getRigidbody().hitbox.type
-            )) {
+        auto& hitbox = entity->getRigidbody().hitbox;
+        if (!BodyTypeMeta.getItem(lua::tostring(L, 2), hitbox.type)) {
             throw std::runtime_error(
                 "unknown body type " + util::quote(lua::tostring(L, 2))
             );
         }
+        hitbox.wake();
     }
     return 0;
 }
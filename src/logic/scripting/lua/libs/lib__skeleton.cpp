@@ -75,6 +75,7 @@ static int l_set_matrix(lua::State* L) {
     if (auto skeleton = get_skeleton(L)) {
         auto index = index_range_check(*skeleton, lua::tointeger(L, 2));
         skeleton->pose.matrices[index] = lua::tomat4(L, 3);
+        skeleton->dirty = true;
     }
     return 0;
 }
@@ -21,7 +21,7 @@ static void check_valid(const glm::mat3& vec) {
 
 static int l_get_pos(lua::State* L) {
     if (auto entity = get_entity(L, 1)) {
-        return lua::pushvec3(L, entity->getTransform().pos);
+        return lua::pushvec_out(L, 2, entity->getTransform().pos);
     }
     return 0;
 }
@@ -31,14 +31,16 @@ static int l_set_pos(lua::State* L) {
         auto vec = lua::tovec3(L, 2);
         check_valid(vec);
         entity->getTransform().setPos(vec);
-        entity->getRigidbody().hitbox.position = vec;
+        auto& hitbox = entity->getRigidbody().hitbox;
+        hitbox.position = vec;
+        hitbox.wake();
     }
     return 0;
 }
 
 static int l_get_size(lua::State* L) {
     if (auto entity = get_entity(L, 1)) {
-        return lua::pushvec3(L, entity->getTransform().size);
+        return lua::pushvec_out(L, 2, entity->getTransform().size);
     }
     return 0;
 }
@@ -68,6 +70,45 @@ static int l_set_rot(lua::State* L) {
     return 0;
 }
 
+/// @brief Get position and velocity resolving entity once
+static int l_get_state(lua::State* L) {
+    if (auto entity = get_entity(L, 1)) {
+        lua::pushvec_out(L, 2, entity->getTransform().pos);
+        lua::pushvec_out(L, 3, entity->getRigidbody().hitbox.velocity);
+        return 2;
+    }
+    return 0;
+}
+
+/// @brief Set position, rotation and velocity (nil to keep) resolving
+/// entity once
+static int l_set_state(lua::State* L) {
+    auto entity = get_entity(L, 1);
+    if (!entity) {
+        return 0;
+    }
+    auto& transform = entity->getTransform();
+    auto& hitbox = entity->getRigidbody().hitbox;
+    if (!lua::isnoneornil(L, 2)) {
+        auto vec = lua::tovec3(L, 2);
+        check_valid(vec);
+        transform.setPos(vec);
+        hitbox.position = vec;
+    }
+    if (!lua::isnoneornil(L, 3)) {
+        auto matrix = lua::tomat4(L, 3);
+        check_valid(matrix);
+        transform.setRot(matrix);
+    }
+    if (!lua::isnoneornil(L, 4)) {
+        auto vec = lua::tovec3(L, 4);
+        check_valid(vec);
+        hitbox.velocity = vec;
+    }
+    hitbox.wake();
+    return 0;
+}
+
 const luaL_Reg transformlib[] = {
     {"get_pos", lua::wrap<l_get_pos>},
     {"set_pos", lua::wrap<l_set_pos>},
@@ -75,5 +116,7 @@ const luaL_Reg transformlib[] = {
     {"set_size", lua::wrap<l_set_size>},
     {"get_rot", lua::wrap<l_get_rot>},
     {"set_rot", lua::wrap<l_set_rot>},
+    {"get_state", lua::wrap<l_get_state>},
+    {"set_state", lua::wrap<l_set_state>},
     {nullptr, nullptr}
 };
@@ -275,12 +275,12 @@ static int l_reopen_world(lua::State*) {
     return 0;
 }
 
-/// @brief Save world
+/// @brief Save world. Regions are written in background
 static int l_save_world(lua::State* L) {
     if (controller == nullptr) {
         throw std::runtime_error("no world open");
     }
-    controller->saveWorld();
+    controller->saveWorld(true);
     return 0;
 }
 
@@ -308,6 +308,17 @@ static int l_delete_world(lua::State* L) {
     return 0;
 }
 
+/// @brief Defragment world region files
+/// @param name Name world
+static int l_compact_world(lua::State* L) {
+    if (controller != nullptr) {
+        throw std::runtime_error("world must be closed");
+    }
+    auto name = lua::require_string(L, 1);
+    engine->getController()->compactWorld(name);
+    return 0;
+}
+
 /// @brief Get engine version
 /// @return major, minor 
 static int l_get_version(lua::State* L) {
@@ -394,6 +405,7 @@ const luaL_Reg applib[] = {
     {"save_world", lua::wrap<l_save_world>},
     {"close_world", lua::wrap<l_close_world>},
     {"delete_world", lua::wrap<l_delete_world>},
+    {"compact_world", lua::wrap<l_compact_world>},
     /// other
     {"get_version", lua::wrap<l_get_version>},
     {"create_memory_device", lua::wrap<l_create_memory_device>},
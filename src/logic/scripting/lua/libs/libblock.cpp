@@ -7,10 +7,12 @@
 #include "logic/LevelController.hpp"
 #include "objects/Players.hpp"
 #include "voxels/Block.hpp"
+#include "voxels/BlocksBatch.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/Chunks.hpp"
 #include "voxels/voxel.hpp"
 #include "voxels/GlobalChunks.hpp"
+#include "voxels/VoxelsVolume.hpp"
 #include "voxels/blocks_agent.hpp"
 #include "world/Level.hpp"
 #include "maths/voxmaths.hpp"
@@ -91,6 +93,9 @@ static int l_seek_origin(lua::State* L) {
     );
 }
 
+/// @brief Changes collected by block.set calls made inside of block.batch
+static std::unique_ptr<BlocksBatch> blocks_batch;
+
 static int l_set(lua::State* L) {
     auto x = lua::tointeger(L, 1);
     auto y = lua::tointeger(L, 2);
@@ -101,6 +106,10 @@ static int l_set(lua::State* L) {
     if (static_cast<size_t>(id) >= indices->blocks.count()) {
         return 0;
     }
+    if (blocks_batch) {
+        blocks_batch->set(x, y, z, id, int2blockstate(state));
+        return 0;
+    }
     if (!blocks_agent::set(*level->chunks, x, y, z, id, int2blockstate(state))) {
         return 0;
     }
@@ -111,7 +120,7 @@ static int l_set(lua::State* L) {
     }
     if (chunksController->lighting) {
         Lighting& lighting = *chunksController->lighting;
-        lighting.onBlockSet(x, y, z, id);
+        lighting.onBlockSet(x, y, z);
     }
     if (!noupdate) {
         blocks->updateSides(x, y, z);
@@ -119,15 +128,123 @@ static int l_set(lua::State* L) {
     return 0;
 }
 
+static int l_batch(lua::State* L) {
+    bool noupdate = lua::toboolean(L, 2);
+    lua::pushvalue(L, 1);
+    if (blocks_batch) {
+        // nested batch is a part of the outer one
+        lua::call(L, 0, 0);
+        return 0;
+    }
+    blocks_batch = std::make_unique<BlocksBatch>();
+    try {
+        lua::call(L, 0, 0);
+    } catch (...) {
+        blocks_batch.reset();
+        throw;
+    }
+    auto batch = std::move(blocks_batch);
+    return lua::pushinteger(L, blocks->applyBatch(*batch, !noupdate));
+}
+
 static int l_get(lua::State* L) {
     auto x = lua::tointeger(L, 1);
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
-    auto vox = blocks_agent::get(*level->chunks, x, y, z);
-    int id = vox == nullptr ? -1 : vox->id;
+    auto vox = blocks_agent::get_voxel(*level->chunks, x, y, z);
+    int id = vox ? vox->id : -1;
     return lua::pushinteger(L, id);
 }
 
+/// @brief Max voxels count of block.get_area/set_area area
+static constexpr size_t MAX_AREA_VOLUME = 1 << 24;
+/// @brief Bytes per voxel of the area data: id and states (little-endian)
+static constexpr size_t AREA_VOXEL_SIZE = 4;
+
+static size_t check_area(int w, int h, int d) {
+    if (w <= 0 || h <= 0 || d <= 0) {
+        throw std::runtime_error("invalid area size");
+    }
+    size_t volume = static_cast<size_t>(w) * h * d;
+    if (volume > MAX_AREA_VOLUME) {
+        throw std::runtime_error("area is too big");
+    }
+    return volume;
+}
+
+static int l_get_area(lua::State* L) {
+    auto x = lua::tointeger(L, 1);
+    auto y = lua::tointeger(L, 2);
+    auto z = lua::tointeger(L, 3);
+    auto w = lua::tointeger(L, 4);
+    auto h = lua::tointeger(L, 5);
+    auto d = lua::tointeger(L, 6);
+    size_t volume = check_area(w, h, d);
+
+    VoxelsVolume area(x, y, z, w, h, d);
+    blocks_agent::get_voxels(*level->chunks, &area);
+    const voxel* voxels = area.getVoxels();
+
+    std::vector<ubyte> bytes(volume * AREA_VOXEL_SIZE);
+    for (size_t i = 0; i < volume; i++) {
+        blockid_t id = voxels[i].id;
+        blockstate_t states = blockstate2int(voxels[i].state);
+        ubyte* dst = bytes.data() + i * AREA_VOXEL_SIZE;
+        dst[0] = id & 0xFF;
+        dst[1] = id >> 8;
+        dst[2] = states & 0xFF;
+        dst[3] = states >> 8;
+    }
+    return lua::create_bytearray(L, bytes);
+}
+
+static int l_set_area(lua::State* L) {
+    auto x = lua::tointeger(L, 1);
+    auto y = lua::tointeger(L, 2);
+    auto z = lua::tointeger(L, 3);
+    auto w = lua::tointeger(L, 4);
+    auto h = lua::tointeger(L, 5);
+    auto d = lua::tointeger(L, 6);
+    bool noupdate = lua::toboolean(L, 8);
+    size_t volume = check_area(w, h, d);
+
+    auto bytes = lua::bytearray_as_string(L, 7);
+    if (bytes.size() != volume * AREA_VOXEL_SIZE) {
+        throw std::runtime_error(
+            "invalid area data size " + std::to_string(bytes.size()) +
+            " (" + std::to_string(volume * AREA_VOXEL_SIZE) + " expected)"
+        );
+    }
+    // collected into the current batch if called inside of block.batch
+    std::unique_ptr<BlocksBatch> ownBatch;
+    BlocksBatch* batch = blocks_batch.get();
+    if (batch == nullptr) {
+        ownBatch = std::make_unique<BlocksBatch>();
+        batch = ownBatch.get();
+    }
+
+    auto src = reinterpret_cast<const ubyte*>(bytes.data());
+    size_t blocksCount = indices->blocks.count();
+    size_t i = 0;
+    for (int ly = 0; ly < h; ly++) {
+        for (int lz = 0; lz < d; lz++) {
+            for (int lx = 0; lx < w; lx++, i++) {
+                const ubyte* data = src + i * AREA_VOXEL_SIZE;
+                blockid_t id = data[0] | data[1] << 8;
+                if (id == BLOCK_VOID || id >= blocksCount) {
+                    continue;
+                }
+                blockstate_t states = data[2] | data[3] << 8;
+                batch->set(x + lx, y + ly, z + lz, id, int2blockstate(states));
+            }
+        }
+    }
+    if (ownBatch == nullptr) {
+        return lua::pushinteger(L, 0);
+    }
+    return lua::pushinteger(L, blocks->applyBatch(*ownBatch, !noupdate));
+}
+
 template<int n>
 static int get_axis(lua::State* L, const Block& def, int rotation) {
     const CoordSystem& rot = def.rotations.variants[rotation];
@@ -147,8 +264,8 @@ static int get_axis(lua::State* L) {
     glm::ivec3 defAxis {};
     defAxis[n] = 1;
 
-    auto vox = blocks_agent::get(*level->chunks, x, y, z);
-    if (vox == nullptr) {
+    auto vox = blocks_agent::get_voxel(*level->chunks, x, y, z);
+    if (!vox) {
         return lua::pushivec_stack(L, defAxis);
     }
     const auto& def = level->content.getIndices()->blocks.require(vox->id);
@@ -175,8 +292,8 @@ static int l_get_rotation(lua::State* L) {
     auto x = lua::tointeger(L, 1);
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
-    auto vox = blocks_agent::get(*level->chunks, x, y, z);
-    int rotation = vox == nullptr ? 0 : vox->state.rotation;
+    auto vox = blocks_agent::get_voxel(*level->chunks, x, y, z);
+    int rotation = vox ? vox->state.rotation : 0;
     return lua::pushinteger(L, rotation);
 }
 
@@ -193,8 +310,8 @@ static int l_get_states(lua::State* L) {
     auto x = lua::tointeger(L, 1);
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
-    auto vox = blocks_agent::get(*level->chunks, x, y, z);
-    int states = vox == nullptr ? 0 : blockstate2int(vox->state);
+    auto vox = blocks_agent::get_voxel(*level->chunks, x, y, z);
+    int states = vox ? blockstate2int(vox->state) : 0;
     return lua::pushinteger(L, states);
 }
 
@@ -214,8 +331,11 @@ static int l_set_states(lua::State* L) {
     }
     int lx = x - cx * CHUNK_W;
     int lz = z - cz * CHUNK_D;
-    chunk->voxels[vox_index(lx, y, lz)].state = int2blockstate(states);
-    chunk->setModifiedAndUnsaved();
+    uint index = vox_index(lx, y, lz);
+    voxel vox = chunk->get(index);
+    vox.state = int2blockstate(states);
+    chunk->set(index, vox);
+    chunk->setModifiedAndUnsaved(y);
     return 0;
 }
 
@@ -227,8 +347,8 @@ static int l_get_user_bits(lua::State* L) {
     auto offset = lua::tointeger(L, 4) + VOXEL_USER_BITS_OFFSET;
     auto bits = lua::tointeger(L, 5);
 
-    auto vox = blocks_agent::get(*level->chunks, x, y, z);
-    if (vox == nullptr) {
+    auto vox = blocks_agent::get_voxel(*level->chunks, x, y, z);
+    if (!vox) {
         return lua::pushinteger(L, 0);
     }
     const auto& def = content->getIndices()->blocks.require(vox->id);
@@ -236,8 +356,10 @@ static int l_get_user_bits(lua::State* L) {
         auto origin = blocks_agent::seek_origin(
             *level->chunks, {x, y, z}, def, vox->state
         );
-        vox = blocks_agent::get(*level->chunks, origin.x, origin.y, origin.z);
-        if (vox == nullptr) {
+        vox = blocks_agent::get_voxel(
+            *level->chunks, origin.x, origin.y, origin.z
+        );
+        if (!vox) {
             return lua::pushinteger(L, 0);
         }
     }
@@ -250,8 +372,8 @@ static int l_get_variant(lua::State* L) {
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
 
-    auto vox = blocks_agent::get(*level->chunks, x, y, z);
-    if (vox == nullptr) {
+    auto vox = blocks_agent::get_voxel(*level->chunks, x, y, z);
+    if (!vox) {
         return lua::pushinteger(L, 0);
     }
     const auto& def = content->getIndices()->blocks.require(vox->id);
@@ -282,7 +404,7 @@ static int l_set_user_bits(lua::State* L) {
     }
     int lx = x - cx * CHUNK_W;
     int lz = z - cz * CHUNK_D;
-    auto vox = &chunk->voxels[vox_index(lx, y, lz)];
+    auto vox = &chunk->getVoxels()[vox_index(lx, y, lz)];
     const auto& def = content->getIndices()->blocks.require(vox->id);
     if (def.rt.extended) {
         auto origin = blocks_agent::seek_origin(chunks, {x, y, z}, def, vox->state);
@@ -310,7 +432,7 @@ static int l_set_variant(lua::State* L) {
     }
     int lx = x - cx * CHUNK_W;
     int lz = z - cz * CHUNK_D;
-    auto vox = &chunk->voxels[vox_index(lx, y, lz)];
+    auto vox = &chunk->getVoxels()[vox_index(lx, y, lz)];
     const auto& def = content->getIndices()->blocks.require(vox->id);
 
     if (def.variants == nullptr) {
@@ -441,7 +563,7 @@ static int l_place(lua::State* L) {
     if (static_cast<size_t>(id) >= indices->blocks.count()) {
         return 0;
     }
-    if (!blocks_agent::get(*level->chunks, x, y, z)) {
+    if (!blocks_agent::get_voxel(*level->chunks, x, y, z)) {
         return 0;
     }
     const auto def = level->content.getIndices()->blocks.get(id);
@@ -462,8 +584,8 @@ static int l_destruct(lua::State* L) {
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
     auto playerid = lua::gettop(L) >= 4 ? lua::tointeger(L, 4) : -1;
-    auto vox = blocks_agent::get(*level->chunks, x, y, z);
-    if (vox == nullptr) {
+    auto vox = blocks_agent::get_voxel(*level->chunks, x, y, z);
+    if (!vox) {
         return 0;
     }
     auto& def = level->content.getIndices()->blocks.require(vox->id);
@@ -472,6 +594,79 @@ static int l_destruct(lua::State* L) {
     return 0;
 }
 
+static int l_schedule_update(lua::State* L) {
+    auto x = lua::tointeger(L, 1);
+    auto y = lua::tointeger(L, 2);
+    auto z = lua::tointeger(L, 3);
+    auto delay = lua::tointeger(L, 4);
+    if (delay < 0) {
+        throw std::runtime_error("negative delay");
+    }
+    return lua::pushboolean(
+        L, controller->getBlocksController()->scheduleUpdate(x, y, z, delay)
+    );
+}
+
+static int l_cancel_update(lua::State* L) {
+    auto x = lua::tointeger(L, 1);
+    auto y = lua::tointeger(L, 2);
+    auto z = lua::tointeger(L, 3);
+    return lua::pushboolean(
+        L, controller->getBlocksController()->cancelUpdate(x, y, z)
+    );
+}
+
+/// @brief Read raycast filter table of block names or ids
+static std::set<blockid_t> read_raycast_filter(lua::State* L, int idx) {
+    std::set<blockid_t> filteredBlocks {};
+    if (!lua::istable(L, idx)) {
+        throw std::runtime_error("table expected for filter");
+    }
+    int addLen = lua::objlen(L, idx);
+    for (int i = 0; i < addLen; i++) {
+        lua::rawgeti(L, i + 1, idx);
+        if (lua::isnumber(L, -1)) {
+            auto id = lua::tointeger(L, -1);
+            if (indices->blocks.get(id)) {
+                filteredBlocks.insert(id);
+            }
+        } else {
+            auto blockName = std::string(lua::tostring(L, -1));
+            const Block* block = content->blocks.find(blockName);
+            if (block != nullptr) {
+                filteredBlocks.insert(block->rt.id);
+            }
+        }
+        lua::pop(L);
+    }
+    return filteredBlocks;
+}
+
+/// @brief Push raycast result fields into the table on top of the stack
+static void set_raycast_result(
+    lua::State* L,
+    const glm::vec3& start,
+    const glm::vec3& end,
+    const glm::ivec3& normal,
+    const glm::ivec3& iend,
+    blockid_t id
+) {
+    lua::pushvec3(L, end);
+    lua::setfield(L, "endpoint");
+
+    lua::pushvec3(L, normal);
+    lua::setfield(L, "normal");
+
+    lua::pushnumber(L, glm::distance(start, end));
+    lua::setfield(L, "length");
+
+    lua::pushvec3(L, iend);
+    lua::setfield(L, "iendpoint");
+
+    lua::pushinteger(L, id);
+    lua::setfield(L, "block");
+}
+
 static int l_raycast(lua::State* L) {
     auto start = lua::tovec<3>(L, 1);
     auto dir = lua::tovec<3>(L, 2);
@@ -480,20 +675,7 @@ static int l_raycast(lua::State* L) {
     std::set<blockid_t> filteredBlocks {};
     const int luaStackSize = lua::gettop(L);
     if (luaStackSize >= 5) {
-        if (lua::istable(L, 5)) {
-            int addLen = lua::objlen(L, 5);
-            for (int i = 0; i < addLen; i++) {
-                lua::rawgeti(L, i + 1, 5);
-                auto blockName = std::string(lua::tostring(L, -1));
-                const Block* block = content->blocks.find(blockName);
-                if (block != nullptr) {
-                    filteredBlocks.insert(block->rt.id);
-                }
-                lua::pop(L);
-            }
-        } else {
-            throw std::runtime_error("table expected for filter");
-        }
+        filteredBlocks = read_raycast_filter(L, 5);
     }
     if (luaStackSize >= 6) {
         includeNonSelectable = lua::toboolean(L, 6);
@@ -517,24 +699,76 @@ static int l_raycast(lua::State* L) {
         } else {
             lua::createtable(L, 0, 5);
         }
+        set_raycast_result(L, start, end, normal, iend, voxel->id);
+        return 1;
+    }
+    return 0;
+}
 
-        lua::pushvec3(L, end);
-        lua::setfield(L, "endpoint");
-
-        lua::pushvec3(L, normal);
-        lua::setfield(L, "normal");
-
-        lua::pushnumber(L, glm::distance(start, end));
-        lua::setfield(L, "length");
+static int l_raycast_batch(lua::State* L) {
+    if (!lua::istable(L, 1) || !lua::istable(L, 2)) {
+        throw std::runtime_error("tables expected for starts and directions");
+    }
+    auto maxDistance = lua::tonumber(L, 3);
+    std::set<blockid_t> filteredBlocks {};
+    const int luaStackSize = lua::gettop(L);
+    if (luaStackSize >= 4 && !lua::isnil(L, 4)) {
+        filteredBlocks = read_raycast_filter(L, 4);
+    }
+    bool includeNonSelectable =
+        luaStackSize >= 5 ? lua::toboolean(L, 5) : false;
 
-        lua::pushvec3(L, iend);
-        lua::setfield(L, "iendpoint");
+    // single start vector is shared by all rays
+    lua::rawgeti(L, 1, 1);
+    bool sharedStart = lua::isnumber(L, -1);
+    lua::pop(L);
+    glm::vec3 start {};
+    if (sharedStart) {
+        start = lua::tovec<3>(L, 1);
+    }
+    int count = lua::objlen(L, 2);
+    if (!sharedStart && lua::objlen(L, 1) < count) {
+        throw std::runtime_error("start position expected for each direction");
+    }
+    std::vector<blocks_agent::BlockRay> rays(count);
+    for (int i = 0; i < count; i++) {
+        auto& ray = rays[i];
+        if (sharedStart) {
+            ray.start = start;
+        } else {
+            lua::rawgeti(L, i + 1, 1);
+            ray.start = lua::tovec<3>(L, -1);
+            lua::pop(L);
+        }
+        lua::rawgeti(L, i + 1, 2);
+        ray.dir = lua::tovec<3>(L, -1);
+        lua::pop(L);
+        ray.maxDist = maxDistance;
+    }
+    std::vector<blocks_agent::BlockRayHit> hits(count);
+    blocks_agent::raycast_batch(
+        *level->chunks,
+        rays.data(),
+        count,
+        hits.data(),
+        filteredBlocks,
+        includeNonSelectable
+    );
 
-        lua::pushinteger(L, voxel->id);
-        lua::setfield(L, "block");
-        return 1;
+    lua::createtable(L, count, 0);
+    for (int i = 0; i < count; i++) {
+        const auto& hit = hits[i];
+        if (hit.vox == nullptr) {
+            lua::pushboolean(L, false);
+        } else {
+            lua::createtable(L, 0, 5);
+            set_raycast_result(
+                L, rays[i].start, hit.end, hit.norm, hit.iend, hit.vox->id
+            );
+        }
+        lua::rawseti(L, i + 1);
     }
-    return 0;
+    return 1;
 }
 
 static int l_compose_state(lua::State* L) {
@@ -614,7 +848,7 @@ static int l_get_field(lua::State* L) {
     auto lz = z - cz * CHUNK_W;
     size_t voxelIndex = vox_index(lx, y, lz);
 
-    const auto& vox = chunk->voxels[voxelIndex];
+    voxel vox = chunk->get(voxelIndex);
     const auto& def = content->getIndices()->blocks.require(vox.id);
     if (def.dataStruct == nullptr) {
         return 0;
@@ -683,7 +917,7 @@ static int l_set_field(lua::State* L) {
         return 0;
     }
     size_t voxelIndex = vox_index(lx, y, lz);
-    const auto& vox = chunk->voxels[voxelIndex];
+    voxel vox = chunk->get(voxelIndex);
 
     const auto& def = content->getIndices()->blocks.require(vox.id);
     if (def.dataStruct == nullptr) {
@@ -702,8 +936,7 @@ static int l_set_field(lua::State* L) {
     if (dst == nullptr) {
         dst = chunk->blocksMetadata.allocate(voxelIndex, dataStruct.size());
     }
-    chunk->flags.unsaved = true;
-    chunk->flags.blocksData = true;
+    chunk->setBlocksDataModified();
     return set_field(L, dst, *field, index, dataStruct, value);
 }
 
@@ -720,9 +953,11 @@ static int l_reload_script(lua::State* L) {
 
 static int l_has_tag(lua::State* L) {
     if (auto def = get_block_def(L)) {
-        auto tag = lua::require_string(L, 2);
+        int tag = lua::isnumber(L, 2)
+                      ? lua::tointeger(L, 2)
+                      : content->getTagIndex(lua::require_string(L, 2));
         const auto& tags = def->rt.tags;
-        return lua::pushboolean(L, tags.find(content->getTagIndex(tag)) != tags.end());
+        return lua::pushboolean(L, tags.find(tag) != tags.end());
     }
     return 0;
 }
@@ -770,11 +1005,14 @@ const luaL_Reg blocklib[] = {
     {"is_solid_at", lua::wrap<l_is_solid_at>},
     {"is_replaceable_at", lua::wrap<l_is_replaceable_at>},
     {"set", lua::wrap<l_set>},
+    {"batch", lua::wrap<l_batch>},
     {"get", lua::wrap<l_get>},
     {"get_X", lua::wrap<l_get_x>},
     {"get_Y", lua::wrap<l_get_y>},
     {"get_Z", lua::wrap<l_get_z>},
     {"get_states", lua::wrap<l_get_states>},
+    {"get_area", lua::wrap<l_get_area>},
+    {"set_area", lua::wrap<l_set_area>},
     {"set_states", lua::wrap<l_set_states>},
     {"get_rotation", lua::wrap<l_get_rotation>},
     {"set_rotation", lua::wrap<l_set_rotation>},
@@ -794,7 +1032,10 @@ const luaL_Reg blocklib[] = {
     {"get_picking_item", lua::wrap<l_get_picking_item>},
     {"place", lua::wrap<l_place>},
     {"destruct", lua::wrap<l_destruct>},
+    {"schedule_update", lua::wrap<l_schedule_update>},
+    {"cancel_update", lua::wrap<l_cancel_update>},
     {"raycast", lua::wrap<l_raycast>},
+    {"raycast_batch", lua::wrap<l_raycast_batch>},
     {"compose_state", lua::wrap<l_compose_state>},
     {"decompose_state", lua::wrap<l_decompose_state>},
     {"get_field", lua::wrap<l_get_field>},
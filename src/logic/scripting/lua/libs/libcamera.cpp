@@ -32,8 +32,9 @@ static int l_name(lua::State* L) {
     return lua::pushstring(L, indices.getName(index));
 }
 
+/// @brief vector getters write to the optional dst argument
 static int getter_pos(lua::State* L, const Camera& camera) {
-    return lua::pushvec3(L, camera.position);
+    return lua::pushvec_out(L, 2, camera.position);
 }
 
 static void setter_pos(lua::State* L, Camera& camera, int idx) {
@@ -78,13 +79,13 @@ static void setter_flipped(lua::State* L, Camera& camera, int idx) {
 }
 
 static int getter_front(lua::State* L, const Camera& camera) {
-    return lua::pushvec3(L, camera.front);
+    return lua::pushvec_out(L, 2, camera.front);
 }
 static int getter_right(lua::State* L, const Camera& camera) {
-    return lua::pushvec3(L, camera.right);
+    return lua::pushvec_out(L, 2, camera.right);
 }
 static int getter_up(lua::State* L, const Camera& camera) {
-    return lua::pushvec3(L, camera.up);
+    return lua::pushvec_out(L, 2, camera.up);
 }
 
 static int l_look_at(lua::State* L) {
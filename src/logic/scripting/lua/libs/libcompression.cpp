@@ -1,5 +1,6 @@
 #include "api_lua.hpp"
 #include "coders/gzip.hpp"
+#include "../lua_async.hpp"
 #include "../lua_engine.hpp"
 
 static int l_encode(lua::State* L) {
@@ -76,9 +77,42 @@ static int l_decode(lua::State* L) {
     return 1;
 }
 
+static int submit_async(lua::State* L, bool encode) {
+    std::string algo = "gzip";
+    if (lua::gettop(L) >= 2 && !lua::isnil(L, 2)) {
+        if (!lua::isstring(L, 2)) {
+            throw std::runtime_error("compression algorithm must be a string");
+        }
+        algo = lua::require_lstring(L, 2);
+    }
+    if (algo != "gzip") {
+        throw std::runtime_error("unsupported compression algorithm");
+    }
+    auto str = lua::bytearray_as_string(L, 1);
+    std::vector<ubyte> bytes(str.begin(), str.end());
+    return lua::pushinteger(L, lua::async::submit(
+        lua::async::Queue::COMPUTE,
+        [encode, bytes = std::move(bytes)]() {
+            return lua::async::Data {
+                encode ? gzip::compress(bytes.data(), bytes.size())
+                       : gzip::decompress(bytes.data(), bytes.size())};
+        }
+    ));
+}
+
+static int l_encode_async(lua::State* L) {
+    return submit_async(L, true);
+}
+
+static int l_decode_async(lua::State* L) {
+    return submit_async(L, false);
+}
+
 const luaL_Reg compressionlib[] = {
     {"encode", lua::wrap<l_encode>},
     {"decode", lua::wrap<l_decode>},
+    {"__encode_async", lua::wrap<l_encode_async>},
+    {"__decode_async", lua::wrap<l_decode_async>},
     {nullptr, nullptr}
 };
 
@@ -43,6 +43,32 @@ static int l_execute(lua::State* L) {
     }
 }
 
+static int l_execute_batch(lua::State* L) {
+    if (!lua::istable(L, 1)) {
+        throw std::runtime_error("strings array expected");
+    }
+    int len = lua::objlen(L, 1);
+    std::vector<std::string> prompts;
+    prompts.reserve(len);
+    for (int i = 0; i < len; i++) {
+        lua::rawgeti(L, i + 1, 1);
+        prompts.emplace_back(lua::require_lstring(L, -1));
+        lua::pop(L);
+    }
+    std::unordered_map<size_t, std::string> errors;
+    auto results = engine->getCmd().executeBatch(prompts, errors);
+    lua::pushvalue(L, results);
+    if (errors.empty()) {
+        return 1;
+    }
+    lua::createtable(L, 0, errors.size());
+    for (const auto& [index, message] : errors) {
+        lua::pushstring(L, message);
+        lua::rawseti(L, index + 1);
+    }
+    return 2;
+}
+
 static int l_get(lua::State* L) {
     auto name = lua::require_string(L, 1);
     return lua::pushvalue(L, engine->getCmd()[name]);
@@ -122,6 +148,7 @@ static int l_get_command_info(lua::State* L) {
 const luaL_Reg consolelib[] = {
     {"__add_command", lua::wrap<l_add_command>},
     {"execute", lua::wrap<l_execute>},
+    {"execute_batch", lua::wrap<l_execute_batch>},
     {"get", lua::wrap<l_get>},
     {"set", lua::wrap<l_set>},
     {"get_commands_list", lua::wrap<l_get_commands_list>},
@@ -1,3 +1,4 @@
+#include <fstream>
 #include <string>
 #include <set>
 
@@ -9,6 +10,7 @@
 #include "io/devices/ZipFileDevice.hpp"
 #include "util/stringutil.hpp"
 #include "api_lua.hpp"
+#include "../lua_async.hpp"
 #include "../lua_engine.hpp"
 #include "logic/scripting/descriptors_manager.hpp"
 
@@ -154,6 +156,79 @@ static int l_write_bytes(lua::State* L) {
     return lua::pushboolean(L, res);
 }
 
+/// @brief Resolve path to the filesystem path at submit time, so the IO
+/// worker does not access io devices, used by the main thread
+/// @throws std::runtime_error - entry-point is not a file system one
+static fs::path resolve_async_path(const io::path& path) {
+    auto device = io::get_device(path.entryPoint());
+    if (device == nullptr) {
+        throw std::runtime_error("io-device not found: " + path.entryPoint());
+    }
+    try {
+        return device->resolve(path.pathPart());
+    } catch (const std::runtime_error&) {
+        throw std::runtime_error(
+            "async operations are not supported for " +
+            util::quote(path.entryPoint())
+        );
+    }
+}
+
+static int l_read_async(lua::State* L) {
+    io::path path = lua::require_string(L, 1);
+    bool text = !lua::toboolean(L, 2);
+    auto file = resolve_async_path(path);
+    return lua::pushinteger(L, lua::async::submit(
+        lua::async::Queue::IO,
+        [path, file, text]() {
+            std::ifstream input(file, std::ios::binary);
+            if (!fs::is_regular_file(file) || !input) {
+                throw std::runtime_error(
+                    "file does not exists " + util::quote(path.string())
+                );
+            }
+            std::vector<ubyte> bytes(fs::file_size(file));
+            input.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+            if (input.gcount() != static_cast<std::streamsize>(bytes.size())) {
+                throw std::runtime_error(
+                    "could not read file " + util::quote(path.string())
+                );
+            }
+            return lua::async::Data {std::move(bytes), text};
+        }
+    ));
+}
+
+static int l_write_async(lua::State* L) {
+    io::path path = get_writeable_path(L);
+    std::string_view view = lua::isstring(L, 2)
+                                ? lua::require_lstring(L, 2)
+                                : lua::bytearray_as_string(L, 2);
+    std::vector<ubyte> bytes(view.begin(), view.end());
+    auto file = resolve_async_path(path);
+    return lua::pushinteger(L, lua::async::submit(
+        lua::async::Queue::IO,
+        [path, file, bytes = std::move(bytes)]() {
+            std::ofstream output(file, std::ios::binary);
+            output.write(
+                reinterpret_cast<const char*>(bytes.data()), bytes.size()
+            );
+            // flush errors are reported by close
+            output.close();
+            if (!output) {
+                throw std::runtime_error(
+                    "could not write file " + util::quote(path.string())
+                );
+            }
+            return lua::async::Data {};
+        }
+    ));
+}
+
+static int l_pull_async_results(lua::State* L) {
+    return lua::async::pull_results(L);
+}
+
 static int l_list_all_res(lua::State* L) {
     std::string path = lua::require_string(L, 1);
     auto files = engine->getResPaths().listdirRaw(path);
@@ -409,6 +484,9 @@ const luaL_Reg filelib[] = {
     {"__flush_descriptor", lua::wrap<l_flush_descriptor>},
     {"__close_descriptor", lua::wrap<l_close_descriptor>},
     {"__close_all_descriptors", lua::wrap<l_close_all_descriptors>},
+    {"__read_async", lua::wrap<l_read_async>},
+    {"__write_async", lua::wrap<l_write_async>},
+    {"__pull_async_results", lua::wrap<l_pull_async_results>},
     {nullptr, nullptr}
 };
 
@@ -57,8 +57,8 @@ static int l_open_block(lua::State* L) {
     auto z = lua::tointeger(L, 3);
     bool playerInventory = !lua::toboolean(L, 4);
 
-    auto vox = blocks_agent::get(*level->chunks, x, y, z);
-    if (vox == nullptr) {
+    auto vox = blocks_agent::get_voxel(*level->chunks, x, y, z);
+    if (!vox) {
         throw std::runtime_error(
             "block does not exists at " + std::to_string(x) + " " +
             std::to_string(y) + " " + std::to_string(z)
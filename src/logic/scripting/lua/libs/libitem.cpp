@@ -110,9 +110,11 @@ static int l_reload_script(lua::State* L) {
 
 static int l_has_tag(lua::State* L) {
     if (auto def = get_item_def(L, 1)) {
-        auto tag = lua::require_string(L, 2);
+        int tag = lua::isnumber(L, 2)
+                      ? lua::tointeger(L, 2)
+                      : content->getTagIndex(lua::require_string(L, 2));
         const auto& tags = def->rt.tags;
-        return lua::pushboolean(L, tags.find(content->getTagIndex(tag)) != tags.end());
+        return lua::pushboolean(L, tags.find(tag) != tags.end());
     }
     return 0;
 }
@@ -1,9 +1,12 @@
 #include "api_lua.hpp"
+#include "../lua_journal.hpp"
 #include "coders/json.hpp"
 #include "engine/Engine.hpp"
 #include "network/Network.hpp"
 #include "devtools/Project.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <variant>
 #include <utility>
 
@@ -172,6 +175,30 @@ static int l_closeserver(lua::State* L, network::Network& network) {
     return 0;
 }
 
+/// @brief Get bytes of a send data argument.
+/// Tables are copied to the storage, bytearrays are converted to a string
+/// left on the stack, so the view is valid until the function returns
+static std::string_view get_send_data(
+    lua::State* L, int idx, std::vector<util::Buffer<char>>& storage
+) {
+    if (lua::istable(L, idx)) {
+        size_t size = lua::objlen(L, idx);
+        auto& buffer = storage.emplace_back(size);
+        for (size_t i = 0; i < size; i++) {
+            lua::rawgeti(L, i + 1, idx);
+            buffer[i] = lua::tointeger(L, -1);
+            lua::pop(L);
+        }
+        return std::string_view(buffer.data(), size);
+    } else if (lua::isstring(L, idx)) {
+        return lua::tolstring(L, idx);
+    }
+    lua::requireglobal(L, "Bytearray_as_string");
+    lua::pushvalue(L, idx);
+    lua::call(L, 1, 1);
+    return lua::tolstring(L, -1);
+}
+
 static int l_send(lua::State* L, network::Network& network) {
     u64id_t id = lua::tointeger(L, 1);
     auto connection = network.getConnection(id, false);
@@ -179,25 +206,25 @@ static int l_send(lua::State* L, network::Network& network) {
         connection->getState() == network::ConnectionState::CLOSED) {
         return 0;
     }
-    if (lua::istable(L, 2)) {
-        lua::pushvalue(L, 2);
-        size_t size = lua::objlen(L, 2);
-        util::Buffer<char> buffer(size);
-        for (size_t i = 0; i < size; i++) {
-            lua::rawgeti(L, i + 1);
-            buffer[i] = lua::tointeger(L, -1);
-            lua::pop(L);
-        }
-        lua::pop(L);
-        connection->send(buffer.data(), size);
-    } else if (lua::isstring(L, 2)) {
-        auto string = lua::tolstring(L, 2);
-        connection->send(string.data(), string.length());
-    } else {
-        auto string = lua::bytearray_as_string(L, 2);
-        connection->send(string.data(), string.length());
-        lua::pop(L);
+    int argc = lua::gettop(L);
+    if (argc <= 2) {
+        std::vector<util::Buffer<char>> storage;
+        auto data = get_send_data(L, 2, storage);
+        connection->send(data.data(), data.length());
+        return 0;
+    }
+    // multiple buffers are sent at once to avoid concatenation
+    if (!lua_checkstack(L, argc)) {
+        throw std::runtime_error("too many buffers");
+    }
+    std::vector<util::Buffer<char>> storage;
+    storage.reserve(argc - 1);
+    std::vector<std::string_view> buffers;
+    buffers.reserve(argc - 1);
+    for (int i = 2; i <= argc; i++) {
+        buffers.push_back(get_send_data(L, i, storage));
     }
+    connection->sendv(buffers.data(), buffers.size());
     return 0;
 }
 
@@ -237,22 +264,32 @@ static int l_udp_server_send_to(lua::State* L, network::Network& network) {
     return 0;
 }
 
-static int l_recv(lua::State* L, network::Network& network) {
-    u64id_t id = lua::tointeger(L, 1);
-    int length = lua::tointeger(L, 2);
-
+static network::TcpConnection* get_tcp_connection(
+    network::Network& network, u64id_t id
+) {
     auto connection = network.getConnection(id, false);
 
     if (connection == nullptr || connection->getTransportType() != network::TransportType::TCP) {
-        return 0;
+        return nullptr;
     }
+    return dynamic_cast<network::TcpConnection*>(connection);
+}
 
-    auto tcpConnection = dynamic_cast<network::TcpConnection*>(connection);
+/// @param consume drop returned data from the connection
+static int recv_data(lua::State* L, network::Network& network, bool consume) {
+    u64id_t id = lua::tointeger(L, 1);
+    int length = lua::tointeger(L, 2);
+
+    auto tcpConnection = get_tcp_connection(network, id);
+    if (tcpConnection == nullptr) {
+        return 0;
+    }
 
     length = glm::min(length, tcpConnection->available());
     util::Buffer<char> buffer(length);
     
-    int size = tcpConnection->recv(buffer.data(), length);
+    int size = consume ? tcpConnection->recv(buffer.data(), length)
+                       : tcpConnection->peek(buffer.data(), length);
     if (size == -1) {
         return 0;
     }
@@ -268,6 +305,43 @@ static int l_recv(lua::State* L, network::Network& network) {
     }
 }
 
+static int l_recv(lua::State* L, network::Network& network) {
+    return recv_data(L, network, true);
+}
+
+static int l_peek(lua::State* L, network::Network& network) {
+    return recv_data(L, network, false);
+}
+
+/// @brief Receive data directly into the bytearray memory.
+/// Address is passed as decimal string (see __vc_Socket_recv_into)
+static int l_recv_into(lua::State* L, network::Network& network) {
+    u64id_t id = lua::tointeger(L, 1);
+    auto ptr = reinterpret_cast<char*>(std::stoull(lua::require_string(L, 2)));
+    int length = lua::tointeger(L, 3);
+
+    auto tcpConnection = get_tcp_connection(network, id);
+    if (tcpConnection == nullptr || length < 0) {
+        return 0;
+    }
+    int size = tcpConnection->recv(ptr, length);
+    if (size == -1) {
+        return 0;
+    }
+    return lua::pushinteger(L, size);
+}
+
+static int l_consume(lua::State* L, network::Network& network) {
+    u64id_t id = lua::tointeger(L, 1);
+    int length = lua::tointeger(L, 2);
+
+    auto tcpConnection = get_tcp_connection(network, id);
+    if (tcpConnection == nullptr || length < 0) {
+        return 0;
+    }
+    return lua::pushinteger(L, tcpConnection->consume(length));
+}
+
 static int l_available(lua::State* L, network::Network& network) {
     u64id_t id = lua::tointeger(L, 1);
 
@@ -402,6 +476,46 @@ static int l_get_serverport(lua::State* L, network::Network& network) {
     return 0;
 }
 
+static int push_stats(lua::State* L, const network::ConnectionStats& stats) {
+    lua::createtable(L, 0, 7);
+    lua::pushinteger(L, stats.bytesSent);
+    lua::setfield(L, "bytes_sent");
+    lua::pushinteger(L, stats.bytesReceived);
+    lua::setfield(L, "bytes_received");
+    lua::pushinteger(L, stats.packetsSent);
+    lua::setfield(L, "packets_sent");
+    lua::pushinteger(L, stats.packetsReceived);
+    lua::setfield(L, "packets_received");
+    lua::pushinteger(L, stats.sendQueue);
+    lua::setfield(L, "send_queue");
+    lua::pushnumber(L, stats.rtt / 1000.0);
+    lua::setfield(L, "rtt");
+    lua::pushinteger(L, stats.drops);
+    lua::setfield(L, "drops");
+    return 1;
+}
+
+static int l_get_stats(lua::State* L, network::Network& network) {
+    if (lua::isnoneornil(L, 1)) {
+        return push_stats(L, network.getStats());
+    }
+    u64id_t id = lua::tointeger(L, 1);
+    if (auto connection = network.getConnection(id, false)) {
+        return push_stats(L, connection->getStats());
+    }
+    return 0;
+}
+
+static int l_get_server_stats(lua::State* L, network::Network& network) {
+    u64id_t id = lua::tointeger(L, 1);
+    if (auto server = network.getServer(id, false)) {
+        if (auto udpServer = dynamic_cast<network::UdpServer*>(server)) {
+            return push_stats(L, udpServer->getStats());
+        }
+    }
+    return 0;
+}
+
 static int l_get_total_upload(lua::State* L, network::Network& network) {
     return lua::pushinteger(L, network.getTotalUpload());
 }
@@ -440,6 +554,39 @@ static int l_is_nodelay(lua::State* L, network::Network& network) {
     return lua::pushboolean(L, false);
 }
 
+static network::TcpConnection* get_tcp_connection(
+    lua::State* L, network::Network& network
+) {
+    u64id_t id = lua::tointeger(L, 1);
+    if (auto connection = network.getConnection(id, false)) {
+        if (connection->getTransportType() == network::TransportType::TCP) {
+            return dynamic_cast<network::TcpConnection*>(connection);
+        }
+    }
+    return nullptr;
+}
+
+static int l_set_coalescing(lua::State* L, network::Network& network) {
+    if (auto connection = get_tcp_connection(L, network)) {
+        connection->setCoalescing(lua::toboolean(L, 2));
+    }
+    return 0;
+}
+
+static int l_is_coalescing(lua::State* L, network::Network& network) {
+    if (auto connection = get_tcp_connection(L, network)) {
+        return lua::pushboolean(L, connection->isCoalescing());
+    }
+    return lua::pushboolean(L, false);
+}
+
+static int l_flush(lua::State* L, network::Network& network) {
+    if (auto connection = get_tcp_connection(L, network)) {
+        connection->flush();
+    }
+    return 0;
+}
+
 static int l_pull_events(lua::State* L) {
     std::vector<NetworkEvent> local_queue;
     {
@@ -548,31 +695,74 @@ int wrap(lua_State* L) {
     return result;
 }
 
+/// @brief Received bytes are written to the bytearray memory, so they are
+/// journaled instead of the call results
+static int l_journaled_recv_into(lua::State* L) {
+    auto journal = lua::get_journal();
+    if (journal == nullptr) {
+        return wrap<l_recv_into>(L);
+    }
+    auto ptr = reinterpret_cast<char*>(std::stoull(lua::require_string(L, 2)));
+    int length = lua::tointeger(L, 3);
+    if (journal->isReplaying()) {
+        auto bytes = journal->take(devtools::JournalEntryType::CALL_RESULT);
+        if (bytes.isInteger()) {
+            return 0;
+        }
+        const auto& data = bytes.asBytes();
+        if (data.size() > static_cast<size_t>(std::max(length, 0))) {
+            throw std::runtime_error("replay desync: recv_into buffer overflow");
+        }
+        std::memcpy(ptr, data.data(), data.size());
+        return lua::pushinteger(L, data.size());
+    }
+    if (wrap<l_recv_into>(L) == 0) {
+        journal->add(devtools::JournalEntryType::CALL_RESULT, 0);
+        return 0;
+    }
+    size_t size = lua::tointeger(L, -1);
+    journal->add(
+        devtools::JournalEntryType::CALL_RESULT,
+        std::make_shared<dv::objects::Bytes>(
+            reinterpret_cast<const ubyte*>(ptr), size
+        )
+    );
+    return 1;
+}
+
 const luaL_Reg networklib[] = {
     {"__get", wrap<l_get>},
     {"__get_binary", wrap<l_get_binary>},
     {"__post", wrap<l_post>},
     {"get_total_upload", wrap<l_get_total_upload>},
     {"get_total_download", wrap<l_get_total_download>},
+    {"get_stats", wrap<l_get_stats>},
+    {"__get_server_stats", wrap<l_get_server_stats>},
     {"find_free_port", wrap<l_find_free_port>},
     {"is_available", lua::wrap<l_is_available>},
-    {"__pull_events", lua::wrap<l_pull_events>},
-    {"__open_tcp", wrap<l_open_tcp>},
-    {"__open_udp", wrap<l_open_udp>},
+    {"__pull_events", lua::journaled<lua::wrap<l_pull_events>>},
+    {"__open_tcp", lua::journaled<wrap<l_open_tcp>>},
+    {"__open_udp", lua::journaled<wrap<l_open_udp>>},
     {"__closeserver", wrap<l_closeserver>},
     {"__udp_server_send_to", wrap<l_udp_server_send_to>},
-    {"__connect_tcp", wrap<l_connect_tcp>},
-    {"__connect_udp", wrap<l_connect_udp>},
+    {"__connect_tcp", lua::journaled<wrap<l_connect_tcp>>},
+    {"__connect_udp", lua::journaled<wrap<l_connect_udp>>},
     {"__close", wrap<l_close>},
     {"__send", wrap<l_send>},
-    {"__recv", wrap<l_recv>},
-    {"__available", wrap<l_available>},
-    {"__is_alive", wrap<l_is_alive>},
-    {"__is_connected", wrap<l_is_connected>},
-    {"__get_address", wrap<l_get_address>},
-    {"__is_serveropen", wrap<l_is_serveropen>},
-    {"__get_serverport", wrap<l_get_serverport>},
+    {"__recv", lua::journaled<wrap<l_recv>>},
+    {"__recv_into", lua::wrap<l_journaled_recv_into>},
+    {"__peek", lua::journaled<wrap<l_peek>>},
+    {"__consume", lua::journaled<wrap<l_consume>>},
+    {"__available", lua::journaled<wrap<l_available>>},
+    {"__is_alive", lua::journaled<wrap<l_is_alive>>},
+    {"__is_connected", lua::journaled<wrap<l_is_connected>>},
+    {"__get_address", lua::journaled<wrap<l_get_address>>},
+    {"__is_serveropen", lua::journaled<wrap<l_is_serveropen>>},
+    {"__get_serverport", lua::journaled<wrap<l_get_serverport>>},
     {"__set_nodelay", wrap<l_set_nodelay>},
     {"__is_nodelay", wrap<l_is_nodelay>},
+    {"__set_coalescing", wrap<l_set_coalescing>},
+    {"__is_coalescing", wrap<l_is_coalescing>},
+    {"__flush", wrap<l_flush>},
     {nullptr, nullptr}
 };
@@ -9,6 +9,7 @@
 #include "objects/Players.hpp"
 #include "physics/Hitbox.hpp"
 #include "window/Camera.hpp"
+#include "world/InterestManager.hpp"
 #include "world/Level.hpp"
 #include "engine/Engine.hpp"
 
@@ -64,6 +65,7 @@ static int l_set_vel(lua::State* L) {
 
     if (auto hitbox = player->getHitbox()) {
         hitbox->velocity = glm::vec3(x, y, z);
+        hitbox->wake();
     }
     return 0;
 }
@@ -97,7 +99,7 @@ static int l_set_rot(lua::State* L) {
 
 static int l_get_dir(lua::State* L) {
     if (auto player = get_player(L, 1)) {
-        return lua::pushvec3(L, player->fpCamera->front);
+        return lua::pushvec_out(L, 2, player->fpCamera->front);
     }
     return 0;
 }
@@ -364,6 +366,53 @@ static int l_get_nearest(lua::State* L) {
     return 0;
 }
 
+template <class T>
+static int push_ids(lua::State* L, const std::vector<T>& ids) {
+    lua::createtable(L, ids.size(), 0);
+    for (size_t i = 0; i < ids.size(); i++) {
+        lua::pushinteger(L, ids[i]);
+        lua::rawseti(L, i + 1);
+    }
+    return 1;
+}
+
+static int l_set_interest_radius(lua::State* L) {
+    level->interests->setRadius(
+        lua::tointeger(L, 1), static_cast<float>(lua::tonumber(L, 2))
+    );
+    return 0;
+}
+
+static int l_get_interest_radius(lua::State* L) {
+    return lua::pushnumber(
+        L, level->interests->getRadius(lua::tointeger(L, 1))
+    );
+}
+
+static int l_get_visible_entities(lua::State* L) {
+    return push_ids(L, level->interests->getVisible(lua::tointeger(L, 1)));
+}
+
+static int l_get_interest_delta(lua::State* L) {
+    int64_t id = lua::tointeger(L, 1);
+    push_ids(L, level->interests->getEntered(id));
+    push_ids(L, level->interests->getLeft(id));
+    return 2;
+}
+
+static int l_get_entity_observers(lua::State* L) {
+    return push_ids(L, level->interests->getObservers(lua::tointeger(L, 1)));
+}
+
+static int l_get_chunk_observers(lua::State* L) {
+    return push_ids(
+        L,
+        level->interests->getChunkObservers(
+            lua::tointeger(L, 1), lua::tointeger(L, 2)
+        )
+    );
+}
+
 const luaL_Reg playerlib[] = {
     {"get_pos", lua::wrap<l_get_pos>},
     {"set_pos", lua::wrap<l_set_pos>},
@@ -403,5 +452,11 @@ const luaL_Reg playerlib[] = {
     {"get_all_in_radius", lua::wrap<l_get_all_in_radius>},
     {"get_all", lua::wrap<l_get_all>},
     {"get_nearest", lua::wrap<l_get_nearest>},
+    {"set_interest_radius", lua::wrap<l_set_interest_radius>},
+    {"get_interest_radius", lua::wrap<l_get_interest_radius>},
+    {"get_visible_entities", lua::wrap<l_get_visible_entities>},
+    {"get_interest_delta", lua::wrap<l_get_interest_delta>},
+    {"get_entity_observers", lua::wrap<l_get_entity_observers>},
+    {"get_chunk_observers", lua::wrap<l_get_chunk_observers>},
     {nullptr, nullptr}
 };
@@ -0,0 +1,222 @@
+#include "api_lua.hpp"
+
+#include "debug/Allocations.hpp"
+#include "debug/Memory.hpp"
+#include "debug/Profiler.hpp"
+#include "../lua_engine.hpp"
+#include "../lua_profiler.hpp"
+
+static int l_start(lua::State*) {
+    debug::profiler::set_enabled(true);
+    return 0;
+}
+
+static int l_stop(lua::State*) {
+    debug::profiler::set_enabled(false);
+    return 0;
+}
+
+static int l_is_enabled(lua::State* L) {
+    return lua::pushboolean(L, debug::profiler::is_enabled());
+}
+
+static int l_clear(lua::State*) {
+    debug::profiler::clear();
+    lua::profiler::clear();
+    return 0;
+}
+
+static int l_dump(lua::State* L) {
+    return lua::pushstring(L, debug::profiler::to_chrome_trace());
+}
+
+static int l_get_stats(lua::State* L) {
+    double period = lua::isnumber(L, 1) ? lua::tonumber(L, 1) : 1.0;
+    auto stats = debug::profiler::get_stats(
+        static_cast<int64_t>(period * 1e9)
+    );
+    lua::createtable(L, stats.size(), 0);
+    for (size_t i = 0; i < stats.size(); i++) {
+        const auto& zone = stats[i];
+        lua::createtable(L, 0, 6);
+        lua::pushlstring(L, zone.name);
+        lua::setfield(L, "name");
+        lua::pushinteger(L, zone.calls);
+        lua::setfield(L, "calls");
+        lua::pushnumber(L, zone.total / 1e6);
+        lua::setfield(L, "total");
+        lua::pushnumber(L, zone.max / 1e6);
+        lua::setfield(L, "max");
+        lua::pushinteger(L, zone.allocations);
+        lua::setfield(L, "allocations");
+        lua::pushinteger(L, zone.allocatedBytes);
+        lua::setfield(L, "allocated");
+        lua::rawseti(L, i + 1);
+    }
+    return 1;
+}
+
+static int l_start_scripts(lua::State* L) {
+    int interval = lua::isnumber(L, 1) ? lua::tointeger(L, 1)
+                                       : lua::profiler::DEFAULT_INTERVAL;
+    lua::profiler::set_enabled(true, interval);
+    return 0;
+}
+
+static int l_stop_scripts(lua::State*) {
+    lua::profiler::set_enabled(false);
+    return 0;
+}
+
+static int l_is_scripts_enabled(lua::State* L) {
+    return lua::pushboolean(L, lua::profiler::is_enabled());
+}
+
+static int l_get_scripts_stats(lua::State* L) {
+    auto packs = lua::profiler::get_stats();
+    lua::createtable(L, packs.size(), 0);
+    for (size_t i = 0; i < packs.size(); i++) {
+        const auto& pack = packs[i];
+        lua::createtable(L, 0, 7);
+        lua::pushlstring(L, pack.packid);
+        lua::setfield(L, "pack");
+        lua::pushinteger(L, pack.calls);
+        lua::setfield(L, "calls");
+        lua::pushnumber(L, pack.total / 1e6);
+        lua::setfield(L, "total");
+        lua::pushinteger(L, pack.allocated);
+        lua::setfield(L, "allocated");
+        lua::pushinteger(L, pack.samples);
+        lua::setfield(L, "samples");
+
+        lua::createtable(L, pack.events.size(), 0);
+        for (size_t j = 0; j < pack.events.size(); j++) {
+            const auto& event = pack.events[j];
+            lua::createtable(L, 0, 4);
+            lua::pushlstring(L, event.name);
+            lua::setfield(L, "name");
+            lua::pushinteger(L, event.calls);
+            lua::setfield(L, "calls");
+            lua::pushnumber(L, event.total / 1e6);
+            lua::setfield(L, "total");
+            lua::pushinteger(L, event.allocated);
+            lua::setfield(L, "allocated");
+            lua::rawseti(L, j + 1);
+        }
+        lua::setfield(L, "events");
+
+        lua::createtable(L, pack.files.size(), 0);
+        for (size_t j = 0; j < pack.files.size(); j++) {
+            const auto& file = pack.files[j];
+            lua::createtable(L, 0, 2);
+            lua::pushlstring(L, file.file);
+            lua::setfield(L, "file");
+            lua::pushinteger(L, file.samples);
+            lua::setfield(L, "samples");
+            lua::rawseti(L, j + 1);
+        }
+        lua::setfield(L, "files");
+        lua::rawseti(L, i + 1);
+    }
+    return 1;
+}
+
+static int l_dump_scripts(lua::State* L) {
+    return lua::pushstring(L, lua::profiler::to_folded_stacks());
+}
+
+static int l_gc_metrics(lua::State* L) {
+    const auto& metrics = lua::get_gc_metrics();
+    lua::createtable(L, 0, 7);
+    lua::pushinteger(L, metrics.memory);
+    lua::setfield(L, "memory");
+    lua::pushinteger(L, metrics.maxMemory);
+    lua::setfield(L, "max_memory");
+    lua::pushinteger(L, metrics.liveMemory);
+    lua::setfield(L, "live_memory");
+    lua::pushinteger(L, metrics.steps);
+    lua::setfield(L, "steps");
+    lua::pushinteger(L, metrics.cycles);
+    lua::setfield(L, "cycles");
+    lua::pushnumber(L, metrics.lastTime * 1000);
+    lua::setfield(L, "last_time");
+    lua::pushnumber(L, metrics.maxTime * 1000);
+    lua::setfield(L, "max_time");
+    return 1;
+}
+
+static int l_memory_stats(lua::State* L) {
+    auto usage = debug::memory::collect();
+    size_t total = 0;
+    lua::createtable(L, 0, usage.size() + 5);
+    for (size_t i = 0; i < usage.size(); i++) {
+        lua::pushinteger(L, usage[i]);
+        auto tag = static_cast<debug::MemoryTag>(i);
+        lua::setfield(L, std::string(debug::memory::tag_name(tag)));
+        total += usage[i];
+    }
+    lua::pushinteger(L, total);
+    lua::setfield(L, "total");
+    lua::pushinteger(L, debug::memory::get_budget());
+    lua::setfield(L, "budget");
+    lua::pushinteger(L, debug::memory::video_usage(usage));
+    lua::setfield(L, "video_total");
+    lua::pushinteger(L, debug::memory::get_video_budget());
+    lua::setfield(L, "video_budget");
+    lua::pushinteger(L, debug::memory::get_video_pressure());
+    lua::setfield(L, "video_pressure");
+    return 1;
+}
+
+static void push_allocation_stats(
+    lua::State* L, const debug::AllocationStats& stats
+) {
+    lua::createtable(L, 0, 3);
+    lua::pushinteger(L, stats.allocations);
+    lua::setfield(L, "allocations");
+    lua::pushinteger(L, stats.frees);
+    lua::setfield(L, "frees");
+    lua::pushinteger(L, stats.bytes);
+    lua::setfield(L, "bytes");
+}
+
+static int l_allocation_stats(lua::State* L) {
+    lua::createtable(L, 0, 5);
+    lua::pushboolean(L, debug::allocations::is_available());
+    lua::setfield(L, "available");
+    push_allocation_stats(L, debug::allocations::get_last_frame());
+    lua::setfield(L, "frame");
+    push_allocation_stats(L, debug::allocations::get_last_tick());
+    lua::setfield(L, "tick");
+    push_allocation_stats(L, debug::allocations::get_total());
+    lua::setfield(L, "total");
+
+    auto threads = debug::allocations::get_threads();
+    lua::createtable(L, threads.size(), 0);
+    for (size_t i = 0; i < threads.size(); i++) {
+        push_allocation_stats(L, threads[i].stats);
+        lua::pushstring(L, threads[i].threadName);
+        lua::setfield(L, "name");
+        lua::rawseti(L, i + 1);
+    }
+    lua::setfield(L, "threads");
+    return 1;
+}
+
+const luaL_Reg profilerlib[] = {
+    {"start", lua::wrap<l_start>},
+    {"stop", lua::wrap<l_stop>},
+    {"is_enabled", lua::wrap<l_is_enabled>},
+    {"clear", lua::wrap<l_clear>},
+    {"dump", lua::wrap<l_dump>},
+    {"get_stats", lua::wrap<l_get_stats>},
+    {"start_scripts", lua::wrap<l_start_scripts>},
+    {"stop_scripts", lua::wrap<l_stop_scripts>},
+    {"is_scripts_enabled", lua::wrap<l_is_scripts_enabled>},
+    {"get_scripts_stats", lua::wrap<l_get_scripts_stats>},
+    {"dump_scripts", lua::wrap<l_dump_scripts>},
+    {"gc_metrics", lua::wrap<l_gc_metrics>},
+    {"memory_stats", lua::wrap<l_memory_stats>},
+    {"allocation_stats", lua::wrap<l_allocation_stats>},
+    {nullptr, nullptr}
+};
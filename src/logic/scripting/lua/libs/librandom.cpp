@@ -1,4 +1,5 @@
 #include "api_lua.hpp"
+#include "../lua_journal.hpp"
 
 #include "util/random.hpp"
 
@@ -39,8 +40,8 @@ static int l_uuid(lua::State* L) {
 }
 
 const luaL_Reg randomlib[] = {
-    {"random", lua::wrap<l_random>},
-    {"bytes", lua::wrap<l_bytes>},
-    {"uuid", lua::wrap<l_uuid>},
+    {"random", lua::journaled<lua::wrap<l_random>>},
+    {"bytes", lua::journaled<lua::wrap<l_bytes>>},
+    {"uuid", lua::journaled<lua::wrap<l_uuid>>},
     {nullptr, nullptr}
 };
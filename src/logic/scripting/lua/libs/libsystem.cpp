@@ -0,0 +1,48 @@
+#include "api_lua.hpp"
+
+#include "logic/scripting/scripting_systems.hpp"
+
+using namespace scripting;
+
+/// system library (available in worker systems states)
+
+static int l_send(lua::State* L) {
+    auto system = WorkerSystem::of(L);
+    if (system == nullptr) {
+        throw std::runtime_error("not a system state");
+    }
+    system->send(lua::tovalue(L, 1));
+    return 0;
+}
+
+const luaL_Reg systemlib[] = {
+    {"send", lua::wrap<l_send>},
+    {nullptr, nullptr}
+};
+
+/// systems library (available in the main state)
+
+static int l_systems_send(lua::State* L) {
+    auto system = get_worker_system(lua::require_string(L, 1));
+    if (system == nullptr) {
+        return lua::pushboolean(L, false);
+    }
+    system->post(lua::tovalue(L, 2));
+    return lua::pushboolean(L, true);
+}
+
+static int l_systems_list(lua::State* L) {
+    auto names = get_worker_systems_names();
+    lua::createtable(L, names.size(), 0);
+    for (size_t i = 0; i < names.size(); i++) {
+        lua::pushstring(L, names[i]);
+        lua::rawseti(L, i + 1);
+    }
+    return 1;
+}
+
+const luaL_Reg systemslib[] = {
+    {"send", lua::wrap<l_systems_send>},
+    {"list", lua::wrap<l_systems_list>},
+    {nullptr, nullptr}
+};
@@ -1,5 +1,6 @@
 #include "engine/Engine.hpp"
 #include "api_lua.hpp"
+#include "../lua_journal.hpp"
 #include <ctime>
 
 using namespace scripting;
@@ -16,6 +17,24 @@ static int l_delta(lua::State* L) {
     return lua::pushnumber(L, engine->getTime().getDelta());
 }
 
+static int l_tick_metrics(lua::State* L) {
+    const auto& metrics = engine->getTickMetrics();
+    lua::createtable(L, 0, 6);
+    lua::pushinteger(L, metrics.ticks);
+    lua::setfield(L, "ticks");
+    lua::pushinteger(L, metrics.catchUpTicks);
+    lua::setfield(L, "catchup_ticks");
+    lua::pushinteger(L, metrics.skippedTicks);
+    lua::setfield(L, "skipped_ticks");
+    lua::pushnumber(L, metrics.lag);
+    lua::setfield(L, "lag");
+    lua::pushnumber(L, metrics.maxLag);
+    lua::setfield(L, "max_lag");
+    lua::pushnumber(L, metrics.averageLag);
+    lua::setfield(L, "avg_lag");
+    return 1;
+}
+
 static int l_utc_time(lua::State* L) {
     return lua::pushnumber(L, std::time(nullptr));
 }
@@ -65,8 +84,9 @@ static int l_utc_offset(lua::State* L) {
 const luaL_Reg timelib[] = {
     {"uptime", lua::wrap<l_uptime>},
     {"delta", lua::wrap<l_delta>},
-    {"utc_time", lua::wrap<l_utc_time>},
-    {"utc_offset", lua::wrap<l_utc_offset>},
-    {"local_time", lua::wrap<l_local_time>},
+    {"tick_metrics", lua::journaled<lua::wrap<l_tick_metrics>>},
+    {"utc_time", lua::journaled<lua::wrap<l_utc_time>>},
+    {"utc_offset", lua::journaled<lua::wrap<l_utc_offset>>},
+    {"local_time", lua::journaled<lua::wrap<l_local_time>>},
     {nullptr, nullptr}
 };
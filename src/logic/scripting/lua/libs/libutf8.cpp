@@ -50,14 +50,27 @@ static int l_codepoint(lua::State* L) {
     return lua::pushinteger(L, util::decode_utf8(size, string.data()));
 }
 
+/// @brief Byte offset of the codepoint or string length if out of range
+static size_t skip_codepoints(std::string_view string, size_t pos, size_t n) {
+    for (size_t i = 0; i < n && pos < string.length(); i++) {
+        util::next_utf8(string, pos);
+    }
+    return pos;
+}
+
 static int l_sub(lua::State* L) {
-    auto string = util::str2u32str_utf8(lua::require_string(L, 1));
-    int start = std::max(0, static_cast<int>(lua::tointeger(L, 2) - 1));
-    int end = string.length();
+    std::string_view string = lua::require_lstring(L, 1);
+    size_t start = std::max(0, static_cast<int>(lua::tointeger(L, 2) - 1));
+    size_t begin = skip_codepoints(string, 0, start);
+    if (begin == string.length() && start > util::length_utf8(string)) {
+        throw std::out_of_range("utf8.sub: start index is out of range");
+    }
+    size_t end = string.length();
     if (lua::gettop(L) >= 3) {
-        end = std::max(0, static_cast<int>(lua::tointeger(L, 3) - 1));
+        size_t count = std::max(0, static_cast<int>(lua::tointeger(L, 3) - 1));
+        end = skip_codepoints(string, begin, count);
     }
-    return lua::pushstring(L, util::u32str2str_utf8(string.substr(start, end)));
+    return lua::pushlstring(L, string.substr(begin, end - begin));
 }
 
 static int l_upper(lua::State* L) {
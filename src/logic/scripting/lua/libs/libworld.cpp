@@ -21,6 +21,7 @@
 #include "world/World.hpp"
 #include "logic/LevelController.hpp"
 #include "logic/ChunksController.hpp"
+#include "logic/scripting/lua/usertypes/lua_type_bufferview.hpp"
 
 using namespace scripting;
 namespace fs = std::filesystem;
@@ -100,6 +101,25 @@ static int l_get_day_time_speed(lua::State* L) {
     return lua::pushnumber(L, require_world_info().daytimeSpeed);
 }
 
+static int l_get_simulation_distance(lua::State* L) {
+    const auto& simulation = require_world_info().simulation;
+    lua::pushinteger(L, simulation.fullDistance);
+    lua::pushinteger(L, simulation.reducedDistance);
+    lua::pushinteger(L, simulation.reducedRate);
+    return 3;
+}
+
+static int l_set_simulation_distance(lua::State* L) {
+    auto& simulation = require_world_info().simulation;
+    simulation.fullDistance = lua::tointeger(L, 1);
+    simulation.reducedDistance = lua::tointeger(L, 2);
+    if (!lua::isnoneornil(L, 3)) {
+        simulation.reducedRate = lua::tointeger(L, 3);
+    }
+    simulation.validate();
+    return 0;
+}
+
 static int l_get_seed(lua::State* L) {
     return lua::pushinteger(L, require_world_info().seed);
 }
@@ -129,6 +149,12 @@ static int l_get_chunk_data(lua::State* L) {
     int z = static_cast<int>(lua::tointeger(L, 2));
     const auto& chunk = level->chunks->getChunk(x, z);
 
+    if (chunk && lua::isnumber(L, 3)) {
+        auto baseRevision = static_cast<uint32_t>(lua::tointeger(L, 3));
+        return lua::create_bytearray(
+            L, compressed_chunks::encode_delta(*chunk, baseRevision)
+        );
+    }
     auto voxelData = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
     std::vector<ubyte> chunkData;
     if (chunk == nullptr) {
@@ -136,16 +162,48 @@ static int l_get_chunk_data(lua::State* L) {
         if (!regions.getVoxels(x, z, voxelData.get())) {
             return 0;
         }
-        static util::Buffer<ubyte> rleBuffer(CHUNK_DATA_LEN * 2);
         auto metadata = regions.getBlocksData(x, z);
-        chunkData =
-            compressed_chunks::encode(voxelData.get(), metadata, rleBuffer);
+        chunkData = compressed_chunks::encode(voxelData.get(), metadata);
     } else {
         chunkData = compressed_chunks::encode(*chunk);
     }
     return lua::create_bytearray(L, std::move(chunkData));
 }
 
+static int l_get_chunk_view(lua::State* L) {
+    int x = static_cast<int>(lua::tointeger(L, 1));
+    int z = static_cast<int>(lua::tointeger(L, 2));
+    auto chunk = level->chunks->fetch(x, z);
+    if (chunk == nullptr) {
+        return 0;
+    }
+    voxel* voxels = chunk->getVoxels();
+    // chunk is kept alive by the view, but it's not updated after unload
+    // and packing
+    return lua::LuaBufferView::create(
+        L,
+        chunk,
+        voxels,
+        CHUNK_VOL,
+        "vc_voxel",
+        true,
+        [chunk = chunk.get(), voxels]() {
+            return level &&
+                   level->chunks->getChunk(chunk->x, chunk->z) == chunk &&
+                   !chunk->isPacked() && chunk->getVoxels() == voxels;
+        }
+    );
+}
+
+static int l_get_chunk_revision(lua::State* L) {
+    int x = static_cast<int>(lua::tointeger(L, 1));
+    int z = static_cast<int>(lua::tointeger(L, 2));
+    if (auto chunk = level->chunks->getChunk(x, z)) {
+        return lua::pushinteger(L, chunk->revision);
+    }
+    return 0;
+}
+
 static void integrate_chunk_client(Chunk& chunk) {
     int x = chunk.x;
     int z = chunk.z;
@@ -163,7 +221,7 @@ static void integrate_chunk_client(Chunk& chunk) {
                 continue;
             }
             if (auto other = level->chunks->getChunk(x + lx, z + lz)) {
-                other->flags.modified = true;
+                other->setModified();
             }
         }
     }
@@ -213,6 +271,7 @@ static int l_save_chunk_data(lua::State* L) {
         ),
         level->getWorld()->wfile->getRegions()
     );
+    level->chunks->invalidateUnloaded(x, z);
     return 0;
 }
 
@@ -223,6 +282,48 @@ static int l_count_chunks(lua::State* L) {
     return lua::pushinteger(L, level->chunks->size());
 }
 
+static int l_pregenerate(lua::State* L) {
+    if (level == nullptr) {
+        throw std::runtime_error("no open world");
+    }
+    if (level->getWorld()->isNameless()) {
+        throw std::runtime_error("nameless world is not saved");
+    }
+    if (lua::isnoneornil(L, 1)) {
+        return lua::pushboolean(L, controller->resumePregeneration());
+    }
+    controller->startPregeneration(
+        glm::ivec2(lua::tointeger(L, 1), lua::tointeger(L, 2)),
+        glm::ivec2(lua::tointeger(L, 3), lua::tointeger(L, 4))
+    );
+    return lua::pushboolean(L, true);
+}
+
+static int l_stop_pregeneration(lua::State* L) {
+    if (controller) {
+        controller->stopPregeneration();
+    }
+    return 0;
+}
+
+static int l_get_pregeneration(lua::State* L) {
+    if (controller == nullptr) {
+        return 0;
+    }
+    auto pregenerator = controller->getPregenerator();
+    if (pregenerator == nullptr) {
+        return 0;
+    }
+    lua::createtable(L, 0, 3);
+    lua::pushinteger(L, pregenerator->getWorkDone());
+    lua::setfield(L, "done");
+    lua::pushinteger(L, pregenerator->getWorkTotal());
+    lua::setfield(L, "total");
+    lua::pushnumber(L, pregenerator->getSpeed());
+    lua::setfield(L, "speed");
+    return 1;
+}
+
 static int l_reload_script(lua::State* L) {
     auto packid = lua::require_string(L, 1);
     if (content == nullptr) {
@@ -242,15 +343,22 @@ const luaL_Reg worldlib[] = {
     {"set_day_time", lua::wrap<l_set_day_time>},
     {"set_day_time_speed", lua::wrap<l_set_day_time_speed>},
     {"get_day_time_speed", lua::wrap<l_get_day_time_speed>},
+    {"get_simulation_distance", lua::wrap<l_get_simulation_distance>},
+    {"set_simulation_distance", lua::wrap<l_set_simulation_distance>},
     {"get_seed", lua::wrap<l_get_seed>},
     {"get_generator", lua::wrap<l_get_generator>},
     {"is_day", lua::wrap<l_is_day>},
     {"is_night", lua::wrap<l_is_night>},
     {"exists", lua::wrap<l_exists>},
     {"get_chunk_data", lua::wrap<l_get_chunk_data>},
+    {"get_chunk_view", lua::wrap<l_get_chunk_view>},
+    {"get_chunk_revision", lua::wrap<l_get_chunk_revision>},
     {"set_chunk_data", lua::wrap<l_set_chunk_data>},
     {"save_chunk_data", lua::wrap<l_save_chunk_data>},
     {"count_chunks", lua::wrap<l_count_chunks>},
+    {"pregenerate", lua::wrap<l_pregenerate>},
+    {"stop_pregeneration", lua::wrap<l_stop_pregeneration>},
+    {"get_pregeneration", lua::wrap<l_get_pregeneration>},
     {"reload_script", lua::wrap<l_reload_script>},
     {nullptr, nullptr}
 };
@@ -0,0 +1,116 @@
+#include "lua_async.hpp"
+
+#include <memory>
+#include <thread>
+
+#include "lua_util.hpp"
+#include "util/ThreadPool.hpp"
+
+using namespace lua;
+
+namespace {
+    struct AsyncJob {
+        int id;
+        /// @brief Shared as the job is copied to the result
+        std::shared_ptr<async::Operation> operation;
+    };
+
+    struct AsyncResult {
+        int id;
+        async::Data data;
+        std::string error;
+    };
+
+    class AsyncWorker : public util::Worker<AsyncJob, AsyncResult> {
+    public:
+        AsyncResult operator()(const AsyncJob& job) override {
+            try {
+                return AsyncResult {job.id, (*job.operation)(), ""};
+            } catch (const std::exception& err) {
+                return AsyncResult {job.id, {}, err.what()};
+            }
+        }
+    };
+
+    using AsyncPool = util::ThreadPool<AsyncJob, AsyncResult>;
+}
+
+static std::unique_ptr<AsyncPool> io_pool;
+static std::unique_ptr<AsyncPool> compute_pool;
+static std::vector<AsyncResult> results;
+static int next_id = 1;
+
+static std::unique_ptr<AsyncPool> create_pool(std::string name, int workers) {
+    auto pool = std::make_unique<AsyncPool>(
+        std::move(name),
+        []() { return std::make_unique<AsyncWorker>(); },
+        [](AsyncResult&& result) { results.push_back(std::move(result)); },
+        workers
+    );
+    pool->setStopOnFail(false);
+    return pool;
+}
+
+int async::submit(Queue queue, Operation operation) {
+    auto& pool = queue == Queue::IO ? io_pool : compute_pool;
+    if (pool == nullptr) {
+        pool = queue == Queue::IO
+                   ? create_pool("lua-io", 1)
+                   : create_pool("lua-compute", AsyncPool::QUARTER);
+    }
+    int id = next_id++;
+    pool->enqueueJob(AsyncJob {
+        id, std::make_shared<Operation>(std::move(operation))});
+    return id;
+}
+
+int async::pull_results(State* L) {
+    for (auto pool : {io_pool.get(), compute_pool.get()}) {
+        if (pool) {
+            pool->pullResults();
+        }
+    }
+    createtable(L, results.size(), 0);
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& result = results[i];
+        createtable(L, 3, 0);
+        pushinteger(L, result.id);
+        rawseti(L, 1);
+        if (result.error.empty()) {
+            const auto& bytes = result.data.bytes;
+            if (result.data.text) {
+                pushlstring(L, bytes.data(), bytes.size());
+            } else {
+                create_bytearray(L, bytes);
+            }
+            rawseti(L, 2);
+        } else {
+            pushstring(L, result.error);
+            rawseti(L, 3);
+        }
+        rawseti(L, i + 1);
+    }
+    results.clear();
+    return 1;
+}
+
+void async::wait() {
+    for (auto pool : {io_pool.get(), compute_pool.get()}) {
+        if (pool == nullptr) {
+            continue;
+        }
+        // pending writes must not be lost
+        while (pool->getWorkDone() < pool->getWorkTotal()) {
+            pool->pullResults();
+            std::this_thread::yield();
+        }
+    }
+    results.clear();
+}
+
+void async::shutdown() {
+    wait();
+    io_pool.reset();
+    compute_pool.reset();
+    results.clear();
+}
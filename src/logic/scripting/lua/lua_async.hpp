@@ -0,0 +1,42 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "lua_commons.hpp"
+#include "typedefs.hpp"
+
+namespace lua::async {
+    /// @brief Background operation result
+    struct Data {
+        std::vector<ubyte> bytes;
+        /// @brief Pushed to Lua as a string instead of a Bytearray
+        bool text = false;
+    };
+
+    /// @brief Background operation. Exceptions are reported to the script
+    using Operation = std::function<Data()>;
+
+    enum class Queue {
+        /// @brief Single worker: file operations are performed in the
+        /// submission order, so the latest write wins
+        IO,
+        /// @brief CPU-bound operations (compression)
+        COMPUTE,
+    };
+
+    /// @brief Perform operation in a background thread
+    /// @return request id used to match the result
+    int submit(Queue queue, Operation operation);
+
+    /// @brief Push table of completed requests results:
+    /// {{id, data, error}, ...} (data is nil on error)
+    int pull_results(State* L);
+
+    /// @brief Wait for pending operations, results are dropped
+    void wait();
+
+    /// @brief Wait for pending operations and stop workers
+    void shutdown();
+}
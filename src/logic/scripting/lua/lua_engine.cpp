@@ -1,23 +1,61 @@
 #include "lua_engine.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <iomanip>
 #include <iostream>
+#include <unordered_map>
 
 #include "io/io.hpp"
 #include "engine/EnginePaths.hpp"
 #include "debug/Logger.hpp"
+#include "debug/Memory.hpp"
 #include "util/stringutil.hpp"
 #include "libs/api_lua.hpp"
 #include "usertypes/lua_type_heightmap.hpp"
+#include "usertypes/lua_type_heightmap_graph.hpp"
 #include "usertypes/lua_type_voxelfragment.hpp"
 #include "usertypes/lua_type_canvas.hpp"
 #include "usertypes/lua_type_random.hpp"
 #include "usertypes/lua_type_pcmstream.hpp"
+#include "usertypes/lua_type_bufferview.hpp"
+#include "usertypes/lua_type_vec3.hpp"
+#include "lua_profiler.hpp"
 #include "engine/Engine.hpp"
 
 static debug::Logger logger("lua-state");
 static lua::State* main_thread = nullptr;
 
+/// @brief Main state registry references to the events library table and
+/// its handlers table
+static int events_ref = LUA_NOREF;
+static int handlers_ref = LUA_NOREF;
+static std::unordered_map<std::string, lua::EventHandle> interned_events;
+
+/// @brief Amount of work (in LUA_GCSTEP units) of a single collector step
+inline constexpr int GC_STEP_SIZE = 16;
+/// @brief Automatic collector is kept as a fallback for periods without
+/// step_gc calls, starting cycles at larger heap growth than the engine
+inline constexpr int GC_FALLBACK_PAUSE_FACTOR = 2;
+/// @brief Cycle is finished ignoring the budget if the heap exceeds the
+/// cycle start threshold this many times (collector falls behind)
+inline constexpr int GC_FORCE_FACTOR = 2;
+
+static bool gc_stepping = false;
+static int gc_pause = 200;
+/// @brief Cycle is started by step_gc and is not finished yet
+static bool gc_collecting = false;
+/// @brief Heap size starting the next cycle
+static int64_t gc_threshold = 0;
+static lua::GCMetrics gc_metrics {};
+static ObserverHandler memory_source;
+
+/// @return heap size in bytes
+static int64_t gc_memory(lua::State* L) {
+    return static_cast<int64_t>(lua_gc(L, LUA_GCCOUNT, 0)) * 1024 +
+           lua_gc(L, LUA_GCCOUNTB, 0);
+}
+
 using namespace lua;
 
 luaerror::luaerror(const std::string& message) : std::runtime_error(message) {
@@ -82,6 +120,8 @@ static void create_libs(State* L, StateType stateType) {
         openlib(L, "network", networklib);
         openlib(L, "pathfinding", pathfindinglib);
         openlib(L, "player", playerlib);
+        openlib(L, "profiler", profilerlib);
+        openlib(L, "systems", systemslib);
         openlib(L, "time", timelib);
         openlib(L, "world", worldlib);
 
@@ -92,6 +132,8 @@ static void create_libs(State* L, StateType stateType) {
         openlib(L, "__skeleton", skeletonlib);
         openlib(L, "__rigidbody", rigidbodylib);
         openlib(L, "__transform", transformlib);
+    } else if (stateType == StateType::WORKER) {
+        openlib(L, "system", systemlib);
     }
 
     addfunc(L, "print", lua::wrap<l_print>);
@@ -131,6 +173,8 @@ void lua::init_state(State* L, StateType stateType) {
     initialize_libs_extends(L);
 
     newusertype<LuaHeightmap>(L);
+    newusertype<LuaHeightmapGraph>(L);
+    newusertype<LuaHeightmapNode>(L);
     newusertype<LuaVoxelFragment>(L);
     newusertype<LuaCanvas>(L);
 }
@@ -144,25 +188,198 @@ void lua::initialize(const EnginePaths& paths, const CoreParameters& params) {
     );
     lua::pushstring(main_thread, params.scriptFile.stem().u8string());
     lua::setglobal(main_thread, "__VC_SCRIPT_NAME");
+
+    // full collection is the only way to release the heap memory
+    memory_source = debug::memory::add_source(
+        debug::MemoryTag::LUA,
+        []() { return static_cast<size_t>(gc_memory(main_thread)); },
+        [](size_t) {
+            int64_t memory = gc_memory(main_thread);
+            lua_gc(main_thread, LUA_GCCOLLECT, 0);
+            gc_collecting = false;
+            gc_metrics.cycles++;
+            gc_metrics.liveMemory = gc_memory(main_thread);
+            gc_threshold = gc_metrics.liveMemory / 100 * gc_pause;
+            return static_cast<size_t>(
+                std::max<int64_t>(0, memory - gc_metrics.liveMemory)
+            );
+        }
+    );
 }
 
 void lua::finalize() {
+    memory_source = ObserverHandler();
+    profiler::set_enabled(false);
+    profiler::clear();
     lua::close(main_thread);
+    main_thread = nullptr;
+    events_ref = LUA_NOREF;
+    handlers_ref = LUA_NOREF;
+    interned_events.clear();
+    gc_stepping = false;
+    gc_collecting = false;
+    gc_threshold = 0;
+    gc_metrics = {};
+}
+
+EventHandle lua::intern_event(const std::string& name) {
+    const auto& found = interned_events.find(name);
+    if (found != interned_events.end()) {
+        return found->second;
+    }
+    pushstring(main_thread, name);
+    EventHandle handle = luaL_ref(main_thread, LUA_REGISTRYINDEX);
+    interned_events[name] = handle;
+    return handle;
+}
+
+/// @brief Push events library table and its handlers table
+static bool push_events(State* L) {
+    if (L == main_thread && events_ref != LUA_NOREF) {
+        rawgeti(L, events_ref, LUA_REGISTRYINDEX);
+        rawgeti(L, handlers_ref, LUA_REGISTRYINDEX);
+        return true;
+    }
+    if (!getglobal(L, "events")) {
+        return false;
+    }
+    if (!getfield(L, "handlers")) {
+        pop(L);
+        return false;
+    }
+    if (L == main_thread) {
+        pushvalue(L, -2);
+        events_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+        pushvalue(L, -1);
+        handlers_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    }
+    return true;
+}
+
+/// @brief Emit event with name on the stack top. The name is popped
+static bool emit_pushed_event(
+    State* L, const std::function<int(State*)>& args
+) {
+    if (!push_events(L)) {
+        pop(L);
+        return false;
+    }
+    // name, events, handlers
+    pushvalue(L, -3);
+    rawget(L);
+    bool subscribed = !isnil(L, -1);
+    pop(L, 2);
+    if (!subscribed) {
+        pop(L, 2);
+        return false;
+    }
+    // name, events
+    bool profiled = profiler::is_enabled();
+    if (profiled) {
+        profiler::begin_event(L, tostring(L, -2));
+    }
+    getfield(L, "emit");
+    pushvalue(L, -3);
+    bool result = false;
+    if (call_nothrow(L, args(L) + 1)) {
+        result = toboolean(L, -1);
+        pop(L);
+    }
+    if (profiled) {
+        profiler::end_event(L);
+    }
+    pop(L, 2);
+    return result;
 }
 
 bool lua::emit_event(
     State* L, const std::string& name, std::function<int(State*)> args
 ) {
-    getglobal(L, "events");
-    getfield(L, "emit");
     pushstring(L, name);
-    if (call_nothrow(L, args(L) + 1)) {
-        bool result = toboolean(L, -1);
-        pop(L, 2);
-        return result;
+    return emit_pushed_event(L, args);
+}
+
+bool lua::emit_event(
+    State* L, EventHandle event, std::function<int(State*)> args
+) {
+    if (event <= 0) {
+        return false;
+    }
+    assert(L == main_thread);
+    rawgeti(L, event, LUA_REGISTRYINDEX);
+    return emit_pushed_event(L, args);
+}
+
+void lua::configure_gc(bool stepping, int pause, int stepmul) {
+    if (main_thread == nullptr) {
+        return;
+    }
+    gc_stepping = stepping;
+    gc_pause = pause;
+    lua_gc(
+        main_thread,
+        LUA_GCSETPAUSE,
+        stepping ? pause * GC_FALLBACK_PAUSE_FACTOR : pause
+    );
+    lua_gc(main_thread, LUA_GCSETSTEPMUL, stepmul);
+    if (!stepping) {
+        gc_collecting = false;
+        lua_gc(main_thread, LUA_GCRESTART, 0);
+        return;
+    }
+    if (gc_threshold == 0) {
+        gc_threshold = gc_memory(main_thread) / 100 * pause;
+    }
+    logger.info() << "engine GC stepping (pause: " << pause
+                  << ", stepmul: " << stepmul << ")";
+}
+
+void lua::step_gc(double budget) {
+    if (main_thread == nullptr) {
+        return;
+    }
+    auto& metrics = gc_metrics;
+    metrics.memory = gc_memory(main_thread);
+    metrics.maxMemory = std::max(metrics.maxMemory, metrics.memory);
+    if (!gc_stepping) {
+        return;
+    }
+    if (!gc_collecting) {
+        if (metrics.memory < gc_threshold) {
+            return;
+        }
+        gc_collecting = true;
     }
-    pop(L, 1);
-    return false;
+    bool forced = metrics.memory >= gc_threshold * GC_FORCE_FACTOR;
+
+    using namespace std::chrono;
+    auto start = steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        metrics.steps++;
+        bool finished = lua_gc(main_thread, LUA_GCSTEP, GC_STEP_SIZE);
+        elapsed = duration<double>(steady_clock::now() - start).count();
+        if (finished) {
+            gc_collecting = false;
+            metrics.cycles++;
+            metrics.liveMemory = gc_memory(main_thread);
+            gc_threshold = metrics.liveMemory / 100 * gc_pause;
+            break;
+        }
+    } while (forced || elapsed < budget);
+
+    // step restarts the automatic collector in the middle of the cycle,
+    // so it's paused until the next step_gc call
+    if (gc_collecting) {
+        lua_gc(main_thread, LUA_GCSTOP, 0);
+    }
+    metrics.memory = gc_memory(main_thread);
+    metrics.lastTime = elapsed;
+    metrics.maxTime = std::max(metrics.maxTime, elapsed);
+}
+
+const GCMetrics& lua::get_gc_metrics() {
+    return gc_metrics;
 }
 
 State* lua::get_main_state() {
@@ -194,10 +411,36 @@ State* lua::create_state(const EnginePaths& paths, StateType stateType) {
         }
         pop(L);
     }
+    newusertype<LuaBufferView>(L);
+    if (getglobal(L, "__vc_BufferView")) {
+        setglobal(L, "BufferView");
+    }
+    newusertype<LuaVec3>(L);
+    if (getglobal(L, "__vc_Vec3")) {
+        setglobal(L, "Vec3");
+    }
 
-    if (stateType == StateType::GENERATOR) {
+    if (stateType == StateType::GENERATOR ||
+        stateType == StateType::WORKER) {
         pushnil(L);
         setglobal(L, "ffi");
+
+        // async results are pulled by the main state only
+        const char* removed_file[] {
+            "__read_async", "__write_async", "__pull_async_results", nullptr};
+        remove_lib_funcs(L, "file", removed_file);
+        const char* removed_compression[] {
+            "__encode_async", "__decode_async", nullptr};
+        remove_lib_funcs(L, "compression", removed_compression);
+    }
+    if (stateType == StateType::WORKER) {
+        // systems run in parallel with each other, so world is read-only
+        const char* removed_block[] {
+            "set", "batch", "set_area", "set_states", "set_rotation",
+            "set_user_bits", "set_variant", "place", "destruct",
+            "schedule_update", "cancel_update", "set_field", "reload_script",
+            "__pull_register_events", nullptr};
+        remove_lib_funcs(L, "block", removed_block);
     }
     return L;
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <stdexcept>
 #include <string>
 
@@ -15,16 +16,68 @@ namespace lua {
         BASE,
         SCRIPT,
         GENERATOR,
+        /// @brief Isolated pack system state (read-only world access)
+        WORKER,
+    };
+
+    /// @brief Event name interned in the main state registry.
+    /// Valid handles are positive, 0 is used for events not registered
+    using EventHandle = int;
+
+    /// @brief Main state garbage collector metrics
+    struct GCMetrics {
+        /// @brief Heap size (bytes)
+        int64_t memory = 0;
+        /// @brief Max heap size seen by step_gc (bytes)
+        int64_t maxMemory = 0;
+        /// @brief Heap size after the last finished cycle (bytes)
+        int64_t liveMemory = 0;
+        /// @brief Number of steps performed by step_gc
+        uint64_t steps = 0;
+        /// @brief Number of cycles finished by step_gc
+        uint64_t cycles = 0;
+        /// @brief Last step_gc duration (seconds)
+        double lastTime = 0.0;
+        /// @brief Max step_gc duration (seconds)
+        double maxTime = 0.0;
     };
 
     void initialize(const EnginePaths& paths, const CoreParameters& params);
     void finalize();
 
+    /// @brief Get handle of the event name (same name - same handle)
+    EventHandle intern_event(const std::string& name);
+
+    /// @brief Call events.emit, skipping events without handlers
+    /// @return true if any of handlers returned true
     bool emit_event(
         State*,
         const std::string& name,
         std::function<int(State*)> args = [](auto*) { return 0; }
     );
+
+    /// @brief Call events.emit for the interned event (main state only),
+    /// skipping events without handlers
+    /// @return true if any of handlers returned true
+    bool emit_event(
+        State*,
+        EventHandle event,
+        std::function<int(State*)> args = [](auto*) { return 0; }
+    );
+    /// @brief Configure main state garbage collector
+    /// @param stepping collector is stepped by the engine with step_gc
+    /// instead of running on allocations
+    /// @param pause heap growth (percents) starting the next cycle
+    /// @param stepmul collector speed relative to allocations (percents)
+    void configure_gc(bool stepping, int pause, int stepmul);
+
+    /// @brief Perform main state collector steps until the time budget is
+    /// spent or the cycle is finished. Does nothing if stepping is disabled
+    /// @param budget time budget in seconds
+    void step_gc(double budget);
+
+    const GCMetrics& get_gc_metrics();
+
     State* get_main_state();
     State* create_state(const EnginePaths& paths, StateType stateType);
     [[nodiscard]] scriptenv create_environment(State* L);
@@ -8,6 +8,7 @@
 #include "engine/Engine.hpp"
 #include "devtools/DebuggingServer.hpp"
 #include "logic/scripting/scripting.hpp"
+#include "util/stringutil.hpp"
 
 using namespace devtools;
 using namespace scripting;
@@ -32,6 +33,20 @@ static int l_debug_log(lua::State* L) {
     return 0;
 }
 
+static int l_debug_set_log_level(lua::State* L) {
+    std::string name = lua::require_string(L, 1);
+    debug::LogLevel level;
+    if (!debug::Logger::parseLevel(name, level)) {
+        throw std::runtime_error("unknown log level " + util::quote(name));
+    }
+    if (lua::isstring(L, 2)) {
+        debug::Logger::setLevel(lua::require_string(L, 2), level);
+    } else {
+        debug::Logger::setLevel(level);
+    }
+    return 0;
+}
+
 const int MAX_DEPTH = 10;
 
 int l_debug_print(lua::State* L) {
@@ -395,6 +410,9 @@ void initialize_libs_extends(lua::State* L) {
         lua::pushcfunction(L, lua::wrap<l_debug_print>);
         lua::setfield(L, "print");
 
+        lua::pushcfunction(L, lua::wrap<l_debug_set_log_level>);
+        lua::setfield(L, "set_log_level");
+
         lua::pushcfunction(L, lua::wrap<l_debug_pause>);
         lua::setfield(L, "pause");
 
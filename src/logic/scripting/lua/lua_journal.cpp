@@ -0,0 +1,46 @@
+#include "lua_journal.hpp"
+
+#include "debug/Logger.hpp"
+#include "engine/Engine.hpp"
+#include "logic/scripting/scripting.hpp"
+
+static debug::Logger logger("lua-journal");
+
+devtools::InputJournal* lua::get_journal() {
+    return scripting::engine ? scripting::engine->getInputJournal() : nullptr;
+}
+
+int lua::replay_results(lua::State* L) {
+    auto results =
+        get_journal()->take(devtools::JournalEntryType::CALL_RESULT);
+    int count = results["n"].asInteger();
+    for (int i = 1; i <= count; i++) {
+        auto key = std::to_string(i);
+        if (results.has(key)) {
+            pushvalue(L, results[key]);
+        } else {
+            pushnil(L);
+        }
+    }
+    return count;
+}
+
+void lua::record_results(
+    lua::State* L, devtools::InputJournal& journal, int count
+) {
+    // nil results are not stored, binary json encoder does not support them
+    auto results = dv::object({{"n", count}});
+    int top = gettop(L);
+    for (int i = 1; i <= count; i++) {
+        int idx = top - count + i;
+        if (isnil(L, idx)) {
+            continue;
+        }
+        try {
+            results[std::to_string(i)] = tovalue(L, idx);
+        } catch (const std::exception& err) {
+            logger.error() << "could not record call result: " << err.what();
+        }
+    }
+    journal.add(devtools::JournalEntryType::CALL_RESULT, std::move(results));
+}
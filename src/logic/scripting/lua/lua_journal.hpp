@@ -0,0 +1,35 @@
+#pragma once
+
+#include "lua_util.hpp"
+#include "devtools/InputJournal.hpp"
+
+/// Non-deterministic functions (network reads, random, wall clock) are
+/// wrapped to record their results to the inputs journal, so the replay
+/// returns the recorded values without calling the functions
+namespace lua {
+    /// @return active inputs journal or nullptr
+    devtools::InputJournal* get_journal();
+
+    /// @brief Push the recorded results of the current call
+    /// @throws std::runtime_error - results are missing (replay desync)
+    int replay_results(lua::State* L);
+
+    /// @brief Record values on top of the stack as the current call results
+    void record_results(
+        lua::State* L, devtools::InputJournal& journal, int count
+    );
+
+    template <lua_CFunction func>
+    int journaled(lua::State* L) {
+        auto journal = get_journal();
+        if (journal == nullptr) {
+            return func(L);
+        }
+        if (journal->isReplaying()) {
+            return wrap<replay_results>(L);
+        }
+        int count = func(L);
+        record_results(L, *journal, count);
+        return count;
+    }
+}
@@ -0,0 +1,230 @@
+#include "lua_profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <unordered_map>
+
+#include "debug/Logger.hpp"
+#include "lua_engine.hpp"
+
+using namespace lua;
+
+static debug::Logger logger("lua-profiler");
+
+namespace {
+    struct EventRecord {
+        uint64_t calls = 0;
+        int64_t total = 0;
+        int64_t allocated = 0;
+    };
+
+    using EventEntry = std::pair<const std::string, EventRecord>;
+
+    /// @brief Event being handled
+    struct Frame {
+        /// @brief Map nodes are stable, so entry is valid until clear()
+        EventEntry* entry;
+        int64_t start;
+        int64_t memory;
+        /// @brief Time and allocations of nested events
+        int64_t nestedTime = 0;
+        int64_t nestedAllocated = 0;
+    };
+}
+
+/// @brief Everything is accessed from the main state thread only:
+/// LuaJIT calls sampling callback from the VM running the state
+static bool enabled = false;
+static State* profiled_state = nullptr;
+static std::unordered_map<std::string, EventRecord> events;
+static std::unordered_map<std::string, uint64_t> files_samples;
+static std::unordered_map<std::string, uint64_t> folded_stacks;
+static std::vector<Frame> frames;
+
+static int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+/// @return Lua heap size in bytes
+static int64_t memory_usage(State* L) {
+    return static_cast<int64_t>(lua_gc(L, LUA_GCCOUNT, 0)) * 1024 +
+           lua_gc(L, LUA_GCCOUNTB, 0);
+}
+
+static void sample_callback(void*, State* L, int samples, int vmstate) {
+    // timer samples taken while engine code is running outside of Lua are
+    // delivered on the next VM entry, so they are not scripts time
+    if (vmstate == 'C' && frames.empty()) {
+        return;
+    }
+    size_t length;
+    const char* top = luaJIT_profile_dumpstack(L, "pl", 1, &length);
+    files_samples[std::string(profiler::chunk_file({top, length}))] +=
+        samples;
+
+    std::string stack =
+        frames.empty() ? "[no event]" : frames.back().entry->first;
+    const char* dump = luaJIT_profile_dumpstack(
+        L, "pFZ;", -profiler::MAX_STACK_DEPTH, &length
+    );
+    if (length) {
+        stack += ';';
+        stack.append(dump, length);
+    }
+    if (vmstate == 'G') {
+        stack += ";[gc]";
+    }
+    folded_stacks[stack] += samples;
+}
+
+bool profiler::is_enabled() {
+    return enabled;
+}
+
+void profiler::set_enabled(bool flag, int interval) {
+    if (profiled_state) {
+        luaJIT_profile_stop(profiled_state);
+        profiled_state = nullptr;
+    }
+    enabled = false;
+    if (!flag) {
+        return;
+    }
+    State* L = get_main_state();
+    if (L == nullptr) {
+        return;
+    }
+    std::string mode = "fi" + std::to_string(std::max(1, interval));
+    luaJIT_profile_start(L, mode.c_str(), sample_callback, nullptr);
+    profiled_state = L;
+    enabled = true;
+    logger.info() << "scripts profiler started (interval: "
+                  << std::max(1, interval) << "ms)";
+}
+
+void profiler::begin_event(State* L, std::string_view name) {
+    auto& entry = *events.try_emplace(std::string(name)).first;
+    frames.push_back(Frame {&entry, now(), memory_usage(L)});
+}
+
+void profiler::end_event(State* L) {
+    // cleared while handling the event
+    if (frames.empty()) {
+        return;
+    }
+    Frame frame = frames.back();
+    frames.pop_back();
+
+    int64_t duration = now() - frame.start;
+    // collected garbage may outweigh allocations
+    int64_t allocated = std::max<int64_t>(0, memory_usage(L) - frame.memory);
+
+    auto& record = frame.entry->second;
+    record.calls++;
+    record.total += std::max<int64_t>(0, duration - frame.nestedTime);
+    record.allocated +=
+        std::max<int64_t>(0, allocated - frame.nestedAllocated);
+    if (!frames.empty()) {
+        frames.back().nestedTime += duration;
+        frames.back().nestedAllocated += allocated;
+    }
+}
+
+void profiler::clear() {
+    frames.clear();
+    events.clear();
+    files_samples.clear();
+    folded_stacks.clear();
+}
+
+std::vector<ScriptsPackStats> profiler::get_stats() {
+    std::unordered_map<std::string_view, size_t> indices;
+    std::vector<ScriptsPackStats> packs;
+    auto get_pack = [&](std::string_view packid) -> ScriptsPackStats& {
+        auto found = indices.find(packid);
+        if (found != indices.end()) {
+            return packs[found->second];
+        }
+        indices[packid] = packs.size();
+        return packs.emplace_back(
+            ScriptsPackStats {std::string(packid), 0, 0, 0, 0, {}, {}}
+        );
+    };
+    for (const auto& [name, record] : events) {
+        auto& pack = get_pack(pack_of(name));
+        pack.calls += record.calls;
+        pack.total += record.total;
+        pack.allocated += record.allocated;
+        pack.events.push_back(ScriptsEventStats {
+            name, record.calls, record.total, record.allocated});
+    }
+    for (const auto& [file, samples] : files_samples) {
+        auto& pack = get_pack(pack_of(file));
+        pack.samples += samples;
+        pack.files.push_back(ScriptsFileStats {file, samples});
+    }
+    for (auto& pack : packs) {
+        auto& events = pack.events;
+        std::sort(events.begin(), events.end(), [](auto& a, auto& b) {
+            return a.total > b.total;
+        });
+        auto& files = pack.files;
+        std::sort(files.begin(), files.end(), [](auto& a, auto& b) {
+            return a.samples > b.samples;
+        });
+    }
+    std::sort(packs.begin(), packs.end(), [](auto& a, auto& b) {
+        return a.total > b.total ||
+               (a.total == b.total && a.samples > b.samples);
+    });
+    return packs;
+}
+
+std::string profiler::to_folded_stacks() {
+    std::vector<const std::pair<const std::string, uint64_t>*> sorted;
+    sorted.reserve(folded_stacks.size());
+    for (const auto& entry : folded_stacks) {
+        sorted.push_back(&entry);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](auto a, auto b) {
+        return a->first < b->first;
+    });
+    std::stringstream ss;
+    for (const auto& entry : sorted) {
+        ss << entry->first << ' ' << entry->second << '\n';
+    }
+    return ss.str();
+}
+
+std::string_view profiler::chunk_file(std::string_view frame) {
+    constexpr std::string_view stringPrefix = "[string \"";
+    if (frame.substr(0, stringPrefix.length()) == stringPrefix) {
+        frame.remove_prefix(stringPrefix.length());
+        return frame.substr(0, frame.find("\"]"));
+    }
+    if (!frame.empty() && (frame[0] == '@' || frame[0] == '=')) {
+        frame.remove_prefix(1);
+    }
+    size_t separator = frame.rfind(':');
+    if (separator == std::string_view::npos ||
+        separator + 1 == frame.length()) {
+        return frame;
+    }
+    for (size_t i = separator + 1; i < frame.length(); i++) {
+        if (frame[i] < '0' || frame[i] > '9') {
+            return frame;
+        }
+    }
+    return frame.substr(0, separator);
+}
+
+std::string_view profiler::pack_of(std::string_view name) {
+    size_t separator = name.find(':');
+    if (separator == std::string_view::npos) {
+        return "";
+    }
+    return name.substr(0, separator);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lua_commons.hpp"
+
+namespace lua {
+    /// @brief Event handlers statistics. Durations do not include nested
+    /// events handlers
+    struct ScriptsEventStats {
+        std::string name;
+        uint64_t calls;
+        /// @brief Nanoseconds
+        int64_t total;
+        /// @brief Approximate bytes allocated by handlers (Lua heap growth)
+        int64_t allocated;
+    };
+
+    /// @brief Number of samples taken while executing the script file
+    struct ScriptsFileStats {
+        std::string file;
+        uint64_t samples;
+    };
+
+    struct ScriptsPackStats {
+        std::string packid;
+        uint64_t calls;
+        int64_t total;
+        int64_t allocated;
+        uint64_t samples;
+        /// @brief Sorted by total duration (descending)
+        std::vector<ScriptsEventStats> events;
+        /// @brief Sorted by samples (descending)
+        std::vector<ScriptsFileStats> files;
+    };
+
+    /// @brief Main Lua state scripts profiler. Attributes events handlers
+    /// time and allocations to packs, and LuaJIT profiler samples to
+    /// script files and call stacks
+    namespace profiler {
+        /// @brief Default sampling interval (milliseconds)
+        inline constexpr int DEFAULT_INTERVAL = 10;
+
+        /// @brief Max number of stack frames kept in a sample
+        inline constexpr int MAX_STACK_DEPTH = 48;
+
+        bool is_enabled();
+
+        /// @brief Start or stop sampling of the main state.
+        /// Recorded statistics are kept
+        /// @param interval sampling interval in milliseconds
+        void set_enabled(bool flag, int interval = DEFAULT_INTERVAL);
+
+        /// @brief Called by emit_event before handlers are called
+        void begin_event(State* L, std::string_view name);
+
+        /// @brief Called by emit_event after handlers are called
+        void end_event(State* L);
+
+        /// @brief Drop recorded statistics and samples
+        void clear();
+
+        /// @return packs statistics since start or clear sorted by total
+        /// handlers duration (descending)
+        std::vector<ScriptsPackStats> get_stats();
+
+        /// @brief Export samples in folded stacks format used by
+        /// flamegraph.pl, speedscope and inferno. Stacks are rooted by
+        /// the event name being handled
+        std::string to_folded_stacks();
+
+        /// @brief Get script file name from a chunk name or a stack frame
+        /// ('[string "base:scripts/a.lua"]:12' -> 'base:scripts/a.lua')
+        std::string_view chunk_file(std::string_view frame);
+
+        /// @brief Get pack id from an event or a file name prefix
+        /// ('base:stone.update' -> 'base')
+        std::string_view pack_of(std::string_view name);
+    }
+}
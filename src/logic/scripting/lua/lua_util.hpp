@@ -7,6 +7,7 @@
 
 #include "data/dv.hpp"
 #include "lua_wrapper.hpp"
+#include "usertypes/lua_type_vec3.hpp"
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/quaternion.hpp>
 
@@ -162,6 +163,12 @@ namespace lua {
     }
     template <int n, typename T = float>
     inline int setvec(lua::State* L, int idx, glm::vec<n, T> vec) {
+        if constexpr (n == 3) {
+            if (auto dst = LuaVec3::get(L, idx)) {
+                dst->vec = vec;
+                return pushvalue(L, idx);
+            }
+        }
         pushvalue(L, idx);
         for (int i = 0; i < n; i++) {
             pushnumber(L, vec[i]);
@@ -169,6 +176,22 @@ namespace lua {
         }
         return 1;
     }
+    /// @brief Write vector to the destination argument (vec3 table or Vec3)
+    /// to not create a table per call, or push a new table if the
+    /// argument is absent
+    template <int n, typename T = float>
+    inline int pushvec_out(lua::State* L, int idx, glm::vec<n, T> vec) {
+        if (lua_istable(L, idx)) {
+            return setvec(L, idx, vec);
+        }
+        if constexpr (n == 3) {
+            if (LuaVec3::get(L, idx)) {
+                return setvec(L, idx, vec);
+            }
+        }
+        return pushvec(L, vec);
+    }
+
     inline int pushcfunction(lua::State* L, lua_CFunction func) {
         lua_pushcfunction(L, func);
         return 1;
@@ -200,6 +223,10 @@ namespace lua {
         lua_pushboolean(L, value);
         return 1;
     }
+    inline int pushlightuserdata(lua::State* L, void* ptr) {
+        lua_pushlightuserdata(L, ptr);
+        return 1;
+    }
     inline int pushglobals(lua::State* L) {
         return pushvalue(L, LUA_GLOBALSINDEX);
     }
@@ -315,6 +342,11 @@ namespace lua {
 
     template <int n, typename T = float>
     inline glm::vec<n, T> tovec(lua::State* L, int idx) {
+        if constexpr (n == 3) {
+            if (auto vec = LuaVec3::get(L, idx)) {
+                return glm::vec<n, T>(vec->vec);
+            }
+        }
         pushvalue(L, idx);
         if (!istable(L, idx) || objlen(L, idx) < n) {
             throw std::runtime_error(
@@ -346,6 +378,9 @@ namespace lua {
         return glm::vec2(x, y);
     }
     inline glm::vec3 tovec3(lua::State* L, int idx) {
+        if (auto vec = LuaVec3::get(L, idx)) {
+            return vec->vec;
+        }
         pushvalue(L, idx);
         if (!istable(L, idx) || objlen(L, idx) < 3) {
             throw std::runtime_error("value must be an array of three numbers");
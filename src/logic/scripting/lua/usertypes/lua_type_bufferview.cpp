@@ -0,0 +1,149 @@
+#include "lua_type_bufferview.hpp"
+
+#include <cstring>
+#include <unordered_map>
+
+#include "devtools/Project.hpp"
+#include "engine/Engine.hpp"
+
+using namespace lua;
+
+/// @brief FFI types available for views created by scripts
+static const std::unordered_map<std::string, size_t> element_sizes {
+    {"int8_t", 1},
+    {"uint8_t", 1},
+    {"int16_t", 2},
+    {"uint16_t", 2},
+    {"int32_t", 4},
+    {"uint32_t", 4},
+    {"float", 4},
+    {"double", 8},
+    {"vc_voxel", 4},
+};
+
+LuaBufferView::LuaBufferView(
+    std::shared_ptr<const void> owner,
+    void* data,
+    size_t length,
+    std::string elementType,
+    bool readonly,
+    std::function<bool()> validator
+)
+    : owner(std::move(owner)),
+      data(data),
+      length(length),
+      elementType(std::move(elementType)),
+      readonly(readonly),
+      validator(std::move(validator)) {
+}
+
+LuaBufferView::~LuaBufferView() = default;
+
+size_t LuaBufferView::getSize() const {
+    return length * element_sizes.at(elementType);
+}
+
+bool LuaBufferView::isValid() const {
+    return validator == nullptr || validator();
+}
+
+LuaBufferView* LuaBufferView::get(lua::State* L, int idx) {
+    if (istable(L, idx)) {
+        if (!getfield(L, "handle", idx)) {
+            return nullptr;
+        }
+        auto view = get(L, -1);
+        pop(L);
+        return view;
+    }
+    if (!isuserdata(L, idx)) {
+        return nullptr;
+    }
+    auto userdata = touserdata<Userdata>(L, idx);
+    if (userdata == nullptr || userdata->getTypeName() != TYPENAME) {
+        return nullptr;
+    }
+    return static_cast<LuaBufferView*>(userdata);
+}
+
+void LuaBufferView::requirePermission() {
+    const auto& permissions = scripting::engine->getProject().permissions;
+    if (!permissions.has(Permissions::FFI_VIEWS)) {
+        throw std::runtime_error("project has no ffi-views permission");
+    }
+}
+
+int lua::wrap_buffer_view(lua::State* L) {
+    if (!getglobal(L, "__vc_wrap_view")) {
+        throw std::runtime_error("views are not available");
+    }
+    pushvalue(L, -2);
+    call(L, 1, 1);
+    // replace handle with the view table
+    lua_replace(L, -2);
+    return 1;
+}
+
+static int l_is_valid(lua::State* L) {
+    auto view = LuaBufferView::get(L, 1);
+    return pushboolean(L, view && view->isValid());
+}
+
+static int l_meta_meta_call(lua::State* L) {
+    auto type = require_string(L, 2);
+    auto length = tointeger(L, 3);
+    auto found = element_sizes.find(type);
+    if (found == element_sizes.end() || found->first == "vc_voxel") {
+        throw std::runtime_error(
+            "unsupported view type '" + std::string(type) + "'"
+        );
+    }
+    if (length <= 0) {
+        throw std::runtime_error("invalid view length");
+    }
+    size_t size = length * found->second;
+    std::shared_ptr<ubyte[]> buffer(new ubyte[size]);
+    std::memset(buffer.get(), 0, size);
+    auto data = buffer.get();
+    return LuaBufferView::create(
+        L, std::move(buffer), data, length, std::string(type), false
+    );
+}
+
+static int l_meta_tostring(lua::State* L) {
+    return pushstring(L, "BufferView");
+}
+
+static int l_meta_index(lua::State* L) {
+    auto view = touserdata<LuaBufferView>(L, 1);
+    if (view == nullptr || !isstring(L, 2)) {
+        return 0;
+    }
+    auto name = tostring(L, 2);
+    if (!std::strcmp(name, "address")) {
+        return pushlightuserdata(L, view->getData());
+    } else if (!std::strcmp(name, "length")) {
+        return pushinteger(L, view->getLength());
+    } else if (!std::strcmp(name, "type")) {
+        return pushstring(L, view->getElementType());
+    } else if (!std::strcmp(name, "readonly")) {
+        return pushboolean(L, view->isReadonly());
+    } else if (!std::strcmp(name, "is_valid")) {
+        return pushcfunction(L, lua::wrap<l_is_valid>);
+    }
+    return 0;
+}
+
+int LuaBufferView::createMetatable(lua::State* L) {
+    createtable(L, 0, 2);
+    pushcfunction(L, lua::wrap<l_meta_tostring>);
+    setfield(L, "__tostring");
+    pushcfunction(L, lua::wrap<l_meta_index>);
+    setfield(L, "__index");
+
+    createtable(L, 0, 1);
+    pushcfunction(L, lua::wrap<l_meta_meta_call>);
+    setfield(L, "__call");
+    setmetatable(L);
+    return 1;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "../lua_util.hpp"
+
+namespace lua {
+    /// @brief Handle of an engine buffer accessed from Lua via FFI without
+    /// copying. Keeps the buffer owner alive while the handle exists
+    class LuaBufferView : public Userdata {
+    public:
+        /// @param owner object owning the buffer memory
+        /// @param data buffer start
+        /// @param length number of elements
+        /// @param elementType FFI element type name
+        /// @param readonly view is created with const pointer type
+        /// @param validator checks if the buffer is not moved or released
+        /// by the owner (nullptr - always valid)
+        LuaBufferView(
+            std::shared_ptr<const void> owner,
+            void* data,
+            size_t length,
+            std::string elementType,
+            bool readonly,
+            std::function<bool()> validator = nullptr
+        );
+        ~LuaBufferView() override;
+
+        void* getData() const {
+            return data;
+        }
+
+        size_t getLength() const {
+            return length;
+        }
+
+        /// @return buffer size in bytes
+        size_t getSize() const;
+
+        const std::string& getElementType() const {
+            return elementType;
+        }
+
+        bool isReadonly() const {
+            return readonly;
+        }
+
+        bool isValid() const;
+
+        const std::string& getTypeName() const override {
+            return TYPENAME;
+        }
+
+        /// @brief Push a view, wrapped into a table having typed FFI
+        /// pointer (see __vc_wrap_view). Project must have ffi-views
+        /// permission
+        template <typename... Args>
+        static int create(lua::State* L, Args&&... args);
+
+        /// @return handle of the view table or handle at index, nullptr if
+        /// the value is not a view
+        static LuaBufferView* get(lua::State* L, int idx);
+
+        /// @throws std::runtime_error if project has no ffi-views
+        /// permission
+        static void requirePermission();
+
+        static int createMetatable(lua::State*);
+        inline static std::string TYPENAME = "__vc_BufferView";
+    private:
+        std::shared_ptr<const void> owner;
+        void* data;
+        size_t length;
+        std::string elementType;
+        bool readonly;
+        std::function<bool()> validator;
+    };
+    static_assert(!std::is_abstract<LuaBufferView>());
+
+    /// @brief Wrap handle at the stack top into the view table
+    int wrap_buffer_view(lua::State* L);
+
+    template <typename... Args>
+    int LuaBufferView::create(lua::State* L, Args&&... args) {
+        requirePermission();
+        newuserdata<LuaBufferView>(L, std::forward<Args>(args)...);
+        return wrap_buffer_view(L);
+    }
+}
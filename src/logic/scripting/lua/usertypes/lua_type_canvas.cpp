@@ -4,6 +4,7 @@
 #include "graphics/core/ImageData.hpp"
 #include "graphics/core/Texture.hpp"
 #include "logic/scripting/lua/lua_util.hpp"
+#include "lua_type_bufferview.hpp"
 #include "coders/imageio.hpp"
 #include "engine/Engine.hpp"
 #include "assets/Assets.hpp"
@@ -26,8 +27,21 @@ void LuaCanvas::update(int extrusion) {
     if (!hasTexture()) {
         return;
     }
+    // only pixels modified since the last update are uploaded
+    auto dirty = data->getDirty();
+    if (dirty.empty()) {
+        return;
+    }
     if (region.isFull()) {
-        texture->reload(*data);
+        uint width = data->getWidth();
+        uint height = data->getHeight();
+        if (texture->getWidth() != width || texture->getHeight() != height ||
+            (dirty.w == static_cast<int>(width) &&
+             dirty.h == static_cast<int>(height))) {
+            texture->reload(*data);
+        } else {
+            texture->reloadRegion(*data, dirty);
+        }
     } else {
         uint texWidth = texture->getWidth();
         uint texHeight = texture->getHeight();
@@ -63,6 +77,7 @@ void LuaCanvas::update(int extrusion) {
             texture->reloadPartial(*data, x, y, w, h);
         }
     }
+    data->resetDirty();
 }
 
 void LuaCanvas::createTexture() {
@@ -142,8 +157,12 @@ static int l_set(State* L) {
     auto x = static_cast<uint>(tointeger(L, 2));
     auto y = static_cast<uint>(tointeger(L, 3));
 
-    if (auto pixel = get_at(L, x, y)) {
-        *pixel = get_rgba(L, 4);
+    if (auto canvas = touserdata<LuaCanvas>(L, 1)) {
+        auto& image = canvas->getData();
+        if (auto pixel = get_at(image, x, y)) {
+            *pixel = get_rgba(L, 4);
+            image.markDirty(x, y, 1, 1);
+        }
     }
     return 0;
 }
@@ -161,6 +180,7 @@ static int l_clear(State* L) {
     auto& canvas = require_canvas(L, 1);
     auto& image = canvas.getData();
     ubyte* data = image.getData();
+    image.markDirty();
     RGBA rgba {};
     if (gettop(L) == 1) {
         std::fill(data, data + image.getDataSize(), 0);
@@ -217,6 +237,7 @@ static int l_set_data(State* L) {
     auto& canvas = require_canvas(L, 1);
     auto& image = canvas.getData();
     auto data = image.getData();
+    image.markDirty();
 
     if (lua::isstring(L, 2)) {
         auto ptr = reinterpret_cast<ubyte*>(std::stoull(lua::tostring(L, 2)));
@@ -332,6 +353,24 @@ static int l_encode(State* L) {
     return lua::create_bytearray(L, buffer.data(), buffer.size());
 }
 
+static int l_view(State* L) {
+    auto& canvas = require_canvas(L, 1);
+    const auto& image = canvas.shareData();
+    auto data = image->getData();
+    // writes through the view are not tracked
+    image->disableDirtyTracking();
+    // image is kept alive by the view
+    return LuaBufferView::create(
+        L,
+        image,
+        data,
+        image->getDataSize(),
+        "uint8_t",
+        false,
+        [image = image.get(), data]() { return image->getData() == data; }
+    );
+}
+
 static std::unordered_map<std::string, lua_CFunction> methods {
     {"at", lua::wrap<l_at>},
     {"set", lua::wrap<l_set>},
@@ -348,6 +387,7 @@ static std::unordered_map<std::string, lua_CFunction> methods {
     {"encode", lua::wrap<l_encode>},
     {"get_data", lua::wrap<l_get_data>},
     {"_set_data", lua::wrap<l_set_data>},
+    {"view", lua::wrap<l_view>},
 };
 
 static int l_meta_index(State* L) {
@@ -386,8 +426,12 @@ static int l_meta_newindex(State* L) {
     }
     auto& data = texture->getData();
     if (isnumber(L, 2) && isnumber(L, 3)) {
-        if (auto pixel = get_at(data, static_cast<uint>(tointeger(L, 2)))) {
+        auto index = static_cast<uint>(tointeger(L, 2));
+        if (auto pixel = get_at(data, index)) {
             pixel->rgba = static_cast<uint>(tointeger(L, 3));
+            data.markDirty(
+                index % data.getWidth(), index / data.getWidth(), 1, 1
+            );
         }
     }
     return 0;
@@ -29,6 +29,10 @@ namespace lua {
             return *data;
         }
 
+        [[nodiscard]] const auto& shareData() const {
+            return data;
+        }
+
         [[nodiscard]] bool hasTexture() const {
             return texture != nullptr;
         }
@@ -1,16 +1,17 @@
 #include "lua_type_heightmap.hpp"
 
 #include "util/functional_util.hpp"
-#define FNL_IMPL
 #include "maths/FastNoiseLite.h"
 #include "coders/imageio.hpp"
 #include "io/util.hpp"
 #include "graphics/core/ImageData.hpp"
 #include "maths/Heightmap.hpp"
+#include "maths/noise.hpp"
 #include "engine/Engine.hpp"
 #include "engine/EnginePaths.hpp"
 #include "../lua_util.hpp"
 #include "lua_type_heightmap.hpp"
+#include "lua_type_bufferview.hpp"
 
 #include <cstring>
 #include <sstream>
@@ -83,7 +84,7 @@ static int l_at(lua::State* L) {
     return 0;
 }
 
-template<fnl_noise_type noise_type>
+template<NoiseType noise_type>
 static int l_noise(lua::State* L) {
     if (auto heightmap = touserdata<LuaHeightmap>(L, 1)) {
         uint w = heightmap->getWidth();
@@ -110,28 +111,20 @@ static int l_noise(lua::State* L) {
         if (gettop(L) > 6) {
             shiftMapY = touserdata<LuaHeightmap>(L, 7);
         }
-        noise->noise_type = noise_type;
-        for (uint y = 0; y < h; y++) {
-            for (uint x = 0; x < w; x++) {
-                uint i = y * w + x;
-                for (uint c = 0; c < octaves; c++) {
-                    float m = s * (1 << c);
-                    float value = heights[i];
-                    float u = (x + offset.x) * m;
-                    float v = (y + offset.y) * m;
-                    if (shiftMapX) {
-                        u += shiftMapX->getValues()[i];
-                    }
-                    if (shiftMapY) {
-                        v += shiftMapY->getValues()[i];
-                    }
-
-                    value += fnlGetNoise2D(noise, u, v) /
-                            static_cast<float>(1 << c) * multiplier;
-                    heights[i] = value;
-                }
-            }
-        }
+        noise::add_octaves2d(
+            noise_type,
+            noise->seed,
+            offset,
+            s,
+            octaves,
+            multiplier,
+            w,
+            0,
+            w * h,
+            heights,
+            shiftMapX ? shiftMapX->getValues() : nullptr,
+            shiftMapY ? shiftMapY->getValues() : nullptr
+        );
     }
     return 0;
 }
@@ -235,7 +228,19 @@ static int l_resize(lua::State* L) {
         } else if (std::strcmp(interpName, "cubic") == 0) {
             interpolation = InterpolationType::CUBIC;
         }
-        heightmap->getHeightmap()->resize(width, height, interpolation);
+        if (gettop(L) >= 8) {
+            heightmap->getHeightmap()->resize(
+                width,
+                height,
+                interpolation,
+                touinteger(L, 5),
+                touinteger(L, 6),
+                touinteger(L, 7),
+                touinteger(L, 8)
+            );
+        } else {
+            heightmap->getHeightmap()->resize(width, height, interpolation);
+        }
     }
     return 0;
 }
@@ -253,10 +258,33 @@ static int l_crop(lua::State* L) {
     return 0;
 }
 
+static int l_view(lua::State* L) {
+    auto heightmap = touserdata<LuaHeightmap>(L, 1);
+    if (heightmap == nullptr) {
+        return 0;
+    }
+    const auto& map = heightmap->getHeightmap();
+    auto values = map->getValues();
+    size_t length = map->getWidth() * map->getHeight();
+    // resize and crop move the values buffer
+    return LuaBufferView::create(
+        L,
+        map,
+        values,
+        length,
+        "float",
+        false,
+        [map = map.get(), values, length]() {
+            return map->getValues() == values &&
+                   map->getWidth() * map->getHeight() == length;
+        }
+    );
+}
+
 static std::unordered_map<std::string, lua_CFunction> methods {
     {"dump", lua::wrap<l_dump>},
-    {"noise", lua::wrap<l_noise<FNL_NOISE_OPENSIMPLEX2>>},
-    {"cellnoise", lua::wrap<l_noise<FNL_NOISE_CELLULAR>>},
+    {"noise", lua::wrap<l_noise<NoiseType::SIMPLEX>>},
+    {"cellnoise", lua::wrap<l_noise<NoiseType::CELLULAR>>},
     {"pow", lua::wrap<l_binop_func<util::pow>>},
     {"add", lua::wrap<l_binop_func<std::plus>>},
     {"sub", lua::wrap<l_binop_func<std::minus>>},
@@ -268,6 +296,7 @@ static std::unordered_map<std::string, lua_CFunction> methods {
     {"crop", lua::wrap<l_crop>},
     {"at", lua::wrap<l_at>},
     {"mixin", lua::wrap<l_mixin>},
+    {"view", lua::wrap<l_view>},
 };
 
 static int l_meta_meta_call(lua::State* L) {
@@ -0,0 +1,277 @@
+#include "lua_type_heightmap_graph.hpp"
+
+#include "lua_type_heightmap.hpp"
+#include "maths/Heightmap.hpp"
+#include "../lua_util.hpp"
+
+#include <cstring>
+#include <unordered_map>
+
+using namespace lua;
+
+LuaHeightmapGraph::LuaHeightmapGraph(uint width, uint height)
+    : graph(std::make_shared<HeightmapGraph>(width, height)) {
+}
+
+template <class T>
+static T* touserdata_of(lua::State* L, int idx) {
+    if (!isuserdata(L, idx)) {
+        return nullptr;
+    }
+    auto data = touserdata<Userdata>(L, idx);
+    if (data && data->getTypeName() == T::TYPENAME) {
+        return static_cast<T*>(data);
+    }
+    return nullptr;
+}
+
+static LuaHeightmapNode& require_node(lua::State* L, int idx) {
+    if (auto node = touserdata_of<LuaHeightmapNode>(L, idx)) {
+        return *node;
+    }
+    throw std::runtime_error("heightmap graph node expected");
+}
+
+/// @return register of the graph node or an input register created for
+/// the heightmap
+static HeightmapGraph::Register to_register(
+    lua::State* L, int idx, HeightmapGraph& graph
+) {
+    if (auto node = touserdata_of<LuaHeightmapNode>(L, idx)) {
+        if (node->getGraph().get() != &graph) {
+            throw std::runtime_error("node belongs to another graph");
+        }
+        return node->getRegister();
+    } else if (auto map = touserdata_of<LuaHeightmap>(L, idx)) {
+        return graph.input(map->getHeightmap());
+    }
+    throw std::runtime_error("heightmap or graph node expected");
+}
+
+static HeightmapGraph::Operand to_operand(
+    lua::State* L, int idx, HeightmapGraph& graph
+) {
+    if (isnumber(L, idx)) {
+        return HeightmapGraph::Operand::of(
+            static_cast<float>(tonumber(L, idx))
+        );
+    }
+    return HeightmapGraph::Operand::of(to_register(L, idx, graph));
+}
+
+template <NoiseType type>
+static int l_node_noise(lua::State* L) {
+    auto& node = require_node(L, 1);
+    auto& graph = *node.getGraph();
+
+    HeightmapGraph::NoiseParams params {};
+    params.type = type;
+    params.seed = node.getSeed();
+    params.offset = tovec<2>(L, 2);
+    params.scale = tonumber(L, 3);
+    if (gettop(L) > 3) {
+        params.octaves = tointeger(L, 4);
+    }
+    if (gettop(L) > 4) {
+        params.multiplier = tonumber(L, 5);
+    }
+    if (!isnoneornil(L, 6)) {
+        params.shiftX = to_register(L, 6, graph);
+    }
+    if (!isnoneornil(L, 7)) {
+        params.shiftY = to_register(L, 7, graph);
+    }
+    graph.noise(node.getRegister(), params);
+    return 0;
+}
+
+template <HeightmapBinaryOp op>
+static int l_node_binop(lua::State* L) {
+    auto& node = require_node(L, 1);
+    auto& graph = *node.getGraph();
+    graph.binary(op, node.getRegister(), to_operand(L, 2, graph));
+    return 0;
+}
+
+static int l_node_abs(lua::State* L) {
+    auto& node = require_node(L, 1);
+    node.getGraph()->abs(node.getRegister());
+    return 0;
+}
+
+static int l_node_mixin(lua::State* L) {
+    auto& node = require_node(L, 1);
+    auto& graph = *node.getGraph();
+    auto value = to_operand(L, 2, graph);
+    auto t = to_operand(L, 3, graph);
+    graph.mixin(node.getRegister(), value, t);
+    return 0;
+}
+
+static std::unordered_map<std::string, lua_CFunction> node_methods {
+    {"noise", wrap<l_node_noise<NoiseType::SIMPLEX>>},
+    {"cellnoise", wrap<l_node_noise<NoiseType::CELLULAR>>},
+    {"add", wrap<l_node_binop<HeightmapBinaryOp::ADD>>},
+    {"sub", wrap<l_node_binop<HeightmapBinaryOp::SUB>>},
+    {"mul", wrap<l_node_binop<HeightmapBinaryOp::MUL>>},
+    {"pow", wrap<l_node_binop<HeightmapBinaryOp::POW>>},
+    {"min", wrap<l_node_binop<HeightmapBinaryOp::MIN>>},
+    {"max", wrap<l_node_binop<HeightmapBinaryOp::MAX>>},
+    {"abs", wrap<l_node_abs>},
+    {"mixin", wrap<l_node_mixin>},
+};
+
+static int l_node_meta_index(lua::State* L) {
+    auto node = touserdata_of<LuaHeightmapNode>(L, 1);
+    if (node == nullptr || !isstring(L, 2)) {
+        return 0;
+    }
+    auto fieldname = tostring(L, 2);
+    if (!std::strcmp(fieldname, "width")) {
+        return pushinteger(L, node->getGraph()->getWidth());
+    } else if (!std::strcmp(fieldname, "height")) {
+        return pushinteger(L, node->getGraph()->getHeight());
+    } else if (!std::strcmp(fieldname, "noiseSeed")) {
+        return pushinteger(L, node->getSeed());
+    }
+    auto found = node_methods.find(fieldname);
+    if (found != node_methods.end()) {
+        return pushcfunction(L, found->second);
+    }
+    return 0;
+}
+
+static int l_node_meta_newindex(lua::State* L) {
+    auto node = touserdata_of<LuaHeightmapNode>(L, 1);
+    if (node == nullptr || !isstring(L, 2)) {
+        return 0;
+    }
+    if (!std::strcmp(tostring(L, 2), "noiseSeed")) {
+        node->setSeed(tointeger(L, 3));
+    }
+    return 0;
+}
+
+static int l_node_meta_tostring(lua::State* L) {
+    auto node = touserdata_of<LuaHeightmapNode>(L, 1);
+    if (node == nullptr) {
+        return 0;
+    }
+    return pushstring(
+        L, "HeightmapNode(" + std::to_string(node->getRegister()) + ")"
+    );
+}
+
+int LuaHeightmapNode::createMetatable(lua::State* L) {
+    createtable(L, 0, 3);
+    pushcfunction(L, wrap<l_node_meta_tostring>);
+    setfield(L, "__tostring");
+    pushcfunction(L, wrap<l_node_meta_index>);
+    setfield(L, "__index");
+    pushcfunction(L, wrap<l_node_meta_newindex>);
+    setfield(L, "__newindex");
+    return 1;
+}
+
+static LuaHeightmapGraph& require_graph(lua::State* L, int idx) {
+    if (auto graph = touserdata_of<LuaHeightmapGraph>(L, idx)) {
+        return *graph;
+    }
+    throw std::runtime_error("heightmap graph expected");
+}
+
+static int l_graph_map(lua::State* L) {
+    const auto& graph = require_graph(L, 1).getGraph();
+    return newuserdata<LuaHeightmapNode>(L, graph, graph->create());
+}
+
+static int l_graph_input(lua::State* L) {
+    const auto& graph = require_graph(L, 1).getGraph();
+    auto map = touserdata_of<LuaHeightmap>(L, 2);
+    if (map == nullptr) {
+        throw std::runtime_error("heightmap expected");
+    }
+    return newuserdata<LuaHeightmapNode>(
+        L, graph, graph->input(map->getHeightmap())
+    );
+}
+
+static int l_graph_evaluate(lua::State* L) {
+    const auto& graph = require_graph(L, 1).getGraph();
+    int argc = gettop(L);
+    std::vector<HeightmapGraph::Register> outputs;
+    for (int i = 2; i <= argc; i++) {
+        auto& node = require_node(L, i);
+        if (node.getGraph() != graph) {
+            throw std::runtime_error("node belongs to another graph");
+        }
+        outputs.push_back(node.getRegister());
+    }
+    auto maps = graph->evaluate(outputs);
+    for (const auto& map : maps) {
+        newuserdata<LuaHeightmap>(L, map);
+    }
+    return maps.size();
+}
+
+static std::unordered_map<std::string, lua_CFunction> graph_methods {
+    {"map", wrap<l_graph_map>},
+    {"input", wrap<l_graph_input>},
+    {"evaluate", wrap<l_graph_evaluate>},
+};
+
+static int l_graph_meta_meta_call(lua::State* L) {
+    auto width = tointeger(L, 2);
+    auto height = tointeger(L, 3);
+    if (width <= 0 || height <= 0) {
+        throw std::runtime_error("width and height must be greater than 0");
+    }
+    return newuserdata<LuaHeightmapGraph>(
+        L, static_cast<uint>(width), static_cast<uint>(height)
+    );
+}
+
+static int l_graph_meta_index(lua::State* L) {
+    auto graph = touserdata_of<LuaHeightmapGraph>(L, 1);
+    if (graph == nullptr || !isstring(L, 2)) {
+        return 0;
+    }
+    auto fieldname = tostring(L, 2);
+    if (!std::strcmp(fieldname, "width")) {
+        return pushinteger(L, graph->getGraph()->getWidth());
+    } else if (!std::strcmp(fieldname, "height")) {
+        return pushinteger(L, graph->getGraph()->getHeight());
+    }
+    auto found = graph_methods.find(fieldname);
+    if (found != graph_methods.end()) {
+        return pushcfunction(L, found->second);
+    }
+    return 0;
+}
+
+static int l_graph_meta_tostring(lua::State* L) {
+    auto graph = touserdata_of<LuaHeightmapGraph>(L, 1);
+    if (graph == nullptr) {
+        return 0;
+    }
+    const auto& ptr = graph->getGraph();
+    return pushstring(
+        L, "HeightmapGraph(" + std::to_string(ptr->getWidth()) + "*" +
+               std::to_string(ptr->getHeight()) + ", " +
+               std::to_string(ptr->getOperationsCount()) + " operations)"
+    );
+}
+
+int LuaHeightmapGraph::createMetatable(lua::State* L) {
+    createtable(L, 0, 2);
+    pushcfunction(L, wrap<l_graph_meta_tostring>);
+    setfield(L, "__tostring");
+    pushcfunction(L, wrap<l_graph_meta_index>);
+    setfield(L, "__index");
+
+    createtable(L, 0, 1);
+    pushcfunction(L, wrap<l_graph_meta_meta_call>);
+    setfield(L, "__call");
+    setmetatable(L);
+    return 1;
+}
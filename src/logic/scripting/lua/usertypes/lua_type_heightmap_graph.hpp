@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../lua_commons.hpp"
+#include "maths/HeightmapGraph.hpp"
+
+namespace lua {
+    class LuaHeightmapGraph : public Userdata {
+        std::shared_ptr<HeightmapGraph> graph;
+    public:
+        LuaHeightmapGraph(uint width, uint height);
+        virtual ~LuaHeightmapGraph() override = default;
+
+        const std::shared_ptr<HeightmapGraph>& getGraph() const {
+            return graph;
+        }
+
+        const std::string& getTypeName() const override {
+            return TYPENAME;
+        }
+
+        static int createMetatable(lua::State*);
+        inline static std::string TYPENAME = "HeightmapGraph";
+    };
+    static_assert(!std::is_abstract<LuaHeightmapGraph>());
+
+    /// @brief Heightmap graph register used like a regular heightmap
+    class LuaHeightmapNode : public Userdata {
+        std::shared_ptr<HeightmapGraph> graph;
+        HeightmapGraph::Register reg;
+        int noiseSeed = 0;
+    public:
+        LuaHeightmapNode(
+            std::shared_ptr<HeightmapGraph> graph, HeightmapGraph::Register reg
+        )
+            : graph(std::move(graph)), reg(reg) {
+        }
+        virtual ~LuaHeightmapNode() override = default;
+
+        const std::shared_ptr<HeightmapGraph>& getGraph() const {
+            return graph;
+        }
+
+        HeightmapGraph::Register getRegister() const {
+            return reg;
+        }
+
+        int getSeed() const {
+            return noiseSeed;
+        }
+
+        void setSeed(int64_t seed) {
+            noiseSeed = seed;
+        }
+
+        const std::string& getTypeName() const override {
+            return TYPENAME;
+        }
+
+        static int createMetatable(lua::State*);
+        inline static std::string TYPENAME = "__vc_HeightmapNode";
+    };
+    static_assert(!std::is_abstract<LuaHeightmapNode>());
+}
@@ -1,5 +1,6 @@
 #include "../lua_util.hpp"
 #include "lua_type_pcmstream.hpp"
+#include "lua_type_bufferview.hpp"
 #include "assets/Assets.hpp"
 #include "audio/MemoryPCMStream.hpp"
 #include "engine/Engine.hpp"
@@ -23,6 +24,15 @@ static int l_feed(lua::State* L) {
     if (stream == nullptr) {
         return 0;
     }
+    if (auto view = LuaBufferView::get(L, 2)) {
+        if (!view->isValid()) {
+            throw std::runtime_error("invalid view");
+        }
+        stream->getStream()->feed(
+            {static_cast<const ubyte*>(view->getData()), view->getSize()}
+        );
+        return 0;
+    }
     auto bytes = bytearray_as_string(L, 2);
     stream->getStream()->feed(
         {reinterpret_cast<const ubyte*>(bytes.data()), bytes.size()}
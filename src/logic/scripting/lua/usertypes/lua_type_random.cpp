@@ -1,3 +1,4 @@
+#include "../lua_journal.hpp"
 #include "../lua_util.hpp"
 #include "lua_type_random.hpp"
 
@@ -29,6 +30,9 @@ static int l_meta_meta_call(lua::State* L) {
     integer_t seed;
     if (lua::isnoneornil(L, 1)) {
         seed = system_clock::now().time_since_epoch().count();
+        if (auto journal = get_journal()) {
+            seed = journal->pass(seed).asInteger();
+        }
     } else {
         seed = tointeger(L, 1);
     }
@@ -0,0 +1,169 @@
+#include "../lua_util.hpp"
+#include "lua_type_vec3.hpp"
+
+#include "util/stringutil.hpp"
+
+using namespace lua;
+
+/// @return component index or -1 if key is not a component
+static int component_index(lua::State* L, int idx) {
+    if (isnumber(L, idx)) {
+        int index = tointeger(L, idx) - 1;
+        return index >= 0 && index < 3 ? index : -1;
+    }
+    if (!isstring(L, idx)) {
+        return -1;
+    }
+    size_t length;
+    const char* name = lua_tolstring(L, idx, &length);
+    if (length != 1 || name[0] < 'x' || name[0] > 'z') {
+        return -1;
+    }
+    return name[0] - 'x';
+}
+
+/// @brief Get arithmetic operand (Vec3, vec3 table or scalar)
+static glm::dvec3 to_operand(lua::State* L, int idx) {
+    if (isnumber(L, idx)) {
+        return glm::dvec3(tonumber(L, idx));
+    }
+    if (auto vec = LuaVec3::get(L, idx)) {
+        return vec->vec;
+    }
+    return tovec3(L, idx);
+}
+
+static int l_set(lua::State* L) {
+    auto& vec = require_userdata<LuaVec3>(L, 1).vec;
+    if (isnumber(L, 2)) {
+        vec = glm::dvec3(tonumber(L, 2), tonumber(L, 3), tonumber(L, 4));
+    } else {
+        vec = to_operand(L, 2);
+    }
+    pushvalue(L, 1);
+    return 1;
+}
+
+static int l_unpack(lua::State* L) {
+    auto& vec = require_userdata<LuaVec3>(L, 1).vec;
+    pushnumber(L, vec.x);
+    pushnumber(L, vec.y);
+    pushnumber(L, vec.z);
+    return 3;
+}
+
+static int l_copy(lua::State* L) {
+    return newuserdata<LuaVec3>(L, require_userdata<LuaVec3>(L, 1).vec);
+}
+
+static int l_meta_index(lua::State* L) {
+    auto& vec = require_userdata<LuaVec3>(L, 1).vec;
+    int index = component_index(L, 2);
+    if (index >= 0) {
+        return pushnumber(L, vec[index]);
+    }
+    if (!isstring(L, 2)) {
+        return 0;
+    }
+    static const std::unordered_map<std::string_view, lua_CFunction> methods {
+        {"set", wrap<l_set>},
+        {"unpack", wrap<l_unpack>},
+        {"copy", wrap<l_copy>},
+    };
+    auto found = methods.find(tostring(L, 2));
+    if (found == methods.end()) {
+        return 0;
+    }
+    return pushcfunction(L, found->second);
+}
+
+static int l_meta_newindex(lua::State* L) {
+    auto& vec = require_userdata<LuaVec3>(L, 1).vec;
+    int index = component_index(L, 2);
+    if (index < 0) {
+        throw std::runtime_error("invalid Vec3 component");
+    }
+    vec[index] = tonumber(L, 3);
+    return 0;
+}
+
+static int l_meta_add(lua::State* L) {
+    return newuserdata<LuaVec3>(L, to_operand(L, 1) + to_operand(L, 2));
+}
+
+static int l_meta_sub(lua::State* L) {
+    return newuserdata<LuaVec3>(L, to_operand(L, 1) - to_operand(L, 2));
+}
+
+static int l_meta_mul(lua::State* L) {
+    return newuserdata<LuaVec3>(L, to_operand(L, 1) * to_operand(L, 2));
+}
+
+static int l_meta_div(lua::State* L) {
+    return newuserdata<LuaVec3>(L, to_operand(L, 1) / to_operand(L, 2));
+}
+
+static int l_meta_unm(lua::State* L) {
+    return newuserdata<LuaVec3>(L, -require_userdata<LuaVec3>(L, 1).vec);
+}
+
+static int l_meta_eq(lua::State* L) {
+    auto a = LuaVec3::get(L, 1);
+    auto b = LuaVec3::get(L, 2);
+    return pushboolean(L, a && b && a->vec == b->vec);
+}
+
+static int l_meta_len(lua::State* L) {
+    return pushinteger(L, 3);
+}
+
+static int l_meta_tostring(lua::State* L) {
+    auto& vec = require_userdata<LuaVec3>(L, 1).vec;
+    return pushstring(
+        L,
+        "Vec3(" + util::to_string(vec.x) + ", " + util::to_string(vec.y) +
+            ", " + util::to_string(vec.z) + ")"
+    );
+}
+
+static int l_meta_meta_call(lua::State* L) {
+    if (isnoneornil(L, 2)) {
+        return newuserdata<LuaVec3>(L, glm::dvec3(0.0));
+    }
+    if (isnumber(L, 2)) {
+        return newuserdata<LuaVec3>(
+            L, glm::dvec3(tonumber(L, 2), tonumber(L, 3), tonumber(L, 4))
+        );
+    }
+    return newuserdata<LuaVec3>(L, to_operand(L, 2));
+}
+
+int LuaVec3::createMetatable(lua::State* L) {
+    createtable(L, 0, 10);
+    pushcfunction(L, wrap<l_meta_index>);
+    setfield(L, "__index");
+    pushcfunction(L, wrap<l_meta_newindex>);
+    setfield(L, "__newindex");
+    pushcfunction(L, wrap<l_meta_add>);
+    setfield(L, "__add");
+    pushcfunction(L, wrap<l_meta_sub>);
+    setfield(L, "__sub");
+    pushcfunction(L, wrap<l_meta_mul>);
+    setfield(L, "__mul");
+    pushcfunction(L, wrap<l_meta_div>);
+    setfield(L, "__div");
+    pushcfunction(L, wrap<l_meta_unm>);
+    setfield(L, "__unm");
+    pushcfunction(L, wrap<l_meta_eq>);
+    setfield(L, "__eq");
+    pushcfunction(L, wrap<l_meta_len>);
+    setfield(L, "__len");
+    pushcfunction(L, wrap<l_meta_tostring>);
+    setfield(L, "__tostring");
+
+    createtable(L, 0, 1);
+    pushcfunction(L, wrap<l_meta_meta_call>);
+    setfield(L, "__call");
+    setmetatable(L);
+    return 1;
+}
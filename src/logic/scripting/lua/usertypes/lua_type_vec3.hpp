@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../lua_commons.hpp"
+
+namespace lua {
+    /// @brief Mutable 3D vector userdata indexed as x, y, z or 1, 2, 3.
+    /// Accepted everywhere a vec3 table is, so getters may write to a
+    /// reused vector instead of creating tables per call
+    class LuaVec3 : public Userdata {
+    public:
+        glm::dvec3 vec;
+
+        explicit LuaVec3(const glm::dvec3& vec) : vec(vec) {
+        }
+        virtual ~LuaVec3() override = default;
+
+        const std::string& getTypeName() const override {
+            return TYPENAME;
+        }
+
+        /// @return vector at the stack index or nullptr if value is not
+        /// a Vec3
+        static LuaVec3* get(lua::State* L, int idx) {
+            // size check keeps foreign userdata from being accessed as
+            // engine userdata
+            if (lua_type(L, idx) != LUA_TUSERDATA ||
+                lua_objlen(L, idx) != sizeof(LuaVec3)) {
+                return nullptr;
+            }
+            auto userdata = static_cast<Userdata*>(lua_touserdata(L, idx));
+            if (userdata->getTypeName() != TYPENAME) {
+                return nullptr;
+            }
+            return static_cast<LuaVec3*>(userdata);
+        }
+
+        static int createMetatable(lua::State*);
+        inline static std::string TYPENAME = "__vc_Vec3";
+    };
+    static_assert(!std::is_abstract<LuaVec3>());
+}
@@ -1,10 +1,12 @@
 #include "scripting.hpp"
 
 #include "scripting_commons.hpp"
+#include "scripting_systems.hpp"
 #include "content/Content.hpp"
 #include "content/ContentPack.hpp"
 #include "content/ContentControl.hpp"
 #include "debug/Logger.hpp"
+#include "debug/Profiler.hpp"
 #include "engine/Engine.hpp"
 #include "engine/EnginePaths.hpp"
 #include "io/io.hpp"
@@ -13,9 +15,11 @@
 #include "items/ItemDef.hpp"
 #include "logic/BlocksController.hpp"
 #include "logic/LevelController.hpp"
+#include "lua/lua_async.hpp"
 #include "lua/lua_engine.hpp"
 #include "maths/Heightmap.hpp"
 #include "objects/Player.hpp"
+#include "settings.hpp"
 #include "util/stringutil.hpp"
 #include "util/timeutil.hpp"
 #include "voxels/Block.hpp"
@@ -25,6 +29,7 @@
 #include "world/World.hpp"
 #include "interfaces/Process.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
@@ -42,6 +47,9 @@ ContentControl* scripting::content_control = nullptr;
 BlocksController* scripting::blocks = nullptr;
 LevelController* scripting::controller = nullptr;
 
+/// @brief Handles of packs world tick events emitted every tick
+static std::vector<lua::EventHandle> world_tick_events;
+
 void scripting::load_script(const io::path& name, bool throwable) {
     io::path file = io::path("res:scripts") / name;
     std::string src = io::read_string(file);
@@ -65,6 +73,27 @@ int scripting::load_script(
     return lua::execute(lua::get_main_state(), env, src, fileName);
 }
 
+/// @brief Share of the tick slack given to the garbage collector
+inline constexpr double GC_SLACK_SHARE = 0.5;
+
+void scripting::configure_gc() {
+    const auto& settings = engine->getSettings().scripting;
+    lua::configure_gc(
+        settings.gcStepping.get(),
+        settings.gcPause.get(),
+        settings.gcStepMul.get()
+    );
+}
+
+void scripting::step_gc(double slack) {
+    VC_PROFILE_ZONE("scripting::step_gc");
+    const auto& settings = engine->getSettings().scripting;
+    double minBudget = settings.gcMinBudget.get() / 1000.0;
+    double maxBudget =
+        std::max(minBudget, settings.gcMaxBudget.get() / 1000.0);
+    lua::step_gc(std::clamp(slack * GC_SLACK_SHARE, minBudget, maxBudget));
+}
+
 void scripting::initialize(Engine* engine) {
     scripting::engine = engine;
     scripting::content_control = &engine->getContentControl();
@@ -267,6 +296,31 @@ static int push_properties_tables(
     return 1;
 }
 
+/// @brief Push table of content units ids by full names
+template <typename T, typename IdType>
+static int push_ids_table(
+    lua::State* L, const ContentUnitIndices<T, IdType>& indices
+) {
+    const auto units = indices.getDefs();
+    size_t size = indices.count();
+    lua::createtable(L, 0, size);
+    for (size_t i = 0; i < size; i++) {
+        lua::pushinteger(L, i);
+        lua::setfield(L, units[i]->name);
+    }
+    return 1;
+}
+
+static int push_tags_table(lua::State* L, const Content& content) {
+    const auto& tags = content.getTags();
+    lua::createtable(L, 0, tags.size());
+    for (const auto& [name, index] : tags) {
+        lua::pushinteger(L, index);
+        lua::setfield(L, name);
+    }
+    return 1;
+}
+
 void scripting::on_content_load(Content* content) {
     scripting::content = content;
     scripting::indices = content->getIndices();
@@ -285,11 +339,21 @@ void scripting::on_content_load(Content* content) {
         
         push_properties_tables(L, indices.blocks);
         lua::setfield(L, "properties");
+
+        push_ids_table(L, indices.blocks);
+        lua::setfield(L, "ids");
+        push_tags_table(L, *content);
+        lua::setfield(L, "tag_ids");
         lua::pop(L);
     }
     if (lua::getglobal(L, "item")) {
         push_properties_tables(L, indices.items);
         lua::setfield(L, "properties");
+
+        push_ids_table(L, indices.items);
+        lua::setfield(L, "ids");
+        push_tags_table(L, *content);
+        lua::setfield(L, "tag_ids");
         lua::pop(L);
     }
     load_script("post_content.lua", true);
@@ -311,23 +375,30 @@ void scripting::on_world_load(LevelController* controller) {
         lua::call_nothrow(L, 0, 0);
     } 
     
+    load_worker_systems();
+
+    world_tick_events.clear();
     for (auto& pack : content_control->getAllContentPacks()) {
         lua::emit_event(L, pack.id + ":.worldopen", [](auto L) {
             return lua::pushboolean(
                 L, !scripting::level->getWorld()->getInfo().isLoaded
             );
         });
+        world_tick_events.push_back(lua::intern_event(pack.id + ":.worldtick"));
     }
 }
 
 void scripting::on_world_tick(int tps) {
+    VC_PROFILE_ZONE("scripting::on_world_tick");
+    on_worker_systems_tick(tps);
+
     auto L = lua::get_main_state();
     if (lua::getglobal(L, "__vc_on_world_tick")) {
         lua::pushinteger(L, tps);
         lua::call_nothrow(L, 1, 0);
     } 
-    for (auto& pack : content_control->getAllContentPacks()) {
-        lua::emit_event(L, pack.id + ":.worldtick");
+    for (auto event : world_tick_events) {
+        lua::emit_event(L, event);
     }
 }
 
@@ -356,6 +427,10 @@ void scripting::on_world_quit() {
     if (lua::getglobal(L, "__vc_on_world_quit")) {
         lua::call_nothrow(L, 0, 0);
     }
+    // operations may use the world entry-point removed after quit
+    lua::async::wait();
+    unload_worker_systems();
+    world_tick_events.clear();
     scripting::level = nullptr;
     scripting::content = nullptr;
     scripting::indices = nullptr;
@@ -384,10 +459,12 @@ void scripting::cleanup(const std::vector<std::string>& nonReset) {
 }
 
 void scripting::on_blocks_tick(const Block& block, int tps) {
-    std::string name = block.name + ".blockstick";
-    lua::emit_event(lua::get_main_state(), name, [tps](auto L) {
-        return lua::pushinteger(L, tps);
-    });
+    VC_PROFILE_ZONE("scripting::on_blocks_tick");
+    lua::emit_event(
+        lua::get_main_state(),
+        block.rt.eventNames.blocksTick,
+        [tps](auto L) { return lua::pushinteger(L, tps); }
+    );
 }
 
 void scripting::update_block(const Block& block, const glm::ivec3& pos) {
@@ -404,10 +481,40 @@ void scripting::random_update_block(const Block& block, const glm::ivec3& pos) {
     });
 }
 
-/// TODO: replace template with index
-template<bool WorldFuncsSet::*worldfunc>
+void scripting::scheduled_update_block(
+    const Block& block, const glm::ivec3& pos
+) {
+    lua::emit_event(lua::get_main_state(), block.rt.eventNames.scheduledUpdate,
+    [pos](auto L) {
+        return lua::pushivec_stack(L, pos);
+    });
+}
+
+void scripting::random_update_blocks(
+    const Block& block, const std::vector<glm::ivec3>& positions
+) {
+    lua::emit_event(lua::get_main_state(), block.rt.eventNames.randomUpdates,
+    [&positions](auto L) {
+        lua::createtable(L, positions.size() * 3, 0);
+        for (size_t i = 0; i < positions.size(); i++) {
+            const auto& pos = positions[i];
+            lua::pushinteger(L, pos.x);
+            lua::rawseti(L, i * 3 + 1);
+            lua::pushinteger(L, pos.y);
+            lua::rawseti(L, i * 3 + 2);
+            lua::pushinteger(L, pos.z);
+            lua::rawseti(L, i * 3 + 3);
+        }
+        lua::pushinteger(L, positions.size());
+        return 2;
+    });
+}
+
+template <
+    bool WorldFuncsSet::*worldfunc,
+    int WorldFuncNamesCache::*worldevent>
 static bool on_block_common(
-    const std::string& suffix,
+    lua::EventHandle event,
     bool blockfunc,
     Player* player,
     const Block& block,
@@ -415,9 +522,8 @@ static bool on_block_common(
 ) {
     bool result = false;
     if (blockfunc) {
-        std::string name = block.name + "." + suffix;
         result =
-            lua::emit_event(lua::get_main_state(), name, [pos, player](auto L) {
+            lua::emit_event(lua::get_main_state(), event, [pos, player](auto L) {
                 lua::pushivec_stack(L, pos);
                 lua::pushinteger(L, player ? player->getId() : -1);
                 return 4;
@@ -432,7 +538,7 @@ static bool on_block_common(
     for (auto& [packid, pack] : content->getPacks()) {
         if (pack->worldfuncsset.*worldfunc) {
             lua::emit_event(
-                lua::get_main_state(), packid + ":.block" + suffix, args
+                lua::get_main_state(), pack->worldeventnames.*worldevent, args
             );
         }
     }
@@ -442,43 +548,91 @@ static bool on_block_common(
 void scripting::on_block_placed(
     Player* player, const Block& block, const glm::ivec3& pos
 ) {
-    on_block_common<&WorldFuncsSet::onblockplaced>(
-        "placed", block.rt.funcsset.onplaced, player, block, pos
+    on_block_common<
+        &WorldFuncsSet::onblockplaced,
+        &WorldFuncNamesCache::onblockplaced>(
+        block.rt.eventNames.placed,
+        block.rt.funcsset.onplaced,
+        player,
+        block,
+        pos
     );
 }
 
 void scripting::on_block_replaced(
     Player* player, const Block& block, const glm::ivec3& pos
 ) {
-    on_block_common<&WorldFuncsSet::onblockreplaced>(
-        "replaced", block.rt.funcsset.onreplaced, player, block, pos
+    on_block_common<
+        &WorldFuncsSet::onblockreplaced,
+        &WorldFuncNamesCache::onblockreplaced>(
+        block.rt.eventNames.replaced,
+        block.rt.funcsset.onreplaced,
+        player,
+        block,
+        pos
     );
 }
 
 void scripting::on_block_breaking(
     Player* player, const Block& block, const glm::ivec3& pos
 ) {
-    on_block_common<&WorldFuncsSet::onblockbreaking>(
-        "breaking", block.rt.funcsset.onbreaking, player, block, pos
+    on_block_common<
+        &WorldFuncsSet::onblockbreaking,
+        &WorldFuncNamesCache::onblockbreaking>(
+        block.rt.eventNames.breaking,
+        block.rt.funcsset.onbreaking,
+        player,
+        block,
+        pos
     );
 }
 
 void scripting::on_block_broken(
     Player* player, const Block& block, const glm::ivec3& pos
 ) {
-    on_block_common<&WorldFuncsSet::onblockbroken>(
-        "broken", block.rt.funcsset.onbroken, player, block, pos
+    on_block_common<
+        &WorldFuncsSet::onblockbroken,
+        &WorldFuncNamesCache::onblockbroken>(
+        block.rt.eventNames.broken,
+        block.rt.funcsset.onbroken,
+        player,
+        block,
+        pos
     );
 }
 
 bool scripting::on_block_interact(
     Player* player, const Block& block, const glm::ivec3& pos
 ) {
-    return on_block_common<&WorldFuncsSet::onblockinteract>(
-        "interact", block.rt.funcsset.oninteract, player, block, pos
+    return on_block_common<
+        &WorldFuncsSet::onblockinteract,
+        &WorldFuncNamesCache::onblockinteract>(
+        block.rt.eventNames.interact,
+        block.rt.funcsset.oninteract,
+        player,
+        block,
+        pos
     );
 }
 
+void scripting::on_blocks_batch(
+    const glm::ivec3& min, const glm::ivec3& max, size_t count
+) {
+    auto args = [&min, &max, count](lua::State* L) {
+        lua::pushivec_stack(L, min);
+        lua::pushivec_stack(L, max);
+        lua::pushinteger(L, count);
+        return 7;
+    };
+    for (auto& [packid, pack] : content->getPacks()) {
+        if (pack->worldfuncsset.onblocksbatch) {
+            lua::emit_event(
+                lua::get_main_state(), pack->worldeventnames.onblocksbatch, args
+            );
+        }
+    }
+}
+
 void scripting::on_chunk_present(const Chunk& chunk, bool loaded) {
     auto args = [&chunk, loaded](lua::State* L) {
         lua::pushvec_stack<2>(L, {chunk.x, chunk.z});
@@ -488,7 +642,7 @@ void scripting::on_chunk_present(const Chunk& chunk, bool loaded) {
     for (auto& [packid, pack] : content->getPacks()) {
         if (pack->worldfuncsset.onchunkpresent) {
             lua::emit_event(
-                lua::get_main_state(), packid + ":.chunkpresent", args
+                lua::get_main_state(), pack->worldeventnames.onchunkpresent, args
             );
         }
     }
@@ -503,7 +657,7 @@ void scripting::on_chunk_remove(const Chunk& chunk) {
     for (auto& [packid, pack] : content->getPacks()) {
         if (pack->worldfuncsset.onchunkremove) {
             lua::emit_event(
-                lua::get_main_state(), packid + ":.chunkremove", args
+                lua::get_main_state(), pack->worldeventnames.onchunkremove, args
             );
         }
     }
@@ -519,7 +673,7 @@ void scripting::on_inventory_open(const Player* player, const Inventory& invento
     for (auto& [packid, pack] : content->getPacks()) {
         if (pack->worldfuncsset.oninventoryopen) {
             lua::emit_event(
-                lua::get_main_state(), packid + ":.inventoryopen", args
+                lua::get_main_state(), pack->worldeventnames.oninventoryopen, args
             );
         }
     }
@@ -534,13 +688,14 @@ void scripting::on_inventory_closed(const Player* player, const Inventory& inven
     for (auto& [packid, pack] : content->getPacks()) {
         if (pack->worldfuncsset.oninventoryclosed) {
             lua::emit_event(
-                lua::get_main_state(), packid + ":.inventoryclosed", args
+                lua::get_main_state(), pack->worldeventnames.oninventoryclosed, args
             );
         }
     }
 }
 
 void scripting::on_player_tick(Player* player, int tps) {
+    VC_PROFILE_ZONE("scripting::on_player_tick");
     auto args = [=](lua::State* L) {
         lua::pushinteger(L, player ? player->getId() : -1);
         lua::pushinteger(L, tps);
@@ -549,17 +704,16 @@ void scripting::on_player_tick(Player* player, int tps) {
     for (auto& [packid, pack] : content->getPacks()) {
         if (pack->worldfuncsset.onplayertick) {
             lua::emit_event(
-                lua::get_main_state(), packid + ":.playertick", args
+                lua::get_main_state(), pack->worldeventnames.onplayertick, args
             );
         }
     }
 }
 
 bool scripting::on_item_use(Player* player, const ItemDef& item) {
-    std::string name = item.name + ".use";
     return lua::emit_event(
         lua::get_main_state(),
-        name,
+        item.rt.eventNames.use,
         [player](lua::State* L) { return lua::pushinteger(L, player->getId()); }
     );
 }
@@ -567,10 +721,9 @@ bool scripting::on_item_use(Player* player, const ItemDef& item) {
 bool scripting::on_item_use_on_block(
     Player* player, const ItemDef& item, glm::ivec3 ipos, glm::ivec3 normal
 ) {
-    std::string name = item.name + ".useon";
     return lua::emit_event(
         lua::get_main_state(),
-        name,
+        item.rt.eventNames.useOn,
         [ipos, normal, player](auto L) {
             lua::pushivec_stack(L, ipos);
             lua::pushinteger(L, player->getId());
@@ -583,10 +736,9 @@ bool scripting::on_item_use_on_block(
 bool scripting::on_item_break_block(
     Player* player, const ItemDef& item, int x, int y, int z
 ) {
-    std::string name = item.name + ".blockbreakby";
     return lua::emit_event(
         lua::get_main_state(),
-        name,
+        item.rt.eventNames.blockBreakBy,
         [x, y, z, player](auto L) {
             lua::pushivec_stack(L, glm::ivec3(x, y, z));
             lua::pushinteger(L, player->getId());
@@ -671,6 +823,8 @@ void scripting::load_content_script(
     funcsset.update = register_event(env, "on_update", prefix + ".update");
     funcsset.randupdate =
         register_event(env, "on_random_update", prefix + ".randupdate");
+    funcsset.randupdates =
+        register_event(env, "on_random_updates", prefix + ".randupdates");
     funcsset.onbreaking =
         register_event(env, "on_breaking", prefix + ".breaking");
     funcsset.onbroken = register_event(env, "on_broken", prefix + ".broken");
@@ -687,9 +841,21 @@ void scripting::load_content_script(
         register_event(env, "on_block_present", prefix + ".blockpresent");
     funcsset.onblockremoved =
         register_event(env, "on_block_removed", prefix + ".blockremoved");
+    funcsset.scheduledupdate = register_event(
+        env, "on_scheduled_update", prefix + ".scheduledupdate"
+    );
 
-    namesCache.update = prefix + ".update";
-    namesCache.randomUpdate = prefix + ".randupdate";
+    namesCache.update = lua::intern_event(prefix + ".update");
+    namesCache.randomUpdate = lua::intern_event(prefix + ".randupdate");
+    namesCache.randomUpdates = lua::intern_event(prefix + ".randupdates");
+    namesCache.scheduledUpdate =
+        lua::intern_event(prefix + ".scheduledupdate");
+    namesCache.blocksTick = lua::intern_event(prefix + ".blockstick");
+    namesCache.placed = lua::intern_event(prefix + ".placed");
+    namesCache.replaced = lua::intern_event(prefix + ".replaced");
+    namesCache.breaking = lua::intern_event(prefix + ".breaking");
+    namesCache.broken = lua::intern_event(prefix + ".broken");
+    namesCache.interact = lua::intern_event(prefix + ".interact");
 }
 
 void scripting::load_content_script(
@@ -710,6 +876,10 @@ void scripting::load_content_script(
         register_event(env, "on_use_on_block", prefix + ".useon");
     funcsset.on_block_break_by =
         register_event(env, "on_block_break_by", prefix + ".blockbreakby");
+
+    namesCache.use = lua::intern_event(prefix + ".use");
+    namesCache.useOn = lua::intern_event(prefix + ".useon");
+    namesCache.blockBreakBy = lua::intern_event(prefix + ".blockbreakby");
 }
 
 void scripting::load_entity_component(
@@ -730,7 +900,8 @@ void scripting::load_world_script(
     const std::string& prefix,
     const io::path& file,
     const std::string& fileName,
-    WorldFuncsSet& funcsset
+    WorldFuncsSet& funcsset,
+    WorldFuncNamesCache& namesCache
 ) {
     int env = *senv;
     lua::pop(lua::get_main_state(), load_script(env, "world", file, fileName));
@@ -751,6 +922,8 @@ void scripting::load_world_script(
         register_event(env, "on_block_replaced", prefix + ":.blockreplaced");
     funcsset.onblockinteract =
         register_event(env, "on_block_interact", prefix + ":.blockinteract");
+    funcsset.onblocksbatch =
+        register_event(env, "on_blocks_batch", prefix + ":.blocksbatch");
     funcsset.onplayertick =
         register_event(env, "on_player_tick", prefix + ":.playertick");
     funcsset.onchunkpresent =
@@ -761,6 +934,19 @@ void scripting::load_world_script(
         register_event(env, "on_inventory_open", prefix + ":.inventoryopen");
     funcsset.oninventoryclosed =
         register_event(env, "on_inventory_closed", prefix + ":.inventoryclosed");
+
+    namesCache.onblockplaced = lua::intern_event(prefix + ":.blockplaced");
+    namesCache.onblockbreaking = lua::intern_event(prefix + ":.blockbreaking");
+    namesCache.onblockbroken = lua::intern_event(prefix + ":.blockbroken");
+    namesCache.onblockreplaced = lua::intern_event(prefix + ":.blockreplaced");
+    namesCache.onblockinteract = lua::intern_event(prefix + ":.blockinteract");
+    namesCache.onblocksbatch = lua::intern_event(prefix + ":.blocksbatch");
+    namesCache.onplayertick = lua::intern_event(prefix + ":.playertick");
+    namesCache.onchunkpresent = lua::intern_event(prefix + ":.chunkpresent");
+    namesCache.onchunkremove = lua::intern_event(prefix + ":.chunkremove");
+    namesCache.oninventoryopen = lua::intern_event(prefix + ":.inventoryopen");
+    namesCache.oninventoryclosed =
+        lua::intern_event(prefix + ":.inventoryclosed");
 }
 
 void scripting::load_layout_script(
@@ -780,6 +966,7 @@ void scripting::load_layout_script(
 }
 
 void scripting::close() {
+    lua::async::shutdown();
     lua::finalize();
     content = nullptr;
     indices = nullptr;
@@ -27,6 +27,7 @@ struct BlockFuncNamesCache;
 struct ItemFuncsSet;
 struct ItemFuncNamesCache;
 struct WorldFuncsSet;
+struct WorldFuncNamesCache;
 struct UserComponent;
 struct UiDocScript;
 class BlocksController;
@@ -50,6 +51,14 @@ namespace scripting {
 
     void initialize(Engine* engine);
 
+    /// @brief Apply main state garbage collector settings
+    void configure_gc();
+
+    /// @brief Step main state garbage collector at the tick end
+    /// @param slack tick time left (seconds), the collector budget is
+    /// clamped to the scripting settings limits
+    void step_gc(double slack);
+
     void on_content_load(Content* content);
     void on_content_reset();
 
@@ -89,6 +98,13 @@ namespace scripting {
     void on_blocks_tick(const Block& block, int tps);
     void update_block(const Block& block, const glm::ivec3& pos);
     void random_update_block(const Block& block, const glm::ivec3& pos);
+    /// @brief Call on_scheduled_update of the block (see block.schedule_update)
+    void scheduled_update_block(const Block& block, const glm::ivec3& pos);
+    /// @brief Call on_random_updates once for all randomly updated blocks
+    /// of the type
+    void random_update_blocks(
+        const Block& block, const std::vector<glm::ivec3>& positions
+    );
     void on_block_placed(
         Player* player, const Block& block, const glm::ivec3& pos
     );
@@ -102,6 +118,13 @@ namespace scripting {
         Player* player, const Block& block, const glm::ivec3& pos
     );
     bool on_block_interact(Player* player, const Block& block, const glm::ivec3& pos);
+    /// @brief Called once after a blocks batch is applied
+    /// @param min minimal corner of the changed blocks bounding box
+    /// @param max maximal corner of the changed blocks bounding box
+    /// @param count number of changed blocks
+    void on_blocks_batch(
+        const glm::ivec3& min, const glm::ivec3& max, size_t count
+    );
     
     void on_chunk_present(const Chunk& chunk, bool loaded);
     void on_chunk_remove(const Chunk& chunk);
@@ -138,6 +161,9 @@ namespace scripting {
         const dv::value& saved
     );
     void on_entity_despawn(const Entity& entity);
+    /// @brief Notify entity update callbacks about simulation rate change
+    /// @param divider tick rate divider (0 if entity is frozen)
+    void on_entity_rate_change(entityid_t uid, int divider);
     void on_entity_grounded(const Entity& entity, float force);
     void on_entity_fall(const Entity& entity);
     void on_entity_save(const Entity& entity);
@@ -217,7 +243,8 @@ namespace scripting {
         const std::string& packid,
         const io::path& file,
         const std::string& fileName,
-        WorldFuncsSet& funcsset
+        WorldFuncsSet& funcsset,
+        WorldFuncNamesCache& namesCache
     );
 
     /// @brief Load script associated with an UiDocument
@@ -1,5 +1,6 @@
 #include "scripting.hpp"
 
+#include "debug/Profiler.hpp"
 #include "lua/lua_engine.hpp"
 #include "objects/Entities.hpp"
 #include "objects/EntityDef.hpp"
@@ -129,6 +130,9 @@ void scripting::on_entity_spawn(
     for (auto& component : components) {
         create_component(L, -1, *component, args, saved);
     }
+    lua::get_from(L, STDCOMP, "register_components", true);
+    lua::pushinteger(L, eid);
+    lua::call_nothrow(L, 1, 0);
 }
 
 static void process_entity_callback(
@@ -176,6 +180,14 @@ void scripting::on_entity_despawn(const Entity& entity) {
     lua::call(L, 1, 0);
 }
 
+void scripting::on_entity_rate_change(entityid_t uid, int divider) {
+    auto L = lua::get_main_state();
+    lua::get_from(L, "stdcomp", "set_rate", true);
+    lua::pushinteger(L, uid);
+    lua::pushinteger(L, divider);
+    lua::call(L, 2, 0);
+}
+
 void scripting::on_entity_grounded(const Entity& entity, float force) {
     process_entity_callback(
         entity,
@@ -270,6 +282,7 @@ void scripting::on_entity_used(const Entity& entity, Player* player) {
 }
 
 void scripting::on_entities_update(int tps, int parts, int part) {
+    VC_PROFILE_ZONE("scripting::on_entities_update");
     auto L = lua::get_main_state();
     lua::get_from(L, STDCOMP, "update", true);
     lua::pushinteger(L, tps);
@@ -280,6 +293,7 @@ void scripting::on_entities_update(int tps, int parts, int part) {
 }
 
 void scripting::on_entities_physics_update(float delta) {
+    VC_PROFILE_ZONE("scripting::on_entities_physics_update");
     auto L = lua::get_main_state();
     lua::get_from(L, STDCOMP, "physics_update", true);
     lua::pushnumber(L, delta);
@@ -1,6 +1,7 @@
 #include "scripting_hud.hpp"
 
 #include "debug/Logger.hpp"
+#include "debug/Profiler.hpp"
 #include "engine/Engine.hpp"
 #include "io/io.hpp"
 #include "assets/Assets.hpp"
@@ -63,6 +64,7 @@ void scripting::on_frontend_init(
 }
 
 void scripting::on_frontend_render() {
+    VC_PROFILE_ZONE("scripting::on_frontend_render");
     for (auto& pack : content_control->getAllContentPacks()) {
         lua::emit_event(
             lua::get_main_state(),
@@ -0,0 +1,201 @@
+#include "scripting_systems.hpp"
+
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+#include "scripting.hpp"
+#include "content/ContentControl.hpp"
+#include "content/ContentPack.hpp"
+#include "debug/Logger.hpp"
+#include "debug/Profiler.hpp"
+#include "engine/Engine.hpp"
+#include "io/io.hpp"
+#include "lua/lua_engine.hpp"
+#include "settings.hpp"
+#include "util/ThreadPool.hpp"
+
+using namespace scripting;
+
+static debug::Logger logger("systems");
+
+/// @brief Registry field storing the state system pointer
+inline constexpr const char* SYSTEM_REGISTRY_FIELD = "__vc_system";
+
+using namespace lua;
+
+WorkerSystem::WorkerSystem(
+    std::string name, const io::path& file, const std::string& fileName
+)
+    : name(std::move(name)),
+      L(create_state(engine->getPaths(), StateType::WORKER)) {
+    stackguard _(L);
+    pushlightuserdata(L, this);
+    lua_setfield(L, LUA_REGISTRYINDEX, SYSTEM_REGISTRY_FIELD);
+
+    pushstring(L, this->name);
+    setglobal(L, "SYSTEM_NAME");
+    pushstring(L, fileName);
+    setglobal(L, "__FILE__");
+    try {
+        loadbuffer(L, 0, io::read_string(file), fileName);
+        call_nothrow(L, 0, 0);
+    } catch (const std::runtime_error& err) {
+        logger.error() << fileName << ": " << err.what();
+        failed = true;
+    }
+}
+
+WorkerSystem::~WorkerSystem() {
+    lua::close(L);
+}
+
+void WorkerSystem::tick(int tps) {
+    if (failed) {
+        inbox.clear();
+        return;
+    }
+    stackguard _(L);
+    if (!inbox.empty() && getglobal(L, "on_message")) {
+        for (const auto& message : inbox) {
+            pushvalue(L, -1);
+            pushvalue(L, message);
+            call_nothrow(L, 1, 0);
+        }
+    }
+    inbox.clear();
+    if (getglobal(L, "on_tick")) {
+        pushinteger(L, tps);
+        call_nothrow(L, 1, 0);
+    }
+}
+
+void WorkerSystem::dispatchMessages() {
+    if (outbox.empty()) {
+        return;
+    }
+    // messages sent by handlers are dispatched on the next tick
+    auto messages = std::move(outbox);
+    outbox.clear();
+
+    auto state = get_main_state();
+    std::string event = name + ".message";
+    for (const auto& message : messages) {
+        emit_event(state, event, [&message](State* state) {
+            return pushvalue(state, message);
+        });
+    }
+}
+
+void WorkerSystem::post(dv::value message) {
+    inbox.push_back(std::move(message));
+}
+
+void WorkerSystem::send(dv::value message) {
+    outbox.push_back(std::move(message));
+}
+
+WorkerSystem* WorkerSystem::of(State* L) {
+    lua_getfield(L, LUA_REGISTRYINDEX, SYSTEM_REGISTRY_FIELD);
+    auto system = static_cast<WorkerSystem*>(lua_touserdata(L, -1));
+    pop(L);
+    return system;
+}
+
+namespace {
+    struct SystemsJob {
+        WorkerSystem* system;
+        int tps;
+    };
+
+    class SystemsWorker : public util::Worker<SystemsJob, int> {
+    public:
+        int operator()(const SystemsJob& job) override {
+            job.system->tick(job.tps);
+            return 0;
+        }
+    };
+}
+
+static std::vector<std::unique_ptr<WorkerSystem>> systems;
+static std::unordered_map<std::string, WorkerSystem*> systems_map;
+static std::unique_ptr<util::ThreadPool<SystemsJob, int>> systems_pool;
+static size_t systems_jobs_done = 0;
+
+void scripting::load_worker_systems() {
+    unload_worker_systems();
+    for (const auto& pack : content_control->getAllContentPacks()) {
+        io::path dir = pack.folder / "scripts/systems";
+        if (!io::is_directory(dir)) {
+            continue;
+        }
+        for (const auto& file : io::directory_iterator(dir)) {
+            if (io::is_directory(file) || file.extension() != ".lua") {
+                continue;
+            }
+            std::string name = pack.id + ":" + file.stem();
+            std::string fileName =
+                pack.id + ":scripts/systems/" + file.name();
+            auto& system = systems.emplace_back(
+                std::make_unique<WorkerSystem>(name, file, fileName)
+            );
+            systems_map[name] = system.get();
+            logger.info() << "loaded system " << name;
+        }
+    }
+}
+
+void scripting::unload_worker_systems() {
+    systems_pool.reset();
+    systems_map.clear();
+    systems.clear();
+}
+
+void scripting::on_worker_systems_tick(int tps) {
+    if (systems.empty()) {
+        return;
+    }
+    VC_PROFILE_ZONE("scripting::on_worker_systems_tick");
+    if (systems_pool == nullptr && systems.size() > 1) {
+        systems_pool = std::make_unique<util::ThreadPool<SystemsJob, int>>(
+            "systems",
+            []() { return std::make_unique<SystemsWorker>(); },
+            [](int&&) { systems_jobs_done++; },
+            engine->getSettings().scripting.systemsWorkers.get()
+        );
+        systems_pool->setStandaloneResults(true);
+    }
+    systems_jobs_done = 0;
+    size_t enqueued = 0;
+    // the first system is ticked by the current thread
+    for (size_t i = 1; i < systems.size(); i++) {
+        systems_pool->enqueueJob(SystemsJob {systems[i].get(), tps});
+        enqueued++;
+    }
+    systems[0]->tick(tps);
+    while (systems_jobs_done < enqueued) {
+        if (systems_pool->pullResults() == 0) {
+            std::this_thread::yield();
+        }
+    }
+    for (const auto& system : systems) {
+        system->dispatchMessages();
+    }
+}
+
+WorkerSystem* scripting::get_worker_system(const std::string& name) {
+    auto found = systems_map.find(name);
+    if (found == systems_map.end()) {
+        return nullptr;
+    }
+    return found->second;
+}
+
+std::vector<std::string> scripting::get_worker_systems_names() {
+    std::vector<std::string> names;
+    names.reserve(systems.size());
+    for (const auto& system : systems) {
+        names.push_back(system->getName());
+    }
+    return names;
+}
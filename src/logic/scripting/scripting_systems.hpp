@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "data/dv.hpp"
+#include "io/fwd.hpp"
+
+struct lua_State;
+
+namespace scripting {
+    /// @brief Pack system script running in its own Lua state on a worker
+    /// thread. Systems have no access to the main state and mutating
+    /// engine API, so they communicate with it via messages only.
+    /// Messages are delivered at the ticks boundaries
+    class WorkerSystem {
+        std::string name;
+        lua_State* L;
+        /// @brief Messages sent by the main state, delivered on next tick
+        std::vector<dv::value> inbox;
+        /// @brief Messages sent by the system, dispatched after tick
+        std::vector<dv::value> outbox;
+        /// @brief Script could not be loaded, so system is not ticked
+        bool failed = false;
+    public:
+        WorkerSystem(
+            std::string name, const io::path& file, const std::string& fileName
+        );
+        ~WorkerSystem();
+
+        /// @brief Deliver inbox messages and call on_tick.
+        /// Called from a worker thread
+        void tick(int tps);
+
+        /// @brief Emit outbox messages as '<system>.message' events in
+        /// the main state
+        void dispatchMessages();
+
+        /// @brief Queue message from the main state
+        void post(dv::value message);
+
+        /// @brief Queue message to the main state. Called by the system
+        void send(dv::value message);
+
+        const std::string& getName() const {
+            return name;
+        }
+
+        /// @return system owning the state or nullptr
+        static WorkerSystem* of(lua_State* L);
+    };
+
+    /// @brief Create systems of all content packs
+    /// (scripts/systems/*.lua files)
+    void load_worker_systems();
+
+    void unload_worker_systems();
+
+    /// @brief Tick all systems in parallel and dispatch their messages.
+    /// Main thread is waiting for systems, so voxels may be read safely
+    void on_worker_systems_tick(int tps);
+
+    /// @return system by id (packid:name) or nullptr
+    WorkerSystem* get_worker_system(const std::string& name);
+
+    std::vector<std::string> get_worker_systems_names();
+}
@@ -38,6 +38,15 @@ public:
         : L(L), def(def), file(file), dirPath(dirPath) {
     }
 
+    std::unique_ptr<GeneratorScript> clone() const override {
+        auto state = create_state(
+            Engine::getInstance().getPaths(), StateType::GENERATOR
+        );
+        return std::make_unique<LuaGeneratorScript>(
+            state, def, file, dirPath
+        );
+    }
+
     virtual ~LuaGeneratorScript() {
         env.reset();
         if (L != get_main_state()) {
@@ -29,7 +29,10 @@ int main(int argc, char** argv) {
     }
     std::signal(SIGTERM, sigterm_handler);
     
-    debug::Logger::init(coreParameters.userFolder.string() + "/latest.log");
+    debug::Logger::init(
+        coreParameters.userFolder.string() + "/latest.log",
+        coreParameters.asyncLogging
+    );
     platform::configure_encoding();
 
     auto& engine = Engine::getInstance();
@@ -48,5 +51,6 @@ int main(int argc, char** argv) {
     }
 #endif
     Engine::terminate();
+    debug::Logger::terminate();
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,127 @@
+#include "FrustumCulling.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define VC_FRUSTUM_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define VC_FRUSTUM_NEON
+#endif
+
+/// 4 boxes lanes operations
+namespace {
+#if defined(VC_FRUSTUM_SSE2)
+    using lanes4 = __m128;
+
+    inline lanes4 lanes_set(float x) {
+        return _mm_set1_ps(x);
+    }
+    inline lanes4 lanes_load(const float* src) {
+        return _mm_loadu_ps(src);
+    }
+    inline lanes4 lanes_add(lanes4 a, lanes4 b) {
+        return _mm_add_ps(a, b);
+    }
+    inline lanes4 lanes_mul(lanes4 a, lanes4 b) {
+        return _mm_mul_ps(a, b);
+    }
+    inline lanes4 lanes_lt(lanes4 a, lanes4 b) {
+        return _mm_cmplt_ps(a, b);
+    }
+    inline lanes4 lanes_or(lanes4 a, lanes4 b) {
+        return _mm_or_ps(a, b);
+    }
+    inline lanes4 lanes_none() {
+        return _mm_setzero_ps();
+    }
+    /// @return bit i is set if lane i is not set
+    inline uint64_t lanes_unset_bits(lanes4 a) {
+        return ~_mm_movemask_ps(a) & 0xF;
+    }
+#elif defined(VC_FRUSTUM_NEON)
+    using lanes4 = float32x4_t;
+
+    inline lanes4 lanes_set(float x) {
+        return vdupq_n_f32(x);
+    }
+    inline lanes4 lanes_load(const float* src) {
+        return vld1q_f32(src);
+    }
+    inline lanes4 lanes_add(lanes4 a, lanes4 b) {
+        return vaddq_f32(a, b);
+    }
+    inline lanes4 lanes_mul(lanes4 a, lanes4 b) {
+        return vmulq_f32(a, b);
+    }
+    inline lanes4 lanes_lt(lanes4 a, lanes4 b) {
+        return vreinterpretq_f32_u32(vcltq_f32(a, b));
+    }
+    inline lanes4 lanes_or(lanes4 a, lanes4 b) {
+        return vreinterpretq_f32_u32(
+            vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))
+        );
+    }
+    inline lanes4 lanes_none() {
+        return vdupq_n_f32(0.0f);
+    }
+    inline uint64_t lanes_unset_bits(lanes4 a) {
+        uint32x4_t mask = vreinterpretq_u32_f32(a);
+        return (vgetq_lane_u32(mask, 0) ? 0 : 1) |
+               (vgetq_lane_u32(mask, 1) ? 0 : 2) |
+               (vgetq_lane_u32(mask, 2) ? 0 : 4) |
+               (vgetq_lane_u32(mask, 3) ? 0 : 8);
+    }
+#endif
+}
+
+void Frustum::areBoxesVisible(
+    const BoxesArray& boxes, std::vector<uint64_t>& visible
+) const {
+    size_t count = boxes.size();
+    visible.assign((count + 63) / 64, 0);
+    size_t i = 0;
+#if defined(VC_FRUSTUM_SSE2) || defined(VC_FRUSTUM_NEON)
+    for (; i + 4 <= count; i += 4) {
+        lanes4 minX = lanes_load(boxes.minX.data() + i);
+        lanes4 minY = lanes_load(boxes.minY.data() + i);
+        lanes4 minZ = lanes_load(boxes.minZ.data() + i);
+        lanes4 maxX = lanes_load(boxes.maxX.data() + i);
+        lanes4 maxY = lanes_load(boxes.maxY.data() + i);
+        lanes4 maxZ = lanes_load(boxes.maxZ.data() + i);
+
+        lanes4 outside = lanes_none();
+        for (int p = 0; p < Count; p++) {
+            const auto& plane = m_planes[p];
+            // box corner farthest along the plane normal, summed in the
+            // same order as in isBoxVisible
+            lanes4 dot = lanes_mul(
+                lanes_set(plane.x), plane.x >= 0.0f ? maxX : minX
+            );
+            dot = lanes_add(dot, lanes_mul(
+                lanes_set(plane.y), plane.y >= 0.0f ? maxY : minY
+            ));
+            dot = lanes_add(dot, lanes_mul(
+                lanes_set(plane.z), plane.z >= 0.0f ? maxZ : minZ
+            ));
+            dot = lanes_add(dot, lanes_set(plane.w));
+            outside = lanes_or(outside, lanes_lt(dot, lanes_none()));
+        }
+        outside = lanes_or(outside, lanes_lt(maxX, lanes_set(m_pointsMin.x)));
+        outside = lanes_or(outside, lanes_lt(lanes_set(m_pointsMax.x), minX));
+        outside = lanes_or(outside, lanes_lt(maxY, lanes_set(m_pointsMin.y)));
+        outside = lanes_or(outside, lanes_lt(lanes_set(m_pointsMax.y), minY));
+        outside = lanes_or(outside, lanes_lt(maxZ, lanes_set(m_pointsMin.z)));
+        outside = lanes_or(outside, lanes_lt(lanes_set(m_pointsMax.z), minZ));
+
+        // i is a multiple of 4, so lanes never cross a word
+        visible[i / 64] |= lanes_unset_bits(outside) << (i % 64);
+    }
+#endif
+    for (; i < count; i++) {
+        glm::vec3 min(boxes.minX[i], boxes.minY[i], boxes.minZ[i]);
+        glm::vec3 max(boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i]);
+        if (isBoxVisible(min, max)) {
+            visible[i / 64] |= uint64_t(1) << (i % 64);
+        }
+    }
+}
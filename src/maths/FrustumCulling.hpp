@@ -2,12 +2,48 @@
 
 #include <glm/matrix.hpp>
 
+#include <cstdint>
+#include <vector>
+
+/// @brief Axis-aligned boxes in structure of arrays layout, used for batch
+/// frustum culling
+struct BoxesArray {
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    size_t size() const {
+        return minX.size();
+    }
+
+    void clear() {
+        minX.clear(); minY.clear(); minZ.clear();
+        maxX.clear(); maxY.clear(); maxZ.clear();
+    }
+
+    void push_back(const glm::vec3& min, const glm::vec3& max) {
+        minX.push_back(min.x); minY.push_back(min.y); minZ.push_back(min.z);
+        maxX.push_back(max.x); maxY.push_back(max.y); maxZ.push_back(max.z);
+    }
+};
+
 class Frustum {
 public:
     Frustum() = default;
 
     void update(glm::mat4 projview);
     bool isBoxVisible(const glm::vec3& minp, const glm::vec3& maxp) const;
+
+    /// @brief Test many boxes at once (SIMD if available). Gives the same
+    /// results as isBoxVisible
+    /// @param visible bit i % 64 of word i / 64 is set if box i is visible
+    /// (resized to fit all boxes)
+    void areBoxesVisible(
+        const BoxesArray& boxes, std::vector<uint64_t>& visible
+    ) const;
+
+    static bool isVisible(const std::vector<uint64_t>& visible, size_t index) {
+        return (visible[index / 64] >> (index % 64)) & 1;
+    }
 private:
     enum Planes {
         Left = 0,
@@ -29,7 +65,9 @@ private:
     glm::vec3 intersection(const glm::vec3* crosses) const;
 
     glm::vec4 m_planes[Count];
-    glm::vec3 m_points[8];
+    /// @brief Bounding box of the frustum corners
+    glm::vec3 m_pointsMin;
+    glm::vec3 m_pointsMax;
 };
 
 inline void Frustum::update(glm::mat4 m) {
@@ -58,62 +96,42 @@ inline void Frustum::update(glm::mat4 m) {
         glm::cross(glm::vec3(m_planes[Top]), glm::vec3(m_planes[Far])),
         glm::cross(glm::vec3(m_planes[Near]), glm::vec3(m_planes[Far]))};
 
-    m_points[0] = intersection<Left, Bottom, Near>(crosses);
-    m_points[1] = intersection<Left, Top, Near>(crosses);
-    m_points[2] = intersection<Right, Bottom, Near>(crosses);
-    m_points[3] = intersection<Right, Top, Near>(crosses);
-    m_points[4] = intersection<Left, Bottom, Far>(crosses);
-    m_points[5] = intersection<Left, Top, Far>(crosses);
-    m_points[6] = intersection<Right, Bottom, Far>(crosses);
-    m_points[7] = intersection<Right, Top, Far>(crosses);
+    glm::vec3 points[8] {
+        intersection<Left, Bottom, Near>(crosses),
+        intersection<Left, Top, Near>(crosses),
+        intersection<Right, Bottom, Near>(crosses),
+        intersection<Right, Top, Near>(crosses),
+        intersection<Left, Bottom, Far>(crosses),
+        intersection<Left, Top, Far>(crosses),
+        intersection<Right, Bottom, Far>(crosses),
+        intersection<Right, Top, Far>(crosses)};
+    m_pointsMin = m_pointsMax = points[0];
+    for (int i = 1; i < 8; i++) {
+        m_pointsMin = glm::min(m_pointsMin, points[i]);
+        m_pointsMax = glm::max(m_pointsMax, points[i]);
+    }
 }
 
 inline bool Frustum::isBoxVisible(const glm::vec3& minp, const glm::vec3& maxp)
     const {
-    // check box outside/inside of frustum
+    // box is outside if its corner farthest along the plane normal is
     for (int i = 0; i < Count; i++) {
-        if ((glm::dot(m_planes[i], glm::vec4(minp.x, minp.y, minp.z, 1.0f)) <
-             0.0) &&
-            (glm::dot(m_planes[i], glm::vec4(maxp.x, minp.y, minp.z, 1.0f)) <
-             0.0) &&
-            (glm::dot(m_planes[i], glm::vec4(minp.x, maxp.y, minp.z, 1.0f)) <
-             0.0) &&
-            (glm::dot(m_planes[i], glm::vec4(maxp.x, maxp.y, minp.z, 1.0f)) <
-             0.0) &&
-            (glm::dot(m_planes[i], glm::vec4(minp.x, minp.y, maxp.z, 1.0f)) <
-             0.0) &&
-            (glm::dot(m_planes[i], glm::vec4(maxp.x, minp.y, maxp.z, 1.0f)) <
-             0.0) &&
-            (glm::dot(m_planes[i], glm::vec4(minp.x, maxp.y, maxp.z, 1.0f)) <
-             0.0) &&
-            (glm::dot(m_planes[i], glm::vec4(maxp.x, maxp.y, maxp.z, 1.0f)) <
-             0.0)) {
+        const auto& plane = m_planes[i];
+        glm::vec3 corner(
+            plane.x >= 0.0f ? maxp.x : minp.x,
+            plane.y >= 0.0f ? maxp.y : minp.y,
+            plane.z >= 0.0f ? maxp.z : minp.z
+        );
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
             return false;
         }
     }
-
-    // check frustum outside/inside box
-    int out;
-    out = 0;
-    for (int i = 0; i < 8; i++) out += ((m_points[i].x > maxp.x) ? 1 : 0);
-    if (out == 8) return false;
-    out = 0;
-    for (int i = 0; i < 8; i++) out += ((m_points[i].x < minp.x) ? 1 : 0);
-    if (out == 8) return false;
-    out = 0;
-    for (int i = 0; i < 8; i++) out += ((m_points[i].y > maxp.y) ? 1 : 0);
-    if (out == 8) return false;
-    out = 0;
-    for (int i = 0; i < 8; i++) out += ((m_points[i].y < minp.y) ? 1 : 0);
-    if (out == 8) return false;
-    out = 0;
-    for (int i = 0; i < 8; i++) out += ((m_points[i].z > maxp.z) ? 1 : 0);
-    if (out == 8) return false;
-    out = 0;
-    for (int i = 0; i < 8; i++) out += ((m_points[i].z < minp.z) ? 1 : 0);
-    if (out == 8) return false;
-
-    return true;
+    // all frustum corners are on one side of the box
+    return !(
+        m_pointsMin.x > maxp.x || m_pointsMax.x < minp.x ||
+        m_pointsMin.y > maxp.y || m_pointsMax.y < minp.y ||
+        m_pointsMin.z > maxp.z || m_pointsMax.z < minp.z
+    );
 }
 
 template <Frustum::Planes a, Frustum::Planes b, Frustum::Planes c>
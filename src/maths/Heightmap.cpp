@@ -5,105 +5,202 @@
 #include <stdexcept>
 #include <glm/glm.hpp>
 
-static inline float sample_at(
-    const float* buffer,
-    uint width,
-    uint x, uint y
+static inline float interpolate_cubic(
+    float p0, float p1, float p2, float p3, float x
 ) {
-    return buffer[y*width+x];
+    return p1 + 0.5 * x*(p2 - p0 + x*(2.0*p0 - 5.0*p1 + 4.0*p2 -
+           p3 + x*(3.0*(p1 - p2) + p3 - p0)));
 }
 
-static inline float sample_at(
-    const float* buffer,
-    uint width, uint height,
-    uint x, uint y
-) {
-    return buffer[(y >= height ? height-1 : y)*width+(x >= width ? width-1 : x)];
-}
-
-static inline float interpolate_cubic(float p[4], float x) {
-    return p[1] + 0.5 * x*(p[2] - p[0] + x*(2.0*p[0] - 5.0*p[1] + 4.0*p[2] - 
-           p[3] + x*(3.0*(p[1] - p[2]) + p[3] - p[0])));
+namespace {
+    /// @brief Precomputed source position of an output column or row
+    struct SamplePos {
+        /// @brief Source indices of the kernel (clamped)
+        uint indices[4];
+        /// @brief Position between indices[1] and indices[2]
+        float t;
+    };
+
+    struct ResampleBuffers {
+        std::vector<SamplePos> columns;
+        std::vector<SamplePos> rows;
+        /// @brief Source rows resampled horizontally
+        std::vector<float> rowsData;
+    };
 }
 
-static inline float interpolate_bicubic(float p[4][4], float x, float y) {
-    float q[4];
-    for (int i = 0; i < 4; i++) {
-        q[i] = interpolate_cubic(p[i], y);
+/// @brief Scratch buffers reused by resample calls of the thread
+static thread_local ResampleBuffers resample_buffers;
+
+/// @param offset first output index in the scaled space
+/// @param count number of output indices
+/// @param scaled scaled size
+/// @param size source size
+static void compute_positions(
+    std::vector<SamplePos>& positions,
+    uint offset,
+    uint count,
+    uint scaled,
+    uint size
+) {
+    positions.resize(count);
+    for (uint i = 0; i < count; i++) {
+        float s = static_cast<float>(offset + i) / scaled * size;
+        // std::floor is redundant here because s is positive
+        uint index = static_cast<uint>(s);
+        auto& pos = positions[i];
+        pos.t = s - index;
+        // kernel sides are clamped
+        for (uint j = 0; j < 4; j++) {
+            uint k = index + j - 1;
+            pos.indices[j] = k >= size ? size - 1 : k;
+        }
     }
-    return interpolate_cubic(q, x);
 }
 
-static inline float sample_at(
-    const float* buffer,
-    uint width, uint height,
-    float x, float y,
+/// @brief Resample source row for every output column
+static void resample_row(
+    const float* src,
+    float* dst,
+    const std::vector<SamplePos>& columns,
     InterpolationType interp
 ) {
-    // std::floor is redundant here because x and y are positive values
-    uint ix = static_cast<uint>(x);
-    uint iy = static_cast<uint>(y);
-    float val = buffer[iy*width+ix];
-    if (interp == InterpolationType::NEAREST) {
-        return val;
+    size_t count = columns.size();
+    switch (interp) {
+        case InterpolationType::NEAREST:
+            for (size_t x = 0; x < count; x++) {
+                dst[x] = src[columns[x].indices[1]];
+            }
+            break;
+        case InterpolationType::LINEAR:
+            for (size_t x = 0; x < count; x++) {
+                const auto& pos = columns[x];
+                float a = src[pos.indices[1]];
+                float b = src[pos.indices[2]];
+                dst[x] = a + (b - a) * pos.t;
+            }
+            break;
+        case InterpolationType::CUBIC:
+            for (size_t x = 0; x < count; x++) {
+                const auto& pos = columns[x];
+                dst[x] = interpolate_cubic(
+                    src[pos.indices[0]],
+                    src[pos.indices[1]],
+                    src[pos.indices[2]],
+                    src[pos.indices[3]],
+                    pos.t
+                );
+            }
+            break;
+        default:
+            throw std::runtime_error("interpolation type is not implemented");
     }
-    float tx = x - ix;
-    float ty = y - iy;
+}
 
+/// @brief Interpolate between horizontally resampled rows. Loops are
+/// contiguous to be vectorized
+static void resample_column(
+    const float* rowsData,
+    float* dst,
+    size_t count,
+    const SamplePos& pos,
+    InterpolationType interp
+) {
+    const float* r0 = rowsData + pos.indices[0] * count;
+    const float* r1 = rowsData + pos.indices[1] * count;
+    const float* r2 = rowsData + pos.indices[2] * count;
+    const float* r3 = rowsData + pos.indices[3] * count;
+    float t = pos.t;
     switch (interp) {
-        case InterpolationType::LINEAR: {
-            float s00 = val;
-            float s10 = sample_at(buffer, width, 
-                ix + 1 < width ? ix + 1 : ix, iy);
-            float s01 = sample_at(buffer, width, ix, 
-                iy + 1 < height ? iy + 1 : iy);
-            float s11 = sample_at(buffer, width, 
-                ix + 1 < width ? ix + 1 : ix, iy + 1 < height ? iy + 1 : iy);
-
-            float a00 = s00;
-            float a10 = s10 - s00;
-            float a01 = s01 - s00;
-            float a11 = s11 - s10 - s01 + s00;
-
-            return a00 + a10*tx + a01*ty + a11*tx*ty;
-        }
-        case InterpolationType::CUBIC: {
-            float p[4][4];
-            for (int i = 0; i < 4; i++) {
-                for (int j = 0; j < 4; j++) {
-                    p[i][j] = sample_at(
-                        buffer, width, height, ix + j - 1, iy + i - 1
-                    );
-                }
+        case InterpolationType::NEAREST:
+            std::memcpy(dst, r1, count * sizeof(float));
+            break;
+        case InterpolationType::LINEAR:
+            for (size_t x = 0; x < count; x++) {
+                dst[x] = r1[x] + (r2[x] - r1[x]) * t;
             }
-            return interpolate_bicubic(p, ty, tx);
-        }
+            break;
+        case InterpolationType::CUBIC:
+            for (size_t x = 0; x < count; x++) {
+                dst[x] = interpolate_cubic(r0[x], r1[x], r2[x], r3[x], t);
+            }
+            break;
         default:
             throw std::runtime_error("interpolation type is not implemented");
     }
-    return val;
+}
+
+void Heightmap::resample(
+    float* dst,
+    uint scaledWidth,
+    uint scaledHeight,
+    InterpolationType interp,
+    uint dstX,
+    uint dstY,
+    uint dstWidth,
+    uint dstHeight
+) const {
+    if (dstX + dstWidth > scaledWidth || dstY + dstHeight > scaledHeight) {
+        throw std::runtime_error(
+            "crop zone is not fully inside of the resized map");
+    }
+    auto& buffers = resample_buffers;
+    compute_positions(buffers.columns, dstX, dstWidth, scaledWidth, width);
+    compute_positions(buffers.rows, dstY, dstHeight, scaledHeight, height);
+
+    // separable passes: source rows are resampled horizontally once
+    buffers.rowsData.resize(static_cast<size_t>(height) * dstWidth);
+    for (uint y = 0; y < height; y++) {
+        resample_row(
+            buffer.data() + y * width,
+            buffers.rowsData.data() + y * dstWidth,
+            buffers.columns,
+            interp
+        );
+    }
+    for (uint y = 0; y < dstHeight; y++) {
+        resample_column(
+            buffers.rowsData.data(),
+            dst + y * dstWidth,
+            dstWidth,
+            buffers.rows[y],
+            interp
+        );
+    }
 }
 
 void Heightmap::resize(
     uint dstwidth, uint dstheight, InterpolationType interp
 ) {
-    if (width == dstwidth && height == dstheight) {
-        return;
-    }
-    std::vector<float> dst;
-    dst.resize(dstwidth*dstheight);
+    resize(dstwidth, dstheight, interp, 0, 0, dstwidth, dstheight);
+}
 
-    uint index = 0;
-    for (uint y = 0; y < dstheight; y++) {
-        for (uint x = 0; x < dstwidth; x++, index++) {
-            float sx = static_cast<float>(x) / dstwidth * width;
-            float sy = static_cast<float>(y) / dstheight * height;
-            dst[index] = sample_at(buffer.data(), width, height, sx, sy, interp);
-        }
+void Heightmap::resize(
+    uint scaledWidth,
+    uint scaledHeight,
+    InterpolationType interp,
+    uint cropX,
+    uint cropY,
+    uint cropWidth,
+    uint cropHeight
+) {
+    if (width == scaledWidth && height == scaledHeight) {
+        crop(cropX, cropY, cropWidth, cropHeight);
+        return;
     }
-
-    width = dstwidth;
-    height = dstheight;
+    std::vector<float> dst(static_cast<size_t>(cropWidth) * cropHeight);
+    resample(
+        dst.data(),
+        scaledWidth,
+        scaledHeight,
+        interp,
+        cropX,
+        cropY,
+        cropWidth,
+        cropHeight
+    );
+    width = cropWidth;
+    height = cropHeight;
     buffer = std::move(dst);
 }
 
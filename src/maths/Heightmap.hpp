@@ -36,6 +36,32 @@ public:
 
     void resize(uint width, uint height, InterpolationType interpolation);
 
+    /// @brief Resize and crop the map at once. Only the crop zone values
+    /// are computed
+    void resize(
+        uint scaledWidth,
+        uint scaledHeight,
+        InterpolationType interpolation,
+        uint cropX,
+        uint cropY,
+        uint cropWidth,
+        uint cropHeight
+    );
+
+    /// @brief Write values of the map resized to scaledWidth * scaledHeight
+    /// and cropped to the dst zone without modifying the map
+    /// @param dst output buffer of dstWidth * dstHeight values
+    void resample(
+        float* dst,
+        uint scaledWidth,
+        uint scaledHeight,
+        InterpolationType interpolation,
+        uint dstX,
+        uint dstY,
+        uint dstWidth,
+        uint dstHeight
+    ) const;
+
     void crop(uint srcX, uint srcY, uint dstWidth, uint dstHeight);
 
     void clamp();
@@ -0,0 +1,211 @@
+#include "HeightmapGraph.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#include "Heightmap.hpp"
+#include "util/functional_util.hpp"
+
+HeightmapGraph::HeightmapGraph(uint width, uint height)
+    : width(width), height(height) {
+    if (width == 0 || height == 0) {
+        throw std::invalid_argument("width and height must be greater than 0");
+    }
+}
+
+void HeightmapGraph::checkRegister(Register reg) const {
+    if (reg >= registers.size()) {
+        throw std::out_of_range(
+            "invalid heightmap graph register " + std::to_string(reg)
+        );
+    }
+}
+
+void HeightmapGraph::checkOperand(const Operand& operand) const {
+    if (operand.reg != Operand::NONE) {
+        checkRegister(operand.reg);
+    }
+}
+
+HeightmapGraph::Register HeightmapGraph::create() {
+    registers.push_back(nullptr);
+    return registers.size() - 1;
+}
+
+HeightmapGraph::Register HeightmapGraph::input(
+    std::shared_ptr<const Heightmap> map
+) {
+    if (map->getWidth() != width || map->getHeight() != height) {
+        throw std::invalid_argument(
+            "heightmap size does not match the graph size"
+        );
+    }
+    registers.push_back(std::move(map));
+    return registers.size() - 1;
+}
+
+void HeightmapGraph::binary(
+    HeightmapBinaryOp op, Register dst, Operand value
+) {
+    checkRegister(dst);
+    checkOperand(value);
+    Operation operation {OpType::BINARY, dst};
+    operation.binaryOp = op;
+    operation.a = value;
+    operations.push_back(operation);
+}
+
+void HeightmapGraph::abs(Register dst) {
+    checkRegister(dst);
+    operations.push_back(Operation {OpType::ABS, dst});
+}
+
+void HeightmapGraph::mixin(Register dst, Operand value, Operand t) {
+    checkRegister(dst);
+    checkOperand(value);
+    checkOperand(t);
+    Operation operation {OpType::MIXIN, dst};
+    operation.a = value;
+    operation.b = t;
+    operations.push_back(operation);
+}
+
+void HeightmapGraph::noise(Register dst, const NoiseParams& params) {
+    checkRegister(dst);
+    if (params.shiftX != Operand::NONE) {
+        checkRegister(params.shiftX);
+    }
+    if (params.shiftY != Operand::NONE) {
+        checkRegister(params.shiftY);
+    }
+    Operation operation {OpType::NOISE, dst};
+    operation.noise = params;
+    operations.push_back(operation);
+}
+
+template <template <class> class Op>
+static void apply_binary(
+    float* dst, const float* src, float scalar, uint count
+) {
+    Op<float> op;
+    if (src) {
+        for (uint i = 0; i < count; i++) {
+            dst[i] = op(dst[i], src[i]);
+        }
+    } else {
+        for (uint i = 0; i < count; i++) {
+            dst[i] = op(dst[i], scalar);
+        }
+    }
+}
+
+void HeightmapGraph::execute(
+    const Operation& operation, float* values, uint start, uint count
+) const {
+    auto tile = [values](Register reg) -> float* {
+        return reg == Operand::NONE ? nullptr : values + reg * TILE_SIZE;
+    };
+    float* dst = tile(operation.dst);
+    switch (operation.type) {
+        case OpType::BINARY: {
+            const float* src = tile(operation.a.reg);
+            float scalar = operation.a.value;
+            switch (operation.binaryOp) {
+                case HeightmapBinaryOp::ADD:
+                    apply_binary<std::plus>(dst, src, scalar, count);
+                    break;
+                case HeightmapBinaryOp::SUB:
+                    apply_binary<std::minus>(dst, src, scalar, count);
+                    break;
+                case HeightmapBinaryOp::MUL:
+                    apply_binary<std::multiplies>(dst, src, scalar, count);
+                    break;
+                case HeightmapBinaryOp::POW:
+                    apply_binary<util::pow>(dst, src, scalar, count);
+                    break;
+                case HeightmapBinaryOp::MIN:
+                    apply_binary<util::min>(dst, src, scalar, count);
+                    break;
+                case HeightmapBinaryOp::MAX:
+                    apply_binary<util::max>(dst, src, scalar, count);
+                    break;
+            }
+            break;
+        }
+        case OpType::ABS: {
+            util::abs<float> op;
+            for (uint i = 0; i < count; i++) {
+                dst[i] = op(dst[i]);
+            }
+            break;
+        }
+        case OpType::MIXIN: {
+            const float* src = tile(operation.a.reg);
+            const float* tsrc = tile(operation.b.reg);
+            for (uint i = 0; i < count; i++) {
+                float value = src ? src[i] : operation.a.value;
+                float t = tsrc ? tsrc[i] : operation.b.value;
+                dst[i] = dst[i] * (1.0f - t) + value * t;
+            }
+            break;
+        }
+        case OpType::NOISE: {
+            const auto& params = operation.noise;
+            noise::add_octaves2d(
+                params.type,
+                params.seed,
+                params.offset,
+                params.scale,
+                params.octaves,
+                params.multiplier,
+                width,
+                start,
+                count,
+                dst,
+                tile(params.shiftX),
+                tile(params.shiftY)
+            );
+            break;
+        }
+    }
+}
+
+std::vector<std::shared_ptr<Heightmap>> HeightmapGraph::evaluate(
+    const std::vector<Register>& outputs
+) const {
+    std::vector<std::shared_ptr<Heightmap>> maps;
+    for (auto reg : outputs) {
+        checkRegister(reg);
+        maps.push_back(std::make_shared<Heightmap>(width, height));
+    }
+    // all registers tiles stay in cache while the operations are executed
+    auto values = std::make_unique<float[]>(registers.size() * TILE_SIZE);
+    uint total = width * height;
+    for (uint start = 0; start < total; start += TILE_SIZE) {
+        uint count = std::min(TILE_SIZE, total - start);
+        for (size_t reg = 0; reg < registers.size(); reg++) {
+            float* tile = values.get() + reg * TILE_SIZE;
+            if (const auto& map = registers[reg]) {
+                std::memcpy(
+                    tile, map->getValues() + start, count * sizeof(float)
+                );
+            } else {
+                std::fill(tile, tile + count, 0.0f);
+            }
+        }
+        for (const auto& operation : operations) {
+            execute(operation, values.get(), start, count);
+        }
+        for (size_t i = 0; i < outputs.size(); i++) {
+            std::memcpy(
+                maps[i]->getValues() + start,
+                values.get() + outputs[i] * TILE_SIZE,
+                count * sizeof(float)
+            );
+        }
+    }
+    return maps;
+}
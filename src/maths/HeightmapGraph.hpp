@@ -0,0 +1,128 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "noise.hpp"
+#include "typedefs.hpp"
+
+class Heightmap;
+
+enum class HeightmapBinaryOp {
+    ADD, SUB, MUL, POW, MIN, MAX
+};
+
+/// @brief Recorded sequence of per-point heightmap operations evaluated
+/// natively tile by tile without intermediate full-size maps.
+/// Every operation modifies a register (virtual map) in place, so results
+/// are equal to the same Heightmap operations sequence
+class HeightmapGraph {
+public:
+    using Register = uint;
+
+    /// @brief Operation argument: a register or a scalar value
+    struct Operand {
+        static constexpr Register NONE = static_cast<Register>(-1);
+
+        Register reg = NONE;
+        float value = 0.0f;
+
+        static Operand of(Register reg) {
+            return Operand {reg, 0.0f};
+        }
+
+        static Operand of(float value) {
+            return Operand {NONE, value};
+        }
+    };
+
+    struct NoiseParams {
+        NoiseType type = NoiseType::SIMPLEX;
+        int seed = 0;
+        glm::vec2 offset {};
+        float scale = 1.0f;
+        int octaves = 1;
+        float multiplier = 1.0f;
+        /// @brief Coordinates shift registers (Operand::NONE if not used)
+        Register shiftX = Operand::NONE;
+        Register shiftY = Operand::NONE;
+    };
+private:
+    enum class OpType {
+        BINARY, ABS, MIXIN, NOISE
+    };
+
+    struct Operation {
+        OpType type;
+        Register dst;
+        HeightmapBinaryOp binaryOp = HeightmapBinaryOp::ADD;
+        Operand a {};
+        Operand b {};
+        NoiseParams noise {};
+    };
+
+    uint width;
+    uint height;
+    /// @brief Initial register values (nullptr - zeros)
+    std::vector<std::shared_ptr<const Heightmap>> registers;
+    std::vector<Operation> operations;
+
+    void checkRegister(Register reg) const;
+    void checkOperand(const Operand& operand) const;
+
+    void execute(
+        const Operation& operation,
+        float* values,
+        uint start,
+        uint count
+    ) const;
+public:
+    /// @brief Number of points evaluated at once
+    static constexpr uint TILE_SIZE = 256;
+
+    HeightmapGraph(uint width, uint height);
+
+    /// @brief Create a register filled with zeros
+    Register create();
+
+    /// @brief Create a register initialized with the heightmap values.
+    /// The heightmap must not be modified until evaluation
+    /// @throws std::invalid_argument - heightmap size does not match
+    Register input(std::shared_ptr<const Heightmap> map);
+
+    /// @brief dst = op(dst, value)
+    void binary(HeightmapBinaryOp op, Register dst, Operand value);
+
+    /// @brief dst = abs(dst)
+    void abs(Register dst);
+
+    /// @brief dst = dst * (1 - t) + value * t
+    void mixin(Register dst, Operand value, Operand t);
+
+    /// @brief Add noise octaves to dst (see heightmap:noise)
+    void noise(Register dst, const NoiseParams& params);
+
+    /// @brief Evaluate recorded operations
+    /// @param outputs registers to return
+    /// @return heightmaps with final values of the output registers
+    std::vector<std::shared_ptr<Heightmap>> evaluate(
+        const std::vector<Register>& outputs
+    ) const;
+
+    uint getWidth() const {
+        return width;
+    }
+
+    uint getHeight() const {
+        return height;
+    }
+
+    size_t getRegistersCount() const {
+        return registers.size();
+    }
+
+    size_t getOperationsCount() const {
+        return operations.size();
+    }
+};
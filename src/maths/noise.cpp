@@ -0,0 +1,411 @@
+#include "noise.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+#define VC_NOISE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define VC_NOISE_NEON
+#endif
+
+#define FNL_IMPL
+#include "FastNoiseLite.h"
+
+// Lane primitives used by the kernels. Every kernel step mirrors the
+// scalar FastNoiseLite code operation by operation, so lanes produce the
+// same values as fnlGetNoise2D
+namespace {
+#if defined(VC_NOISE_SSE2)
+    using vfloat = __m128;
+    using vint = __m128i;
+    constexpr uint LANES = 4;
+
+    inline vfloat load(const float* src) { return _mm_loadu_ps(src); }
+    inline void store(float* dst, vfloat v) { _mm_storeu_ps(dst, v); }
+    inline vfloat set(float f) { return _mm_set1_ps(f); }
+    inline vint seti(int i) { return _mm_set1_epi32(i); }
+
+    inline vfloat add(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+    inline vfloat sub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+    inline vfloat mul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+    inline vfloat min(vfloat a, vfloat b) { return _mm_min_ps(a, b); }
+    inline vfloat max(vfloat a, vfloat b) { return _mm_max_ps(a, b); }
+
+    inline vint iadd(vint a, vint b) { return _mm_add_epi32(a, b); }
+    inline vint ixor(vint a, vint b) { return _mm_xor_si128(a, b); }
+    inline vint iand(vint a, vint b) { return _mm_and_si128(a, b); }
+    inline vint sra15(vint a) { return _mm_srai_epi32(a, 15); }
+    inline vint imul(vint a, vint b) {
+#ifdef __SSE4_1__
+        return _mm_mullo_epi32(a, b);
+#else
+        __m128i even = _mm_mul_epu32(a, b);
+        __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+        return _mm_unpacklo_epi32(
+            _mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))
+        );
+#endif
+    }
+
+    inline vint cmple(vfloat a, vfloat b) {
+        return _mm_castps_si128(_mm_cmple_ps(a, b));
+    }
+    inline vint cmpge(vfloat a, vfloat b) {
+        return _mm_castps_si128(_mm_cmpge_ps(a, b));
+    }
+    inline vint cmpgt(vfloat a, vfloat b) {
+        return _mm_castps_si128(_mm_cmpgt_ps(a, b));
+    }
+    inline vfloat select(vint mask, vfloat a, vfloat b) {
+        __m128 m = _mm_castsi128_ps(mask);
+        return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+    }
+    inline vint select(vint mask, vint a, vint b) {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    inline vint to_int(vfloat v) { return _mm_cvttps_epi32(v); }
+    inline vfloat to_float(vint v) { return _mm_cvtepi32_ps(v); }
+
+    inline vfloat gather(const float* table, vint indices) {
+        alignas(16) int32_t idx[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(idx), indices);
+        return _mm_setr_ps(
+            table[idx[0]], table[idx[1]], table[idx[2]], table[idx[3]]
+        );
+    }
+#elif defined(VC_NOISE_NEON)
+    using vfloat = float32x4_t;
+    using vint = int32x4_t;
+    constexpr uint LANES = 4;
+
+    inline vfloat load(const float* src) { return vld1q_f32(src); }
+    inline void store(float* dst, vfloat v) { vst1q_f32(dst, v); }
+    inline vfloat set(float f) { return vdupq_n_f32(f); }
+    inline vint seti(int i) { return vdupq_n_s32(i); }
+
+    inline vfloat add(vfloat a, vfloat b) { return vaddq_f32(a, b); }
+    inline vfloat sub(vfloat a, vfloat b) { return vsubq_f32(a, b); }
+    inline vfloat mul(vfloat a, vfloat b) { return vmulq_f32(a, b); }
+    inline vfloat min(vfloat a, vfloat b) { return vminq_f32(a, b); }
+    inline vfloat max(vfloat a, vfloat b) { return vmaxq_f32(a, b); }
+
+    inline vint iadd(vint a, vint b) { return vaddq_s32(a, b); }
+    inline vint ixor(vint a, vint b) { return veorq_s32(a, b); }
+    inline vint iand(vint a, vint b) { return vandq_s32(a, b); }
+    inline vint sra15(vint a) { return vshrq_n_s32(a, 15); }
+    inline vint imul(vint a, vint b) { return vmulq_s32(a, b); }
+
+    inline vint cmple(vfloat a, vfloat b) {
+        return vreinterpretq_s32_u32(vcleq_f32(a, b));
+    }
+    inline vint cmpge(vfloat a, vfloat b) {
+        return vreinterpretq_s32_u32(vcgeq_f32(a, b));
+    }
+    inline vint cmpgt(vfloat a, vfloat b) {
+        return vreinterpretq_s32_u32(vcgtq_f32(a, b));
+    }
+    inline vfloat select(vint mask, vfloat a, vfloat b) {
+        return vbslq_f32(vreinterpretq_u32_s32(mask), a, b);
+    }
+    inline vint select(vint mask, vint a, vint b) {
+        return vbslq_s32(vreinterpretq_u32_s32(mask), a, b);
+    }
+
+    inline vint to_int(vfloat v) { return vcvtq_s32_f32(v); }
+    inline vfloat to_float(vint v) { return vcvtq_f32_s32(v); }
+
+    inline vfloat gather(const float* table, vint indices) {
+        int32_t idx[4];
+        vst1q_s32(idx, indices);
+        float values[4] {
+            table[idx[0]], table[idx[1]], table[idx[2]], table[idx[3]]};
+        return vld1q_f32(values);
+    }
+#else
+    using vfloat = float;
+    using vint = int32_t;
+    constexpr uint LANES = 1;
+
+    inline vfloat load(const float* src) { return *src; }
+    inline void store(float* dst, vfloat v) { *dst = v; }
+    inline vfloat set(float f) { return f; }
+    inline vint seti(int i) { return i; }
+
+    inline vfloat add(vfloat a, vfloat b) { return a + b; }
+    inline vfloat sub(vfloat a, vfloat b) { return a - b; }
+    inline vfloat mul(vfloat a, vfloat b) { return a * b; }
+    inline vfloat min(vfloat a, vfloat b) { return a < b ? a : b; }
+    inline vfloat max(vfloat a, vfloat b) { return a > b ? a : b; }
+
+    inline vint iadd(vint a, vint b) {
+        return static_cast<vint>(
+            static_cast<uint32_t>(a) + static_cast<uint32_t>(b)
+        );
+    }
+    inline vint ixor(vint a, vint b) { return a ^ b; }
+    inline vint iand(vint a, vint b) { return a & b; }
+    inline vint sra15(vint a) { return a >> 15; }
+    inline vint imul(vint a, vint b) {
+        return static_cast<vint>(
+            static_cast<uint32_t>(a) * static_cast<uint32_t>(b)
+        );
+    }
+
+    inline vint cmple(vfloat a, vfloat b) { return a <= b ? -1 : 0; }
+    inline vint cmpge(vfloat a, vfloat b) { return a >= b ? -1 : 0; }
+    inline vint cmpgt(vfloat a, vfloat b) { return a > b ? -1 : 0; }
+    inline vfloat select(vint mask, vfloat a, vfloat b) {
+        return mask ? a : b;
+    }
+    inline vint select(vint mask, vint a, vint b) { return mask ? a : b; }
+
+    inline vint to_int(vfloat v) { return static_cast<vint>(v); }
+    inline vfloat to_float(vint v) { return static_cast<vfloat>(v); }
+
+    inline vfloat gather(const float* table, vint index) {
+        return table[index];
+    }
+#endif
+
+    constexpr float FREQUENCY = 0.01f;
+    constexpr float SQRT3 = 1.7320508075688772935274463415059f;
+    constexpr float F2 = 0.5f * (SQRT3 - 1);
+    constexpr float G2 = (3 - SQRT3) / 6;
+    constexpr float CELLULAR_JITTER = 0.5f;
+
+    /// @brief _fnlFastFloor
+    inline vint fast_floor(vfloat f) {
+        vint i = to_int(f);
+        return select(cmpge(f, set(0.0f)), i, iadd(i, seti(-1)));
+    }
+
+    /// @brief _fnlFastRound
+    inline vint fast_round(vfloat f) {
+        return select(
+            cmpge(f, set(0.0f)),
+            to_int(add(f, set(0.5f))),
+            to_int(sub(f, set(0.5f)))
+        );
+    }
+
+    /// @brief _fnlHash2D
+    inline vint hash2d(vint seed, vint xPrimed, vint yPrimed) {
+        return imul(ixor(ixor(seed, xPrimed), yPrimed), seti(0x27d4eb2d));
+    }
+
+    /// @brief _fnlGradCoord2D
+    inline vfloat grad_coord2d(
+        vint seed, vint xPrimed, vint yPrimed, vfloat xd, vfloat yd
+    ) {
+        vint hash = hash2d(seed, xPrimed, yPrimed);
+        hash = ixor(hash, sra15(hash));
+        hash = iand(hash, seti(127 << 1));
+        return add(
+            mul(xd, gather(GRADIENTS_2D, hash)),
+            mul(yd, gather(GRADIENTS_2D + 1, hash))
+        );
+    }
+
+    /// @brief (a * a) * (a * a) * gradient or 0 if a <= 0
+    inline vfloat falloff(vfloat a, vfloat gradient) {
+        vfloat zero = set(0.0f);
+        vfloat a2 = mul(a, a);
+        return select(cmple(a, zero), zero, mul(mul(a2, a2), gradient));
+    }
+
+    /// @brief Frequency transform, skew and _fnlSingleSimplex2D
+    vfloat simplex_lanes(vint seed, vfloat x, vfloat y) {
+        x = mul(x, set(FREQUENCY));
+        y = mul(y, set(FREQUENCY));
+        vfloat s = mul(add(x, y), set(F2));
+        x = add(x, s);
+        y = add(y, s);
+
+        vint i = fast_floor(x);
+        vint j = fast_floor(y);
+        vfloat xi = sub(x, to_float(i));
+        vfloat yi = sub(y, to_float(j));
+
+        vfloat t = mul(add(xi, yi), set(G2));
+        vfloat x0 = sub(xi, t);
+        vfloat y0 = sub(yi, t);
+
+        i = imul(i, seti(PRIME_X));
+        j = imul(j, seti(PRIME_Y));
+
+        vfloat a = sub(sub(set(0.5f), mul(x0, x0)), mul(y0, y0));
+        vfloat n0 = falloff(a, grad_coord2d(seed, i, j, x0, y0));
+
+        vfloat c = add(
+            mul(set(static_cast<float>(2 * (1 - 2 * G2) * (1 / G2 - 2))), t),
+            add(set(static_cast<float>(-2 * (1 - 2 * G2) * (1 - 2 * G2))), a)
+        );
+        vfloat x2 = add(x0, set(2 * G2 - 1));
+        vfloat y2 = add(y0, set(2 * G2 - 1));
+        vfloat n2 = falloff(
+            c,
+            grad_coord2d(
+                seed, iadd(i, seti(PRIME_X)), iadd(j, seti(PRIME_Y)), x2, y2
+            )
+        );
+
+        vint upper = cmpgt(y0, x0);
+        vfloat x1 = add(x0, select(upper, set(G2), set(G2 - 1)));
+        vfloat y1 = add(y0, select(upper, set(G2 - 1), set(G2)));
+        vint i1 = iadd(i, select(upper, seti(0), seti(PRIME_X)));
+        vint j1 = iadd(j, select(upper, seti(PRIME_Y), seti(0)));
+        vfloat b = sub(sub(set(0.5f), mul(x1, x1)), mul(y1, y1));
+        vfloat n1 = falloff(b, grad_coord2d(seed, i1, j1, x1, y1));
+
+        return mul(add(add(n0, n1), n2), set(99.83685446303647f));
+    }
+
+    /// @brief Frequency transform and _fnlSingleCellular2D with default
+    /// settings: euclidean squared distance, distance return type
+    vfloat cellular_lanes(vint seed, vfloat x, vfloat y) {
+        x = mul(x, set(FREQUENCY));
+        y = mul(y, set(FREQUENCY));
+
+        vint xr = fast_round(x);
+        vint yr = fast_round(y);
+
+        vfloat distance0 = set(FLT_MAX);
+        vfloat distance1 = set(FLT_MAX);
+
+        vint xi = iadd(xr, seti(-1));
+        vint xPrimed = imul(xi, seti(PRIME_X));
+        vint yiBase = iadd(yr, seti(-1));
+        vint yPrimedBase = imul(yiBase, seti(PRIME_Y));
+        for (int dx = 0; dx < 3; dx++) {
+            vint yi = yiBase;
+            vint yPrimed = yPrimedBase;
+            for (int dy = 0; dy < 3; dy++) {
+                vint hash = hash2d(seed, xPrimed, yPrimed);
+                vint idx = iand(hash, seti(255 << 1));
+
+                vfloat vecX = add(
+                    sub(to_float(xi), x),
+                    mul(gather(RAND_VECS_2D, idx), set(CELLULAR_JITTER))
+                );
+                vfloat vecY = add(
+                    sub(to_float(yi), y),
+                    mul(gather(RAND_VECS_2D + 1, idx), set(CELLULAR_JITTER))
+                );
+                vfloat newDistance = add(mul(vecX, vecX), mul(vecY, vecY));
+
+                distance1 = max(min(distance1, newDistance), distance0);
+                distance0 = min(newDistance, distance0);
+
+                yi = iadd(yi, seti(1));
+                yPrimed = iadd(yPrimed, seti(PRIME_Y));
+            }
+            xi = iadd(xi, seti(1));
+            xPrimed = iadd(xPrimed, seti(PRIME_X));
+        }
+        return sub(distance0, set(1.0f));
+    }
+
+    template <vfloat (*kernel)(vint, vfloat, vfloat)>
+    void sample_lanes(
+        int seed, const float* x, const float* y, float* dst, uint count
+    ) {
+        vint vseed = seti(seed);
+        uint i = 0;
+        for (; i + LANES <= count; i += LANES) {
+            store(dst + i, kernel(vseed, load(x + i), load(y + i)));
+        }
+        if (i < count) {
+            // tail is padded to the full lanes count
+            float tailX[LANES] {};
+            float tailY[LANES] {};
+            float tailDst[LANES];
+            std::copy(x + i, x + count, tailX);
+            std::copy(y + i, y + count, tailY);
+            store(tailDst, kernel(vseed, load(tailX), load(tailY)));
+            std::copy(tailDst, tailDst + (count - i), dst + i);
+        }
+    }
+}
+
+void noise::simplex2d(
+    int seed, const float* x, const float* y, float* dst, uint count
+) {
+    sample_lanes<simplex_lanes>(seed, x, y, dst, count);
+}
+
+void noise::cellular2d(
+    int seed, const float* x, const float* y, float* dst, uint count
+) {
+    sample_lanes<cellular_lanes>(seed, x, y, dst, count);
+}
+
+void noise::sample2d(
+    NoiseType type,
+    int seed,
+    const float* x,
+    const float* y,
+    float* dst,
+    uint count
+) {
+    switch (type) {
+        case NoiseType::SIMPLEX:
+            simplex2d(seed, x, y, dst, count);
+            break;
+        case NoiseType::CELLULAR:
+            cellular2d(seed, x, y, dst, count);
+            break;
+    }
+}
+
+void noise::add_octaves2d(
+    NoiseType type,
+    int seed,
+    glm::vec2 offset,
+    float scale,
+    int octaves,
+    float multiplier,
+    uint width,
+    uint start,
+    uint count,
+    float* values,
+    const float* shiftX,
+    const float* shiftY
+) {
+    constexpr uint BATCH_SIZE = 256;
+    float u[BATCH_SIZE];
+    float v[BATCH_SIZE];
+    float n[BATCH_SIZE];
+    for (uint batch = 0; batch < count; batch += BATCH_SIZE) {
+        uint batchSize = std::min(BATCH_SIZE, count - batch);
+        for (int c = 0; c < octaves; c++) {
+            float m = scale * (1 << c);
+            for (uint i = 0; i < batchSize; i++) {
+                uint index = start + batch + i;
+                uint x = index % width;
+                uint y = index / width;
+                u[i] = (x + offset.x) * m;
+                v[i] = (y + offset.y) * m;
+                if (shiftX) {
+                    u[i] += shiftX[batch + i];
+                }
+                if (shiftY) {
+                    v[i] += shiftY[batch + i];
+                }
+            }
+            sample2d(type, seed, u, v, n, batchSize);
+            float* dst = values + batch;
+            for (uint i = 0; i < batchSize; i++) {
+                dst[i] += n[i] / static_cast<float>(1 << c) * multiplier;
+            }
+        }
+    }
+}
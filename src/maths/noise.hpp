@@ -0,0 +1,58 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "typedefs.hpp"
+
+enum class NoiseType {
+    SIMPLEX,
+    CELLULAR,
+};
+
+/// @brief Batched 2D noise kernels processing multiple points per step
+/// (SSE2/NEON where available). Results are equal to fnlGetNoise2D with
+/// the default fnl_state (only seed and noise type changed)
+namespace noise {
+    /// @brief Sample OpenSimplex2 noise (FNL_NOISE_OPENSIMPLEX2)
+    /// @param x, y points coordinates (count)
+    /// @param dst destination values (count)
+    void simplex2d(
+        int seed, const float* x, const float* y, float* dst, uint count
+    );
+
+    /// @brief Sample cellular noise (FNL_NOISE_CELLULAR)
+    /// @param x, y points coordinates (count)
+    /// @param dst destination values (count)
+    void cellular2d(
+        int seed, const float* x, const float* y, float* dst, uint count
+    );
+
+    void sample2d(
+        NoiseType type,
+        int seed,
+        const float* x,
+        const float* y,
+        float* dst,
+        uint count
+    );
+
+    /// @brief Add noise octaves to the points [start, start + count) of a
+    /// map (see heightmap:noise)
+    /// @param width map width
+    /// @param values points values (count)
+    /// @param shiftX, shiftY coordinates shifts (count) or nullptr
+    void add_octaves2d(
+        NoiseType type,
+        int seed,
+        glm::vec2 offset,
+        float scale,
+        int octaves,
+        float multiplier,
+        uint width,
+        uint start,
+        uint count,
+        float* values,
+        const float* shiftX,
+        const float* shiftY
+    );
+}
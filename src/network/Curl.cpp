@@ -4,7 +4,10 @@
 
 #define NOMINMAX
 #include <curl/curl.h>
+#include <algorithm>
+#include <limits>
 #include <queue>
+#include <unordered_map>
 
 using namespace network;
 
@@ -13,15 +16,8 @@ static debug::Logger logger("curl");
 inline constexpr int HTTP_OK = 200;
 inline constexpr int HTTP_BAD_GATEWAY = 502;
 
-static size_t write_callback(
-    char* ptr, size_t size, size_t nmemb, void* userdata
-) {
-    auto& buffer = *reinterpret_cast<std::vector<char>*>(userdata);
-    size_t psize = buffer.size();
-    buffer.resize(psize + size * nmemb);
-    std::memcpy(buffer.data() + psize, ptr, size * nmemb);
-    return size * nmemb;
-}
+/// @brief Max response size reserved ahead by Content-Length
+inline constexpr curl_off_t MAX_RESERVE = 64 * 1024 * 1024;
 
 enum class RequestType {
     GET, POST
@@ -38,29 +34,216 @@ struct Request {
     std::vector<std::string> headers;
 };
 
+/// @brief Request being performed by an easy handle added to the multi handle
+struct Transfer {
+    CURL* curl;
+    Request request;
+    curl_slist* headers = nullptr;
+    /// @brief Response body, moved to the callback when done
+    std::vector<char> buffer;
+};
+
+static size_t write_callback(
+    char* ptr, size_t size, size_t nmemb, void* userdata
+) {
+    auto& transfer = *reinterpret_cast<Transfer*>(userdata);
+    auto& buffer = transfer.buffer;
+    size_t length = size * nmemb;
+    long maxSize = transfer.request.maxSize;
+    if (maxSize > 0 && buffer.size() + length > static_cast<size_t>(maxSize)) {
+        // aborts the transfer if Content-Length was not given
+        return 0;
+    }
+    if (buffer.empty()) {
+        curl_off_t contentLength = -1;
+        curl_easy_getinfo(
+            transfer.curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &contentLength
+        );
+        if (contentLength > 0) {
+            buffer.reserve(std::min(contentLength, MAX_RESERVE));
+        }
+    }
+    buffer.insert(buffer.end(), ptr, ptr + length);
+    return length;
+}
+
 class CurlRequests : public Requests {
     CURLM* multiHandle;
-    CURL* curl;
+    /// @brief Max number of concurrent transfers
+    size_t maxTransfers;
 
     size_t totalUpload = 0;
     size_t totalDownload = 0;
 
-    OnResponse onResponse;
-    OnReject onReject;
-    std::vector<char> buffer;
-    std::string url;
-
+    /// @brief Easy handles kept to reuse their connections and DNS cache
+    std::vector<CURL*> idleHandles;
+    std::unordered_map<CURL*, std::unique_ptr<Transfer>> transfers;
+    /// @brief Requests waiting for a free transfer slot
     std::queue<Request> requests;
+
+    CURL* acquireHandle() {
+        if (!idleHandles.empty()) {
+            CURL* curl = idleHandles.back();
+            idleHandles.pop_back();
+            return curl;
+        }
+        return curl_easy_init();
+    }
+
+    void releaseHandle(CURL* curl) {
+        if (idleHandles.size() >= maxTransfers) {
+            curl_easy_cleanup(curl);
+            return;
+        }
+        // keeps live connections, session ID and DNS caches
+        curl_easy_reset(curl);
+        idleHandles.push_back(curl);
+    }
+
+    void startTransfer(Request request) {
+        CURL* curl = acquireHandle();
+        if (curl == nullptr) {
+            logger.error() << "could not create handle (" << request.url << ")";
+            if (request.onReject) {
+                request.onReject(HTTP_BAD_GATEWAY, {});
+            }
+            return;
+        }
+        auto transfer = std::make_unique<Transfer>();
+        transfer->curl = curl;
+        transfer->request = std::move(request);
+        const auto& req = transfer->request;
+
+        curl_slist* hs = nullptr;
+        for (const auto& header : req.headers) {
+            hs = curl_slist_append(hs, header.c_str());
+        }
+
+        curl_easy_setopt(curl, CURLOPT_URL, req.url.c_str());
+        switch (req.type) {
+            case RequestType::GET:
+                break;
+            case RequestType::POST:
+                hs = curl_slist_append(hs, "Content-Type: application/json");
+                curl_easy_setopt(curl, CURLOPT_POST, 1L);
+                // data is owned by the transfer, so it is not copied
+                curl_easy_setopt(
+                    curl,
+                    CURLOPT_POSTFIELDSIZE_LARGE,
+                    static_cast<curl_off_t>(req.data.length())
+                );
+                curl_easy_setopt(curl, CURLOPT_POSTFIELDS, req.data.c_str());
+                break;
+            default:
+                throw std::runtime_error("not implemented");
+        }
+        transfer->headers = hs;
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, hs);
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, req.followLocation ? 1L : 0L);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, transfer.get());
+        curl_easy_setopt(curl, CURLOPT_USERAGENT, "curl/7.81.0");
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        // wait for a connection being reused instead of opening a new one
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+        curl_easy_setopt(
+            curl,
+            CURLOPT_MAXFILESIZE_LARGE,
+            req.maxSize == 0 ? std::numeric_limits<curl_off_t>::max()
+                             : static_cast<curl_off_t>(req.maxSize)
+        );
+
+        CURLMcode res = curl_multi_add_handle(multiHandle, curl);
+        if (res != CURLM_OK) {
+            logger.error() << curl_multi_strerror(res) << " (" << req.url << ")";
+            if (req.onReject) {
+                req.onReject(HTTP_BAD_GATEWAY, {});
+            }
+            curl_slist_free_all(hs);
+            releaseHandle(curl);
+            return;
+        }
+        transfers[curl] = std::move(transfer);
+    }
+
+    void finishTransfer(CURL* curl, CURLcode result) {
+        auto found = transfers.find(curl);
+        if (found == transfers.end()) {
+            return;
+        }
+        auto transfer = std::move(found->second);
+        transfers.erase(found);
+        curl_multi_remove_handle(multiHandle, curl);
+
+        const auto& req = transfer->request;
+        auto& buffer = transfer->buffer;
+
+        long response = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response);
+        long size;
+        if (!curl_easy_getinfo(curl, CURLINFO_REQUEST_SIZE, &size)) {
+            totalUpload += size;
+        }
+        if (!curl_easy_getinfo(curl, CURLINFO_HEADER_SIZE, &size)) {
+            totalDownload += size;
+        }
+        totalDownload += buffer.size();
+
+        curl_slist_free_all(transfer->headers);
+        releaseHandle(curl);
+
+        if (result == CURLE_OK && response == HTTP_OK) {
+            if (req.onResponse) {
+                req.onResponse(std::move(buffer));
+            }
+            return;
+        }
+        if (result != CURLE_OK) {
+            logger.error() << curl_easy_strerror(result) << " (" << req.url
+                           << ")";
+        } else {
+            logger.error()
+                << "response code " << response << " (" << req.url << ")"
+                << (buffer.empty()
+                        ? ""
+                        : std::to_string(buffer.size()) + " byte(s)");
+        }
+        if (req.onReject) {
+            req.onReject(static_cast<int>(response), std::move(buffer));
+        }
+    }
+
+    void processRequest(Request request) {
+        if (transfers.size() >= maxTransfers) {
+            requests.push(std::move(request));
+            return;
+        }
+        startTransfer(std::move(request));
+    }
 public:
-    CurlRequests(CURLM* multiHandle, CURL* curl)
-        : multiHandle(multiHandle), curl(curl) {
+    CurlRequests(CURLM* multiHandle, size_t maxTransfers)
+        : multiHandle(multiHandle), maxTransfers(maxTransfers) {
+        curl_multi_setopt(multiHandle, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        curl_multi_setopt(
+            multiHandle, CURLMOPT_MAX_TOTAL_CONNECTIONS, static_cast<long>(maxTransfers)
+        );
+        curl_multi_setopt(
+            multiHandle, CURLMOPT_MAXCONNECTS, static_cast<long>(maxTransfers)
+        );
     }
 
     virtual ~CurlRequests() {
-        curl_multi_remove_handle(multiHandle, curl);
-        curl_easy_cleanup(curl);
+        for (auto& [curl, transfer] : transfers) {
+            curl_multi_remove_handle(multiHandle, curl);
+            curl_slist_free_all(transfer->headers);
+            curl_easy_cleanup(curl);
+        }
+        for (auto curl : idleHandles) {
+            curl_easy_cleanup(curl);
+        }
         curl_multi_cleanup(multiHandle);
     }
+
     void get(
         const std::string& url,
         OnResponse onResponse,
@@ -71,8 +254,8 @@ public:
         Request request {
             RequestType::GET,
             url,
-            onResponse,
-            onReject,
+            std::move(onResponse),
+            std::move(onReject),
             maxSize,
             true,
             "",
@@ -91,122 +274,43 @@ public:
         Request request {
             RequestType::POST,
             url,
-            onResponse,
-            onReject,
+            std::move(onResponse),
+            std::move(onReject),
             maxSize,
             false,
-            "",
+            data,
             std::move(headers)};
-        request.data = data;
         processRequest(std::move(request));
     }
 
-    void processRequest(Request request) {
-        if (!url.empty()) {
-            requests.push(request);
+    void update() override {
+        if (transfers.empty()) {
             return;
         }
-        onResponse = request.onResponse;
-        onReject = request.onReject;
-        url = request.url;
-
-        buffer.clear();
-
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_POST, request.type == RequestType::POST);
-        
-        curl_slist* hs = nullptr;
-        
-        for (const auto& header : request.headers) {
-            hs = curl_slist_append(hs, header.c_str());
-        }
-
-        switch (request.type) {
-            case RequestType::GET:
-                break;
-            case RequestType::POST: 
-                hs = curl_slist_append(hs, "Content-Type: application/json");
-                curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, request.data.length());
-                curl_easy_setopt(curl, CURLOPT_COPYPOSTFIELDS, request.data.c_str());
-                break;
-            default:
-                throw std::runtime_error("not implemented");
-        }
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, hs);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, request.followLocation);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buffer);
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, "curl/7.81.0");
-        if (request.maxSize == 0) {
-            curl_easy_setopt(
-                curl, CURLOPT_MAXFILESIZE, std::numeric_limits<long>::max()
-            );
-        } else {
-            curl_easy_setopt(curl, CURLOPT_MAXFILESIZE, request.maxSize);
-        }
-        curl_multi_add_handle(multiHandle, curl);
         int running;
         CURLMcode res = curl_multi_perform(multiHandle, &running);
         if (res != CURLM_OK) {
-            auto message = curl_multi_strerror(res);
-            logger.error() << message << " (" << url << ")";
-            if (onReject) {
-                onReject(HTTP_BAD_GATEWAY, {});
+            logger.error() << curl_multi_strerror(res);
+            std::vector<CURL*> failed;
+            for (const auto& [curl, _] : transfers) {
+                failed.push_back(curl);
             }
-            url = "";
-        }
-    }
-
-    void update() override {
-        int messagesLeft;
-        int running;
-        CURLMsg* msg;
-        CURLMcode res = curl_multi_perform(multiHandle, &running);
-        if (res != CURLM_OK) {
-            auto message = curl_multi_strerror(res);
-            logger.error() << message << " (" << url << ")";
-            if (onReject) {
-                onReject(HTTP_BAD_GATEWAY, {});
-            }
-            curl_multi_remove_handle(multiHandle, curl);
-            url = "";
-            return;
-        }
-        if ((msg = curl_multi_info_read(multiHandle, &messagesLeft)) != nullptr) {
-            if(msg->msg == CURLMSG_DONE) {
-                curl_multi_remove_handle(multiHandle, curl);
+            for (auto curl : failed) {
+                finishTransfer(curl, CURLE_FAILED_INIT);
             }
-            int response;
-            curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &response);
-            if (response == HTTP_OK) {
-                long size;
-                if (!curl_easy_getinfo(curl, CURLINFO_REQUEST_SIZE, &size)) {
-                    totalUpload += size;
-                }
-                if (!curl_easy_getinfo(curl, CURLINFO_HEADER_SIZE, &size)) {
-                    totalDownload += size;
-                }
-                totalDownload += buffer.size();
-                if (onResponse) {
-                    onResponse(std::move(buffer));
-                }
-            } else {
-                logger.error()
-                    << "response code " << response << " (" << url << ")"
-                    << (buffer.empty()
-                            ? ""
-                            : std::to_string(buffer.size()) + " byte(s)");
-                totalDownload += buffer.size();
-                if (onReject) {
-                    onReject(response, std::move(buffer));
+        } else {
+            int messagesLeft;
+            CURLMsg* msg;
+            while ((msg = curl_multi_info_read(multiHandle, &messagesLeft))) {
+                if (msg->msg == CURLMSG_DONE) {
+                    finishTransfer(msg->easy_handle, msg->data.result);
                 }
             }
-            url = "";
         }
-        if (url.empty() && !requests.empty()) {
+        while (transfers.size() < maxTransfers && !requests.empty()) {
             auto request = std::move(requests.front());
             requests.pop();
-            processRequest(std::move(request));
+            startTransfer(std::move(request));
         }
     }
 
@@ -218,22 +322,19 @@ public:
         return totalDownload;
     }
 
-    static std::unique_ptr<CurlRequests> create() {
-        auto curl = curl_easy_init();
-        if (curl == nullptr) {
-            throw std::runtime_error("could not initialzie cURL");
-        }
+    static std::unique_ptr<CurlRequests> create(size_t maxTransfers) {
         auto multiHandle = curl_multi_init();
         if (multiHandle == nullptr) {
-            curl_easy_cleanup(curl);
             throw std::runtime_error("could not initialzie cURL-multi");
         }
-        return std::make_unique<CurlRequests>(multiHandle, curl);
+        return std::make_unique<CurlRequests>(
+            multiHandle, std::max<size_t>(1, maxTransfers)
+        );
     }
 };
 
 namespace network {
-    std::unique_ptr<Requests> create_curl_requests() {
-        return CurlRequests::create();
+    std::unique_ptr<Requests> create_curl_requests(size_t maxTransfers) {
+        return CurlRequests::create(maxTransfers);
     }
 }
@@ -1,11 +1,13 @@
 #include "Network.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 #include <limits>
 #include <queue>
 #include <thread>
 
 #include "debug/Logger.hpp"
+#include "Reactor.hpp"
 #include "util/stringutil.hpp"
 
 using namespace network;
@@ -13,9 +15,10 @@ using namespace network;
 static debug::Logger logger("network");
 
 namespace network {
-    std::unique_ptr<Requests> create_curl_requests();
+    std::unique_ptr<Requests> create_curl_requests(size_t maxTransfers);
 
     std::shared_ptr<TcpConnection> connect_tcp(
+        Reactor& reactor,
         const std::string& address,
         int port,
         runnable callback,
@@ -23,11 +26,16 @@ namespace network {
     );
 
     std::shared_ptr<TcpServer> open_tcp_server(
-        u64id_t id, Network* network, int port, ConnectCallback handler
+        u64id_t id,
+        Network* network,
+        Reactor& reactor,
+        int port,
+        ConnectCallback handler
     );
 
     std::shared_ptr<UdpConnection> connect_udp(
         u64id_t id,
+        Reactor& reactor,
         const std::string& address,
         int port,
         ClientDatagramCallback handler,
@@ -36,7 +44,7 @@ namespace network {
 
     std::shared_ptr<UdpServer> open_udp_server(
         u64id_t id,
-        Network* network,
+        Reactor& reactor,
         int port,
         const ServerDatagramCallback& handler
     );
@@ -46,10 +54,14 @@ namespace network {
 
 
 Network::Network(std::unique_ptr<Requests> requests)
-: requests(std::move(requests)) {
+: requests(std::move(requests)), reactor(create_reactor()) {
 }
 
-Network::~Network() = default;
+Network::~Network() {
+    // handlers must not be called while connections and servers are
+    // being destroyed
+    reactor->stop();
+}
 
 void Network::get(
     const std::string& url,
@@ -105,7 +117,7 @@ u64id_t Network::connectTcp(
     std::lock_guard lock(connectionsMutex);
     
     u64id_t id = nextConnection++;
-    auto socket = connect_tcp(address, port, [id, callback]() {
+    auto socket = connect_tcp(*reactor, address, port, [id, callback]() {
         callback(id);
     }, [id, errorCallback](auto errorMessage) {
         errorCallback(id, errorMessage);
@@ -116,7 +128,7 @@ u64id_t Network::connectTcp(
 
 u64id_t Network::openTcpServer(int port, ConnectCallback handler) {
     u64id_t id = nextServer++;
-    auto server = open_tcp_server(id, this, port, handler);
+    auto server = open_tcp_server(id, this, *reactor, port, handler);
     servers[id] = std::move(server);
     return id;
 }
@@ -130,7 +142,7 @@ u64id_t Network::connectUdp(
     std::lock_guard lock(connectionsMutex);
 
     u64id_t id = nextConnection++;
-    auto socket = connect_udp(id, address, port, std::move(handler), [id, callback]() {
+    auto socket = connect_udp(id, *reactor, address, port, std::move(handler), [id, callback]() {
         callback(id);
     });
     connections[id] = std::move(socket);
@@ -139,7 +151,7 @@ u64id_t Network::connectUdp(
 
 u64id_t Network::openUdpServer(int port, const ServerDatagramCallback& handler) {
     u64id_t id = nextServer++;
-    auto server = open_udp_server(id, this, port, handler);
+    auto server = open_udp_server(id, *reactor, port, handler);
     servers[id] = std::move(server);
     return id;
 }
@@ -160,6 +172,37 @@ size_t Network::getTotalDownload() const {
     return requests->getTotalDownload() + totalDownload;
 }
 
+static void add_stats(ConnectionStats& dst, const ConnectionStats& src) {
+    dst.bytesSent += src.bytesSent;
+    dst.bytesReceived += src.bytesReceived;
+    dst.packetsSent += src.packetsSent;
+    dst.packetsReceived += src.packetsReceived;
+    dst.sendQueue += src.sendQueue;
+    dst.rtt = std::max(dst.rtt, src.rtt);
+    dst.drops += src.drops;
+}
+
+ConnectionStats Network::getStats() {
+    ConnectionStats stats {};
+    {
+        std::lock_guard lock(connectionsMutex);
+        for (const auto& [_, connection] : connections) {
+            add_stats(stats, connection->getStats());
+        }
+    }
+    for (const auto& [_, server] : servers) {
+        if (auto udpServer = dynamic_cast<UdpServer*>(server.get())) {
+            add_stats(stats, udpServer->getStats());
+        }
+    }
+    return stats;
+}
+
+size_t Network::countConnections() {
+    std::lock_guard lock(connectionsMutex);
+    return connections.size();
+}
+
 void Network::update() {
     requests->update();
 
@@ -168,6 +211,10 @@ void Network::update() {
         auto socketiter = connections.begin();
         while (socketiter != connections.end()) {
             auto socket = socketiter->second.get();
+            if (socket->getTransportType() == TransportType::TCP) {
+                // coalesced writes of the tick
+                static_cast<TcpConnection*>(socket)->flush();
+            }
             totalDownload += socket->pullDownload();
             totalUpload += socket->pullUpload();
             if (
@@ -195,5 +242,7 @@ void Network::update() {
 
 std::unique_ptr<Network> Network::create(const NetworkSettings& settings) {
     logger.info() << "initializing network";
-    return std::make_unique<Network>(network::create_curl_requests());
+    return std::make_unique<Network>(
+        network::create_curl_requests(settings.maxRequests.get())
+    );
 }
@@ -3,6 +3,8 @@
 #include "commons.hpp"
 
 namespace network {
+    class Reactor;
+
     class TcpConnection : public ReadableConnection {
     public:
         ~TcpConnection() override = default;
@@ -12,6 +14,14 @@ namespace network {
         virtual void setNoDelay(bool noDelay) = 0;
         [[nodiscard]] virtual bool isNoDelay() const = 0;
 
+        /// @brief If enabled, sent data is accumulated and written at once
+        /// by flush (called by Network::update) or when the buffer is large
+        virtual void setCoalescing(bool flag) = 0;
+        [[nodiscard]] virtual bool isCoalescing() const = 0;
+
+        /// @brief Write accumulated data
+        virtual void flush() = 0;
+
         [[nodiscard]] TransportType getTransportType() const noexcept override {
             return TransportType::TCP;
         }
@@ -47,6 +57,8 @@ namespace network {
 
         virtual void sendTo(const std::string& addr, int port, const char* buffer, size_t length) = 0;
 
+        [[nodiscard]] virtual ConnectionStats getStats() const = 0;
+
         [[nodiscard]] TransportType getTransportType() const noexcept override {
             return TransportType::UDP;
         }
@@ -54,6 +66,8 @@ namespace network {
 
     class Network {
         std::unique_ptr<Requests> requests;
+        /// @brief Sockets I/O thread (must outlive connections and servers)
+        std::unique_ptr<Reactor> reactor;
 
         std::unordered_map<u64id_t, std::shared_ptr<Connection>> connections;
         std::mutex connectionsMutex {};
@@ -111,6 +125,12 @@ namespace network {
         [[nodiscard]] size_t getTotalUpload() const;
         [[nodiscard]] size_t getTotalDownload() const;
 
+        /// @brief Sum of all connections and UDP servers stats
+        /// (rtt is the max one)
+        [[nodiscard]] ConnectionStats getStats();
+
+        [[nodiscard]] size_t countConnections();
+
         void update();
 
         static std::unique_ptr<Network> create(const NetworkSettings& settings);
@@ -0,0 +1,348 @@
+#include "Reactor.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h>
+#define VC_REACTOR_POLL
+#elif defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#define VC_REACTOR_EPOLL
+#elif defined(__APPLE__) || defined(__FreeBSD__)
+#include <sys/event.h>
+#include <unistd.h>
+#define VC_REACTOR_KQUEUE
+#else
+#include <poll.h>
+#include <unistd.h>
+#define VC_REACTOR_POLL
+#endif
+
+#include "debug/Logger.hpp"
+#include "debug/Profiler.hpp"
+
+using namespace network;
+
+static debug::Logger logger("reactor");
+
+#ifdef VC_REACTOR_POLL
+/// @brief Poll backend has no wake-up mechanism, so sockets and posted
+/// tasks changes are picked up after the timeout (milliseconds)
+inline constexpr int POLL_TIMEOUT = 10;
+#endif
+inline constexpr int MAX_EVENTS = 64;
+
+namespace {
+    struct ReadyEvent {
+        socket_t socket;
+        bool readable;
+        bool writable;
+    };
+
+    struct Entry {
+        std::weak_ptr<SocketHandler> handler;
+        int events;
+    };
+}
+
+class SocketsReactor : public Reactor {
+    std::mutex mutex;
+    std::unordered_map<socket_t, Entry> entries;
+    std::vector<runnable> tasks;
+    std::atomic<bool> running = true;
+    std::thread thread;
+#if defined(VC_REACTOR_EPOLL)
+    int epollfd;
+    int wakefd;
+#elif defined(VC_REACTOR_KQUEUE)
+    int kq;
+#endif
+
+    void initBackend() {
+#if defined(VC_REACTOR_EPOLL)
+        epollfd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollfd == -1) {
+            throw std::runtime_error("epoll_create1 failed");
+        }
+        wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakefd == -1) {
+            ::close(epollfd);
+            throw std::runtime_error("eventfd failed");
+        }
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.fd = wakefd;
+        epoll_ctl(epollfd, EPOLL_CTL_ADD, wakefd, &event);
+#elif defined(VC_REACTOR_KQUEUE)
+        kq = kqueue();
+        if (kq == -1) {
+            throw std::runtime_error("kqueue failed");
+        }
+        struct kevent event;
+        EV_SET(&event, 0, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+        kevent(kq, &event, 1, nullptr, 0, nullptr);
+#endif
+    }
+
+    void closeBackend() {
+#if defined(VC_REACTOR_EPOLL)
+        ::close(wakefd);
+        ::close(epollfd);
+#elif defined(VC_REACTOR_KQUEUE)
+        ::close(kq);
+#endif
+    }
+
+    void wake() {
+#if defined(VC_REACTOR_EPOLL)
+        uint64_t value = 1;
+        [[maybe_unused]] auto written = ::write(wakefd, &value, sizeof(value));
+#elif defined(VC_REACTOR_KQUEUE)
+        struct kevent event;
+        EV_SET(&event, 0, EVFILT_USER, 0, NOTE_TRIGGER, 0, nullptr);
+        kevent(kq, &event, 1, nullptr, 0, nullptr);
+#endif
+    }
+
+    void watch(socket_t socket, int events, bool added) {
+#if defined(VC_REACTOR_EPOLL)
+        epoll_event event {};
+        event.events = ((events & SOCKET_READ) ? uint32_t(EPOLLIN) : 0) |
+                       ((events & SOCKET_WRITE) ? uint32_t(EPOLLOUT) : 0);
+        event.data.fd = socket;
+        if (epoll_ctl(
+                epollfd, added ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, socket, &event
+            )) {
+            logger.error() << "epoll_ctl failed for socket " << socket;
+        }
+#elif defined(VC_REACTOR_KQUEUE)
+        // both filters are always registered to be simply enabled/disabled
+        struct kevent changes[2];
+        EV_SET(
+            &changes[0], socket, EVFILT_READ,
+            EV_ADD | ((events & SOCKET_READ) ? EV_ENABLE : EV_DISABLE),
+            0, 0, nullptr
+        );
+        EV_SET(
+            &changes[1], socket, EVFILT_WRITE,
+            EV_ADD | ((events & SOCKET_WRITE) ? EV_ENABLE : EV_DISABLE),
+            0, 0, nullptr
+        );
+        if (kevent(kq, changes, 2, nullptr, 0, nullptr) == -1) {
+            logger.error() << "kevent failed for socket " << socket;
+        }
+#endif
+    }
+
+    void unwatch(socket_t socket) {
+#if defined(VC_REACTOR_EPOLL)
+        epoll_ctl(epollfd, EPOLL_CTL_DEL, socket, nullptr);
+#elif defined(VC_REACTOR_KQUEUE)
+        struct kevent changes[2];
+        EV_SET(&changes[0], socket, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
+        EV_SET(&changes[1], socket, EVFILT_WRITE, EV_DELETE, 0, 0, nullptr);
+        kevent(kq, changes, 2, nullptr, 0, nullptr);
+#endif
+    }
+
+    void waitEvents(std::vector<ReadyEvent>& ready) {
+#if defined(VC_REACTOR_EPOLL)
+        epoll_event events[MAX_EVENTS];
+        int count = epoll_wait(epollfd, events, MAX_EVENTS, -1);
+        for (int i = 0; i < count; i++) {
+            const auto& event = events[i];
+            if (event.data.fd == wakefd) {
+                uint64_t value;
+                [[maybe_unused]] auto read =
+                    ::read(wakefd, &value, sizeof(value));
+                continue;
+            }
+            bool failed = event.events & (EPOLLERR | EPOLLHUP);
+            ready.push_back(ReadyEvent {
+                event.data.fd,
+                failed || (event.events & (EPOLLIN | EPOLLRDHUP)),
+                failed || (event.events & EPOLLOUT)
+            });
+        }
+#elif defined(VC_REACTOR_KQUEUE)
+        struct kevent events[MAX_EVENTS];
+        int count = kevent(kq, nullptr, 0, events, MAX_EVENTS, nullptr);
+        for (int i = 0; i < count; i++) {
+            const auto& event = events[i];
+            if (event.filter == EVFILT_USER) {
+                continue;
+            }
+            ready.push_back(ReadyEvent {
+                static_cast<socket_t>(event.ident),
+                event.filter == EVFILT_READ,
+                event.filter == EVFILT_WRITE
+            });
+        }
+#else
+        std::vector<pollfd> fds;
+        {
+            std::lock_guard lock(mutex);
+            fds.reserve(entries.size());
+            for (const auto& [socket, entry] : entries) {
+                pollfd fd {};
+                fd.fd = socket;
+                fd.events = ((entry.events & SOCKET_READ) ? POLLIN : 0) |
+                            ((entry.events & SOCKET_WRITE) ? POLLOUT : 0);
+                fds.push_back(fd);
+            }
+        }
+        if (fds.empty()) {
+            std::this_thread::sleep_for(
+                std::chrono::milliseconds(POLL_TIMEOUT)
+            );
+            return;
+        }
+#ifdef _WIN32
+        int count = WSAPoll(fds.data(), fds.size(), POLL_TIMEOUT);
+#else
+        int count = poll(fds.data(), fds.size(), POLL_TIMEOUT);
+#endif
+        if (count <= 0) {
+            return;
+        }
+        for (const auto& fd : fds) {
+            if (fd.revents == 0) {
+                continue;
+            }
+            bool failed = fd.revents & (POLLERR | POLLHUP | POLLNVAL);
+            ready.push_back(ReadyEvent {
+                static_cast<socket_t>(fd.fd),
+                failed || (fd.revents & POLLIN),
+                failed || (fd.revents & POLLOUT)
+            });
+        }
+#endif
+    }
+
+    void dispatch(const ReadyEvent& event) {
+        std::shared_ptr<SocketHandler> handler;
+        int events;
+        {
+            std::lock_guard lock(mutex);
+            const auto& found = entries.find(event.socket);
+            if (found == entries.end()) {
+                // removed while events were collected
+                return;
+            }
+            handler = found->second.handler.lock();
+            events = found->second.events;
+            if (handler == nullptr) {
+                unwatch(event.socket);
+                entries.erase(found);
+                return;
+            }
+        }
+        if (event.writable && (events & SOCKET_WRITE)) {
+            handler->onWritable();
+        }
+        if (event.readable && (events & SOCKET_READ)) {
+            handler->onReadable();
+        }
+    }
+
+    void runTasks() {
+        std::vector<runnable> tasks;
+        {
+            std::lock_guard lock(mutex);
+            std::swap(tasks, this->tasks);
+        }
+        for (const auto& task : tasks) {
+            task();
+        }
+    }
+
+    void run() {
+        debug::profiler::set_thread_name("network");
+        std::vector<ReadyEvent> events;
+        while (running) {
+            events.clear();
+            waitEvents(events);
+            runTasks();
+            if (!running) {
+                break;
+            }
+            for (const auto& event : events) {
+                try {
+                    dispatch(event);
+                } catch (const std::exception& err) {
+                    logger.error() << "socket " << event.socket << ": "
+                                   << err.what();
+                }
+            }
+        }
+    }
+public:
+    SocketsReactor() {
+        initBackend();
+        thread = std::thread([this]() { run(); });
+    }
+
+    ~SocketsReactor() override {
+        stop();
+        closeBackend();
+    }
+
+    void add(
+        socket_t socket, int events, std::weak_ptr<SocketHandler> handler
+    ) override {
+        std::lock_guard lock(mutex);
+        bool added = entries.find(socket) == entries.end();
+        entries[socket] = Entry {std::move(handler), events};
+        watch(socket, events, added);
+    }
+
+    void modify(socket_t socket, int events) override {
+        std::lock_guard lock(mutex);
+        const auto& found = entries.find(socket);
+        if (found == entries.end() || found->second.events == events) {
+            return;
+        }
+        found->second.events = events;
+        watch(socket, events, false);
+    }
+
+    void remove(socket_t socket) override {
+        std::lock_guard lock(mutex);
+        if (entries.erase(socket)) {
+            unwatch(socket);
+        }
+    }
+
+    void post(runnable task) override {
+        {
+            std::lock_guard lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        wake();
+    }
+
+    void stop() override {
+        if (!running.exchange(false)) {
+            return;
+        }
+        wake();
+        if (thread.joinable()) {
+            thread.join();
+        }
+        std::lock_guard lock(mutex);
+        entries.clear();
+        tasks.clear();
+    }
+};
+
+std::unique_ptr<Reactor> network::create_reactor() {
+    return std::make_unique<SocketsReactor>();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "delegates.hpp"
+
+namespace network {
+#ifdef _WIN32
+    using socket_t = uintptr_t;
+#else
+    using socket_t = int;
+#endif
+
+    enum SocketEvents {
+        SOCKET_READ = 1,
+        SOCKET_WRITE = 2,
+    };
+
+    /// @brief Sockets events handler. Methods are called from the reactor
+    /// I/O thread, socket operations must be non-blocking
+    class SocketHandler {
+    public:
+        virtual ~SocketHandler() = default;
+
+        /// @brief Socket has data or incoming connection to accept, was
+        /// closed by peer or got an error
+        virtual void onReadable() = 0;
+
+        /// @brief Socket is ready to write or non-blocking connect finished
+        virtual void onWritable() {}
+    };
+
+    /// @brief Sockets events demultiplexer dispatching readiness events to
+    /// handlers from a single I/O thread (epoll, kqueue or poll backend)
+    class Reactor {
+    public:
+        virtual ~Reactor() = default;
+
+        /// @brief Start watching socket events
+        /// @param events SocketEvents flags
+        /// @param handler events handler, socket is removed automatically
+        /// when the handler is expired
+        virtual void add(
+            socket_t socket, int events, std::weak_ptr<SocketHandler> handler
+        ) = 0;
+
+        /// @brief Change watched events of the socket
+        virtual void modify(socket_t socket, int events) = 0;
+
+        /// @brief Stop watching socket events. Handler may still be running
+        /// in the I/O thread if called from another thread, so the socket
+        /// must not be closed until the handler is destroyed
+        virtual void remove(socket_t socket) = 0;
+
+        /// @brief Run task in the I/O thread
+        virtual void post(runnable task) = 0;
+
+        /// @brief Stop the I/O thread. Handlers are not called after return
+        virtual void stop() = 0;
+    };
+
+    std::unique_ptr<Reactor> create_reactor();
+}
@@ -3,6 +3,7 @@
 #pragma comment(lib, "Ws2_32.lib")
 
 #define NOMINMAX
+#include <atomic>
 #include <stdexcept>
 #include <limits>
 #include <queue>
@@ -14,18 +15,26 @@
 #else
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <poll.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
+#endif
 
 using SOCKET = int;
 #endif // _WIN32
 
 #include "Network.hpp"
+#include "Reactor.hpp"
+#include "util/RingBuffer.hpp"
 #include "util/stringutil.hpp"
 #include "debug/Logger.hpp"
 
@@ -87,6 +96,130 @@ static inline int sendsocket(
     return send(descriptor, buf, len, flags);
 }
 
+/// @brief Max number of buffers passed to a single gather write
+inline constexpr size_t MAX_SEND_BUFFERS = 64;
+
+/// @brief Gather write
+/// @return number of sent bytes or -1
+static int sendvsocket(
+    SOCKET descriptor, const std::string_view* buffers, size_t count
+) noexcept {
+    count = std::min(count, MAX_SEND_BUFFERS);
+#ifdef _WIN32
+    WSABUF wsabufs[MAX_SEND_BUFFERS];
+    for (size_t i = 0; i < count; i++) {
+        wsabufs[i].buf = const_cast<char*>(buffers[i].data());
+        wsabufs[i].len = static_cast<ULONG>(buffers[i].length());
+    }
+    DWORD sent = 0;
+    if (WSASend(descriptor, wsabufs, count, &sent, 0, nullptr, nullptr)) {
+        return -1;
+    }
+    return static_cast<int>(sent);
+#else
+    iovec iov[MAX_SEND_BUFFERS];
+    for (size_t i = 0; i < count; i++) {
+        iov[i].iov_base = const_cast<char*>(buffers[i].data());
+        iov[i].iov_len = buffers[i].length();
+    }
+    msghdr message {};
+    message.msg_iov = iov;
+    message.msg_iovlen = count;
+    return sendmsg(descriptor, &message, 0);
+#endif
+}
+
+static void set_nonblocking(SOCKET descriptor) {
+#ifdef _WIN32
+    u_long mode = 1;
+    if (ioctlsocket(descriptor, FIONBIO, &mode)) {
+        throw handle_socket_error("ioctlsocket(FIONBIO) failed");
+    }
+#else
+    int flags = fcntl(descriptor, F_GETFL, 0);
+    if (flags == -1 || fcntl(descriptor, F_SETFL, flags | O_NONBLOCK) == -1) {
+        throw handle_socket_error("fcntl(O_NONBLOCK) failed");
+    }
+#endif
+}
+
+/// @return true if the last non-blocking operation failed because it
+/// would block (or connect is in progress)
+static bool is_would_block() noexcept {
+#ifdef _WIN32
+    int err = WSAGetLastError();
+    return err == WSAEWOULDBLOCK || err == WSAEINPROGRESS;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS ||
+           errno == EINTR;
+#endif
+}
+
+/// @brief Wait until the socket is ready to write
+static void wait_writable(SOCKET descriptor, int timeoutMillis) noexcept {
+    pollfd fd {};
+    fd.fd = descriptor;
+    fd.events = POLLOUT;
+#ifdef _WIN32
+    WSAPoll(&fd, 1, timeoutMillis);
+#else
+    poll(&fd, 1, timeoutMillis);
+#endif
+}
+
+/// @brief Max send wait time before the connection state is checked again
+inline constexpr int SEND_WAIT_TIMEOUT = 100;
+
+/// @brief Min contiguous receive buffer space for a single recv call
+inline constexpr size_t RECV_CHUNK_SIZE = 16'384;
+/// @brief Coalesced writes buffer size flushed before the tick end
+inline constexpr size_t COALESCE_FLUSH_SIZE = 65'536;
+
+/// @brief Traffic counters updated from both the I/O and the user threads
+struct TrafficCounters {
+    std::atomic<size_t> bytesSent = 0;
+    std::atomic<size_t> bytesReceived = 0;
+    std::atomic<size_t> packetsSent = 0;
+    std::atomic<size_t> packetsReceived = 0;
+    std::atomic<size_t> drops = 0;
+
+    void sent(size_t bytes, size_t packets = 1) {
+        bytesSent.fetch_add(bytes, std::memory_order_relaxed);
+        packetsSent.fetch_add(packets, std::memory_order_relaxed);
+    }
+
+    void received(size_t bytes, size_t packets = 1) {
+        bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+        packetsReceived.fetch_add(packets, std::memory_order_relaxed);
+    }
+
+    ConnectionStats get() const {
+        ConnectionStats stats {};
+        stats.bytesSent = bytesSent.load(std::memory_order_relaxed);
+        stats.bytesReceived = bytesReceived.load(std::memory_order_relaxed);
+        stats.packetsSent = packetsSent.load(std::memory_order_relaxed);
+        stats.packetsReceived = packetsReceived.load(std::memory_order_relaxed);
+        stats.drops = drops.load(std::memory_order_relaxed);
+        return stats;
+    }
+};
+
+/// @brief Read send queue size and RTT estimate of a TCP socket
+/// (Linux only, left zero elsewhere)
+static void read_tcp_info(SOCKET descriptor, ConnectionStats& stats) {
+#ifdef __linux__
+    tcp_info info {};
+    socklen_t len = sizeof(info);
+    if (getsockopt(descriptor, IPPROTO_TCP, TCP_INFO, &info, &len) == 0) {
+        stats.rtt = info.tcpi_rtt;
+    }
+    int queued = 0;
+    if (ioctl(descriptor, SIOCOUTQ, &queued) == 0) {
+        stats.sendQueue = queued;
+    }
+#endif
+}
+
 static std::string to_string(const sockaddr_in& addr, bool port=true) {
     char ip[INET_ADDRSTRLEN];
     if (inet_ntop(AF_INET, &(addr.sin_addr), ip, INET_ADDRSTRLEN)) {
@@ -96,44 +229,79 @@ static std::string to_string(const sockaddr_in& addr, bool port=true) {
     return "";
 }
 
-class SocketTcpConnection : public TcpConnection {
+class SocketTcpConnection
+    : public TcpConnection,
+      public SocketHandler,
+      public std::enable_shared_from_this<SocketTcpConnection> {
+    Reactor& reactor;
     SOCKET descriptor;
     sockaddr_in addr;
     size_t totalUpload = 0;
     size_t totalDownload = 0;
-    ConnectionState state = ConnectionState::INITIAL;
-    std::unique_ptr<std::thread> thread = nullptr;
-    std::vector<char> readBatch;
-    util::Buffer<char> buffer;
+    TrafficCounters counters;
+    std::atomic<ConnectionState> state = ConnectionState::INITIAL;
+    /// @brief Received data, filled by recv(...) without intermediate
+    /// buffers and read by the connection user
+    util::RingBuffer<char> readBatch;
     std::mutex mutex;
     std::string errorMessage;
+    runnable connectCallback;
+    stringconsumer connectErrorCallback;
+    /// @brief Writes accumulated until flush (if coalescing is enabled)
+    std::vector<char> writeBuffer;
+    bool coalescing = false;
 
-    void connectSocket() {
-        state = ConnectionState::CONNECTING;
-        logger.info() << "connecting to " << to_string(addr);
-        int res = connectsocket(descriptor, (const sockaddr*)&addr, sizeof(sockaddr_in));
-        if (res < 0) {
-            auto error = handle_socket_error("Connect failed");
-            closesocket(descriptor);
-            state = ConnectionState::CLOSED;
-            errorMessage = error.what();
-            logger.error() << errorMessage;
-            return;
+    void failConnect(const std::string& message) {
+        state = ConnectionState::CLOSED;
+        errorMessage = message;
+        logger.error() << errorMessage;
+        reactor.remove(descriptor);
+        if (connectErrorCallback) {
+            connectErrorCallback(errorMessage);
         }
+    }
+
+    void finishConnect() {
         logger.info() << "connected to " << to_string(addr);
         state = ConnectionState::CONNECTED;
+        reactor.modify(descriptor, SOCKET_READ);
+        if (connectCallback) {
+            connectCallback();
+        }
+    }
+
+    /// @brief Mark connection closed by peer or due to an error
+    void closeReceiving() {
+        state = ConnectionState::CLOSED;
+        reactor.remove(descriptor);
+    }
+
+    /// @brief Handle failed send call
+    /// @return true if send should be retried
+    bool waitSend() {
+        if (is_would_block()) {
+            // socket is non-blocking, wait for the send buffer space
+            wait_writable(descriptor, SEND_WAIT_TIMEOUT);
+            return state != ConnectionState::CLOSED;
+        }
+        auto error = handle_socket_error("Send failed");
+        close();
+        throw error;
     }
 public:
-    SocketTcpConnection(SOCKET descriptor, sockaddr_in addr)
-        : descriptor(descriptor), addr(std::move(addr)), buffer(16'384) {}
+    SocketTcpConnection(Reactor& reactor, SOCKET descriptor, sockaddr_in addr)
+        : reactor(reactor),
+          descriptor(descriptor),
+          addr(std::move(addr)),
+          readBatch(RECV_CHUNK_SIZE * 2) {
+    }
 
     ~SocketTcpConnection() {
         if (state != ConnectionState::CLOSED) {
-            shutdown(descriptor, 2);
-        }
-        if (thread) {
-            thread->join();
+            shutdown(descriptor, SHUT_RDWR);
         }
+        reactor.remove(descriptor);
+        closesocket(descriptor);
     }
 
     void setNoDelay(bool noDelay) override {
@@ -152,48 +320,85 @@ public:
         return opt != 0;
     }
 
-    void startListen() {
-        while (state == ConnectionState::CONNECTED) {
-            int size = recvsocket(descriptor, buffer.data(), buffer.size());
-            if (size == 0) {
-                logger.info() << "closed connection with " << to_string(addr);
-                closesocket(descriptor);
-                state = ConnectionState::CLOSED;
-                break;
-            } else if (size < 0) {
-                logger.warning() << "an error ocurred while receiving from "
-                            << to_string(addr);
-                auto error = handle_socket_error("recv(...) error");
-                closesocket(descriptor);
-                state = ConnectionState::CLOSED;
-                logger.error() << error.what();
-                break;
-            }
-            {
-                std::lock_guard lock(mutex);
-                for (size_t i = 0; i < size; i++) {
-                    readBatch.emplace_back(buffer[i]);
-                }
-                totalDownload += size;
-            }
+    void onReadable() override {
+        if (state != ConnectionState::CONNECTED) {
+            return;
+        }
+        std::unique_lock lock(mutex);
+        auto [dst, length] = readBatch.prepare(RECV_CHUNK_SIZE);
+        int size = recvsocket(descriptor, dst, length);
+        if (size > 0) {
+            readBatch.commit(size);
+            totalDownload += size;
+            counters.received(size);
+            return;
+        } else if (size == 0) {
+            lock.unlock();
+            logger.info() << "closed connection with " << to_string(addr);
+            closeReceiving();
+            return;
+        } else if (is_would_block()) {
+            return;
+        }
+        auto error = handle_socket_error("recv(...) error");
+        lock.unlock();
+        logger.warning() << "an error ocurred while receiving from "
+                    << to_string(addr);
+        closeReceiving();
+        logger.error() << error.what();
+    }
+
+    void onWritable() override {
+        if (state != ConnectionState::CONNECTING) {
+            return;
+        }
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (getsockopt(
+                descriptor, SOL_SOCKET, SO_ERROR, (char*)&error, &len
+            ) < 0) {
+            failConnect(handle_socket_error("Connect failed").what());
+        } else if (error) {
+            failConnect(
+                "Connect failed [error=" + std::to_string(error) + "]: " +
+                std::string(strerror(error))
+            );
+        } else {
+            finishConnect();
         }
     }
 
     void startClient() {
+        set_nonblocking(descriptor);
         state = ConnectionState::CONNECTED;
-        thread = std::make_unique<std::thread>([this]() { startListen();});
+        reactor.add(descriptor, SOCKET_READ, weak_from_this());
     }
 
     void connect(runnable callback, stringconsumer errorCallback) override {
-        thread = std::make_unique<std::thread>([this, callback, errorCallback]() {
-            connectSocket();
-            if (state == ConnectionState::CONNECTED) {
-                callback();
-                startListen();
-            } else {
-                errorCallback(errorMessage);
-            }
-        });
+        connectCallback = std::move(callback);
+        connectErrorCallback = std::move(errorCallback);
+
+        set_nonblocking(descriptor);
+        state = ConnectionState::CONNECTING;
+        logger.info() << "connecting to " << to_string(addr);
+        int res = connectsocket(
+            descriptor, (const sockaddr*)&addr, sizeof(sockaddr_in)
+        );
+        if (res < 0 && !is_would_block()) {
+            auto error = handle_socket_error("Connect failed");
+            state = ConnectionState::CLOSED;
+            errorMessage = error.what();
+            logger.error() << errorMessage;
+            // callbacks are always called from the I/O thread
+            reactor.post([errorCallback = connectErrorCallback, error]() {
+                if (errorCallback) {
+                    errorCallback(error.what());
+                }
+            });
+            return;
+        }
+        // completion (even immediate) is reported as writable socket
+        reactor.add(descriptor, SOCKET_WRITE, weak_from_this());
     }
 
     int recv(char* buffer, size_t length) override {
@@ -202,27 +407,126 @@ public:
         if (state != ConnectionState::CONNECTED && readBatch.empty()) {
             return -1;
         }
-        int size = std::min(readBatch.size(), length);
-        std::memcpy(buffer, readBatch.data(), size);
-        readBatch.erase(readBatch.begin(), readBatch.begin() + size);
-        return size;
+        return readBatch.read(buffer, length);
+    }
+
+    int peek(char* buffer, size_t length) override {
+        std::lock_guard lock(mutex);
+
+        if (state != ConnectionState::CONNECTED && readBatch.empty()) {
+            return -1;
+        }
+        return readBatch.peek(buffer, length);
+    }
+
+    int consume(size_t length) override {
+        std::lock_guard lock(mutex);
+        return readBatch.consume(length);
+    }
+
+    int sendNow(const char* buffer, size_t length) {
+        size_t sent = 0;
+        while (sent < length) {
+            int len = sendsocket(descriptor, buffer + sent, length - sent, 0);
+            if (len >= 0) {
+                sent += len;
+            } else if (!waitSend()) {
+                break;
+            }
+        }
+        totalUpload += sent;
+        counters.sent(sent);
+        return sent;
+    }
+
+    int sendvNow(const std::string_view* buffers, size_t count) {
+        std::vector<std::string_view> pending(buffers, buffers + count);
+        size_t index = 0;
+        size_t sent = 0;
+        while (index < pending.size()) {
+            int len = sendvsocket(
+                descriptor, pending.data() + index, pending.size() - index
+            );
+            if (len < 0) {
+                if (!waitSend()) {
+                    break;
+                }
+                continue;
+            }
+            sent += len;
+            // skip fully sent buffers
+            size_t left = len;
+            while (index < pending.size() && left >= pending[index].length()) {
+                left -= pending[index++].length();
+            }
+            if (index < pending.size()) {
+                pending[index].remove_prefix(left);
+            }
+        }
+        totalUpload += sent;
+        counters.sent(sent);
+        return sent;
+    }
+
+    void coalesce(const char* buffer, size_t length) {
+        writeBuffer.insert(writeBuffer.end(), buffer, buffer + length);
+        if (writeBuffer.size() >= COALESCE_FLUSH_SIZE) {
+            flush();
+        }
     }
 
     int send(const char* buffer, size_t length) override {
         if (state == ConnectionState::CLOSED) {
             return 0;
         }
-        int len = sendsocket(descriptor, buffer, length, 0);
-        if (len == -1) {
-            int err = errno;
-            close();
-            throw std::runtime_error(
-                "Send failed [errno=" + std::to_string(err) + "]: "
-                 + std::string(strerror(err))
-            );
+        if (coalescing) {
+            coalesce(buffer, length);
+            return length;
+        }
+        return sendNow(buffer, length);
+    }
+
+    int sendv(const std::string_view* buffers, size_t count) override {
+        if (state == ConnectionState::CLOSED) {
+            return 0;
+        }
+        if (coalescing) {
+            size_t length = 0;
+            for (size_t i = 0; i < count; i++) {
+                coalesce(buffers[i].data(), buffers[i].length());
+                length += buffers[i].length();
+            }
+            return length;
+        }
+        return sendvNow(buffers, count);
+    }
+
+    void setCoalescing(bool flag) override {
+        coalescing = flag;
+        if (!flag) {
+            flush();
+        }
+    }
+
+    bool isCoalescing() const override {
+        return coalescing;
+    }
+
+    void flush() override {
+        if (writeBuffer.empty()) {
+            return;
+        }
+        // moved out as failed send closes the connection flushing again
+        auto data = std::move(writeBuffer);
+        writeBuffer.clear();
+        if (state != ConnectionState::CONNECTED) {
+            return;
+        }
+        try {
+            sendNow(data.data(), data.size());
+        } catch (const std::runtime_error& err) {
+            logger.error() << "flush failed: " << err.what();
         }
-        totalUpload += len;
-        return len;
     }
 
     int available() override {
@@ -231,18 +535,18 @@ public:
     }
 
     void close(bool discardAll=false) override {
-        {
-            std::lock_guard lock(mutex);
-            readBatch.clear();
-
-            if (state != ConnectionState::CLOSED) {
-                shutdown(descriptor, SHUT_RDWR);
-                closesocket(descriptor);
-            }
+        if (discardAll) {
+            writeBuffer.clear();
+        } else if (state == ConnectionState::CONNECTED) {
+            flush();
         }
-        if (thread) {
-            thread->join();
-            thread = nullptr;
+        std::lock_guard lock(mutex);
+        readBatch.clear();
+
+        if (state != ConnectionState::CLOSED) {
+            state = ConnectionState::CLOSED;
+            shutdown(descriptor, SHUT_RDWR);
+            reactor.remove(descriptor);
         }
     }
 
@@ -253,11 +557,20 @@ public:
     }
 
     size_t pullDownload() override {
+        std::lock_guard lock(mutex);
         size_t size = totalDownload;
         totalDownload = 0;
         return size;
     }
 
+    ConnectionStats getStats() const override {
+        auto stats = counters.get();
+        if (state != ConnectionState::CLOSED) {
+            read_tcp_info(descriptor, stats);
+        }
+        return stats;
+    }
+
     int getPort() const override {
         return htons(addr.sin_port);
     }
@@ -267,6 +580,7 @@ public:
     }
 
     static std::shared_ptr<SocketTcpConnection> connect(
+        Reactor& reactor,
         const std::string& address,
         int port,
         runnable callback,
@@ -301,7 +615,9 @@ public:
             }
             throw std::runtime_error(errorMessage);
         }
-        auto socket = std::make_shared<SocketTcpConnection>(descriptor, std::move(serverAddress));
+        auto socket = std::make_shared<SocketTcpConnection>(
+            reactor, descriptor, std::move(serverAddress)
+        );
         socket->connect(std::move(callback), std::move(errorCallback));
         return socket;
     }
@@ -311,22 +627,34 @@ public:
     }
 };
 
-class SocketTcpServer : public TcpServer {
+class SocketTcpServer
+    : public TcpServer,
+      public SocketHandler,
+      public std::enable_shared_from_this<SocketTcpServer> {
     u64id_t id;
     Network* network;
+    Reactor& reactor;
     SOCKET descriptor;
     std::vector<u64id_t> clients;
     std::mutex clientsMutex;
-    bool open = true;
-    std::unique_ptr<std::thread> thread = nullptr;
+    std::atomic<bool> open = true;
+    ConnectCallback handler;
     int port;
     int maxConnected = -1;
 public:
-    SocketTcpServer(u64id_t id, Network* network, SOCKET descriptor, int port)
-    : id(id), network(network), descriptor(descriptor), port(port) {}
+    SocketTcpServer(
+        u64id_t id, Network* network, Reactor& reactor, SOCKET descriptor, int port
+    )
+        : id(id),
+          network(network),
+          reactor(reactor),
+          descriptor(descriptor),
+          port(port) {
+    }
 
     ~SocketTcpServer() {
         closeSocket();
+        closesocket(descriptor);
     }
 
     void setMaxClientsConnected(int count) override {
@@ -335,6 +663,7 @@ public:
 
     void update() override {
         std::vector<u64id_t> clients;
+        std::lock_guard lock(clientsMutex);
         for (u64id_t cid : this->clients) {
             if (auto client = network->getConnection(cid, true)) {
                 if (client->getState() != ConnectionState::CLOSED) {
@@ -345,62 +674,71 @@ public:
         std::swap(clients, this->clients);
     }
 
-    void startListen(ConnectCallback handler) override {
-        thread = std::make_unique<std::thread>([this, handler]() {
-            while (open) {
-                logger.info() << "listening for connections";
-                if (listen(descriptor, 2) < 0) {
-                    close();
-                    break;
-                }
-                socklen_t addrlen = sizeof(sockaddr_in);
-                SOCKET clientDescriptor;
-                sockaddr_in address;
-                logger.info() << "accepting clients";
-                if ((clientDescriptor = accept(descriptor, (sockaddr*)&address, &addrlen)) == -1) {
-                    close();
-                    break;
-                }
-                if (maxConnected >= 0 && clients.size() >= maxConnected) {
-                    logger.info() << "refused connection attempt from " << to_string(address);
-                    closesocket(clientDescriptor);
-                    continue;
-                }
-                logger.info() << "client connected: " << to_string(address);
-                auto socket = std::make_shared<SocketTcpConnection>(
-                    clientDescriptor, address
-                );
-                socket->startClient();
-                u64id_t id = network->addConnection(socket);
-                {
-                    std::lock_guard lock(clientsMutex);
-                    clients.push_back(id);
+    void onReadable() override {
+        while (open) {
+            socklen_t addrlen = sizeof(sockaddr_in);
+            sockaddr_in address;
+            SOCKET clientDescriptor =
+                accept(descriptor, (sockaddr*)&address, &addrlen);
+            if (clientDescriptor == -1) {
+                if (!is_would_block()) {
+                    logger.error() << handle_socket_error("accept failed").what();
                 }
-                handler(this->id, id);
+                break;
+            }
+            size_t clientsCount;
+            {
+                std::lock_guard lock(clientsMutex);
+                clientsCount = clients.size();
+            }
+            if (maxConnected >= 0 && clientsCount >= maxConnected) {
+                logger.info() << "refused connection attempt from " << to_string(address);
+                closesocket(clientDescriptor);
+                continue;
             }
-        });
+            logger.info() << "client connected: " << to_string(address);
+            auto socket = std::make_shared<SocketTcpConnection>(
+                reactor, clientDescriptor, address
+            );
+            socket->startClient();
+            u64id_t id = network->addConnection(socket);
+            {
+                std::lock_guard lock(clientsMutex);
+                clients.push_back(id);
+            }
+            handler(this->id, id);
+        }
+    }
+
+    void startListen(ConnectCallback handler) override {
+        this->handler = std::move(handler);
+        logger.info() << "listening for connections";
+        if (listen(descriptor, SOMAXCONN) < 0) {
+            throw handle_socket_error("listen failed");
+        }
+        set_nonblocking(descriptor);
+        reactor.add(descriptor, SOCKET_READ, weak_from_this());
     }
     
     void closeSocket() {
-        if (!open) {
+        if (!open.exchange(false)) {
             return;
         }
         logger.info() << "closing server";
-        open = false;
+        reactor.remove(descriptor);
 
+        std::vector<u64id_t> clients;
         {
             std::lock_guard lock(clientsMutex);
-            for (u64id_t clientid : clients) {
-                if (auto client = network->getConnection(clientid, true)) {
-                    client->close();
-                }
+            std::swap(clients, this->clients);
+        }
+        for (u64id_t clientid : clients) {
+            if (auto client = network->getConnection(clientid, true)) {
+                client->close();
             }
         }
-        clients.clear();
-
-        shutdown(descriptor, 2);
-        closesocket(descriptor);
-        thread->join();
+        // descriptor is closed by destructor as the handler may be running
+        shutdown(descriptor, SHUT_RDWR);
     }
 
     void close() override {
@@ -416,7 +754,11 @@ public:
     }
 
     static std::shared_ptr<SocketTcpServer> openServer(
-        u64id_t id, Network* network, int port, ConnectCallback handler
+        u64id_t id,
+        Network* network,
+        Reactor& reactor,
+        int port,
+        ConnectCallback handler
     ) {
         SOCKET descriptor = socket(
             AF_INET, SOCK_STREAM, 0
@@ -445,8 +787,9 @@ public:
         }
         port = ntohs(address.sin_port);
         logger.info() << "opened server at port " << port;
-        auto server =
-            std::make_shared<SocketTcpServer>(id, network, descriptor, port);
+        auto server = std::make_shared<SocketTcpServer>(
+            id, network, reactor, descriptor, port
+        );
         server->startListen(std::move(handler));
         return server;
     }
@@ -454,6 +797,12 @@ public:
 
 static sockaddr_in resolve_address_dgram(const std::string& address, int port) {
     sockaddr_in serverAddr{};
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_port = htons(port);
+    // replies are usually sent to addresses taken from received datagrams
+    if (inet_pton(AF_INET, address.c_str(), &serverAddr.sin_addr) == 1) {
+        return serverAddr;
+    }
     addrinfo hints {};
 
     hints.ai_family = AF_INET;
@@ -472,28 +821,42 @@ static sockaddr_in resolve_address_dgram(const std::string& address, int port) {
     return serverAddr;
 }
 
-class SocketUdpConnection : public UdpConnection {
+class SocketUdpConnection
+    : public UdpConnection,
+      public SocketHandler,
+      public std::enable_shared_from_this<SocketUdpConnection> {
     u64id_t id;
+    Reactor& reactor;
     SOCKET descriptor;
     sockaddr_in addr{};
-    bool open = true;
-    std::unique_ptr<std::thread> thread;
+    std::atomic<bool> open = true;
+    util::Buffer<char> buffer;
     ClientDatagramCallback callback;
 
-    size_t totalUpload = 0;
-    size_t totalDownload = 0;
-    ConnectionState state = ConnectionState::INITIAL;
+    std::atomic<size_t> totalUpload = 0;
+    std::atomic<size_t> totalDownload = 0;
+    TrafficCounters counters;
+    std::atomic<ConnectionState> state = ConnectionState::INITIAL;
 
 public:
-    SocketUdpConnection(u64id_t id, SOCKET descriptor, sockaddr_in addr)
-        : id(id), descriptor(descriptor), addr(std::move(addr)) {}
+    SocketUdpConnection(
+        u64id_t id, Reactor& reactor, SOCKET descriptor, sockaddr_in addr
+    )
+        : id(id),
+          reactor(reactor),
+          descriptor(descriptor),
+          addr(std::move(addr)),
+          buffer(16'384) {
+    }
 
     ~SocketUdpConnection() override {
         SocketUdpConnection::close();
+        closesocket(descriptor);
     }
 
     static std::shared_ptr<SocketUdpConnection> connect(
         u64id_t id,
+        Reactor& reactor,
         const std::string& address,
         int port,
         ClientDatagramCallback handler,
@@ -511,8 +874,11 @@ public:
             closesocket(descriptor);
             throw err;
         }
+        set_nonblocking(descriptor);
 
-        auto socket = std::make_shared<SocketUdpConnection>(id, descriptor, serverAddr);
+        auto socket = std::make_shared<SocketUdpConnection>(
+            id, reactor, descriptor, serverAddr
+        );
         socket->connect(std::move(handler));
 
         callback();
@@ -520,69 +886,74 @@ public:
         return socket;
     }
 
+    void onReadable() override {
+        while (open) {
+            int size = ::recv(descriptor, buffer.data(), buffer.size(), 0);
+            if (size < 0 && is_would_block()) {
+                return;
+            }
+            if (size <= 0) {
+                logger.error() << "udp connection " << id
+                               << handle_socket_error(" recv error").what();
+                state = ConnectionState::CLOSED;
+                reactor.remove(descriptor);
+                return;
+            }
+            totalDownload += size;
+            counters.received(size);
+            if (callback) {
+                callback(id, buffer.data(), size);
+            }
+        }
+    }
+
     void connect(ClientDatagramCallback handler) override {
         callback = std::move(handler);
         state = ConnectionState::CONNECTED;
-
-        thread = std::make_unique<std::thread>([this]() {
-            util::Buffer<char> buffer(16'384);
-            while (open) {
-                int size = recv(descriptor, buffer.data(), buffer.size(), 0);
-                if (size <= 0) {
-                    logger.error() << "udp connection " << id
-                                   << handle_socket_error(" recv error").what();
-                    if (!open) break;
-                    closesocket(descriptor);
-                    state = ConnectionState::CLOSED;
-                    break;
-                }
-                totalDownload += size;
-                if (callback) {
-                    callback(id, buffer.data(), size);
-                }
-            }
-        });
+        reactor.add(descriptor, SOCKET_READ, weak_from_this());
     }
 
     int send(const char* buffer, size_t length) override {
         int len = ::send(descriptor, buffer, length, 0);
+        if (len < 0 && is_would_block()) {
+            wait_writable(descriptor, SEND_WAIT_TIMEOUT);
+            len = ::send(descriptor, buffer, length, 0);
+        }
         if (len < 0) {
             auto err = handle_socket_error(" send failed");
-            closesocket(descriptor);
+            counters.drops++;
             state = ConnectionState::CLOSED;
+            reactor.remove(descriptor);
             logger.error() << "udp connection " << id << err.what();
-        } else totalUpload += len;
+        } else {
+            totalUpload += len;
+            counters.sent(len);
+        }
 
         return len;
     }
 
     void close(bool discardAll=false) override {
-        if (!open) return;
-        open = false;
+        if (!open.exchange(false)) return;
         logger.info() << "closing udp connection "<< id;
 
         if (state != ConnectionState::CLOSED) {
-            shutdown(descriptor, 2);
-            closesocket(descriptor);
-        }
-
-        if (thread) {
-            thread->join();
-            thread.reset();
+            shutdown(descriptor, SHUT_RDWR);
         }
+        reactor.remove(descriptor);
         state = ConnectionState::CLOSED;
     }
 
     size_t pullUpload() override {
-        size_t s = totalUpload;
-        totalUpload = 0;
-        return s;
+        return totalUpload.exchange(0);
     }
 
     size_t pullDownload() override {
-        size_t s = totalDownload;
-        totalDownload = 0;
-        return s;
+        return totalDownload.exchange(0);
+    }
+
+    ConnectionStats getStats() const override {
+        return counters.get();
     }
 
     [[nodiscard]] int getPort() const override {
@@ -598,72 +969,224 @@ public:
     }
 };
 
-class SocketUdpServer : public UdpServer {
+/// @brief Max number of datagrams received or sent by a single syscall
+inline constexpr size_t UDP_BATCH_SIZE = 32;
+/// @brief Max size of a received datagram (larger ones are truncated)
+inline constexpr size_t MAX_DATAGRAM_SIZE = 16'384;
+
+class SocketUdpServer
+    : public UdpServer,
+      public SocketHandler,
+      public std::enable_shared_from_this<SocketUdpServer> {
+    struct OutgoingDatagram {
+        sockaddr_in addr;
+        std::vector<char> data;
+    };
+
     u64id_t id;
+    Reactor& reactor;
     SOCKET descriptor;
-    bool open = true;
-    std::unique_ptr<std::thread> thread = nullptr;
+    std::atomic<bool> open = true;
+    /// @brief UDP_BATCH_SIZE receive slots of MAX_DATAGRAM_SIZE bytes
+    util::Buffer<char> buffer;
     int port;
     ServerDatagramCallback callback;
+    TrafficCounters counters;
+    /// @brief Datagrams dropped by the kernel due to receive buffer overflow
+    std::atomic<size_t> overflowDrops = 0;
+
+    std::mutex outgoingMutex;
+    /// @brief Datagrams queued by sendTo until update
+    std::vector<OutgoingDatagram> outgoing;
+    /// @brief Sent datagrams kept to reuse allocations
+    std::vector<OutgoingDatagram> spare;
+
+    void handleDatagram(const sockaddr_in& clientAddr, const char* data, size_t size) {
+        counters.received(size);
+        std::string addrStr = to_string(clientAddr, false);
+        int port = ntohs(clientAddr.sin_port);
+        callback(id, addrStr, port, data, size);
+    }
+
+    /// @brief Send queued datagrams
+    void flush() {
+        std::lock_guard lock(outgoingMutex);
+        size_t sent = 0;
+        while (sent < outgoing.size()) {
+            size_t count = sendBatch(outgoing.data() + sent, outgoing.size() - sent);
+            if (count == 0) {
+                // send buffer is full or the socket failed, drop the rest
+                size_t dropped = outgoing.size() - sent;
+                counters.drops += dropped;
+                logger.error() << handle_socket_error("sendto").what() << " ("
+                               << dropped << " datagram(s) dropped)";
+                break;
+            }
+            size_t bytes = 0;
+            for (size_t i = 0; i < count; i++) {
+                bytes += outgoing[sent + i].data.size();
+            }
+            counters.sent(bytes, count);
+            sent += count;
+        }
+        for (auto& datagram : outgoing) {
+            spare.push_back(std::move(datagram));
+        }
+        outgoing.clear();
+    }
 
+    /// @return number of datagrams sent
+    size_t sendBatch(const OutgoingDatagram* datagrams, size_t count) {
+#ifdef __linux__
+        count = std::min(count, UDP_BATCH_SIZE);
+        mmsghdr messages[UDP_BATCH_SIZE] {};
+        iovec iov[UDP_BATCH_SIZE];
+        for (size_t i = 0; i < count; i++) {
+            iov[i].iov_base = const_cast<char*>(datagrams[i].data.data());
+            iov[i].iov_len = datagrams[i].data.size();
+            auto& header = messages[i].msg_hdr;
+            header.msg_name = const_cast<sockaddr_in*>(&datagrams[i].addr);
+            header.msg_namelen = sizeof(sockaddr_in);
+            header.msg_iov = &iov[i];
+            header.msg_iovlen = 1;
+        }
+        int sent = sendmmsg(descriptor, messages, count, 0);
+        return sent < 0 ? 0 : sent;
+#else
+        const auto& datagram = datagrams[0];
+        if (sendto(descriptor, datagram.data.data(), datagram.data.size(), 0,
+               reinterpret_cast<const sockaddr*>(&datagram.addr),
+               sizeof(datagram.addr)) < 0) {
+            return 0;
+        }
+        return 1;
+#endif
+    }
 public:
-    SocketUdpServer(u64id_t id, Network* network, SOCKET descriptor, int port)
-        : id(id), descriptor(descriptor), port(port) {}
+    SocketUdpServer(u64id_t id, Reactor& reactor, SOCKET descriptor, int port)
+        : id(id),
+          reactor(reactor),
+          descriptor(descriptor),
+#ifdef __linux__
+          buffer(UDP_BATCH_SIZE * MAX_DATAGRAM_SIZE),
+#else
+          buffer(MAX_DATAGRAM_SIZE),
+#endif
+          port(port) {
+    }
 
     ~SocketUdpServer() override {
         SocketUdpServer::close();
+        closesocket(descriptor);
     }
 
-    void update() override {}
-
-    void startListen(ServerDatagramCallback handler) override {
-        callback = std::move(handler);
-
-        thread = std::make_unique<std::thread>([this]() {
-            util::Buffer<char> buffer(16384);
-            sockaddr_in clientAddr{};
-            socklen_t addrlen = sizeof(clientAddr);
+    void update() override {
+        flush();
+    }
 
-            while (open) {
-                int size = recvfrom(descriptor, buffer.data(), buffer.size(), 0,
-                                    reinterpret_cast<sockaddr*>(&clientAddr), &addrlen);
-                if (size <= 0) {
-                    if (!open) break;
-                    continue;
+    void onReadable() override {
+#ifdef __linux__
+        mmsghdr messages[UDP_BATCH_SIZE] {};
+        iovec iov[UDP_BATCH_SIZE];
+        sockaddr_in addresses[UDP_BATCH_SIZE];
+        // SO_RXQ_OVFL drops counter
+        alignas(cmsghdr) char control[UDP_BATCH_SIZE][CMSG_SPACE(sizeof(uint32_t))];
+        while (open) {
+            for (size_t i = 0; i < UDP_BATCH_SIZE; i++) {
+                iov[i].iov_base = buffer.data() + i * MAX_DATAGRAM_SIZE;
+                iov[i].iov_len = MAX_DATAGRAM_SIZE;
+                auto& header = messages[i].msg_hdr;
+                header.msg_name = &addresses[i];
+                header.msg_namelen = sizeof(sockaddr_in);
+                header.msg_iov = &iov[i];
+                header.msg_iovlen = 1;
+                header.msg_control = control[i];
+                header.msg_controllen = sizeof(control[i]);
+            }
+            int count = recvmmsg(descriptor, messages, UDP_BATCH_SIZE, 0, nullptr);
+            if (count <= 0) {
+                // errors (like ICMP port unreachable) are ignored
+                return;
+            }
+            for (int i = 0; i < count; i++) {
+                auto& header = messages[i].msg_hdr;
+                if (header.msg_flags & MSG_TRUNC) {
+                    counters.drops++;
                 }
-
-                std::string addrStr = to_string(clientAddr, false);
-                int port = ntohs(clientAddr.sin_port);
-
-                callback(id, addrStr, port, buffer.data(), size);
+                for (auto cmsg = CMSG_FIRSTHDR(&header); cmsg;
+                     cmsg = CMSG_NXTHDR(&header, cmsg)) {
+                    if (cmsg->cmsg_level == SOL_SOCKET &&
+                        cmsg->cmsg_type == SO_RXQ_OVFL) {
+                        uint32_t drops;
+                        std::memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+                        overflowDrops = drops;
+                    }
+                }
+                handleDatagram(
+                    addresses[i],
+                    buffer.data() + i * MAX_DATAGRAM_SIZE,
+                    messages[i].msg_len
+                );
             }
-        });
+            if (count < static_cast<int>(UDP_BATCH_SIZE)) {
+                return;
+            }
+        }
+#else
+        sockaddr_in clientAddr{};
+        while (open) {
+            socklen_t addrlen = sizeof(clientAddr);
+            int size = recvfrom(descriptor, buffer.data(), buffer.size(), 0,
+                                reinterpret_cast<sockaddr*>(&clientAddr), &addrlen);
+            if (size <= 0) {
+                // errors (like ICMP port unreachable) are ignored
+                return;
+            }
+            handleDatagram(clientAddr, buffer.data(), size);
+        }
+#endif
+    }
+
+    void startListen(ServerDatagramCallback handler) override {
+        callback = std::move(handler);
+        set_nonblocking(descriptor);
+        reactor.add(descriptor, SOCKET_READ, weak_from_this());
     }
 
     void sendTo(const std::string& addr, int port, const char* buffer, size_t length) override {
         sockaddr_in client = resolve_address_dgram(addr, port);
-        if (sendto(descriptor, buffer, length, 0,
-               reinterpret_cast<sockaddr*>(&client), sizeof(client)) < 0) {
-            logger.error() << handle_socket_error("sendto").what();
+        std::lock_guard lock(outgoingMutex);
+        OutgoingDatagram datagram;
+        if (!spare.empty()) {
+            datagram = std::move(spare.back());
+            spare.pop_back();
         }
+        datagram.addr = client;
+        datagram.data.assign(buffer, buffer + length);
+        outgoing.push_back(std::move(datagram));
     }
 
     void close() override {
-        if (!open) return;
-        open = false;
-        shutdown(descriptor, 2);
-        closesocket(descriptor);
-        if (thread) {
-            thread->join();
-            thread = nullptr;
-        }
+        if (!open.exchange(false)) return;
+        flush();
+        reactor.remove(descriptor);
+        shutdown(descriptor, SHUT_RDWR);
     }
 
     bool isOpen() override { return open; }
     int getPort() const override { return port; }
 
+    ConnectionStats getStats() const override {
+        auto stats = counters.get();
+        stats.drops += overflowDrops.load(std::memory_order_relaxed);
+        return stats;
+    }
+
     static std::shared_ptr<SocketUdpServer> openServer(
-        u64id_t id, Network* network, int port, const ServerDatagramCallback& handler
+        u64id_t id,
+        Reactor& reactor,
+        int port,
+        const ServerDatagramCallback& handler
     ) {
         SOCKET descriptor = socket(AF_INET, SOCK_DGRAM, 0);
         if (descriptor == -1) throw std::runtime_error("could not create udp socket");
@@ -677,8 +1200,14 @@ public:
             closesocket(descriptor);
             throw std::runtime_error("could not bind udp port " + std::to_string(port));
         }
+#ifdef __linux__
+        int enable = 1;
+        setsockopt(descriptor, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable));
+#endif
 
-        auto server = std::make_shared<SocketUdpServer>(id, network, descriptor, port);
+        auto server = std::make_shared<SocketUdpServer>(
+            id, reactor, descriptor, port
+        );
         server->startListen(std::move(handler));
         return server;
     }
@@ -686,41 +1215,49 @@ public:
 
 namespace network {
     std::shared_ptr<TcpConnection> connect_tcp(
+        Reactor& reactor,
         const std::string& address,
         int port,
         runnable callback,
         stringconsumer errorCallback
     ) {
         return SocketTcpConnection::connect(
-            address, port, std::move(callback), std::move(errorCallback)
+            reactor, address, port, std::move(callback), std::move(errorCallback)
         );
     }
 
     std::shared_ptr<TcpServer> open_tcp_server(
-        u64id_t id, Network* network, int port, ConnectCallback handler
+        u64id_t id,
+        Network* network,
+        Reactor& reactor,
+        int port,
+        ConnectCallback handler
     ) {
-        return SocketTcpServer::openServer(id, network, port, std::move(handler));
+        return SocketTcpServer::openServer(
+            id, network, reactor, port, std::move(handler)
+        );
     }
 
     std::shared_ptr<UdpConnection> connect_udp(
         u64id_t id,
+        Reactor& reactor,
         const std::string& address,
         int port,
         ClientDatagramCallback handler,
         runnable callback
     ) {
         return SocketUdpConnection::connect(
-            id, address, port, std::move(handler), std::move(callback)
+            id, reactor, address, port, std::move(handler), std::move(callback)
         );
     }
 
     std::shared_ptr<UdpServer> open_udp_server(
         u64id_t id,
-        Network* network,
+        Reactor& reactor,
         int port,
         const ServerDatagramCallback& handler
     ) {
-        return SocketUdpServer::openServer(id, network, port, handler);
+        return SocketUdpServer::openServer(id, reactor, port, handler);
     }
 
     int find_free_port() {
@@ -8,6 +8,7 @@
 #include <memory>
 #include <vector>
 #include <mutex>
+#include <string_view>
 
 namespace network {
     using OnResponse = std::function<void(std::vector<char>)>;
@@ -44,6 +45,23 @@ namespace network {
         virtual void update() = 0;
     };
 
+    /// @brief Connection or UDP server traffic counters since it was opened
+    struct ConnectionStats {
+        size_t bytesSent = 0;
+        size_t bytesReceived = 0;
+        /// @brief Number of sent datagrams or TCP send calls
+        size_t packetsSent = 0;
+        /// @brief Number of received datagrams or TCP receive calls
+        size_t packetsReceived = 0;
+        /// @brief Bytes in the socket send queue not sent or acknowledged yet
+        size_t sendQueue = 0;
+        /// @brief Smoothed TCP round-trip time estimate in microseconds
+        /// (0 - unknown)
+        uint rtt = 0;
+        /// @brief Dropped or truncated datagrams (UDP)
+        size_t drops = 0;
+    };
+
     enum class ConnectionState {
         INITIAL, CONNECTING, CONNECTED, CLOSED
     };
@@ -60,9 +78,21 @@ namespace network {
 
         virtual int send(const char* buffer, size_t length) = 0;
 
+        /// @brief Send multiple buffers as a single gather write
+        /// @return number of sent bytes
+        virtual int sendv(const std::string_view* buffers, size_t count) {
+            int sent = 0;
+            for (size_t i = 0; i < count; i++) {
+                sent += send(buffers[i].data(), buffers[i].length());
+            }
+            return sent;
+        }
+
         virtual size_t pullUpload() = 0;
         virtual size_t pullDownload() = 0;
 
+        [[nodiscard]] virtual ConnectionStats getStats() const = 0;
+
         bool isPrivate() const { return isprivate; }
         void setPrivate(bool flag) {isprivate = flag;}
 
@@ -80,6 +110,15 @@ namespace network {
     public:
         virtual int recv(char* buffer, size_t length) = 0;
         virtual int available() = 0;
+
+        /// @brief Copy up to length received bytes without consuming them
+        /// @return number of copied bytes or -1 if connection is closed
+        /// and no data left
+        virtual int peek(char* buffer, size_t length) = 0;
+
+        /// @brief Drop up to length received bytes
+        /// @return number of dropped bytes
+        virtual int consume(size_t length) = 0;
     };
 
     class Server {
@@ -9,6 +9,8 @@
 #include "content/Content.hpp"
 #include "data/dv_util.hpp"
 #include "debug/Logger.hpp"
+#include "debug/Memory.hpp"
+#include "debug/Profiler.hpp"
 #include "engine/Engine.hpp"
 #include "graphics/core/DrawContext.hpp"
 #include "graphics/core/LineBatch.hpp"
@@ -17,35 +19,109 @@
 #include "logic/scripting/scripting.hpp"
 #include "maths/FrustumCulling.hpp"
 #include "maths/rays.hpp"
+#include "coders/binary_json.hpp"
 #include "EntityDef.hpp"
 #include "Entity.hpp"
 #include "rigging.hpp"
 #include "physics/PhysicsSolver.hpp"
+#include "util/ThreadPool.hpp"
+#include "constants.hpp"
 #include "world/Level.hpp"
+#include "world/SimulationArea.hpp"
 
 static debug::Logger logger("entities");
 
+/// @brief Min number of bodies per physics job
+inline constexpr size_t PHYSICS_JOB_MIN_BODIES = 32;
+inline constexpr size_t POSE_JOB_MIN_SKELETONS = 64;
+
+static void step_bodies(
+    PhysicsSolver& solver, const GlobalChunks& chunks, const PhysicsJob& job
+) {
+    for (size_t i = 0; i < job.count; i++) {
+        const auto& task = job.tasks[i];
+        solver.step(chunks, *task.hitbox, task.delta, task.substeps);
+    }
+}
+
+class PhysicsWorker : public util::Worker<PhysicsJob, size_t> {
+    PhysicsSolver& solver;
+    const GlobalChunks& chunks;
+public:
+    PhysicsWorker(PhysicsSolver& solver, const GlobalChunks& chunks)
+        : solver(solver), chunks(chunks) {
+    }
+
+    size_t operator()(const PhysicsJob& job) override {
+        step_bodies(solver, chunks, job);
+        return job.count;
+    }
+};
+
+static void update_poses(const PoseJob& job) {
+    for (size_t i = 0; i < job.count; i++) {
+        const auto& task = job.tasks[i];
+        const auto& transform = *task.transform;
+        task.skeleton->config->update(
+            *task.skeleton, transform.rot, transform.pos, transform.size
+        );
+    }
+}
+
+class PoseWorker : public util::Worker<PoseJob, size_t> {
+public:
+    size_t operator()(const PoseJob& job) override {
+        update_poses(job);
+        return job.count;
+    }
+};
+
 Entities::Entities(Level& level)
     : registry(std::make_unique<entt::registry>()),
       level(level),
+      lookupEntity(entt::null),
       sensorsTickClock(20, 3),
-      updateTickClock(20, 3) {
+      updateTickClock(20, 3),
+      grid(CHUNK_W) {
+    memorySource = debug::memory::add_source(
+        debug::MemoryTag::ENTITIES, [this]() { return getMemoryUsage(); }
+    );
 }
 
 Entities::~Entities() = default;
 
+template <typename T>
+static size_t storage_memory(entt::registry& registry) {
+    return registry.storage<T>().capacity() * (sizeof(T) + sizeof(entt::entity));
+}
+
+size_t Entities::getMemoryUsage() const {
+    return storage_memory<EntityId>(*registry) +
+           storage_memory<Transform>(*registry) +
+           storage_memory<Rigidbody>(*registry) +
+           storage_memory<ScriptComponents>(*registry) +
+           storage_memory<rigging::Skeleton>(*registry) +
+           entities.size() * sizeof(entt::entity);
+}
+
 void Entities::setAssets(Assets& assets) {
     this->assets = &assets;
 }
 
 std::optional<Entity> Entities::get(entityid_t id) {
-    const auto& found = entities.find(id);
-    if (found != entities.end() && registry->valid(found->second)) {
-        return Entity(*this, id, *registry, found->second);
+    if (id == lookupId && registry->valid(lookupEntity)) {
+        return Entity(*this, id, *registry, lookupEntity);
+    }
+    auto found = entities.find(id);
+    if (found && registry->valid(*found)) {
+        lookupId = id;
+        lookupEntity = *found;
+        return Entity(*this, id, *registry, *found);
     }
     return std::nullopt;
 }
 
+
 entityid_t Entities::spawn(
     const EntityDef& def,
     glm::vec3 position,
@@ -76,8 +152,7 @@ entityid_t Entities::spawn(
         }
     }
     auto entity = registry->create();
-    entities[id] = entity;
-    uids[entity] = id;
+    entities.set(id, entity);
 
     registry->emplace<EntityId>(entity, static_cast<entityid_t>(id), def);
     const auto& tsf = registry->emplace<Transform>(
@@ -113,6 +188,7 @@ entityid_t Entities::spawn(
         loadEntity(saved, get(id).value());
     }
     body.hitbox.position = tsf.pos;
+    insertToGrid(entity, tsf, body);
     scripting::on_entity_spawn(
         def, id, scripting.components, args, componentsMap
     );
@@ -164,14 +240,20 @@ std::optional<Entities::RaycastResult> Entities::rayCast(
     glm::vec3 start, glm::vec3 dir, float maxDistance, entityid_t ignore
 ) {
     Ray ray(start, dir);
-    auto view = registry->view<EntityId, Transform, Rigidbody>();
 
     entityid_t foundUID = 0;
     glm::ivec3 foundNormal;
 
-    for (auto [entity, eid, transform, body] : view.each()) {
+    AABB area(start, start + dir * maxDistance);
+    area.fix();
+    grid.query(area, [&](entt::entity entity) {
+        if (!registry->valid(entity)) {
+            return;
+        }
+        const auto& eid = registry->get<EntityId>(entity);
+        const auto& body = registry->get<Rigidbody>(entity);
         if (eid.uid == ignore || !body.enabled) {
-            continue;
+            return;
         }
         auto& hitbox = body.hitbox;
         glm::ivec3 normal;
@@ -183,7 +265,7 @@ std::optional<Entities::RaycastResult> Entities::rayCast(
             foundNormal = normal;
             maxDistance = static_cast<float>(distance);
         }
-    }
+    });
     if (foundUID) {
         return Entities::RaycastResult {foundUID, foundNormal, maxDistance};
     } else {
@@ -203,6 +285,103 @@ void Entities::loadEntities(dv::value root) {
     }
 }
 
+void Entities::addPending(
+    int chunkX, int chunkZ, std::shared_ptr<entities_index::Index> index
+) {
+    PendingEntities entities {std::move(index), {}};
+    size_t count = entities.index->getHeaders().size();
+    if (count == 0) {
+        return;
+    }
+    entities.entries.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        entities.entries[i] = i;
+    }
+    pending[{chunkX, chunkZ}] = std::move(entities);
+}
+
+void Entities::writePending(
+    int chunkX, int chunkZ, entities_index::Builder& builder
+) const {
+    const auto& found = pending.find({chunkX, chunkZ});
+    if (found == pending.end()) {
+        return;
+    }
+    auto& index = *found->second.index;
+    for (size_t entry : found->second.entries) {
+        builder.add(index, entry);
+    }
+}
+
+void Entities::dropPending(int chunkX, int chunkZ) {
+    pending.erase({chunkX, chunkZ});
+}
+
+size_t Entities::getPendingCount() const {
+    size_t count = 0;
+    for (const auto& [_, entities] : pending) {
+        count += entities.entries.size();
+    }
+    return count;
+}
+
+void Entities::spawnPending() {
+    if (pending.empty()) {
+        return;
+    }
+    VC_PROFILE_ZONE("Entities::spawnPending");
+    const auto& simulation = *level.simulation;
+    int maxDistance = simulation.getSettings().reducedDistance;
+    // spawn callbacks may load chunks, so entries are collected first
+    std::vector<std::pair<std::shared_ptr<entities_index::Index>, size_t>>
+        spawnList;
+    for (auto it = pending.begin(); it != pending.end();) {
+        // saved entities may slightly stick out of the chunk
+        if (simulation.getDistance(it->first.x, it->first.y) >
+            maxDistance + 1) {
+            ++it;
+            continue;
+        }
+        auto& entities = it->second;
+        const auto& headers = entities.index->getHeaders();
+        auto& entries = entities.entries;
+        for (size_t i = 0; i < entries.size();) {
+            const auto& position = headers[entries[i]].position;
+            if (simulation.getTier(position) != SimulationTier::FROZEN) {
+                spawnList.emplace_back(entities.index, entries[i]);
+                entries[i] = entries.back();
+                entries.pop_back();
+            } else {
+                i++;
+            }
+        }
+        if (entries.empty()) {
+            it = pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto& [index, entry] : spawnList) {
+        try {
+            loadEntity(index->decode(entry));
+        } catch (const std::runtime_error& err) {
+            logger.error() << "could not read entity: " << err.what();
+        }
+    }
+}
+
+void Entities::updateTiers() {
+    const auto& simulation = *level.simulation;
+    auto view = registry->view<EntityId, Transform>();
+    for (auto [entity, eid, transform] : view.each()) {
+        int divider = simulation.getRateDivider(simulation.getTier(transform.pos));
+        if (divider != eid.rateDivider) {
+            eid.rateDivider = divider;
+            scripting::on_entity_rate_change(eid.uid, divider);
+        }
+    }
+}
+
 void Entities::onSave(const Entity& entity) {
     scripting::on_entity_save(entity);
 }
@@ -222,6 +401,28 @@ dv::value Entities::serialize(const std::vector<Entity>& entities) {
     return list;
 }
 
+void Entities::serialize(
+    const std::vector<Entity>& entities, entities_index::Builder& builder
+) {
+    for (auto& entity : entities) {
+        const EntityId& eid = entity.getID();
+        if (!entity.getDef().save.enabled || eid.destroyFlag) {
+            continue;
+        }
+        onSave(entity);
+        if (!eid.destroyFlag) {
+            auto document = json::to_binary(entity.serialize());
+            builder.add(
+                eid.uid,
+                eid.def.name,
+                entity.getTransform().pos,
+                document.data(),
+                document.size()
+            );
+        }
+    }
+}
+
 void Entities::despawn(std::vector<Entity> entities) {
     for (auto& entity : entities) {
         entity.destroy();
@@ -229,19 +430,77 @@ void Entities::despawn(std::vector<Entity> entities) {
 }
 
 void Entities::clean() {
-    for (auto it = entities.begin(); it != entities.end();) {
-        if (!registry->get<EntityId>(it->second).destroyFlag) {
-            ++it;
-        } else {
-            auto& rigidbody = registry->get<Rigidbody>(it->second);
-            // todo: refactor
-            auto physics = level.physics.get();
-            for (auto& sensor : rigidbody.sensors) {
-                physics->removeSensor(&sensor);
+    // erase moves the last entity to the erased place, so iterating from
+    // the end visits every entity once
+    for (size_t i = entities.size(); i-- > 0;) {
+        auto entity = entities.valueAt(i);
+        if (!registry->get<EntityId>(entity).destroyFlag) {
+            continue;
+        }
+        auto& rigidbody = registry->get<Rigidbody>(entity);
+        // todo: refactor
+        auto physics = level.physics.get();
+        for (auto& sensor : rigidbody.sensors) {
+            physics->removeSensor(&sensor);
+        }
+        registry->destroy(entity);
+        entities.erase(entities.idAt(i));
+    }
+}
+
+void Entities::insertToGrid(
+    entt::entity entity, const Transform& tsf, const Rigidbody& body
+) {
+    const auto& hitbox = body.hitbox;
+    glm::vec3 extent =
+        glm::abs(hitbox.position - tsf.pos) + hitbox.getHalfSize();
+    grid.insert(
+        entity, tsf.pos, glm::max(extent.x, glm::max(extent.y, extent.z))
+    );
+}
+
+void Entities::rebuildGrid() {
+    grid.clear();
+    auto view = registry->view<Transform, Rigidbody>();
+    for (auto [entity, transform, rigidbody] : view.each()) {
+        insertToGrid(entity, transform, rigidbody);
+    }
+}
+
+void Entities::checkSensors() {
+    VC_PROFILE_ZONE("Entities::checkSensors");
+    auto physics = level.physics.get();
+    // callbacks may spawn entities, so candidates are collected first
+    std::vector<entt::entity> candidates;
+    for (auto sensor : physics->getSensors()) {
+        AABB area;
+        switch (sensor->type) {
+            case SensorType::AABB:
+                area = sensor->calculated.aabb;
+                break;
+            case SensorType::RADIUS: {
+                glm::vec3 center(sensor->calculated.radial);
+                float radius = glm::sqrt(sensor->calculated.radial.w);
+                area = AABB(center - radius, center + radius);
+                break;
+            }
+        }
+        candidates.clear();
+        grid.query(area, [&candidates](entt::entity entity) {
+            candidates.push_back(entity);
+        });
+        for (auto entity : candidates) {
+            if (!registry->valid(entity)) {
+                continue;
+            }
+            const auto& eid = registry->get<EntityId>(entity);
+            auto& body = registry->get<Rigidbody>(entity);
+            if (!body.enabled || body.hitbox.type == BodyType::STATIC) {
+                continue;
+            }
+            if (physics->checkSensor(*sensor, body.hitbox, eid.uid)) {
+                body.hitbox.wake();
             }
-            uids.erase(it->second);
-            registry->destroy(it->second);
-            it = entities.erase(it);
         }
     }
 }
@@ -298,23 +557,102 @@ void Entities::preparePhysics(float delta) {
     }
 }
 
+void Entities::stepBodies() {
+    auto& physics = *level.physics;
+    const auto& chunks = *level.chunks;
+
+    size_t count = physicsTasks.size();
+    if (physicsPool == nullptr && count >= PHYSICS_JOB_MIN_BODIES * 2) {
+        physicsPool = std::make_unique<util::ThreadPool<PhysicsJob, size_t>>(
+            "physics",
+            [&physics, &chunks]() {
+                return std::make_unique<PhysicsWorker>(physics, chunks);
+            },
+            [this](size_t&&) { physicsJobsDone++; },
+            util::ThreadPool<PhysicsJob, size_t>::QUARTER
+        );
+        physicsPool->setStandaloneResults(true);
+    }
+    size_t jobsCount = 1;
+    if (physicsPool) {
+        jobsCount = std::min(
+            static_cast<size_t>(physicsPool->getWorkersCount()) + 1,
+            count / PHYSICS_JOB_MIN_BODIES
+        );
+    }
+    if (jobsCount <= 1) {
+        step_bodies(physics, chunks, {physicsTasks.data(), count});
+        return;
+    }
+    size_t jobSize = (count + jobsCount - 1) / jobsCount;
+    physicsJobsDone = 0;
+    size_t enqueued = 0;
+    // the last range is processed by the current thread
+    for (size_t offset = jobSize; offset < count; offset += jobSize) {
+        physicsPool->enqueueJob(PhysicsJob {
+            physicsTasks.data() + offset,
+            std::min(jobSize, count - offset)});
+        enqueued++;
+    }
+    step_bodies(physics, chunks, {physicsTasks.data(), jobSize});
+    while (physicsJobsDone < enqueued) {
+        if (physicsPool->pullResults() == 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
 void Entities::updatePhysics(float delta) {
+    VC_PROFILE_ZONE("Entities::updatePhysics");
     preparePhysics(delta);
 
+    physicsTasks.clear();
+    physicsTick++;
     auto view = registry->view<EntityId, Transform, Rigidbody>();
-    auto physics = level.physics.get();
     for (auto [entity, eid, transform, rigidbody] : view.each()) {
         if (!rigidbody.enabled || rigidbody.hitbox.type == BodyType::STATIC) {
             continue;
         }
+        // reduced tier bodies are stepped once per rateDivider updates
+        int divider = eid.rateDivider;
+        if (divider == 0 || (physicsTick + eid.uid) % divider != 0) {
+            continue;
+        }
+        float bodyDelta = delta * divider;
         auto& hitbox = rigidbody.hitbox;
-        auto prevVel = hitbox.velocity;
-        bool grounded = hitbox.grounded;
-
-        float vel = glm::length(prevVel);
-        int substeps = static_cast<int>(delta * vel * 20);
+        if (hitbox.sleeping) {
+            // woken up by an impulse
+            if (glm::length2(hitbox.velocity) <
+                PhysicsSolver::SLEEP_VELOCITY * PhysicsSolver::SLEEP_VELOCITY) {
+                continue;
+            }
+            hitbox.wake();
+        }
+        float vel = glm::length(hitbox.velocity);
+        int substeps = static_cast<int>(bodyDelta * vel * 20);
         substeps = std::min(100, std::max(2, substeps));
-        physics->step(*level.chunks, hitbox, delta, substeps, eid.uid);
+        physicsTasks.push_back(PhysicsTask {
+            entity,
+            &hitbox,
+            hitbox.velocity,
+            hitbox.grounded,
+            bodyDelta,
+            static_cast<uint>(substeps)});
+    }
+    // parallel phase: integration and voxel collisions only,
+    // chunks and registry must not be modified until it's done
+    stepBodies();
+
+    // serial phase: components sync and scripting events
+    for (const auto& task : physicsTasks) {
+        if (!registry->valid(task.entity)) {
+            continue;
+        }
+        const auto& eid = registry->get<EntityId>(task.entity);
+        auto& transform = registry->get<Transform>(task.entity);
+        auto& hitbox = registry->get<Rigidbody>(task.entity).hitbox;
+        bool grounded = task.grounded;
+
         hitbox.friction = glm::abs(hitbox.gravityScale <= 1e-7f)
                               ? 8.0f
                               : (!grounded ? 2.0f : 10.0f);
@@ -322,16 +660,21 @@ void Entities::updatePhysics(float delta) {
         transform.setPos(hitbox.position);
         if (hitbox.grounded && !grounded) {
             scripting::on_entity_grounded(
-                *get(eid.uid), glm::length(prevVel - hitbox.velocity)
+                *get(eid.uid), glm::length(task.prevVel - hitbox.velocity)
             );
         }
         if (!hitbox.grounded && grounded) {
             scripting::on_entity_fall(*get(eid.uid));
         }
     }
+    rebuildGrid();
+    checkSensors();
 }
 
 void Entities::update(float delta) {
+    VC_PROFILE_ZONE("Entities::update");
+    spawnPending();
+    updateTiers();
     if (updateTickClock.update(delta)) {
         scripting::on_entities_update(
             updateTickClock.getTickRate(),
@@ -386,7 +729,10 @@ void Entities::renderDebug(
                 continue;
             }
             batch.box(
-                hitbox.position, hitbox.getHalfSize() * 2.0f, glm::vec4(1.0f)
+                hitbox.position,
+                hitbox.getHalfSize() * 2.0f,
+                hitbox.sleeping ? glm::vec4(0.5f, 0.5f, 0.5f, 1.0f)
+                                : glm::vec4(1.0f)
             );
 
             for (auto& sensor : rigidbody.sensors) {
@@ -427,66 +773,126 @@ void Entities::render(
     const Frustum* frustum,
     entityid_t fpsEntity
 ) {
+    poseTasks.clear();
+    poseBounds.clear();
     auto view = registry->view<EntityId, Transform, rigging::Skeleton>();
     for (auto [entity, eid, transform, skeleton] : view.each()) {
-        if (eid.uid == fpsEntity) {
+        if (eid.uid == fpsEntity || skeleton.config == nullptr) {
             continue;
         }
         const auto& pos = transform.pos;
         const auto& size = transform.size;
-        if (frustum && !frustum->isBoxVisible(pos - size, pos + size)) {
-            continue;
+        poseTasks.push_back(PoseTask {&skeleton, &transform});
+        poseBounds.push_back(pos - size, pos + size);
+    }
+    if (frustum) {
+        frustum->areBoxesVisible(poseBounds, poseVisible);
+        size_t visibleCount = 0;
+        for (size_t i = 0; i < poseTasks.size(); i++) {
+            if (Frustum::isVisible(poseVisible, i)) {
+                poseTasks[visibleCount++] = poseTasks[i];
+            }
         }
+        poseTasks.resize(visibleCount);
+    }
+    updatePoses();
 
-        const auto* rigConfig = skeleton.config;
-        if (rigConfig) {
-            rigConfig->render(
-                assets, batch, skeleton, transform.rot, pos, size
-            );
+    for (const auto& task : poseTasks) {
+        task.skeleton->config->render(assets, batch, *task.skeleton);
+    }
+}
+
+void Entities::updatePoses() {
+    size_t count = poseTasks.size();
+    if (posePool == nullptr && count >= POSE_JOB_MIN_SKELETONS * 2) {
+        posePool = std::make_unique<util::ThreadPool<PoseJob, size_t>>(
+            "poses",
+            []() { return std::make_unique<PoseWorker>(); },
+            [this](size_t&&) { poseJobsDone++; },
+            util::ThreadPool<PoseJob, size_t>::QUARTER
+        );
+        posePool->setStandaloneResults(true);
+    }
+    size_t jobsCount = 1;
+    if (posePool) {
+        jobsCount = std::min(
+            static_cast<size_t>(posePool->getWorkersCount()) + 1,
+            count / POSE_JOB_MIN_SKELETONS
+        );
+    }
+    if (jobsCount <= 1) {
+        update_poses({poseTasks.data(), count});
+        return;
+    }
+    size_t jobSize = (count + jobsCount - 1) / jobsCount;
+    poseJobsDone = 0;
+    size_t enqueued = 0;
+    // the first range is processed by the current thread
+    for (size_t offset = jobSize; offset < count; offset += jobSize) {
+        posePool->enqueueJob(PoseJob {
+            poseTasks.data() + offset, std::min(jobSize, count - offset)});
+        enqueued++;
+    }
+    update_poses({poseTasks.data(), jobSize});
+    while (poseJobsDone < enqueued) {
+        if (posePool->pullResults() == 0) {
+            std::this_thread::yield();
         }
     }
 }
 
 bool Entities::hasBlockingInside(AABB aabb) {
-    auto view = registry->view<EntityId, Rigidbody>();
-    for (auto [entity, eid, body] : view.each()) {
-        if (eid.def.blocking && aabb.intersect(body.hitbox.getAABB(), -0.05f)) {
+    return !grid.query(aabb, [this, &aabb](entt::entity entity) {
+        if (!registry->valid(entity)) {
             return true;
         }
-    }
-    return false;
+        const auto& eid = registry->get<EntityId>(entity);
+        const auto& body = registry->get<Rigidbody>(entity);
+        return !(
+            eid.def.blocking && aabb.intersect(body.hitbox.getAABB(), -0.05f)
+        );
+    });
+}
+
+void Entities::wakeInside(AABB aabb) {
+    grid.query(aabb, [this, &aabb](entt::entity entity) {
+        if (!registry->valid(entity)) {
+            return;
+        }
+        auto& hitbox = registry->get<Rigidbody>(entity).hitbox;
+        if (hitbox.sleeping && aabb.intersect(hitbox.getAABB())) {
+            hitbox.wake();
+        }
+    });
 }
 
 std::vector<Entity> Entities::getAllInside(AABB aabb) {
     std::vector<Entity> collected;
-    auto view = registry->view<EntityId, Transform>();
-    for (auto [entity, eid, transform] : view.each()) {
+    grid.query(aabb, [this, &aabb, &collected](entt::entity entity) {
+        if (!registry->valid(entity)) {
+            return;
+        }
+        const auto& eid = registry->get<EntityId>(entity);
+        const auto& transform = registry->get<Transform>(entity);
         if (!eid.destroyFlag && aabb.contains(transform.pos)) {
-            const auto& found = uids.find(entity);
-            if (found == uids.end()) {
-                continue;
-            }
-            if (auto wrapper = get(found->second)) {
-                collected.push_back(*wrapper);
-            }
+            collected.emplace_back(*this, eid.uid, *registry, entity);
         }
-    }
+    });
     return collected;
 }
 
 std::vector<Entity> Entities::getAllInRadius(glm::vec3 center, float radius) {
     std::vector<Entity> collected;
-    auto view = registry->view<Transform>();
-    for (auto [entity, transform] : view.each()) {
+    AABB area(center - radius, center + radius);
+    grid.query(area, [&](entt::entity entity) {
+        if (!registry->valid(entity)) {
+            return;
+        }
+        const auto& transform = registry->get<Transform>(entity);
         if (glm::distance2(transform.pos, center) <= radius * radius) {
-            const auto& found = uids.find(entity);
-            if (found == uids.end()) {
-                continue;
-            }
-            if (auto wrapper = get(found->second)) {
-                collected.push_back(*wrapper);
-            }
+            const auto& eid = registry->get<EntityId>(entity);
+            collected.emplace_back(*this, eid.uid, *registry, entity);
         }
-    }
+    });
     return collected;
 }
@@ -1,16 +1,23 @@
 #pragma once
 
+#define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
 #include <memory>
 #include <optional>
 #include <vector>
 
+#include "entities_index.hpp"
+#include "maths/FrustumCulling.hpp"
 #include "physics/Hitbox.hpp"
+#include "physics/SpatialGrid.hpp"
 #include "Transform.hpp"
 #include "Rigidbody.hpp"
 #include "ScriptComponents.hpp"
 #include "typedefs.hpp"
 #include "util/Clock.hpp"
+#include "util/SparseSet.hpp"
+#include "util/observer_handler.hpp"
 
 #include <entt/entity/fwd.hpp>
 #include <unordered_map>
@@ -22,7 +29,6 @@ class Assets;
 class Entity;
 class LineBatch;
 class ModelBatch;
-class Frustum;
 class Entities;
 class DrawContext;
 
@@ -31,16 +37,104 @@ namespace rigging {
     class SkeletonConfig;
 }
 
+namespace util {
+    template <class T, class R>
+    class ThreadPool;
+}
+
+/// @brief Body integrated in the parallel physics phase
+struct PhysicsTask {
+    entt::entity entity;
+    Hitbox* hitbox;
+    /// @brief Velocity before the step
+    glm::vec3 prevVel;
+    /// @brief Grounded state before the step
+    bool grounded;
+    /// @brief Step duration (longer for reduced simulation tier)
+    float delta;
+    uint substeps;
+};
+
+/// @brief Range of physics tasks processed by a single worker
+struct PhysicsJob {
+    const PhysicsTask* tasks;
+    size_t count;
+};
+
+/// @brief Visible skeleton pose evaluated in the parallel phase
+struct PoseTask {
+    rigging::Skeleton* skeleton;
+    const Transform* transform;
+};
+
+/// @brief Range of pose tasks processed by a single worker
+struct PoseJob {
+    const PoseTask* tasks;
+    size_t count;
+};
+
 class Entities final {
     std::unique_ptr<entt::registry> registry;
     Level& level;
-    std::unordered_map<entityid_t, entt::entity> entities;
-    std::unordered_map<entt::entity, entityid_t> uids;
+    /// @brief Entities handles by uid. Reverse mapping is the EntityId
+    /// component
+    util::SparseSet<entt::entity> entities;
+    /// @brief Last get() result. Scripts access the same entity
+    /// components several times in a row, so the map lookup is skipped.
+    /// Destroyed entity handle is rejected by the registry version check
+    entityid_t lookupId = 0;
+    entt::entity lookupEntity;
     entityid_t nextID = 1;
     util::Clock sensorsTickClock;
     util::Clock updateTickClock;
     Assets* assets = nullptr;
+    /// @brief Broadphase grid of entities. Rebuilt on every physics update,
+    /// so entities moved by scripts are found at the new position after
+    /// the next update.
+    SpatialGrid<entt::entity> grid;
+    std::vector<PhysicsTask> physicsTasks;
+    /// @brief Bodies integration workers (created on demand)
+    std::unique_ptr<util::ThreadPool<PhysicsJob, size_t>> physicsPool;
+    size_t physicsJobsDone = 0;
+    uint64_t physicsTick = 0;
+    std::vector<PoseTask> poseTasks;
+    /// @brief Bounding boxes of poseTasks culled in a single batch
+    BoxesArray poseBounds;
+    std::vector<uint64_t> poseVisible;
+    /// @brief Skeleton poses evaluation workers (created on demand)
+    std::unique_ptr<util::ThreadPool<PoseJob, size_t>> posePool;
+    size_t poseJobsDone = 0;
+
+    /// @brief Loaded chunk entities not spawned yet
+    struct PendingEntities {
+        std::shared_ptr<entities_index::Index> index;
+        /// @brief Indices of not spawned index entries
+        std::vector<size_t> entries;
+    };
+    std::unordered_map<glm::ivec2, PendingEntities> pending;
+
+    /// @brief Memory accounting source (see debug::memory)
+    ObserverHandler memorySource;
+
+    /// @brief Spawn pending entities outside of the frozen simulation tier
+    void spawnPending();
+    /// @brief Update entities simulation rate by the simulation tier
+    void updateTiers();
+
+    /// @brief Integrate bodies and solve voxel collisions. Work is split
+    /// between workers when there are enough bodies.
+    void stepBodies();
+
+    /// @brief Calculate bone matrices of the pose tasks skeletons. Work is
+    /// split between workers when there are enough skeletons.
+    void updatePoses();
 
+    void insertToGrid(
+        entt::entity entity, const Transform& tsf, const Rigidbody& body
+    );
+    void rebuildGrid();
+    /// @brief Check enabled sensors against nearby bodies
+    void checkSensors();
     void updateSensors(
         Rigidbody& body, const Transform& tsf, std::vector<Sensor*>& sensors
     );
@@ -97,15 +191,31 @@ public:
     );
 
     void loadEntities(dv::value map);
+    /// @brief Defer chunk entities spawn until they leave the frozen
+    /// simulation tier. Only headers are read
+    void addPending(
+        int chunkX, int chunkZ, std::shared_ptr<entities_index::Index> index
+    );
+    /// @brief Copy not spawned chunk entities without decoding
+    void writePending(
+        int chunkX, int chunkZ, entities_index::Builder& builder
+    ) const;
+    void dropPending(int chunkX, int chunkZ);
+    size_t getPendingCount() const;
     void loadEntity(const dv::value& map);
     void loadEntity(const dv::value& map, Entity entity);
     void onSave(const Entity& entity);
     bool hasBlockingInside(AABB aabb);
+    /// @brief Wake up sleeping bodies intersecting the area
+    void wakeInside(AABB aabb);
     std::vector<Entity> getAllInside(AABB aabb);
     std::vector<Entity> getAllInRadius(glm::vec3 center, float radius);
     void despawn(entityid_t id);
     void despawn(std::vector<Entity> entities);
     dv::value serialize(const std::vector<Entity>& entities);
+    void serialize(
+        const std::vector<Entity>& entities, entities_index::Builder& builder
+    );
 
     void setNextID(entityid_t id) {
         nextID = id;
@@ -118,4 +228,8 @@ public:
     inline entityid_t peekNextID() const {
         return nextID;
     }
+
+    /// @return components storages capacity in bytes. Heap data owned by
+    /// components is not included
+    size_t getMemoryUsage() const;
 };
@@ -46,6 +46,7 @@ void Entity::setRig(const rigging::SkeletonConfig* rigConfig) {
     skeleton.calculated.matrices.resize(
         rigConfig->getBones().size(), glm::mat4(1.0f)
     );
+    skeleton.dirty = true;
 }
 
 dv::value Entity::serialize() const {
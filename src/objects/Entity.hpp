@@ -27,6 +27,8 @@ struct EntityId {
     const EntityDef& def;
     bool destroyFlag = false;
     int64_t player = -1;
+    /// @brief Simulation tick rate divider (0 if frozen)
+    int rateDivider = 1;
 };
 
 class Entity {
@@ -22,6 +22,11 @@
 static debug::Logger logger("player");
 
 constexpr int SPAWN_ATTEMPTS_PER_UPDATE = 64;
+/// @brief Min horizontal speed (blocks per second) movement is predicted at
+constexpr float LOOKAHEAD_MIN_SPEED = 10.0f;
+/// @brief Time (seconds) movement is predicted for, so the look-ahead
+/// distance grows with speed
+constexpr float LOOKAHEAD_TIME = 3.0f;
 
 Player::Player(
     Level& level,
@@ -84,6 +89,18 @@ Hitbox* Player::getHitbox() {
     return nullptr;
 }
 
+glm::vec3 Player::getLookAhead() {
+    auto hitbox = getHitbox();
+    if (hitbox == nullptr) {
+        return {};
+    }
+    glm::vec3 velocity(hitbox->velocity.x, 0.0f, hitbox->velocity.z);
+    if (glm::length(velocity) < LOOKAHEAD_MIN_SPEED) {
+        return {};
+    }
+    return velocity * LOOKAHEAD_TIME;
+}
+
 bool Player::isCurrentCameraBuiltin() const {
     return currentCamera.get() == fpCamera.get() ||
            currentCamera.get() == spCamera.get() ||
@@ -111,10 +128,13 @@ void Player::postUpdate() {
 }
 
 void Player::teleport(glm::vec3 position) {
+    dirty = true;
     this->position = position;
 
     if (auto entity = level.entities->get(eid)) {
-        entity->getRigidbody().hitbox.position = position;
+        auto& hitbox = entity->getRigidbody().hitbox;
+        hitbox.position = position;
+        hitbox.wake();
         entity->getTransform().setPos(position);
         entity->setInterpolatedPosition(position);
     }
@@ -131,9 +151,9 @@ void Player::attemptToFindSpawnpoint() {
         newpos.y--;
     }
 
-    voxel* headvox = chunks->get(newpos.x, newpos.y + 1, newpos.z);
+    auto headvox = chunks->getVoxel(newpos.x, newpos.y + 1, newpos.z);
     if (chunks->isObstacleBlock(newpos.x, newpos.y, newpos.z) ||
-        headvox == nullptr || headvox->id != 0) {
+        !headvox || headvox->id != 0) {
         return;
     }
     spawnpoint = newpos + glm::vec3(0.5f, 0.0f, 0.5f);
@@ -141,6 +161,7 @@ void Player::attemptToFindSpawnpoint() {
 }
 
 void Player::setChosenSlot(int index) {
+    dirty = true;
     chosenSlot = index;
 }
 
@@ -157,6 +178,7 @@ bool Player::isSuspended() const {
 }
 
 void Player::setSuspended(bool flag) {
+    dirty = true;
     suspended = flag;
 }
 
@@ -165,6 +187,7 @@ bool Player::isFlight() const {
 }
 
 void Player::setFlight(bool flag) {
+    dirty = true;
     this->flight = flag;
 }
 
@@ -173,6 +196,7 @@ bool Player::isNoclip() const {
 }
 
 void Player::setNoclip(bool flag) {
+    dirty = true;
     this->noclip = flag;
 }
 
@@ -181,6 +205,7 @@ bool Player::isInfiniteItems() const {
 }
 
 void Player::setInfiniteItems(bool flag) {
+    dirty = true;
     infiniteItems = flag;
 }
 
@@ -189,6 +214,7 @@ bool Player::isInstantDestruction() const {
 }
 
 void Player::setInstantDestruction(bool flag) {
+    dirty = true;
     instantDestruction = flag;
 }
 
@@ -197,6 +223,7 @@ bool Player::isLoadingChunks() const {
 }
 
 void Player::setLoadingChunks(bool flag) {
+    dirty = true;
     loadingChunks = flag;
 }
 
@@ -205,6 +232,7 @@ float Player::getMaxInteractionDistance() const {
 }
 
 void Player::setMaxInteractionDistance(float distance) {
+    dirty = true;
     interactionDistance = std::max(1.0f, std::min(200.0f, distance));
 }
 
@@ -213,6 +241,7 @@ entityid_t Player::getEntity() const {
 }
 
 void Player::setEntity(entityid_t eid) {
+    dirty = true;
     this->eid = eid;
 }
 
@@ -221,6 +250,7 @@ entityid_t Player::getSelectedEntity() const {
 }
 
 void Player::setName(const std::string& name) {
+    dirty = true;
     this->name = name;
 }
 
@@ -228,11 +258,21 @@ const std::string& Player::getName() const {
     return name;
 }
 
+bool Player::isDirty() const {
+    return dirty || !suspended || inventory->isDirty();
+}
+
+void Player::resetDirty() {
+    dirty = false;
+    inventory->resetDirty();
+}
+
 const std::shared_ptr<Inventory>& Player::getInventory() const {
     return inventory;
 }
 
 void Player::setSpawnPoint(glm::vec3 spawnpoint) {
+    dirty = true;
     this->spawnpoint = spawnpoint;
 }
 
@@ -248,6 +288,7 @@ glm::vec3 Player::getRotation(bool interpolated) const {
 }
 
 void Player::setRotation(const glm::vec3& rotation) {
+    dirty = true;
     this->rotation = rotation;
     rotationInterpolation.refresh(rotation);
 }
@@ -282,6 +323,7 @@ dv::value Player::serialize() const {
 }
 
 void Player::deserialize(const dv::value& src) {
+    dirty = true;
     src.at("id").get(id);
     src.at("name").get(name);
 
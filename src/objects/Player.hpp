@@ -57,6 +57,7 @@ class Player : public Serializable {
     bool infiniteItems = true;
     bool instantDestruction = true;
     bool loadingChunks = true;
+    bool dirty = true;
     float interactionDistance = 10.0f;
 
     entityid_t eid = ENTITY_AUTO;
@@ -125,6 +126,13 @@ public:
     void setName(const std::string& name);
     const std::string& getName() const;
 
+    /// @return true if player must be written on the next world save.
+    /// Not suspended players are always considered modified
+    bool isDirty() const;
+
+    /// @brief Mark player written (inventory included)
+    void resetDirty();
+
     const std::shared_ptr<Inventory>& getInventory() const;
 
     const glm::vec3& getPosition() const {
@@ -135,6 +143,11 @@ public:
 
     Hitbox* getHitbox();
 
+    /// @brief Offset to the position the player is expected to reach
+    /// at the current velocity. Chunks around it are loaded and meshed
+    /// first. Zero when the player is not moving fast
+    glm::vec3 getLookAhead();
+
     void setSpawnPoint(glm::vec3 point);
     glm::vec3 getSpawnPoint() const;
 
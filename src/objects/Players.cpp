@@ -32,7 +32,7 @@ std::vector<Player*> Players::getAllInRadius(
     for (const auto& pair : players) {
         auto player = pair.second.get();
         auto relativePos = player->getPosition() - center;
-        if (!player->isSuspended() && glm::length2(relativePos) <= radius) {
+        if (!player->isSuspended() && glm::length2(relativePos) <= radius * radius) {
             foundPlayers.emplace_back(player);
         }
     }
@@ -113,7 +113,15 @@ void Players::resume(int64_t id) {
 }
 
 void Players::remove(int64_t id) {
-    players.erase(id);
+    if (players.erase(id)) {
+        removed.push_back(id);
+    }
+}
+
+std::vector<int64_t> Players::takeRemoved() {
+    std::vector<int64_t> ids;
+    ids.swap(removed);
+    return ids;
 }
 
 dv::value Players::serialize() const {
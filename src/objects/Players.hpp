@@ -21,6 +21,8 @@ public:
 private:
     Level& level;
     std::unordered_map<int64_t, std::unique_ptr<Player>> players;
+    /// @brief Removed since the last takeRemoved call
+    std::vector<int64_t> removed;
 
     void add(std::unique_ptr<Player> player);
 public:
@@ -36,6 +38,9 @@ public:
 
     void remove(int64_t id);
 
+    /// @return ids of players removed since the previous call
+    std::vector<int64_t> takeRemoved();
+
     std::vector<Player*> getAllInRadius(const glm::vec3& center, float radius) const;
     std::vector<Player*> getAll() const;
     Player* getNearest(const glm::vec3& position) const;
@@ -0,0 +1,150 @@
+#include "entities_index.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "coders/binary_json.hpp"
+#include "coders/byte_utils.hpp"
+#include "coders/gzip.hpp"
+#include "data/dv_util.hpp"
+#include "Entity.hpp"
+
+using namespace entities_index;
+
+Index::Index(
+    std::vector<Header> headers,
+    std::vector<ubyte> payload,
+    uint32_t payloadSize,
+    bool compressed
+)
+    : headers(std::move(headers)),
+      payload(std::move(payload)),
+      payloadSize(payloadSize),
+      compressed(compressed) {
+}
+
+void Index::inflate() {
+    if (!compressed) {
+        return;
+    }
+    payload = gzip::decompress(payload.data(), payload.size());
+    compressed = false;
+    if (payload.size() != payloadSize) {
+        throw std::runtime_error("entities index payload size mismatch");
+    }
+}
+
+const ubyte* Index::getDocument(size_t index, uint32_t& size) {
+    inflate();
+    const auto& header = headers.at(index);
+    if (static_cast<size_t>(header.offset) + header.size > payload.size()) {
+        throw std::runtime_error("entity document is out of payload bounds");
+    }
+    size = header.size;
+    return payload.data() + header.offset;
+}
+
+dv::value Index::decode(size_t index) {
+    uint32_t size;
+    auto document = getDocument(index, size);
+    return json::from_binary(document, size);
+}
+
+void Builder::add(
+    entityid_t uid,
+    const std::string& def,
+    const glm::vec3& position,
+    const ubyte* document,
+    uint32_t size
+) {
+    headers.push_back(Header {
+        uid, def, position, static_cast<uint32_t>(payload.size()), size});
+    payload.insert(payload.end(), document, document + size);
+}
+
+void Builder::add(Index& index, size_t entry) {
+    const auto& header = index.getHeaders().at(entry);
+    uint32_t size;
+    auto document = index.getDocument(entry, size);
+    add(header.uid, header.def, header.position, document, size);
+}
+
+std::vector<ubyte> Builder::build() const {
+    auto compressed = gzip::compress(payload.data(), payload.size());
+
+    ByteBuilder builder;
+    builder.put(MAGIC, sizeof(MAGIC));
+    builder.put(VERSION);
+    builder.putInt32(headers.size());
+    for (const auto& header : headers) {
+        builder.putInt64(header.uid);
+        builder.putCStr(header.def.c_str());
+        builder.putFloat32(header.position.x);
+        builder.putFloat32(header.position.y);
+        builder.putFloat32(header.position.z);
+        builder.putInt32(header.offset);
+        builder.putInt32(header.size);
+    }
+    builder.putInt32(payload.size());
+    builder.put(compressed.data(), compressed.size());
+    return builder.build();
+}
+
+bool entities_index::is_indexed(const ubyte* src, size_t size) {
+    return size > sizeof(MAGIC) &&
+           std::memcmp(src, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+Index entities_index::read(const ubyte* src, size_t size) {
+    if (!is_indexed(src, size)) {
+        throw std::runtime_error("invalid entities index");
+    }
+    ByteReader reader(src, size);
+    reader.skip(sizeof(MAGIC));
+    ubyte version = reader.get();
+    if (version > VERSION) {
+        throw std::runtime_error(
+            "unsupported entities index version " + std::to_string(version)
+        );
+    }
+    int32_t count = reader.getInt32();
+    if (count < 0) {
+        throw std::runtime_error("invalid entities count");
+    }
+    std::vector<Header> headers;
+    headers.reserve(count);
+    for (int32_t i = 0; i < count; i++) {
+        Header header {};
+        header.uid = reader.getInt64();
+        header.def = reader.getCString();
+        header.position.x = reader.getFloat32();
+        header.position.y = reader.getFloat32();
+        header.position.z = reader.getFloat32();
+        header.offset = reader.getInt32();
+        header.size = reader.getInt32();
+        headers.push_back(std::move(header));
+    }
+    uint32_t payloadSize = reader.getInt32();
+    std::vector<ubyte> payload(reader.pointer(), src + size);
+    return Index(std::move(headers), std::move(payload), payloadSize, true);
+}
+
+Index entities_index::from_legacy(const dv::value& root) {
+    std::vector<Header> headers;
+    std::vector<ubyte> payload;
+    for (const auto& map : root["data"]) {
+        Header header {};
+        header.uid = map["uid"].asInteger();
+        header.def = map["def"].asString();
+        if (map.has(COMP_TRANSFORM)) {
+            dv::get_vec(map[COMP_TRANSFORM], "pos", header.position);
+        }
+        auto document = json::to_binary(map);
+        header.offset = payload.size();
+        header.size = document.size();
+        payload.insert(payload.end(), document.begin(), document.end());
+        headers.push_back(std::move(header));
+    }
+    uint32_t payloadSize = payload.size();
+    return Index(std::move(headers), std::move(payload), payloadSize, false);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+#include "data/dv.hpp"
+#include "typedefs.hpp"
+
+/// @brief Chunk entities storage format listing entities headers before
+/// the compressed documents, so headers are read without decoding
+/// components data
+namespace entities_index {
+    inline constexpr ubyte MAGIC[] {0x0, 'E', 'N', 'I'};
+    inline constexpr ubyte VERSION = 1;
+
+    struct Header {
+        entityid_t uid;
+        std::string def;
+        glm::vec3 position;
+        /// @brief Entity document offset in the payload
+        uint32_t offset;
+        /// @brief Entity document size
+        uint32_t size;
+    };
+
+    /// @brief Chunk entities headers. Payload is inflated on the first
+    /// document access
+    class Index {
+        std::vector<Header> headers;
+        std::vector<ubyte> payload;
+        uint32_t payloadSize = 0;
+        bool compressed = false;
+
+        void inflate();
+    public:
+        Index() = default;
+        Index(
+            std::vector<Header> headers,
+            std::vector<ubyte> payload,
+            uint32_t payloadSize,
+            bool compressed
+        );
+
+        const std::vector<Header>& getHeaders() const {
+            return headers;
+        }
+
+        /// @brief Get raw binary json document of the entity
+        const ubyte* getDocument(size_t index, uint32_t& size);
+
+        /// @brief Decode full entity data
+        dv::value decode(size_t index);
+    };
+
+    class Builder {
+        std::vector<Header> headers;
+        std::vector<ubyte> payload;
+    public:
+        /// @param document binary json entity document
+        void add(
+            entityid_t uid,
+            const std::string& def,
+            const glm::vec3& position,
+            const ubyte* document,
+            uint32_t size
+        );
+
+        /// @brief Copy entity from other index without decoding
+        void add(Index& index, size_t entry);
+
+        bool empty() const {
+            return headers.empty();
+        }
+
+        size_t size() const {
+            return headers.size();
+        }
+
+        std::vector<ubyte> build() const;
+    };
+
+    /// @return true if data is produced by Builder::build()
+    bool is_indexed(const ubyte* src, size_t size);
+
+    /// @brief Read headers. Payload is kept compressed
+    Index read(const ubyte* src, size_t size);
+
+    /// @brief Convert legacy {"data": [...]} entities document
+    Index from_legacy(const dv::value& root);
+}
@@ -83,6 +83,7 @@ void Skeleton::deserialize(const dv::value& root) {
         for (size_t i = 0; i < std::min(matrices.size(), posearr.size()); i++) {
             dv::get_mat(posearr[i], pose.matrices[i]);
         }
+        dirty = true;
     }
 }
 
@@ -138,17 +139,18 @@ void SkeletonConfig::update(
     const glm::vec3& position,
     const glm::vec3& scale
 ) const {
-    if (skeleton.interpolation.isEnabled()) {
-        const auto& interpolation = skeleton.interpolation;
-        update(
-            0,
-            skeleton,
-            root.get(),
-            build_matrix(rotation, interpolation.getCurrent(), scale)
-        );
-    } else {
-        update(0, skeleton, root.get(), build_matrix(rotation, position, scale));
+    const auto& interpolation = skeleton.interpolation;
+    auto matrix = build_matrix(
+        rotation,
+        interpolation.isEnabled() ? interpolation.getCurrent() : position,
+        scale
+    );
+    if (!skeleton.dirty && matrix == skeleton.calculatedRoot) {
+        return;
     }
+    update(0, skeleton, root.get(), matrix);
+    skeleton.calculatedRoot = matrix;
+    skeleton.dirty = false;
 }
 
 void SkeletonConfig::render(
@@ -160,7 +162,12 @@ void SkeletonConfig::render(
     const glm::vec3& scale
 ) const {
     update(skeleton, rotation, position, scale);
+    render(assets, batch, skeleton);
+}
 
+void SkeletonConfig::render(
+    const Assets& assets, ModelBatch& batch, Skeleton& skeleton
+) const {
     if (!skeleton.visible) {
         return;
     }
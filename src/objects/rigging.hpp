@@ -89,6 +89,12 @@ namespace rigging {
 
         util::VecInterpolation<3, float> interpolation {false};
 
+        /// @brief Pose was modified after calculated matrices update
+        bool dirty = true;
+        /// @brief Root matrix of the calculated matrices. Unchanged pose and
+        /// transform skip the bones matrices update
+        glm::mat4 calculatedRoot {0.0f};
+
         Skeleton(const SkeletonConfig* config);
 
         dv::value serialize(bool saveTextures, bool savePose) const;
@@ -134,6 +140,11 @@ namespace rigging {
             const glm::vec3& scale
         ) const;
 
+        /// @brief Render skeleton using pose calculated with update(...)
+        void render(
+            const Assets& assets, ModelBatch& batch, Skeleton& skeleton
+        ) const;
+
         Skeleton instance() const {
             return Skeleton(this);
         }
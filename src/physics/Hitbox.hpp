@@ -60,9 +60,18 @@ struct Hitbox {
     float gravityScale = 1.0f;
     bool crouching = false;
     float stepHeight = 0.5f;
+    /// @brief Resting body is not stepped until woken up
+    bool sleeping = false;
+    /// @brief Number of steps the body has been resting for
+    uint restingSteps = 0;
 
     Hitbox(BodyType type, glm::vec3 position, glm::vec3 halfsize);
 
+    void wake() {
+        sleeping = false;
+        restingSteps = 0;
+    }
+
     AABB getAABB() const {
         return AABB(position-halfsize, position+halfsize);
     }
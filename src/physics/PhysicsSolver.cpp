@@ -4,6 +4,7 @@
 #include "maths/aabb.hpp"
 #include "voxels/Block.hpp"
 #include "voxels/GlobalChunks.hpp"
+#include "voxels/blocks_agent.hpp"
 #include "voxels/voxel.hpp"
 
 #include <iostream>
@@ -14,18 +15,20 @@
 inline const float E = 0.03f;
 inline const float MAX_FIX = 0.1f;
 
+using ChunksCursor = blocks_agent::ChunksCursor<GlobalChunks>;
+
 PhysicsSolver::PhysicsSolver(glm::vec3 gravity) : gravity(gravity) {}
 
 void PhysicsSolver::step(
     const GlobalChunks& chunks, 
     Hitbox& hitbox, 
     float delta, 
-    uint substeps, 
-    entityid_t entity
+    uint substeps
 ) {
     float dt = delta / static_cast<float>(substeps);
     float linearDamping = hitbox.linearDamping * hitbox.friction;
     float s = 2.0f/BLOCK_AABB_GRID;
+    ChunksCursor cursor(chunks);
 
     auto half = hitbox.getHalfSize();
     glm::vec3& pos = hitbox.position;
@@ -57,7 +60,7 @@ void PhysicsSolver::step(
                 float x = (px-half.x+E) + ix * s;
                 for (int iz = 0; iz <= (half.z-E)*2/s; iz++){
                     float z = (pos.z-half.z+E) + iz * s;
-                    if (chunks.isObstacleAt(x,y,z)){
+                    if (cursor.isObstacleAt(x,y,z)){
                         hitbox.grounded = true;
                         break;
                     }
@@ -72,7 +75,7 @@ void PhysicsSolver::step(
                 float x = (pos.x-half.x+E) + ix * s;
                 for (int iz = 0; iz <= (half.z-E)*2/s; iz++){
                     float z = (pz-half.z+E) + iz * s;
-                    if (chunks.isObstacleAt(x,y,z)){
+                    if (cursor.isObstacleAt(x,y,z)){
                         hitbox.grounded = true;
                         break;
                     }
@@ -91,37 +94,50 @@ void PhysicsSolver::step(
         vel.y /= 1.0f + delta * linearDamping * hitbox.verticalDamping;
     }
 
+    bool resting = glm::length2(vel) < SLEEP_VELOCITY * SLEEP_VELOCITY &&
+                   (hitbox.grounded || gravityScale == 0.0f);
+    if (!resting) {
+        hitbox.restingSteps = 0;
+    } else if (++hitbox.restingSteps >= SLEEP_STEPS) {
+        hitbox.sleeping = true;
+    }
+}
+
+bool PhysicsSolver::checkSensor(
+    Sensor& sensor, const Hitbox& hitbox, entityid_t entity
+) {
+    if (sensor.entity == entity) {
+        return false;
+    }
     AABB aabb;
     aabb.a = hitbox.position - hitbox.getHalfSize();
     aabb.b = hitbox.position + hitbox.getHalfSize();
-    for (size_t i = 0; i < sensors.size(); i++) {
-        auto& sensor = *sensors[i];
-        if (sensor.entity == entity) {
-            continue;
-        }
 
-        bool triggered = false;
-        switch (sensor.type) {
-            case SensorType::AABB:
-                triggered = aabb.intersect(sensor.calculated.aabb);
-                break;
-            case SensorType::RADIUS:
-                triggered = glm::distance2(
-                    hitbox.position, glm::vec3(sensor.calculated.radial))
-                     < sensor.calculated.radial.w;
-                break;
-        }
-        if (triggered) {
-            if (sensor.prevEntered.find(entity) == sensor.prevEntered.end()) {
-                sensor.enterCallback(sensor.entity, sensor.index, entity);
-            }
-            sensor.nextEntered.insert(entity);
-        }
+    bool triggered = false;
+    switch (sensor.type) {
+        case SensorType::AABB:
+            triggered = aabb.intersect(sensor.calculated.aabb);
+            break;
+        case SensorType::RADIUS:
+            triggered = glm::distance2(
+                hitbox.position, glm::vec3(sensor.calculated.radial))
+                 < sensor.calculated.radial.w;
+            break;
     }
+    if (!triggered) {
+        return false;
+    }
+    bool entered =
+        sensor.prevEntered.find(entity) == sensor.prevEntered.end();
+    if (entered) {
+        sensor.enterCallback(sensor.entity, sensor.index, entity);
+    }
+    sensor.nextEntered.insert(entity);
+    return entered;
 }
 
 static float calc_step_height(
-    const GlobalChunks& chunks, 
+    const ChunksCursor& chunks, 
     const glm::vec3& pos, 
     const glm::vec3& half,
     float stepHeight,
@@ -143,7 +159,7 @@ static float calc_step_height(
 
 template <int nx, int ny, int nz>
 static bool calc_collision_neg(
-    const GlobalChunks& chunks,
+    const ChunksCursor& chunks,
     glm::vec3& pos,
     glm::vec3& vel,
     const glm::vec3& half,
@@ -175,7 +191,7 @@ static bool calc_collision_neg(
 
 template <int nx, int ny, int nz>
 static void calc_collision_pos(
-    const GlobalChunks& chunks,
+    const ChunksCursor& chunks,
     glm::vec3& pos,
     glm::vec3& vel,
     const glm::vec3& half,
@@ -214,18 +230,20 @@ void PhysicsSolver::colisionCalc(
 ) {
     // step size (smaller - more accurate, but slower) // TODO: GET RID OF THIS
     float s = 2.0f/BLOCK_AABB_GRID;
+    // most of the checked points are in the same chunk
+    ChunksCursor cursor(chunks);
 
-    stepHeight = calc_step_height(chunks, pos, half, stepHeight, s);
+    stepHeight = calc_step_height(cursor, pos, half, stepHeight, s);
 
     const AABB* aabb;
     
-    calc_collision_neg<0, 1, 2>(chunks, pos, vel, half, stepHeight, s);
-    calc_collision_pos<0, 1, 2>(chunks, pos, vel, half, stepHeight, s);
+    calc_collision_neg<0, 1, 2>(cursor, pos, vel, half, stepHeight, s);
+    calc_collision_pos<0, 1, 2>(cursor, pos, vel, half, stepHeight, s);
 
-    calc_collision_neg<2, 1, 0>(chunks, pos, vel, half, stepHeight, s);
-    calc_collision_pos<2, 1, 0>(chunks, pos, vel, half, stepHeight, s);
+    calc_collision_neg<2, 1, 0>(cursor, pos, vel, half, stepHeight, s);
+    calc_collision_pos<2, 1, 0>(cursor, pos, vel, half, stepHeight, s);
 
-    if (calc_collision_neg<1, 0, 2>(chunks, pos, vel, half, 0.0f, s)) {
+    if (calc_collision_neg<1, 0, 2>(cursor, pos, vel, half, 0.0f, s)) {
         hitbox.grounded = true;
     }
 
@@ -235,7 +253,7 @@ void PhysicsSolver::colisionCalc(
             for (int iz = 0; iz <= (half.z-E)*2/s; iz++) {
                 float z = (pos.z-half.z+E) + iz * s;
                 float y = (pos.y-half.y+E);
-                if ((aabb = chunks.isObstacleAt(x,y,z))){
+                if ((aabb = cursor.isObstacleAt(x,y,z))){
                     vel.y = 0.0f;
                     float newy = std::floor(y) + aabb->max().y + half.y;
                     if (std::abs(newy-pos.y) <= MAX_FIX+stepHeight) {
@@ -252,7 +270,7 @@ void PhysicsSolver::colisionCalc(
             for (int iz = 0; iz <= (half.z-E)*2/s; iz++) {
                 float z = (pos.z-half.z+E) + iz * s;
                 float y = (pos.y+half.y+E);
-                if ((aabb = chunks.isObstacleAt(x,y,z))){
+                if ((aabb = cursor.isObstacleAt(x,y,z))){
                     vel.y = 0.0f;
                     float newy = std::floor(y) - half.y + aabb->min().y - E;
                     if (std::abs(newy-pos.y) <= MAX_FIX) {
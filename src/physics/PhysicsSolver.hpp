@@ -16,13 +16,17 @@ class PhysicsSolver {
     glm::vec3 gravity;
     std::vector<Sensor*> sensors;
 public:
+    /// @brief Max speed of a resting body
+    static constexpr float SLEEP_VELOCITY = 0.05f;
+    /// @brief Number of resting steps before the body falls asleep
+    static constexpr uint SLEEP_STEPS = 30;
+
     PhysicsSolver(glm::vec3 gravity);
     void step(
         const GlobalChunks& chunks,
         Hitbox& hitbox,
         float delta,
-        uint substeps,
-        entityid_t entity
+        uint substeps
     );
     void colisionCalc(
         const GlobalChunks& chunks,
@@ -35,9 +39,18 @@ public:
     bool isBlockInside(int x, int y, int z, Hitbox* hitbox);
     bool isBlockInside(int x, int y, int z, Block* def, blockstate state, Hitbox* hitbox);
 
+    /// @brief Check if the body is inside the sensor and call enter
+    /// callback if it was not inside on previous sensors tick
+    /// @return true if the body has entered the sensor
+    bool checkSensor(Sensor& sensor, const Hitbox& hitbox, entityid_t entity);
+
     void setSensors(std::vector<Sensor*> sensors) {
         this->sensors = std::move(sensors);
     }
 
+    const std::vector<Sensor*>& getSensors() const {
+        return sensors;
+    }
+
     void removeSensor(Sensor* sensor);
 };
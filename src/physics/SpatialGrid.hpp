@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
+
+#include "maths/aabb.hpp"
+
+/// @brief Loose uniform grid used as a broadphase for spatial queries.
+/// Each value is stored in the single cell containing its position, queries
+/// are expanded by the largest inserted extent, so callers must perform
+/// exact checks on returned candidates.
+/// @tparam T stored value type (cheap to copy handle)
+template <typename T>
+class SpatialGrid {
+    struct Entry {
+        T value;
+        glm::vec3 pos;
+    };
+
+    int cellSize;
+    /// @brief Largest distance from stored position to the value bounds
+    float maxExtent = 0.0f;
+    size_t count = 0;
+    std::unordered_map<glm::ivec3, std::vector<Entry>> cells;
+
+    glm::ivec3 toCell(const glm::vec3& pos) const {
+        return glm::ivec3(glm::floor(pos / static_cast<float>(cellSize)));
+    }
+
+    template <typename Func>
+    static bool call(Func& func, const T& value) {
+        if constexpr (std::is_same_v<std::invoke_result_t<Func&, const T&>, bool>) {
+            return func(value);
+        } else {
+            func(value);
+            return true;
+        }
+    }
+
+    template <typename Func>
+    static bool visitCell(
+        const std::vector<Entry>& entries,
+        const glm::vec3& min,
+        const glm::vec3& max,
+        Func& func
+    ) {
+        for (const auto& entry : entries) {
+            const auto& pos = entry.pos;
+            if (pos.x < min.x || pos.y < min.y || pos.z < min.z ||
+                pos.x > max.x || pos.y > max.y || pos.z > max.z) {
+                continue;
+            }
+            if (!call(func, entry.value)) {
+                return false;
+            }
+        }
+        return true;
+    }
+public:
+    explicit SpatialGrid(int cellSize) : cellSize(cellSize) {
+    }
+
+    /// @brief Remove all values. Non-empty cells keep their storage to be
+    /// reused by the next rebuild, cells left empty since the previous clear
+    /// are released.
+    void clear() {
+        for (auto it = cells.begin(); it != cells.end();) {
+            if (it->second.empty()) {
+                it = cells.erase(it);
+            } else {
+                it->second.clear();
+                ++it;
+            }
+        }
+        maxExtent = 0.0f;
+        count = 0;
+    }
+
+    /// @param value stored value
+    /// @param pos value position used to select the cell
+    /// @param extent max distance (per axis) from pos to the value bounds
+    void insert(const T& value, const glm::vec3& pos, float extent) {
+        cells[toCell(pos)].push_back(Entry {value, pos});
+        maxExtent = std::max(maxExtent, extent);
+        count++;
+    }
+
+    /// @brief Call func for every value which bounds may intersect the box.
+    /// Iteration stops if func returns false.
+    /// @return false if iteration was stopped by func
+    template <typename Func>
+    bool query(const AABB& aabb, Func&& func) const {
+        if (count == 0) {
+            return true;
+        }
+        glm::vec3 min = aabb.min() - maxExtent;
+        glm::vec3 max = aabb.max() + maxExtent;
+
+        glm::dvec3 cmin = glm::floor(glm::dvec3(min) / double(cellSize));
+        glm::dvec3 cmax = glm::floor(glm::dvec3(max) / double(cellSize));
+        glm::dvec3 range = cmax - cmin + 1.0;
+        if (range.x * range.y * range.z > static_cast<double>(cells.size())) {
+            // the box covers more cells than exist
+            for (const auto& [cell, entries] : cells) {
+                if (cell.x < cmin.x || cell.y < cmin.y || cell.z < cmin.z ||
+                    cell.x > cmax.x || cell.y > cmax.y || cell.z > cmax.z) {
+                    continue;
+                }
+                if (!visitCell(entries, min, max, func)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        glm::ivec3 begin(cmin);
+        glm::ivec3 end(cmax);
+        for (int y = begin.y; y <= end.y; y++) {
+            for (int z = begin.z; z <= end.z; z++) {
+                for (int x = begin.x; x <= end.x; x++) {
+                    const auto& found = cells.find({x, y, z});
+                    if (found == cells.end()) {
+                        continue;
+                    }
+                    if (!visitCell(found->second, min, max, func)) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    float getMaxExtent() const {
+        return maxExtent;
+    }
+};
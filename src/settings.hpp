@@ -20,6 +20,14 @@ struct AudioSettings {
     StringSetting inputDevice {"auto"};
 
     FlagSetting acousticEffects {true};
+
+    /// @brief Decoded sounds cache size (MiB). Sounds out of the cache
+    /// are kept compressed until played (0 - decode all sounds on load)
+    IntegerSetting soundsCacheSize {128, 0, 4096};
+
+    /// @brief Max number of simultaneously playing sounds. Inaudible and
+    /// least important sounds over the limit are virtualized
+    IntegerSetting maxVoices {64, 8, 240};
 };
 
 struct DisplaySettings {
@@ -37,6 +45,9 @@ struct DisplaySettings {
     FlagSetting limitFpsIconified {false};
     /// @brief Adaptive framerate in menu (experimental)
     FlagSetting adaptiveFpsInMenu {false};
+    /// @brief Delay frames start with V-Sync to reduce input latency
+    /// and prevent queueing frames by the driver
+    FlagSetting lowLatency {false};
 };
 
 struct ChunksSettings {
@@ -46,6 +57,29 @@ struct ChunksSettings {
     IntegerSetting loadDistance {22, 3, 80};
     /// @brief Buffer zone where chunks are not unloading (chunk is unit)
     IntegerSetting padding {2, 1, 8};
+    /// @brief Generate chunks voxels in background threads
+    FlagSetting asyncGeneration {true};
+    /// @brief Limit of chunk generator workers count
+    IntegerSetting generatorWorkers {-2, -4, 32};
+    /// @brief Generate chunk prototype stages (biomes, heightmaps,
+    /// structures) ahead in background threads
+    FlagSetting asyncPrototypes {true};
+    /// @brief Limit of prototype stages workers count. Every worker owns
+    /// an instance of the generator script
+    IntegerSetting prototypeWorkers {-4, -4, 32};
+    /// @brief Save chunk prototypes generation results to the world
+    /// folder, so they're not generated again
+    FlagSetting prototypesCache {true};
+    /// @brief Build initial chunk lights in background threads
+    FlagSetting asyncLighting {false};
+    /// @brief Limit of chunk lights workers count
+    IntegerSetting lightsWorkers {-2, -4, 32};
+    /// @brief Max memory of recently unloaded chunks data kept to be
+    /// restored without reading regions and building lights (MiB)
+    IntegerSetting unloadedCache {32, 0, 1024};
+    /// @brief Seconds chunk voxels are not accessed for to be stored
+    /// paletted, using less memory (0 - disabled)
+    IntegerSetting packDelay {30, 0, 600};
 };
 
 struct CameraSettings {
@@ -71,35 +105,60 @@ struct GraphicsSettings {
     FlagSetting backlight {true};
     /// @brief Disable culling with 'optional' mode
     FlagSetting denseRender {true};
+    /// @brief Merge coplanar full-cube block faces into larger quads
+    FlagSetting greedyMeshing {false};
     /// @brief Enable chunks frustum culling
     FlagSetting frustumCulling {true};
+    /// @brief Skip chunk sections hidden behind opaque blocks
+    /// (requires frustum culling)
+    FlagSetting occlusionCulling {true};
+    /// @brief Draw chunks with multi-draw indirect if supported by driver
+    FlagSetting indirectRender {true};
     /// @brief Skybox texture face resolution
     IntegerSetting skyboxResolution {64 + 32, 64, 128};
+    /// @brief Refresh one skybox face per frame during slow sky changes
+    FlagSetting skyboxAmortized {true};
     /// @brief Chunk renderer vertices buffer capacity
     IntegerSetting chunkMaxVertices {200'000, 0, 4'000'000};
     /// @brief Chunk renderer vertices buffer capacity in dense render mode
     IntegerSetting chunkMaxVerticesDense {800'000, 0, 8'000'000};
     /// @brief Limit of chunk renderers count
     IntegerSetting chunkMaxRenderers {6, -4, 32};
+    /// @brief Chunk meshes upload limit per frame in KiB (0 - unlimited)
+    IntegerSetting chunkUploadBudget {4096, 0, 65536};
     /// @brief Particles renderer vertices buffer capacity
     IntegerSetting particlesBatchVertices {4'096, 0, 1'000'000};
     /// @brief Advanced render pipeline
     FlagSetting advancedRender {true};
+    /// @brief Target framerate of the world rendering resolution scaling
+    /// (0 - disabled)
+    IntegerSetting dynamicResolution {0, 0, 240};
+    /// @brief Render consecutive per-pixel post-effects in a single pass
+    FlagSetting postEffectsFusion {true};
     /// @brief Screen space ambient occlusion quality
     IntegerSetting ssao {1, 0, 2};
     /// @brief Shadows quality
     IntegerSetting shadowsQuality {0, 0, 3};
     /// @brief Dense render distance
     IntegerSetting denseRenderDistance {56, 0, 10'000};
+    /// @brief Distance in chunks after which chunks are meshed with lower
+    /// level of detail, doubled for every next level (0 - disabled)
+    IntegerSetting lodDistance {0, 0, 64};
     /// @brief Soft lighting for blocks
     FlagSetting softLighting {true};
     /// @brief Clouds quality level
     IntegerSetting cloudsQuality {2, 0, 2};
+    /// @brief Use block compressed atlas textures (applied on assets reload)
+    FlagSetting atlasCompression {false};
 };
 
 struct PathfindingSettings {
     /// @brief Max visited blocks by an agent per async tick
     IntegerSetting stepsPerAsyncAgent {128, 1, 2048};
+    /// @brief Max visited blocks by all agents per async tick
+    IntegerSetting stepsPerTick {4096, 1, 1 << 20};
+    /// @brief Ticks the shared target routes field is kept before rebuild
+    IntegerSetting sharedFieldTicks {20, 1, 1200};
 };
 
 struct DebugSettings {
@@ -107,6 +166,12 @@ struct DebugSettings {
     FlagSetting generatorTestMode {false};
     /// @brief Write lights cache
     FlagSetting doWriteLights {true};
+    /// @brief Read region files via memory mapping
+    FlagSetting doMapRegionFiles {false};
+    /// @brief Max open region files per layer kept after use
+    IntegerSetting maxOpenRegionFiles {MAX_OPEN_REGION_FILES, 8, 4096};
+    /// @brief Max memory of saved regions data kept per layer (MiB)
+    IntegerSetting regionsMemoryBudget {256, 1, 65536};
     /// @brief Write preprocessed shaders code to user:export
     FlagSetting doTraceShaders {false};
     /// @brief Enable experimental optimizations and features
@@ -119,10 +184,43 @@ struct UiSettings {
 };
 
 struct NetworkSettings {
+    /// @brief Max number of HTTP requests performed at once
+    IntegerSetting maxRequests {8, 1, 64};
+};
+
+struct ScriptingSettings {
+    /// @brief Main state garbage collector is stepped by the engine
+    /// between ticks instead of running on allocations
+    FlagSetting gcStepping {true};
+    /// @brief Heap growth (percents) starting the next collector cycle
+    IntegerSetting gcPause {200, 100, 1000};
+    /// @brief Collector speed relative to allocations (percents)
+    IntegerSetting gcStepMul {200, 100, 1000};
+    /// @brief Min collector time per tick (milliseconds) used when tick
+    /// has no slack
+    NumberSetting gcMinBudget {0.25f, 0.0f, 10.0f};
+    /// @brief Max collector time per tick (milliseconds)
+    NumberSetting gcMaxBudget {2.0f, 0.0f, 50.0f};
+    /// @brief Max number of threads ticking packs worker systems
+    IntegerSetting systemsWorkers {-4, -4, 32};
 };
 
 struct SystemSettings {
     IntegerSetting maxBgAssetLoaders {3, -4, 16};
+    /// @brief Total memory of the accounted consumers evicting caches
+    /// (unloaded chunks, regions, sounds, Lua garbage) when exceeded
+    /// (MiB, 0 - unlimited)
+    IntegerSetting memoryBudget {0, 0, 1 << 20};
+    /// @brief Video memory of the accounted GPU resources. Chunk meshes
+    /// level of detail, shadow maps resolution and blocks atlas mip level
+    /// are lowered when approached (MiB, 0 - unlimited)
+    IntegerSetting videoMemoryBudget {0, 0, 1 << 20};
+    /// @brief Max number of active worker threads of all thread pools
+    /// (0 - number of cores minus the main thread)
+    IntegerSetting workerThreads {0, 0, 256};
+    /// @brief Keep the main thread on a dedicated core, worker threads
+    /// on the rest (applied to threads started after)
+    FlagSetting pinThreads {false};
 };
 
 struct EngineSettings {
@@ -135,5 +233,6 @@ struct EngineSettings {
     UiSettings ui;
     NetworkSettings network;
     PathfindingSettings pathfinding;
+    ScriptingSettings scripting;
     SystemSettings system;
 };
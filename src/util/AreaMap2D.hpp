@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdlib>
 #include <vector>
 #include <stdexcept>
 #include <functional>
@@ -7,6 +9,8 @@
 
 namespace util {
 
+    /// @brief Sliding window 2D map. Values are stored in a toroidal
+    /// buffer, so moving the window affects only cells going out of it
     template<class T, typename TCoord=int>
     class AreaMap2D {
     public:
@@ -14,61 +18,92 @@ namespace util {
     private:
         TCoord offsetX = 0, offsetY = 0;
         TCoord sizeX, sizeY;
-        std::vector<T> firstBuffer;
-        std::vector<T> secondBuffer;
+        std::vector<T> buffer;
         OutCallback outCallback;
 
         size_t valuesCount = 0;
-    
+
+        bool isInsideLocal(TCoord lx, TCoord ly) const {
+            return !(lx < 0 || ly < 0 || lx >= sizeX || ly >= sizeY);
+        }
+
+        /// @brief Get buffer index of the position inside of the window
+        size_t indexOf(TCoord x, TCoord y) const {
+            TCoord bx = x % sizeX;
+            TCoord by = y % sizeY;
+            if (bx < 0) {
+                bx += sizeX;
+            }
+            if (by < 0) {
+                by += sizeY;
+            }
+            return by * sizeX + bx;
+        }
+
+        /// @brief Remove value calling out-callback
+        void release(TCoord x, TCoord y) {
+            auto& element = buffer[indexOf(x, y)];
+            if (element == T{}) {
+                return;
+            }
+            auto value = std::move(element);
+            element = T{};
+            if (outCallback) {
+                outCallback(x, y, value);
+            }
+            valuesCount--;
+        }
+
         void translate(TCoord dx, TCoord dy) {
             if (dx == 0 && dy == 0) {
                 return;
             }
-            std::fill(secondBuffer.begin(), secondBuffer.end(), T{});
-            for (TCoord y = 0; y < sizeY; y++) {
-                for (TCoord x = 0; x < sizeX; x++) {
-                    auto value = std::move(firstBuffer[y * sizeX + x]);
-                    auto nx = x - dx;
-                    auto ny = y - dy;
-                    if (value == T{}) {
-                        continue;
+            TCoord newOffsetX = offsetX + dx;
+            TCoord newOffsetY = offsetY + dy;
+            if (std::abs(dx) >= sizeX || std::abs(dy) >= sizeY) {
+                for (TCoord y = offsetY; y < offsetY + sizeY; y++) {
+                    for (TCoord x = offsetX; x < offsetX + sizeX; x++) {
+                        release(x, y);
                     }
-                    if (nx < 0 || ny < 0 || nx >= sizeX || ny >= sizeY) {
-                        if (outCallback) {
-                            outCallback(x + offsetX, y + offsetY, value);
-                        }
-                        valuesCount--;
-                        continue;
+                }
+            } else {
+                // columns going out of the window
+                TCoord fromX = dx > 0 ? offsetX : offsetX + sizeX + dx;
+                for (TCoord y = offsetY; y < offsetY + sizeY; y++) {
+                    for (TCoord x = fromX; x < fromX + std::abs(dx); x++) {
+                        release(x, y);
+                    }
+                }
+                // rows going out of the window, except released columns
+                TCoord keepFromX = std::max(offsetX, newOffsetX);
+                TCoord keepToX = std::min(offsetX + sizeX, newOffsetX + sizeX);
+                TCoord fromY = dy > 0 ? offsetY : offsetY + sizeY + dy;
+                for (TCoord y = fromY; y < fromY + std::abs(dy); y++) {
+                    for (TCoord x = keepFromX; x < keepToX; x++) {
+                        release(x, y);
                     }
-                    secondBuffer[ny * sizeX + nx] = std::move(value);
                 }
             }
-            std::swap(firstBuffer, secondBuffer);
-            offsetX += dx;
-            offsetY += dy;
+            offsetX = newOffsetX;
+            offsetY = newOffsetY;
         }
     public:
         AreaMap2D(TCoord width, TCoord height)
-            : sizeX(width), sizeY(height), 
-              firstBuffer(width * height), secondBuffer(width * height) {
+            : sizeX(width), sizeY(height), buffer(width * height) {
         }
 
         const T* getIf(TCoord x, TCoord y) const {
-            auto lx = x - offsetX;
-            auto ly = y - offsetY;
-            if (lx < 0 || ly < 0 || lx >= sizeX || ly >= sizeY) {
+            if (!isInside(x, y)) {
                 return nullptr;
             }
-            return &firstBuffer[ly * sizeX + lx];
+            return &buffer[indexOf(x, y)];
         }
 
         T get(TCoord x, TCoord y) const {
-            auto lx = x - offsetX;
-            auto ly = y - offsetY;
-            if (lx < 0 || ly < 0 || lx >= sizeX || ly >= sizeY) {
+            if (!isInside(x, y)) {
                 return T{};
             }
-            return firstBuffer[ly * sizeX + lx];
+            return buffer[indexOf(x, y)];
         }
 
         T get(TCoord x, TCoord y, const T& def) const {
@@ -83,27 +118,21 @@ namespace util {
         }
 
         bool isInside(TCoord x, TCoord y) const {
-            auto lx = x - offsetX;
-            auto ly = y - offsetY;
-            return !(lx < 0 || ly < 0 || lx >= sizeX || ly >= sizeY);
+            return isInsideLocal(x - offsetX, y - offsetY);
         }
 
         const T& require(TCoord x, TCoord y) const {
-            auto lx = x - offsetX;
-            auto ly = y - offsetY;
-            if (lx < 0 || ly < 0 || lx >= sizeX || ly >= sizeY) {
+            if (!isInside(x, y)) {
                 throw std::invalid_argument("position is out of window");
             }
-            return firstBuffer[ly * sizeX + lx];
+            return buffer[indexOf(x, y)];
         }
 
         bool set(TCoord x, TCoord y, T value) {
-            auto lx = x - offsetX;
-            auto ly = y - offsetY;
-            if (lx < 0 || ly < 0 || lx >= sizeX || ly >= sizeY) {
+            if (!isInside(x, y)) {
                 return false;
             }
-            auto& element = firstBuffer[ly * sizeX + lx];
+            auto& element = buffer[indexOf(x, y)];
             if (value && !element) {
                 valuesCount++;
             }
@@ -115,14 +144,16 @@ namespace util {
         }
 
         void remove(TCoord x, TCoord y) {
-            auto lx = x - offsetX;
-            auto ly = y - offsetY;
-            if (lx < 0 || ly < 0 || lx >= sizeX || ly >= sizeY) {
+            if (!isInside(x, y)) {
                 return;
             }
+            auto& element = buffer[indexOf(x, y)];
             if (outCallback)
-                outCallback(x, y, firstBuffer[ly * sizeX + lx]);
-            firstBuffer[ly * sizeX + lx] = T{};
+                outCallback(x, y, element);
+            if (element != T{}) {
+                valuesCount--;
+            }
+            element = T{};
         }
 
         void setOutCallback(const OutCallback& callback) {
@@ -130,30 +161,46 @@ namespace util {
         }
 
         void resize(TCoord newSizeX, TCoord newSizeY) {
+            // shrinking window keeps its center
+            TCoord newOffsetX = offsetX;
+            TCoord newOffsetY = offsetY;
             if (newSizeX < sizeX) {
-                TCoord delta = sizeX - newSizeX;
-                translate(delta / 2, 0);
-                translate(-delta, 0);
-                translate(delta, 0);
+                newOffsetX += (sizeX - newSizeX) / 2;
             }
             if (newSizeY < sizeY) {
-                TCoord delta = sizeY - newSizeY;
-                translate(0, delta / 2);
-                translate(0, -delta);
-                translate(0, delta);
-            }
-            const TCoord newVolume = newSizeX * newSizeY;
-            std::vector<T> newFirstBuffer(newVolume);
-            std::vector<T> newSecondBuffer(newVolume);
-            for (TCoord y = 0; y < sizeY && y < newSizeY; y++) {
-                for (TCoord x = 0; x < sizeX && x < newSizeX; x++) {
-                    newFirstBuffer[y * newSizeX + x] = firstBuffer[y * sizeX + x];
-                }
+                newOffsetY += (sizeY - newSizeY) / 2;
             }
+            std::vector<T> oldBuffer(newSizeX * newSizeY);
+            std::swap(buffer, oldBuffer);
+            TCoord oldSizeX = sizeX;
+            TCoord oldSizeY = sizeY;
+            TCoord oldOffsetX = offsetX;
+            TCoord oldOffsetY = offsetY;
             sizeX = newSizeX;
             sizeY = newSizeY;
-            firstBuffer = std::move(newFirstBuffer);
-            secondBuffer = std::move(newSecondBuffer);
+            offsetX = newOffsetX;
+            offsetY = newOffsetY;
+
+            for (TCoord y = oldOffsetY; y < oldOffsetY + oldSizeY; y++) {
+                for (TCoord x = oldOffsetX; x < oldOffsetX + oldSizeX; x++) {
+                    TCoord bx = x % oldSizeX;
+                    TCoord by = y % oldSizeY;
+                    bx += bx < 0 ? oldSizeX : 0;
+                    by += by < 0 ? oldSizeY : 0;
+                    auto& value = oldBuffer[by * oldSizeX + bx];
+                    if (value == T{}) {
+                        continue;
+                    }
+                    if (isInside(x, y)) {
+                        buffer[indexOf(x, y)] = std::move(value);
+                        continue;
+                    }
+                    if (outCallback) {
+                        outCallback(x, y, value);
+                    }
+                    valuesCount--;
+                }
+            }
         }
 
         void setCenter(TCoord centerX, TCoord centerY) {
@@ -165,14 +212,9 @@ namespace util {
         }
 
         void clear() {
-            for (TCoord y = 0; y < sizeY; y++) {
-                for (TCoord x = 0; x < sizeX; x++) {
-                    auto i = y * sizeX + x;
-                    auto value = firstBuffer[i];
-                    firstBuffer[i] = {};
-                    if (outCallback && value != T {}) {
-                        outCallback(x + offsetX, y + offsetY, value);
-                    }
+            for (TCoord y = offsetY; y < offsetY + sizeY; y++) {
+                for (TCoord x = offsetX; x < offsetX + sizeX; x++) {
+                    release(x, y);
                 }
             }
             valuesCount = 0;
@@ -194,8 +236,15 @@ namespace util {
             return sizeY;
         }
 
+        /// @brief Get values storage. Order of values does not match
+        /// their positions, use getLocal for positional access
         const std::vector<T>& getBuffer() const {
-            return firstBuffer;
+            return buffer;
+        }
+
+        /// @brief Get value by position relative to the window offset
+        const T& getLocal(TCoord lx, TCoord ly) const {
+            return buffer[indexOf(lx + offsetX, ly + offsetY)];
         }
 
         size_t count() const {
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace util {
+    /// @brief Open addressing hash map with 64 bit integer keys.
+    /// Robin Hood linear probing keeps probe sequences short at high load,
+    /// so lookup does mostly one cache line access instead of buckets
+    /// list traversal. Erase uses backward shift (no tombstones).
+    /// @attention pointers to values are invalidated by insertion and
+    /// erase. Concurrent reads are safe while the map is not modified
+    /// @tparam V default constructible movable value type
+    template <typename V>
+    class FlatMap {
+    public:
+        using value_type = std::pair<uint64_t, V>;
+    private:
+        struct Slot {
+            value_type entry {};
+            /// @brief Probe sequence length + 1 (0 - empty slot)
+            uint32_t probe = 0;
+        };
+
+        std::vector<Slot> slots;
+        size_t count = 0;
+        size_t mask = 0;
+
+        static size_t hash(uint64_t key) {
+            // murmur3 finalizer
+            key ^= key >> 33;
+            key *= 0xff51afd7ed558ccdULL;
+            key ^= key >> 33;
+            key *= 0xc4ceb9fe1a85ec53ULL;
+            key ^= key >> 33;
+            return static_cast<size_t>(key);
+        }
+
+        long indexOf(uint64_t key) const {
+            if (count == 0) {
+                return -1;
+            }
+            size_t index = hash(key) & mask;
+            for (uint32_t probe = 1;; probe++) {
+                const auto& slot = slots[index];
+                // every key with a longer probe would be placed here
+                if (slot.probe < probe) {
+                    return -1;
+                }
+                if (slot.entry.first == key) {
+                    return index;
+                }
+                index = (index + 1) & mask;
+            }
+        }
+
+        /// @brief Insert key missing in the map
+        /// @return value slot index
+        size_t place(uint64_t key, V&& value) {
+            Slot current {{key, std::move(value)}, 1};
+            size_t index = hash(key) & mask;
+            size_t placed = slots.size();
+            while (true) {
+                auto& slot = slots[index];
+                if (slot.probe == 0) {
+                    slot = std::move(current);
+                    count++;
+                    return placed == slots.size() ? index : placed;
+                }
+                if (slot.probe < current.probe) {
+                    std::swap(slot, current);
+                    if (placed == slots.size()) {
+                        placed = index;
+                    }
+                }
+                index = (index + 1) & mask;
+                current.probe++;
+            }
+        }
+
+        void rehash(size_t capacity) {
+            auto old = std::move(slots);
+            slots = std::vector<Slot>(capacity);
+            mask = capacity - 1;
+            count = 0;
+            for (auto& slot : old) {
+                if (slot.probe) {
+                    place(slot.entry.first, std::move(slot.entry.second));
+                }
+            }
+        }
+
+        template <typename SlotT, typename EntryT>
+        class Iterator {
+            SlotT* slot;
+            SlotT* end;
+
+            void skipEmpty() {
+                while (slot != end && slot->probe == 0) {
+                    slot++;
+                }
+            }
+        public:
+            Iterator(SlotT* slot, SlotT* end) : slot(slot), end(end) {
+                skipEmpty();
+            }
+
+            EntryT& operator*() const {
+                return slot->entry;
+            }
+
+            EntryT* operator->() const {
+                return &slot->entry;
+            }
+
+            Iterator& operator++() {
+                slot++;
+                skipEmpty();
+                return *this;
+            }
+
+            bool operator!=(const Iterator& o) const {
+                return slot != o.slot;
+            }
+        };
+    public:
+        using iterator = Iterator<Slot, value_type>;
+        using const_iterator = Iterator<const Slot, const value_type>;
+
+        /// @return value pointer or nullptr if key is not found
+        V* find(uint64_t key) {
+            long index = indexOf(key);
+            return index < 0 ? nullptr : &slots[index].entry.second;
+        }
+
+        /// @return value pointer or nullptr if key is not found
+        const V* find(uint64_t key) const {
+            long index = indexOf(key);
+            return index < 0 ? nullptr : &slots[index].entry.second;
+        }
+
+        /// @brief Get value inserting default one if key is not found
+        V& operator[](uint64_t key) {
+            long index = indexOf(key);
+            if (index >= 0) {
+                return slots[index].entry.second;
+            }
+            // max load factor is 0.75
+            if ((count + 1) * 4 > slots.size() * 3) {
+                rehash(slots.empty() ? 16 : slots.size() * 2);
+            }
+            return slots[place(key, V {})].entry.second;
+        }
+
+        /// @return true if key was found and erased
+        bool erase(uint64_t key) {
+            long found = indexOf(key);
+            if (found < 0) {
+                return false;
+            }
+            size_t index = found;
+            size_t next = (index + 1) & mask;
+            // shift following entries back to keep probe sequences unbroken
+            while (slots[next].probe > 1) {
+                slots[index] = std::move(slots[next]);
+                slots[index].probe--;
+                index = next;
+                next = (next + 1) & mask;
+            }
+            slots[index] = Slot {};
+            count--;
+            return true;
+        }
+
+        void clear() {
+            slots.clear();
+            count = 0;
+            mask = 0;
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+        bool empty() const {
+            return count == 0;
+        }
+
+        iterator begin() {
+            return iterator(slots.data(), slots.data() + slots.size());
+        }
+
+        iterator end() {
+            auto end = slots.data() + slots.size();
+            return iterator(end, end);
+        }
+
+        const_iterator begin() const {
+            return const_iterator(slots.data(), slots.data() + slots.size());
+        }
+
+        const_iterator end() const {
+            auto end = slots.data() + slots.size();
+            return const_iterator(end, end);
+        }
+    };
+}
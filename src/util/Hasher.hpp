@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <type_traits>
+
+#include "typedefs.hpp"
+
+namespace util {
+    /// @brief FNV-1a 64 bit hash builder (not cryptographic, used for
+    /// cache keys)
+    class Hasher {
+        uint64_t value = 0xcbf29ce484222325ULL;
+    public:
+        void update(const void* data, size_t size) {
+            auto bytes = static_cast<const ubyte*>(data);
+            for (size_t i = 0; i < size; i++) {
+                value ^= bytes[i];
+                value *= 0x100000001b3ULL;
+            }
+        }
+
+        void update(const std::string& str) {
+            update(str.data(), str.size() + 1);
+        }
+
+        template <typename T>
+        void update(T number) {
+            static_assert(std::is_arithmetic_v<T>);
+            update(&number, sizeof(T));
+        }
+
+        uint64_t get() const {
+            return value;
+        }
+    };
+}
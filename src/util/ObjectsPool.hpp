@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <vector>
@@ -7,6 +8,8 @@
 
 #if defined(_WIN32)
 #include <malloc.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
 #endif
 
 namespace util {
@@ -20,20 +23,28 @@ namespace util {
         }
     };
 
+    /// @brief Pool of objects allocated in slabs. Memory of released
+    /// objects is reused and never returned to the system
     template <class T>
     class ObjectsPool {
     public:
-        ObjectsPool(size_t preallocated = 0) {
-            for (size_t i = 0; i < preallocated; i++) {
-                allocateNew();
-            }
+        /// @brief Slabs of at least this size are aligned to it and backed
+        /// by transparent huge pages where available
+        static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+        /// @param preallocated number of objects allocated ahead
+        /// @param slabSize target size of the objects slab (bytes). Slab
+        /// holds at least one object
+        ObjectsPool(size_t preallocated = 0, size_t slabSize = HUGE_PAGE_SIZE)
+            : slabObjects(std::max<size_t>(1, slabSize / STRIDE)) {
+            reserve(preallocated);
         }
 
         template<typename... Args>
         std::shared_ptr<T> create(Args&&... args) {
             std::lock_guard lock(mutex);
             if (freeObjects.empty()) {
-                if (!allocateNew()) {
+                if (!allocateSlab()) {
                     return std::make_shared<T>(std::forward<Args>(args)...);
                 }
             }
@@ -47,31 +58,63 @@ namespace util {
             });
         }
 
+        /// @brief Allocate slabs until the pool has at least the given
+        /// number of objects
+        void reserve(size_t count) {
+            std::lock_guard lock(mutex);
+            while (totalObjects < count) {
+                if (!allocateSlab()) {
+                    return;
+                }
+            }
+        }
+
         size_t countTotal() const {
-            return objects.size();
+            return totalObjects;
         }
 
         size_t countFree() const {
             return freeObjects.size();
         }
     private:
-        std::vector<std::unique_ptr<void, AlignedDeleter>> objects;
+        static constexpr size_t STRIDE =
+            (sizeof(T) + alignof(T) - 1) / alignof(T) * alignof(T);
+
+        const size_t slabObjects;
+        size_t totalObjects = 0;
+        std::vector<std::unique_ptr<void, AlignedDeleter>> slabs;
         std::queue<void*> freeObjects;
         std::mutex mutex;
 
-        bool allocateNew() {
-            std::unique_ptr<void, AlignedDeleter> ptr(
+        bool allocateSlab() {
+            size_t size = slabObjects * STRIDE;
+            size_t alignment = alignof(T);
+            if (size >= HUGE_PAGE_SIZE) {
+                alignment = std::max(alignment, HUGE_PAGE_SIZE);
+            }
+            // aligned_alloc requires size to be multiple of the alignment
+            size = (size + alignment - 1) / alignment * alignment;
+            std::unique_ptr<void, AlignedDeleter> slab(
 #if defined(_WIN32)
-                _aligned_malloc(sizeof(T), alignof(T))
+                _aligned_malloc(size, alignment)
 #else
-                std::aligned_alloc(alignof(T), sizeof(T))
+                std::aligned_alloc(alignment, size)
 #endif
             );
-            if (ptr == nullptr) {
+            if (slab == nullptr) {
                 return false;
             }
-            freeObjects.push(ptr.get());
-            objects.push_back(std::move(ptr));
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+            if (alignment >= HUGE_PAGE_SIZE) {
+                madvise(slab.get(), size, MADV_HUGEPAGE);
+            }
+#endif
+            auto bytes = static_cast<unsigned char*>(slab.get());
+            for (size_t i = 0; i < slabObjects; i++) {
+                freeObjects.push(bytes + i * STRIDE);
+            }
+            totalObjects += slabObjects;
+            slabs.push_back(std::move(slab));
             return true;
         }
     };
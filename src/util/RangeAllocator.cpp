@@ -0,0 +1,79 @@
+#include "RangeAllocator.hpp"
+
+using namespace util;
+
+RangeAllocator::RangeAllocator(size_t capacity)
+    : capacity(capacity), freeSize(0) {
+    reset();
+}
+
+std::optional<size_t> RangeAllocator::allocate(size_t size) {
+    if (size == 0 || size > freeSize) {
+        return std::nullopt;
+    }
+    for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+        if (it->second < size) {
+            continue;
+        }
+        size_t offset = it->first;
+        size_t rest = it->second - size;
+        freeRanges.erase(it);
+        if (rest) {
+            freeRanges[offset + size] = rest;
+        }
+        freeSize -= size;
+        return offset;
+    }
+    return std::nullopt;
+}
+
+void RangeAllocator::free(size_t offset, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    freeSize += size;
+
+    auto next = freeRanges.lower_bound(offset);
+    if (next != freeRanges.end() && offset + size == next->first) {
+        size += next->second;
+        next = freeRanges.erase(next);
+    }
+    if (next != freeRanges.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            prev->second += size;
+            return;
+        }
+    }
+    freeRanges[offset] = size;
+}
+
+bool RangeAllocator::resize(size_t offset, size_t size, size_t newSize) {
+    if (newSize == size) {
+        return true;
+    }
+    if (newSize < size) {
+        free(offset + newSize, size - newSize);
+        return true;
+    }
+    auto next = freeRanges.find(offset + size);
+    size_t extra = newSize - size;
+    if (next == freeRanges.end() || next->second < extra) {
+        return false;
+    }
+    size_t rest = next->second - extra;
+    freeRanges.erase(next);
+    if (rest) {
+        freeRanges[offset + newSize] = rest;
+    }
+    freeSize -= extra;
+    return true;
+}
+
+void RangeAllocator::reset() {
+    freeRanges.clear();
+    if (capacity) {
+        freeRanges[0] = capacity;
+    }
+    freeSize = capacity;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <map>
+#include <optional>
+
+namespace util {
+    /// @brief First-fit allocator of ranges inside [0, capacity).
+    /// Does not own any memory, used to sub-allocate large buffers
+    class RangeAllocator {
+        size_t capacity;
+        size_t freeSize;
+        /// @brief Free ranges sizes by offset
+        std::map<size_t, size_t> freeRanges;
+    public:
+        explicit RangeAllocator(size_t capacity);
+
+        /// @brief Allocate range of the specified size
+        /// @return range offset or std::nullopt if there is no free range
+        /// large enough
+        std::optional<size_t> allocate(size_t size);
+
+        /// @brief Return range to the allocator. Merges with adjacent
+        /// free ranges
+        /// @param offset range offset returned by allocate(...)
+        /// @param size range size used in allocate(...)
+        void free(size_t offset, size_t size);
+
+        /// @brief Try to change size of the allocated range in-place
+        /// @return true if range now has the new size
+        bool resize(size_t offset, size_t size, size_t newSize);
+
+        /// @brief Make whole capacity free
+        void reset();
+
+        size_t getCapacity() const {
+            return capacity;
+        }
+
+        size_t getFreeSize() const {
+            return freeSize;
+        }
+
+        /// @return number of free ranges (fragmentation metric)
+        size_t getFreeRangesCount() const {
+            return freeRanges.size();
+        }
+    };
+}
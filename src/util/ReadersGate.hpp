@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+namespace util {
+    /// @brief Lets other threads read data owned by a thread while the
+    /// owner guarantees it is not modified (gate is open).
+    ///
+    /// Closing the gate waits for the entered readers to leave, the rest
+    /// wait for the gate to be opened again.
+    class ReadersGate {
+        std::mutex mutex;
+        std::condition_variable variable;
+        int readers = 0;
+        bool opened = false;
+        bool stopped = false;
+    public:
+        /// @brief Allow readers to enter
+        void open() {
+            std::lock_guard lock(mutex);
+            opened = true;
+            variable.notify_all();
+        }
+
+        /// @brief Forbid entering and wait for the entered readers to leave
+        void close() {
+            std::unique_lock lock(mutex);
+            opened = false;
+            variable.wait(lock, [this]() { return readers == 0; });
+        }
+
+        /// @brief Release waiting readers. Gate is never opened after
+        void stop() {
+            std::lock_guard lock(mutex);
+            stopped = true;
+            variable.notify_all();
+        }
+
+        /// @brief Wait for the gate to be opened and enter it
+        /// @return false if the gate is stopped (not entered)
+        bool enter() {
+            std::unique_lock lock(mutex);
+            variable.wait(lock, [this]() { return opened || stopped; });
+            if (stopped) {
+                return false;
+            }
+            readers++;
+            return true;
+        }
+
+        /// @brief Leave entered gate
+        void leave() {
+            std::lock_guard lock(mutex);
+            if (--readers == 0) {
+                variable.notify_all();
+            }
+        }
+    };
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "span.hpp"
+
+namespace util {
+    /// @brief Growable FIFO of trivially copyable elements stored in a
+    /// circular buffer. Data is written to and read from the storage directly
+    /// via contiguous regions, so no intermediate buffers are required.
+    /// @tparam T element type
+    template <typename T>
+    class RingBuffer {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        std::unique_ptr<T[]> buffer;
+        /// @brief Storage size (power of 2)
+        size_t capacity;
+        /// @brief Index of the first readable element
+        size_t front = 0;
+        size_t count = 0;
+
+        size_t index(size_t offset) const {
+            return (front + offset) & (capacity - 1);
+        }
+
+        void reallocate(size_t newCapacity) {
+            auto newBuffer = std::make_unique<T[]>(newCapacity);
+            peek(newBuffer.get(), count);
+            buffer = std::move(newBuffer);
+            capacity = newCapacity;
+            front = 0;
+        }
+    public:
+        /// @param initCapacity initial capacity (must be positive power of 2)
+        explicit RingBuffer(size_t initCapacity = 4096)
+            : buffer(std::make_unique<T[]>(initCapacity)),
+              capacity(initCapacity) {
+            if (initCapacity == 0 || (initCapacity & (initCapacity - 1)) != 0) {
+                throw std::invalid_argument(
+                    "initCapacity must be positive power of 2"
+                );
+            }
+        }
+
+        /// @brief Make sure at least n elements may be written without
+        /// reallocation
+        void reserve(size_t n) {
+            if (count + n <= capacity) {
+                return;
+            }
+            size_t newCapacity = capacity;
+            while (newCapacity < count + n) {
+                newCapacity *= 2;
+            }
+            reallocate(newCapacity);
+        }
+
+        /// @brief Get contiguous free region following the written data.
+        /// Grows the storage if less than minSize elements are available
+        /// in one piece.
+        /// @attention region becomes invalid after any non-const call
+        /// except commit(...)
+        std::pair<T*, size_t> prepare(size_t minSize = 1) {
+            reserve(minSize);
+            size_t back = index(count);
+            size_t length = std::min(capacity - count, capacity - back);
+            if (length < minSize) {
+                // free space is split by the storage end
+                reallocate(capacity);
+                back = count;
+                length = capacity - count;
+            }
+            return {buffer.get() + back, length};
+        }
+
+        /// @brief Append n elements written to the region returned by
+        /// prepare(...)
+        void commit(size_t n) {
+            count += n;
+        }
+
+        /// @brief Append elements copy
+        void write(const T* data, size_t n) {
+            reserve(n);
+            size_t back = index(count);
+            size_t first = std::min(n, capacity - back);
+            std::memcpy(buffer.get() + back, data, first * sizeof(T));
+            std::memcpy(buffer.get(), data + first, (n - first) * sizeof(T));
+            count += n;
+        }
+
+        /// @brief Get contiguous readable region starting at offset.
+        /// At most two regions exist: readable(0) and readable(first.size())
+        /// @attention region becomes invalid after any non-const call
+        span<T> readable(size_t offset = 0) const {
+            if (offset >= count) {
+                return span<T>(buffer.get(), 0);
+            }
+            size_t start = index(offset);
+            return span<T>(
+                buffer.get() + start,
+                std::min(count - offset, capacity - start)
+            );
+        }
+
+        /// @brief Copy up to n first elements without consuming them
+        /// @return number of copied elements
+        size_t peek(T* dst, size_t n) const {
+            n = std::min(n, count);
+            auto first = readable(0);
+            size_t length = std::min(n, first.size());
+            std::memcpy(dst, first.data(), length * sizeof(T));
+            std::memcpy(dst + length, buffer.get(), (n - length) * sizeof(T));
+            return n;
+        }
+
+        /// @brief Drop up to n first elements
+        /// @return number of dropped elements
+        size_t consume(size_t n) {
+            n = std::min(n, count);
+            front = index(n);
+            count -= n;
+            if (count == 0) {
+                // keep next writes contiguous
+                front = 0;
+            }
+            return n;
+        }
+
+        /// @brief Copy and consume up to n first elements
+        /// @return number of read elements
+        size_t read(T* dst, size_t n) {
+            return consume(peek(dst, n));
+        }
+
+        void clear() {
+            front = 0;
+            count = 0;
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+        bool empty() const {
+            return count == 0;
+        }
+
+        size_t getCapacity() const {
+            return capacity;
+        }
+    };
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <vector>
@@ -23,30 +24,54 @@ namespace util {
     /// @tparam Tsize entry size type
     template <typename Tindex, typename Tsize>
     class SmallHeap {
+        static constexpr size_t HEADER_SIZE = sizeof(Tindex) + sizeof(Tsize);
+
         std::vector<uint8_t> buffer;
-        Tindex entriesCount;
+        /// @brief Sorted entries indices (entries are stored in the same
+        /// order), side-table for binary search, not serialized
+        std::vector<Tindex> indices;
+        /// @brief Entries data offsets in the buffer
+        std::vector<size_t> offsets;
+
+        /// @return position of the first entry with index not less than
+        /// the given one
+        size_t lowerBound(Tindex index) const {
+            return std::lower_bound(indices.begin(), indices.end(), index) -
+                   indices.begin();
+        }
+
+        /// @brief Shift offsets of entries starting from position
+        void shiftOffsets(size_t pos, ptrdiff_t delta) {
+            for (size_t i = pos; i < offsets.size(); i++) {
+                offsets[i] += delta;
+            }
+        }
+
+        void rebuildIndex() {
+            indices.clear();
+            offsets.clear();
+            size_t offset = 0;
+            while (offset + HEADER_SIZE <= buffer.size()) {
+                auto data = buffer.data() + offset;
+                indices.push_back(read_int_le<Tindex>(data));
+                offsets.push_back(offset + HEADER_SIZE);
+                offset += HEADER_SIZE +
+                          read_int_le<Tsize>(data + sizeof(Tindex));
+            }
+        }
     public:
-        SmallHeap() : entriesCount(0) {}
+        SmallHeap() = default;
 
         /// @brief Find current entry address by index
         /// @param index entry index
         /// @return temporary raw pointer or nullptr if entry does not exists
         /// @attention pointer becomes invalid after allocate(...) or free(...)
         uint8_t* find(Tindex index) {
-            auto data = buffer.data();
-            for (size_t i = 0; i < entriesCount; i++) {
-                auto nextIndex = read_int_le<Tindex>(data);
-                data += sizeof(Tindex);
-                auto nextSize = read_int_le<Tsize>(data);
-                data += sizeof(Tsize);
-                if (nextIndex == index) {
-                    return data;
-                } else if (nextIndex > index) {
-                    return nullptr;
-                }
-                data += nextSize;
+            size_t pos = lowerBound(index);
+            if (pos == indices.size() || indices[pos] != index) {
+                return nullptr;
             }
-            return nullptr;
+            return buffer.data() + offsets[pos];
         }
 
         /// @brief Erase entry from the heap
@@ -55,14 +80,16 @@ namespace util {
             if (ptr == nullptr) {
                 return;
             }
-            auto entrySize = sizeOf(ptr);
-            auto begin =
-                buffer.begin() +
-                ((ptr - sizeof(Tsize) - sizeof(Tindex)) - buffer.data());
-            buffer.erase(
-                begin, begin + entrySize + sizeof(Tsize) + sizeof(Tindex)
-            );
-            entriesCount--;
+            size_t offset = ptr - buffer.data();
+            size_t pos =
+                std::lower_bound(offsets.begin(), offsets.end(), offset) -
+                offsets.begin();
+            size_t entrySize = sizeOf(ptr) + HEADER_SIZE;
+            auto begin = buffer.begin() + (offset - HEADER_SIZE);
+            buffer.erase(begin, begin + entrySize);
+            indices.erase(indices.begin() + pos);
+            offsets.erase(offsets.begin() + pos);
+            shiftOffsets(pos, -static_cast<ptrdiff_t>(entrySize));
         }
 
         /// @brief Create or update entry (size)
@@ -80,7 +107,6 @@ namespace util {
             if (size == 0) {
                 throw std::invalid_argument("zero size");
             }
-            ptrdiff_t offset = 0;
             if (auto found = find(index)) {
                 auto entrySize = sizeOf(found);
                 if (size == entrySize) {
@@ -88,26 +114,16 @@ namespace util {
                     return found;
                 }
                 this->free(found);
-                return allocate(index, size);
-            }
-            for (size_t i = 0; i < entriesCount; i++) {
-                auto data = buffer.data() + offset;
-                auto nextIndex = read_int_le<Tindex>(data);
-                data += sizeof(Tindex);
-                auto nextSize = read_int_le<Tsize>(data);
-                data += sizeof(Tsize);
-                if (nextIndex > index) {
-                    break;
-                }
-                data += nextSize;
-                offset = data - buffer.data();
             }
+            size_t pos = lowerBound(index);
+            size_t offset = pos < offsets.size() ? offsets[pos] - HEADER_SIZE
+                                                 : buffer.size();
             buffer.insert(
-                buffer.begin() + offset,
-                size + sizeof(Tindex) + sizeof(Tsize),
-                0
+                buffer.begin() + offset, size + HEADER_SIZE, 0
             );
-            entriesCount++;
+            shiftOffsets(pos, size + HEADER_SIZE);
+            indices.insert(indices.begin() + pos, index);
+            offsets.insert(offsets.begin() + pos, offset + HEADER_SIZE);
 
             auto data = buffer.data() + offset;
             *reinterpret_cast<Tindex*>(data) = dataio::h2le(index);
@@ -127,7 +143,7 @@ namespace util {
 
         /// @return number of entries
         Tindex count() const {
-            return entriesCount;
+            return static_cast<Tindex>(indices.size());
         }
 
         /// @return total used bytes including entries metadata
@@ -136,9 +152,6 @@ namespace util {
         }
 
         inline bool operator==(const SmallHeap<Tindex, Tsize>& o) const {
-            if (o.entriesCount != entriesCount) {
-                return false;
-            }
             return buffer == o.buffer;
         }
 
@@ -147,7 +160,7 @@ namespace util {
             ubyte* dst = out.data();
             const ubyte* src = buffer.data();
 
-            *reinterpret_cast<Tindex*>(dst) = dataio::h2le(entriesCount);
+            *reinterpret_cast<Tindex*>(dst) = dataio::h2le(count());
             dst += sizeof(Tindex);
 
             std::memcpy(dst, src, buffer.size());
@@ -155,9 +168,9 @@ namespace util {
         }
 
         void deserialize(const ubyte* src, size_t size) {
-            entriesCount = read_int_le<Tindex>(src);
             buffer.resize(size - sizeof(Tindex));
             std::memcpy(buffer.data(), src + sizeof(Tindex), buffer.size());
+            rebuildIndex();
         }
 
         struct const_iterator {
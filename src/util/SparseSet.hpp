@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "FlatMap.hpp"
+
+namespace util {
+    /// @brief Map of 64 bit integer ids to values stored in dense arrays.
+    /// Sequentially allocated ids are resolved via paged sparse array
+    /// (two indexed reads, no hashing), ids beyond the paged range fall back
+    /// to a hash map. Erase moves the last element to the freed place.
+    /// @attention pointers to values are invalidated by insertion and erase
+    /// @tparam V movable value type
+    template <typename V>
+    class SparseSet {
+        static constexpr int PAGE_BITS = 12;
+        static constexpr size_t PAGE_SIZE = 1 << PAGE_BITS;
+        /// @brief Ids below are stored in pages (at most 64K pages)
+        static constexpr uint64_t MAX_PAGED_ID = uint64_t(1) << 28;
+
+        struct Page {
+            /// @brief Dense index + 1 (0 - no element)
+            std::unique_ptr<uint32_t[]> indices;
+            size_t count = 0;
+        };
+
+        std::vector<Page> pages;
+        FlatMap<uint32_t> overflow;
+        std::vector<uint64_t> denseIds;
+        std::vector<V> denseValues;
+
+        uint32_t* slotOf(uint64_t id) {
+            if (id >= MAX_PAGED_ID) {
+                return overflow.find(id);
+            }
+            size_t page = id >> PAGE_BITS;
+            if (page >= pages.size() || pages[page].indices == nullptr) {
+                return nullptr;
+            }
+            uint32_t* slot = &pages[page].indices[id & (PAGE_SIZE - 1)];
+            return *slot ? slot : nullptr;
+        }
+
+        void setSlot(uint64_t id, uint32_t index) {
+            if (id >= MAX_PAGED_ID) {
+                overflow[id] = index;
+                return;
+            }
+            size_t pageIndex = id >> PAGE_BITS;
+            if (pageIndex >= pages.size()) {
+                pages.resize(pageIndex + 1);
+            }
+            auto& page = pages[pageIndex];
+            if (page.indices == nullptr) {
+                page.indices = std::make_unique<uint32_t[]>(PAGE_SIZE);
+            }
+            page.indices[id & (PAGE_SIZE - 1)] = index;
+            page.count++;
+        }
+
+        void clearSlot(uint64_t id) {
+            if (id >= MAX_PAGED_ID) {
+                overflow.erase(id);
+                return;
+            }
+            auto& page = pages[id >> PAGE_BITS];
+            page.indices[id & (PAGE_SIZE - 1)] = 0;
+            // pages of long despawned ids are released
+            if (--page.count == 0) {
+                page.indices.reset();
+            }
+        }
+    public:
+        V* find(uint64_t id) {
+            const uint32_t* slot = slotOf(id);
+            return slot ? &denseValues[*slot - 1] : nullptr;
+        }
+
+        const V* find(uint64_t id) const {
+            return const_cast<SparseSet*>(this)->find(id);
+        }
+
+        /// @brief Insert or replace value
+        void set(uint64_t id, V value) {
+            if (auto found = find(id)) {
+                *found = std::move(value);
+                return;
+            }
+            denseIds.push_back(id);
+            denseValues.push_back(std::move(value));
+            setSlot(id, static_cast<uint32_t>(denseIds.size()));
+        }
+
+        /// @return true if element was erased
+        bool erase(uint64_t id) {
+            uint32_t* slot = slotOf(id);
+            if (slot == nullptr) {
+                return false;
+            }
+            size_t index = *slot - 1;
+            size_t last = denseIds.size() - 1;
+            if (index != last) {
+                uint64_t lastId = denseIds[last];
+                denseIds[index] = lastId;
+                denseValues[index] = std::move(denseValues[last]);
+                *slotOf(lastId) = static_cast<uint32_t>(index + 1);
+            }
+            denseIds.pop_back();
+            denseValues.pop_back();
+            clearSlot(id);
+            return true;
+        }
+
+        void clear() {
+            pages.clear();
+            overflow.clear();
+            denseIds.clear();
+            denseValues.clear();
+        }
+
+        size_t size() const {
+            return denseIds.size();
+        }
+
+        /// @brief Element id by dense index. Erasing elements while
+        /// iterating from the end keeps not visited indices valid
+        uint64_t idAt(size_t index) const {
+            return denseIds[index];
+        }
+
+        V& valueAt(size_t index) {
+            return denseValues[index];
+        }
+
+        const V& valueAt(size_t index) const {
+            return denseValues[index];
+        }
+    };
+}
@@ -1,18 +1,25 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <optional>
 #include <condition_variable>
 #include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include "debug/Logger.hpp"
+#include "debug/Profiler.hpp"
 #include "delegates.hpp"
 #include "interfaces/Task.hpp"
+#include "util/cores.hpp"
+#include "util/platform.hpp"
 
 namespace util {
 
@@ -25,6 +32,29 @@ namespace util {
         T entry;
     };
 
+    template <class J>
+    struct ThreadPoolJob {
+        J job;
+        int priority;
+        /// @brief Enqueue order used to keep FIFO for equal priorities
+        uint64_t order;
+
+        bool operator<(const ThreadPoolJob& o) const {
+            if (priority != o.priority) {
+                return priority < o.priority;
+            }
+            return order > o.order;
+        }
+    };
+
+    /// @brief Per-worker jobs queue, ordered by priority
+    template <class J>
+    struct ThreadPoolQueue {
+        std::mutex mutex;
+        /// @brief Binary heap of jobs (max-priority on top)
+        std::vector<ThreadPoolJob<J>> jobs;
+    };
+
     template <class T, class R>
     class Worker {
     public:
@@ -35,12 +65,15 @@ namespace util {
 
     template <class T, class R>
     class ThreadPool : public Task {
+        std::string name;
         debug::Logger logger;
-        std::queue<T> jobs;
+        /// @brief Workers own queues. Idle workers steal jobs from others
+        std::vector<std::unique_ptr<ThreadPoolQueue<T>>> queues;
         std::queue<ThreadPoolResult<T, R>> results;
         std::mutex resultsMutex;
         std::vector<std::thread> threads;
         std::condition_variable jobsMutexCondition;
+        /// @brief Used for idle workers sleeping only
         std::mutex jobsMutex;
         std::vector<std::unique_lock<std::mutex>> workersBlocked;
         consumer<R&&> resultConsumer;
@@ -48,31 +81,125 @@ namespace util {
         runnable onComplete = nullptr;
         std::atomic<int> busyWorkers = 0;
         std::atomic<uint> jobsDone = 0;
+        std::atomic<uint> jobsQueued = 0;
+        std::atomic<uint64_t> jobsOrder = 0;
+        std::atomic<uint> nextQueue = 0;
         std::atomic<bool> working = true;
         supplier<std::optional<T>> jobsSource = nullptr;
-        bool failed = false;
+        std::atomic<bool> failed = false;
         bool standaloneResults = true;
         bool stopOnFail = true;
+        /// @brief Number of workers taking jobs. Acquired from the global
+        /// cores budget
+        std::atomic<uint> activeWorkers = 0;
+        bool adaptiveWorkers = true;
+        std::mutex scaleMutex;
+        /// @brief Last time when all active workers were in demand
+        std::chrono::steady_clock::time_point lastDemandTime {};
+
+        void pushJob(T&& job, int priority) {
+            auto& queue = *queues[nextQueue++ % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(
+                ThreadPoolJob<T> {std::move(job), priority, jobsOrder++}
+            );
+            std::push_heap(queue.jobs.begin(), queue.jobs.end());
+            jobsQueued++;
+        }
+
+        /// @brief Take the most prioritized job from the worker own queue
+        /// or steal it from other workers queues
+        std::optional<T> takeJob(int index) {
+            for (size_t i = 0; i < queues.size(); i++) {
+                auto& queue = *queues[(index + i) % queues.size()];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (queue.jobs.empty()) {
+                    continue;
+                }
+                std::pop_heap(queue.jobs.begin(), queue.jobs.end());
+                T job = std::move(queue.jobs.back().job);
+                queue.jobs.pop_back();
+                // must be incremented before decrementing queued jobs
+                // counter to not trigger onComplete too early
+                busyWorkers++;
+                jobsQueued--;
+                return job;
+            }
+            return std::nullopt;
+        }
+
+        void notifyWorkers(bool all) {
+            {
+                // prevents lost wake-up of a worker checking predicate
+                std::lock_guard<std::mutex> lock(jobsMutex);
+            }
+            // inactive workers may consume a single notification
+            if (all || activeWorkers < threads.size()) {
+                jobsMutexCondition.notify_all();
+            } else {
+                jobsMutexCondition.notify_one();
+            }
+        }
+
+        /// @brief Scale active workers count by the queue depth
+        void adjustWorkers() {
+            std::unique_lock<std::mutex> lock(scaleMutex, std::try_to_lock);
+            if (!lock.owns_lock() || !working) {
+                return;
+            }
+            uint active = activeWorkers;
+            uint target = threads.size();
+            if (adaptiveWorkers) {
+                uint demand = jobsQueued + busyWorkers;
+                target = std::clamp<uint>(
+                    (demand + JOBS_PER_WORKER - 1) / JOBS_PER_WORKER,
+                    1,
+                    threads.size()
+                );
+            }
+            auto now = std::chrono::steady_clock::now();
+            if (target > active) {
+                lastDemandTime = now;
+                uint granted = cores::acquire(target - active);
+                if (granted) {
+                    activeWorkers += granted;
+                    notifyWorkers(true);
+                }
+            } else if (target == active) {
+                lastDemandTime = now;
+            } else if (now - lastDemandTime >= SCALE_DOWN_DELAY) {
+                // one worker at a time to not thrash on bursts
+                lastDemandTime = now;
+                activeWorkers--;
+                cores::release(1);
+            }
+        }
 
         void threadLoop(int index, std::unique_ptr<Worker<T, R>> worker) {
+            std::string threadName = name + " " + std::to_string(index);
+            platform::set_thread_name(threadName);
+            cores::pin_worker_thread();
+            debug::profiler::set_thread_name(std::move(threadName));
             std::condition_variable variable;
             std::mutex mutex;
             bool locked = false;
             while (working) {
-                T job;
                 {
                     std::unique_lock<std::mutex> lock(jobsMutex);
-                    jobsMutexCondition.wait(lock, [this] {
-                        return !jobs.empty() || !working;
+                    jobsMutexCondition.wait(lock, [this, index] {
+                        return (jobsQueued > 0 && index < activeWorkers) ||
+                               !working;
                     });
-                    if (!working || failed) {
-                        break;
-                    }
-                    job = std::move(jobs.front());
-                    jobs.pop();
-
-                    busyWorkers++;
                 }
+                if (!working || failed) {
+                    break;
+                }
+                auto taken = takeJob(index);
+                if (!taken.has_value()) {
+                    // taken by another worker
+                    continue;
+                }
+                T job = std::move(*taken);
                 try {
                     R result = (*worker)(job);
                     {
@@ -96,7 +223,6 @@ namespace util {
                         onJobFailed(job);
                     }
                     if (stopOnFail) {
-                        std::lock_guard<std::mutex> lock(jobsMutex);
                         failed = true;
                     }
                     logger.error() << "uncaught exception: " << err.what();
@@ -108,6 +234,10 @@ namespace util {
         static constexpr int UNLIMITED = 0;
         static constexpr int HALF = -2;
         static constexpr int QUARTER = -4;
+        /// @brief Queued jobs per active worker wanted
+        static constexpr uint JOBS_PER_WORKER = 2;
+        /// @brief Demand must be lower for this time to stop a worker
+        static constexpr auto SCALE_DOWN_DELAY = std::chrono::milliseconds(500);
 
         /// @brief Main thread pool constructor
         /// @param name thread pool name (used in logger)
@@ -115,19 +245,22 @@ namespace util {
         /// @param resultConsumer workers results consumer function
         /// @param maxWorkers max number of workers. Special values: 0 is 
         /// unlimited, -2 is half of auto count, -4 is quarter.
+        /// Number of workers taking jobs is scaled by the queue depth and
+        /// limited by the global cores budget (see util::cores), one
+        /// worker is always active
         ThreadPool(
             std::string name,
             supplier<std::unique_ptr<Worker<T, R>>> workersSupplier,
             consumer<R&&> resultConsumer,
             int maxWorkers=UNLIMITED
         )
-            : logger(std::move(name)), resultConsumer(resultConsumer) {
+            : name(name), logger(name), resultConsumer(resultConsumer) {
             uint numThreads = std::thread::hardware_concurrency();
             switch (maxWorkers) {
                 case UNLIMITED:
                     break;
                 case HALF:
-                    numThreads = std::max(1U, numThreads);
+                    numThreads = std::max(1U, numThreads / 2);
                     break;
                 case QUARTER:
                     numThreads = std::max(1U, numThreads / 4);
@@ -138,6 +271,11 @@ namespace util {
                     );
                     break;
             }
+            numThreads = std::max(1U, numThreads);
+            for (uint i = 0; i < numThreads; i++) {
+                queues.push_back(std::make_unique<ThreadPoolQueue<T>>());
+            }
+            activeWorkers = cores::acquire(1, 1);
             for (uint i = 0; i < numThreads; i++) {
                 threads.emplace_back(
                     &ThreadPool<T, R>::threadLoop, this, i, workersSupplier()
@@ -161,10 +299,7 @@ namespace util {
             if (!working) {
                 return;
             }
-            {
-                std::lock_guard<std::mutex> lock(jobsMutex);
-                working = false;
-            }
+            working = false;
             {
                 std::lock_guard<std::mutex> lock(resultsMutex);
                 while (!results.empty()) {
@@ -177,10 +312,12 @@ namespace util {
                 }
             }
 
-            jobsMutexCondition.notify_all();
+            notifyWorkers(true);
             for (auto& thread : threads) {
                 thread.join();
             }
+            std::lock_guard<std::mutex> lock(scaleMutex);
+            cores::release(activeWorkers.exchange(0));
         }
 
         void update() override {
@@ -212,7 +349,6 @@ namespace util {
                             onJobFailed(entry.job);
                         }
                         if (stopOnFail) {
-                            std::lock_guard<std::mutex> jobsLock(jobsMutex);
                             failed = true;
                             complete = false;
                         }
@@ -225,30 +361,29 @@ namespace util {
                     }
                 }
 
-                if (onComplete && busyWorkers == 0 && results.empty()) {
-                    std::lock_guard<std::mutex> jobsLock(jobsMutex);
-                    if (jobs.empty()) {
-                        onComplete();
-                        complete = true;
-                    }
+                // queued jobs counter must be checked first
+                if (onComplete && jobsQueued == 0 && busyWorkers == 0 &&
+                    results.empty()) {
+                    onComplete();
+                    complete = true;
                 }
             }
             if (jobsSource) {
-                bool jobsAdded = false;
-                std::lock_guard<std::mutex> jobsLock(jobsMutex);
+                size_t jobsAdded = 0;
                 while (true) {
                     auto job = jobsSource();
                     if (job.has_value()) {
-                        jobs.push(std::move(job.value()));
-                        jobsAdded = true;
+                        pushJob(std::move(job.value()), 0);
+                        jobsAdded++;
                     } else {
                         break;
                     }
                 }
                 if (jobsAdded) {
-                    jobsMutexCondition.notify_one();
+                    notifyWorkers(jobsAdded > 1);
                 }
             }
+            adjustWorkers();
             if (failed) {
                 throw std::runtime_error("some job failed");
             }
@@ -258,17 +393,51 @@ namespace util {
             return resultsProcessed;
         }
 
-        void enqueueJob(T&& job) {
-            {
-                std::lock_guard<std::mutex> lock(jobsMutex);
-                jobs.push(std::move(job));
+        /// @param priority jobs with greater priority are taken first.
+        /// Jobs with equal priority are taken in the enqueue order
+        void enqueueJob(T&& job, int priority = 0) {
+            pushJob(std::move(job), priority);
+            adjustWorkers();
+            notifyWorkers(false);
+        }
+
+        /// @brief Remove queued jobs that are not started yet and match
+        /// the predicate (like jobs become irrelevant)
+        /// @return removed jobs
+        std::vector<T> cancelJobs(
+            const std::function<bool(const T&)>& predicate
+        ) {
+            std::vector<T> cancelled;
+            for (auto& queuePtr : queues) {
+                auto& queue = *queuePtr;
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                auto end = std::partition(
+                    queue.jobs.begin(),
+                    queue.jobs.end(),
+                    [&predicate](const auto& entry) {
+                        return !predicate(entry.job);
+                    }
+                );
+                if (end == queue.jobs.end()) {
+                    continue;
+                }
+                for (auto it = end; it != queue.jobs.end(); ++it) {
+                    cancelled.push_back(std::move(it->job));
+                }
+                jobsQueued -= std::distance(end, queue.jobs.end());
+                queue.jobs.erase(end, queue.jobs.end());
+                std::make_heap(queue.jobs.begin(), queue.jobs.end());
             }
-            jobsMutexCondition.notify_one();
+            return cancelled;
         }
 
         void clearQueue() {
-            std::lock_guard<std::mutex> lock(jobsMutex);
-            jobs = {};
+            for (auto& queuePtr : queues) {
+                auto& queue = *queuePtr;
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                jobsQueued -= queue.jobs.size();
+                queue.jobs.clear();
+            }
         }
 
         /// @brief If false: worker will be blocked until it's result performed
@@ -280,6 +449,12 @@ namespace util {
             stopOnFail = flag;
         }
 
+        /// @brief If false: all workers are kept active (as the cores
+        /// budget allows) regardless of the queue depth
+        void setAdaptiveWorkers(bool flag) {
+            adaptiveWorkers = flag;
+        }
+
         /// @brief onJobFailed called on exception thrown in worker thread.
         /// Use engine.postRunnable when calling terminate()
         void setOnJobFailed(consumer<T&> callback) {
@@ -293,7 +468,7 @@ namespace util {
         }
 
         uint getWorkTotal() const override {
-            return jobs.size() + jobsDone + busyWorkers;
+            return jobsQueued + jobsDone + busyWorkers;
         }
 
         uint getWorkDone() const override {
@@ -311,6 +486,11 @@ namespace util {
         uint getWorkersCount() const {
             return threads.size();
         }
+
+        /// @return number of workers currently taking jobs
+        uint getActiveWorkersCount() const {
+            return activeWorkers;
+        }
     };
 
 }  // namespace util
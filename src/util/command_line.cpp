@@ -9,6 +9,7 @@
 #include "engine/EnginePaths.hpp"
 #include "util/ArgsReader.hpp"
 #include "engine/Engine.hpp"
+#include "debug/Logger.hpp"
 
 namespace fs = std::filesystem;
 
@@ -66,10 +67,69 @@ static bool perform_keyword(
             params.stdinCommands = true;
             return true;
         }, "", "run commands from stdin."),
+        ArgC("--async-log", [&params]() -> bool {
+            params.asyncLogging = true;
+            return true;
+        }, "", "write log in background thread."),
+        ArgC("--log-level", [&reader]() -> bool {
+            std::string arg = reader.next();
+            size_t sep = arg.find('=');
+            std::string levelName =
+                sep == std::string::npos ? arg : arg.substr(sep + 1);
+            debug::LogLevel level;
+            if (!debug::Logger::parseLevel(levelName, level)) {
+                throw std::runtime_error("unknown log level " + levelName);
+            }
+            if (sep == std::string::npos) {
+                debug::Logger::setLevel(level);
+            } else {
+                debug::Logger::setLevel(arg.substr(0, sep), level);
+            }
+            return true;
+        }, "<[module=]level>", "set min log level (debug/info/warning/error)."),
         ArgC("--tps", [&params, &reader]() -> bool {
             params.tps = reader.nextInt();
             return true;
         }, "<tps>", "headless mode tick-rate (default - 20)."),
+        ArgC("--benchmark", [&params, &reader]() -> bool {
+            params.headless = true;
+            params.testMode = true;
+            params.benchmarkWorld = reader.next();
+            return true;
+        }, "<world>", "run headless benchmark in the world."),
+        ArgC("--bench-players", [&params, &reader]() -> bool {
+            params.benchmarkPlayers = reader.nextInt();
+            return true;
+        }, "<n>", "benchmark simulated players count (default - 8)."),
+        ArgC("--bench-ticks", [&params, &reader]() -> bool {
+            params.benchmarkTicks = reader.nextInt();
+            return true;
+        }, "<n>", "benchmark ticks count (default - 1200)."),
+        ArgC("--bench-report", [&params, &reader]() -> bool {
+            params.benchmarkReport = reader.next();
+            return true;
+        }, "<path>", "write benchmark report to JSON file."),
+        ArgC("--trace-startup", [&params, &reader]() -> bool {
+            params.startupTrace = reader.next();
+            return true;
+        }, "<path>", "write startup trace to JSON file."),
+        ArgC("--metrics-port", [&params, &reader]() -> bool {
+            params.metricsPort = reader.nextInt();
+            return true;
+        }, "<port>", "headless mode Prometheus metrics HTTP port."),
+        ArgC("--record-inputs", [&params, &reader]() -> bool {
+            params.inputsRecord = reader.next();
+            return true;
+        }, "<path>", "headless mode: write inputs journal file."),
+        ArgC("--replay-inputs", [&params, &reader]() -> bool {
+            params.headless = true;
+            params.inputsReplay = reader.next();
+            return true;
+        }, "<path>", "replay inputs journal under the profiler."),
+        ArgC("--replay-trace", [&params, &reader]() -> bool {
+            params.replayTrace = reader.next();
+            return true;
+        }, "<path>", "write replay trace to JSON file."),
         ArgC("--version", []() -> bool {
             std::cout << ENGINE_VERSION_STRING << std::endl;
             return false;
@@ -0,0 +1,83 @@
+#include "cores.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "platform.hpp"
+
+using namespace util;
+
+static std::mutex mutex;
+static size_t budget = 0;
+static size_t used = 0;
+static std::atomic<bool> pinning = false;
+
+/// @brief Main thread dedicated core index
+static constexpr size_t MAIN_CORE = 0;
+
+static size_t hardware_cores() {
+    return std::max(1U, std::thread::hardware_concurrency());
+}
+
+static size_t effective_budget() {
+    if (budget) {
+        return budget;
+    }
+    return std::max<size_t>(1, hardware_cores() - 1);
+}
+
+void cores::set_budget(size_t count) {
+    std::lock_guard lock(mutex);
+    budget = count;
+}
+
+size_t cores::get_budget() {
+    std::lock_guard lock(mutex);
+    return effective_budget();
+}
+
+size_t cores::get_used() {
+    std::lock_guard lock(mutex);
+    return used;
+}
+
+size_t cores::acquire(size_t wanted, size_t min) {
+    std::lock_guard lock(mutex);
+    size_t available = effective_budget();
+    available = available > used ? available - used : 0;
+    size_t granted = std::max(min, std::min(wanted, available));
+    used += granted;
+    return granted;
+}
+
+void cores::release(size_t count) {
+    std::lock_guard lock(mutex);
+    used -= std::min(used, count);
+}
+
+void cores::set_pinning(bool flag) {
+    pinning = flag;
+}
+
+bool cores::is_pinning() {
+    return pinning;
+}
+
+void cores::pin_main_thread() {
+    if (!pinning) {
+        return;
+    }
+    platform::set_thread_affinity(uint64_t(1) << MAIN_CORE);
+}
+
+void cores::pin_worker_thread() {
+    size_t count = std::min<size_t>(hardware_cores(), 64);
+    if (!pinning || count < 2) {
+        return;
+    }
+    uint64_t mask = count == 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+    platform::set_thread_affinity(mask & ~(uint64_t(1) << MAIN_CORE));
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+
+namespace util::cores {
+    /// @brief Set total number of worker threads allowed to be active at
+    /// once across all thread pools
+    /// @param count budget (0 - hardware concurrency minus the main thread)
+    void set_budget(size_t count);
+
+    size_t get_budget();
+
+    /// @return number of currently acquired cores
+    size_t get_used();
+
+    /// @brief Acquire cores for worker threads. Thread-safe
+    /// @param wanted number of cores wanted
+    /// @param min number of cores granted even if the budget is exceeded
+    /// @return number of granted cores (release them when not used)
+    size_t acquire(size_t wanted, size_t min = 0);
+
+    /// @brief Return cores acquired before. Thread-safe
+    void release(size_t count);
+
+    /// @brief Enable pinning: the main thread keeps the first core while
+    /// worker threads are kept on the rest. Affects threads pinned after
+    void set_pinning(bool flag);
+
+    bool is_pinning();
+
+    /// @brief Pin the current thread to the main thread dedicated core
+    /// (if pinning is enabled)
+    void pin_main_thread();
+
+    /// @brief Keep the current thread off the main thread core
+    /// (if pinning is enabled)
+    void pin_worker_thread();
+}
@@ -2,6 +2,7 @@
 
 #include <time.h>
 
+#include <chrono>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -14,10 +15,18 @@
 
 #ifdef _WIN32
 #include <Windows.h>
+#include <psapi.h>
 #pragma comment(lib, "winmm.lib")
+#pragma comment(lib, "psapi.lib")
 #else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/resource.h>
 #include <unistd.h>
 #endif
+#if defined(__linux__)
+#include <sched.h>
+#endif
 
 namespace platform::internal {
     std::filesystem::path get_executable_path();
@@ -74,6 +83,16 @@ int platform::get_process_id() {
     return GetCurrentProcessId(); 
 }
 
+size_t platform::get_peak_memory_usage() {
+    PROCESS_MEMORY_COUNTERS counters {};
+    if (!GetProcessMemoryInfo(
+            GetCurrentProcess(), &counters, sizeof(counters)
+        )) {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+}
+
 bool platform::open_url(const std::string& url) {
     if (url.empty()) return false;
     // UTF-8 → UTF-16
@@ -119,6 +138,19 @@ int platform::get_process_id() {
     return getpid();
 }
 
+size_t platform::get_peak_memory_usage() {
+    rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage)) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    // kilobytes on Linux and BSD
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
 bool platform::open_url(const std::string& url) {
     if (url.empty()) return false;
 
@@ -148,6 +180,93 @@ bool platform::open_url(const std::string& url) {
 }
 #endif // _WIN32
 
+#ifdef _WIN32
+/// @brief Sleep precision is limited by the system timer resolution
+static constexpr auto SLEEP_SPIN_MARGIN = std::chrono::microseconds(2000);
+#else
+static constexpr auto SLEEP_SPIN_MARGIN = std::chrono::microseconds(200);
+#endif
+
+void platform::sleep_precise(double seconds) {
+    using namespace std::chrono;
+    auto deadline = steady_clock::now() +
+                    duration_cast<steady_clock::duration>(
+                        duration<double>(seconds)
+                    );
+    auto coarse = deadline - steady_clock::now() - SLEEP_SPIN_MARGIN;
+    if (coarse > steady_clock::duration::zero()) {
+#ifdef _WIN32
+        sleep(duration_cast<milliseconds>(coarse).count());
+#else
+        std::this_thread::sleep_for(coarse);
+#endif
+    }
+    while (steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
+
+void platform::set_thread_name(const std::string& name) {
+#ifdef _WIN32
+    SetThreadDescription(
+        GetCurrentThread(), util::str2wstr_utf8(name).c_str()
+    );
+#elif defined(__APPLE__)
+    pthread_setname_np(name.c_str());
+#else
+    // 15 characters max on Linux
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#endif
+}
+
+bool platform::set_thread_affinity(uint64_t coresMask) {
+#ifdef _WIN32
+    return SetThreadAffinityMask(
+        GetCurrentThread(), static_cast<DWORD_PTR>(coresMask)
+    ) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int i = 0; i < 64; i++) {
+        if (coresMask & (uint64_t(1) << i)) {
+            CPU_SET(i, &set);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    // not supported on macOS
+    return false;
+#endif
+}
+
+bool platform::sync_file(const std::filesystem::path& file) {
+#ifdef _WIN32
+    HANDLE handle = CreateFileW(
+        file.wstring().c_str(),
+        GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    bool success = FlushFileBuffers(handle) != 0;
+    CloseHandle(handle);
+    return success;
+#else
+    int fd = open(file.c_str(), O_RDWR);
+    if (fd == -1) {
+        return false;
+    }
+    bool success = fsync(fd) == 0;
+    close(fd);
+    return success;
+#endif
+}
+
 void platform::open_folder(const std::filesystem::path& folder) {
     if (!std::filesystem::is_directory(folder)) {
         logger.warning() << folder << " is not a directory or does not exist";
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <filesystem>
@@ -11,10 +12,27 @@ namespace platform {
     /// @brief Open folder using system file manager asynchronously
     /// @param folder target folder
     void open_folder(const std::filesystem::path& folder);
+    /// @brief Flush file data written to the storage device, so the
+    /// following writes are not persisted before it
+    /// @return false if failed
+    bool sync_file(const std::filesystem::path& file);
     /// @brief Makes the current thread sleep for the specified amount of milliseconds.
     void sleep(size_t millis);
+    /// @brief Makes the current thread sleep for the specified amount of
+    /// seconds with sub-millisecond precision. The end of the wait is
+    /// performed by yielding
+    void sleep_precise(double seconds);
+    /// @brief Set the current thread name shown by system tools and
+    /// debuggers (may be truncated)
+    void set_thread_name(const std::string& name);
+    /// @brief Restrict the current thread to the cores set
+    /// @param coresMask bit mask of the first 64 cores
+    /// @return false if not supported or failed
+    bool set_thread_affinity(uint64_t coresMask);
     /// @brief Get current process id 
     int get_process_id();
+    /// @brief Get peak resident set size of the current process in bytes
+    size_t get_peak_memory_usage();
     /// @brief Get current process running executable path  
     std::filesystem::path get_executable_path();
     /// @brief Run a separate engine instance with specified arguments
@@ -2,11 +2,17 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <iomanip>
 #include <locale>
 #include <sstream>
 #include <stdexcept>
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define VC_STRINGUTIL_SSE2
+#endif
+
 std::string util::escape(std::string_view s, bool escapeUnicode) {
     std::stringstream ss;
     ss << '"';
@@ -195,6 +201,88 @@ uint32_t util::decode_utf8(uint& size, const char* chr) {
     return code;
 }
 
+uint32_t util::next_utf8(std::string_view s, size_t& pos) {
+    ubyte lead = s[pos];
+    if (lead < 0x80) {
+        pos++;
+        return lead;
+    }
+    uint size = utf8_len(lead);
+    if (pos + size > s.length()) {
+        throw std::runtime_error("utf8 decode error");
+    }
+    uint32_t code = decode_utf8(size, s.data() + pos);
+    pos += size;
+    return code;
+}
+
+size_t util::ascii_prefix(std::string_view s) {
+    const char* data = s.data();
+    size_t size = s.length();
+    size_t pos = 0;
+#if defined(VC_STRINGUTIL_SSE2)
+    for (; pos + 16 <= size; pos += 16) {
+        __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        if (_mm_movemask_epi8(chunk)) {
+            break;
+        }
+    }
+#endif
+    for (; pos + 8 <= size; pos += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + pos, sizeof(word));
+        if (word & 0x8080808080808080ULL) {
+            break;
+        }
+    }
+    while (pos < size && (data[pos] & 0x80) == 0) {
+        pos++;
+    }
+    return pos;
+}
+
+bool util::is_valid_utf8(std::string_view s) {
+    size_t pos = 0;
+    size_t length = s.length();
+    while (pos < length) {
+        pos += ascii_prefix(s.substr(pos));
+        if (pos == length) {
+            break;
+        }
+        ubyte lead = s[pos];
+        uint size;
+        uint32_t min;
+        if ((lead & 0xE0) == 0xC0) {
+            size = 2;
+            min = 0x80;
+        } else if ((lead & 0xF0) == 0xE0) {
+            size = 3;
+            min = 0x800;
+        } else if ((lead & 0xF8) == 0xF0) {
+            size = 4;
+            min = 0x10000;
+        } else {
+            return false;
+        }
+        if (pos + size > length) {
+            return false;
+        }
+        for (uint i = 1; i < size; i++) {
+            if ((s[pos + i] & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+        uint32_t code = decode_utf8(size, s.data() + pos);
+        if (code < min || code > 0x10FFFF ||
+            (code >= 0xD800 && code <= 0xDFFF)) {
+            return false;
+        }
+        pos += size;
+    }
+    return true;
+}
+
 size_t util::crop_utf8(std::string_view s, size_t maxSize) {
     size_t pos = 0;
     uint size = 0;
@@ -212,8 +300,13 @@ size_t util::length_utf8(std::string_view s) {
     size_t length = 0;
     size_t pos = 0;
     while (pos < s.length()) {
-        pos += utf8_len(s[pos]);
-        length++;
+        size_t ascii = ascii_prefix(s.substr(pos));
+        pos += ascii;
+        length += ascii;
+        if (pos < s.length()) {
+            pos += utf8_len(s[pos]);
+            length++;
+        }
     }
     return length;
 }
@@ -228,16 +321,19 @@ size_t util::length_utf8(std::wstring_view s) {
 
 template<class C>
 std::string xstr2str_utf8(std::basic_string_view<C> xs) {
-    std::vector<char> chars;
+    std::string str;
+    str.reserve(xs.size());
     ubyte buffer[4];
     for (C xc : xs) {
-        uint size = util::encode_utf8(
-            static_cast<uint>(xc), buffer);
-        for (uint i = 0; i < size; i++) {
-            chars.push_back(buffer[i]);
+        auto code = static_cast<uint>(xc);
+        if (code < 0x80) {
+            str.push_back(static_cast<char>(code));
+            continue;
         }
+        uint size = util::encode_utf8(code, buffer);
+        str.append(reinterpret_cast<const char*>(buffer), size);
     }
-    return std::string(chars.data(), chars.size());
+    return str;
 }
 
 std::string util::wstr2str_utf8(std::wstring_view ws) {
@@ -250,14 +346,21 @@ std::string util::u32str2str_utf8(std::u32string_view ws) {
 
 template<class C>
 std::basic_string<C> str2xstr_utf8(std::string_view s) {
-    std::vector<C> chars;
+    std::basic_string<C> str;
+    str.reserve(s.length());
     size_t pos = 0;
-    uint size = 0;
     while (pos < s.length()) {
-        chars.push_back(util::decode_utf8(size, &s.at(pos)));
-        pos += size;
+        // ASCII runs are widened without decoding
+        size_t ascii = util::ascii_prefix(s.substr(pos));
+        for (size_t i = 0; i < ascii; i++) {
+            str.push_back(static_cast<C>(s[pos + i]));
+        }
+        pos += ascii;
+        if (pos < s.length()) {
+            str.push_back(static_cast<C>(util::next_utf8(s, pos)));
+        }
     }
-    return std::basic_string<C>(chars.data(), chars.size());
+    return str;
 }
 
 std::wstring util::str2wstr_utf8(std::string_view s) {
@@ -22,6 +22,21 @@ namespace util {
     uint encode_utf8(uint32_t c, ubyte* bytes);
     uint32_t decode_utf8(uint& size, const char* bytes);
 
+    /// @brief Decode codepoint at the position and move position to the
+    /// next one. Allows to iterate codepoints without decoding the whole
+    /// string into a buffer
+    /// @param s source UTF-8 encoded string
+    /// @param pos byte position of the codepoint (less than s.length())
+    /// @throws std::runtime_error on invalid or truncated sequence
+    uint32_t next_utf8(std::string_view s, size_t& pos);
+
+    /// @return number of leading ASCII characters (bytes below 0x80)
+    size_t ascii_prefix(std::string_view s);
+
+    /// @brief Check if string is a well-formed UTF-8 (no overlong forms,
+    /// surrogates and codepoints beyond U+10FFFF)
+    bool is_valid_utf8(std::string_view s);
+
     /// @brief Encode raw wstring to UTF-8
     /// @param ws source raw wstring
     /// @return new UTF-8 encoded string
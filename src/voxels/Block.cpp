@@ -152,6 +152,7 @@ void Block::cloneTo(Block& dst) {
     dst.uiLayout = uiLayout;
     dst.inventorySize = inventorySize;
     dst.tickInterval = tickInterval;
+    dst.cellular = cellular;
     dst.overlayTexture = overlayTexture;
     dst.translucent = translucent;
     dst.explictlySolid = explictlySolid;
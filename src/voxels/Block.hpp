@@ -48,15 +48,26 @@ struct BlockFuncsSet {
     bool onreplaced : 1;
     bool oninteract : 1;
     bool randupdate : 1;
+    bool randupdates : 1;
     bool onblocktick : 1;
     bool onblockstick : 1;
     bool onblockpresent : 1;
     bool onblockremoved : 1;
+    bool scheduledupdate : 1;
 };
 
+/// @brief Block events handles (see lua::intern_event)
 struct BlockFuncNamesCache {
-    std::string update;
-    std::string randomUpdate;
+    int update;
+    int randomUpdate;
+    int randomUpdates;
+    int scheduledUpdate;
+    int blocksTick;
+    int placed;
+    int replaced;
+    int breaking;
+    int broken;
+    int interact;
 };
 
 struct CoordSystem {
@@ -140,6 +151,32 @@ VC_ENUM_METADATA(CullingMode)
     {"disabled", CullingMode::DISABLED},
 VC_ENUM_END
 
+enum class CellularType : uint8_t {
+    NONE,
+    /// @brief Flows down and spreads to sides losing a level per block
+    LIQUID,
+    /// @brief Falls down (sinking in liquids), slides from piles if enabled
+    POWDER,
+};
+
+VC_ENUM_METADATA(CellularType)
+    {"none", CellularType::NONE},
+    {"liquid", CellularType::LIQUID},
+    {"powder", CellularType::POWDER},
+VC_ENUM_END
+
+/// @brief Native cellular simulation rules (see CellularSimulation)
+struct CellularRules {
+    CellularType type = CellularType::NONE;
+    /// @brief Liquid flow levels number. Level is stored in the block state
+    /// user bits: 0 - source, levels - 1 - the farthest flow
+    uint8_t levels = 8;
+    /// @brief Simulation step interval in world ticks (1 - 20tps)
+    uint8_t interval = 5;
+    /// @brief Powder slides down diagonally from piles
+    bool slide = false;
+};
+
 /// @brief Common kit of block properties applied to groups of blocks
 struct BlockMaterial : Serializable {
     std::string name;
@@ -268,6 +305,9 @@ public:
     // @brief Block tick interval (1 - 20tps, 2 - 10tps)
     uint tickInterval = 1;
 
+    /// @brief Liquid or powder rules processed natively
+    CellularRules cellular {};
+
     std::unique_ptr<data::StructLayout> dataStruct;
 
     std::unique_ptr<ParticlesPreset> particles;
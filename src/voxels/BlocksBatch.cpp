@@ -0,0 +1,21 @@
+#include "BlocksBatch.hpp"
+
+#include <algorithm>
+
+#include "constants.hpp"
+#include "maths/voxmaths.hpp"
+
+void BlocksBatch::sortByChunks() {
+    std::stable_sort(
+        entries.begin(),
+        entries.end(),
+        [](const Entry& a, const Entry& b) {
+            int az = floordiv<CHUNK_D>(a.pos.z);
+            int bz = floordiv<CHUNK_D>(b.pos.z);
+            if (az != bz) {
+                return az < bz;
+            }
+            return floordiv<CHUNK_W>(a.pos.x) < floordiv<CHUNK_W>(b.pos.x);
+        }
+    );
+}
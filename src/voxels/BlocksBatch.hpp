@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "typedefs.hpp"
+#include "voxel.hpp"
+
+/// @brief Blocks changes collected to be applied at once.
+/// @see BlocksController::applyBatch
+class BlocksBatch {
+public:
+    struct Entry {
+        glm::ivec3 pos;
+        blockid_t id;
+        blockstate state;
+    };
+
+    void set(int x, int y, int z, blockid_t id, blockstate state) {
+        entries.push_back(Entry {{x, y, z}, id, state});
+    }
+
+    /// @brief Group entries by chunks. Order of the changes made within
+    /// a chunk is kept, so the last change of a block wins
+    void sortByChunks();
+
+    const std::vector<Entry>& getEntries() const {
+        return entries;
+    }
+
+    size_t size() const {
+        return entries.size();
+    }
+
+    bool empty() const {
+        return entries.empty();
+    }
+
+    void clear() {
+        entries.clear();
+    }
+private:
+    std::vector<Entry> entries;
+};
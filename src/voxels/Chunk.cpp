@@ -6,51 +6,155 @@
 #include "util/data_io.hpp"
 #include "voxel.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <utility>
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define VC_CHUNK_SSE2
+#endif
+
+static std::atomic<uint32_t> next_revision = 1;
+
 Chunk::Chunk(int xpos, int zpos, std::shared_ptr<Lightmap> lightmap)
-    : x(xpos), z(zpos), lightmap(std::move(lightmap)) {
+    : voxels(std::make_unique<voxel[]>(CHUNK_VOL)),
+      x(xpos),
+      z(zpos),
+      lightmap(std::move(lightmap)),
+      revision(nextRevision()),
+      metadataRevision(revision) {
     bottom = 0;
     top = CHUNK_H;
+    std::fill_n(layerRevisions, CHUNK_H, revision);
+}
+
+uint32_t Chunk::nextRevision() {
+    return next_revision.fetch_add(1, std::memory_order_relaxed);
 }
 
 void Chunk::updateHeights() {
     flags.dirtyHeights = false;
+    emptySections = 0;
+    uniformSections = 0;
+    for (int section = 0; section < CHUNK_SECTIONS; section++) {
+        uint begin = section * CHUNK_SECTION_VOL;
+        uint end = begin + CHUNK_SECTION_VOL;
+        blockid_t id = get(begin).id;
+        uint i = begin + 1;
+        while (i < end && get(i).id == id) {
+            i++;
+        }
+        if (i == end) {
+            uniformSections |= 1U << section;
+            if (id == BLOCK_AIR) {
+                emptySections |= 1U << section;
+            }
+        }
+    }
     for (uint i = 0; i < CHUNK_VOL; i++) {
-        if (voxels[i].id != 0) {
+        if (get(i).id != 0) {
             bottom = i / (CHUNK_D * CHUNK_W);
             break;
         }
     }
     for (int i = CHUNK_VOL - 1; i >= 0; i--) {
-        if (voxels[i].id != 0) {
+        if (get(i).id != 0) {
             top = i / (CHUNK_D * CHUNK_W) + 1;
             break;
         }
     }
 }
 
+voxel* Chunk::getVoxels() {
+    idleChecks = 0;
+    if (voxels == nullptr) {
+        voxels.reset(new voxel[CHUNK_VOL]);
+        packedVoxels->unpack(voxels.get());
+        packedVoxels.reset();
+    }
+    return voxels.get();
+}
+
+void Chunk::copyVoxels(voxel* dst, uint begin, uint end) const {
+    if (voxels) {
+        std::copy(voxels.get() + begin, voxels.get() + end, dst);
+        return;
+    }
+    uint i = begin;
+    while (i < end) {
+        // whole sections are unpacked at once
+        if (i % PalettedSection::VOLUME == 0 &&
+            end - i >= PalettedSection::VOLUME) {
+            packedVoxels->getSection(i / PalettedSection::VOLUME)
+                .unpack(dst + (i - begin));
+            i += PalettedSection::VOLUME;
+        } else {
+            dst[i - begin] = packedVoxels->get(i);
+            i++;
+        }
+    }
+}
+
+void Chunk::pack() {
+    if (voxels == nullptr) {
+        return;
+    }
+    packedVoxels = std::make_unique<PalettedVoxels>(voxels.get());
+    voxels.reset();
+}
+
+PalettedVoxels Chunk::getPalettedVoxels() const {
+    if (packedVoxels) {
+        return *packedVoxels;
+    }
+    return PalettedVoxels(voxels.get());
+}
+
+size_t Chunk::getVoxelsMemory() const {
+    if (voxels) {
+        return CHUNK_VOL * sizeof(voxel);
+    }
+    return packedVoxels->getMemoryConsumption();
+}
+
 void Chunk::addBlockInventory(
     std::shared_ptr<Inventory> inventory, uint x, uint y, uint z
 ) {
+    getBlockInventories();
     inventories[vox_index(x, y, z)] = std::move(inventory);
-    flags.unsaved = true;
+    flags.unsavedInventories = true;
 }
 
 void Chunk::removeBlockInventory(uint x, uint y, uint z) {
+    getBlockInventories();
     if (inventories.erase(vox_index(x, y, z))) {
-        flags.unsaved = true;
-        flags.inventoriesRemoved = true;
+        flags.unsavedInventories = true;
     }
 }
 
 void Chunk::setBlockInventories(ChunkInventoriesMap map) {
+    inventoriesLoader = nullptr;
     inventories = std::move(map);
 }
 
-std::shared_ptr<Inventory> Chunk::getBlockInventory(uint x, uint y, uint z)
-    const {
+void Chunk::setBlockInventoriesLoader(ChunkInventoriesLoader loader) {
+    inventories.clear();
+    inventoriesLoader = std::move(loader);
+}
+
+const ChunkInventoriesMap& Chunk::getBlockInventories() {
+    if (inventoriesLoader) {
+        auto loader = std::move(inventoriesLoader);
+        inventoriesLoader = nullptr;
+        inventories = loader();
+    }
+    return inventories;
+}
+
+std::shared_ptr<Inventory> Chunk::getBlockInventory(uint x, uint y, uint z) {
     if (x >= CHUNK_W || y >= CHUNK_H || z >= CHUNK_D) return nullptr;
+    const auto& inventories = getBlockInventories();
     const auto& found = inventories.find(vox_index(x, y, z));
     if (found == inventories.end()) {
         return nullptr;
@@ -73,14 +177,16 @@ std::unique_ptr<ubyte[]> Chunk::encode() const {
     auto buffer = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
     auto dst = reinterpret_cast<uint16_t*>(buffer.get());
     for (uint i = 0; i < CHUNK_VOL; i++) {
-        dst[i] = dataio::h2le(voxels[i].id);
-        dst[CHUNK_VOL + i] = dataio::h2le(blockstate2int(voxels[i].state));
+        voxel vox = get(i);
+        dst[i] = dataio::h2le(vox.id);
+        dst[CHUNK_VOL + i] = dataio::h2le(blockstate2int(vox.state));
     }
     return buffer;
 }
 
 bool Chunk::decode(const ubyte* data) {
     auto src = reinterpret_cast<const uint16_t*>(data);
+    voxel* voxels = getVoxels();
     for (uint i = 0; i < CHUNK_VOL; i++) {
         voxel& vox = voxels[i];
 
@@ -90,11 +196,61 @@ bool Chunk::decode(const ubyte* data) {
     return true;
 }
 
-void Chunk::convert(ubyte* data, const ContentReport* report) {
+namespace {
+    /// @brief Scalar ids remapping. Voxels are mostly stored in runs of
+    /// the same id, so the last replacement is reused
+    struct IdsRemapper {
+        const blockid_t* table;
+        size_t count;
+        blockid_t prevId;
+        blockid_t prevReplacement;
+
+        void operator()(uint16_t* ids, uint length) {
+            for (uint i = 0; i < length; i++) {
+                blockid_t id = dataio::le2h(ids[i]);
+                if (id != prevId) {
+                    prevId = id;
+                    prevReplacement = id < count ? table[id] : id;
+                }
+                ids[i] = dataio::h2le(prevReplacement);
+            }
+        }
+    };
+}
+
+void Chunk::convert(ubyte* data, const blockid_t* table, size_t count) {
+    // ids below are not changed by the table
+    size_t identityEnd = 0;
+    while (identityEnd < count && table[identityEnd] == identityEnd) {
+        identityEnd++;
+    }
+    if (identityEnd == count) {
+        return;
+    }
     auto buffer = reinterpret_cast<uint16_t*>(data);
-    for (uint i = 0; i < CHUNK_VOL; i++) {
-        blockid_t id = dataio::le2h(buffer[i]);
-        blockid_t replacement = report->blocks.getId(id);
-        buffer[i] = dataio::h2le(replacement);
+    IdsRemapper remap {table, count, 0, table[0]};
+    uint i = 0;
+#if defined(VC_CHUNK_SSE2)
+    if (identityEnd > 0) {
+        // ids of the identity range saturate to zero
+        const __m128i limit =
+            _mm_set1_epi16(static_cast<short>(identityEnd - 1));
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 8 <= CHUNK_VOL; i += 8) {
+            __m128i ids = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(buffer + i)
+            );
+            __m128i over = _mm_cmpeq_epi16(_mm_subs_epu16(ids, limit), zero);
+            if (_mm_movemask_epi8(over) != 0xFFFF) {
+                remap(buffer + i, 8);
+            }
+        }
     }
+#endif
+    remap(buffer + i, CHUNK_VOL - i);
+}
+
+void Chunk::convert(ubyte* data, const ContentReport* report) {
+    const auto& indices = report->blocks.getIndices();
+    convert(data, indices.data(), indices.size());
 }
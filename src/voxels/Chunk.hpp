@@ -2,13 +2,17 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
+#include <functional>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "constants.hpp"
 #include "lighting/Lightmap.hpp"
 #include "util/SmallHeap.hpp"
 #include "maths/aabb.hpp"
+#include "PalettedVoxels.hpp"
 #include "voxel.hpp"
 
 /// @brief Total bytes number of chunk voxel data
@@ -20,39 +24,156 @@ class Inventory;
 using ChunkInventoriesMap =
     std::unordered_map<uint, std::shared_ptr<Inventory>>;
 
+/// @brief Reads saved block inventories of a chunk
+using ChunkInventoriesLoader = std::function<ChunkInventoriesMap()>;
+
 using BlocksMetadata = util::SmallHeap<uint16_t, uint8_t>;
 
+/// @brief Block update scheduled by scripts
+struct ScheduledUpdate {
+    /// @brief Index of the block in voxels array
+    uint index;
+    /// @brief World tick of the update (see WorldInfo::ticks)
+    uint64_t tick;
+};
+
 class Chunk {
+    /// @brief Flat voxels array (nullptr if the chunk is packed)
+    std::unique_ptr<voxel[]> voxels;
+    /// @brief Paletted voxels of the packed chunk (nullptr if not packed)
+    std::unique_ptr<PalettedVoxels> packedVoxels;
 public:
     int x, z;
     int bottom, top;
-    voxel voxels[CHUNK_VOL] {};
     std::shared_ptr<Lightmap> lightmap;
+    /// Unsaved layers flags are reset when the chunk is captured to be
+    /// saved, so only changed layers are encoded and written
     struct {
         bool modified : 1;
         bool ready : 1;
         bool loaded : 1;
         bool lighted : 1;
+        /// @brief All layers are unsaved (new chunk)
         bool unsaved : 1;
         bool loadedLights : 1;
         bool entities : 1;
+        /// @brief Blocks metadata is unsaved
         bool blocksData : 1;
         bool dirtyHeights : 1;
-        bool inventoriesRemoved : 1;
+        /// @brief Block inventories were added or removed
+        bool unsavedInventories : 1;
+        /// @brief Scheduled updates are unsaved
+        bool scheduledUpdates : 1;
+        bool unsavedVoxels : 1;
+        /// @brief Lightmap has been written since the chunk load
+        bool savedLights : 1;
     } flags {};
+    /// @brief Mesh sections to rebuild (valid if flags.modified is set)
+    chunk_sections_t modifiedSections = 0;
+    /// @brief Sections containing air only (refreshed by updateHeights)
+    chunk_sections_t emptySections = 0;
+    /// @brief Sections filled with a single block id (refreshed by
+    /// updateHeights). Empty sections are uniform too
+    chunk_sections_t uniformSections = 0;
 
     uint64_t lastRandomTickId = -1;
 
-    /// @brief Block inventories map where key is index of block in voxels array
+    /// @brief Packing checks passed since the last flat voxels access
+    /// (see GlobalChunks::packIdle)
+    uint16_t idleChecks = 0;
+
+    /// @brief Revision of the last voxels or metadata change. Revisions
+    /// are unique across all chunks, so reloaded chunk is never considered
+    /// unchanged since an older revision
+    uint32_t revision;
+    /// @brief Revision of the last voxels change in each layer
+    uint32_t layerRevisions[CHUNK_H];
+    /// @brief Revision of the last blocks metadata change
+    uint32_t metadataRevision;
+
+    /// @brief Block inventories map where key is index of block in voxels
+    /// array. Use getBlockInventories() to access (may be not loaded yet)
     ChunkInventoriesMap inventories;
+    /// @brief Saved block inventories are loaded on first access
+    /// (nullptr if loaded)
+    ChunkInventoriesLoader inventoriesLoader;
     /// @brief Blocks metadata heap
     BlocksMetadata blocksMetadata;
+    /// @brief Scheduled blocks updates, one per block at most
+    std::vector<ScheduledUpdate> scheduledUpdates;
 
     Chunk(int x, int z, std::shared_ptr<Lightmap> lightmap=nullptr);
 
-    /// @brief Refresh `bottom` and `top` values
+    /// @brief Refresh `bottom`, `top` values and sections summaries
     void updateHeights();
 
+    /// @param index voxel index (see vox_index)
+    inline voxel get(uint index) const {
+        if (voxels) {
+            return voxels[index];
+        }
+        return packedVoxels->get(index);
+    }
+
+    inline voxel get(uint x, uint y, uint z) const {
+        return get(vox_index(x, y, z));
+    }
+
+    /// @brief Set voxel value. Packed chunk stays packed
+    /// @param index voxel index (see vox_index)
+    inline void set(uint index, voxel vox) {
+        if (voxels) {
+            voxels[index] = vox;
+        } else {
+            packedVoxels->set(index, vox);
+        }
+    }
+
+    /// @brief Get flat voxels array of CHUNK_VOL length, the chunk is
+    /// unpacked if packed. Use get/set to access single voxels
+    /// @attention the pointer is invalidated by pack() call
+    voxel* getVoxels();
+
+    /// @brief Copy voxels of [begin, end) indices range without unpacking
+    /// @param dst destination array of (end - begin) length
+    void copyVoxels(voxel* dst, uint begin = 0, uint end = CHUNK_VOL) const;
+
+    /// @brief Store voxels paletted and release the flat array.
+    /// Access becomes slower, so only idle chunks are packed
+    void pack();
+
+    bool isPacked() const {
+        return packedVoxels != nullptr;
+    }
+
+    /// @return paletted copy of the voxels
+    PalettedVoxels getPalettedVoxels() const;
+
+    /// @return number of bytes used by the voxels storage
+    size_t getVoxelsMemory() const;
+
+    inline bool isSectionEmpty(int section) const {
+        return emptySections & (1U << section);
+    }
+
+    inline bool isSectionUniform(int section) const {
+        return uniformSections & (1U << section);
+    }
+
+    /// @brief Get id of the block filling the section
+    /// (valid if isSectionUniform(section) is true)
+    inline blockid_t getSectionBlock(int section) const {
+        return get(section * CHUNK_SECTION_VOL).id;
+    }
+
+    /// @brief Drop summaries of the section containing y
+    /// (called on block id change)
+    inline void resetSectionInfo(int y) {
+        chunk_sections_t mask = ~(1U << (y / CHUNK_SECTION_H));
+        emptySections &= mask;
+        uniformSections &= mask;
+    }
+
     /// @brief Creates new block inventory given size
     /// @return inventory id or 0 if block does not exists
     void addBlockInventory(
@@ -61,14 +182,67 @@ public:
     void removeBlockInventory(uint x, uint y, uint z);
     void setBlockInventories(ChunkInventoriesMap map);
 
+    /// @brief Set loader of saved block inventories called on first
+    /// block inventories access
+    void setBlockInventoriesLoader(ChunkInventoriesLoader loader);
+
+    /// @brief Get block inventories loading them if not loaded yet
+    const ChunkInventoriesMap& getBlockInventories();
+
+    /// @return false if saved block inventories were not accessed yet
+    /// (so they're not changed)
+    bool isBlockInventoriesLoaded() const {
+        return inventoriesLoader == nullptr;
+    }
+
     /// @return inventory bound to the given block or nullptr
-    std::shared_ptr<Inventory> getBlockInventory(uint x, uint y, uint z) const;
+    std::shared_ptr<Inventory> getBlockInventory(uint x, uint y, uint z);
 
-    inline void setModifiedAndUnsaved() {
+    /// @brief Mark whole chunk mesh to be rebuilt
+    inline void setModified() {
         flags.modified = true;
-        flags.unsaved = true;
+        modifiedSections = CHUNK_ALL_SECTIONS;
     }
 
+    /// @brief Mark mesh section containing y to be rebuilt. Adjacent
+    /// section is marked too if y is on the sections border
+    inline void setModified(int y) {
+        flags.modified = true;
+        int section = y / CHUNK_SECTION_H;
+        modifiedSections |= 1U << section;
+        int ly = y % CHUNK_SECTION_H;
+        if (ly == 0 && section > 0) {
+            modifiedSections |= 1U << (section - 1);
+        } else if (ly == CHUNK_SECTION_H - 1 && section + 1 < CHUNK_SECTIONS) {
+            modifiedSections |= 1U << (section + 1);
+        }
+    }
+
+    inline void setModifiedAndUnsaved() {
+        setModified();
+        flags.unsavedVoxels = true;
+        revision = nextRevision();
+        std::fill_n(layerRevisions, CHUNK_H, revision);
+    }
+
+    inline void setModifiedAndUnsaved(int y) {
+        setModified(y);
+        resetSectionInfo(y);
+        flags.unsavedVoxels = true;
+        revision = nextRevision();
+        layerRevisions[y] = revision;
+    }
+
+    /// @brief Mark blocks metadata changed
+    inline void setBlocksDataModified() {
+        flags.blocksData = true;
+        revision = nextRevision();
+        metadataRevision = revision;
+    }
+
+    /// @brief Allocate new revision number (thread-safe)
+    static uint32_t nextRevision();
+
     /// @brief Encode chunk to bytes array of size CHUNK_DATA_LEN
     /// @see /doc/specs/region_voxels_chunk_spec.md
     std::unique_ptr<ubyte[]> encode() const;
@@ -78,6 +252,13 @@ public:
 
     static void convert(ubyte* data, const ContentReport* report);
 
+    /// @brief Replace encoded chunk voxels ids using dense ids table.
+    /// Ids out of the table are left unchanged
+    /// @param data chunk data of CHUNK_DATA_LEN bytes
+    /// @param table old to new block ids table
+    /// @param count table length
+    static void convert(ubyte* data, const blockid_t* table, size_t count);
+
     AABB getAABB() const {
         return AABB(
             glm::vec3(x * CHUNK_W, -INFINITY, z * CHUNK_D),
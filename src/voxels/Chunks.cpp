@@ -53,18 +53,27 @@ voxel& Chunks::require(int32_t x, int32_t y, int32_t z) const {
     return blocks_agent::require(*this, x, y, z);
 }
 
+std::optional<voxel> Chunks::getVoxel(int32_t x, int32_t y, int32_t z) const {
+    return blocks_agent::get_voxel(*this, x, y, z);
+}
+
 const AABB* Chunks::isObstacleAt(float x, float y, float z) const {
     int ix = std::floor(x);
     int iy = std::floor(y);
     int iz = std::floor(z);
-    voxel* v = get(ix, iy, iz);
-    if (v == nullptr) {
-        if (iy >= CHUNK_H) {
+    auto v = getVoxel(ix, iy, iz);
+    // unit cube
+    static const AABB full;
+    if (!v) {
+        return iy >= CHUNK_H ? nullptr : &full;
+    }
+    switch (indices.getBlockCollision(v->id)) {
+        case BlockCollision::NONE:
             return nullptr;
-        } else {
-            static const AABB empty;
-            return &empty;
-        }
+        case BlockCollision::FULL:
+            return &full;
+        case BlockCollision::COMPLEX:
+            break;
     }
     const auto& def = indices.blocks.require(v->id);
     if (def.obstacle) {
@@ -95,8 +104,8 @@ bool Chunks::isReplaceableBlock(int32_t x, int32_t y, int32_t z) {
 }
 
 bool Chunks::isObstacleBlock(int32_t x, int32_t y, int32_t z) {
-    voxel* v = get(x, y, z);
-    if (v == nullptr) return false;
+    auto v = getVoxel(x, y, z);
+    if (!v) return false;
     return indices.blocks.require(v->id).obstacle;
 }
 
@@ -119,7 +128,10 @@ ubyte Chunks::getLight(int32_t x, int32_t y, int32_t z, int channel) const {
     if (chunk == nullptr) {
         return 0;
     }
-    assert(chunk->lightmap != nullptr);
+    if (chunk->lightmap == nullptr) {
+        // no-lightmap mode
+        return Lightmap::extract(Lightmap::SUN_LIGHT_ONLY, channel);
+    }
     int lx = x - cx * CHUNK_W;
     int lz = z - cz * CHUNK_D;
     return chunk->lightmap->get(lx, y, lz, channel);
@@ -140,7 +152,10 @@ light_t Chunks::getLight(int32_t x, int32_t y, int32_t z) const {
     if (chunk == nullptr) {
         return 0;
     }
-    assert(chunk->lightmap != nullptr);
+    if (chunk->lightmap == nullptr) {
+        // no-lightmap mode
+        return Lightmap::SUN_LIGHT_ONLY;
+    }
     int lx = x - cx * CHUNK_W;
     int lz = z - cz * CHUNK_D;
     return chunk->lightmap->get(lx, y, lz);
@@ -165,6 +180,13 @@ Chunk* Chunks::getChunk(int x, int z) const {
     return nullptr;
 }
 
+std::shared_ptr<Chunk> Chunks::getChunkShared(int x, int z) const {
+    if (auto ptr = areaMap.getIf(x, z)) {
+        return *ptr;
+    }
+    return nullptr;
+}
+
 glm::ivec3 Chunks::seekOrigin(
     const glm::ivec3& srcpos, const Block& def, blockstate state
 ) const {
@@ -226,96 +248,7 @@ voxel* Chunks::rayCast(
 glm::vec3 Chunks::rayCastToObstacle(
     const glm::vec3& start, const glm::vec3& dir, float maxDist
 ) const {
-    const float px = start.x;
-    const float py = start.y;
-    const float pz = start.z;
-
-    float dx = dir.x;
-    float dy = dir.y;
-    float dz = dir.z;
-
-    float t = 0.0f;
-    int ix = floor(px);
-    int iy = floor(py);
-    int iz = floor(pz);
-
-    int stepx = (dx > 0.0f) ? 1 : -1;
-    int stepy = (dy > 0.0f) ? 1 : -1;
-    int stepz = (dz > 0.0f) ? 1 : -1;
-
-    constexpr float infinity = std::numeric_limits<float>::infinity();
-    constexpr float epsilon = 1e-6f;  // 0.000001
-    float txDelta = (std::fabs(dx) < epsilon) ? infinity : std::fabs(1.0f / dx);
-    float tyDelta = (std::fabs(dy) < epsilon) ? infinity : std::fabs(1.0f / dy);
-    float tzDelta = (std::fabs(dz) < epsilon) ? infinity : std::fabs(1.0f / dz);
-
-    float xdist = (stepx > 0) ? (ix + 1 - px) : (px - ix);
-    float ydist = (stepy > 0) ? (iy + 1 - py) : (py - iy);
-    float zdist = (stepz > 0) ? (iz + 1 - pz) : (pz - iz);
-
-    float txMax = (txDelta < infinity) ? txDelta * xdist : infinity;
-    float tyMax = (tyDelta < infinity) ? tyDelta * ydist : infinity;
-    float tzMax = (tzDelta < infinity) ? tzDelta * zdist : infinity;
-
-    while (t <= maxDist) {
-        voxel* voxel = get(ix, iy, iz);
-        if (voxel) {
-            const auto& def = indices.blocks.require(voxel->id);
-            if (def.obstacle) {
-                if (!def.rt.solid) {
-                    const std::vector<AABB>& hitboxes =
-                        def.rt.hitboxes[voxel->state.rotation];
-
-                    scalar_t distance;
-                    glm::ivec3 norm;
-                    Ray ray(start, dir);
-
-                    glm::ivec3 offset {};
-                    if (voxel->state.segment) {
-                        offset = seekOrigin({ix, iy, iz}, def, voxel->state) -
-                                 glm::ivec3(ix, iy, iz);
-                    }
-
-                    for (const auto& box : hitboxes) {
-                        // norm is dummy now, can be inefficient
-                        if (ray.intersectAABB(
-                                glm::ivec3(ix, iy, iz) + offset,
-                                box,
-                                maxDist,
-                                norm,
-                                distance
-                            ) > RayRelation::None) {
-                            return start + (dir * glm::vec3(distance));
-                        }
-                    }
-                } else {
-                    return glm::vec3(px + t * dx, py + t * dy, pz + t * dz);
-                }
-            }
-        }
-        if (txMax < tyMax) {
-            if (txMax < tzMax) {
-                ix += stepx;
-                t = txMax;
-                txMax += txDelta;
-            } else {
-                iz += stepz;
-                t = tzMax;
-                tzMax += tzDelta;
-            }
-        } else {
-            if (tyMax < tzMax) {
-                iy += stepy;
-                t = tyMax;
-                tyMax += tyDelta;
-            } else {
-                iz += stepz;
-                t = tzMax;
-                tzMax += tzDelta;
-            }
-        }
-    }
-    return glm::vec3(px + maxDist * dx, py + maxDist * dy, pz + maxDist * dz);
+    return blocks_agent::raycast_to_obstacle(*this, start, dir, maxDist);
 }
 
 void Chunks::setCenter(int32_t x, int32_t z) {
@@ -382,12 +315,13 @@ static inline void sample_chunk(
     int cz,
     bool backlight
 ) {
-    const auto cvoxels = chunk.voxels;
-    const auto clights = chunk.lightmap ? chunk.lightmap->getLights() : nullptr;
+    const auto clightmap = chunk.lightmap.get();
     for (int ly = pos.y; ly < pos.y + size.y; ly++) {
         for (int lz = std::max(pos.z, cz * CHUNK_D);
                 lz < std::min(pos.z + size.z, (cz + 1) * CHUNK_D);
                 lz++) {
+            const light_t* clights =
+                clightmap ? clightmap->getRow(ly, lz - cz * CHUNK_D) : nullptr;
             for (int lx = std::max(pos.x, cx * CHUNK_W);
                     lx < std::min(pos.x + size.x, (cx + 1) * CHUNK_W);
                     lx++) {
@@ -402,8 +336,8 @@ static inline void sample_chunk(
                     CHUNK_D
                 );
                 auto& vox = voxels[vidx];
-                vox = cvoxels[cidx];
-                light_t light = clights ? clights[cidx]
+                vox = chunk.get(cidx);
+                light_t light = clights ? clights[lx - cx * CHUNK_W]
                                         : Lightmap::SUN_LIGHT_ONLY;
                 // todo: move to the BlocksRenderer
                 if (backlight) {
@@ -426,6 +360,28 @@ void Chunks::getVoxels(
     bool backlight,
     int top
 ) const {
+    getVoxels(
+        indices,
+        [this](int32_t x, int32_t z) { return getChunk(x, z); },
+        voxels,
+        lights,
+        pos,
+        size,
+        backlight,
+        top
+    );
+}
+
+void Chunks::getVoxels(
+    const ContentIndices& indices,
+    const ChunkGetter& getChunk,
+    voxel* voxels,
+    light_t* lights,
+    const glm::ivec3& pos,
+    const glm::ivec3& size,
+    bool backlight,
+    int top
+) {
     int h = std::min<int>(size.y, top);
 
     int scx = floordiv<CHUNK_W>(pos.x);
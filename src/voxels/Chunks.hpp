@@ -3,7 +3,9 @@
 #include <stdlib.h>
 
 #include <glm/glm.hpp>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <set>
 #include <vector>
 
@@ -58,6 +60,10 @@ public:
     bool putChunk(const std::shared_ptr<Chunk>& chunk);
 
     Chunk* getChunk(int32_t x, int32_t z) const;
+
+    /// @return owning pointer to the chunk or nullptr
+    std::shared_ptr<Chunk> getChunkShared(int32_t x, int32_t z) const;
+
     Chunk* getChunkByVoxel(int32_t x, int32_t y, int32_t z) const;
 
     template <typename T>
@@ -67,9 +73,14 @@ public:
         );
     }
 
+    /// @brief Get voxel pointer unpacking the chunk if packed.
+    /// Use getVoxel for reading
     voxel* get(int32_t x, int32_t y, int32_t z) const;
     voxel& require(int32_t x, int32_t y, int32_t z) const;
 
+    /// @return voxel value or std::nullopt if chunk is not loaded
+    std::optional<voxel> getVoxel(int32_t x, int32_t y, int32_t z) const;
+
     inline voxel* get(const glm::ivec3& pos) {
         return get(pos.x, pos.y, pos.z);
     }
@@ -135,19 +146,23 @@ public:
         VoxelsVolume& volume, bool backlight = false, int top = CHUNK_H
     ) const;
 
+    /// @param bottom lowest volume layer to fill, layers below are not
+    /// modified
     template <int w, int h, int d>
     void getVoxels(
         StaticVoxelsVolume<w, h, d>& volume,
         bool backlight = false,
-        int top = CHUNK_H
+        int top = CHUNK_H,
+        int bottom = 0
     ) const {
+        size_t offset = static_cast<size_t>(bottom) * w * d;
         getVoxels(
-            volume.getVoxels(),
-            volume.getLights(),
-            {volume.getX(), volume.getY(), volume.getZ()},
-            {w, h, d},
+            volume.getVoxels() + offset,
+            volume.getLights() + offset,
+            {volume.getX(), volume.getY() + bottom, volume.getZ()},
+            {w, h - bottom, d},
             backlight,
-            top
+            top - bottom
         );
     }
 
@@ -160,6 +175,23 @@ public:
         int top
     ) const;
 
+    /// @brief Provides chunk by position (nullptr if missing)
+    using ChunkGetter = std::function<const Chunk*(int32_t x, int32_t z)>;
+
+    /// @brief Copy voxels and lights of the area from chunks provided by
+    /// the getter. Chunks matrix is not accessed, so it may be called from
+    /// another thread while the provided chunks are not modified
+    static void getVoxels(
+        const ContentIndices& indices,
+        const ChunkGetter& getChunk,
+        voxel* voxels,
+        light_t* lights,
+        const glm::ivec3& pos,
+        const glm::ivec3& size,
+        bool backlight,
+        int top
+    );
+
     void setCenter(int32_t x, int32_t z);
     void resize(uint32_t newW, uint32_t newD);
 
@@ -167,10 +199,17 @@ public:
 
     void remove(int32_t x, int32_t z);
 
+    /// @brief Get all chunks slots. Slots order does not match chunks
+    /// positions, use getChunkLocal for positional access
     const std::vector<std::shared_ptr<Chunk>>& getChunks() const {
         return areaMap.getBuffer();
     }
 
+    /// @brief Get chunk slot by position relative to the area offset
+    const std::shared_ptr<Chunk>& getChunkLocal(int32_t x, int32_t z) const {
+        return areaMap.getLocal(x, z);
+    }
+
     int getWidth() const {
         return areaMap.getWidth();
     }
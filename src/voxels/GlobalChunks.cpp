@@ -4,9 +4,11 @@
 
 #include "Block.hpp"
 #include "Chunk.hpp"
+#include "coders/compression.hpp"
 #include "coders/json.hpp"
 #include "content/Content.hpp"
 #include "debug/Logger.hpp"
+#include "debug/Memory.hpp"
 #include "items/Inventories.hpp"
 #include "lighting/Lightmap.hpp"
 #include "maths/voxmaths.hpp"
@@ -24,26 +26,146 @@ static debug::Logger logger("chunks-storage");
 
 GlobalChunks::GlobalChunks(Level& level)
     : level(level), indices(*level.content.getIndices()) {
-    chunksMap.max_load_factor(CHUNKS_MAP_MAX_LOAD_FACTOR);
+    using debug::MemoryTag;
+    namespace memory = debug::memory;
+
+    memorySources.push_back(memory::add_source(MemoryTag::CHUNKS, [this]() {
+        size_t usage = chunksMap.size() * sizeof(Chunk);
+        for (const auto& [_, chunk] : chunksMap) {
+            usage += chunk->getVoxelsMemory();
+        }
+        return usage;
+    }));
+    memorySources.push_back(memory::add_source(MemoryTag::LIGHTMAPS, [this]() {
+        size_t usage = 0;
+        for (const auto& [_, chunk] : chunksMap) {
+            if (const auto& lightmap = chunk->lightmap) {
+                usage += sizeof(Lightmap) + lightmap->countDenseSections() *
+                                                CHUNK_SECTION_VOL *
+                                                sizeof(light_t);
+            }
+        }
+        return usage;
+    }));
+    memorySources.push_back(
+        memory::add_source(MemoryTag::BLOCKS_METADATA, [this]() {
+            size_t usage = 0;
+            for (const auto& [_, chunk] : chunksMap) {
+                usage += chunk->blocksMetadata.size();
+            }
+            return usage;
+        })
+    );
+    memorySources.push_back(memory::add_source(
+        MemoryTag::UNLOADED_CHUNKS,
+        [this]() { return unloadedMemory; },
+        [this](size_t bytes) { return evictUnloaded(bytes); }
+    ));
 }
 
 void GlobalChunks::setOnUnload(consumer<Chunk&> onUnload) {
     this->onUnload = std::move(onUnload);
 }
 
+void GlobalChunks::setUnloadedCacheBudget(size_t bytes) {
+    unloadedBudget = bytes;
+    while (unloadedMemory > unloadedBudget && !unloadedOrder.empty()) {
+        eraseUnloaded(unloadedOrder.back());
+    }
+}
+
+size_t GlobalChunks::evictUnloaded(size_t bytes) {
+    size_t before = unloadedMemory;
+    while (before - unloadedMemory < bytes && !unloadedOrder.empty()) {
+        eraseUnloaded(unloadedOrder.back());
+    }
+    return before - unloadedMemory;
+}
+
+void GlobalChunks::eraseUnloaded(uint64_t key) {
+    auto found = unloadedChunks.find(key);
+    if (found == unloadedChunks.end()) {
+        return;
+    }
+    unloadedMemory -= found->second.memoryUsage();
+    unloadedOrder.erase(found->second.position);
+    unloadedChunks.erase(found);
+}
+
+void GlobalChunks::invalidateUnloaded(int x, int z) {
+    eraseUnloaded(keyfrom(x, z));
+}
+
+void GlobalChunks::cacheUnloaded(const Chunk& chunk) {
+    uint64_t key = keyfrom(chunk.x, chunk.z);
+    eraseUnloaded(key);
+    if (unloadedBudget == 0 || !chunk.flags.ready ||
+        level.getWorld()->wfile->getRegions().generatorTestMode) {
+        return;
+    }
+    UnloadedChunk entry {};
+    entry.voxels = chunk.getPalettedVoxels();
+    if (chunk.lightmap && chunk.flags.lighted) {
+        auto lights = chunk.lightmap->encode();
+        entry.lights = compression::compress(
+            lights.get(),
+            LIGHTMAP_DATA_LEN,
+            entry.lightsSize,
+            compression::Method::EXTRLE8
+        );
+    }
+    entry.revision = chunk.revision;
+    entry.metadataRevision = chunk.metadataRevision;
+    std::copy_n(chunk.layerRevisions, CHUNK_H, entry.layerRevisions.begin());
+
+    unloadedOrder.push_front(key);
+    entry.position = unloadedOrder.begin();
+    unloadedMemory += entry.memoryUsage();
+    unloadedChunks[key] = std::move(entry);
+    while (unloadedMemory > unloadedBudget) {
+        eraseUnloaded(unloadedOrder.back());
+    }
+}
+
+bool GlobalChunks::restoreUnloaded(Chunk& chunk, ubyte* buffer) {
+    uint64_t key = keyfrom(chunk.x, chunk.z);
+    auto found = unloadedChunks.find(key);
+    if (found == unloadedChunks.end()) {
+        return false;
+    }
+    auto& entry = found->second;
+    entry.voxels.unpack(chunk.getVoxels());
+    if (chunk.lightmap && entry.lights) {
+        compression::decompress(
+            {entry.lights.get(), entry.lightsSize},
+            buffer,
+            LIGHTMAP_DATA_LEN,
+            compression::Method::EXTRLE8
+        );
+        chunk.lightmap->decode(buffer);
+        chunk.flags.loadedLights = true;
+    }
+    chunk.revision = entry.revision;
+    chunk.metadataRevision = entry.metadataRevision;
+    std::copy_n(entry.layerRevisions.begin(), CHUNK_H, chunk.layerRevisions);
+    eraseUnloaded(key);
+    return true;
+}
+
 std::shared_ptr<Chunk> GlobalChunks::fetch(int x, int z) {
-    const auto& found = chunksMap.find(keyfrom(x, z));
-    if (found == chunksMap.end()) {
+    const auto found = chunksMap.find(keyfrom(x, z));
+    if (found == nullptr) {
         return nullptr;
     }
-    return found->second;
+    return *found;
 }
 
 static void check_voxels(const ContentIndices& indices, Chunk& chunk) {
     bool corrupted = false;
     blockid_t defsCount = indices.blocks.count();
+    voxel* voxels = chunk.getVoxels();
     for (size_t i = 0; i < CHUNK_VOL; i++) {
-        blockid_t id = chunk.voxels[i].id;
+        blockid_t id = voxels[i].id;
         if (id >= defsCount) {
             if (!corrupted) {
 #ifdef NDEBUG
@@ -58,7 +180,7 @@ static void check_voxels(const ContentIndices& indices, Chunk& chunk) {
                 abort();
 #endif
             }
-            chunk.voxels[i] = {};
+            voxels[i] = {};
         }
     }
 }
@@ -76,7 +198,7 @@ static inline auto load_inventories(
     auto iterator = invs.begin();
     while (iterator != invs.end()) {
         uint index = iterator->first;
-        const auto& def = defs.require(chunk.voxels[index].id);
+        const auto& def = defs.require(chunk.get(index).id);
         if (def.inventorySize == 0) {
             iterator = invs.erase(iterator);
             continue;
@@ -90,13 +212,20 @@ static inline auto load_inventories(
     return invs;
 }
 
-static util::ObjectsPool<Chunk> chunks_pool(1'024);
+static util::ObjectsPool<Chunk> chunks_pool;
 static util::ObjectsPool<Lightmap> lightmaps_pool;
 
+void GlobalChunks::reserve(size_t count, bool lighting) {
+    chunks_pool.reserve(count);
+    if (lighting) {
+        lightmaps_pool.reserve(count);
+    }
+}
+
 std::shared_ptr<Chunk> GlobalChunks::create(int x, int z, bool lighting) {
-    const auto& found = chunksMap.find(keyfrom(x, z));
-    if (found != chunksMap.end()) {
-        return found->second;
+    const auto found = chunksMap.find(keyfrom(x, z));
+    if (found != nullptr) {
+        return *found;
     }
     static std::unique_ptr<ubyte[]> voxelDataBuffer = nullptr;
     if (voxelDataBuffer == nullptr) {
@@ -110,34 +239,51 @@ std::shared_ptr<Chunk> GlobalChunks::create(int x, int z, bool lighting) {
     World& world = *level.getWorld();
     auto& regions = world.wfile.get()->getRegions();
 
-    if (regions.getVoxels(chunk->x, chunk->z, voxelDataBuffer.get())) {
-        const auto& indices = *level.content.getIndices();
-
-        chunk->decode(voxelDataBuffer.get());
-        check_voxels(indices, *chunk);
+    bool cached = restoreUnloaded(*chunk, voxelDataBuffer.get());
+    if (cached ||
+        regions.getVoxels(chunk->x, chunk->z, voxelDataBuffer.get())) {
+        if (!cached) {
+            chunk->decode(voxelDataBuffer.get());
+            check_voxels(*level.content.getIndices(), *chunk);
+        }
 
-        chunk->setBlockInventories(
-            load_inventories(regions, *chunk, indices.blocks)
+        // block inventories are read on first access
+        chunk->setBlockInventoriesLoader(
+            [this, &regions, chunk = chunk.get()]() {
+                auto inventories = load_inventories(
+                    regions, *chunk, level.content.getIndices()->blocks
+                );
+                for (auto& entry : inventories) {
+                    level.inventories->store(entry.second);
+                }
+                return inventories;
+            }
         );
 
-        auto entitiesData = regions.fetchEntities(chunk->x, chunk->z);
-        if (entitiesData.getType() == dv::value_type::object) {
-            level.entities->loadEntities(std::move(entitiesData));
+        std::shared_ptr<entities_index::Index> entitiesIndex;
+        {
+            // legacy data tree is freed after conversion
+            dv::ArenaScope arena;
+            entitiesIndex = regions.fetchEntities(chunk->x, chunk->z);
+        }
+        if (entitiesIndex) {
+            // entities are spawned when get within simulation distance
+            level.entities->addPending(
+                chunk->x, chunk->z, std::move(entitiesIndex)
+            );
             chunk->flags.entities = true;
         }
 
         chunk->flags.loaded = true;
-        for (auto& entry : chunk->inventories) {
-            level.inventories->store(entry.second);
-        }
     }
-    if (chunk->lightmap) {
+    if (chunk->lightmap && !chunk->flags.loadedLights) {
         if (regions.getLights(chunk->x, chunk->z, voxelDataBuffer.get())) {
             chunk->lightmap->decode(voxelDataBuffer.get());
             chunk->flags.loadedLights = true;
         }
     }
     chunk->blocksMetadata = regions.getBlocksData(chunk->x, chunk->z);
+    chunk->scheduledUpdates = regions.getScheduledUpdates(chunk->x, chunk->z);
     return chunk;
 }
 
@@ -170,37 +316,36 @@ void GlobalChunks::decref(Chunk* chunk) {
         abort();
     }
     if (--found->second == 0) {
-        union {
-            int pos[2];
-            long long key;
-        } ekey;
-        ekey.pos[0] = chunk->x;
-        ekey.pos[1] = chunk->z;
-
         save(chunk);
+        cacheUnloaded(*chunk);
         if (onUnload) {
             onUnload(*chunk);
         }
-        chunksMap.erase(ekey.key);
+        chunksMap.erase(keyfrom(chunk->x, chunk->z));
         refCounters.erase(found);
     }
 }
 
+static std::vector<ubyte> serialize_entities(Level& level, Chunk& chunk) {
+    // the tree is freed right after encoding
+    dv::ArenaScope arena;
+    AABB aabb = chunk.getAABB();
+    auto entities = level.entities->getAllInside(aabb);
+    entities_index::Builder builder;
+    level.entities->serialize(entities, builder);
+    level.entities->writePending(chunk.x, chunk.z, builder);
+    if (!builder.empty()) {
+        chunk.flags.entities = true;
+    }
+    return chunk.flags.entities ? builder.build() : std::vector<ubyte>();
+}
+
 void GlobalChunks::save(Chunk* chunk) {
     if (chunk == nullptr) {
         return;
     }
-    AABB aabb = chunk->getAABB();
-    auto entities = level.entities->getAllInside(aabb);
-    auto root = dv::object();
-    root["data"] = level.entities->serialize(entities);
-    if (!entities.empty()) {
-        chunk->flags.entities = true;
-    }
     level.getWorld()->wfile->getRegions().put(
-        chunk,
-        chunk->flags.entities ? json::to_binary(root, true)
-                                : std::vector<ubyte>()
+        chunk, serialize_entities(level, *chunk)
     );
 }
 
@@ -210,6 +355,42 @@ void GlobalChunks::saveAll() {
     }
 }
 
+void GlobalChunks::captureAll(RegionsSnapshot& snapshot) {
+    auto& regions = level.getWorld()->wfile->getRegions();
+    for (const auto& [_, chunk] : chunksMap) {
+        regions.capture(
+            chunk.get(), serialize_entities(level, *chunk), snapshot.entries
+        );
+    }
+}
+
+size_t GlobalChunks::packIdle(int delay, size_t maxCount) {
+    size_t packed = 0;
+    for (const auto& [_, chunk] : chunksMap) {
+        if (packed == maxCount) {
+            break;
+        }
+        if (chunk->isPacked() || !chunk->flags.ready) {
+            continue;
+        }
+        if (chunk->idleChecks < delay) {
+            chunk->idleChecks++;
+            continue;
+        }
+        chunk->pack();
+        packed++;
+    }
+    return packed;
+}
+
+size_t GlobalChunks::countPacked() const {
+    size_t count = 0;
+    for (const auto& [_, chunk] : chunksMap) {
+        count += chunk->isPacked();
+    }
+    return count;
+}
+
 void GlobalChunks::putChunk(std::shared_ptr<Chunk> chunk) {
     chunksMap[keyfrom(chunk->x, chunk->z)] = std::move(chunk);
 }
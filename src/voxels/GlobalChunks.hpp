@@ -1,17 +1,25 @@
 #pragma once
 
+#include <array>
+#include <list>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
 #include <glm/gtx/hash.hpp>
 
+#include "constants.hpp"
+#include "PalettedVoxels.hpp"
 #include "voxel.hpp"
 #include "delegates.hpp"
+#include "util/FlatMap.hpp"
+#include "util/observer_handler.hpp"
 
 class Chunk;
 class Level;
+struct RegionsSnapshot;
 struct AABB;
 class ContentIndices;
 
@@ -26,19 +34,82 @@ class GlobalChunks {
         return ekey.key;
     }
 
+    /// @brief Paletted voxels and compressed lights of a recently unloaded
+    /// chunk, so it's restored without reading regions and building lights
+    struct UnloadedChunk {
+        PalettedVoxels voxels;
+        /// @brief nullptr if lights were not built
+        std::unique_ptr<ubyte[]> lights;
+        size_t lightsSize;
+        /// @brief Chunk revisions, so the restored chunk is considered
+        /// unchanged since them
+        uint32_t revision;
+        uint32_t metadataRevision;
+        std::array<uint32_t, CHUNK_H> layerRevisions;
+        /// @brief Position in the unloadedOrder list
+        std::list<uint64_t>::iterator position;
+
+        size_t memoryUsage() const {
+            return sizeof(UnloadedChunk) - sizeof(voxels) +
+                   voxels.getMemoryConsumption() + lightsSize;
+        }
+    };
+
     Level& level;
     const ContentIndices& indices;
-    std::unordered_map<uint64_t, std::shared_ptr<Chunk>> chunksMap;
+    util::FlatMap<std::shared_ptr<Chunk>> chunksMap;
     std::unordered_map<glm::ivec2, std::shared_ptr<Chunk>> pinnedChunks;
     std::unordered_map<ptrdiff_t, int> refCounters;
 
+    std::unordered_map<uint64_t, UnloadedChunk> unloadedChunks;
+    /// @brief Unloaded chunks keys from most to least recently unloaded
+    std::list<uint64_t> unloadedOrder;
+    size_t unloadedMemory = 0;
+    /// @brief Max memory of unloaded chunks cache (0 - disabled)
+    size_t unloadedBudget = 0;
+
     consumer<Chunk&> onUnload;
+
+    /// @brief Memory accounting sources (see debug::memory)
+    std::vector<ObserverHandler> memorySources;
+
+    /// @brief Keep chunk data in the unloaded chunks cache
+    void cacheUnloaded(const Chunk& chunk);
+
+    /// @brief Restore chunk voxels and lights from the unloaded chunks
+    /// cache
+    /// @param buffer CHUNK_DATA_LEN bytes decoding buffer
+    /// @return false if chunk is not cached
+    bool restoreUnloaded(Chunk& chunk, ubyte* buffer);
+
+    void eraseUnloaded(uint64_t key);
+
+    /// @brief Drop least recently unloaded chunks data
+    /// @return number of released bytes
+    size_t evictUnloaded(size_t bytes);
 public:
     GlobalChunks(Level& level);
     ~GlobalChunks() = default;
 
     void setOnUnload(consumer<Chunk&> onUnload);
 
+    /// @brief Allocate memory of chunks created later ahead
+    /// @param count number of chunks
+    /// @param lighting allocate lightmaps too
+    static void reserve(size_t count, bool lighting);
+
+    /// @brief Set max memory of recently unloaded chunks data kept
+    /// to be restored cheaply (0 - disabled)
+    void setUnloadedCacheBudget(size_t bytes);
+
+    /// @brief Drop cached data of the unloaded chunk. Must be called when
+    /// saved chunk data is changed directly
+    void invalidateUnloaded(int x, int z);
+
+    size_t getUnloadedCount() const {
+        return unloadedChunks.size();
+    }
+
     std::shared_ptr<Chunk> fetch(int x, int z);
     std::shared_ptr<Chunk> create(int x, int z, bool lighting);
 
@@ -55,16 +126,30 @@ public:
     void save(Chunk* chunk);
     void saveAll();
 
+    /// @brief Capture all chunks data to be saved in background
+    void captureAll(RegionsSnapshot& snapshot);
+
+    /// @brief Store voxels of chunks not accessed for a while paletted
+    /// (see Chunk::pack). Must be called periodically from the main thread
+    /// while chunks are not read by other threads
+    /// @param delay number of calls the chunk voxels must be not accessed
+    /// for to be packed
+    /// @param maxCount max number of chunks packed by the call
+    /// @return number of packed chunks
+    size_t packIdle(int delay, size_t maxCount);
+
+    size_t countPacked() const;
+
     void putChunk(std::shared_ptr<Chunk> chunk);
 
     const AABB* isObstacleAt(float x, float y, float z) const;
 
     inline Chunk* getChunk(int cx, int cz) const {
-        const auto& found = chunksMap.find(keyfrom(cx, cz));
-        if (found == chunksMap.end()) {
+        const auto found = chunksMap.find(keyfrom(cx, cz));
+        if (found == nullptr) {
             return nullptr;
         }
-        return found->second.get();
+        return found->get();
     }
 
     const ContentIndices& getContentIndices() const {
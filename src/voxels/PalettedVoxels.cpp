@@ -0,0 +1,137 @@
+#include "PalettedVoxels.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+static_assert(
+    CHUNK_VOL == PalettedSection::VOLUME * CHUNK_SECTIONS,
+    "sections must cover chunk volume"
+);
+
+PalettedSection::PalettedSection() : palette({pack_voxel(voxel {0, {}})}) {
+}
+
+uint PalettedSection::bits_for(size_t paletteSize) {
+    // only powers of two are used so indices never cross words border
+    uint bits = 0;
+    while ((1ULL << bits) < paletteSize) {
+        bits = bits == 0 ? 1 : bits * 2;
+    }
+    return bits;
+}
+
+void PalettedSection::setIndex(uint index, uint paletteIndex) {
+    uint perWord = 64 / bits;
+    uint64_t& word = data[index / perWord];
+    uint shift = (index % perWord) * bits;
+    uint64_t mask = ((1ULL << bits) - 1) << shift;
+    word = (word & ~mask) | (static_cast<uint64_t>(paletteIndex) << shift);
+}
+
+void PalettedSection::repack(uint newBits) {
+    if (newBits == bits) {
+        return;
+    }
+    std::vector<uint32_t> indices(VOLUME, 0);
+    if (bits) {
+        uint perWord = 64 / bits;
+        uint64_t mask = (1ULL << bits) - 1;
+        for (uint i = 0; i < VOLUME; i++) {
+            uint shift = (i % perWord) * bits;
+            indices[i] = (data[i / perWord] >> shift) & mask;
+        }
+    }
+    bits = newBits;
+    if (bits == 0) {
+        data = {};
+        return;
+    }
+    data.assign((VOLUME + 64 / bits - 1) / (64 / bits), 0);
+    for (uint i = 0; i < VOLUME; i++) {
+        setIndex(i, indices[i]);
+    }
+}
+
+void PalettedSection::set(uint index, voxel vox) {
+    uint32_t value = pack_voxel(vox);
+    // palettes are mostly small, so linear search is fast enough
+    auto found = std::find(palette.begin(), palette.end(), value);
+    uint paletteIndex = found - palette.begin();
+    if (found == palette.end()) {
+        palette.push_back(value);
+        repack(bits_for(palette.size()));
+    }
+    if (bits) {
+        setIndex(index, paletteIndex);
+    }
+}
+
+void PalettedSection::assign(const voxel* voxels) {
+    std::unordered_map<uint32_t, uint32_t> indices;
+    palette.clear();
+    for (uint i = 0; i < VOLUME; i++) {
+        uint32_t value = pack_voxel(voxels[i]);
+        if (indices.emplace(value, palette.size()).second) {
+            palette.push_back(value);
+        }
+    }
+    bits = 0;
+    data = {};
+    repack(bits_for(palette.size()));
+    if (bits == 0) {
+        return;
+    }
+    for (uint i = 0; i < VOLUME; i++) {
+        setIndex(i, indices[pack_voxel(voxels[i])]);
+    }
+}
+
+void PalettedSection::unpack(voxel* dst) const {
+    for (uint i = 0; i < VOLUME; i++) {
+        dst[i] = get(i);
+    }
+}
+
+void PalettedSection::compact() {
+    if (bits == 0) {
+        return;
+    }
+    std::vector<voxel> voxels(VOLUME);
+    unpack(voxels.data());
+    assign(voxels.data());
+}
+
+size_t PalettedSection::getMemoryConsumption() const {
+    return sizeof(PalettedSection) + palette.capacity() * sizeof(uint32_t) +
+           data.capacity() * sizeof(uint64_t);
+}
+
+PalettedVoxels::PalettedVoxels(const voxel* voxels) {
+    assign(voxels);
+}
+
+void PalettedVoxels::assign(const voxel* voxels) {
+    for (uint i = 0; i < CHUNK_SECTIONS; i++) {
+        sections[i].assign(voxels + i * PalettedSection::VOLUME);
+    }
+}
+
+void PalettedVoxels::unpack(voxel* dst) const {
+    for (uint i = 0; i < CHUNK_SECTIONS; i++) {
+        sections[i].unpack(dst + i * PalettedSection::VOLUME);
+    }
+}
+
+void PalettedVoxels::compact() {
+    for (auto& section : sections) {
+        section.compact();
+    }
+}
+
+size_t PalettedVoxels::getMemoryConsumption() const {
+    size_t size = sizeof(PalettedVoxels) - sizeof(sections);
+    for (const auto& section : sections) {
+        size += section.getMemoryConsumption();
+    }
+    return size;
+}
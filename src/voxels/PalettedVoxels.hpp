@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "constants.hpp"
+#include "typedefs.hpp"
+#include "voxel.hpp"
+
+/// @brief Voxels of a chunk section stored as a palette of distinct
+/// voxel values and bit-packed palette indices
+class PalettedSection {
+public:
+    static constexpr uint VOLUME = CHUNK_W * CHUNK_D * CHUNK_SECTION_H;
+
+    PalettedSection();
+
+    /// @param index voxel index inside of the section
+    inline voxel get(uint index) const {
+        if (bits == 0) {
+            return unpack_voxel(palette[0]);
+        }
+        uint perWord = 64 / bits;
+        uint64_t word = data[index / perWord];
+        uint shift = (index % perWord) * bits;
+        uint paletteIndex = (word >> shift) & ((1ULL << bits) - 1);
+        return unpack_voxel(palette[paletteIndex]);
+    }
+
+    /// @brief Set voxel value. Palette grows if the value is new
+    /// @param index voxel index inside of the section
+    void set(uint index, voxel vox);
+
+    /// @brief Fill the section from flat voxels array
+    void assign(const voxel* voxels);
+
+    /// @brief Write all section voxels to a flat array
+    void unpack(voxel* dst) const;
+
+    /// @brief Remove palette entries not used anymore
+    void compact();
+
+    /// @return number of bits per voxel index (0 if section is uniform)
+    uint getBits() const {
+        return bits;
+    }
+
+    size_t getPaletteSize() const {
+        return palette.size();
+    }
+
+    size_t getMemoryConsumption() const;
+private:
+    /// @brief Voxel values packed to 32 bit integers
+    std::vector<uint32_t> palette;
+    std::vector<uint64_t> data;
+    uint bits = 0;
+
+    static inline constexpr uint32_t pack_voxel(voxel vox) {
+        return static_cast<uint32_t>(vox.id) |
+               static_cast<uint32_t>(blockstate2int(vox.state)) << 16;
+    }
+
+    static inline constexpr voxel unpack_voxel(uint32_t value) {
+        return voxel {
+            static_cast<blockid_t>(value & 0xFFFF),
+            int2blockstate(static_cast<blockstate_t>(value >> 16))};
+    }
+
+    void setIndex(uint index, uint paletteIndex);
+    /// @brief Change bits per index keeping stored values
+    void repack(uint newBits);
+    static uint bits_for(size_t paletteSize);
+};
+
+/// @brief Compact chunk voxels storage made of paletted sections.
+/// Memory consumption depends on number of distinct voxel values per
+/// section: uniform sections (like air above the chunk top) take a few
+/// bytes only
+class PalettedVoxels {
+    std::array<PalettedSection, CHUNK_SECTIONS> sections;
+public:
+    /// @brief Create voxels filled with air
+    PalettedVoxels() = default;
+
+    /// @param voxels flat chunk voxels array of CHUNK_VOL length
+    explicit PalettedVoxels(const voxel* voxels);
+
+    /// @param index voxel index in the chunk (see vox_index)
+    inline voxel get(uint index) const {
+        return sections[index / PalettedSection::VOLUME].get(
+            index % PalettedSection::VOLUME
+        );
+    }
+
+    inline voxel get(uint x, uint y, uint z) const {
+        return get(vox_index(x, y, z));
+    }
+
+    inline void set(uint index, voxel vox) {
+        sections[index / PalettedSection::VOLUME].set(
+            index % PalettedSection::VOLUME, vox
+        );
+    }
+
+    inline void set(uint x, uint y, uint z, voxel vox) {
+        set(vox_index(x, y, z), vox);
+    }
+
+    const PalettedSection& getSection(uint index) const {
+        return sections[index];
+    }
+
+    /// @brief Fill from flat chunk voxels array of CHUNK_VOL length
+    void assign(const voxel* voxels);
+
+    /// @brief Write all voxels to flat array of CHUNK_VOL length
+    void unpack(voxel* dst) const;
+
+    /// @brief Remove unused palette entries in all sections
+    void compact();
+
+    size_t getMemoryConsumption() const;
+};
@@ -1,37 +1,475 @@
 #include "Pathfinding.hpp"
 
 #include "content/Content.hpp"
+#include "debug/Profiler.hpp"
+#include "objects/Player.hpp"
+#include "objects/Players.hpp"
+#include "util/ThreadPool.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/GlobalChunks.hpp"
+#include "voxels/VoxelsVolume.hpp"
 #include "voxels/blocks_agent.hpp"
 #include "world/Level.hpp"
+#include "world/LevelEvents.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <queue>
+#include <tuple>
 
 inline constexpr float SQRT2 = 1.4142135623730951f;  // sqrt(2)
 
+/// @brief Arena margin around start and target positions
+inline constexpr int ARENA_MARGIN_XZ = 16;
+inline constexpr int ARENA_MARGIN_Y = 8;
+/// @brief Max arena size (routes leading outside are not searched)
+inline constexpr int ARENA_MAX_XZ = 96;
+inline constexpr int ARENA_MAX_Y = 48;
+/// @brief Shared target field area radius
+inline constexpr int SHARED_FIELD_RADIUS_XZ = 32;
+inline constexpr int SHARED_FIELD_RADIUS_Y = 16;
+/// @brief Max shared target fields kept (the oldest one is replaced)
+inline constexpr int MAX_SHARED_FIELDS = 16;
+/// @brief Max distance from the target to the target of the field used
+/// instead of building a new one (moving targets like players)
+inline constexpr int SHARED_TARGET_TOLERANCE = 1;
+
 using namespace voxels;
 
+void State::reset() {
+    nodes.clear();
+    heap.clear();
+    closedCount = 0;
+    nearest = -1;
+    finished = true;
+    snapshot = nullptr;
+    hierarchical = false;
+}
+
+/// @brief Get arena range along an axis containing start and target
+/// positions where possible and the start position anyway
+static void arena_range(
+    int start, int target, int margin, int maxSize, int& origin, int& size
+) {
+    int min = std::min(start, target) - margin;
+    int max = std::max(start, target) + margin;
+    if (max - min + 1 > maxSize) {
+        if (target >= start) {
+            min = start - margin;
+            max = min + maxSize - 1;
+        } else {
+            max = start + margin;
+            min = max - maxSize + 1;
+        }
+    }
+    origin = min;
+    size = max - min + 1;
+}
+
+void State::begin(const glm::ivec3& start, const glm::ivec3& target) {
+    glm::ivec3 arenaOrigin;
+    glm::ivec3 arenaSize;
+    arena_range(
+        start.x, target.x, ARENA_MARGIN_XZ, ARENA_MAX_XZ,
+        arenaOrigin.x, arenaSize.x
+    );
+    arena_range(
+        start.z, target.z, ARENA_MARGIN_XZ, ARENA_MAX_XZ,
+        arenaOrigin.z, arenaSize.z
+    );
+    arena_range(
+        start.y, target.y, ARENA_MARGIN_Y, ARENA_MAX_Y,
+        arenaOrigin.y, arenaSize.y
+    );
+    beginArea(arenaOrigin, arenaSize);
+}
+
+void State::beginArea(const glm::ivec3& origin, const glm::ivec3& size) {
+    reset();
+    finished = false;
+    arenaOrigin = origin;
+    arenaSize = size;
+    int bottom = std::max(arenaOrigin.y, 0);
+    int top = std::min(arenaOrigin.y + arenaSize.y, CHUNK_H);
+    arenaOrigin.y = bottom;
+    arenaSize.y = std::max(top - bottom, 1);
+
+    size_t volume = static_cast<size_t>(arenaSize.x) * arenaSize.y * arenaSize.z;
+    if (cells.size() < volume) {
+        cells.resize(volume, ArenaCell {generation, 0});
+    }
+    if (++generation == 0) {
+        // stamps overflow, forget all the old ones
+        std::fill(cells.begin(), cells.end(), ArenaCell {0, 0});
+        generation = 1;
+    }
+}
+
+ArenaCell* State::getCell(const glm::ivec3& pos) {
+    auto local = pos - arenaOrigin;
+    if (local.x < 0 || local.y < 0 || local.z < 0 || local.x >= arenaSize.x ||
+        local.y >= arenaSize.y || local.z >= arenaSize.z) {
+        return nullptr;
+    }
+    return &cells[(local.y * arenaSize.z + local.z) * arenaSize.x + local.x];
+}
+
+void State::push(int node) {
+    nodes[node].heapIndex = heap.size();
+    heap.push_back(node);
+    decrease(node);
+}
+
+void State::decrease(int node) {
+    int index = nodes[node].heapIndex;
+    float fScore = nodes[node].fScore;
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        int parentNode = heap[parent];
+        if (nodes[parentNode].fScore <= fScore) {
+            break;
+        }
+        heap[index] = parentNode;
+        nodes[parentNode].heapIndex = index;
+        index = parent;
+    }
+    heap[index] = node;
+    nodes[node].heapIndex = index;
+}
+
+int State::pop() {
+    int top = heap[0];
+    nodes[top].heapIndex = -1;
+    int last = heap.back();
+    heap.pop_back();
+    int count = heap.size();
+    if (count == 0) {
+        return top;
+    }
+    float fScore = nodes[last].fScore;
+    int index = 0;
+    while (true) {
+        int child = index * 2 + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count &&
+            nodes[heap[child + 1]].fScore < nodes[heap[child]].fScore) {
+            child++;
+        }
+        if (nodes[heap[child]].fScore >= fScore) {
+            break;
+        }
+        heap[index] = heap[child];
+        nodes[heap[index]].heapIndex = index;
+        index = child;
+    }
+    heap[index] = last;
+    nodes[last].heapIndex = index;
+    return top;
+}
+
 static float heuristic(const glm::ivec3& a, const glm::ivec3& b) {
     return glm::distance(glm::vec3(a), glm::vec3(b));
 }
 
+/// @brief Copy of voxels area made on the main thread to be read by the
+/// search running on a worker
+class voxels::VoxelsSnapshot {
+    VoxelsVolume volume;
+    const ContentIndices& indices;
+public:
+    VoxelsSnapshot(
+        const GlobalChunks& chunks,
+        const glm::ivec3& origin,
+        const glm::ivec3& size
+    )
+        : volume(origin.x, origin.y, origin.z, size.x, size.y, size.z),
+          indices(chunks.getContentIndices()) {
+        blocks_agent::get_voxels(chunks, &volume);
+    }
+
+    /// @return voxel or nullptr if outside of the area or chunk is missing
+    voxel* get(int x, int y, int z) const {
+        x -= volume.getX();
+        y -= volume.getY();
+        z -= volume.getZ();
+        if (x < 0 || y < 0 || z < 0 || x >= volume.getW() ||
+            y >= volume.getH() || z >= volume.getD()) {
+            return nullptr;
+        }
+        auto& vox = const_cast<voxel*>(volume.getVoxels())[vox_index(
+            x, y, z, volume.getW(), volume.getD()
+        )];
+        return vox.id == BLOCK_VOID ? nullptr : &vox;
+    }
+
+    const ContentIndices& getContentIndices() const {
+        return indices;
+    }
+};
+
+template <>
+inline std::optional<voxel> blocks_agent::get_voxel(
+    const VoxelsSnapshot& snapshot, int32_t x, int32_t y, int32_t z
+) {
+    if (auto vox = snapshot.get(x, y, z)) {
+        return *vox;
+    }
+    return std::nullopt;
+}
+
+enum Passability {
+    NON_PASSABLE = -1,
+    OBSTACLE = 0,
+    PASSABLE = 1,
+};
+
+/// @brief Node moves: 4 straight ones first, then diagonal ones
+inline constexpr glm::ivec2 NEIGHBORS[] {
+    {0, 1},
+    {1, 0},
+    {0, -1},
+    {-1, 0},
+    {-1, -1},
+    {1, -1},
+    {1, 1},
+    {-1, 1},
+};
+inline constexpr int NEIGHBORS_COUNT = sizeof(NEIGHBORS) / sizeof(glm::ivec2);
+inline constexpr int STRAIGHT_NEIGHBORS_COUNT = 4;
+
+namespace voxels {
+    /// @brief Move leaving a chunk section
+    struct Transition {
+        glm::ivec3 from;
+        glm::ivec3 to;
+        float cost;
+    };
+
+    /// @brief Chunk section portals to the neighbor sections
+    struct Cluster {
+        bool built = false;
+        /// @brief Max revision of the chunks layers read on build
+        uint32_t revision = 0;
+        /// @brief Bit is set for the section column and its neighbors
+        /// (see SECTION_COLUMNS) that are not loaded
+        int missingColumns = 0;
+        /// @brief Moves to the neighbor sections, one per connected part
+        /// of the transitions to the same section and direction
+        std::vector<Transition> exits;
+        /// @brief Costs of routes from the section entry positions to the
+        /// exits (INFINITY if the exit is not reachable)
+        std::unordered_map<glm::ivec3, std::vector<float>> routes;
+    };
+
+    /// @brief Agent parameters the portals depend on
+    using AgentProfile = std::tuple<int, int, std::set<std::pair<int, int>>>;
+
+    /// @brief Chunk sections portals graphs built only for sections
+    /// visited by searches. Block changes are detected by the chunk
+    /// layers revisions
+    class PortalsGraph {
+    public:
+        std::map<AgentProfile, std::unordered_map<glm::ivec3, Cluster>>
+            profiles;
+
+        /// @brief Drop sections reading voxels of the chunk
+        void dropChunk(int cx, int cz) {
+            for (auto& [_, clusters] : profiles) {
+                for (auto it = clusters.begin(); it != clusters.end();) {
+                    const auto& key = it->first;
+                    if (std::abs(key.x - cx) + std::abs(key.z - cz) <= 1) {
+                        it = clusters.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+        }
+    };
+}
+
+namespace voxels {
+    /// @brief Routes from the area around the target to the target, shared
+    /// by agents having the same target and parameters
+    struct SharedField {
+        AgentProfile profile;
+        glm::ivec3 target;
+        /// @brief Pathfinding tick the field is built on
+        uint64_t tick;
+        /// @brief Node parent is the next route position
+        State state;
+    };
+
+    class SharedFields {
+    public:
+        std::vector<SharedField> fields;
+
+        /// @return alive field of the target or of a position next to it
+        SharedField* find(
+            const AgentProfile& profile,
+            const glm::ivec3& target,
+            uint64_t minTick
+        ) {
+            SharedField* nearest = nullptr;
+            int minDistance = SHARED_TARGET_TOLERANCE + 1;
+            for (auto& field : fields) {
+                if (field.tick < minTick || field.profile != profile) {
+                    continue;
+                }
+                auto delta = glm::abs(field.target - target);
+                int distance = std::max(delta.x, std::max(delta.y, delta.z));
+                if (distance < minDistance) {
+                    minDistance = distance;
+                    nearest = &field;
+                }
+            }
+            return nearest;
+        }
+
+        /// @brief Drop fields built before the tick
+        void expire(uint64_t minTick) {
+            fields.erase(
+                std::remove_if(
+                    fields.begin(),
+                    fields.end(),
+                    [minTick](const auto& field) {
+                        return field.tick < minTick;
+                    }
+                ),
+                fields.end()
+            );
+        }
+    };
+}
+
+/// @brief Max portals visited by a hierarchical search (voxels visited
+/// within sections are not limited by Agent::maxVisitedBlocks)
+inline constexpr int MAX_VISITED_PORTALS = 4096;
+inline const glm::ivec3 SECTION_SIZE {CHUNK_W, CHUNK_SECTION_H, CHUNK_D};
+
+/// @return true if the target does not fit in a single search arena
+static bool is_far_target(const glm::ivec3& start, const glm::ivec3& target) {
+    auto delta = glm::abs(target - start);
+    return delta.x + ARENA_MARGIN_XZ * 2 + 1 > ARENA_MAX_XZ ||
+           delta.z + ARENA_MARGIN_XZ * 2 + 1 > ARENA_MAX_XZ ||
+           delta.y + ARENA_MARGIN_Y * 2 + 1 > ARENA_MAX_Y;
+}
+
+namespace {
+    /// @brief A* search over voxels storage
+    template <class Storage>
+    class Search {
+        const Storage& chunks;
+        const ContentUnitIndices<Block, blockid_t>& blockDefs;
+    public:
+        Search(
+            const Storage& chunks,
+            const ContentUnitIndices<Block, blockid_t>& blockDefs
+        )
+            : chunks(chunks), blockDefs(blockDefs) {
+        }
+
+        Route perform(Agent& agent, int maxVisited);
+
+        /// @brief Find costs of routes from start to all reachable
+        /// positions of the box (Dijkstra search)
+        /// @return number of visited positions
+        int flood(
+            const Agent& agent,
+            State& state,
+            const glm::ivec3& start,
+            const glm::ivec3& origin,
+            const glm::ivec3& size
+        ) const;
+
+        /// @brief Find costs of routes from all positions of the box to
+        /// the target (reverse Dijkstra search). Parent of a node is the
+        /// next position of the route
+        /// @return number of visited positions
+        int floodTo(
+            const Agent& agent,
+            State& state,
+            const glm::ivec3& target,
+            const glm::ivec3& origin,
+            const glm::ivec3& size
+        ) const;
+
+        /// @brief Find straight moves leaving the box from its positions
+        void findTransitions(
+            const Agent& agent,
+            const glm::ivec3& origin,
+            const glm::ivec3& size,
+            std::vector<Transition>& transitions
+        ) const;
+    private:
+        /// @brief Find neighbor position in the direction, ignoring
+        /// the checks made by checkMove
+        /// @param direction index in NEIGHBORS
+        /// @param point [out] neighbor position
+        /// @param cost [out] move cost
+        /// @return false if the neighbor is not passable
+        bool getMove(
+            const Agent& agent,
+            const glm::ivec3& from,
+            int direction,
+            glm::ivec3& point,
+            float& cost
+        ) const;
+
+        /// @brief Check jump and diagonal moves clearance
+        bool checkMove(
+            const Agent& agent,
+            const glm::ivec3& from,
+            const glm::ivec3& point,
+            int direction
+        ) const;
+
+        bool checkPassability(
+            const Agent& agent,
+            const glm::ivec3& pos,
+            const glm::ivec2& offset,
+            bool diagonal
+        ) const;
+
+        int getSurfaceAt(
+            const Agent& agent, const glm::ivec3& pos, int maxDelta, float& cost
+        ) const;
+
+        int checkPoint(const Agent& agent, int x, int y, int z, int& cost) const;
+    };
+}
+
 Pathfinding::Pathfinding(const Level& level)
     : level(level),
       chunks(*level.chunks),
-      blockDefs(level.content.getIndices()->blocks) {
+      blockDefs(level.content.getIndices()->blocks),
+      graph(std::make_unique<PortalsGraph>()),
+      fields(std::make_unique<SharedFields>()) {
+    level.events->listen(
+        LevelEventType::CHUNK_UNLOAD,
+        [this](LevelEventType, Chunk* chunk) {
+            graph->dropChunk(chunk->x, chunk->z);
+        }
+    );
 }
 
-static bool check_passability(
+Pathfinding::~Pathfinding() = default;
+
+template <class Storage>
+bool Search<Storage>::checkPassability(
     const Agent& agent,
-    const GlobalChunks& chunks,
-    const Node& node,
+    const glm::ivec3& pos,
     const glm::ivec2& offset,
     bool diagonal
-) {
+) const {
     if (!diagonal) {
         return true;
     }
-    auto a = node.pos + glm::ivec3(offset.x, 0, 0);
-    auto b = node.pos + glm::ivec3(0, 0, offset.y);
+    auto a = pos + glm::ivec3(offset.x, 0, 0);
+    auto b = pos + glm::ivec3(0, 0, offset.y);
 
     for (int i = 0; i < agent.height; i++) {
         if (blocks_agent::is_obstacle_at(chunks, a.x, a.y + i, a.z))
@@ -42,20 +480,49 @@ static bool check_passability(
     return true;
 }
 
+template <class Storage>
+bool Search<Storage>::getMove(
+    const Agent& agent,
+    const glm::ivec3& from,
+    int direction,
+    glm::ivec3& point,
+    float& cost
+) const {
+    auto offset = NEIGHBORS[direction];
+    cost = 0.0f;
+    int surface = getSurfaceAt(
+        agent, from + glm::ivec3(offset.x, 0, offset.y), 1, cost
+    );
+    if (surface == NON_PASSABLE) {
+        return false;
+    }
+    point = glm::ivec3(from.x + offset.x, surface, from.z + offset.y);
+    cost += glm::abs(offset.x) + glm::abs(offset.y);
+    return true;
+}
+
+template <class Storage>
+bool Search<Storage>::checkMove(
+    const Agent& agent,
+    const glm::ivec3& from,
+    const glm::ivec3& point,
+    int direction
+) const {
+    if (blocks_agent::is_obstacle_at(
+            chunks, from.x, point.y + agent.jumpHeight, from.z
+        )) {
+        return false;
+    }
+    return checkPassability(
+        agent, from, NEIGHBORS[direction], direction >= STRAIGHT_NEIGHBORS_COUNT
+    );
+}
+
 static void restore_route(
-    Route& route,
-    const glm::ivec3& lastPos,
-    const std::unordered_map<glm::ivec3, Node>& parents
+    Route& route, int lastNode, const std::vector<Node>& nodes
 ) {
-    auto pos = lastPos;
-    while (true) {
-        const auto& found = parents.find(pos);
-        if (found == parents.end()) {
-            route.nodes.push_back({pos});
-            break;
-        }
-        route.nodes.push_back({pos});
-        pos = found->second.pos;
+    for (int index = lastNode; index != -1; index = nodes[index].parent) {
+        route.nodes.push_back({nodes[index].pos});
     }
 }
 
@@ -74,19 +541,171 @@ bool Pathfinding::removeAgent(int id) {
     return false;
 }
 
-void Pathfinding::performAllAsync(int stepsPerAgent) {
-    for (auto& [_, agent] : agents) {
-        if (agent.state.finished) {
+class PathfindingWorker : public util::Worker<PathfindingJob, PathfindingResult> {
+    const ContentUnitIndices<Block, blockid_t>& blockDefs;
+public:
+    PathfindingWorker(const ContentUnitIndices<Block, blockid_t>& blockDefs)
+        : blockDefs(blockDefs) {
+    }
+
+    PathfindingResult operator()(const PathfindingJob& job) override {
+        VC_PROFILE_ZONE("Pathfinding::search");
+        auto& agent = *job.agent;
+        auto snapshot = agent.state.snapshot;
+        try {
+            Search<VoxelsSnapshot>(*snapshot, blockDefs)
+                .perform(agent, job.steps);
+        } catch (const std::exception&) {
+            // agent must not stay in work forever
+            agent.state.reset();
+            agent.route = {};
+        }
+        return PathfindingResult {job.agentId, job.agent};
+    }
+};
+
+/// @return distance to the nearest player
+static float distance_to_players(const Level& level, const glm::ivec3& pos) {
+    float minDistance = INFINITY;
+    for (const auto& [_, player] : *level.players) {
+        minDistance = std::min(
+            minDistance, glm::distance(player->getPosition(), glm::vec3(pos))
+        );
+    }
+    return minDistance;
+}
+
+void Pathfinding::installResult(PathfindingResult&& result) {
+    auto found = agents.find(result.agentId);
+    if (found == agents.end()) {
+        return;
+    }
+    auto& agent = found->second;
+    auto& resultAgent = *result.agent;
+    if (agent.searchId != resultAgent.searchId) {
+        // new search started, result is outdated
+        return;
+    }
+    agent.inwork = false;
+    agent.state = std::move(resultAgent.state);
+    if (agent.state.finished) {
+        agent.state.snapshot = nullptr;
+        agent.route = std::move(resultAgent.route);
+    }
+}
+
+void Pathfinding::resetAgent(Agent& agent) {
+    agent.searchId++;
+    agent.inwork = false;
+    agent.state.reset();
+}
+
+static void push_start_node(Agent& agent) {
+    auto& state = agent.state;
+    float hScore = heuristic(agent.start, agent.target);
+    state.nodes.push_back(Node {agent.start, -1, 0, hScore, -1});
+    if (auto cell = state.getCell(agent.start)) {
+        *cell = ArenaCell {state.generation, 0};
+    }
+    state.push(0);
+    state.nearest = 0;
+    state.minHScore = hScore;
+}
+
+/// @brief Setup the search arena and push the start node
+static void start_search(Agent& agent) {
+    agent.state.begin(agent.start, agent.target);
+    push_start_node(agent);
+}
+
+/// @brief Push the start node of the search limited to the box
+static void start_search(
+    Agent& agent, const glm::ivec3& origin, const glm::ivec3& size
+) {
+    agent.state.beginArea(origin, size);
+    push_start_node(agent);
+}
+
+void Pathfinding::performAllAsync(
+    int stepsPerAgent, int stepsPerTick, int fieldLifetime
+) {
+    VC_PROFILE_ZONE("Pathfinding::performAllAsync");
+    tick++;
+    this->fieldLifetime = fieldLifetime;
+    if (tick > static_cast<uint64_t>(fieldLifetime)) {
+        fields->expire(tick - fieldLifetime);
+    }
+    if (pool == nullptr) {
+        pool = std::make_unique<util::ThreadPool<PathfindingJob, PathfindingResult>>(
+            "pathfinding",
+            [this]() {
+                return std::make_unique<PathfindingWorker>(blockDefs);
+            },
+            [this](PathfindingResult&& result) {
+                installResult(std::move(result));
+            },
+            util::ThreadPool<PathfindingJob, PathfindingResult>::QUARTER
+        );
+        pool->setStandaloneResults(true);
+    }
+    pool->update();
+
+    std::vector<std::pair<float, int>> queue;
+    for (auto& [id, agent] : agents) {
+        if (agent.state.finished || agent.inwork) {
             continue;
         }
-        perform(agent, stepsPerAgent);
+        queue.emplace_back(distance_to_players(level, agent.start), id);
+    }
+    std::sort(queue.begin(), queue.end());
+
+    int budget = stepsPerTick;
+    for (const auto& [distance, id] : queue) {
+        if (budget <= 0) {
+            break;
+        }
+        budget -= stepsPerAgent;
+
+        auto& agent = agents.at(id);
+        auto& state = agent.state;
+        if (state.hierarchical) {
+            // portals graph is not shared with workers
+            budget -= performHierarchical(agent).totalVisited;
+            continue;
+        }
+        if (state.snapshot == nullptr) {
+            if (state.nodes.empty()) {
+                start_search(agent);
+            }
+            // margin covers blocks checked around the nodes
+            glm::ivec3 margin(1, agent.height + agent.jumpHeight + 2, 1);
+            auto origin = state.arenaOrigin - margin;
+            auto end = state.arenaOrigin + state.arenaSize + margin;
+            origin.y = std::max(origin.y, 0);
+            end.y = std::min(end.y, CHUNK_H);
+            state.snapshot = std::make_shared<VoxelsSnapshot>(
+                chunks, origin, end - origin
+            );
+        }
+        auto route = std::move(agent.route);
+        auto jobAgent = std::make_shared<Agent>(agent);
+        agent.route = std::move(route);
+        jobAgent->state = std::move(state);
+        // the agent stays unfinished until the result is installed
+        state = {};
+        state.finished = false;
+        agent.inwork = true;
+        pool->enqueueJob(
+            PathfindingJob {id, std::move(jobAgent), stepsPerAgent},
+            -static_cast<int>(std::min(distance, 1e6f))
+        );
     }
 }
 
 static Route finish_route(Agent& agent, State&& state) {
     Route route {};
-    restore_route(route, state.nearest, state.parents);
-    route.totalVisited = state.blocked.size();
+    restore_route(route, state.nearest, state.nodes);
+    route.totalVisited = state.closedCount;
     route.nodes.push_back({agent.start});
     route.found = true;
     state.finished = true;
@@ -95,33 +714,38 @@ static Route finish_route(Agent& agent, State&& state) {
     return route;
 }
 
-enum Passability {
-    NON_PASSABLE = -1,
-    OBSTACLE = 0,
-    PASSABLE = 1,
-};
-
 Route Pathfinding::perform(Agent& agent, int maxVisited) {
+    if (agent.sharedTarget && performShared(agent)) {
+        return agent.route;
+    }
+    if (is_far_target(agent.start, agent.target)) {
+        if (maxVisited == 0) {
+            // continued by performAllAsync
+            agent.state.reset();
+            agent.state.finished = false;
+            agent.state.hierarchical = true;
+            return {};
+        }
+        return performHierarchical(agent);
+    }
+    blocks_agent::ChunksCursor cursor(chunks);
+    return Search<blocks_agent::ChunksCursor<GlobalChunks>>(cursor, blockDefs)
+        .perform(agent, maxVisited);
+}
+
+template <class Storage>
+Route Search<Storage>::perform(Agent& agent, int maxVisited) {
     using namespace blocks_agent;
 
-    State state = std::move(agent.state);
-    if (state.queue.empty()) {
-        state.queue.push(
-            {agent.start, {}, 0, heuristic(agent.start, agent.target)}
-        );
+    if (agent.state.nodes.empty()) {
+        start_search(agent);
     }
+    State state = std::move(agent.state);
 
-    const auto& chunks = *level.chunks;
     int height = std::max(agent.height, 1);
-
-    if (state.nearest == glm::ivec3(0)) {
-        state.nearest = agent.start;
-        state.minHScore = heuristic(agent.start, agent.target);
-    }
     int visited = -1;
-
-    while (!state.queue.empty()) {
-        if (state.blocked.size() == agent.maxVisitedBlocks) {
+    while (!state.heap.empty()) {
+        if (state.closedCount == agent.maxVisitedBlocks) {
             if (agent.mayBeIncomplete) {
                 return finish_route(agent, std::move(state));
             }
@@ -134,8 +758,9 @@ Route Pathfinding::perform(Agent& agent, int maxVisited) {
             return {};
         }
 
-        auto node = state.queue.top();
-        state.queue.pop();
+        int nodeIndex = state.pop();
+        // copied as nodes vector may grow below
+        const Node node = state.nodes[nodeIndex];
 
         if (node.pos.x == agent.target.x &&
             glm::abs((node.pos.y - agent.target.y) / height) == 0 &&
@@ -143,58 +768,48 @@ Route Pathfinding::perform(Agent& agent, int maxVisited) {
             return finish_route(agent, std::move(state));
         }
 
-        state.blocked.emplace(node.pos);
-        glm::ivec2 neighbors[8] {
-            {0, 1},
-            {1, 0},
-            {0, -1},
-            {-1, 0},
-            {-1, -1},
-            {1, -1},
-            {1, 1},
-            {-1, 1},
-        };
-
-        for (int i = 0; i < sizeof(neighbors) / sizeof(glm::ivec2); i++) {
-            auto offset = neighbors[i];
-            auto pos = node.pos;
-
-            float cost = glm::abs(node.pos.y - pos.y) * 10;
-            int surface = getSurfaceAt(
-                agent, pos + glm::ivec3(offset.x, 0, offset.y), 1, cost
-            );
-
-            if (surface == NON_PASSABLE) {
+        state.closedCount++;
+        for (int i = 0; i < NEIGHBORS_COUNT; i++) {
+            glm::ivec3 point;
+            float cost;
+            if (!getMove(agent, node.pos, i, point, cost)) {
                 continue;
             }
-            pos.y = surface;
-            auto point = pos + glm::ivec3(offset.x, 0, offset.y);
-            if (state.blocked.find(point) != state.blocked.end()) {
+            auto cell = state.getCell(point);
+            if (cell == nullptr) {
                 continue;
             }
-
-            if (is_obstacle_at(
-                    chunks, pos.x, pos.y + agent.jumpHeight, pos.z
-                )) {
+            int found = cell->generation == state.generation ? cell->node : -1;
+            if (found != -1 && state.nodes[found].heapIndex == -1) {
+                // closed
                 continue;
             }
-            if (!check_passability(agent, chunks, node, offset, i >= 4)) {
+
+            if (!checkMove(agent, node.pos, point, i)) {
                 continue;
             }
 
-            float sum = glm::abs(offset.x) + glm::abs(offset.y);
-            float gScore = node.gScore + sum + cost;
-            const auto& found = state.parents.find(point);
-            if (found == state.parents.end()) {
-                float hScore = heuristic(point, agent.target);
+            float gScore = node.gScore + cost;
+            float hScore = heuristic(point, agent.target);
+            float fScore = gScore * 0.75f + hScore;
+            if (found == -1) {
                 if (hScore < state.minHScore) {
                     state.minHScore = hScore;
-                    state.nearest = point;
+                    state.nearest = state.nodes.size();
                 }
-                float fScore = gScore * 0.75f + hScore;
-                Node nNode {point, node.pos, gScore, fScore};
-                state.parents[point] = node;
-                state.queue.push(nNode);
+                *cell = ArenaCell {
+                    state.generation, static_cast<int>(state.nodes.size())};
+                state.nodes.push_back(
+                    Node {point, nodeIndex, gScore, fScore, -1}
+                );
+                state.push(state.nodes.size() - 1);
+            } else if (gScore < state.nodes[found].gScore) {
+                // shorter way to the open node found
+                auto& openNode = state.nodes[found];
+                openNode.parent = nodeIndex;
+                openNode.gScore = gScore;
+                openNode.fScore = fScore;
+                state.decrease(found);
             }
         }
     }
@@ -203,6 +818,620 @@ Route Pathfinding::perform(Agent& agent, int maxVisited) {
     return finish_route(agent, std::move(agent.state));
 }
 
+template <class Storage>
+int Search<Storage>::flood(
+    const Agent& agent,
+    State& state,
+    const glm::ivec3& start,
+    const glm::ivec3& origin,
+    const glm::ivec3& size
+) const {
+    state.beginArea(origin, size);
+    auto startCell = state.getCell(start);
+    if (startCell == nullptr) {
+        return 0;
+    }
+    *startCell = ArenaCell {state.generation, 0};
+    state.nodes.push_back(Node {start, -1, 0.0f, 0.0f, -1});
+    state.push(0);
+
+    while (!state.heap.empty()) {
+        int nodeIndex = state.pop();
+        const Node node = state.nodes[nodeIndex];
+        state.closedCount++;
+        for (int i = 0; i < NEIGHBORS_COUNT; i++) {
+            glm::ivec3 point;
+            float cost;
+            if (!getMove(agent, node.pos, i, point, cost)) {
+                continue;
+            }
+            auto cell = state.getCell(point);
+            if (cell == nullptr) {
+                continue;
+            }
+            int found = cell->generation == state.generation ? cell->node : -1;
+            if (found != -1 && state.nodes[found].heapIndex == -1) {
+                continue;
+            }
+            if (!checkMove(agent, node.pos, point, i)) {
+                continue;
+            }
+            float gScore = node.gScore + cost;
+            if (found == -1) {
+                *cell = ArenaCell {
+                    state.generation, static_cast<int>(state.nodes.size())};
+                state.nodes.push_back(
+                    Node {point, nodeIndex, gScore, gScore, -1}
+                );
+                state.push(state.nodes.size() - 1);
+            } else if (gScore < state.nodes[found].gScore) {
+                auto& openNode = state.nodes[found];
+                openNode.parent = nodeIndex;
+                openNode.gScore = gScore;
+                openNode.fScore = gScore;
+                state.decrease(found);
+            }
+        }
+    }
+    state.finished = true;
+    return state.closedCount;
+}
+
+template <class Storage>
+int Search<Storage>::floodTo(
+    const Agent& agent,
+    State& state,
+    const glm::ivec3& target,
+    const glm::ivec3& origin,
+    const glm::ivec3& size
+) const {
+    state.beginArea(origin, size);
+    auto targetCell = state.getCell(target);
+    if (targetCell == nullptr) {
+        return 0;
+    }
+    *targetCell = ArenaCell {state.generation, 0};
+    state.nodes.push_back(Node {target, -1, 0.0f, 0.0f, -1});
+    state.push(0);
+
+    while (!state.heap.empty()) {
+        int nodeIndex = state.pop();
+        const Node node = state.nodes[nodeIndex];
+        state.closedCount++;
+        for (int i = 0; i < NEIGHBORS_COUNT; i++) {
+            auto offset = NEIGHBORS[i];
+            // moves change height by one block at most
+            for (int dy = -1; dy <= 1; dy++) {
+                glm::ivec3 from = node.pos - glm::ivec3(offset.x, dy, offset.y);
+                auto cell = state.getCell(from);
+                if (cell == nullptr) {
+                    continue;
+                }
+                int found =
+                    cell->generation == state.generation ? cell->node : -1;
+                if (found != -1 && state.nodes[found].heapIndex == -1) {
+                    continue;
+                }
+                glm::ivec3 point;
+                float cost;
+                if (!getMove(agent, from, i, point, cost) ||
+                    point != node.pos ||
+                    !checkMove(agent, from, point, i)) {
+                    continue;
+                }
+                float gScore = node.gScore + cost;
+                if (found == -1) {
+                    *cell = ArenaCell {
+                        state.generation, static_cast<int>(state.nodes.size())};
+                    state.nodes.push_back(
+                        Node {from, nodeIndex, gScore, gScore, -1}
+                    );
+                    state.push(state.nodes.size() - 1);
+                } else if (gScore < state.nodes[found].gScore) {
+                    auto& openNode = state.nodes[found];
+                    openNode.parent = nodeIndex;
+                    openNode.gScore = gScore;
+                    openNode.fScore = gScore;
+                    state.decrease(found);
+                }
+            }
+        }
+    }
+    state.finished = true;
+    return state.closedCount;
+}
+
+template <class Storage>
+void Search<Storage>::findTransitions(
+    const Agent& agent,
+    const glm::ivec3& origin,
+    const glm::ivec3& size,
+    std::vector<Transition>& transitions
+) const {
+    auto end = origin + size;
+    for (int y = origin.y; y < end.y; y++) {
+        bool borderLayer = y == origin.y || y == end.y - 1;
+        for (int z = origin.z; z < end.z; z++) {
+            bool borderRow = borderLayer || z == origin.z || z == end.z - 1;
+            for (int x = origin.x; x < end.x; x++) {
+                if (!borderRow && x != origin.x && x != end.x - 1) {
+                    // moves from inner positions stay in the box
+                    x = end.x - 2;
+                    continue;
+                }
+                glm::ivec3 pos(x, y, z);
+                float cost = 0.0f;
+                if (getSurfaceAt(agent, pos, 1, cost) != y) {
+                    // agent does not stand here
+                    continue;
+                }
+                for (int i = 0; i < STRAIGHT_NEIGHBORS_COUNT; i++) {
+                    glm::ivec3 point;
+                    if (!getMove(agent, pos, i, point, cost)) {
+                        continue;
+                    }
+                    auto local = point - origin;
+                    if (local.x >= 0 && local.y >= 0 && local.z >= 0 &&
+                        local.x < size.x && local.y < size.y &&
+                        local.z < size.z) {
+                        continue;
+                    }
+                    if (!checkMove(agent, pos, point, i)) {
+                        continue;
+                    }
+                    transitions.push_back(Transition {pos, point, cost});
+                }
+            }
+        }
+    }
+}
+
+/// @brief Section column and its neighbors read on the section portals build
+static const glm::ivec2 SECTION_COLUMNS[] {
+    {0, 0}, {1, 0}, {-1, 0}, {0, 1}, {0, -1}
+};
+
+static glm::ivec3 section_key(const glm::ivec3& pos) {
+    return {
+        floordiv<CHUNK_W>(pos.x),
+        pos.y >= 0 ? pos.y / CHUNK_SECTION_H : -1,
+        floordiv<CHUNK_D>(pos.z)};
+}
+
+static glm::ivec3 section_origin(const glm::ivec3& key) {
+    return key * SECTION_SIZE;
+}
+
+/// @brief Get max revision of the chunks layers read on the section
+/// portals build
+/// @return bit mask of not loaded SECTION_COLUMNS
+static int get_section_revision(
+    const GlobalChunks& chunks,
+    const Agent& agent,
+    const glm::ivec3& key,
+    uint32_t& revision
+) {
+    int bottom = std::max(key.y * CHUNK_SECTION_H - 3, 0);
+    int top = std::min(
+        (key.y + 1) * CHUNK_SECTION_H + agent.height + agent.jumpHeight + 2,
+        CHUNK_H
+    );
+    int missing = 0;
+    revision = 0;
+    for (int i = 0; i < std::size(SECTION_COLUMNS); i++) {
+        const auto& offset = SECTION_COLUMNS[i];
+        auto chunk = chunks.getChunk(key.x + offset.x, key.z + offset.y);
+        if (chunk == nullptr) {
+            missing |= 1 << i;
+            continue;
+        }
+        for (int y = bottom; y < top; y++) {
+            revision = std::max(revision, chunk->layerRevisions[y]);
+        }
+    }
+    return missing;
+}
+
+/// @return cost of the route found by Search::flood or INFINITY
+static float flooded_cost(State& state, const glm::ivec3& pos) {
+    auto cell = state.getCell(pos);
+    if (cell == nullptr || cell->generation != state.generation) {
+        return INFINITY;
+    }
+    return state.nodes[cell->node].gScore;
+}
+
+namespace {
+    /// @brief Hierarchical (HPA*) search: A* over the sections portals,
+    /// then the route is refined with voxels searches within sections
+    class HierarchicalSearch {
+        using LocalSearch = Search<blocks_agent::ChunksCursor<GlobalChunks>>;
+
+        struct Portal {
+            glm::ivec3 pos;
+            int parent;
+            /// @brief Position in the parent section the route leaves
+            /// it from
+            glm::ivec3 via;
+            float gScore;
+            bool closed;
+            bool target;
+        };
+
+        const GlobalChunks& chunks;
+        LocalSearch& search;
+        std::unordered_map<glm::ivec3, Cluster>& clusters;
+        Agent& agent;
+        /// @brief Sections searches state
+        State state;
+        int visited = 0;
+
+        std::vector<Portal> portals;
+        std::unordered_map<glm::ivec3, int> portalsMap;
+        std::priority_queue<
+            std::pair<float, int>,
+            std::vector<std::pair<float, int>>,
+            std::greater<>>
+            open;
+    public:
+        HierarchicalSearch(
+            const GlobalChunks& chunks,
+            LocalSearch& search,
+            std::unordered_map<glm::ivec3, Cluster>& clusters,
+            Agent& agent
+        )
+            : chunks(chunks), search(search), clusters(clusters), agent(agent) {
+        }
+
+        Route perform();
+    private:
+        Cluster& getCluster(const glm::ivec3& key);
+
+        const std::vector<float>& getRoutes(
+            Cluster& cluster, const glm::ivec3& key, const glm::ivec3& entry
+        );
+
+        bool isTargetNear(const glm::ivec3& key) const;
+
+        void relax(
+            int parent,
+            const glm::ivec3& pos,
+            const glm::ivec3& via,
+            float gScore,
+            bool target
+        );
+
+        /// @brief Find voxels route within the section
+        /// @param nodes [out] route positions without the start one
+        bool refine(
+            const glm::ivec3& from,
+            const glm::ivec3& to,
+            std::vector<RouteNode>& nodes
+        );
+
+        Route restore(int portal);
+    };
+}
+
+Cluster& HierarchicalSearch::getCluster(const glm::ivec3& key) {
+    uint32_t revision;
+    int missing = get_section_revision(chunks, agent, key, revision);
+    auto& cluster = clusters[key];
+    if (cluster.built && cluster.revision == revision &&
+        cluster.missingColumns == missing) {
+        return cluster;
+    }
+    cluster = {};
+    cluster.built = true;
+    cluster.revision = revision;
+    cluster.missingColumns = missing;
+    if (missing & 1) {
+        // section is not loaded
+        return cluster;
+    }
+    std::vector<Transition> transitions;
+    search.findTransitions(agent, section_origin(key), SECTION_SIZE, transitions);
+
+    // group transitions to the same section in the same direction
+    auto compare = [](const auto& a, const auto& b) {
+        return std::tie(a.first.x, a.first.y, a.first.z, a.second.x, a.second.y) <
+               std::tie(b.first.x, b.first.y, b.first.z, b.second.x, b.second.y);
+    };
+    std::map<
+        std::pair<glm::ivec3, glm::ivec2>,
+        std::vector<int>,
+        decltype(compare)>
+        groups(compare);
+    for (int i = 0; i < transitions.size(); i++) {
+        const auto& transition = transitions[i];
+        glm::ivec2 direction(
+            transition.to.x - transition.from.x,
+            transition.to.z - transition.from.z
+        );
+        groups[{section_key(transition.to), direction}].push_back(i);
+    }
+    std::vector<int> parents(transitions.size());
+    auto find = [&parents](int i) {
+        while (parents[i] != i) {
+            i = parents[i] = parents[parents[i]];
+        }
+        return i;
+    };
+    for (const auto& [_, indices] : groups) {
+        for (int i : indices) {
+            parents[i] = i;
+        }
+        // touching positions form a single portal
+        for (int a = 0; a < indices.size(); a++) {
+            for (int b = a + 1; b < indices.size(); b++) {
+                auto delta = glm::abs(
+                    transitions[indices[a]].from - transitions[indices[b]].from
+                );
+                if (std::max(delta.x, std::max(delta.y, delta.z)) <= 1) {
+                    parents[find(indices[a])] = find(indices[b]);
+                }
+            }
+        }
+        std::unordered_map<int, std::vector<int>> portals;
+        for (int i : indices) {
+            portals[find(i)].push_back(i);
+        }
+        for (const auto& [_, members] : portals) {
+            // middle of the portal
+            cluster.exits.push_back(transitions[members[members.size() / 2]]);
+        }
+    }
+    return cluster;
+}
+
+const std::vector<float>& HierarchicalSearch::getRoutes(
+    Cluster& cluster, const glm::ivec3& key, const glm::ivec3& entry
+) {
+    const auto& found = cluster.routes.find(entry);
+    if (found != cluster.routes.end()) {
+        return found->second;
+    }
+    visited += search.flood(
+        agent, state, entry, section_origin(key), SECTION_SIZE
+    );
+    auto& costs = cluster.routes[entry];
+    for (const auto& exit : cluster.exits) {
+        costs.push_back(flooded_cost(state, exit.from));
+    }
+    return costs;
+}
+
+bool HierarchicalSearch::isTargetNear(const glm::ivec3& key) const {
+    auto origin = section_origin(key);
+    const auto& target = agent.target;
+    int height = std::max(agent.height, 1);
+    return target.x >= origin.x && target.x < origin.x + CHUNK_W &&
+           target.z >= origin.z && target.z < origin.z + CHUNK_D &&
+           target.y + height > origin.y &&
+           target.y - height < origin.y + CHUNK_SECTION_H;
+}
+
+void HierarchicalSearch::relax(
+    int parent,
+    const glm::ivec3& pos,
+    const glm::ivec3& via,
+    float gScore,
+    bool target
+) {
+    auto found = portalsMap.find(pos);
+    if (found != portalsMap.end()) {
+        auto& portal = portals[found->second];
+        if (portal.closed || portal.gScore <= gScore) {
+            return;
+        }
+        portal.parent = parent;
+        portal.via = via;
+        portal.gScore = gScore;
+        portal.target |= target;
+        open.push({gScore + heuristic(pos, agent.target), found->second});
+        return;
+    }
+    int index = portals.size();
+    portalsMap[pos] = index;
+    portals.push_back(Portal {pos, parent, via, gScore, false, target});
+    open.push({gScore + heuristic(pos, agent.target), index});
+}
+
+Route HierarchicalSearch::perform() {
+    relax(-1, agent.start, agent.start, 0.0f, false);
+    int height = std::max(agent.height, 1);
+    int nearest = 0;
+    float minHScore = heuristic(agent.start, agent.target);
+    int expanded = 0;
+
+    while (!open.empty() && expanded < MAX_VISITED_PORTALS) {
+        auto [fScore, index] = open.top();
+        open.pop();
+        if (portals[index].closed) {
+            continue;
+        }
+        portals[index].closed = true;
+        const Portal portal = portals[index];
+        if (portal.target) {
+            return restore(index);
+        }
+        expanded++;
+        float hScore = heuristic(portal.pos, agent.target);
+        if (hScore < minHScore) {
+            minHScore = hScore;
+            nearest = index;
+        }
+
+        auto key = section_key(portal.pos);
+        if (key.y < 0 || key.y >= CHUNK_SECTIONS) {
+            continue;
+        }
+        auto& cluster = getCluster(key);
+        const std::vector<float>* costs;
+        std::vector<float> nearCosts;
+        if (isTargetNear(key)) {
+            // route to the target is not cached, so the section is
+            // searched again
+            visited += search.flood(
+                agent, state, portal.pos, section_origin(key), SECTION_SIZE
+            );
+            for (const auto& exit : cluster.exits) {
+                nearCosts.push_back(flooded_cost(state, exit.from));
+            }
+            costs = &nearCosts;
+
+            const auto& target = agent.target;
+            for (int y = target.y - height + 1; y < target.y + height; y++) {
+                glm::ivec3 pos(target.x, y, target.z);
+                float cost = flooded_cost(state, pos);
+                if (cost < INFINITY) {
+                    relax(index, pos, pos, portal.gScore + cost, true);
+                }
+            }
+        } else {
+            costs = &getRoutes(cluster, key, portal.pos);
+        }
+        for (int i = 0; i < cluster.exits.size(); i++) {
+            float cost = (*costs)[i];
+            if (cost == INFINITY) {
+                continue;
+            }
+            const auto& exit = cluster.exits[i];
+            relax(
+                index, exit.to, exit.from, portal.gScore + cost + exit.cost, false
+            );
+        }
+    }
+    if (agent.mayBeIncomplete) {
+        return restore(nearest);
+    }
+    return Route {false, {}, visited};
+}
+
+bool HierarchicalSearch::refine(
+    const glm::ivec3& from,
+    const glm::ivec3& to,
+    std::vector<RouteNode>& nodes
+) {
+    Agent local;
+    local.mayBeIncomplete = false;
+    local.height = agent.height;
+    local.jumpHeight = agent.jumpHeight;
+    local.maxVisitedBlocks = CHUNK_W * CHUNK_SECTION_H * CHUNK_D;
+    local.avoidTags = agent.avoidTags;
+    local.start = from;
+    local.target = to;
+    local.state = std::move(state);
+    start_search(local, section_origin(section_key(from)), SECTION_SIZE);
+    auto route = search.perform(local, -1);
+    state = std::move(local.state);
+    visited += route.totalVisited;
+
+    const auto& reached = route.nodes.front().pos;
+    if (reached.x != to.x || reached.z != to.z) {
+        return false;
+    }
+    // route nodes are ordered from the end to the start
+    for (int i = static_cast<int>(route.nodes.size()) - 1; i >= 0; i--) {
+        const auto& pos = route.nodes[i].pos;
+        if (pos != from && (nodes.empty() || nodes.back().pos != pos)) {
+            nodes.push_back(route.nodes[i]);
+        }
+    }
+    return true;
+}
+
+Route HierarchicalSearch::restore(int portal) {
+    std::vector<int> chain;
+    for (int index = portal; index != -1; index = portals[index].parent) {
+        chain.push_back(index);
+    }
+    std::reverse(chain.begin(), chain.end());
+
+    Route route {true, {{agent.start}}, 0};
+    for (size_t i = 1; i < chain.size(); i++) {
+        const auto& prev = portals[chain[i - 1]];
+        const auto& next = portals[chain[i]];
+        if (!refine(prev.pos, next.via, route.nodes)) {
+            // voxels changed while the route was planned
+            route.found = agent.mayBeIncomplete;
+            break;
+        }
+        if (!next.target) {
+            route.nodes.push_back({next.pos});
+        }
+    }
+    std::reverse(route.nodes.begin(), route.nodes.end());
+    route.totalVisited = visited;
+    return route;
+}
+
+Route Pathfinding::performHierarchical(Agent& agent) {
+    VC_PROFILE_ZONE("Pathfinding::performHierarchical");
+    auto& clusters = graph->profiles[AgentProfile {
+        agent.height, agent.jumpHeight, agent.avoidTags}];
+    blocks_agent::ChunksCursor cursor(chunks);
+    Search<blocks_agent::ChunksCursor<GlobalChunks>> search(cursor, blockDefs);
+    auto route = HierarchicalSearch(chunks, search, clusters, agent).perform();
+    agent.state.reset();
+    agent.route = route;
+    return route;
+}
+
+bool Pathfinding::performShared(Agent& agent) {
+    AgentProfile profile {agent.height, agent.jumpHeight, agent.avoidTags};
+    uint64_t minTick = tick >= static_cast<uint64_t>(fieldLifetime)
+                           ? tick - fieldLifetime + 1
+                           : 0;
+    int visited = 0;
+    auto field = fields->find(profile, agent.target, minTick);
+    if (field == nullptr) {
+        VC_PROFILE_ZONE("Pathfinding::buildSharedField");
+        auto& list = fields->fields;
+        if (list.size() >= MAX_SHARED_FIELDS) {
+            // reuse the oldest field memory
+            auto oldest = std::min_element(
+                list.begin(),
+                list.end(),
+                [](const auto& a, const auto& b) { return a.tick < b.tick; }
+            );
+            std::swap(*oldest, list.back());
+        } else {
+            list.emplace_back();
+        }
+        field = &list.back();
+        field->profile = std::move(profile);
+        field->target = agent.target;
+        field->tick = tick;
+
+        glm::ivec3 radius(
+            SHARED_FIELD_RADIUS_XZ, SHARED_FIELD_RADIUS_Y, SHARED_FIELD_RADIUS_XZ
+        );
+        blocks_agent::ChunksCursor cursor(chunks);
+        visited = Search<blocks_agent::ChunksCursor<GlobalChunks>>(
+            cursor, blockDefs
+        ).floodTo(
+            agent, field->state, agent.target, agent.target - radius,
+            radius * 2 + 1
+        );
+    }
+    auto& state = field->state;
+    auto cell = state.getCell(agent.start);
+    if (cell == nullptr || cell->generation != state.generation) {
+        return false;
+    }
+    Route route {};
+    for (int index = cell->node; index != -1; index = state.nodes[index].parent) {
+        route.nodes.push_back({state.nodes[index].pos});
+    }
+    std::reverse(route.nodes.begin(), route.nodes.end());
+    route.found = true;
+    route.totalVisited = visited;
+    agent.state.reset();
+    agent.route = std::move(route);
+    return true;
+}
+
 Agent* Pathfinding::getAgent(int id) {
     const auto& found = agents.find(id);
     if (found != agents.end()) {
@@ -215,9 +1444,12 @@ const std::unordered_map<int, Agent>& Pathfinding::getAgents() const {
     return agents;
 }
 
-int Pathfinding::checkPoint(const Agent& agent, int x, int y, int z, int& cost) {
-    auto vox = blocks_agent::get(chunks, x, y, z);
-    if (vox == nullptr) {
+template <class Storage>
+int Search<Storage>::checkPoint(
+    const Agent& agent, int x, int y, int z, int& cost
+) const {
+    auto vox = blocks_agent::get_voxel(chunks, x, y, z);
+    if (!vox) {
         return OBSTACLE;
     }
     const auto& def = blockDefs.require(vox->id);
@@ -233,9 +1465,10 @@ int Pathfinding::checkPoint(const Agent& agent, int x, int y, int z, int& cost)
     return PASSABLE;
 }
 
-int Pathfinding::getSurfaceAt(
+template <class Storage>
+int Search<Storage>::getSurfaceAt(
     const Agent& agent, const glm::ivec3& pos, int maxDelta, float& cost
-) {
+) const {
     using namespace blocks_agent;
 
     int status;
@@ -5,10 +5,8 @@
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <memory>
-#include <queue>
 #include <set>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "typedefs.hpp"
@@ -20,7 +18,16 @@ class GlobalChunks;
 template <typename T, typename IdType>
 class ContentUnitIndices;
 
+namespace util {
+    template <class T, class R>
+    class ThreadPool;
+}
+
 namespace voxels {
+    class VoxelsSnapshot;
+    class PortalsGraph;
+    class SharedFields;
+
     struct RouteNode {
         glm::ivec3 pos;
     };
@@ -33,29 +40,71 @@ namespace voxels {
 
     struct Node {
         glm::ivec3 pos;
-        glm::ivec3 parent;
+        /// @brief Index of the parent node (-1 for the start node)
+        int parent;
         float gScore;
         float fScore;
+        /// @brief Position in the open nodes heap (-1 if the node is closed)
+        int heapIndex;
     };
 
-    struct NodeLess {
-        bool operator()(const Node& l, const Node& r) const {
-            return l.fScore > r.fScore;
-        }
+    /// @brief Search area cell
+    struct ArenaCell {
+        /// @brief Cell is not discovered if not equal to State::generation
+        uint32_t generation;
+        /// @brief Index of the node in State::nodes
+        int node;
     };
 
+    /// @brief A* search state. Search is limited to a box area (arena)
+    /// around start and target positions. Buffers are kept between
+    /// searches, so repeated searches of an agent do not allocate memory
     struct State {
-        std::priority_queue<Node, std::vector<Node>, NodeLess> queue;
-        std::unordered_set<glm::ivec3> blocked;
-        std::unordered_map<glm::ivec3, Node> parents;
-        glm::ivec3 nearest;
+        std::vector<Node> nodes;
+        /// @brief Binary heap of open nodes indices ordered by fScore
+        std::vector<int> heap;
+        std::vector<ArenaCell> cells;
+        glm::ivec3 arenaOrigin {};
+        glm::ivec3 arenaSize {};
+        /// @brief Incremented on every search start to invalidate cells
+        uint32_t generation = 0;
+        /// @brief Number of closed nodes
+        int closedCount = 0;
+        /// @brief Index of node nearest to the target
+        int nearest = -1;
         float minHScore;
         bool finished = true;
+        /// @brief Route is planned over the sections portals graph on the
+        /// main thread (target is too far for the arena)
+        bool hierarchical = false;
+        /// @brief Voxels of the arena area read by the async search
+        std::shared_ptr<VoxelsSnapshot> snapshot;
+
+        /// @brief Prepare for a new search keeping allocated memory
+        void reset();
+
+        /// @brief Start search: setup arena and push the start node
+        void begin(const glm::ivec3& start, const glm::ivec3& target);
+
+        /// @brief Start search in the given arena box
+        void beginArea(const glm::ivec3& origin, const glm::ivec3& size);
+
+        /// @return cell of the position or nullptr if the position is
+        /// outside of the arena
+        ArenaCell* getCell(const glm::ivec3& pos);
+
+        void push(int node);
+        int pop();
+        /// @brief Restore heap order after node fScore decrease
+        void decrease(int node);
     };
 
     struct Agent {
         bool enabled = false;
         bool mayBeIncomplete = true;
+        /// @brief Read route from the field of routes to the target
+        /// shared by agents having the same target and parameters
+        bool sharedTarget = false;
         int height = 2;
         int jumpHeight = 1;
         int maxVisitedBlocks = 1e3;
@@ -64,18 +113,56 @@ namespace voxels {
         Route route;
         State state {};
         std::set<std::pair<int, int>> avoidTags;
+        /// @brief Incremented on new search start, so the async search
+        /// results of the previous one are dropped
+        int searchId = 0;
+        /// @brief Search is running on a worker
+        bool inwork = false;
+    };
+
+    struct PathfindingJob {
+        int agentId;
+        /// @brief Copy of the agent owning the search state
+        std::shared_ptr<Agent> agent;
+        int steps;
+    };
+
+    struct PathfindingResult {
+        int agentId;
+        std::shared_ptr<Agent> agent;
     };
 
     class Pathfinding {
     public:
         Pathfinding(const Level& level);
+        ~Pathfinding();
 
         int createAgent();
 
         bool removeAgent(int id);
 
-        void performAllAsync(int stepsPerAgent);
+        /// @brief Publish results of the async searches and continue
+        /// unfinished searches on workers. Agents nearest to the players
+        /// are processed first. Searches read copy of the voxels area
+        /// made on search start
+        /// @param stepsPerAgent max visited blocks by an agent per call
+        /// @param stepsPerTick max visited blocks by all agents per call
+        /// @param fieldLifetime ticks the shared target fields are kept
+        void performAllAsync(
+            int stepsPerAgent, int stepsPerTick, int fieldLifetime
+        );
 
+        /// @brief Cancel running async search if any and prepare agent
+        /// for a new search
+        void resetAgent(Agent& agent);
+
+        /// @brief Find route to the agent target. Targets too far for a
+        /// single voxels search are routed over the chunk sections portals
+        /// graph first, then the route is refined within sections.
+        /// Shared target agents read the route from the target field
+        /// made by the first of them (see Agent::sharedTarget)
+        /// @param maxVisited max visited blocks (0 - only start the async
+        /// search)
         Route perform(Agent& agent, int maxVisited = -1);
 
         Agent* getAgent(int id);
@@ -87,11 +174,22 @@ namespace voxels {
         const ContentUnitIndices<Block, blockid_t>& blockDefs;
         std::unordered_map<int, Agent> agents;
         int nextAgent = 1;
-
-        int getSurfaceAt(
-            const Agent& agent, const glm::ivec3& pos, int maxDelta, float& cost
-        );
-
-        int checkPoint(const Agent& agent, int x, int y, int z, int& cost);
+        std::unique_ptr<util::ThreadPool<PathfindingJob, PathfindingResult>>
+            pool;
+        /// @brief Lazily built sections portals graphs
+        std::unique_ptr<PortalsGraph> graph;
+        /// @brief Fields of routes to the shared targets
+        std::unique_ptr<SharedFields> fields;
+        /// @brief Number of performAllAsync calls
+        uint64_t tick = 0;
+        int fieldLifetime = 20;
+
+        void installResult(PathfindingResult&& result);
+
+        Route performHierarchical(Agent& agent);
+
+        /// @return false if the agent start is not covered by the target
+        /// field
+        bool performShared(Agent& agent);
     };
 }
@@ -138,10 +138,18 @@ public:
         return voxels;
     }
 
+    const voxel* getVoxels() const {
+        return voxels;
+    }
+
     light_t* getLights() {
         return lights;
     }
 
+    const light_t* getLights() const {
+        return lights;
+    }
+
     inline blockid_t pickBlockId(uint bx, uint by, uint bz) const {
         bx -= x;
         by -= y;
@@ -28,15 +28,13 @@ static void on_chunk_register_event(
     const Chunk& chunk,
     bool present
 ) {
-    const auto& voxels = chunk.voxels;
-
     int totalBegin = chunk.bottom * (CHUNK_W * CHUNK_D);
     int totalEnd = chunk.top * (CHUNK_W * CHUNK_D);
 
     uint8_t flagsCache[1024] {};
 
     for (int i = totalBegin; i < totalEnd; i++) {
-        blockid_t id = voxels[i].id;
+        blockid_t id = chunk.get(i).id;
         uint8_t bits = id < sizeof(flagsCache) ? flagsCache[id] : 0;
         if ((bits & 0x80) == 0) {
             const auto& def = indices.blocks.require(id);
@@ -72,20 +70,20 @@ void blocks_agent::on_chunk_remove(
 
 template <class Storage>
 static void mark_neighboirs_modified(
-    Storage& chunks, int32_t cx, int32_t cz, int32_t lx, int32_t lz
+    Storage& chunks, int32_t cx, int32_t cz, int32_t lx, int32_t y, int32_t lz
 ) {
     Chunk* chunk;
     if (lx == 0 && (chunk = get_chunk(chunks, cx - 1, cz))) {
-        chunk->flags.modified = true;
+        chunk->setModified(y);
     }
     if (lz == 0 && (chunk = get_chunk(chunks, cx, cz - 1))) {
-        chunk->flags.modified = true;
+        chunk->setModified(y);
     }
     if (lx == CHUNK_W - 1 && (chunk = get_chunk(chunks, cx + 1, cz))) {
-        chunk->flags.modified = true;
+        chunk->setModified(y);
     }
     if (lz == CHUNK_D - 1 && (chunk = get_chunk(chunks, cx, cz + 1))) {
-        chunk->flags.modified = true;
+        chunk->setModified(y);
     }
 }
 
@@ -118,8 +116,7 @@ static void finalize_block(
     if (def.dataStruct) {
         if (auto found = chunk.blocksMetadata.find(index)) {
             chunk.blocksMetadata.free(found);
-            chunk.flags.unsaved = true;
-            chunk.flags.blocksData = true;
+            chunk.setBlocksDataModified();
         }
     }
 
@@ -147,13 +144,13 @@ static void initialize_block(
     const auto& def = indices.blocks.require(id);
     vox.id = id;
     vox.state = state;
-    chunk.setModifiedAndUnsaved();
+    chunk.setModifiedAndUnsaved(y);
     if (!state.segment && def.rt.extended) {
         restore_segments(chunks, def, state, x, y, z);
     }
 
     refresh_chunk_heights(chunk, id == BLOCK_AIR, y);
-    mark_neighboirs_modified(chunks, cx, cz, lx, lz);
+    mark_neighboirs_modified(chunks, cx, cz, lx, y, lz);
 
     uint8_t bits = get_events_bits(def);
     if (bits == 0) {
@@ -185,7 +182,7 @@ static inline bool set_block(
     int lx = x - cx * CHUNK_W;
     int lz = z - cz * CHUNK_D;
 
-    voxel& vox = chunk->voxels[(y * CHUNK_D + lz) * CHUNK_W + lx];
+    voxel& vox = chunk->getVoxels()[vox_index(lx, y, lz)];
 
     finalize_block(chunks, *chunk, vox, x, y, z, lx, lz);
     initialize_block(chunks, *chunk, vox, id, state, x, y, z, lx, lz, cx, cz);
@@ -214,67 +211,180 @@ bool blocks_agent::set(
     return set_block(chunks, x, y, z, id, state);
 }
 
+namespace {
+    /// @brief Voxel grid traversal state (DDA stepping through every voxel
+    /// crossed by the ray)
+    struct VoxelRay {
+        glm::vec3 start;
+        glm::vec3 dir;
+        float t = 0.0f;
+        glm::ivec3 pos;
+        glm::ivec3 step;
+        glm::vec3 tDelta;
+        /// @brief Ray length at the next voxel border crossing on each axis
+        glm::vec3 tMax;
+        /// @brief Axis of the last step (-1 if not stepped yet)
+        int steppedIndex = -1;
+
+        VoxelRay(const glm::vec3& start, const glm::vec3& dir)
+            : start(start), dir(dir) {
+            constexpr float infinity = std::numeric_limits<float>::infinity();
+            constexpr float epsilon = 1e-6f;  // 0.000001
+            for (int i = 0; i < 3; i++) {
+                pos[i] = std::floor(start[i]);
+                step[i] = (dir[i] > 0.0f) ? 1 : -1;
+                tDelta[i] = (std::fabs(dir[i]) < epsilon)
+                                ? infinity
+                                : std::fabs(1.0f / dir[i]);
+                float dist = (step[i] > 0) ? (pos[i] + 1 - start[i])
+                                           : (start[i] - pos[i]);
+                tMax[i] = (tDelta[i] < infinity) ? tDelta[i] * dist : infinity;
+            }
+        }
+
+        void next() {
+            int axis;
+            if (tMax.x < tMax.y) {
+                axis = tMax.x < tMax.z ? 0 : 2;
+            } else {
+                axis = tMax.y < tMax.z ? 1 : 2;
+            }
+            pos[axis] += step[axis];
+            t = tMax[axis];
+            tMax[axis] += tDelta[axis];
+            steppedIndex = axis;
+        }
+
+        glm::vec3 point() const {
+            return start + dir * t;
+        }
+
+        /// @brief Move to the last voxel of the air box [min, max) crossed
+        /// by the ray, so next() leaves the box
+        /// @param maxDist the ray is not moved further than this length
+        void skip(const glm::ivec3& min, const glm::ivec3& max, float maxDist) {
+            constexpr float infinity = std::numeric_limits<float>::infinity();
+            glm::ivec3 left;
+            float exit = maxDist;
+            for (int i = 0; i < 3; i++) {
+                left[i] = (step[i] > 0) ? (max[i] - 1 - pos[i]) : (pos[i] - min[i]);
+                if (tDelta[i] < infinity) {
+                    exit = std::min(exit, tMax[i] + left[i] * tDelta[i]);
+                }
+            }
+            // all axes take every border crossing located before the exit,
+            // so the position stays on the ray
+            for (int i = 0; i < 3; i++) {
+                if (tDelta[i] == infinity || left[i] <= 0) {
+                    continue;
+                }
+                float estimate = std::ceil((exit - tMax[i]) / tDelta[i]);
+                int k = estimate <= 0.0f ? 0 : std::min<float>(estimate, left[i]);
+                while (k > 0 && tMax[i] + (k - 1) * tDelta[i] >= exit) {
+                    k--;
+                }
+                while (k < left[i] && tMax[i] + k * tDelta[i] < exit) {
+                    k++;
+                }
+                pos[i] += step[i] * k;
+                tMax[i] += k * tDelta[i];
+            }
+        }
+
+        /// @brief Skip air voxels around the current position if they form
+        /// an empty section or space above/below chunk blocks
+        void skipAir(const Chunk& chunk, float maxDist) {
+            int minY;
+            int maxY;
+            if (pos.y >= chunk.top) {
+                minY = chunk.top;
+                maxY = CHUNK_H;
+            } else if (pos.y < chunk.bottom) {
+                minY = 0;
+                maxY = chunk.bottom;
+            } else {
+                int first = pos.y / CHUNK_SECTION_H;
+                if (!chunk.isSectionEmpty(first)) {
+                    return;
+                }
+                int last = first;
+                while (first > 0 && chunk.isSectionEmpty(first - 1)) {
+                    first--;
+                }
+                while (last + 1 < CHUNK_SECTIONS &&
+                       chunk.isSectionEmpty(last + 1)) {
+                    last++;
+                }
+                minY = first * CHUNK_SECTION_H;
+                maxY = (last + 1) * CHUNK_SECTION_H;
+                if (maxY >= chunk.top) {
+                    maxY = CHUNK_H;
+                }
+                if (minY <= chunk.bottom) {
+                    minY = 0;
+                }
+            }
+            glm::ivec3 min(chunk.x * CHUNK_W, minY, chunk.z * CHUNK_D);
+            skip(min, min + glm::ivec3(CHUNK_W, maxY - minY, CHUNK_D), maxDist);
+        }
+    };
+}
+
+/// @param index [out] voxel index in the chunk
+/// @return voxel at the ray position or std::nullopt if not loaded
+template <class Storage>
+static inline std::optional<voxel> get_ray_voxel(
+    const ChunksCursor<Storage>& cursor,
+    const glm::ivec3& pos,
+    Chunk*& chunk,
+    uint& index
+) {
+    if (pos.y < 0 || pos.y >= CHUNK_H) {
+        return std::nullopt;
+    }
+    int cx = floordiv<CHUNK_W>(pos.x);
+    int cz = floordiv<CHUNK_D>(pos.z);
+    chunk = cursor.getChunk(cx, cz);
+    if (chunk == nullptr) {
+        return std::nullopt;
+    }
+    index = vox_index(pos.x - cx * CHUNK_W, pos.y, pos.z - cz * CHUNK_D);
+    return chunk->get(index);
+}
+
 template <class Storage>
 static inline voxel* raycast_blocks(
-    const Storage& chunks,
+    const ChunksCursor<Storage>& chunks,
     const glm::vec3& start,
     const glm::vec3& dir,
     float maxDist,
     glm::vec3& end,
     glm::ivec3& norm,
     glm::ivec3& iend,
-    std::set<blockid_t> filter,
+    const std::set<blockid_t>& filter,
     bool includeNonSelectable
 ) {
     const auto& blocks = chunks.getContentIndices().blocks;
-    float px = start.x;
-    float py = start.y;
-    float pz = start.z;
-
-    float dx = dir.x;
-    float dy = dir.y;
-    float dz = dir.z;
-
-    float t = 0.0f;
-    int ix = std::floor(px);
-    int iy = std::floor(py);
-    int iz = std::floor(pz);
-
-    int stepx = (dx > 0.0f) ? 1 : -1;
-    int stepy = (dy > 0.0f) ? 1 : -1;
-    int stepz = (dz > 0.0f) ? 1 : -1;
-
-    constexpr float infinity = std::numeric_limits<float>::infinity();
-    constexpr float epsilon = 1e-6f;  // 0.000001
-    float txDelta = (std::fabs(dx) < epsilon) ? infinity : std::fabs(1.0f / dx);
-    float tyDelta = (std::fabs(dy) < epsilon) ? infinity : std::fabs(1.0f / dy);
-    float tzDelta = (std::fabs(dz) < epsilon) ? infinity : std::fabs(1.0f / dz);
-
-    float xdist = (stepx > 0) ? (ix + 1 - px) : (px - ix);
-    float ydist = (stepy > 0) ? (iy + 1 - py) : (py - iy);
-    float zdist = (stepz > 0) ? (iz + 1 - pz) : (pz - iz);
-
-    float txMax = (txDelta < infinity) ? txDelta * xdist : infinity;
-    float tyMax = (tyDelta < infinity) ? tyDelta * ydist : infinity;
-    float tzMax = (tzDelta < infinity) ? tzDelta * zdist : infinity;
-
-    int steppedIndex = -1;
-
-    while (t <= maxDist) {
-        voxel* voxel = get(chunks, ix, iy, iz);
-        if (voxel == nullptr) {
+    VoxelRay ray(start, dir);
+
+    while (ray.t <= maxDist) {
+        Chunk* chunk;
+        uint index;
+        auto voxel = get_ray_voxel(chunks, ray.pos, chunk, index);
+        if (!voxel) {
             return nullptr;
         }
+        if (voxel->id == BLOCK_AIR) {
+            ray.skipAir(*chunk, maxDist);
+            ray.next();
+            continue;
+        }
 
         const auto& def = blocks.require(voxel->id);
-        if (voxel->id != BLOCK_AIR && (def.selectable || includeNonSelectable) &&
+        if ((def.selectable || includeNonSelectable) &&
             (filter.empty() || filter.find(def.rt.id) == filter.end())) {
-            end.x = px + t * dx;
-            end.y = py + t * dy;
-            end.z = pz + t * dz;
-            iend.x = ix;
-            iend.y = iy;
-            iend.z = iz;
+            end = ray.point();
+            iend = ray.pos;
 
             if (!def.rt.solid) {
                 const std::vector<AABB>& hitboxes =
@@ -282,7 +392,7 @@ static inline voxel* raycast_blocks(
                                   : def.hitboxes;
 
                 scalar_t distance = maxDist;
-                Ray ray(start, dir);
+                Ray hitRay(start, dir);
 
                 bool hit = false;
 
@@ -296,7 +406,7 @@ static inline voxel* raycast_blocks(
                     box.b += offset;
                     scalar_t boxDistance;
                     glm::ivec3 boxNorm;
-                    if (ray.intersectAABB(
+                    if (hitRay.intersectAABB(
                             iend, box, maxDist, boxNorm, boxDistance
                         ) > RayRelation::None &&
                         boxDistance < distance) {
@@ -307,54 +417,104 @@ static inline voxel* raycast_blocks(
                     }
                 }
 
-                if (hit) return voxel;
+                if (hit) return &chunk->getVoxels()[index];
             } else {
-                iend.x = ix;
-                iend.y = iy;
-                iend.z = iz;
-
                 norm.x = norm.y = norm.z = 0;
-                if (steppedIndex == 0) norm.x = -stepx;
-                if (steppedIndex == 1) norm.y = -stepy;
-                if (steppedIndex == 2) norm.z = -stepz;
-                return voxel;
+                if (ray.steppedIndex >= 0) {
+                    norm[ray.steppedIndex] = -ray.step[ray.steppedIndex];
+                }
+                return &chunk->getVoxels()[index];
             }
         }
-        if (txMax < tyMax) {
-            if (txMax < tzMax) {
-                ix += stepx;
-                t = txMax;
-                txMax += txDelta;
-                steppedIndex = 0;
-            } else {
-                iz += stepz;
-                t = tzMax;
-                tzMax += tzDelta;
-                steppedIndex = 2;
-            }
-        } else {
-            if (tyMax < tzMax) {
-                iy += stepy;
-                t = tyMax;
-                tyMax += tyDelta;
-                steppedIndex = 1;
-            } else {
-                iz += stepz;
-                t = tzMax;
-                tzMax += tzDelta;
-                steppedIndex = 2;
+        ray.next();
+    }
+    iend = ray.pos;
+    end = ray.point();
+    norm.x = norm.y = norm.z = 0;
+    return nullptr;
+}
+
+template <class Storage>
+static inline glm::vec3 raycast_obstacle(
+    const ChunksCursor<Storage>& chunks,
+    const glm::vec3& start,
+    const glm::vec3& dir,
+    float maxDist
+) {
+    const auto& blocks = chunks.getContentIndices().blocks;
+    VoxelRay ray(start, dir);
+
+    while (ray.t <= maxDist) {
+        Chunk* chunk;
+        uint index;
+        auto voxel = get_ray_voxel(chunks, ray.pos, chunk, index);
+        if (voxel && voxel->id == BLOCK_AIR) {
+            ray.skipAir(*chunk, maxDist);
+        } else if (voxel) {
+            const auto& def = blocks.require(voxel->id);
+            if (def.obstacle) {
+                if (!def.rt.solid) {
+                    const std::vector<AABB>& hitboxes =
+                        def.rt.hitboxes[voxel->state.rotation];
+
+                    scalar_t distance;
+                    glm::ivec3 norm;
+                    Ray hitRay(start, dir);
+
+                    glm::ivec3 offset {};
+                    if (voxel->state.segment) {
+                        offset = seek_origin(chunks, ray.pos, def, voxel->state) -
+                                 ray.pos;
+                    }
+
+                    for (const auto& box : hitboxes) {
+                        // norm is dummy now, can be inefficient
+                        if (hitRay.intersectAABB(
+                                ray.pos + offset,
+                                box,
+                                maxDist,
+                                norm,
+                                distance
+                            ) > RayRelation::None) {
+                            return start + (dir * glm::vec3(distance));
+                        }
+                    }
+                } else {
+                    return ray.point();
+                }
             }
         }
+        ray.next();
     }
-    iend.x = ix;
-    iend.y = iy;
-    iend.z = iz;
+    return start + dir * maxDist;
+}
 
-    end.x = px + t * dx;
-    end.y = py + t * dy;
-    end.z = pz + t * dz;
-    norm.x = norm.y = norm.z = 0;
-    return nullptr;
+template <class Storage>
+static void raycast_batch_impl(
+    const Storage& chunks,
+    const BlockRay* rays,
+    size_t count,
+    BlockRayHit* hits,
+    const std::set<blockid_t>& filter,
+    bool includeNonSelectable
+) {
+    // rays traced by a single call usually start near each other
+    ChunksCursor cursor(chunks);
+    for (size_t i = 0; i < count; i++) {
+        const auto& ray = rays[i];
+        auto& hit = hits[i];
+        hit.vox = raycast_blocks(
+            cursor,
+            ray.start,
+            ray.dir,
+            ray.maxDist,
+            hit.end,
+            hit.norm,
+            hit.iend,
+            filter,
+            includeNonSelectable
+        );
+    }
 }
 
 voxel* blocks_agent::raycast(
@@ -368,7 +528,8 @@ voxel* blocks_agent::raycast(
     std::set<blockid_t> filter,
     bool includeNonSelectable
 ) {
-    return raycast_blocks(chunks, start, dir, maxDist, end, norm, iend, filter, includeNonSelectable);
+    ChunksCursor cursor(chunks);
+    return raycast_blocks(cursor, start, dir, maxDist, end, norm, iend, filter, includeNonSelectable);
 }
 
 voxel* blocks_agent::raycast(
@@ -382,7 +543,40 @@ voxel* blocks_agent::raycast(
     std::set<blockid_t> filter,
     bool includeNonSelectable
 ) {
-    return raycast_blocks(chunks, start, dir, maxDist, end, norm, iend, filter, includeNonSelectable);
+    ChunksCursor cursor(chunks);
+    return raycast_blocks(cursor, start, dir, maxDist, end, norm, iend, filter, includeNonSelectable);
+}
+
+void blocks_agent::raycast_batch(
+    const Chunks& chunks,
+    const BlockRay* rays,
+    size_t count,
+    BlockRayHit* hits,
+    const std::set<blockid_t>& filter,
+    bool includeNonSelectable
+) {
+    raycast_batch_impl(chunks, rays, count, hits, filter, includeNonSelectable);
+}
+
+void blocks_agent::raycast_batch(
+    const GlobalChunks& chunks,
+    const BlockRay* rays,
+    size_t count,
+    BlockRayHit* hits,
+    const std::set<blockid_t>& filter,
+    bool includeNonSelectable
+) {
+    raycast_batch_impl(chunks, rays, count, hits, filter, includeNonSelectable);
+}
+
+glm::vec3 blocks_agent::raycast_to_obstacle(
+    const Chunks& chunks,
+    const glm::vec3& start,
+    const glm::vec3& dir,
+    float maxDist
+) {
+    ChunksCursor cursor(chunks);
+    return raycast_obstacle(cursor, start, dir, maxDist);
 }
 
 // reduce nesting on next modification
@@ -432,13 +626,14 @@ inline void get_voxels_impl(
                     }
                 }
             } else {
-                const voxel* cvoxels = chunk->voxels;
-                const light_t* clights =
-                    chunk->lightmap ? chunk->lightmap->getLights() : nullptr;
+                const Lightmap* clightmap = chunk->lightmap.get();
                 for (int ly = y; ly < y + h; ly++) {
                     for (int lz = std::max(z, cz * CHUNK_D);
                              lz < std::min(z + d, (cz + 1) * CHUNK_D);
                              lz++) {
+                        const light_t* clights =
+                            clightmap ? clightmap->getRow(ly, lz - cz * CHUNK_D)
+                                      : nullptr;
                         for (int lx = std::max(x, cx * CHUNK_W);
                                  lx < std::min(x + w, (cx + 1) * CHUNK_W);
                                  lx++) {
@@ -450,9 +645,10 @@ inline void get_voxels_impl(
                                 CHUNK_W,
                                 CHUNK_D
                             );
-                            voxels[vidx] = cvoxels[cidx];
-                            light_t light = clights ? clights[cidx]
-                                                    : Lightmap::SUN_LIGHT_ONLY;
+                            voxels[vidx] = chunk->get(cidx);
+                            light_t light = clights
+                                ? clights[lx - cx * CHUNK_W]
+                                : Lightmap::SUN_LIGHT_ONLY;
                             if (backlight) {
                                 const auto block = blocks.get(voxels[vidx].id);
                                 if (block && block->lightPassing) {
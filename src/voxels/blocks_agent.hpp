@@ -14,6 +14,7 @@
 #include "maths/voxmaths.hpp"
 
 #include <algorithm>
+#include <optional>
 #include <set>
 #include <algorithm>
 #include <stdint.h>
@@ -51,7 +52,8 @@ inline Chunk* get_chunk(const Storage& chunks, int cx, int cz) {
 }
 
 /// @brief Get voxel at specified position.
-/// Returns nullptr if voxel does not exists. 
+/// Returns nullptr if voxel does not exists. Packed chunk is unpacked,
+/// so get_voxel is preferred for reading
 /// @tparam Storage chunks storage class
 /// @param chunks chunks storage
 /// @param x position X
@@ -71,7 +73,31 @@ inline voxel* get(const Storage& chunks, int32_t x, int32_t y, int32_t z) {
     }
     int lx = x - cx * CHUNK_W;
     int lz = z - cz * CHUNK_D;
-    return &chunk->voxels[(y * CHUNK_D + lz) * CHUNK_W + lx];
+    return &chunk->getVoxels()[vox_index(lx, y, lz)];
+}
+
+/// @brief Get voxel value at specified position without unpacking
+/// packed chunk.
+/// @tparam Storage chunks storage class
+/// @param chunks chunks storage
+/// @param x position X
+/// @param y position Y
+/// @param z position Z
+/// @return voxel or std::nullopt if voxel does not exists
+template<class Storage>
+inline std::optional<voxel> get_voxel(
+    const Storage& chunks, int32_t x, int32_t y, int32_t z
+) {
+    if (y < 0 || y >= CHUNK_H) {
+        return std::nullopt;
+    }
+    int cx = floordiv<CHUNK_W>(x);
+    int cz = floordiv<CHUNK_D>(z);
+    const Chunk* chunk = get_chunk(chunks, cx, cz);
+    if (chunk == nullptr) {
+        return std::nullopt;
+    }
+    return chunk->get(x - cx * CHUNK_W, y, z - cz * CHUNK_D);
 }
 
 /// @brief Get voxel at specified position.
@@ -106,7 +132,7 @@ inline const Block& get_block_def(const Storage& chunks, blockid_t id) {
 /// @return true if block exists and solid
 template<class Storage>
 inline bool is_solid_at(const Storage& chunks, int32_t x, int32_t y, int32_t z) {
-    if (auto vox = get(chunks, x, y, z)) {
+    if (auto vox = get_voxel(chunks, x, y, z)) {
         return get_block_def(chunks, vox->id).rt.solid;
     }
     return false;
@@ -121,7 +147,7 @@ inline bool is_solid_at(const Storage& chunks, int32_t x, int32_t y, int32_t z)
 /// @return true if block exists and replaceable
 template<class Storage>
 inline bool is_replaceable_at(const Storage& chunks, int32_t x, int32_t y, int32_t z) {
-    if (auto vox = get(chunks, x, y, z)) {
+    if (auto vox = get_voxel(chunks, x, y, z)) {
         return get_block_def(chunks, vox->id).replaceable;
     }
     return false;
@@ -254,7 +280,7 @@ inline glm::ivec3 seek_origin(
         if (segment & 2) pos -= rotation.axes[1];
         if (segment & 4) pos -= rotation.axes[2];
 
-        if (auto* voxel = get(chunks, pos.x, pos.y, pos.z)) {
+        if (auto voxel = get_voxel(chunks, pos.x, pos.y, pos.z)) {
             segment = voxel->state.segment;
         } else {
             return pos;
@@ -288,7 +314,7 @@ inline bool check_replaceability(
                 pos += rotation.axes[0] * sx;
                 pos += rotation.axes[1] * sy;
                 pos += rotation.axes[2] * sz;
-                if (auto vox = get(chunks, pos.x, pos.y, pos.z)) {
+                if (auto vox = get_voxel(chunks, pos.x, pos.y, pos.z)) {
                     auto& target = blocks.require(vox->id);
                     if (!target.replaceable && vox->id != ignore) {
                         return false;
@@ -350,7 +376,7 @@ inline void set_rotation_extended(
                     int cz = floordiv<CHUNK_D>(pos.z);
                     auto chunk = get_chunk(chunks, cx, cz);
                     assert(chunk != nullptr);
-                    chunk->setModifiedAndUnsaved();
+                    chunk->setModifiedAndUnsaved(pos.y);
                     segmentBlocks.emplace_back(pos);
                 }
             }
@@ -406,7 +432,7 @@ inline void set_rotation(
         int cz = floordiv<CHUNK_D>(z);
         auto chunk = get_chunk(chunks, cx, cz);
         assert(chunk != nullptr);
-        chunk->setModifiedAndUnsaved();
+        chunk->setModifiedAndUnsaved(y);
     }
 }
 
@@ -456,6 +482,70 @@ voxel* raycast(
     bool includeNonSelectable
 );
 
+/// @brief Ray traced by raycast_batch
+struct BlockRay {
+    glm::vec3 start;
+    /// @brief normalized ray direction vector
+    glm::vec3 dir;
+    float maxDist;
+};
+
+/// @brief Result of a ray traced by raycast_batch (see raycast)
+struct BlockRayHit {
+    /// @brief hit voxel or nullptr
+    voxel* vox;
+    glm::vec3 end;
+    glm::ivec3 norm;
+    glm::ivec3 iend;
+};
+
+/// @brief Cast many rays to selectable blocks at once. Cheaper than
+/// separate raycast calls for rays located close to each other.
+/// @param chunks chunks matrix
+/// @param rays rays to trace
+/// @param count number of rays
+/// @param hits [out] results array of count elements
+/// @param filter filtered ids
+/// @param includeNonSelectable will non-selectable blocks be included
+void raycast_batch(
+    const Chunks& chunks,
+    const BlockRay* rays,
+    size_t count,
+    BlockRayHit* hits,
+    const std::set<blockid_t>& filter,
+    bool includeNonSelectable
+);
+
+/// @brief Cast many rays to selectable blocks at once. Cheaper than
+/// separate raycast calls for rays located close to each other.
+/// @param chunks chunks storage
+/// @param rays rays to trace
+/// @param count number of rays
+/// @param hits [out] results array of count elements
+/// @param filter filtered ids
+/// @param includeNonSelectable will non-selectable blocks be included
+void raycast_batch(
+    const GlobalChunks& chunks,
+    const BlockRay* rays,
+    size_t count,
+    BlockRayHit* hits,
+    const std::set<blockid_t>& filter,
+    bool includeNonSelectable
+);
+
+/// @brief Cast ray to the nearest obstacle block
+/// @param chunks chunks matrix
+/// @param start ray start position
+/// @param dir normalized ray direction vector
+/// @param maxDist maximum ray length
+/// @return ray end position
+glm::vec3 raycast_to_obstacle(
+    const Chunks& chunks,
+    const glm::vec3& start,
+    const glm::vec3& dir,
+    float maxDist
+);
+
 void get_voxels(const Chunks& chunks, VoxelsVolume* volume, bool backlight=false);
 
 void get_voxels(const GlobalChunks& chunks, VoxelsVolume* volume, bool backlight=false);
@@ -465,16 +555,22 @@ inline const AABB* is_obstacle_at(const Storage& chunks, float x, float y, float
     int ix = std::floor(x);
     int iy = std::floor(y);
     int iz = std::floor(z);
-    voxel* v = get(chunks, ix, iy, iz);
-    if (v == nullptr) {
-        if (iy >= CHUNK_H) {
+    auto v = get_voxel(chunks, ix, iy, iz);
+    // unit cube
+    static const AABB full;
+    if (!v) {
+        return iy >= CHUNK_H ? nullptr : &full;
+    }
+    const auto& indices = chunks.getContentIndices();
+    switch (indices.getBlockCollision(v->id)) {
+        case BlockCollision::NONE:
             return nullptr;
-        } else {
-            static const AABB empty;
-            return &empty;
-        }
+        case BlockCollision::FULL:
+            return &full;
+        case BlockCollision::COMPLEX:
+            break;
     }
-    const auto& def = chunks.getContentIndices().blocks.require(v->id);
+    const auto& def = indices.blocks.require(v->id);
     if (def.obstacle) {
         glm::ivec3 offset {};
         if (v->state.segment) {
@@ -494,4 +590,37 @@ inline const AABB* is_obstacle_at(const Storage& chunks, float x, float y, float
     return nullptr;
 }
 
+/// @brief Chunks storage adapter caching the last accessed chunk, so
+/// access to nearby voxels in a loop skips the storage lookup.
+/// Usable as Storage of all blocks_agent templates.
+/// @attention cached chunk is not updated on chunks loading or unloading,
+/// so a cursor must be used within a single operation only
+/// @tparam Storage chunks storage class
+template <class Storage>
+class ChunksCursor {
+    const Storage& chunks;
+    mutable Chunk* chunk = nullptr;
+    mutable int cx = INT32_MIN;
+    mutable int cz = INT32_MIN;
+public:
+    explicit ChunksCursor(const Storage& chunks) : chunks(chunks) {}
+
+    Chunk* getChunk(int x, int z) const {
+        if (x != cx || z != cz) {
+            chunk = get_chunk(chunks, x, z);
+            cx = x;
+            cz = z;
+        }
+        return chunk;
+    }
+
+    const AABB* isObstacleAt(float x, float y, float z) const {
+        return is_obstacle_at(*this, x, y, z);
+    }
+
+    const ContentIndices& getContentIndices() const {
+        return chunks.getContentIndices();
+    }
+};
+
 } // blocks_agent
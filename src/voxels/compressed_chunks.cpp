@@ -5,20 +5,28 @@
 
 #include "world/files/WorldFiles.hpp"
 #include "content/Content.hpp"
+#include "util/BufferPool.hpp"
 
 inline constexpr int HAS_VOXELS = 0x1;
 inline constexpr int HAS_METADATA = 0x2;
+/// @brief Data contains changed layers only
+inline constexpr int IS_DELTA = 0x4;
 
-std::vector<ubyte> compressed_chunks::encode(
-    const ubyte* data,
-    const BlocksMetadata& metadata,
-    util::Buffer<ubyte>& rleBuffer
+inline constexpr int LAYER_VOL = CHUNK_W * CHUNK_D;
+
+/// @brief Scratch buffers shared by all threads encoding chunks
+static util::BufferPool<ubyte> rle_buffers(CHUNK_DATA_LEN * 2);
+/// @brief Scratch buffers shared by all threads decoding chunks
+static util::BufferPool<ubyte> voxel_buffers(CHUNK_DATA_LEN);
+
+static std::vector<ubyte> encode_impl(
+    const ubyte* data, const BlocksMetadata& metadata, ubyte* rleBuffer
 ) {
     size_t rleCompressedSize =
-        extrle::encode16(data, CHUNK_DATA_LEN, rleBuffer.data());
+        extrle::encode16(data, CHUNK_DATA_LEN, rleBuffer);
 
     const auto gzipCompressedData = gzip::compress(
-        rleBuffer.data(), rleCompressedSize
+        rleBuffer, rleCompressedSize
     );
     auto metadataBytes = metadata.serialize();
 
@@ -32,21 +40,141 @@ std::vector<ubyte> compressed_chunks::encode(
     return builder.build();
 }
 
+std::vector<ubyte> compressed_chunks::encode(
+    const ubyte* data,
+    const BlocksMetadata& metadata,
+    util::Buffer<ubyte>& rleBuffer
+) {
+    return encode_impl(data, metadata, rleBuffer.data());
+}
+
+std::vector<ubyte> compressed_chunks::encode(
+    const ubyte* data, const BlocksMetadata& metadata
+) {
+    auto rleBuffer = rle_buffers.get();
+    return encode_impl(data, metadata, rleBuffer.get());
+}
+
 std::vector<ubyte> compressed_chunks::encode(const Chunk& chunk) {
     auto data = chunk.encode();
+    return encode(data.get(), chunk.blocksMetadata);
+}
+
+std::vector<ubyte> compressed_chunks::encode_delta(
+    const Chunk& chunk, uint32_t baseRevision
+) {
+    // ranges of changed layers: 
+    // int16 first layer, int16 layers count,
+    // uint16 ids[count * LAYER_VOL], uint16 states[count * LAYER_VOL]
+    ByteBuilder voxels;
+    int rangesCount = 0;
+    for (int y = 0; y < CHUNK_H;) {
+        if (chunk.layerRevisions[y] <= baseRevision) {
+            y++;
+            continue;
+        }
+        int first = y;
+        while (y < CHUNK_H && chunk.layerRevisions[y] > baseRevision) {
+            y++;
+        }
+        uint begin = first * LAYER_VOL;
+        uint end = y * LAYER_VOL;
+        voxels.putInt16(first);
+        voxels.putInt16(y - first);
+        for (uint index = begin; index < end; index++) {
+            voxels.putInt16(chunk.get(index).id);
+        }
+        for (uint index = begin; index < end; index++) {
+            voxels.putInt16(blockstate2int(chunk.get(index).state));
+        }
+        rangesCount++;
+    }
+    bool hasMetadata = chunk.metadataRevision > baseRevision;
+
+    ByteBuilder builder;
+    builder.put(
+        IS_DELTA | (rangesCount ? HAS_VOXELS : 0) |
+        (hasMetadata ? HAS_METADATA : 0)
+    );
+    builder.put(0); // reserved
+    builder.putInt32(baseRevision);
+    builder.putInt32(chunk.revision);
+    if (rangesCount) {
+        auto bytes = voxels.build();
+        auto compressed = gzip::compress(bytes.data(), bytes.size());
+        builder.putInt32(compressed.size());
+        builder.putInt16(rangesCount);
+        builder.put(compressed.data(), compressed.size());
+    }
+    if (hasMetadata) {
+        auto metadataBytes = chunk.blocksMetadata.serialize();
+        builder.putInt32(metadataBytes.size());
+        builder.put(metadataBytes.data(), metadataBytes.size());
+    }
+    return builder.build();
+}
+
+bool compressed_chunks::is_delta(const ubyte* src, size_t size) {
+    return size > 0 && (src[0] & IS_DELTA);
+}
+
+static void check_block_id(
+    const Chunk& chunk,
+    blockid_t id,
+    size_t index,
+    const ContentIndices& indices
+) {
+    if (indices.blocks.get(id) == nullptr) {
+        throw std::runtime_error(
+            "block data corruption (chunk: " + std::to_string(chunk.x) +
+            ", " + std::to_string(chunk.z) + ") at " +
+            std::to_string(index) + " id: " + std::to_string(id)
+        );
+    }
+}
 
-    /// world.get_chunk_data is only available in the main Lua state
-    static util::Buffer<ubyte> rleBuffer(CHUNK_DATA_LEN * 2);
-    return encode(data.get(), chunk.blocksMetadata, rleBuffer);
+static void decode_delta_voxels(
+    Chunk& chunk, ByteReader& reader, const ContentIndices& indices
+) {
+    size_t gzipCompressedSize = reader.getInt32();
+    int rangesCount = reader.getInt16();
+    auto bytes = gzip::decompress(reader.pointer(), gzipCompressedSize);
+    reader.skip(gzipCompressedSize);
+
+    ByteReader ranges(bytes.data(), bytes.size());
+    voxel* voxels = chunk.getVoxels();
+    for (int i = 0; i < rangesCount; i++) {
+        int first = ranges.getInt16();
+        int count = ranges.getInt16();
+        if (first < 0 || count < 0 || first + count > CHUNK_H) {
+            throw std::runtime_error("invalid chunk delta layers range");
+        }
+        size_t begin = first * LAYER_VOL;
+        size_t end = (first + count) * LAYER_VOL;
+        for (size_t index = begin; index < end; index++) {
+            blockid_t id = static_cast<uint16_t>(ranges.getInt16());
+            check_block_id(chunk, id, index, indices);
+            voxels[index].id = id;
+        }
+        for (size_t index = begin; index < end; index++) {
+            voxels[index].state =
+                int2blockstate(static_cast<uint16_t>(ranges.getInt16()));
+        }
+        for (int y = first; y < first + count; y++) {
+            chunk.setModifiedAndUnsaved(y);
+        }
+    }
+    chunk.updateHeights();
 }
 
-static void read_voxel_data(ByteReader& reader, util::Buffer<ubyte>& dst) {
+/// @param dst buffer of CHUNK_DATA_LEN bytes
+static void read_voxel_data(ByteReader& reader, ubyte* dst) {
     size_t gzipCompressedSize = reader.getInt32();
         
     auto rleData = gzip::decompress(reader.pointer(), gzipCompressedSize);
     reader.skip(gzipCompressedSize);
 
-    extrle::decode16(rleData.data(), rleData.size(), dst.data(), dst.size());
+    extrle::decode16(rleData.data(), rleData.size(), dst, CHUNK_DATA_LEN);
 }
 
 void compressed_chunks::decode(
@@ -57,29 +185,35 @@ void compressed_chunks::decode(
     ubyte flags = reader.get();
     reader.skip(1); // reserved byte
 
+    if (flags & IS_DELTA) {
+        reader.skip(8); // base revision and revision
+        if (flags & HAS_VOXELS) {
+            decode_delta_voxels(chunk, reader, indices);
+        }
+        if (flags & HAS_METADATA) {
+            size_t metadataSize = reader.getInt32();
+            chunk.blocksMetadata.deserialize(reader.pointer(), metadataSize);
+            reader.skip(metadataSize);
+            chunk.setBlocksDataModified();
+        }
+        return;
+    }
     if (flags & HAS_VOXELS) {
-        /// world.get_chunk_data is only available in the main Lua state
-        static util::Buffer<ubyte> voxelData (CHUNK_DATA_LEN);
-        read_voxel_data(reader, voxelData);
+        auto voxelData = voxel_buffers.get();
+        read_voxel_data(reader, voxelData.get());
         // TODO: move somewhere in Chunk
-        auto src = reinterpret_cast<const uint16_t*>(voxelData.data());
+        auto src = reinterpret_cast<const uint16_t*>(voxelData.get());
         for (size_t i = 0; i < CHUNK_VOL; i++) {
-            blockid_t id = dataio::le2h(src[i]);;
-            if (indices.blocks.get(id) == nullptr) {
-                throw std::runtime_error(
-                    "block data corruption (chunk: " + std::to_string(chunk.x) +
-                    ", " + std::to_string(chunk.z) + ") at " +
-                    std::to_string(i) + " id: " + std::to_string(id)
-                );
-            }
+            check_block_id(chunk, dataio::le2h(src[i]), i, indices);
         }
-        chunk.decode(voxelData.data());
+        chunk.decode(voxelData.get());
         chunk.updateHeights();
     }
     if (flags & HAS_METADATA) {
         size_t metadataSize = reader.getInt32();
         chunk.blocksMetadata.deserialize(reader.pointer(), metadataSize);
         reader.skip(metadataSize);
+        chunk.setBlocksDataModified();
     }
     chunk.setModifiedAndUnsaved();
 }
@@ -91,9 +225,12 @@ void compressed_chunks::save(
 
     ubyte flags = reader.get();
     reader.skip(1); // reserved byte
+    if (flags & IS_DELTA) {
+        throw std::runtime_error("chunk delta can not be saved to regions");
+    }
     if (flags & HAS_VOXELS) {
         util::Buffer<ubyte> voxelData (CHUNK_DATA_LEN);
-        read_voxel_data(reader, voxelData);
+        read_voxel_data(reader, voxelData.data());
         regions.put(
             x, z, REGION_LAYER_VOXELS, voxelData.release(), CHUNK_DATA_LEN
         );
@@ -9,13 +9,31 @@
 class ContentIndices;
 class WorldRegions;
 
+/// @brief Chunks transfer encoding. All functions are thread-safe:
+/// scratch buffers are taken from shared pools
 namespace compressed_chunks {
+    /// @param rleBuffer scratch buffer of CHUNK_DATA_LEN * 2 bytes
+    /// owned by the caller
     std::vector<ubyte> encode(
         const ubyte* voxelData,
         const BlocksMetadata& metadata,
         util::Buffer<ubyte>& rleBuffer
     );
+    /// @param voxelData CHUNK_DATA_LEN bytes produced by Chunk::encode()
+    std::vector<ubyte> encode(
+        const ubyte* voxelData, const BlocksMetadata& metadata
+    );
     std::vector<ubyte> encode(const Chunk& chunk);
+
+    /// @brief Encode voxel layers and blocks metadata changed after the base
+    /// revision (see Chunk::revision). Result is accepted by decode(...)
+    /// @param baseRevision chunk revision held by the receiver
+    std::vector<ubyte> encode_delta(const Chunk& chunk, uint32_t baseRevision);
+
+    /// @return true if data is produced by encode_delta(...)
+    bool is_delta(const ubyte* src, size_t size);
+
+    /// @brief Apply full chunk data or delta
     void decode(
         Chunk& chunk,
         const ubyte* src,
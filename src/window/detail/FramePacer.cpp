@@ -0,0 +1,65 @@
+#include "FramePacer.hpp"
+
+#include <GL/glew.h>
+#include <algorithm>
+
+/// @brief Smoothing of work time decrease. Increase is applied at once,
+/// so a slower frame does not miss the present
+inline constexpr double DECAY_FACTOR = 0.05;
+
+static void add_sample(double& average, double sample) {
+    if (sample > average) {
+        average = sample;
+    } else {
+        average += (sample - average) * DECAY_FACTOR;
+    }
+}
+
+FramePacer::FramePacer() {
+    timerQueries = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    if (timerQueries) {
+        glGenQueries(QUERIES_COUNT, queries);
+    }
+}
+
+FramePacer::~FramePacer() {
+    if (timerQueries) {
+        glDeleteQueries(QUERIES_COUNT, queries);
+    }
+}
+
+void FramePacer::beginFrame(double time) {
+    frameStart = time;
+    if (timerQueries) {
+        glBeginQuery(GL_TIME_ELAPSED, queries[queryIndex]);
+        issued[queryIndex] = true;
+        queryActive = true;
+    }
+}
+
+void FramePacer::endFrame(double time) {
+    add_sample(cpuTime, time - frameStart);
+    if (!queryActive) {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    queryActive = false;
+
+    // the oldest query is reused by the next frame
+    queryIndex = (queryIndex + 1) % QUERIES_COUNT;
+    GLuint query = queries[queryIndex];
+    if (!issued[queryIndex]) {
+        return;
+    }
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+        GLuint64 nanos = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanos);
+        add_sample(gpuTime, nanos * 1e-9);
+    }
+}
+
+double FramePacer::getPredictedWorkTime() const {
+    return std::max(cpuTime, gpuTime);
+}
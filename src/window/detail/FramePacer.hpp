@@ -0,0 +1,35 @@
+#pragma once
+
+/// @brief Measures frames CPU and GPU work time (GL timer queries) to
+/// predict duration of the next frame, so it may be started as late as
+/// possible before present
+class FramePacer {
+    static constexpr int QUERIES_COUNT = 3;
+
+    /// @brief Ring of GL_TIME_ELAPSED queries. Results are read a few
+    /// frames later to not stall the pipeline
+    unsigned int queries[QUERIES_COUNT] {};
+    bool issued[QUERIES_COUNT] {};
+    int queryIndex = 0;
+    bool queryActive = false;
+    bool timerQueries = false;
+
+    double frameStart = 0.0;
+    double cpuTime = 0.0;
+    double gpuTime = 0.0;
+public:
+    /// @brief Must be created with current GL context
+    FramePacer();
+    ~FramePacer();
+
+    /// @brief Start measuring the frame work
+    /// @param time current time (seconds)
+    void beginFrame(double time);
+
+    /// @brief Finish measuring the frame work. Called before present
+    /// @param time current time (seconds)
+    void endFrame(double time);
+
+    /// @return predicted duration of the next frame work (seconds)
+    double getPredictedWorkTime() const;
+};
@@ -1,4 +1,5 @@
 #include "window/Window.hpp"
+#include "FramePacer.hpp"
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -337,6 +338,9 @@ private:
 };
 static_assert(!std::is_abstract<GLFWInput>());
 
+/// @brief Reserve for frame work time prediction error in low latency mode
+inline constexpr double LOW_LATENCY_MARGIN = 0.002;
+
 class GLFWWindow : public Window {
 public:
     GLFWInput& input;
@@ -352,10 +356,13 @@ public:
         : Window({width, height}),
           input(glfwInput),
           settings(settings),
-          window(window) {
+          window(window),
+          pacer(std::make_unique<FramePacer>()) {
+        pacer->beginFrame(time());
     }
 
     ~GLFWWindow() {
+        pacer.reset();
         for (int i = 0; i <= static_cast<int>(CursorShape::LAST); i++) {
             glfwDestroyCursor(standard_cursors[i]);
         }
@@ -367,18 +374,33 @@ public:
     }
 
     void swapBuffers() override {
+        bool lowLatency = settings->lowLatency.get();
+        pacer->endFrame(time());
         glfwSwapBuffers(window);
         resetScissor();
+        if (lowLatency) {
+            // wait for the present, so driver does not queue frames
+            // and the wait below starts at the vertical blank
+            glFinish();
+        }
         if (framerate > 0) {
             auto elapsedTime = time() - prevSwap;
             auto frameTime = 1.0 / framerate;
             if (elapsedTime < frameTime) {
-                platform::sleep(
-                    static_cast<size_t>((frameTime - elapsedTime) * 1000)
-                );
+                platform::sleep_precise(frameTime - elapsedTime);
+            }
+        } else if (framerate == -1 && lowLatency) {
+            // input polling and simulation are moved as close to the
+            // next present as predicted frame work time allows
+            double delay = getRefreshInterval() -
+                           pacer->getPredictedWorkTime() -
+                           LOW_LATENCY_MARGIN;
+            if (delay > 0.0) {
+                platform::sleep_precise(delay);
             }
         }
         prevSwap = time();
+        pacer->beginFrame(prevSwap);
     }
 
     void setShouldRefresh() override {
@@ -579,9 +601,23 @@ private:
     std::stack<glm::vec4> scissorStack;
     glm::vec4 scissorArea {};
     double prevSwap = 0.0;
+    std::unique_ptr<FramePacer> pacer;
     int posX = 0;
     int posY = 0;
     bool shouldRefresh = true;
+
+    double getRefreshInterval() const {
+        GLFWmonitor* monitor = glfwGetWindowMonitor(window);
+        if (monitor == nullptr) {
+            monitor = glfwGetPrimaryMonitor();
+        }
+        const GLFWvidmode* mode =
+            monitor ? glfwGetVideoMode(monitor) : nullptr;
+        if (mode == nullptr || mode->refreshRate <= 0) {
+            return 1.0 / 60.0;
+        }
+        return 1.0 / mode->refreshRate;
+    }
 };
 static_assert(!std::is_abstract<GLFWWindow>());
 
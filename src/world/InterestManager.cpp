@@ -0,0 +1,126 @@
+#include "InterestManager.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include "constants.hpp"
+
+void InterestManager::setRadius(int64_t observer, float radius) {
+    if (radius <= 0.0f) {
+        observers.erase(observer);
+        return;
+    }
+    observers[observer].radius = radius;
+}
+
+float InterestManager::getRadius(int64_t observer) const {
+    const auto& found = observers.find(observer);
+    if (found == observers.end()) {
+        return 0.0f;
+    }
+    return found->second.radius;
+}
+
+void InterestManager::update(
+    const std::vector<InterestObserver>& present, const EntitiesQuery& query
+) {
+    for (auto& [_, state] : observers) {
+        state.present = false;
+    }
+    for (const auto& observer : present) {
+        const auto& found = observers.find(observer.id);
+        if (found == observers.end()) {
+            continue;
+        }
+        found->second.present = true;
+        found->second.position = observer.position;
+    }
+    for (auto& [_, ids] : entityObservers) {
+        ids.clear();
+    }
+    for (auto& [id, state] : observers) {
+        buffer.clear();
+        if (state.present) {
+            query(state.position, state.radius, buffer);
+            std::sort(buffer.begin(), buffer.end());
+            buffer.erase(
+                std::unique(buffer.begin(), buffer.end()), buffer.end()
+            );
+        }
+        state.entered.clear();
+        state.left.clear();
+        std::set_difference(
+            buffer.begin(),
+            buffer.end(),
+            state.visible.begin(),
+            state.visible.end(),
+            std::back_inserter(state.entered)
+        );
+        std::set_difference(
+            state.visible.begin(),
+            state.visible.end(),
+            buffer.begin(),
+            buffer.end(),
+            std::back_inserter(state.left)
+        );
+        state.visible.swap(buffer);
+        for (entityid_t entity : state.visible) {
+            entityObservers[entity].push_back(id);
+        }
+    }
+    for (auto it = entityObservers.begin(); it != entityObservers.end();) {
+        if (it->second.empty()) {
+            it = entityObservers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+const std::vector<entityid_t>& InterestManager::getVisible(
+    int64_t observer
+) const {
+    const auto& found = observers.find(observer);
+    return found == observers.end() ? EMPTY_ENTITIES : found->second.visible;
+}
+
+const std::vector<entityid_t>& InterestManager::getEntered(
+    int64_t observer
+) const {
+    const auto& found = observers.find(observer);
+    return found == observers.end() ? EMPTY_ENTITIES : found->second.entered;
+}
+
+const std::vector<entityid_t>& InterestManager::getLeft(
+    int64_t observer
+) const {
+    const auto& found = observers.find(observer);
+    return found == observers.end() ? EMPTY_ENTITIES : found->second.left;
+}
+
+const std::vector<int64_t>& InterestManager::getObservers(
+    entityid_t entity
+) const {
+    const auto& found = entityObservers.find(entity);
+    return found == entityObservers.end() ? EMPTY_OBSERVERS : found->second;
+}
+
+std::vector<int64_t> InterestManager::getChunkObservers(
+    int chunkX, int chunkZ
+) const {
+    std::vector<int64_t> result;
+    glm::vec2 min(chunkX * CHUNK_W, chunkZ * CHUNK_D);
+    glm::vec2 max = min + glm::vec2(CHUNK_W, CHUNK_D);
+    for (const auto& [id, state] : observers) {
+        if (!state.present) {
+            continue;
+        }
+        glm::vec2 pos(state.position.x, state.position.z);
+        glm::vec2 nearest = glm::clamp(pos, min, max);
+        glm::vec2 delta = pos - nearest;
+        if (glm::dot(delta, delta) <= state.radius * state.radius) {
+            result.push_back(id);
+        }
+    }
+    return result;
+}
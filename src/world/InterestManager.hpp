@@ -0,0 +1,75 @@
+#pragma once
+
+#include <functional>
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+#include "typedefs.hpp"
+
+/// @brief Observer position for the interest update
+struct InterestObserver {
+    int64_t id;
+    glm::vec3 position;
+};
+
+/// @brief Tracks entities and chunks observed by players, so replication
+/// scripts may send updates to interested players only. Observers are
+/// tracked after the interest radius is set
+class InterestManager {
+public:
+    /// @brief Collect uids of entities within the sphere
+    using EntitiesQuery = std::function<void(
+        const glm::vec3& center, float radius, std::vector<entityid_t>& dst
+    )>;
+private:
+    struct ObserverState {
+        float radius;
+        glm::vec3 position {};
+        bool present = false;
+        /// @brief Sorted uids of observed entities
+        std::vector<entityid_t> visible;
+        std::vector<entityid_t> entered;
+        std::vector<entityid_t> left;
+    };
+    std::unordered_map<int64_t, ObserverState> observers;
+    std::unordered_map<entityid_t, std::vector<int64_t>> entityObservers;
+    std::vector<entityid_t> buffer;
+
+    static inline const std::vector<entityid_t> EMPTY_ENTITIES {};
+    static inline const std::vector<int64_t> EMPTY_OBSERVERS {};
+public:
+    /// @param radius interest radius (observer is removed if <= 0)
+    void setRadius(int64_t observer, float radius);
+
+    /// @return interest radius or 0 if the observer is not tracked
+    float getRadius(int64_t observer) const;
+
+    bool empty() const {
+        return observers.empty();
+    }
+
+    /// @brief Update observed entities and enter/leave deltas of tracked
+    /// observers. Observers missing in the list leave all entities
+    void update(
+        const std::vector<InterestObserver>& present,
+        const EntitiesQuery& query
+    );
+
+    /// @return sorted uids of entities observed after the last update
+    const std::vector<entityid_t>& getVisible(int64_t observer) const;
+
+    /// @return uids of entities entered the observer interest area
+    /// during the last update
+    const std::vector<entityid_t>& getEntered(int64_t observer) const;
+
+    /// @return uids of entities left the observer interest area during
+    /// the last update
+    const std::vector<entityid_t>& getLeft(int64_t observer) const;
+
+    /// @return ids of observers of the entity
+    const std::vector<int64_t>& getObservers(entityid_t entity) const;
+
+    /// @return ids of observers which interest area intersects the chunk
+    std::vector<int64_t> getChunkObservers(int chunkX, int chunkZ) const;
+};
@@ -15,7 +15,9 @@
 #include "voxels/GlobalChunks.hpp"
 #include "voxels/Pathfinding.hpp"
 #include "window/Camera.hpp"
+#include "InterestManager.hpp"
 #include "LevelEvents.hpp"
+#include "SimulationArea.hpp"
 #include "World.hpp"
 
 Level::Level(
@@ -30,7 +32,9 @@ Level::Level(
       events(std::make_unique<LevelEvents>()),
       entities(std::make_unique<Entities>(*this)),
       players(std::make_unique<Players>(*this)),
-      pathfinding(std::make_unique<voxels::Pathfinding>(*this)) {
+      pathfinding(std::make_unique<voxels::Pathfinding>(*this)),
+      simulation(std::make_unique<SimulationArea>()),
+      interests(std::make_unique<InterestManager>()) {
     const auto& worldInfo = world->getInfo();
     auto& cameraIndices = content.getIndices(ResourceType::CAMERA);
     for (size_t i = 0; i < cameraIndices.size(); i++) {
@@ -64,6 +68,7 @@ Level::Level(
         events->trigger(LevelEventType::CHUNK_UNLOAD, &chunk);
         AABB aabb = chunk.getAABB();
         entities->despawn(entities->getAllInside(aabb));
+        entities->dropPending(chunk.x, chunk.z);
     });
     inventories = std::make_unique<Inventories>(*this);
 }
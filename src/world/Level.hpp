@@ -14,8 +14,10 @@ class Inventories;
 class LevelEvents;
 class PhysicsSolver;
 class GlobalChunks;
+class InterestManager;
 class Camera;
 class Players;
+class SimulationArea;
 struct EngineSettings;
 
 namespace voxels {
@@ -35,6 +37,11 @@ public:
     std::unique_ptr<Entities> entities;
     std::unique_ptr<Players> players;
     std::unique_ptr<voxels::Pathfinding> pathfinding;
+    /// @brief Simulation tiers of chunks (updated by LevelController)
+    std::unique_ptr<SimulationArea> simulation;
+    /// @brief Entities and chunks observed by players (updated by
+    /// LevelController)
+    std::unique_ptr<InterestManager> interests;
     std::vector<std::shared_ptr<Camera>> cameras;  // move somewhere?
 
     Level(
@@ -0,0 +1,87 @@
+#include "SimulationArea.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include "constants.hpp"
+#include "maths/voxmaths.hpp"
+#include "objects/Player.hpp"
+#include "objects/Players.hpp"
+
+void SimulationSettings::validate() {
+    fullDistance = std::max(0, fullDistance);
+    reducedDistance = std::max(fullDistance, reducedDistance);
+    reducedRate = std::max(1, reducedRate);
+}
+
+dv::value SimulationSettings::serialize() const {
+    return dv::object({
+        {"full-distance", fullDistance},
+        {"reduced-distance", reducedDistance},
+        {"reduced-rate", reducedRate},
+    });
+}
+
+void SimulationSettings::deserialize(const dv::value& src) {
+    src.at("full-distance").get(fullDistance);
+    src.at("reduced-distance").get(reducedDistance);
+    src.at("reduced-rate").get(reducedRate);
+    validate();
+}
+
+void SimulationArea::update(
+    const Players& players, const SimulationSettings& settings
+) {
+    this->settings = settings;
+    centers.clear();
+    for (const auto& [_, player] : players) {
+        if (player->isSuspended()) {
+            continue;
+        }
+        const auto& position = player->getPosition();
+        centers.emplace_back(
+            floordiv<CHUNK_W>(static_cast<int>(std::floor(position.x))),
+            floordiv<CHUNK_D>(static_cast<int>(std::floor(position.z)))
+        );
+    }
+}
+
+int SimulationArea::getDistance(int chunkX, int chunkZ) const {
+    int distance = INT_MAX;
+    for (const auto& center : centers) {
+        distance = std::min(
+            distance,
+            std::max(std::abs(chunkX - center.x), std::abs(chunkZ - center.y))
+        );
+    }
+    return distance;
+}
+
+SimulationTier SimulationArea::getTier(int chunkX, int chunkZ) const {
+    int distance = getDistance(chunkX, chunkZ);
+    if (distance <= settings.fullDistance) {
+        return SimulationTier::FULL;
+    } else if (distance <= settings.reducedDistance) {
+        return SimulationTier::REDUCED;
+    }
+    return SimulationTier::FROZEN;
+}
+
+SimulationTier SimulationArea::getTier(const glm::vec3& position) const {
+    return getTier(
+        floordiv<CHUNK_W>(static_cast<int>(std::floor(position.x))),
+        floordiv<CHUNK_D>(static_cast<int>(std::floor(position.z)))
+    );
+}
+
+int SimulationArea::getRateDivider(SimulationTier tier) const {
+    switch (tier) {
+        case SimulationTier::FULL:
+            return 1;
+        case SimulationTier::REDUCED:
+            return settings.reducedRate;
+        default:
+            return 0;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "data/dv.hpp"
+
+class Players;
+
+enum class SimulationTier {
+    /// @brief Simulated every tick
+    FULL,
+    /// @brief Simulated with reduced tick rate
+    REDUCED,
+    /// @brief Loaded and visible, but not simulated
+    FROZEN
+};
+
+/// @brief Simulation tiers distances (in chunks to the nearest player).
+/// Configured per world
+struct SimulationSettings {
+    int fullDistance = 8;
+    int reducedDistance = 16;
+    /// @brief Reduced tier tick rate divider
+    int reducedRate = 4;
+
+    /// @brief Clamp values to valid ranges
+    void validate();
+
+    dv::value serialize() const;
+    void deserialize(const dv::value& src);
+};
+
+/// @brief Defines simulation tier of chunks by distance to players
+class SimulationArea {
+    SimulationSettings settings;
+    /// @brief Chunk positions of not suspended players
+    std::vector<glm::ivec2> centers;
+public:
+    /// @brief Update players positions and settings (called every frame)
+    void update(const Players& players, const SimulationSettings& settings);
+
+    /// @return Chebyshev distance in chunks to the nearest player
+    int getDistance(int chunkX, int chunkZ) const;
+
+    SimulationTier getTier(int chunkX, int chunkZ) const;
+
+    SimulationTier getTier(const glm::vec3& position) const;
+
+    /// @return tick rate divider of the tier (0 if not simulated)
+    int getRateDivider(SimulationTier tier) const;
+
+    /// @brief Check if the tier is simulated at the tick
+    /// @param tick tick counter
+    /// @param seed value used to spread reduced tier ticks
+    bool isTicked(SimulationTier tier, uint64_t tick, uint64_t seed) const {
+        int divider = getRateDivider(tier);
+        return divider != 0 && (tick + seed) % divider == 0;
+    }
+
+    const SimulationSettings& getSettings() const {
+        return settings;
+    }
+};
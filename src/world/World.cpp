@@ -5,6 +5,7 @@
 #include <memory>
 #include <utility>
 
+#include "constants.hpp"
 #include "content/Content.hpp"
 #include "content/ContentReport.hpp"
 #include "debug/Logger.hpp"
@@ -42,9 +43,21 @@ World::~World() {
 }
 
 void World::updateTimers(float delta) {
-    info.daytime += delta * info.daytimeSpeed * DAYIME_SPECIFIC_SPEED;
-    info.daytime = std::fmod(info.daytime, 1.0f);
     info.totalTime += delta;
+    environmentTimer += delta;
+    if (environmentTimer < ENVIRONMENT_TICK_INTERVAL) {
+        return;
+    }
+    info.daytime +=
+        environmentTimer * info.daytimeSpeed * DAYIME_SPECIFIC_SPEED;
+    info.daytime = std::fmod(info.daytime, 1.0f);
+    environmentTimer = 0.0f;
+}
+
+float World::getRenderDaytime() const {
+    float daytime = info.daytime +
+                    environmentTimer * info.daytimeSpeed * DAYIME_SPECIFIC_SPEED;
+    return std::fmod(daytime, 1.0f);
 }
 
 void World::writeResources(const Content& content) {
@@ -65,17 +78,44 @@ void World::writeResources(const Content& content) {
     io::write_json(wfile->getResourcesFile(), root);
 }
 
-void World::write(Level* level) {
-    level->chunks->saveAll();
+void World::write(Level* level, bool background) {
     info.nextEntityId = level->entities->peekNextID();
-    wfile->write(this, &content);
-
-    auto playerFile = level->players->serialize();
-    io::write_json(wfile->getPlayerFile(), playerFile);
+    if (background) {
+        auto snapshot = wfile->getRegions().createSnapshot();
+        level->chunks->captureAll(snapshot);
+        wfile->writeAsync(this, &content, std::move(snapshot));
+    } else {
+        level->chunks->saveAll();
+        wfile->write(this, &content);
+    }
 
+    writePlayers(*level->players);
     writeResources(content);
 }
 
+void World::writePlayers(Players& players) {
+    io::create_directories(wfile->getPlayersFolder());
+    for (int64_t id : players.takeRemoved()) {
+        io::remove(wfile->getPlayerFile(id));
+    }
+    size_t written = 0;
+    for (const auto& [id, player] : players) {
+        if (!player->isDirty()) {
+            continue;
+        }
+        io::write_binary_json(wfile->getPlayerFile(id), player->serialize());
+        player->resetDirty();
+        written++;
+    }
+    // all players are written after the legacy file has been loaded
+    io::path legacyFile = wfile->getPlayerFile();
+    if (io::is_regular_file(legacyFile)) {
+        io::remove(legacyFile);
+    }
+    logger.info() << "written " << written << " of " << players.size()
+                  << " players";
+}
+
 std::unique_ptr<Level> World::create(
     const std::string& name,
     const std::string& generator,
@@ -132,8 +172,21 @@ std::unique_ptr<Level> World::load(
 
     auto level = std::make_unique<Level>(std::move(world), content, settings);
 
+    io::path folder = wfile->getPlayersFolder();
     io::path file = wfile->getPlayerFile();
-    if (!io::is_regular_file(file)) {
+    if (io::is_directory(folder) && !io::is_regular_file(file)) {
+        auto playerRoot = dv::object();
+        auto& list = playerRoot.list("players");
+        for (const auto& entry : io::directory_iterator(folder)) {
+            if (entry.extension() == ".bjson") {
+                list.add(io::read_binary_json(entry));
+            }
+        }
+        level->players->deserialize(playerRoot);
+        for (const auto& [_, player] : *level->players) {
+            player->resetDirty();
+        }
+    } else if (!io::is_regular_file(file)) {
         logger.warning() << "player.json does not exists";
         level->players->create();
     } else {
@@ -209,6 +262,7 @@ void WorldInfo::deserialize(const dv::value& root) {
         daytime = timeobj["day-time"].asNumber();
         daytimeSpeed = timeobj["day-time-speed"].asNumber();
         totalTime = timeobj["total-time"].asNumber();
+        ticks = timeobj["ticks"].asInteger(0);
     }
     if (root.has("weather")) {
         fog = root["weather"]["fog"].asNumber();
@@ -216,6 +270,9 @@ void WorldInfo::deserialize(const dv::value& root) {
     nextInventoryId = root["next-inventory-id"].asInteger(2);
     nextEntityId = root["next-entity-id"].asInteger(1);
     root.at("next-player-id").get(nextPlayerId);
+    if (root.has("simulation")) {
+        simulation.deserialize(root["simulation"]);
+    }
 }
 
 dv::value WorldInfo::serialize() const {
@@ -233,6 +290,7 @@ dv::value WorldInfo::serialize() const {
     timeobj["day-time"] = daytime;
     timeobj["day-time-speed"] = daytimeSpeed;
     timeobj["total-time"] = totalTime;
+    timeobj["ticks"] = ticks;
 
     root["weather"] = dv::object();
     root["weather"]["fog"] = fog;
@@ -240,5 +298,6 @@ dv::value WorldInfo::serialize() const {
     root["next-inventory-id"] = nextInventoryId;
     root["next-entity-id"] = nextEntityId;
     root["next-player-id"] = nextPlayerId;
+    root["simulation"] = simulation.serialize();
     return root;
 }
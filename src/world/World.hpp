@@ -9,10 +9,12 @@
 #include "io/fwd.hpp"
 #include "typedefs.hpp"
 #include "util/timeutil.hpp"
+#include "SimulationArea.hpp"
 
 class Content;
 class WorldFiles;
 class Level;
+class Players;
 class ContentReport;
 struct EngineSettings;
 
@@ -38,11 +40,16 @@ struct WorldInfo : public Serializable {
     /// @brief total time passed in the world (not depending on daytimeSpeed)
     double totalTime = 0.0;
 
+    /// @brief Number of world ticks passed (scheduled blocks updates time)
+    uint64_t ticks = 0;
+
     /// @brief will be replaced with weather in future
     float fog = 0.0f;
 
     entityid_t nextEntityId = 0;
 
+    SimulationSettings simulation {};
+
     int major = 0, minor = -1;
 
     bool isLoaded = false;
@@ -54,11 +61,15 @@ struct WorldInfo : public Serializable {
 /// @brief holds all world data except the level (chunks and objects)
 class World {
     WorldInfo info {};
+    /// @brief Time passed since the last environment tick
+    float environmentTimer = 0.0f;
 
     const Content& content;
     std::vector<ContentPack> packs;
 
     void writeResources(const Content& content);
+    /// @brief Write modified players to separate files
+    void writePlayers(Players& players);
 public:
     std::shared_ptr<WorldFiles> wfile;
 
@@ -71,12 +82,19 @@ public:
 
     ~World();
 
-    /// @brief Update world day-time and total time
+    /// @brief Update world total time. Day-time is updated with
+    /// ENVIRONMENT_TICK_INTERVAL rate
     /// @param delta delta-time
     void updateTimers(float delta);
 
+    /// @brief Get day-time including the time passed since the last
+    /// environment tick (used for rendering)
+    float getRenderDaytime() const;
+
     /// @brief Write all unsaved level data to the world directory
-    void write(Level* level);
+    /// @param background write regions in background: chunks data is
+    /// captured uncompressed and compressed by the saving thread
+    void write(Level* level, bool background = false);
 
     /// @brief Check world indices and generate ContentReport if convert required
     /// @param directory world directory
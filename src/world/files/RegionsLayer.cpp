@@ -1,40 +1,183 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <zlib.h>
 
 #include "WorldRegions.hpp"
 #include "debug/Logger.hpp"
+#include "io/devices/Device.hpp"
 #include "util/data_io.hpp"
+#include "util/platform.hpp"
 
 static debug::Logger logger("regions-layer");
 
 #define REGION_FORMAT_MAGIC ".VOXREG"
+/// @brief Offsets table footer end (since version 5)
+#define REGION_TABLE_MAGIC "VTBL"
+
+static std::atomic<uint64_t> read_chunks = 0;
+static std::atomic<uint64_t> read_bytes = 0;
+static std::atomic<uint64_t> written_chunks = 0;
+static std::atomic<uint64_t> written_bytes = 0;
+
+static void count_read(uint32_t size) {
+    read_chunks.fetch_add(1, std::memory_order_relaxed);
+    read_bytes.fetch_add(8 + size, std::memory_order_relaxed);
+}
+
+static void count_write(uint32_t size) {
+    written_chunks.fetch_add(1, std::memory_order_relaxed);
+    written_bytes.fetch_add(8 + size, std::memory_order_relaxed);
+}
+
+RegionsIOStats WorldRegions::getIOStats() {
+    return {
+        read_chunks.load(std::memory_order_relaxed),
+        read_bytes.load(std::memory_order_relaxed),
+        written_chunks.load(std::memory_order_relaxed),
+        written_bytes.load(std::memory_order_relaxed),
+    };
+}
+
+/// @return offsets table size including the footer
+static size_t get_table_size(int version) {
+    size_t size = REGION_CHUNKS_COUNT * 4;
+    if (version == 4) {
+        size += 4;
+    } else if (version > 4) {
+        size += REGION_FOOTER_SIZE;
+    }
+    return size;
+}
+
+/// @brief Write offsets table with the current version footer
+static void write_table(
+    std::ostream& file,
+    const std::array<uint32_t, REGION_CHUNKS_COUNT>& offsets,
+    uint32_t usedBytes
+) {
+    std::array<ubyte, REGION_CHUNKS_COUNT * 4 + REGION_FOOTER_SIZE> table;
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        uint32_t intbuf = dataio::h2le(offsets[i]);
+        std::memcpy(table.data() + i * 4, &intbuf, 4);
+    }
+    size_t checked = REGION_CHUNKS_COUNT * 4 + 4;
+    uint32_t intbuf = dataio::h2le(usedBytes);
+    std::memcpy(table.data() + checked - 4, &intbuf, 4);
+    intbuf = dataio::h2le(
+        static_cast<uint32_t>(crc32(0, table.data(), checked))
+    );
+    std::memcpy(table.data() + checked, &intbuf, 4);
+    std::memcpy(table.data() + checked + 4, REGION_TABLE_MAGIC, 4);
+    file.write(reinterpret_cast<const char*>(table.data()), table.size());
+}
+
+/// @brief Check the offsets table magic number and checksum (version 5+)
+/// @param table offsets table including the footer
+static bool is_table_valid(const ubyte* table) {
+    size_t checked = REGION_CHUNKS_COUNT * 4 + 4;
+    if (std::memcmp(table + checked + 4, REGION_TABLE_MAGIC, 4) != 0) {
+        return false;
+    }
+    uint32_t checksum;
+    std::memcpy(&checksum, table + checked, 4);
+    return dataio::le2h(checksum) == crc32(0, table, checked);
+}
 
 static io::path get_region_filename(int x, int z) {
     return std::to_string(x) + "_" + std::to_string(z) + ".bin";
 }
 
-/// @brief Read missing chunks data (null pointers) from region file
-static void fetch_chunks(WorldRegion* region, int x, int z, regfile* file) {
+/// @brief Read missing chunks data (null pointers) from region file.
+/// Dirty null chunks are removed ones, so they're not read
+static void fetch_chunks(
+    RegionsLayer& layer, WorldRegion* region, int x, int z, regfile* file
+) {
     auto* chunks = region->getChunks();
-    auto sizes = region->getSizes();
 
     for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
         int chunk_x = (i % REGION_SIZE) + x * REGION_SIZE;
         int chunk_z = (i / REGION_SIZE) + z * REGION_SIZE;
-        if (chunks[i] == nullptr) {
-            chunks[i] = RegionsLayer::readChunkData(
-                chunk_x, chunk_z, sizes[i][0], sizes[i][1], file
-            );
+        if (chunks[i] == nullptr && !region->isChunkDirty(i)) {
+            uint32_t size;
+            uint32_t srcSize;
+            auto data =
+                layer.readChunkData(chunk_x, chunk_z, size, srcSize, file);
+            if (data) {
+                region->put(
+                    i % REGION_SIZE, i / REGION_SIZE, std::move(data), size, srcSize
+                );
+            }
+        }
+    }
+}
+
+/// @param data source data (may be a mapped region file view)
+/// @param owned data as unique_ptr if already copied
+static std::unique_ptr<ubyte[]> recompress(
+    const ubyte* data,
+    std::unique_ptr<ubyte[]> owned,
+    uint32_t& size,
+    uint32_t srcSize,
+    compression::Method srcMethod,
+    compression::Method dstMethod
+) {
+    if (srcMethod == dstMethod) {
+        if (owned) {
+            return owned;
+        }
+        auto copy = std::make_unique<ubyte[]>(size);
+        std::memcpy(copy.get(), data, size);
+        return copy;
+    }
+    if (srcMethod != compression::Method::NONE) {
+        owned = compression::decompress(data, size, srcSize, srcMethod);
+        data = owned.get();
+        size = srcSize;
+    }
+    if (dstMethod != compression::Method::NONE) {
+        size_t length;
+        owned = compression::compress(data, srcSize, length, dstMethod);
+        size = length;
+    } else if (owned == nullptr) {
+        owned = std::make_unique<ubyte[]>(size);
+        std::memcpy(owned.get(), data, size);
+    }
+    return owned;
+}
+
+static std::unique_ptr<io::mapped_file> map_region_file(
+    const io::path& filename
+) {
+    try {
+        auto& device = io::require_device(filename.entryPoint());
+        auto mapping = device.map(filename.pathPart());
+        if (mapping == nullptr || mapping->data() == nullptr) {
+            return nullptr;
         }
+        return mapping;
+    } catch (const std::runtime_error& err) {
+        logger.warning() << err.what();
+        return nullptr;
     }
 }
 
-regfile::regfile(io::path filename) : file(filename), filename(filename) {
-    if (file.length() < REGION_HEADER_SIZE)
+regfile::regfile(io::path filename, bool mapped) : filename(filename) {
+    if (mapped) {
+        mapping = map_region_file(filename);
+    }
+    if (mapping == nullptr) {
+        file = std::make_unique<io::rafile>(filename);
+    }
+    if (length() < REGION_HEADER_SIZE)
         throw std::runtime_error(
             "incomplete region file header in " + filename.string()
         );
     char header[REGION_HEADER_SIZE];
-    file.read(header, REGION_HEADER_SIZE);
+    readAt(0, header, REGION_HEADER_SIZE);
 
     // avoid of use strcmp_s
     if (std::string(header, std::strlen(REGION_FORMAT_MAGIC)) !=
@@ -50,110 +193,264 @@ regfile::regfile(io::path filename) : file(filename), filename(filename) {
             " is not supported in " + filename.string()
         );
     }
+    auto method = static_cast<ubyte>(header[9]);
+    if (method > static_cast<ubyte>(compression::Method::LZ4)) {
+        throw illegal_region_format(
+            "unknown compression method " + std::to_string(method) + " in " +
+            filename.string()
+        );
+    }
+    compression = static_cast<compression::Method>(method);
 
-    size_t file_size = file.length();
-    size_t table_offset = file_size - REGION_CHUNKS_COUNT * 4;
+    size_t tail = get_table_size(version);
+    size_t file_size = length();
+    if (file_size < REGION_HEADER_SIZE + tail) {
+        throw std::runtime_error(
+            "incomplete region file " + filename.string()
+        );
+    }
+    tableOffset = file_size - tail;
 
-    file.seekg(table_offset);
-    file.read(
-        reinterpret_cast<char*>(offsets.data()),
-        sizeof(uint32_t) * REGION_CHUNKS_COUNT
-    );
+    std::vector<ubyte> table(tail);
+    readAt(tableOffset, table.data(), tail);
+    if (version >= 5 && !is_table_valid(table.data())) {
+        logger.warning() << "corrupted offsets table in " << filename.string()
+                         << ", using the previous one";
+        tableOffset = findValidTable();
+        readAt(tableOffset, table.data(), tail);
+        recovered = true;
+    }
+    std::memcpy(offsets.data(), table.data(), REGION_CHUNKS_COUNT * 4);
     if (dataio::is_big_endian()) {
         for (size_t i = 0; i < offsets.size(); i++) {
-            offsets[i] = dataio::le2h(i);
+            offsets[i] = dataio::le2h(offsets[i]);
         }
     }
+    if (version >= 4) {
+        std::memcpy(&usedBytes, table.data() + REGION_CHUNKS_COUNT * 4, 4);
+        usedBytes = dataio::le2h(usedBytes);
+    }
 }
 
-std::unique_ptr<ubyte[]> regfile::read(
-    int index, uint32_t& size, uint32_t& srcSize
-) {
-    size_t file_size = file.length();
-    size_t table_offset = file_size - REGION_CHUNKS_COUNT * 4;
+size_t regfile::findValidTable() {
+    size_t tail = get_table_size(version);
+    // the file is read once, as it happens only after a crash
+    std::vector<ubyte> bytes(length());
+    readAt(0, bytes.data(), bytes.size());
+    for (size_t end = bytes.size() - 1; end >= REGION_HEADER_SIZE + tail;
+         end--) {
+        const ubyte* table = bytes.data() + end - tail;
+        if (table[tail - 4] == REGION_TABLE_MAGIC[0] &&
+            is_table_valid(table)) {
+            return end - tail;
+        }
+    }
+    throw std::runtime_error(
+        "no valid offsets table found in " + filename.string()
+    );
+}
 
-    uint32_t offset = offsets.at(index);
-    if (offset == 0) {
-        return nullptr;
+size_t regfile::length() const {
+    return mapping ? mapping->size() : file->length();
+}
+
+void regfile::readAt(size_t offset, void* dst, size_t size) {
+    if (mapping) {
+        std::memcpy(dst, mapping->data() + offset, size);
+        return;
     }
+    std::lock_guard lock(streamMutex);
+    file->seekg(offset);
+    file->read(reinterpret_cast<char*>(dst), size);
+}
 
-    uint32_t buff32;
-    file.seekg(offset);
-    file.read(reinterpret_cast<char*>(&buff32), 4);
-    size = dataio::le2h(buff32);
-    file.read(reinterpret_cast<char*>(&buff32), 4);
-    srcSize = dataio::le2h(buff32);
+size_t regfile::locate(int index, uint32_t& size, uint32_t& srcSize) {
+    size_t table_offset = tableOffset;
 
-    if (offset + size > file_size) {
+    uint32_t offset = offsets.at(index);
+    if (offset == 0) {
+        return 0;
+    }
+    if (offset + 8 > table_offset) {
+        size = 0;
+    } else {
+        uint32_t buff32[2];
+        readAt(offset, buff32, 8);
+        size = dataio::le2h(buff32[0]);
+        srcSize = dataio::le2h(buff32[1]);
+    }
+    if (offset + 8 > table_offset || offset + 8 + size > table_offset) {
         logger.error() << "corrupted region " << filename.string()
                        << " chunk offset detected at "
                        << (table_offset + index * 4);
+        return 0;
+    }
+    return offset + 8;
+}
+
+uint32_t regfile::recordSize(int index) {
+    uint32_t size;
+    uint32_t srcSize;
+    if (locate(index, size, srcSize) == 0) {
+        return 0;
+    }
+    return 8 + size;
+}
+
+std::unique_ptr<ubyte[]> regfile::read(
+    int index, uint32_t& size, uint32_t& srcSize
+) {
+    size_t offset = locate(index, size, srcSize);
+    if (offset == 0) {
         return nullptr;
     }
     auto data = std::make_unique<ubyte[]>(size);
-    file.read(reinterpret_cast<char*>(data.get()), size);
+    readAt(offset, data.get(), size);
+    count_read(size);
     return data;
 }
 
-void RegionsLayer::closeRegFile(glm::ivec2 coord) {
-    openRegFiles.erase(coord);
-    regFilesCv.notify_one();
+const ubyte* regfile::view(int index, uint32_t& size, uint32_t& srcSize) {
+    if (mapping == nullptr) {
+        return nullptr;
+    }
+    size_t offset = locate(index, size, srcSize);
+    if (offset == 0) {
+        return nullptr;
+    }
+    count_read(size);
+    return mapping->data() + offset;
 }
 
-regfile_ptr RegionsLayer::useRegFile(glm::ivec2 coord) {
-    auto* file = openRegFiles[coord].get();
-    file->inUse = true;
-    return regfile_ptr(file, &regFilesCv);
+void RegionFilesShard::close(glm::ivec2 coord) {
+    auto found = files.find(coord);
+    lru.erase(found->second.position);
+    files.erase(found);
 }
 
-// Marks regfile as used and unmarks when shared_ptr dies
-regfile_ptr RegionsLayer::getRegFile(glm::ivec2 coord, bool create) {
-    {
-        std::lock_guard lock(regFilesMutex);
-        const auto found = openRegFiles.find(coord);
-        if (found != openRegFiles.end()) {
-            if (found->second->inUse) {
-                throw std::runtime_error("regfile is currently in use");
-            }
-            return useRegFile(found->first);
+void RegionFilesShard::evict() {
+    for (auto it = lru.end(); files.size() > capacity && it != lru.begin();) {
+        --it;
+        const auto& file = files.at(*it).file;
+        if (file->users == 0 && !file->closing) {
+            close(*(it++));
         }
     }
-    if (create) {
-        return createRegFile(coord);
+}
+
+void RegionFilesShard::release(regfile* file) {
+    if (--file->users > 0) {
+        return;
+    }
+    if (file->closing) {
+        cv.notify_all();
+    } else if (files.size() > capacity) {
+        evict();
     }
-    return nullptr;
 }
 
-regfile_ptr RegionsLayer::createRegFile(glm::ivec2 coord) {
-    auto file = folder / get_region_filename(coord[0], coord[1]);
-    if (!io::exists(file)) {
+RegionFilesShard& RegionsLayer::getRegFilesShard(glm::ivec2 coord) {
+    uint hash = static_cast<uint>(coord.x) * 73856093U ^
+                static_cast<uint>(coord.y) * 19349663U;
+    return regFiles[hash % REGION_FILES_SHARDS];
+}
+
+regfile_ptr RegionsLayer::getRegFile(glm::ivec2 coord, bool create) {
+    auto& shard = getRegFilesShard(coord);
+    std::unique_lock lock(shard.mutex);
+    auto found = shard.files.find(coord);
+    // the file is being replaced, so wait until it's closed
+    while (found != shard.files.end() && found->second.file->closing) {
+        shard.cv.wait(lock);
+        found = shard.files.find(coord);
+    }
+    if (found != shard.files.end()) {
+        auto& entry = found->second;
+        shard.lru.splice(shard.lru.begin(), shard.lru, entry.position);
+        entry.file->users++;
+        return regfile_ptr(entry.file.get(), &shard);
+    }
+    if (!create) {
         return nullptr;
     }
-    if (openRegFiles.size() == MAX_OPEN_REGION_FILES) {
-        std::unique_lock lock(regFilesMutex);
-        while (true) {
-            bool closed = false;
-            // FIXME: bad choosing algorithm
-            for (auto& entry : openRegFiles) {
-                if (!entry.second->inUse) {
-                    closeRegFile(entry.first);
-                    closed = true;
-                    break;
-                }
-            }
-            if (closed) {
-                break;
-            }
-            // notified when any regfile gets out of use or closed
-            regFilesCv.wait(lock);
+    auto filename = folder / get_region_filename(coord.x, coord.y);
+    if (!io::exists(filename)) {
+        return nullptr;
+    }
+    auto file = std::make_unique<regfile>(filename, mappedFiles);
+    auto* ptr = file.get();
+    ptr->users++;
+    shard.lru.push_front(coord);
+    shard.files[coord] = {std::move(file), shard.lru.begin()};
+    shard.evict();
+    return regfile_ptr(ptr, &shard);
+}
+
+size_t RegionsLayer::evict(size_t budget) {
+    std::lock_guard dataLock(dataMutex);
+    std::lock_guard mapLock(mapMutex);
+    size_t usage = 0;
+    std::vector<std::pair<uint64_t, glm::ivec2>> saved;
+    for (const auto& [coord, region] : regions) {
+        usage += region->getMemoryUsage();
+        if (!region->isUnsaved()) {
+            saved.emplace_back(region->getLastUse(), coord);
         }
-        openRegFiles[coord] = std::make_unique<regfile>(file);
-        return useRegFile(coord);
-    } else {
-        std::lock_guard lock(regFilesMutex);
-        openRegFiles[coord] = std::make_unique<regfile>(file);
-        return useRegFile(coord);
     }
+    if (usage <= budget) {
+        return 0;
+    }
+    std::sort(
+        saved.begin(),
+        saved.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; }
+    );
+    size_t evicted = 0;
+    size_t released = 0;
+    for (const auto& [_, coord] : saved) {
+        if (usage <= budget) {
+            break;
+        }
+        auto found = regions.find(coord);
+        size_t regionUsage = found->second->getMemoryUsage();
+        usage -= regionUsage;
+        released += regionUsage;
+        regions.erase(found);
+        evicted++;
+    }
+    logger.info() << "evicted " << evicted << " regions from "
+                  << folder.string() << ", " << usage << " bytes left";
+    return released;
+}
+
+size_t RegionsLayer::getMemoryUsage() {
+    std::lock_guard dataLock(dataMutex);
+    std::lock_guard mapLock(mapMutex);
+    size_t usage = 0;
+    for (const auto& [_, region] : regions) {
+        usage += region->getMemoryUsage();
+    }
+    return usage;
+}
+
+void RegionsLayer::setMaxOpenFiles(uint count) {
+    size_t capacity = std::max<size_t>(
+        1, (count + REGION_FILES_SHARDS - 1) / REGION_FILES_SHARDS
+    );
+    for (auto& shard : regFiles) {
+        std::lock_guard lock(shard.mutex);
+        shard.capacity = capacity;
+        shard.evict();
+    }
+}
+
+size_t RegionsLayer::countOpenFiles() {
+    size_t count = 0;
+    for (auto& shard : regFiles) {
+        std::lock_guard lock(shard.mutex);
+        count += shard.files.size();
+    }
+    return count;
 }
 
 WorldRegion* RegionsLayer::getRegion(int x, int z) {
@@ -170,92 +467,520 @@ io::path RegionsLayer::getRegionFilePath(int x, int z) const {
 }
 
 WorldRegion* RegionsLayer::getOrCreateRegion(int x, int z) {
-    if (auto region = getRegion(x, z)) {
-        return region;
-    }
     std::lock_guard lock(mapMutex);
-    auto region_ptr = std::make_unique<WorldRegion>();
-    auto region = region_ptr.get();
-    regions[{x, z}] = std::move(region_ptr);
-    return region;
+    auto& region = regions[{x, z}];
+    if (region == nullptr) {
+        region = std::make_unique<WorldRegion>();
+    }
+    return region.get();
 }
 
 ubyte* RegionsLayer::getData(int x, int z, uint32_t& size, uint32_t& srcSize) {
+    std::unique_lock lock(dataMutex);
+    return getData(x, z, size, srcSize, lock);
+}
+
+bool RegionsLayer::readData(int x, int z, const ChunkDataProc& func) {
+    std::unique_lock lock(dataMutex);
+    uint32_t size;
+    uint32_t srcSize;
+    const ubyte* data = getData(x, z, size, srcSize, lock);
+    if (data == nullptr) {
+        return false;
+    }
+    func(data, size, srcSize);
+    return true;
+}
+
+ubyte* RegionsLayer::getData(
+    int x,
+    int z,
+    uint32_t& size,
+    uint32_t& srcSize,
+    std::unique_lock<std::mutex>& lock
+) {
     int regionX, regionZ, localX, localZ;
     calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
 
     WorldRegion* region = getOrCreateRegion(regionX, regionZ);
-    ubyte* data = region->getChunkData(localX, localZ);
-    if (data == nullptr) {
-        auto regfile = getRegFile({regionX, regionZ});
-        if (regfile != nullptr) {
-            auto dataptr = readChunkData(x, z, size, srcSize, regfile.get());
-            if (dataptr) {
-                data = dataptr.get();
-                region->put(localX, localZ, std::move(dataptr), size, srcSize);
-            }
-        }
+    region->touch(++useCounter);
+    if (ubyte* data = region->getChunkData(localX, localZ)) {
+        auto sizevec = region->getChunkDataSize(localX, localZ);
+        size = sizevec[0];
+        srcSize = sizevec[1];
+        return data;
+    }
+    if (region->isChunkDirty(localZ * REGION_SIZE + localX)) {
+        // removed, but not saved yet
+        return nullptr;
+    }
+    lock.unlock();
+    std::unique_ptr<ubyte[]> dataptr;
+    if (auto regfile = getRegFile({regionX, regionZ})) {
+        dataptr = readChunkData(x, z, size, srcSize, regfile.get());
     }
-    if (data != nullptr) {
+    lock.lock();
+    if (dataptr == nullptr) {
+        return nullptr;
+    }
+    // region may be evicted meanwhile
+    region = getOrCreateRegion(regionX, regionZ);
+    // may be already read in background
+    if (ubyte* data = region->getChunkData(localX, localZ)) {
         auto sizevec = region->getChunkDataSize(localX, localZ);
         size = sizevec[0];
         srcSize = sizevec[1];
         return data;
     }
-    return nullptr;
+    ubyte* data = dataptr.get();
+    region->put(localX, localZ, std::move(dataptr), size, srcSize);
+    return data;
+}
+
+void RegionsLayer::prefetch(int x, int z, std::vector<uint> indices) {
+    {
+        std::lock_guard lock(dataMutex);
+        WorldRegion* region = getOrCreateRegion(x, z);
+        auto* chunks = region->getChunks();
+        indices.erase(
+            std::remove_if(
+                indices.begin(),
+                indices.end(),
+                [chunks](uint index) { return chunks[index] != nullptr; }
+            ),
+            indices.end()
+        );
+    }
+    if (indices.empty()) {
+        return;
+    }
+    struct ChunkData {
+        uint index;
+        std::unique_ptr<ubyte[]> data;
+        glm::u32vec2 size;
+    };
+    std::vector<ChunkData> entries;
+    {
+        auto regfile = getRegFile({x, z});
+        if (regfile == nullptr) {
+            return;
+        }
+        auto* file = regfile.get();
+        // read chunks in file order to avoid random access
+        std::sort(
+            indices.begin(),
+            indices.end(),
+            [file](uint a, uint b) {
+                return file->offsets[a] < file->offsets[b];
+            }
+        );
+        for (uint index : indices) {
+            ChunkData entry {index, nullptr, {}};
+            entry.data = readChunkData(
+                x * REGION_SIZE + index % REGION_SIZE,
+                z * REGION_SIZE + index / REGION_SIZE,
+                entry.size[0],
+                entry.size[1],
+                file
+            );
+            if (entry.data) {
+                entries.push_back(std::move(entry));
+            }
+        }
+    }
+    std::lock_guard lock(dataMutex);
+    WorldRegion* region = getOrCreateRegion(x, z);
+    for (auto& entry : entries) {
+        uint localX = entry.index % REGION_SIZE;
+        uint localZ = entry.index / REGION_SIZE;
+        if (region->getChunkData(localX, localZ) == nullptr) {
+            region->put(
+                localX,
+                localZ,
+                std::move(entry.data),
+                entry.size[0],
+                entry.size[1]
+            );
+        }
+    }
+}
+
+/// @brief Region chunks indices in Z-order curve, so spatially adjacent
+/// chunks are stored close to each other
+static const std::array<uint, REGION_CHUNKS_COUNT>& get_morton_order() {
+    static const auto order = []() {
+        std::array<uint, REGION_CHUNKS_COUNT> order {};
+        for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+            uint x = i % REGION_SIZE;
+            uint z = i / REGION_SIZE;
+            uint code = 0;
+            for (uint bit = 0; bit < REGION_SIZE_BIT; bit++) {
+                code |= ((x >> bit) & 1) << (bit * 2);
+                code |= ((z >> bit) & 1) << (bit * 2 + 1);
+            }
+            order[code] = i;
+        }
+        return order;
+    }();
+    return order;
+}
+
+/// @brief Write region file with chunks laid out in Morton order
+RegionFileWriter::RegionFileWriter(
+    io::path filename, compression::Method compression, uint version
+)
+    : filename(std::move(filename)),
+      file(std::make_unique<std::ofstream>(
+          io::resolve(this->filename), std::ios::out | std::ios::binary
+      )),
+      offset(REGION_HEADER_SIZE),
+      version(version) {
+    char header[REGION_HEADER_SIZE] = REGION_FORMAT_MAGIC;
+    header[8] = version;
+    header[9] = static_cast<ubyte>(compression);  // FIXME
+    file->write(header, REGION_HEADER_SIZE);
+}
+
+RegionFileWriter::~RegionFileWriter() = default;
+
+void RegionFileWriter::write(
+    uint index, const ubyte* data, uint32_t size, uint32_t srcSize
+) {
+    offsets[index] = offset;
+
+    uint32_t intbuf = dataio::h2le(size);
+    file->write(reinterpret_cast<const char*>(&intbuf), 4);
+    intbuf = dataio::h2le(srcSize);
+    file->write(reinterpret_cast<const char*>(&intbuf), 4);
+    file->write(reinterpret_cast<const char*>(data), size);
+    offset += 8 + size;
+    count_write(size);
+}
+
+void RegionFileWriter::finish() {
+    auto usedBytes = static_cast<uint32_t>(offset - REGION_HEADER_SIZE);
+    if (version >= 5) {
+        write_table(*file, offsets, usedBytes);
+    } else {
+        for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+            uint32_t intbuf = dataio::h2le(offsets[i]);
+            file->write(reinterpret_cast<const char*>(&intbuf), 4);
+        }
+        if (version == 4) {
+            uint32_t intbuf = dataio::h2le(usedBytes);
+            file->write(reinterpret_cast<const char*>(&intbuf), 4);
+        }
+    }
+    auto& stream = static_cast<std::ofstream&>(*file);
+    stream.close();
+    if (!stream) {
+        throw std::runtime_error("could not write " + filename.string());
+    }
+}
+
+static void write_region_file(
+    const io::path& filename,
+    compression::Method compression,
+    const std::unique_ptr<ubyte[]>* chunks,
+    const glm::u32vec2* sizes
+) {
+    RegionFileWriter writer(filename, compression);
+    for (uint i : get_morton_order()) {
+        if (const ubyte* chunk = chunks[i].get()) {
+            writer.write(i, chunk, sizes[i][0], sizes[i][1]);
+        }
+    }
+    writer.finish();
 }
 
 void RegionsLayer::writeRegion(int x, int z, WorldRegion* entry) {
     io::path filename = folder / get_region_filename(x, z);
 
-    glm::ivec2 regcoord(x, z);
-    if (auto regfile = getRegFile(regcoord, false)) {
-        fetch_chunks(entry, x, z, regfile.get());
+    io::path tmpfile = filename.string() + ".tmp";
 
-        std::lock_guard lock(regFilesMutex);
-        regfile.reset();
-        closeRegFile(regcoord);
-    }
+    std::lock_guard dataLock(dataMutex);
+    // data put while writing will be written next time
+    entry->setUnsaved(false);
 
-    char header[REGION_HEADER_SIZE] = REGION_FORMAT_MAGIC;
-    header[8] = REGION_FORMAT_VERSION;
-    header[9] = static_cast<ubyte>(compression);  // FIXME
-    std::ofstream file(io::resolve(filename), std::ios::out | std::ios::binary);
-    file.write(header, REGION_HEADER_SIZE);
+    glm::ivec2 regcoord(x, z);
+    if (appendRegion(regcoord, filename, *entry)) {
+        entry->clearDirty();
+        return;
+    }
+    if (auto regfile = getRegFile(regcoord)) {
+        fetch_chunks(*this, entry, x, z, regfile.get());
+    }
 
-    size_t offset = REGION_HEADER_SIZE;
-    uint32_t intbuf;
-    uint offsets[REGION_CHUNKS_COUNT] {};
+    write_region_file(
+        tmpfile, compression, entry->getChunks(), entry->getSizes()
+    );
+    replaceRegFile(regcoord, filename);
+    entry->clearDirty();
+}
 
-    auto region = entry->getChunks();
-    auto sizes = entry->getSizes();
+/// @brief Append chunk records, offsets table and footer to the region file.
+/// Records are flushed to the storage before the table is written, so an
+/// interrupted append leaves the previous table the last valid one
+/// @param length current file length (new data start)
+/// @throws std::runtime_error - file writing failed
+static void append_region_file(
+    const io::path& filename,
+    size_t length,
+    std::array<uint32_t, REGION_CHUNKS_COUNT>& offsets,
+    const WorldRegion& region,
+    uint32_t usedBytes
+) {
+    std::fstream file(
+        io::resolve(filename), std::ios::in | std::ios::out | std::ios::binary
+    );
+    file.seekp(length);
 
-    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
-        ubyte* chunk = region[i].get();
+    auto* chunks = region.getChunks();
+    auto* sizes = region.getSizes();
+    size_t offset = length;
+    for (uint i : get_morton_order()) {
+        if (!region.isChunkDirty(i)) {
+            continue;
+        }
+        const ubyte* chunk = chunks[i].get();
         if (chunk == nullptr) {
+            offsets[i] = 0;
             continue;
         }
         offsets[i] = offset;
 
-        auto sizevec = sizes[i];
-        uint32_t compressedSize = sizevec[0];
-        uint32_t srcSize = sizevec[1];
-
-        intbuf = dataio::h2le(compressedSize);
+        uint32_t intbuf = dataio::h2le(sizes[i][0]);
         file.write(reinterpret_cast<const char*>(&intbuf), 4);
-        offset += 4;
-
-        intbuf = dataio::h2le(srcSize);
+        intbuf = dataio::h2le(sizes[i][1]);
         file.write(reinterpret_cast<const char*>(&intbuf), 4);
-        offset += 4;
+        file.write(reinterpret_cast<const char*>(chunk), sizes[i][0]);
+        offset += 8 + sizes[i][0];
+        count_write(sizes[i][0]);
+    }
+    file.flush();
+    if (!file || !platform::sync_file(io::resolve(filename))) {
+        throw std::runtime_error("could not write " + filename.string());
+    }
+    write_table(file, offsets, usedBytes);
+    file.close();
+    if (!file) {
+        throw std::runtime_error("could not write " + filename.string());
+    }
+}
+
+bool RegionsLayer::appendRegion(
+    glm::ivec2 coord, const io::path& filename, WorldRegion& region
+) {
+    auto regfile = getRegFile(coord);
+    if (regfile == nullptr) {
+        return false;
+    }
+    auto* file = regfile.get();
+    if (file->version != REGION_FORMAT_VERSION ||
+        file->compression != compression || file->recovered) {
+        return false;
+    }
+    auto offsets = file->offsets;
+    size_t length = file->length();
+    size_t usedBytes = file->usedBytes;
+    size_t appended = 0;
+    auto* chunks = region.getChunks();
+    auto* sizes = region.getSizes();
+    for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        if (!region.isChunkDirty(i)) {
+            continue;
+        }
+        usedBytes -= std::min<size_t>(usedBytes, file->recordSize(i));
+        if (chunks[i] != nullptr) {
+            appended += 8 + sizes[i][0];
+        }
+    }
+    usedBytes += appended;
+
+    size_t tail = REGION_CHUNKS_COUNT * 4 + REGION_FOOTER_SIZE;
+    size_t newLength = length + appended + tail;
+    // replaced chunks and tables are reclaimed by rewriting the region
+    if (newLength > UINT32_MAX ||
+        (newLength > REGION_COMPACTION_MIN_SIZE &&
+         newLength > (REGION_HEADER_SIZE + usedBytes + tail) * 2)) {
+        return false;
+    }
+    auto& shard = getRegFilesShard(coord);
+    {
+        std::unique_lock lock(shard.mutex);
+        if (file->closing) {
+            return false;
+        }
+        // the file is not given to readers until the new table is written
+        file->closing = true;
+        regfile.resetLocked();
+        shard.cv.wait(lock, [file]() { return file->users == 0; });
+    }
+    bool success = true;
+    try {
+        append_region_file(filename, length, offsets, region, usedBytes);
+    } catch (const std::runtime_error& err) {
+        logger.error() << err.what();
+        // drop incomplete data, so the previous table stays at the end
+        std::error_code ec;
+        std::filesystem::resize_file(io::resolve(filename), length, ec);
+        success = false;
+    }
+    std::lock_guard lock(shard.mutex);
+    shard.close(coord);
+    shard.cv.notify_all();
+    return success;
+}
+
+int64_t RegionsLayer::compactRegion(int x, int z) {
+    io::path filename = folder / get_region_filename(x, z);
+    io::path tmpfile = filename.string() + ".tmp";
+    glm::ivec2 regcoord(x, z);
+
+    size_t srcLength;
+    {
+        auto regfile = getRegFile(regcoord);
+        if (regfile == nullptr) {
+            return 0;
+        }
+        auto* file = regfile.get();
+        if (file->version < REGION_FORMAT_MIN_VERSION) {
+            logger.warning() << "region " << filename.string()
+                             << " must be upgraded before compaction";
+            return 0;
+        }
+        srcLength = file->length();
+
+        auto chunks =
+            std::make_unique<std::unique_ptr<ubyte[]>[]>(REGION_CHUNKS_COUNT);
+        auto sizes = std::make_unique<glm::u32vec2[]>(REGION_CHUNKS_COUNT);
+        for (uint index : get_morton_order()) {
+            chunks[index] = file->read(index, sizes[index][0], sizes[index][1]);
+        }
+        write_region_file(
+            tmpfile, file->compression, chunks.get(), sizes.get()
+        );
+    }
+    size_t dstLength = std::filesystem::file_size(io::resolve(tmpfile));
+    replaceRegFile(regcoord, filename);
+    return static_cast<int64_t>(srcLength) - static_cast<int64_t>(dstLength);
+}
 
-        file.write(reinterpret_cast<const char*>(chunk), compressedSize);
-        offset += compressedSize;
+void RegionsLayer::rewriteRegion(
+    int x, int z, const RegionChunkProc& func
+) {
+    io::path filename = folder / get_region_filename(x, z);
+    io::path tmpfile = filename.string() + ".tmp";
+    glm::ivec2 regcoord(x, z);
+    {
+        auto regfile = getRegFile(regcoord);
+        if (regfile == nullptr) {
+            throw std::runtime_error("could not open region file");
+        }
+        RegionFileWriter writer(tmpfile, compression);
+        for (uint index : get_morton_order()) {
+            int gx = index % REGION_SIZE + x * REGION_SIZE;
+            int gz = index / REGION_SIZE + z * REGION_SIZE;
+            uint32_t size;
+            uint32_t srcSize;
+            auto data = readChunkData(gx, gz, size, srcSize, regfile.get());
+            if (data == nullptr) {
+                continue;
+            }
+            std::unique_ptr<ubyte[]> source;
+            if (compression == compression::Method::NONE) {
+                source = std::make_unique<ubyte[]>(srcSize);
+                std::memcpy(source.get(), data.get(), srcSize);
+            } else {
+                source = compression::decompress(
+                    data.get(), size, srcSize, compression
+                );
+            }
+            uint32_t dstSize = srcSize;
+            auto processed = func(gx, gz, std::move(source), &dstSize);
+            if (processed == nullptr) {
+                if (dstSize != 0) {
+                    writer.write(index, data.get(), size, srcSize);
+                }
+                continue;
+            }
+            size_t length = dstSize;
+            if (compression != compression::Method::NONE) {
+                processed = compression::compress(
+                    processed.get(), dstSize, length, compression
+                );
+            }
+            writer.write(index, processed.get(), length, dstSize);
+        }
+        writer.finish();
     }
+    replaceRegFile(regcoord, filename);
+}
+
+void RegionsLayer::transformRegion(
+    int x, int z, const std::function<void(ubyte*, uint32_t)>& func
+) {
+    std::lock_guard lock(dataMutex);
+    WorldRegion* region = getOrCreateRegion(x, z);
+    if (auto regfile = getRegFile({x, z})) {
+        fetch_chunks(*this, region, x, z, regfile.get());
+    }
+    auto* chunks = region->getChunks();
+    auto* sizes = region->getSizes();
     for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
-        intbuf = dataio::h2le(offsets[i]);
-        file.write(reinterpret_cast<const char*>(&intbuf), 4);
+        const ubyte* stored = chunks[i].get();
+        if (stored == nullptr) {
+            continue;
+        }
+        uint32_t srcSize = sizes[i][1];
+        std::unique_ptr<ubyte[]> data;
+        if (compression != compression::Method::NONE) {
+            data = compression::decompress(
+                stored, sizes[i][0], srcSize, compression
+            );
+        } else {
+            data = std::make_unique<ubyte[]>(srcSize);
+            std::memcpy(data.get(), stored, srcSize);
+        }
+        func(data.get(), srcSize);
+
+        size_t size = srcSize;
+        if (compression != compression::Method::NONE) {
+            data = compression::compress(data.get(), srcSize, size, compression);
+        }
+        uint localX = i % REGION_SIZE;
+        uint localZ = i / REGION_SIZE;
+        region->put(localX, localZ, std::move(data), size, srcSize);
+        region->setChunkDirty(localX, localZ);
+    }
+    region->setUnsaved(true);
+}
+
+void RegionsLayer::replaceRegFile(glm::ivec2 coord, const io::path& file) {
+    io::path tmpfile = file.string() + ".tmp";
+    auto& shard = getRegFilesShard(coord);
+    std::unique_lock lock(shard.mutex);
+    auto found = shard.files.find(coord);
+    while (found != shard.files.end()) {
+        auto& regfile = *found->second.file;
+        if (regfile.users == 0) {
+            shard.close(coord);
+            break;
+        }
+        if (regfile.closing) {
+            // replaced by another thread
+            shard.cv.wait(lock);
+            found = shard.files.find(coord);
+            continue;
+        }
+        regfile.closing = true;
+        shard.cv.wait(lock, [&regfile]() { return regfile.users == 0; });
+        shard.close(coord);
+        shard.cv.notify_all();
+        break;
     }
+    // still locked, so the file is not reopened until replaced
+    std::filesystem::rename(io::resolve(tmpfile), io::resolve(file));
 }
 
 std::unique_ptr<ubyte[]> RegionsLayer::readChunkData(
@@ -264,5 +989,50 @@ std::unique_ptr<ubyte[]> RegionsLayer::readChunkData(
     int regionX, regionZ, localX, localZ;
     calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
     int chunkIndex = localZ * REGION_SIZE + localX;
-    return rfile->read(chunkIndex, size, srcSize);
+    auto srcMethod = rfile->version < REGION_FORMAT_MIN_VERSION
+                         ? compression
+                         : rfile->compression;
+    if (const ubyte* view = rfile->view(chunkIndex, size, srcSize)) {
+        return recompress(view, nullptr, size, srcSize, srcMethod, compression);
+    }
+    auto data = rfile->read(chunkIndex, size, srcSize);
+    if (data == nullptr) {
+        return nullptr;
+    }
+    const ubyte* src = data.get();
+    return recompress(
+        src, std::move(data), size, srcSize, srcMethod, compression
+    );
+}
+
+std::unique_ptr<ubyte[]> RegionsLayer::readChunkSource(
+    int x, int z, uint32_t& srcSize, regfile* rfile
+) {
+    int regionX, regionZ, localX, localZ;
+    calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
+    int chunkIndex = localZ * REGION_SIZE + localX;
+    auto srcMethod = rfile->version < REGION_FORMAT_MIN_VERSION
+                         ? compression
+                         : rfile->compression;
+    uint32_t size;
+    std::unique_ptr<ubyte[]> data;
+    if (const ubyte* view = rfile->view(chunkIndex, size, srcSize)) {
+        data = recompress(
+            view, nullptr, size, srcSize, srcMethod, compression::Method::NONE
+        );
+    } else if ((data = rfile->read(chunkIndex, size, srcSize))) {
+        const ubyte* src = data.get();
+        data = recompress(
+            src,
+            std::move(data),
+            size,
+            srcSize,
+            srcMethod,
+            compression::Method::NONE
+        );
+    } else {
+        return nullptr;
+    }
+    srcSize = size;
+    return data;
 }
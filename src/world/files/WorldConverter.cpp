@@ -1,8 +1,10 @@
 #include "WorldConverter.hpp"
 
+#include <filesystem>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <unordered_map>
 #include <utility>
 
 #include "content/ContentReport.hpp"
@@ -95,8 +97,16 @@ void WorldConverter::createConvertTasks() {
         }
     }
 
-    tasks.push(ConvertTask {
-        ConvertTaskType::PLAYER, wfile->getPlayerFile(), 0, 0, {}});
+    if (io::is_regular_file(wfile->getPlayerFile())) {
+        tasks.push(ConvertTask {
+            ConvertTaskType::PLAYER, wfile->getPlayerFile(), 0, 0, {}});
+    }
+    auto playersFolder = wfile->getPlayersFolder();
+    if (io::is_directory(playersFolder)) {
+        for (const auto& file : io::directory_iterator(playersFolder)) {
+            tasks.push(ConvertTask {ConvertTaskType::PLAYER, file, 0, 0, {}});
+        }
+    }
 }
 
 void WorldConverter::createBlockFieldsConvertTasks() {
@@ -116,6 +126,14 @@ void WorldConverter::createBlockFieldsConvertTasks() {
     }
 }
 
+void WorldConverter::createCompactTasks() {
+    for (size_t i = 0; i < REGION_LAYERS_COUNT; i++) {
+        addRegionsTasks(
+            static_cast<RegionLayerIndex>(i), ConvertTaskType::COMPACT_REGION
+        );
+    }
+}
+
 WorldConverter::WorldConverter(
     const std::shared_ptr<WorldFiles>& worldFiles,
     const Content* content,
@@ -137,6 +155,9 @@ WorldConverter::WorldConverter(
         case ConvertMode::BLOCK_FIELDS:
             createBlockFieldsConvertTasks();
             break;
+        case ConvertMode::COMPACT:
+            createCompactTasks();
+            break;
     }
 }
 
@@ -183,9 +204,10 @@ void WorldConverter::upgradeRegion(
     const io::path& file, int x, int z, RegionLayerIndex layer
 ) const {
     auto path = wfile->getRegions().getRegionFilePath(layer, x, z);
-    auto bytes = io::read_bytes_buffer(path);
-    auto buffer = compatibility::convert_region_2to3(bytes, layer);
-    io::write_bytes(path, buffer.data(), buffer.size());
+    io::path tmpfile = path.string() + ".tmp";
+    compatibility::convert_region_2to3(path, tmpfile, layer);
+    // source file is not replaced until upgraded one is complete
+    std::filesystem::rename(io::resolve(tmpfile), io::resolve(path));
 }
 
 void WorldConverter::convertVoxels(const io::path& file, int x, int z) const {
@@ -206,6 +228,12 @@ void WorldConverter::convertInventories(const io::path& file, int x, int z) cons
 
 void WorldConverter::convertPlayer(const io::path& file) const {
     logger.info() << "converting player " << file.string();
+    if (file.extension() == ".bjson") {
+        auto map = io::read_binary_json(file);
+        Player::convert(map, report.get());
+        io::write_binary_json(file, map);
+        return;
+    }
     auto map = io::read_json(file);
     Player::convert(map, report.get());
     io::write_json(file, map);
@@ -220,25 +248,61 @@ void WorldConverter::convertBlocksData(int x, int z, const ContentReport& report
 
         const auto& indices = content->getIndices()->blocks;
 
+        // entries of the same block are converted at once
+        struct BlockEntries {
+            const data::StructLayout* prevStruct;
+            std::vector<uint16_t> indices;
+            std::vector<const ubyte*> src;
+            std::vector<ubyte*> dst;
+        };
+        std::unordered_map<const Block*, BlockEntries> blocks;
+
         BlocksMetadata newHeap;
         for (const auto& entry : *heap) {
             size_t index = entry.index;
-            const auto& def = indices.require(chunk.voxels[index].id);
-            const auto& newStruct = *def.dataStruct;
-            const auto& found = report.blocksDataLayouts.find(def.name);
-            if (found == report.blocksDataLayouts.end()) {
-                logger.error() << "no previous fields layout found for block" 
-                    << def.name << " - discard";
-                continue; 
+            const auto& def = indices.require(chunk.get(index).id);
+            auto& entries = blocks[&def];
+            if (entries.prevStruct == nullptr) {
+                const auto& found = report.blocksDataLayouts.find(def.name);
+                if (found == report.blocksDataLayouts.end()) {
+                    logger.error() << "no previous fields layout found for block" 
+                        << def.name << " - discard";
+                    continue; 
+                }
+                entries.prevStruct = &found->second;
             }
-            const auto& prevStruct = found->second;
-            uint8_t* dst = newHeap.allocate(index, newStruct.size());
-            newStruct.convert(prevStruct, entry.data(), dst, true);
+            newHeap.allocate(index, def.dataStruct->size());
+            entries.indices.push_back(index);
+            entries.src.push_back(entry.data());
+        }
+        // heap pointers are valid when all entries are allocated
+        for (auto& [def, entries] : blocks) {
+            if (entries.indices.empty()) {
+                continue;
+            }
+            for (uint16_t index : entries.indices) {
+                entries.dst.push_back(newHeap.find(index));
+            }
+            def->dataStruct->convert(
+                *entries.prevStruct,
+                entries.src.data(),
+                entries.dst.data(),
+                entries.dst.size(),
+                true
+            );
         }
         *heap = std::move(newHeap);
     });
 }
 
+void WorldConverter::compactRegion(
+    int x, int z, RegionLayerIndex layer
+) const {
+    logger.info() << "compacting region " << x << "_" << z << " of layer "
+                  << static_cast<int>(layer);
+    reclaimedBytes += wfile->getRegions().compactRegion(layer, x, z);
+}
+
 void WorldConverter::convert(const ConvertTask& task) const {
     if (!io::is_regular_file(task.file)) return;
 
@@ -258,6 +322,9 @@ void WorldConverter::convert(const ConvertTask& task) const {
         case ConvertTaskType::CONVERT_BLOCKS_DATA:
             convertBlocksData(task.x, task.z, *report);
             break;
+        case ConvertTaskType::COMPACT_REGION:
+            compactRegion(task.x, task.z, task.layer);
+            break;
     }
 }
 
@@ -292,6 +359,11 @@ bool WorldConverter::isActive() const {
 }
 
 void WorldConverter::write() {
+    if (mode == ConvertMode::COMPACT) {
+        logger.info() << "compaction finished, reclaimed "
+                      << reclaimedBytes.load() << " bytes";
+        return;
+    }
     logger.info() << "applying changes";
 
     auto patch = dv::object();
@@ -305,6 +377,8 @@ void WorldConverter::write() {
         case ConvertMode::BLOCK_FIELDS:
             WorldFiles::createBlockFieldsIndices(content->getIndices(), patch);
             break;
+        case ConvertMode::COMPACT:
+            break;
     }
     wfile->patchIndicesFile(patch);
     wfile->write(nullptr, nullptr);
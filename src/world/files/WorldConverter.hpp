@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <queue>
 
@@ -24,6 +25,8 @@ enum class ConvertTaskType {
     UPGRADE_REGION,
     /// @brief convert blocks data to updated layouts
     CONVERT_BLOCKS_DATA,
+    /// @brief rewrite region file with chunks laid out in Morton order
+    COMPACT_REGION,
 };
 
 struct ConvertTask {
@@ -39,6 +42,8 @@ enum class ConvertMode {
     UPGRADE,
     REINDEX,
     BLOCK_FIELDS,
+    /// @brief defragment region files (report is not required)
+    COMPACT,
 };
 
 class WorldConverter : public Task {
@@ -49,6 +54,8 @@ class WorldConverter : public Task {
     runnable onComplete;
     uint tasksDone = 0;
     ConvertMode mode;
+    /// @brief Total size reduction of compacted region files
+    mutable std::atomic<int64_t> reclaimedBytes = 0;
 
     void upgradeRegion(
         const io::path& file, int x, int z, RegionLayerIndex layer) const;
@@ -56,6 +63,7 @@ class WorldConverter : public Task {
     void convertVoxels(const io::path& file, int x, int z) const;
     void convertInventories(const io::path& file, int x, int z) const;
     void convertBlocksData(int x, int z, const ContentReport& report) const;
+    void compactRegion(int x, int z, RegionLayerIndex layer) const;
 
     void addRegionsTasks(
         RegionLayerIndex layerid,
@@ -65,6 +73,7 @@ class WorldConverter : public Task {
     void createUpgradeTasks();
     void createConvertTasks();
     void createBlockFieldsConvertTasks();
+    void createCompactTasks();
 public:
     WorldConverter(
         const std::shared_ptr<WorldFiles>& worldFiles,
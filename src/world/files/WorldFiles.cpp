@@ -47,6 +47,11 @@ WorldFiles::WorldFiles(const io::path& directory, const DebugSettings& settings)
     doWriteLights = settings.doWriteLights.get();
     regions.generatorTestMode = generatorTestMode;
     regions.doWriteLights = doWriteLights;
+    regions.setMappedFiles(settings.doMapRegionFiles.get());
+    regions.setMaxOpenFiles(settings.maxOpenRegionFiles.get());
+    regions.setMemoryBudget(
+        static_cast<size_t>(settings.regionsMemoryBudget.get()) * 1024 * 1024
+    );
 }
 
 WorldFiles::~WorldFiles() = default;
@@ -60,10 +65,22 @@ io::path WorldFiles::getPlayerFile() const {
     return directory / "player.json";
 }
 
+io::path WorldFiles::getPlayersFolder() const {
+    return directory / "players";
+}
+
+io::path WorldFiles::getPlayerFile(int64_t id) const {
+    return getPlayersFolder() / (std::to_string(id) + ".bjson");
+}
+
 io::path WorldFiles::getResourcesFile() const {
     return directory / "resources.json";
 }
 
+io::path WorldFiles::getPregenerationFile() const {
+    return directory / "pregen.json";
+}
+
 io::path WorldFiles::getWorldFile() const {
     return directory / WORLD_FILE;
 }
@@ -76,9 +93,7 @@ io::path WorldFiles::getPacksFile() const {
     return directory / "packs.list";
 }
 
-void WorldFiles::write(
-    const World* world, const Content* content
-) {
+bool WorldFiles::writeMetadata(const World* world, const Content* content) {
     if (world) {
         writeWorldInfo(world->getInfo());
         if (!io::exists(getPacksFile())) {
@@ -86,12 +101,28 @@ void WorldFiles::write(
         }
     }
     if (generatorTestMode) {
-        return;
+        return false;
     }
     if (content) {
         writeIndices(content->getIndices());
     }
-    regions.writeAll();
+    return true;
+}
+
+void WorldFiles::write(
+    const World* world, const Content* content
+) {
+    if (writeMetadata(world, content)) {
+        regions.writeAll();
+    }
+}
+
+void WorldFiles::writeAsync(
+    const World* world, const Content* content, RegionsSnapshot snapshot
+) {
+    if (writeMetadata(world, content)) {
+        regions.writeAllAsync(std::move(snapshot));
+    }
 }
 
 void WorldFiles::writePacks(const std::vector<ContentPack>& packs) {
@@ -35,14 +35,22 @@ class WorldFiles {
 
     void writeWorldInfo(const WorldInfo& info);
     void writeIndices(const ContentIndices* indices);
+
+    /// @return false if regions must not be written
+    bool writeMetadata(const World* world, const Content* content);
 public:
     WorldFiles(const io::path& directory);
     WorldFiles(const io::path& directory, const DebugSettings& settings);
     ~WorldFiles();
 
+    /// @brief Legacy file containing all players (before per-player files)
     io::path getPlayerFile() const;
+    io::path getPlayersFolder() const;
+    io::path getPlayerFile(int64_t id) const;
     io::path getIndicesFile() const;
     io::path getResourcesFile() const;
+    /// @brief Chunks pre-generation progress file (see ChunksPregenerator)
+    io::path getPregenerationFile() const;
     void createDirectories();
 
     std::optional<WorldInfo> readWorldInfo();
@@ -62,6 +70,15 @@ public:
     /// @param content world content
     void write(const World* world, const Content* content);
 
+    /// @brief Write world info and indices, then write regions with the
+    /// snapshot data in background
+    /// @param world target world
+    /// @param content world content
+    /// @param snapshot captured chunks data
+    void writeAsync(
+        const World* world, const Content* content, RegionsSnapshot snapshot
+    );
+
     void writePacks(const std::vector<ContentPack>& packs);
 
     void removeIndices(const std::vector<std::string>& packs);
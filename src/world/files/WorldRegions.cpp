@@ -5,13 +5,16 @@
 #include <vector>
 
 #include "debug/Logger.hpp"
+#include "debug/Memory.hpp"
 #include "coders/json.hpp"
 #include "coders/byte_utils.hpp"
 #include "coders/rle.hpp"
 #include "coders/binary_json.hpp"
 #include "items/Inventory.hpp"
+#include "objects/entities_index.hpp"
 #include "maths/voxmaths.hpp"
 #include "util/data_io.hpp"
+#include "util/ThreadPool.hpp"
 
 #define REGION_FORMAT_MAGIC ".VOXREG"
 
@@ -21,7 +24,8 @@ WorldRegion::WorldRegion()
     : chunksData(
           std::make_unique<std::unique_ptr<ubyte[]>[]>(REGION_CHUNKS_COUNT)
       ),
-      sizes(std::make_unique<glm::u32vec2[]>(REGION_CHUNKS_COUNT)) {
+      sizes(std::make_unique<glm::u32vec2[]>(REGION_CHUNKS_COUNT)),
+      sequences(std::make_unique<uint64_t[]>(REGION_CHUNKS_COUNT)) {
 }
 
 WorldRegion::~WorldRegion() = default;
@@ -33,6 +37,18 @@ bool WorldRegion::isUnsaved() const {
     return unsaved;
 }
 
+void WorldRegion::setChunkDirty(uint x, uint z) {
+    dirty.set(z * REGION_SIZE + x);
+}
+
+bool WorldRegion::isChunkDirty(uint index) const {
+    return dirty.test(index);
+}
+
+void WorldRegion::clearDirty() {
+    dirty.reset();
+}
+
 std::unique_ptr<ubyte[]>* WorldRegion::getChunks() const {
     return chunksData.get();
 }
@@ -41,12 +57,30 @@ glm::u32vec2* WorldRegion::getSizes() const {
     return sizes.get();
 }
 
-void WorldRegion::put(
-    uint x, uint z, std::unique_ptr<ubyte[]> data, uint32_t size, uint32_t srcSize
+bool WorldRegion::put(
+    uint x,
+    uint z,
+    std::unique_ptr<ubyte[]> data,
+    uint32_t size,
+    uint32_t srcSize,
+    uint64_t sequence
 ) {
     size_t chunk_index = z * REGION_SIZE + x;
+    if (sequence) {
+        if (sequence < sequences[chunk_index]) {
+            return false;
+        }
+        sequences[chunk_index] = sequence;
+    }
+    if (chunksData[chunk_index]) {
+        memoryUsage -= sizes[chunk_index][0];
+    }
+    if (data) {
+        memoryUsage += size;
+    }
     chunksData[chunk_index] = std::move(data);
     sizes[chunk_index] = glm::u32vec2(size, srcSize);
+    return true;
 }
 
 ubyte* WorldRegion::getChunkData(uint x, uint z) {
@@ -75,19 +109,90 @@ WorldRegions::WorldRegions(const io::path& directory) : directory(directory) {
 
     auto& blocksData = layers[REGION_LAYER_BLOCKS_DATA];
     blocksData.folder = directory / "blocksdata";
+
+    layers[REGION_LAYER_SCHEDULED_UPDATES].folder = directory / "updates";
+
+    auto& prototypes = layers[REGION_LAYER_PROTOTYPES];
+    prototypes.folder = directory / "prototypes";
+    prototypes.compression = compression::Method::GZIP;
+
+    readRemap();
+
+    memorySource = debug::memory::add_source(
+        debug::MemoryTag::REGIONS,
+        [this]() { return getMemoryUsage(); },
+        [this](size_t bytes) { return evict(bytes); }
+    );
+}
+
+WorldRegions::~WorldRegions() {
+    waitSaving();
 }
 
-WorldRegions::~WorldRegions() = default;
+class RegionsPrefetchWorker : public util::Worker<RegionsPrefetchJob, int> {
+public:
+    int operator()(const RegionsPrefetchJob& job) override {
+        job.layer->prefetch(job.region.x, job.region.y, job.indices);
+        return 0;
+    }
+};
+
+void WorldRegions::prefetch(const std::vector<glm::ivec2>& chunks) {
+    if (generatorTestMode || chunks.empty()) {
+        return;
+    }
+    if (prefetchPool == nullptr) {
+        // region files reading is sequential, so one worker is enough
+        prefetchPool =
+            std::make_unique<util::ThreadPool<RegionsPrefetchJob, int>>(
+                "regions-prefetch",
+                []() { return std::make_unique<RegionsPrefetchWorker>(); },
+                [](int&&) {},
+                1
+            );
+        prefetchPool->setStopOnFail(false);
+    }
+    prefetchPool->pullResults();
+
+    std::unordered_map<glm::ivec2, std::vector<uint>> regionsChunks;
+    for (const auto& pos : chunks) {
+        int regionX, regionZ, localX, localZ;
+        calc_reg_coords(pos.x, pos.y, regionX, regionZ, localX, localZ);
+        regionsChunks[{regionX, regionZ}].push_back(
+            localZ * REGION_SIZE + localX
+        );
+    }
+    for (auto& layer : layers) {
+        for (const auto& [region, indices] : regionsChunks) {
+            prefetchPool->enqueueJob(
+                RegionsPrefetchJob {&layer, region, indices}
+            );
+        }
+    }
+}
 
 void RegionsLayer::writeAll() {
-    for (auto& it : regions) {
-        WorldRegion* region = it.second.get();
-        if (region->getChunks() == nullptr || !region->isUnsaved()) {
+    // regions are removed from the map by evict only,
+    // so it's not locked while writing
+    std::vector<std::pair<glm::ivec2, WorldRegion*>> entries;
+    {
+        std::lock_guard lock(mapMutex);
+        for (auto& [key, region] : regions) {
+            entries.emplace_back(key, region.get());
+        }
+    }
+    for (auto& [key, region] : entries) {
+        bool unsaved;
+        {
+            std::lock_guard lock(dataMutex);
+            unsaved = region->isUnsaved();
+        }
+        if (region->getChunks() == nullptr || !unsaved) {
             continue;
         }
-        const auto& key = it.first;
         writeRegion(key[0], key[1], region);
     }
+    evict();
 }
 
 void WorldRegions::put(
@@ -96,25 +201,38 @@ void WorldRegions::put(
     RegionLayerIndex layerid,
     std::unique_ptr<ubyte[]> data,
     size_t srcSize
+) {
+    put(x, z, layerid, std::move(data), srcSize, putSequence++);
+}
+
+void WorldRegions::put(
+    int x,
+    int z,
+    RegionLayerIndex layerid,
+    std::unique_ptr<ubyte[]> data,
+    size_t srcSize,
+    uint64_t sequence
 ) {
     size_t size = srcSize;
     auto& layer = layers[layerid];
     int regionX, regionZ, localX, localZ;
     calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
 
+    if (data != nullptr && layer.compression != compression::Method::NONE) {
+        data = compression::compress(
+            data.get(), size, size, layer.compression);
+    }
+    std::lock_guard lock(layer.dataMutex);
     WorldRegion* region = layer.getOrCreateRegion(regionX, regionZ);
-    region->setUnsaved(true);
-    
+    region->touch(++layer.useCounter);
     if (data == nullptr) {
-        region->put(localX, localZ, nullptr, 0, 0);
-        return;
+        size = 0;
+        srcSize = 0;
     }
-
-    if (layer.compression != compression::Method::NONE) {
-        data = compression::compress(
-            data.get(), size, size, layer.compression);
+    if (region->put(localX, localZ, std::move(data), size, srcSize, sequence)) {
+        region->setChunkDirty(localX, localZ);
+        region->setUnsaved(true);
     }
-    region->put(localX, localZ, std::move(data), size, srcSize);
 }
 
 static std::unique_ptr<ubyte[]> write_inventories(
@@ -152,7 +270,34 @@ static ChunkInventoriesMap load_inventories(const ubyte* src, uint32_t size) {
     return inventories;
 }
 
+static std::unique_ptr<ubyte[]> write_scheduled_updates(
+    const std::vector<ScheduledUpdate>& updates, uint32_t& datasize
+) {
+    ByteBuilder builder;
+    builder.putInt32(updates.size());
+    for (const auto& update : updates) {
+        builder.putInt32(update.index);
+        builder.putInt64(update.tick);
+    }
+    datasize = builder.size();
+    auto data = std::make_unique<ubyte[]>(datasize);
+    std::memcpy(data.get(), builder.data(), datasize);
+    return data;
+}
+
 void WorldRegions::put(Chunk* chunk, std::vector<ubyte> entitiesData) {
+    std::vector<ChunkLayerData> entries;
+    capture(chunk, std::move(entitiesData), entries);
+    for (auto& entry : entries) {
+        put(entry.x, entry.z, entry.layer, std::move(entry.data), entry.size);
+    }
+}
+
+void WorldRegions::capture(
+    Chunk* chunk,
+    std::vector<ubyte> entitiesData,
+    std::vector<ChunkLayerData>& dst
+) {
     if (generatorTestMode) {
         return;
     }
@@ -160,108 +305,165 @@ void WorldRegions::put(Chunk* chunk, std::vector<ubyte> entitiesData) {
     if (!chunk->flags.ready) {
         return;
     }
-    bool lightsUnsaved = !chunk->flags.loadedLights && doWriteLights;
-    if (!chunk->flags.unsaved && !lightsUnsaved && !chunk->flags.entities) {
-        return;
-    }
-
-    int regionX, regionZ, localX, localZ;
-    calc_reg_coords(chunk->x, chunk->z, regionX, regionZ, localX, localZ);
-
-    put(chunk->x,
-        chunk->z,
-        REGION_LAYER_VOXELS,
-        chunk->encode(),
-        CHUNK_DATA_LEN);
-
-    // Writing lights cache
-    if (doWriteLights && chunk->flags.lighted && chunk->lightmap) {
-        put(chunk->x,
-            chunk->z,
-            REGION_LAYER_LIGHTS,
+    auto& flags = chunk->flags;
+    bool all = flags.unsaved;
+    bool voxels = all || flags.unsavedVoxels;
+    int x = chunk->x;
+    int z = chunk->z;
+
+    if (voxels) {
+        dst.push_back(
+            {x, z, REGION_LAYER_VOXELS, chunk->encode(), CHUNK_DATA_LEN}
+        );
+    }
+    // Writing lights cache (changed with voxels or computed after load)
+    if (doWriteLights && flags.lighted && chunk->lightmap &&
+        (voxels || (!flags.loadedLights && !flags.savedLights))) {
+        dst.push_back({
+            x, z, REGION_LAYER_LIGHTS,
             chunk->lightmap->encode(),
-            LIGHTMAP_DATA_LEN);
-    }
-    // Writing block inventories
-    if (!chunk->inventories.empty() || chunk->flags.inventoriesRemoved) {
-        uint datasize;
-        auto data = write_inventories(chunk->inventories, datasize);
-        put(chunk->x,
-            chunk->z,
-            REGION_LAYER_INVENTORIES,
-            std::move(data),
-            datasize);
+            LIGHTMAP_DATA_LEN
+        });
+        flags.savedLights = true;
+    }
+    // Writing block inventories (not accessed ones are saved already)
+    const auto& inventories = chunk->inventories;
+    if (chunk->isBlockInventoriesLoaded()) {
+        bool inventoriesUnsaved = flags.unsavedInventories ||
+                                  (all && !inventories.empty());
+        for (const auto& [_, inventory] : inventories) {
+            inventoriesUnsaved |= inventory->isDirty();
+            inventory->resetDirty();
+        }
+        if (inventoriesUnsaved) {
+            uint datasize;
+            auto data = write_inventories(inventories, datasize);
+            dst.push_back(
+                {x, z, REGION_LAYER_INVENTORIES, std::move(data), datasize}
+            );
+        }
     }
     // Writing entities
     if (!entitiesData.empty()) {
         auto data = std::make_unique<ubyte[]>(entitiesData.size());
-        for (size_t i = 0; i < entitiesData.size(); i++) {
-            data[i] = entitiesData[i];
-        }
-        put(chunk->x,
-            chunk->z,
-            REGION_LAYER_ENTITIES,
-            std::move(data),
-            entitiesData.size());
+        std::memcpy(data.get(), entitiesData.data(), entitiesData.size());
+        dst.push_back({
+            x, z, REGION_LAYER_ENTITIES, std::move(data), entitiesData.size()
+        });
     }
     // Writing blocks data
-    if (chunk->flags.blocksData) {
+    if (flags.blocksData) {
         auto bytes = chunk->blocksMetadata.serialize();
-        put(chunk->x,
-            chunk->z,
-            REGION_LAYER_BLOCKS_DATA,
-            bytes.release(),
-            bytes.size());
-    }
+        size_t size = bytes.size();
+        dst.push_back(
+            {x, z, REGION_LAYER_BLOCKS_DATA, bytes.release(), size}
+        );
+    }
+    // Writing scheduled updates
+    const auto& updates = chunk->scheduledUpdates;
+    if (flags.scheduledUpdates || (all && !updates.empty())) {
+        uint32_t datasize;
+        auto data = write_scheduled_updates(updates, datasize);
+        dst.push_back(
+            {x, z, REGION_LAYER_SCHEDULED_UPDATES, std::move(data), datasize}
+        );
+    }
+    flags.unsaved = false;
+    flags.unsavedVoxels = false;
+    flags.unsavedInventories = false;
+    flags.blocksData = false;
+    flags.scheduledUpdates = false;
+}
+
+RegionsSnapshot WorldRegions::createSnapshot() {
+    return RegionsSnapshot {putSequence++, {}};
 }
 
 bool WorldRegions::getVoxels(int x, int z, ubyte* dst) {
-    uint32_t size;
-    uint32_t srcSize;
-    auto& layer = layers[REGION_LAYER_VOXELS];
-    auto* data = layer.getData(x, z, size, srcSize);
-    if (data == nullptr) {
-        return false;
+    if (!remapTables.empty()) {
+        int regionX, regionZ, localX, localZ;
+        calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
+        applyRemap(regionX, regionZ);
     }
-    assert(srcSize == CHUNK_DATA_LEN);
-    compression::decompress({data, size}, dst, CHUNK_DATA_LEN, layer.compression);
-    return true;
+    auto& layer = layers[REGION_LAYER_VOXELS];
+    return layer.readData(
+        x, z, [&layer, dst](const ubyte* data, uint32_t size, uint32_t srcSize) {
+            assert(srcSize == CHUNK_DATA_LEN);
+            compression::decompress(
+                {data, size}, dst, CHUNK_DATA_LEN, layer.compression
+            );
+        }
+    );
+}
+
+bool WorldRegions::hasVoxels(int x, int z) {
+    return layers[REGION_LAYER_VOXELS].readData(
+        x, z, [](const ubyte*, uint32_t, uint32_t) {}
+    );
 }
 
 bool WorldRegions::getLights(int x, int z, ubyte* dst) {
-    uint32_t size;
-    uint32_t srcSize;
     auto& layer = layers[REGION_LAYER_LIGHTS];
-    auto* bytes = layer.getData(x, z, size, srcSize);
-    if (bytes == nullptr) {
-        return false;
-    }
-    compression::decompress({bytes, size}, dst, srcSize, layer.compression);
-    return true;
+    return layer.readData(
+        x, z, [&layer, dst](const ubyte* bytes, uint32_t size, uint32_t srcSize) {
+            compression::decompress(
+                {bytes, size}, dst, srcSize, layer.compression
+            );
+        }
+    );
+}
+
+std::unique_ptr<ubyte[]> WorldRegions::getPrototype(
+    int x, int z, uint32_t& size
+) {
+    auto& layer = layers[REGION_LAYER_PROTOTYPES];
+    std::unique_ptr<ubyte[]> data;
+    layer.readData(
+        x, z, [&](const ubyte* bytes, uint32_t bytesSize, uint32_t srcSize) {
+            data = compression::decompress(
+                bytes, bytesSize, srcSize, layer.compression
+            );
+            size = srcSize;
+        }
+    );
+    return data;
 }
 
 ChunkInventoriesMap WorldRegions::fetchInventories(int x, int z) {
-    uint32_t bytesSize;
-    uint32_t srcSize;
-    auto bytes = layers[REGION_LAYER_INVENTORIES].getData(x, z, bytesSize, srcSize);
-    if (bytes == nullptr) {
-        return {};
-    }
-    return load_inventories(bytes, bytesSize);
+    ChunkInventoriesMap inventories;
+    layers[REGION_LAYER_INVENTORIES].readData(
+        x, z, [&inventories](const ubyte* bytes, uint32_t bytesSize, uint32_t) {
+            inventories = load_inventories(bytes, bytesSize);
+        }
+    );
+    return inventories;
 }
 
 BlocksMetadata WorldRegions::getBlocksData(int x, int z) {
-    uint32_t bytesSize;
-    uint32_t srcSize;
-    auto bytes = layers[REGION_LAYER_BLOCKS_DATA].getData(x, z, bytesSize, srcSize);
-    if (bytes == nullptr) {
-        return {};
-    }
     BlocksMetadata heap;
-    heap.deserialize(bytes, bytesSize);
+    layers[REGION_LAYER_BLOCKS_DATA].readData(
+        x, z, [&heap](const ubyte* bytes, uint32_t bytesSize, uint32_t) {
+            heap.deserialize(bytes, bytesSize);
+        }
+    );
     return heap;
 }
 
+std::vector<ScheduledUpdate> WorldRegions::getScheduledUpdates(int x, int z) {
+    std::vector<ScheduledUpdate> updates;
+    layers[REGION_LAYER_SCHEDULED_UPDATES].readData(
+        x, z, [&updates](const ubyte* bytes, uint32_t bytesSize, uint32_t) {
+            ByteReader reader(bytes, bytesSize);
+            updates.resize(reader.getInt32());
+            for (auto& update : updates) {
+                update.index = reader.getInt32();
+                update.tick = reader.getInt64();
+            }
+        }
+    );
+    return updates;
+}
+
 void WorldRegions::processInventories(int x, int z, const InventoryProc& func) {
     processRegion(x, z, REGION_LAYER_INVENTORIES,
     [=](std::unique_ptr<ubyte[]> data, uint32_t* size) {
@@ -279,10 +481,6 @@ void WorldRegions::processBlocksData(int x, int z, const BlockDataProc& func) {
     if (voxLayer.getRegion(x, z) || datLayer.getRegion(x, z)) {
         throw std::runtime_error("not implemented for in-memory regions");
     }
-    auto datRegfile = datLayer.getRegFile({x, z});
-    if (datRegfile == nullptr) {
-        throw std::runtime_error("could not open region file");
-    }
     auto voxRegfile = voxLayer.getRegFile({x, z});
     if (voxRegfile == nullptr) {
         logger.warning() << "missing voxels region - discard blocks data for "
@@ -290,64 +488,59 @@ void WorldRegions::processBlocksData(int x, int z, const BlockDataProc& func) {
         deleteRegion(REGION_LAYER_BLOCKS_DATA, x, z);
         return;
     }
-    for (uint cz = 0; cz < REGION_SIZE; cz++) {
-        for (uint cx = 0; cx < REGION_SIZE; cx++) {
-            int gx = cx + x * REGION_SIZE;
-            int gz = cz + z * REGION_SIZE;
-
-            uint32_t datLength;
-            uint32_t datSrcSize;
-            auto datData = RegionsLayer::readChunkData(
-                gx, gz, datLength, datSrcSize, datRegfile.get()
-            );
-            if (datData == nullptr) {
-                continue;
-            }
-            uint32_t voxLength;
-            uint32_t voxSrcSize;
-            auto voxData = RegionsLayer::readChunkData(
-                gx, gz, voxLength, voxSrcSize, voxRegfile.get()
-            );
-            if (voxData == nullptr) {
-                logger.warning()
-                    << "missing voxels for chunk (" << gx << ", " << gz << ")";
-                put(gx, gz, REGION_LAYER_BLOCKS_DATA, nullptr, 0);
-                continue;
-            }
-            voxData = compression::decompress(
-                voxData.get(), voxLength, voxSrcSize, voxLayer.compression
-            );
+    datLayer.rewriteRegion(x, z, [&](
+        int gx, int gz, std::unique_ptr<ubyte[]> datData, uint32_t* datLength
+    ) -> std::unique_ptr<ubyte[]> {
+        uint32_t voxSrcSize;
+        auto voxData = voxLayer.readChunkSource(
+            gx, gz, voxSrcSize, voxRegfile.get()
+        );
+        if (voxData == nullptr) {
+            logger.warning()
+                << "missing voxels for chunk (" << gx << ", " << gz << ")";
+            *datLength = 0;
+            return nullptr;
+        }
 
-            BlocksMetadata blocksData;
-            blocksData.deserialize(datData.get(), datLength);
-            try {
-                func(&blocksData, std::move(voxData));
-            } catch (const std::exception& err) {
-                logger.error() << "an error ocurred while processing blocks "
-                    "data in chunk (" << gx << ", " << gz << "): " << err.what();
-                blocksData = {};
-            }
-            auto bytes = blocksData.serialize();
-            put(gx, gz, REGION_LAYER_BLOCKS_DATA, bytes.release(), bytes.size());
+        BlocksMetadata blocksData;
+        blocksData.deserialize(datData.get(), *datLength);
+        try {
+            func(&blocksData, std::move(voxData));
+        } catch (const std::exception& err) {
+            logger.error() << "an error ocurred while processing blocks "
+                "data in chunk (" << gx << ", " << gz << "): " << err.what();
+            blocksData = {};
         }
-    }
+        auto bytes = blocksData.serialize();
+        *datLength = bytes.size();
+        return bytes.release();
+    });
 }
 
-dv::value WorldRegions::fetchEntities(int x, int z) {
+std::shared_ptr<entities_index::Index> WorldRegions::fetchEntities(
+    int x, int z
+) {
     if (generatorTestMode) {
         return nullptr;
     }
-    uint32_t bytesSize;
-    uint32_t srcSize;
-    const ubyte* data = layers[REGION_LAYER_ENTITIES].getData(x, z, bytesSize, srcSize);
-    if (data == nullptr) {
-        return nullptr;
-    }
-    auto map = json::from_binary(data, bytesSize);
-    if (map.empty()) {
-        return nullptr;
-    }
-    return map;
+    std::shared_ptr<entities_index::Index> index;
+    layers[REGION_LAYER_ENTITIES].readData(
+        x, z, [&index](const ubyte* data, uint32_t bytesSize, uint32_t) {
+            if (entities_index::is_indexed(data, bytesSize)) {
+                index = std::make_shared<entities_index::Index>(
+                    entities_index::read(data, bytesSize)
+                );
+                return;
+            }
+            auto map = json::from_binary(data, bytesSize);
+            if (!map.empty()) {
+                index = std::make_shared<entities_index::Index>(
+                    entities_index::from_legacy(map)
+                );
+            }
+        }
+    );
+    return index;
 }
 
 void WorldRegions::processRegion(
@@ -357,33 +550,76 @@ void WorldRegions::processRegion(
     if (layer.getRegion(x, z)) {
         throw std::runtime_error("not implemented for in-memory regions");
     }
-    auto regfile = layer.getRegFile({x, z});
-    if (regfile == nullptr) {
-        throw std::runtime_error("could not open region file");
-    }
-    for (uint cz = 0; cz < REGION_SIZE; cz++) {
-        for (uint cx = 0; cx < REGION_SIZE; cx++) {
-            int gx = cx + x * REGION_SIZE;
-            int gz = cz + z * REGION_SIZE;
-            uint32_t length;
-            uint32_t srcSize;
-            auto data =
-                RegionsLayer::readChunkData(gx, gz, length, srcSize, regfile.get());
-            if (data == nullptr) {
-                continue;
-            }
-            if (layer.compression != compression::Method::NONE) {
-                data = compression::decompress(
-                    data.get(), length, srcSize, layer.compression
-                );
-            } else {
-                srcSize = length;
-            }
-            if (auto writeData = func(std::move(data), &srcSize)) {
-                put(gx, gz, layerid, std::move(writeData), srcSize);
-            }
+    layer.rewriteRegion(
+        x, z, [&func](int, int, std::unique_ptr<ubyte[]> data, uint32_t* size) {
+            return func(std::move(data), size);
+        }
+    );
+}
+
+void WorldRegions::setMappedFiles(bool flag) {
+    for (auto& layer : layers) {
+        layer.mappedFiles = flag;
+    }
+}
+
+void WorldRegions::setMaxOpenFiles(uint count) {
+    for (auto& layer : layers) {
+        layer.setMaxOpenFiles(count);
+    }
+}
+
+void WorldRegions::setMemoryBudget(size_t bytes) {
+    for (auto& layer : layers) {
+        layer.memoryBudget = bytes;
+    }
+}
+
+size_t WorldRegions::getMemoryUsage(RegionLayerIndex layerid) {
+    return layers[layerid].getMemoryUsage();
+}
+
+size_t WorldRegions::getMemoryUsage() {
+    size_t usage = 0;
+    for (auto& layer : layers) {
+        usage += layer.getMemoryUsage();
+    }
+    return usage;
+}
+
+size_t WorldRegions::evict(size_t bytes) {
+    size_t released = 0;
+    for (auto& layer : layers) {
+        if (released >= bytes) {
+            break;
         }
+        size_t usage = layer.getMemoryUsage();
+        size_t left = bytes - released;
+        released += layer.evict(usage > left ? usage - left : 0);
     }
+    return released;
+}
+
+void WorldRegions::setCompression(
+    RegionLayerIndex layerid, compression::Method method
+) {
+    auto& layer = layers[layerid];
+    if (layer.compression == method) {
+        return;
+    }
+    std::lock_guard lock(layer.mapMutex);
+    if (!layer.regions.empty()) {
+        throw std::runtime_error(
+            "could not change compression of layer with loaded regions"
+        );
+    }
+    layer.compression = method;
+}
+
+compression::Method WorldRegions::getCompression(
+    RegionLayerIndex layerid
+) const {
+    return layers[layerid].compression;
 }
 
 const io::path& WorldRegions::getRegionsFolder(RegionLayerIndex layerid) const {
@@ -395,13 +631,215 @@ io::path WorldRegions::getRegionFilePath(RegionLayerIndex layerid, int x, int z)
 }
 
 void WorldRegions::writeAll() {
+    waitSaving();
+    std::unordered_map<glm::ivec2, size_t> pending;
+    {
+        std::lock_guard lock(remapMutex);
+        pending = remapPending;
+    }
     for (auto& layer : layers) {
         io::create_directories(layer.folder);
         layer.writeAll();
     }
+    writeRemap(pending);
+}
+
+void WorldRegions::writeAllAsync(RegionsSnapshot snapshot) {
+    waitSaving();
+    for (auto& layer : layers) {
+        io::create_directories(layer.folder);
+    }
+    saveThread = std::thread([this, snapshot = std::move(snapshot)]() mutable {
+        try {
+            // regions converted after this point are written next time
+            std::unordered_map<glm::ivec2, size_t> pending;
+            {
+                std::lock_guard lock(remapMutex);
+                pending = remapPending;
+            }
+            for (auto& entry : snapshot.entries) {
+                put(entry.x,
+                    entry.z,
+                    entry.layer,
+                    std::move(entry.data),
+                    entry.size,
+                    snapshot.sequence);
+            }
+            snapshot.entries.clear();
+            for (auto& layer : layers) {
+                layer.writeAll();
+            }
+            writeRemap(pending);
+            logger.info() << "background saving finished";
+        } catch (const std::exception& err) {
+            logger.error() << "background saving failed: " << err.what();
+        }
+    });
+}
+
+void WorldRegions::waitSaving() {
+    if (saveThread.joinable()) {
+        saveThread.join();
+    }
+}
+
+io::path WorldRegions::getRemapFile() const {
+    return directory / "remap.json";
+}
+
+void WorldRegions::readRemap() {
+    io::path file = getRemapFile();
+    if (!io::is_regular_file(file)) {
+        return;
+    }
+    auto root = io::read_json(file);
+    const auto& tables = root["tables"];
+    for (size_t i = 0; i < tables.size(); i++) {
+        const auto& list = tables[i];
+        auto& table = remapTables.emplace_back(list.size());
+        for (size_t j = 0; j < list.size(); j++) {
+            table[j] = list[j].asInteger();
+        }
+    }
+    const auto& regions = root["regions"];
+    for (size_t i = 0; i < regions.size(); i++) {
+        const auto& entry = regions[i];
+        size_t index = entry[2].asInteger();
+        if (index >= remapTables.size()) {
+            logger.error() << "invalid remap table index " << index;
+            continue;
+        }
+        glm::ivec2 coord(entry[0].asInteger(), entry[1].asInteger());
+        remapPending[coord] = index;
+    }
+    logger.info() << remapPending.size() << " regions are pending conversion";
+}
+
+void WorldRegions::writeRemap(
+    const std::unordered_map<glm::ivec2, size_t>& pending
+) {
+    if (remapTables.empty()) {
+        return;
+    }
+    io::path file = getRemapFile();
+    if (pending.empty()) {
+        if (io::exists(file)) {
+            io::remove(file);
+            logger.info() << "world conversion finished";
+        }
+        return;
+    }
+    dv::value root = dv::object();
+    auto& tables = root.list("tables");
+    for (const auto& table : remapTables) {
+        auto& list = tables.list();
+        for (blockid_t id : table) {
+            list.add(id);
+        }
+    }
+    auto& regions = root.list("regions");
+    for (const auto& [coord, index] : pending) {
+        auto& entry = regions.list();
+        entry.add(coord.x);
+        entry.add(coord.y);
+        entry.add(index);
+    }
+    io::write_json(file, root, false);
+}
+
+void WorldRegions::applyRemap(int x, int z) {
+    size_t index;
+    {
+        std::lock_guard lock(remapMutex);
+        auto found = remapPending.find({x, z});
+        if (found == remapPending.end()) {
+            return;
+        }
+        index = found->second;
+    }
+    const auto& table = remapTables[index];
+    layers[REGION_LAYER_VOXELS].transformRegion(
+        x, z, [&table](ubyte* data, uint32_t size) {
+            assert(size == CHUNK_DATA_LEN);
+            Chunk::convert(data, table.data(), table.size());
+        }
+    );
+    // removed after conversion as snapshot saving may list it meanwhile
+    std::lock_guard lock(remapMutex);
+    remapPending.erase({x, z});
+}
+
+void WorldRegions::remapBlocks(std::vector<blockid_t> table) {
+    waitSaving();
+    std::lock_guard lock(remapMutex);
+    // still pending regions are converted with both tables at once
+    for (auto& prevTable : remapTables) {
+        for (auto& id : prevTable) {
+            if (id < table.size()) {
+                id = table[id];
+            }
+        }
+    }
+    size_t index = remapTables.size();
+    remapTables.push_back(std::move(table));
+
+    const auto& folder = layers[REGION_LAYER_VOXELS].folder;
+    if (io::is_directory(folder)) {
+        for (const auto& file : io::directory_iterator(folder)) {
+            int x, z;
+            if (!parseRegionFilename(file.stem(), x, z)) {
+                continue;
+            }
+            remapPending.try_emplace({x, z}, index);
+        }
+    }
+    logger.info() << remapPending.size() << " regions are pending conversion";
+    writeRemap(remapPending);
+}
+
+size_t WorldRegions::convertPendingRegions(size_t count) {
+    std::vector<glm::ivec2> coords;
+    {
+        std::lock_guard lock(remapMutex);
+        for (const auto& [coord, _] : remapPending) {
+            if (coords.size() == count) {
+                break;
+            }
+            coords.push_back(coord);
+        }
+    }
+    for (const auto& coord : coords) {
+        applyRemap(coord.x, coord.y);
+    }
+    std::lock_guard lock(remapMutex);
+    return remapPending.size();
+}
+
+void WorldRegions::finishRemap() {
+    waitSaving();
+    auto& layer = layers[REGION_LAYER_VOXELS];
+    while (!remapPending.empty()) {
+        glm::ivec2 coord = remapPending.begin()->first;
+        applyRemap(coord.x, coord.y);
+        layer.writeRegion(coord.x, coord.y, layer.getRegion(coord.x, coord.y));
+        {
+            std::lock_guard lock(layer.mapMutex);
+            layer.regions.erase(coord);
+        }
+        writeRemap(remapPending);
+    }
+}
+
+int64_t WorldRegions::compactRegion(RegionLayerIndex layerid, int x, int z) {
+    auto& layer = layers[layerid];
+    if (layer.getRegion(x, z)) {
+        throw std::runtime_error("not implemented for in-memory regions");
+    }
+    return layer.compactRegion(x, z);
 }
 
 void WorldRegions::deleteRegion(RegionLayerIndex layerid, int x, int z) {
+    waitSaving();
     auto& layer = layers[layerid];
     if (layer.getRegFile({x, z}, false)) {
         throw std::runtime_error("region file is currently in use");
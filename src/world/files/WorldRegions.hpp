@@ -1,30 +1,61 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <bitset>
 #include <condition_variable>
 #include <functional>
 #include <glm/glm.hpp>
+#include <list>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "coders/compression.hpp"
 #include "io/io.hpp"
+#include "io/mapped_file.hpp"
 #include "maths/voxmaths.hpp"
 #include "typedefs.hpp"
 #include "util/BufferPool.hpp"
+#include "util/observer_handler.hpp"
 #include "voxels/Chunk.hpp"
 #include "world_regions_fwd.hpp"
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 
+namespace util {
+    template <class T, class R>
+    class ThreadPool;
+}
+
+namespace entities_index {
+    class Index;
+}
+
 inline constexpr uint REGION_HEADER_SIZE = 10;
+/// @brief Live chunk records bytes, table checksum and magic number
+/// stored after the offsets table (since version 5, version 4 has live
+/// chunk records bytes only)
+inline constexpr uint REGION_FOOTER_SIZE = 12;
+/// @brief Region files smaller than this are not compacted on save
+inline constexpr size_t REGION_COMPACTION_MIN_SIZE = 64 * 1024;
 
 inline constexpr uint REGION_SIZE_BIT = 5;
 inline constexpr uint REGION_SIZE = (1 << (REGION_SIZE_BIT));
 inline constexpr uint REGION_CHUNKS_COUNT = ((REGION_SIZE) * (REGION_SIZE));
 
+/// @brief Region files chunk records I/O counters of all worlds since
+/// the engine start
+struct RegionsIOStats {
+    uint64_t readChunks = 0;
+    uint64_t readBytes = 0;
+    uint64_t writtenChunks = 0;
+    uint64_t writtenBytes = 0;
+};
+
 class illegal_region_format : public std::runtime_error {
 public:
     illegal_region_format(const std::string& message)
@@ -35,52 +66,201 @@ public:
 class WorldRegion {
     std::unique_ptr<std::unique_ptr<ubyte[]>[]> chunksData;
     std::unique_ptr<glm::u32vec2[]> sizes;
+    /// @brief Sequence numbers of the last ordered puts
+    std::unique_ptr<uint64_t[]> sequences;
+    /// @brief Chunks changed since the region was written
+    std::bitset<REGION_CHUNKS_COUNT> dirty;
+    /// @brief Stored chunks data bytes
+    size_t memoryUsage = 0;
+    /// @brief Layer use counter value at the last access (LRU order)
+    uint64_t lastUse = 0;
     bool unsaved = false;
 public:
     WorldRegion();
     ~WorldRegion();
 
-    void put(uint x, uint z, std::unique_ptr<ubyte[]> data, uint32_t size, uint32_t srcSize);
+    /// @param sequence put order number: data older than already stored
+    /// one is ignored. 0 is unordered (always stored)
+    /// @return false if data is ignored
+    bool put(
+        uint x,
+        uint z,
+        std::unique_ptr<ubyte[]> data,
+        uint32_t size,
+        uint32_t srcSize,
+        uint64_t sequence = 0
+    );
     ubyte* getChunkData(uint x, uint z);
     glm::u32vec2 getChunkDataSize(uint x, uint z);
 
     void setUnsaved(bool unsaved);
     bool isUnsaved() const;
 
+    /// @brief Mark chunk data changed, so it's written on the next save
+    void setChunkDirty(uint x, uint z);
+    bool isChunkDirty(uint index) const;
+    void clearDirty();
+
+    size_t getMemoryUsage() const {
+        return memoryUsage;
+    }
+
+    void touch(uint64_t counter) {
+        lastUse = counter;
+    }
+
+    uint64_t getLastUse() const {
+        return lastUse;
+    }
+
     std::unique_ptr<ubyte[]>* getChunks() const;
     glm::u32vec2* getSizes() const;
 };
 
+/// @brief Region file written chunk by chunk, so written data is not
+/// kept in memory. Offsets table is written on finish
+class RegionFileWriter {
+    io::path filename;
+    std::unique_ptr<std::ostream> file;
+    size_t offset;
+    uint version;
+    std::array<uint32_t, REGION_CHUNKS_COUNT> offsets {};
+public:
+    /// @param filename destination file (usually temporary one)
+    /// @param compression chunks data compression method
+    /// @param version region format version stored in the header
+    RegionFileWriter(
+        io::path filename,
+        compression::Method compression,
+        uint version = REGION_FORMAT_VERSION
+    );
+    ~RegionFileWriter();
+
+    /// @param index chunk index in region
+    /// @param data compressed chunk data
+    /// @param size compressed chunk data length
+    /// @param srcSize source chunk data length
+    void write(uint index, const ubyte* data, uint32_t size, uint32_t srcSize);
+
+    /// @brief Write offsets table and close file
+    /// @throws std::runtime_error - file writing failed
+    void finish();
+};
+
 struct regfile {
-    io::rafile file;
+    /// @brief File stream (nullptr if mapped)
+    std::unique_ptr<io::rafile> file;
+    /// @brief File memory mapping (nullptr if not mapped)
+    std::unique_ptr<io::mapped_file> mapping;
     io::path filename;
     int version;
-    bool inUse = false;
+    /// @brief Chunks data compression method stored in the region header
+    compression::Method compression;
+    /// @brief Number of region file pointers in use (shard mutex guarded)
+    int users = 0;
+    /// @brief File is going to be closed, so it's not given to new users
+    /// (shard mutex guarded)
+    bool closing = false;
     std::array<uint32_t, REGION_CHUNKS_COUNT> offsets;
-
-    regfile(io::path filename);
+    /// @brief Offsets table position
+    size_t tableOffset;
+    /// @brief Live chunk records bytes, so replaced ones are
+    /// garbage (0 before version 4)
+    uint32_t usedBytes = 0;
+    /// @brief The last offsets table is corrupted (interrupted append),
+    /// so the previous one is used
+    bool recovered = false;
+
+    /// @param mapped map file to memory if possible
+    regfile(io::path filename, bool mapped = false);
     regfile(const regfile&) = delete;
 
+    size_t length() const;
+
+    /// @return chunk record size including the sizes prefix
+    /// or 0 if chunk is not present
+    uint32_t recordSize(int index);
+
     std::unique_ptr<ubyte[]> read(int index, uint32_t& size, uint32_t& srcSize);
+
+    /// @brief Get chunk data without copying. Valid until the file is closed
+    /// (while it's in use)
+    /// @return nullptr if file is not mapped or chunk is not present
+    const ubyte* view(int index, uint32_t& size, uint32_t& srcSize);
+private:
+    /// @brief Stream position mutex (not used for mapped files)
+    std::mutex streamMutex;
+
+    /// @brief Read bytes at the offset. Safe to call from multiple threads
+    void readAt(size_t offset, void* dst, size_t size);
+
+    /// @brief Get chunk data location
+    /// @return chunk data offset or 0 if chunk is not present
+    size_t locate(int index, uint32_t& size, uint32_t& srcSize);
+
+    /// @brief Find the last valid offsets table (version 5+)
+    /// @return table offset
+    /// @throws std::runtime_error - no valid table found
+    size_t findValidTable();
 };
 
 using RegionsMap = std::unordered_map<glm::ivec2, std::unique_ptr<WorldRegion>>;
 using RegionProc = std::function<std::unique_ptr<ubyte[]>(std::unique_ptr<ubyte[]>,uint32_t*)>;
+/// @brief Region chunk processing callback (chunk x, chunk z, data, size).
+/// Returns nullptr to keep chunk unchanged, nullptr with zero size to
+/// remove the chunk
+using RegionChunkProc = std::function<std::unique_ptr<ubyte[]>(
+    int, int, std::unique_ptr<ubyte[]>, uint32_t*
+)>;
 using InventoryProc = std::function<void(Inventory*)>;
+/// @brief Chunk data callback (data, size, source size)
+using ChunkDataProc =
+    std::function<void(const ubyte*, uint32_t, uint32_t)>;
 using BlockDataProc = std::function<void(BlocksMetadata*, std::unique_ptr<ubyte[]>)>;
 
-/// @brief Region file pointer keeping inUse flag on until destroyed
+/// @brief Part of a layer open region files with own lock and LRU order,
+/// so threads reading different regions rarely wait for each other
+struct RegionFilesShard {
+    struct Entry {
+        std::unique_ptr<regfile> file;
+        /// @brief Position in the lru list
+        std::list<glm::ivec2>::iterator position;
+    };
+    std::unordered_map<glm::ivec2, Entry> files;
+    /// @brief Region coords from most to least recently used
+    std::list<glm::ivec2> lru;
+    /// @brief Max open files not in use. Limit is exceeded instead of
+    /// waiting when all files are in use
+    size_t capacity = MAX_OPEN_REGION_FILES / REGION_FILES_SHARDS;
+
+    std::mutex mutex;
+    /// @brief Notified when a closing region file gets out of use
+    std::condition_variable cv;
+
+    /// @brief Close least recently used files not in use until capacity
+    /// is not exceeded. Mutex must be locked
+    void evict();
+
+    /// @brief Close the file. Mutex must be locked, file must not be used
+    void close(glm::ivec2 coord);
+
+    /// @brief Release region file user. Mutex must be locked
+    void release(regfile* file);
+};
+
+/// @brief Region file pointer keeping the file open until destroyed.
+/// Region file may be used by multiple threads at once
 class regfile_ptr {
     regfile* file;
-    std::condition_variable* cv;
+    RegionFilesShard* shard;
 public:
-    regfile_ptr(regfile* file, std::condition_variable* cv)
-        : file(file), cv(cv) {
+    regfile_ptr(regfile* file, RegionFilesShard* shard)
+        : file(file), shard(shard) {
     }
 
     regfile_ptr(const regfile_ptr&) = delete;
 
-    regfile_ptr(std::nullptr_t) : file(nullptr), cv(nullptr) {
+    regfile_ptr(std::nullptr_t) : file(nullptr), shard(nullptr) {
     }
 
     bool operator==(std::nullptr_t) const {
@@ -100,8 +280,14 @@ public:
     }
     void reset() {
         if (file) {
-            file->inUse = false;
-            cv->notify_one();
+            std::lock_guard lock(shard->mutex);
+            resetLocked();
+        }
+    }
+    /// @brief Reset with shard mutex already locked by caller
+    void resetLocked() {
+        if (file) {
+            shard->release(file);
             file = nullptr;
         }
     }
@@ -125,23 +311,43 @@ struct RegionsLayer {
 
     compression::Method compression = compression::Method::NONE;
 
+    /// @brief Map region files to memory instead of reading via streams
+    bool mappedFiles = false;
+
     /// @brief In-memory regions data
     RegionsMap regions;
 
+    /// @brief Max memory of saved regions chunks data. Least recently used
+    /// saved regions are evicted after writing
+    size_t memoryBudget = SIZE_MAX;
+
+    /// @brief Regions access counter (dataMutex guarded)
+    uint64_t useCounter = 0;
+
     /// @brief In-memory regions map mutex
     std::mutex mapMutex;
 
-    /// @brief Open region files map
-    std::unordered_map<glm::ivec2, std::unique_ptr<regfile>> openRegFiles;
+    /// @brief In-memory regions chunks data mutex. Must not be locked
+    /// while holding a region file. In-memory regions are accessed with
+    /// this mutex locked only, as they may be evicted
+    std::mutex dataMutex;
+
+    /// @brief Open region files split by region coords
+    std::array<RegionFilesShard, REGION_FILES_SHARDS> regFiles;
 
-    /// @brief Open region files map mutex
-    std::mutex regFilesMutex;
-    std::condition_variable regFilesCv;
+    RegionFilesShard& getRegFilesShard(glm::ivec2 coord);
 
+    /// @brief Get region file, opening it if not open yet. Waits only
+    /// while the file is being replaced
+    /// @param create open the file if it's not open
+    /// @return nullptr if region file does not exist (or is not open)
     [[nodiscard]] regfile_ptr getRegFile(glm::ivec2 coord, bool create = true);
-    [[nodiscard]] regfile_ptr useRegFile(glm::ivec2 coord);
-    regfile_ptr createRegFile(glm::ivec2 coord);
-    void closeRegFile(glm::ivec2 coord);
+
+    /// @brief Set max open region files of the layer not in use
+    void setMaxOpenFiles(uint count);
+
+    /// @return number of open region files
+    size_t countOpenFiles();
 
     WorldRegion* getRegion(int x, int z);
     WorldRegion* getOrCreateRegion(int x, int z);
@@ -149,6 +355,8 @@ struct RegionsLayer {
     io::path getRegionFilePath(int x, int z) const;
 
     /// @brief Get chunk data. Read from file if not loaded yet.
+    /// @attention data may be freed by evict or put, use readData when
+    /// the layer is written or modified by other threads
     /// @param x chunk x coord
     /// @param z chunk z coord
     /// @param size [out] compressed chunk data length
@@ -156,24 +364,136 @@ struct RegionsLayer {
     /// @return nullptr if no saved chunk data found
     [[nodiscard]] ubyte* getData(int x, int z, uint32_t& size, uint32_t& srcSize);
 
-    /// @brief Write or rewrite region file
+    /// @brief Get chunk data with dataMutex locked by the caller. The mutex
+    /// is unlocked while reading region file
+    [[nodiscard]] ubyte* getData(
+        int x,
+        int z,
+        uint32_t& size,
+        uint32_t& srcSize,
+        std::unique_lock<std::mutex>& lock
+    );
+
+    /// @brief Get chunk data. Read from file if not loaded yet.
+    /// Data is not freed until the callback returns
+    /// @param x chunk x coord
+    /// @param z chunk z coord
+    /// @param func callback called if saved chunk data found
+    /// @return false if no saved chunk data found
+    bool readData(int x, int z, const ChunkDataProc& func);
+
+    /// @brief Remove least recently used saved regions from memory
+    /// until memory budget is not exceeded
+    void evict() {
+        evict(memoryBudget);
+    }
+
+    /// @brief Remove least recently used saved regions from memory
+    /// until the usage fits the given budget
+    /// @return number of released bytes
+    size_t evict(size_t budget);
+
+    /// @return in-memory regions chunks data bytes
+    size_t getMemoryUsage();
+
+    /// @brief Read missing chunks data from region file to memory in
+    /// file order
+    /// @param x region X
+    /// @param z region Z
+    /// @param indices region chunks indices
+    void prefetch(int x, int z, std::vector<uint> indices);
+
+    /// @brief Write region changes. Dirty chunks are appended to the
+    /// current format region file with a new offsets table. Otherwise
+    /// or if the file has too much garbage, the whole region is written
+    /// to a temporary file first, then renamed to replace the previous
+    /// one. Chunks are laid out in Morton order
     /// @param x region X
     /// @param z region Z
     void writeRegion(int x, int y, WorldRegion* entry);
 
+    /// @brief Append dirty chunks of the region and the new offsets
+    /// table to the region file
+    /// @return false if the file must be rewritten instead
+    bool appendRegion(
+        glm::ivec2 coord, const io::path& filename, WorldRegion& region
+    );
+
+    /// @brief Move written region file to its place, closing the
+    /// previous one first
+    void replaceRegFile(glm::ivec2 coord, const io::path& file);
+
     /// @brief Write all unsaved regions to files
     void writeAll();
 
-    /// @brief Read chunk data from region file
+    /// @brief Rewrite region file with chunks laid out contiguously in
+    /// Morton order (region must not be loaded)
+    /// @param x region X
+    /// @param z region Z
+    /// @return number of reclaimed bytes
+    int64_t compactRegion(int x, int z);
+
+    /// @brief Process region chunks one by one, writing them to a
+    /// temporary file replacing the region file when done
+    /// (region must not be loaded)
+    /// @param x region X
+    /// @param z region Z
+    /// @param func processing callback
+    void rewriteRegion(int x, int z, const RegionChunkProc& func);
+
+    /// @brief Load all region chunks to memory and process their
+    /// decompressed data in place. Region is marked unsaved
+    /// @param x region X
+    /// @param z region Z
+    /// @param func processing callback (data, length)
+    void transformRegion(
+        int x, int z, const std::function<void(ubyte*, uint32_t)>& func
+    );
+
+    /// @brief Read chunk data from region file. Data is recompressed
+    /// if region file compression method differs from the layer one
     /// @param x chunk x coord
     /// @param z chunk z coord
     /// @param size [out] compressed chunk data length
     /// @param srcSize [out] source chunk data length
     /// @param rfile region file
     /// @return nullptr if chunk is not present in region file
-    [[nodiscard]] static std::unique_ptr<ubyte[]> readChunkData(
+    [[nodiscard]] std::unique_ptr<ubyte[]> readChunkData(
         int x, int z, uint32_t& size, uint32_t& srcSize, regfile* rfile
     );
+
+    /// @brief Read chunk data from region file and decompress it.
+    /// Mapped region file data is decompressed without copying
+    /// @param x chunk x coord
+    /// @param z chunk z coord
+    /// @param srcSize [out] source chunk data length
+    /// @param rfile region file
+    /// @return nullptr if chunk is not present in region file
+    [[nodiscard]] std::unique_ptr<ubyte[]> readChunkSource(
+        int x, int z, uint32_t& srcSize, regfile* rfile
+    );
+};
+
+/// @brief Uncompressed chunk layer data to be put to regions
+struct ChunkLayerData {
+    int x;
+    int z;
+    RegionLayerIndex layer;
+    std::unique_ptr<ubyte[]> data;
+    size_t size;
+};
+
+/// @brief Chunks data captured to be saved in background
+struct RegionsSnapshot {
+    /// @brief Regions put sequence number at the capture moment
+    uint64_t sequence;
+    std::vector<ChunkLayerData> entries;
+};
+
+struct RegionsPrefetchJob {
+    RegionsLayer* layer;
+    glm::ivec2 region;
+    std::vector<uint> indices;
 };
 
 class WorldRegions {
@@ -181,6 +501,43 @@ class WorldRegions {
     io::path directory;
 
     RegionsLayer layers[REGION_LAYERS_COUNT] {};
+
+    /// @brief Background region files reader (created on first use).
+    /// Must be destroyed before layers
+    std::unique_ptr<util::ThreadPool<RegionsPrefetchJob, int>> prefetchPool;
+
+    /// @brief Put order counter, so background snapshot saving never
+    /// overwrites data put after the capture
+    std::atomic<uint64_t> putSequence = 1;
+
+    /// @brief Snapshot saving thread (joinable until waitSaving call)
+    std::thread saveThread;
+
+    /// @brief Old to new block ids tables of lazily converted regions
+    std::vector<std::vector<blockid_t>> remapTables;
+    /// @brief Voxels regions not converted yet to remapTables indices
+    std::unordered_map<glm::ivec2, size_t> remapPending;
+    std::mutex remapMutex;
+
+    /// @brief Memory accounting source (see debug::memory)
+    ObserverHandler memorySource;
+
+    io::path getRemapFile() const;
+    void readRemap();
+    /// @brief Write pending regions list (or delete the file if empty).
+    /// Must be called after the regions are written
+    void writeRemap(const std::unordered_map<glm::ivec2, size_t>& pending);
+    /// @brief Convert voxels region if it's pending
+    void applyRemap(int x, int z);
+
+    void put(
+        int x,
+        int z,
+        RegionLayerIndex layer,
+        std::unique_ptr<ubyte[]> data,
+        size_t size,
+        uint64_t sequence
+    );
 public:
     bool generatorTestMode = false;
     bool doWriteLights = true;
@@ -192,6 +549,17 @@ public:
     /// @brief Put all chunk data to regions
     void put(Chunk* chunk, std::vector<ubyte> entitiesData);
 
+    /// @brief Copy chunk data to be saved without compression
+    /// (see writeAllAsync)
+    void capture(
+        Chunk* chunk,
+        std::vector<ubyte> entitiesData,
+        std::vector<ChunkLayerData>& dst
+    );
+
+    /// @brief Start new snapshot
+    RegionsSnapshot createSnapshot();
+
     /// @brief Store data in specified region
     /// @param x chunk.x
     /// @param z chunk.z
@@ -206,25 +574,68 @@ public:
         size_t size
     );
 
+    /// @brief Read saved data of the chunks in background, so next
+    /// loading of them will not wait for disk
+    /// @param chunks chunks coordinates
+    void prefetch(const std::vector<glm::ivec2>& chunks);
+
+    /// @brief Set compression method used for new region files of the
+    /// layer. Existing region files are read with their own method
+    void setCompression(RegionLayerIndex layerid, compression::Method method);
+
+    compression::Method getCompression(RegionLayerIndex layerid) const;
+
+    /// @brief Map region files opened later to memory, so chunks data is
+    /// read without syscalls and decompressed without intermediate copies
+    void setMappedFiles(bool flag);
+
+    /// @brief Set max open region files per layer kept after use
+    void setMaxOpenFiles(uint count);
+
+    /// @brief Set max memory of saved regions data kept per layer
+    void setMemoryBudget(size_t bytes);
+
+    /// @return in-memory regions chunks data bytes of the layer
+    size_t getMemoryUsage(RegionLayerIndex layerid);
+
+    /// @return in-memory regions chunks data bytes of all layers
+    size_t getMemoryUsage();
+
+    /// @brief Remove least recently used saved regions from memory
+    /// @param bytes number of bytes to release
+    /// @return number of released bytes
+    size_t evict(size_t bytes);
+
     /// @brief Get chunk voxels data
     /// @param x chunk.x
     /// @param z chunk.z
     /// @return true if data read
     bool getVoxels(int x, int z, ubyte* dst);
 
+    /// @return true if chunk voxels are saved
+    bool hasVoxels(int x, int z);
+
     /// @brief Get cached lights for chunk at x,z
     /// @return true if data read
     bool getLights(int x, int z, ubyte* dst);
     
+    /// @brief Get cached world generator prototype data
+    /// @param size [out] data size
+    /// @return nullptr if no data found
+    std::unique_ptr<ubyte[]> getPrototype(int x, int z, uint32_t& size);
+
     ChunkInventoriesMap fetchInventories(int x, int z);
 
     BlocksMetadata getBlocksData(int x, int z);
+
+    std::vector<ScheduledUpdate> getScheduledUpdates(int x, int z);
     
     /// @brief Load saved entities data for chunk
     /// @param x chunk.x
     /// @param z chunk.z
-    /// @return map with entities list as "data"
-    dv::value fetchEntities(int x, int z);
+    /// @return entities headers or nullptr if chunk has no entities.
+    /// Legacy data is converted to the index format
+    std::shared_ptr<entities_index::Index> fetchEntities(int x, int z);
 
     /// @brief Load, process and save processed region chunks data
     /// @param x region X
@@ -245,15 +656,46 @@ public:
 
     io::path getRegionFilePath(RegionLayerIndex layerid, int x, int z) const;
 
-    /// @brief Write all region layers
+    /// @brief Write all region layers. Waits for background saving
     void writeAll();
 
+    /// @brief Put snapshot data to regions and write all region layers
+    /// in background. Waits for previous background saving
+    void writeAllAsync(RegionsSnapshot snapshot);
+
+    /// @brief Wait until background saving is finished
+    void waitSaving();
+
+    /// @brief Schedule lazy conversion of all existing voxels regions
+    /// instead of converting the whole world before opening. Region is
+    /// converted on first chunk access or by convertPendingRegions.
+    /// Pending regions list is stored in the world folder
+    /// @param table old to new block ids table
+    void remapBlocks(std::vector<blockid_t> table);
+
+    /// @brief Convert not accessed yet pending regions
+    /// @param count max number of regions to convert
+    /// @return number of regions left
+    size_t convertPendingRegions(size_t count);
+
+    /// @brief Convert and write all pending regions, releasing their
+    /// memory. Must not be called while the regions are used
+    void finishRemap();
+
     void deleteRegion(RegionLayerIndex layerid, int x, int z);
 
+    /// @brief Rewrite region file with chunks laid out contiguously in
+    /// Morton order
+    /// @return number of reclaimed bytes
+    int64_t compactRegion(RegionLayerIndex layerid, int x, int z);
+
     /// @brief Extract X and Z from 'X_Z.bin' region file name.
     /// @param name source region file name
     /// @param x parsed X destination
     /// @param z parsed Z destination
     /// @return false if std::invalid_argument or std::out_of_range occurred
     static bool parseRegionFilename(const std::string& name, int& x, int& y);
+
+    /// @brief Get region files I/O counters. Thread-safe
+    static RegionsIOStats getIOStats();
 };
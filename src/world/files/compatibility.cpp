@@ -1,13 +1,16 @@
 #include "compatibility.hpp"
 
 #include <stdexcept>
+#include <vector>
 
 #include "constants.hpp"
 #include "voxels/voxel.hpp"
 #include "coders/compression.hpp"
-#include "coders/byte_utils.hpp"
+#include "io/io.hpp"
 #include "lighting/Lightmap.hpp"
+#include "util/Buffer.hpp"
 #include "util/data_io.hpp"
+#include "WorldRegions.hpp"
 
 static inline size_t VOXELS_DATA_SIZE_V1 = CHUNK_VOL * 4;
 static inline size_t VOXELS_DATA_SIZE_V2 = CHUNK_VOL * 4;
@@ -39,71 +42,64 @@ static util::Buffer<ubyte> convert_voxels_1to2(const ubyte* buffer, uint32_t siz
     return util::Buffer<ubyte>(std::move(compressed), outLen);
 }
 
-util::Buffer<ubyte> compatibility::convert_region_2to3(
-    const util::Buffer<ubyte>& src, RegionLayerIndex layer
+void compatibility::convert_region_2to3(
+    const io::path& src, const io::path& dst, RegionLayerIndex layer
 ) {
-    const size_t REGION_CHUNKS = 1024;
-    // const size_t HEADER_SIZE = 10;
-    const size_t OFFSET_TABLE_SIZE = REGION_CHUNKS * sizeof(uint32_t);
-    const ubyte COMPRESS_NONE = 0;
-    const ubyte COMPRESS_EXTRLE8 = 1;
-    const ubyte COMPRESS_EXTRLE16 = 2;
+    const size_t OFFSET_TABLE_SIZE = REGION_CHUNKS_COUNT * sizeof(uint32_t);
 
-    const ubyte* const ptr = src.data();
+    io::rafile file(src);
+    if (file.length() < OFFSET_TABLE_SIZE) {
+        throw std::runtime_error("invalid region file " + src.string());
+    }
+    uint32_t offsets[REGION_CHUNKS_COUNT];
+    file.seekg(file.length() - OFFSET_TABLE_SIZE);
+    file.read(reinterpret_cast<char*>(offsets), OFFSET_TABLE_SIZE);
 
-    ByteBuilder builder;
-    builder.putCStr(".VOXREG");
-    builder.put(3);
+    auto method = compression::Method::NONE;
     switch (layer) {
-        case REGION_LAYER_VOXELS: builder.put(COMPRESS_EXTRLE16); break;
-        case REGION_LAYER_LIGHTS: builder.put(COMPRESS_EXTRLE8); break;
-        default: builder.put(COMPRESS_NONE); break;
+        case REGION_LAYER_VOXELS: method = compression::Method::EXTRLE16; break;
+        case REGION_LAYER_LIGHTS: method = compression::Method::EXTRLE8; break;
+        default: break;
     }
+    RegionFileWriter writer(dst, method, 3);
 
-    uint32_t offsets[REGION_CHUNKS] {};
-
-    auto tablePtr = reinterpret_cast<const uint32_t*>(
-        ptr + src.size() - OFFSET_TABLE_SIZE
-    );
-
-    for (size_t i = 0; i < REGION_CHUNKS; i++) {
-        uint32_t srcOffset = dataio::be2h(tablePtr[i]);
+    // the only chunk kept in memory
+    std::vector<ubyte> buffer;
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        uint32_t srcOffset = dataio::be2h(offsets[i]);
         if (srcOffset == 0) {
             continue;
         }
-        uint32_t size = *reinterpret_cast<const uint32_t*>(ptr + srcOffset);
+        uint32_t size;
+        file.seekg(srcOffset);
+        file.read(reinterpret_cast<char*>(&size), sizeof(uint32_t));
         size = dataio::be2h(size);
 
-        const ubyte* data = ptr + srcOffset + sizeof(uint32_t);
-        offsets[i] = builder.size();
+        buffer.resize(size);
+        file.read(reinterpret_cast<char*>(buffer.data()), size);
+        const ubyte* data = buffer.data();
 
         switch (layer) {
             case REGION_LAYER_VOXELS: {
                 auto dstdata = convert_voxels_1to2(data, size);
-                builder.putInt32(dstdata.size());
-                builder.putInt32(VOXELS_DATA_SIZE_V2);
-                builder.put(dstdata.data(), dstdata.size());
+                writer.write(
+                    i, dstdata.data(), dstdata.size(), VOXELS_DATA_SIZE_V2
+                );
                 break;
             }
             case REGION_LAYER_LIGHTS:
-                builder.putInt32(size);
-                builder.putInt32(LIGHTMAP_DATA_LEN);
-                builder.put(data, size);
+                writer.write(i, data, size, LIGHTMAP_DATA_LEN);
                 break;
             case REGION_LAYER_ENTITIES:
             case REGION_LAYER_INVENTORIES:
-            case REGION_LAYER_BLOCKS_DATA: {
-                builder.putInt32(size);
-                builder.putInt32(size);
-                builder.put(data, size);
+            case REGION_LAYER_BLOCKS_DATA:
+            case REGION_LAYER_PROTOTYPES:
+            case REGION_LAYER_SCHEDULED_UPDATES:
+                writer.write(i, data, size, size);
                 break;
             case REGION_LAYERS_COUNT: 
                 throw std::invalid_argument("invalid enum");
-            }
         }
     }
-    for (size_t i = 0; i < REGION_CHUNKS; i++) {
-        builder.putInt32(offsets[i]);
-    }
-    return util::Buffer<ubyte>(builder.build().data(), builder.size());
+    writer.finish();
 }
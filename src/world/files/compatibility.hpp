@@ -1,14 +1,15 @@
 #pragma once
 
+#include "io/fwd.hpp"
 #include "typedefs.hpp"
-#include "util/Buffer.hpp"
 #include "world/files/world_regions_fwd.hpp"
 
 namespace compatibility {
-    /// @brief Convert region file from version 2 to 3
+    /// @brief Convert region file from version 2 to 3. Chunks are
+    /// converted one by one, so the source file is not read to memory
     /// @see /doc/specs/region_file_spec.md
-    /// @param src region file source content
-    /// @return new region file content
-    util::Buffer<ubyte> convert_region_2to3(
-        const util::Buffer<ubyte>& src, RegionLayerIndex layer);
+    /// @param src source region file
+    /// @param dst destination file (must not be the source one)
+    void convert_region_2to3(
+        const io::path& src, const io::path& dst, RegionLayerIndex layer);
 }
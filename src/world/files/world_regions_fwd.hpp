@@ -8,6 +8,10 @@ enum RegionLayerIndex : uint {
     REGION_LAYER_INVENTORIES,
     REGION_LAYER_ENTITIES,
     REGION_LAYER_BLOCKS_DATA,
+    /// @brief World generator prototypes cache (see PrototypesCache)
+    REGION_LAYER_PROTOTYPES,
+    /// @brief Scheduled blocks updates (see Chunk::scheduledUpdates)
+    REGION_LAYER_SCHEDULED_UPDATES,
     
     REGION_LAYERS_COUNT
 };
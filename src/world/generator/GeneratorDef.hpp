@@ -121,13 +121,24 @@ struct Biome {
     BlocksLayers seaLayers;
 };
 
-/// @brief Generator behaviour and settings interface
+/// @brief Generator behaviour and settings interface.
+///
+/// Determinism contract: results of generateParameterMaps, generateHeightmap
+/// and placeStructures must depend on arguments and the seed only, so any
+/// instance initialized with the same seed produces the same output in any
+/// calls order. Multiple instances may be used in different threads.
 class GeneratorScript {
 public:
     virtual ~GeneratorScript() = default;
 
     virtual void initialize(uint64_t seed) = 0;
 
+    /// @brief Create an independent not initialized instance of the script
+    /// sharing no mutable state with this one. Must be called in the thread
+    /// owning the script
+    /// @return new instance
+    virtual std::unique_ptr<GeneratorScript> clone() const = 0;
+
     /// @brief Generate a heightmap with values in range 0..1
     /// @param offset position of the heightmap in the world
     /// @param size size of the heightmap
@@ -229,6 +240,10 @@ struct GeneratorDef {
     std::vector<std::unique_ptr<VoxelStructure>> structures;
     std::vector<Biome> biomes;
 
+    /// @brief Hash of the generator files and the pack version, so cached
+    /// generation results are dropped when the generator is changed
+    uint64_t fingerprint = 0;
+
     GeneratorDef(std::string name);
     GeneratorDef(const GeneratorDef&) = delete;
 
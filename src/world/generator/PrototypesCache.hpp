@@ -0,0 +1,24 @@
+#pragma once
+
+#include <memory>
+
+#include "typedefs.hpp"
+
+/// @brief Persistent storage of chunk prototypes generation results
+/// depending on the chunk position and the seed only, so areas visited
+/// before are not generated again after restart or teleport.
+/// Used in the thread owning the generator script only
+class PrototypesCache {
+public:
+    virtual ~PrototypesCache() = default;
+
+    /// @brief Read chunk entry
+    /// @param size [out] entry size
+    /// @return nullptr if the chunk entry is not found
+    virtual std::unique_ptr<ubyte[]> read(int x, int z, size_t& size) = 0;
+
+    /// @brief Write or replace chunk entry
+    virtual void write(
+        int x, int z, std::unique_ptr<ubyte[]> data, size_t size
+    ) = 0;
+};
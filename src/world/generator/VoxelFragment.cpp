@@ -11,8 +11,9 @@
 #include "voxels/GlobalChunks.hpp"
 #include "voxels/VoxelsVolume.hpp"
 #include "voxels/blocks_agent.hpp"
+#include "voxels/BlocksBatch.hpp"
+#include "logic/BlocksController.hpp"
 #include "logic/LevelController.hpp"
-#include "lighting/Lighting.hpp"
 #include "world/Level.hpp"
 #include "core_defs.hpp"
 
@@ -170,16 +171,75 @@ void VoxelFragment::prepare(const Content& content) {
         voxelsRuntime[i].id = content.blocks.require(name).rt.id;
         voxelsRuntime[i].state = voxels[i].state;
     }
+    buildRuns();
+}
+
+void VoxelFragment::buildRuns() {
+    int rows = size.y * size.z;
+    runs.clear();
+    rowRuns.resize(rows + 1);
+    for (int row = 0; row < rows; row++) {
+        rowRuns[row] = runs.size();
+        const voxel* rowVoxels = voxelsRuntime.data() + row * size.x;
+        int x = 0;
+        while (x < size.x) {
+            if (rowVoxels[x].id == BLOCK_AIR) {
+                x++;
+                continue;
+            }
+            int start = x;
+            while (x < size.x && rowVoxels[x].id != BLOCK_AIR) {
+                x++;
+            }
+            runs.push_back(VoxelsRun {
+                static_cast<uint32_t>(start), static_cast<uint32_t>(x - start)
+            });
+        }
+    }
+    rowRuns[rows] = runs.size();
+}
+
+void VoxelFragment::stamp(voxel* voxels, const glm::ivec3& offset) const {
+    assert(rowRuns.size() == size.y * size.z + 1);
+
+    int xa = std::max(0, -offset.x);
+    int xb = std::min(size.x, CHUNK_W - offset.x);
+    int ya = std::max(0, -offset.y);
+    int yb = std::min(size.y, CHUNK_H - offset.y);
+    int za = std::max(0, -offset.z);
+    int zb = std::min(size.z, CHUNK_D - offset.z);
+    if (xa >= xb) {
+        return;
+    }
+    for (int y = ya; y < yb; y++) {
+        for (int z = za; z < zb; z++) {
+            int row = y * size.z + z;
+            const voxel* src = voxelsRuntime.data() + row * size.x;
+            // chunk voxels row start shifted by the fragment x offset
+            int dst = static_cast<int>(vox_index(0, y + offset.y, z + offset.z)) +
+                      offset.x;
+            for (uint32_t i = rowRuns[row]; i < rowRuns[row + 1]; i++) {
+                const auto& run = runs[i];
+                if (static_cast<int>(run.x) >= xb) {
+                    break;
+                }
+                int a = std::max(static_cast<int>(run.x), xa);
+                int b = std::min(static_cast<int>(run.x + run.length), xb);
+                if (a < b) {
+                    std::memcpy(
+                        voxels + (dst + a), src + a, (b - a) * sizeof(voxel)
+                    );
+                }
+            }
+        }
+    }
 }
 
 void VoxelFragment::place(
     LevelController& controller, const glm::ivec3& offset
 ) {
-    auto& level = *controller.getLevel();
-    auto& chunks = *level.chunks;
-    auto lighting = controller.getChunksController()->lighting.get();
-    const auto& defs = level.content.getIndices()->blocks;
     auto& structVoxels = getRuntimeVoxels();
+    BlocksBatch batch;
     for (int y = 0; y < size.y; y++) {
         int sy = y + offset.y;
         if (sy < 0 || sy >= CHUNK_H) {
@@ -192,17 +252,12 @@ void VoxelFragment::place(
                 const auto& structVoxel = 
                     structVoxels[vox_index(x, y, z, size.x, size.z)];
                 if (structVoxel.id) {
-                    blocks_agent::set(
-                        chunks, sx, sy, sz, structVoxel.id, structVoxel.state
-                    );
-                    if (lighting) {
-                        const auto& def = defs.require(structVoxel.id);
-                        lighting->onBlockSet(sx, sy, sz, def.rt.id);
-                    }
+                    batch.set(sx, sy, sz, structVoxel.id, structVoxel.state);
                 }
             }
         }
     }
+    controller.getBlocksController()->applyBatch(batch, false);
 }
 
 std::unique_ptr<VoxelFragment> VoxelFragment::rotated(const Content& content) const {
@@ -24,6 +24,18 @@ class VoxelFragment : public Serializable {
 
     /// @brief Structure voxels built on prepare(...) call
     std::vector<voxel> voxelsRuntime;
+
+    /// @brief Run of non-air runtime voxels in a fragment row
+    struct VoxelsRun {
+        uint32_t x;
+        uint32_t length;
+    };
+    /// @brief Non-air runs built on prepare(...) call listed row by row
+    std::vector<VoxelsRun> runs;
+    /// @brief Index of the first run of each (y, z) row + total runs count
+    std::vector<uint32_t> rowRuns;
+
+    void buildRuns();
 public:
     VoxelFragment() : size() {}
 
@@ -48,6 +60,13 @@ public:
     /// @param offset target location
     void place(LevelController& controller, const glm::ivec3& offset);
 
+    /// @brief Copy non-air voxels to the chunk voxels clipping by the chunk
+    /// bounds. Structure air is copied too, to be replaced with air later.
+    /// Runtime voxels must be built
+    /// @param voxels chunk voxels (CHUNK_VOL)
+    /// @param offset fragment location relative to the chunk
+    void stamp(voxel* voxels, const glm::ivec3& offset) const;
+
     /// @brief Create structure copy rotated 90 deg. clockwise
     std::unique_ptr<VoxelFragment> rotated(const Content& content) const;
 
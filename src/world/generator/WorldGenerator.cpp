@@ -4,15 +4,19 @@
 #include <algorithm>
 
 #include "maths/util.hpp"
+#include "coders/byte_utils.hpp"
 #include "content/Content.hpp"
 #include "voxels/Block.hpp"
 #include "voxels/Chunk.hpp"
 #include "GeneratorDef.hpp"
 #include "VoxelFragment.hpp"
+#include "PrototypesCache.hpp"
 #include "util/timeutil.hpp"
 #include "util/listutil.hpp"
 #include "maths/voxmaths.hpp"
 #include "maths/util.hpp"
+#include "util/ThreadPool.hpp"
+#include "util/Hasher.hpp"
 #include "debug/Logger.hpp"
 
 static debug::Logger logger("world-generator");
@@ -23,8 +27,39 @@ static inline constexpr uint MAX_PARAMETERS = 4;
 /// @brief Initial + wide_structs + biomes + heightmaps + complete
 static inline constexpr uint BASIC_PROTOTYPE_LAYERS = 5;
 
+/// @brief Radius of chunks area reaching biomes level on chunk completion
+static inline constexpr int BIOMES_RADIUS = 3;
+
+/// @brief Radius of chunks area scheduled for stages generation around
+/// a generated chunk
+static inline constexpr int STAGES_SCHEDULE_RADIUS = BIOMES_RADIUS + 2;
+
+class ChunkStagesWorker
+    : public util::Worker<ChunkStagesJob, ChunkStagesResult> {
+    const WorldGenerator& generator;
+    std::unique_ptr<GeneratorScript> script;
+public:
+    ChunkStagesWorker(
+        const WorldGenerator& generator, std::unique_ptr<GeneratorScript> script
+    )
+        : generator(generator), script(std::move(script)) {
+    }
+
+    ChunkStagesResult operator()(const ChunkStagesJob& job) override {
+        VC_PROFILE_ZONE("WorldGenerator::generateStages");
+        auto stages = std::make_shared<ChunkStages>();
+        generator.generateStages(
+            *script, *stages, job.x, job.z, ChunkPrototypeLevel::STRUCTURES
+        );
+        return ChunkStagesResult {job.x, job.z, std::move(stages)};
+    }
+};
+
 WorldGenerator::WorldGenerator(
-    const GeneratorDef& def, const Content& content, uint64_t seed
+    const GeneratorDef& def,
+    const Content& content,
+    uint64_t seed,
+    std::optional<int> stagesWorkers
 )
     : def(def), 
       content(content), 
@@ -44,6 +79,7 @@ WorldGenerator::WorldGenerator(
             return;
         }
         prototypes.erase({x, z});
+        stages.erase({x, z});
     });
     surroundMap.setLevelCallback(1, [this](int const x, int const z) {
         if (prototypes.find({x, z}) != prototypes.end()) {
@@ -72,9 +108,44 @@ WorldGenerator::WorldGenerator(
                 def.structures[i]->fragments[j-1]->rotated(content);
         }
     }
+    // placements refer to blocks by indices
+    util::Hasher hasher;
+    hasher.update(seed);
+    hasher.update(def.name);
+    hasher.update(def.fingerprint);
+    const auto& blocks = content.getIndices()->blocks;
+    for (size_t i = 0; i < blocks.count(); i++) {
+        hasher.update(blocks.get(i)->name);
+    }
+    cacheKey = hasher.get();
+
+    if (!stagesWorkers.has_value()) {
+        return;
+    }
+    stagesPool = std::make_unique<
+        util::ThreadPool<ChunkStagesJob, ChunkStagesResult>>(
+        "generator-stages-pool",
+        [this]() {
+            auto script = this->def.script->clone();
+            script->initialize(this->seed);
+            return std::make_unique<ChunkStagesWorker>(
+                *this, std::move(script)
+            );
+        },
+        [this](ChunkStagesResult&& result) {
+            installStages(std::move(result));
+        },
+        *stagesWorkers
+    );
+    stagesPool->setStopOnFail(false);
+    logger.info() << "created " << stagesPool->getWorkersCount()
+                  << " prototype stages workers";
 }
 
-WorldGenerator::~WorldGenerator() {}
+WorldGenerator::~WorldGenerator() {
+    // workers must be stopped before the generator is destroyed
+    stagesPool.reset();
+}
 
 ChunkPrototype& WorldGenerator::requirePrototype(int x, int z) {
     const auto& found = prototypes.find({x, z});
@@ -84,12 +155,89 @@ ChunkPrototype& WorldGenerator::requirePrototype(int x, int z) {
     return *found->second;
 }
 
+ChunkStages& WorldGenerator::requireStages(
+    int x, int z, ChunkPrototypeLevel level
+) {
+    auto& chunkStages = stages[{x, z}];
+    if (chunkStages == nullptr) {
+        chunkStages = std::make_shared<ChunkStages>();
+    }
+    if (chunkStages->level < level) {
+        generateStages(*def.script, *chunkStages, x, z, level);
+    }
+    return *chunkStages;
+}
+
+void WorldGenerator::scheduleStages(int centerX, int centerZ) {
+    if (stagesPool == nullptr) {
+        return;
+    }
+    stagesPool->pullResults();
+
+    const auto& area = surroundMap.getArea();
+    int radius = STAGES_SCHEDULE_RADIUS;
+    for (int dz = -radius; dz <= radius; dz++) {
+        for (int dx = -radius; dx <= radius; dx++) {
+            glm::ivec2 pos(centerX + dx, centerZ + dz);
+            if (!area.isInside(pos.x, pos.y) ||
+                stagesRequested.find(pos) != stagesRequested.end() ||
+                stages.find(pos) != stages.end()) {
+                continue;
+            }
+            const auto& found = prototypes.find(pos);
+            if (found != prototypes.end() &&
+                found->second->level >= ChunkPrototypeLevel::BIOMES) {
+                continue;
+            }
+            stagesRequested.insert(pos);
+            // nearest chunks are required first
+            stagesPool->enqueueJob(
+                ChunkStagesJob {pos.x, pos.y}, -(dx * dx + dz * dz)
+            );
+        }
+    }
+}
+
+void WorldGenerator::installStages(ChunkStagesResult&& result) {
+    glm::ivec2 pos(result.x, result.z);
+    stagesRequested.erase(pos);
+    if (!surroundMap.getArea().isInside(pos.x, pos.y)) {
+        return;
+    }
+    const auto& found = prototypes.find(pos);
+    if (found != prototypes.end() &&
+        found->second->level >= ChunkPrototypeLevel::STRUCTURES) {
+        return;
+    }
+    // stages generated in the main thread meanwhile are replaced too, as
+    // the results are equal by the generator script determinism contract
+    auto& chunkStages = stages[pos];
+    if (chunkStages == nullptr || chunkStages->level < result.stages->level) {
+        chunkStages = std::move(result.stages);
+    }
+}
+
+/// @brief Vertical run [bottom, top) of a layer block in a column
+struct LandSpan {
+    int bottom;
+    int top;
+    blockid_t id;
+};
+
+/// @brief Column block change at y (see WorldGenerator::generateLand)
+struct LandChange {
+    int y;
+    uint column;
+    blockid_t id;
+};
+
+/// @brief Append spans of a column filled with the layers from top to
+/// bottom. Later spans overwrite earlier ones
 static inline void generate_pole(
     const BlocksLayers& layers,
     int top, int bottom,
     int seaLevel,
-    voxel* voxels,
-    int x, int z
+    std::vector<LandSpan>& spans
 ) {
     uint y = std::min<uint>(top, CHUNK_H - 1);
     uint layerExtension = 0;
@@ -110,8 +258,12 @@ static inline void generate_pole(
             static_cast<uint>(layerHeight), std::min<uint>(CHUNK_H - 1, y + 1)
         );
 
-        for (uint i = 0; i < layerHeight; i++, y--) {
-            voxels[vox_index(x, y, z)].id = layer.rt.id;
+        if (layerHeight > 0) {
+            spans.push_back(LandSpan {
+                static_cast<int>(y + 1 - layerHeight),
+                static_cast<int>(y + 1),
+                layer.rt.id});
+            y -= layerHeight;
         }
         layerExtension = 0;
     }
@@ -147,7 +299,160 @@ static inline const Biome* choose_biome(
 std::unique_ptr<ChunkPrototype> WorldGenerator::generatePrototype(
     int chunkX, int chunkZ
 ) {
-    return std::make_unique<ChunkPrototype>();
+    auto prototype = std::make_unique<ChunkPrototype>();
+    if (cache) {
+        readCached(*prototype, chunkX, chunkZ);
+    }
+    return prototype;
+}
+
+void WorldGenerator::setCache(std::unique_ptr<PrototypesCache> cache) {
+    this->cache = std::move(cache);
+}
+
+static void write_placements(
+    ByteBuilder& builder, const std::vector<Placement>& placements
+) {
+    auto put_ivec3 = [&builder](const glm::ivec3& vec) {
+        builder.putInt32(vec.x);
+        builder.putInt32(vec.y);
+        builder.putInt32(vec.z);
+    };
+    builder.putInt32(placements.size());
+    for (const auto& placement : placements) {
+        builder.putInt32(placement.priority);
+        builder.put(static_cast<ubyte>(placement.placement.index()));
+        if (auto sp = std::get_if<StructurePlacement>(&placement.placement)) {
+            builder.putInt32(sp->structure);
+            put_ivec3(sp->position);
+            builder.put(sp->rotation);
+        } else if (auto lp = std::get_if<LinePlacement>(&placement.placement)) {
+            builder.putInt16(lp->block);
+            put_ivec3(lp->a);
+            put_ivec3(lp->b);
+            builder.putInt32(lp->radius);
+        } else {
+            const auto& bp = std::get<BlockPlacement>(placement.placement);
+            builder.putInt16(bp.block);
+            put_ivec3(bp.position);
+            builder.put(bp.rotation);
+            builder.put(bp.mirror);
+        }
+    }
+}
+
+static std::vector<Placement> read_placements(ByteReader& reader) {
+    auto get_ivec3 = [&reader]() {
+        int x = reader.getInt32();
+        int y = reader.getInt32();
+        int z = reader.getInt32();
+        return glm::ivec3(x, y, z);
+    };
+    std::vector<Placement> placements;
+    int count = reader.getInt32();
+    for (int i = 0; i < count; i++) {
+        int priority = reader.getInt32();
+        switch (reader.get()) {
+            case 0: {
+                int structure = reader.getInt32();
+                auto position = get_ivec3();
+                ubyte rotation = reader.get();
+                placements.emplace_back(
+                    priority, StructurePlacement {structure, position, rotation}
+                );
+                break;
+            }
+            case 1: {
+                blockid_t block = reader.getInt16();
+                auto a = get_ivec3();
+                auto b = get_ivec3();
+                int radius = reader.getInt32();
+                placements.emplace_back(
+                    priority, LinePlacement {block, a, b, radius}
+                );
+                break;
+            }
+            case 2: {
+                blockid_t block = reader.getInt16();
+                auto position = get_ivec3();
+                ubyte rotation = reader.get();
+                bool mirror = reader.get();
+                placements.emplace_back(
+                    priority, BlockPlacement {block, position, rotation, mirror}
+                );
+                break;
+            }
+            default:
+                throw std::runtime_error("invalid placement type");
+        }
+    }
+    return placements;
+}
+
+void WorldGenerator::readCached(ChunkPrototype& prototype, int x, int z) {
+    size_t size;
+    auto data = cache->read(x, z, size);
+    if (data == nullptr) {
+        return;
+    }
+    auto chunkStages = std::make_shared<ChunkStages>();
+    std::vector<Placement> widePlacements;
+    try {
+        ByteReader reader(data.get(), size);
+        if (static_cast<uint64_t>(reader.getInt64()) != cacheKey) {
+            // generated with another seed, generator or content
+            return;
+        }
+        auto biomes = std::make_unique<const Biome*[]>(CHUNK_W * CHUNK_D);
+        for (uint i = 0; i < CHUNK_W * CHUNK_D; i++) {
+            uint index = static_cast<uint16_t>(reader.getInt16());
+            if (index >= def.biomes.size()) {
+                throw std::runtime_error("invalid biome index");
+            }
+            biomes[i] = &def.biomes[index];
+        }
+        auto heightmap = std::make_shared<Heightmap>(CHUNK_W, CHUNK_D);
+        auto heights = heightmap->getValues();
+        for (uint i = 0; i < CHUNK_W * CHUNK_D; i++) {
+            heights[i] = reader.getFloat32();
+        }
+        chunkStages->biomes = std::move(biomes);
+        chunkStages->heightmap = std::move(heightmap);
+        chunkStages->placements = read_placements(reader);
+        widePlacements = read_placements(reader);
+    } catch (const std::runtime_error& err) {
+        logger.warning() << "invalid cached prototype " << x << " " << z
+                         << ": " << err.what();
+        return;
+    }
+    chunkStages->level = ChunkPrototypeLevel::STRUCTURES;
+    // equal to stages generated ahead by the script determinism contract
+    stages[{x, z}] = std::move(chunkStages);
+    prototype.widePlacements = std::move(widePlacements);
+    prototype.cached = true;
+}
+
+void WorldGenerator::writeCached(
+    const ChunkPrototype& prototype,
+    const std::vector<Placement>& placements,
+    int x,
+    int z
+) {
+    ByteBuilder builder;
+    builder.putInt64(cacheKey);
+    for (uint i = 0; i < CHUNK_W * CHUNK_D; i++) {
+        builder.putInt16(prototype.biomes[i] - def.biomes.data());
+    }
+    auto heights = prototype.heightmap->getValues();
+    for (uint i = 0; i < CHUNK_W * CHUNK_D; i++) {
+        builder.putFloat32(heights[i]);
+    }
+    write_placements(builder, placements);
+    write_placements(builder, prototype.widePlacements);
+
+    auto data = std::make_unique<ubyte[]>(builder.size());
+    std::memcpy(data.get(), builder.data(), builder.size());
+    cache->write(x, z, std::move(data), builder.size());
 }
 
 inline AABB gen_chunk_aabb(int chunkX, int chunkZ) {
@@ -187,6 +492,24 @@ void WorldGenerator::placeStructure(
     }
 }
 
+/// @brief Check if the line may affect voxels of the chunk: xz-distance
+/// between the segment and the chunk center must not exceed the line radius
+/// extended with half of the chunk diagonal
+static bool line_reaches_chunk(const LinePlacement& line, int cx, int cz) {
+    glm::vec2 a(line.a.x, line.a.z);
+    glm::vec2 b(line.b.x, line.b.z);
+    glm::vec2 center((cx + 0.5f) * CHUNK_W, (cz + 0.5f) * CHUNK_D);
+    glm::vec2 ab = b - a;
+    float length2 = glm::dot(ab, ab);
+    float t = 0.0f;
+    if (length2 > 0.0f) {
+        t = glm::clamp(glm::dot(center - a, ab) / length2, 0.0f, 1.0f);
+    }
+    float reach = line.radius + 1.0f +
+                  glm::length(glm::vec2(CHUNK_W, CHUNK_D)) * 0.5f;
+    return glm::distance(a + ab * t, center) <= reach;
+}
+
 void WorldGenerator::placeLine(const LinePlacement& line, int priority) {
     AABB aabb(line.a, line.b);
     aabb.fix();
@@ -198,6 +521,10 @@ void WorldGenerator::placeLine(const LinePlacement& line, int priority) {
     int czb = floordiv<CHUNK_D>(aabb.b.z);
     for (int cz = cza; cz <= czb; cz++) {
         for (int cx = cxa; cx <= cxb; cx++) {
+            // long diagonal lines pass far from most chunks of the box
+            if (!line_reaches_chunk(line, cx, cz)) {
+                continue;
+            }
             const auto& found = prototypes.find({cx, cz});
             if (found != prototypes.end()) {
                 found->second->placements.emplace_back(priority, line);
@@ -275,10 +602,15 @@ void WorldGenerator::generateStructuresWide(
     if (prototype.level >= ChunkPrototypeLevel::WIDE_STRUCTS) {
         return;
     }
-    auto placements = def.script->placeStructuresWide(
-        {chunkX * CHUNK_W, chunkZ * CHUNK_D}, {CHUNK_W, CHUNK_D}, CHUNK_H
-    );
-    placeStructures(placements, prototype, chunkX, chunkZ);
+    if (!prototype.cached) {
+        prototype.widePlacements = def.script->placeStructuresWide(
+            {chunkX * CHUNK_W, chunkZ * CHUNK_D}, {CHUNK_W, CHUNK_D}, CHUNK_H
+        );
+    }
+    placeStructures(prototype.widePlacements, prototype, chunkX, chunkZ);
+    if (cache == nullptr || prototype.cached) {
+        prototype.widePlacements = {};
+    }
 
     prototype.level = ChunkPrototypeLevel::WIDE_STRUCTS;
 }
@@ -292,10 +624,15 @@ void WorldGenerator::generateStructures(
     const auto& biomes = prototype.biomes;
     const auto& heightmap = prototype.heightmap;
 
-    auto placements = def.script->placeStructures(
-        {chunkX * CHUNK_W, chunkZ * CHUNK_D}, {CHUNK_W, CHUNK_D},
-        heightmap, CHUNK_H
+    auto placements = std::move(
+        requireStages(chunkX, chunkZ, ChunkPrototypeLevel::STRUCTURES)
+            .placements
     );
+    stages.erase({chunkX, chunkZ});
+    if (cache && !prototype.cached) {
+        writeCached(prototype, placements, chunkX, chunkZ);
+    }
+    prototype.widePlacements = {};
     placeStructures(placements, prototype, chunkX, chunkZ);
 
     util::PseudoRandom structsRand;
@@ -336,14 +673,48 @@ void WorldGenerator::generateStructures(
     prototype.level = ChunkPrototypeLevel::STRUCTURES;
 }
 
+void WorldGenerator::generateStages(
+    GeneratorScript& script,
+    ChunkStages& stages,
+    int chunkX,
+    int chunkZ,
+    ChunkPrototypeLevel level
+) const {
+    if (stages.level < ChunkPrototypeLevel::BIOMES &&
+        level >= ChunkPrototypeLevel::BIOMES) {
+        generateBiomes(script, stages, chunkX, chunkZ);
+    }
+    if (stages.level < ChunkPrototypeLevel::HEIGHTMAP &&
+        level >= ChunkPrototypeLevel::HEIGHTMAP) {
+        generateHeightmap(script, stages, chunkX, chunkZ);
+    }
+    if (stages.level < ChunkPrototypeLevel::STRUCTURES &&
+        level >= ChunkPrototypeLevel::STRUCTURES) {
+        stages.placements = script.placeStructures(
+            {chunkX * CHUNK_W, chunkZ * CHUNK_D}, {CHUNK_W, CHUNK_D},
+            stages.heightmap, CHUNK_H
+        );
+        stages.level = ChunkPrototypeLevel::STRUCTURES;
+    }
+}
+
 void WorldGenerator::generateBiomes(
     ChunkPrototype& prototype, int chunkX, int chunkZ
 ) {
     if (prototype.level >= ChunkPrototypeLevel::BIOMES) {
         return;
     }
+    auto& chunkStages =
+        requireStages(chunkX, chunkZ, ChunkPrototypeLevel::BIOMES);
+    prototype.biomes = std::move(chunkStages.biomes);
+    prototype.level = ChunkPrototypeLevel::BIOMES;
+}
+
+void WorldGenerator::generateBiomes(
+    GeneratorScript& script, ChunkStages& stages, int chunkX, int chunkZ
+) const {
     uint bpd = def.biomesBPD;
-    auto biomeParams = def.script->generateParameterMaps(
+    auto biomeParams = script.generateParameterMaps(
         {floordiv(chunkX * CHUNK_W, bpd), floordiv(chunkZ * CHUNK_D, bpd)},
         {floordiv(CHUNK_W, bpd)+1, floordiv(CHUNK_D, bpd)+1},
         bpd
@@ -356,13 +727,18 @@ void WorldGenerator::generateBiomes(
             floordiv(CHUNK_D, def.heightsBPD) + 1,
             def.heightsInterpolation
         );
-        prototype.heightmapInputs.push_back(std::move(copy));
+        stages.heightmapInputs.push_back(std::move(copy));
     }
     for (const auto& map : biomeParams) {
         map->resize(
-            CHUNK_W + bpd, CHUNK_D + bpd, def.biomesInterpolation
+            CHUNK_W + bpd,
+            CHUNK_D + bpd,
+            def.biomesInterpolation,
+            0,
+            0,
+            CHUNK_W,
+            CHUNK_D
         );
-        map->crop(0, 0, CHUNK_W, CHUNK_D);
     }
     const auto& biomes = def.biomes;
 
@@ -373,8 +749,8 @@ void WorldGenerator::generateBiomes(
                 choose_biome(biomes, biomeParams, x, z);
         }
     }
-    prototype.biomes = std::move(chunkBiomes);
-    prototype.level = ChunkPrototypeLevel::BIOMES;
+    stages.biomes = std::move(chunkBiomes);
+    stages.level = ChunkPrototypeLevel::BIOMES;
 }
 
 void WorldGenerator::generateHeightmap(
@@ -383,25 +759,63 @@ void WorldGenerator::generateHeightmap(
     if (prototype.level >= ChunkPrototypeLevel::HEIGHTMAP) {
         return;
     }
+    prototype.heightmap =
+        requireStages(chunkX, chunkZ, ChunkPrototypeLevel::HEIGHTMAP)
+            .heightmap;
+    prototype.level = ChunkPrototypeLevel::HEIGHTMAP;
+}
+
+void WorldGenerator::generateHeightmap(
+    GeneratorScript& script, ChunkStages& stages, int chunkX, int chunkZ
+) const {
     uint bpd = def.heightsBPD;
-    prototype.heightmap = def.script->generateHeightmap(
+    auto heightmap = script.generateHeightmap(
         {floordiv(chunkX * CHUNK_W, bpd), floordiv(chunkZ * CHUNK_D, bpd)},
         {floordiv(CHUNK_W, bpd)+1, floordiv(CHUNK_D, bpd)+1},
         bpd,
-        prototype.heightmapInputs
+        stages.heightmapInputs
     );
-    prototype.heightmap->clamp();
-    prototype.heightmap->resize(
-        CHUNK_W + bpd, CHUNK_D + bpd, def.heightsInterpolation
+    heightmap->clamp();
+    heightmap->resize(
+        CHUNK_W + bpd,
+        CHUNK_D + bpd,
+        def.heightsInterpolation,
+        0,
+        0,
+        CHUNK_W,
+        CHUNK_D
     );
-    prototype.heightmap->crop(0, 0, CHUNK_W, CHUNK_D);
-    prototype.level = ChunkPrototypeLevel::HEIGHTMAP;
+    stages.heightmap = std::move(heightmap);
+    stages.heightmapInputs.clear();
+    stages.level = ChunkPrototypeLevel::HEIGHTMAP;
 }
 
 void WorldGenerator::update(int centerX, int centerY, int loadDistance) {
     surroundMap.setCenter(centerX, centerY);
     surroundMap.resize(loadDistance);
     surroundMap.setCenter(centerX, centerY);
+
+    if (stagesPool == nullptr) {
+        return;
+    }
+    stagesPool->pullResults();
+
+    // stages outside of the area are not removed by the out callback
+    // if the prototype was not created
+    const auto& area = surroundMap.getArea();
+    for (auto it = stages.begin(); it != stages.end();) {
+        if (!area.isInside(it->first.x, it->first.y)) {
+            it = stages.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    auto cancelled = stagesPool->cancelJobs([&area](const auto& job) {
+        return !area.isInside(job.x, job.z);
+    });
+    for (const auto& job : cancelled) {
+        stagesRequested.erase({job.x, job.z});
+    }
 }
 
 void WorldGenerator::generatePlants(
@@ -411,7 +825,7 @@ void WorldGenerator::generatePlants(
     int chunkX,
     int chunkZ,
     const Biome** biomes
-) {
+) const {
     const auto& indices = content.getIndices()->blocks;
     util::PseudoRandom plantsRand;
     plantsRand.setSeed(chunkX, chunkZ);
@@ -453,49 +867,115 @@ void WorldGenerator::generateLand(
     int chunkX,
     int chunkZ,
     const Biome** biomes
-) {
+) const {
+    constexpr uint AREA = CHUNK_W * CHUNK_D;
     uint seaLevel = def.seaLevel;
-    for (uint z = 0; z < CHUNK_D; z++) {
-        for (uint x = 0; x < CHUNK_W; x++) {
-            const Biome* biome = biomes[z * CHUNK_W + x];
-
-            int height = values[z * CHUNK_W + x] * CHUNK_H;
-            height = std::max(0, height);
 
-            const auto& groundLayers = biome->groundLayers;
-            const auto& seaLayers = biome->seaLayers;
-
-            generate_pole(seaLayers, seaLevel, height, seaLevel, voxels, x, z);
-            generate_pole(groundLayers, height, 0, seaLevel, voxels, x, z);
+    std::vector<LandSpan> spans;
+    std::vector<int> bounds;
+    // column block changes: the block is set at y and above
+    std::vector<LandChange> changes;
+    std::array<uint, CHUNK_H + 2> changesOffsets {};
+    for (uint i = 0; i < AREA; i++) {
+        const Biome* biome = biomes[i];
+
+        int height = values[i] * CHUNK_H;
+        height = std::max(0, height);
+
+        spans.clear();
+        generate_pole(biome->seaLayers, seaLevel, height, seaLevel, spans);
+        generate_pole(biome->groundLayers, height, 0, seaLevel, spans);
+
+        bounds.clear();
+        for (const auto& span : spans) {
+            bounds.push_back(span.bottom);
+            bounds.push_back(span.top);
+        }
+        std::sort(bounds.begin(), bounds.end());
+        bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+        blockid_t current = BLOCK_AIR;
+        for (size_t b = 0; b < bounds.size(); b++) {
+            int y = bounds[b];
+            blockid_t id = BLOCK_AIR;
+            if (b + 1 < bounds.size()) {
+                // the last written span covering [y, next bound) wins
+                for (auto it = spans.rbegin(); it != spans.rend(); ++it) {
+                    if (it->bottom <= y && it->top > y) {
+                        id = it->id;
+                        break;
+                    }
+                }
+            }
+            if (id != current) {
+                changes.push_back(LandChange {y, i, id});
+                changesOffsets[y + 1]++;
+                current = id;
+            }
+        }
+    }
+    if (changes.empty()) {
+        return;
+    }
+    // sort changes by y
+    for (uint y = 1; y < changesOffsets.size(); y++) {
+        changesOffsets[y] += changesOffsets[y - 1];
+    }
+    std::vector<LandChange> sorted(changes.size());
+    {
+        auto offsets = changesOffsets;
+        for (const auto& change : changes) {
+            sorted[offsets[change.y]++] = change;
         }
     }
+    // all columns end with air, so layers above the top change are
+    // already zeroed
+    int top = sorted.back().y;
+    voxel layer[AREA] {};
+    for (int y = 0; y < top; y++) {
+        for (uint c = changesOffsets[y]; c < changesOffsets[y + 1]; c++) {
+            layer[sorted[c].column].id = sorted[c].id;
+        }
+        std::memcpy(voxels + y * AREA, layer, sizeof(layer));
+    }
 }
 
 void WorldGenerator::generate(voxel* voxels, int chunkX, int chunkZ) {
+    scheduleStages(chunkX, chunkZ);
+    surroundMap.completeAt(chunkX, chunkZ);
+    generate(requirePrototype(chunkX, chunkZ), voxels, chunkX, chunkZ);
+}
+
+std::shared_ptr<const ChunkPrototype> WorldGenerator::prepare(
+    int chunkX, int chunkZ
+) {
+    scheduleStages(chunkX, chunkZ);
     surroundMap.completeAt(chunkX, chunkZ);
 
     const auto& prototype = requirePrototype(chunkX, chunkZ);
-    const auto values = prototype.heightmap->getValues();
+    auto snapshot = std::make_shared<ChunkPrototype>();
+    snapshot->level = prototype.level;
+    snapshot->biomes = std::make_unique<const Biome*[]>(CHUNK_W * CHUNK_D);
+    std::memcpy(
+        snapshot->biomes.get(),
+        prototype.biomes.get(),
+        CHUNK_W * CHUNK_D * sizeof(const Biome*)
+    );
+    // heightmap is not modified after HEIGHTMAP level
+    snapshot->heightmap = prototype.heightmap;
+    snapshot->placements = prototype.placements;
+    return snapshot;
+}
 
-    uint seaLevel = def.seaLevel;
+void WorldGenerator::generate(
+    const ChunkPrototype& prototype, voxel* voxels, int chunkX, int chunkZ
+) const {
+    const auto values = prototype.heightmap->getValues();
 
     std::memset(voxels, 0, sizeof(voxel) * CHUNK_VOL);
 
     const auto& biomes = prototype.biomes.get();
-    for (uint z = 0; z < CHUNK_D; z++) {
-        for (uint x = 0; x < CHUNK_W; x++) {
-            const Biome* biome = biomes[z * CHUNK_W + x];
-
-            int height = values[z * CHUNK_W + x] * CHUNK_H;
-            height = std::max(0, height);
-
-            const auto& groundLayers = biome->groundLayers;
-            const auto& seaLayers = biome->seaLayers;
-
-            generate_pole(seaLayers, seaLevel, height, seaLevel, voxels, x, z);
-            generate_pole(groundLayers, height, 0, seaLevel, voxels, x, z);
-        }
-    }
+    generateLand(prototype, values, voxels, chunkX, chunkZ, biomes);
     generatePlacements(prototype, voxels, chunkX, chunkZ);
     generatePlants(prototype, values, voxels, chunkX, chunkZ, biomes);
 
@@ -515,16 +995,21 @@ void WorldGenerator::generate(voxel* voxels, int chunkX, int chunkZ) {
 
 void WorldGenerator::generatePlacements(
     const ChunkPrototype& prototype, voxel* voxels, int chunkX, int chunkZ
-) {
-    auto placements = prototype.placements;
+) const {
+    std::vector<const Placement*> placements;
+    placements.reserve(prototype.placements.size());
+    for (const auto& placement : prototype.placements) {
+        placements.push_back(&placement);
+    }
     std::stable_sort(
         placements.begin(),
         placements.end(), 
         [](const auto& a, const auto& b) {
-            return a.priority < b.priority;
+            return a->priority < b->priority;
         }
     );
-    for (const auto& placement : placements) {
+    for (const auto placementPtr : placements) {
+        const auto& placement = *placementPtr;
         if (auto structure = std::get_if<StructurePlacement>(&placement.placement)) {
             generateStructure(prototype, *structure, voxels, chunkX, chunkZ);
         } else if (auto line = std::get_if<LinePlacement>(&placement.placement)) {
@@ -540,40 +1025,14 @@ void WorldGenerator::generateStructure(
     const StructurePlacement& placement,
     voxel* voxels, 
     int chunkX, int chunkZ
-) {
+) const {
     if (placement.structure < 0 || placement.structure >= def.structures.size()) {
         logger.error() << "invalid structure index " << placement.structure;
         return;
     }
     auto& generatingStructure = def.structures[placement.structure];
-    auto& structure = *generatingStructure->fragments[placement.rotation];
-    auto& structVoxels = structure.getRuntimeVoxels();
-    const auto& offset = placement.position;
-    const auto& size = structure.getSize();
-
-    for (int y = 0; y < size.y; y++) {
-        int sy = y + offset.y;
-        if (sy < 0 || sy >= CHUNK_H) {
-            continue;
-        }
-        for (int z = 0; z < size.z; z++) {
-            int sz = z + offset.z;
-            if (sz < 0 || sz >= CHUNK_D) {
-                continue;
-            }
-            for (int x = 0; x < size.x; x++) {
-                int sx = x + offset.x;
-                if (sx < 0 || sx >= CHUNK_W) {
-                    continue;
-                }
-                const auto& structVoxel = 
-                    structVoxels[vox_index(x, y, z, size.x, size.z)];
-                if (structVoxel.id) {
-                    voxels[vox_index(sx, sy, sz)] = structVoxel;
-                }
-            }
-        }
-    }
+    const auto& structure = *generatingStructure->fragments[placement.rotation];
+    structure.stamp(voxels, placement.position);
 }
 
 void WorldGenerator::generateLine(
@@ -581,7 +1040,7 @@ void WorldGenerator::generateLine(
     const LinePlacement& line,
     voxel* voxels, 
     int chunkX, int chunkZ
-) {
+) const {
     const auto& indices = content.getIndices()->blocks;
 
     int cgx = chunkX * CHUNK_W;
@@ -642,7 +1101,7 @@ void WorldGenerator::generateBlock(
     const BlockPlacement& placement,
     voxel* voxels,
     int chunkX, int chunkZ
-) {
+) const {
     const auto& indices = content.getIndices()->blocks;
     const auto& def = indices.require(placement.block);
 
@@ -694,11 +1153,14 @@ void WorldGenerator::generateBlock(
 
 WorldGenDebugInfo WorldGenerator::createDebugInfo() const {
     const auto& area = surroundMap.getArea();
-    const auto& levels = area.getBuffer();
-    auto values = std::make_unique<ubyte[]>(area.getWidth()*area.getHeight());
+    int width = area.getWidth();
+    int height = area.getHeight();
+    auto values = std::make_unique<ubyte[]>(width * height);
 
-    for (uint i = 0; i < levels.size(); i++) {
-        values[i] = levels[i];
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            values[y * width + x] = area.getLocal(x, y);
+        }
     }
 
     return WorldGenDebugInfo {
@@ -3,8 +3,10 @@
 #include <array>
 #include <string>
 #include <memory>
+#include <optional>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "constants.hpp"
 #include "typedefs.hpp"
@@ -14,9 +16,16 @@
 
 class Content;
 struct GeneratorDef;
+class GeneratorScript;
 class Heightmap;
 struct Biome;
 class VoxelFragment;
+class PrototypesCache;
+
+namespace util {
+    template <class J, class T>
+    class ThreadPool;
+}
 
 enum class ChunkPrototypeLevel {
     VOID=0, WIDE_STRUCTS, BIOMES, HEIGHTMAP, STRUCTURES
@@ -33,8 +42,40 @@ struct ChunkPrototype {
 
     std::vector<Placement> placements;
 
+    /// @brief placements returned by place_structures_wide, kept until
+    /// the prototype is written to the cache
+    std::vector<Placement> widePlacements;
+
+    /// @brief Generation results are read from the cache
+    bool cached = false;
+};
+
+/// @brief Results of prototype stages depending on the chunk position and
+/// the seed only, so may be generated ahead by any script instance
+struct ChunkStages {
+    /// @brief Last generated stage (BIOMES, HEIGHTMAP or STRUCTURES)
+    ChunkPrototypeLevel level = ChunkPrototypeLevel::VOID;
+
+    std::unique_ptr<const Biome*[]> biomes;
+
     /// @brief biome parameters maps saved until heightmaps generation
-    std::vector<std::shared_ptr<Heightmap>> heightmapInputs {};
+    std::vector<std::shared_ptr<Heightmap>> heightmapInputs;
+
+    std::shared_ptr<Heightmap> heightmap;
+
+    /// @brief placements returned by place_structures script function
+    std::vector<Placement> placements;
+};
+
+struct ChunkStagesJob {
+    int x;
+    int z;
+};
+
+struct ChunkStagesResult {
+    int x;
+    int z;
+    std::shared_ptr<ChunkStages> stages;
 };
 
 struct WorldGenDebugInfo {
@@ -57,6 +98,18 @@ class WorldGenerator {
     std::unordered_map<glm::ivec2, std::unique_ptr<ChunkPrototype>> prototypes;
     /// @brief Chunk prototypes loading surround map
     SurroundMap surroundMap;
+    /// @brief Stages generated ahead or not consumed by prototypes yet
+    std::unordered_map<glm::ivec2, std::shared_ptr<ChunkStages>> stages;
+    /// @brief Positions of stages being generated by workers
+    std::unordered_set<glm::ivec2> stagesRequested;
+    /// @brief Stages workers owning script instances (may be nullptr)
+    std::unique_ptr<util::ThreadPool<ChunkStagesJob, ChunkStagesResult>>
+        stagesPool;
+    /// @brief Generation results storage (may be nullptr)
+    std::unique_ptr<PrototypesCache> cache;
+    /// @brief Hash of the seed, generator and content the cache entries
+    /// are valid for
+    uint64_t cacheKey;
 
     /// @brief Generate chunk prototype (see ChunkPrototype)
     /// @param x chunk position X divided by CHUNK_W
@@ -65,6 +118,29 @@ class WorldGenerator {
 
     ChunkPrototype& requirePrototype(int x, int z);
 
+    /// @brief Get stages of the chunk generating missing ones in the
+    /// current thread
+    ChunkStages& requireStages(int x, int z, ChunkPrototypeLevel level);
+
+    /// @brief Install generated stages and request workers to generate
+    /// stages of chunks around
+    void scheduleStages(int x, int z);
+
+    void installStages(ChunkStagesResult&& result);
+
+    /// @brief Read cached generation results of the chunk to the prototype
+    /// and stages
+    void readCached(ChunkPrototype& prototype, int x, int z);
+
+    /// @brief Write prototype generation results to the cache
+    /// @param placements placements returned by place_structures
+    void writeCached(
+        const ChunkPrototype& prototype,
+        const std::vector<Placement>& placements,
+        int x,
+        int z
+    );
+
     void generateStructuresWide(ChunkPrototype& prototype, int x, int z);
 
     void generateStructures(ChunkPrototype& prototype, int x, int z);
@@ -73,6 +149,14 @@ class WorldGenerator {
 
     void generateHeightmap(ChunkPrototype& prototype, int x, int z);
 
+    void generateBiomes(
+        GeneratorScript& script, ChunkStages& stages, int x, int z
+    ) const;
+
+    void generateHeightmap(
+        GeneratorScript& script, ChunkStages& stages, int x, int z
+    ) const;
+
     void placeStructure(
         const StructurePlacement& placement, int priority, 
         int chunkX, int chunkZ
@@ -83,25 +167,25 @@ class WorldGenerator {
 
     void generatePlacements(
         const ChunkPrototype& prototype, voxel* voxels, int x, int z
-    );
+    ) const;
     void generateLine(
         const ChunkPrototype& prototype, 
         const LinePlacement& placement,
         voxel* voxels, 
         int x, int z
-    );
+    ) const;
     void generateBlock(
         const ChunkPrototype& prototype,
         const BlockPlacement& placement,
         voxel* voxels,
         int x, int z
-    );
+    ) const;
     void generateStructure(
         const ChunkPrototype& prototype, 
         const StructurePlacement& placement,
         voxel* voxels, 
         int x, int z
-    );
+    ) const;
     void generatePlants(
         const ChunkPrototype& prototype,
         float* values,
@@ -109,7 +193,7 @@ class WorldGenerator {
         int x,
         int z,
         const Biome** biomes
-    );
+    ) const;
     void generateLand(
         const ChunkPrototype& prototype,
         float* values,
@@ -117,7 +201,7 @@ class WorldGenerator {
         int x,
         int z,
         const Biome** biomes
-    );
+    ) const;
 
     void placeStructures(
         const std::vector<Placement>& placements,
@@ -125,21 +209,61 @@ class WorldGenerator {
         int x, int z
     );
 public:
+    /// @param stagesWorkers prototype stages workers limit (see
+    /// util::ThreadPool). Every worker uses own script instance.
+    /// Stages are generated in the calling thread if not specified
     WorldGenerator(
         const GeneratorDef& def,
         const Content& content,
-        uint64_t seed
+        uint64_t seed,
+        std::optional<int> stagesWorkers = std::nullopt
     );
     ~WorldGenerator();
 
     void update(int centerX, int centerY, int loadDistance);
 
+    /// @brief Set generation results storage. Prototypes created later
+    /// are read from the cache if available
+    void setCache(std::unique_ptr<PrototypesCache> cache);
+
     /// @brief Generate complete chunk voxels
     /// @param voxels destinatiopn chunk voxels buffer
     /// @param x chunk position X divided by CHUNK_W
     /// @param z chunk position Y divided by CHUNK_D
     void generate(voxel* voxels, int x, int z);
 
+    /// @brief Complete chunk prototype and make a snapshot of it.
+    /// Must be called in the thread owning the generator script
+    /// @param x chunk position X divided by CHUNK_W
+    /// @param z chunk position Y divided by CHUNK_D
+    /// @return independent copy of the complete prototype
+    std::shared_ptr<const ChunkPrototype> prepare(int x, int z);
+
+    /// @brief Generate chunk voxels from a prepared prototype.
+    /// Does not access the generator script or prototypes storage, so may
+    /// be called from worker threads.
+    /// @param prototype snapshot returned by prepare(...)
+    /// @param voxels destination chunk voxels buffer
+    /// @param x chunk position X divided by CHUNK_W
+    /// @param z chunk position Y divided by CHUNK_D
+    void generate(
+        const ChunkPrototype& prototype, voxel* voxels, int x, int z
+    ) const;
+
+    /// @brief Generate chunk stages up to the level using the script.
+    /// Does not access prototypes storage, so may be called from worker
+    /// threads, each using own script instance
+    /// @param script initialized script (see GeneratorScript::clone)
+    /// @param stages destination stages
+    /// @param level max stage to generate
+    void generateStages(
+        GeneratorScript& script,
+        ChunkStages& stages,
+        int x,
+        int z,
+        ChunkPrototypeLevel level
+    ) const;
+
     WorldGenDebugInfo createDebugInfo() const;
 
     uint64_t getSeed() const;
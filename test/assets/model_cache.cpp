@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include "assets/model_cache.hpp"
+#include "graphics/commons/Model.hpp"
+
+static model::Model make_model() {
+    model::Model model;
+    auto& first = model.addMesh("blocks:stone");
+    for (int i = 0; i < 6; i++) {
+        float f = static_cast<float>(i);
+        first.vertices.push_back(
+            {{f, f * 2, f * 3}, {f / 6, 1 - f / 6}, {0, 1, 0}}
+        );
+    }
+    auto& second = model.addMesh("$0", false);
+    second.vertices.push_back({{-1, -2, -3}, {0.5f, 0.25f}, {1, 0, 0}});
+    model.meshes.emplace_back().texture = "blocks:stone";
+    return model;
+}
+
+TEST(model_cache, RoundTrip) {
+    auto model = make_model();
+    auto bytes = model_cache::serialize(42, model);
+    auto loaded = model_cache::deserialize(bytes.data(), bytes.size(), 42);
+    ASSERT_NE(loaded, nullptr);
+    ASSERT_EQ(loaded->meshes.size(), model.meshes.size());
+    for (size_t i = 0; i < model.meshes.size(); i++) {
+        const auto& expected = model.meshes[i];
+        const auto& actual = loaded->meshes[i];
+        EXPECT_EQ(actual.texture, expected.texture);
+        EXPECT_EQ(actual.shading, expected.shading);
+        ASSERT_EQ(actual.vertices.size(), expected.vertices.size());
+        for (size_t j = 0; j < expected.vertices.size(); j++) {
+            EXPECT_EQ(actual.vertices[j].coord, expected.vertices[j].coord);
+            EXPECT_EQ(actual.vertices[j].uv, expected.vertices[j].uv);
+            EXPECT_EQ(actual.vertices[j].normal, expected.vertices[j].normal);
+        }
+    }
+}
+
+TEST(model_cache, KeyMismatch) {
+    auto bytes = model_cache::serialize(42, make_model());
+    EXPECT_EQ(model_cache::deserialize(bytes.data(), bytes.size(), 43), nullptr);
+}
+
+TEST(model_cache, Truncated) {
+    auto bytes = model_cache::serialize(42, make_model());
+    EXPECT_THROW(
+        model_cache::deserialize(bytes.data(), bytes.size() - 1, 42),
+        std::runtime_error
+    );
+}
@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "audio/MemoryPCMStream.hpp"
+#include "audio/StreamsDecoder.hpp"
+
+using namespace audio;
+
+TEST(StreamsDecoder, DecodeAhead) {
+    const size_t size = 10000;
+    const size_t chunkSize = 1024;
+    std::vector<ubyte> bytes(size);
+    for (size_t i = 0; i < size; i++) {
+        bytes[i] = i * 31 % 251;
+    }
+    auto source = std::make_shared<MemoryPCMStream>(44100, 1, 16);
+    source->feed(util::span<ubyte>(bytes.data(), bytes.size()));
+
+    auto stream = std::make_shared<DecodedStream>(source, chunkSize, 3);
+    StreamsDecoder decoder(2);
+
+    std::vector<ubyte> result;
+    std::vector<char> chunk(chunkSize);
+    while (size_t read = stream->read(chunk.data(), false)) {
+        result.insert(result.end(), chunk.begin(), chunk.begin() + read);
+        decoder.schedule(stream);
+    }
+    EXPECT_TRUE(stream->isEnd());
+    EXPECT_EQ(result, bytes);
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include "coders/bcn.hpp"
+#include "graphics/core/ImageData.hpp"
+
+static std::vector<ubyte> make_gradient(uint width, uint height, bool alpha) {
+    std::vector<ubyte> pixels(width * height * 4);
+    for (uint y = 0; y < height; y++) {
+        for (uint x = 0; x < width; x++) {
+            ubyte* pixel = pixels.data() + (y * width + x) * 4;
+            pixel[0] = x * 255 / width;
+            pixel[1] = y * 255 / height;
+            pixel[2] = 128;
+            pixel[3] = alpha ? ((x / 4 + y / 4) % 2) * 255 : 255;
+        }
+    }
+    return pixels;
+}
+
+static int max_error(
+    const std::vector<ubyte>& a, const std::vector<ubyte>& b, int channel
+) {
+    int error = 0;
+    for (size_t i = channel; i < a.size(); i += 4) {
+        error = std::max(error, std::abs(a[i] - b[i]));
+    }
+    return error;
+}
+
+TEST(bcn, EncodeDecode) {
+    const uint width = 64;
+    const uint height = 32;
+    for (auto format : {bcn::Format::BC1, bcn::Format::BC3}) {
+        auto source = make_gradient(width, height, format == bcn::Format::BC3);
+        auto encoded = bcn::encode(format, source.data(), width, height);
+        EXPECT_EQ(
+            encoded.size(), bcn::get_data_size(format, width, height)
+        );
+        std::vector<ubyte> decoded(source.size());
+        bcn::decode(format, encoded.data(), width, height, decoded.data());
+        for (int c = 0; c < 3; c++) {
+            EXPECT_LE(max_error(source, decoded, c), 16);
+        }
+        EXPECT_EQ(max_error(source, decoded, 3), 0);
+    }
+}
+
+TEST(bcn, CompressLevels) {
+    auto pixels = make_gradient(32, 32, false);
+    ImageData image(ImageFormat::RGBA8888, 32, 32, pixels.data());
+    auto compressed = bcn::compress(image, 2);
+    EXPECT_EQ(compressed->format, bcn::Format::BC1);
+    ASSERT_EQ(compressed->levels.size(), 2);
+    EXPECT_EQ(compressed->levels[1].size(), (16 / 4) * (16 / 4) * 8);
+}
@@ -2,6 +2,21 @@
 
 #include "util/Buffer.hpp"
 #include "coders/binary_json.hpp"
+#include "io/memory_istream.hpp"
+#include "io/memory_ostream.hpp"
+
+static void expect_stream_object(const dv::value& object) {
+    EXPECT_EQ(object["name"].asString(), "stream");
+    EXPECT_EQ(object["big"].asInteger(), 1LL << 40);
+    EXPECT_EQ(object["negative"].asInteger(), -300);
+    EXPECT_EQ(object["number"].asNumber(), 0.5);
+    const auto& list = object["list"];
+    ASSERT_EQ(list.size(), 2);
+    EXPECT_TRUE(list[0].asBoolean());
+    EXPECT_EQ(list[1]["bytes"].asBytes().size(), 100);
+    EXPECT_EQ(list[1]["bytes"].asBytes()[99], 99);
+    EXPECT_EQ(list[1]["inner"]["a"].asInteger(), 1);
+}
 
 TEST(BJSON, EncodeDecode) {
     const std::string name = "JSON-encoder";
@@ -36,3 +51,46 @@ TEST(BJSON, EncodeDecode) {
         }
     }
 }
+
+TEST(BJSON, Streaming) {
+    auto object = dv::object();
+    object["name"] = "stream";
+    object["big"] = 1LL << 40;
+    object["negative"] = -300;
+    object["number"] = 0.5;
+    auto& list = object.list("list");
+    list.add(true);
+    auto& nested = list.object();
+    dv::objects::Bytes data(100);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = i;
+    }
+    nested["bytes"] = data;
+    nested["inner"] = dv::object({{"a", 1}});
+
+    // streamed output is the same as the original encoder one
+    auto bytes = json::to_binary(object);
+    memory_ostream output;
+    json::write_binary(output, object);
+    auto view = output.view();
+    ASSERT_EQ(
+        std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size()),
+        view
+    );
+    for (bool compress : {false, true}) {
+        auto encoded = json::to_binary(object, compress);
+        auto decoded = json::from_binary(encoded.data(), encoded.size());
+        expect_stream_object(decoded);
+
+        memory_istream input(util::Buffer<char>(
+            reinterpret_cast<const char*>(encoded.data()), encoded.size()
+        ));
+        decoded = json::read_binary(input);
+        expect_stream_object(decoded);
+    }
+    // truncated document
+    memory_istream input(util::Buffer<char>(
+        reinterpret_cast<const char*>(bytes.data()), bytes.size() / 2
+    ));
+    EXPECT_THROW(json::read_binary(input), std::runtime_error);
+}
@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "coders/compression.hpp"
+
+using namespace compression;
+
+static void test_compress_decompress(Method method) {
+    std::vector<ubyte> initial(60'000);
+    ubyte next = rand();
+    for (size_t i = 0; i < initial.size(); i++) {
+        initial[i] = next;
+        if (rand() % 20 == 0) {
+            next = rand();
+        }
+    }
+    size_t length;
+    auto compressed = compress(initial.data(), initial.size(), length, method);
+    EXPECT_LT(length, initial.size());
+
+    auto decompressed =
+        decompress(compressed.get(), length, initial.size(), method);
+    for (size_t i = 0; i < initial.size(); i++) {
+        ASSERT_EQ(decompressed[i], initial[i]);
+    }
+
+    std::vector<ubyte> dst(initial.size());
+    decompress(
+        util::span<ubyte>(compressed.get(), length),
+        dst.data(),
+        dst.size(),
+        method
+    );
+    EXPECT_EQ(dst, initial);
+}
+
+TEST(compression, EncodeDecodeGZIP) {
+    test_compress_decompress(Method::GZIP);
+}
+
+TEST(compression, EncodeDecodeZSTD) {
+    test_compress_decompress(Method::ZSTD);
+}
+
+TEST(compression, EncodeDecodeLZ4) {
+    test_compress_decompress(Method::LZ4);
+}
+
+TEST(compression, CorruptedZSTD) {
+    std::vector<ubyte> initial(1'000, 7);
+    size_t length;
+    auto compressed =
+        compress(initial.data(), initial.size(), length, Method::ZSTD);
+    EXPECT_THROW(
+        decompress(compressed.get(), length / 2, initial.size(), Method::ZSTD),
+        std::runtime_error
+    );
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include "coders/commons.hpp"
 #include "coders/json.hpp"
 #include "util/stringutil.hpp"
 
@@ -40,3 +41,23 @@ TEST(JSON, EncodeDecode) {
         }
     }
 }
+
+TEST(JSON, Strings) {
+    auto object = json::parse(
+        "{\"plain string longer than sixteen bytes\": "
+        "\"value with \\\"escapes\\\" after sixteen\\n bytes \\u00e9\", "
+        "\"short\": 'single \"quoted\"', \"\": \"\"}"
+    );
+    EXPECT_EQ(
+        object["plain string longer than sixteen bytes"].asString(),
+        "value with \"escapes\" after sixteen\n bytes \u00e9"
+    );
+    EXPECT_EQ(object["short"].asString(), "single \"quoted\"");
+    EXPECT_EQ(object[""].asString(), "");
+
+    EXPECT_THROW(
+        json::parse("{\"key\": \"non-closed string literal\n\"}"),
+        parsing_error
+    );
+    EXPECT_THROW(json::parse("{\"key\": \"unexpected end"), parsing_error);
+}
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include "content/loading/ContentFilesCache.hpp"
+#include "io/devices/MemoryDevice.hpp"
+#include "io/io.hpp"
+
+TEST(ContentFilesCache, ParallelLoad) {
+    io::set_device("cachetest", std::make_shared<io::MemoryDevice>());
+
+    std::vector<io::path> paths;
+    for (int i = 0; i < 64; i++) {
+        io::path file = "cachetest:" + std::to_string(i) + ".json";
+        io::write_string(file, "{\"index\": " + std::to_string(i) + "}");
+        paths.push_back(file);
+    }
+    io::path broken = "cachetest:broken.json";
+    io::write_string(broken, "{\"index\": ");
+    paths.push_back(broken);
+
+    ContentFilesCache files;
+    files.load(paths, 4);
+    EXPECT_EQ(files.size(), 64);
+    EXPECT_FALSE(files.has(broken));
+    EXPECT_THROW(files.read(broken), std::runtime_error);
+
+    for (int i = 0; i < 64; i++) {
+        EXPECT_EQ(files.read(paths[i])["index"].asInteger(), i);
+    }
+    // not cached file is read directly
+    io::write_string("cachetest:other.json", "{\"index\": -1}");
+    EXPECT_EQ(files.read("cachetest:other.json")["index"].asInteger(), -1);
+
+    io::remove_device("cachetest");
+}
+
+TEST(ContentFilesCache, Image) {
+    io::set_device("cachetest", std::make_shared<io::MemoryDevice>());
+    io::path image = "cachetest:cache/content.bin";
+    io::path file = "cachetest:block.json";
+    io::write_string(file, "{\"caption\": \"Stone\"}");
+
+    ContentFilesCache first;
+    first.load({file}, image, 1);
+    EXPECT_TRUE(io::is_regular_file(image));
+
+    ContentFilesCache second;
+    second.load({file}, image, 1);
+    EXPECT_EQ(second.read(file)["caption"].asString(), "Stone");
+
+    // modified file size changes the key
+    io::write_string(file, "{\"caption\": \"Granite\"}");
+    ContentFilesCache third;
+    third.load({file}, image, 1);
+    EXPECT_EQ(third.read(file)["caption"].asString(), "Granite");
+
+    io::remove_device("cachetest");
+}
@@ -71,6 +71,37 @@ TEST(StructLayout, ConvertReorder) {
     EXPECT_DOUBLE_EQ(dstLayout.getNumber(dst, "pi"), 3.141592);
 }
 
+TEST(StructLayout, ConvertBulk) {
+    std::vector<Field> srcFields {
+        Field {FieldType::I16, "count", 1},
+        Field {FieldType::F32, "speed", 1},
+    };
+    auto srcLayout = StructLayout::create(srcFields);
+    std::vector<Field> dstFields {
+        Field {FieldType::F64, "speed", 1},
+        Field {FieldType::I32, "count", 1},
+    };
+    auto dstLayout = StructLayout::create(dstFields);
+
+    constexpr size_t count = 4;
+    ubyte src[count][8] {};
+    ubyte dst[count][16] {};
+    const ubyte* srcPtrs[count];
+    ubyte* dstPtrs[count];
+    for (size_t i = 0; i < count; i++) {
+        srcLayout.setInteger(src[i], i * 100, "count");
+        srcLayout.setNumber(src[i], i * 0.5, "speed");
+        srcPtrs[i] = src[i];
+        dstPtrs[i] = dst[i];
+    }
+    dstLayout.convert(srcLayout, srcPtrs, dstPtrs, count, false);
+
+    for (size_t i = 0; i < count; i++) {
+        EXPECT_EQ(dstLayout.getInteger(dst[i], "count"), i * 100);
+        EXPECT_DOUBLE_EQ(dstLayout.getNumber(dst[i], "speed"), i * 0.5);
+    }
+}
+
 TEST(StructLayout, ConvertWithLoss) {
     ubyte src[32] {};
     std::vector<Field> srcFields {
@@ -27,3 +27,32 @@ TEST(dv, dv) {
         }
     }
 }
+
+TEST(dv, Arena) {
+    auto arena = std::make_shared<dv::Arena>();
+    dv::value value;
+    {
+        dv::ArenaScope scope(arena);
+        value = dv::object();
+        auto& list = value.list("elements");
+        for (int i = 0; i < 100; i++) {
+            auto& obj = list.object();
+            obj["index"] = i;
+            obj["position"] = dv::list({i, -i, i * 2});
+        }
+    }
+    size_t allocated = arena->getAllocated();
+    EXPECT_GT(allocated, 0);
+    // the tree keeps the arena alive
+    arena.reset();
+
+    // modified after the scope
+    value["elements"].add(dv::object());
+    ASSERT_EQ(value["elements"].size(), 101);
+    for (int i = 0; i < 100; i++) {
+        const auto& obj = value["elements"][i];
+        EXPECT_EQ(obj["index"].asInteger(), i);
+        EXPECT_EQ(obj["position"][2].asInteger(), i * 2);
+    }
+    EXPECT_EQ(dv::get_current_arena(), nullptr);
+}
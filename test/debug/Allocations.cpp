@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+
+#include "debug/Allocations.hpp"
+
+using namespace debug;
+
+TEST(Allocations, Counters) {
+    auto start = allocations::get_total();
+    allocations::count_allocation(100);
+    allocations::count_allocation(28);
+    allocations::count_free();
+    auto made = allocations::get_total() - start;
+    // other threads may allocate concurrently if tracking is available
+    EXPECT_GE(made.allocations, 2);
+    EXPECT_GE(made.frees, 1);
+    EXPECT_GE(made.bytes, 128);
+
+    std::thread thread([]() {
+        allocations::set_thread_name("allocations-test");
+        allocations::count_allocation(64);
+    });
+    thread.join();
+    bool found = false;
+    for (const auto& entry : allocations::get_threads()) {
+        if (entry.threadName == "allocations-test") {
+            found = true;
+            EXPECT_GE(entry.stats.bytes, 64);
+        }
+    }
+    EXPECT_TRUE(found);
+}
+
+TEST(Allocations, Frame) {
+    allocations::end_frame();
+    allocations::count_allocation(10);
+    allocations::end_frame();
+    EXPECT_GE(allocations::get_last_frame().allocations, 1);
+}
+
+TEST(Allocations, OperatorNew) {
+    if (!allocations::is_available()) {
+        GTEST_SKIP() << "allocations tracking is not available";
+    }
+    auto start = allocations::get_thread();
+    auto value = std::make_unique<int>(42);
+    value.reset();
+    auto made = allocations::get_thread() - start;
+    EXPECT_EQ(made.allocations, 1);
+    EXPECT_EQ(made.frees, 1);
+    EXPECT_EQ(made.bytes, sizeof(int));
+}
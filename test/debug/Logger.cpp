@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+
+#include "debug/Logger.hpp"
+
+struct CountedValue {
+    int& counter;
+};
+
+static std::ostream& operator<<(std::ostream& stream, const CountedValue& v) {
+    v.counter++;
+    return stream;
+}
+
+TEST(Logger, Levels) {
+    debug::Logger first("test.first");
+    debug::Logger second("test.second");
+
+    debug::Logger::setLevel(debug::LogLevel::warning);
+    EXPECT_FALSE(first.isEnabled(debug::LogLevel::info));
+    EXPECT_TRUE(first.isEnabled(debug::LogLevel::error));
+    EXPECT_TRUE(first.isEnabled(debug::LogLevel::print));
+
+    debug::Logger::setLevel("test.first", debug::LogLevel::debug);
+    EXPECT_TRUE(first.isEnabled(debug::LogLevel::debug));
+    EXPECT_FALSE(second.isEnabled(debug::LogLevel::info));
+    // loggers having the same name share the level
+    EXPECT_TRUE(debug::Logger("test.first").isEnabled(debug::LogLevel::debug));
+
+    // module level is kept
+    debug::Logger::setLevel(debug::LogLevel::error);
+    EXPECT_TRUE(first.isEnabled(debug::LogLevel::info));
+    EXPECT_FALSE(second.isEnabled(debug::LogLevel::warning));
+
+    int formatted = 0;
+    second.info() << CountedValue {formatted};
+    EXPECT_EQ(formatted, 0);
+
+    debug::Logger::setLevel(debug::LogLevel::info);
+}
+
+TEST(Logger, ParseLevel) {
+    debug::LogLevel level;
+    EXPECT_TRUE(debug::Logger::parseLevel("warning", level));
+    EXPECT_EQ(level, debug::LogLevel::warning);
+    EXPECT_FALSE(debug::Logger::parseLevel("verbose", level));
+}
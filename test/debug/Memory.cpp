@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
+
+#include "debug/Memory.hpp"
+
+using namespace debug;
+
+static size_t usage_of(MemoryTag tag) {
+    return memory::collect()[static_cast<size_t>(tag)];
+}
+
+TEST(Memory, CountersAndSources) {
+    size_t base = usage_of(MemoryTag::TEXTURES);
+    memory::add(MemoryTag::TEXTURES, 1000);
+    EXPECT_EQ(base + 1000, usage_of(MemoryTag::TEXTURES));
+    {
+        auto handler = memory::add_source(MemoryTag::TEXTURES, []() {
+            return size_t(24);
+        });
+        EXPECT_EQ(base + 1024, usage_of(MemoryTag::TEXTURES));
+    }
+    memory::add(MemoryTag::TEXTURES, -1000);
+    EXPECT_EQ(base, usage_of(MemoryTag::TEXTURES));
+}
+
+TEST(Memory, BudgetEviction) {
+    size_t regions = 3000;
+    size_t unloaded = 2000;
+    std::vector<MemoryTag> evicted;
+    auto regionsSource = memory::add_source(
+        MemoryTag::REGIONS,
+        [&]() { return regions; },
+        [&](size_t bytes) {
+            evicted.push_back(MemoryTag::REGIONS);
+            size_t released = std::min(bytes, regions);
+            regions -= released;
+            return released;
+        }
+    );
+    auto unloadedSource = memory::add_source(
+        MemoryTag::UNLOADED_CHUNKS,
+        [&]() { return unloaded; },
+        [&](size_t) {
+            evicted.push_back(MemoryTag::UNLOADED_CHUNKS);
+            unloaded = 0;
+            return size_t(2000);
+        }
+    );
+    auto usage = memory::collect();
+    size_t total = 0;
+    for (size_t bytes : usage) {
+        total += bytes;
+    }
+    memory::set_budget(total - 2500);
+    EXPECT_EQ(2500, memory::enforce_budget());
+    memory::set_budget(0);
+
+    // unloaded chunks are evicted first
+    ASSERT_EQ(2, evicted.size());
+    EXPECT_EQ(MemoryTag::UNLOADED_CHUNKS, evicted[0]);
+    EXPECT_EQ(MemoryTag::REGIONS, evicted[1]);
+    EXPECT_EQ(2500, regions);
+    EXPECT_EQ(0, memory::enforce_budget());
+}
+
+TEST(Memory, VideoPressure) {
+    size_t shadowMaps = 0;
+    auto source = memory::add_source(MemoryTag::SHADOW_MAPS, [&]() {
+        return shadowMaps;
+    });
+    size_t base = memory::video_usage(memory::collect());
+    EXPECT_EQ(0, memory::update_video_pressure());
+
+    memory::set_video_budget(base + 1000);
+    shadowMaps = 950;
+    EXPECT_EQ(1, memory::update_video_pressure());
+    EXPECT_EQ(2, memory::update_video_pressure());
+
+    // level is kept until the usage goes far below the budget
+    shadowMaps = 800;
+    EXPECT_EQ(2, memory::update_video_pressure());
+    shadowMaps = 0;
+    EXPECT_EQ(1, memory::update_video_pressure());
+
+    memory::set_video_budget(0);
+    EXPECT_EQ(0, memory::update_video_pressure());
+    EXPECT_EQ(0, memory::get_video_pressure());
+}
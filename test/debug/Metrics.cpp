@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include "debug/Metrics.hpp"
+
+using namespace debug;
+
+TEST(Metrics, Histogram) {
+    Histogram histogram({0.1, 0.01, 1.0});
+    histogram.observe(0.005);
+    histogram.observe(0.01);
+    histogram.observe(0.5);
+    histogram.observe(2.0);
+
+    ASSERT_EQ(3, histogram.getBounds().size());
+    EXPECT_EQ(0.01, histogram.getBounds()[0]);
+    EXPECT_EQ(2, histogram.getCumulativeCount(0));
+    EXPECT_EQ(2, histogram.getCumulativeCount(1));
+    EXPECT_EQ(3, histogram.getCumulativeCount(2));
+    EXPECT_EQ(4, histogram.getCumulativeCount(3));
+    EXPECT_EQ(4, histogram.getCount());
+    EXPECT_DOUBLE_EQ(2.515, histogram.getSum());
+}
+
+TEST(Metrics, Writer) {
+    Histogram histogram({0.05, 0.1});
+    histogram.observe(0.07);
+
+    MetricsWriter writer;
+    writer.gauge("vc_chunks", "Loaded chunks", 42);
+    writer.counter(
+        "vc_passed_total", "Passed chunks", 3, {{"stage", "io"}}
+    );
+    writer.counter(
+        "vc_passed_total", "Passed chunks", 0.5, {{"stage", "a\"b"}}
+    );
+    writer.histogram("vc_tick_seconds", "Tick duration", histogram);
+
+    EXPECT_EQ(
+        "# HELP vc_chunks Loaded chunks\n"
+        "# TYPE vc_chunks gauge\n"
+        "vc_chunks 42\n"
+        "# HELP vc_passed_total Passed chunks\n"
+        "# TYPE vc_passed_total counter\n"
+        "vc_passed_total{stage=\"io\"} 3\n"
+        "vc_passed_total{stage=\"a\\\"b\"} 0.5\n"
+        "# HELP vc_tick_seconds Tick duration\n"
+        "# TYPE vc_tick_seconds histogram\n"
+        "vc_tick_seconds_bucket{le=\"0.05\"} 0\n"
+        "vc_tick_seconds_bucket{le=\"0.1\"} 1\n"
+        "vc_tick_seconds_bucket{le=\"+Inf\"} 1\n"
+        "vc_tick_seconds_sum 0.07\n"
+        "vc_tick_seconds_count 1\n",
+        writer.build()
+    );
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "debug/Profiler.hpp"
+
+using namespace debug;
+
+static size_t count_events(std::string_view name) {
+    size_t count = 0;
+    for (const auto& thread : profiler::collect()) {
+        for (const auto& event : thread.events) {
+            if (name == event.name) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+TEST(Profiler, Zones) {
+    profiler::clear();
+    {
+        VC_PROFILE_ZONE("test.disabled");
+    }
+    EXPECT_EQ(count_events("test.disabled"), 0);
+
+    profiler::set_enabled(true);
+    for (int i = 0; i < 3; i++) {
+        VC_PROFILE_ZONE("test.zone");
+    }
+    std::thread thread([]() {
+        profiler::set_thread_name("test thread");
+        VC_PROFILE_ZONE("test.thread");
+    });
+    thread.join();
+    profiler::set_enabled(false);
+
+    EXPECT_EQ(count_events("test.zone"), 3);
+    EXPECT_EQ(count_events("test.thread"), 1);
+
+    auto stats = profiler::get_stats(60'000'000'000LL);
+    auto found = std::find_if(stats.begin(), stats.end(), [](const auto& z) {
+        return z.name == "test.zone";
+    });
+    ASSERT_NE(found, stats.end());
+    EXPECT_EQ(found->calls, 3);
+    EXPECT_GE(found->total, found->max);
+
+    auto trace = profiler::to_chrome_trace();
+    EXPECT_NE(trace.find("\"test thread\""), std::string::npos);
+    EXPECT_NE(trace.find("\"test.zone\""), std::string::npos);
+
+    profiler::clear();
+    EXPECT_EQ(count_events("test.zone"), 0);
+}
+
+TEST(Profiler, RingOverflow) {
+    profiler::clear();
+    size_t total = profiler::BUFFER_CAPACITY + 100;
+    for (size_t i = 0; i < total; i++) {
+        profiler::record("test.overflow", i, i + 1);
+    }
+    std::vector<ProfilerEvent> events;
+    for (const auto& thread : profiler::collect()) {
+        for (const auto& event : thread.events) {
+            if (std::string_view("test.overflow") == event.name) {
+                events.push_back(event);
+            }
+        }
+    }
+    // the oldest slot may be rewritten by the owner thread while copying
+    ASSERT_EQ(events.size(), profiler::BUFFER_CAPACITY - 1);
+    EXPECT_EQ(events.front().start, 101);
+    EXPECT_EQ(events.back().start, total - 1);
+    profiler::clear();
+}
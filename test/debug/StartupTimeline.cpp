@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "debug/StartupTimeline.hpp"
+
+using namespace debug;
+
+TEST(StartupTimeline, Phases) {
+    StartupTimeline timeline;
+    {
+        auto outer = timeline.phase("test.outer");
+        std::thread thread([&timeline]() {
+            auto phase = timeline.phase("test.concurrent");
+        });
+        {
+            auto inner = timeline.phase("test.inner");
+        }
+        thread.join();
+    }
+    auto phases = timeline.getPhases();
+    ASSERT_EQ(3, phases.size());
+    EXPECT_STREQ("test.outer", phases[0].name);
+    for (size_t i = 1; i < phases.size(); i++) {
+        EXPECT_LE(phases[i - 1].start, phases[i].start);
+        EXPECT_GE(phases[i].start, phases[0].start);
+        EXPECT_LE(
+            phases[i].start + phases[i].duration,
+            phases[0].start + phases[0].duration
+        );
+    }
+    EXPECT_NE(std::string::npos, timeline.toString().find("test.inner"));
+}
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+#include "devtools/InputJournal.hpp"
+
+using namespace devtools;
+
+TEST(InputJournal, RecordReplay) {
+    auto file = std::filesystem::temp_directory_path() / "vc_test_inputs.bin";
+    {
+        auto journal = InputJournal::record(file, 30);
+        journal->add(JournalEntryType::CALL_RESULT, dv::object({{"n", 0}}));
+        journal->nextTick();
+        journal->nextTick();
+        journal->add(JournalEntryType::COMMAND, std::string("time.set 0.5"));
+        EXPECT_EQ(42, journal->pass(42).asInteger());
+        journal->nextTick();
+        journal->nextTick();
+    }
+    auto journal = InputJournal::replay(file);
+    EXPECT_TRUE(journal->isReplaying());
+    EXPECT_EQ(30, journal->getTps());
+
+    EXPECT_FALSE(journal->isFinished());
+    EXPECT_EQ(0, journal->take(JournalEntryType::CALL_RESULT)["n"].asInteger());
+    journal->nextTick();
+    EXPECT_THROW(journal->pass(0), std::runtime_error);
+    EXPECT_TRUE(journal->takeCommands().empty());
+    journal->nextTick();
+
+    auto commands = journal->takeCommands();
+    ASSERT_EQ(1, commands.size());
+    EXPECT_EQ("time.set 0.5", commands[0]);
+    EXPECT_EQ(42, journal->pass(7).asInteger());
+    journal->nextTick();
+    EXPECT_FALSE(journal->isFinished());
+    journal->nextTick();
+    EXPECT_TRUE(journal->isFinished());
+    journal.reset();
+    std::filesystem::remove(file);
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "coders/syntax_parser.hpp"
+#include "devtools/SyntaxProcessor.hpp"
+#include "graphics/core/Font.hpp"
+
+using namespace devtools;
+
+static std::unique_ptr<Syntax> create_lua_syntax() {
+    auto syntax = std::make_unique<Syntax>();
+    syntax->language = "Lua";
+    syntax->extensions = {"lua"};
+    syntax->keywords = {L"local", L"function", L"end", L"if", L"then", L"return"};
+    syntax->lineComment = L"--";
+    syntax->multilineCommentStart = L"--[[";
+    syntax->multilineCommentEnd = L"]]";
+    syntax->multilineStringStart = L"[[";
+    syntax->multilineStringEnd = L"]]";
+    return syntax;
+}
+
+static unsigned char style_at(const FontStylesScheme& styles, size_t i) {
+    return styles.map.at(std::min(styles.map.size() - 1, i));
+}
+
+TEST(SyntaxProcessor, IncrementalSameAsFull) {
+    SyntaxProcessor processor;
+    processor.addSyntax(create_lua_syntax());
+
+    FontStylesScheme scheme {};
+    scheme.palette.resize(5);
+
+    const std::wstring fragments[] {
+        L"local x = 10\n", L"-- comment\n", L"--[[ long\ncomment ]]\n",
+        L"s = [[multi\nline]]\n", L"function f() return 'str' end\n",
+        L"\n", L"]]", L"--[[", L"[[", L"'", L"if x then", L"1.5", L" end\n",
+    };
+    std::mt19937 random(7);
+    std::wstring source;
+    for (int i = 0; i < 40; i++) {
+        source += fragments[random() % std::size(fragments)];
+    }
+
+    HighlightCache cache;
+    for (int step = 0; step < 500; step++) {
+        size_t pos = random() % (source.length() + 1);
+        if (random() % 2 && !source.empty()) {
+            size_t length = std::min<size_t>(
+                random() % 8 + 1, source.length() - std::min(pos, source.length() - 1)
+            );
+            source.erase(std::min(pos, source.length() - 1), length);
+        } else {
+            source.insert(pos, fragments[random() % std::size(fragments)]);
+        }
+        auto full = processor.highlight(scheme, "lua", source);
+        auto incremental = processor.highlight(scheme, "lua", source, cache);
+        ASSERT_EQ(full == nullptr, incremental == nullptr);
+        if (full == nullptr) {
+            continue;
+        }
+        for (size_t i = 0; i <= source.length(); i++) {
+            ASSERT_EQ(style_at(*full, i), style_at(*incremental, i))
+                << "step " << step << " index " << i;
+        }
+    }
+}
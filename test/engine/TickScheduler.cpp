@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "engine/TickScheduler.hpp"
+
+using namespace std::chrono;
+
+TEST(TickScheduler, FixedInterval) {
+    TickScheduler scheduler(100, 5);
+    auto begin = steady_clock::now();
+    scheduler.start();
+    for (int i = 0; i < 10; i++) {
+        scheduler.waitNextTick();
+    }
+    auto elapsed = duration<double>(steady_clock::now() - begin).count();
+    EXPECT_GE(elapsed, 0.1);
+    EXPECT_LT(elapsed, 0.5);
+
+    const auto& metrics = scheduler.getMetrics();
+    EXPECT_EQ(metrics.ticks, 10);
+    EXPECT_EQ(metrics.skippedTicks, 0);
+}
+
+TEST(TickScheduler, CatchUp) {
+    TickScheduler scheduler(100, 3);
+    scheduler.start();
+    // overrun by ~10 ticks
+    std::this_thread::sleep_for(milliseconds(105));
+    for (int i = 0; i < 4; i++) {
+        scheduler.waitNextTick();
+    }
+    const auto& metrics = scheduler.getMetrics();
+    EXPECT_EQ(metrics.catchUpTicks, 3);
+    EXPECT_GE(metrics.skippedTicks, 5);
+    EXPECT_GT(metrics.maxLag, 0.05);
+
+    // schedule is reset, so the next tick waits again
+    auto begin = steady_clock::now();
+    scheduler.waitNextTick();
+    EXPECT_GT(duration<double>(steady_clock::now() - begin).count(), 0.001);
+}
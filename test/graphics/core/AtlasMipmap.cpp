@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include "graphics/core/Atlas.hpp"
+#include "graphics/core/ImageData.hpp"
+
+TEST(AtlasMipmap, NoBleeding) {
+    const uint width = 32;
+    const uint height = 16;
+    ImageData image(ImageFormat::RGBA8888, width, height);
+    ubyte* data = image.getData();
+    // two 16x16 regions: red on the left, blue on the right
+    for (uint y = 0; y < height; y++) {
+        for (uint x = 0; x < width; x++) {
+            ubyte* pixel = data + (y * width + x) * 4;
+            pixel[0] = x < 16 ? 255 : 0;
+            pixel[1] = 0;
+            pixel[2] = x < 16 ? 0 : 255;
+            pixel[3] = 255;
+        }
+    }
+    std::vector<glm::ivec4> regions {{0, 0, 16, 16}, {16, 0, 16, 16}};
+    for (uint level = 1; level <= 4; level++) {
+        auto mipmap = build_atlas_mipmap(image, regions, level, 2);
+        ASSERT_EQ(mipmap->getWidth(), width >> level);
+        ASSERT_EQ(mipmap->getHeight(), height >> level);
+        const ubyte* texels = mipmap->getData();
+        uint half = mipmap->getWidth() / 2;
+        for (uint y = 0; y < mipmap->getHeight(); y++) {
+            for (uint x = 0; x < mipmap->getWidth(); x++) {
+                const ubyte* texel = texels + (y * mipmap->getWidth() + x) * 4;
+                EXPECT_EQ(texel[0], x < half ? 255 : 0);
+                EXPECT_EQ(texel[2], x < half ? 0 : 255);
+                EXPECT_EQ(texel[3], 255);
+            }
+        }
+    }
+}
+
+TEST(AtlasMipmap, Average) {
+    ImageData image(ImageFormat::RGBA8888, 4, 4);
+    ubyte* data = image.getData();
+    for (uint i = 0; i < 16; i++) {
+        ubyte value = (i % 2) ? 200 : 100;
+        data[i * 4] = data[i * 4 + 1] = data[i * 4 + 2] = value;
+        data[i * 4 + 3] = 255;
+    }
+    auto mipmap = build_atlas_mipmap(image, {{0, 0, 4, 4}}, 1, 0);
+    for (uint i = 0; i < 4; i++) {
+        EXPECT_EQ(mipmap->getData()[i * 4], 150);
+    }
+}
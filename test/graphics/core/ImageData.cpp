@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+
+#include "graphics/core/ImageData.hpp"
+
+static std::unique_ptr<ImageData> random_image(
+    uint width, uint height, uint seed
+) {
+    auto image = std::make_unique<ImageData>(
+        ImageFormat::RGBA8888, width, height
+    );
+    std::mt19937 random(seed);
+    ubyte* data = image->getData();
+    for (size_t i = 0; i < image->getDataSize(); i++) {
+        data[i] = static_cast<ubyte>(random());
+    }
+    return image;
+}
+
+TEST(ImageData, BlendKernels) {
+    // odd size to cover vectorized and scalar tails
+    const uint width = 13;
+    const uint height = 7;
+    auto other = random_image(width, height, 2);
+    const glm::ivec4 color {200, 17, 255, 0};
+    const ubyte* src = other->getData();
+
+    auto check = [&](auto apply, auto expected) {
+        auto image = random_image(width, height, 1);
+        auto original = random_image(width, height, 1);
+        apply(*image);
+        const ubyte* data = image->getData();
+        const ubyte* orig = original->getData();
+        for (size_t i = 0; i < image->getDataSize(); i++) {
+            ASSERT_EQ(data[i], expected(orig[i], src[i], color[i % 4])) << i;
+        }
+    };
+    auto clamp = [](int value) { return std::min(std::max(value, 0), 255); };
+    check(
+        [&](ImageData& image) { image.mulColor(*other); },
+        [](int a, int b, int) { return a * b / 255; }
+    );
+    check(
+        [&](ImageData& image) { image.mulColor(color); },
+        [](int a, int, int c) { return a * c / 255; }
+    );
+    check(
+        [&](ImageData& image) { image.addColor(*other, 1); },
+        [&](int a, int b, int) { return clamp(a + b); }
+    );
+    check(
+        [&](ImageData& image) { image.addColor(*other, -1); },
+        [&](int a, int b, int) { return clamp(a - b); }
+    );
+    check(
+        [&](ImageData& image) { image.addColor(color, -1); },
+        [&](int a, int, int c) { return clamp(a - c); }
+    );
+    check(
+        [&](ImageData& image) { image.addColor(color, 2); },
+        [&](int a, int, int c) { return clamp(a + c * 2); }
+    );
+}
+
+TEST(ImageData, DirtyRegion) {
+    ImageData image(ImageFormat::RGBA8888, 64, 32);
+    auto dirty = image.getDirty();
+    EXPECT_EQ(64, dirty.w);
+    EXPECT_EQ(32, dirty.h);
+
+    image.resetDirty();
+    EXPECT_TRUE(image.getDirty().empty());
+
+    image.drawLine(10, 5, 4, 8, {255, 0, 0, 255});
+    image.markDirty(60, 30, 10, 10);
+    dirty = image.getDirty();
+    EXPECT_EQ(4, dirty.x);
+    EXPECT_EQ(5, dirty.y);
+    EXPECT_EQ(60, dirty.w);
+    EXPECT_EQ(27, dirty.h);
+
+    image.resetDirty();
+    ImageData small(ImageFormat::RGBA8888, 4, 4);
+    image.blit(small, -2, 30);
+    dirty = image.getDirty();
+    EXPECT_EQ(0, dirty.x);
+    EXPECT_EQ(30, dirty.y);
+    EXPECT_EQ(2, dirty.w);
+    EXPECT_EQ(2, dirty.h);
+
+    image.resetDirty();
+    image.disableDirtyTracking();
+    EXPECT_EQ(64, image.getDirty().w);
+}
+
+TEST(ImageData, BlitClipping) {
+    auto source = random_image(5, 3, 3);
+    ImageData image(ImageFormat::RGBA8888, 4, 4);
+    std::fill(image.getData(), image.getData() + image.getDataSize(), 0);
+    image.blit(*source, -1, 2);
+    const ubyte* dst = image.getData();
+    const ubyte* src = source->getData();
+    for (uint y = 0; y < 4; y++) {
+        for (uint x = 0; x < 4; x++) {
+            for (uint c = 0; c < 4; c++) {
+                int sx = x + 1;
+                int sy = static_cast<int>(y) - 2;
+                ubyte expected = sy >= 0 && sy < 3 && sx < 5
+                                     ? src[(sy * 5 + sx) * 4 + c]
+                                     : 0;
+                ASSERT_EQ(expected, dst[(y * 4 + x) * 4 + c]);
+            }
+        }
+    }
+}
@@ -0,0 +1,26 @@
+#include <gtest/gtest.h>
+
+#include "graphics/render/DynamicResolution.hpp"
+
+TEST(DynamicResolution, Adapts) {
+    DynamicResolution resolution;
+    const float target = 1.0f / 60.0f;
+    for (int i = 0; i < 100; i++) {
+        resolution.update(target, target);
+    }
+    EXPECT_FLOAT_EQ(resolution.getScale(), 1.0f);
+
+    // twice slower frames
+    for (int i = 0; i < 100; i++) {
+        resolution.update(target * 2.0f, target);
+    }
+    float scale = resolution.getScale();
+    EXPECT_LT(scale, 0.8f);
+    EXPECT_GE(scale, DynamicResolution::MIN_SCALE);
+
+    // much faster frames
+    for (int i = 0; i < 1000; i++) {
+        resolution.update(target * 0.25f, target);
+    }
+    EXPECT_FLOAT_EQ(resolution.getScale(), 1.0f);
+}
@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+
+#include "graphics/render/FrameGraph.hpp"
+
+TEST(FrameGraph, PassesCulling) {
+    FrameGraph graph;
+    std::vector<std::string> order;
+    auto pass = [&order](const char* name) {
+        return [&order, name]() { order.emplace_back(name); };
+    };
+    graph.addPass("shadows", {}, {"shadow-map"}, pass("shadows"));
+    graph.addPass("unused", {}, {"unused"}, pass("unused"));
+    graph.addPass("opaque", {"shadow-map"}, {"scene"}, pass("opaque"));
+    graph.addPass("disabled", {"scene"}, {"scene"}, pass("disabled"), false);
+    graph.addPass("post", {"scene"}, {"screen"}, pass("post"));
+    graph.addPass("overlay", {"screen"}, {"screen"}, pass("overlay"));
+    graph.addOutput("screen");
+    graph.execute();
+
+    std::vector<std::string> expected {"shadows", "opaque", "post", "overlay"};
+    EXPECT_EQ(order, expected);
+    EXPECT_FALSE(graph.wasExecuted("unused"));
+    EXPECT_TRUE(graph.wasExecuted("post"));
+}
+
+TEST(FrameGraph, OverwrittenResource) {
+    FrameGraph graph;
+    int executed = 0;
+    graph.addPass("first", {}, {"screen"}, [&]() { executed |= 1; });
+    graph.addPass("second", {}, {"screen"}, [&]() { executed |= 2; });
+    graph.addOutput("screen");
+    graph.execute();
+
+    // the second pass does not read the resource written by the first one
+    EXPECT_EQ(executed, 2);
+}
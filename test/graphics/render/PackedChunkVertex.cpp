@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include "graphics/render/commons.hpp"
+
+static glm::vec3 decode_position(const PackedChunkVertex& vertex) {
+    return glm::vec3(
+        vertex.position[0], vertex.position[1], vertex.position[2]
+    ) / PackedChunkVertex::POSITION_SCALE + glm::vec3(
+        PackedChunkVertex::ORIGIN_X,
+        PackedChunkVertex::ORIGIN_Y,
+        PackedChunkVertex::ORIGIN_Z
+    );
+}
+
+TEST(PackedChunkVertex, Position) {
+    const glm::vec3 positions[] {
+        {-0.5f, -0.5f, -0.5f},
+        {15.5f, 255.5f, 15.5f},
+        {3.0625f, 100.4375f, 7.8125f},
+    };
+    for (const auto& position : positions) {
+        ChunkVertex vertex {position, {0.25f, 0.75f}, {}, {}, {}};
+        auto packed = PackedChunkVertex::pack(vertex);
+        // block model coordinates (1/16 grid) are exact
+        EXPECT_EQ(decode_position(packed), position);
+        EXPECT_NEAR(packed.uv[0] / 65535.0f, 0.25f, 1e-4f);
+    }
+    ChunkVertex vertex {{0.1234f, 17.777f, -3.3f}, {}, {}, {}, {}};
+    auto decoded = decode_position(PackedChunkVertex::pack(vertex));
+    float eps = 0.5f / PackedChunkVertex::POSITION_SCALE;
+    EXPECT_NEAR(decoded.x, vertex.position.x, eps);
+    EXPECT_NEAR(decoded.y, vertex.position.y, eps);
+    EXPECT_NEAR(decoded.z, vertex.position.z, eps);
+}
+
+TEST(PackedChunkVertex, GreedyTiles) {
+    ChunkVertex vertex {{}, {16.0f, 3.0f}, {}, {}, {10, 20, 30, 40}};
+    auto packed = PackedChunkVertex::pack(vertex);
+    EXPECT_EQ(packed.uv[0], 0xFFFF);
+    EXPECT_NEAR(
+        packed.uv[1] / 65535.0f * PackedChunkVertex::MAX_TILES, 3.0f, 1e-3f
+    );
+}
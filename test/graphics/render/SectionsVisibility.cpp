@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+
+#include "graphics/render/SectionsVisibility.hpp"
+#include "maths/voxmaths.hpp"
+
+TEST(SectionsVisibility, Connectivity) {
+    std::vector<char> voxels(CHUNK_SECTION_VOL, false);
+    auto occluding = reinterpret_cast<const bool*>(voxels.data());
+    EXPECT_EQ(calculate_connectivity(occluding), SectionConnectivity::all());
+
+    std::fill(voxels.begin(), voxels.end(), true);
+    EXPECT_EQ(calculate_connectivity(occluding).getBits(), 0);
+
+    // wall splitting the section along x
+    std::fill(voxels.begin(), voxels.end(), false);
+    for (int y = 0; y < CHUNK_SECTION_H; y++) {
+        for (int z = 0; z < CHUNK_D; z++) {
+            voxels[vox_index(CHUNK_W / 2, y, z, CHUNK_W, CHUNK_D)] = true;
+        }
+    }
+    auto connectivity = calculate_connectivity(occluding);
+    EXPECT_FALSE(connectivity.isConnected(0, 1));
+    for (int face = 2; face < SectionConnectivity::FACES; face++) {
+        EXPECT_TRUE(connectivity.isConnected(0, face));
+        EXPECT_TRUE(connectivity.isConnected(1, face));
+    }
+}
+
+TEST(SectionsVisibility, WallOccludes) {
+    const int width = 3;
+    sections_connectivity open;
+    open.fill(SectionConnectivity::all());
+    sections_connectivity closed;
+    closed.fill(SectionConnectivity());
+
+    std::vector<const sections_connectivity*> chunks {&open, &closed, &open};
+    glm::vec3 camera(CHUNK_W * 0.5f, CHUNK_SECTION_H * 0.5f, CHUNK_D * 0.5f);
+
+    SectionsVisibility visibility;
+    ASSERT_TRUE(visibility.update(width, 1, {0, 0}, chunks, camera, nullptr));
+    EXPECT_EQ(visibility.getVisible(0), CHUNK_ALL_SECTIONS);
+    // wall sections are visible, but nothing behind them
+    EXPECT_EQ(visibility.getVisible(1), CHUNK_ALL_SECTIONS);
+    EXPECT_EQ(visibility.getVisible(2), 0);
+
+    chunks[1] = &open;
+    ASSERT_TRUE(visibility.update(width, 1, {0, 0}, chunks, camera, nullptr));
+    EXPECT_EQ(visibility.getVisible(2), CHUNK_ALL_SECTIONS);
+
+    // camera outside of the meshed chunks
+    chunks[0] = nullptr;
+    EXPECT_FALSE(visibility.update(width, 1, {0, 0}, chunks, camera, nullptr));
+}
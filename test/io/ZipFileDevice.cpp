@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "io/io.hpp"
+#include "io/devices/StdfsDevice.hpp"
+#include "io/devices/ZipFileDevice.hpp"
+
+static std::vector<std::string> list_names(
+    io::Device& device, std::string_view path
+) {
+    std::vector<std::string> names;
+    auto generator = device.list(path);
+    io::path name;
+    while (generator->next(name)) {
+        names.push_back(name.string());
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+TEST(io, ZipFileDevice) {
+    auto root = std::filesystem::temp_directory_path() / "vc_zip_test";
+    std::filesystem::remove_all(root);
+    io::set_device("ziptest", std::make_shared<io::StdfsDevice>(root));
+    io::create_directories("ziptest:pack/textures/blocks");
+    // large enough to be streamed instead of caching
+    std::string text(300000, 'a');
+    for (size_t i = 0; i < text.length(); i += 7) {
+        text[i] = 'b' + i % 11;
+    }
+    io::write_string("ziptest:pack/package.json", "{}");
+    io::write_string("ziptest:pack/textures/blocks/stone.txt", text);
+    io::write_zip("ziptest:pack", "ziptest:pack.zip");
+
+    io::ZipFileDevice device(io::read("ziptest:pack.zip"), []() {
+        return io::read("ziptest:pack.zip");
+    });
+    EXPECT_TRUE(device.isdir("textures/blocks"));
+    EXPECT_TRUE(device.isfile("textures/blocks/stone.txt"));
+    EXPECT_EQ(
+        list_names(device, ""),
+        std::vector<std::string>({"package.json", "textures"})
+    );
+    EXPECT_EQ(
+        list_names(device, "textures/blocks"),
+        std::vector<std::string>({"stone.txt"})
+    );
+    auto stream = device.read("textures/blocks/stone.txt");
+    std::string content(text.length(), '\0');
+    stream->read(content.data(), content.length());
+    EXPECT_EQ(stream->gcount(), text.length());
+    EXPECT_EQ(content, text);
+
+    // second read is taken from the cache
+    for (int i = 0; i < 2; i++) {
+        auto stream = device.read("package.json");
+        std::string content(2, '\0');
+        stream->read(content.data(), content.length());
+        EXPECT_EQ(content, "{}");
+    }
+    io::remove_device("ziptest");
+    std::filesystem::remove_all(root);
+}
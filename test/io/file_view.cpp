@@ -0,0 +1,21 @@
+#include <gtest/gtest.h>
+
+#include "io/io.hpp"
+#include "io/devices/StdfsDevice.hpp"
+
+TEST(io, read_view) {
+    auto root = std::filesystem::temp_directory_path() / "vc_view_test";
+    std::filesystem::remove_all(root);
+    io::set_device("viewtest", std::make_shared<io::StdfsDevice>(root));
+
+    std::string large(200000, 'x');
+    large[1000] = 'y';
+    io::write_string("viewtest:small.txt", "small");
+    io::write_string("viewtest:large.txt", large);
+
+    EXPECT_EQ(io::read_view("viewtest:small.txt").text(), "small");
+    EXPECT_EQ(io::read_view("viewtest:large.txt").text(), large);
+
+    io::remove_device("viewtest");
+    std::filesystem::remove_all(root);
+}
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+
+#include "content/Content.hpp"
+#include "lighting/LightSolver.hpp"
+#include "lighting/Lightmap.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+
+TEST(LightSolver, IsolatedAddRemove) {
+    Block air("core:air");
+    air.lightPassing = true;
+    Block lamp("test:lamp");
+    lamp.emission[0] = 15;
+    ContentIndices indices(
+        {std::vector<Block*> {&air, &lamp}},
+        {std::vector<ItemDef*> {}},
+        {std::vector<EntityDef*> {}}
+    );
+    Chunk chunk(0, 0, std::make_shared<Lightmap>());
+
+    LightSolver solver(indices, 0);
+    solver.setIsolatedChunk(&chunk);
+
+    // lamp at the chunk border: light does not leave the chunk
+    chunk.getVoxels()[vox_index(0, 10, 8)].id = 1;
+    solver.add(0, 10, 8, 15);
+    solver.solve(&chunk);
+
+    const auto& lightmap = *chunk.lightmap;
+    EXPECT_EQ(lightmap.getR(0, 10, 8), 15);
+    EXPECT_EQ(lightmap.getR(1, 10, 8), 14);
+    EXPECT_EQ(lightmap.getR(5, 12, 8), 8);
+    EXPECT_EQ(lightmap.getR(14, 10, 8), 1);
+    EXPECT_EQ(lightmap.getR(15, 10, 8), 0);
+
+    chunk.getVoxels()[vox_index(0, 10, 8)].id = 0;
+    solver.remove(0, 10, 8);
+    solver.solve(&chunk);
+    EXPECT_EQ(lightmap.getR(0, 10, 8), 0);
+    EXPECT_EQ(lightmap.getR(5, 12, 8), 0);
+
+    chunk.lightmap->compact();
+    EXPECT_EQ(lightmap.countDenseSections(), 0);
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include "lighting/Lightmap.hpp"
+
+TEST(Lightmap, SparseSections) {
+    Lightmap lightmap;
+    EXPECT_EQ(lightmap.countDenseSections(), 0);
+    EXPECT_EQ(lightmap.get(3, 100, 7), 0);
+
+    // writing the same value does not allocate section
+    lightmap.setS(3, 100, 7, 0);
+    EXPECT_EQ(lightmap.countDenseSections(), 0);
+
+    lightmap.setS(3, 100, 7, 15);
+    lightmap.setR(3, 100, 7, 4);
+    EXPECT_EQ(lightmap.countDenseSections(), 1);
+    EXPECT_FALSE(lightmap.isSectionUniform(100 / CHUNK_SECTION_H));
+    EXPECT_EQ(lightmap.getS(3, 100, 7), 15);
+    EXPECT_EQ(lightmap.getR(3, 100, 7), 4);
+    EXPECT_EQ(lightmap.getRow(100, 7)[3], Lightmap::combine(4, 0, 0, 15));
+    EXPECT_EQ(lightmap.get(4, 100, 7), 0);
+
+    lightmap.set(3, 100, 7, 0, 0);
+    lightmap.set(3, 100, 7, 3, 0);
+    lightmap.compact();
+    EXPECT_EQ(lightmap.countDenseSections(), 0);
+
+    for (int section = 8; section < CHUNK_SECTIONS; section++) {
+        lightmap.orSection(section, Lightmap::SUN_LIGHT_ONLY);
+    }
+    EXPECT_EQ(lightmap.getS(0, CHUNK_H - 1, 0), 15);
+    EXPECT_EQ(lightmap.getS(0, 8 * CHUNK_SECTION_H - 1, 0), 0);
+    EXPECT_EQ(lightmap.countDenseSections(), 0);
+}
+
+TEST(Lightmap, EncodeDecode) {
+    Lightmap source;
+    source.fill(Lightmap::SUN_LIGHT_ONLY);
+    for (int y = 0; y < 40; y++) {
+        source.setS(y % CHUNK_W, y, (y * 7) % CHUNK_D, y % 15);
+    }
+    auto bytes = source.encode();
+
+    Lightmap decoded;
+    decoded.decode(bytes.get());
+    // sections above y=40 are restored uniform
+    EXPECT_EQ(decoded.countDenseSections(), 3);
+    for (int y = 0; y < CHUNK_H; y++) {
+        for (int z = 0; z < CHUNK_D; z++) {
+            for (int x = 0; x < CHUNK_W; x++) {
+                ASSERT_EQ(decoded.getS(x, y, z), source.getS(x, y, z));
+            }
+        }
+    }
+}
+
+TEST(Lightmap, Merge) {
+    Lightmap a;
+    Lightmap b;
+    a.setR(1, 2, 3, 7);
+    b.setR(1, 2, 3, 5);
+    b.setG(1, 2, 3, 9);
+    b.orSection(CHUNK_SECTIONS - 1, Lightmap::SUN_LIGHT_ONLY);
+    a.merge(b);
+    EXPECT_EQ(a.getR(1, 2, 3), 7);
+    EXPECT_EQ(a.getG(1, 2, 3), 9);
+    EXPECT_EQ(a.getS(0, CHUNK_H - 1, 0), 15);
+    EXPECT_TRUE(a.isSectionUniform(CHUNK_SECTIONS - 1));
+
+    Lightmap copy;
+    copy.set(&a);
+    EXPECT_EQ(copy.get(1, 2, 3), a.get(1, 2, 3));
+    EXPECT_EQ(copy.countDenseSections(), a.countDenseSections());
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include "content/Content.hpp"
+#include "lighting/Lightmap.hpp"
+#include "logic/CellularSimulation.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/BlocksBatch.hpp"
+#include "voxels/Chunk.hpp"
+
+namespace {
+    struct TestWorld {
+        Block air {"core:air"};
+        Block stone {"test:stone"};
+        Block water {"test:water"};
+        Block sand {"test:sand"};
+        ContentIndices indices;
+        Chunk chunk {0, 0, std::make_shared<Lightmap>()};
+        CellularSimulation simulation;
+
+        TestWorld()
+            : indices(
+                  {std::vector<Block*> {&air, &stone, &water, &sand}},
+                  {std::vector<ItemDef*> {}},
+                  {std::vector<EntityDef*> {}}
+              ),
+              simulation(indices, [this](int cx, int cz) {
+                  return cx == 0 && cz == 0 ? &chunk : nullptr;
+              }) {
+            air.replaceable = true;
+            water.replaceable = true;
+            water.cellular = {CellularType::LIQUID, 4, 1, false};
+            sand.cellular = {CellularType::POWDER, 1, 1, false};
+            for (int z = 0; z < CHUNK_D; z++) {
+                for (int x = 0; x < CHUNK_W; x++) {
+                    chunk.getVoxels()[vox_index(x, 10, z)].id = 1;
+                }
+            }
+        }
+
+        voxel& at(int x, int y, int z) {
+            return chunk.getVoxels()[vox_index(x, y, z)];
+        }
+
+        /// @brief Set block activating it and neighbours as blocks
+        /// updates do
+        void place(int x, int y, int z, blockid_t id) {
+            at(x, y, z) = {id, {}};
+            simulation.activate(x, y, z);
+            simulation.activate(x - 1, y, z);
+            simulation.activate(x + 1, y, z);
+            simulation.activate(x, y - 1, z);
+            simulation.activate(x, y + 1, z);
+            simulation.activate(x, y, z - 1);
+            simulation.activate(x, y, z + 1);
+        }
+
+        /// @brief Run steps applying changes until cells are settled
+        void simulate(int maxSteps) {
+            BlocksBatch batch;
+            for (int tick = 1; tick <= maxSteps; tick++) {
+                simulation.step(tick, batch);
+                for (const auto& entry : batch.getEntries()) {
+                    at(entry.pos.x, entry.pos.y, entry.pos.z) =
+                        {entry.id, entry.state};
+                }
+                batch.clear();
+                if (simulation.getActiveCount() == 0) {
+                    return;
+                }
+            }
+            FAIL() << "cells are not settled";
+        }
+    };
+}
+
+static int level_at(TestWorld& world, int x, int y, int z) {
+    const auto& vox = world.at(x, y, z);
+    if (vox.id != 2) {
+        return -1;
+    }
+    return CellularSimulation::getLevel(vox.state);
+}
+
+TEST(CellularSimulation, LiquidSpreadAndDrain) {
+    TestWorld world;
+    world.place(8, 11, 8, 2);
+    world.simulate(20);
+
+    EXPECT_EQ(0, level_at(world, 8, 11, 8));
+    EXPECT_EQ(1, level_at(world, 9, 11, 8));
+    EXPECT_EQ(2, level_at(world, 10, 11, 8));
+    EXPECT_EQ(2, level_at(world, 9, 11, 9));
+    EXPECT_EQ(3, level_at(world, 8, 11, 5));
+    EXPECT_EQ(-1, level_at(world, 12, 11, 8));
+    EXPECT_EQ(-1, level_at(world, 8, 12, 8));
+
+    // flow is drained when the source is removed
+    world.place(8, 11, 8, 0);
+    world.simulate(40);
+    for (int z = 0; z < CHUNK_D; z++) {
+        for (int x = 0; x < CHUNK_W; x++) {
+            EXPECT_EQ(0, world.at(x, 11, z).id);
+        }
+    }
+}
+
+TEST(CellularSimulation, LiquidFallsDown) {
+    TestWorld world;
+    world.place(4, 15, 4, 2);
+    world.simulate(40);
+
+    EXPECT_EQ(1, level_at(world, 4, 14, 4));
+    EXPECT_EQ(1, level_at(world, 4, 11, 4));
+    // falling liquid does not spread until it lands
+    EXPECT_EQ(-1, level_at(world, 5, 14, 4));
+    EXPECT_EQ(2, level_at(world, 5, 11, 4));
+}
+
+TEST(CellularSimulation, PowderSinksInLiquid) {
+    TestWorld world;
+    world.water.cellular.levels = 1;
+    world.place(3, 11, 3, 2);
+    world.place(3, 15, 3, 3);
+    world.simulate(20);
+
+    EXPECT_EQ(3, world.at(3, 11, 3).id);
+    EXPECT_EQ(2, world.at(3, 12, 3).id);
+    EXPECT_EQ(0, world.at(3, 15, 3).id);
+}
@@ -0,0 +1,56 @@
+#include "logic/CommandsInterpreter.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace cmd;
+
+TEST(CommandsInterpreter, CachedPrompt) {
+    int calls = 0;
+    CommandsInterpreter interpreter;
+    interpreter.getRepository()->add(
+        "sum a:int b:int=$b", "",
+        [&calls](auto, const dv::value& args, auto) {
+            calls++;
+            return args[0].asInteger() + args[1].asInteger();
+        }
+    );
+    interpreter["b"] = 1;
+    EXPECT_EQ(interpreter.execute("sum 2 3").asInteger(), 5);
+    EXPECT_EQ(interpreter.execute("sum 2 3").asInteger(), 5);
+    // prompts reading variables are parsed again
+    EXPECT_EQ(interpreter.execute("sum 2").asInteger(), 3);
+    interpreter["b"] = 10;
+    EXPECT_EQ(interpreter.execute("sum 2").asInteger(), 12);
+
+    // replaced command must not be executed from cache
+    interpreter.getRepository()->add(
+        "sum a:int b:int=$b", "",
+        [](auto, const dv::value& args, auto) {
+            return args[0].asInteger() * args[1].asInteger();
+        }
+    );
+    EXPECT_EQ(interpreter.execute("sum 2 3").asInteger(), 6);
+    EXPECT_EQ(calls, 4);
+}
+
+TEST(CommandsInterpreter, Batch) {
+    CommandsInterpreter interpreter;
+    interpreter.getRepository()->add(
+        "neg a:int", "",
+        [](auto, const dv::value& args, auto) {
+            return -args[0].asInteger();
+        }
+    );
+    std::unordered_map<size_t, std::string> errors;
+    auto results = interpreter.executeBatch(
+        {"neg 1", "unknown 2", "neg x", "neg 1"}, errors
+    );
+    ASSERT_EQ(results.size(), 4);
+    EXPECT_EQ(results[0].asInteger(), -1);
+    EXPECT_TRUE(results[1] == nullptr);
+    EXPECT_TRUE(results[2] == nullptr);
+    EXPECT_EQ(results[3].asInteger(), -1);
+    EXPECT_EQ(errors.size(), 2);
+    EXPECT_EQ(errors.count(1), 1);
+    EXPECT_EQ(errors.count(2), 1);
+}
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include "logic/scripting/lua/lua_profiler.hpp"
+
+using namespace lua;
+
+TEST(LuaProfiler, ChunkFile) {
+    EXPECT_EQ(
+        profiler::chunk_file("[string \"base:scripts/a.lua\"]:12"),
+        "base:scripts/a.lua"
+    );
+    EXPECT_EQ(
+        profiler::chunk_file("base:scripts/a.lua:12"), "base:scripts/a.lua"
+    );
+    EXPECT_EQ(
+        profiler::chunk_file("@core:scripts/b.lua"), "core:scripts/b.lua"
+    );
+    EXPECT_EQ(profiler::chunk_file("[C]"), "[C]");
+    EXPECT_EQ(profiler::pack_of("base:stone.update"), "base");
+    EXPECT_EQ(profiler::pack_of("[C]"), "");
+}
+
+TEST(LuaProfiler, Events) {
+    auto L = luaL_newstate();
+    profiler::clear();
+    profiler::begin_event(L, "base:stone.update");
+    profiler::begin_event(L, "test:.worldtick");
+    lua_createtable(L, 1024, 0);
+    profiler::end_event(L);
+    profiler::end_event(L);
+    profiler::begin_event(L, "base:stone.update");
+    profiler::end_event(L);
+
+    auto stats = profiler::get_stats();
+    ASSERT_EQ(stats.size(), 2);
+    for (const auto& pack : stats) {
+        ASSERT_EQ(pack.events.size(), 1);
+        if (pack.packid == "base") {
+            EXPECT_EQ(pack.calls, 2);
+            // nested event allocations are not included
+            EXPECT_EQ(pack.allocated, 0);
+        } else {
+            EXPECT_EQ(pack.packid, "test");
+            EXPECT_EQ(pack.calls, 1);
+            EXPECT_GT(pack.allocated, 0);
+        }
+    }
+    profiler::clear();
+    EXPECT_TRUE(profiler::get_stats().empty());
+    lua_close(L);
+}
@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "maths/FrustumCulling.hpp"
+
+TEST(FrustumCulling, BatchSameAsSingle) {
+    Frustum frustum;
+    frustum.update(
+        glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 200.0f) *
+        glm::lookAt(
+            glm::vec3(3.0f, 40.0f, -7.0f),
+            glm::vec3(50.0f, 20.0f, 30.0f),
+            glm::vec3(0.0f, 1.0f, 0.0f)
+        )
+    );
+    // odd count to cover the scalar tail
+    BoxesArray boxes;
+    for (int z = -12; z < 13; z++) {
+        for (int x = -12; x < 13; x++) {
+            glm::vec3 min(x * 16.0f, (x * 7 + z * 3) % 64, z * 16.0f);
+            boxes.push_back(min, min + glm::vec3(16.0f, 40.0f, 16.0f));
+        }
+    }
+    std::vector<uint64_t> visible;
+    frustum.areBoxesVisible(boxes, visible);
+    ASSERT_EQ(visible.size(), (boxes.size() + 63) / 64);
+
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < boxes.size(); i++) {
+        glm::vec3 min(boxes.minX[i], boxes.minY[i], boxes.minZ[i]);
+        glm::vec3 max(boxes.maxX[i], boxes.maxY[i], boxes.maxZ[i]);
+        bool expected = frustum.isBoxVisible(min, max);
+        EXPECT_EQ(Frustum::isVisible(visible, i), expected) << "box " << i;
+        visibleCount += expected;
+    }
+    EXPECT_GT(visibleCount, 0u);
+    EXPECT_LT(visibleCount, boxes.size());
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "maths/Heightmap.hpp"
+
+static std::vector<float> make_values(uint width, uint height) {
+    std::vector<float> values(width * height);
+    for (uint i = 0; i < values.size(); i++) {
+        values[i] = ((i * 7919) % 101) / 101.0f;
+    }
+    return values;
+}
+
+TEST(Heightmap, ResizeCroppedSameAsResizeAndCrop) {
+    const uint width = 5;
+    const uint height = 4;
+    auto values = make_values(width, height);
+    for (auto interpolation : {
+             InterpolationType::NEAREST,
+             InterpolationType::LINEAR,
+             InterpolationType::CUBIC,
+         }) {
+        Heightmap expected(width, height, values);
+        expected.resize(37, 29, interpolation);
+        expected.crop(3, 2, 30, 20);
+
+        Heightmap fused(width, height, values);
+        fused.resize(37, 29, interpolation, 3, 2, 30, 20);
+        ASSERT_EQ(30, fused.getWidth());
+        ASSERT_EQ(20, fused.getHeight());
+
+        std::vector<float> dst(30 * 20);
+        Heightmap(width, height, values)
+            .resample(dst.data(), 37, 29, interpolation, 3, 2, 30, 20);
+
+        for (uint i = 0; i < dst.size(); i++) {
+            EXPECT_EQ(expected.getValues()[i], fused.getValues()[i]);
+            EXPECT_EQ(expected.getValues()[i], dst[i]);
+        }
+    }
+}
+
+TEST(Heightmap, ResizeLinear) {
+    Heightmap map(2, 2, {0.0f, 1.0f, 2.0f, 3.0f});
+    map.resize(4, 4, InterpolationType::LINEAR);
+    const float expected[] {
+        0.0f, 0.5f, 1.0f, 1.0f,
+        1.0f, 1.5f, 2.0f, 2.0f,
+        2.0f, 2.5f, 3.0f, 3.0f,
+        2.0f, 2.5f, 3.0f, 3.0f,
+    };
+    for (uint i = 0; i < 16; i++) {
+        EXPECT_FLOAT_EQ(expected[i], map.getValues()[i]);
+    }
+}
+
+TEST(Heightmap, ResampleOutOfBounds) {
+    Heightmap map(4, 4);
+    std::vector<float> dst(16);
+    EXPECT_THROW(
+        map.resample(dst.data(), 8, 8, InterpolationType::CUBIC, 6, 0, 4, 4),
+        std::runtime_error
+    );
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include "maths/FastNoiseLite.h"
+#include "maths/Heightmap.hpp"
+#include "maths/HeightmapGraph.hpp"
+
+using Operand = HeightmapGraph::Operand;
+
+TEST(HeightmapGraph, SameAsSequentialOps) {
+    // size is not a multiple of the tile size
+    const uint w = 37;
+    const uint h = 29;
+    auto input = std::make_shared<Heightmap>(w, h);
+    for (uint i = 0; i < w * h; i++) {
+        input->getValues()[i] = (i % 7) / 7.0f;
+    }
+
+    HeightmapGraph graph(w, h);
+    auto shift = graph.create();
+    HeightmapGraph::NoiseParams shiftNoise {};
+    shiftNoise.seed = 42;
+    shiftNoise.offset = {10.0f, 20.0f};
+    shiftNoise.scale = 0.1f;
+    shiftNoise.octaves = 2;
+    shiftNoise.multiplier = 25.0f;
+    graph.noise(shift, shiftNoise);
+
+    auto map = graph.create();
+    HeightmapGraph::NoiseParams cellNoise {};
+    cellNoise.type = NoiseType::CELLULAR;
+    cellNoise.seed = 7;
+    cellNoise.scale = 0.05f;
+    cellNoise.octaves = 3;
+    cellNoise.shiftY = shift;
+    graph.noise(map, cellNoise);
+    graph.binary(HeightmapBinaryOp::ADD, map, Operand::of(0.5f));
+    graph.abs(map);
+    graph.binary(HeightmapBinaryOp::POW, map, Operand::of(1.5f));
+    auto t = graph.input(input);
+    graph.mixin(map, Operand::of(0.25f), Operand::of(t));
+    graph.binary(HeightmapBinaryOp::MAX, map, Operand::of(shift));
+
+    auto outputs = graph.evaluate({map, shift});
+    ASSERT_EQ(outputs.size(), 2);
+
+    fnl_state simplex = fnlCreateState();
+    simplex.seed = 42;
+    simplex.noise_type = FNL_NOISE_OPENSIMPLEX2;
+    fnl_state cellular = fnlCreateState();
+    cellular.seed = 7;
+    cellular.noise_type = FNL_NOISE_CELLULAR;
+    for (uint y = 0; y < h; y++) {
+        for (uint x = 0; x < w; x++) {
+            uint i = y * w + x;
+            float shiftValue = 0.0f;
+            for (uint c = 0; c < 2; c++) {
+                float m = 0.1f * (1 << c);
+                shiftValue += fnlGetNoise2D(
+                    &simplex, (x + 10.0f) * m, (y + 20.0f) * m
+                ) / static_cast<float>(1 << c) * 25.0f;
+            }
+            float value = 0.0f;
+            for (uint c = 0; c < 3; c++) {
+                float m = 0.05f * (1 << c);
+                value += fnlGetNoise2D(
+                    &cellular, x * m, y * m + shiftValue
+                ) / static_cast<float>(1 << c);
+            }
+            value = glm::pow(glm::abs(value + 0.5f), 1.5f);
+            float tvalue = input->getValues()[i];
+            value = value * (1.0f - tvalue) + 0.25f * tvalue;
+            value = glm::max(value, shiftValue);
+
+            ASSERT_FLOAT_EQ(outputs[1]->getValues()[i], shiftValue);
+            ASSERT_FLOAT_EQ(outputs[0]->getValues()[i], value);
+        }
+    }
+}
+
+TEST(HeightmapGraph, InvalidArguments) {
+    HeightmapGraph graph(4, 4);
+    auto map = graph.create();
+    EXPECT_THROW(graph.abs(map + 1), std::out_of_range);
+    EXPECT_THROW(
+        graph.input(std::make_shared<Heightmap>(2, 4)), std::invalid_argument
+    );
+    EXPECT_THROW(graph.evaluate({map + 1}), std::out_of_range);
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "maths/FastNoiseLite.h"
+#include "maths/noise.hpp"
+
+static void check_same_as_fnl(NoiseType type, fnl_noise_type fnlType) {
+    fnl_state state = fnlCreateState();
+    state.noise_type = fnlType;
+
+    // odd count to cover the padded tail
+    const uint count = 1001;
+    std::vector<float> x(count);
+    std::vector<float> y(count);
+    for (uint i = 0; i < count; i++) {
+        x[i] = (static_cast<int>(i % 37) - 18) * 13.7f + i * 0.31f;
+        y[i] = (static_cast<int>(i / 37) - 13) * 21.3f - i * 0.57f;
+    }
+    std::vector<float> values(count);
+    for (int seed : {0, 42, -7331}) {
+        state.seed = seed;
+        noise::sample2d(type, seed, x.data(), y.data(), values.data(), count);
+        for (uint i = 0; i < count; i++) {
+            ASSERT_NEAR(values[i], fnlGetNoise2D(&state, x[i], y[i]), 1e-5f)
+                << "point " << x[i] << ", " << y[i] << " seed " << seed;
+        }
+    }
+}
+
+TEST(noise, SimplexSameAsFNL) {
+    check_same_as_fnl(NoiseType::SIMPLEX, FNL_NOISE_OPENSIMPLEX2);
+}
+
+TEST(noise, CellularSameAsFNL) {
+    check_same_as_fnl(NoiseType::CELLULAR, FNL_NOISE_CELLULAR);
+}
+
+TEST(noise, Octaves) {
+    const uint width = 19;
+    const uint height = 23;
+    fnl_state state = fnlCreateState();
+    state.seed = 5;
+
+    std::vector<float> expected(width * height, 1.0f);
+    for (uint y = 0; y < height; y++) {
+        for (uint x = 0; x < width; x++) {
+            uint i = y * width + x;
+            for (int c = 0; c < 3; c++) {
+                float m = 0.5f * (1 << c);
+                float u = (x + 10.0f) * m;
+                float v = (y - 3.0f) * m;
+                expected[i] += fnlGetNoise2D(&state, u, v) /
+                               static_cast<float>(1 << c) * 2.0f;
+            }
+        }
+    }
+    std::vector<float> values(width * height, 1.0f);
+    noise::add_octaves2d(
+        NoiseType::SIMPLEX,
+        5,
+        {10.0f, -3.0f},
+        0.5f,
+        3,
+        2.0f,
+        width,
+        0,
+        width * height,
+        values.data(),
+        nullptr,
+        nullptr
+    );
+    for (uint i = 0; i < width * height; i++) {
+        ASSERT_NEAR(values[i], expected[i], 1e-5f);
+    }
+}
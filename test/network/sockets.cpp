@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "network/Network.hpp"
+
+using namespace network;
+
+namespace {
+    class NoRequests : public Requests {
+    public:
+        void get(
+            const std::string&,
+            OnResponse,
+            OnReject,
+            std::vector<std::string>,
+            long
+        ) override {
+        }
+
+        void post(
+            const std::string&,
+            const std::string&,
+            OnResponse,
+            OnReject,
+            std::vector<std::string>,
+            long
+        ) override {
+        }
+
+        size_t getTotalUpload() const override {
+            return 0;
+        }
+
+        size_t getTotalDownload() const override {
+            return 0;
+        }
+
+        void update() override {
+        }
+    };
+}
+
+template <typename Predicate>
+static bool wait_for(Network& network, Predicate&& predicate) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        network.update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+TEST(Sockets, TcpExchange) {
+    Network network(std::make_unique<NoRequests>());
+    int port = network.findFreePort();
+    ASSERT_NE(port, -1);
+
+    std::atomic<u64id_t> serverSide = 0;
+    network.openTcpServer(port, [&](u64id_t, u64id_t cid) {
+        serverSide = cid;
+    });
+    std::atomic<bool> connected = false;
+    u64id_t clientSide = network.connectTcp(
+        "127.0.0.1",
+        port,
+        [&](u64id_t) { connected = true; },
+        [](u64id_t, const std::string& message) { FAIL() << message; }
+    );
+    ASSERT_TRUE(wait_for(network, [&]() { return connected && serverSide; }));
+
+    auto client =
+        dynamic_cast<TcpConnection*>(network.getConnection(clientSide, true));
+    auto server =
+        dynamic_cast<TcpConnection*>(network.getConnection(serverSide, true));
+    ASSERT_NE(client, nullptr);
+    ASSERT_NE(server, nullptr);
+
+    std::string message(100'000, 'x');
+    for (size_t i = 0; i < message.size(); i++) {
+        message[i] = 'a' + i % 26;
+    }
+    EXPECT_EQ(client->send(message.data(), message.size()), message.size());
+    ASSERT_TRUE(wait_for(network, [&]() {
+        return server->available() == message.size();
+    }));
+    std::string received(message.size(), '\0');
+    EXPECT_EQ(server->recv(received.data(), received.size()), message.size());
+    EXPECT_EQ(received, message);
+    EXPECT_EQ(client->getStats().bytesSent, message.size());
+    EXPECT_EQ(server->getStats().bytesReceived, message.size());
+
+    client->close();
+    EXPECT_TRUE(wait_for(network, [&]() {
+        return server->getState() == ConnectionState::CLOSED;
+    }));
+}
+
+TEST(Sockets, TcpVectoredSendPeek) {
+    Network network(std::make_unique<NoRequests>());
+    int port = network.findFreePort();
+    ASSERT_NE(port, -1);
+
+    std::atomic<u64id_t> serverSide = 0;
+    network.openTcpServer(port, [&](u64id_t, u64id_t cid) {
+        serverSide = cid;
+    });
+    std::atomic<bool> connected = false;
+    u64id_t clientSide = network.connectTcp(
+        "127.0.0.1",
+        port,
+        [&](u64id_t) { connected = true; },
+        [](u64id_t, const std::string& message) { FAIL() << message; }
+    );
+    ASSERT_TRUE(wait_for(network, [&]() { return connected && serverSide; }));
+
+    auto client =
+        dynamic_cast<TcpConnection*>(network.getConnection(clientSide, true));
+    auto server =
+        dynamic_cast<TcpConnection*>(network.getConnection(serverSide, true));
+    ASSERT_NE(client, nullptr);
+    ASSERT_NE(server, nullptr);
+
+    std::string payload(50'000, 'p');
+    std::string_view buffers[] {"head", payload, "tail"};
+    size_t total = 8 + payload.size();
+    EXPECT_EQ(client->sendv(buffers, 3), total);
+    ASSERT_TRUE(wait_for(network, [&]() {
+        return server->available() == total;
+    }));
+    char header[4];
+    EXPECT_EQ(server->peek(header, 4), 4);
+    EXPECT_EQ(std::string(header, 4), "head");
+    EXPECT_EQ(server->available(), total);
+    EXPECT_EQ(server->consume(4 + payload.size()), 4 + payload.size());
+    EXPECT_EQ(server->recv(header, 4), 4);
+    EXPECT_EQ(std::string(header, 4), "tail");
+    EXPECT_EQ(server->available(), 0);
+}
+
+TEST(Sockets, TcpConnectRefused) {
+    Network network(std::make_unique<NoRequests>());
+    int port = network.findFreePort();
+    ASSERT_NE(port, -1);
+
+    std::atomic<bool> failed = false;
+    network.connectTcp(
+        "127.0.0.1",
+        port,
+        [](u64id_t) { FAIL() << "connected to closed port"; },
+        [&](u64id_t, const std::string&) { failed = true; }
+    );
+    EXPECT_TRUE(wait_for(network, [&]() { return failed.load(); }));
+}
+
+TEST(Sockets, UdpExchange) {
+    Network network(std::make_unique<NoRequests>());
+    int port = network.findFreePort();
+    ASSERT_NE(port, -1);
+
+    std::atomic<int> received = 0;
+    network.openUdpServer(port, [&](u64id_t, const std::string&, int, const char*, size_t length) {
+        received += length;
+    });
+    u64id_t cid = network.connectUdp(
+        "127.0.0.1", port, [](u64id_t) {}, [](u64id_t, const char*, size_t) {}
+    );
+    auto connection = network.getConnection(cid, true);
+    ASSERT_NE(connection, nullptr);
+    EXPECT_EQ(connection->send("datagram", 8), 8);
+    EXPECT_TRUE(wait_for(network, [&]() { return received == 8; }));
+}
+
+TEST(Sockets, UdpServerBatches) {
+    Network network(std::make_unique<NoRequests>());
+    int port = network.findFreePort();
+    ASSERT_NE(port, -1);
+
+    constexpr int count = 100;
+    std::atomic<int> received = 0;
+    std::atomic<int> clientPort = 0;
+    u64id_t sid = network.openUdpServer(
+        port,
+        [&](u64id_t, const std::string&, int port, const char*, size_t length) {
+            clientPort = port;
+            received += length == 4;
+        }
+    );
+    std::atomic<int> replies = 0;
+    u64id_t cid = network.connectUdp(
+        "127.0.0.1",
+        port,
+        [](u64id_t) {},
+        [&](u64id_t, const char*, size_t length) { replies += length == 5; }
+    );
+    auto connection = network.getConnection(cid, true);
+    ASSERT_NE(connection, nullptr);
+    for (int i = 0; i < count; i++) {
+        connection->send("ping", 4);
+    }
+    ASSERT_TRUE(wait_for(network, [&]() { return received == count; }));
+
+    auto server = dynamic_cast<UdpServer*>(network.getServer(sid, true));
+    ASSERT_NE(server, nullptr);
+    for (int i = 0; i < count; i++) {
+        server->sendTo("127.0.0.1", clientPort, "reply", 5);
+    }
+    // queued datagrams are sent on update
+    EXPECT_TRUE(wait_for(network, [&]() { return replies == count; }));
+
+    auto stats = server->getStats();
+    EXPECT_EQ(stats.packetsReceived, static_cast<size_t>(count));
+    EXPECT_EQ(stats.packetsSent, static_cast<size_t>(count));
+    EXPECT_EQ(stats.bytesSent, static_cast<size_t>(count) * 5);
+    EXPECT_EQ(stats.drops, 0u);
+}
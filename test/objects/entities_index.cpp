@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include "coders/binary_json.hpp"
+#include "objects/entities_index.hpp"
+
+TEST(entities_index, EncodeDecode) {
+    entities_index::Builder builder;
+    for (int i = 0; i < 10; i++) {
+        auto map = dv::object();
+        map["uid"] = i + 1;
+        map["def"] = "test:entity";
+        map["comps"] = dv::object({{"value", i * 10}});
+        auto document = json::to_binary(map);
+        builder.add(
+            i + 1,
+            "test:entity",
+            glm::vec3(i, 0, -i),
+            document.data(),
+            document.size()
+        );
+    }
+    auto bytes = builder.build();
+    ASSERT_TRUE(entities_index::is_indexed(bytes.data(), bytes.size()));
+
+    auto index = entities_index::read(bytes.data(), bytes.size());
+    const auto& headers = index.getHeaders();
+    ASSERT_EQ(headers.size(), 10);
+    EXPECT_EQ(headers[3].uid, 4);
+    EXPECT_EQ(headers[3].def, "test:entity");
+    EXPECT_EQ(headers[3].position, glm::vec3(3, 0, -3));
+
+    auto map = index.decode(7);
+    EXPECT_EQ(map["uid"].asInteger(), 8);
+    EXPECT_EQ(map["comps"]["value"].asInteger(), 70);
+
+    // entries are copied without decoding
+    entities_index::Builder copy;
+    copy.add(index, 7);
+    auto copyBytes = copy.build();
+    auto copyIndex = entities_index::read(copyBytes.data(), copyBytes.size());
+    ASSERT_EQ(copyIndex.getHeaders().size(), 1);
+    EXPECT_EQ(copyIndex.decode(0)["comps"]["value"].asInteger(), 70);
+}
+
+TEST(entities_index, Legacy) {
+    auto root = dv::object();
+    auto& list = root.list("data");
+    auto& entity = list.object();
+    entity["uid"] = 5;
+    entity["def"] = "test:legacy";
+    entity["transform"] = dv::object({{"pos", dv::list({1, 2, 3})}});
+
+    auto bytes = json::to_binary(root, true);
+    ASSERT_FALSE(entities_index::is_indexed(bytes.data(), bytes.size()));
+
+    auto index = entities_index::from_legacy(root);
+    ASSERT_EQ(index.getHeaders().size(), 1);
+    EXPECT_EQ(index.getHeaders()[0].position, glm::vec3(1, 2, 3));
+    EXPECT_EQ(index.decode(0)["def"].asString(), "test:legacy");
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "physics/SpatialGrid.hpp"
+
+static std::vector<int> collect(const SpatialGrid<int>& grid, const AABB& aabb) {
+    std::vector<int> found;
+    grid.query(aabb, [&found](int value) {
+        found.push_back(value);
+    });
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+TEST(SpatialGrid, Query) {
+    SpatialGrid<int> grid(16);
+    grid.insert(1, {1.0f, 1.0f, 1.0f}, 0.5f);
+    grid.insert(2, {15.8f, 1.0f, 1.0f}, 0.5f);
+    grid.insert(3, {-40.0f, 100.0f, 7.0f}, 0.5f);
+    EXPECT_EQ(grid.size(), 3);
+
+    // value bounds crossing the cell border are found from the neighbour
+    EXPECT_EQ(collect(grid, AABB({16.2f, 0, 0}, {17, 2, 2})), std::vector {2});
+    EXPECT_EQ(collect(grid, AABB({0, 0, 0}, {16, 2, 2})), (std::vector {1, 2}));
+    EXPECT_EQ(collect(grid, AABB({-41, 99, 6}, {-39, 101, 8})), std::vector {3});
+    EXPECT_TRUE(collect(grid, AABB({100, 0, 0}, {110, 2, 2})).empty());
+
+    // huge box falls back to iterating existing cells
+    float inf = std::numeric_limits<float>::infinity();
+    EXPECT_EQ(
+        collect(grid, AABB(glm::vec3(-inf), glm::vec3(inf))),
+        (std::vector {1, 2, 3})
+    );
+}
+
+TEST(SpatialGrid, StopAndClear) {
+    SpatialGrid<int> grid(16);
+    for (int i = 0; i < 10; i++) {
+        grid.insert(i, {i * 0.1f, 0.0f, 0.0f}, 0.1f);
+    }
+    int visited = 0;
+    EXPECT_FALSE(grid.query(AABB({0, 0, 0}, {1, 1, 1}), [&](int) {
+        return ++visited < 3;
+    }));
+    EXPECT_EQ(visited, 3);
+
+    grid.clear();
+    EXPECT_EQ(grid.size(), 0);
+    EXPECT_EQ(grid.getMaxExtent(), 0.0f);
+    EXPECT_TRUE(collect(grid, AABB({0, 0, 0}, {1, 1, 1})).empty());
+}
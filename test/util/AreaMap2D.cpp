@@ -76,3 +76,57 @@ TEST(AreaMap2D, TranslateWithOut) {
     EXPECT_EQ(outside, 15);
     EXPECT_EQ(window.count(), 20);
 }
+
+TEST(AreaMap2D, TranslateKeepsPositions) {
+    util::AreaMap2D<int> window({6, 4});
+    window.setCenter(0, 0);
+    auto value_at = [](int x, int y) { return (x + 100) * 1000 + y + 100; };
+    for (int cy = 0; cy < 20; cy++) {
+        int cx = (cy * 7) % 11 - 5;
+        window.setCenter(cx, cy);
+        for (int y = window.getOffsetY();
+             y < window.getOffsetY() + window.getHeight();
+             y++) {
+            for (int x = window.getOffsetX();
+                 x < window.getOffsetX() + window.getWidth();
+                 x++) {
+                if (window.get(x, y)) {
+                    EXPECT_EQ(window.require(x, y), value_at(x, y));
+                } else {
+                    window.set(x, y, value_at(x, y));
+                }
+            }
+        }
+        EXPECT_EQ(window.count(), 6 * 4);
+        for (int ly = 0; ly < window.getHeight(); ly++) {
+            for (int lx = 0; lx < window.getWidth(); lx++) {
+                EXPECT_EQ(
+                    window.getLocal(lx, ly),
+                    value_at(
+                        lx + window.getOffsetX(), ly + window.getOffsetY()
+                    )
+                );
+            }
+        }
+    }
+}
+
+TEST(AreaMap2D, ShrinkWithOut) {
+    util::AreaMap2D<int> window({7, 5});
+    window.setCenter(0, 0);
+    for (int y = -2; y <= 2; y++) {
+        for (int x = -3; x <= 3; x++) {
+            window.set(x, y, 1);
+        }
+    }
+    int outside = 0;
+    window.setOutCallback([&outside](auto, auto, auto) {
+        outside++;
+    });
+    window.resize(5, 3);
+    EXPECT_EQ(outside, 7 * 5 - 5 * 3);
+    EXPECT_EQ(window.count(), 5 * 3);
+    EXPECT_TRUE(window.isInside(-2, -1));
+    EXPECT_TRUE(window.isInside(2, 1));
+    EXPECT_FALSE(window.isInside(3, 0));
+}
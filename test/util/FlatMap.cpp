@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+#include <unordered_map>
+
+#include "util/FlatMap.hpp"
+
+using namespace util;
+
+TEST(FlatMap, InsertFindErase) {
+    FlatMap<int> map;
+    EXPECT_EQ(map.find(1), nullptr);
+    EXPECT_FALSE(map.erase(1));
+    map[1] = 10;
+    map[2] = 20;
+    ASSERT_NE(map.find(1), nullptr);
+    EXPECT_EQ(*map.find(1), 10);
+    EXPECT_EQ(map.size(), 2);
+    EXPECT_TRUE(map.erase(1));
+    EXPECT_EQ(map.find(1), nullptr);
+    EXPECT_EQ(*map.find(2), 20);
+    EXPECT_EQ(map.size(), 1);
+}
+
+TEST(FlatMap, SameAsUnorderedMap) {
+    FlatMap<std::shared_ptr<int>> map;
+    std::unordered_map<uint64_t, int> expected;
+    std::mt19937 random(42);
+    for (int i = 0; i < 200'000; i++) {
+        // chunk-like keys in a small area to produce collisions
+        uint64_t key = (random() % 64) << 32 | (random() % 64);
+        if (random() % 3 == 0) {
+            EXPECT_EQ(map.erase(key), expected.erase(key) > 0);
+        } else {
+            map[key] = std::make_shared<int>(i);
+            expected[key] = i;
+        }
+    }
+    ASSERT_EQ(map.size(), expected.size());
+    for (const auto& [key, value] : expected) {
+        auto found = map.find(key);
+        ASSERT_NE(found, nullptr);
+        EXPECT_EQ(**found, value);
+    }
+    size_t count = 0;
+    for (const auto& [key, value] : map) {
+        EXPECT_EQ(expected.at(key), *value);
+        count++;
+    }
+    EXPECT_EQ(count, expected.size());
+}
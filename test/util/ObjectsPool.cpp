@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+
+#include "util/ObjectsPool.hpp"
+
+using namespace util;
+
+struct alignas(64) PooledObject {
+    int value;
+    char payload[1000];
+
+    PooledObject(int value) : value(value) {
+    }
+};
+
+TEST(ObjectsPool, SlabAllocation) {
+    ObjectsPool<PooledObject> pool(0, 4096);
+    ASSERT_EQ(0, pool.countTotal());
+
+    auto a = pool.create(1);
+    // 1000 bytes objects with 64 bytes alignment take 1024 bytes each
+    ASSERT_EQ(4, pool.countTotal());
+    ASSERT_EQ(3, pool.countFree());
+    ASSERT_EQ(1, a->value);
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(a.get()) % alignof(PooledObject));
+
+    pool.reserve(6);
+    ASSERT_EQ(8, pool.countTotal());
+}
+
+TEST(ObjectsPool, Reuse) {
+    ObjectsPool<PooledObject> pool(2, 0);
+    ASSERT_EQ(2, pool.countTotal());
+    PooledObject* address;
+    {
+        auto a = pool.create(1);
+        auto b = pool.create(2);
+        address = a.get();
+        ASSERT_EQ(0, pool.countFree());
+    }
+    ASSERT_EQ(2, pool.countFree());
+    auto c = pool.create(3);
+    auto d = pool.create(4);
+    ASSERT_EQ(2, pool.countTotal());
+    ASSERT_TRUE(c.get() == address || d.get() == address);
+}
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include "util/RangeAllocator.hpp"
+
+using namespace util;
+
+TEST(RangeAllocator, Allocation) {
+    RangeAllocator allocator(100);
+    EXPECT_EQ(allocator.allocate(10), 0);
+    EXPECT_EQ(allocator.allocate(20), 10);
+    EXPECT_EQ(allocator.getFreeSize(), 70);
+    EXPECT_EQ(allocator.allocate(71), std::nullopt);
+    EXPECT_EQ(allocator.allocate(70), 30);
+    EXPECT_EQ(allocator.allocate(1), std::nullopt);
+}
+
+TEST(RangeAllocator, FreeMerge) {
+    RangeAllocator allocator(30);
+    auto a = allocator.allocate(10);
+    auto b = allocator.allocate(10);
+    auto c = allocator.allocate(10);
+    allocator.free(*a, 10);
+    allocator.free(*c, 10);
+    EXPECT_EQ(allocator.getFreeRangesCount(), 2);
+    EXPECT_EQ(allocator.allocate(20), std::nullopt);
+
+    allocator.free(*b, 10);
+    EXPECT_EQ(allocator.getFreeRangesCount(), 1);
+    EXPECT_EQ(allocator.allocate(30), 0);
+}
+
+TEST(RangeAllocator, FirstFit) {
+    RangeAllocator allocator(40);
+    auto a = allocator.allocate(10);
+    allocator.allocate(10);
+    auto c = allocator.allocate(5);
+    allocator.allocate(15);
+    allocator.free(*a, 10);
+    allocator.free(*c, 5);
+    EXPECT_EQ(allocator.allocate(4), 0);
+    EXPECT_EQ(allocator.allocate(6), 4);
+    EXPECT_EQ(allocator.allocate(5), 20);
+}
+
+TEST(RangeAllocator, Resize) {
+    RangeAllocator allocator(30);
+    auto a = allocator.allocate(10);
+    EXPECT_TRUE(allocator.resize(*a, 10, 20));
+    EXPECT_EQ(allocator.getFreeSize(), 10);
+    EXPECT_TRUE(allocator.resize(*a, 20, 5));
+    EXPECT_EQ(allocator.getFreeSize(), 25);
+
+    auto b = allocator.allocate(25);
+    EXPECT_EQ(b, 5);
+    EXPECT_FALSE(allocator.resize(*a, 5, 6));
+}
@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "util/ReadersGate.hpp"
+
+using namespace util;
+
+TEST(ReadersGate, ReadersWaitForOpen) {
+    ReadersGate gate;
+    std::atomic<int> entered = 0;
+    std::thread reader([&]() {
+        while (gate.enter()) {
+            entered++;
+            gate.leave();
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(0, entered);
+
+    gate.open();
+    while (entered == 0) {
+        std::this_thread::yield();
+    }
+    gate.close();
+    int closedAt = entered;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(closedAt, entered);
+
+    gate.stop();
+    reader.join();
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include <string>
+
+#include "util/RingBuffer.hpp"
+
+using namespace util;
+
+TEST(RingBuffer, WrapAround) {
+    RingBuffer<char> buffer(8);
+    buffer.write("abcdef", 6);
+    char dst[8] {};
+    ASSERT_EQ(4, buffer.read(dst, 4));
+    ASSERT_EQ("abcd", std::string(dst, 4));
+
+    buffer.write("ghijk", 5);
+    ASSERT_EQ(8, buffer.getCapacity());
+    ASSERT_EQ(7, buffer.size());
+    auto first = buffer.readable();
+    auto second = buffer.readable(first.size());
+    ASSERT_EQ(
+        "efghijk",
+        std::string(first.data(), first.size()) +
+            std::string(second.data(), second.size())
+    );
+    ASSERT_EQ(7, buffer.peek(dst, 8));
+    ASSERT_EQ("efghijk", std::string(dst, 7));
+    ASSERT_EQ(7, buffer.size());
+}
+
+TEST(RingBuffer, PrepareCommit) {
+    RingBuffer<char> buffer(8);
+    buffer.write("abcdef", 6);
+    buffer.consume(5);
+
+    auto [ptr, length] = buffer.prepare(4);
+    ASSERT_GE(length, 4);
+    std::memcpy(ptr, "1234", 4);
+    buffer.commit(4);
+
+    // no room left for contiguous 16 bytes, storage grows
+    auto [ptr2, length2] = buffer.prepare(16);
+    ASSERT_GE(length2, 16);
+    std::memcpy(ptr2, "5", 1);
+    buffer.commit(1);
+
+    std::string result(buffer.size(), '\0');
+    buffer.read(result.data(), result.size());
+    ASSERT_EQ("f12345", result);
+    ASSERT_TRUE(buffer.empty());
+}
@@ -2,6 +2,8 @@
 
 #include "util/SmallHeap.hpp"
 
+#include <map>
+
 using namespace util;
 
 TEST(SmallHeap, Allocation) {
@@ -82,3 +84,39 @@ TEST(SmallHeap, Iterator) {
     }
     EXPECT_EQ(sum, 44);
 }
+
+TEST(SmallHeap, FindAfterChanges) {
+    SmallHeap<uint16_t, uint8_t> map;
+    std::map<uint16_t, uint8_t> expected;
+    for (int i = 0; i < 5'000; i++) {
+        uint16_t index = rand() % 1'000;
+        if (rand() % 4 == 0) {
+            map.free(map.find(index));
+            expected.erase(index);
+            continue;
+        }
+        uint8_t size = rand() % 32 + 1;
+        map.allocate(index, size)[size - 1] = index & 0xFF;
+        expected[index] = size;
+    }
+    ASSERT_EQ(map.count(), expected.size());
+    for (uint16_t index = 0; index < 1'000; index++) {
+        auto ptr = map.find(index);
+        auto found = expected.find(index);
+        if (found == expected.end()) {
+            EXPECT_EQ(ptr, nullptr);
+            continue;
+        }
+        ASSERT_NE(ptr, nullptr);
+        EXPECT_EQ(map.sizeOf(ptr), found->second);
+        EXPECT_EQ(ptr[found->second - 1], index & 0xFF);
+    }
+
+    auto bytes = map.serialize();
+    SmallHeap<uint16_t, uint8_t> out;
+    out.deserialize(bytes.data(), bytes.size());
+    EXPECT_EQ(out.count(), map.count());
+    for (const auto& [index, size] : expected) {
+        EXPECT_EQ(out.sizeOf(out.find(index)), size);
+    }
+}
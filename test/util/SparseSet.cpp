@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <unordered_map>
+
+#include "util/SparseSet.hpp"
+
+using namespace util;
+
+TEST(SparseSet, SetFindErase) {
+    SparseSet<int> set;
+    EXPECT_EQ(set.find(1), nullptr);
+    EXPECT_FALSE(set.erase(1));
+    set.set(1, 10);
+    set.set(2, 20);
+    set.set(1, 11);
+    ASSERT_NE(set.find(1), nullptr);
+    EXPECT_EQ(*set.find(1), 11);
+    EXPECT_EQ(set.size(), 2);
+    EXPECT_TRUE(set.erase(1));
+    EXPECT_EQ(set.find(1), nullptr);
+    EXPECT_EQ(*set.find(2), 20);
+    EXPECT_EQ(set.size(), 1);
+    EXPECT_EQ(set.idAt(0), 2);
+}
+
+TEST(SparseSet, LargeIds) {
+    SparseSet<int> set;
+    uint64_t large = uint64_t(1) << 40;
+    set.set(large, 1);
+    set.set(5, 2);
+    EXPECT_EQ(*set.find(large), 1);
+    EXPECT_TRUE(set.erase(5));
+    EXPECT_EQ(*set.find(large), 1);
+    EXPECT_TRUE(set.erase(large));
+    EXPECT_EQ(set.size(), 0);
+}
+
+TEST(SparseSet, SameAsUnorderedMap) {
+    SparseSet<int> set;
+    std::unordered_map<uint64_t, int> expected;
+    std::mt19937 random(42);
+    for (int i = 0; i < 200'000; i++) {
+        uint64_t id = random() % 20'000;
+        if (random() % 4 == 0) {
+            id += uint64_t(1) << 32;
+        }
+        if (random() % 3 == 0) {
+            EXPECT_EQ(set.erase(id), expected.erase(id) > 0);
+        } else {
+            set.set(id, i);
+            expected[id] = i;
+        }
+    }
+    ASSERT_EQ(set.size(), expected.size());
+    for (size_t i = 0; i < set.size(); i++) {
+        EXPECT_EQ(set.valueAt(i), expected.at(set.idAt(i)));
+    }
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <future>
+
+#include "util/ThreadPool.hpp"
+
+using namespace util;
+
+namespace {
+    class TestWorker : public Worker<int, int> {
+        std::shared_future<void> gate;
+        std::atomic<bool>& started;
+    public:
+        TestWorker(std::shared_future<void> gate, std::atomic<bool>& started)
+            : gate(std::move(gate)), started(started) {
+        }
+
+        int operator()(const int& job) override {
+            started = true;
+            gate.wait();
+            return job;
+        }
+    };
+
+    std::vector<int> run_pool(
+        std::vector<std::pair<int, int>> jobs,
+        const std::function<bool(const int&)>& cancel,
+        size_t& cancelled
+    ) {
+        std::promise<void> promise;
+        std::shared_future<void> gate = promise.get_future().share();
+        std::atomic<bool> started = false;
+        std::vector<int> results;
+        ThreadPool<int, int> pool(
+            "test-pool",
+            [gate, &started]() {
+                return std::make_unique<TestWorker>(gate, started);
+            },
+            [&results](int&& result) { results.push_back(result); },
+            1
+        );
+        // first job blocks the only worker until all jobs are enqueued
+        pool.enqueueJob(-1, 0);
+        while (!started) {
+            std::this_thread::yield();
+        }
+        for (auto& [job, priority] : jobs) {
+            pool.enqueueJob(std::move(job), priority);
+        }
+        if (cancel) {
+            cancelled = pool.cancelJobs(cancel).size();
+        }
+        promise.set_value();
+        while (results.size() < jobs.size() + 1 - cancelled) {
+            pool.pullResults();
+            std::this_thread::yield();
+        }
+        return results;
+    }
+}
+
+TEST(ThreadPool, Priorities) {
+    size_t cancelled = 0;
+    auto results = run_pool(
+        {{1, 0}, {2, 5}, {3, 0}, {4, 10}, {5, -3}}, nullptr, cancelled
+    );
+    EXPECT_EQ(results, std::vector<int>({-1, 4, 2, 1, 3, 5}));
+}
+
+TEST(ThreadPool, CancelJobs) {
+    size_t cancelled = 0;
+    auto results = run_pool(
+        {{1, 0}, {2, 0}, {3, 0}, {4, 0}},
+        [](const int& job) { return job % 2 == 0; },
+        cancelled
+    );
+    EXPECT_EQ(cancelled, 2);
+    EXPECT_EQ(results, std::vector<int>({-1, 1, 3}));
+}
+
+TEST(ThreadPool, AllJobsDone) {
+    std::atomic<int> sum = 0;
+    class SquareWorker : public Worker<int, int> {
+    public:
+        int operator()(const int& job) override {
+            return job * job;
+        }
+    };
+    ThreadPool<int, int> pool(
+        "test-pool",
+        []() { return std::make_unique<SquareWorker>(); },
+        [&sum](int&& result) { sum += result; },
+        4
+    );
+    int expected = 0;
+    for (int i = 0; i < 1000; i++) {
+        expected += i * i;
+        pool.enqueueJob(int(i), i % 7);
+    }
+    while (pool.getWorkDone() < 1000) {
+        pool.pullResults();
+        std::this_thread::yield();
+    }
+    pool.pullResults();
+    EXPECT_EQ(sum, expected);
+}
+
+TEST(ThreadPool, CoresBudget) {
+    cores::set_budget(3);
+    size_t used = cores::get_used();
+    EXPECT_EQ(cores::acquire(2), 2);
+    EXPECT_EQ(cores::acquire(5), 3 - used - 2);
+    EXPECT_EQ(cores::acquire(1, 1), 1);
+    cores::release(3 - used + 1);
+    EXPECT_EQ(cores::get_used(), used);
+    cores::set_budget(0);
+}
+
+TEST(ThreadPool, AdaptiveWorkers) {
+    cores::set_budget(2);
+    std::promise<void> promise;
+    std::shared_future<void> gate = promise.get_future().share();
+    std::atomic<bool> started = false;
+    {
+        ThreadPool<int, int> pool(
+            "test-pool",
+            [gate, &started]() {
+                return std::make_unique<TestWorker>(gate, started);
+            },
+            [](int&&) {},
+            4
+        );
+        EXPECT_EQ(pool.getActiveWorkersCount(), 1);
+        for (int i = 0; i < 16; i++) {
+            pool.enqueueJob(int(i));
+        }
+        // limited by the cores budget
+        uint expected = std::min(2U, pool.getWorkersCount());
+        EXPECT_EQ(pool.getActiveWorkersCount(), expected);
+        EXPECT_EQ(cores::get_used(), expected);
+        promise.set_value();
+        while (pool.getWorkDone() < 16) {
+            pool.pullResults();
+            std::this_thread::yield();
+        }
+    }
+    EXPECT_EQ(cores::get_used(), 0);
+    cores::set_budget(0);
+}
@@ -101,3 +101,21 @@ TEST(stringutil, escape_cases) {
     }
     EXPECT_EQ(utf8str, restored);
 }
+
+TEST(stringutil, utf8_fast_paths) {
+    std::string str = "ascii text longer than sixteen bytes " +
+                      std::string(u8"и пример テキスト");
+    EXPECT_EQ(util::ascii_prefix(str), 37);
+    EXPECT_EQ(util::length_utf8(str), 50);
+    EXPECT_TRUE(util::is_valid_utf8(str));
+    EXPECT_FALSE(util::is_valid_utf8("\xC0\xAF"));  // overlong
+    EXPECT_FALSE(util::is_valid_utf8("\xED\xA0\x80"));  // surrogate
+    EXPECT_FALSE(util::is_valid_utf8("abc\xE3\x83"));  // truncated
+
+    auto u32str = util::str2u32str_utf8(str);
+    size_t pos = 0;
+    for (char32_t c : u32str) {
+        EXPECT_EQ(util::next_utf8(str, pos), static_cast<uint32_t>(c));
+    }
+    EXPECT_EQ(pos, str.length());
+}
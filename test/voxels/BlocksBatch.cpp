@@ -0,0 +1,26 @@
+#include <gtest/gtest.h>
+
+#include "voxels/BlocksBatch.hpp"
+#include "constants.hpp"
+
+TEST(BlocksBatch, SortByChunks) {
+    BlocksBatch batch;
+    batch.set(CHUNK_W + 1, 0, 0, 1, {});
+    batch.set(-1, 10, 0, 2, {});
+    batch.set(0, 5, CHUNK_D, 3, {});
+    batch.set(CHUNK_W + 1, 0, 0, 4, {});
+    batch.set(2, 7, 3, 5, {});
+    batch.sortByChunks();
+
+    const auto& entries = batch.getEntries();
+    ASSERT_EQ(entries.size(), 5);
+    EXPECT_EQ(entries[0].id, 2);
+    EXPECT_EQ(entries[1].id, 5);
+    // order of changes within a chunk is kept
+    EXPECT_EQ(entries[2].id, 1);
+    EXPECT_EQ(entries[3].id, 4);
+    EXPECT_EQ(entries[4].id, 3);
+
+    batch.clear();
+    EXPECT_TRUE(batch.empty());
+}
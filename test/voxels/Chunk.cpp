@@ -1,14 +1,15 @@
 #include <gtest/gtest.h>
 
 #include "voxels/Chunk.hpp"
+#include "items/Inventory.hpp"
 
 TEST(Chunk, EncodeDecode) {
     Chunk chunk1(0, 0);
     for (uint i = 0; i < CHUNK_VOL; i++) {
-        chunk1.voxels[i].id = rand();
-        chunk1.voxels[i].state.rotation = rand();
-        chunk1.voxels[i].state.segment = rand();
-        chunk1.voxels[i].state.userbits = rand();
+        chunk1.getVoxels()[i].id = rand();
+        chunk1.getVoxels()[i].state.rotation = rand();
+        chunk1.getVoxels()[i].state.segment = rand();
+        chunk1.getVoxels()[i].state.userbits = rand();
     }
     auto bytes = chunk1.encode();
 
@@ -16,10 +17,125 @@ TEST(Chunk, EncodeDecode) {
     chunk2.decode(bytes.get());
 
     for (uint i = 0; i < CHUNK_VOL; i++) {
-        EXPECT_EQ(chunk1.voxels[i].id, chunk2.voxels[i].id);
+        EXPECT_EQ(chunk1.getVoxels()[i].id, chunk2.getVoxels()[i].id);
         EXPECT_EQ(
-            blockstate2int(chunk1.voxels[i].state), 
-            blockstate2int(chunk2.voxels[i].state)
+            blockstate2int(chunk1.getVoxels()[i].state), 
+            blockstate2int(chunk2.getVoxels()[i].state)
         );
     }
 }
+
+TEST(Chunk, SectionsInfo) {
+    Chunk chunk(0, 0);
+    for (uint i = 0; i < CHUNK_SECTION_VOL * 2; i++) {
+        chunk.getVoxels()[i].id = 1;
+    }
+    chunk.getVoxels()[CHUNK_SECTION_VOL * 3 + 100].id = 2;
+    chunk.updateHeights();
+
+    EXPECT_TRUE(chunk.isSectionUniform(0));
+    EXPECT_TRUE(chunk.isSectionUniform(1));
+    EXPECT_FALSE(chunk.isSectionEmpty(1));
+    EXPECT_EQ(chunk.getSectionBlock(1), 1);
+    EXPECT_TRUE(chunk.isSectionEmpty(2));
+    EXPECT_FALSE(chunk.isSectionUniform(3));
+    EXPECT_FALSE(chunk.isSectionEmpty(3));
+    EXPECT_TRUE(chunk.isSectionEmpty(CHUNK_SECTIONS - 1));
+
+    chunk.setModifiedAndUnsaved(CHUNK_SECTION_H * 2);
+    EXPECT_FALSE(chunk.isSectionUniform(2));
+    EXPECT_FALSE(chunk.isSectionEmpty(2));
+    EXPECT_TRUE(chunk.isSectionUniform(1));
+}
+
+TEST(Chunk, LazyBlockInventories) {
+    Chunk chunk(0, 0);
+    int calls = 0;
+    chunk.setBlockInventoriesLoader([&calls]() {
+        calls++;
+        ChunkInventoriesMap map;
+        map[vox_index(1, 2, 3)] = std::make_shared<Inventory>(1, 4);
+        return map;
+    });
+    EXPECT_FALSE(chunk.isBlockInventoriesLoaded());
+    EXPECT_EQ(calls, 0);
+
+    EXPECT_NE(chunk.getBlockInventory(1, 2, 3), nullptr);
+    EXPECT_EQ(chunk.getBlockInventory(0, 0, 0), nullptr);
+    EXPECT_TRUE(chunk.isBlockInventoriesLoaded());
+    EXPECT_EQ(calls, 1);
+
+    chunk.removeBlockInventory(1, 2, 3);
+    EXPECT_TRUE(chunk.getBlockInventories().empty());
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(Chunk, ConvertIds) {
+    Chunk chunk(0, 0);
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        chunk.getVoxels()[i].id = (i / 100) % 13;
+    }
+    auto bytes = chunk.encode();
+
+    // ids 0-4 are not changed, 12 is out of the table
+    std::vector<blockid_t> table {0, 1, 2, 3, 4, 10, 5, 6, 7, 8, 11, 9};
+    Chunk::convert(bytes.get(), table.data(), table.size());
+
+    Chunk converted(0, 0);
+    converted.decode(bytes.get());
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        blockid_t id = chunk.get(i).id;
+        EXPECT_EQ(converted.get(i).id, id < table.size() ? table[id] : id);
+        EXPECT_EQ(
+            blockstate2int(converted.get(i).state),
+            blockstate2int(chunk.get(i).state)
+        );
+    }
+}
+
+TEST(Chunk, PackedVoxels) {
+    Chunk chunk(0, 0);
+    voxel* voxels = chunk.getVoxels();
+    for (uint i = 0; i < CHUNK_SECTION_VOL * 2; i++) {
+        voxels[i].id = 1 + i % 3;
+        voxels[i].state.rotation = i % 4;
+    }
+    chunk.updateHeights();
+    std::vector<voxel> source(voxels, voxels + CHUNK_VOL);
+    size_t flatMemory = chunk.getVoxelsMemory();
+
+    chunk.pack();
+    EXPECT_TRUE(chunk.isPacked());
+    EXPECT_LT(chunk.getVoxelsMemory(), flatMemory);
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        EXPECT_EQ(chunk.get(i).id, source[i].id);
+    }
+    // ranges not aligned to sections are copied too
+    uint begin = CHUNK_SECTION_VOL - 10;
+    uint end = CHUNK_SECTION_VOL * 2 + 10;
+    std::vector<voxel> copy(end - begin);
+    chunk.copyVoxels(copy.data(), begin, end);
+    for (uint i = begin; i < end; i++) {
+        EXPECT_EQ(copy[i - begin].id, source[i].id);
+        EXPECT_EQ(
+            blockstate2int(copy[i - begin].state),
+            blockstate2int(source[i].state)
+        );
+    }
+
+    chunk.set(vox_index(1, 0, 2), {7, {}});
+    EXPECT_TRUE(chunk.isPacked());
+    EXPECT_EQ(chunk.get(1, 0, 2).id, 7);
+
+    chunk.updateHeights();
+    EXPECT_TRUE(chunk.isPacked());
+    EXPECT_EQ(chunk.top, CHUNK_SECTION_H * 2);
+    EXPECT_TRUE(chunk.isSectionEmpty(2));
+
+    voxels = chunk.getVoxels();
+    EXPECT_FALSE(chunk.isPacked());
+    EXPECT_EQ(chunk.getVoxelsMemory(), flatMemory);
+    EXPECT_EQ(voxels[vox_index(1, 0, 2)].id, 7);
+    uint index = CHUNK_SECTION_VOL + 5;
+    EXPECT_EQ(voxels[index].id, source[index].id);
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "voxels/PalettedVoxels.hpp"
+
+static bool equals(voxel a, voxel b) {
+    return a.id == b.id && blockstate2int(a.state) == blockstate2int(b.state);
+}
+
+TEST(PalettedVoxels, Uniform) {
+    PalettedVoxels voxels;
+    EXPECT_EQ(voxels.get(3, 200, 7).id, 0);
+    for (uint i = 0; i < CHUNK_SECTIONS; i++) {
+        EXPECT_EQ(voxels.getSection(i).getBits(), 0);
+    }
+    EXPECT_LT(voxels.getMemoryConsumption(), CHUNK_VOL / 64);
+}
+
+TEST(PalettedVoxels, AssignUnpack) {
+    std::vector<voxel> source(CHUNK_VOL);
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        uint y = i / (CHUNK_W * CHUNK_D);
+        source[i].id = y < 64 ? rand() % 5 + 1 : 0;
+        source[i].state = int2blockstate(y < 32 ? rand() % 3 : 0);
+    }
+    PalettedVoxels voxels(source.data());
+    EXPECT_EQ(voxels.getSection(CHUNK_SECTIONS - 1).getBits(), 0);
+    EXPECT_EQ(voxels.getSection(0).getBits(), 4);
+
+    std::vector<voxel> unpacked(CHUNK_VOL);
+    voxels.unpack(unpacked.data());
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        ASSERT_TRUE(equals(source[i], unpacked[i]));
+        ASSERT_TRUE(equals(source[i], voxels.get(i)));
+    }
+}
+
+TEST(PalettedVoxels, SetGrowCompact) {
+    PalettedVoxels voxels;
+    std::vector<voxel> expected(CHUNK_VOL, voxel {0, {}});
+    for (uint i = 0; i < 600; i++) {
+        uint index = rand() % CHUNK_VOL;
+        voxel vox {static_cast<blockid_t>(rand() % 300), {}};
+        voxels.set(index, vox);
+        expected[index] = vox;
+    }
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        ASSERT_TRUE(equals(expected[i], voxels.get(i)));
+    }
+    // clear everything except the first section
+    for (uint i = PalettedSection::VOLUME; i < CHUNK_VOL; i++) {
+        voxels.set(i, voxel {0, {}});
+        expected[i] = voxel {0, {}};
+    }
+    voxels.compact();
+    EXPECT_EQ(voxels.getSection(1).getBits(), 0);
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        ASSERT_TRUE(equals(expected[i], voxels.get(i)));
+    }
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include "voxels/Pathfinding.hpp"
+#include "constants.hpp"
+
+using namespace voxels;
+
+TEST(Pathfinding, StateHeap) {
+    State state;
+    state.begin({0, 64, 0}, {10, 64, 10});
+    const float scores[] {5.0f, 1.0f, 4.0f, 3.0f, 2.0f, 6.0f};
+    for (float score : scores) {
+        state.nodes.push_back(Node {{}, -1, 0.0f, score, -1});
+        state.push(state.nodes.size() - 1);
+    }
+    state.nodes[5].fScore = 0.5f;
+    state.decrease(5);
+
+    const int expected[] {5, 1, 4, 3, 2, 0};
+    for (int index : expected) {
+        ASSERT_FALSE(state.heap.empty());
+        EXPECT_EQ(state.pop(), index);
+        EXPECT_EQ(state.nodes[index].heapIndex, -1);
+    }
+    EXPECT_TRUE(state.heap.empty());
+}
+
+TEST(Pathfinding, StateArena) {
+    State state;
+    state.begin({0, 64, 0}, {10, 60, -10});
+    auto cell = state.getCell({5, 62, -5});
+    ASSERT_NE(cell, nullptr);
+    EXPECT_NE(cell->generation, state.generation);
+    *cell = ArenaCell {state.generation, 0};
+
+    EXPECT_EQ(state.getCell({1000, 64, 0}), nullptr);
+    EXPECT_EQ(state.getCell({0, -1, 0}), nullptr);
+
+    // new search invalidates all cells without clearing
+    state.begin({0, 64, 0}, {10, 60, -10});
+    cell = state.getCell({5, 62, -5});
+    ASSERT_NE(cell, nullptr);
+    EXPECT_NE(cell->generation, state.generation);
+
+    // far target: arena is limited but contains the start position
+    state.begin({0, 64, 0}, {100000, 64, 0});
+    EXPECT_NE(state.getCell({0, 64, 0}), nullptr);
+    EXPECT_NE(state.getCell({50, 64, 0}), nullptr);
+    EXPECT_EQ(state.getCell({-100, 64, 0}), nullptr);
+}
+
+TEST(Pathfinding, StateArea) {
+    State state;
+    state.beginArea({16, 48, -16}, {16, 16, 16});
+    EXPECT_NE(state.getCell({16, 48, -16}), nullptr);
+    EXPECT_NE(state.getCell({31, 63, -1}), nullptr);
+    EXPECT_EQ(state.getCell({32, 48, -16}), nullptr);
+    EXPECT_EQ(state.getCell({16, 64, -16}), nullptr);
+
+    // area is clamped by the world height
+    state.beginArea({0, CHUNK_H - 8, 0}, {16, 16, 16});
+    EXPECT_NE(state.getCell({0, CHUNK_H - 1, 0}), nullptr);
+    EXPECT_EQ(state.getCell({0, CHUNK_H, 0}), nullptr);
+}
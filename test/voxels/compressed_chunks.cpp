@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "content/Content.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/compressed_chunks.hpp"
+
+TEST(compressed_chunks, Delta) {
+    Block air("core:air");
+    Block stone("test:stone");
+    ContentIndices indices({{&air, &stone}}, {{}}, {{}});
+
+    Chunk server(0, 0);
+    for (uint i = 0; i < CHUNK_W * CHUNK_D * 64; i++) {
+        server.getVoxels()[i].id = rand() % 2;
+    }
+    server.setModifiedAndUnsaved();
+
+    Chunk client(0, 0);
+    auto full = compressed_chunks::encode(server);
+    compressed_chunks::decode(client, full.data(), full.size(), indices);
+    uint32_t clientRevision = server.revision;
+
+    auto empty = compressed_chunks::encode_delta(server, clientRevision);
+    EXPECT_TRUE(compressed_chunks::is_delta(empty.data(), empty.size()));
+    EXPECT_EQ(empty.size(), 10);
+
+    int y = 100;
+    server.getVoxels()[vox_index(3, y, 4)].id = 1;
+    server.getVoxels()[vox_index(3, y, 4)].state.rotation = 2;
+    server.setModifiedAndUnsaved(y);
+    server.getVoxels()[vox_index(5, y + 1, 5)].id = 1;
+    server.setModifiedAndUnsaved(y + 1);
+
+    auto delta = compressed_chunks::encode_delta(server, clientRevision);
+    EXPECT_LT(delta.size(), full.size());
+    compressed_chunks::decode(client, delta.data(), delta.size(), indices);
+
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        ASSERT_EQ(server.getVoxels()[i].id, client.getVoxels()[i].id);
+        ASSERT_EQ(
+            blockstate2int(server.getVoxels()[i].state),
+            blockstate2int(client.getVoxels()[i].state)
+        );
+    }
+    EXPECT_EQ(client.top, y + 2);
+    EXPECT_EQ(client.bottom, 0);
+}
+
+TEST(compressed_chunks, ParallelEncodeDecode) {
+    Block air("core:air");
+    Block stone("test:stone");
+    ContentIndices indices({{&air, &stone}}, {{}}, {{}});
+
+    Chunk source(0, 0);
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        source.getVoxels()[i].id = (i * 31 / 7) % 2;
+    }
+    auto expected = compressed_chunks::encode(source);
+
+    std::atomic<int> mismatches = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&]() {
+            Chunk chunk(0, 0);
+            for (int i = 0; i < 20; i++) {
+                auto bytes = compressed_chunks::encode(source);
+                compressed_chunks::decode(
+                    chunk, bytes.data(), bytes.size(), indices
+                );
+                if (bytes != expected ||
+                    chunk.getVoxels()[CHUNK_VOL - 1].id !=
+                        source.getVoxels()[CHUNK_VOL - 1].id) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(mismatches, 0);
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+
+#include "world/InterestManager.hpp"
+
+using Entities = std::vector<std::pair<entityid_t, glm::vec3>>;
+
+static InterestManager::EntitiesQuery query_of(const Entities& entities) {
+    return [&entities](
+               const glm::vec3& center, float radius, auto& dst
+           ) {
+        for (const auto& [uid, pos] : entities) {
+            float dx = pos.x - center.x;
+            float dy = pos.y - center.y;
+            float dz = pos.z - center.z;
+            if (dx * dx + dy * dy + dz * dz <= radius * radius) {
+                dst.push_back(uid);
+            }
+        }
+    };
+}
+
+TEST(InterestManager, EnterLeave) {
+    Entities entities {
+        {1, {0, 0, 0}},
+        {2, {10, 0, 0}},
+        {3, {100, 0, 0}},
+    };
+    InterestManager interests;
+    interests.setRadius(7, 20.0f);
+    // not tracked
+    interests.update({{7, {0, 0, 0}}, {8, {0, 0, 0}}}, query_of(entities));
+
+    using ids = std::vector<entityid_t>;
+    EXPECT_EQ(interests.getVisible(7), ids({1, 2}));
+    EXPECT_EQ(interests.getEntered(7), ids({1, 2}));
+    EXPECT_TRUE(interests.getLeft(7).empty());
+    EXPECT_TRUE(interests.getVisible(8).empty());
+    EXPECT_EQ(interests.getObservers(2), std::vector<int64_t>({7}));
+
+    interests.update({{7, {95, 0, 0}}}, query_of(entities));
+    EXPECT_EQ(interests.getVisible(7), ids({3}));
+    EXPECT_EQ(interests.getEntered(7), ids({3}));
+    EXPECT_EQ(interests.getLeft(7), ids({1, 2}));
+    EXPECT_TRUE(interests.getObservers(1).empty());
+
+    interests.update({{7, {95, 0, 0}}}, query_of(entities));
+    EXPECT_TRUE(interests.getEntered(7).empty());
+    EXPECT_TRUE(interests.getLeft(7).empty());
+
+    // observer is not present (suspended)
+    interests.update({}, query_of(entities));
+    EXPECT_TRUE(interests.getVisible(7).empty());
+    EXPECT_EQ(interests.getLeft(7), ids({3}));
+}
+
+TEST(InterestManager, ChunkObservers) {
+    InterestManager interests;
+    interests.setRadius(1, 8.0f);
+    interests.setRadius(2, 40.0f);
+    interests.update({{1, {8, 0, 8}}, {2, {8, 0, 8}}}, query_of({}));
+
+    auto observers = interests.getChunkObservers(0, 0);
+    std::sort(observers.begin(), observers.end());
+    EXPECT_EQ(observers, std::vector<int64_t>({1, 2}));
+    EXPECT_EQ(interests.getChunkObservers(2, 0), std::vector<int64_t>({2}));
+    EXPECT_TRUE(interests.getChunkObservers(5, 5).empty());
+
+    interests.setRadius(2, 0.0f);
+    EXPECT_TRUE(interests.getChunkObservers(2, 0).empty());
+    EXPECT_EQ(interests.getRadius(2), 0.0f);
+}
@@ -0,0 +1,332 @@
+#include <gtest/gtest.h>
+
+#include "io/devices/StdfsDevice.hpp"
+#include "items/Inventory.hpp"
+#include "voxels/Chunk.hpp"
+#include "world/files/WorldRegions.hpp"
+
+namespace fs = std::filesystem;
+
+static std::unique_ptr<ubyte[]> make_data(ubyte value) {
+    auto data = std::make_unique<ubyte[]>(1);
+    data[0] = value;
+    return data;
+}
+
+TEST(WorldRegions, PutSequence) {
+    WorldRegion region;
+    EXPECT_TRUE(region.put(1, 2, make_data(1), 1, 1, 10));
+    // captured before the last put
+    EXPECT_FALSE(region.put(1, 2, make_data(2), 1, 1, 5));
+    EXPECT_EQ(region.getChunkData(1, 2)[0], 1);
+
+    EXPECT_TRUE(region.put(1, 2, make_data(3), 1, 1, 11));
+    EXPECT_EQ(region.getChunkData(1, 2)[0], 3);
+
+    // unordered put
+    EXPECT_TRUE(region.put(1, 2, make_data(4), 1, 1));
+    EXPECT_EQ(region.getChunkData(1, 2)[0], 4);
+}
+
+TEST(WorldRegions, MappedFiles) {
+    auto root = fs::temp_directory_path() / "vc_regions_test";
+    fs::remove_all(root);
+    io::set_device("regtest", std::make_shared<io::StdfsDevice>(root));
+
+    auto source = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
+    for (size_t i = 0; i < CHUNK_DATA_LEN; i++) {
+        source[i] = (i / 100) % 3;
+    }
+    {
+        WorldRegions regions("regtest:world");
+        auto data = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
+        std::memcpy(data.get(), source.get(), CHUNK_DATA_LEN);
+        regions.put(3, -5, REGION_LAYER_VOXELS, std::move(data), CHUNK_DATA_LEN);
+        regions.writeAll();
+    }
+    for (bool mapped : {false, true}) {
+        WorldRegions regions("regtest:world");
+        regions.setMappedFiles(mapped);
+        auto dst = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
+        ASSERT_TRUE(regions.getVoxels(3, -5, dst.get()));
+        EXPECT_EQ(std::memcmp(dst.get(), source.get(), CHUNK_DATA_LEN), 0);
+        EXPECT_FALSE(regions.getVoxels(4, -5, dst.get()));
+    }
+    io::remove_device("regtest");
+    fs::remove_all(root);
+}
+
+TEST(WorldRegions, CompactRegion) {
+    auto root = fs::temp_directory_path() / "vc_regions_compact_test";
+    fs::remove_all(root);
+    io::set_device("regtest", std::make_shared<io::StdfsDevice>(root));
+    {
+        WorldRegions regions("regtest:world");
+        for (auto [x, z] : {std::pair {0, 0}, {1, 0}, {2, 0}, {0, 1}}) {
+            regions.put(
+                x, z, REGION_LAYER_ENTITIES, make_data(x + z * 10), 1
+            );
+        }
+        regions.writeAll();
+    }
+    WorldRegions regions("regtest:world");
+    EXPECT_EQ(regions.compactRegion(REGION_LAYER_ENTITIES, 0, 0), 0);
+
+    auto bytes = io::read_bytes_buffer(
+        regions.getRegionFilePath(REGION_LAYER_ENTITIES, 0, 0)
+    );
+    uint32_t offsets[REGION_CHUNKS_COUNT];
+    std::memcpy(
+        offsets,
+        bytes.data() + bytes.size() - sizeof(offsets) - REGION_FOOTER_SIZE,
+        sizeof(offsets)
+    );
+    // (0, 1) is closer to (0, 0) than (2, 0) in Morton order
+    EXPECT_LT(offsets[1], offsets[REGION_SIZE]);
+    EXPECT_LT(offsets[REGION_SIZE], offsets[2]);
+    EXPECT_EQ(bytes[offsets[REGION_SIZE] + 8], 10);
+
+    io::remove_device("regtest");
+    fs::remove_all(root);
+}
+
+TEST(WorldRegions, AppendChunks) {
+    auto root = fs::temp_directory_path() / "vc_regions_append_test";
+    fs::remove_all(root);
+    io::set_device("regtest", std::make_shared<io::StdfsDevice>(root));
+    {
+        WorldRegions regions("regtest:world");
+        for (int i = 0; i < 4; i++) {
+            regions.put(i, 0, REGION_LAYER_ENTITIES, make_data(i), 1);
+        }
+        regions.writeAll();
+    }
+    auto file = fs::path(root) / "world/entities/0_0.bin";
+    size_t length = fs::file_size(file);
+    {
+        WorldRegions regions("regtest:world");
+        regions.put(1, 0, REGION_LAYER_ENTITIES, make_data(10), 1);
+        regions.put(2, 0, REGION_LAYER_ENTITIES, nullptr, 0);
+        regions.writeAll();
+    }
+    // only the changed chunk and the new table are written
+    size_t tail = REGION_CHUNKS_COUNT * 4 + REGION_FOOTER_SIZE;
+    EXPECT_EQ(fs::file_size(file), length + 9 + tail);
+    {
+        RegionsLayer layer {};
+        layer.folder = "regtest:world/entities";
+        uint32_t size, srcSize;
+        auto data = layer.getData(0, 0, size, srcSize);
+        ASSERT_NE(data, nullptr);
+        EXPECT_EQ(data[0], 0);
+        data = layer.getData(1, 0, size, srcSize);
+        ASSERT_NE(data, nullptr);
+        EXPECT_EQ(data[0], 10);
+        EXPECT_EQ(layer.getData(2, 0, size, srcSize), nullptr);
+        data = layer.getData(3, 0, size, srcSize);
+        ASSERT_NE(data, nullptr);
+        EXPECT_EQ(data[0], 3);
+    }
+    // garbage is reclaimed by rewriting the region
+    {
+        WorldRegions regions("regtest:world");
+        for (int i = 0; i < 100; i++) {
+            regions.put(1, 0, REGION_LAYER_ENTITIES, make_data(i), 1);
+            regions.writeAll();
+        }
+    }
+    EXPECT_LT(fs::file_size(file), REGION_COMPACTION_MIN_SIZE + tail * 2);
+
+    io::remove_device("regtest");
+    fs::remove_all(root);
+}
+
+TEST(WorldRegions, InterruptedAppend) {
+    auto root = fs::temp_directory_path() / "vc_regions_interrupted_test";
+    fs::remove_all(root);
+    io::set_device("regtest", std::make_shared<io::StdfsDevice>(root));
+    {
+        WorldRegions regions("regtest:world");
+        regions.put(0, 0, REGION_LAYER_ENTITIES, make_data(1), 1);
+        regions.writeAll();
+        regions.put(0, 0, REGION_LAYER_ENTITIES, make_data(2), 1);
+        regions.writeAll();
+    }
+    // the last table is not completely written
+    auto file = fs::path(root) / "world/entities/0_0.bin";
+    fs::resize_file(file, fs::file_size(file) - 5);
+
+    uint32_t size, srcSize;
+    {
+        RegionsLayer layer {};
+        layer.folder = "regtest:world/entities";
+        auto data = layer.getData(0, 0, size, srcSize);
+        ASSERT_NE(data, nullptr);
+        EXPECT_EQ(data[0], 1);
+    }
+    // region with the recovered table is rewritten on save
+    {
+        WorldRegions regions("regtest:world");
+        regions.put(1, 0, REGION_LAYER_ENTITIES, make_data(3), 1);
+        regions.writeAll();
+    }
+    RegionsLayer layer {};
+    layer.folder = "regtest:world/entities";
+    auto data = layer.getData(0, 0, size, srcSize);
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(data[0], 1);
+    data = layer.getData(1, 0, size, srcSize);
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(data[0], 3);
+    EXPECT_FALSE(layer.getRegFile({0, 0}).get()->recovered);
+
+    io::remove_device("regtest");
+    fs::remove_all(root);
+}
+
+TEST(WorldRegions, EvictSavedRegions) {
+    auto root = fs::temp_directory_path() / "vc_regions_evict_test";
+    fs::remove_all(root);
+    io::set_device("regtest", std::make_shared<io::StdfsDevice>(root));
+    // empty inventories list
+    auto make_inventories = []() {
+        return std::make_unique<ubyte[]>(4);
+    };
+    const auto layer = REGION_LAYER_INVENTORIES;
+    {
+        WorldRegions regions("regtest:world");
+        regions.setMemoryBudget(8);
+        for (int i = 0; i < 4; i++) {
+            regions.put(i * REGION_SIZE, 0, layer, make_inventories(), 4);
+        }
+        EXPECT_EQ(regions.getMemoryUsage(layer), 16);
+        // (0, 0) and (1, 0) regions are the least recently used ones
+        regions.put(3 * REGION_SIZE, 0, layer, make_inventories(), 4);
+        regions.put(2 * REGION_SIZE, 0, layer, make_inventories(), 4);
+        regions.writeAll();
+        EXPECT_EQ(regions.getMemoryUsage(layer), 8);
+
+        // evicted data is read from file again
+        EXPECT_TRUE(regions.fetchInventories(0, 0).empty());
+        EXPECT_EQ(regions.getMemoryUsage(layer), 12);
+    }
+    io::remove_device("regtest");
+    fs::remove_all(root);
+}
+
+TEST(WorldRegions, OpenFilesCache) {
+    auto root = fs::temp_directory_path() / "vc_regions_files_test";
+    fs::remove_all(root);
+    io::set_device("regtest", std::make_shared<io::StdfsDevice>(root));
+    const int regionsCount = 40;
+    {
+        WorldRegions regions("regtest:world");
+        for (int i = 0; i < regionsCount; i++) {
+            regions.put(
+                i * REGION_SIZE, 0, REGION_LAYER_ENTITIES, make_data(i), 1
+            );
+        }
+        regions.writeAll();
+    }
+    RegionsLayer layer {};
+    layer.folder = "regtest:world/entities";
+    layer.setMaxOpenFiles(16);
+    {
+        // same file is shared by multiple users
+        auto first = layer.getRegFile({1, 0});
+        auto second = layer.getRegFile({1, 0});
+        ASSERT_TRUE(first && second);
+        EXPECT_EQ(first.get(), second.get());
+
+        uint32_t size, srcSize;
+        for (int i = 0; i < regionsCount; i++) {
+            auto data = layer.getData(i * REGION_SIZE, 0, size, srcSize);
+            ASSERT_NE(data, nullptr);
+            EXPECT_EQ(data[0], i);
+        }
+        EXPECT_LE(layer.countOpenFiles(), 16 + 1);
+    }
+    EXPECT_LE(layer.countOpenFiles(), 16);
+    EXPECT_EQ(layer.getRegFile({regionsCount, 0}), nullptr);
+
+    io::remove_device("regtest");
+    fs::remove_all(root);
+}
+
+TEST(WorldRegions, Prototypes) {
+    auto root = fs::temp_directory_path() / "vc_regions_prototypes_test";
+    fs::remove_all(root);
+    io::set_device("regtest", std::make_shared<io::StdfsDevice>(root));
+
+    const uint32_t size = 3000;
+    auto source = std::make_unique<ubyte[]>(size);
+    for (uint32_t i = 0; i < size; i++) {
+        source[i] = i * 7 % 251;
+    }
+    {
+        WorldRegions regions("regtest:world");
+        auto data = std::make_unique<ubyte[]>(size);
+        std::memcpy(data.get(), source.get(), size);
+        regions.put(-40, 7, REGION_LAYER_PROTOTYPES, std::move(data), size);
+        regions.writeAll();
+    }
+    WorldRegions regions("regtest:world");
+    uint32_t readSize = 0;
+    auto data = regions.getPrototype(-40, 7, readSize);
+    ASSERT_NE(data, nullptr);
+    ASSERT_EQ(readSize, size);
+    EXPECT_EQ(std::memcmp(data.get(), source.get(), size), 0);
+    EXPECT_EQ(regions.getPrototype(-41, 7, readSize), nullptr);
+
+    io::remove_device("regtest");
+    fs::remove_all(root);
+}
+
+static std::vector<RegionLayerIndex> capture_layers(
+    WorldRegions& regions, Chunk& chunk
+) {
+    std::vector<ChunkLayerData> entries;
+    regions.capture(&chunk, {}, entries);
+    std::vector<RegionLayerIndex> layers;
+    for (const auto& entry : entries) {
+        layers.push_back(entry.layer);
+    }
+    return layers;
+}
+
+TEST(WorldRegions, CaptureChangedLayers) {
+    auto root = fs::temp_directory_path() / "vc_regions_capture_test";
+    fs::remove_all(root);
+    io::set_device("regtest", std::make_shared<io::StdfsDevice>(root));
+    {
+        using Layers = std::vector<RegionLayerIndex>;
+        WorldRegions regions("regtest:world");
+        Chunk chunk(0, 0);
+        chunk.flags.ready = true;
+        chunk.flags.unsaved = true;
+        EXPECT_EQ(capture_layers(regions, chunk), Layers {REGION_LAYER_VOXELS});
+        EXPECT_TRUE(capture_layers(regions, chunk).empty());
+
+        chunk.setModifiedAndUnsaved(10);
+        EXPECT_EQ(capture_layers(regions, chunk), Layers {REGION_LAYER_VOXELS});
+
+        auto inventory = std::make_shared<Inventory>(1, 4);
+        chunk.addBlockInventory(inventory, 1, 2, 3);
+        EXPECT_EQ(
+            capture_layers(regions, chunk), Layers {REGION_LAYER_INVENTORIES}
+        );
+        EXPECT_TRUE(capture_layers(regions, chunk).empty());
+
+        inventory->getSlot(0);
+        EXPECT_EQ(
+            capture_layers(regions, chunk), Layers {REGION_LAYER_INVENTORIES}
+        );
+
+        chunk.setBlocksDataModified();
+        EXPECT_EQ(
+            capture_layers(regions, chunk), Layers {REGION_LAYER_BLOCKS_DATA}
+        );
+    }
+    io::remove_device("regtest");
+    fs::remove_all(root);
+}
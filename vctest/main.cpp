@@ -1,7 +1,9 @@
 #include <chrono>
+#include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <vector>
 
@@ -18,8 +20,27 @@ struct Config {
     fs::path workingDir {"."};
     std::string memchecker = "valgrind";
     bool outputAlways = false;
+    fs::path reportFile;
+    fs::path baselineFile;
+    /// @brief Allowed regression relative to the baseline in percents
+    double threshold = 10.0;
 };
 
+inline const std::string METRIC_PREFIX = "[METRIC] ";
+
+/// @brief Performance metric reported by a test script (lower is better)
+struct Metric {
+    std::string name;
+    double value;
+    std::string unit;
+    /// @brief Maximum allowed value (NAN if not specified)
+    double budget = NAN;
+    std::string status = "ok";
+};
+
+/// @brief Metric values by test name and metric name
+using Baseline = std::map<std::string, std::map<std::string, double>>;
+
 static bool perform_keyword(
     util::ArgsReader& reader, const std::string& keyword, Config& config
 ) {
@@ -32,6 +53,9 @@ static bool perform_keyword(
         std::cout << "  --user <path>, -u <path>        = user directory path\n";
         std::cout << "  --memchecker <path>             = path to valgrind\n";
         std::cout << "  --output-always                 = always show tests output\n";
+        std::cout << "  --report <path>                 = write tests metrics report\n";
+        std::cout << "  --baseline <path>               = previous report to compare metrics with\n";
+        std::cout << "  --threshold <percent>           = allowed metrics regression (default: 10)\n";
         std::cout << std::endl;
         return false;
     } else if (keyword == "--exe" || keyword == "-e") {
@@ -46,6 +70,12 @@ static bool perform_keyword(
         config.outputAlways = true;
     } else if (keyword == "--memchecker") {
         config.memchecker = reader.next();
+    } else if (keyword == "--report") {
+        config.reportFile = fs::path(reader.next());
+    } else if (keyword == "--baseline") {
+        config.baselineFile = fs::path(reader.next());
+    } else if (keyword == "--threshold") {
+        config.threshold = std::stod(reader.next());
     } else {
         std::cerr << "unknown argument " << keyword << std::endl;
         return false;
@@ -95,6 +125,10 @@ static bool check_config(const Config& config) {
     if (!check_dir(config.workingDir)) {
         return true;
     }
+    if (!config.baselineFile.empty() && !fs::exists(config.baselineFile)) {
+        std::cerr << "file " << config.baselineFile << " not found" << std::endl;
+        return true;
+    }
     return false;
 }
 
@@ -163,6 +197,117 @@ static void display_segfault_valgrind(
     }
 }
 
+/// @brief Collect metrics reported by the test script.
+/// Line format: [METRIC] <name> <value> <unit> <budget or '-'>
+static std::vector<Metric> read_metrics(const fs::path& path) {
+    std::vector<Metric> metrics;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t pos = line.find(METRIC_PREFIX);
+        if (pos == std::string::npos) {
+            continue;
+        }
+        std::stringstream ss(line.substr(pos + METRIC_PREFIX.length()));
+        Metric metric {};
+        std::string budget;
+        if (!(ss >> metric.name >> metric.value >> metric.unit >> budget)) {
+            std::cerr << "invalid metric: " << line << std::endl;
+            continue;
+        }
+        metric.budget = budget == "-" ? NAN : std::stod(budget);
+        metric.status = "ok";
+        metrics.push_back(std::move(metric));
+    }
+    return metrics;
+}
+
+/// @brief Check metrics against budgets and the baseline
+/// @return false if any budget is exceeded or any metric is regressed
+static bool check_metrics(
+    const Config& config,
+    const std::string& test,
+    std::vector<Metric>& metrics,
+    const Baseline& baseline
+) {
+    const std::map<std::string, double>* previous = nullptr;
+    auto found = baseline.find(test);
+    if (found != baseline.end()) {
+        previous = &found->second;
+    }
+    bool success = true;
+    for (auto& metric : metrics) {
+        if (!std::isnan(metric.budget) && metric.value > metric.budget) {
+            metric.status = "over-budget";
+            std::cerr << "[BUDGET] " << test << " " << metric.name << " = "
+                      << metric.value << " " << metric.unit << " exceeds "
+                      << metric.budget << " " << metric.unit << std::endl;
+            success = false;
+            continue;
+        }
+        if (previous == nullptr) {
+            continue;
+        }
+        auto prev = previous->find(metric.name);
+        if (prev == previous->end()) {
+            continue;
+        }
+        double limit = prev->second * (1.0 + config.threshold / 100.0);
+        if (metric.value > limit) {
+            metric.status = "regressed";
+            std::cerr << "[REGRESSION] " << test << " " << metric.name
+                      << " = " << metric.value << " " << metric.unit
+                      << " (baseline " << prev->second << " " << metric.unit
+                      << ", threshold " << config.threshold << "%)"
+                      << std::endl;
+            success = false;
+        }
+    }
+    return success;
+}
+
+/// @brief Read metrics from a previous report
+static Baseline read_baseline(const fs::path& path) {
+    Baseline baseline;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::stringstream ss(line);
+        std::string test, name;
+        double value;
+        if (std::getline(ss, test, '\t') && std::getline(ss, name, '\t') &&
+            ss >> value) {
+            baseline[test][name] = value;
+        }
+    }
+    return baseline;
+}
+
+/// @brief Write tab-separated metrics report
+static void write_report(
+    const fs::path& path,
+    const std::map<std::string, std::vector<Metric>>& results
+) {
+    std::ofstream file(path);
+    file << "# test\tmetric\tvalue\tunit\tbudget\tstatus\n";
+    for (const auto& [test, metrics] : results) {
+        for (const auto& metric : metrics) {
+            file << test << "\t" << metric.name << "\t" << metric.value
+                 << "\t" << metric.unit << "\t";
+            if (std::isnan(metric.budget)) {
+                file << "-";
+            } else {
+                file << metric.budget;
+            }
+            file << "\t" << metric.status << "\n";
+        }
+    }
+    std::cout << "report written to " << path << std::endl;
+}
+
 static std::string fix_path(std::string s) {
     for (char& c : s) {
         if (c == '\\') {
@@ -172,7 +317,13 @@ static std::string fix_path(std::string s) {
     return s;
 }
 
-static bool run_test(const Config& config, const fs::path& path, bool memcheck = false) {
+static bool run_test(
+    const Config& config,
+    const fs::path& path,
+    const Baseline& baseline,
+    std::vector<Metric>& metrics,
+    bool memcheck = false
+) {
     using std::chrono::duration_cast;
     using std::chrono::high_resolution_clock;
     using std::chrono::milliseconds;
@@ -213,17 +364,25 @@ static bool run_test(const Config& config, const fs::path& path, bool memcheck =
             std::cerr << "[FAILED] " << name << " in " << testTime
                     << " ms (code=" << code << ")" << std::endl;
             fs::remove(outputFile);
-            run_test(config, path, true);
+            std::vector<Metric> memcheckMetrics;
+            run_test(config, path, baseline, memcheckMetrics, true);
         }
         return false;
-    } else {
-        if (config.outputAlways) {
-            display_test_output(outputFile, name, std::cout);
-        }
-        std::cout << "[PASSED] " << name << " in " << testTime << " ms" << std::endl;
+    }
+    metrics = read_metrics(outputFile);
+    if (!check_metrics(config, name.u8string(), metrics, baseline)) {
+        display_test_output(outputFile, name, std::cerr);
+        std::cerr << "[FAILED] " << name << " in " << testTime
+                  << " ms (performance budget)" << std::endl;
         fs::remove(outputFile);
-        return true;
+        return false;
+    }
+    if (config.outputAlways) {
+        display_test_output(outputFile, name, std::cout);
     }
+    std::cout << "[PASSED] " << name << " in " << testTime << " ms" << std::endl;
+    fs::remove(outputFile);
+    return true;
 }
 
 int main(int argc, char** argv) {
@@ -253,17 +412,27 @@ int main(int argc, char** argv) {
         tests.push_back(path);
     }
 
+    Baseline baseline;
+    if (!config.baselineFile.empty()) {
+        baseline = read_baseline(config.baselineFile);
+    }
     setup_working_dir(config.workingDir);
     config.workingDir /= TESTING_DIR;
 
     size_t passed = 0;
+    std::map<std::string, std::vector<Metric>> results;
     std::cout << "running " << tests.size() << " test(s)" << std::endl;
     for (const auto& path : tests) {
-        passed += run_test(config, path);
+        std::vector<Metric> metrics;
+        passed += run_test(config, path, baseline, metrics);
+        results[path.stem().u8string()] = std::move(metrics);
         fs::remove_all(config.workingDir / fs::u8path("worlds"));
     }
     print_separator(std::cout);
     cleanup(config.workingDir);
+    if (!config.reportFile.empty()) {
+        write_report(config.reportFile, results);
+    }
     std::cout << std::endl;
     std::cout << passed << " test(s) passed, " << (tests.size() - passed)
               << " test(s) failed" << std::endl;